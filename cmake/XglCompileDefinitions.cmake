@@ -39,6 +39,11 @@ macro(xgl_set_compile_definitions)
         target_compile_definitions(xgl PRIVATE ICD_MEMTRACK)
     endif()
 
+    # Driver performance counters are only reported if compiled in.
+    if(ICD_PERF_COUNTERS)
+        target_compile_definitions(xgl PRIVATE ICD_PERF_COUNTERS)
+    endif()
+
     # Enable relevant GPUOpen preprocessor definitions
     if(ICD_GPUOPEN_DEVMODE_BUILD)
         target_compile_definitions(xgl PRIVATE ICD_GPUOPEN_DEVMODE_BUILD)
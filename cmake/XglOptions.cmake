@@ -44,6 +44,18 @@ macro(xgl_options)
 
     option(XGL_BUILD_CACHE_CREATOR "Build cache-creator tools?" OFF)
 
+    option(XGL_BUILD_CMDBUF_BENCHMARK "Build the command buffer recording benchmark?" OFF)
+
+    option(XGL_BUILD_PIPELINE_BENCHMARK "Build the pipeline creation benchmark?" OFF)
+
+    option(XGL_BUILD_DESCRIPTOR_BENCHMARK "Build the descriptor update benchmark?" OFF)
+
+    option(XGL_BUILD_SYNC_BENCHMARK "Build the submission and synchronization benchmark?" OFF)
+
+    option(XGL_BUILD_STARTUP_BENCHMARK "Build the instance and device startup benchmark?" OFF)
+
+    option(XGL_BUILD_PIPELINE_TESTS "Build the pipeline creation tests?" OFF)
+
 #if VKI_EXT_EXTENDED_DYNAMIC_STATE2
     option(VKI_EXT_EXTENDED_DYNAMIC_STATE2 "Build vulkan with EXT_EXTENDED_DYNAMIC_STATE2" OFF)
 #endif
@@ -78,6 +90,8 @@ macro(xgl_options)
 
     option(ICD_MEMTRACK "Turn on memory tracking?" ${CMAKE_BUILD_TYPE_DEBUG})
 
+    option(ICD_PERF_COUNTERS "Build the driver performance counter registry?" ON)
+
     if (NOT WIN32)
         option(BUILD_WAYLAND_SUPPORT "Build XGL with Wayland support" ON)
 
@@ -89,6 +89,34 @@ macro(xgl_get_path)
     # XGL cache creator tool
     set(XGL_CACHE_CREATOR_PATH ${PROJECT_SOURCE_DIR}/tools/cache_creator CACHE PATH "Path to the cache creator tool")
 
+    # XGL benchmark support library
+    set(XGL_BENCHMARK_SUPPORT_PATH ${PROJECT_SOURCE_DIR}/tools/benchmark_support CACHE PATH
+        "Path to the library shared by the benchmarks")
+
+    # XGL command buffer recording benchmark
+    set(XGL_CMDBUF_BENCHMARK_PATH ${PROJECT_SOURCE_DIR}/tools/cmdbuf_benchmark CACHE PATH
+        "Path to the command buffer recording benchmark")
+
+    # XGL pipeline creation benchmark
+    set(XGL_PIPELINE_BENCHMARK_PATH ${PROJECT_SOURCE_DIR}/tools/pipeline_benchmark CACHE PATH
+        "Path to the pipeline creation benchmark")
+
+    # XGL descriptor update benchmark
+    set(XGL_DESCRIPTOR_BENCHMARK_PATH ${PROJECT_SOURCE_DIR}/tools/descriptor_benchmark CACHE PATH
+        "Path to the descriptor update benchmark")
+
+    # XGL submission and synchronization benchmark
+    set(XGL_SYNC_BENCHMARK_PATH ${PROJECT_SOURCE_DIR}/tools/sync_benchmark CACHE PATH
+        "Path to the submission and synchronization benchmark")
+
+    # XGL instance and device startup benchmark
+    set(XGL_STARTUP_BENCHMARK_PATH ${PROJECT_SOURCE_DIR}/tools/startup_benchmark CACHE PATH
+        "Path to the instance and device startup benchmark")
+
+    # XGL pipeline creation tests
+    set(XGL_PIPELINE_TESTS_PATH ${PROJECT_SOURCE_DIR}/tools/pipeline_tests CACHE PATH
+        "Path to the pipeline creation tests")
+
     # PAL path
     if(EXISTS ${PROJECT_SOURCE_DIR}/../pal)
         set(XGL_PAL_PATH ${PROJECT_SOURCE_DIR}/../pal CACHE PATH "Specify the path to the PAL project.")
@@ -0,0 +1,393 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  api_object_pool.cpp
+* @brief Implementation of the per-device slab allocator for the system memory of frequently created API objects.
+***********************************************************************************************************************
+*/
+#include "include/api_object_pool.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+
+#include "palInlineFuncs.h"
+
+#include <atomic>
+#include <string.h>
+
+namespace vk
+{
+
+static constexpr size_t SizeClasses[] = { 64, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048 };
+
+// Pools which are still alive, so that a thread's free lists are only handed back to a pool which still exists
+static Util::Mutex            s_livePoolLock;
+static ApiObjectPool*         s_pLivePools = nullptr;
+static std::atomic<uint64_t>  s_nextPoolId(1);
+
+// =====================================================================================================================
+// Free lists of one thread for the pool it used last.
+struct ApiObjectThreadCache
+{
+    ApiObjectThreadCache() : alive(true), pPool(nullptr), poolId(0)
+    {
+        memset(pFreeBlocks, 0, sizeof(pFreeBlocks));
+        memset(freeCount, 0, sizeof(freeCount));
+    }
+
+    ~ApiObjectThreadCache()
+    {
+        ApiObjectPool::ReleaseThreadCache(this);
+
+        // Objects destroyed by later thread-exit destructors go straight to the pool's shared free lists
+        alive = false;
+    }
+
+    bool                       alive;
+    ApiObjectPool*             pPool;                                       // Pool the blocks belong to
+    uint64_t                   poolId;                                      // Id of that pool
+    ApiObjectPool::FreeBlock*  pFreeBlocks[ApiObjectPool::SizeClassCount];  // Free blocks of each size class
+    uint32_t                   freeCount[ApiObjectPool::SizeClassCount];    // Length of each free list
+};
+
+static thread_local ApiObjectThreadCache t_objectCache;
+
+// =====================================================================================================================
+ApiObjectPool* ApiObjectPool::Create(
+    Device* pDevice)
+{
+    ApiObjectPool* pPool = nullptr;
+    void*          pMem  = pDevice->VkInstance()->AllocMem(sizeof(ApiObjectPool), VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+    if (pMem != nullptr)
+    {
+        pPool = VK_PLACEMENT_NEW(pMem) ApiObjectPool(pDevice);
+
+        Util::MutexAuto lock(&s_livePoolLock);
+
+        pPool->m_pNextLive = s_pLivePools;
+        s_pLivePools       = pPool;
+    }
+
+    return pPool;
+}
+
+// =====================================================================================================================
+ApiObjectPool::ApiObjectPool(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_id(s_nextPoolId.fetch_add(1, std::memory_order_relaxed)),
+    m_pNextLive(nullptr),
+    m_pSlabs(nullptr)
+{
+    memset(m_pFreeBlocks, 0, sizeof(m_pFreeBlocks));
+}
+
+// =====================================================================================================================
+ApiObjectPool::~ApiObjectPool()
+{
+    Instance* pInstance = m_pDevice->VkInstance();
+
+    while (m_pSlabs != nullptr)
+    {
+        Slab* pSlab = m_pSlabs;
+
+        m_pSlabs = pSlab->pNext;
+
+        pInstance->FreeMem(pSlab);
+    }
+}
+
+// =====================================================================================================================
+// Frees all slabs.  Free lists other threads still hold for this pool are dropped the next time they use a pool.
+void ApiObjectPool::Destroy()
+{
+    Instance* pInstance = m_pDevice->VkInstance();
+
+    {
+        Util::MutexAuto lock(&s_livePoolLock);
+
+        ApiObjectPool** ppPool = &s_pLivePools;
+
+        while (*ppPool != this)
+        {
+            ppPool = &(*ppPool)->m_pNextLive;
+        }
+
+        *ppPool = m_pNextLive;
+    }
+
+    Util::Destructor(this);
+
+    pInstance->FreeMem(this);
+}
+
+// =====================================================================================================================
+uint32_t ApiObjectPool::GetSizeClass(
+    size_t size)
+{
+    static_assert((sizeof(SizeClasses) / sizeof(SizeClasses[0])) == SizeClassCount, "Size class count mismatch");
+
+    uint32_t sizeClass = 0;
+
+    while ((sizeClass < SizeClassCount) && (SizeClasses[sizeClass] < size))
+    {
+        ++sizeClass;
+    }
+
+    return (sizeClass < SizeClassCount) ? sizeClass : NoSizeClass;
+}
+
+// =====================================================================================================================
+// Returns a block of the given size class, or nullptr if a new slab was needed and could not be allocated.
+void* ApiObjectPool::Alloc(
+    uint32_t sizeClass)
+{
+    VK_ASSERT(sizeClass < SizeClassCount);
+
+    ApiObjectThreadCache* pCache = BindThreadCache();
+
+    FreeBlock* pBlock = nullptr;
+
+    if (pCache != nullptr)
+    {
+        if (pCache->pFreeBlocks[sizeClass] == nullptr)
+        {
+            pCache->pFreeBlocks[sizeClass] = TakeBlocks(sizeClass, TransferBatchSize, &pCache->freeCount[sizeClass]);
+        }
+
+        pBlock = pCache->pFreeBlocks[sizeClass];
+
+        if (pBlock != nullptr)
+        {
+            pCache->pFreeBlocks[sizeClass] = pBlock->pNext;
+            pCache->freeCount[sizeClass]--;
+        }
+    }
+    else
+    {
+        uint32_t count = 0;
+
+        pBlock = TakeBlocks(sizeClass, 1, &count);
+    }
+
+    return pBlock;
+}
+
+// =====================================================================================================================
+// Returns a block obtained from Alloc() with the same size class.
+void ApiObjectPool::Free(
+    uint32_t sizeClass,
+    void*    pMemory)
+{
+    VK_ASSERT(sizeClass < SizeClassCount);
+
+    ApiObjectThreadCache* pCache = BindThreadCache();
+
+    FreeBlock* pBlock = static_cast<FreeBlock*>(pMemory);
+
+    if (pCache != nullptr)
+    {
+        // Hand a batch back to the pool rather than growing without bound when a thread only destroys objects
+        if (pCache->freeCount[sizeClass] >= MaxCachedPerClass)
+        {
+            FreeBlock* pLast = pCache->pFreeBlocks[sizeClass];
+
+            for (uint32_t i = 1; i < TransferBatchSize; ++i)
+            {
+                pLast = pLast->pNext;
+            }
+
+            FreeBlock* pBatch = pCache->pFreeBlocks[sizeClass];
+
+            pCache->pFreeBlocks[sizeClass] = pLast->pNext;
+            pCache->freeCount[sizeClass]  -= TransferBatchSize;
+
+            pLast->pNext = nullptr;
+
+            ReturnBlocks(sizeClass, pBatch);
+        }
+
+        pBlock->pNext                  = pCache->pFreeBlocks[sizeClass];
+        pCache->pFreeBlocks[sizeClass] = pBlock;
+        pCache->freeCount[sizeClass]++;
+    }
+    else
+    {
+        pBlock->pNext = nullptr;
+
+        ReturnBlocks(sizeClass, pBlock);
+    }
+}
+
+// =====================================================================================================================
+// Returns the calling thread's free lists after making sure they belong to this pool, or nullptr during thread exit.
+ApiObjectThreadCache* ApiObjectPool::BindThreadCache()
+{
+    ApiObjectThreadCache* pCache = t_objectCache.alive ? &t_objectCache : nullptr;
+
+    if ((pCache != nullptr) && ((pCache->pPool != this) || (pCache->poolId != m_id)))
+    {
+        ReleaseThreadCache(pCache);
+
+        pCache->pPool  = this;
+        pCache->poolId = m_id;
+    }
+
+    return pCache;
+}
+
+// =====================================================================================================================
+// Hands a thread's free lists back to their pool if it is still alive and empties them.  The blocks of a destroyed
+// pool were freed along with its slabs, so they are simply forgotten.
+void ApiObjectPool::ReleaseThreadCache(
+    ApiObjectThreadCache* pCache)
+{
+    if (pCache->pPool != nullptr)
+    {
+        Util::MutexAuto lock(&s_livePoolLock);
+
+        ApiObjectPool* pPool = s_pLivePools;
+
+        while ((pPool != nullptr) && ((pPool != pCache->pPool) || (pPool->m_id != pCache->poolId)))
+        {
+            pPool = pPool->m_pNextLive;
+        }
+
+        if (pPool != nullptr)
+        {
+            for (uint32_t sizeClass = 0; sizeClass < SizeClassCount; ++sizeClass)
+            {
+                if (pCache->pFreeBlocks[sizeClass] != nullptr)
+                {
+                    pPool->ReturnBlocks(sizeClass, pCache->pFreeBlocks[sizeClass]);
+                }
+            }
+        }
+    }
+
+    memset(pCache->pFreeBlocks, 0, sizeof(pCache->pFreeBlocks));
+    memset(pCache->freeCount, 0, sizeof(pCache->freeCount));
+
+    pCache->pPool  = nullptr;
+    pCache->poolId = 0;
+}
+
+// =====================================================================================================================
+// Detaches up to maxCount blocks from the shared free list of the given size class, carving a new slab if it is empty.
+ApiObjectPool::FreeBlock* ApiObjectPool::TakeBlocks(
+    uint32_t  sizeClass,
+    uint32_t  maxCount,
+    uint32_t* pCount)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    if (m_pFreeBlocks[sizeClass] == nullptr)
+    {
+        AllocSlab(sizeClass);
+    }
+
+    FreeBlock* pFirst = m_pFreeBlocks[sizeClass];
+    FreeBlock* pLast  = nullptr;
+    uint32_t   count  = 0;
+
+    for (FreeBlock* pBlock = pFirst; (pBlock != nullptr) && (count < maxCount); pBlock = pBlock->pNext)
+    {
+        pLast = pBlock;
+        count++;
+    }
+
+    if (pLast != nullptr)
+    {
+        m_pFreeBlocks[sizeClass] = pLast->pNext;
+
+        pLast->pNext = nullptr;
+    }
+
+    *pCount = count;
+
+    return pFirst;
+}
+
+// =====================================================================================================================
+// Prepends a null-terminated list of blocks to the shared free list of the given size class.
+void ApiObjectPool::ReturnBlocks(
+    uint32_t   sizeClass,
+    FreeBlock* pBlocks)
+{
+    FreeBlock* pLast = pBlocks;
+
+    while (pLast->pNext != nullptr)
+    {
+        pLast = pLast->pNext;
+    }
+
+    Util::MutexAuto lock(&m_lock);
+
+    pLast->pNext             = m_pFreeBlocks[sizeClass];
+    m_pFreeBlocks[sizeClass] = pBlocks;
+}
+
+// =====================================================================================================================
+// Carves a new slab into blocks of the given size class and puts them on its shared free list.  The caller must hold
+// m_lock.
+bool ApiObjectPool::AllocSlab(
+    uint32_t sizeClass)
+{
+    const size_t   blockStride = BlockHeaderSize + SizeClasses[sizeClass];
+    const uint32_t blockCount  = static_cast<uint32_t>(Util::Max(TargetSlabSize / blockStride, size_t(8)));
+
+    void* pMemory = m_pDevice->VkInstance()->AllocMem(
+        sizeof(Slab) + (blockStride * blockCount),
+        VK_DEFAULT_MEM_ALIGN,
+        VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+    if (pMemory != nullptr)
+    {
+        Slab* pSlab = static_cast<Slab*>(pMemory);
+
+        pSlab->pNext = m_pSlabs;
+        m_pSlabs     = pSlab;
+
+        void* pBlockBase = Util::VoidPtrInc(pMemory, sizeof(Slab));
+
+        for (uint32_t i = 0; i < blockCount; ++i)
+        {
+            static_cast<BlockHeader*>(pBlockBase)->sizeClass = sizeClass;
+
+            FreeBlock* pBlock = static_cast<FreeBlock*>(Util::VoidPtrInc(pBlockBase, BlockHeaderSize));
+
+            pBlock->pNext            = m_pFreeBlocks[sizeClass];
+            m_pFreeBlocks[sizeClass] = pBlock;
+
+            pBlockBase = Util::VoidPtrInc(pBlockBase, blockStride);
+        }
+    }
+
+    return (pMemory != nullptr);
+}
+
+} // namespace vk
@@ -30,6 +30,7 @@
 */
 
 #include "include/app_profile.h"
+#include "include/startup_profile.h"
 #include "include/vk_utils.h"
 
 #include "palMetroHash.h"
@@ -889,6 +890,8 @@ char* StringToLower(const char* pString, size_t strLength)
 AppProfile ScanApplicationProfile(
     const VkInstanceCreateInfo& instanceInfo)
 {
+    StartupPhase startupPhase("ScanApplicationProfile");
+
     // You can uncomment these if you need to add new hashes for specific strings (which is
     // hopefully never).  DON'T LEAVE THIS UNCOMMENTED:
     //
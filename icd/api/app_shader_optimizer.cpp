@@ -35,12 +35,26 @@
 #include "include/vk_utils.h"
 
 #include "include/app_shader_optimizer.h"
+#include "include/pipeline_binary_cache.h"
+#include "include/pipeline_compiler.h"
 
 #include "palDbgPrint.h"
 #include "palFile.h"
 
+#include <algorithm>
+
 #if ICD_RUNTIME_APP_PROFILE
 #include "utils/json_reader.h"
+#include "utils/temp_mem_arena.h"
+
+#include "palMetroHash.h"
+#include "palSysUtil.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 namespace vk
@@ -53,7 +67,22 @@ ShaderOptimizer::ShaderOptimizer(
     :
     m_pDevice(pDevice),
     m_settings(pPhysicalDevice->GetRuntimeSettings())
+#if ICD_RUNTIME_APP_PROFILE
+    ,
+    m_pRuntimeProfileMapping(nullptr),
+    m_runtimeProfileMappingSize(0)
+#endif
 {
+    memset(&m_compileCostProfile, 0, sizeof(m_compileCostProfile));
+    memset(&m_autotuneProfile, 0, sizeof(m_autotuneProfile));
+
+    memset(&m_tuningProfileIndex, 0, sizeof(m_tuningProfileIndex));
+    memset(&m_appProfileIndex, 0, sizeof(m_appProfileIndex));
+    memset(&m_compileCostProfileIndex, 0, sizeof(m_compileCostProfileIndex));
+    memset(&m_autotuneProfileIndex, 0, sizeof(m_autotuneProfileIndex));
+#if ICD_RUNTIME_APP_PROFILE
+    memset(&m_runtimeProfileIndex, 0, sizeof(m_runtimeProfileIndex));
+#endif
 }
 
 // =====================================================================================================================
@@ -63,6 +92,10 @@ void ShaderOptimizer::Init()
 
     BuildTuningProfile();
 
+    BuildCompileCostProfile();
+
+    BuildAutotuneProfile();
+
     if (m_settings.enablePipelineProfileDumping)
     {
         m_appShaderProfile.PipelineProfileToJson(m_tuningProfile, m_settings.pipelineProfileDumpFile);
@@ -71,17 +104,33 @@ void ShaderOptimizer::Init()
 #if ICD_RUNTIME_APP_PROFILE
     BuildRuntimeProfile();
 #endif
+
+    BuildProfileIndex(m_tuningProfile, &m_tuningProfileIndex);
+    BuildProfileIndex(m_appProfile, &m_appProfileIndex);
+    BuildProfileIndex(m_compileCostProfile, &m_compileCostProfileIndex);
+    BuildProfileIndex(m_autotuneProfile, &m_autotuneProfileIndex);
+#if ICD_RUNTIME_APP_PROFILE
+    BuildProfileIndex(m_runtimeProfile, &m_runtimeProfileIndex);
+#endif
 }
 
 // =====================================================================================================================
 void ShaderOptimizer::ApplyProfileToShaderCreateInfo(
     const PipelineProfile&           profile,
+    const PipelineProfileIndex&      index,
     const PipelineOptimizerKey&      pipelineKey,
     ShaderStage                      shaderStage,
     PipelineShaderOptionsPtr         options)
 {
-    for (uint32_t entry = 0; entry < profile.entryCount; ++entry)
+    uint32_t candidates[MaxProfileCandidates];
+    uint32_t candidateCount = 0;
+
+    const bool     indexed   = GetCandidateEntries(index, pipelineKey, candidates, &candidateCount);
+    const uint32_t testCount = indexed ? candidateCount : profile.entryCount;
+
+    for (uint32_t i = 0; i < testCount; ++i)
     {
+        const uint32_t              entry        = indexed ? candidates[i] : i;
         const PipelineProfileEntry& profileEntry = profile.pEntries[entry];
 
         if (ProfilePatternMatchesPipeline(profileEntry.pattern, pipelineKey))
@@ -222,13 +271,19 @@ void ShaderOptimizer::OverrideShaderCreateInfo(
     ShaderStage                        shaderStage,
     PipelineShaderOptionsPtr           options)
 {
+    // Applied first, so that explicit profiles still have the last word.
+    ApplyProfileToShaderCreateInfo(m_compileCostProfile, m_compileCostProfileIndex, pipelineKey, shaderStage, options);
+
+    ApplyProfileToShaderCreateInfo(m_autotuneProfile, m_autotuneProfileIndex, pipelineKey, shaderStage, options);
 
-    ApplyProfileToShaderCreateInfo(m_appProfile, pipelineKey, shaderStage, options);
+    m_pDevice->GetPipelineAutotuner()->ApplyTrial(pipelineKey, options);
 
-    ApplyProfileToShaderCreateInfo(m_tuningProfile, pipelineKey, shaderStage, options);
+    ApplyProfileToShaderCreateInfo(m_appProfile, m_appProfileIndex, pipelineKey, shaderStage, options);
+
+    ApplyProfileToShaderCreateInfo(m_tuningProfile, m_tuningProfileIndex, pipelineKey, shaderStage, options);
 
 #if ICD_RUNTIME_APP_PROFILE
-    ApplyProfileToShaderCreateInfo(m_runtimeProfile, pipelineKey, shaderStage, options);
+    ApplyProfileToShaderCreateInfo(m_runtimeProfile, m_runtimeProfileIndex, pipelineKey, shaderStage, options);
 #endif
 }
 
@@ -240,14 +295,14 @@ void ShaderOptimizer::OverrideGraphicsPipelineCreateInfo(
     Pal::DynamicGraphicsShaderInfos*  pGraphicsShaderInfos)
 {
     ApplyProfileToGraphicsPipelineCreateInfo(
-        m_appProfile, pipelineKey, shaderStages, pPalCreateInfo, pGraphicsShaderInfos);
+        m_appProfile, m_appProfileIndex, pipelineKey, shaderStages, pPalCreateInfo, pGraphicsShaderInfos);
 
     ApplyProfileToGraphicsPipelineCreateInfo(
-        m_tuningProfile, pipelineKey, shaderStages, pPalCreateInfo, pGraphicsShaderInfos);
+        m_tuningProfile, m_tuningProfileIndex, pipelineKey, shaderStages, pPalCreateInfo, pGraphicsShaderInfos);
 
 #if ICD_RUNTIME_APP_PROFILE
     ApplyProfileToGraphicsPipelineCreateInfo(
-        m_runtimeProfile, pipelineKey, shaderStages, pPalCreateInfo, pGraphicsShaderInfos);
+        m_runtimeProfile, m_runtimeProfileIndex, pipelineKey, shaderStages, pPalCreateInfo, pGraphicsShaderInfos);
 #endif
 }
 
@@ -256,12 +311,15 @@ void ShaderOptimizer::OverrideComputePipelineCreateInfo(
     const PipelineOptimizerKey&      pipelineKey,
     Pal::DynamicComputeShaderInfo*   pDynamicCompueShaderInfo)
 {
-    ApplyProfileToComputePipelineCreateInfo(m_appProfile, pipelineKey, pDynamicCompueShaderInfo);
+    ApplyProfileToComputePipelineCreateInfo(
+        m_appProfile, m_appProfileIndex, pipelineKey, pDynamicCompueShaderInfo);
 
-    ApplyProfileToComputePipelineCreateInfo(m_tuningProfile, pipelineKey, pDynamicCompueShaderInfo);
+    ApplyProfileToComputePipelineCreateInfo(
+        m_tuningProfile, m_tuningProfileIndex, pipelineKey, pDynamicCompueShaderInfo);
 
 #if ICD_RUNTIME_APP_PROFILE
-    ApplyProfileToComputePipelineCreateInfo(m_runtimeProfile, pipelineKey, pDynamicCompueShaderInfo);
+    ApplyProfileToComputePipelineCreateInfo(
+        m_runtimeProfile, m_runtimeProfileIndex, pipelineKey, pDynamicCompueShaderInfo);
 #endif
 }
 
@@ -278,12 +336,32 @@ ShaderOptimizer::~ShaderOptimizer()
     {
         pAllocCB->pfnFree(pAllocCB->pUserData, m_tuningProfile.pEntries);
     }
+    if (m_compileCostProfile.pEntries != nullptr)
+    {
+        pAllocCB->pfnFree(pAllocCB->pUserData, m_compileCostProfile.pEntries);
+    }
+    if (m_autotuneProfile.pEntries != nullptr)
+    {
+        pAllocCB->pfnFree(pAllocCB->pUserData, m_autotuneProfile.pEntries);
+    }
 #if ICD_RUNTIME_APP_PROFILE
-    if (m_runtimeProfile.pEntries != nullptr)
+    if (m_pRuntimeProfileMapping != nullptr)
+    {
+        munmap(m_pRuntimeProfileMapping, m_runtimeProfileMappingSize);
+    }
+    else if (m_runtimeProfile.pEntries != nullptr)
     {
         pAllocCB->pfnFree(pAllocCB->pUserData, m_runtimeProfile.pEntries);
     }
 #endif
+
+    DestroyProfileIndex(&m_tuningProfileIndex);
+    DestroyProfileIndex(&m_appProfileIndex);
+    DestroyProfileIndex(&m_compileCostProfileIndex);
+    DestroyProfileIndex(&m_autotuneProfileIndex);
+#if ICD_RUNTIME_APP_PROFILE
+    DestroyProfileIndex(&m_runtimeProfileIndex);
+#endif
 }
 
 // =====================================================================================================================
@@ -308,13 +386,21 @@ void ShaderOptimizer::ApplyProfileToDynamicGraphicsShaderInfo(
 // =====================================================================================================================
 void ShaderOptimizer::ApplyProfileToGraphicsPipelineCreateInfo(
     const PipelineProfile&            profile,
+    const PipelineProfileIndex&       index,
     const PipelineOptimizerKey&       pipelineKey,
     VkShaderStageFlagBits             shaderStages,
     Pal::GraphicsPipelineCreateInfo*  pPalCreateInfo,
     Pal::DynamicGraphicsShaderInfos*  pGraphicsShaderInfos)
 {
-    for (uint32_t entry = 0; entry < profile.entryCount; ++entry)
+    uint32_t candidates[MaxProfileCandidates];
+    uint32_t candidateCount = 0;
+
+    const bool     indexed   = GetCandidateEntries(index, pipelineKey, candidates, &candidateCount);
+    const uint32_t testCount = indexed ? candidateCount : profile.entryCount;
+
+    for (uint32_t i = 0; i < testCount; ++i)
     {
+        const uint32_t              entry        = indexed ? candidates[i] : i;
         const PipelineProfileEntry& profileEntry = profile.pEntries[entry];
 
         if (ProfilePatternMatchesPipeline(profileEntry.pattern, pipelineKey))
@@ -374,11 +460,19 @@ void ShaderOptimizer::ApplyProfileToGraphicsPipelineCreateInfo(
 // =====================================================================================================================
 void ShaderOptimizer::ApplyProfileToComputePipelineCreateInfo(
     const PipelineProfile&           profile,
+    const PipelineProfileIndex&      index,
     const PipelineOptimizerKey&      pipelineKey,
     Pal::DynamicComputeShaderInfo*   pDynamicComputeShaderInfo)
 {
-    for (uint32_t entry = 0; entry < profile.entryCount; ++entry)
+    uint32_t candidates[MaxProfileCandidates];
+    uint32_t candidateCount = 0;
+
+    const bool     indexed   = GetCandidateEntries(index, pipelineKey, candidates, &candidateCount);
+    const uint32_t testCount = indexed ? candidateCount : profile.entryCount;
+
+    for (uint32_t i = 0; i < testCount; ++i)
     {
+        const uint32_t              entry        = indexed ? candidates[i] : i;
         const PipelineProfileEntry& profileEntry = profile.pEntries[entry];
 
         if (ProfilePatternMatchesPipeline(profileEntry.pattern, pipelineKey))
@@ -424,6 +518,161 @@ Pal::ShaderHash ShaderOptimizer::GetFirstMatchingShaderHash(
     return emptyHash;
 }
 
+// =====================================================================================================================
+// Orders indexed entries by stage, then code hash, then entry index.
+static bool HashedEntryLess(
+    const PipelineProfileIndex::HashedEntry& lhs,
+    const PipelineProfileIndex::HashedEntry& rhs)
+{
+    bool less;
+
+    if (lhs.stage != rhs.stage)
+    {
+        less = (lhs.stage < rhs.stage);
+    }
+    else if (lhs.hashLower != rhs.hashLower)
+    {
+        less = (lhs.hashLower < rhs.hashLower);
+    }
+    else if (lhs.hashUpper != rhs.hashUpper)
+    {
+        less = (lhs.hashUpper < rhs.hashUpper);
+    }
+    else
+    {
+        less = (lhs.entry < rhs.entry);
+    }
+
+    return less;
+}
+
+// =====================================================================================================================
+// Builds the lookup index of a profile.  Must be called once the profile's entries are final.
+void ShaderOptimizer::BuildProfileIndex(
+    const PipelineProfile& profile,
+    PipelineProfileIndex*  pIndex)
+{
+    memset(pIndex, 0, sizeof(*pIndex));
+
+    if ((profile.entryCount > 0) && (profile.pEntries != nullptr))
+    {
+        const VkAllocationCallbacks* pAllocCB = m_pDevice->VkInstance()->GetAllocCallbacks();
+
+        const size_t hashedSize = profile.entryCount * sizeof(PipelineProfileIndex::HashedEntry);
+        void*        pMemory    = pAllocCB->pfnAllocation(pAllocCB->pUserData,
+                                                          hashedSize + (profile.entryCount * sizeof(uint32_t)),
+                                                          VK_DEFAULT_MEM_ALIGN,
+                                                          VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+        if (pMemory != nullptr)
+        {
+            pIndex->pHashedEntries   = static_cast<PipelineProfileIndex::HashedEntry*>(pMemory);
+            pIndex->pResidualEntries = static_cast<uint32_t*>(Util::VoidPtrInc(pMemory, hashedSize));
+
+            for (uint32_t entry = 0; entry < profile.entryCount; ++entry)
+            {
+                const PipelineProfilePattern& pattern = profile.pEntries[entry].pattern;
+
+                uint32_t hashStage = ShaderStageCount;
+
+                // An always-match pattern ignores its stage patterns, so it can't be found through a hash.
+                for (uint32_t stage = 0; (pattern.match.always == 0) && (stage < ShaderStageCount); ++stage)
+                {
+                    if (pattern.shaders[stage].match.codeHash)
+                    {
+                        hashStage = stage;
+                        break;
+                    }
+                }
+
+                if (hashStage < ShaderStageCount)
+                {
+                    PipelineProfileIndex::HashedEntry* pHashed = &pIndex->pHashedEntries[pIndex->hashedCount++];
+
+                    pHashed->hashLower = pattern.shaders[hashStage].codeHash.lower;
+                    pHashed->hashUpper = pattern.shaders[hashStage].codeHash.upper;
+                    pHashed->stage     = hashStage;
+                    pHashed->entry     = entry;
+                }
+                else
+                {
+                    pIndex->pResidualEntries[pIndex->residualCount++] = entry;
+                }
+            }
+
+            std::sort(pIndex->pHashedEntries, pIndex->pHashedEntries + pIndex->hashedCount, HashedEntryLess);
+        }
+    }
+}
+
+// =====================================================================================================================
+void ShaderOptimizer::DestroyProfileIndex(
+    PipelineProfileIndex* pIndex)
+{
+    if (pIndex->pHashedEntries != nullptr)
+    {
+        const VkAllocationCallbacks* pAllocCB = m_pDevice->VkInstance()->GetAllocCallbacks();
+
+        pAllocCB->pfnFree(pAllocCB->pUserData, pIndex->pHashedEntries);
+    }
+
+    memset(pIndex, 0, sizeof(*pIndex));
+}
+
+// =====================================================================================================================
+// Gathers the entries of an indexed profile that may match the given pipeline, in entry order so that later entries
+// still override earlier ones.  Each candidate must still be tested with ProfilePatternMatchesPipeline().  Returns
+// false if the profile isn't indexed or has too many candidates, in which case every entry has to be tested.
+bool ShaderOptimizer::GetCandidateEntries(
+    const PipelineProfileIndex& index,
+    const PipelineOptimizerKey& pipelineKey,
+    uint32_t*                   pCandidates,
+    uint32_t*                   pCandidateCount) const
+{
+    bool     indexed = (index.pHashedEntries != nullptr) && (index.residualCount <= MaxProfileCandidates);
+    uint32_t count   = 0;
+
+    if (indexed)
+    {
+        memcpy(pCandidates, index.pResidualEntries, index.residualCount * sizeof(uint32_t));
+        count = index.residualCount;
+
+        const PipelineProfileIndex::HashedEntry* pEnd = index.pHashedEntries + index.hashedCount;
+
+        for (uint32_t stage = 0; indexed && (stage < ShaderStageCount); ++stage)
+        {
+            const Pal::ShaderHash& codeHash = pipelineKey.shaders[stage].codeHash;
+
+            const PipelineProfileIndex::HashedEntry key = { codeHash.lower, codeHash.upper, stage, 0 };
+
+            for (const PipelineProfileIndex::HashedEntry* pHashed =
+                     std::lower_bound(index.pHashedEntries, pEnd, key, HashedEntryLess);
+                 indexed                                &&
+                 (pHashed != pEnd)                      &&
+                 (pHashed->stage     == stage)          &&
+                 (pHashed->hashLower == codeHash.lower) &&
+                 (pHashed->hashUpper == codeHash.upper);
+                 ++pHashed)
+            {
+                if (count < MaxProfileCandidates)
+                {
+                    pCandidates[count++] = pHashed->entry;
+                }
+                else
+                {
+                    indexed = false;
+                }
+            }
+        }
+
+        std::sort(pCandidates, pCandidates + count);
+    }
+
+    *pCandidateCount = count;
+
+    return indexed;
+}
+
 // =====================================================================================================================
 bool ShaderOptimizer::ProfilePatternMatchesPipeline(
     const PipelineProfilePattern& pattern,
@@ -630,6 +879,170 @@ void ShaderOptimizer::BuildTuningProfile()
     }
 }
 
+// =====================================================================================================================
+// Builds profile entries from the compile cost database of previous runs.  Pipelines which took a long time to compile
+// but were only used in a few runs are matched by their shader hashes and compiled without loop unrolling, which is
+// the most effective way to cut the compile time of a pipeline without touching the rest.
+void ShaderOptimizer::BuildCompileCostProfile()
+{
+    PipelineBinaryCache*         pBinaryCache = m_pDevice->GetCompiler(DefaultDeviceIndex)->GetBinaryCache();
+    const PipelineCompileCostDb* pCostDb      = (pBinaryCache != nullptr) ? pBinaryCache->GetCompileCostDb() : nullptr;
+
+    if ((m_settings.compileCostAutoTuneThresholdMs == 0) || (pCostDb == nullptr))
+    {
+        return;
+    }
+
+    const VkAllocationCallbacks* pAllocCB = m_pDevice->VkInstance()->GetAllocCallbacks();
+
+    const uint32_t capacity = m_settings.compileCostAutoTuneMaxPipelines;
+    void*          pKeyMem  = m_pDevice->VkInstance()->AllocMem(capacity * sizeof(PipelineOptimizerKey),
+                                                                VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+
+    if (pKeyMem == nullptr)
+    {
+        return;
+    }
+
+    PipelineOptimizerKey* pKeys = static_cast<PipelineOptimizerKey*>(pKeyMem);
+
+    const uint32_t keyCount = pCostDb->GetExpensiveRarePipelines(
+        static_cast<uint64_t>(m_settings.compileCostAutoTuneThresholdMs) * 1000,
+        m_settings.compileCostAutoTuneMaxRuns,
+        capacity,
+        pKeys);
+
+    size_t newSize = keyCount * sizeof(PipelineProfileEntry);
+    void*  pMemory = (keyCount > 0) ? pAllocCB->pfnAllocation(pAllocCB->pUserData,
+                                                              newSize,
+                                                              VK_DEFAULT_MEM_ALIGN,
+                                                              VK_SYSTEM_ALLOCATION_SCOPE_OBJECT) : nullptr;
+
+    if (pMemory != nullptr)
+    {
+        memset(pMemory, 0, newSize);
+
+        m_compileCostProfile.pEntries      = static_cast<PipelineProfileEntry*>(pMemory);
+        m_compileCostProfile.entryCapacity = keyCount;
+        m_compileCostProfile.entryCount    = keyCount;
+
+        for (uint32_t i = 0; i < keyCount; ++i)
+        {
+            PipelineProfileEntry& entry = m_compileCostProfile.pEntries[i];
+
+            for (uint32_t stage = 0; stage < ShaderStageCount; ++stage)
+            {
+                const ShaderOptimizerKey& shaderKey = pKeys[i].shaders[stage];
+                ShaderProfilePattern&     pattern   = entry.pattern.shaders[stage];
+
+                if (shaderKey.codeSize != 0)
+                {
+                    pattern.match.stageActive = true;
+                    pattern.match.codeHash    = true;
+                    pattern.codeHash          = shaderKey.codeHash;
+
+                    entry.action.shaders[stage].shaderCreate.apply.disableLoopUnrolls = true;
+                }
+                else
+                {
+                    pattern.match.stageInactive = true;
+                }
+            }
+        }
+    }
+
+    m_pDevice->VkInstance()->FreeMem(pKeyMem);
+}
+
+// =====================================================================================================================
+// Turns the variants the pipeline autotuner settled on in earlier runs into profile entries.  The variant is an action
+// of the last active stage, which is where a pipeline's key first matches the pattern.
+void ShaderOptimizer::BuildAutotuneProfile()
+{
+    const PipelineAutotuner* pAutotuner = m_pDevice->GetPipelineAutotuner();
+
+    if (pAutotuner->IsEnabled() == false)
+    {
+        return;
+    }
+
+    const VkAllocationCallbacks* pAllocCB = m_pDevice->VkInstance()->GetAllocCallbacks();
+
+    const uint32_t capacity = PipelineAutotuner::MaxRecords;
+    void*          pKeyMem  = m_pDevice->VkInstance()->AllocMem(
+                                  capacity * (sizeof(PipelineOptimizerKey) + sizeof(AutotuneVariant)),
+                                  VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+
+    if (pKeyMem == nullptr)
+    {
+        return;
+    }
+
+    PipelineOptimizerKey* pKeys     = static_cast<PipelineOptimizerKey*>(pKeyMem);
+    AutotuneVariant*      pVariants = static_cast<AutotuneVariant*>(Util::VoidPtrInc(pKeyMem,
+                                                                    capacity * sizeof(PipelineOptimizerKey)));
+
+    const uint32_t keyCount = pAutotuner->GetTunedPipelines(capacity, pKeys, pVariants);
+
+    size_t newSize = keyCount * sizeof(PipelineProfileEntry);
+    void*  pMemory = (keyCount > 0) ? pAllocCB->pfnAllocation(pAllocCB->pUserData,
+                                                              newSize,
+                                                              VK_DEFAULT_MEM_ALIGN,
+                                                              VK_SYSTEM_ALLOCATION_SCOPE_OBJECT) : nullptr;
+
+    if (pMemory != nullptr)
+    {
+        memset(pMemory, 0, newSize);
+
+        m_autotuneProfile.pEntries      = static_cast<PipelineProfileEntry*>(pMemory);
+        m_autotuneProfile.entryCapacity = keyCount;
+        m_autotuneProfile.entryCount    = keyCount;
+
+        for (uint32_t i = 0; i < keyCount; ++i)
+        {
+            PipelineProfileEntry& entry = m_autotuneProfile.pEntries[i];
+
+            for (uint32_t stage = 0; stage < ShaderStageCount; ++stage)
+            {
+                const ShaderOptimizerKey& shaderKey = pKeys[i].shaders[stage];
+                ShaderProfilePattern&     pattern   = entry.pattern.shaders[stage];
+
+                if (shaderKey.codeSize != 0)
+                {
+                    pattern.match.stageActive = true;
+                    pattern.match.codeHash    = true;
+                    pattern.codeHash          = shaderKey.codeHash;
+                }
+                else
+                {
+                    pattern.match.stageInactive = true;
+                }
+            }
+
+            auto& shaderCreate = entry.action.shaders[PipelineAutotuner::GetTunedStage(pKeys[i])].shaderCreate;
+
+            switch (pVariants[i])
+            {
+            case AutotuneVariantWave32:
+            case AutotuneVariantWave64:
+                shaderCreate.apply.waveSize         = true;
+                shaderCreate.tuningOptions.waveSize = (pVariants[i] == AutotuneVariantWave32) ? 32 : 64;
+                break;
+            case AutotuneVariantNggCulling:
+                shaderCreate.apply.nggEnableBackfaceCulling = true;
+                shaderCreate.apply.nggEnableFrustumCulling  = true;
+                shaderCreate.apply.nggEnableSmallPrimFilter = true;
+                break;
+            default:
+                VK_NEVER_CALLED();
+                break;
+            }
+        }
+    }
+
+    m_pDevice->VkInstance()->FreeMem(pKeyMem);
+}
+
 // =====================================================================================================================
 void ShaderOptimizer::BuildAppProfile()
 {
@@ -831,8 +1244,8 @@ void ShaderOptimizer::BuildRuntimeProfile()
 
     memset(pMemory, 0, newSize);
 
-    utils::JsonSettings jsonSettings = utils::JsonMakeInstanceSettings(m_pDevice->VkInstance());
-    utils::Json* pJson               = nullptr;
+    void*  pJsonBuffer = nullptr;
+    size_t jsonSize    = 0;
 
     if (m_settings.pipelineProfileRuntimeFile[0] != '\0')
     {
@@ -842,44 +1255,173 @@ void ShaderOptimizer::BuildRuntimeProfile()
         {
             size_t size = jsonFile.GetFileSize(m_settings.pipelineProfileRuntimeFile);
 
-            void* pJsonBuffer = m_pDevice->VkInstance()->AllocMem(size, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+            pJsonBuffer = m_pDevice->VkInstance()->AllocMem(size, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
 
             if (pJsonBuffer != nullptr)
             {
-                size_t bytesRead = 0;
+                jsonFile.Read(pJsonBuffer, size, &jsonSize);
+            }
 
-                jsonFile.Read(pJsonBuffer, size, &bytesRead);
+            jsonFile.Close();
+        }
+    }
 
-                if (bytesRead > 0)
-                {
-                    pJson = utils::JsonParse(jsonSettings, pJsonBuffer, bytesRead);
+    uint64_t sourceHash = 0;
 
-                    if (pJson != nullptr)
-                    {
-                        bool success = m_appShaderProfile.ParseJsonProfile(
-                            pJson,
-                            &m_runtimeProfile,
-                            m_pDevice->VkInstance()->GetAllocCallbacks());
-
-                        if (success == false)
-                        {
-                            // Failed to parse some part of the profile (e.g. unsupported/missing key name)
-                            RuntimeProfileParseError();
-                        }
-
-                        utils::JsonDestroy(jsonSettings, pJson);
-                    }
-                    else
-                    {
-                        // Failed to parse JSON file entirely
-                        RuntimeProfileParseError();
-                    }
-                }
+    if (jsonSize > 0)
+    {
+        Util::MetroHash::Hash hash = {};
+        Util::MetroHash64::Hash(static_cast<const uint8_t*>(pJsonBuffer), jsonSize, hash.bytes);
+
+        sourceHash = Util::MetroHash::Compact64(&hash);
+    }
+
+    // A binary profile converted from the same JSON (or used without any JSON) skips parsing altogether.
+    const bool mapped = (m_settings.pipelineProfileRuntimeBinaryFile[0] != '\0') &&
+                        MapRuntimeProfileBinary((jsonSize > 0), sourceHash);
+
+    if ((mapped == false) && (jsonSize > 0))
+    {
+        // The buffer is a private copy of the file, so it can be parsed in place.  Nothing below keeps pointers into
+        // the tree once the profile has been filled in.
+        utils::TempMemArena arena(m_pDevice->VkInstance()->GetAllocCallbacks(), VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+        utils::Json*        pJson = utils::JsonParseInSitu(&arena, pJsonBuffer, jsonSize);
+
+        if (pJson != nullptr)
+        {
+            bool success = m_appShaderProfile.ParseJsonProfile(
+                pJson,
+                &m_runtimeProfile,
+                m_pDevice->VkInstance()->GetAllocCallbacks());
 
-                m_pDevice->VkInstance()->FreeMem(pJsonBuffer);
+            if (success == false)
+            {
+                // Failed to parse some part of the profile (e.g. unsupported/missing key name)
+                RuntimeProfileParseError();
+            }
+            else if (m_settings.pipelineProfileRuntimeBinaryFile[0] != '\0')
+            {
+                WriteRuntimeProfileBinary(sourceHash);
             }
+        }
+        else
+        {
+            // Failed to parse JSON file entirely
+            RuntimeProfileParseError();
+        }
+    }
 
-            jsonFile.Close();
+    if (pJsonBuffer != nullptr)
+    {
+        m_pDevice->VkInstance()->FreeMem(pJsonBuffer);
+    }
+}
+
+// =====================================================================================================================
+// Maps PipelineProfileRuntimeBinaryFile and uses its entries as the runtime profile.  The mapping is read-only and
+// shared with every other process using the same file.  If hasSource is set, the file is only used if it was converted
+// from a JSON profile with the given hash.  Returns false if the file is missing, stale or doesn't match this driver.
+bool ShaderOptimizer::MapRuntimeProfileBinary(
+    bool     hasSource,
+    uint64_t sourceHash)
+{
+    static_assert((sizeof(RuntimeProfileFileHeader) % alignof(PipelineProfileEntry)) == 0,
+                  "Profile entries following the header must stay aligned.");
+
+    VK_ASSERT(m_pRuntimeProfileMapping == nullptr);
+
+    const int fd = open(m_settings.pipelineProfileRuntimeBinaryFile, O_RDONLY);
+
+    if (fd >= 0)
+    {
+        struct stat fileStat = {};
+
+        if ((fstat(fd, &fileStat) == 0) && (static_cast<size_t>(fileStat.st_size) >= sizeof(RuntimeProfileFileHeader)))
+        {
+            const size_t fileSize = static_cast<size_t>(fileStat.st_size);
+            void*        pMapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+
+            if (pMapping != MAP_FAILED)
+            {
+                const RuntimeProfileFileHeader* pHeader = static_cast<const RuntimeProfileFileHeader*>(pMapping);
+
+                const size_t entryBytes = static_cast<size_t>(pHeader->entryCount) * sizeof(PipelineProfileEntry);
+
+                if ((pHeader->magic      == RuntimeProfileFileMagic)                            &&
+                    (pHeader->version    == RuntimeProfileFileVersion)                          &&
+                    (pHeader->entrySize  == sizeof(PipelineProfileEntry))                       &&
+                    (entryBytes          == (fileSize - sizeof(RuntimeProfileFileHeader)))      &&
+                    ((hasSource == false) || (pHeader->sourceHash == sourceHash)))
+                {
+                    m_pRuntimeProfileMapping    = pMapping;
+                    m_runtimeProfileMappingSize = fileSize;
+                }
+                else
+                {
+                    munmap(pMapping, fileSize);
+                }
+            }
+        }
+
+        // The mapping keeps its own reference to the file.
+        close(fd);
+    }
+
+    if (m_pRuntimeProfileMapping != nullptr)
+    {
+        const RuntimeProfileFileHeader* pHeader =
+            static_cast<const RuntimeProfileFileHeader*>(m_pRuntimeProfileMapping);
+
+        const VkAllocationCallbacks* pAllocCB = m_pDevice->VkInstance()->GetAllocCallbacks();
+
+        pAllocCB->pfnFree(pAllocCB->pUserData, m_runtimeProfile.pEntries);
+
+        // The entries are only ever read after the profile is built, so they can live in the read-only mapping.
+        m_runtimeProfile.pEntries      = static_cast<PipelineProfileEntry*>(
+            Util::VoidPtrInc(m_pRuntimeProfileMapping, sizeof(RuntimeProfileFileHeader)));
+        m_runtimeProfile.entryCount    = pHeader->entryCount;
+        m_runtimeProfile.entryCapacity = pHeader->entryCount;
+    }
+
+    return (m_pRuntimeProfileMapping != nullptr);
+}
+
+// =====================================================================================================================
+// Converts the parsed runtime profile into PipelineProfileRuntimeBinaryFile, so later runs can map it instead of
+// parsing the JSON again.  The file is written under a temporary name and renamed into place, because other processes
+// may have the old file mapped.
+void ShaderOptimizer::WriteRuntimeProfileBinary(
+    uint64_t sourceHash
+    ) const
+{
+    char tempPath[Util::PathBufferLen] = {};
+    Util::Snprintf(tempPath, sizeof(tempPath), "%s.%d.tmp", m_settings.pipelineProfileRuntimeBinaryFile, getpid());
+
+    Util::File file;
+
+    if (file.Open(tempPath, Util::FileAccessWrite | Util::FileAccessBinary) == Util::Result::Success)
+    {
+        RuntimeProfileFileHeader header = {};
+        header.magic      = RuntimeProfileFileMagic;
+        header.version    = RuntimeProfileFileVersion;
+        header.entrySize  = sizeof(PipelineProfileEntry);
+        header.entryCount = m_runtimeProfile.entryCount;
+        header.sourceHash = sourceHash;
+
+        Util::Result result = file.Write(&header, sizeof(header));
+
+        if ((result == Util::Result::Success) && (m_runtimeProfile.entryCount > 0))
+        {
+            result = file.Write(m_runtimeProfile.pEntries, m_runtimeProfile.entryCount * sizeof(PipelineProfileEntry));
+        }
+
+        VK_ALERT(result != Util::Result::Success);
+
+        file.Close();
+
+        if ((result != Util::Result::Success) || (rename(tempPath, m_settings.pipelineProfileRuntimeBinaryFile) != 0))
+        {
+            remove(tempPath);
         }
     }
 }
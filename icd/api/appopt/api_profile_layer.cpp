@@ -0,0 +1,253 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  api_profile_layer.cpp
+* @brief Implementation of the API profile layer.
+***********************************************************************************************************************
+*/
+
+#include "api_profile_layer.h"
+
+#include "include/vk_cmdbuffer.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+#include "include/vk_queue.h"
+
+#include "utils/json_writer.h"
+
+#include "palJsonWriter.h"
+#include "palSysUtil.h"
+
+#include <algorithm>
+
+namespace vk
+{
+
+// =====================================================================================================================
+ApiProfileLayer::ApiProfileLayer(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_counters(pDevice->VkInstance()->GetAllocCallbacks(), VK_SYSTEM_ALLOCATION_SCOPE_DEVICE)
+{
+    memset(m_pNames, 0, sizeof(m_pNames));
+}
+
+// =====================================================================================================================
+ApiProfileLayer::~ApiProfileLayer()
+{
+}
+
+// =====================================================================================================================
+// Returns the calling thread's counters, or null if they couldn't be allocated.
+VK_FORCEINLINE ApiProfileLayer::ThreadCounters* ApiProfileLayer::GetThreadCounters()
+{
+    return m_counters.Get([](ThreadCounters* pNew) { memset(pNew, 0, sizeof(ThreadCounters)); });
+}
+
+// =====================================================================================================================
+// Appends the call counts and CPU times summed over all threads to a file as JSON, sorted by total time.
+void ApiProfileLayer::WriteReport(
+    const char* pFilePath) const
+{
+    uint64_t callCount[VKI_ENTRY_POINT_COUNT] = {};
+    uint64_t ticks[VKI_ENTRY_POINT_COUNT]     = {};
+    uint32_t sorted[VKI_ENTRY_POINT_COUNT];
+    uint32_t sortedCount = 0;
+    uint32_t threadCount = 0;
+
+    m_counters.ForEach([&](const ThreadCounters* pCounters)
+    {
+        for (uint32_t i = 0; i < VKI_ENTRY_POINT_COUNT; ++i)
+        {
+            callCount[i] += pCounters->callCount[i];
+            ticks[i]     += pCounters->ticks[i];
+        }
+
+        threadCount++;
+    });
+
+    for (uint32_t i = 0; i < VKI_ENTRY_POINT_COUNT; ++i)
+    {
+        if (callCount[i] > 0)
+        {
+            sorted[sortedCount++] = i;
+        }
+    }
+
+    std::sort(sorted, sorted + sortedCount, [&ticks](uint32_t a, uint32_t b) { return ticks[a] > ticks[b]; });
+
+    const uint64_t frequency = Util::GetPerfFrequency();
+
+    utils::JsonOutputStream stream(pFilePath);
+    Util::JsonWriter        writer(&stream);
+
+    writer.BeginMap(false);
+    writer.KeyAndValue("timestampMs", static_cast<uint64_t>((Util::GetPerfCpuTime() * 1000) / frequency));
+    writer.KeyAndValue("threads", threadCount);
+    writer.KeyAndBeginList("apiCalls", false);
+
+    for (uint32_t i = 0; i < sortedCount; ++i)
+    {
+        const uint32_t entry   = sorted[i];
+        const uint64_t totalNs = (ticks[entry] * 1000000000) / frequency;
+
+        writer.BeginMap(true);
+        writer.KeyAndValue("name", m_pNames[entry]);
+        writer.KeyAndValue("count", callCount[entry]);
+        writer.KeyAndValue("totalUs", totalNs / 1000);
+        writer.KeyAndValue("avgNs", totalNs / callCount[entry]);
+        writer.EndMap();
+    }
+
+    writer.EndList();
+    writer.EndMap();
+}
+
+namespace entry
+{
+
+namespace api_profile_layer
+{
+
+// =====================================================================================================================
+// Device-level entry points are dispatched through a VkDevice, VkQueue or VkCommandBuffer.  The few taking an instance
+// or physical device handle map to no device and are left unwrapped.
+template <typename Handle>
+static Device* DeviceOf(Handle)
+{
+    return nullptr;
+}
+
+static Device* DeviceOf(VkDevice device)
+{
+    return ApiDevice::ObjectFromHandle(device);
+}
+
+static Device* DeviceOf(VkQueue queue)
+{
+    return ApiQueue::ObjectFromHandle(queue)->VkDevice();
+}
+
+static Device* DeviceOf(VkCommandBuffer cmdBuffer)
+{
+    return ApiCmdBuffer::ObjectFromHandle(cmdBuffer)->VkDevice();
+}
+
+template <typename Handle> struct IsDeviceHandle                  { static constexpr bool Value = false; };
+template <>                struct IsDeviceHandle<VkDevice>        { static constexpr bool Value = true;  };
+template <>                struct IsDeviceHandle<VkQueue>         { static constexpr bool Value = true;  };
+template <>                struct IsDeviceHandle<VkCommandBuffer> { static constexpr bool Value = true;  };
+
+// Adds the time since construction to an entry point's counters, after the next layer's call has returned.
+class CallScope
+{
+public:
+    VK_FORCEINLINE CallScope(
+        ApiProfileLayer::ThreadCounters* pCounters,
+        uint32_t                         entryIndex)
+        :
+        m_pCounters(pCounters),
+        m_entryIndex(entryIndex),
+        m_startTicks(Util::GetPerfCpuTime())
+    {
+    }
+
+    VK_FORCEINLINE ~CallScope()
+    {
+        if (m_pCounters != nullptr)
+        {
+            m_pCounters->callCount[m_entryIndex]++;
+            m_pCounters->ticks[m_entryIndex] += Util::GetPerfCpuTime() - m_startTicks;
+        }
+    }
+
+private:
+    ApiProfileLayer::ThreadCounters* const m_pCounters;
+    const uint32_t                         m_entryIndex;
+    const uint64_t                         m_startTicks;
+};
+
+// =====================================================================================================================
+// Wrapper of one entry point, generated from its PFN type.
+template <uint32_t EntryIndex, typename Func>
+struct ProfiledEntry;
+
+template <uint32_t EntryIndex, typename Ret, typename Handle, typename... Args>
+struct ProfiledEntry<EntryIndex, Ret (VKAPI_PTR*)(Handle, Args...)>
+{
+    typedef Ret (VKAPI_PTR* Func)(Handle, Args...);
+
+    static VKAPI_ATTR Ret VKAPI_CALL Call(
+        Handle  handle,
+        Args... args)
+    {
+        ApiProfileLayer* pLayer = DeviceOf(handle)->GetApiProfileLayer();
+
+        CallScope scope(pLayer->GetThreadCounters(), EntryIndex);
+
+        return reinterpret_cast<Func>(pLayer->GetNextLayer()->GetEntryPoint(EntryIndex))(handle, args...);
+    }
+
+    static Func Get()
+    {
+        return IsDeviceHandle<Handle>::Value ? &Call : nullptr;
+    }
+};
+
+} // namespace api_profile_layer
+
+} // namespace entry
+
+// =====================================================================================================================
+void ApiProfileLayer::OverrideDispatchTable(
+    DispatchTable* pDispatchTable)
+{
+    // Save current device dispatch table to use as the next layer.
+    m_nextLayer = *pDispatchTable;
+
+    // Wrap every device-level entry point the device exposes.
+#define VKI_DEVICE_ENTRY_POINT(entry_name) \
+    { \
+        PFN_##entry_name pWrapper = \
+            vk::entry::api_profile_layer::ProfiledEntry<entry_name##_index, PFN_##entry_name>::Get(); \
+        if ((pWrapper != nullptr) && (m_nextLayer.GetEntryPoints().entry_name != nullptr)) \
+        { \
+            pDispatchTable->OverrideEntryPoints()->entry_name = pWrapper; \
+            m_pNames[entry_name##_index] = vk::strings::entry::entry_name##_name; \
+        } \
+    }
+
+#include "strings/g_device_entry_points.h"
+
+#undef VKI_DEVICE_ENTRY_POINT
+
+    // The layer is gone by the time vkDestroyDevice returns, so it can't be counted.
+    pDispatchTable->OverrideEntryPoints()->vkDestroyDevice = m_nextLayer.GetEntryPoints().vkDestroyDevice;
+    m_pNames[vkDestroyDevice_index] = nullptr;
+}
+
+} // namespace vk
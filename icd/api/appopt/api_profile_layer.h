@@ -1,7 +1,7 @@
 /*
  ***********************************************************************************************************************
  *
- *  Copyright (c) 2014-2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
  *
  *  Permission is hereby granted, free of charge, to any person obtaining a copy
  *  of this software and associated documentation files (the "Software"), to deal
@@ -24,34 +24,56 @@
  **********************************************************************************************************************/
 /**
 ***********************************************************************************************************************
-* @file  strange_brigade_layer.h
-* @brief Contains shadowed entry points related to strange brigade.
+* @file  api_profile_layer.h
+* @brief Counts the calls and CPU time spent in every device-level entry point.
 ***********************************************************************************************************************
 */
 
-#ifndef __STRANGE_BRIGADE_LAYER_H__
-#define __STRANGE_BRIGADE_LAYER_H__
+#ifndef __API_PROFILE_LAYER_H__
+#define __API_PROFILE_LAYER_H__
 
 #pragma once
 
 #include "opt_layer.h"
 
+#include "utils/per_thread_registry.h"
+
 namespace vk
 {
+
+class Device;
+
 // =====================================================================================================================
-// Class for the Strange Brigade Layer to simplify calls to the overriden dispatch table from the layer's entrypoints
-class StrangeBrigadeLayer final : public OptLayer
+// Wraps every device-level entry point to count its calls and the CPU time spent in the driver below it.  Each thread
+// counts into its own counters, so the only lock taken is when a thread calls into the device for the first time.  A
+// report sorted by total time is written when the device is destroyed.
+class ApiProfileLayer final : public OptLayer
 {
 public:
-    StrangeBrigadeLayer() {}
-    virtual ~StrangeBrigadeLayer() {}
+    // Per-thread counters, indexed by entry point
+    struct ThreadCounters
+    {
+        uint64_t callCount[VKI_ENTRY_POINT_COUNT];    // Calls per entry point
+        uint64_t ticks[VKI_ENTRY_POINT_COUNT];        // Performance counter ticks per entry point
+    };
+
+    ApiProfileLayer(Device* pDevice);
+    virtual ~ApiProfileLayer();
 
     virtual void OverrideDispatchTable(DispatchTable* pDispatchTable) override;
 
+    ThreadCounters* GetThreadCounters();
+
+    void WriteReport(const char* pFilePath) const;
+
 private:
-    PAL_DISALLOW_COPY_AND_ASSIGN(StrangeBrigadeLayer);
+    PAL_DISALLOW_COPY_AND_ASSIGN(ApiProfileLayer);
+
+    Device* const                            m_pDevice;
+    utils::PerThreadRegistry<ThreadCounters> m_counters;                      // Of every thread that called the device
+    const char*                              m_pNames[VKI_ENTRY_POINT_COUNT]; // Names of the wrapped entry points
 };
 
-}; // namespace vk
+} // namespace vk
 
-#endif /* __STRANGE_BRIGADE_LAYER_H__ */
+#endif /* __API_PROFILE_LAYER_H__ */
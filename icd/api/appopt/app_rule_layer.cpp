@@ -0,0 +1,650 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  app_rule_layer.cpp
+* @brief Implementation of the optimization layer applying per-application rules.
+***********************************************************************************************************************
+*/
+
+#include "app_rule_layer.h"
+
+#include "include/vk_cmdbuffer.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+#include "include/vk_utils.h"
+
+#include "utils/json_reader.h"
+#include "utils/temp_mem_arena.h"
+
+#include "palFile.h"
+#include "palInlineFuncs.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+AppRuleLayer::AppRuleLayer(
+    const AppOptRules& rules)
+    :
+    m_rules(rules)
+{
+}
+
+// =====================================================================================================================
+// Returns true if any rule is enabled
+bool AppRuleLayer::HasRules(
+    const AppOptRules& rules)
+{
+    return (rules.barrierFilter.transitionCount > 0) ||
+           (rules.elideDynamicState.u32All != 0)     ||
+           (rules.descriptorPool.minSets > 0)        ||
+           (rules.descriptorPool.sizeScale > 1.0f);
+}
+
+// =====================================================================================================================
+// Fills in the rules of the running title: the built-in rules of its application profile, unless a profile in
+// AppOptRuleFile matches it.
+void AppRuleLayer::BuildRules(
+    Device*      pDevice,
+    AppOptRules* pRules)
+{
+    memset(pRules, 0, sizeof(*pRules));
+
+    const char* pRuleFile = pDevice->GetRuntimeSettings().appOptRuleFile;
+
+    if ((pRuleFile[0] == '\0') || (LoadRuleFile(pDevice, pRuleFile, pRules) == false))
+    {
+        GetBuiltInRules(pDevice->GetAppProfile(), pRules);
+    }
+}
+
+// =====================================================================================================================
+// The rules shipped with the driver
+void AppRuleLayer::GetBuiltInRules(
+    AppProfile   appProfile,
+    AppOptRules* pRules)
+{
+    switch (appProfile)
+    {
+    case AppProfile::StrangeBrigade:
+        // This app transitions from VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL to VK_IMAGE_LAYOUT_GENERAL and then back
+        // again.  Such transitions were found in barriers with less than 5 images, which were the majority of barriers.
+        pRules->barrierFilter.maxImageBarriers                = 4;
+        pRules->barrierFilter.transitionCount                 = 2;
+        pRules->barrierFilter.transitions[0].oldLayout        = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        pRules->barrierFilter.transitions[0].newLayout        = VK_IMAGE_LAYOUT_GENERAL;
+        pRules->barrierFilter.transitions[1].oldLayout        = VK_IMAGE_LAYOUT_GENERAL;
+        pRules->barrierFilter.transitions[1].newLayout        = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        break;
+    default:
+        break;
+    }
+}
+
+// =====================================================================================================================
+// Reads AppOptRuleFile and takes the rules of its first profile matching the running title.  The file looks like:
+//
+// {
+//   "profiles": [
+//     {
+//       "match":             { "exeName": "Game.exe", "appName": "Game" },
+//       "barrierFilter":     { "maxImageBarriers": 4,
+//                              "skipTransitions": [ { "oldLayout": "VK_IMAGE_LAYOUT_GENERAL",
+//                                                     "newLayout": "VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL" } ] },
+//       "elideDynamicState": [ "lineWidth", "depthBounds" ],
+//       "descriptorPool":    { "minSets": 1024, "sizeScale": 2.0 }
+//     }
+//   ]
+// }
+//
+// Every key is optional; a profile without "match" matches any title and a matching profile without rules disables
+// the built-in ones.  Returns false if the file can't be read or parsed or no profile matches.
+bool AppRuleLayer::LoadRuleFile(
+    Device*      pDevice,
+    const char*  pFilePath,
+    AppOptRules* pRules)
+{
+    Instance* pInstance = pDevice->VkInstance();
+    bool      found     = false;
+
+    void*      pJsonBuffer = nullptr;
+    size_t     jsonSize    = 0;
+    Util::File jsonFile;
+
+    if (jsonFile.Open(pFilePath, Util::FileAccessRead) == Pal::Result::Success)
+    {
+        const size_t size = jsonFile.GetFileSize(pFilePath);
+
+        pJsonBuffer = pInstance->AllocMem(size, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+
+        if (pJsonBuffer != nullptr)
+        {
+            jsonFile.Read(pJsonBuffer, size, &jsonSize);
+        }
+
+        jsonFile.Close();
+    }
+
+    if (jsonSize > 0)
+    {
+        // Nothing below keeps pointers into the tree, so the private copy of the file can be parsed in place.
+        utils::TempMemArena arena(pInstance->GetAllocCallbacks(), VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+        utils::Json*        pJson     = utils::JsonParseInSitu(&arena, pJsonBuffer, jsonSize);
+        utils::Json*        pProfiles = (pJson != nullptr) ? utils::JsonGetValue(pJson, "profiles") : nullptr;
+
+        if ((pProfiles != nullptr) && (pProfiles->type == utils::JsonValueType::Array))
+        {
+            for (utils::Json* pProfile = pProfiles->pChild; (pProfile != nullptr) && (found == false);
+                 pProfile = pProfile->pNext)
+            {
+                if ((pProfile->type == utils::JsonValueType::Object) &&
+                    MatchesApplication(pDevice, utils::JsonGetValue(pProfile, "match")))
+                {
+                    found = ParseRules(pProfile, pRules);
+
+                    VK_ASSERT(found && "Failed to parse a profile of AppOptRuleFile");
+                }
+            }
+        }
+        else
+        {
+            VK_ASSERT(false && "Failed to parse AppOptRuleFile");
+        }
+    }
+
+    if (pJsonBuffer != nullptr)
+    {
+        pInstance->FreeMem(pJsonBuffer);
+    }
+
+    if (found == false)
+    {
+        memset(pRules, 0, sizeof(*pRules));
+    }
+
+    return found;
+}
+
+// =====================================================================================================================
+// Returns true if the executable and application names listed by a "match" object are those of the running title.
+// Names are compared case-insensitively.
+bool AppRuleLayer::MatchesApplication(
+    Device*      pDevice,
+    utils::Json* pMatch)
+{
+    bool matches = true;
+
+    if (pMatch != nullptr)
+    {
+        for (utils::Json* pItem = pMatch->pChild; (pItem != nullptr) && matches; pItem = pItem->pNext)
+        {
+            if (pItem->type != utils::JsonValueType::String)
+            {
+                matches = false;
+            }
+            else if (strcmp(pItem->pKey, "exeName") == 0)
+            {
+                char exeName[PATH_MAX];
+                char exePath[PATH_MAX];
+
+                utils::GetExecutableNameAndPath(exeName, exePath);
+
+                matches = (Util::Strcasecmp(exeName, pItem->pStringValue) == 0);
+            }
+            else if (strcmp(pItem->pKey, "appName") == 0)
+            {
+                const char* pAppName = pDevice->VkInstance()->GetApplicationName();
+
+                matches = (pAppName != nullptr) && (Util::Strcasecmp(pAppName, pItem->pStringValue) == 0);
+            }
+            else
+            {
+                VK_ASSERT(false && "Unknown key in an AppOptRuleFile match object");
+
+                matches = false;
+            }
+        }
+    }
+
+    return matches;
+}
+
+// =====================================================================================================================
+// Converts an image layout given by name or value.  Returns false for unknown names.
+static bool ParseImageLayout(
+    const utils::Json* pValue,
+    VkImageLayout*     pLayout)
+{
+    static constexpr struct
+    {
+        const char*   pName;
+        VkImageLayout layout;
+    } LayoutNames[] =
+    {
+        { "VK_IMAGE_LAYOUT_UNDEFINED",                        VK_IMAGE_LAYOUT_UNDEFINED },
+        { "VK_IMAGE_LAYOUT_GENERAL",                          VK_IMAGE_LAYOUT_GENERAL },
+        { "VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL",         VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+        { "VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL", VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL },
+        { "VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL",  VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL },
+        { "VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL",         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+        { "VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL",             VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL },
+        { "VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL",             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL },
+        { "VK_IMAGE_LAYOUT_PREINITIALIZED",                   VK_IMAGE_LAYOUT_PREINITIALIZED },
+        { "VK_IMAGE_LAYOUT_PRESENT_SRC_KHR",                  VK_IMAGE_LAYOUT_PRESENT_SRC_KHR },
+    };
+
+    bool success = false;
+
+    if (pValue != nullptr)
+    {
+        if (pValue->type == utils::JsonValueType::Number)
+        {
+            *pLayout = static_cast<VkImageLayout>(pValue->integerValue);
+            success  = true;
+        }
+        else if (pValue->type == utils::JsonValueType::String)
+        {
+            for (uint32_t i = 0; (i < VK_ARRAY_SIZE(LayoutNames)) && (success == false); ++i)
+            {
+                if (strcmp(pValue->pStringValue, LayoutNames[i].pName) == 0)
+                {
+                    *pLayout = LayoutNames[i].layout;
+                    success  = true;
+                }
+            }
+        }
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Fills in the rules declared by one profile of AppOptRuleFile.  Returns false if any part of it is not understood.
+bool AppRuleLayer::ParseRules(
+    utils::Json* pProfile,
+    AppOptRules* pRules)
+{
+    bool success = true;
+
+    memset(pRules, 0, sizeof(*pRules));
+
+    for (utils::Json* pItem = pProfile->pChild; (pItem != nullptr) && success; pItem = pItem->pNext)
+    {
+        if (strcmp(pItem->pKey, "match") == 0)
+        {
+            // Already checked by MatchesApplication()
+        }
+        else if (strcmp(pItem->pKey, "barrierFilter") == 0)
+        {
+            utils::Json* pMax         = utils::JsonGetValue(pItem, "maxImageBarriers");
+            utils::Json* pTransitions = utils::JsonGetValue(pItem, "skipTransitions");
+
+            if (pMax != nullptr)
+            {
+                success = (pMax->type == utils::JsonValueType::Number);
+
+                pRules->barrierFilter.maxImageBarriers = static_cast<uint32_t>(pMax->integerValue);
+            }
+
+            success &= (pTransitions != nullptr) &&
+                       (pTransitions->type == utils::JsonValueType::Array) &&
+                       (utils::JsonArraySize(pTransitions) <= AppOptRules::MaxSkippedTransitions);
+
+            for (utils::Json* pTransition = success ? pTransitions->pChild : nullptr;
+                 (pTransition != nullptr) && success;
+                 pTransition = pTransition->pNext)
+            {
+                auto* pSkipped = &pRules->barrierFilter.transitions[pRules->barrierFilter.transitionCount++];
+
+                success = ParseImageLayout(utils::JsonGetValue(pTransition, "oldLayout"), &pSkipped->oldLayout) &&
+                          ParseImageLayout(utils::JsonGetValue(pTransition, "newLayout"), &pSkipped->newLayout);
+            }
+        }
+        else if (strcmp(pItem->pKey, "elideDynamicState") == 0)
+        {
+            success = (pItem->type == utils::JsonValueType::Array);
+
+            for (utils::Json* pState = success ? pItem->pChild : nullptr;
+                 (pState != nullptr) && success;
+                 pState = pState->pNext)
+            {
+                const char* pName = (pState->type == utils::JsonValueType::String) ? pState->pStringValue : "";
+
+                if (strcmp(pName, "lineWidth") == 0)
+                {
+                    pRules->elideDynamicState.lineWidth = 1;
+                }
+                else if (strcmp(pName, "depthBias") == 0)
+                {
+                    pRules->elideDynamicState.depthBias = 1;
+                }
+                else if (strcmp(pName, "blendConstants") == 0)
+                {
+                    pRules->elideDynamicState.blendConstants = 1;
+                }
+                else if (strcmp(pName, "depthBounds") == 0)
+                {
+                    pRules->elideDynamicState.depthBounds = 1;
+                }
+                else if (strcmp(pName, "stencilCompareMask") == 0)
+                {
+                    pRules->elideDynamicState.stencilCompareMask = 1;
+                }
+                else if (strcmp(pName, "stencilWriteMask") == 0)
+                {
+                    pRules->elideDynamicState.stencilWriteMask = 1;
+                }
+                else if (strcmp(pName, "stencilReference") == 0)
+                {
+                    pRules->elideDynamicState.stencilReference = 1;
+                }
+                else
+                {
+                    success = false;
+                }
+            }
+        }
+        else if (strcmp(pItem->pKey, "descriptorPool") == 0)
+        {
+            utils::Json* pMinSets   = utils::JsonGetValue(pItem, "minSets");
+            utils::Json* pSizeScale = utils::JsonGetValue(pItem, "sizeScale");
+
+            if (pMinSets != nullptr)
+            {
+                success &= (pMinSets->type == utils::JsonValueType::Number);
+
+                pRules->descriptorPool.minSets = static_cast<uint32_t>(pMinSets->integerValue);
+            }
+
+            if (pSizeScale != nullptr)
+            {
+                success &= (pSizeScale->type == utils::JsonValueType::Number);
+
+                pRules->descriptorPool.sizeScale = static_cast<float>(pSizeScale->doubleValue);
+            }
+        }
+        else
+        {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+namespace entry
+{
+
+namespace app_rule_layer
+{
+
+// =====================================================================================================================
+// Drops the image barriers between the layouts listed by the barrier filter rule.  The call is skipped if it has no
+// barriers left.
+VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier(
+    VkCommandBuffer                             cmdBuffer,
+    VkPipelineStageFlags                        srcStageMask,
+    VkPipelineStageFlags                        dstStageMask,
+    VkDependencyFlags                           dependencyFlags,
+    uint32_t                                    memoryBarrierCount,
+    const VkMemoryBarrier*                      pMemoryBarriers,
+    uint32_t                                    bufferMemoryBarrierCount,
+    const VkBufferMemoryBarrier*                pBufferMemoryBarriers,
+    uint32_t                                    imageMemoryBarrierCount,
+    const VkImageMemoryBarrier*                 pImageMemoryBarriers)
+{
+    CmdBuffer*          pCmdBuffer = ApiCmdBuffer::ObjectFromHandle(cmdBuffer);
+    const AppRuleLayer* pLayer     = static_cast<const AppRuleLayer*>(pCmdBuffer->VkDevice()->GetAppOptLayer());
+    const auto&         rule       = pLayer->GetRules().barrierFilter;
+
+    VirtualStackFrame     virtStackFrame(pCmdBuffer->GetStackAllocator());
+    VkImageMemoryBarrier* pImages    = nullptr;
+    uint32_t              imageCount = imageMemoryBarrierCount;
+
+    if ((imageMemoryBarrierCount > 0) &&
+        ((rule.maxImageBarriers == 0) || (imageMemoryBarrierCount <= rule.maxImageBarriers)))
+    {
+        pImages = virtStackFrame.AllocArray<VkImageMemoryBarrier>(imageMemoryBarrierCount);
+
+        if (pImages != nullptr)
+        {
+            imageCount = 0;
+
+            for (uint32_t i = 0; i < imageMemoryBarrierCount; ++i)
+            {
+                bool skip = false;
+
+                for (uint32_t j = 0; (j < rule.transitionCount) && (skip == false); ++j)
+                {
+                    skip = (pImageMemoryBarriers[i].oldLayout == rule.transitions[j].oldLayout) &&
+                           (pImageMemoryBarriers[i].newLayout == rule.transitions[j].newLayout);
+                }
+
+                if (skip == false)
+                {
+                    pImages[imageCount++] = pImageMemoryBarriers[i];
+                }
+            }
+        }
+    }
+
+    if ((memoryBarrierCount + bufferMemoryBarrierCount + imageCount) > 0)
+    {
+        pLayer->GetNextLayer()->GetEntryPoints().vkCmdPipelineBarrier(
+            cmdBuffer,
+            srcStageMask,
+            dstStageMask,
+            dependencyFlags,
+            memoryBarrierCount,
+            pMemoryBarriers,
+            bufferMemoryBarrierCount,
+            pBufferMemoryBarriers,
+            imageCount,
+            (pImages != nullptr) ? pImages : pImageMemoryBarriers);
+    }
+
+    if (pImages != nullptr)
+    {
+        virtStackFrame.FreeArray(pImages);
+    }
+}
+
+// =====================================================================================================================
+// Applies the descriptor pool sizing hints
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorPool(
+    VkDevice                                    device,
+    const VkDescriptorPoolCreateInfo*           pCreateInfo,
+    const VkAllocationCallbacks*                pAllocator,
+    VkDescriptorPool*                           pDescriptorPool)
+{
+    Device*             pDevice = ApiDevice::ObjectFromHandle(device);
+    const AppRuleLayer* pLayer  = static_cast<const AppRuleLayer*>(pDevice->GetAppOptLayer());
+    const auto&         rule    = pLayer->GetRules().descriptorPool;
+
+    VkDescriptorPoolCreateInfo createInfo = *pCreateInfo;
+    VkDescriptorPoolSize*      pSizes     = nullptr;
+
+    createInfo.maxSets = Util::Max(createInfo.maxSets, rule.minSets);
+
+    if ((rule.sizeScale > 1.0f) && (createInfo.poolSizeCount > 0))
+    {
+        pSizes = static_cast<VkDescriptorPoolSize*>(pDevice->VkInstance()->AllocMem(
+            sizeof(VkDescriptorPoolSize) * createInfo.poolSizeCount,
+            VK_SYSTEM_ALLOCATION_SCOPE_COMMAND));
+
+        if (pSizes != nullptr)
+        {
+            for (uint32_t i = 0; i < createInfo.poolSizeCount; ++i)
+            {
+                pSizes[i] = pCreateInfo->pPoolSizes[i];
+
+                // Inline uniform block sizes are in bytes and must stay a multiple of 4, so they are left alone.
+                if (pSizes[i].type != VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT)
+                {
+                    pSizes[i].descriptorCount = static_cast<uint32_t>(pSizes[i].descriptorCount * rule.sizeScale);
+                }
+            }
+
+            createInfo.pPoolSizes = pSizes;
+        }
+    }
+
+    const VkResult result = pLayer->GetNextLayer()->GetEntryPoints().vkCreateDescriptorPool(
+        device,
+        &createInfo,
+        pAllocator,
+        pDescriptorPool);
+
+    if (pSizes != nullptr)
+    {
+        pDevice->VkInstance()->FreeMem(pSizes);
+    }
+
+    return result;
+}
+
+// Dynamic state commands elided by a rule are dropped without reaching the command buffer.
+
+// =====================================================================================================================
+VKAPI_ATTR void VKAPI_CALL vkCmdSetLineWidth(
+    VkCommandBuffer                             cmdBuffer,
+    float                                       lineWidth)
+{
+}
+
+// =====================================================================================================================
+VKAPI_ATTR void VKAPI_CALL vkCmdSetDepthBias(
+    VkCommandBuffer                             cmdBuffer,
+    float                                       depthBiasConstantFactor,
+    float                                       depthBiasClamp,
+    float                                       depthBiasSlopeFactor)
+{
+}
+
+// =====================================================================================================================
+VKAPI_ATTR void VKAPI_CALL vkCmdSetBlendConstants(
+    VkCommandBuffer                             cmdBuffer,
+    const float                                 blendConstants[4])
+{
+}
+
+// =====================================================================================================================
+VKAPI_ATTR void VKAPI_CALL vkCmdSetDepthBounds(
+    VkCommandBuffer                             cmdBuffer,
+    float                                       minDepthBounds,
+    float                                       maxDepthBounds)
+{
+}
+
+// =====================================================================================================================
+VKAPI_ATTR void VKAPI_CALL vkCmdSetStencilCompareMask(
+    VkCommandBuffer                             cmdBuffer,
+    VkStencilFaceFlags                          faceMask,
+    uint32_t                                    compareMask)
+{
+}
+
+// =====================================================================================================================
+VKAPI_ATTR void VKAPI_CALL vkCmdSetStencilWriteMask(
+    VkCommandBuffer                             cmdBuffer,
+    VkStencilFaceFlags                          faceMask,
+    uint32_t                                    writeMask)
+{
+}
+
+// =====================================================================================================================
+VKAPI_ATTR void VKAPI_CALL vkCmdSetStencilReference(
+    VkCommandBuffer                             cmdBuffer,
+    VkStencilFaceFlags                          faceMask,
+    uint32_t                                    reference)
+{
+}
+
+} // namespace app_rule_layer
+
+} // namespace entry
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define APP_RULE_LAYER_OVERRIDE_ALIAS(entry_name, func_name) \
+    pDispatchTable->OverrideEntryPoints()->entry_name = vk::entry::app_rule_layer::func_name
+
+#define APP_RULE_LAYER_OVERRIDE_ENTRY(entry_name) APP_RULE_LAYER_OVERRIDE_ALIAS(entry_name, entry_name)
+
+// =====================================================================================================================
+void AppRuleLayer::OverrideDispatchTable(
+    DispatchTable* pDispatchTable)
+{
+    // Save current device dispatch table to use as the next layer.
+    m_nextLayer = *pDispatchTable;
+
+    if (m_rules.barrierFilter.transitionCount > 0)
+    {
+        APP_RULE_LAYER_OVERRIDE_ENTRY(vkCmdPipelineBarrier);
+    }
+
+    if ((m_rules.descriptorPool.minSets > 0) || (m_rules.descriptorPool.sizeScale > 1.0f))
+    {
+        APP_RULE_LAYER_OVERRIDE_ENTRY(vkCreateDescriptorPool);
+    }
+
+    if (m_rules.elideDynamicState.lineWidth)
+    {
+        APP_RULE_LAYER_OVERRIDE_ENTRY(vkCmdSetLineWidth);
+    }
+
+    if (m_rules.elideDynamicState.depthBias)
+    {
+        APP_RULE_LAYER_OVERRIDE_ENTRY(vkCmdSetDepthBias);
+    }
+
+    if (m_rules.elideDynamicState.blendConstants)
+    {
+        APP_RULE_LAYER_OVERRIDE_ENTRY(vkCmdSetBlendConstants);
+    }
+
+    if (m_rules.elideDynamicState.depthBounds)
+    {
+        APP_RULE_LAYER_OVERRIDE_ENTRY(vkCmdSetDepthBounds);
+    }
+
+    if (m_rules.elideDynamicState.stencilCompareMask)
+    {
+        APP_RULE_LAYER_OVERRIDE_ENTRY(vkCmdSetStencilCompareMask);
+    }
+
+    if (m_rules.elideDynamicState.stencilWriteMask)
+    {
+        APP_RULE_LAYER_OVERRIDE_ENTRY(vkCmdSetStencilWriteMask);
+    }
+
+    if (m_rules.elideDynamicState.stencilReference)
+    {
+        APP_RULE_LAYER_OVERRIDE_ENTRY(vkCmdSetStencilReference);
+    }
+}
+
+} // namespace vk
@@ -0,0 +1,143 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  app_rule_layer.h
+* @brief Optimization layer applying the per-application rules declared by an application profile.
+***********************************************************************************************************************
+*/
+
+#ifndef __APP_RULE_LAYER_H__
+#define __APP_RULE_LAYER_H__
+
+#pragma once
+
+#include "opt_layer.h"
+
+#include "include/app_profile.h"
+
+namespace vk
+{
+
+class Device;
+
+namespace utils
+{
+struct Json;
+}
+
+// =====================================================================================================================
+// CPU optimizations an application profile may declare.  Each rule is disabled while it is zero.  These may skip work
+// the Vulkan spec requires, so they are only ever applied to the titles they were validated with.
+struct AppOptRules
+{
+    static constexpr uint32_t MaxSkippedTransitions = 8;
+
+    // Image barriers between the listed layouts are dropped from vkCmdPipelineBarrier
+    struct
+    {
+        uint32_t maxImageBarriers;    // Only calls with at most this many image barriers are filtered, 0 for any
+        uint32_t transitionCount;
+        struct
+        {
+            VkImageLayout oldLayout;
+            VkImageLayout newLayout;
+        } transitions[MaxSkippedTransitions];
+    } barrierFilter;
+
+    // Dynamic state commands which are dropped altogether, because the title only sets state its pipelines don't use
+    union
+    {
+        struct
+        {
+            uint32_t lineWidth          : 1;
+            uint32_t depthBias          : 1;
+            uint32_t blendConstants     : 1;
+            uint32_t depthBounds        : 1;
+            uint32_t stencilCompareMask : 1;
+            uint32_t stencilWriteMask   : 1;
+            uint32_t stencilReference   : 1;
+            uint32_t reserved           : 25;
+        };
+        uint32_t u32All;
+    } elideDynamicState;
+
+    // Sizing hints for titles which keep creating descriptor pools because each one runs out early
+    struct
+    {
+        uint32_t minSets;             // maxSets of each pool is raised to at least this
+        float    sizeScale;           // Descriptor counts of each pool are multiplied by this if it is above 1
+    } descriptorPool;
+};
+
+// =====================================================================================================================
+// Applies the AppOptRules of the running title.  The rules come from a table built into the driver, keyed by the
+// application profile, and can be replaced by the first matching entry of AppOptRuleFile, so that a rule can be
+// rolled out or withdrawn without a driver rebuild.  Only the entry points needed by the active rules are overridden;
+// titles without rules don't get this layer at all.
+class AppRuleLayer final : public OptLayer
+{
+public:
+    explicit AppRuleLayer(const AppOptRules& rules);
+    virtual ~AppRuleLayer() {}
+
+    virtual void OverrideDispatchTable(DispatchTable* pDispatchTable) override;
+
+    static void BuildRules(
+        Device*      pDevice,
+        AppOptRules* pRules);
+
+    static bool HasRules(
+        const AppOptRules& rules);
+
+    VK_INLINE const AppOptRules& GetRules() const
+        { return m_rules; }
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(AppRuleLayer);
+
+    static void GetBuiltInRules(
+        AppProfile   appProfile,
+        AppOptRules* pRules);
+
+    static bool LoadRuleFile(
+        Device*      pDevice,
+        const char*  pFilePath,
+        AppOptRules* pRules);
+
+    static bool MatchesApplication(
+        Device*      pDevice,
+        utils::Json* pMatch);
+
+    static bool ParseRules(
+        utils::Json* pProfile,
+        AppOptRules* pRules);
+
+    const AppOptRules m_rules;
+};
+
+} // namespace vk
+
+#endif /* __APP_RULE_LAYER_H__ */
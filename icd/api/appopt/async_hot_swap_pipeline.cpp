@@ -0,0 +1,625 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  async_hot_swap_pipeline.cpp
+* @brief Implementation of class async::HotSwapPipeline
+***********************************************************************************************************************
+*/
+#include "async_layer.h"
+#include "async_hot_swap_pipeline.h"
+#include "async_shader_module.h"
+
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+#include "include/vk_pipeline.h"
+
+#include <string.h>
+
+namespace vk
+{
+
+namespace async
+{
+
+namespace
+{
+
+// =====================================================================================================================
+// Carves a deep copy of a create info out of a single allocation.  With a null base it only measures the size.
+class CreateInfoCopy
+{
+public:
+    explicit CreateInfoCopy(void* pBase) : m_pBase(static_cast<uint8_t*>(pBase)), m_size(0) { }
+
+    VK_INLINE bool IsWriting() const { return (m_pBase != nullptr); }
+    VK_INLINE size_t GetSize() const { return m_size; }
+
+    // Copies count elements from pSrc.  Returns the copy, or nullptr when measuring or if there is nothing to copy.
+    template<typename T>
+    T* Copy(const T* pSrc, size_t count)
+    {
+        T* pDst = nullptr;
+
+        if ((pSrc != nullptr) && (count > 0))
+        {
+            m_size = Util::Pow2Align(m_size, alignof(T));
+
+            if (IsWriting())
+            {
+                pDst = reinterpret_cast<T*>(m_pBase + m_size);
+                memcpy(pDst, pSrc, sizeof(T) * count);
+            }
+
+            m_size += sizeof(T) * count;
+        }
+
+        return pDst;
+    }
+
+private:
+    uint8_t* m_pBase;
+    size_t   m_size;
+};
+
+// =====================================================================================================================
+// Copies a shader stage along with its entry point name and specialization constants.
+void CopyStage(
+    CreateInfoCopy*                        pCopy,
+    const VkPipelineShaderStageCreateInfo& src,
+    VkPipelineShaderStageCreateInfo*       pDst)
+{
+    const char*           pName = pCopy->Copy(src.pName, strlen(src.pName) + 1);
+    VkSpecializationInfo* pSpec = pCopy->Copy(src.pSpecializationInfo, 1);
+
+    const VkSpecializationMapEntry* pEntries = nullptr;
+    const void*                     pData    = nullptr;
+
+    if (src.pSpecializationInfo != nullptr)
+    {
+        pEntries = pCopy->Copy(src.pSpecializationInfo->pMapEntries, src.pSpecializationInfo->mapEntryCount);
+        pData    = pCopy->Copy(static_cast<const uint8_t*>(src.pSpecializationInfo->pData),
+                               src.pSpecializationInfo->dataSize);
+    }
+
+    if (pCopy->IsWriting())
+    {
+        pDst->pName = pName;
+
+        if (pSpec != nullptr)
+        {
+            pSpec->pMapEntries = pEntries;
+            pSpec->pData       = pData;
+        }
+
+        pDst->pSpecializationInfo = pSpec;
+    }
+}
+
+// =====================================================================================================================
+bool HasTessellationStage(
+    const VkGraphicsPipelineCreateInfo* pCreateInfo)
+{
+    bool hasTess = false;
+
+    for (uint32_t i = 0; i < pCreateInfo->stageCount; ++i)
+    {
+        hasTess |= ((pCreateInfo->pStages[i].stage &
+                     (VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT | VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT)) != 0);
+    }
+
+    return hasTess;
+}
+
+// =====================================================================================================================
+// Returns true if the rasterization dependent states are read for this pipeline.
+bool UsesRasterStates(
+    const VkGraphicsPipelineCreateInfo* pCreateInfo)
+{
+    return (pCreateInfo->pRasterizationState != nullptr) &&
+           (pCreateInfo->pRasterizationState->rasterizerDiscardEnable == VK_FALSE);
+}
+
+// =====================================================================================================================
+bool IsDynamicState(
+    const VkGraphicsPipelineCreateInfo* pCreateInfo,
+    VkDynamicState                      state)
+{
+    bool isDynamic = false;
+
+    if (pCreateInfo->pDynamicState != nullptr)
+    {
+        for (uint32_t i = 0; i < pCreateInfo->pDynamicState->dynamicStateCount; ++i)
+        {
+            isDynamic |= (pCreateInfo->pDynamicState->pDynamicStates[i] == state);
+        }
+    }
+
+    return isDynamic;
+}
+
+// =====================================================================================================================
+template<typename T>
+bool HasNoExtensions(
+    const T* pState)
+{
+    return (pState == nullptr) || (pState->pNext == nullptr);
+}
+
+} // anonymous namespace
+
+// =====================================================================================================================
+HotSwapPipeline::HotSwapPipeline(
+    Device*             pDevice,
+    VkPipeline          pipeline,
+    VkPipelineBindPoint bindPoint)
+    :
+    m_pDevice(pDevice),
+    m_pipeline(pipeline),
+    m_rebuiltPipeline(VK_NULL_HANDLE),
+    m_bindPoint(bindPoint),
+    m_moduleCount(0),
+    m_claimed(0),
+    m_pendingTasks(0)
+{
+    m_createInfo.pGraphics = nullptr;
+}
+
+// =====================================================================================================================
+// Returns true if the create info can be copied for a later rebuild.  Only core structures are copied; pipelines using
+// extension structures are built synchronously with the optimized modules instead.
+bool HotSwapPipeline::CanDefer(
+    const VkGraphicsPipelineCreateInfo* pCreateInfo)
+{
+    bool canDefer = (pCreateInfo->pNext == nullptr) &&
+                    (pCreateInfo->stageCount <= ShaderStage::ShaderStageGfxCount) &&
+                    HasNoExtensions(pCreateInfo->pVertexInputState) &&
+                    HasNoExtensions(pCreateInfo->pInputAssemblyState) &&
+                    HasNoExtensions(pCreateInfo->pRasterizationState) &&
+                    HasNoExtensions(pCreateInfo->pDynamicState);
+
+    for (uint32_t i = 0; canDefer && (i < pCreateInfo->stageCount); ++i)
+    {
+        canDefer = (pCreateInfo->pStages[i].pNext == nullptr);
+    }
+
+    if (canDefer && HasTessellationStage(pCreateInfo))
+    {
+        canDefer = HasNoExtensions(pCreateInfo->pTessellationState);
+    }
+
+    if (canDefer && UsesRasterStates(pCreateInfo))
+    {
+        canDefer = HasNoExtensions(pCreateInfo->pViewportState)    &&
+                   HasNoExtensions(pCreateInfo->pMultisampleState) &&
+                   HasNoExtensions(pCreateInfo->pDepthStencilState) &&
+                   HasNoExtensions(pCreateInfo->pColorBlendState);
+    }
+
+    return canDefer;
+}
+
+// =====================================================================================================================
+bool HotSwapPipeline::CanDefer(
+    const VkComputePipelineCreateInfo* pCreateInfo)
+{
+    return (pCreateInfo->pNext == nullptr) && (pCreateInfo->stage.pNext == nullptr);
+}
+
+// =====================================================================================================================
+// Deep copies a graphics pipeline create info into pDst, or only measures it if pDst is null.  States which the
+// pipeline ignores are not copied, since the application may pass dangling pointers for them.
+size_t HotSwapPipeline::CopyCreateInfo(
+    const VkGraphicsPipelineCreateInfo* pSrc,
+    void*                               pDst)
+{
+    CreateInfoCopy copy(pDst);
+
+    VkGraphicsPipelineCreateInfo*    pInfo   = copy.Copy(pSrc, 1);
+    VkPipelineShaderStageCreateInfo* pStages = copy.Copy(pSrc->pStages, pSrc->stageCount);
+
+    for (uint32_t i = 0; i < pSrc->stageCount; ++i)
+    {
+        CopyStage(&copy, pSrc->pStages[i], copy.IsWriting() ? &pStages[i] : nullptr);
+    }
+
+    VkPipelineVertexInputStateCreateInfo* pVertexInput = copy.Copy(pSrc->pVertexInputState, 1);
+
+    const VkVertexInputBindingDescription*   pBindings   = nullptr;
+    const VkVertexInputAttributeDescription* pAttributes = nullptr;
+
+    if (pSrc->pVertexInputState != nullptr)
+    {
+        pBindings   = copy.Copy(pSrc->pVertexInputState->pVertexBindingDescriptions,
+                                pSrc->pVertexInputState->vertexBindingDescriptionCount);
+        pAttributes = copy.Copy(pSrc->pVertexInputState->pVertexAttributeDescriptions,
+                                pSrc->pVertexInputState->vertexAttributeDescriptionCount);
+    }
+
+    const VkPipelineInputAssemblyStateCreateInfo* pInputAssembly = copy.Copy(pSrc->pInputAssemblyState, 1);
+    const VkPipelineTessellationStateCreateInfo*  pTessellation  =
+        HasTessellationStage(pSrc) ? copy.Copy(pSrc->pTessellationState, 1) : nullptr;
+    const VkPipelineRasterizationStateCreateInfo* pRaster        = copy.Copy(pSrc->pRasterizationState, 1);
+
+    VkPipelineViewportStateCreateInfo*    pViewport    = nullptr;
+    VkPipelineMultisampleStateCreateInfo* pMultisample = nullptr;
+    VkPipelineColorBlendStateCreateInfo*  pColorBlend  = nullptr;
+    const VkPipelineDepthStencilStateCreateInfo* pDepthStencil = nullptr;
+
+    const VkViewport*                          pViewports   = nullptr;
+    const VkRect2D*                            pScissors    = nullptr;
+    const VkSampleMask*                        pSampleMask  = nullptr;
+    const VkPipelineColorBlendAttachmentState* pAttachments = nullptr;
+
+    if (UsesRasterStates(pSrc))
+    {
+        pViewport     = copy.Copy(pSrc->pViewportState, 1);
+        pMultisample  = copy.Copy(pSrc->pMultisampleState, 1);
+        pDepthStencil = copy.Copy(pSrc->pDepthStencilState, 1);
+        pColorBlend   = copy.Copy(pSrc->pColorBlendState, 1);
+
+        if (pSrc->pViewportState != nullptr)
+        {
+            if (IsDynamicState(pSrc, VK_DYNAMIC_STATE_VIEWPORT) == false)
+            {
+                pViewports = copy.Copy(pSrc->pViewportState->pViewports, pSrc->pViewportState->viewportCount);
+            }
+
+            if (IsDynamicState(pSrc, VK_DYNAMIC_STATE_SCISSOR) == false)
+            {
+                pScissors = copy.Copy(pSrc->pViewportState->pScissors, pSrc->pViewportState->scissorCount);
+            }
+        }
+
+        if (pSrc->pMultisampleState != nullptr)
+        {
+            pSampleMask = copy.Copy(pSrc->pMultisampleState->pSampleMask,
+                                    Util::RoundUpQuotient(static_cast<uint32_t>(
+                                        pSrc->pMultisampleState->rasterizationSamples), 32u));
+        }
+
+        if (pSrc->pColorBlendState != nullptr)
+        {
+            pAttachments = copy.Copy(pSrc->pColorBlendState->pAttachments, pSrc->pColorBlendState->attachmentCount);
+        }
+    }
+
+    VkPipelineDynamicStateCreateInfo* pDynamic       = copy.Copy(pSrc->pDynamicState, 1);
+    const VkDynamicState*             pDynamicStates = nullptr;
+
+    if (pSrc->pDynamicState != nullptr)
+    {
+        pDynamicStates = copy.Copy(pSrc->pDynamicState->pDynamicStates, pSrc->pDynamicState->dynamicStateCount);
+    }
+
+    if (copy.IsWriting())
+    {
+        pInfo->pStages             = pStages;
+        pInfo->pVertexInputState   = pVertexInput;
+        pInfo->pInputAssemblyState = pInputAssembly;
+        pInfo->pTessellationState  = pTessellation;
+        pInfo->pViewportState      = pViewport;
+        pInfo->pRasterizationState = pRaster;
+        pInfo->pMultisampleState   = pMultisample;
+        pInfo->pDepthStencilState  = pDepthStencil;
+        pInfo->pColorBlendState    = pColorBlend;
+        pInfo->pDynamicState       = pDynamic;
+
+        // The rebuild is a standalone pipeline.
+        pInfo->flags              &= ~VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+        pInfo->basePipelineHandle  = VK_NULL_HANDLE;
+        pInfo->basePipelineIndex   = -1;
+
+        if (pVertexInput != nullptr)
+        {
+            pVertexInput->pVertexBindingDescriptions   = pBindings;
+            pVertexInput->pVertexAttributeDescriptions = pAttributes;
+        }
+
+        if (pViewport != nullptr)
+        {
+            pViewport->pViewports = pViewports;
+            pViewport->pScissors  = pScissors;
+        }
+
+        if (pMultisample != nullptr)
+        {
+            pMultisample->pSampleMask = pSampleMask;
+        }
+
+        if (pColorBlend != nullptr)
+        {
+            pColorBlend->pAttachments = pAttachments;
+        }
+
+        if (pDynamic != nullptr)
+        {
+            pDynamic->pDynamicStates = pDynamicStates;
+        }
+    }
+
+    return copy.GetSize();
+}
+
+// =====================================================================================================================
+size_t HotSwapPipeline::CopyCreateInfo(
+    const VkComputePipelineCreateInfo* pSrc,
+    void*                              pDst)
+{
+    CreateInfoCopy copy(pDst);
+
+    VkComputePipelineCreateInfo* pInfo = copy.Copy(pSrc, 1);
+
+    CopyStage(&copy, pSrc->stage, copy.IsWriting() ? &pInfo->stage : nullptr);
+
+    if (copy.IsWriting())
+    {
+        pInfo->flags              &= ~VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+        pInfo->basePipelineHandle  = VK_NULL_HANDLE;
+        pInfo->basePipelineIndex   = -1;
+    }
+
+    return copy.GetSize();
+}
+
+// =====================================================================================================================
+// Sets up and queues the rebuild of a graphics pipeline.  The create info must pass CanDefer() and its stages must
+// reference async shader modules.  Returns nullptr if the rebuild couldn't be queued; the pipeline then simply keeps
+// its immediate mode build.
+HotSwapPipeline* HotSwapPipeline::Create(
+    Device*                             pDevice,
+    const VkGraphicsPipelineCreateInfo* pCreateInfo,
+    VkPipeline                          pipeline)
+{
+    VK_ASSERT(CanDefer(pCreateInfo));
+
+    const size_t infoSize = CopyCreateInfo(pCreateInfo, nullptr);
+    void*        pMemory  = pDevice->VkInstance()->AllocMem(sizeof(HotSwapPipeline) + infoSize,
+                                                            VK_DEFAULT_MEM_ALIGN,
+                                                            VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+    HotSwapPipeline* pObj = nullptr;
+
+    if (pMemory != nullptr)
+    {
+        pObj = VK_PLACEMENT_NEW(pMemory) HotSwapPipeline(pDevice, pipeline, VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+        void* pInfoMem = Util::VoidPtrInc(pMemory, sizeof(HotSwapPipeline));
+
+        CopyCreateInfo(pCreateInfo, pInfoMem);
+
+        pObj->m_createInfo.pGraphics = static_cast<VkGraphicsPipelineCreateInfo*>(pInfoMem);
+
+        for (uint32_t i = 0; i < pCreateInfo->stageCount; ++i)
+        {
+            pObj->m_pModules[pObj->m_moduleCount++] =
+                ShaderModule::ObjectFromHandle(pCreateInfo->pStages[i].module)->GetOptimizedModule();
+        }
+
+        pObj->Queue(pDevice->GetAsyncLayer());
+    }
+
+    return pObj;
+}
+
+// =====================================================================================================================
+HotSwapPipeline* HotSwapPipeline::Create(
+    Device*                            pDevice,
+    const VkComputePipelineCreateInfo* pCreateInfo,
+    VkPipeline                         pipeline)
+{
+    VK_ASSERT(CanDefer(pCreateInfo));
+
+    const size_t infoSize = CopyCreateInfo(pCreateInfo, nullptr);
+    void*        pMemory  = pDevice->VkInstance()->AllocMem(sizeof(HotSwapPipeline) + infoSize,
+                                                            VK_DEFAULT_MEM_ALIGN,
+                                                            VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+    HotSwapPipeline* pObj = nullptr;
+
+    if (pMemory != nullptr)
+    {
+        pObj = VK_PLACEMENT_NEW(pMemory) HotSwapPipeline(pDevice, pipeline, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+        void* pInfoMem = Util::VoidPtrInc(pMemory, sizeof(HotSwapPipeline));
+
+        CopyCreateInfo(pCreateInfo, pInfoMem);
+
+        pObj->m_createInfo.pCompute = static_cast<VkComputePipelineCreateInfo*>(pInfoMem);
+        pObj->m_pModules[pObj->m_moduleCount++] =
+            ShaderModule::ObjectFromHandle(pCreateInfo->stage.module)->GetOptimizedModule();
+
+        pObj->Queue(pDevice->GetAsyncLayer());
+    }
+
+    return pObj;
+}
+
+// =====================================================================================================================
+// Queues the rebuild behind the shader module builds.  The rebuild holds references to the optimized modules, so the
+// application may destroy its shader modules right away.  The layer is told to wait for it before a pipeline layout or
+// render pass is destroyed, since the create info references those.
+void HotSwapPipeline::Queue(
+    AsyncLayer* pAsyncLayer)
+{
+    for (uint32_t i = 0; i < m_moduleCount; ++i)
+    {
+        m_pModules[i]->AddRef();
+    }
+
+    pAsyncLayer->AddHotSwapUser();
+
+    AsyncTask task = {};
+    task.type     = HotSwapPipelineTaskType;
+    task.priority = TaskPriorityLow;
+    task.pOwner   = this;
+    task.hotSwapPipeline.pObj = this;
+
+    m_pendingTasks = 1;
+
+    if (pAsyncLayer->GetTaskPool()->AddTask(&task) != VK_SUCCESS)
+    {
+        m_claimed      = 1;
+        m_pendingTasks = 0;
+
+        ReleaseReferences(pAsyncLayer);
+    }
+}
+
+// =====================================================================================================================
+void HotSwapPipeline::ReleaseReferences(
+    AsyncLayer* pAsyncLayer)
+{
+    for (uint32_t i = 0; i < m_moduleCount; ++i)
+    {
+        m_pModules[i]->Release(pAsyncLayer);
+    }
+
+    pAsyncLayer->ReleaseHotSwapUser();
+}
+
+// =====================================================================================================================
+// Builds the pipeline with the optimized modules and swaps its PAL pipelines into the application's pipeline.
+void HotSwapPipeline::Rebuild(
+    AsyncLayer* pAsyncLayer)
+{
+    VkDevice device = VkDevice(ApiDevice::FromObject(m_pDevice));
+    VkResult result = VK_SUCCESS;
+    bool     built  = true;
+
+    // Finish the module builds first; a build no worker has picked up yet runs right here.  Without an optimized build
+    // of every module there is nothing to gain.
+    for (uint32_t i = 0; i < m_moduleCount; ++i)
+    {
+        m_pModules[i]->WaitForBuild(pAsyncLayer);
+
+        built &= (m_pModules[i]->GetModule() != VK_NULL_HANDLE);
+    }
+
+    if (built && (m_bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS))
+    {
+        VkGraphicsPipelineCreateInfo    createInfo = *m_createInfo.pGraphics;
+        VkPipelineShaderStageCreateInfo stages[ShaderStage::ShaderStageGfxCount];
+
+        for (uint32_t stage = 0; stage < createInfo.stageCount; ++stage)
+        {
+            stages[stage]        = createInfo.pStages[stage];
+            stages[stage].module = m_pModules[stage]->GetModule();
+        }
+
+        createInfo.pStages = stages;
+
+        result = ASYNC_CALL_NEXT_LAYER(vkCreateGraphicsPipelines)(device,
+                                                                  VK_NULL_HANDLE,
+                                                                  1,
+                                                                  &createInfo,
+                                                                  nullptr,
+                                                                  &m_rebuiltPipeline);
+    }
+    else if (built)
+    {
+        VkComputePipelineCreateInfo createInfo = *m_createInfo.pCompute;
+
+        createInfo.stage.module = m_pModules[0]->GetModule();
+
+        result = ASYNC_CALL_NEXT_LAYER(vkCreateComputePipelines)(device,
+                                                                 VK_NULL_HANDLE,
+                                                                 1,
+                                                                 &createInfo,
+                                                                 nullptr,
+                                                                 &m_rebuiltPipeline);
+    }
+
+    if (built && (result == VK_SUCCESS))
+    {
+        if (Pipeline::BaseObjectFromHandle(m_pipeline)->UsePalPipelinesOf(
+                Pipeline::BaseObjectFromHandle(m_rebuiltPipeline)) == false)
+        {
+            // The optimized build changed state which the pipeline derived at creation; keep the immediate mode build.
+            ASYNC_CALL_NEXT_LAYER(vkDestroyPipeline)(device, m_rebuiltPipeline, nullptr);
+
+            m_rebuiltPipeline = VK_NULL_HANDLE;
+        }
+    }
+    else
+    {
+        // Keep the immediate mode build.
+        m_rebuiltPipeline = VK_NULL_HANDLE;
+    }
+}
+
+// =====================================================================================================================
+// Runs the queued rebuild, unless Destroy() cancelled it.
+void HotSwapPipeline::Execute(
+    AsyncLayer*          pAsyncLayer,
+    HotSwapPipelineTask* pTask)
+{
+    VK_IGNORE(pTask);
+
+    if (Util::AtomicCompareAndSwap(&m_claimed, 0, 1) == 0)
+    {
+        Rebuild(pAsyncLayer);
+        ReleaseReferences(pAsyncLayer);
+    }
+
+    // Destroy() may free the object as soon as this is done.
+    pAsyncLayer->GetTaskPool()->CompleteTask(&m_pendingTasks);
+}
+
+// =====================================================================================================================
+// Called before the application's pipeline is destroyed.  Cancels a rebuild which hasn't started, waits for one which
+// is running and points the application's pipeline back at its own PAL pipelines before the rebuild is destroyed.
+void HotSwapPipeline::Destroy(
+    AsyncLayer* pAsyncLayer)
+{
+    if (Util::AtomicCompareAndSwap(&m_claimed, 0, 1) == 0)
+    {
+        ReleaseReferences(pAsyncLayer);
+    }
+
+    if (m_pendingTasks != 0)
+    {
+        // The queued task is a no-op now; move it up so it doesn't hold us behind unrelated work.
+        pAsyncLayer->GetTaskPool()->PromoteTasks(this);
+        pAsyncLayer->GetTaskPool()->WaitForTasks(&m_pendingTasks);
+    }
+
+    if (m_rebuiltPipeline != VK_NULL_HANDLE)
+    {
+        Pipeline::BaseObjectFromHandle(m_pipeline)->UsePalPipelinesOf(nullptr);
+
+        ASYNC_CALL_NEXT_LAYER(vkDestroyPipeline)(VkDevice(ApiDevice::FromObject(m_pDevice)),
+                                                 m_rebuiltPipeline,
+                                                 nullptr);
+    }
+
+    Instance* pInstance = m_pDevice->VkInstance();
+
+    Util::Destructor(this);
+
+    pInstance->FreeMem(this);
+}
+
+} // namespace async
+
+} // namespace vk
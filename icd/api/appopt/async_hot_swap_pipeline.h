@@ -0,0 +1,112 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  async_hot_swap_pipeline.h
+* @brief Header file of class async::HotSwapPipeline
+***********************************************************************************************************************
+*/
+
+#ifndef __ASYNC_HOT_SWAP_PIPELINE_H__
+#define __ASYNC_HOT_SWAP_PIPELINE_H__
+
+#pragma once
+
+#include "include/vk_dispatch.h"
+#include "include/vk_shader_code.h"
+
+namespace vk
+{
+
+class AsyncLayer;
+class Device;
+class Pipeline;
+struct HotSwapPipelineTask;
+
+namespace async
+{
+
+class OptimizedShaderModule;
+
+// =====================================================================================================================
+// A pipeline which was handed to the application while the optimized builds of its shader modules were still pending.
+// It was created with the immediate mode modules; this object rebuilds it with the optimized modules in the background
+// and points the application's pipeline object at the optimized PAL pipelines.  The rebuilt pipeline object owns those
+// PAL pipelines, so it is kept until the application destroys the pipeline.
+class HotSwapPipeline
+{
+public:
+    static bool CanDefer(const VkGraphicsPipelineCreateInfo* pCreateInfo);
+    static bool CanDefer(const VkComputePipelineCreateInfo* pCreateInfo);
+
+    static HotSwapPipeline* Create(
+        Device*                             pDevice,
+        const VkGraphicsPipelineCreateInfo* pCreateInfo,
+        VkPipeline                          pipeline);
+
+    static HotSwapPipeline* Create(
+        Device*                            pDevice,
+        const VkComputePipelineCreateInfo* pCreateInfo,
+        VkPipeline                         pipeline);
+
+    void Destroy(AsyncLayer* pAsyncLayer);
+
+    void Execute(AsyncLayer* pAsyncLayer, HotSwapPipelineTask* pTask);
+
+protected:
+    HotSwapPipeline(Device* pDevice, VkPipeline pipeline, VkPipelineBindPoint bindPoint);
+
+    void Queue(AsyncLayer* pAsyncLayer);
+
+    void Rebuild(AsyncLayer* pAsyncLayer);
+
+    void ReleaseReferences(AsyncLayer* pAsyncLayer);
+
+    static size_t CopyCreateInfo(const VkGraphicsPipelineCreateInfo* pSrc, void* pDst);
+    static size_t CopyCreateInfo(const VkComputePipelineCreateInfo* pSrc, void* pDst);
+
+    Device* const       m_pDevice;
+    const VkPipeline    m_pipeline;                            // Application's pipeline
+    VkPipeline          m_rebuiltPipeline;                     // Optimized rebuild, holding the original PAL pipelines
+    VkPipelineBindPoint m_bindPoint;
+    union
+    {
+        VkGraphicsPipelineCreateInfo* pGraphics;               // Deep copy of the application's create info
+        VkComputePipelineCreateInfo*  pCompute;
+    }                   m_createInfo;
+    OptimizedShaderModule* m_pModules[ShaderStage::ShaderStageGfxCount]; // Optimized builds of the stages' modules
+    uint32_t            m_moduleCount;
+    volatile uint32_t   m_claimed;                             // Set by whichever thread runs or cancels the rebuild
+    volatile uint32_t   m_pendingTasks;                        // Non-zero until the queued task has run
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(HotSwapPipeline);
+};
+
+} // namespace async
+
+} // namespace vk
+
+#endif
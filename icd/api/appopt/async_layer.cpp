@@ -31,12 +31,15 @@
 #include "async_layer.h"
 #include "async_shader_module.h"
 #include "async_partial_pipeline.h"
+#include "async_hot_swap_pipeline.h"
 
 #include "include/vk_device.h"
 #include "include/vk_shader.h"
 #include "include/vk_graphics_pipeline.h"
 #include "include/vk_compute_pipeline.h"
-#include "palListImpl.h"
+
+#include "palHashMapImpl.h"
+#include "palHashSetImpl.h"
 
 namespace vk
 {
@@ -68,10 +71,8 @@ VKAPI_ATTR void VKAPI_CALL vkDestroyShaderModule(
     if (shaderModule != VK_NULL_HANDLE)
     {
         Device* pDevice  = ApiDevice::ObjectFromHandle(device);
-        AsyncLayer* pAsyncLayer = pDevice->GetAsyncLayer();
         const VkAllocationCallbacks* pAllocCB = pAllocator ? pAllocator : pDevice->VkInstance()->GetAllocCallbacks();
 
-        pAsyncLayer->SyncAll();
         vk::async::ShaderModule::ObjectFromHandle(shaderModule)->Destroy(pDevice, pAllocCB);
     }
 }
@@ -94,10 +95,30 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateGraphicsPipelines(
         VkGraphicsPipelineCreateInfo createInfo = pCreateInfos[i];
         VkPipelineShaderStageCreateInfo stages[ShaderStage::ShaderStageGfxCount];
         VK_ASSERT(createInfo.stageCount <= ShaderStage::ShaderStageGfxCount);
+
+        // Don't stall on optimized builds which are still pending; use the immediate modules for now and swap the
+        // optimized pipeline in later.
+        bool hotSwap = false;
+
+        if (pAsyncLayer->IsHotSwapEnabled() && vk::async::HotSwapPipeline::CanDefer(&createInfo))
+        {
+            for (uint32_t stage = 0; stage < createInfo.stageCount; ++stage)
+            {
+                const vk::async::ShaderModule* pModule =
+                    vk::async::ShaderModule::ObjectFromHandle(createInfo.pStages[stage].module);
+
+                hotSwap |= pModule->IsBuildPending();
+            }
+        }
+
         for (uint32_t stage = 0; stage < createInfo.stageCount; ++stage)
         {
             stages[stage] = createInfo.pStages[stage];
             vk::async::ShaderModule* pModule = vk::async::ShaderModule::ObjectFromHandle(stages[stage].module);
+            if (hotSwap == false)
+            {
+                pModule->PromoteAndWait(pAsyncLayer);
+            }
             stages[stage].module = pModule->GetNextLayerModule();
         }
         createInfo.pStages = stages;
@@ -107,6 +128,17 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateGraphicsPipelines(
                                                                   &createInfo,
                                                                   pAllocator,
                                                                   pPipelines + i);
+
+        if ((result == VK_SUCCESS) && hotSwap)
+        {
+            vk::async::HotSwapPipeline* pHotSwap =
+                vk::async::HotSwapPipeline::Create(pDevice, &pCreateInfos[i], pPipelines[i]);
+
+            if ((pHotSwap != nullptr) && (pAsyncLayer->TrackHotSwapPipeline(pPipelines[i], pHotSwap) == false))
+            {
+                pHotSwap->Destroy(pAsyncLayer);
+            }
+        }
     }
 
     return result;
@@ -130,6 +162,15 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateComputePipelines(
         VkComputePipelineCreateInfo createInfo = pCreateInfos[i];
         VK_ASSERT(createInfo.stage.module != VK_NULL_HANDLE);
         vk::async::ShaderModule* pModule = vk::async::ShaderModule::ObjectFromHandle(createInfo.stage.module);
+
+        const bool hotSwap = pAsyncLayer->IsHotSwapEnabled()                   &&
+                             pModule->IsBuildPending()                        &&
+                             vk::async::HotSwapPipeline::CanDefer(&createInfo);
+
+        if (hotSwap == false)
+        {
+            pModule->PromoteAndWait(pAsyncLayer);
+        }
         createInfo.stage.module = pModule->GetNextLayerModule();
         result = ASYNC_CALL_NEXT_LAYER(vkCreateComputePipelines)(device,
                                                                  pipelineCache,
@@ -137,11 +178,74 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateComputePipelines(
                                                                  &createInfo,
                                                                  pAllocator,
                                                                  pPipelines + i);
+
+        if ((result == VK_SUCCESS) && hotSwap)
+        {
+            vk::async::HotSwapPipeline* pHotSwap =
+                vk::async::HotSwapPipeline::Create(pDevice, &pCreateInfos[i], pPipelines[i]);
+
+            if ((pHotSwap != nullptr) && (pAsyncLayer->TrackHotSwapPipeline(pPipelines[i], pHotSwap) == false))
+            {
+                pHotSwap->Destroy(pAsyncLayer);
+            }
+        }
     }
 
     return result;
 }
 
+// =====================================================================================================================
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipeline(
+    VkDevice                                    device,
+    VkPipeline                                  pipeline,
+    const VkAllocationCallbacks*                pAllocator)
+{
+    Device* pDevice = ApiDevice::ObjectFromHandle(device);
+    AsyncLayer* pAsyncLayer = pDevice->GetAsyncLayer();
+
+    if (pipeline != VK_NULL_HANDLE)
+    {
+        vk::async::HotSwapPipeline* pHotSwap = pAsyncLayer->UntrackHotSwapPipeline(pipeline);
+
+        if (pHotSwap != nullptr)
+        {
+            // Hands the original PAL pipelines back to the application's pipeline before it is destroyed.
+            pHotSwap->Destroy(pAsyncLayer);
+        }
+    }
+
+    ASYNC_CALL_NEXT_LAYER(vkDestroyPipeline)(device, pipeline, pAllocator);
+}
+
+// =====================================================================================================================
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipelineLayout(
+    VkDevice                                    device,
+    VkPipelineLayout                            pipelineLayout,
+    const VkAllocationCallbacks*                pAllocator)
+{
+    Device* pDevice = ApiDevice::ObjectFromHandle(device);
+    AsyncLayer* pAsyncLayer = pDevice->GetAsyncLayer();
+
+    // Pending rebuilds may still read the layout through their copied create info.
+    pAsyncLayer->WaitForHotSwaps();
+
+    ASYNC_CALL_NEXT_LAYER(vkDestroyPipelineLayout)(device, pipelineLayout, pAllocator);
+}
+
+// =====================================================================================================================
+VKAPI_ATTR void VKAPI_CALL vkDestroyRenderPass(
+    VkDevice                                    device,
+    VkRenderPass                                renderPass,
+    const VkAllocationCallbacks*                pAllocator)
+{
+    Device* pDevice = ApiDevice::ObjectFromHandle(device);
+    AsyncLayer* pAsyncLayer = pDevice->GetAsyncLayer();
+
+    pAsyncLayer->WaitForHotSwaps();
+
+    ASYNC_CALL_NEXT_LAYER(vkDestroyRenderPass)(device, renderPass, pAllocator);
+}
+
 } // namespace async
 
 } // namespace entry
@@ -150,53 +254,122 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateComputePipelines(
 AsyncLayer::AsyncLayer(Device* pDevice)
     :
     m_pDevice(pDevice),
-    m_pModuleTaskThreads(),
-    m_pPipelineTaskThreads()
+    m_taskPool(this, pDevice->VkInstance()),
+    m_poolReady(false),
+    m_hotSwapEnabled(false),
+    m_builtParts(256, pDevice->VkInstance()->Allocator()),
+    m_hotSwapPipelines(64, pDevice->VkInstance()->Allocator()),
+    m_pendingHotSwaps(0)
 {
+    m_builtParts.Init();
+    m_hotSwapPipelines.Init();
+
     Util::SystemInfo sysInfo = {};
     Util::QuerySystemInfo(&sysInfo);
 
-    for (uint32_t i = 0; i < MaxTaskType; ++i)
+    // Shader module and partial pipeline tasks share the workers, so a burst of either type can use all of them.
+    const uint32_t threadCount = Util::Min(async::TaskPool::MaxThreads, sysInfo.cpuLogicalCoreCount / 2);
+
+    m_poolReady = (threadCount > 0) && (m_taskPool.Init(threadCount) == VK_SUCCESS);
+
+    m_hotSwapEnabled = m_poolReady && pDevice->GetRuntimeSettings().asyncPipelineHotSwap;
+}
+
+// =====================================================================================================================
+AsyncLayer::~AsyncLayer()
+{
+}
+
+// =====================================================================================================================
+// Runs a task on the calling thread.  Called by the task pool.
+void AsyncLayer::ExecuteTask(
+    AsyncTask* pTask)
+{
+    switch (pTask->type)
     {
-        m_taskId[i] = 0;
-        m_activeThreadCount[i] = Util::Min(MaxThreads, sysInfo.cpuLogicalCoreCount / 2);
+    case ShaderModuleTaskType:
+        pTask->shaderModule.pObj->Execute(this, &pTask->shaderModule);
+        break;
+    case PartialPipelineTaskType:
+        pTask->partialPipeline.pObj->Execute(this, &pTask->partialPipeline);
+        m_taskPool.CompleteTask(pTask->partialPipeline.pOwnerTaskCount);
+        break;
+    case HotSwapPipelineTaskType:
+        pTask->hotSwapPipeline.pObj->Execute(this, &pTask->hotSwapPipeline);
+        break;
+    default:
+        VK_NEVER_CALLED();
+        break;
     }
-    for (uint32_t i = 0; i < m_activeThreadCount[0]; ++i)
+}
+
+// =====================================================================================================================
+// Returns true if the partial pipeline part with the given key hasn't been built yet, and marks it as built.  Modules
+// with identical code (common in apps that create many permutations) then share a single part build.
+bool AsyncLayer::ClaimPartialPipelinePart(
+    uint64_t partKey)
+{
+    Util::MutexAuto lock(&m_partLock);
+
+    bool claimed = false;
+
+    if (m_builtParts.Contains(partKey) == false)
     {
-        m_pModuleTaskThreads[i] = VK_PLACEMENT_NEW(m_moduleTaskThreadBuffer[i])
-                                  async::TaskThread<ShaderModuleTask>(this, pDevice->VkInstance()->Allocator());
-        m_pModuleTaskThreads[i]->Begin();
+        // If the key can't be recorded the part is simply built again later.
+        m_builtParts.Insert(partKey);
+        claimed = true;
+    }
+
+    return claimed;
+}
 
-        m_pPipelineTaskThreads[i] = VK_PLACEMENT_NEW(m_pipelineTaskThreadBuffer[i])
-                                    async::TaskThread<PartialPipelineTask>(this, pDevice->VkInstance()->Allocator());
-        m_pPipelineTaskThreads[i]->Begin();
+// =====================================================================================================================
+// Associates a hot swap object with the application's pipeline handle so that vkDestroyPipeline can find it.
+bool AsyncLayer::TrackHotSwapPipeline(
+    VkPipeline              pipeline,
+    async::HotSwapPipeline* pObj)
+{
+    Util::MutexAuto lock(&m_hotSwapLock);
+
+    return (m_hotSwapPipelines.Insert(uint64_t(pipeline), pObj) == Util::Result::Success);
+}
+
+// =====================================================================================================================
+// Removes and returns the hot swap object of a pipeline, or nullptr if the pipeline was created normally.
+async::HotSwapPipeline* AsyncLayer::UntrackHotSwapPipeline(
+    VkPipeline pipeline)
+{
+    Util::MutexAuto lock(&m_hotSwapLock);
+
+    async::HotSwapPipeline*  pObj  = nullptr;
+    async::HotSwapPipeline** ppObj = m_hotSwapPipelines.FindKey(uint64_t(pipeline));
+
+    if (ppObj != nullptr)
+    {
+        pObj = *ppObj;
+        m_hotSwapPipelines.Erase(uint64_t(pipeline));
     }
+
+    return pObj;
 }
 
 // =====================================================================================================================
-AsyncLayer::~AsyncLayer()
+// Returns once no pipeline rebuild is pending.  Called before destroying objects a rebuild may reference.
+void AsyncLayer::WaitForHotSwaps()
 {
-    for (uint32_t i = 0; i < m_activeThreadCount[0]; ++i)
+    if (m_pendingHotSwaps != 0)
     {
-        m_pModuleTaskThreads[i]->SetStop();
-        m_pModuleTaskThreads[i]->Join();
-        Util::Destructor(m_pModuleTaskThreads[i]);
-        m_pModuleTaskThreads[i] = nullptr;
-
-        m_pPipelineTaskThreads[i]->SetStop();
-        m_pPipelineTaskThreads[i]->Join();
-        Util::Destructor(m_pPipelineTaskThreads[i]);
-        m_pPipelineTaskThreads[i] = nullptr;
+        m_taskPool.WaitForTasks(&m_pendingHotSwaps);
     }
 }
 
 // =====================================================================================================================
+// Returns once all queued shader module and partial pipeline tasks have finished.
 void AsyncLayer::SyncAll()
 {
-    for (uint32_t i = 0; i < m_activeThreadCount[0]; ++i)
+    if (m_poolReady)
     {
-        m_pModuleTaskThreads[i]->SyncAll();
-        m_pPipelineTaskThreads[i]->SyncAll();
+        m_taskPool.SyncAll();
     }
 }
 
@@ -211,6 +384,9 @@ void AsyncLayer::OverrideDispatchTable(
     ASYNC_OVERRIDE_ENTRY(vkDestroyShaderModule);
     ASYNC_OVERRIDE_ENTRY(vkCreateGraphicsPipelines);
     ASYNC_OVERRIDE_ENTRY(vkCreateComputePipelines);
+    ASYNC_OVERRIDE_ENTRY(vkDestroyPipeline);
+    ASYNC_OVERRIDE_ENTRY(vkDestroyPipelineLayout);
+    ASYNC_OVERRIDE_ENTRY(vkDestroyRenderPass);
 }
 
 } // namespace vk
@@ -35,7 +35,10 @@
 #pragma once
 
 #include "opt_layer.h"
-#include "async_task_thread.h"
+#include "async_task_pool.h"
+
+#include "palHashMap.h"
+#include "palHashSet.h"
 
 namespace vk
 {
@@ -44,7 +47,7 @@ class Device;
 class AsyncLayer;
 class PalAllocator;
 
-namespace async { class ShaderModule; class PartialPipeline; }
+namespace async { class ShaderModule; class PartialPipeline; class HotSwapPipeline; }
 
 // Represents the shader module async compile info
 struct ShaderModuleTask
@@ -58,6 +61,13 @@ struct PartialPipelineTask
 {
     VkShaderModule              shaderModuleHandle; // Shader module handle
     async::PartialPipeline*     pObj;               // Output shader module object
+    volatile uint32_t*          pOwnerTaskCount;    // Outstanding task count of the shader module owning the handle
+};
+
+// Represents the background rebuild of a pipeline with optimized shader modules
+struct HotSwapPipelineTask
+{
+    async::HotSwapPipeline*     pObj;               // Pipeline to rebuild
 };
 
 // Thread task type
@@ -65,9 +75,24 @@ enum TaskType : uint32_t
 {
     ShaderModuleTaskType = 0,
     PartialPipelineTaskType,
+    HotSwapPipelineTaskType,
     MaxTaskType,
 };
 
+// A task queued on the async layer's task pool
+struct AsyncTask
+{
+    TaskType            type;                   // Selects the member of the union below
+    async::TaskPriority priority;               // Scheduling priority
+    const void*         pOwner;                 // Object waiting for the task, used to promote it
+    union
+    {
+        ShaderModuleTask    shaderModule;       // Valid for ShaderModuleTaskType
+        PartialPipelineTask partialPipeline;    // Valid for PartialPipelineTaskType
+        HotSwapPipelineTask hotSwapPipeline;    // Valid for HotSwapPipelineTaskType
+    };
+};
+
 // =====================================================================================================================
 // Class that specifies dispatch table override behavior for async compiler layers
 class AsyncLayer final : public OptLayer
@@ -80,36 +105,37 @@ public:
 
     VK_INLINE Device* GetDevice() { return m_pDevice; }
 
-    void* GetTaskThread(TaskType type)
-    {
-        VK_ASSERT(type < MaxTaskType);
-        if (type == ShaderModuleTaskType)
-        {
-            return (m_activeThreadCount[type] > 0) ?
-                    m_pModuleTaskThreads[(m_taskId[type]++) % m_activeThreadCount[type]] :
-                    nullptr;
-        }
-        else
-        {
-            return (m_activeThreadCount[type] > 0) ?
-                    m_pPipelineTaskThreads[(m_taskId[type]++) % m_activeThreadCount[type]] :
-                    nullptr;
-        }
-    }
+    // Returns the shared task pool, or nullptr if no worker thread could be started.
+    VK_INLINE async::TaskPool* GetTaskPool() { return m_poolReady ? &m_taskPool : nullptr; }
+
+    void ExecuteTask(AsyncTask* pTask);
 
     void SyncAll();
 
+    bool ClaimPartialPipelinePart(uint64_t partKey);
+
+    bool TrackHotSwapPipeline(VkPipeline pipeline, async::HotSwapPipeline* pObj);
+
+    async::HotSwapPipeline* UntrackHotSwapPipeline(VkPipeline pipeline);
+
+    VK_INLINE void AddHotSwapUser() { Util::AtomicIncrement(&m_pendingHotSwaps); }
+
+    VK_INLINE void ReleaseHotSwapUser() { m_taskPool.CompleteTask(&m_pendingHotSwaps); }
+
+    void WaitForHotSwaps();
+
+    VK_INLINE bool IsHotSwapEnabled() const { return m_hotSwapEnabled; }
+
 protected:
-    static constexpr uint32_t        MaxThreads = 8;  // Max thread count for shader module compile
     Device*                          m_pDevice;                  // Vulkan Device object
-    async::TaskThread<ShaderModuleTask>* m_pModuleTaskThreads[MaxThreads]; // Async compiler threads
-    async::TaskThread<PartialPipelineTask>* m_pPipelineTaskThreads[MaxThreads]; // Async compiler threads
-    uint32_t                         m_taskId[MaxTaskType];                   // Hint to select compile thread
-    uint32_t                         m_activeThreadCount[MaxTaskType];        // Active thread count
-    // Internal buffer for m_taskThreadBuffer
-    uint8_t                          m_moduleTaskThreadBuffer[MaxThreads][sizeof(async::TaskThread<ShaderModuleTask>)];
-    uint8_t                          m_pipelineTaskThreadBuffer[MaxThreads]
-                                                               [sizeof(async::TaskThread<PartialPipelineTask>)];
+    async::TaskPool                  m_taskPool;                 // Workers shared by all async task types
+    bool                             m_poolReady;                // Set if m_taskPool has at least one worker
+    bool                             m_hotSwapEnabled;           // Create pipelines without waiting for async builds
+    Util::Mutex                      m_partLock;                 // Protects m_builtParts
+    Util::HashSet<uint64_t, PalAllocator> m_builtParts;          // Keys of the partial pipeline parts built so far
+    Util::Mutex                      m_hotSwapLock;              // Protects m_hotSwapPipelines
+    Util::HashMap<uint64_t, async::HotSwapPipeline*, PalAllocator> m_hotSwapPipelines; // Pipelines with a rebuild
+    volatile uint32_t                m_pendingHotSwaps;          // Rebuilds which haven't finished or been cancelled
 
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(AsyncLayer);
@@ -37,7 +37,8 @@
 
 #include "include/vk_device.h"
 #include "include/vk_shader.h"
-#include "palListImpl.h"
+
+#include "palMetroHash.h"
 
 #include <limits.h>
 
@@ -87,23 +88,30 @@ VkResult PartialPipeline::Destroy()
 }
 
 // =====================================================================================================================
-// Builds partial pipeline in async mode
+// Builds partial pipeline in async mode.  pOwnerTaskCount is decremented once the task has run or couldn't be queued.
 void PartialPipeline::AsyncBuildPartialPipeline(
-    AsyncLayer* pAsyncLayer,
-    VkShaderModule asyncShaderModule)
+    AsyncLayer*        pAsyncLayer,
+    VkShaderModule     asyncShaderModule,
+    const void*        pOwner,
+    volatile uint32_t* pOwnerTaskCount)
 {
-    auto pTaskThread = reinterpret_cast<async::TaskThread<PartialPipelineTask>*>
-                       (pAsyncLayer->GetTaskThread(PartialPipelineTaskType));
-    if (pTaskThread != nullptr)
-    {
-        PartialPipelineTask task = {};
+    async::TaskPool* pTaskPool = pAsyncLayer->GetTaskPool();
+    AsyncTask        task      = {};
 
-        task.shaderModuleHandle = asyncShaderModule;
-        task.pObj = this;
-        pTaskThread->AddTask(&task);
-    }
-    else
+    task.type     = PartialPipelineTaskType;
+    task.priority = async::TaskPriorityLow;
+    task.pOwner   = pOwner;
+    task.partialPipeline.shaderModuleHandle = asyncShaderModule;
+    task.partialPipeline.pObj = this;
+    task.partialPipeline.pOwnerTaskCount = pOwnerTaskCount;
+
+    if ((pTaskPool == nullptr) || (pTaskPool->AddTask(&task) != VK_SUCCESS))
     {
+        if (pTaskPool != nullptr)
+        {
+            pTaskPool->CompleteTask(pOwnerTaskCount);
+        }
+
         Destroy();
     }
 }
@@ -355,31 +363,81 @@ void PartialPipeline::Execute(
     vk::ShaderModule* pShaderModule = vk::ShaderModule::ObjectFromHandle(pTask->shaderModuleHandle);
     void* pShaderModuleData =  pShaderModule->GetShaderData(compilerType);
     auto pShaderModuleDataEx = reinterpret_cast<Vkgc::ShaderModuleDataEx*>(pShaderModuleData);
-    Vkgc::ShaderModuleEntryData* pShaderModuleEntryData = nullptr;
+
+    // The color targets are derived from the module's fragment outputs, so they are the same for every entry.
     Vkgc::ColorTarget pColorTarget[Vkgc::MaxColorTargets] = {};
-    if ((pShaderModuleDataEx->extra.entryCount == 1) &&
-        (pShaderModuleDataEx->extra.entryDatas[0].stage == Vkgc::ShaderStageCompute))
-    {
-        pShaderModuleEntryData = &pShaderModuleDataEx->extra.entryDatas[0];
-    }
-    else
+    bool              colorTargetsValid                   = false;
+
+    for (uint32_t i = 0; i < pShaderModuleDataEx->extra.entryCount; ++i)
     {
-        for (uint32_t i = 0; i < pShaderModuleDataEx->extra.entryCount; ++i)
+        Vkgc::ShaderModuleEntryData* pShaderModuleEntryData = &pShaderModuleDataEx->extra.entryDatas[i];
+
+        if (pShaderModuleEntryData->stage == Vkgc::ShaderStageFragment)
         {
-            if (pShaderModuleDataEx->extra.entryDatas[i].stage == Vkgc::ShaderStageFragment)
+            if (colorTargetsValid == false)
             {
                 CreateColorTargetFromModuleData(pShaderModuleDataEx, pColorTarget);
-                if (pColorTarget[0].format == VK_FORMAT_UNDEFINED)
-                {
-                    break;
-                }
+                colorTargetsValid = true;
+            }
 
-                pShaderModuleEntryData = &pShaderModuleDataEx->extra.entryDatas[i];
-                break;
+            if (pColorTarget[0].format != VK_FORMAT_UNDEFINED)
+            {
+                BuildPart(pAsyncLayer, pShaderModule, pShaderModuleData, pShaderModuleEntryData, pColorTarget);
             }
         }
+        else if (pShaderModuleEntryData->stage == Vkgc::ShaderStageCompute)
+        {
+            BuildPart(pAsyncLayer, pShaderModule, pShaderModuleData, pShaderModuleEntryData, nullptr);
+        }
+    }
+
+    Destroy();
+}
+
+// =====================================================================================================================
+// Returns the key of a part in the async layer's part cache: the entry point's code hash and the state the part was
+// built with.
+uint64_t PartialPipeline::GetPartKey(
+    const vk::ShaderModule*            pShaderModule,
+    const Vkgc::ShaderModuleEntryData* pShaderModuleEntryData,
+    const Vkgc::ColorTarget*           pColorTarget)
+{
+    const Pal::ShaderHash codeHash = pShaderModule->GetCodeHash(pShaderModuleEntryData->pEntryName);
+
+    Util::MetroHash64 hasher;
+
+    hasher.Update(codeHash.lower);
+    hasher.Update(codeHash.upper);
+    hasher.Update(pShaderModuleEntryData->stage);
+
+    if (pColorTarget != nullptr)
+    {
+        for (uint32_t i = 0; i < Vkgc::MaxColorTargets; ++i)
+        {
+            hasher.Update(pColorTarget[i].format);
+            hasher.Update(pColorTarget[i].channelWriteMask);
+        }
     }
-    if (pShaderModuleEntryData != nullptr)
+
+    uint64_t key = 0;
+    hasher.Finalize(reinterpret_cast<uint8_t* const>(&key));
+
+    return key;
+}
+
+// =====================================================================================================================
+// Builds the pipeline part of one entry point on every device, unless an identical part was built before.  Parts end up
+// in the compiler's shader cache, where full pipelines sharing the entry point and state pick them up.
+void PartialPipeline::BuildPart(
+    AsyncLayer*                  pAsyncLayer,
+    const vk::ShaderModule*      pShaderModule,
+    void*                        pShaderModuleData,
+    Vkgc::ShaderModuleEntryData* pShaderModuleEntryData,
+    Vkgc::ColorTarget*           pColorTarget)
+{
+    Device* pDevice = pAsyncLayer->GetDevice();
+
+    if (pAsyncLayer->ClaimPartialPipelinePart(GetPartKey(pShaderModule, pShaderModuleEntryData, pColorTarget)))
     {
         for (uint32_t deviceIdx = 0; deviceIdx < pDevice->NumPalDevices(); deviceIdx++)
         {
@@ -393,7 +451,6 @@ void PartialPipeline::Execute(
             m_pAllocator->pfnFree(m_pAllocator->pUserData, (void*)pResourceMappingNode);
         }
     }
-    Destroy();
 }
 
 } // namespace async
@@ -44,6 +44,8 @@
 namespace vk
 {
 
+class ShaderModule;
+
 namespace async
 {
 
@@ -80,11 +82,37 @@ public:
 
     void Execute(AsyncLayer* pAsyncLayer, PartialPipelineTask* pTask);
 
-    void AsyncBuildPartialPipeline(AsyncLayer* pAsyncLayer, VkShaderModule asyncShaderModule);
+    static uint64_t GetPartKey(
+        const vk::ShaderModule*            pShaderModule,
+#if LLPC_CLIENT_INTERFACE_MAJOR_VERSION >= 39
+        const Vkgc::ShaderModuleEntryData* pShaderModuleEntryData,
+        const Vkgc::ColorTarget*           pColorTarget);
+#else
+        const Llpc::ShaderModuleEntryData* pShaderModuleEntryData,
+        const Llpc::ColorTarget*           pColorTarget);
+#endif
+
+    void AsyncBuildPartialPipeline(
+        AsyncLayer*        pAsyncLayer,
+        VkShaderModule     asyncShaderModule,
+        const void*        pOwner,
+        volatile uint32_t* pOwnerTaskCount);
 
 protected:
     PartialPipeline(const VkAllocationCallbacks* pAllocator);
 
+    void BuildPart(
+        AsyncLayer*                  pAsyncLayer,
+        const vk::ShaderModule*      pShaderModule,
+        void*                        pShaderModuleData,
+#if LLPC_CLIENT_INTERFACE_MAJOR_VERSION >= 39
+        Vkgc::ShaderModuleEntryData* pShaderModuleEntryData,
+        Vkgc::ColorTarget*           pColorTarget);
+#else
+        Llpc::ShaderModuleEntryData* pShaderModuleEntryData,
+        Llpc::ColorTarget*           pColorTarget);
+#endif
+
 private:
     const VkAllocationCallbacks*    m_pAllocator;
 
@@ -33,8 +33,8 @@
 #include "async_partial_pipeline.h"
 
 #include "include/vk_device.h"
+#include "include/vk_instance.h"
 #include "include/vk_shader.h"
-#include "palListImpl.h"
 
 namespace vk
 {
@@ -42,12 +42,79 @@ namespace vk
 namespace async
 {
 
+// =====================================================================================================================
+OptimizedShaderModule::OptimizedShaderModule(
+    Device*       pDevice,
+    ShaderModule* pOwner)
+    :
+    m_pDevice(pDevice),
+    m_pOwner(pOwner),
+    m_module(VK_NULL_HANDLE),
+    m_refCount(1),
+    m_claimed(0),
+    m_buildPending(0)
+{
+}
+
+// =====================================================================================================================
+// Creates the optimized build of pOwner, holding the owner's reference.  The build itself is queued by the owner.
+OptimizedShaderModule* OptimizedShaderModule::Create(
+    Device*       pDevice,
+    ShaderModule* pOwner)
+{
+    void* pMemory = pDevice->VkInstance()->AllocMem(sizeof(OptimizedShaderModule),
+                                                    VK_DEFAULT_MEM_ALIGN,
+                                                    VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+    return (pMemory != nullptr) ? VK_PLACEMENT_NEW(pMemory) OptimizedShaderModule(pDevice, pOwner) : nullptr;
+}
+
+// =====================================================================================================================
+// Drops a reference.  The optimized module was created without application callbacks, so the last reference may be
+// dropped on any thread.
+void OptimizedShaderModule::Release(
+    AsyncLayer* pAsyncLayer)
+{
+    if (Util::AtomicDecrement(&m_refCount) == 0)
+    {
+        if (m_module != VK_NULL_HANDLE)
+        {
+            ASYNC_CALL_NEXT_LAYER(vkDestroyShaderModule)(VkDevice(ApiDevice::FromObject(m_pDevice)),
+                                                         m_module,
+                                                         nullptr);
+        }
+
+        Instance* pInstance = m_pDevice->VkInstance();
+
+        Util::Destructor(this);
+
+        pInstance->FreeMem(this);
+    }
+}
+
+// =====================================================================================================================
+// Returns once the build has finished.  A build no worker has picked up yet runs right here; the owner is still alive
+// then, since it isn't destroyed before its build has finished.  Safe to call from a pool task: the build never waits
+// on other tasks.
+void OptimizedShaderModule::WaitForBuild(
+    AsyncLayer* pAsyncLayer)
+{
+    if (Claim())
+    {
+        m_pOwner->RunClaimedBuild(pAsyncLayer);
+    }
+
+    pAsyncLayer->GetTaskPool()->WaitForTasks(&m_buildPending);
+}
+
 // =====================================================================================================================
 ShaderModule::ShaderModule(
-    VkShaderModule immedModule)
+    VkShaderModule         immedModule,
+    OptimizedShaderModule* pOptimized)
     :
     m_immedModule(immedModule),
-    m_asyncModule(VK_NULL_HANDLE)
+    m_pOptimized(pOptimized),
+    m_pendingTasks(0)
 {
 }
 
@@ -80,13 +147,26 @@ VkResult ShaderModule::Create(
             VK_DEFAULT_MEM_ALIGN,
             VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
 
-        if (pMemory == nullptr)
+        ShaderModule* pShaderModuleObj = static_cast<ShaderModule*>(pMemory);
+        OptimizedShaderModule* pOptimized = (pMemory != nullptr) ?
+                                            OptimizedShaderModule::Create(pDevice, pShaderModuleObj) : nullptr;
+
+        if (pOptimized == nullptr)
         {
+            if (pMemory != nullptr)
+            {
+                pAllocator->pfnFree(pAllocator->pUserData, pMemory);
+            }
+
+            ASYNC_CALL_NEXT_LAYER(vkDestroyShaderModule)(
+                VkDevice(ApiDevice::FromObject(pDevice)),
+                immedModule,
+                pAllocator);
+
             return VK_ERROR_OUT_OF_HOST_MEMORY;
         }
 
-        VK_PLACEMENT_NEW(pMemory) ShaderModule(immedModule);
-        ShaderModule* pShaderModuleObj = static_cast<ShaderModule*>(pMemory);
+        VK_PLACEMENT_NEW(pMemory) ShaderModule(immedModule, pOptimized);
         *pShaderModule = ShaderModule::HandleFromVoidPointer(pMemory);
 
         // Build shader module in async mode
@@ -103,10 +183,10 @@ VkResult ShaderModule::Destroy(
     const VkAllocationCallbacks* pAllocator)
 {
     AsyncLayer* pAsyncLayer = pDevice->GetAsyncLayer();
-    if (m_asyncModule == VK_NULL_HANDLE)
-    {
-        pAsyncLayer->SyncAll();
-    }
+
+    // Partial pipeline tasks still reference the async module.  Pipeline hot swaps hold their own reference to the
+    // optimized module instead, so they aren't waited for.
+    PromoteAndWait(pAsyncLayer);
 
     if (m_immedModule != VK_NULL_HANDLE)
     {
@@ -116,13 +196,7 @@ VkResult ShaderModule::Destroy(
             pAllocator);
     }
 
-    if (m_asyncModule != VK_NULL_HANDLE)
-    {
-        ASYNC_CALL_NEXT_LAYER(vkDestroyShaderModule)(
-            VkDevice(ApiDevice::FromObject(pDevice)),
-            m_asyncModule,
-            pAllocator);
-    }
+    m_pOptimized->Release(pAsyncLayer);
 
     return VK_SUCCESS;
 }
@@ -132,45 +206,141 @@ VkResult ShaderModule::Destroy(
 void ShaderModule::AsyncBuildShaderModule(
     AsyncLayer* pAsyncLayer)
 {
-    auto pTaskThread = reinterpret_cast<async::TaskThread<ShaderModuleTask>*>
-                       (pAsyncLayer->GetTaskThread(ShaderModuleTaskType));
-    if (pTaskThread != nullptr)
+    async::TaskPool* pTaskPool = pAsyncLayer->GetTaskPool();
+    if (pTaskPool != nullptr)
+    {
+        AsyncTask task = {};
+        task.type     = ShaderModuleTaskType;
+        task.priority = async::TaskPriorityNormal;
+        task.pOwner   = this;
+        InitTaskInfo(&task.shaderModule.info);
+        task.shaderModule.pObj = this;
+
+        m_pendingTasks               = 1;
+        m_pOptimized->m_buildPending = 1;
+
+        if (pTaskPool->AddTask(&task) != VK_SUCCESS)
+        {
+            // The module keeps using the immediate mode build.
+            m_pOptimized->m_claimed      = 1;
+            m_pOptimized->m_buildPending = 0;
+            m_pendingTasks               = 0;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Fills in the create info of the async build from the immediate mode module.
+void ShaderModule::InitTaskInfo(
+    VkShaderModuleCreateInfo* pInfo) const
+{
+    vk::ShaderModule* pNextLayerModule = vk::ShaderModule::ObjectFromHandle(m_immedModule);
+
+    pInfo->sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    pInfo->pCode    = reinterpret_cast<const uint32_t*>(pNextLayerModule->GetCode());
+    pInfo->codeSize = pNextLayerModule->GetCodeSize();
+    pInfo->flags    = VK_SHADER_MODULE_ENABLE_OPT_BIT;
+}
+
+// =====================================================================================================================
+// Makes sure the async build and the partial pipelines of this module have finished, without waiting for unrelated
+// tasks queued ahead of them.  A build which hasn't started yet runs on the calling thread; partial pipelines are moved
+// to the front of the pool's queues.
+void ShaderModule::PromoteAndWait(
+    AsyncLayer* pAsyncLayer)
+{
+    if (m_pendingTasks != 0)
     {
-        vk::ShaderModule* pNextLayerModule = vk::ShaderModule::ObjectFromHandle(m_immedModule);
-
-        ShaderModuleTask task = {};
-        task.info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        task.info.pCode = reinterpret_cast<const uint32_t*>(pNextLayerModule->GetCode());
-        task.info.codeSize = pNextLayerModule->GetCodeSize();
-        task.info.flags = VK_SHADER_MODULE_ENABLE_OPT_BIT;
-        task.pObj = this;
-        pTaskThread->AddTask(&task);
+        async::TaskPool* pTaskPool = pAsyncLayer->GetTaskPool();
+
+        VK_ASSERT(pTaskPool != nullptr);
+
+        // The queued copy of the task is skipped once it reaches a worker.
+        if (m_pOptimized->Claim())
+        {
+            RunClaimedBuild(pAsyncLayer);
+        }
+
+        pTaskPool->PromoteTasks(this);
+        pTaskPool->WaitForTasks(&m_pendingTasks);
     }
 }
 
 // =====================================================================================================================
-// Creates shader module with shader module opt enabled.
+// Runs the async build on the calling thread.  The caller must have claimed it.
+void ShaderModule::RunClaimedBuild(
+    AsyncLayer* pAsyncLayer)
+{
+    VkShaderModuleCreateInfo info = {};
+
+    InitTaskInfo(&info);
+
+    Build(pAsyncLayer, &info);
+}
+
+// =====================================================================================================================
+// Runs the queued async build, unless another thread has claimed it first.
 void ShaderModule::Execute(
     AsyncLayer*      pAsyncLayer,
     ShaderModuleTask* pTask)
+{
+    if (m_pOptimized->Claim())
+    {
+        Build(pAsyncLayer, &pTask->info);
+    }
+}
+
+// =====================================================================================================================
+// Creates shader module with shader module opt enabled.  The module may be destroyed as soon as this returns.
+void ShaderModule::Build(
+    AsyncLayer*               pAsyncLayer,
+    VkShaderModuleCreateInfo* pInfo)
 {
     Device* pDevice = pAsyncLayer->GetDevice();
-    ASYNC_CALL_NEXT_LAYER(vkCreateShaderModule)(VkDevice(ApiDevice::FromObject(pDevice)),
-                                                &pTask->info,
-                                                nullptr,
-                                                &m_asyncModule);
+    VkShaderModule asyncModule = VK_NULL_HANDLE;
+    void* pCode = nullptr;
+
+    if (pInfo->pCode == nullptr)
+    {
+        // The immediate mode module retains its code compressed.
+        const vk::ShaderModule* pNextLayerModule = vk::ShaderModule::ObjectFromHandle(m_immedModule);
+
+        pCode = pDevice->VkInstance()->AllocMem(pInfo->codeSize, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+
+        if ((pCode != nullptr) && (pNextLayerModule->CopyCode(pCode) == VK_SUCCESS))
+        {
+            pInfo->pCode = static_cast<const uint32_t*>(pCode);
+        }
+    }
+
+    if (pInfo->pCode != nullptr)
+    {
+        ASYNC_CALL_NEXT_LAYER(vkCreateShaderModule)(VkDevice(ApiDevice::FromObject(pDevice)),
+                                                    pInfo,
+                                                    nullptr,
+                                                    &asyncModule);
+    }
+
+    pDevice->VkInstance()->FreeMem(pCode);
+
+    m_pOptimized->m_module = asyncModule;
     const RuntimeSettings& settings  = pDevice->GetRuntimeSettings();
     if (settings.enablePartialPipelineCompile)
     {
         const VkAllocationCallbacks* pAllocCB = pDevice->VkInstance()->GetAllocCallbacks();
         auto pPartialPipelineObj = vk::async::PartialPipeline::Create(pDevice, pAllocCB);
 
-        if ((pPartialPipelineObj != nullptr) && (m_asyncModule != VK_NULL_HANDLE))
+        if ((pPartialPipelineObj != nullptr) && (asyncModule != VK_NULL_HANDLE))
         {
             // Build partial pipeline in async mode
-            pPartialPipelineObj->AsyncBuildPartialPipeline(pDevice->GetAsyncLayer(), m_asyncModule);
+            Util::AtomicIncrement(&m_pendingTasks);
+            pPartialPipelineObj->AsyncBuildPartialPipeline(pDevice->GetAsyncLayer(), asyncModule, this,
+                                                           &m_pendingTasks);
         }
     }
+
+    pAsyncLayer->GetTaskPool()->CompleteTask(&m_pOptimized->m_buildPending);
+    pAsyncLayer->GetTaskPool()->CompleteTask(&m_pendingTasks);
 }
 
 } // namespace async
@@ -42,6 +42,45 @@ namespace vk
 namespace async
 {
 
+class ShaderModule;
+
+// =====================================================================================================================
+// The optimized build of an async shader module.  It is reference counted apart from the module: pipeline hot swaps
+// hold a reference until their rebuild has run, so the application can destroy the module without waiting for them.
+// The last reference destroys the optimized next layer module.
+class OptimizedShaderModule
+{
+public:
+    static OptimizedShaderModule* Create(Device* pDevice, ShaderModule* pOwner);
+
+    VK_INLINE void AddRef() { Util::AtomicIncrement(&m_refCount); }
+
+    void Release(AsyncLayer* pAsyncLayer);
+
+    // Returns true for the one caller which gets to run the build.
+    VK_INLINE bool Claim() { return (Util::AtomicCompareAndSwap(&m_claimed, 0, 1) == 0); }
+
+    VK_INLINE bool IsBuildPending() const { return (m_buildPending != 0); }
+
+    void WaitForBuild(AsyncLayer* pAsyncLayer);
+
+    VK_INLINE VkShaderModule GetModule() const { return m_module; }
+
+private:
+    OptimizedShaderModule(Device* pDevice, ShaderModule* pOwner);
+
+    friend class ShaderModule;
+
+    Device* const       m_pDevice;
+    ShaderModule* const m_pOwner;          // Only valid until the build has finished
+    VkShaderModule      m_module;          // Next layer module compiled with optimization, if the build succeeded
+    volatile uint32_t   m_refCount;
+    volatile uint32_t   m_claimed;         // Set by whichever thread runs the build first
+    volatile uint32_t   m_buildPending;    // Non-zero until the build has finished
+
+    PAL_DISALLOW_COPY_AND_ASSIGN(OptimizedShaderModule);
+};
+
 // =====================================================================================================================
 // Implementation of a async shader module
 class ShaderModule final : public vk::NonDispatchable<VkShaderModule, ShaderModule>
@@ -59,18 +98,33 @@ public:
 
     VK_INLINE VkShaderModule GetNextLayerModule()
     {
-        return (m_asyncModule == VK_NULL_HANDLE) ? m_immedModule : m_asyncModule;
+        const VkShaderModule asyncModule = m_pOptimized->GetModule();
+
+        return (asyncModule == VK_NULL_HANDLE) ? m_immedModule : asyncModule;
     }
 
     void Execute(AsyncLayer* pAsyncLayer, ShaderModuleTask* pTask);
 
     void AsyncBuildShaderModule(AsyncLayer* pAsyncLayer);
 
+    void PromoteAndWait(AsyncLayer* pAsyncLayer);
+
+    void RunClaimedBuild(AsyncLayer* pAsyncLayer);
+
+    VK_INLINE bool IsBuildPending() const { return m_pOptimized->IsBuildPending(); }
+
+    VK_INLINE OptimizedShaderModule* GetOptimizedModule() { return m_pOptimized; }
+
 protected:
-    ShaderModule(VkShaderModule immedModule);
+    ShaderModule(VkShaderModule immedModule, OptimizedShaderModule* pOptimized);
+
+    void InitTaskInfo(VkShaderModuleCreateInfo* pInfo) const;
+
+    void Build(AsyncLayer* pAsyncLayer, VkShaderModuleCreateInfo* pInfo);
 
-    VkShaderModule m_immedModule;        // Shader module handle which is compiled with immedidate mode
-    VkShaderModule m_asyncModule;        // Shader module handle which is compiled with async mode
+    VkShaderModule         m_immedModule;     // Shader module handle which is compiled with immedidate mode
+    OptimizedShaderModule* m_pOptimized;      // Async build; the module holds one reference
+    volatile uint32_t      m_pendingTasks;    // Async build plus partial pipeline tasks which haven't finished
 
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(ShaderModule);
@@ -0,0 +1,445 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  async_task_pool.cpp
+* @brief Implementation of the work-stealing thread pool shared by the async compiler layer
+***********************************************************************************************************************
+*/
+#include "async_task_pool.h"
+#include "async_layer.h"
+
+#include "include/vk_conv.h"
+#include "include/vk_instance.h"
+
+#include "palSysUtil.h"
+
+namespace vk
+{
+
+namespace async
+{
+
+// A queued task
+struct TaskPool::TaskNode
+{
+    AsyncTask task;    // Copy of the submitted task
+    TaskNode* pPrev;   // Previous (older) task in the queue
+    TaskNode* pNext;   // Next (newer) task in the queue
+};
+
+// =====================================================================================================================
+TaskPool::TaskPool(
+    AsyncLayer* pAsyncLayer,
+    Instance*   pInstance)
+    :
+    m_pAsyncLayer(pAsyncLayer),
+    m_pInstance(pInstance),
+    m_threadCount(0),
+    m_nextQueue(0),
+    m_queuedTasks(0),
+    m_outstandingTasks(0),
+    m_stop(false)
+{
+    for (uint32_t i = 0; i < MaxThreads; ++i)
+    {
+        for (uint32_t priority = 0; priority < TaskPriorityCount; ++priority)
+        {
+            m_queues[i].pHead[priority] = nullptr;
+            m_queues[i].pTail[priority] = nullptr;
+        }
+
+        m_workerInfo[i].pPool = this;
+        m_workerInfo[i].index = i;
+    }
+}
+
+// =====================================================================================================================
+// Stops and joins the workers.  Tasks which haven't started yet are dropped.
+TaskPool::~TaskPool()
+{
+    m_stop = true;
+    m_wakeEvent.Set();
+
+    for (uint32_t i = 0; i < m_threadCount; ++i)
+    {
+        m_threads[i].Join();
+    }
+
+    for (uint32_t i = 0; i < m_threadCount; ++i)
+    {
+        for (uint32_t priority = 0; priority < TaskPriorityCount; ++priority)
+        {
+            TaskNode* pNode = nullptr;
+
+            while ((pNode = PopFront(&m_queues[i], priority)) != nullptr)
+            {
+                m_pInstance->FreeMem(pNode);
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Starts up to threadCount workers.  Fails if no worker could be started.
+VkResult TaskPool::Init(
+    uint32_t threadCount)
+{
+    Util::EventCreateFlags wakeFlags = {};
+    wakeFlags.manualReset       = false;
+    wakeFlags.initiallySignaled = false;
+
+    Util::EventCreateFlags idleFlags = {};
+    idleFlags.manualReset       = true;
+    idleFlags.initiallySignaled = true;
+
+    VkResult result = PalToVkResult(m_wakeEvent.Init(wakeFlags));
+
+    if (result == VK_SUCCESS)
+    {
+        result = PalToVkResult(m_idleEvent.Init(idleFlags));
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        result = PalToVkResult(m_taskDone.Init());
+    }
+
+    threadCount = Util::Min(threadCount, MaxThreads);
+
+    for (uint32_t i = 0; (result == VK_SUCCESS) && (i < threadCount); ++i)
+    {
+        if (m_threads[i].Begin(ThreadFunc, &m_workerInfo[i]) == Util::Result::Success)
+        {
+            m_threadCount++;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if ((result == VK_SUCCESS) && (m_threadCount == 0))
+    {
+        result = VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Queues a copy of the task and wakes a worker.
+VkResult TaskPool::AddTask(
+    const AsyncTask* pTask)
+{
+    VK_ASSERT(m_threadCount > 0);
+    VK_ASSERT(pTask->priority < TaskPriorityCount);
+
+    TaskNode* pNode = static_cast<TaskNode*>(m_pInstance->AllocMem(sizeof(TaskNode),
+                                                                   VK_SYSTEM_ALLOCATION_SCOPE_DEVICE));
+
+    if (pNode == nullptr)
+    {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    pNode->task  = *pTask;
+    pNode->pNext = nullptr;
+
+    {
+        Util::MutexAuto lock(&m_countLock);
+
+        if (m_outstandingTasks++ == 0)
+        {
+            m_idleEvent.Reset();
+        }
+    }
+
+    TaskQueue* pQueue = &m_queues[Util::AtomicIncrement(&m_nextQueue) % m_threadCount];
+
+    {
+        Util::MutexAuto lock(&pQueue->lock);
+
+        const uint32_t priority = pTask->priority;
+
+        pNode->pPrev = pQueue->pTail[priority];
+
+        if (pQueue->pTail[priority] != nullptr)
+        {
+            pQueue->pTail[priority]->pNext = pNode;
+        }
+        else
+        {
+            pQueue->pHead[priority] = pNode;
+        }
+
+        pQueue->pTail[priority] = pNode;
+    }
+
+    Util::AtomicIncrement(&m_queuedTasks);
+
+    m_wakeEvent.Set();
+
+    return VK_SUCCESS;
+}
+
+// =====================================================================================================================
+// Returns once every queued task has finished.  The calling thread runs queued tasks itself while it waits.
+void TaskPool::SyncAll()
+{
+    TaskNode* pNode = nullptr;
+
+    while ((pNode = PopTask(0)) != nullptr)
+    {
+        RunTask(pNode);
+    }
+
+    // Everything left has been claimed by a worker; wait for the workers to finish.
+    while (true)
+    {
+        {
+            Util::MutexAuto lock(&m_countLock);
+
+            if (m_outstandingTasks == 0)
+            {
+                break;
+            }
+        }
+
+        m_idleEvent.Wait(IdleWaitSeconds);
+    }
+}
+
+// =====================================================================================================================
+// Moves the queued tasks of pOwner to the front of the high priority lists, so the next free worker picks them up.
+void TaskPool::PromoteTasks(
+    const void* pOwner)
+{
+    for (uint32_t i = 0; i < m_threadCount; ++i)
+    {
+        TaskQueue* pQueue = &m_queues[i];
+
+        Util::MutexAuto lock(&pQueue->lock);
+
+        for (uint32_t priority = TaskPriorityHigh + 1; priority < TaskPriorityCount; ++priority)
+        {
+            TaskNode* pNode = pQueue->pHead[priority];
+
+            while (pNode != nullptr)
+            {
+                TaskNode* pNext = pNode->pNext;
+
+                if (pNode->task.pOwner == pOwner)
+                {
+                    Unlink(pQueue, priority, pNode);
+
+                    pNode->task.priority = TaskPriorityHigh;
+                    pNode->pPrev         = nullptr;
+                    pNode->pNext         = pQueue->pHead[TaskPriorityHigh];
+
+                    if (pQueue->pHead[TaskPriorityHigh] != nullptr)
+                    {
+                        pQueue->pHead[TaskPriorityHigh]->pPrev = pNode;
+                    }
+                    else
+                    {
+                        pQueue->pTail[TaskPriorityHigh] = pNode;
+                    }
+
+                    pQueue->pHead[TaskPriorityHigh] = pNode;
+                }
+
+                pNode = pNext;
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Retires one task from an owner's outstanding task count and wakes up WaitForTasks().
+void TaskPool::CompleteTask(
+    volatile uint32_t* pTaskCount)
+{
+    Util::MutexAuto lock(&m_countLock);
+
+    VK_ASSERT(*pTaskCount > 0);
+
+    (*pTaskCount)--;
+
+    m_taskDone.WakeAll();
+}
+
+// =====================================================================================================================
+// Blocks until an owner's outstanding task count drops to zero.  Only waits for the tasks counted there, not for
+// unrelated work queued ahead of them.
+void TaskPool::WaitForTasks(
+    volatile uint32_t* pTaskCount)
+{
+    Util::MutexAuto lock(&m_countLock);
+
+    while (*pTaskCount != 0)
+    {
+        m_taskDone.Wait(&m_countLock, IdleWaitMilliseconds);
+    }
+}
+
+// =====================================================================================================================
+void TaskPool::ThreadFunc(
+    void* pParam)
+{
+    WorkerInfo* pInfo = static_cast<WorkerInfo*>(pParam);
+
+    pInfo->pPool->WorkerLoop(pInfo->index);
+}
+
+// =====================================================================================================================
+void TaskPool::WorkerLoop(
+    uint32_t workerIndex)
+{
+    while (m_stop == false)
+    {
+        TaskNode* pNode = PopTask(workerIndex);
+
+        if (pNode != nullptr)
+        {
+            RunTask(pNode);
+        }
+        else
+        {
+            m_wakeEvent.Wait(IdleWaitSeconds);
+        }
+    }
+
+    // The wake event auto-resets, so pass the stop signal on to the next worker.
+    m_wakeEvent.Set();
+}
+
+// =====================================================================================================================
+// Claims a task for a worker: for the highest priority which has queued work, the oldest task of its own queue,
+// otherwise the newest task of another queue.
+TaskPool::TaskNode* TaskPool::PopTask(
+    uint32_t workerIndex)
+{
+    TaskNode* pNode = nullptr;
+
+    for (uint32_t priority = 0; (pNode == nullptr) && (priority < TaskPriorityCount); ++priority)
+    {
+        pNode = PopFront(&m_queues[workerIndex], priority);
+
+        for (uint32_t i = 1; (pNode == nullptr) && (i < m_threadCount); ++i)
+        {
+            pNode = PopBack(&m_queues[(workerIndex + i) % m_threadCount], priority);
+        }
+    }
+
+    if ((pNode != nullptr) && (Util::AtomicDecrement(&m_queuedTasks) > 0))
+    {
+        // More work is left; wake another worker.
+        m_wakeEvent.Set();
+    }
+
+    return pNode;
+}
+
+// =====================================================================================================================
+TaskPool::TaskNode* TaskPool::PopFront(
+    TaskQueue* pQueue,
+    uint32_t   priority)
+{
+    Util::MutexAuto lock(&pQueue->lock);
+
+    TaskNode* pNode = pQueue->pHead[priority];
+
+    if (pNode != nullptr)
+    {
+        Unlink(pQueue, priority, pNode);
+    }
+
+    return pNode;
+}
+
+// =====================================================================================================================
+TaskPool::TaskNode* TaskPool::PopBack(
+    TaskQueue* pQueue,
+    uint32_t   priority)
+{
+    Util::MutexAuto lock(&pQueue->lock);
+
+    TaskNode* pNode = pQueue->pTail[priority];
+
+    if (pNode != nullptr)
+    {
+        Unlink(pQueue, priority, pNode);
+    }
+
+    return pNode;
+}
+
+// =====================================================================================================================
+// Removes a node from one of the queue's lists.  Must be called with the queue lock held.
+void TaskPool::Unlink(
+    TaskQueue* pQueue,
+    uint32_t   priority,
+    TaskNode*  pNode)
+{
+    if (pNode->pPrev != nullptr)
+    {
+        pNode->pPrev->pNext = pNode->pNext;
+    }
+    else
+    {
+        pQueue->pHead[priority] = pNode->pNext;
+    }
+
+    if (pNode->pNext != nullptr)
+    {
+        pNode->pNext->pPrev = pNode->pPrev;
+    }
+    else
+    {
+        pQueue->pTail[priority] = pNode->pPrev;
+    }
+}
+
+// =====================================================================================================================
+// Executes and frees a claimed task.
+void TaskPool::RunTask(
+    TaskNode* pNode)
+{
+    m_pAsyncLayer->ExecuteTask(&pNode->task);
+
+    m_pInstance->FreeMem(pNode);
+
+    Util::MutexAuto lock(&m_countLock);
+
+    if (--m_outstandingTasks == 0)
+    {
+        m_idleEvent.Set();
+    }
+}
+
+} // namespace async
+
+} // namespace vk
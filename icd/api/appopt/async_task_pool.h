@@ -0,0 +1,152 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  async_task_pool.h
+* @brief Declaration of the work-stealing thread pool shared by the async compiler layer
+***********************************************************************************************************************
+*/
+#ifndef __ASYNC_TASK_POOL_H__
+#define __ASYNC_TASK_POOL_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "palThread.h"
+#include "palMutex.h"
+#include "palEvent.h"
+#include "palConditionVariable.h"
+
+namespace vk
+{
+
+class AsyncLayer;
+class Instance;
+struct AsyncTask;
+
+namespace async
+{
+
+// Scheduling priority of a task.  Workers always pick a task of the highest priority available in any queue.
+enum TaskPriority : uint32_t
+{
+    TaskPriorityHigh = 0,     // Tasks the application is waiting for
+    TaskPriorityNormal,       // Shader module builds
+    TaskPriorityLow,          // Speculative work like partial pipelines
+    TaskPriorityCount,
+};
+
+// =====================================================================================================================
+// A pool of worker threads executing the shader module and partial pipeline tasks of the async layer.  Every worker
+// owns a task queue per priority; new tasks are distributed over the queues round-robin and a worker whose queues run
+// dry steals from the other queues, so a burst of tasks never waits behind a single busy thread.  Idle workers and
+// SyncAll() block on events instead of polling.
+//
+// Objects which need their own tasks finished (rather than the whole pool drained) keep a count of their outstanding
+// tasks: PromoteTasks() moves their queued tasks to the front, CompleteTask() retires one and WaitForTasks() blocks
+// until the count reaches zero.
+class TaskPool
+{
+public:
+    TaskPool(AsyncLayer* pAsyncLayer, Instance* pInstance);
+    ~TaskPool();
+
+    VkResult Init(uint32_t threadCount);
+
+    VkResult AddTask(const AsyncTask* pTask);
+
+    void SyncAll();
+
+    void PromoteTasks(const void* pOwner);
+
+    void CompleteTask(volatile uint32_t* pTaskCount);
+
+    void WaitForTasks(volatile uint32_t* pTaskCount);
+
+    VK_INLINE uint32_t GetThreadCount() const
+        { return m_threadCount; }
+
+    static constexpr uint32_t MaxThreads = 8;  // Upper bound on the number of worker threads
+
+    // Idle workers are woken explicitly; the timeout only bounds how long a lost wakeup could stall them.
+    static constexpr float IdleWaitSeconds = 10.0f;
+    static constexpr uint32_t IdleWaitMilliseconds = 10000;
+
+private:
+    PAL_DISALLOW_DEFAULT_CTOR(TaskPool);
+    PAL_DISALLOW_COPY_AND_ASSIGN(TaskPool);
+
+    struct TaskNode;
+
+    // Per-worker queue with one list per priority.  The owner takes tasks from the front, thieves take them from the
+    // back.
+    struct TaskQueue
+    {
+        Util::Mutex lock;                        // Protects the lists
+        TaskNode*   pHead[TaskPriorityCount];    // Oldest task of each priority
+        TaskNode*   pTail[TaskPriorityCount];    // Newest task of each priority
+    };
+
+    // Parameters of a worker thread
+    struct WorkerInfo
+    {
+        TaskPool* pPool;     // Owning pool
+        uint32_t  index;     // Index of the worker's own queue
+    };
+
+    static void ThreadFunc(void* pParam);
+
+    void WorkerLoop(uint32_t workerIndex);
+
+    TaskNode* PopTask(uint32_t workerIndex);
+    TaskNode* PopFront(TaskQueue* pQueue, uint32_t priority);
+    TaskNode* PopBack(TaskQueue* pQueue, uint32_t priority);
+
+    static void Unlink(TaskQueue* pQueue, uint32_t priority, TaskNode* pNode);
+
+    void RunTask(TaskNode* pNode);
+
+    AsyncLayer* const m_pAsyncLayer;
+    Instance* const   m_pInstance;
+    uint32_t          m_threadCount;               // Number of worker threads that were started
+    Util::Thread      m_threads[MaxThreads];       // Worker threads
+    WorkerInfo        m_workerInfo[MaxThreads];    // Parameters passed to the worker threads
+    TaskQueue         m_queues[MaxThreads];        // Per-worker task queues
+    volatile uint32_t m_nextQueue;                 // Round-robin hint for queueing new tasks
+    volatile uint32_t m_queuedTasks;               // Tasks which are queued but not yet claimed
+    Util::Mutex       m_countLock;                 // Serializes updates of m_outstandingTasks with m_idleEvent
+    uint32_t          m_outstandingTasks;          // Tasks which are queued or running
+    Util::ConditionVariable m_taskDone;            // Broadcast under m_countLock by CompleteTask()
+    Util::Event       m_wakeEvent;                 // Signaled when there is queued work or the pool is stopping
+    Util::Event       m_idleEvent;                 // Signaled while m_outstandingTasks is zero
+    volatile bool     m_stop;                      // Set when the pool is destroyed
+};
+
+} // namespace async
+
+} // namespace vk
+
+#endif /* __ASYNC_TASK_POOL_H__ */
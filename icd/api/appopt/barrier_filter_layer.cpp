@@ -35,6 +35,7 @@
 #include "include/vk_cmdbuffer.h"
 #include "include/vk_device.h"
 #include "include/vk_dispatch.h"
+#include "include/vk_image.h"
 
 namespace vk
 {
@@ -49,12 +50,288 @@ BarrierFilterLayer::~BarrierFilterLayer()
 {
 }
 
+// Access flags that denote writes which a barrier makes available.
+constexpr VkAccessFlags WriteAccessMask = VK_ACCESS_SHADER_WRITE_BIT                         |
+                                          VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT               |
+                                          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT       |
+                                          VK_ACCESS_TRANSFER_WRITE_BIT                       |
+                                          VK_ACCESS_HOST_WRITE_BIT                           |
+                                          VK_ACCESS_MEMORY_WRITE_BIT                         |
+                                          VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT         |
+                                          VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT |
+                                          VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR     |
+                                          VK_ACCESS_COMMAND_PREPROCESS_WRITE_BIT_NV;
+
+// =====================================================================================================================
+// Returns true if the first range fully contains the second one.  Both ranges must be resolved.
+static bool RangeContains(
+    const VkImageSubresourceRange& outer,
+    const VkImageSubresourceRange& inner)
+{
+    return ((outer.aspectMask & inner.aspectMask) == inner.aspectMask) &&
+           (outer.baseMipLevel <= inner.baseMipLevel) &&
+           ((outer.baseMipLevel + outer.levelCount) >= (inner.baseMipLevel + inner.levelCount)) &&
+           (outer.baseArrayLayer <= inner.baseArrayLayer) &&
+           ((outer.baseArrayLayer + outer.layerCount) >= (inner.baseArrayLayer + inner.layerCount));
+}
+
+// =====================================================================================================================
+// Returns true if the two ranges share at least one subresource.  Both ranges must be resolved.
+static bool RangesOverlap(
+    const VkImageSubresourceRange& a,
+    const VkImageSubresourceRange& b)
+{
+    return ((a.aspectMask & b.aspectMask) != 0) &&
+           (a.baseMipLevel < (b.baseMipLevel + b.levelCount)) &&
+           (b.baseMipLevel < (a.baseMipLevel + a.levelCount)) &&
+           (a.baseArrayLayer < (b.baseArrayLayer + b.layerCount)) &&
+           (b.baseArrayLayer < (a.baseArrayLayer + a.layerCount));
+}
+
+// =====================================================================================================================
+BarrierFilterCmdBufferState::BarrierFilterCmdBufferState()
+    :
+    m_rangeCount(0),
+    m_nextReplaced(0)
+{
+}
+
+// =====================================================================================================================
+// Forgets all tracked ranges.  Called whenever the command buffer is begun or reset since the layouts images are in
+// at that point are only known to the application.
+void BarrierFilterCmdBufferState::Reset()
+{
+    m_rangeCount   = 0;
+    m_nextReplaced = 0;
+}
+
+// =====================================================================================================================
+// Returns the subresource range of the barrier with VK_REMAINING_MIP_LEVELS and VK_REMAINING_ARRAY_LAYERS resolved.
+VkImageSubresourceRange BarrierFilterCmdBufferState::GetResolvedRange(
+    const VkImageMemoryBarrier& barrier)
+{
+    const Image* pImage = Image::ObjectFromHandle(barrier.image);
+
+    VkImageSubresourceRange range = barrier.subresourceRange;
+
+    if (range.levelCount == VK_REMAINING_MIP_LEVELS)
+    {
+        range.levelCount = pImage->GetMipLevels() - range.baseMipLevel;
+    }
+
+    if (range.layerCount == VK_REMAINING_ARRAY_LAYERS)
+    {
+        range.layerCount = pImage->GetArraySize() - range.baseArrayLayer;
+    }
+
+    return range;
+}
+
+// =====================================================================================================================
+// Merges range into *pMergedRange if the union of the two is itself a subresource range, i.e. they cover the same
+// aspects and either the same mips with touching layers or the same layers with touching mips.  Returns true on
+// success.
+bool BarrierFilterCmdBufferState::MergeRanges(
+    const VkImageSubresourceRange& range,
+    VkImageSubresourceRange*       pMergedRange)
+{
+    bool merged = false;
+
+    if (range.aspectMask == pMergedRange->aspectMask)
+    {
+        const uint32_t rangeMipEnd    = range.baseMipLevel + range.levelCount;
+        const uint32_t mergedMipEnd   = pMergedRange->baseMipLevel + pMergedRange->levelCount;
+        const uint32_t rangeLayerEnd  = range.baseArrayLayer + range.layerCount;
+        const uint32_t mergedLayerEnd = pMergedRange->baseArrayLayer + pMergedRange->layerCount;
+
+        if ((range.baseMipLevel == pMergedRange->baseMipLevel) && (range.levelCount == pMergedRange->levelCount) &&
+            (range.baseArrayLayer <= mergedLayerEnd) && (pMergedRange->baseArrayLayer <= rangeLayerEnd))
+        {
+            const uint32_t baseLayer = Util::Min(range.baseArrayLayer, pMergedRange->baseArrayLayer);
+
+            pMergedRange->layerCount     = Util::Max(rangeLayerEnd, mergedLayerEnd) - baseLayer;
+            pMergedRange->baseArrayLayer = baseLayer;
+
+            merged = true;
+        }
+        else if ((range.baseArrayLayer == pMergedRange->baseArrayLayer) &&
+                 (range.layerCount == pMergedRange->layerCount) &&
+                 (range.baseMipLevel <= mergedMipEnd) && (pMergedRange->baseMipLevel <= rangeMipEnd))
+        {
+            const uint32_t baseMip = Util::Min(range.baseMipLevel, pMergedRange->baseMipLevel);
+
+            pMergedRange->levelCount   = Util::Max(rangeMipEnd, mergedMipEnd) - baseMip;
+            pMergedRange->baseMipLevel = baseMip;
+
+            merged = true;
+        }
+    }
+
+    return merged;
+}
+
+// =====================================================================================================================
+// Returns the tracked range fully containing the given range of the image, or nullptr if there is none.
+const BarrierFilterCmdBufferState::TrackedRange* BarrierFilterCmdBufferState::FindContainingRange(
+    VkImage                        image,
+    const VkImageSubresourceRange& range) const
+{
+    const TrackedRange* pResult = nullptr;
+
+    for (uint32_t i = 0; (i < m_rangeCount) && (pResult == nullptr); ++i)
+    {
+        if ((m_ranges[i].image == image) && RangeContains(m_ranges[i].range, range))
+        {
+            pResult = &m_ranges[i];
+        }
+    }
+
+    return pResult;
+}
+
+// =====================================================================================================================
+// Returns true if the barrier has no effect given the tracked state: it keeps the layout the range is already known
+// to be in, makes no writes available and only makes accesses visible that previous barriers already covered.
+bool BarrierFilterCmdBufferState::IsRedundant(
+    const VkImageMemoryBarrier&    barrier,
+    const VkImageSubresourceRange& range) const
+{
+    bool redundant = false;
+
+    if ((barrier.pNext == nullptr) &&
+        (barrier.oldLayout == barrier.newLayout) &&
+        (barrier.srcQueueFamilyIndex == barrier.dstQueueFamilyIndex) &&
+        ((barrier.srcAccessMask & WriteAccessMask) == 0))
+    {
+        const TrackedRange* pTracked = FindContainingRange(barrier.image, range);
+
+        redundant = (pTracked != nullptr) &&
+                    (pTracked->layout == barrier.newLayout) &&
+                    ((barrier.dstAccessMask & ~pTracked->visibleAccess) == 0);
+    }
+
+    return redundant;
+}
+
+// =====================================================================================================================
+// Records the state a barrier that was not filtered leaves the given range of its image in.
+void BarrierFilterCmdBufferState::Update(
+    const VkImageMemoryBarrier&    barrier,
+    const VkImageSubresourceRange& range)
+{
+    VkAccessFlags visibleAccess = barrier.dstAccessMask;
+
+    // Without new writes the accesses previous barriers made visible in the same layout remain visible.
+    if ((barrier.oldLayout == barrier.newLayout) && ((barrier.srcAccessMask & WriteAccessMask) == 0))
+    {
+        const TrackedRange* pTracked = FindContainingRange(barrier.image, range);
+
+        if ((pTracked != nullptr) && (pTracked->layout == barrier.newLayout))
+        {
+            visibleAccess |= pTracked->visibleAccess;
+        }
+    }
+
+    // Forget everything known about subresources of the range.  Partially overlapping ranges are dropped as a whole
+    // rather than split, which only costs filtering opportunities.
+    for (uint32_t i = 0; i < m_rangeCount; )
+    {
+        if ((m_ranges[i].image == barrier.image) && RangesOverlap(m_ranges[i].range, range))
+        {
+            m_ranges[i] = m_ranges[--m_rangeCount];
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    // Extend a neighbouring range in the same state if possible, otherwise start tracking a new one.
+    bool merged = false;
+
+    for (uint32_t i = 0; (i < m_rangeCount) && (merged == false); ++i)
+    {
+        if ((m_ranges[i].image == barrier.image) &&
+            (m_ranges[i].layout == barrier.newLayout) &&
+            (m_ranges[i].visibleAccess == visibleAccess))
+        {
+            merged = MergeRanges(range, &m_ranges[i].range);
+        }
+    }
+
+    if (merged == false)
+    {
+        uint32_t slot = m_rangeCount;
+
+        if (m_rangeCount < MaxTrackedRanges)
+        {
+            m_rangeCount++;
+        }
+        else
+        {
+            slot           = m_nextReplaced;
+            m_nextReplaced = (m_nextReplaced + 1) % MaxTrackedRanges;
+        }
+
+        m_ranges[slot].image         = barrier.image;
+        m_ranges[slot].range         = range;
+        m_ranges[slot].layout        = barrier.newLayout;
+        m_ranges[slot].visibleAccess = visibleAccess;
+    }
+}
+
 namespace entry
 {
 
 namespace barrier_filter_layer
 {
 
+// =====================================================================================================================
+// Appends an image barrier to the filtered list unless the tracked state shows it to be redundant.  Barriers that only
+// differ in touching subresource ranges from one already in the list are merged into it.
+static void FilterTrackedImageBarrier(
+    BarrierFilterCmdBufferState* pTrackingState,
+    const VkImageMemoryBarrier&  barrier,
+    VkImageMemoryBarrier*        pImages,
+    uint32_t*                    pImageCount)
+{
+    const VkImageSubresourceRange range = BarrierFilterCmdBufferState::GetResolvedRange(barrier);
+
+    if (pTrackingState->IsRedundant(barrier, range) == false)
+    {
+        bool merged = false;
+
+        for (uint32_t i = 0; (i < *pImageCount) && (merged == false); ++i)
+        {
+            VkImageMemoryBarrier* pPrev = &pImages[i];
+
+            if ((pPrev->pNext == nullptr) &&
+                (barrier.pNext == nullptr) &&
+                (pPrev->image == barrier.image) &&
+                (pPrev->oldLayout == barrier.oldLayout) &&
+                (pPrev->newLayout == barrier.newLayout) &&
+                (pPrev->srcAccessMask == barrier.srcAccessMask) &&
+                (pPrev->dstAccessMask == barrier.dstAccessMask) &&
+                (pPrev->srcQueueFamilyIndex == barrier.srcQueueFamilyIndex) &&
+                (pPrev->dstQueueFamilyIndex == barrier.dstQueueFamilyIndex))
+            {
+                // Earlier entries in the list were already resolved when they were added.
+                merged = BarrierFilterCmdBufferState::MergeRanges(range, &pPrev->subresourceRange);
+            }
+        }
+
+        if (merged == false)
+        {
+            pImages[*pImageCount]                  = barrier;
+            pImages[*pImageCount].subresourceRange = range;
+
+            (*pImageCount)++;
+        }
+
+        pTrackingState->Update(barrier, range);
+    }
+}
+
 // =====================================================================================================================
 VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier(
     VkCommandBuffer                             cmdBuffer,
@@ -72,6 +349,8 @@ VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier(
     BarrierFilterLayer* pLayer        = pCmdBuffer->VkDevice()->GetBarrierFilterLayer();
     const uint32_t      filterOptions = pCmdBuffer->VkDevice()->GetRuntimeSettings().barrierFilterOptions;
 
+    BarrierFilterCmdBufferState* pTrackingState = pCmdBuffer->GetBarrierFilterState();
+
     {
         uint32_t memoryCount = memoryBarrierCount;
         uint32_t bufferCount = bufferMemoryBarrierCount;
@@ -144,7 +423,14 @@ VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier(
                          (pImageMemoryBarriers[i].srcAccessMask != pImageMemoryBarriers[i].dstAccessMask) ||
                          (pImageMemoryBarriers[i].srcQueueFamilyIndex != pImageMemoryBarriers[i].dstQueueFamilyIndex)))
                     {
-                        pImages[imageCount++] = pImageMemoryBarriers[i];
+                        if (pTrackingState == nullptr)
+                        {
+                            pImages[imageCount++] = pImageMemoryBarriers[i];
+                        }
+                        else
+                        {
+                            FilterTrackedImageBarrier(pTrackingState, pImageMemoryBarriers[i], pImages, &imageCount);
+                        }
                     }
                 }
             }
@@ -213,7 +499,8 @@ void BarrierFilterLayer::OverrideDispatchTable(
                                          SkipDuplicateResourceBarriers  |
                                          SkipWithAppProfile             |
                                          SkipWithAppProfileRegen        |
-                                         SkipWithIntDevOverlay))
+                                         SkipWithIntDevOverlay          |
+                                         SkipRedundantImageBarriers))
     {
         BARRIER_FILTER_LAYER_OVERRIDE_ENTRY(vkCmdPipelineBarrier);
     }
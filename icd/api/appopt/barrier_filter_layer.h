@@ -51,6 +51,55 @@ public:
 
 };
 
+// =====================================================================================================================
+// Per command buffer state of the barrier filter layer used by SkipRedundantImageBarriers.  Tracks the last known
+// layout of image subresource ranges and the accesses already made visible in it, so that image barriers that neither
+// change the layout nor make new writes available can be dropped.
+class BarrierFilterCmdBufferState
+{
+public:
+    BarrierFilterCmdBufferState();
+
+    void Reset();
+
+    bool IsRedundant(
+        const VkImageMemoryBarrier&    barrier,
+        const VkImageSubresourceRange& range) const;
+
+    void Update(
+        const VkImageMemoryBarrier&    barrier,
+        const VkImageSubresourceRange& range);
+
+    static VkImageSubresourceRange GetResolvedRange(
+        const VkImageMemoryBarrier&    barrier);
+
+    static bool MergeRanges(
+        const VkImageSubresourceRange& range,
+        VkImageSubresourceRange*       pMergedRange);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(BarrierFilterCmdBufferState);
+
+    struct TrackedRange
+    {
+        VkImage                 image;          // Image the range belongs to
+        VkImageSubresourceRange range;          // Resolved subresource range (no VK_REMAINING_* values)
+        VkImageLayout           layout;         // Last layout the range was transitioned to
+        VkAccessFlags           visibleAccess;  // Destination accesses the last writes were made visible to
+    };
+
+    const TrackedRange* FindContainingRange(
+        VkImage                        image,
+        const VkImageSubresourceRange& range) const;
+
+    // The tracked set is small and searched linearly; when it is full the oldest slots are recycled.
+    enum : uint32_t { MaxTrackedRanges = 64 };
+
+    TrackedRange m_ranges[MaxTrackedRanges];
+    uint32_t     m_rangeCount;
+    uint32_t     m_nextReplaced;
+};
+
 } // namespace vk
 
 #endif /* __BARRIER_FILTER_LAYER_H__ */
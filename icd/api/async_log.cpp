@@ -0,0 +1,385 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  async_log.cpp
+* @brief Implementation of the driver log which formats messages on a background thread.
+***********************************************************************************************************************
+*/
+
+#include "include/async_log.h"
+#include "include/log.h"
+#include "include/vk_instance.h"
+
+#include "palInlineFuncs.h"
+
+#include <string.h>
+
+namespace vk
+{
+
+std::atomic<AsyncLog*> AsyncLog::s_pActive(nullptr);
+
+// How often the log thread wakes up to format the recorded messages, in seconds
+static constexpr float DrainInterval = 0.01f;
+
+// =====================================================================================================================
+AsyncLog::AsyncLog(
+    Instance* pInstance)
+    :
+    m_pInstance(pInstance),
+    m_enabled(false),
+    m_startTicks(0),
+    m_perfFrequency(1),
+    m_stop(false),
+    m_rings(pInstance->GetAllocCallbacks(), VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE),
+    m_ringCount(0)
+{
+}
+
+// =====================================================================================================================
+// Opens the log file and starts the log thread.  AmdvlkLog() messages of the whole process are recorded into the first
+// log started; further logs stay disabled until it is destroyed.
+VkResult AsyncLog::Init(
+    const char* pFilePath)
+{
+    Util::EventCreateFlags flags = {};
+    flags.manualReset       = false;
+    flags.initiallySignaled = false;
+
+    VkResult result = PalToVkResult(m_file.Open(pFilePath, Util::FileAccessAppend));
+
+    if (result == VK_SUCCESS)
+    {
+        m_startTicks    = Util::GetPerfCpuTime();
+        m_perfFrequency = Util::GetPerfFrequency();
+
+        m_file.Printf("# %s, start %llu ms\n",
+                      m_pInstance->GetApplicationName(),
+                      static_cast<uint64_t>((m_startTicks * 1000) / m_perfFrequency));
+
+        result = PalToVkResult(m_wakeEvent.Init(flags));
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        result = PalToVkResult(m_thread.Begin(LogThreadFunc, this));
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        m_enabled = true;
+
+        AsyncLog* pExpected = nullptr;
+
+        if (s_pActive.compare_exchange_strong(pExpected, this, std::memory_order_acq_rel) == false)
+        {
+            Destroy();
+        }
+    }
+    else if (m_file.IsOpen())
+    {
+        m_file.Close();
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Stops the log thread, writes the messages still in the rings and closes the file.  No thread may log anymore.
+void AsyncLog::Destroy()
+{
+    if (m_enabled)
+    {
+        AsyncLog* pExpected = this;
+
+        s_pActive.compare_exchange_strong(pExpected, nullptr, std::memory_order_acq_rel);
+
+        m_stop = true;
+        m_wakeEvent.Set();
+        m_thread.Join();
+
+        Drain();
+
+        m_enabled = false;
+
+        m_rings.Reset();
+
+        m_ringCount = 0;
+
+        m_file.Close();
+    }
+}
+
+// =====================================================================================================================
+// Copies a string argument into a record, truncating it to the space left.  The record keeps the terminating zero of
+// its last copied string at the end of the space, so an argument that doesn't fit at all prints as an empty string.
+void AsyncLog::EncodeArg(
+    LogRecord*  pRecord,
+    const char* pString)
+{
+    LogArg* pArg = &pRecord->args[pRecord->argCount++];
+
+    const uint32_t offset = pRecord->stringSize;
+
+    pArg->type = ArgType::String;
+    pArg->u    = (offset < StringDataSize) ? offset : (StringDataSize - 1);
+
+    if (offset < StringDataSize)
+    {
+        if (pString == nullptr)
+        {
+            pString = "(null)";
+        }
+
+        const size_t length = strnlen(pString, StringDataSize - offset - 1);
+
+        memcpy(&pRecord->strings[offset], pString, length);
+        pRecord->strings[offset + length] = '\0';
+
+        pRecord->stringSize = offset + static_cast<uint32_t>(length) + 1;
+    }
+}
+
+// =====================================================================================================================
+// Copies a pointer argument into a record
+void AsyncLog::EncodeArg(
+    LogRecord*  pRecord,
+    const void* pValue)
+{
+    LogArg* pArg = &pRecord->args[pRecord->argCount++];
+
+    pArg->type = ArgType::Pointer;
+    pArg->p    = pValue;
+}
+
+// =====================================================================================================================
+// Copies a floating point argument into a record
+void AsyncLog::EncodeArg(
+    LogRecord* pRecord,
+    double     value)
+{
+    LogArg* pArg = &pRecord->args[pRecord->argCount++];
+
+    pArg->type = ArgType::Float;
+    pArg->f    = value;
+}
+
+// =====================================================================================================================
+// Log thread: formats the recorded messages periodically until the log is destroyed.
+void AsyncLog::LogThreadFunc(
+    void* pParam)
+{
+    AsyncLog* pLog = static_cast<AsyncLog*>(pParam);
+
+    while (pLog->m_stop == false)
+    {
+        pLog->m_wakeEvent.Wait(DrainInterval);
+        pLog->Drain();
+    }
+}
+
+// =====================================================================================================================
+// Formats and writes the messages of all rings.  Called by the log thread, or once it has exited.
+void AsyncLog::Drain()
+{
+    bool wrote = false;
+
+    m_rings.ForEach([this, &wrote](ThreadRing* pRing)
+    {
+        const uint32_t head    = pRing->head.load(std::memory_order_acquire);
+        const uint32_t dropped = pRing->dropped.load(std::memory_order_relaxed);
+
+        uint32_t tail = pRing->tail.load(std::memory_order_relaxed);
+
+        if (dropped != pRing->reportedDrops)
+        {
+            m_file.Printf("t%u: %u messages dropped, the ring was full\n",
+                          pRing->threadIndex,
+                          dropped - pRing->reportedDrops);
+
+            pRing->reportedDrops = dropped;
+            wrote                = true;
+        }
+
+        for (; tail != head; ++tail)
+        {
+            FormatRecord(*pRing, pRing->records[tail & (RingSize - 1)]);
+            wrote = true;
+        }
+
+        pRing->tail.store(tail, std::memory_order_release);
+    });
+
+    if (wrote)
+    {
+        m_file.Flush();
+    }
+}
+
+// =====================================================================================================================
+// Formats a message and appends it to the file as a line with its time in microseconds, thread and tag.
+//
+// Conversions are formatted one at a time with the argument recorded for them.  Integers are recorded at 64 bits, so
+// length modifiers in the format are replaced by "ll"; '*' widths and precisions are not supported.
+void AsyncLog::FormatRecord(
+    const ThreadRing& ring,
+    const LogRecord&  record)
+{
+    constexpr size_t MaxMessageSize = 512;
+    constexpr size_t MaxSpecSize    = 32;
+
+    char     message[MaxMessageSize];
+    size_t   length   = 0;
+    uint32_t argIndex = 0;
+
+    const char* pCur = record.pFormat;
+
+    while ((*pCur != '\0') && (length < (MaxMessageSize - 1)))
+    {
+        if (*pCur != '%')
+        {
+            message[length++] = *pCur++;
+        }
+        else if (pCur[1] == '%')
+        {
+            message[length++] = '%';
+            pCur += 2;
+        }
+        else
+        {
+            // Copy the flags, width and precision of the conversion specification
+            char   spec[MaxSpecSize];
+            size_t specLength = 0;
+
+            spec[specLength++] = *pCur++;
+
+            while ((*pCur != '\0') && (strchr("-+ #0123456789.", *pCur) != nullptr) &&
+                   (specLength < (MaxSpecSize - 4)))
+            {
+                spec[specLength++] = *pCur++;
+            }
+
+            // Skip the length modifier
+            while ((*pCur != '\0') && (strchr("hljztL", *pCur) != nullptr))
+            {
+                pCur++;
+            }
+
+            const char conversion = *pCur;
+
+            if (conversion != '\0')
+            {
+                pCur++;
+            }
+
+            const LogArg* pArg = (argIndex < record.argCount) ? &record.args[argIndex++] : nullptr;
+
+            char*        pOut    = &message[length];
+            const size_t room    = MaxMessageSize - length;
+            int32_t      written = 0;
+
+            if (pArg != nullptr)
+            {
+                switch (conversion)
+                {
+                case 'd':
+                case 'i':
+                case 'u':
+                case 'x':
+                case 'X':
+                case 'o':
+                    spec[specLength++] = 'l';
+                    spec[specLength++] = 'l';
+                    spec[specLength++] = conversion;
+                    spec[specLength]   = '\0';
+
+                    written = ((conversion == 'd') || (conversion == 'i')) ?
+                              Util::Snprintf(pOut, room, spec, static_cast<long long>(pArg->s)) :
+                              Util::Snprintf(pOut, room, spec, static_cast<unsigned long long>(pArg->u));
+                    break;
+                case 'c':
+                    spec[specLength++] = conversion;
+                    spec[specLength]   = '\0';
+
+                    written = Util::Snprintf(pOut, room, spec, static_cast<int32_t>(pArg->s));
+                    break;
+                case 'f':
+                case 'F':
+                case 'e':
+                case 'E':
+                case 'g':
+                case 'G':
+                case 'a':
+                case 'A':
+                    spec[specLength++] = conversion;
+                    spec[specLength]   = '\0';
+
+                    written = Util::Snprintf(pOut, room, spec, (pArg->type == ArgType::Float) ?
+                                                               pArg->f : static_cast<double>(pArg->s));
+                    break;
+                case 's':
+                    spec[specLength++] = conversion;
+                    spec[specLength]   = '\0';
+
+                    written = Util::Snprintf(pOut, room, spec, (pArg->type == ArgType::String) ?
+                                                               &record.strings[pArg->u] : "(?)");
+                    break;
+                case 'p':
+                    spec[specLength++] = conversion;
+                    spec[specLength]   = '\0';
+
+                    written = Util::Snprintf(pOut, room, spec, pArg->p);
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            if (written > 0)
+            {
+                length = Util::Min(length + static_cast<size_t>(written), MaxMessageSize - 1);
+            }
+        }
+    }
+
+    // Messages are written one per line, whether or not their format ends with a newline
+    if ((length > 0) && (message[length - 1] == '\n'))
+    {
+        length--;
+    }
+
+    message[length] = '\0';
+
+    const uint64_t timeUs = static_cast<uint64_t>(((record.timestamp - m_startTicks) * 1000000) / m_perfFrequency);
+
+    m_file.Printf("%llu t%u %s-%s\n",
+                  timeUs,
+                  ring.threadIndex,
+                  (record.tagId < LogTagIdCount) ? LogTag[record.tagId] : "Unknown",
+                  message);
+}
+
+} // namespace vk
@@ -290,8 +290,9 @@ static VK_INLINE uint32_t ImageLayoutToCacheMask(VkImageLayout imageLayout)
 }
 
 // =====================================================================================================================
-// Converts source access flags to source cache coherency flags.
-static VK_INLINE uint32_t SrcAccessToCacheMask(AccessFlags accessMask, VkImageLayout imageLayout)
+// Converts source access flags to source cache coherency flags, excluding the layout dependent part of
+// VK_ACCESS_MEMORY_WRITE_BIT. Only used to build the access mask lookup tables.
+static uint32_t SrcAccessBitsToCacheMask(AccessFlags accessMask)
 {
     uint32_t cacheMask = 0;
 
@@ -327,7 +328,7 @@ static VK_INLINE uint32_t SrcAccessToCacheMask(AccessFlags accessMask, VkImageLa
 
     if (accessMask & VK_ACCESS_MEMORY_WRITE_BIT)
     {
-        cacheMask |= Pal::CoherMemory | ImageLayoutToCacheMask(imageLayout);
+        cacheMask |= Pal::CoherMemory;
     }
 
     if (accessMask & VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT)
@@ -354,8 +355,9 @@ static VK_INLINE uint32_t SrcAccessToCacheMask(AccessFlags accessMask, VkImageLa
 }
 
 // =====================================================================================================================
-// Converts destination access flags to destination cache coherency flags.
-static VK_INLINE uint32_t DstAccessToCacheMask(AccessFlags accessMask, VkImageLayout imageLayout)
+// Converts destination access flags to destination cache coherency flags, excluding the layout dependent part of
+// VK_ACCESS_MEMORY_READ_BIT. Only used to build the access mask lookup tables.
+static uint32_t DstAccessBitsToCacheMask(AccessFlags accessMask)
 {
     uint32_t cacheMask = 0;
 
@@ -403,7 +405,7 @@ static VK_INLINE uint32_t DstAccessToCacheMask(AccessFlags accessMask, VkImageLa
 
     if (accessMask & VK_ACCESS_MEMORY_READ_BIT)
     {
-        cacheMask |= Pal::CoherMemory | ImageLayoutToCacheMask(imageLayout);
+        cacheMask |= Pal::CoherMemory;
     }
 
     if (accessMask & VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_READ_BIT_EXT)
@@ -424,6 +426,79 @@ static VK_INLINE uint32_t DstAccessToCacheMask(AccessFlags accessMask, VkImageLa
     return cacheMask;
 }
 
+// =====================================================================================================================
+// Helper class to convert Vulkan access flags to PAL cache coherency flags.
+// The access mask is split into bytes and each byte indexes a table holding the union of the cache masks of the access
+// bits it contains, so translating an access mask takes one lookup per byte instead of testing every access bit.
+class AccessCacheMaskHelper
+{
+public:
+    // Constructor initializes the lookup tables.
+    AccessCacheMaskHelper()
+    {
+        for (uint32_t byteIndex = 0; byteIndex < AccessTableByteCount; ++byteIndex)
+        {
+            for (uint32_t byteValue = 0; byteValue < AccessTableEntryCount; ++byteValue)
+            {
+                const AccessFlags accessMask = static_cast<AccessFlags>(byteValue) << (byteIndex * 8);
+
+                m_srcCacheMaskTable[byteIndex][byteValue] = SrcAccessBitsToCacheMask(accessMask);
+                m_dstCacheMaskTable[byteIndex][byteValue] = DstAccessBitsToCacheMask(accessMask);
+            }
+        }
+    }
+
+    // Return the source cache mask corresponding to the specified access mask and image layout.
+    VK_FORCEINLINE uint32_t GetSrcCacheMask(AccessFlags accessMask, VkImageLayout imageLayout) const
+    {
+        uint32_t cacheMask = Lookup(m_srcCacheMaskTable, accessMask);
+
+        if (accessMask & VK_ACCESS_MEMORY_WRITE_BIT)
+        {
+            cacheMask |= ImageLayoutToCacheMask(imageLayout);
+        }
+
+        return cacheMask;
+    }
+
+    // Return the destination cache mask corresponding to the specified access mask and image layout.
+    VK_FORCEINLINE uint32_t GetDstCacheMask(AccessFlags accessMask, VkImageLayout imageLayout) const
+    {
+        uint32_t cacheMask = Lookup(m_dstCacheMaskTable, accessMask);
+
+        if (accessMask & VK_ACCESS_MEMORY_READ_BIT)
+        {
+            cacheMask |= ImageLayoutToCacheMask(imageLayout);
+        }
+
+        return cacheMask;
+    }
+
+protected:
+    // Access bits above the ones covered by the tables don't map to any cache coherency flags.
+    enum
+    {
+        AccessTableByteCount  = 5,
+        AccessTableEntryCount = 256
+    };
+
+    typedef uint32_t AccessTable[AccessTableByteCount][AccessTableEntryCount];
+
+    static VK_FORCEINLINE uint32_t Lookup(const AccessTable& table, AccessFlags accessMask)
+    {
+        return table[0][(accessMask >>  0) & 0xFF] |
+               table[1][(accessMask >>  8) & 0xFF] |
+               table[2][(accessMask >> 16) & 0xFF] |
+               table[3][(accessMask >> 24) & 0xFF] |
+               table[4][(accessMask >> 32) & 0xFF];
+    }
+
+    AccessTable m_srcCacheMaskTable;
+    AccessTable m_dstCacheMaskTable;
+};
+
+static const AccessCacheMaskHelper g_AccessCacheMaskHelper;
+
 // =====================================================================================================================
 // Initializes the cache policy of the barrier policy.
 void BarrierPolicy::InitCachePolicy(
@@ -521,8 +596,8 @@ void BarrierPolicy::ApplyBarrierCacheFlags(
     Pal::BarrierTransition*             pResult) const
 {
     // Convert access masks to cache coherency masks and exclude any coherency flags that are not supported.
-    uint32_t srcCacheMask = SrcAccessToCacheMask(srcAccess, srcLayout) & m_supportedOutputCacheMask;
-    uint32_t dstCacheMask = DstAccessToCacheMask(dstAccess, dstLayout) & m_supportedInputCacheMask;
+    uint32_t srcCacheMask = g_AccessCacheMaskHelper.GetSrcCacheMask(srcAccess, srcLayout) & m_supportedOutputCacheMask;
+    uint32_t dstCacheMask = g_AccessCacheMaskHelper.GetDstCacheMask(dstAccess, dstLayout) & m_supportedInputCacheMask;
 
     // Calculate the union of both masks that are used for handling the domains that are always kept coherent and the
     // domains that are avoided to be kept coherent unless explicitly requested.
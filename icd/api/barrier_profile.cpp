@@ -0,0 +1,433 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  barrier_profile.cpp
+* @brief Implementation of the barrier cost profile.
+***********************************************************************************************************************
+*/
+#include "include/barrier_profile.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+#include "sqtt/sqtt_rgp_annotations.h"
+
+#include "palCmdBuffer.h"
+#include "palInlineFuncs.h"
+#include "palJsonWriter.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace vk
+{
+
+// =====================================================================================================================
+// Names where a barrier reason comes from, following the value ranges of RgpBarrierReason.  The values the driver
+// doesn't define are PAL's own, used around its internal blits, clears and resolves.
+static const char* GetBarrierSource(
+    uint32_t reason)
+{
+    const char* pSource = "pal";
+
+    if (reason == RgpBarrierExternalCmdPipelineBarrier)
+    {
+        pSource = "pipelineBarrier";
+    }
+    else if (reason == RgpBarrierExternalRenderPassSync)
+    {
+        pSource = "renderPass";
+    }
+    else if (reason == RgpBarrierExternalCmdWaitEvents)
+    {
+        pSource = "waitEvents";
+    }
+    else if (reason == RgpBarrierUnknownReason)
+    {
+        pSource = "unknown";
+    }
+    else if (reason >= RgpBarrierInternalBase)
+    {
+        pSource = "driverInternal";
+    }
+
+    return pSource;
+}
+
+// =====================================================================================================================
+static void WriteOperationNames(
+    Util::JsonWriter* pWriter,
+    uint16_t          pipelineStalls,
+    uint16_t          caches)
+{
+    Pal::Developer::BarrierOperations operations = {};
+
+    operations.pipelineStalls.u16All = pipelineStalls;
+    operations.caches.u16All         = caches;
+
+    const struct
+    {
+        uint32_t    set;
+        const char* pName;
+    } stallNames[] =
+    {
+        { operations.pipelineStalls.eopTsBottomOfPipe, "eopTsBottomOfPipe" },
+        { operations.pipelineStalls.vsPartialFlush,    "vsPartialFlush" },
+        { operations.pipelineStalls.psPartialFlush,    "psPartialFlush" },
+        { operations.pipelineStalls.csPartialFlush,    "csPartialFlush" },
+        { operations.pipelineStalls.pfpSyncMe,         "pfpSyncMe" },
+        { operations.pipelineStalls.syncCpDma,         "syncCpDma" },
+    };
+
+    const struct
+    {
+        uint32_t    set;
+        const char* pName;
+    } cacheNames[] =
+    {
+        { operations.caches.invalTcp,  "invalTcp" },
+        { operations.caches.invalSqI$, "invalSqI" },
+        { operations.caches.invalSqK$, "invalSqK" },
+        { operations.caches.flushTcc,  "flushTcc" },
+        { operations.caches.invalTcc,  "invalTcc" },
+        { operations.caches.flushCb,   "flushCb" },
+        { operations.caches.invalCb,   "invalCb" },
+        { operations.caches.flushDb,   "flushDb" },
+        { operations.caches.invalDb,   "invalDb" },
+        { operations.caches.invalGl1,  "invalGl1" },
+    };
+
+    pWriter->KeyAndBeginList("stalls", true);
+
+    for (uint32_t i = 0; i < VK_ARRAY_SIZE(stallNames); ++i)
+    {
+        if (stallNames[i].set != 0)
+        {
+            pWriter->Value(stallNames[i].pName);
+        }
+    }
+
+    pWriter->EndList();
+
+    pWriter->KeyAndBeginList("caches", true);
+
+    for (uint32_t i = 0; i < VK_ARRAY_SIZE(cacheNames); ++i)
+    {
+        if (cacheNames[i].set != 0)
+        {
+            pWriter->Value(cacheNames[i].pName);
+        }
+    }
+
+    pWriter->EndList();
+}
+
+// =====================================================================================================================
+BarrierProfile* BarrierProfile::Create(
+    Device* pDevice)
+{
+    BarrierProfile* pProfile = nullptr;
+    void*           pMem     = pDevice->VkInstance()->AllocMem(sizeof(BarrierProfile),
+                                                               VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+    if (pMem != nullptr)
+    {
+        pProfile = VK_PLACEMENT_NEW(pMem) BarrierProfile(pDevice);
+    }
+
+    return pProfile;
+}
+
+// =====================================================================================================================
+BarrierProfile::BarrierProfile(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_entryCount(0),
+    m_droppedCount(0)
+{
+}
+
+// =====================================================================================================================
+void BarrierProfile::Destroy()
+{
+    Instance* pInstance = m_pDevice->VkInstance();
+
+    Util::Destructor(this);
+
+    pInstance->FreeMem(this);
+}
+
+// =====================================================================================================================
+// Adds the barriers of one command buffer recording, plus the number of its barriers which couldn't be measured.
+void BarrierProfile::RecordSamples(
+    const BarrierProfileSample* pSamples,
+    uint32_t                    sampleCount,
+    uint32_t                    droppedCount)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    m_droppedCount += droppedCount;
+
+    for (uint32_t i = 0; i < sampleCount; ++i)
+    {
+        const BarrierProfileSample& sample = pSamples[i];
+
+        Entry* pEntry = nullptr;
+
+        for (uint32_t entry = 0; (entry < m_entryCount) && (pEntry == nullptr); ++entry)
+        {
+            if (m_entries[entry].reason == sample.reason)
+            {
+                pEntry = &m_entries[entry];
+            }
+        }
+
+        if ((pEntry == nullptr) && (m_entryCount < MaxEntries))
+        {
+            pEntry = &m_entries[m_entryCount++];
+
+            memset(pEntry, 0, sizeof(*pEntry));
+            pEntry->reason = sample.reason;
+        }
+
+        if (pEntry != nullptr)
+        {
+            pEntry->pipelineStalls    |= sample.pipelineStalls;
+            pEntry->caches            |= sample.caches;
+            pEntry->count++;
+            pEntry->stallingCount     += (sample.pipelineStalls != 0) ? 1 : 0;
+            pEntry->layoutTransitions += sample.layoutTransitions;
+            pEntry->totalNs           += sample.stallNs;
+            pEntry->maxNs              = Util::Max(pEntry->maxNs, sample.stallNs);
+        }
+        else
+        {
+            m_droppedCount++;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Writes the call sites, most expensive first.
+void BarrierProfile::Write(
+    Util::JsonWriter* pWriter) const
+{
+    Util::MutexAuto lock(&m_lock);
+
+    uint32_t sorted[MaxEntries];
+
+    for (uint32_t i = 0; i < m_entryCount; ++i)
+    {
+        sorted[i] = i;
+    }
+
+    std::sort(sorted, sorted + m_entryCount,
+              [this](uint32_t a, uint32_t b) { return m_entries[a].totalNs > m_entries[b].totalNs; });
+
+    pWriter->KeyAndBeginList("barriers", false);
+
+    for (uint32_t i = 0; i < m_entryCount; ++i)
+    {
+        const Entry& entry = m_entries[sorted[i]];
+
+        char reasonString[11];
+        Util::Snprintf(reasonString, sizeof(reasonString), "0x%08X", entry.reason);
+
+        pWriter->BeginMap(false);
+        pWriter->KeyAndValue("reason", reasonString);
+        pWriter->KeyAndValue("source", GetBarrierSource(entry.reason));
+        pWriter->KeyAndValue("count", entry.count);
+        pWriter->KeyAndValue("stallingCount", entry.stallingCount);
+        pWriter->KeyAndValue("layoutTransitions", entry.layoutTransitions);
+        pWriter->KeyAndValue("totalUs", entry.totalNs / 1000);
+        pWriter->KeyAndValue("avgNs", entry.totalNs / entry.count);
+        pWriter->KeyAndValue("maxNs", entry.maxNs);
+        WriteOperationNames(pWriter, entry.pipelineStalls, entry.caches);
+        pWriter->EndMap();
+    }
+
+    pWriter->EndList();
+
+    pWriter->KeyAndValue("droppedBarriers", m_droppedCount);
+}
+
+// =====================================================================================================================
+BarrierProfileCmdBufferState::BarrierProfileCmdBufferState(
+    Device*         pDevice,
+    BarrierProfile* pProfile)
+    :
+    m_pDevice(pDevice),
+    m_pProfile(pProfile),
+    m_barrierCount(0),
+    m_openBarrier(InvalidSlot),
+    m_droppedCount(0)
+{
+}
+
+// =====================================================================================================================
+// Allocates the timestamp memory.  Only the default device's command buffer is measured.
+VkResult BarrierProfileCmdBufferState::Init()
+{
+    InternalMemCreateInfo allocInfo = {};
+
+    allocInfo.pal.size      = 2 * MaxBarriers * sizeof(uint64_t);
+    allocInfo.pal.alignment = sizeof(uint64_t);
+    allocInfo.pal.priority  = Pal::GpuMemPriority::Normal;
+
+    m_pDevice->MemMgr()->GetCommonPool(InternalPoolCpuCacheableGpuUncached, &allocInfo);
+
+    return m_pDevice->MemMgr()->AllocGpuMem(allocInfo, &m_timestampMem, 1 << DefaultDeviceIndex);
+}
+
+// =====================================================================================================================
+void BarrierProfileCmdBufferState::Destroy()
+{
+    Resolve();
+
+    if (m_timestampMem.Size() > 0)
+    {
+        m_pDevice->MemMgr()->FreeGpuMem(&m_timestampMem);
+    }
+}
+
+// =====================================================================================================================
+// Starts a new recording.  Whatever the previous one measured is collected first, then all slots are marked unwritten.
+void BarrierProfileCmdBufferState::Begin()
+{
+    Resolve();
+
+    memset(m_timestampMem.CpuAddr(DefaultDeviceIndex), 0xFF, 2 * MaxBarriers * sizeof(uint64_t));
+}
+
+// =====================================================================================================================
+// Called for every PAL barrier callback of the command buffer while it is being recorded.
+void BarrierProfileCmdBufferState::PalBarrierCallback(
+    Pal::ICmdBuffer*                   pPalCmdBuffer,
+    Pal::Developer::CallbackType       type,
+    const Pal::Developer::BarrierData& barrier)
+{
+    if (type == Pal::Developer::CallbackType::BarrierBegin)
+    {
+        VK_ASSERT(m_openBarrier == InvalidSlot);
+
+        if (m_barrierCount < MaxBarriers)
+        {
+            m_openBarrier = m_barrierCount++;
+
+            Barrier* pBarrier = &m_barriers[m_openBarrier];
+
+            pBarrier->reason            = barrier.reason;
+            pBarrier->pipelineStalls    = 0;
+            pBarrier->caches            = 0;
+            pBarrier->layoutTransitions = 0;
+            pBarrier->ended             = false;
+
+            WriteTimestamp(pPalCmdBuffer, 2 * m_openBarrier);
+        }
+        else
+        {
+            m_droppedCount++;
+        }
+    }
+
+    if (m_openBarrier != InvalidSlot)
+    {
+        Barrier* pBarrier = &m_barriers[m_openBarrier];
+
+        // As for the RGP markers, the operations of the whole barrier are the union of all its callbacks, since
+        // layout transitions may report cache operations of their own.
+        pBarrier->pipelineStalls |= barrier.operations.pipelineStalls.u16All;
+        pBarrier->caches         |= barrier.operations.caches.u16All;
+
+        if (type == Pal::Developer::CallbackType::ImageBarrier)
+        {
+            pBarrier->layoutTransitions++;
+        }
+        else if (type == Pal::Developer::CallbackType::BarrierEnd)
+        {
+            WriteTimestamp(pPalCmdBuffer, (2 * m_openBarrier) + 1);
+
+            pBarrier->ended = true;
+            m_openBarrier   = InvalidSlot;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Hands the measured barriers of the last recording to the profile.  Only called when the command buffer isn't
+// pending, so the GPU has written all the timestamps it is ever going to write.
+void BarrierProfileCmdBufferState::Resolve()
+{
+    if (m_barrierCount > 0)
+    {
+        const uint64_t* pTimestamps = static_cast<const uint64_t*>(m_timestampMem.CpuAddr(DefaultDeviceIndex));
+        const uint64_t  frequency   = m_pDevice->TimestampFrequency();
+
+        BarrierProfileSample samples[MaxBarriers];
+        uint32_t             sampleCount = 0;
+
+        for (uint32_t i = 0; i < m_barrierCount; ++i)
+        {
+            const Barrier& barrier    = m_barriers[i];
+            const uint64_t beginTicks = pTimestamps[2 * i];
+            const uint64_t endTicks   = pTimestamps[(2 * i) + 1];
+
+            if (barrier.ended && (beginTicks != TimestampNotDone) && (endTicks != TimestampNotDone) &&
+                (endTicks >= beginTicks))
+            {
+                BarrierProfileSample* pSample = &samples[sampleCount++];
+
+                pSample->reason            = barrier.reason;
+                pSample->pipelineStalls    = barrier.pipelineStalls;
+                pSample->caches            = barrier.caches;
+                pSample->layoutTransitions = barrier.layoutTransitions;
+                pSample->stallNs           = ((endTicks - beginTicks) * 1000000000) / frequency;
+            }
+            else
+            {
+                m_droppedCount++;
+            }
+        }
+
+        m_pProfile->RecordSamples(samples, sampleCount, m_droppedCount);
+
+        m_barrierCount = 0;
+        m_droppedCount = 0;
+    }
+
+    m_openBarrier = InvalidSlot;
+}
+
+// =====================================================================================================================
+void BarrierProfileCmdBufferState::WriteTimestamp(
+    Pal::ICmdBuffer* pPalCmdBuffer,
+    uint32_t         slot)
+{
+    pPalCmdBuffer->CmdWriteTimestamp(Pal::HwPipeTop,
+                                     *m_timestampMem.PalMemory(DefaultDeviceIndex),
+                                     m_timestampMem.Offset() + (slot * sizeof(uint64_t)));
+}
+
+} // namespace vk
@@ -66,6 +66,396 @@
 namespace vk
 {
 
+namespace
+{
+
+// LZ4 block format constants.  See https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md.
+constexpr size_t   Lz4MinMatch         = 4;      // Shortest match that can be encoded
+constexpr size_t   Lz4LastLiterals     = 5;      // The last bytes of a block are always literals
+constexpr size_t   Lz4MatchStartLimit  = 12;     // The last match must start at least this many bytes before the end
+constexpr size_t   Lz4MaxOffset        = 65535;  // Largest encodable match distance
+constexpr uint32_t Lz4HashLog          = 12;     // Log2 of the number of entries in the match finder hash table
+constexpr uint8_t  Lz4RunMask          = 15;     // Token nibble value meaning that more length bytes follow
+
+// =====================================================================================================================
+uint32_t Lz4Read32(
+    const uint8_t* pSrc)
+{
+    uint32_t value;
+    memcpy(&value, pSrc, sizeof(value));
+    return value;
+}
+
+// =====================================================================================================================
+uint32_t Lz4Hash(
+    uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - Lz4HashLog);
+}
+
+// =====================================================================================================================
+// Writes the extra length bytes of a literal or match length which didn't fit in its token nibble.
+bool Lz4WriteLength(
+    size_t          length,
+    uint8_t**       ppDst,
+    const uint8_t*  pDstEnd)
+{
+    bool fits = true;
+
+    while (fits && (length >= 255))
+    {
+        fits = (*ppDst < pDstEnd);
+
+        if (fits)
+        {
+            *(*ppDst)++ = 255;
+            length     -= 255;
+        }
+    }
+
+    if (fits)
+    {
+        fits = (*ppDst < pDstEnd);
+
+        if (fits)
+        {
+            *(*ppDst)++ = static_cast<uint8_t>(length);
+        }
+    }
+
+    return fits;
+}
+
+// =====================================================================================================================
+// Writes one sequence: the pending literals followed by a match.  The last sequence of a block has no match, which is
+// indicated by a matchLength of 0.
+bool Lz4WriteSequence(
+    const uint8_t*  pLiterals,
+    size_t          literalLength,
+    size_t          offset,
+    size_t          matchLength,
+    uint8_t**       ppDst,
+    const uint8_t*  pDstEnd)
+{
+    bool fits = (*ppDst < pDstEnd);
+
+    if (fits)
+    {
+        uint8_t* pToken = (*ppDst)++;
+        uint8_t  token  = static_cast<uint8_t>(Util::Min<size_t>(literalLength, Lz4RunMask) << 4);
+
+        if (literalLength >= Lz4RunMask)
+        {
+            fits = Lz4WriteLength(literalLength - Lz4RunMask, ppDst, pDstEnd);
+        }
+
+        if (fits)
+        {
+            fits = (static_cast<size_t>(pDstEnd - *ppDst) >= literalLength);
+        }
+
+        if (fits)
+        {
+            memcpy(*ppDst, pLiterals, literalLength);
+            *ppDst += literalLength;
+        }
+
+        if (fits && (matchLength > 0))
+        {
+            fits = (static_cast<size_t>(pDstEnd - *ppDst) >= sizeof(uint16_t));
+
+            if (fits)
+            {
+                (*ppDst)[0] = static_cast<uint8_t>(offset & 0xFF);
+                (*ppDst)[1] = static_cast<uint8_t>(offset >> 8);
+                *ppDst     += sizeof(uint16_t);
+
+                const size_t matchCode = matchLength - Lz4MinMatch;
+
+                token |= static_cast<uint8_t>(Util::Min<size_t>(matchCode, Lz4RunMask));
+
+                if (matchCode >= Lz4RunMask)
+                {
+                    fits = Lz4WriteLength(matchCode - Lz4RunMask, ppDst, pDstEnd);
+                }
+            }
+        }
+
+        *pToken = token;
+    }
+
+    return fits;
+}
+
+// =====================================================================================================================
+// Reads the extra length bytes of a literal or match length.
+bool Lz4ReadLength(
+    const uint8_t** ppSrc,
+    const uint8_t*  pSrcEnd,
+    size_t*         pLength)
+{
+    bool    valid = true;
+    uint8_t value = 255;
+
+    while (valid && (value == 255))
+    {
+        valid = (*ppSrc < pSrcEnd);
+
+        if (valid)
+        {
+            value     = *(*ppSrc)++;
+            *pLength += value;
+        }
+    }
+
+    return valid;
+}
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Compresses srcSize bytes into the LZ4 block format using a fast greedy match finder.  Returns the compressed size, or
+// 0 if the result doesn't fit in dstCapacity bytes.
+size_t CompressLz4Block(
+    const void* pSrc,
+    size_t      srcSize,
+    void*       pDst,
+    size_t      dstCapacity)
+{
+    const uint8_t* const pIn      = static_cast<const uint8_t*>(pSrc);
+    const uint8_t* const pInEnd   = pIn + srcSize;
+    uint8_t*             pOut     = static_cast<uint8_t*>(pDst);
+    const uint8_t* const pOutEnd  = pOut + dstCapacity;
+    const uint8_t*       pAnchor  = pIn;
+    bool                 fits     = (srcSize <= UINT32_MAX);
+
+    if (fits && (srcSize > Lz4MatchStartLimit))
+    {
+        const uint8_t* const pMatchStartLimit = pInEnd - Lz4MatchStartLimit;
+        const uint8_t* const pMatchEndLimit   = pInEnd - Lz4LastLiterals;
+
+        // Positions are relative to pIn.  Stale or zero-initialized slots are harmless since every candidate is
+        // verified before it is used.
+        uint32_t hashTable[1u << Lz4HashLog] = {};
+
+        const uint8_t* pCurrent = pIn;
+
+        while (fits && (pCurrent < pMatchStartLimit))
+        {
+            const uint32_t       sequence   = Lz4Read32(pCurrent);
+            const uint32_t       hash       = Lz4Hash(sequence);
+            const uint8_t* const pCandidate = pIn + hashTable[hash];
+
+            hashTable[hash] = static_cast<uint32_t>(pCurrent - pIn);
+
+            if ((pCandidate < pCurrent)                                        &&
+                (static_cast<size_t>(pCurrent - pCandidate) <= Lz4MaxOffset) &&
+                (Lz4Read32(pCandidate) == sequence))
+            {
+                const uint8_t* pMatchEnd     = pCurrent  + Lz4MinMatch;
+                const uint8_t* pCandidateEnd = pCandidate + Lz4MinMatch;
+
+                while ((pMatchEnd < pMatchEndLimit) && (*pMatchEnd == *pCandidateEnd))
+                {
+                    pMatchEnd++;
+                    pCandidateEnd++;
+                }
+
+                fits = Lz4WriteSequence(pAnchor,
+                                        static_cast<size_t>(pCurrent - pAnchor),
+                                        static_cast<size_t>(pCurrent - pCandidate),
+                                        static_cast<size_t>(pMatchEnd - pCurrent),
+                                        &pOut,
+                                        pOutEnd);
+
+                pCurrent = pMatchEnd;
+                pAnchor  = pMatchEnd;
+            }
+            else
+            {
+                pCurrent++;
+            }
+        }
+    }
+
+    if (fits)
+    {
+        fits = Lz4WriteSequence(pAnchor, static_cast<size_t>(pInEnd - pAnchor), 0, 0, &pOut, pOutEnd);
+    }
+
+    return fits ? static_cast<size_t>(pOut - static_cast<uint8_t*>(pDst)) : 0;
+}
+
+// =====================================================================================================================
+// Decompresses an LZ4 block.  Returns true only if the block is well-formed and decompresses to exactly dstSize bytes;
+// malformed input never reads or writes out of bounds.
+bool DecompressLz4Block(
+    const void* pSrc,
+    size_t      srcSize,
+    void*       pDst,
+    size_t      dstSize)
+{
+    const uint8_t*       pIn     = static_cast<const uint8_t*>(pSrc);
+    const uint8_t* const pInEnd  = pIn + srcSize;
+    uint8_t* const       pOutBeg = static_cast<uint8_t*>(pDst);
+    uint8_t*             pOut    = pOutBeg;
+    uint8_t* const       pOutEnd = pOutBeg + dstSize;
+    bool                 valid   = true;
+
+    while (valid && (pIn < pInEnd))
+    {
+        const uint8_t token         = *pIn++;
+        size_t        literalLength = (token >> 4);
+
+        if (literalLength == Lz4RunMask)
+        {
+            valid = Lz4ReadLength(&pIn, pInEnd, &literalLength);
+        }
+
+        valid = valid                                                              &&
+                (literalLength <= static_cast<size_t>(pInEnd - pIn))               &&
+                (literalLength <= static_cast<size_t>(pOutEnd - pOut));
+
+        if (valid)
+        {
+            memcpy(pOut, pIn, literalLength);
+            pIn  += literalLength;
+            pOut += literalLength;
+
+            // The last sequence only has literals.
+            if (pIn < pInEnd)
+            {
+                valid = (static_cast<size_t>(pInEnd - pIn) >= sizeof(uint16_t));
+
+                size_t offset      = 0;
+                size_t matchLength = (token & Lz4RunMask);
+
+                if (valid)
+                {
+                    offset  = pIn[0] | (static_cast<size_t>(pIn[1]) << 8);
+                    pIn    += sizeof(uint16_t);
+                    valid   = (offset > 0) && (offset <= static_cast<size_t>(pOut - pOutBeg));
+                }
+
+                if (valid && (matchLength == Lz4RunMask))
+                {
+                    valid = Lz4ReadLength(&pIn, pInEnd, &matchLength);
+                }
+
+                matchLength += Lz4MinMatch;
+
+                if (valid)
+                {
+                    valid = (matchLength <= static_cast<size_t>(pOutEnd - pOut));
+                }
+
+                if (valid)
+                {
+                    // Matches may overlap the bytes they produce, so copy front to back.
+                    const uint8_t* pMatch = pOut - offset;
+
+                    for (size_t i = 0; i < matchLength; ++i)
+                    {
+                        pOut[i] = pMatch[i];
+                    }
+
+                    pOut += matchLength;
+                }
+            }
+        }
+    }
+
+    return valid && (pOut == pOutEnd);
+}
+
+// =====================================================================================================================
+// Returns the size of the binary stored in a cache entry once decompressed.  For uncompressed entries this is the
+// stored size.
+Util::Result GetBinaryCacheEntryDecompressedSize(
+    const BinaryCacheEntry* pEntry,
+    const void*             pData,
+    size_t*                 pDecompressedSize)
+{
+    PAL_ASSERT(pEntry != nullptr);
+    PAL_ASSERT(pDecompressedSize != nullptr);
+
+    Util::Result result     = Util::Result::Success;
+    const size_t storedSize = GetBinaryCacheEntryStoredSize(*pEntry);
+
+    if (IsCompressedBinaryCacheEntry(*pEntry))
+    {
+        CompressedBinaryCacheEntryHeader header = {};
+
+        if (storedSize < sizeof(header))
+        {
+            result = Util::Result::ErrorInvalidValue;
+        }
+        else
+        {
+            memcpy(&header, pData, sizeof(header));
+
+            if ((header.compression != static_cast<uint32_t>(BinaryCacheCompression::Lz4)) ||
+                (header.decompressedSize > SIZE_MAX))
+            {
+                result = Util::Result::ErrorInvalidValue;
+            }
+            else
+            {
+                *pDecompressedSize = static_cast<size_t>(header.decompressedSize);
+            }
+        }
+    }
+    else
+    {
+        *pDecompressedSize = storedSize;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Writes the binary stored in a cache entry to pOutput, decompressing it if needed.  outputSize must be the size
+// returned by GetBinaryCacheEntryDecompressedSize.
+Util::Result DecompressBinaryCacheEntry(
+    const BinaryCacheEntry* pEntry,
+    const void*             pData,
+    size_t                  outputSize,
+    void*                   pOutput)
+{
+    PAL_ASSERT(pEntry != nullptr);
+    PAL_ASSERT(pOutput != nullptr);
+
+    size_t       decompressedSize = 0;
+    Util::Result result           = GetBinaryCacheEntryDecompressedSize(pEntry, pData, &decompressedSize);
+
+    if ((result == Util::Result::Success) && (decompressedSize != outputSize))
+    {
+        result = Util::Result::ErrorInvalidMemorySize;
+    }
+
+    if (result == Util::Result::Success)
+    {
+        if (IsCompressedBinaryCacheEntry(*pEntry))
+        {
+            constexpr size_t HeaderSize = sizeof(CompressedBinaryCacheEntryHeader);
+
+            if (DecompressLz4Block(Util::VoidPtrInc(pData, HeaderSize),
+                                   GetBinaryCacheEntryStoredSize(*pEntry) - HeaderSize,
+                                   pOutput,
+                                   outputSize) == false)
+            {
+                result = Util::Result::ErrorInvalidValue;
+            }
+        }
+        else
+        {
+            memcpy(pOutput, pData, outputSize);
+        }
+    }
+
+    return result;
+}
+
 // =====================================================================================================================
 // Writes Vulkan pipeline cache data object header into the provided output buffer.
 Util::Result WriteVkPipelineCacheHeaderData(
@@ -155,15 +545,19 @@ Util::Result CalculatePipelineBinaryCacheHashId(
 // =====================================================================================================================
 // Returns Util::Result::Success on success or Util::Result::ErrorInvalidMemorySize if the provided buffer is too small
 // to create a valid pipeline binary cache blob.
+//
+// When compressEntries is set, entries are LZ4-compressed whenever that makes them smaller.
 Util::Result PipelineBinaryCacheSerializer::Initialize(
     size_t bufferCapacity,
-    void*  pOutputBuffer)
+    void*  pOutputBuffer,
+    bool   compressEntries)
 {
     PAL_ASSERT(pOutputBuffer != nullptr);
 
     Util::Result result = Util::Result::ErrorInvalidMemorySize;
 
-    m_pOutputBuffer = pOutputBuffer;
+    m_pOutputBuffer   = pOutputBuffer;
+    m_compressEntries = compressEntries;
     if (bufferCapacity >= HeaderSize)
     {
         m_bufferCapacity = bufferCapacity;
@@ -173,6 +567,30 @@ Util::Result PipelineBinaryCacheSerializer::Initialize(
     return result;
 }
 
+// =====================================================================================================================
+// Resumes serialization into a buffer whose first bytesUsed bytes are a blob written by an earlier serializer.  New
+// entries are appended after the existing ones; Finalize() must be called again to rewrite the header.
+Util::Result PipelineBinaryCacheSerializer::InitializeAppend(
+    size_t bufferCapacity,
+    void*  pOutputBuffer,
+    size_t bytesUsed,
+    bool   compressEntries)
+{
+    PAL_ASSERT(pOutputBuffer != nullptr);
+
+    Util::Result result = Util::Result::ErrorInvalidMemorySize;
+
+    m_pOutputBuffer   = pOutputBuffer;
+    m_compressEntries = compressEntries;
+    if ((bytesUsed >= HeaderSize) && (bufferCapacity >= bytesUsed))
+    {
+        m_bufferCapacity = bufferCapacity;
+        m_bytesUsed = bytesUsed;
+        result = Util::Result::Success;
+    }
+    return result;
+}
+
 // =====================================================================================================================
 // Copies the provided data into the internal buffer.
 Util::Result PipelineBinaryCacheSerializer::AddPipelineBinary(
@@ -181,10 +599,15 @@ Util::Result PipelineBinaryCacheSerializer::AddPipelineBinary(
 {
     PAL_ASSERT(pEntry != nullptr);
     PAL_ASSERT(pData != nullptr);
+    PAL_ASSERT(IsCompressedBinaryCacheEntry(*pEntry) == false);
 
     Util::Result result = Util::Result::ErrorIncompleteResults;
     const size_t bytesToWrite = EntryHeaderSize + pEntry->dataSize;
-    if (bytesToWrite <= (m_bufferCapacity - m_bytesUsed))
+    if (m_compressEntries && AddCompressedPipelineBinary(pEntry, pData))
+    {
+        result = Util::Result::Success;
+    }
+    else if (bytesToWrite <= (m_bufferCapacity - m_bytesUsed))
     {
         void *pOutputMem = Util::VoidPtrInc(m_pOutputBuffer, m_bytesUsed);
         memcpy(pOutputMem, pEntry, EntryHeaderSize);
@@ -198,6 +621,77 @@ Util::Result PipelineBinaryCacheSerializer::AddPipelineBinary(
     return result;
 }
 
+// =====================================================================================================================
+// Copies an entry taken from another serialized blob as is.  pEntry->dataSize may carry BinaryCacheEntryCompressedFlag,
+// in which case pData is the stored (compressed) data; it is never compressed or decompressed here.
+Util::Result PipelineBinaryCacheSerializer::AddStoredPipelineBinary(
+    const BinaryCacheEntry* pEntry,
+    const void*             pData)
+{
+    PAL_ASSERT(pEntry != nullptr);
+    PAL_ASSERT(pData != nullptr);
+
+    Util::Result result     = Util::Result::ErrorIncompleteResults;
+    const size_t storedSize = GetBinaryCacheEntryStoredSize(*pEntry);
+
+    if ((EntryHeaderSize + storedSize) <= (m_bufferCapacity - m_bytesUsed))
+    {
+        void* pOutputMem = Util::VoidPtrInc(m_pOutputBuffer, m_bytesUsed);
+        memcpy(pOutputMem, pEntry, EntryHeaderSize);
+        memcpy(Util::VoidPtrInc(pOutputMem, EntryHeaderSize), pData, storedSize);
+        m_bytesUsed += EntryHeaderSize + storedSize;
+        ++m_numEntries;
+        result = Util::Result::Success;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Tries to store the provided data compressed.  Returns false, without writing anything, if the entry is too small or
+// compression wouldn't save any space.
+bool PipelineBinaryCacheSerializer::AddCompressedPipelineBinary(
+    const BinaryCacheEntry* pEntry,
+    const void*             pData)
+{
+    constexpr size_t CompressedHeaderSize = sizeof(CompressedBinaryCacheEntryHeader);
+
+    const size_t bytesAvailable = m_bufferCapacity - m_bytesUsed;
+    bool         added          = false;
+
+    if ((pEntry->dataSize >= MinCompressedEntrySize) &&
+        (bytesAvailable > (EntryHeaderSize + CompressedHeaderSize)))
+    {
+        // Only accept results which are smaller than the raw entry, so the serialized blob never grows.
+        const size_t dstCapacity = Util::Min(bytesAvailable - EntryHeaderSize, pEntry->dataSize) - CompressedHeaderSize;
+
+        void* pEntryMem      = Util::VoidPtrInc(m_pOutputBuffer, m_bytesUsed);
+        void* pHeaderMem     = Util::VoidPtrInc(pEntryMem, EntryHeaderSize);
+        void* pCompressedMem = Util::VoidPtrInc(pHeaderMem, CompressedHeaderSize);
+
+        const size_t compressedSize = CompressLz4Block(pData, pEntry->dataSize, pCompressedMem, dstCapacity);
+
+        if ((compressedSize > 0) && ((compressedSize + CompressedHeaderSize) < pEntry->dataSize))
+        {
+            CompressedBinaryCacheEntryHeader header = {};
+            header.compression      = static_cast<uint32_t>(BinaryCacheCompression::Lz4);
+            header.decompressedSize = pEntry->dataSize;
+
+            BinaryCacheEntry entry = *pEntry;
+            entry.dataSize = (compressedSize + CompressedHeaderSize) | BinaryCacheEntryCompressedFlag;
+
+            memcpy(pEntryMem, &entry, EntryHeaderSize);
+            memcpy(pHeaderMem, &header, CompressedHeaderSize);
+
+            m_bytesUsed += EntryHeaderSize + CompressedHeaderSize + compressedSize;
+            ++m_numEntries;
+            added = true;
+        }
+    }
+
+    return added;
+}
+
 // =====================================================================================================================
 // Writes a pipeline binary cache header based on the added data entries, producing a valid pipeline binary cache blob.
 // No further data entries can be added after calling Finalize.
@@ -48,6 +48,20 @@ CacheAdapter* CacheAdapter::Create(
     if (pMem != nullptr)
     {
         pObj = VK_PLACEMENT_NEW(pMem) CacheAdapter(pPipelineBinaryCache);
+
+        // The snapshot table is only an accelerator; without it every lookup simply goes through the cache layers.
+        void* pSlotMem = pPipelineBinaryCache->AllocMem(sizeof(SnapshotSlot) * SnapshotSlotCount);
+
+        if (pSlotMem != nullptr)
+        {
+            pObj->m_pSnapshotSlots = static_cast<SnapshotSlot*>(pSlotMem);
+
+            for (uint32_t i = 0; i < SnapshotSlotCount; ++i)
+            {
+                SnapshotSlot* pSlot = VK_PLACEMENT_NEW(&pObj->m_pSnapshotSlots[i]) SnapshotSlot();
+                pSlot->state.store(SnapshotSlot::Empty, std::memory_order_relaxed);
+            }
+        }
     }
 
     return pObj;
@@ -58,6 +72,26 @@ void CacheAdapter::Destroy()
 {
     PipelineBinaryCache* pCache = m_pPipelineBinaryCache;
     void*                pMem   = this;
+
+    if (m_pSnapshotSlots != nullptr)
+    {
+        for (uint32_t i = 0; i < SnapshotSlotCount; ++i)
+        {
+            SnapshotSlot* pSlot = &m_pSnapshotSlots[i];
+
+            if (pSlot->state.load(std::memory_order_acquire) == SnapshotSlot::Ready)
+            {
+                pCache->ReleaseCacheRef(pSlot->pQuery);
+                pCache->FreeMem(pSlot->pQuery);
+            }
+
+            Util::Destructor(pSlot);
+        }
+
+        pCache->FreeMem(m_pSnapshotSlots);
+        m_pSnapshotSlots = nullptr;
+    }
+
     Util::Destructor(this);
     pCache->FreeMem(pMem);
 }
@@ -66,7 +100,9 @@ void CacheAdapter::Destroy()
 CacheAdapter::CacheAdapter(
     PipelineBinaryCache* pPipelineBinaryCache)
     :
-    m_pPipelineBinaryCache { pPipelineBinaryCache }
+    m_pPipelineBinaryCache { pPipelineBinaryCache },
+    m_pSnapshotSlots       { nullptr },
+    m_snapshotBytes        { 0 }
 {
 }
 
@@ -75,12 +111,148 @@ CacheAdapter::~CacheAdapter()
 {
 }
 
+// =====================================================================================================================
+void CacheAdapter::HashIdToCacheId(
+    HashId                 hashId,
+    Util::MetroHash::Hash* pCacheId)
+{
+    Util::MetroHash128 hash128 = {};
+    hash128.Update(hashId);
+    hash128.Finalize(pCacheId->bytes);
+}
+
+// =====================================================================================================================
+// Probes the snapshot table without taking any lock.  Returns nullptr if the entry hasn't been published.
+const CacheAdapter::SnapshotSlot* CacheAdapter::FindSnapshot(
+    const Util::MetroHash::Hash& cacheId) const
+{
+    const SnapshotSlot* pFound = nullptr;
+
+    if (m_pSnapshotSlots != nullptr)
+    {
+        const uint32_t start = cacheId.dwords[0] & (SnapshotSlotCount - 1);
+
+        for (uint32_t probe = 0; probe < SnapshotProbeLimit; ++probe)
+        {
+            const SnapshotSlot* pSlot = &m_pSnapshotSlots[(start + probe) & (SnapshotSlotCount - 1)];
+            const uint32_t      state = pSlot->state.load(std::memory_order_acquire);
+
+            if (state == SnapshotSlot::Empty)
+            {
+                // Slots are filled in probe order.  A slot freed by a failed publish may hide a later entry, which
+                // only costs a lookup through the cache layers.
+                break;
+            }
+            else if ((state == SnapshotSlot::Ready) && (memcmp(&pSlot->cacheId, &cacheId, sizeof(cacheId)) == 0))
+            {
+                pFound = pSlot;
+                break;
+            }
+        }
+    }
+
+    return pFound;
+}
+
+// =====================================================================================================================
+// Publishes a complete entry in the snapshot table.  Takes its own reference on the cache entry; the caller keeps the
+// reference held by pQuery.  Publishing is best effort and silently gives up if the table or byte budget is exhausted.
+void CacheAdapter::PublishSnapshot(
+    const Util::MetroHash::Hash& cacheId,
+    const Util::QueryResult*     pQuery)
+{
+    if ((m_pSnapshotSlots == nullptr) ||
+        (m_snapshotBytes.load(std::memory_order_relaxed) + pQuery->dataSize > SnapshotMaxBytes))
+    {
+        return;
+    }
+
+    const uint32_t start = cacheId.dwords[0] & (SnapshotSlotCount - 1);
+    SnapshotSlot*  pSlot = nullptr;
+
+    for (uint32_t probe = 0; probe < SnapshotProbeLimit; ++probe)
+    {
+        SnapshotSlot* pCandidate = &m_pSnapshotSlots[(start + probe) & (SnapshotSlotCount - 1)];
+        uint32_t      expected   = SnapshotSlot::Empty;
+
+        if (pCandidate->state.compare_exchange_strong(expected, SnapshotSlot::Writing, std::memory_order_acquire))
+        {
+            pSlot = pCandidate;
+            break;
+        }
+        else if ((expected == SnapshotSlot::Ready) && (memcmp(&pCandidate->cacheId, &cacheId, sizeof(cacheId)) == 0))
+        {
+            // Another thread got here first.
+            break;
+        }
+
+        // The slot is taken by a different entry or is being written; a duplicate in a later slot is harmless.
+    }
+
+    if (pSlot != nullptr)
+    {
+        bool published = false;
+
+        Util::QueryResult* pPinned =
+            static_cast<Util::QueryResult*>(m_pPipelineBinaryCache->AllocMem(sizeof(Util::QueryResult)));
+
+        if (pPinned != nullptr)
+        {
+            Util::Result palResult = m_pPipelineBinaryCache->QueryPipelineBinary(
+                &pQuery->hashId,
+                Util::ICacheLayer::QueryFlags::AcquireEntryRef,
+                pPinned);
+
+            if (palResult == Util::Result::Success)
+            {
+                const void* pData = nullptr;
+
+                if (m_pPipelineBinaryCache->GetCacheDataPtr(pPinned, &pData) == Util::Result::Success)
+                {
+                    pSlot->cacheId  = cacheId;
+                    pSlot->pData    = pData;
+                    pSlot->dataSize = pPinned->dataSize;
+                    pSlot->pQuery   = pPinned;
+
+                    m_snapshotBytes.fetch_add(pPinned->dataSize, std::memory_order_relaxed);
+
+                    published = true;
+                }
+                else
+                {
+                    // Not every layer can hand out a stable data pointer.
+                    m_pPipelineBinaryCache->ReleaseCacheRef(pPinned);
+                }
+            }
+
+            if (published == false)
+            {
+                m_pPipelineBinaryCache->FreeMem(pPinned);
+            }
+        }
+
+        pSlot->state.store(published ? SnapshotSlot::Ready : SnapshotSlot::Empty, std::memory_order_release);
+    }
+}
+
 // =====================================================================================================================
 Result CacheAdapter::GetEntry(
     HashId              hashId,
     bool                allocateOnMiss,
     EntryHandle*        pHandle)
 {
+    Util::MetroHash::Hash cacheId = {};
+    HashIdToCacheId(hashId, &cacheId);
+
+    const SnapshotSlot* pSnapshot = FindSnapshot(cacheId);
+
+    if (pSnapshot != nullptr)
+    {
+        *pHandle = EntryHandle(this, ToSnapshotHandle(pSnapshot), false);
+
+        return Result::Success;
+    }
+
     Result result = Result::Success;
     bool mustPopulate = false;
     Util::QueryResult* pQuery =
@@ -88,10 +260,6 @@ Result CacheAdapter::GetEntry(
 
     if (pQuery != nullptr)
     {
-        Util::MetroHash::Hash cacheId = {};
-        Util::MetroHash128 hash128 = {};
-        hash128.Update(hashId);
-        hash128.Finalize(cacheId.bytes);
         uint32_t flags  = Util::ICacheLayer::QueryFlags::AcquireEntryRef;
 
         if (allocateOnMiss)
@@ -99,6 +267,21 @@ Result CacheAdapter::GetEntry(
             flags |= Util::ICacheLayer::QueryFlags::ReserveEntryOnMiss;
         }
         Util::Result palResult = m_pPipelineBinaryCache->QueryPipelineBinary(&cacheId, flags, pQuery);
+        if (palResult == Util::Result::Success)
+        {
+            // Identical binaries are stored once; SetValue() may have stored this one as an alias.
+            palResult = m_pPipelineBinaryCache->ResolveShaderAlias(flags, pQuery);
+
+            if (palResult != Util::Result::Success)
+            {
+                m_pPipelineBinaryCache->ReleaseCacheRef(pQuery);
+            }
+            else
+            {
+                PublishSnapshot(cacheId, pQuery);
+            }
+        }
+
         if (palResult == Util::Result::Reserved)
         {
             mustPopulate = true;
@@ -137,6 +320,12 @@ Result CacheAdapter::GetEntry(
 Result CacheAdapter::WaitForEntry(
     RawEntryHandle rawHandle)
 {
+    if (IsSnapshotHandle(rawHandle))
+    {
+        // Only complete entries are published.
+        return Result::Success;
+    }
+
     Util::QueryResult* pQuery  = static_cast<Util::QueryResult*>(rawHandle);
 
     Util::Result palResult = m_pPipelineBinaryCache->WaitPipelineBinary(&pQuery->hashId);
@@ -146,6 +335,15 @@ Result CacheAdapter::WaitForEntry(
         palResult = m_pPipelineBinaryCache->QueryPipelineBinary(&pQuery->hashId, 0, pQuery);
     }
 
+    if (palResult == Util::Result::Success)
+    {
+        // The handle holds the reference GetEntry() acquired on the entry.
+        palResult = m_pPipelineBinaryCache->ResolveShaderAlias(Util::ICacheLayer::QueryFlags::AcquireEntryRef, pQuery);
+    }
+
+    // The original LLPC hash ID isn't known here, so entries completed by another thread are published by the next
+    // GetEntry() which finds them ready.
+
     return (palResult == Util::Result::Success) ? Result::Success : Result::ErrorUnknown;
 }
 
@@ -153,7 +351,8 @@ Result CacheAdapter::WaitForEntry(
 void CacheAdapter::ReleaseEntry(
     RawEntryHandle rawHandle)
 {
-    if (rawHandle != nullptr)
+    // Snapshot handles don't own anything; the adapter keeps the reference until it is destroyed.
+    if ((rawHandle != nullptr) && (IsSnapshotHandle(rawHandle) == false))
     {
         Util::QueryResult* pQuery  = static_cast<Util::QueryResult*>(rawHandle);
         m_pPipelineBinaryCache->ReleaseCacheRef(pQuery);
@@ -168,6 +367,13 @@ Result CacheAdapter::SetValue(
     const void* pData,
     size_t dataLen)
 {
+    // Snapshot handles are only handed out for complete entries, which LLPC never populates.
+    if (IsSnapshotHandle(rawHandle))
+    {
+        VK_NEVER_CALLED();
+        return Result::ErrorUnknown;
+    }
+
     Result result = Result::Success;
     Util::QueryResult* pQuery  = static_cast<Util::QueryResult*>(rawHandle);
     Util::Result palResult = Util::Result::Success;
@@ -179,7 +385,7 @@ Result CacheAdapter::SetValue(
     }
     else
     {
-        palResult = m_pPipelineBinaryCache->StorePipelineBinary(&pQuery->hashId, dataLen, pData);
+        palResult = m_pPipelineBinaryCache->StoreShaderBinary(&pQuery->hashId, dataLen, pData);
     }
     result = (palResult == Util::Result::Success) ? Result::Success : Result::ErrorUnknown;
 
@@ -192,6 +398,27 @@ Result CacheAdapter::GetValue(
     void*   pData,
     size_t* pDataLen)
 {
+    if (IsSnapshotHandle(rawHandle))
+    {
+        const SnapshotSlot* pSlot  = FromSnapshotHandle(rawHandle);
+        Result              result = Result::Success;
+
+        if (pData == nullptr)
+        {
+            *pDataLen = pSlot->dataSize;
+        }
+        else if (*pDataLen < pSlot->dataSize)
+        {
+            result = Result::ErrorInvalidValue;
+        }
+        else
+        {
+            memcpy(pData, pSlot->pData, pSlot->dataSize);
+        }
+
+        return result;
+    }
+
     Result result = Result::NotReady;
     Util::Result palResult = Util::Result::Success;
     Util::QueryResult* pQuery  = static_cast<Util::QueryResult*>(rawHandle);
@@ -235,6 +462,16 @@ Result CacheAdapter::GetValueZeroCopy(
     const void** ppData,
     size_t* pDataLen)
 {
+    if (IsSnapshotHandle(rawHandle))
+    {
+        const SnapshotSlot* pSlot = FromSnapshotHandle(rawHandle);
+
+        *ppData   = pSlot->pData;
+        *pDataLen = pSlot->dataSize;
+
+        return Result::Success;
+    }
+
     Result result = Result::NotReady;
     Util::Result palResult = Util::Result::Success;
     Util::QueryResult* pQuery  = static_cast<Util::QueryResult*>(rawHandle);
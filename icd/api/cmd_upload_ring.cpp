@@ -0,0 +1,184 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  cmd_upload_ring.cpp
+* @brief Implementation of the upload ring command buffers stage inline data through.
+***********************************************************************************************************************
+*/
+
+#include "include/cmd_upload_ring.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+
+namespace vk
+{
+
+// Alignment of every upload within its chunk
+constexpr Pal::gpusize UploadAlignment = 16;
+
+// =====================================================================================================================
+CmdUploadRing::CmdUploadRing(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_pFirstChunk(nullptr),
+    m_pCurChunk(nullptr),
+    m_curOffset(0)
+{
+}
+
+// =====================================================================================================================
+// Copies data into the ring for every device in the mask.  Returns the memory and the offset into its PAL memory object
+// the GPU can copy the data from until the ring is reset.
+VkResult CmdUploadRing::Upload(
+    uint32_t               deviceMask,
+    Pal::gpusize           size,
+    const void*            pData,
+    const InternalMemory** ppMemory,
+    Pal::gpusize*          pOffset)
+{
+    VK_ASSERT((size > 0) && (size <= ChunkSize));
+
+    VkResult result = VK_SUCCESS;
+
+    const Pal::gpusize alignedOffset = Util::Pow2Align(m_curOffset, UploadAlignment);
+
+    if ((m_pCurChunk == nullptr) || ((alignedOffset + size) > ChunkSize))
+    {
+        // Move on to the next chunk, creating it if the ring never grew this far
+        Chunk** ppNext = (m_pCurChunk == nullptr) ? &m_pFirstChunk : &m_pCurChunk->pNext;
+
+        if (*ppNext == nullptr)
+        {
+            result = AllocChunk(ppNext);
+        }
+
+        if (result == VK_SUCCESS)
+        {
+            m_pCurChunk = *ppNext;
+            m_curOffset = 0;
+        }
+    }
+    else
+    {
+        m_curOffset = alignedOffset;
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        InternalMemory* pMemory = &m_pCurChunk->memory;
+
+        utils::IterateMask deviceGroup(deviceMask);
+
+        do
+        {
+            const uint32_t deviceIdx = deviceGroup.Index();
+
+            memcpy(Util::VoidPtrInc(pMemory->CpuAddr(deviceIdx), static_cast<size_t>(m_curOffset)),
+                   pData,
+                   static_cast<size_t>(size));
+        }
+        while (deviceGroup.IterateNext());
+
+        *ppMemory = pMemory;
+        *pOffset  = pMemory->Offset() + m_curOffset;
+
+        m_curOffset += size;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Makes all chunks available again.  Only valid once the GPU no longer reads any earlier upload.
+void CmdUploadRing::Reset()
+{
+    m_pCurChunk = nullptr;
+    m_curOffset = 0;
+}
+
+// =====================================================================================================================
+// Frees all chunks.  Only valid once the GPU no longer reads any earlier upload.
+void CmdUploadRing::Destroy()
+{
+    while (m_pFirstChunk != nullptr)
+    {
+        Chunk* pChunk = m_pFirstChunk;
+
+        m_pFirstChunk = pChunk->pNext;
+
+        m_pDevice->MemMgr()->FreeGpuMem(&pChunk->memory);
+
+        Util::Destructor(pChunk);
+
+        m_pDevice->VkInstance()->FreeMem(pChunk);
+    }
+
+    Reset();
+}
+
+// =====================================================================================================================
+// Creates a chunk in write-combined GART memory, which is persistently mapped and only read by the GPU.
+VkResult CmdUploadRing::AllocChunk(
+    Chunk** ppChunk)
+{
+    VkResult result = VK_ERROR_OUT_OF_HOST_MEMORY;
+
+    void* pMemory = m_pDevice->VkInstance()->AllocMem(
+        sizeof(Chunk), VK_DEFAULT_MEM_ALIGN, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+    if (pMemory != nullptr)
+    {
+        Chunk* pChunk = VK_PLACEMENT_NEW(pMemory) Chunk();
+
+        pChunk->pNext = nullptr;
+
+        InternalMemCreateInfo allocInfo = {};
+
+        allocInfo.pal.size      = ChunkSize;
+        allocInfo.pal.alignment = UploadAlignment;
+        allocInfo.pal.priority  = Pal::GpuMemPriority::Normal;
+
+        m_pDevice->MemMgr()->GetCommonPool(InternalPoolGpuReadOnlyRemote, &allocInfo);
+
+        result = m_pDevice->MemMgr()->AllocGpuMem(allocInfo, &pChunk->memory, m_pDevice->GetPalDeviceMask());
+
+        if (result == VK_SUCCESS)
+        {
+            *ppChunk = pChunk;
+        }
+        else
+        {
+            Util::Destructor(pChunk);
+
+            m_pDevice->VkInstance()->FreeMem(pChunk);
+        }
+    }
+
+    return result;
+}
+
+} // namespace vk
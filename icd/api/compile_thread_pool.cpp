@@ -0,0 +1,329 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  compile_thread_pool.cpp
+* @brief Implementation of the driver-owned worker pool used for batched pipeline compiles.
+***********************************************************************************************************************
+*/
+#include "include/compile_thread_pool.h"
+#include "include/vk_conv.h"
+#include "include/vk_instance.h"
+
+#include "palSysUtil.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+// Allocates a pool and starts up to threadCount worker threads.  Returns nullptr if no worker could be started.
+CompileThreadPool* CompileThreadPool::Create(
+    Instance* pInstance,
+    uint32_t  threadCount)
+{
+    CompileThreadPool* pPool = nullptr;
+    void*              pMem  = pInstance->AllocMem(sizeof(CompileThreadPool), VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+    if (pMem != nullptr)
+    {
+        pPool = VK_PLACEMENT_NEW(pMem) CompileThreadPool(pInstance);
+
+        if (pPool->Init(threadCount) != VK_SUCCESS)
+        {
+            pPool->Destroy();
+            pPool = nullptr;
+        }
+    }
+
+    return pPool;
+}
+
+// =====================================================================================================================
+CompileThreadPool::CompileThreadPool(
+    Instance* pInstance)
+    :
+    m_pInstance(pInstance),
+    m_threadCount(0),
+    m_pPendingHead(nullptr),
+    m_stop(false)
+{
+}
+
+// =====================================================================================================================
+VkResult CompileThreadPool::Init(
+    uint32_t threadCount)
+{
+    Util::EventCreateFlags flags = {};
+    flags.manualReset       = false;
+    flags.initiallySignaled = false;
+
+    VkResult result = PalToVkResult(m_wakeEvent.Init(flags));
+
+    threadCount = Util::Min(threadCount, MaxThreads);
+
+    for (uint32_t i = 0; (result == VK_SUCCESS) && (i < threadCount); ++i)
+    {
+        if (m_threads[i].Begin(ThreadFunc, this) == Util::Result::Success)
+        {
+            m_threadCount++;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if ((result == VK_SUCCESS) && (m_threadCount == 0))
+    {
+        result = VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Stops and joins all worker threads, then frees the pool.  No Execute() call may be in flight.
+void CompileThreadPool::Destroy()
+{
+    VK_ASSERT(m_pPendingHead == nullptr);
+
+    m_stop = true;
+    m_wakeEvent.Set();
+
+    for (uint32_t i = 0; i < m_threadCount; ++i)
+    {
+        m_threads[i].Join();
+    }
+
+    Instance* pInstance = m_pInstance;
+
+    Util::Destructor(this);
+
+    pInstance->FreeMem(this);
+}
+
+// =====================================================================================================================
+// Runs pfnTask for every index in [0, taskCount).  The calling thread executes tasks alongside the workers and returns
+// once every task of this batch has finished.  Tasks from different batches (submitted concurrently by different
+// application threads) are picked up by the workers in submission order.
+void CompileThreadPool::Execute(
+    TaskFunc pfnTask,
+    void*    pPayload,
+    uint32_t taskCount)
+{
+    if (taskCount == 0)
+    {
+        return;
+    }
+
+    Util::EventCreateFlags flags = {};
+    flags.manualReset       = true;
+    flags.initiallySignaled = false;
+
+    Util::Event doneEvent;
+    Util::Result palResult = doneEvent.Init(flags);
+
+    if (palResult != Util::Result::Success)
+    {
+        // Without a completion event we can't wait on the workers; just run the batch here.
+        for (uint32_t i = 0; i < taskCount; ++i)
+        {
+            pfnTask(pPayload, i);
+        }
+
+        return;
+    }
+
+    Batch batch          = {};
+    batch.pfnTask        = pfnTask;
+    batch.pPayload       = pPayload;
+    batch.taskCount      = taskCount;
+    batch.nextTask       = 0;
+    batch.completedTasks = 0;
+    batch.pDoneEvent     = &doneEvent;
+    batch.pNext          = nullptr;
+
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        Batch** ppTail = &m_pPendingHead;
+
+        while (*ppTail != nullptr)
+        {
+            ppTail = &(*ppTail)->pNext;
+        }
+
+        *ppTail = &batch;
+    }
+
+    m_wakeEvent.Set();
+
+    // Help out with our own batch instead of sitting idle.
+    uint32_t taskIndex = 0;
+
+    while (ClaimTask(&batch, &taskIndex))
+    {
+        pfnTask(pPayload, taskIndex);
+        CompleteTask(&batch);
+    }
+
+    // All tasks have been claimed; wait for the ones still running on worker threads.
+    while (IsBatchDone(&batch) == false)
+    {
+        doneEvent.Wait(1.0f);
+    }
+}
+
+// =====================================================================================================================
+void CompileThreadPool::ThreadFunc(
+    void* pParam)
+{
+    static_cast<CompileThreadPool*>(pParam)->WorkerLoop();
+}
+
+// =====================================================================================================================
+void CompileThreadPool::WorkerLoop()
+{
+    while (m_stop == false)
+    {
+        m_wakeEvent.Wait(1.0f);
+
+        Batch*   pBatch    = nullptr;
+        uint32_t taskIndex = 0;
+
+        while ((m_stop == false) && ClaimPendingTask(&pBatch, &taskIndex))
+        {
+            pBatch->pfnTask(pBatch->pPayload, taskIndex);
+            CompleteTask(pBatch);
+        }
+    }
+
+    // The wake event auto-resets, so pass the stop signal on to the next worker.
+    m_wakeEvent.Set();
+}
+
+// =====================================================================================================================
+// Claims the next task of a specific batch.  Returns false if every task of the batch has already been claimed.
+bool CompileThreadPool::ClaimTask(
+    Batch*    pBatch,
+    uint32_t* pTaskIndex)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    bool claimed = false;
+
+    if (pBatch->nextTask < pBatch->taskCount)
+    {
+        *pTaskIndex = pBatch->nextTask++;
+        claimed     = true;
+
+        if (pBatch->nextTask == pBatch->taskCount)
+        {
+            UnlinkBatch(pBatch);
+        }
+    }
+
+    return claimed;
+}
+
+// =====================================================================================================================
+// Claims the next task of the oldest pending batch.  Returns false if there is no pending work.
+bool CompileThreadPool::ClaimPendingTask(
+    Batch**   ppBatch,
+    uint32_t* pTaskIndex)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    Batch* pBatch = m_pPendingHead;
+
+    if (pBatch != nullptr)
+    {
+        // Batches are unlinked as soon as their last task is claimed, so the head always has work left.
+        VK_ASSERT(pBatch->nextTask < pBatch->taskCount);
+
+        *pTaskIndex = pBatch->nextTask++;
+        *ppBatch    = pBatch;
+
+        if (pBatch->nextTask == pBatch->taskCount)
+        {
+            UnlinkBatch(pBatch);
+        }
+
+        if (m_pPendingHead != nullptr)
+        {
+            // More work is left; wake another worker.
+            m_wakeEvent.Set();
+        }
+    }
+
+    return (pBatch != nullptr);
+}
+
+// =====================================================================================================================
+// Marks one task of the batch as finished.  The done event is signaled under the lock so that the submitting thread
+// can't observe completion and release the batch while the event is still being touched.
+void CompileThreadPool::CompleteTask(
+    Batch* pBatch)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    pBatch->completedTasks++;
+
+    if (pBatch->completedTasks == pBatch->taskCount)
+    {
+        pBatch->pDoneEvent->Set();
+    }
+}
+
+// =====================================================================================================================
+bool CompileThreadPool::IsBatchDone(
+    Batch* pBatch)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    return (pBatch->completedTasks == pBatch->taskCount);
+}
+
+// =====================================================================================================================
+// Removes a batch from the pending list.  Must be called with m_lock held.
+void CompileThreadPool::UnlinkBatch(
+    Batch* pBatch)
+{
+    Batch** ppCurrent = &m_pPendingHead;
+
+    while ((*ppCurrent != nullptr) && (*ppCurrent != pBatch))
+    {
+        ppCurrent = &(*ppCurrent)->pNext;
+    }
+
+    if (*ppCurrent != nullptr)
+    {
+        *ppCurrent = pBatch->pNext;
+    }
+
+    pBatch->pNext = nullptr;
+}
+
+} // namespace vk
@@ -0,0 +1,159 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  debug_name_table.cpp
+* @brief Implementation of the per-device table of interned debug object names.
+***********************************************************************************************************************
+*/
+#include "include/debug_name_table.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+
+#include "palInlineFuncs.h"
+#include "palMetroHash.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+DebugNameTable::DebugNameTable(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_names(pDevice->VkInstance()),
+    m_pChunks(nullptr)
+{
+}
+
+// =====================================================================================================================
+VkResult DebugNameTable::Init()
+{
+    return PalToVkResult(m_names.Init());
+}
+
+// =====================================================================================================================
+// Frees every name.  Nothing may use an interned name afterwards.
+void DebugNameTable::Destroy()
+{
+    while (m_pChunks != nullptr)
+    {
+        Chunk* pChunk = m_pChunks;
+
+        m_pChunks = pChunk->pNext;
+
+        m_pDevice->VkInstance()->FreeMem(pChunk);
+    }
+}
+
+// =====================================================================================================================
+// Returns the interned copy of a name, adding it to the table if it is new.  Returns null if out of memory.
+const char* DebugNameTable::Intern(
+    const char* pName)
+{
+    const size_t length = strlen(pName);
+
+    Util::MetroHash::Hash hash = {};
+    Util::MetroHash64::Hash(reinterpret_cast<const uint8_t*>(pName), length, hash.bytes);
+
+    const uint64_t key = Util::MetroHash::Compact64(&hash);
+
+    Util::MutexAuto lock(&m_lock);
+
+    InternedName** ppNames = nullptr;
+    bool           existed = false;
+    const char*    pChars  = nullptr;
+
+    if (m_names.FindAllocate(key, &existed, &ppNames) == Pal::Result::Success)
+    {
+        for (const InternedName* pInterned = *ppNames; (pInterned != nullptr) && (pChars == nullptr);
+             pInterned = pInterned->pNext)
+        {
+            if (strcmp(pInterned->Chars(), pName) == 0)
+            {
+                pChars = pInterned->Chars();
+            }
+        }
+
+        if (pChars == nullptr)
+        {
+            InternedName* pInterned = static_cast<InternedName*>(AllocStorage(sizeof(InternedName) + length + 1));
+
+            if (pInterned != nullptr)
+            {
+                memcpy(pInterned + 1, pName, length + 1);
+
+                pInterned->pNext = *ppNames;
+                *ppNames         = pInterned;
+
+                pChars = pInterned->Chars();
+            }
+        }
+    }
+
+    return pChars;
+}
+
+// =====================================================================================================================
+// Takes pointer-aligned storage from the current chunk, or from a new one if it is full.  Names longer than a chunk
+// get a chunk of their own.
+//
+// WARNING: This function is NOT thread-safe and assumes the caller is holding m_lock.
+void* DebugNameTable::AllocStorage(
+    size_t size)
+{
+    void* pStorage = nullptr;
+
+    size = Util::Pow2Align(size, alignof(InternedName));
+
+    if ((m_pChunks == nullptr) || ((m_pChunks->used + size) > m_pChunks->size))
+    {
+        const size_t chunkSize = Util::Max(ChunkSize, size);
+
+        Chunk* pChunk = static_cast<Chunk*>(m_pDevice->VkInstance()->AllocMem(
+            sizeof(Chunk) + chunkSize,
+            VK_SYSTEM_ALLOCATION_SCOPE_DEVICE));
+
+        if (pChunk != nullptr)
+        {
+            pChunk->size  = chunkSize;
+            pChunk->used  = 0;
+            pChunk->pNext = m_pChunks;
+
+            m_pChunks = pChunk;
+        }
+    }
+
+    if ((m_pChunks != nullptr) && ((m_pChunks->used + size) <= m_pChunks->size))
+    {
+        pStorage = Util::VoidPtrInc(m_pChunks + 1, m_pChunks->used);
+
+        m_pChunks->used += size;
+    }
+
+    return pStorage;
+}
+
+} // namespace vk
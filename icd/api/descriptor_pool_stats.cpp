@@ -0,0 +1,135 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  descriptor_pool_stats.cpp
+* @brief Implementation of the device-wide descriptor pool memory statistics.
+***********************************************************************************************************************
+*/
+#include "include/descriptor_pool_stats.h"
+
+#include "palInlineFuncs.h"
+#include "palJsonWriter.h"
+#include "palSysUtil.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+DescriptorPoolStats::DescriptorPoolStats()
+    :
+    m_poolsCreated(0),
+    m_livePools(0),
+    m_reservedBytes(0),
+    m_usedBytes(0),
+    m_liveSets(0),
+    m_setsAllocated(0),
+    m_allocFailures(0),
+    m_retiredReservedBytes(0),
+    m_retiredPeakUsedBytes(0)
+{
+}
+
+// =====================================================================================================================
+void DescriptorPoolStats::RecordPoolCreate(
+    uint64_t reservedBytes)
+{
+    Util::AtomicIncrement64(&m_poolsCreated);
+    Util::AtomicIncrement64(&m_livePools);
+    Util::AtomicAdd64(&m_reservedBytes, reservedBytes);
+}
+
+// =====================================================================================================================
+// Moves a pool's reservation from the live to the retired totals.  The pool must have reported its usage as zero first.
+void DescriptorPoolStats::RecordPoolDestroy(
+    uint64_t reservedBytes,
+    uint64_t peakUsedBytes)
+{
+    Util::AtomicAdd64(&m_livePools, UINT64_MAX);
+    Util::AtomicAdd64(&m_reservedBytes, 0 - reservedBytes);
+    Util::AtomicAdd64(&m_retiredReservedBytes, reservedBytes);
+    Util::AtomicAdd64(&m_retiredPeakUsedBytes, peakUsedBytes);
+}
+
+// =====================================================================================================================
+// Applies the change in live sets and used GPU memory of one pool.  The deltas wrap around for decreases.
+void DescriptorPoolStats::RecordUsage(
+    int64_t liveSetDelta,
+    int64_t usedByteDelta)
+{
+    if (liveSetDelta != 0)
+    {
+        Util::AtomicAdd64(&m_liveSets, static_cast<uint64_t>(liveSetDelta));
+    }
+
+    if (usedByteDelta != 0)
+    {
+        Util::AtomicAdd64(&m_usedBytes, static_cast<uint64_t>(usedByteDelta));
+    }
+}
+
+// =====================================================================================================================
+void DescriptorPoolStats::RecordAllocs(
+    uint32_t setCount)
+{
+    Util::AtomicAdd64(&m_setsAllocated, setCount);
+}
+
+// =====================================================================================================================
+void DescriptorPoolStats::RecordAllocFailure()
+{
+    Util::AtomicIncrement64(&m_allocFailures);
+}
+
+// =====================================================================================================================
+// Writes the stats as the members of the JSON map the writer is currently in.  The counters keep running while they
+// are read, so the members of a snapshot may be off by the calls that were in flight.
+void DescriptorPoolStats::Write(
+    Util::JsonWriter* pWriter) const
+{
+    pWriter->KeyAndBeginMap("livePools", false);
+    pWriter->KeyAndValue("count", m_livePools);
+    pWriter->KeyAndValue("sets", m_liveSets);
+    pWriter->KeyAndValue("reservedBytes", m_reservedBytes);
+    pWriter->KeyAndValue("usedBytes", m_usedBytes);
+    pWriter->KeyAndValue("utilization",
+                         (m_reservedBytes > 0) ? (static_cast<double>(m_usedBytes) / m_reservedBytes) : 0.0);
+    pWriter->EndMap();
+
+    pWriter->KeyAndBeginMap("destroyedPools", false);
+    pWriter->KeyAndValue("count", m_poolsCreated - m_livePools);
+    pWriter->KeyAndValue("reservedBytes", m_retiredReservedBytes);
+    pWriter->KeyAndValue("peakUsedBytes", m_retiredPeakUsedBytes);
+    pWriter->KeyAndValue("peakUtilization",
+                         (m_retiredReservedBytes > 0) ?
+                         (static_cast<double>(m_retiredPeakUsedBytes) / m_retiredReservedBytes) : 0.0);
+    pWriter->EndMap();
+
+    pWriter->KeyAndValue("poolsCreated", m_poolsCreated);
+    pWriter->KeyAndValue("setsAllocated", m_setsAllocated);
+    pWriter->KeyAndValue("allocFailures", m_allocFailures);
+}
+
+} // namespace vk
@@ -0,0 +1,318 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  device_group_cmd_stream.cpp
+* @brief Implementation of the record-once command stream of device group command buffers.
+***********************************************************************************************************************
+*/
+
+#include "include/device_group_cmd_stream.h"
+#include "include/compile_thread_pool.h"
+#include "include/vk_instance.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+DeviceGroupCmdStream::DeviceGroupCmdStream(
+    CompileThreadPool*      pThreadPool,
+    Pal::ICmdBuffer* const* ppPalCmdBuffers,
+    uint32_t                deviceCount)
+    :
+    m_pThreadPool(pThreadPool),
+    m_ppPalCmdBuffers(ppPalCmdBuffers),
+    m_deviceCount(deviceCount),
+    m_pStream(static_cast<uint8_t*>(Util::VoidPtrInc(this, sizeof(*this)))),
+    m_size(0),
+    m_cmdCount(0)
+{
+}
+
+// =====================================================================================================================
+// Creates the stream of a command buffer.  Returns nullptr if out of memory, in which case the command buffer records
+// to each device directly.
+DeviceGroupCmdStream* DeviceGroupCmdStream::Create(
+    Instance*               pInstance,
+    CompileThreadPool*      pThreadPool,
+    Pal::ICmdBuffer* const* ppPalCmdBuffers,
+    uint32_t                deviceCount)
+{
+    DeviceGroupCmdStream* pStream = nullptr;
+
+    void* pMemory = pInstance->AllocMem(sizeof(DeviceGroupCmdStream) + StreamSize, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+    if (pMemory != nullptr)
+    {
+        pStream = VK_PLACEMENT_NEW(pMemory) DeviceGroupCmdStream(pThreadPool, ppPalCmdBuffers, deviceCount);
+    }
+
+    return pStream;
+}
+
+// =====================================================================================================================
+void DeviceGroupCmdStream::Destroy(
+    Instance* pInstance)
+{
+    Util::Destructor(this);
+
+    pInstance->FreeMem(this);
+}
+
+// =====================================================================================================================
+// Reserves space for a command, replaying the stream first if it is full.
+void* DeviceGroupCmdStream::AllocCmd(
+    CmdType  type,
+    uint32_t deviceMask,
+    size_t   size)
+{
+    VK_ASSERT(size <= StreamSize);
+
+    if ((m_size + size) > StreamSize)
+    {
+        Replay();
+    }
+
+    CmdHeader* pHeader = reinterpret_cast<CmdHeader*>(m_pStream + m_size);
+
+    pHeader->type       = type;
+    pHeader->deviceMask = deviceMask;
+    pHeader->size       = static_cast<uint32_t>(size);
+
+    m_size += size;
+    m_cmdCount++;
+
+    return pHeader;
+}
+
+// =====================================================================================================================
+// Records a user data write.  The values of device i are read from pEntryValues + i * perDeviceStride bytes; they are
+// stored only once if they are the same on all devices of the mask.
+void DeviceGroupCmdStream::CmdSetUserData(
+    uint32_t               deviceMask,
+    Pal::PipelineBindPoint bindPoint,
+    uint32_t               firstEntry,
+    uint32_t               entryCount,
+    size_t                 perDeviceStride,
+    const uint32_t*        pEntryValues)
+{
+    const size_t valuesSize = entryCount * sizeof(uint32_t);
+
+    bool perDevice = false;
+
+    if (perDeviceStride != 0)
+    {
+        utils::IterateMask deviceGroup(deviceMask);
+        do
+        {
+            const void* pDeviceValues = Util::VoidPtrInc(pEntryValues, deviceGroup.Index() * perDeviceStride);
+
+            perDevice |= (memcmp(pDeviceValues, pEntryValues, valuesSize) != 0);
+        }
+        while ((perDevice == false) && deviceGroup.IterateNext());
+    }
+
+    const size_t cmdSize = sizeof(SetUserDataCmd) + (perDevice ? (valuesSize * m_deviceCount) : valuesSize);
+
+    SetUserDataCmd* pCmd = static_cast<SetUserDataCmd*>(AllocCmd(CmdType::SetUserData, deviceMask, cmdSize));
+
+    pCmd->bindPoint  = bindPoint;
+    pCmd->firstEntry = firstEntry;
+    pCmd->entryCount = entryCount;
+    pCmd->perDevice  = perDevice;
+
+    void* pValues = Util::VoidPtrInc(pCmd, sizeof(SetUserDataCmd));
+
+    if (perDevice)
+    {
+        utils::IterateMask deviceGroup(deviceMask);
+        do
+        {
+            const uint32_t deviceIdx = deviceGroup.Index();
+
+            memcpy(Util::VoidPtrInc(pValues, deviceIdx * valuesSize),
+                   Util::VoidPtrInc(pEntryValues, deviceIdx * perDeviceStride),
+                   valuesSize);
+        }
+        while (deviceGroup.IterateNext());
+    }
+    else
+    {
+        memcpy(pValues, pEntryValues, valuesSize);
+    }
+}
+
+// =====================================================================================================================
+void DeviceGroupCmdStream::CmdDraw(
+    uint32_t deviceMask,
+    uint32_t firstVertex,
+    uint32_t vertexCount,
+    uint32_t firstInstance,
+    uint32_t instanceCount,
+    uint32_t drawId)
+{
+    DrawCmd* pCmd = static_cast<DrawCmd*>(AllocCmd(CmdType::Draw, deviceMask, sizeof(DrawCmd)));
+
+    pCmd->firstVertex   = firstVertex;
+    pCmd->vertexCount   = vertexCount;
+    pCmd->firstInstance = firstInstance;
+    pCmd->instanceCount = instanceCount;
+    pCmd->drawId        = drawId;
+}
+
+// =====================================================================================================================
+void DeviceGroupCmdStream::CmdDrawIndexed(
+    uint32_t deviceMask,
+    uint32_t firstIndex,
+    uint32_t indexCount,
+    int32_t  vertexOffset,
+    uint32_t firstInstance,
+    uint32_t instanceCount,
+    uint32_t drawId)
+{
+    DrawIndexedCmd* pCmd =
+        static_cast<DrawIndexedCmd*>(AllocCmd(CmdType::DrawIndexed, deviceMask, sizeof(DrawIndexedCmd)));
+
+    pCmd->firstIndex    = firstIndex;
+    pCmd->indexCount    = indexCount;
+    pCmd->vertexOffset  = vertexOffset;
+    pCmd->firstInstance = firstInstance;
+    pCmd->instanceCount = instanceCount;
+    pCmd->drawId        = drawId;
+}
+
+// =====================================================================================================================
+void DeviceGroupCmdStream::CmdDispatch(
+    uint32_t deviceMask,
+    uint32_t x,
+    uint32_t y,
+    uint32_t z)
+{
+    DispatchCmd* pCmd = static_cast<DispatchCmd*>(AllocCmd(CmdType::Dispatch, deviceMask, sizeof(DispatchCmd)));
+
+    pCmd->x = x;
+    pCmd->y = y;
+    pCmd->z = z;
+}
+
+// =====================================================================================================================
+// Records the commands of the stream which apply to the given device into its PAL command buffer.
+void DeviceGroupCmdStream::ReplayDevice(
+    uint32_t deviceIdx
+    ) const
+{
+    Pal::ICmdBuffer* const pPalCmdBuffer = m_ppPalCmdBuffers[deviceIdx];
+    const uint32_t         deviceBit     = (1u << deviceIdx);
+
+    for (size_t offset = 0; offset < m_size; )
+    {
+        const CmdHeader* pHeader = reinterpret_cast<const CmdHeader*>(m_pStream + offset);
+
+        if ((pHeader->deviceMask & deviceBit) != 0)
+        {
+            switch (pHeader->type)
+            {
+            case CmdType::SetUserData:
+            {
+                const SetUserDataCmd* pCmd    = reinterpret_cast<const SetUserDataCmd*>(pHeader);
+                const uint32_t*       pValues = reinterpret_cast<const uint32_t*>(pCmd + 1);
+
+                if (pCmd->perDevice != 0)
+                {
+                    pValues += deviceIdx * pCmd->entryCount;
+                }
+
+                pPalCmdBuffer->CmdSetUserData(pCmd->bindPoint, pCmd->firstEntry, pCmd->entryCount, pValues);
+                break;
+            }
+            case CmdType::Draw:
+            {
+                const DrawCmd* pCmd = reinterpret_cast<const DrawCmd*>(pHeader);
+
+                pPalCmdBuffer->CmdDraw(pCmd->firstVertex,
+                                       pCmd->vertexCount,
+                                       pCmd->firstInstance,
+                                       pCmd->instanceCount,
+                                       pCmd->drawId);
+                break;
+            }
+            case CmdType::DrawIndexed:
+            {
+                const DrawIndexedCmd* pCmd = reinterpret_cast<const DrawIndexedCmd*>(pHeader);
+
+                pPalCmdBuffer->CmdDrawIndexed(pCmd->firstIndex,
+                                              pCmd->indexCount,
+                                              pCmd->vertexOffset,
+                                              pCmd->firstInstance,
+                                              pCmd->instanceCount,
+                                              pCmd->drawId);
+                break;
+            }
+            case CmdType::Dispatch:
+            {
+                const DispatchCmd* pCmd = reinterpret_cast<const DispatchCmd*>(pHeader);
+
+                pPalCmdBuffer->CmdDispatch(pCmd->x, pCmd->y, pCmd->z);
+                break;
+            }
+            default:
+                VK_NEVER_CALLED();
+                break;
+            }
+        }
+
+        offset += pHeader->size;
+    }
+}
+
+// =====================================================================================================================
+void DeviceGroupCmdStream::ReplayTask(
+    void*    pPayload,
+    uint32_t taskIndex)
+{
+    static_cast<const DeviceGroupCmdStream*>(pPayload)->ReplayDevice(taskIndex);
+}
+
+// =====================================================================================================================
+// Records all pending commands into the PAL command buffers and empties the stream.  The devices' PAL command buffers
+// are independent, so each one can be built by a different thread.
+void DeviceGroupCmdStream::Replay()
+{
+    if ((m_pThreadPool != nullptr) && (m_cmdCount >= MinParallelCmds))
+    {
+        m_pThreadPool->Execute(ReplayTask, this, m_deviceCount);
+    }
+    else
+    {
+        for (uint32_t deviceIdx = 0; deviceIdx < m_deviceCount; deviceIdx++)
+        {
+            ReplayDevice(deviceIdx);
+        }
+    }
+
+    Discard();
+}
+
+} // namespace vk
@@ -33,6 +33,7 @@
 // Vulkan headers
 #include "devmode/devmode_mgr.h"
 #include "include/vk_cmdbuffer.h"
+#include "include/vk_device.h"
 #include "include/vk_instance.h"
 #include "include/vk_pipeline.h"
 #include "include/vk_physical_device.h"
@@ -59,6 +60,7 @@
 #include "protocols/driverControlServer.h"
 #include "protocols/ddPipelineUriService.h"
 #include "protocols/ddEventServer.h"
+#include "ddUriInterface.h"
 
 #if VKI_GPUOPEN_PROTOCOL_ETW_CLIENT
 #include "protocols/etwClient.h"
@@ -127,6 +129,121 @@ static Pal::Result DevDriverToPalResult(
     return result;
 }
 
+// =====================================================================================================================
+// Answers requests for the "perfcounters" URI with a JSON snapshot of the driver performance counters of the device
+// which registered last.  The layout matches what PerfCounterRegistry::Write() puts into PerfCountersFile.
+class PerfCounterUriService : public DevDriver::IService
+{
+public:
+    PerfCounterUriService() : m_pRegistry(nullptr) { }
+
+    virtual ~PerfCounterUriService() { }
+
+    virtual const char* GetName() const override { return "perfcounters"; }
+
+    virtual DevDriver::Version GetVersion() const override { return 1; }
+
+    virtual DevDriver::Result HandleRequest(DevDriver::IURIRequestContext* pContext) override;
+
+    void SetRegistry(PerfCounterRegistry* pRegistry)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        m_pRegistry = pRegistry;
+    }
+
+    // Stops serving the counters of a registry which is about to be destroyed
+    void ClearRegistry(PerfCounterRegistry* pRegistry)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        if (m_pRegistry == pRegistry)
+        {
+            m_pRegistry = nullptr;
+        }
+    }
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(PerfCounterUriService);
+
+    Util::Mutex          m_lock;       // Keeps the registry alive while a request reads it
+    PerfCounterRegistry* m_pRegistry;
+};
+
+// =====================================================================================================================
+DevDriver::Result PerfCounterUriService::HandleRequest(
+    DevDriver::IURIRequestContext* pContext)
+{
+    DevDriver::Result result = DevDriver::Result::Unavailable;
+
+    PerfCounterSnapshot snapshot;
+
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        if (m_pRegistry != nullptr)
+        {
+            m_pRegistry->Read(&snapshot);
+
+            result = DevDriver::Result::Success;
+        }
+    }
+
+    DevDriver::IStructuredWriter* pWriter = nullptr;
+
+    if (result == DevDriver::Result::Success)
+    {
+        result = pContext->BeginJsonResponse(&pWriter);
+    }
+
+    if (result == DevDriver::Result::Success)
+    {
+        pWriter->BeginMap();
+
+        for (uint32_t counter = 0; counter < PerfCounterCount; counter++)
+        {
+            pWriter->Key(PerfCounterRegistry::GetName(static_cast<PerfCounter>(counter)));
+            pWriter->Value(snapshot.counters[counter]);
+        }
+
+        for (uint32_t histogram = 0; histogram < PerfHistogramCount; histogram++)
+        {
+            const PerfCounterSnapshot::Histogram& data = snapshot.histograms[histogram];
+
+            pWriter->Key(PerfCounterRegistry::GetName(static_cast<PerfHistogram>(histogram)));
+            pWriter->BeginMap();
+            pWriter->Key("count");
+            pWriter->Value(data.count);
+            pWriter->Key("sum");
+            pWriter->Value(data.sum);
+            pWriter->Key("buckets");
+            pWriter->BeginList();
+
+            for (uint32_t bucket = 0; bucket < PerfCounterSnapshot::BucketCount; bucket++)
+            {
+                if (data.buckets[bucket] > 0)
+                {
+                    pWriter->BeginMap();
+                    pWriter->Key("upTo");
+                    pWriter->Value(PerfCounterRegistry::GetBucketUpperBound(bucket));
+                    pWriter->Key("count");
+                    pWriter->Value(data.buckets[bucket]);
+                    pWriter->EndMap();
+                }
+            }
+
+            pWriter->EndList();
+            pWriter->EndMap();
+        }
+
+        pWriter->EndMap();
+
+        result = pWriter->End();
+    }
+
+    return result;
+}
+
 // =====================================================================================================================
 // Callback method for providing hashes and sizes for tracked pipelines to the PipelineUriService
 static DevDriver::Result GetPipelineHashes(
@@ -316,6 +433,7 @@ DevModeMgr::DevModeMgr(Instance* pInstance)
     m_pDevDriverServer(pInstance->PalPlatform()->GetDevDriverServer()),
     m_pRGPServer(nullptr),
     m_pPipelineUriService(nullptr),
+    m_pPerfCounterUriService(nullptr),
 #if VKI_GPUOPEN_PROTOCOL_ETW_CLIENT
     m_pEtwClient(nullptr),
 #endif
@@ -339,12 +457,21 @@ DevModeMgr::DevModeMgr(Instance* pInstance)
     m_pipelineCaches(pInstance->Allocator())
 {
     memset(&m_trace, 0, sizeof(m_trace));
+    memset(&m_spikeTrigger, 0, sizeof(m_spikeTrigger));
 }
 
 // =====================================================================================================================
 DevModeMgr::~DevModeMgr()
 {
     DestroyRGPTracing(&m_trace);
+
+    if (m_pPerfCounterUriService != nullptr)
+    {
+        m_pDevDriverServer->GetMessageChannel()->UnregisterService(m_pPerfCounterUriService);
+
+        Util::Destructor(m_pPerfCounterUriService);
+        m_pInstance->FreeMem(m_pPerfCounterUriService);
+    }
 }
 
 // =====================================================================================================================
@@ -485,6 +612,12 @@ void DevModeMgr::NotifyFrameEnd(
                         VK_ASSERT(result == Pal::Result::Success);
                     }
 
+                    // Track frame times while a spike-triggered trace is armed.
+                    if (m_trace.status == TraceStatus::Pending)
+                    {
+                        UpdateSpikeTrigger(pQueue->VkDevice()->GetRuntimeSettings());
+                    }
+
                     // Increment trace frame counters.  These control when the trace can transition
                     if (m_trace.status == TraceStatus::Preparing)
                     {
@@ -502,6 +635,62 @@ void DevModeMgr::NotifyFrameEnd(
     }
 
     m_globalFrameIndex++;
+
+    // Publish periodic pipeline compile stats snapshots while developer mode is active.
+    const RuntimeSettings& settings = pQueue->VkDevice()->GetRuntimeSettings();
+
+    if (settings.dumpPipelineCompileStats                  &&
+        (settings.pipelineCompileStatsDumpInterval > 0)    &&
+        (delimiterType == FrameDelimiterType::QueuePresent) &&
+        ((m_globalFrameIndex % settings.pipelineCompileStatsDumpInterval) == 0))
+    {
+        pQueue->VkDevice()->GetCompiler(DefaultDeviceIndex)->WriteCompileStats(settings.pipelineCompileStatsFile);
+    }
+
+    // Likewise for the descriptor pool memory stats.
+    if (settings.dumpDescriptorPoolStats                   &&
+        (settings.descriptorPoolStatsDumpInterval > 0)     &&
+        (delimiterType == FrameDelimiterType::QueuePresent) &&
+        ((m_globalFrameIndex % settings.descriptorPoolStatsDumpInterval) == 0))
+    {
+        pQueue->VkDevice()->WriteDescriptorPoolStats(settings.descriptorPoolStatsFile);
+    }
+
+    // And for the submission stats of the presenting queue.
+    if (settings.enableQueueSubmitStats                    &&
+        (settings.queueSubmitStatsDumpInterval > 0)        &&
+        (delimiterType == FrameDelimiterType::QueuePresent) &&
+        ((m_globalFrameIndex % settings.queueSubmitStatsDumpInterval) == 0))
+    {
+        pQueue->WriteSubmitStats(settings.queueSubmitStatsFile);
+    }
+
+    // And for the GPU time per debug label.
+    if (settings.enableGpuTimingTable                      &&
+        (settings.gpuTimingTableDumpInterval > 0)          &&
+        (delimiterType == FrameDelimiterType::QueuePresent) &&
+        ((m_globalFrameIndex % settings.gpuTimingTableDumpInterval) == 0))
+    {
+        pQueue->VkDevice()->WriteGpuTimingTable(settings.gpuTimingTableFile);
+    }
+
+    // And for the per-pipeline statistics.
+    if (settings.enablePipelineStatsProfile                 &&
+        (settings.pipelineStatsProfileDumpInterval > 0)     &&
+        (delimiterType == FrameDelimiterType::QueuePresent) &&
+        ((m_globalFrameIndex % settings.pipelineStatsProfileDumpInterval) == 0))
+    {
+        pQueue->VkDevice()->WritePipelineStatsProfile(settings.pipelineStatsProfileFile);
+    }
+
+    // And for the barrier costs.
+    if (settings.enableBarrierProfile                       &&
+        (settings.barrierProfileDumpInterval > 0)           &&
+        (delimiterType == FrameDelimiterType::QueuePresent) &&
+        ((m_globalFrameIndex % settings.barrierProfileDumpInterval) == 0))
+    {
+        pQueue->VkDevice()->WriteBarrierProfile(settings.barrierProfileFile);
+    }
 }
 
 // =====================================================================================================================
@@ -973,6 +1162,12 @@ void DevModeMgr::TraceIdleToPendingStep(
                 m_traceFrameEndTag   = settings.devModeSqttTraceEndTagValue;
             }
 
+            // Optionally hold present-triggered traces until a frame-time spike is seen.  Frame history is collected
+            // from scratch so that the frames preceding the request don't count towards the average.
+            memset(&m_spikeTrigger, 0, sizeof(m_spikeTrigger));
+
+            m_spikeTrigger.armed = settings.devModeSqttSpikeTriggerEnable && (m_triggerMode == TriggerMode::Present);
+
             // Reset trace device status
             pState->preparedFrameCount = 0;
             pState->sqttFrameCount     = 0;
@@ -981,6 +1176,47 @@ void DevModeMgr::TraceIdleToPendingStep(
     }
 }
 
+// =====================================================================================================================
+// Records the CPU time of the frame that just ended while a spike-triggered trace is armed, and flags a spike once the
+// frame history is full and a frame takes longer than both the absolute threshold and a multiple of the average.
+//
+// Must be called with the trace mutex held.
+void DevModeMgr::UpdateSpikeTrigger(
+    const RuntimeSettings& settings)
+{
+    if (m_spikeTrigger.armed && (m_spikeTrigger.detected == false))
+    {
+        const int64_t now = Util::GetPerfCpuTime();
+
+        if (m_spikeTrigger.lastFrameEndTicks != 0)
+        {
+            const int64_t frameTicks = now - m_spikeTrigger.lastFrameEndTicks;
+
+            if (m_spikeTrigger.frameCount == SpikeHistoryFrameCount)
+            {
+                const double averageTicks = static_cast<double>(m_spikeTrigger.frameTicksSum) / SpikeHistoryFrameCount;
+                const double minTicks     = static_cast<double>(settings.devModeSqttSpikeMinFrameTimeMs) *
+                                            static_cast<double>(Util::GetPerfFrequency()) / 1000.0;
+
+                m_spikeTrigger.detected = (frameTicks >= minTicks) &&
+                                          (frameTicks >= (averageTicks * settings.devModeSqttSpikeFactor));
+
+                m_spikeTrigger.frameTicksSum -= m_spikeTrigger.frameTicks[m_spikeTrigger.nextFrame];
+            }
+            else
+            {
+                m_spikeTrigger.frameCount++;
+            }
+
+            m_spikeTrigger.frameTicks[m_spikeTrigger.nextFrame] = frameTicks;
+            m_spikeTrigger.frameTicksSum                       += frameTicks;
+            m_spikeTrigger.nextFrame = (m_spikeTrigger.nextFrame + 1) % SpikeHistoryFrameCount;
+        }
+
+        m_spikeTrigger.lastFrameEndTicks = now;
+    }
+}
+
 // =====================================================================================================================
 // This function starts preparing for an RGP trace.  Preparation involves some N frames of lead-up time during which
 // timing samples are accumulated to synchronize CPU and GPU clock domains.
@@ -1002,6 +1238,12 @@ Pal::Result DevModeMgr::TracePendingToPreparingStep(
         return Pal::Result::Success;
     }
 
+    // In spike trigger mode the trace stays armed until a frame exceeds the spike threshold
+    if (m_spikeTrigger.armed && (m_spikeTrigger.detected == false))
+    {
+        return Pal::Result::Success;
+    }
+
     // If we're presenting from a compute queue and the trace parameters indicate that we want to support
     // compute queue presents, then we need to enable sample updates for this trace.  Mid-trace sample updates
     // allow us to capture a smaller set of trace data as the preparation frames run, then change the sqtt
@@ -2353,6 +2595,11 @@ void DevModeMgr::PostDeviceCreate(Device* pDevice)
     {
         pDriverControlServer->FinishDeviceInit();
     }
+
+    if (pDevice->GetPerfCounters()->IsEnabled())
+    {
+        RegisterPerfCounters(pDevice->GetPerfCounters());
+    }
 }
 
 // =====================================================================================================================
@@ -2366,6 +2613,11 @@ void DevModeMgr::PreDeviceDestroy(Device* pDevice)
         // Free trace resources
         CheckTraceDeviceChanged(&m_trace, nullptr);
     }
+
+    if (m_pPerfCounterUriService != nullptr)
+    {
+        m_pPerfCounterUriService->ClearRegistry(pDevice->GetPerfCounters());
+    }
 }
 
 // =====================================================================================================================
@@ -2691,6 +2943,39 @@ void DevModeMgr::CleanupEtwClient()
 }
 #endif
 
+// =====================================================================================================================
+// Serves the perf counters of a device under the "perfcounters" URI, registering the service with the message channel
+// the first time.  Only one device is served at a time; a later device takes over.
+void DevModeMgr::RegisterPerfCounters(
+    PerfCounterRegistry* pRegistry)
+{
+    if (m_pPerfCounterUriService == nullptr)
+    {
+        void* pStorage = m_pInstance->AllocMem(sizeof(PerfCounterUriService), VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
+
+        if (pStorage != nullptr)
+        {
+            PerfCounterUriService* pService = VK_PLACEMENT_NEW(pStorage) PerfCounterUriService();
+
+            if (m_pDevDriverServer->GetMessageChannel()->RegisterService(pService) == DevDriver::Result::Success)
+            {
+                m_pPerfCounterUriService = pService;
+            }
+            else
+            {
+                Util::Destructor(pService);
+                m_pInstance->FreeMem(pStorage);
+            }
+        }
+    }
+
+    // Counters are optional, so failing to serve them is not an error.
+    if (m_pPerfCounterUriService != nullptr)
+    {
+        m_pPerfCounterUriService->SetRegistry(pRegistry);
+    }
+}
+
 // =====================================================================================================================
 // Registers a pipeline binary cache object with the pipeline URI service and initializes the pipeline URI service
 // the first time a pipeline binary cache object is registered
@@ -105,6 +105,8 @@ class Queue;
 class SqttCmdBufferState;
 class CmdBuffer;
 class PipelineBinaryCache;
+class PerfCounterRegistry;
+class PerfCounterUriService;
 };
 
 namespace vk
@@ -295,6 +297,7 @@ private:
 
     void AdvanceActiveTraceStep(TraceState* pState, const Queue* pQueue, bool beginFrame, FrameDelimiterType delimiterType);
     void TraceIdleToPendingStep(TraceState* pState);
+    void UpdateSpikeTrigger(const RuntimeSettings& settings);
     Pal::Result TracePendingToPreparingStep(TraceState* pState, const Queue* pQueue, FrameDelimiterType delimiterType);
     Pal::Result TracePreparingToRunningStep(TraceState* pState, const Queue* pQueue);
     Pal::Result TraceRunningToWaitingForSqttStep(TraceState* pState, const Queue* pQueue);
@@ -312,6 +315,8 @@ private:
     TraceQueueState* FindTraceQueueState(TraceState* pState, const Queue* pQueue);
     bool QueueSupportsTiming(uint32_t deviceIdx, const Queue* pQueue);
 
+    void RegisterPerfCounters(PerfCounterRegistry* pRegistry);
+
 #if VKI_GPUOPEN_PROTOCOL_ETW_CLIENT
     Pal::Result InitEtwClient();
     void CleanupEtwClient();
@@ -321,6 +326,7 @@ private:
     DevDriver::DevDriverServer*         m_pDevDriverServer;
     DevDriver::RGPProtocol::RGPServer*  m_pRGPServer;
     DevDriver::PipelineUriService*      m_pPipelineUriService;
+    PerfCounterUriService*              m_pPerfCounterUriService;   // Serves the perf counters of a device
 #if VKI_GPUOPEN_PROTOCOL_ETW_CLIENT
     DevDriver::ETWProtocol::ETWClient*  m_pEtwClient;               // ETW client pointer used to collect gpu
                                                                     // events for RGP
@@ -346,6 +352,20 @@ private:
     uint64_t                            m_perfCounterMemLimit;      // Memory limit for perf counters
     uint32_t                            m_perfCounterFrequency;     // Counter sample frequency
 
+    // Frame-time spike trigger state (see DevModeSqttSpikeTriggerEnable).  Only updated while a trace is Pending.
+    static constexpr uint32_t SpikeHistoryFrameCount = 64;
+
+    struct
+    {
+        bool     armed;                                    // The pending trace waits for a frame-time spike
+        bool     detected;                                 // A spike frame was seen; the trace may proceed
+        int64_t  lastFrameEndTicks;                        // CPU time of the previous frame-end delimiter
+        int64_t  frameTicks[SpikeHistoryFrameCount];       // Ring of the most recent CPU frame times
+        int64_t  frameTicksSum;                            // Sum of the valid entries in frameTicks
+        uint32_t frameCount;                               // Number of valid entries in frameTicks
+        uint32_t nextFrame;                                // Ring index the next frame time is written to
+    } m_spikeTrigger;
+
     using PerfCounterList = Util::Vector<GpuUtil::PerfCounterId, 8, PalAllocator>;
 
     PerfCounterList                     m_perfCounterIds;           // List of perf counter ids
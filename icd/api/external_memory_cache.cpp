@@ -0,0 +1,319 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  external_memory_cache.cpp
+* @brief Implementation of the per-device cache of imported external memory handles.
+***********************************************************************************************************************
+*/
+#include "include/external_memory_cache.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+
+#include "palSysUtil.h"
+
+#if defined(__unix__)
+#include <sys/stat.h>
+#endif
+
+namespace vk
+{
+
+// =====================================================================================================================
+ExternalMemoryCache::ExternalMemoryCache(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_enabled(false),
+    m_maxUnused(0),
+    m_maxAgeTicks(0),
+    m_unusedCount(0),
+    m_pFirstImport(nullptr)
+{
+}
+
+// =====================================================================================================================
+void ExternalMemoryCache::Init()
+{
+    const RuntimeSettings& settings = m_pDevice->GetRuntimeSettings();
+
+    m_enabled     = settings.enableExternalMemoryImportCache;
+    m_maxUnused   = settings.externalMemoryImportCacheSize;
+    m_maxAgeTicks = (static_cast<uint64_t>(settings.externalMemoryImportCacheMaxAge) * Util::GetPerfFrequency()) / 1000;
+}
+
+// =====================================================================================================================
+// Closes every import.  Imports still used by memory objects the application leaked are closed too.
+void ExternalMemoryCache::Destroy()
+{
+    Util::MutexAuto lock(&m_lock);
+
+    while (m_pFirstImport != nullptr)
+    {
+        ExternalMemoryImport* pImport = m_pFirstImport;
+
+        m_pFirstImport = pImport->pNext;
+
+        DestroyImport(pImport);
+    }
+
+    m_unusedCount = 0;
+}
+
+// =====================================================================================================================
+// Fills in the key of the allocation an external handle refers to.  Every fd of a dma-buf refers to the same file, so
+// its device and inode identify the allocation; the inode can't be reused while an import keeps the dma-buf alive.
+// Returns false if the handle can't be identified.
+bool ExternalMemoryCache::MakeKey(
+    Pal::OsExternalHandle handle,
+    uint64_t              imageHash,
+    ExternalMemoryKey*    pKey)
+{
+    bool success = false;
+
+    memset(pKey, 0, sizeof(*pKey));
+
+    pKey->imageHash = imageHash;
+
+#if defined(__unix__)
+    struct stat fileStat = {};
+
+    if (fstat(static_cast<int>(handle), &fileStat) == 0)
+    {
+        pKey->device = static_cast<uint64_t>(fileStat.st_dev);
+        pKey->object = static_cast<uint64_t>(fileStat.st_ino);
+        success      = true;
+    }
+#else
+    pKey->object = static_cast<uint64_t>(handle);
+    success      = true;
+#endif
+
+    return success;
+}
+
+// =====================================================================================================================
+// Returns an open import of the allocation with the given key and adds a reference to it, or null if there is none.
+ExternalMemoryImport* ExternalMemoryCache::Acquire(
+    const ExternalMemoryKey& key)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    ExternalMemoryImport* pImport = m_pFirstImport;
+
+    while ((pImport != nullptr) && (memcmp(&pImport->key, &key, sizeof(key)) != 0))
+    {
+        pImport = pImport->pNext;
+    }
+
+    if (pImport != nullptr)
+    {
+        if (pImport->refCount == 0)
+        {
+            m_unusedCount--;
+        }
+
+        pImport->refCount++;
+    }
+
+    return pImport;
+}
+
+// =====================================================================================================================
+// Allocates an import with room for palObjectSize bytes of PAL objects at GetPalStorage().  The caller opens the
+// handle into that storage and then either adds the import to the cache or frees it.  Returns null if out of memory.
+ExternalMemoryImport* ExternalMemoryCache::CreateImport(
+    const ExternalMemoryKey& key,
+    size_t                   palObjectSize)
+{
+    ExternalMemoryImport* pImport = static_cast<ExternalMemoryImport*>(m_pDevice->VkInstance()->AllocMem(
+        sizeof(ExternalMemoryImport) + palObjectSize,
+        VK_DEFAULT_MEM_ALIGN,
+        VK_SYSTEM_ALLOCATION_SCOPE_DEVICE));
+
+    if (pImport != nullptr)
+    {
+        memset(pImport, 0, sizeof(*pImport));
+
+        pImport->key = key;
+    }
+
+    return pImport;
+}
+
+// =====================================================================================================================
+// Adds an import whose PAL objects were opened and put on the residency list to the cache.  The cache takes over the
+// PAL objects and the residency reference; the caller holds the first reference.
+void ExternalMemoryCache::AddImport(
+    ExternalMemoryImport* pImport)
+{
+    VK_ASSERT(pImport->pGpuMemory != nullptr);
+
+    Util::MutexAuto lock(&m_lock);
+
+    pImport->refCount = 1;
+    pImport->pNext    = m_pFirstImport;
+
+    m_pFirstImport = pImport;
+}
+
+// =====================================================================================================================
+// Frees an import which was never added to the cache, e.g. because the handle could not be opened.
+void ExternalMemoryCache::FreeImport(
+    ExternalMemoryImport* pImport)
+{
+    m_pDevice->VkInstance()->FreeMem(pImport);
+}
+
+// =====================================================================================================================
+// Drops a reference to an import.  An import nothing uses anymore stays open for a while if the cache has room for it.
+void ExternalMemoryCache::Release(
+    ExternalMemoryImport* pImport)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    VK_ASSERT(pImport->refCount > 0);
+
+    pImport->refCount--;
+
+    if (pImport->refCount == 0)
+    {
+        pImport->releaseTime = Util::GetPerfCpuTime();
+
+        m_unusedCount++;
+
+        EvictUnused(pImport->releaseTime);
+    }
+}
+
+// =====================================================================================================================
+// Maps the PAL memory of an import, or returns the address of the existing mapping of another memory object.
+Pal::Result ExternalMemoryCache::Map(
+    ExternalMemoryImport* pImport,
+    void**                ppData)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    Pal::Result result = Pal::Result::Success;
+
+    if (pImport->mapCount == 0)
+    {
+        result = pImport->pGpuMemory->Map(&pImport->pMappedData);
+    }
+
+    if (result == Pal::Result::Success)
+    {
+        pImport->mapCount++;
+
+        *ppData = pImport->pMappedData;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Unmaps the PAL memory of an import once no memory object has it mapped anymore.
+void ExternalMemoryCache::Unmap(
+    ExternalMemoryImport* pImport)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    VK_ASSERT(pImport->mapCount > 0);
+
+    pImport->mapCount--;
+
+    if (pImport->mapCount == 0)
+    {
+        const Pal::Result result = pImport->pGpuMemory->Unmap();
+        VK_ASSERT(result == Pal::Result::Success);
+
+        pImport->pMappedData = nullptr;
+    }
+}
+
+// =====================================================================================================================
+// Closes the unused imports which have expired and then the oldest ones until the number of unused imports is within
+// the limit.
+//
+// WARNING: This function is NOT thread-safe and assumes the caller is holding m_lock.
+void ExternalMemoryCache::EvictUnused(
+    uint64_t now)
+{
+    bool evicted = true;
+
+    while (evicted)
+    {
+        ExternalMemoryImport** ppOldest = nullptr;
+
+        for (ExternalMemoryImport** ppImport = &m_pFirstImport; *ppImport != nullptr; ppImport = &(*ppImport)->pNext)
+        {
+            if (((*ppImport)->refCount == 0) &&
+                ((ppOldest == nullptr) || ((*ppImport)->releaseTime < (*ppOldest)->releaseTime)))
+            {
+                ppOldest = ppImport;
+            }
+        }
+
+        evicted = (ppOldest != nullptr) &&
+                  ((m_unusedCount > m_maxUnused) || ((now - (*ppOldest)->releaseTime) > m_maxAgeTicks));
+
+        if (evicted)
+        {
+            ExternalMemoryImport* pOldest = *ppOldest;
+
+            *ppOldest = pOldest->pNext;
+
+            m_unusedCount--;
+
+            DestroyImport(pOldest);
+        }
+    }
+}
+
+// =====================================================================================================================
+// Takes the PAL objects of an import off the residency list, destroys them and frees the import.
+//
+// WARNING: This function is NOT thread-safe and assumes the caller is holding m_lock.
+void ExternalMemoryCache::DestroyImport(
+    ExternalMemoryImport* pImport)
+{
+    if (pImport->mapCount > 0)
+    {
+        pImport->pGpuMemory->Unmap();
+    }
+
+    if (pImport->pImage != nullptr)
+    {
+        pImport->pImage->Destroy();
+    }
+
+    m_pDevice->RemoveMemReference(m_pDevice->PalDevice(DefaultDeviceIndex), pImport->pGpuMemory);
+
+    pImport->pGpuMemory->Destroy();
+
+    m_pDevice->VkInstance()->FreeMem(pImport);
+}
+
+} // namespace vk
@@ -0,0 +1,336 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  gpu_address_index.cpp
+* @brief Implementation of the optional index from GPU virtual addresses to the buffers and images bound there.
+***********************************************************************************************************************
+*/
+
+#include "include/gpu_address_index.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+
+#include <algorithm>
+
+namespace vk
+{
+
+// =====================================================================================================================
+GpuAddressIndex::GpuAddressIndex(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_enabled(false),
+    m_serial(0),
+    m_pEntries(nullptr),
+    m_entryCount(0),
+    m_pPending(nullptr),
+    m_pendingCount(0),
+    m_pendingCapacity(0),
+    m_pRemovals(nullptr),
+    m_removalCount(0),
+    m_removalCapacity(0)
+{
+}
+
+// =====================================================================================================================
+void GpuAddressIndex::Init()
+{
+    m_enabled = m_pDevice->GetRuntimeSettings().enableGpuAddressIndex;
+}
+
+// =====================================================================================================================
+// Frees all ranges.  No thread may insert, remove or look up ranges anymore.
+void GpuAddressIndex::Destroy()
+{
+    Instance* pInstance = m_pDevice->VkInstance();
+
+    m_enabled = false;
+
+    pInstance->FreeMem(m_pEntries);
+    pInstance->FreeMem(m_pPending);
+    pInstance->FreeMem(m_pRemovals);
+
+    m_pEntries        = nullptr;
+    m_entryCount      = 0;
+    m_pPending        = nullptr;
+    m_pendingCount    = 0;
+    m_pendingCapacity = 0;
+    m_pRemovals       = nullptr;
+    m_removalCount    = 0;
+    m_removalCapacity = 0;
+}
+
+// =====================================================================================================================
+// Makes room for count elements in one of the unsorted lists.  Returns false if out of memory.
+template<typename T>
+bool GpuAddressIndex::Reserve(
+    T**       ppArray,
+    uint32_t* pCapacity,
+    uint32_t  count)
+{
+    bool success = true;
+
+    if (count > *pCapacity)
+    {
+        const uint32_t newCapacity = Util::Max(*pCapacity * 2, 256u);
+
+        T* pNewArray = static_cast<T*>(m_pDevice->VkInstance()->AllocMem(
+            sizeof(T) * newCapacity, VK_DEFAULT_MEM_ALIGN, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE));
+
+        if (pNewArray != nullptr)
+        {
+            if (*ppArray != nullptr)
+            {
+                memcpy(pNewArray, *ppArray, sizeof(T) * *pCapacity);
+
+                m_pDevice->VkInstance()->FreeMem(*ppArray);
+            }
+
+            *ppArray   = pNewArray;
+            *pCapacity = newCapacity;
+        }
+        else
+        {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Records the range of a buffer or image bind.  A range which cannot be recorded for lack of memory is not found.
+void GpuAddressIndex::InsertRange(
+    const void*  pObject,
+    VkObjectType objectType,
+    Pal::gpusize gpuVirtAddr,
+    Pal::gpusize size)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    if (Reserve(&m_pPending, &m_pendingCapacity, m_pendingCount + 1))
+    {
+        Entry* pEntry = &m_pPending[m_pendingCount++];
+
+        pEntry->range.gpuVirtAddr = gpuVirtAddr;
+        pEntry->range.size        = size;
+        pEntry->range.pObject     = pObject;
+        pEntry->range.objectType  = objectType;
+        pEntry->maxEnd            = 0;
+        pEntry->serial            = m_serial++;
+
+        if ((m_pendingCount + m_removalCount) >= Util::Max(m_entryCount, MinMergeThreshold))
+        {
+            Merge();
+        }
+    }
+}
+
+// =====================================================================================================================
+// Forgets the ranges recorded for a buffer or image which is being destroyed.
+void GpuAddressIndex::RemoveObject(
+    const void* pObject)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    if (Reserve(&m_pRemovals, &m_removalCapacity, m_removalCount + 1))
+    {
+        Removal* pRemoval = &m_pRemovals[m_removalCount++];
+
+        pRemoval->pObject = pObject;
+        pRemoval->serial  = m_serial++;
+
+        if ((m_pendingCount + m_removalCount) >= Util::Max(m_entryCount, MinMergeThreshold))
+        {
+            Merge();
+        }
+    }
+    else
+    {
+        // Without a removal record, empty the ranges of the object in place.  Empty ranges never contain an address,
+        // and a stale maxEnd only makes lookups walk a little further.
+        for (uint32_t i = 0; i < m_entryCount; ++i)
+        {
+            if (m_pEntries[i].range.pObject == pObject)
+            {
+                m_pEntries[i].range.size = 0;
+            }
+        }
+
+        for (uint32_t i = 0; i < m_pendingCount; ++i)
+        {
+            if (m_pPending[i].range.pObject == pObject)
+            {
+                m_pPending[i].range.size = 0;
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Returns true if the object of an entry was destroyed after the entry was inserted.  The removals must be sorted.
+bool GpuAddressIndex::IsRemoved(
+    const Entry& entry) const
+{
+    const Removal* pRemoval = std::lower_bound(m_pRemovals, m_pRemovals + m_removalCount, entry.range.pObject,
+        [](const Removal& removal, const void* pObject)
+        {
+            return (reinterpret_cast<uintptr_t>(removal.pObject) < reinterpret_cast<uintptr_t>(pObject));
+        });
+
+    bool removed = false;
+
+    while ((pRemoval != (m_pRemovals + m_removalCount)) &&
+           (pRemoval->pObject == entry.range.pObject) &&
+           (removed == false))
+    {
+        removed = (pRemoval->serial > entry.serial);
+
+        pRemoval++;
+    }
+
+    return removed;
+}
+
+// =====================================================================================================================
+// Sorts the ranges inserted since the last merge into the array and drops the ranges of destroyed objects.  Must be
+// called with m_lock held.  Returns false if out of memory, in which case nothing changes.
+bool GpuAddressIndex::Merge()
+{
+    bool success = true;
+
+    if ((m_pendingCount > 0) || (m_removalCount > 0))
+    {
+        const uint32_t maxCount = m_entryCount + m_pendingCount;
+
+        Entry* pMerged = nullptr;
+
+        if (maxCount > 0)
+        {
+            pMerged = static_cast<Entry*>(m_pDevice->VkInstance()->AllocMem(
+                sizeof(Entry) * maxCount, VK_DEFAULT_MEM_ALIGN, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE));
+
+            success = (pMerged != nullptr);
+        }
+
+        if (success)
+        {
+            std::sort(m_pPending, m_pPending + m_pendingCount,
+                [](const Entry& lhs, const Entry& rhs)
+                {
+                    return (lhs.range.gpuVirtAddr < rhs.range.gpuVirtAddr);
+                });
+
+            std::sort(m_pRemovals, m_pRemovals + m_removalCount,
+                [](const Removal& lhs, const Removal& rhs)
+                {
+                    return (reinterpret_cast<uintptr_t>(lhs.pObject) < reinterpret_cast<uintptr_t>(rhs.pObject));
+                });
+
+            Pal::gpusize maxEnd     = 0;
+            uint32_t     count      = 0;
+            uint32_t     entryIdx   = 0;
+            uint32_t     pendingIdx = 0;
+
+            while ((entryIdx < m_entryCount) || (pendingIdx < m_pendingCount))
+            {
+                const bool takeEntry = (pendingIdx == m_pendingCount) ||
+                                       ((entryIdx < m_entryCount) &&
+                                        (m_pEntries[entryIdx].range.gpuVirtAddr <=
+                                         m_pPending[pendingIdx].range.gpuVirtAddr));
+
+                const Entry& entry = takeEntry ? m_pEntries[entryIdx++] : m_pPending[pendingIdx++];
+
+                if (IsRemoved(entry) == false)
+                {
+                    maxEnd = Util::Max(maxEnd, entry.range.gpuVirtAddr + entry.range.size);
+
+                    pMerged[count]        = entry;
+                    pMerged[count].maxEnd = maxEnd;
+
+                    count++;
+                }
+            }
+
+            m_pDevice->VkInstance()->FreeMem(m_pEntries);
+
+            m_pEntries     = pMerged;
+            m_entryCount   = count;
+            m_pendingCount = 0;
+            m_removalCount = 0;
+        }
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Finds the buffers and images bound at a GPU virtual address of the default device.  Up to maxRanges of them are
+// written to pRanges, highest start address first.  Returns the number of ranges containing the address, which
+// may be larger than maxRanges.
+uint32_t GpuAddressIndex::Find(
+    Pal::gpusize     gpuVirtAddr,
+    uint32_t         maxRanges,
+    GpuAddressRange* pRanges)
+{
+    uint32_t count = 0;
+
+    if (m_enabled)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        if (Merge())
+        {
+            // Every entry at or after the first one starting above the address can be skipped, and the walk back can
+            // stop at the first entry none of whose predecessors ends above the address.
+            const Entry* pEntry = std::upper_bound(m_pEntries, m_pEntries + m_entryCount, gpuVirtAddr,
+                [](Pal::gpusize addr, const Entry& entry)
+                {
+                    return (addr < entry.range.gpuVirtAddr);
+                });
+
+            while ((pEntry != m_pEntries) && (pEntry[-1].maxEnd > gpuVirtAddr))
+            {
+                pEntry--;
+
+                if (gpuVirtAddr < (pEntry->range.gpuVirtAddr + pEntry->range.size))
+                {
+                    if (count < maxRanges)
+                    {
+                        pRanges[count] = pEntry->range;
+                    }
+
+                    count++;
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+} // namespace vk
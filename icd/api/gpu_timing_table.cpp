@@ -0,0 +1,370 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  gpu_timing_table.cpp
+* @brief Implementation of the always-on GPU timing of command buffers and debug label regions.
+***********************************************************************************************************************
+*/
+#include "include/gpu_timing_table.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+
+#include "palCmdBuffer.h"
+#include "palInlineFuncs.h"
+#include "palJsonWriter.h"
+
+#include <string.h>
+
+namespace vk
+{
+
+// =====================================================================================================================
+GpuTimingTable* GpuTimingTable::Create(
+    Device* pDevice)
+{
+    GpuTimingTable* pTable = nullptr;
+    void*           pMem   = pDevice->VkInstance()->AllocMem(sizeof(GpuTimingTable), VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+    if (pMem != nullptr)
+    {
+        pTable = VK_PLACEMENT_NEW(pMem) GpuTimingTable(pDevice);
+    }
+
+    return pTable;
+}
+
+// =====================================================================================================================
+GpuTimingTable::GpuTimingTable(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_entryCount(0),
+    m_droppedCount(0)
+{
+}
+
+// =====================================================================================================================
+void GpuTimingTable::Destroy()
+{
+    Instance* pInstance = m_pDevice->VkInstance();
+
+    Util::Destructor(this);
+
+    pInstance->FreeMem(this);
+}
+
+// =====================================================================================================================
+// Adds the samples of one command buffer recording, plus the number of its regions which couldn't be measured.
+void GpuTimingTable::RecordSamples(
+    const GpuTimingSample* pSamples,
+    uint32_t               sampleCount,
+    uint32_t               droppedCount)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    m_droppedCount += droppedCount;
+
+    for (uint32_t i = 0; i < sampleCount; ++i)
+    {
+        Entry* pEntry = FindOrAddEntry(pSamples[i].pName);
+
+        if (pEntry != nullptr)
+        {
+            const uint64_t us = pSamples[i].us;
+
+            pEntry->count++;
+            pEntry->totalUs    += us;
+            pEntry->maxUs       = Util::Max(pEntry->maxUs, us);
+            pEntry->lastUs      = us;
+            pEntry->recentAvgUs = (pEntry->count == 1) ? us : (((pEntry->recentAvgUs * 7) + us) / 8);
+        }
+        else
+        {
+            m_droppedCount++;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Returns the entry of the given label name, adding it if there is room.  Must be called with the lock held.
+GpuTimingTable::Entry* GpuTimingTable::FindOrAddEntry(
+    const char* pName)
+{
+    // 32-bit FNV-1a over the name, so most mismatching entries are skipped without a string compare.
+    uint32_t hash = 2166136261u;
+
+    for (const char* pChar = pName; *pChar != '\0'; ++pChar)
+    {
+        hash = (hash ^ static_cast<uint8_t>(*pChar)) * 16777619u;
+    }
+
+    Entry* pEntry = nullptr;
+
+    for (uint32_t i = 0; (i < m_entryCount) && (pEntry == nullptr); ++i)
+    {
+        if ((m_entries[i].nameHash == hash) && (strcmp(m_entries[i].name, pName) == 0))
+        {
+            pEntry = &m_entries[i];
+        }
+    }
+
+    if ((pEntry == nullptr) && (m_entryCount < MaxEntries))
+    {
+        pEntry = &m_entries[m_entryCount++];
+
+        memset(pEntry, 0, sizeof(*pEntry));
+        Util::Strncpy(pEntry->name, pName, sizeof(pEntry->name));
+        pEntry->nameHash = hash;
+    }
+
+    return pEntry;
+}
+
+// =====================================================================================================================
+void GpuTimingTable::Write(
+    Util::JsonWriter* pWriter) const
+{
+    Util::MutexAuto lock(&m_lock);
+
+    pWriter->KeyAndBeginList("regions", false);
+
+    for (uint32_t i = 0; i < m_entryCount; ++i)
+    {
+        const Entry& entry = m_entries[i];
+
+        pWriter->BeginMap(true);
+        pWriter->KeyAndValue("name", entry.name);
+        pWriter->KeyAndValue("count", entry.count);
+        pWriter->KeyAndValue("totalUs", entry.totalUs);
+        pWriter->KeyAndValue("avgUs", entry.totalUs / entry.count);
+        pWriter->KeyAndValue("recentAvgUs", entry.recentAvgUs);
+        pWriter->KeyAndValue("lastUs", entry.lastUs);
+        pWriter->KeyAndValue("maxUs", entry.maxUs);
+        pWriter->EndMap();
+    }
+
+    pWriter->EndList();
+
+    pWriter->KeyAndValue("droppedRegions", m_droppedCount);
+}
+
+// =====================================================================================================================
+GpuTimingCmdBufferState::GpuTimingCmdBufferState(
+    Device*         pDevice,
+    GpuTimingTable* pTable)
+    :
+    m_pDevice(pDevice),
+    m_pTable(pTable),
+    m_regionCount(0),
+    m_cmdBufRegion(InvalidSlot),
+    m_labelDepth(0),
+    m_droppedCount(0)
+{
+}
+
+// =====================================================================================================================
+// Allocates the timestamp memory.  Only the default device's command buffer is timed.
+VkResult GpuTimingCmdBufferState::Init()
+{
+    InternalMemCreateInfo allocInfo = {};
+
+    allocInfo.pal.size      = 2 * MaxRegions * sizeof(uint64_t);
+    allocInfo.pal.alignment = sizeof(uint64_t);
+    allocInfo.pal.priority  = Pal::GpuMemPriority::Normal;
+
+    m_pDevice->MemMgr()->GetCommonPool(InternalPoolCpuCacheableGpuUncached, &allocInfo);
+
+    return m_pDevice->MemMgr()->AllocGpuMem(allocInfo, &m_timestampMem, 1 << DefaultDeviceIndex);
+}
+
+// =====================================================================================================================
+void GpuTimingCmdBufferState::Destroy()
+{
+    Resolve();
+
+    if (m_timestampMem.Size() > 0)
+    {
+        m_pDevice->MemMgr()->FreeGpuMem(&m_timestampMem);
+    }
+}
+
+// =====================================================================================================================
+// Starts a new recording.  Whatever the previous one measured is collected first, then all slots are marked unwritten.
+void GpuTimingCmdBufferState::Begin(
+    Pal::ICmdBuffer* pPalCmdBuffer,
+    bool             primary)
+{
+    Resolve();
+
+    memset(m_timestampMem.CpuAddr(DefaultDeviceIndex), 0xFF, 2 * MaxRegions * sizeof(uint64_t));
+
+    // Secondaries are covered by the command buffer region of the primary executing them.
+    m_cmdBufRegion = primary ? BeginRegion(pPalCmdBuffer, "vkCommandBuffer") : InvalidSlot;
+}
+
+// =====================================================================================================================
+void GpuTimingCmdBufferState::End(
+    Pal::ICmdBuffer* pPalCmdBuffer)
+{
+    if (m_cmdBufRegion != InvalidSlot)
+    {
+        EndRegion(pPalCmdBuffer, m_cmdBufRegion);
+    }
+
+    // Labels may legally stay open across command buffers.  Their regions stay open and are dropped on resolve.
+    m_labelDepth = 0;
+}
+
+// =====================================================================================================================
+void GpuTimingCmdBufferState::LabelBegin(
+    Pal::ICmdBuffer* pPalCmdBuffer,
+    const char*      pName)
+{
+    if (m_labelDepth < MaxLabelDepth)
+    {
+        m_labelStack[m_labelDepth] = BeginRegion(pPalCmdBuffer, pName);
+    }
+    else
+    {
+        m_droppedCount++;
+    }
+
+    m_labelDepth++;
+}
+
+// =====================================================================================================================
+void GpuTimingCmdBufferState::LabelEnd(
+    Pal::ICmdBuffer* pPalCmdBuffer)
+{
+    // An end without a begin in this command buffer closes a label opened in an earlier one, which isn't measured.
+    if (m_labelDepth > 0)
+    {
+        m_labelDepth--;
+
+        if ((m_labelDepth < MaxLabelDepth) && (m_labelStack[m_labelDepth] != InvalidSlot))
+        {
+            EndRegion(pPalCmdBuffer, m_labelStack[m_labelDepth]);
+        }
+    }
+}
+
+// =====================================================================================================================
+// Hands the measured regions of the last recording to the table.  Only called when the command buffer isn't pending,
+// so the GPU has written all the timestamps it is ever going to write.
+void GpuTimingCmdBufferState::Resolve()
+{
+    if (m_regionCount > 0)
+    {
+        const uint64_t* pTimestamps = static_cast<const uint64_t*>(m_timestampMem.CpuAddr(DefaultDeviceIndex));
+        const uint64_t  frequency   = m_pDevice->TimestampFrequency();
+
+        GpuTimingSample samples[MaxRegions];
+        uint32_t        sampleCount = 0;
+
+        for (uint32_t i = 0; i < m_regionCount; ++i)
+        {
+            const Region& region = m_regions[i];
+
+            if (region.endSlot != InvalidSlot)
+            {
+                const uint64_t beginTicks = pTimestamps[region.beginSlot];
+                const uint64_t endTicks   = pTimestamps[region.endSlot];
+
+                if ((beginTicks != TimestampNotDone) && (endTicks != TimestampNotDone) && (endTicks >= beginTicks))
+                {
+                    samples[sampleCount].pName = region.name;
+                    samples[sampleCount].us    = ((endTicks - beginTicks) * 1000000) / frequency;
+                    sampleCount++;
+                }
+            }
+            else
+            {
+                m_droppedCount++;
+            }
+        }
+
+        m_pTable->RecordSamples(samples, sampleCount, m_droppedCount);
+
+        m_regionCount  = 0;
+        m_droppedCount = 0;
+    }
+
+    m_cmdBufRegion = InvalidSlot;
+    m_labelDepth   = 0;
+}
+
+// =====================================================================================================================
+// Returns the index of the new region, or InvalidSlot if there is no room left for it.
+uint32_t GpuTimingCmdBufferState::BeginRegion(
+    Pal::ICmdBuffer* pPalCmdBuffer,
+    const char*      pName)
+{
+    uint32_t region = InvalidSlot;
+
+    if (m_regionCount < MaxRegions)
+    {
+        region = m_regionCount++;
+
+        Region* pRegion = &m_regions[region];
+
+        Util::Strncpy(pRegion->name, pName, sizeof(pRegion->name));
+        pRegion->beginSlot = 2 * region;
+        pRegion->endSlot   = InvalidSlot;
+
+        WriteTimestamp(pPalCmdBuffer, pRegion->beginSlot, true);
+    }
+    else
+    {
+        m_droppedCount++;
+    }
+
+    return region;
+}
+
+// =====================================================================================================================
+void GpuTimingCmdBufferState::EndRegion(
+    Pal::ICmdBuffer* pPalCmdBuffer,
+    uint32_t         region)
+{
+    Region* pRegion = &m_regions[region];
+
+    pRegion->endSlot = pRegion->beginSlot + 1;
+
+    WriteTimestamp(pPalCmdBuffer, pRegion->endSlot, false);
+}
+
+// =====================================================================================================================
+void GpuTimingCmdBufferState::WriteTimestamp(
+    Pal::ICmdBuffer* pPalCmdBuffer,
+    uint32_t         slot,
+    bool             topOfPipe)
+{
+    pPalCmdBuffer->CmdWriteTimestamp(topOfPipe ? Pal::HwPipeTop : Pal::HwPipeBottom,
+                                     *m_timestampMem.PalMemory(DefaultDeviceIndex),
+                                     m_timestampMem.Offset() + (slot * sizeof(uint64_t)));
+}
+
+} // namespace vk
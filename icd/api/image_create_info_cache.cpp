@@ -0,0 +1,238 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  image_create_info_cache.cpp
+* @brief Implementation of the cache of converted image create infos of recently created images.
+***********************************************************************************************************************
+*/
+
+#include "include/image_create_info_cache.h"
+#include "include/vk_device.h"
+#include "include/vk_image.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+ImageCreateInfoCache::ImageCreateInfoCache(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_enabled(false),
+    m_useCounter(0)
+{
+    memset(m_entries, 0, sizeof(m_entries));
+}
+
+// =====================================================================================================================
+void ImageCreateInfoCache::Init()
+{
+    m_enabled = m_pDevice->GetRuntimeSettings().enableImageCreateInfoCache;
+}
+
+// =====================================================================================================================
+// Fills in the key of an image create info.  Returns false if images created from it must not be cached.
+bool ImageCreateInfoCache::BuildKey(
+    const VkImageCreateInfo* pCreateInfo,
+    ImageCreateInfoKey*      pKey
+    ) const
+{
+    bool cacheable = m_enabled &&
+                     ((pCreateInfo->flags & Image::SparseEnablingFlags) == 0) &&
+                     (pCreateInfo->queueFamilyIndexCount <= ImageCreateInfoKey::MaxQueueFamilyIndices);
+
+    if (cacheable)
+    {
+        memset(pKey, 0, sizeof(*pKey));
+
+        pKey->flags                 = pCreateInfo->flags;
+        pKey->imageType             = pCreateInfo->imageType;
+        pKey->format                = pCreateInfo->format;
+        pKey->extent                = pCreateInfo->extent;
+        pKey->mipLevels             = pCreateInfo->mipLevels;
+        pKey->arrayLayers           = pCreateInfo->arrayLayers;
+        pKey->samples               = pCreateInfo->samples;
+        pKey->tiling                = pCreateInfo->tiling;
+        pKey->usage                 = pCreateInfo->usage;
+        pKey->sharingMode           = pCreateInfo->sharingMode;
+        pKey->initialLayout         = pCreateInfo->initialLayout;
+        pKey->queueFamilyIndexCount = pCreateInfo->queueFamilyIndexCount;
+
+        if (pCreateInfo->pQueueFamilyIndices != nullptr)
+        {
+            pKey->hasQueueFamilyIndices = 1;
+
+            memcpy(pKey->queueFamilyIndices,
+                   pCreateInfo->pQueueFamilyIndices,
+                   pCreateInfo->queueFamilyIndexCount * sizeof(uint32_t));
+        }
+    }
+
+    const void* pNext = pCreateInfo->pNext;
+
+    while (cacheable && (pNext != nullptr))
+    {
+        const VkStructHeader* pHeader = static_cast<const VkStructHeader*>(pNext);
+
+        switch (static_cast<uint32>(pHeader->sType))
+        {
+        case VK_STRUCTURE_TYPE_IMAGE_FORMAT_LIST_CREATE_INFO:
+        {
+            const auto* pExtInfo = static_cast<const VkImageFormatListCreateInfo*>(pNext);
+
+            cacheable = (pExtInfo->viewFormatCount <= ImageCreateInfoKey::MaxViewFormats);
+
+            if (cacheable)
+            {
+                pKey->hasViewFormatList = 1;
+                pKey->viewFormatCount   = pExtInfo->viewFormatCount;
+
+                memcpy(pKey->viewFormats, pExtInfo->pViewFormats, pExtInfo->viewFormatCount * sizeof(VkFormat));
+            }
+
+            break;
+        }
+
+        case VK_STRUCTURE_TYPE_IMAGE_STENCIL_USAGE_CREATE_INFO:
+        {
+            const auto* pExtInfo = static_cast<const VkImageStencilUsageCreateInfo*>(pNext);
+
+            pKey->hasStencilUsage = 1;
+            pKey->stencilUsage    = pExtInfo->stencilUsage;
+
+            break;
+        }
+
+        default:
+            // External memory and anything else Image::Create handles is left to the full path
+            cacheable = false;
+            break;
+        }
+
+        pNext = pHeader->pNext;
+    }
+
+    return cacheable;
+}
+
+// =====================================================================================================================
+// 32-bit FNV-1a over the key's bytes.
+uint32_t ImageCreateInfoCache::HashKey(
+    const ImageCreateInfoKey& key)
+{
+    const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(&key);
+
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < sizeof(key); ++i)
+    {
+        hash = (hash ^ pBytes[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+// =====================================================================================================================
+// Copies the converted create info cached for the key.  Returns false if there is none.
+bool ImageCreateInfoCache::Find(
+    const ImageCreateInfoKey& key,
+    ConvertedImageCreateInfo* pInfo)
+{
+    Entry* pSet = m_entries[HashKey(key) % SetCount];
+
+    bool found = false;
+
+    Util::MutexAuto lock(&m_lock);
+
+    for (uint32_t i = 0; (i < EntriesPerSet) && (found == false); ++i)
+    {
+        Entry* pEntry = &pSet[i];
+
+        if ((pEntry->lastUse != 0) && (memcmp(&pEntry->key, &key, sizeof(key)) == 0))
+        {
+            pEntry->lastUse = ++m_useCounter;
+
+            *pInfo = pEntry->info;
+
+            found = true;
+        }
+    }
+
+    if (found && (pInfo->palCreateInfo.pViewFormats != nullptr))
+    {
+        pInfo->palCreateInfo.pViewFormats = pInfo->viewFormats;
+    }
+
+    return found;
+}
+
+// =====================================================================================================================
+// Caches the converted create info of an image which was created successfully, replacing the least recently used
+// entry of its set.  The PAL view formats are copied into the entry.
+void ImageCreateInfoCache::Insert(
+    const ImageCreateInfoKey&       key,
+    const ConvertedImageCreateInfo& info)
+{
+    const Pal::ImageCreateInfo& palCreateInfo = info.palCreateInfo;
+
+    const bool hasViewFormats = (palCreateInfo.pViewFormats != nullptr) &&
+                                (palCreateInfo.viewFormatCount != Pal::AllCompatibleFormats);
+
+    VK_ASSERT((hasViewFormats == false) || (palCreateInfo.viewFormatCount <= ImageCreateInfoKey::MaxViewFormats));
+
+    Entry* pSet = m_entries[HashKey(key) % SetCount];
+
+    Util::MutexAuto lock(&m_lock);
+
+    Entry* pVictim = &pSet[0];
+
+    for (uint32_t i = 1; i < EntriesPerSet; ++i)
+    {
+        if (pSet[i].lastUse < pVictim->lastUse)
+        {
+            pVictim = &pSet[i];
+        }
+    }
+
+    pVictim->key     = key;
+    pVictim->info    = info;
+    pVictim->lastUse = ++m_useCounter;
+
+    if (hasViewFormats)
+    {
+        memcpy(pVictim->info.viewFormats,
+               palCreateInfo.pViewFormats,
+               palCreateInfo.viewFormatCount * sizeof(Pal::SwizzledFormat));
+
+        pVictim->info.palCreateInfo.pViewFormats = pVictim->info.viewFormats;
+    }
+    else
+    {
+        pVictim->info.palCreateInfo.pViewFormats = nullptr;
+    }
+}
+
+} // namespace vk
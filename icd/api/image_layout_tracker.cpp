@@ -0,0 +1,365 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  image_layout_tracker.cpp
+* @brief Implementation of the tracking of the PAL layouts images are left in by submitted command buffers.
+***********************************************************************************************************************
+*/
+#include "include/image_layout_tracker.h"
+#include "include/vk_device.h"
+#include "include/vk_formats.h"
+#include "include/vk_image.h"
+#include "include/vk_instance.h"
+#include "include/vk_memory.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+ImageLayoutCmdBufferState::ImageLayoutCmdBufferState(
+    ImageLayoutTracker* pTracker,
+    bool                predict)
+    :
+    m_pTracker(pTracker),
+    m_predict(predict),
+    m_imageCount(0),
+    m_overflow(false)
+{
+}
+
+// =====================================================================================================================
+// Forgets all images, for a new recording.
+void ImageLayoutCmdBufferState::Reset()
+{
+    m_imageCount = 0;
+    m_overflow   = false;
+}
+
+// =====================================================================================================================
+// Returns the entry of an image, adding one with unknown layouts if the image has none yet.  Returns nullptr if the
+// tracked set is full.
+ImageLayoutCmdBufferState::TrackedImage* ImageLayoutCmdBufferState::FindOrAdd(
+    const Image* pImage,
+    bool*        pAdded)
+{
+    TrackedImage* pEntry = nullptr;
+
+    for (uint32_t i = 0; (i < m_imageCount) && (pEntry == nullptr); ++i)
+    {
+        if (m_images[i].pImage == pImage)
+        {
+            pEntry = &m_images[i];
+        }
+    }
+
+    *pAdded = false;
+
+    if ((pEntry == nullptr) && (m_imageCount < MaxTrackedImages))
+    {
+        pEntry = &m_images[m_imageCount++];
+
+        pEntry->pImage         = pImage;
+        pEntry->rangeCount     = 0;
+        pEntry->predictedCount = 0;
+
+        *pAdded = true;
+    }
+
+    return pEntry;
+}
+
+// =====================================================================================================================
+// Returns true if the PAL ranges of a barrier, one per aspect, cover every subresource of an image.
+static bool CoversImage(
+    const Image*            pImage,
+    uint32_t                rangeCount,
+    const Pal::SubresRange* pRanges)
+{
+    const VkFormat format = pImage->GetFormat();
+
+    const uint32_t aspectCount = Formats::IsDepthStencilFormat(format) ?
+        ((Formats::HasDepth(format) ? 1 : 0) + (Formats::HasStencil(format) ? 1 : 0)) : 1;
+
+    bool covers = (rangeCount == aspectCount);
+
+    for (uint32_t i = 0; (i < rangeCount) && covers; ++i)
+    {
+        covers = (pRanges[i].startSubres.mipLevel   == 0)                      &&
+                 (pRanges[i].startSubres.arraySlice == 0)                      &&
+                 (pRanges[i].numMips                == pImage->GetMipLevels()) &&
+                 (pRanges[i].numSlices              == pImage->GetArraySize());
+    }
+
+    return covers;
+}
+
+// =====================================================================================================================
+// Records a layout transition of a tracked image, given as one PAL range and layout per aspect.  Returns true if the
+// transition comes from VK_IMAGE_LAYOUT_UNDEFINED and the image is already in the new layouts, in which case only its
+// cache operations are needed.  The first transition of an image in the command buffer may rely on the layouts
+// committed by earlier submissions; those are then checked when the command buffer is submitted.  A transition over
+// only part of the image makes its layouts unknown.
+bool ImageLayoutCmdBufferState::FilterTransition(
+    const Image*            pImage,
+    bool                    fromUndefined,
+    uint32_t                rangeCount,
+    const Pal::SubresRange* pRanges,
+    const Pal::ImageLayout* pNewLayouts)
+{
+    VK_ASSERT(pImage->IsLayoutTracked() && (rangeCount <= MaxPalAspectsPerMask));
+
+    bool redundant = false;
+    bool added     = false;
+
+    TrackedImage* pEntry = FindOrAdd(pImage, &added);
+
+    if ((pEntry != nullptr) && (CoversImage(pImage, rangeCount, pRanges) == false))
+    {
+        pEntry->rangeCount = 0;
+    }
+    else if (pEntry != nullptr)
+    {
+        const size_t layoutSize = sizeof(Pal::ImageLayout) * rangeCount;
+
+        if (fromUndefined && (pEntry->rangeCount == rangeCount))
+        {
+            redundant = (memcmp(pEntry->layouts, pNewLayouts, layoutSize) == 0);
+        }
+        else if (fromUndefined && added && m_predict &&
+                 m_pTracker->PredictLayouts(pImage, rangeCount, pEntry->predictedLayouts))
+        {
+            redundant = (memcmp(pEntry->predictedLayouts, pNewLayouts, layoutSize) == 0);
+
+            // A prediction the transition doesn't depend on needs no check on submission
+            pEntry->predictedCount = redundant ? rangeCount : 0;
+        }
+
+        pEntry->rangeCount = rangeCount;
+
+        memcpy(pEntry->ranges, pRanges, sizeof(Pal::SubresRange) * rangeCount);
+        memcpy(pEntry->layouts, pNewLayouts, layoutSize);
+    }
+    else
+    {
+        m_overflow = true;
+    }
+
+    return redundant;
+}
+
+// =====================================================================================================================
+// Records that a tracked image was left in layouts the command buffer doesn't know, e.g. by a barrier over part of it
+// or by a render pass.
+void ImageLayoutCmdBufferState::Forget(
+    const Image* pImage)
+{
+    bool added = false;
+
+    TrackedImage* pEntry = FindOrAdd(pImage, &added);
+
+    if (pEntry != nullptr)
+    {
+        pEntry->rangeCount = 0;
+    }
+    else
+    {
+        m_overflow = true;
+    }
+}
+
+// =====================================================================================================================
+// Applies the layouts a nested command buffer leaves its images in to this command buffer, when it is executed.
+// Nested command buffers don't predict, so they have nothing to check on submission.
+void ImageLayoutCmdBufferState::Merge(
+    const ImageLayoutCmdBufferState& nested)
+{
+    VK_ASSERT(nested.m_predict == false);
+
+    for (uint32_t i = 0; i < nested.m_imageCount; ++i)
+    {
+        const TrackedImage& nestedEntry = nested.m_images[i];
+
+        bool added = false;
+
+        TrackedImage* pEntry = FindOrAdd(nestedEntry.pImage, &added);
+
+        if (pEntry != nullptr)
+        {
+            pEntry->rangeCount = nestedEntry.rangeCount;
+
+            memcpy(pEntry->ranges, nestedEntry.ranges, sizeof(nestedEntry.ranges));
+            memcpy(pEntry->layouts, nestedEntry.layouts, sizeof(nestedEntry.layouts));
+        }
+        else
+        {
+            m_overflow = true;
+        }
+    }
+
+    m_overflow |= nested.m_overflow;
+}
+
+// =====================================================================================================================
+ImageLayoutTracker::ImageLayoutTracker(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_enabled(false),
+    m_generation(1)
+{
+}
+
+// =====================================================================================================================
+void ImageLayoutTracker::Init()
+{
+    // A barrier in a command buffer only transitions the image of the device mask it is recorded for.  Timed
+    // submissions hand the application's command buffers to the developer mode manager, with no room for fixups.
+    m_enabled = m_pDevice->GetRuntimeSettings().enableImageLayoutTracking &&
+                (m_pDevice->NumPalDevices() == 1)                          &&
+                (m_pDevice->VkInstance()->GetDevModeMgr() == nullptr);
+}
+
+// =====================================================================================================================
+// Returns true if the layouts of an image bound to the given memory can be tracked.  Its metadata must not be shared
+// with any other resource, process or device, and it must not be presented, so that only barriers of this device's
+// command buffers change its layouts.
+bool ImageLayoutTracker::IsCandidate(
+    const Image*  pImage,
+    const Memory* pMemory) const
+{
+    return m_enabled                                &&
+           (pMemory != nullptr)                     &&
+           pMemory->IsPrivateDedicatedImage()       &&
+           (pMemory->IsTransientAlias() == false)   &&
+           (pImage->IsSparse() == false)            &&
+           (pImage->IsPresentable() == false)       &&
+           (pImage->IsYuvFormat() == false);
+}
+
+// =====================================================================================================================
+// Returns the layouts an image was left in by the command buffers submitted so far, if they are known and haven't
+// changed for a while.  Returns false if they shouldn't be predicted.
+bool ImageLayoutTracker::PredictLayouts(
+    const Image*      pImage,
+    uint32_t          rangeCount,
+    Pal::ImageLayout* pLayouts)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    const CommittedImageLayouts* pCommitted = pImage->GetCommittedLayouts();
+
+    const bool predictable = (pCommitted->generation == m_generation)      &&
+                             (pCommitted->mispredicted == false)           &&
+                             (pCommitted->stableCount >= MinStableCommits);
+
+    if (predictable)
+    {
+        memcpy(pLayouts, pCommitted->layouts, sizeof(Pal::ImageLayout) * rangeCount);
+    }
+
+    return predictable;
+}
+
+// =====================================================================================================================
+// Commits the layouts a command buffer leaves its images in, as it is submitted.  Checks the layouts the command buffer
+// predicted first, and returns the transitions which have to be executed ahead of it to move images into the layouts
+// it was recorded for.  At most MaxPalAspectsPerMask transitions are returned per tracked image.
+uint32_t ImageLayoutTracker::Commit(
+    const ImageLayoutCmdBufferState& state,
+    uint32_t                         maxFixupCount,
+    Pal::BarrierTransition*          pFixups)
+{
+    uint32_t fixupCount = 0;
+
+    Util::MutexAuto lock(&m_lock);
+
+    for (uint32_t i = 0; i < state.m_imageCount; ++i)
+    {
+        const ImageLayoutCmdBufferState::TrackedImage& entry = state.m_images[i];
+
+        CommittedImageLayouts* pCommitted = entry.pImage->GetCommittedLayouts();
+
+        const bool known = (pCommitted->generation == m_generation);
+
+        if ((entry.predictedCount > 0) &&
+            ((known == false) ||
+             (memcmp(pCommitted->layouts,
+                     entry.predictedLayouts,
+                     sizeof(Pal::ImageLayout) * entry.predictedCount) != 0)))
+        {
+            for (uint32_t aspect = 0; (aspect < entry.predictedCount) && (fixupCount < maxFixupCount); ++aspect)
+            {
+                Pal::BarrierTransition* pFixup = &pFixups[fixupCount++];
+
+                memset(pFixup, 0, sizeof(*pFixup));
+
+                pFixup->srcCacheMask          = Pal::CoherAllUsages;
+                pFixup->dstCacheMask          = Pal::CoherAllUsages;
+                pFixup->imageInfo.pImage      = entry.pImage->PalImage(DefaultDeviceIndex);
+                pFixup->imageInfo.subresRange = entry.ranges[aspect];
+                pFixup->imageInfo.newLayout   = entry.predictedLayouts[aspect];
+
+                if (known)
+                {
+                    pFixup->imageInfo.oldLayout = pCommitted->layouts[aspect];
+                }
+                else
+                {
+                    pFixup->imageInfo.oldLayout.usages  = Pal::LayoutUninitializedTarget;
+                    pFixup->imageInfo.oldLayout.engines = entry.predictedLayouts[aspect].engines;
+                }
+            }
+
+            pCommitted->mispredicted = true;
+        }
+
+        if (entry.rangeCount > 0)
+        {
+            const size_t layoutSize = sizeof(Pal::ImageLayout) * entry.rangeCount;
+
+            const bool stable = known && (memcmp(pCommitted->layouts, entry.layouts, layoutSize) == 0);
+
+            memcpy(pCommitted->layouts, entry.layouts, layoutSize);
+
+            pCommitted->stableCount = stable ? (pCommitted->stableCount + 1) : 0;
+            pCommitted->generation  = m_generation;
+        }
+        else
+        {
+            pCommitted->generation = 0;
+        }
+    }
+
+    // Images the command buffer had no room to track may have been left in any layouts
+    if (state.m_overflow)
+    {
+        m_generation = (m_generation == UINT32_MAX) ? 1 : (m_generation + 1);
+    }
+
+    return fixupCount;
+}
+
+} // namespace vk
@@ -0,0 +1,141 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  api_object_pool.h
+* @brief Per-device slab allocator for the system memory of frequently created API objects.
+***********************************************************************************************************************
+*/
+#ifndef __API_OBJECT_POOL_H__
+#define __API_OBJECT_POOL_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "palMutex.h"
+
+namespace vk
+{
+
+class Device;
+struct ApiObjectThreadCache;
+
+// =====================================================================================================================
+// Serves the system memory of buffers, buffer views, image views, samplers, events, fences and framebuffers created
+// without application allocation callbacks.  Objects are rounded up to a size class and carved out of slabs which are
+// only returned when the device is destroyed.  Each thread keeps a short free list per size class, so creating and
+// destroying objects in a loop takes no lock at all; the lists are refilled from and drained to the pool's shared free
+// lists in batches.
+//
+// Every block, pooled or not, starts with a BlockHeaderSize header recording its size class so that the memory can be
+// freed without knowing which path allocated it.  A thread's free lists belong to the last pool it used; switching to
+// another device hands them back to their pool first.
+class ApiObjectPool
+{
+public:
+    static ApiObjectPool* Create(Device* pDevice);
+
+    void Destroy();
+
+    // Returns the smallest size class which fits the given size, or NoSizeClass
+    static uint32_t GetSizeClass(size_t size);
+
+    void* Alloc(uint32_t sizeClass);
+
+    void Free(uint32_t sizeClass, void* pMemory);
+
+    // Writes the header of a block allocated outside of the pool and returns the memory following it
+    static void* InitUnpooledBlock(void* pBase)
+    {
+        static_cast<BlockHeader*>(pBase)->sizeClass = NoSizeClass;
+
+        return Util::VoidPtrInc(pBase, BlockHeaderSize);
+    }
+
+    // Returns the size class recorded in front of the given memory, or NoSizeClass if it was not pooled
+    static uint32_t GetBlockSizeClass(const void* pMemory)
+    {
+        return static_cast<const BlockHeader*>(Util::VoidPtrDec(pMemory, BlockHeaderSize))->sizeClass;
+    }
+
+    static constexpr size_t   BlockHeaderSize = VK_DEFAULT_MEM_ALIGN;
+    static constexpr uint32_t NoSizeClass     = UINT32_MAX;
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(ApiObjectPool);
+
+    friend struct ApiObjectThreadCache;
+
+    ApiObjectPool(Device* pDevice);
+
+    ~ApiObjectPool();
+
+    struct BlockHeader
+    {
+        uint32_t sizeClass;    // Index into SizeClasses, or NoSizeClass
+        uint32_t reserved[3];
+    };
+
+    static_assert(sizeof(BlockHeader) == BlockHeaderSize, "Block header must keep objects aligned");
+
+    struct FreeBlock
+    {
+        FreeBlock* pNext;
+    };
+
+    struct Slab
+    {
+        Slab*    pNext;
+        uint64_t reserved;
+    };
+
+    static constexpr uint32_t SizeClassCount    = 10;    // Entries of SizeClasses in api_object_pool.cpp
+    static constexpr uint32_t MaxCachedPerClass = 32;    // Blocks a thread keeps per size class
+    static constexpr uint32_t TransferBatchSize = 16;    // Blocks moved between a thread and the pool at once
+    static constexpr size_t   TargetSlabSize    = 16384; // Slabs hold at least this many bytes of blocks
+
+    ApiObjectThreadCache* BindThreadCache();
+
+    static void ReleaseThreadCache(ApiObjectThreadCache* pCache);
+
+    FreeBlock* TakeBlocks(uint32_t sizeClass, uint32_t maxCount, uint32_t* pCount);
+
+    void ReturnBlocks(uint32_t sizeClass, FreeBlock* pBlocks);
+
+    bool AllocSlab(uint32_t sizeClass);
+
+    Device* const  m_pDevice;
+    const uint64_t m_id;                          // Distinguishes this pool from earlier ones at the same address
+    ApiObjectPool* m_pNextLive;                   // Next pool in the list of live pools
+
+    Util::Mutex    m_lock;                        // Protects the slabs and shared free lists
+    Slab*          m_pSlabs;                      // All slabs carved so far
+    FreeBlock*     m_pFreeBlocks[SizeClassCount]; // Shared free lists of each size class
+};
+
+} // namespace vk
+
+#endif /* __API_OBJECT_POOL_H__ */
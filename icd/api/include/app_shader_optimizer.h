@@ -76,6 +76,25 @@ struct PipelineShaderOptionsPtr
 
 };
 
+// Lookup structure over the entries of a PipelineProfile, so a pipeline is only tested against the entries that can
+// match it.  Entries requiring an exact code hash are indexed by the first stage with such a pattern; all other entries
+// (always-match, stage activity or code size patterns) are kept in a residual list that is tested for every pipeline.
+struct PipelineProfileIndex
+{
+    struct HashedEntry
+    {
+        uint64_t hashLower;
+        uint64_t hashUpper;
+        uint32_t stage;
+        uint32_t entry;             // Index into PipelineProfile::pEntries
+    };
+
+    HashedEntry* pHashedEntries;    // Sorted by stage, hash and entry; nullptr if the index couldn't be built
+    uint32_t     hashedCount;
+    uint32_t*    pResidualEntries;  // Entries without a code hash pattern, in entry order
+    uint32_t     residualCount;
+};
+
 // =====================================================================================================================
 // This class can tune pre-compile SC parameters based on known shader hashes in order to improve SC code generation
 // output.
@@ -109,14 +128,20 @@ public:
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(ShaderOptimizer);
 
+    // Most candidate entries gathered from a profile index for one pipeline; profiles with more residual entries than
+    // this are scanned in full.
+    static constexpr uint32_t MaxProfileCandidates = 64;
+
     void ApplyProfileToShaderCreateInfo(
         const PipelineProfile&           profile,
+        const PipelineProfileIndex&      index,
         const PipelineOptimizerKey&      pipelineKey,
         ShaderStage                      shaderStage,
         PipelineShaderOptionsPtr         options);
 
     void ApplyProfileToGraphicsPipelineCreateInfo(
         const PipelineProfile&            profile,
+        const PipelineProfileIndex&       index,
         const PipelineOptimizerKey&       pipelineKey,
         VkShaderStageFlagBits             shaderStages,
         Pal::GraphicsPipelineCreateInfo*  pPalCreateInfo,
@@ -124,6 +149,7 @@ private:
 
     void ApplyProfileToComputePipelineCreateInfo(
         const PipelineProfile&           profile,
+        const PipelineProfileIndex&      index,
         const PipelineOptimizerKey&      pipelineKey,
         Pal::DynamicComputeShaderInfo*   pDynamicComputeShaderInfo);
 
@@ -135,6 +161,19 @@ private:
         const ShaderProfileAction&     action,
         Pal::DynamicComputeShaderInfo* pComputeShaderInfo);
 
+    bool GetCandidateEntries(
+        const PipelineProfileIndex& index,
+        const PipelineOptimizerKey& pipelineKey,
+        uint32_t*                   pCandidates,
+        uint32_t*                   pCandidateCount) const;
+
+    void BuildProfileIndex(
+        const PipelineProfile& profile,
+        PipelineProfileIndex*  pIndex);
+
+    void DestroyProfileIndex(
+        PipelineProfileIndex* pIndex);
+
     bool ProfilePatternMatchesPipeline(
         const PipelineProfilePattern& pattern,
         const PipelineOptimizerKey&   pipelineKey);
@@ -145,12 +184,30 @@ private:
 
     void BuildTuningProfile();
     void BuildAppProfile();
+    void BuildCompileCostProfile();
+    void BuildAutotuneProfile();
 
     void BuildAppProfileLlpc();
 
 #if ICD_RUNTIME_APP_PROFILE
+    // Header of the binary runtime profile file, followed by entryCount raw PipelineProfileEntry structures
+    struct RuntimeProfileFileHeader
+    {
+        uint32_t magic;        // RuntimeProfileFileMagic
+        uint32_t version;      // RuntimeProfileFileVersion
+        uint32_t entrySize;    // sizeof(PipelineProfileEntry) of the driver which wrote the file
+        uint32_t entryCount;   // Number of entries following the header
+        uint64_t sourceHash;   // 64-bit MetroHash of the JSON profile the entries were converted from
+    };
+
+    static constexpr uint32_t RuntimeProfileFileMagic   = 0x50505641;  // "AVPP"
+    static constexpr uint32_t RuntimeProfileFileVersion = 1;
+
     void BuildRuntimeProfile();
     void RuntimeProfileParseError();
+
+    bool MapRuntimeProfileBinary(bool hasSource, uint64_t sourceHash);
+    void WriteRuntimeProfileBinary(uint64_t sourceHash) const;
 #endif
 
 #if PAL_ENABLE_PRINTS_ASSERTS
@@ -162,11 +219,22 @@ private:
 
     PipelineProfile        m_tuningProfile;
     PipelineProfile        m_appProfile;
+    PipelineProfile        m_compileCostProfile;  // Fast compile options for expensive, rarely used pipelines
+    PipelineProfile        m_autotuneProfile;     // Variants the pipeline autotuner settled on for hot pipelines
+
+    PipelineProfileIndex   m_tuningProfileIndex;
+    PipelineProfileIndex   m_appProfileIndex;
+    PipelineProfileIndex   m_compileCostProfileIndex;
+    PipelineProfileIndex   m_autotuneProfileIndex;
 
     ShaderProfile          m_appShaderProfile;
 
 #if ICD_RUNTIME_APP_PROFILE
     PipelineProfile        m_runtimeProfile;
+    PipelineProfileIndex   m_runtimeProfileIndex;
+    void*                  m_pRuntimeProfileMapping;     // Read-only mapping of the binary runtime profile, which then
+                                                         // backs m_runtimeProfile.pEntries
+    size_t                 m_runtimeProfileMappingSize;
 #endif
 
 #if PAL_ENABLE_PRINTS_ASSERTS
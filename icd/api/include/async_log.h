@@ -0,0 +1,237 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  async_log.h
+* @brief Driver log which records binary messages per thread and formats them on a background thread.
+***********************************************************************************************************************
+*/
+#ifndef __ASYNC_LOG_H__
+#define __ASYNC_LOG_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "utils/per_thread_registry.h"
+
+#include "palEvent.h"
+#include "palFile.h"
+#include "palSysUtil.h"
+#include "palThread.h"
+
+#include <atomic>
+#include <type_traits>
+
+namespace vk
+{
+
+class Instance;
+
+// =====================================================================================================================
+// Backend of AmdvlkLog() which keeps formatting and file output off the logging threads.
+//
+// A message is recorded as its format string, which must be a literal, and its arguments, copied in binary form into
+// the ring of the calling thread.  Each ring has a single producer and a single consumer, so recording takes no lock
+// and no atomic read-modify-write.  The log thread wakes up periodically, formats the messages of all rings and
+// appends them to AsyncLogFile.  Messages of different threads are only ordered within each wake-up; every line
+// carries its timestamp and thread.  Messages recorded while the ring of their thread is full are dropped and counted.
+class AsyncLog
+{
+public:
+    explicit AsyncLog(Instance* pInstance);
+
+    VkResult Init(const char* pFilePath);
+    void Destroy();
+
+    // Returns the log AmdvlkLog() messages are recorded into, or nullptr if they are printed directly
+    static VK_INLINE AsyncLog* GetActive()
+        { return s_pActive.load(std::memory_order_acquire); }
+
+    template <typename... Args>
+    void Write(
+        uint32_t    tagId,
+        const char* pFormat,
+        Args...     args);
+
+private:
+    PAL_DISALLOW_DEFAULT_CTOR(AsyncLog);
+    PAL_DISALLOW_COPY_AND_ASSIGN(AsyncLog);
+
+    static constexpr uint32_t RingSize       = 1024;  // Messages per thread ring, must be a power of two
+    static constexpr uint32_t MaxArgs        = 8;     // Arguments of one message
+    static constexpr uint32_t StringDataSize = 96;    // Bytes of string arguments copied per message
+
+    enum class ArgType : uint32_t
+    {
+        Signed,
+        Unsigned,
+        Float,
+        Pointer,
+        String      // Offset of the copy in LogRecord::strings
+    };
+
+    struct LogArg
+    {
+        ArgType type;
+        union
+        {
+            int64_t     s;
+            uint64_t    u;
+            double      f;
+            const void* p;
+        };
+    };
+
+    struct LogRecord
+    {
+        int64_t     timestamp;                // CPU ticks
+        const char* pFormat;
+        uint32_t    tagId;
+        uint32_t    argCount;
+        uint32_t    stringSize;               // Bytes used in strings
+        LogArg      args[MaxArgs];
+        char        strings[StringDataSize];
+    };
+
+    struct ThreadRing
+    {
+        std::atomic<uint32_t> head;           // Next record to write, only advanced by the owning thread
+        std::atomic<uint32_t> tail;           // Next record to format, only advanced by the log thread
+        std::atomic<uint32_t> dropped;        // Messages dropped because the ring was full
+        uint32_t              reportedDrops;  // Dropped messages the log thread already reported
+        uint32_t              threadIndex;    // Printed with each message
+        LogRecord             records[RingSize];
+    };
+
+    static std::atomic<AsyncLog*> s_pActive;
+
+    ThreadRing* GetThreadRing();
+
+    static void EncodeArg(LogRecord* pRecord, const char* pString);
+    static void EncodeArg(LogRecord* pRecord, char* pString) { EncodeArg(pRecord, static_cast<const char*>(pString)); }
+
+    static void EncodeArg(LogRecord* pRecord, const void* pValue);
+    static void EncodeArg(LogRecord* pRecord, double value);
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type EncodeArg(
+        LogRecord* pRecord,
+        T          value);
+
+    static void LogThreadFunc(void* pParam);
+
+    void Drain();
+    void FormatRecord(const ThreadRing& ring, const LogRecord& record);
+
+    Instance* const                       m_pInstance;
+    bool                                  m_enabled;
+    int64_t                               m_startTicks;    // Timestamps are written relative to this
+    int64_t                               m_perfFrequency; // CPU ticks per second
+    Util::File                            m_file;
+    Util::Thread                          m_thread;        // Formats and writes the messages
+    Util::Event                           m_wakeEvent;
+    volatile bool                         m_stop;          // Asks the log thread to exit
+    utils::PerThreadRegistry<ThreadRing>  m_rings;         // Rings of all threads which logged
+    uint32_t                              m_ringCount;     // Only changed while the registry creates a ring
+};
+
+// =====================================================================================================================
+// Returns the ring of the calling thread, creating it on its first message or taking over the one a finished thread
+// with the same thread-local storage left behind.  Returns null if out of memory.
+VK_INLINE AsyncLog::ThreadRing* AsyncLog::GetThreadRing()
+{
+    return m_rings.Get([this](ThreadRing* pNew)
+    {
+        pNew->head.store(0, std::memory_order_relaxed);
+        pNew->tail.store(0, std::memory_order_relaxed);
+        pNew->dropped.store(0, std::memory_order_relaxed);
+        pNew->reportedDrops = 0;
+        pNew->threadIndex   = m_ringCount++;
+    });
+}
+
+// =====================================================================================================================
+// Records a message into the ring of the calling thread.  The message is dropped if the ring is full.
+template <typename... Args>
+void AsyncLog::Write(
+    uint32_t    tagId,
+    const char* pFormat,
+    Args...     args)
+{
+    static_assert(sizeof...(Args) <= MaxArgs, "Too many arguments for an async log message");
+
+    ThreadRing* pRing = GetThreadRing();
+
+    if (pRing != nullptr)
+    {
+        const uint32_t head = pRing->head.load(std::memory_order_relaxed);
+
+        if ((head - pRing->tail.load(std::memory_order_acquire)) < RingSize)
+        {
+            LogRecord* pRecord = &pRing->records[head & (RingSize - 1)];
+
+            pRecord->timestamp  = Util::GetPerfCpuTime();
+            pRecord->pFormat    = pFormat;
+            pRecord->tagId      = tagId;
+            pRecord->argCount   = 0;
+            pRecord->stringSize = 0;
+
+            const int expand[] = { 0, (EncodeArg(pRecord, args), 0)... };
+            VK_IGNORE(expand);
+
+            pRing->head.store(head + 1, std::memory_order_release);
+        }
+        else
+        {
+            pRing->dropped.store(pRing->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+}
+
+// =====================================================================================================================
+// Copies an integer argument into a record
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type AsyncLog::EncodeArg(
+    LogRecord* pRecord,
+    T          value)
+{
+    LogArg* pArg = &pRecord->args[pRecord->argCount++];
+
+    if (std::is_signed<T>::value)
+    {
+        pArg->type = ArgType::Signed;
+        pArg->s    = static_cast<int64_t>(value);
+    }
+    else
+    {
+        pArg->type = ArgType::Unsigned;
+        pArg->u    = static_cast<uint64_t>(value);
+    }
+}
+
+} // namespace vk
+
+#endif /* __ASYNC_LOG_H__ */
@@ -0,0 +1,164 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  barrier_profile.h
+* @brief Declaration of the barrier cost profile, which attributes measured GPU stall time to barrier call sites.
+***********************************************************************************************************************
+*/
+#ifndef __BARRIER_PROFILE_H__
+#define __BARRIER_PROFILE_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+#include "include/internal_mem_mgr.h"
+
+#include "palDeveloperHooks.h"
+#include "palMutex.h"
+
+namespace Pal
+{
+class ICmdBuffer;
+}
+
+namespace Util
+{
+class JsonWriter;
+}
+
+namespace vk
+{
+
+class Device;
+
+// One measured barrier, handed from a command buffer to the device-wide profile
+struct BarrierProfileSample
+{
+    uint32_t reason;             // Barrier reason, which identifies the call site (see RgpBarrierReason)
+    uint16_t pipelineStalls;     // Pal::Developer::BarrierOperations::pipelineStalls of the whole barrier
+    uint16_t caches;             // Pal::Developer::BarrierOperations::caches of the whole barrier
+    uint32_t layoutTransitions;  // Number of image layout transitions the barrier performed
+    uint64_t stallNs;            // GPU time the barrier held up the command processor, in nanoseconds
+};
+
+// =====================================================================================================================
+// Device-wide table of the GPU cost of barriers, keyed by the barrier reason each call site passes to PAL.  This covers
+// application barriers, render pass synchronization, the driver's internal barriers and the ones PAL performs itself
+// around its internal blits, separated by the reason ranges.  Command buffers hand in their samples in batches once
+// the GPU is known to be done with them, so the table is only locked once per recording.
+class BarrierProfile
+{
+public:
+    static BarrierProfile* Create(Device* pDevice);
+
+    void Destroy();
+
+    void RecordSamples(const BarrierProfileSample* pSamples, uint32_t sampleCount, uint32_t droppedCount);
+
+    void Write(Util::JsonWriter* pWriter) const;
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(BarrierProfile);
+
+    BarrierProfile(Device* pDevice);
+
+    ~BarrierProfile() { }
+
+    static constexpr uint32_t MaxEntries = 128;
+
+    struct Entry
+    {
+        uint32_t reason;
+        uint16_t pipelineStalls;     // Union of the stalls of all the barriers
+        uint16_t caches;             // Union of the cache operations of all the barriers
+        uint64_t count;              // Number of measured barriers
+        uint64_t stallingCount;      // Number of them which waited for the pipeline to drain
+        uint64_t layoutTransitions;  // Sum of the image layout transitions
+        uint64_t totalNs;            // Sum of the stall times
+        uint64_t maxNs;              // Longest stall
+    };
+
+    Device* const       m_pDevice;
+    mutable Util::Mutex m_lock;           // Serializes access to the entries
+    Entry               m_entries[MaxEntries];
+    uint32_t            m_entryCount;
+    uint64_t            m_droppedCount;   // Barriers which didn't fit their command buffer or the table
+};
+
+// =====================================================================================================================
+// Per-command buffer state of the barrier profile.  It follows the PAL barrier developer callbacks: a top-of-pipe
+// timestamp is written when a barrier begins and another one when it ends, and the operations PAL reports in between
+// are accumulated.  The command processor only moves past the barrier's waits once they are satisfied, so the
+// difference of the two timestamps is the time the barrier stalled the GPU.  The timestamps are read back the next
+// time the command buffer is begun, reset or destroyed, like those of the GPU timing table.
+class BarrierProfileCmdBufferState
+{
+public:
+    BarrierProfileCmdBufferState(Device* pDevice, BarrierProfile* pProfile);
+
+    VkResult Init();
+
+    void Destroy();
+
+    void Begin();
+
+    void PalBarrierCallback(
+        Pal::ICmdBuffer*                   pPalCmdBuffer,
+        Pal::Developer::CallbackType       type,
+        const Pal::Developer::BarrierData& barrier);
+
+    void Resolve();
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(BarrierProfileCmdBufferState);
+
+    static constexpr uint32_t MaxBarriers      = 256;
+    static constexpr uint32_t InvalidSlot      = UINT32_MAX;
+    static constexpr uint64_t TimestampNotDone = UINT64_MAX;
+
+    struct Barrier
+    {
+        uint32_t reason;
+        uint16_t pipelineStalls;
+        uint16_t caches;
+        uint32_t layoutTransitions;
+        bool     ended;              // The end timestamp was written
+    };
+
+    void WriteTimestamp(Pal::ICmdBuffer* pPalCmdBuffer, uint32_t slot);
+
+    Device* const         m_pDevice;
+    BarrierProfile* const m_pProfile;
+    InternalMemory        m_timestampMem;           // Two timestamp slots per barrier
+    Barrier               m_barriers[MaxBarriers];
+    uint32_t              m_barrierCount;
+    uint32_t              m_openBarrier;            // Barrier between its begin and end callbacks, or InvalidSlot
+    uint32_t              m_droppedCount;           // Barriers left out since the last resolve
+};
+
+} // namespace vk
+
+#endif /* __BARRIER_PROFILE_H__ */
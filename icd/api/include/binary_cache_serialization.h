@@ -100,9 +100,66 @@ Util::Result WriteVkPipelineCacheHeaderData(
 struct BinaryCacheEntry
 {
     Util::MetroHash::Hash hashId;
-    size_t                dataSize;
+    size_t                dataSize;  // Size of the stored entry data, may be combined with BinaryCacheEntryCompressedFlag
 };
 
+// Set in BinaryCacheEntry::dataSize when the entry data starts with a CompressedBinaryCacheEntryHeader followed by the
+// compressed binary.  The remaining bits hold the stored (compressed) size.  Readers which don't know about compression
+// see an oversized entry and stop parsing the blob.
+constexpr size_t BinaryCacheEntryCompressedFlag = size_t(1) << ((sizeof(size_t) * 8) - 1);
+
+// Compression algorithms of compressed pipeline binary cache entries.
+enum class BinaryCacheCompression : uint32_t
+{
+    None = 0,  // Not compressed
+    Lz4  = 1,  // LZ4 block format
+};
+
+// Layout for the header of a compressed pipeline binary cache entry's data, all fields are written with LSB first.
+struct CompressedBinaryCacheEntryHeader
+{
+    uint32_t compression;       // A BinaryCacheCompression value
+    uint32_t reserved;          // Must be zero
+    uint64_t decompressedSize;  // Size of the binary after decompression
+};
+
+// Returns true if the entry data is compressed.
+inline bool IsCompressedBinaryCacheEntry(
+    const BinaryCacheEntry& entry)
+{
+    return ((entry.dataSize & BinaryCacheEntryCompressedFlag) != 0);
+}
+
+// Returns the number of bytes following the entry header in the blob.
+inline size_t GetBinaryCacheEntryStoredSize(
+    const BinaryCacheEntry& entry)
+{
+    return (entry.dataSize & ~BinaryCacheEntryCompressedFlag);
+}
+
+Util::Result GetBinaryCacheEntryDecompressedSize(
+    const BinaryCacheEntry* pEntry,
+    const void*             pData,
+    size_t*                 pDecompressedSize);
+
+Util::Result DecompressBinaryCacheEntry(
+    const BinaryCacheEntry* pEntry,
+    const void*             pData,
+    size_t                  outputSize,
+    void*                   pOutput);
+
+size_t CompressLz4Block(
+    const void* pSrc,
+    size_t      srcSize,
+    void*       pDst,
+    size_t      dstCapacity);
+
+bool DecompressLz4Block(
+    const void* pSrc,
+    size_t      srcSize,
+    void*       pDst,
+    size_t      dstSize);
+
 // Layout for pipeline binary cache header, all fields are written with LSB first.
 constexpr size_t SHA_DIGEST_LENGTH = 20;
 struct PipelineBinaryCachePrivateHeader
@@ -136,28 +193,49 @@ public:
 
     Util::Result Initialize(
         size_t bufferCapacity,
-        void*  pOutputBuffer);
+        void*  pOutputBuffer,
+        bool   compressEntries = false);
+
+    Util::Result InitializeAppend(
+        size_t bufferCapacity,
+        void*  pOutputBuffer,
+        size_t bytesUsed,
+        bool   compressEntries = false);
 
     Util::Result AddPipelineBinary(
         const BinaryCacheEntry* pEntry,
         const void*             pData);
 
+    Util::Result AddStoredPipelineBinary(
+        const BinaryCacheEntry* pEntry,
+        const void*             pData);
+
     Util::Result Finalize(
         VkAllocationCallbacks*    pAllocationCallbacks,
         const Util::IPlatformKey* pKey,
         size_t*                   pCacheEntriesWritten,
         size_t*                   pBytesWritten);
 
+    size_t GetBytesUsed() const { return m_bytesUsed; }
+
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(PipelineBinaryCacheSerializer);
 
     static constexpr size_t HeaderSize      = sizeof(PipelineBinaryCachePrivateHeader);
     static constexpr size_t EntryHeaderSize = sizeof(BinaryCacheEntry);
 
-    size_t m_numEntries     = 0;
-    void*  m_pOutputBuffer  = nullptr;
-    size_t m_bufferCapacity = 0;
-    size_t m_bytesUsed      = 0;
+    // Entries smaller than this are always stored uncompressed.
+    static constexpr size_t MinCompressedEntrySize = 256;
+
+    bool AddCompressedPipelineBinary(
+        const BinaryCacheEntry* pEntry,
+        const void*             pData);
+
+    size_t m_numEntries      = 0;
+    bool   m_compressEntries = false;
+    void*  m_pOutputBuffer   = nullptr;
+    size_t m_bufferCapacity  = 0;
+    size_t m_bytesUsed       = 0;
 };
 
 }
@@ -33,6 +33,10 @@
 #include "vkgcDefs.h"
 #include "include/vk_utils.h"
 
+#include "palMetroHash.h"
+
+#include <atomic>
+
 namespace vk
 {
 using namespace Vkgc;
@@ -40,6 +44,11 @@ using namespace Vkgc;
 class PipelineBinaryCache;
 
 // An adapter class that implements ICache in terms of a simple Get/Set interface.
+//
+// Entries which are known to be complete are additionally published in a fixed-size, insert-only table which is probed
+// without taking any lock, so that concurrent compiler threads looking up the same internal cache entries don't
+// serialize on the cache layers.  A published entry holds a reference on the underlying cache entry for the lifetime of
+// the adapter, which keeps its data pointer valid.
 class CacheAdapter : public ICache
 {
 public:
@@ -69,12 +78,49 @@ public:
                             const void** ppData,
                             size_t* pDataLen) override;
 
+    static constexpr uint32_t SnapshotSlotCount  = 4096;               // Must be a power of two
+    static constexpr uint32_t SnapshotProbeLimit = 8;                  // Slots probed before giving up
+    static constexpr size_t   SnapshotMaxBytes   = 64 * 1024 * 1024;   // Upper bound on the data kept pinned
+
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(CacheAdapter);
 
+    // One slot of the lock-free snapshot table.  A slot goes from Empty to Writing once, under a compare-and-swap, and
+    // then from Writing to Ready (or back to Empty if publishing fails); a Ready slot is never modified again.
+    struct SnapshotSlot
+    {
+        enum : uint32_t
+        {
+            Empty   = 0,
+            Writing = 1,
+            Ready   = 2,
+        };
+
+        std::atomic<uint32_t> state;
+        Util::MetroHash::Hash cacheId;   // Hash of the LLPC hash ID
+        const void*           pData;     // Data of the pinned cache entry
+        size_t                dataSize;  // Size of the pinned data in bytes
+        Util::QueryResult*    pQuery;    // Query which holds the reference on the cache entry
+    };
+
     explicit CacheAdapter(PipelineBinaryCache* pPipelineBinaryCache);
 
+    static void HashIdToCacheId(HashId hashId, Util::MetroHash::Hash* pCacheId);
+
+    const SnapshotSlot* FindSnapshot(const Util::MetroHash::Hash& cacheId) const;
+    void PublishSnapshot(const Util::MetroHash::Hash& cacheId, const Util::QueryResult* pQuery);
+
+    // Snapshot handles are tagged so that they can be told apart from handles which own a Util::QueryResult.
+    static bool IsSnapshotHandle(RawEntryHandle rawHandle)
+        { return (reinterpret_cast<uintptr_t>(rawHandle) & 1) != 0; }
+    static RawEntryHandle ToSnapshotHandle(const SnapshotSlot* pSlot)
+        { return reinterpret_cast<RawEntryHandle>(reinterpret_cast<uintptr_t>(pSlot) | 1); }
+    static const SnapshotSlot* FromSnapshotHandle(RawEntryHandle rawHandle)
+        { return reinterpret_cast<const SnapshotSlot*>(reinterpret_cast<uintptr_t>(rawHandle) & ~uintptr_t(1)); }
+
     PipelineBinaryCache* m_pPipelineBinaryCache;
+    SnapshotSlot*        m_pSnapshotSlots;     // Lock-free table of complete entries, may be nullptr
+    std::atomic<size_t>  m_snapshotBytes;      // Bytes pinned by published entries
 };
 
 } // namespace vk
@@ -0,0 +1,89 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  cmd_upload_ring.h
+* @brief Declaration of the upload ring command buffers stage inline data through.
+***********************************************************************************************************************
+*/
+#ifndef __CMD_UPLOAD_RING_H__
+#define __CMD_UPLOAD_RING_H__
+
+#pragma once
+
+#include "include/khronos/vulkan.h"
+#include "include/vk_utils.h"
+#include "include/internal_mem_mgr.h"
+
+namespace vk
+{
+
+class Device;
+
+// =====================================================================================================================
+// Persistently mapped, write-combined GART memory a command buffer copies inline data into (e.g. vkCmdUpdateBuffer)
+// so that the GPU can copy it from there instead of the data being embedded in the command stream.  The ring grows by
+// fixed-size chunks.  The GPU may read an upload until the command buffer is reset, re-begun or destroyed, which the
+// application may only do once the command buffer is no longer pending, so that is when the space is reclaimed;
+// chunks are kept for the next recording and only given back with the command buffer's resources.
+class CmdUploadRing
+{
+public:
+    // Largest upload the ring takes; vkCmdUpdateBuffer is limited to 64 KiB
+    static constexpr Pal::gpusize ChunkSize = 256 * 1024;
+
+    explicit CmdUploadRing(Device* pDevice);
+
+    VkResult Upload(
+        uint32_t               deviceMask,
+        Pal::gpusize           size,
+        const void*            pData,
+        const InternalMemory** ppMemory,
+        Pal::gpusize*          pOffset);
+
+    void Reset();
+
+    void Destroy();
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(CmdUploadRing);
+
+    struct Chunk
+    {
+        InternalMemory memory;
+        Chunk*         pNext;
+    };
+
+    VkResult AllocChunk(Chunk** ppChunk);
+
+    Device* const m_pDevice;
+    Chunk*        m_pFirstChunk; // All chunks of the ring, in order of use
+    Chunk*        m_pCurChunk;   // Chunk uploads are currently taken from, or null if none since the last reset
+    Pal::gpusize  m_curOffset;   // First free byte in the current chunk
+};
+
+} // namespace vk
+
+#endif /* __CMD_UPLOAD_RING_H__ */
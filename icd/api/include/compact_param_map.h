@@ -0,0 +1,294 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  compact_param_map.h
+* @brief Open-addressed hash map for small POD keys and values, used by the render state cache and border colors.
+***********************************************************************************************************************
+*/
+#ifndef __COMPACT_PARAM_MAP_H__
+#define __COMPACT_PARAM_MAP_H__
+
+#pragma once
+
+#include "include/vk_instance.h"
+
+#include <string.h>
+
+namespace vk
+{
+
+// =====================================================================================================================
+// A linear-probing hash map storing POD keys and values inline in a single allocation.  Keys are hashed and compared
+// bytewise, the same as Util::HashMap with Util::JenkinsHashFunc and Util::DefaultEqualFunc.
+//
+// Unlike Util::HashMap, whose chained groups are never released until the map is destroyed, this map rehashes into a
+// smaller table when erasing leaves it mostly empty.  Memory therefore tracks the number of live entries even when
+// pipelines with unique state are constantly created and destroyed.
+//
+// Pointers returned by FindKey() and FindAllocate() are invalidated by the next FindAllocate() or Erase().  This class
+// is not thread-safe; FindKey() is const and may be called concurrently with other FindKey() calls.
+template<typename Key, typename Value>
+class CompactParamMap
+{
+public:
+    CompactParamMap(Instance* pInstance)
+        :
+        m_pInstance(pInstance),
+        m_pSlots(nullptr),
+        m_pStates(nullptr),
+        m_capacity(0),
+        m_numEntries(0),
+        m_numTombstones(0)
+    {
+    }
+
+    ~CompactParamMap()
+    {
+        m_pInstance->FreeMem(m_pSlots);
+    }
+
+    // Allocates the initial table.
+    Pal::Result Init()
+    {
+        return Rehash(MinCapacity);
+    }
+
+    // Returns a pointer to the value mapped to the given key, or nullptr if there is none.
+    Value* FindKey(const Key& key) const
+    {
+        Value* pValue = nullptr;
+
+        const uint32_t slot = FindSlot(key);
+
+        if (slot != InvalidSlot)
+        {
+            pValue = &m_pSlots[slot].value;
+        }
+
+        return pValue;
+    }
+
+    // Returns the value mapped to the given key.  If no such mapping exists, a new uninitialized value is inserted.
+    Pal::Result FindAllocate(
+        const Key& key,
+        bool*      pExisted,
+        Value**    ppValue)
+    {
+        Pal::Result result = Pal::Result::Success;
+
+        uint32_t slot = FindSlot(key);
+
+        *pExisted = (slot != InvalidSlot);
+
+        if (slot == InvalidSlot)
+        {
+            // Keep the table at most 3/4 full counting tombstones, so probe sequences stay short and always end.
+            if (((m_numEntries + m_numTombstones + 1) * 4) > (m_capacity * 3))
+            {
+                result = Rehash(((m_numEntries + 1) * 2 > m_capacity) ? (m_capacity * 2) : m_capacity);
+            }
+
+            if (result == Pal::Result::Success)
+            {
+                slot = InsertSlot(key);
+
+                memset(&m_pSlots[slot].value, 0, sizeof(Value));
+            }
+        }
+
+        if (result == Pal::Result::Success)
+        {
+            *ppValue = &m_pSlots[slot].value;
+        }
+
+        return result;
+    }
+
+    // Removes the mapping for the given key.  Shrinks the table once it is less than 1/8 full.
+    bool Erase(const Key& key)
+    {
+        const uint32_t slot = FindSlot(key);
+
+        if (slot != InvalidSlot)
+        {
+            m_pStates[slot] = SlotTombstone;
+
+            m_numEntries--;
+            m_numTombstones++;
+
+            if ((m_capacity > MinCapacity) && ((m_numEntries * 8) < m_capacity))
+            {
+                // A failed shrink is harmless; the current table stays valid.
+                Rehash(m_capacity / 2);
+            }
+        }
+
+        return (slot != InvalidSlot);
+    }
+
+    uint32_t GetNumEntries() const
+        { return m_numEntries; }
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(CompactParamMap);
+
+    enum : uint32_t
+    {
+        MinCapacity  = 16,
+        InvalidSlot  = UINT32_MAX
+    };
+
+    enum : uint8_t
+    {
+        SlotEmpty     = 0,
+        SlotOccupied  = 1,
+        SlotTombstone = 2
+    };
+
+    struct Slot
+    {
+        Key   key;
+        Value value;
+    };
+
+    // 32-bit FNV-1a over the key's bytes.
+    static uint32_t HashKey(const Key& key)
+    {
+        const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(&key);
+
+        uint32_t hash = 2166136261u;
+
+        for (size_t i = 0; i < sizeof(Key); ++i)
+        {
+            hash = (hash ^ pBytes[i]) * 16777619u;
+        }
+
+        return hash;
+    }
+
+    uint32_t FindSlot(const Key& key) const
+    {
+        uint32_t found = InvalidSlot;
+
+        if (m_capacity > 0)
+        {
+            const uint32_t mask = m_capacity - 1;
+
+            uint32_t slot = HashKey(key) & mask;
+
+            while ((m_pStates[slot] != SlotEmpty) && (found == InvalidSlot))
+            {
+                if ((m_pStates[slot] == SlotOccupied) && (memcmp(&m_pSlots[slot].key, &key, sizeof(Key)) == 0))
+                {
+                    found = slot;
+                }
+
+                slot = (slot + 1) & mask;
+            }
+        }
+
+        return found;
+    }
+
+    // Places a key known not to be in the map into the first free slot of its probe sequence.
+    uint32_t InsertSlot(const Key& key)
+    {
+        const uint32_t mask = m_capacity - 1;
+
+        uint32_t slot = HashKey(key) & mask;
+
+        while (m_pStates[slot] == SlotOccupied)
+        {
+            slot = (slot + 1) & mask;
+        }
+
+        if (m_pStates[slot] == SlotTombstone)
+        {
+            m_numTombstones--;
+        }
+
+        m_pStates[slot]     = SlotOccupied;
+        m_pSlots[slot].key  = key;
+
+        m_numEntries++;
+
+        return slot;
+    }
+
+    // Moves all live entries into a freshly allocated table of the given power-of-two capacity.
+    Pal::Result Rehash(uint32_t newCapacity)
+    {
+        Pal::Result result = Pal::Result::Success;
+
+        const size_t slotBytes = sizeof(Slot) * newCapacity;
+
+        void* pMemory = m_pInstance->AllocMem(slotBytes + newCapacity, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+        if (pMemory != nullptr)
+        {
+            Slot*          pOldSlots    = m_pSlots;
+            const uint8_t* pOldStates   = m_pStates;
+            const uint32_t oldCapacity  = m_capacity;
+
+            m_pSlots        = static_cast<Slot*>(pMemory);
+            m_pStates       = static_cast<uint8_t*>(Util::VoidPtrInc(pMemory, slotBytes));
+            m_capacity      = newCapacity;
+            m_numEntries    = 0;
+            m_numTombstones = 0;
+
+            memset(m_pStates, SlotEmpty, newCapacity);
+
+            for (uint32_t i = 0; i < oldCapacity; ++i)
+            {
+                if (pOldStates[i] == SlotOccupied)
+                {
+                    const uint32_t slot = InsertSlot(pOldSlots[i].key);
+
+                    m_pSlots[slot].value = pOldSlots[i].value;
+                }
+            }
+
+            m_pInstance->FreeMem(pOldSlots);
+        }
+        else
+        {
+            result = Pal::Result::ErrorOutOfMemory;
+        }
+
+        return result;
+    }
+
+    Instance* const m_pInstance;
+    Slot*           m_pSlots;         // Key/value storage; the slot state bytes follow in the same allocation
+    uint8_t*        m_pStates;        // Per-slot SlotEmpty/SlotOccupied/SlotTombstone
+    uint32_t        m_capacity;       // Number of slots (power of two)
+    uint32_t        m_numEntries;     // Number of live entries
+    uint32_t        m_numTombstones;  // Number of erased slots that still break probe sequences
+};
+
+} // namespace vk
+
+#endif /* __COMPACT_PARAM_MAP_H__ */
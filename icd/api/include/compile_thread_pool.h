@@ -0,0 +1,115 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  compile_thread_pool.h
+* @brief Declaration of a driver-owned worker pool used to compile the entries of a batched pipeline create call.
+***********************************************************************************************************************
+*/
+#ifndef __COMPILE_THREAD_POOL_H__
+#define __COMPILE_THREAD_POOL_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "palThread.h"
+#include "palMutex.h"
+#include "palEvent.h"
+
+namespace vk
+{
+
+class Instance;
+
+// =====================================================================================================================
+// A small fixed-size pool of worker threads which executes batches of independent tasks.  A batch is described by a
+// task function and a task count; every index in [0, taskCount) is executed exactly once, either by one of the workers
+// or by the thread which submitted the batch.  The submitting thread always participates in the batch and Execute()
+// does not return until all of its tasks are complete, so callers see plain synchronous semantics.
+class CompileThreadPool
+{
+public:
+    typedef void (*TaskFunc)(void* pPayload, uint32_t taskIndex);
+
+    static CompileThreadPool* Create(
+        Instance* pInstance,
+        uint32_t  threadCount);
+
+    void Destroy();
+
+    void Execute(
+        TaskFunc pfnTask,
+        void*    pPayload,
+        uint32_t taskCount);
+
+    VK_INLINE uint32_t GetThreadCount() const
+        { return m_threadCount; }
+
+    static constexpr uint32_t MaxThreads = 16;  // Upper bound on the number of worker threads
+
+private:
+    PAL_DISALLOW_DEFAULT_CTOR(CompileThreadPool);
+    PAL_DISALLOW_COPY_AND_ASSIGN(CompileThreadPool);
+
+    // A batch of tasks submitted by a single Execute() call.  Lives on the submitting thread's stack and is linked into
+    // the pool's pending list until its last task has been claimed.
+    struct Batch
+    {
+        TaskFunc     pfnTask;         // Function executed for each task index
+        void*        pPayload;        // Opaque data passed to pfnTask
+        uint32_t     taskCount;       // Total number of tasks in the batch
+        uint32_t     nextTask;        // Index of the next unclaimed task (protected by m_lock)
+        uint32_t     completedTasks;  // Number of tasks which have finished executing (protected by m_lock)
+        Util::Event* pDoneEvent;      // Signaled when completedTasks reaches taskCount
+        Batch*       pNext;           // Next batch in the pending list
+    };
+
+    CompileThreadPool(Instance* pInstance);
+
+    VkResult Init(uint32_t threadCount);
+
+    static void ThreadFunc(void* pParam);
+
+    void WorkerLoop();
+
+    bool ClaimTask(Batch* pBatch, uint32_t* pTaskIndex);
+    bool ClaimPendingTask(Batch** ppBatch, uint32_t* pTaskIndex);
+    void CompleteTask(Batch* pBatch);
+    bool IsBatchDone(Batch* pBatch);
+    void UnlinkBatch(Batch* pBatch);
+
+    Instance* const m_pInstance;
+    uint32_t        m_threadCount;                  // Number of worker threads that were started
+    Util::Thread    m_threads[MaxThreads];          // Worker threads
+    Util::Mutex     m_lock;                         // Protects the pending batch list and batch counters
+    Util::Event     m_wakeEvent;                    // Signaled when there is pending work or the pool is stopping
+    Batch*          m_pPendingHead;                 // Batches which still have unclaimed tasks
+    volatile bool   m_stop;                         // Set when the pool is destroyed
+};
+
+} // namespace vk
+
+#endif /* __COMPILE_THREAD_POOL_H__ */
@@ -34,6 +34,7 @@
 #include "include/khronos/vulkan.h"
 #include "include/vk_defines.h"
 #include "include/vk_utils.h"
+#include "include/pipeline_compile_stats.h"
 
 #include "vkgcDefs.h"
 
@@ -96,6 +97,9 @@ struct GraphicsPipelineCreateInfo
     Util::MetroHash::Hash                  basePipelineHash;
     PipelineCreationFeedback               pipelineFeedback;
     PipelineCreationFeedback               stageFeedback[ShaderStage::ShaderStageGfxCount];
+    PipelineCompileStats::Source           binarySource;
+    void*                                  pSpecBuffers[ShaderStage::ShaderStageGfxCount];
+    void*                                  pVertexInputBuffer;
 #if LLPC_CLIENT_INTERFACE_MAJOR_VERSION < 41
     Vkgc::ResourceMappingData              resourceMapping;
 #endif
@@ -115,6 +119,8 @@ struct ComputePipelineCreateInfo
     Util::MetroHash::Hash                  basePipelineHash;
     PipelineCreationFeedback               pipelineFeedback;
     PipelineCreationFeedback               stageFeedback;
+    PipelineCompileStats::Source           binarySource;
+    void*                                  pSpecBuffer;
 #if LLPC_CLIENT_INTERFACE_MAJOR_VERSION < 41
     Vkgc::ResourceMappingData              resourceMapping;
 #endif
@@ -0,0 +1,91 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  debug_name_table.h
+* @brief Per-device table of interned debug object names.
+***********************************************************************************************************************
+*/
+#ifndef __DEBUG_NAME_TABLE_H__
+#define __DEBUG_NAME_TABLE_H__
+
+#pragma once
+
+#include "include/compact_param_map.h"
+#include "include/vk_utils.h"
+
+#include "palMutex.h"
+
+namespace vk
+{
+
+class Device;
+
+// =====================================================================================================================
+// Keeps one copy of every distinct debug object name given to the device.  Engines name most of their objects, often
+// with a handful of distinct names, so objects which keep their name point into this table instead of each allocating
+// a copy.  Names are packed into large chunks and live until the device is destroyed.
+class DebugNameTable
+{
+public:
+    DebugNameTable(Device* pDevice);
+
+    VkResult Init();
+    void Destroy();
+
+    const char* Intern(const char* pName);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(DebugNameTable);
+
+    static constexpr size_t ChunkSize = 16 * 1024;
+
+    // A name, followed by its characters
+    struct InternedName
+    {
+        InternedName* pNext;  // Next name with the same hash
+
+        const char* Chars() const
+            { return reinterpret_cast<const char*>(this + 1); }
+    };
+
+    struct Chunk
+    {
+        Chunk* pNext;
+        size_t size;          // Bytes of name storage following this header
+        size_t used;
+    };
+
+    void* AllocStorage(size_t size);
+
+    Device*                                 m_pDevice;
+    Util::Mutex                             m_lock;       // Serializes access to the map and the chunks
+    CompactParamMap<uint64_t, InternedName*> m_names;     // Hash of the characters to the names with that hash
+    Chunk*                                  m_pChunks;    // Chunk names are currently added to, followed by all others
+};
+
+} // namespace vk
+
+#endif /* __DEBUG_NAME_TABLE_H__ */
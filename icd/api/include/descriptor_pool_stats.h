@@ -0,0 +1,86 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  descriptor_pool_stats.h
+* @brief Declaration of the device-wide descriptor pool memory statistics.
+***********************************************************************************************************************
+*/
+#ifndef __DESCRIPTOR_POOL_STATS_H__
+#define __DESCRIPTOR_POOL_STATS_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+namespace Util
+{
+class JsonWriter;
+}
+
+namespace vk
+{
+
+// =====================================================================================================================
+// Lock-free counters describing the GPU memory use of all descriptor pools of a device.  Pools are externally
+// synchronized and keep their own counters; they only report into these when the state of an allocate, free or reset
+// call changed, so the device-wide numbers cost at most a few atomic adds per call.
+//
+// Reserved bytes are what the pools sized their GPU memory to at creation, used bytes what their live and cached sets
+// occupy.  For destroyed pools the peak use is kept next to the reservation to show how far pools were oversized.
+class DescriptorPoolStats
+{
+public:
+    DescriptorPoolStats();
+
+    void RecordPoolCreate(uint64_t reservedBytes);
+
+    void RecordPoolDestroy(uint64_t reservedBytes, uint64_t peakUsedBytes);
+
+    void RecordUsage(int64_t liveSetDelta, int64_t usedByteDelta);
+
+    void RecordAllocs(uint32_t setCount);
+
+    void RecordAllocFailure();
+
+    void Write(Util::JsonWriter* pWriter) const;
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(DescriptorPoolStats);
+
+    volatile uint64_t m_poolsCreated;            // Pools created over the device's lifetime
+    volatile uint64_t m_livePools;               // Pools currently alive
+    volatile uint64_t m_reservedBytes;           // GPU memory reserved by the live pools
+    volatile uint64_t m_usedBytes;               // GPU memory occupied by sets of the live pools
+    volatile uint64_t m_liveSets;                // Sets currently allocated from the live pools
+    volatile uint64_t m_setsAllocated;           // Sets allocated over the device's lifetime
+    volatile uint64_t m_allocFailures;           // vkAllocateDescriptorSets calls that ran out of pool memory
+    volatile uint64_t m_retiredReservedBytes;    // GPU memory reserved by the destroyed pools
+    volatile uint64_t m_retiredPeakUsedBytes;    // Sum of the peak GPU memory use of the destroyed pools
+};
+
+} // namespace vk
+
+#endif /* __DESCRIPTOR_POOL_STATS_H__ */
@@ -0,0 +1,194 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  device_group_cmd_stream.h
+* @brief Records commands of device group command buffers once and replays them to each device's PAL command buffer.
+***********************************************************************************************************************
+*/
+#ifndef __DEVICE_GROUP_CMD_STREAM_H__
+#define __DEVICE_GROUP_CMD_STREAM_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "palCmdBuffer.h"
+
+namespace vk
+{
+
+class CompileThreadPool;
+class Instance;
+
+// =====================================================================================================================
+// Device-agnostic intermediate stream for command buffers recording to more than one PAL device.
+//
+// Instead of calling into every device's PAL command buffer for each draw, dispatch and user data write, the command
+// buffer appends the command once with the device mask it applies to.  User data which differs between devices is
+// stored per device and patched in during replay; everything else is shared.  The stream is replayed to the PAL
+// command buffers before anything else is recorded to them (see CmdBuffer::PalCmdBuffer()), when it fills up and when
+// the command buffer ends.  Long streams are replayed with one task per device on the compile thread pool, so PAL
+// builds the commands of all devices in parallel.
+class DeviceGroupCmdStream
+{
+public:
+    static DeviceGroupCmdStream* Create(
+        Instance*                      pInstance,
+        CompileThreadPool*             pThreadPool,
+        Pal::ICmdBuffer* const*        ppPalCmdBuffers,
+        uint32_t                       deviceCount);
+
+    void Destroy(Instance* pInstance);
+
+    VK_INLINE bool HasPendingCommands() const
+        { return (m_size > 0); }
+
+    // Drops the recorded commands without replaying them, e.g. when the command buffer is reset.
+    VK_INLINE void Discard()
+    {
+        m_size     = 0;
+        m_cmdCount = 0;
+    }
+
+    void Replay();
+
+    void CmdSetUserData(
+        uint32_t               deviceMask,
+        Pal::PipelineBindPoint bindPoint,
+        uint32_t               firstEntry,
+        uint32_t               entryCount,
+        size_t                 perDeviceStride,
+        const uint32_t*        pEntryValues);
+
+    void CmdDraw(
+        uint32_t deviceMask,
+        uint32_t firstVertex,
+        uint32_t vertexCount,
+        uint32_t firstInstance,
+        uint32_t instanceCount,
+        uint32_t drawId);
+
+    void CmdDrawIndexed(
+        uint32_t deviceMask,
+        uint32_t firstIndex,
+        uint32_t indexCount,
+        int32_t  vertexOffset,
+        uint32_t firstInstance,
+        uint32_t instanceCount,
+        uint32_t drawId);
+
+    void CmdDispatch(
+        uint32_t deviceMask,
+        uint32_t x,
+        uint32_t y,
+        uint32_t z);
+
+private:
+    PAL_DISALLOW_DEFAULT_CTOR(DeviceGroupCmdStream);
+    PAL_DISALLOW_COPY_AND_ASSIGN(DeviceGroupCmdStream);
+
+    // Size of the stream storage, which follows the object in the same allocation
+    static constexpr size_t StreamSize = 64 * 1024;
+
+    // Streams with fewer commands are replayed on the calling thread.
+    static constexpr uint32_t MinParallelCmds = 64;
+
+    enum class CmdType : uint32_t
+    {
+        SetUserData,
+        Draw,
+        DrawIndexed,
+        Dispatch
+    };
+
+    struct CmdHeader
+    {
+        CmdType  type;
+        uint32_t deviceMask;
+        uint32_t size;        // Size of the command including the header, in bytes
+    };
+
+    // Followed by entryCount values, or by entryCount values for each device if perDevice is set
+    struct SetUserDataCmd
+    {
+        CmdHeader              header;
+        Pal::PipelineBindPoint bindPoint;
+        uint32_t               firstEntry;
+        uint32_t               entryCount;
+        uint32_t               perDevice;
+    };
+
+    struct DrawCmd
+    {
+        CmdHeader header;
+        uint32_t  firstVertex;
+        uint32_t  vertexCount;
+        uint32_t  firstInstance;
+        uint32_t  instanceCount;
+        uint32_t  drawId;
+    };
+
+    struct DrawIndexedCmd
+    {
+        CmdHeader header;
+        uint32_t  firstIndex;
+        uint32_t  indexCount;
+        int32_t   vertexOffset;
+        uint32_t  firstInstance;
+        uint32_t  instanceCount;
+        uint32_t  drawId;
+    };
+
+    struct DispatchCmd
+    {
+        CmdHeader header;
+        uint32_t  x;
+        uint32_t  y;
+        uint32_t  z;
+    };
+
+    DeviceGroupCmdStream(
+        CompileThreadPool*      pThreadPool,
+        Pal::ICmdBuffer* const* ppPalCmdBuffers,
+        uint32_t                deviceCount);
+
+    void* AllocCmd(CmdType type, uint32_t deviceMask, size_t size);
+
+    void ReplayDevice(uint32_t deviceIdx) const;
+
+    static void ReplayTask(void* pPayload, uint32_t taskIndex);
+
+    CompileThreadPool* const      m_pThreadPool;      // Workers for parallel replay, or nullptr
+    Pal::ICmdBuffer* const* const m_ppPalCmdBuffers;  // The owning command buffer's per-device PAL command buffers
+    const uint32_t                m_deviceCount;
+    uint8_t* const                m_pStream;
+    size_t                        m_size;             // Bytes of the stream in use
+    uint32_t                      m_cmdCount;         // Commands recorded since the last replay
+};
+
+} // namespace vk
+
+#endif /* __DEVICE_GROUP_CMD_STREAM_H__ */
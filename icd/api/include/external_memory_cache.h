@@ -0,0 +1,123 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  external_memory_cache.h
+* @brief Per-device cache of the PAL objects of imported external memory handles.
+***********************************************************************************************************************
+*/
+#ifndef __EXTERNAL_MEMORY_CACHE_H__
+#define __EXTERNAL_MEMORY_CACHE_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "palGpuMemory.h"
+#include "palImage.h"
+#include "palMutex.h"
+
+namespace vk
+{
+
+class Device;
+
+// =====================================================================================================================
+// Identifies the allocation behind an external handle rather than the handle itself, which differs between imports.
+// Keys are zero-initialized before being filled so they can be compared with memcmp.
+struct ExternalMemoryKey
+{
+    uint64_t device;     // Device of the file a dma-buf fd refers to, 0 for handles which are global names
+    uint64_t object;     // Inode of the file a dma-buf fd refers to, or the global handle
+    uint64_t imageHash;  // Hash of the image open info for imports opened as an image, otherwise 0
+};
+
+// =====================================================================================================================
+// One open external allocation, shared by all memory objects importing it.  The PAL memory object, followed by the
+// PAL image if there is one, is placed right after this structure in the same system memory allocation.
+struct ExternalMemoryImport
+{
+    ExternalMemoryKey        key;
+    Pal::IGpuMemory*         pGpuMemory;   // PAL memory of the import, on the device's residency list
+    Pal::IImage*             pImage;       // PAL image of an import opened as an image, otherwise null
+    Pal::GpuMemoryCreateInfo createInfo;   // Properties PAL reported when the handle was opened
+    uint32_t                 refCount;     // Memory objects using the import
+    uint32_t                 mapCount;     // Memory objects which have the import mapped
+    void*                    pMappedData;  // CPU address of the mapped PAL memory while mapCount is non-zero
+    uint64_t                 releaseTime;  // Perf counter value at the time refCount dropped to zero
+    ExternalMemoryImport*    pNext;        // Next import of the cache
+};
+
+// =====================================================================================================================
+// Lets repeated imports of the same external allocation, e.g. a compositor importing the same dma-bufs every frame,
+// share one PAL memory object instead of opening the handle again.  Imports are refcounted by the memory objects
+// using them.  Once unused, up to ExternalMemoryImportCacheSize of them stay open for ExternalMemoryImportCacheMaxAge,
+// which also keeps the allocation of the exporter alive for that long.
+class ExternalMemoryCache
+{
+public:
+    ExternalMemoryCache(Device* pDevice);
+
+    void Init();
+    void Destroy();
+
+    VK_INLINE bool IsEnabled() const
+        { return m_enabled; }
+
+    static bool MakeKey(Pal::OsExternalHandle handle, uint64_t imageHash, ExternalMemoryKey* pKey);
+
+    ExternalMemoryImport* Acquire(const ExternalMemoryKey& key);
+
+    ExternalMemoryImport* CreateImport(const ExternalMemoryKey& key, size_t palObjectSize);
+    void AddImport(ExternalMemoryImport* pImport);
+    void FreeImport(ExternalMemoryImport* pImport);
+
+    void Release(ExternalMemoryImport* pImport);
+
+    Pal::Result Map(ExternalMemoryImport* pImport, void** ppData);
+    void Unmap(ExternalMemoryImport* pImport);
+
+    static VK_INLINE void* GetPalStorage(ExternalMemoryImport* pImport)
+        { return Util::VoidPtrInc(pImport, sizeof(ExternalMemoryImport)); }
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(ExternalMemoryCache);
+
+    void DestroyImport(ExternalMemoryImport* pImport);
+
+    void EvictUnused(uint64_t now);
+
+    Device*               m_pDevice;
+    Util::Mutex           m_lock;          // Serializes access to the import list and the counts
+    bool                  m_enabled;
+    uint32_t              m_maxUnused;     // Upper bound of m_unusedCount
+    uint64_t              m_maxAgeTicks;   // Perf counter ticks after which an unused import is closed
+    uint32_t              m_unusedCount;   // Imports no memory object uses
+    ExternalMemoryImport* m_pFirstImport;
+};
+
+} // namespace vk
+
+#endif /* __EXTERNAL_MEMORY_CACHE_H__ */
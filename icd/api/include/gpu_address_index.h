@@ -0,0 +1,149 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  gpu_address_index.h
+* @brief Declaration of the optional index from GPU virtual addresses to the buffers and images bound there.
+***********************************************************************************************************************
+*/
+#ifndef __GPU_ADDRESS_INDEX_H__
+#define __GPU_ADDRESS_INDEX_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "palMutex.h"
+
+namespace vk
+{
+
+class Device;
+
+// A GPU virtual address range a buffer or image is bound to
+struct GpuAddressRange
+{
+    Pal::gpusize gpuVirtAddr;
+    Pal::gpusize size;
+    const void*  pObject;    // Buffer or Image
+    VkObjectType objectType; // VK_OBJECT_TYPE_BUFFER or VK_OBJECT_TYPE_IMAGE
+};
+
+// =====================================================================================================================
+// Resolves GPU virtual addresses of the default device back to the buffers and images bound there, for page fault
+// forensics and memory tracing.  The ranges are kept in an array sorted by address in which every entry also holds the
+// highest end address of itself and all entries before it, so overlapping ranges of aliased resources are found by a
+// binary search followed by a short backward walk.
+//
+// Binds and destroys only append to unsorted lists; those are sorted and merged into the array when a lookup needs
+// it, or once they grow as large as the array, so recording stays cheap with millions of live objects.  A destroy
+// removes the ranges recorded for the object before it, even if the memory of the object is reused for a new one.
+class GpuAddressIndex
+{
+public:
+    explicit GpuAddressIndex(Device* pDevice);
+
+    void Init();
+    void Destroy();
+
+    VK_INLINE bool IsEnabled() const
+        { return m_enabled; }
+
+    VK_INLINE void Insert(
+        const void*  pObject,
+        VkObjectType objectType,
+        Pal::gpusize gpuVirtAddr,
+        Pal::gpusize size)
+    {
+        if (m_enabled && (size > 0))
+        {
+            InsertRange(pObject, objectType, gpuVirtAddr, size);
+        }
+    }
+
+    VK_INLINE void Remove(
+        const void* pObject)
+    {
+        if (m_enabled)
+        {
+            RemoveObject(pObject);
+        }
+    }
+
+    uint32_t Find(
+        Pal::gpusize     gpuVirtAddr,
+        uint32_t         maxRanges,
+        GpuAddressRange* pRanges);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(GpuAddressIndex);
+
+    static constexpr uint32_t MinMergeThreshold = 4096;
+
+    struct Entry
+    {
+        GpuAddressRange range;
+        Pal::gpusize    maxEnd;   // Highest end address of this and all earlier entries of the sorted array
+        uint64_t        serial;   // Order of the insert among all inserts and removes
+    };
+
+    struct Removal
+    {
+        const void* pObject;
+        uint64_t    serial;
+    };
+
+    void InsertRange(
+        const void*  pObject,
+        VkObjectType objectType,
+        Pal::gpusize gpuVirtAddr,
+        Pal::gpusize size);
+
+    void RemoveObject(const void* pObject);
+
+    bool Merge();
+
+    bool IsRemoved(const Entry& entry) const;
+
+    template<typename T>
+    bool Reserve(T** ppArray, uint32_t* pCapacity, uint32_t count);
+
+    Device* const m_pDevice;
+    bool          m_enabled;
+    Util::Mutex   m_lock;             // Protects everything below
+    uint64_t      m_serial;           // Serial of the next insert or remove
+    Entry*        m_pEntries;         // Ranges sorted by address
+    uint32_t      m_entryCount;
+    Entry*        m_pPending;         // Ranges inserted since the last merge, unsorted
+    uint32_t      m_pendingCount;
+    uint32_t      m_pendingCapacity;
+    Removal*      m_pRemovals;        // Objects destroyed since the last merge
+    uint32_t      m_removalCount;
+    uint32_t      m_removalCapacity;
+};
+
+} // namespace vk
+
+#endif /* __GPU_ADDRESS_INDEX_H__ */
@@ -0,0 +1,167 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  gpu_timing_table.h
+* @brief Declaration of the always-on GPU timing of command buffers and debug label regions.
+***********************************************************************************************************************
+*/
+#ifndef __GPU_TIMING_TABLE_H__
+#define __GPU_TIMING_TABLE_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+#include "include/internal_mem_mgr.h"
+
+#include "palMutex.h"
+
+namespace Pal
+{
+class ICmdBuffer;
+}
+
+namespace Util
+{
+class JsonWriter;
+}
+
+namespace vk
+{
+
+class Device;
+
+// One measured region, handed from a command buffer to the device-wide table
+struct GpuTimingSample
+{
+    const char* pName;  // Region name, only referenced for the duration of the call
+    uint64_t    us;     // GPU time of the region in microseconds
+};
+
+// =====================================================================================================================
+// Device-wide table of the GPU time spent per command buffer and per debug label region, keyed by the label name.
+// Command buffers hand in their samples in batches once the GPU is known to be done with them, so the table is only
+// locked once per recording.  Labels beyond MaxEntries distinct names are counted as dropped.
+class GpuTimingTable
+{
+public:
+    static GpuTimingTable* Create(Device* pDevice);
+
+    void Destroy();
+
+    void RecordSamples(const GpuTimingSample* pSamples, uint32_t sampleCount, uint32_t droppedCount);
+
+    void Write(Util::JsonWriter* pWriter) const;
+
+    // Longest label name kept, including the terminator; longer names are truncated
+    static constexpr uint32_t MaxNameLength = 64;
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(GpuTimingTable);
+
+    GpuTimingTable(Device* pDevice);
+
+    ~GpuTimingTable() { }
+
+    static constexpr uint32_t MaxEntries = 256;
+
+    struct Entry
+    {
+        char     name[MaxNameLength];
+        uint32_t nameHash;
+        uint64_t count;          // Number of samples
+        uint64_t totalUs;        // Sum of all samples
+        uint64_t maxUs;          // Largest sample
+        uint64_t lastUs;         // Most recent sample
+        uint64_t recentAvgUs;    // Moving average weighted towards the recent samples
+    };
+
+    Entry* FindOrAddEntry(const char* pName);
+
+    Device* const       m_pDevice;
+    mutable Util::Mutex m_lock;           // Serializes access to the entries
+    Entry               m_entries[MaxEntries];
+    uint32_t            m_entryCount;
+    uint64_t            m_droppedCount;   // Regions which didn't fit their command buffer or the table
+};
+
+// =====================================================================================================================
+// Per-command buffer state of the GPU timing table.  A top-of-pipe timestamp is written where a region begins and a
+// bottom-of-pipe one where it ends: around the whole command buffer and around each vkCmdBeginDebugUtilsLabelEXT /
+// vkCmdEndDebugUtilsLabelEXT pair.  The timestamps are read back without waiting the next time the command buffer is
+// begun, reset or destroyed, since the application must have waited for it by then.  Timestamps the GPU never wrote
+// (e.g. the command buffer was never submitted) are skipped.
+class GpuTimingCmdBufferState
+{
+public:
+    GpuTimingCmdBufferState(Device* pDevice, GpuTimingTable* pTable);
+
+    VkResult Init();
+
+    void Destroy();
+
+    void Begin(Pal::ICmdBuffer* pPalCmdBuffer, bool primary);
+
+    void End(Pal::ICmdBuffer* pPalCmdBuffer);
+
+    void LabelBegin(Pal::ICmdBuffer* pPalCmdBuffer, const char* pName);
+
+    void LabelEnd(Pal::ICmdBuffer* pPalCmdBuffer);
+
+    void Resolve();
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(GpuTimingCmdBufferState);
+
+    static constexpr uint32_t MaxRegions       = 64;
+    static constexpr uint32_t MaxLabelDepth    = 16;
+    static constexpr uint32_t InvalidSlot      = UINT32_MAX;
+    static constexpr uint64_t TimestampNotDone = UINT64_MAX;
+
+    struct Region
+    {
+        char     name[GpuTimingTable::MaxNameLength];
+        uint32_t beginSlot;  // Timestamp slot written where the region begins
+        uint32_t endSlot;    // Timestamp slot written where it ends, InvalidSlot while it is open
+    };
+
+    uint32_t BeginRegion(Pal::ICmdBuffer* pPalCmdBuffer, const char* pName);
+    void     EndRegion(Pal::ICmdBuffer* pPalCmdBuffer, uint32_t region);
+    void     WriteTimestamp(Pal::ICmdBuffer* pPalCmdBuffer, uint32_t slot, bool topOfPipe);
+
+    Device* const        m_pDevice;
+    GpuTimingTable* const m_pTable;
+    InternalMemory       m_timestampMem;               // Two timestamp slots per region
+    Region               m_regions[MaxRegions];
+    uint32_t             m_regionCount;
+    uint32_t             m_cmdBufRegion;               // Region covering the whole command buffer, or InvalidSlot
+    uint32_t             m_labelStack[MaxLabelDepth];  // Open label regions, innermost last
+    uint32_t             m_labelDepth;                 // Number of open labels, including those beyond MaxLabelDepth
+    uint32_t             m_droppedCount;               // Regions left out since the last resolve
+};
+
+} // namespace vk
+
+#endif /* __GPU_TIMING_TABLE_H__ */
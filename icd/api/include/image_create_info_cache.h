@@ -0,0 +1,135 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  image_create_info_cache.h
+* @brief Declaration of the cache of converted image create infos of recently created images.
+***********************************************************************************************************************
+*/
+#ifndef __IMAGE_CREATE_INFO_CACHE_H__
+#define __IMAGE_CREATE_INFO_CACHE_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+#include "include/app_resource_optimizer.h"
+
+#include "palImage.h"
+#include "palMutex.h"
+
+namespace vk
+{
+
+class Device;
+
+// =====================================================================================================================
+// Everything in a VkImageCreateInfo and its pNext chain which image creation depends on.  Keys are zero-initialized
+// before being filled so they can be compared with memcmp.
+struct ImageCreateInfoKey
+{
+    static constexpr uint32_t MaxViewFormats        = 8;
+    static constexpr uint32_t MaxQueueFamilyIndices = 4;
+
+    VkImageCreateFlags    flags;
+    VkImageType           imageType;
+    VkFormat              format;
+    VkExtent3D            extent;
+    uint32_t              mipLevels;
+    uint32_t              arrayLayers;
+    VkSampleCountFlagBits samples;
+    VkImageTiling         tiling;
+    VkImageUsageFlags     usage;
+    VkSharingMode         sharingMode;
+    VkImageLayout         initialLayout;
+    uint32_t              queueFamilyIndexCount;
+    uint32_t              hasQueueFamilyIndices;
+    uint32_t              queueFamilyIndices[MaxQueueFamilyIndices];
+    uint32_t              hasStencilUsage;
+    VkImageUsageFlags     stencilUsage;
+    uint32_t              hasViewFormatList;
+    uint32_t              viewFormatCount;
+    VkFormat              viewFormats[MaxViewFormats];
+};
+
+// =====================================================================================================================
+// The result of converting a VkImageCreateInfo for image creation.  It only depends on the create info and the device.
+struct ConvertedImageCreateInfo
+{
+    Pal::ImageCreateInfo palCreateInfo;   // pViewFormats points to viewFormats in copies returned by the cache
+    Pal::SwizzledFormat  viewFormats[ImageCreateInfoKey::MaxViewFormats];
+    uint32_t             imageFlags;      // Image::ImageFlags before the memory-related flags are added
+    VkImageUsageFlags    stencilUsage;
+    VkSharingMode        sharingMode;     // Sharing mode after settings overrides
+    ResourceOptimizerKey resourceKey;
+    size_t               palImageSize;    // System memory size of one PAL image, or 0 if not known yet
+    VkMemoryRequirements memReqs;         // Memory requirements of an image created from this info
+};
+
+// =====================================================================================================================
+// Remembers the converted create infos of recently created images, so that recreating images with an identical
+// description (transient render targets on a resolution change or when an application pools images) skips the
+// format, usage, metadata and resource optimizer decisions as well as the PAL image size and memory requirements
+// queries.  Only images without external memory, sparse binding or unknown pNext structures are cached.
+//
+// The cache is set-associative with a fixed number of entries; the least recently used entry of a set is replaced.
+class ImageCreateInfoCache
+{
+public:
+    explicit ImageCreateInfoCache(Device* pDevice);
+
+    void Init();
+
+    bool BuildKey(const VkImageCreateInfo* pCreateInfo, ImageCreateInfoKey* pKey) const;
+
+    bool Find(const ImageCreateInfoKey& key, ConvertedImageCreateInfo* pInfo);
+
+    void Insert(const ImageCreateInfoKey& key, const ConvertedImageCreateInfo& info);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(ImageCreateInfoCache);
+
+    static constexpr uint32_t SetCount      = 16;
+    static constexpr uint32_t EntriesPerSet = 4;
+
+    struct Entry
+    {
+        ImageCreateInfoKey       key;
+        ConvertedImageCreateInfo info;
+        uint64_t                 lastUse;  // Value of m_useCounter when the entry was last found or inserted; 0 if
+                                           // the entry is empty
+    };
+
+    static uint32_t HashKey(const ImageCreateInfoKey& key);
+
+    Device*     m_pDevice;
+    bool        m_enabled;
+    Util::Mutex m_lock;        // Serializes access to the entries
+    uint64_t    m_useCounter;
+    Entry       m_entries[SetCount][EntriesPerSet];
+};
+
+} // namespace vk
+
+#endif /* __IMAGE_CREATE_INFO_CACHE_H__ */
@@ -0,0 +1,159 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  image_layout_tracker.h
+* @brief Tracking of the PAL layouts images are left in by submitted command buffers.
+***********************************************************************************************************************
+*/
+#ifndef __IMAGE_LAYOUT_TRACKER_H__
+#define __IMAGE_LAYOUT_TRACKER_H__
+
+#pragma once
+
+#include "include/vk_conv.h"
+#include "include/vk_utils.h"
+
+#include "palCmdBuffer.h"
+#include "palMutex.h"
+
+namespace vk
+{
+
+class Device;
+class Image;
+class ImageLayoutTracker;
+class Memory;
+
+// =====================================================================================================================
+// PAL layouts an image was left in by the command buffers submitted so far.  Owned by the image and only accessed
+// under the lock of the device's ImageLayoutTracker.
+struct CommittedImageLayouts
+{
+    Pal::ImageLayout layouts[MaxPalAspectsPerMask];
+    uint32_t         generation;    // Tracker generation the layouts were committed in; 0 if they were never known
+    uint32_t         stableCount;   // Consecutive commits which left the image in the same layouts
+    bool             mispredicted;  // A command buffer was recorded for the wrong layouts; they are not predicted
+};
+
+// =====================================================================================================================
+// Per command buffer record of the layouts images are transitioned to, built while recording and committed to the
+// images when the command buffer is submitted.  Only barriers over every subresource of an image are tracked; any
+// other layout change makes the layouts of the image unknown.
+class ImageLayoutCmdBufferState
+{
+public:
+    // The tracked set is small and searched linearly.  Once it is full, images it has no room for make the layouts of
+    // all images unknown on submission.
+    static constexpr uint32_t MaxTrackedImages = 64;
+
+    // Transitions ImageLayoutTracker::Commit() may return for one command buffer
+    static constexpr uint32_t MaxFixupCount = MaxTrackedImages * MaxPalAspectsPerMask;
+
+    ImageLayoutCmdBufferState(ImageLayoutTracker* pTracker, bool predict);
+
+    void Reset();
+
+    bool FilterTransition(
+        const Image*            pImage,
+        bool                    fromUndefined,
+        uint32_t                rangeCount,
+        const Pal::SubresRange* pRanges,
+        const Pal::ImageLayout* pNewLayouts);
+
+    void Forget(const Image* pImage);
+
+    void Merge(const ImageLayoutCmdBufferState& nested);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(ImageLayoutCmdBufferState);
+
+    friend class ImageLayoutTracker;
+
+    struct TrackedImage
+    {
+        const Image*     pImage;
+        uint32_t         rangeCount;                              // 0 if the layouts of the image became unknown
+        uint32_t         predictedCount;                          // Number of predictedLayouts assumed at the start
+        Pal::SubresRange ranges[MaxPalAspectsPerMask];            // Every subresource of the image, per aspect
+        Pal::ImageLayout predictedLayouts[MaxPalAspectsPerMask];  // Layouts assumed when the command buffer starts
+        Pal::ImageLayout layouts[MaxPalAspectsPerMask];           // Layouts after the last tracked transition
+    };
+
+    TrackedImage* FindOrAdd(const Image* pImage, bool* pAdded);
+
+    ImageLayoutTracker* const m_pTracker;
+    const bool                m_predict;       // Layouts committed by earlier submissions may be assumed
+    TrackedImage              m_images[MaxTrackedImages];
+    uint32_t                  m_imageCount;
+    bool                      m_overflow;      // An image was transitioned without room to track it
+};
+
+// =====================================================================================================================
+// Keeps the PAL layouts each tracked image is left in by submitted command buffers, so that transitions out of
+// VK_IMAGE_LAYOUT_UNDEFINED into the layouts an image is already in can skip initializing its metadata again.
+//
+// Only images bound to their own dedicated, unshared memory are tracked: nothing else can alias their metadata, which
+// stays valid across such a transition even though the contents become undefined.  Within a command buffer the
+// layouts are known exactly.  Across command buffers the layouts committed when recording are a prediction, since
+// other command buffers may be submitted in between.  Submission checks every prediction, transitions the image into
+// the predicted layouts ahead of a command buffer which was recorded for the wrong ones and stops predicting for it.
+class ImageLayoutTracker
+{
+public:
+    explicit ImageLayoutTracker(Device* pDevice);
+
+    void Init();
+
+    VK_INLINE bool IsEnabled() const
+        { return m_enabled; }
+
+    bool IsCandidate(const Image* pImage, const Memory* pMemory) const;
+
+    bool PredictLayouts(
+        const Image*      pImage,
+        uint32_t          rangeCount,
+        Pal::ImageLayout* pLayouts);
+
+    uint32_t Commit(
+        const ImageLayoutCmdBufferState& state,
+        uint32_t                         maxFixupCount,
+        Pal::BarrierTransition*          pFixups);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(ImageLayoutTracker);
+
+    // Commits which have to leave an image in the same layouts before they are predicted
+    static constexpr uint32_t MinStableCommits = 2;
+
+    Device* const m_pDevice;
+    bool          m_enabled;
+    Util::Mutex   m_lock;        // Serializes access to the committed layouts of all images
+    uint32_t      m_generation;  // Committed layouts of older generations are unknown
+};
+
+} // namespace vk
+
+#endif /* __IMAGE_LAYOUT_TRACKER_H__ */
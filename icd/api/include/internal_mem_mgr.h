@@ -56,6 +56,7 @@ namespace vk
 class Device;
 class Instance;
 class InternalMemMgr;
+struct InternalMemorySlab;
 
 // Flags for describing internal memory allocations.
 union InternalMemCreateFlags
@@ -126,6 +127,7 @@ struct InternalMemoryPool
 
     Util::BuddyAllocator<PalAllocator>* pBuddyAllocator; // Buddy allocator used to sub-allocate
                                                          // from the pool
+    Util::Mutex*                        pBuddyAllocatorLock; // Lock of the pool list owning pBuddyAllocator
 };
 
 // =====================================================================================================================
@@ -188,6 +190,7 @@ private:
     Pal::gpusize        m_offset;                       // Offset within the memory pool the suballocation starts from
     Pal::gpusize        m_size;                         // Size of the suballocation
     Pal::gpusize        m_alignment;                    // Alignment of the suballocation
+    InternalMemorySlab* m_pSlab;                        // Slab the allocation is a slot of, or null if it isn't
 };
 
 // =====================================================================================================================
@@ -195,7 +198,8 @@ InternalMemory::InternalMemory()
     :
     m_offset(0),
     m_size(0),
-    m_alignment(0)
+    m_alignment(0),
+    m_pSlab(nullptr)
 {
     memset(&m_gpuVA,       0, sizeof(m_gpuVA));
     memset(&m_gpuShadowVA, 0, sizeof(m_gpuShadowVA));
@@ -251,8 +255,28 @@ public:
 
     VkResult CalcSubAllocationPool(const MemoryPoolProperties& poolProps, void** ppPoolInfo);
 
+    void WriteSlabStats(const char* pFilePath);
+
+    // Small sub-allocations are served from slabs of fixed-size slots instead of the buddy allocators
+    static constexpr uint32_t SlabClassCount = 4;
+
 private:
-    typedef Util::List<InternalMemoryPool, PalAllocator>                                               MemoryPoolList;
+    typedef Util::List<InternalMemoryPool, PalAllocator> MemoryPools;
+
+    // All memory pools sharing one set of pool properties.  Each list carries its own lock so that sub-allocations
+    // from unrelated pools (e.g. descriptor tables vs. query results) don't serialize against each other.
+    struct MemoryPoolList
+    {
+        explicit MemoryPoolList(PalAllocator* pAllocator) : pools(pAllocator), pPartialSlabs(), pFullSlabs() { }
+
+        Util::Mutex         lock;                          // Serializes access to the pools, their buddy allocators
+                                                           // and the slabs carved out of them
+        MemoryPools         pools;                         // Memory pools with these properties, most recently
+                                                           // created first
+        InternalMemorySlab* pPartialSlabs[SlabClassCount]; // Slabs with at least one free slot, per slot size
+        InternalMemorySlab* pFullSlabs[SlabClassCount];    // Slabs without free slots, per slot size
+    };
+
     typedef Util::HashMap<MemoryPoolProperties, MemoryPoolList*, PalAllocator, Util::JenkinsHashFunc>  MemoryPoolListMap;
 
     PAL_DISALLOW_COPY_AND_ASSIGN(InternalMemMgr);
@@ -263,6 +287,22 @@ private:
 
     void CheckProvidedSubAllocPoolInfo(const InternalMemCreateInfo& memInfo) const;
 
+    VkResult SubAllocate(
+        MemoryPoolList*              pPoolList,
+        const InternalMemCreateInfo& createInfo,
+        uint32_t                     allocMask,
+        InternalMemoryPool*          pPool,
+        Pal::gpusize*                pOffset);
+
+    VkResult AllocSlabSlot(
+        MemoryPoolList*              pPoolList,
+        uint32_t                     slabClass,
+        const InternalMemCreateInfo& createInfo,
+        uint32_t                     allocMask,
+        InternalMemory*              pInternalMemory);
+
+    void FreeSlabSlot(const InternalMemory* pInternalMemory);
+
     VkResult CreateMemoryPoolList(
         const MemoryPoolProperties& poolProps,
         MemoryPoolList**            ppNewList);
@@ -289,8 +329,9 @@ private:
     Pal::GpuMemoryHeapProperties m_heapProps[Pal::GpuHeapCount]; // Information about the memory heaps
 
     PalAllocator*       m_pSysMemAllocator; // Allocator object for system-memory allocations
-    Util::Mutex         m_allocatorLock;    // Serialize access to the memory manager to ensure thread-safety
+    Util::RWLock        m_poolListMapLock;  // Guards m_poolListMap only; each pool list has its own lock
     MemoryPoolListMap   m_poolListMap;      // Maintain a hash map of memory pool lists for each property combination
+    bool                m_slabsEnabled;     // Serve small sub-allocations from slabs (EnableInternalMemSlabs)
 
     MemoryPoolProperties m_commonPoolProps[InternalPoolCount]; // Commonly used pool properties
     void*                m_pCommonPools[InternalPoolCount];    // Commonly used memory pools
@@ -0,0 +1,136 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ **********************************************************************************************************************
+ * @file  vk_khr_dynamic_rendering.h
+ * @brief Header for VK_KHR_dynamic_rendering extension.  Only used until the bundled Khronos headers define it.
+ **********************************************************************************************************************
+ */
+#ifndef VK_KHR_DYNAMIC_RENDERING_H_
+#define VK_KHR_DYNAMIC_RENDERING_H_
+
+#ifndef VK_KHR_dynamic_rendering
+
+#include "vk_internal_ext_helper.h"
+
+#define VK_KHR_dynamic_rendering                         1
+#define VK_KHR_DYNAMIC_RENDERING_SPEC_VERSION            1
+#define VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME          "VK_KHR_dynamic_rendering"
+
+#define VK_KHR_DYNAMIC_RENDERING_EXTENSION_NUMBER        45
+
+#define VK_KHR_DYNAMIC_RENDERING_ENUM(type, offset) \
+    VK_EXTENSION_ENUM(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NUMBER, type, offset)
+
+typedef enum VkRenderingFlagBitsKHR
+{
+    VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR = 0x00000001,
+    VK_RENDERING_SUSPENDING_BIT_KHR                         = 0x00000002,
+    VK_RENDERING_RESUMING_BIT_KHR                           = 0x00000004,
+    VK_RENDERING_FLAG_BITS_MAX_ENUM_KHR                     = 0x7FFFFFFF
+} VkRenderingFlagBitsKHR;
+
+typedef VkFlags VkRenderingFlagsKHR;
+
+typedef struct VkRenderingAttachmentInfoKHR
+{
+    VkStructureType       sType;
+    const void*           pNext;
+    VkImageView           imageView;
+    VkImageLayout         imageLayout;
+    VkResolveModeFlagBits resolveMode;
+    VkImageView           resolveImageView;
+    VkImageLayout         resolveImageLayout;
+    VkAttachmentLoadOp    loadOp;
+    VkAttachmentStoreOp   storeOp;
+    VkClearValue          clearValue;
+} VkRenderingAttachmentInfoKHR;
+
+typedef struct VkRenderingInfoKHR
+{
+    VkStructureType                     sType;
+    const void*                         pNext;
+    VkRenderingFlagsKHR                 flags;
+    VkRect2D                            renderArea;
+    uint32_t                            layerCount;
+    uint32_t                            viewMask;
+    uint32_t                            colorAttachmentCount;
+    const VkRenderingAttachmentInfoKHR* pColorAttachments;
+    const VkRenderingAttachmentInfoKHR* pDepthAttachment;
+    const VkRenderingAttachmentInfoKHR* pStencilAttachment;
+} VkRenderingInfoKHR;
+
+typedef struct VkPipelineRenderingCreateInfoKHR
+{
+    VkStructureType sType;
+    const void*     pNext;
+    uint32_t        viewMask;
+    uint32_t        colorAttachmentCount;
+    const VkFormat* pColorAttachmentFormats;
+    VkFormat        depthAttachmentFormat;
+    VkFormat        stencilAttachmentFormat;
+} VkPipelineRenderingCreateInfoKHR;
+
+typedef struct VkPhysicalDeviceDynamicRenderingFeaturesKHR
+{
+    VkStructureType sType;
+    void*           pNext;
+    VkBool32        dynamicRendering;
+} VkPhysicalDeviceDynamicRenderingFeaturesKHR;
+
+typedef struct VkCommandBufferInheritanceRenderingInfoKHR
+{
+    VkStructureType       sType;
+    const void*           pNext;
+    VkRenderingFlagsKHR   flags;
+    uint32_t              viewMask;
+    uint32_t              colorAttachmentCount;
+    const VkFormat*       pColorAttachmentFormats;
+    VkFormat              depthAttachmentFormat;
+    VkFormat              stencilAttachmentFormat;
+    VkSampleCountFlagBits rasterizationSamples;
+} VkCommandBufferInheritanceRenderingInfoKHR;
+
+typedef void (VKAPI_PTR *PFN_vkCmdBeginRenderingKHR)(
+    VkCommandBuffer           commandBuffer,
+    const VkRenderingInfoKHR* pRenderingInfo);
+
+typedef void (VKAPI_PTR *PFN_vkCmdEndRenderingKHR)(
+    VkCommandBuffer commandBuffer);
+
+#define VK_STRUCTURE_TYPE_RENDERING_INFO_KHR \
+    VK_KHR_DYNAMIC_RENDERING_ENUM(VkStructureType, 0)
+#define VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR \
+    VK_KHR_DYNAMIC_RENDERING_ENUM(VkStructureType, 1)
+#define VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR \
+    VK_KHR_DYNAMIC_RENDERING_ENUM(VkStructureType, 2)
+#define VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR \
+    VK_KHR_DYNAMIC_RENDERING_ENUM(VkStructureType, 3)
+#define VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR \
+    VK_KHR_DYNAMIC_RENDERING_ENUM(VkStructureType, 4)
+
+#endif /* VK_KHR_dynamic_rendering */
+
+#endif /* VK_KHR_DYNAMIC_RENDERING_H_ */
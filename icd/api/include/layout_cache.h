@@ -0,0 +1,160 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  layout_cache.h
+* @brief Shares descriptor set layout and pipeline layout objects created from identical create infos.
+***********************************************************************************************************************
+*/
+#ifndef __LAYOUT_CACHE_H__
+#define __LAYOUT_CACHE_H__
+
+#pragma once
+
+#include "include/compact_param_map.h"
+#include "include/vk_alloccb.h"
+#include "include/vk_utils.h"
+
+#include "palMutex.h"
+#include "palVector.h"
+
+namespace vk
+{
+
+class Device;
+class Instance;
+
+// =====================================================================================================================
+// The contents of a layout create info, flattened to dwords so that two create infos can be compared exactly.  Objects
+// referenced by the create info are identified by their handles.
+class LayoutSignature
+{
+public:
+    explicit LayoutSignature(Instance* pInstance);
+
+    VK_INLINE void Append(uint32_t value)
+    {
+        m_valid = m_valid && (m_data.PushBack(value) == Util::Result::Success);
+    }
+
+    VK_INLINE void Append(uint64_t value)
+    {
+        Append(static_cast<uint32_t>(value));
+        Append(static_cast<uint32_t>(value >> 32));
+    }
+
+    // Returns false if the signature ran out of memory, in which case it must not be used
+    VK_INLINE bool IsValid() const
+        { return m_valid; }
+
+    VK_INLINE const uint32_t* GetData() const
+        { return m_data.Data(); }
+
+    VK_INLINE uint32_t GetSize() const
+        { return m_data.NumElements(); }
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(LayoutSignature);
+
+    Util::Vector<uint32_t, 64, PalAllocator> m_data;
+    bool                                     m_valid;
+};
+
+// Kinds of layout objects in the cache
+enum class LayoutType : uint32_t
+{
+    DescriptorSetLayout = 0,
+    PipelineLayout
+};
+
+// =====================================================================================================================
+// Device-level cache of the live descriptor set layouts and pipeline layouts, keyed on the API hash of their create
+// info.  Middleware tends to create the same layouts over and over (e.g. once per material); with the cache these
+// creates return the handle of the existing object instead of converting the create info into a new one.  Vulkan lets
+// non-dispatchable handles of distinct objects have the same value, provided the object stays valid until its handle
+// has been destroyed as many times as it was created, so each entry counts its creates and the object is destroyed
+// with the last reference.  A pipeline layout built from shared set layouts also shares its resource mapping template.
+//
+// Objects are only shared if they use the instance allocator, since a shared object may be destroyed with another
+// create's allocation callbacks, and only without private data, which is stored per handle value.  The API hash only
+// selects the candidate; each entry keeps the LayoutSignature of its create info, and an object is only shared with a
+// create whose signature is identical.
+class LayoutCache
+{
+public:
+    explicit LayoutCache(Device* pDevice);
+
+    void Init();
+
+    bool CanShare(const VkAllocationCallbacks* pAllocator) const;
+
+    void* Acquire(
+        LayoutType             type,
+        uint64_t               apiHash,
+        const LayoutSignature& signature);
+
+    void* Insert(
+        LayoutType             type,
+        uint64_t               apiHash,
+        const LayoutSignature& signature,
+        void*                  pObject);
+
+    bool Release(
+        LayoutType  type,
+        uint64_t    apiHash,
+        const void* pObject);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(LayoutCache);
+
+    // Zero-filled before use since it is compared bytewise
+    struct Key
+    {
+        uint64_t   apiHash;
+        LayoutType type;
+        uint32_t   reserved;
+    };
+
+    struct Entry
+    {
+        void*     pObject;
+        uint32_t* pSignature;      // Copy of the signature of the create info the object was created from
+        uint32_t  signatureSize;   // Number of dwords of the signature
+        uint32_t  refCount;        // Creates returning the object minus destroys of it
+    };
+
+    static Key MakeKey(LayoutType type, uint64_t apiHash);
+
+    static bool Matches(const Entry& entry, const LayoutSignature& signature);
+
+    Device* const                m_pDevice;
+    bool                         m_enabled;
+    Util::Mutex                  m_lock;     // Protects the map and the ref counts
+    CompactParamMap<Key, Entry>  m_entries;
+};
+
+} // namespace vk
+
+#endif /* __LAYOUT_CACHE_H__ */
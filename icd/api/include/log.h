@@ -32,6 +32,7 @@
 #define __LOG_H__
 #pragma once
 
+#include "include/async_log.h"
 #include "include/vk_utils.h"
 
 #include "palDbgPrint.h"
@@ -42,6 +43,7 @@ namespace vk
 enum LogTagId : uint32_t {
     GeneralPrint,
     PipelineCompileTime,
+    DrawValidation,
     LogTagIdCount
 };
 
@@ -49,13 +51,18 @@ static const char* LogTag[LogTagIdCount] =
 {
     "GeneralPrint",
     "PipelineCompileTime",
+    "DrawValidation",
 };
 
+// =====================================================================================================================
+// Logs a message of the given tag if the tag is enabled in logTagIdMask.  The message goes to the async log if one is
+// running (see AsyncLog), in which case pFormatStr must be a literal; it is printed to the PAL log file otherwise.
+template <typename... Args>
 static void AmdvlkLog(
     uint64_t          logTagIdMask,
     LogTagId          tagId,
     const char*       pFormatStr,
-    ...)
+    Args...           args)
 {
     VK_ASSERT(tagId < LogTagIdCount);
     if ((logTagIdMask & (1LLU << tagId)) == 0)
@@ -63,14 +70,19 @@ static void AmdvlkLog(
       return;
     }
 
-    va_list argList;
-    va_start(argList, pFormatStr);
-    va_end(argList);
+    AsyncLog* pAsyncLog = AsyncLog::GetActive();
 
+    if (pAsyncLog != nullptr)
+    {
+        pAsyncLog->Write(tagId, pFormatStr, args...);
+    }
 #if PAL_ENABLE_PRINTS_ASSERTS
-    Util::DbgPrintf(Util::DbgPrintCatMsgFile, Util::DbgPrintStyleNoPrefixNoCrLf, "%s-", LogTag[tagId]);
-    Util::DbgVPrintf(Util::DbgPrintCatMsgFile, Util::DbgPrintStyleNoPrefixNoCrLf, pFormatStr, argList);
-    Util::DbgPrintf(Util::DbgPrintCatMsgFile, Util::DbgPrintStyleNoPrefixNoCrLf, "\n");
+    else
+    {
+        Util::DbgPrintf(Util::DbgPrintCatMsgFile, Util::DbgPrintStyleNoPrefixNoCrLf, "%s-", LogTag[tagId]);
+        Util::DbgPrintf(Util::DbgPrintCatMsgFile, Util::DbgPrintStyleNoPrefixNoCrLf, pFormatStr, args...);
+        Util::DbgPrintf(Util::DbgPrintCatMsgFile, Util::DbgPrintStyleNoPrefixNoCrLf, "\n");
+    }
 #endif
 }
 } // namespace vk
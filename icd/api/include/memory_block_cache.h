@@ -0,0 +1,124 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  memory_block_cache.h
+* @brief Declaration of the cache of PAL memory objects of freed VkDeviceMemory allocations.
+***********************************************************************************************************************
+*/
+#ifndef __MEMORY_BLOCK_CACHE_H__
+#define __MEMORY_BLOCK_CACHE_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "palGpuMemory.h"
+#include "palMutex.h"
+
+namespace vk
+{
+
+class Device;
+
+// =====================================================================================================================
+// Everything a freed PAL memory object has to match for it to satisfy a new allocation.  Keys are zero-initialized
+// before being filled so they can be compared with memcmp.
+struct MemoryBlockKey
+{
+    Pal::gpusize              size;
+    Pal::gpusize              alignment;
+    Pal::GpuMemoryCreateFlags flags;
+    Pal::GpuMemPriority       priority;
+    Pal::GpuMemPriorityOffset priorityOffset;
+    uint32_t                  heapCount;
+    Pal::GpuHeap              heaps[Pal::GpuHeapCount];
+};
+
+// =====================================================================================================================
+// Keeps the PAL memory objects of recently freed VkDeviceMemory allocations around so that an allocate/free/allocate
+// pattern only pays for the kernel allocation once.  Blocks are bucketed by the log2 of their size and must match the
+// new allocation's key exactly.  The cache is bounded in total bytes and per bucket, and blocks that were not reused
+// within MemoryBlockCacheMaxAge are released the next time a block is put into the cache.
+//
+// Cached blocks stay counted in the device's allocated memory size, so memory budget tracking keeps seeing them as
+// used until they are either handed out again or released.
+class MemoryBlockCache
+{
+public:
+    MemoryBlockCache(Device* pDevice);
+
+    void Init();
+    void Destroy();
+
+    bool IsCacheable(const Pal::GpuMemoryCreateInfo& createInfo, uint32_t allocationMask) const;
+
+    static void MakeKey(const Pal::GpuMemoryCreateInfo& createInfo, MemoryBlockKey* pKey);
+
+    Pal::IGpuMemory* Acquire(const MemoryBlockKey& key);
+
+    bool Release(const MemoryBlockKey& key, Pal::IGpuMemory* pGpuMemory);
+
+    Pal::gpusize Trim(Pal::GpuHeap heap, Pal::gpusize size);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(MemoryBlockCache);
+
+    static constexpr uint32_t BucketCount       = 32;
+    static constexpr uint32_t EntriesPerBucket  = 8;
+
+    struct Entry
+    {
+        MemoryBlockKey   key;         // Properties the block was created with
+        Pal::IGpuMemory* pGpuMemory;  // PAL memory object, placed at the start of its own system memory allocation
+        uint64_t         releaseTime; // Perf counter value at the time the block entered the cache
+    };
+
+    struct Bucket
+    {
+        Entry    entries[EntriesPerBucket]; // Cached blocks, oldest first
+        uint32_t count;                     // Number of valid entries
+    };
+
+    static uint32_t GetBucketIndex(Pal::gpusize size);
+
+    void EvictEntry(Bucket* pBucket, uint32_t entryIdx, bool destroy);
+
+    void EvictExpired(uint64_t now);
+
+    bool EvictOldest();
+
+    Device*      m_pDevice;
+    Util::Mutex  m_lock;          // Serializes access to the buckets
+    Pal::gpusize m_maxBytes;      // Upper bound of m_cachedBytes; 0 if the cache is disabled
+    Pal::gpusize m_maxBlockSize;  // Largest block the cache takes
+    uint64_t     m_maxAgeTicks;   // Perf counter ticks after which an unused block is released
+    Pal::gpusize m_cachedBytes;   // Size of all cached blocks
+    Bucket       m_buckets[BucketCount];
+};
+
+} // namespace vk
+
+#endif /* __MEMORY_BLOCK_CACHE_H__ */
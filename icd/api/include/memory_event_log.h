@@ -0,0 +1,134 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  memory_event_log.h
+* @brief Declaration of the optional log of memory allocation, free and bind events.
+***********************************************************************************************************************
+*/
+#ifndef __MEMORY_EVENT_LOG_H__
+#define __MEMORY_EVENT_LOG_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "utils/per_thread_registry.h"
+
+#include "palFile.h"
+#include "palGpuMemory.h"
+#include "palMutex.h"
+
+namespace vk
+{
+
+class Device;
+
+// Kinds of events in the memory event log
+enum class MemoryEventType : uint32_t
+{
+    MemoryCreate = 0,   // vkAllocateMemory
+    MemoryFree,         // vkFreeMemory
+    InternalAlloc,      // Internal memory manager allocation
+    InternalFree,       // Internal memory manager free
+    BufferBind,         // vkBindBufferMemory
+    ImageBind,          // vkBindImageMemory
+    Count
+};
+
+// =====================================================================================================================
+// Timeline of the memory allocations, frees and binds of a device, for finding fragmentation and peak usage sources in
+// long sessions without a memory profiler attached.  Each thread records into a ring of its own without locking; a
+// full ring is appended to the log file as CSV, which is the only time the lock is taken.  Events of different threads
+// are therefore not in order in the file and have to be sorted by timestamp.
+class MemoryEventLog
+{
+public:
+    explicit MemoryEventLog(Device* pDevice);
+
+    void Init();
+    void Destroy();
+
+    VK_INLINE bool IsEnabled() const
+        { return m_enabled; }
+
+    VK_INLINE void Record(
+        MemoryEventType type,
+        const void*     pObject,
+        const void*     pMemory,
+        Pal::gpusize    size,
+        Pal::gpusize    offset,
+        Pal::GpuHeap    heap)
+    {
+        if (m_enabled)
+        {
+            RecordEvent(type, pObject, pMemory, size, offset, heap);
+        }
+    }
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(MemoryEventLog);
+
+    static constexpr uint32_t RingSize = 4096;
+
+    struct Event
+    {
+        int64_t         timestamp; // CPU ticks
+        const void*     pObject;   // Memory, InternalMemory, Buffer or Image the event is about
+        const void*     pMemory;   // Memory bound by bind events
+        Pal::gpusize    size;
+        Pal::gpusize    offset;
+        MemoryEventType type;
+        Pal::GpuHeap    heap;      // Preferred heap, or GpuHeapCount if unknown
+    };
+
+    struct ThreadRing
+    {
+        uint32_t count;            // Events not yet written
+        Event    events[RingSize];
+    };
+
+    void RecordEvent(
+        MemoryEventType type,
+        const void*     pObject,
+        const void*     pMemory,
+        Pal::gpusize    size,
+        Pal::gpusize    offset,
+        Pal::GpuHeap    heap);
+
+    void WriteRing(ThreadRing* pRing);
+
+    Device* const                         m_pDevice;
+    bool                                  m_enabled;
+    int64_t                               m_startTicks;    // Timestamps are written relative to this
+    int64_t                               m_perfFrequency; // CPU ticks per second
+    Util::Mutex                           m_lock;          // Protects the file
+    Util::File                            m_file;
+    utils::PerThreadRegistry<ThreadRing>  m_rings;         // Rings of all threads which recorded events
+};
+
+} // namespace vk
+
+#endif /* __MEMORY_EVENT_LOG_H__ */
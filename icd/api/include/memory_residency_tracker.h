@@ -0,0 +1,88 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  memory_residency_tracker.h
+* @brief Declaration of the tracker lowering the priority of idle VkDeviceMemory while over budget.
+***********************************************************************************************************************
+*/
+#ifndef __MEMORY_RESIDENCY_TRACKER_H__
+#define __MEMORY_RESIDENCY_TRACKER_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "palMutex.h"
+
+namespace vk
+{
+
+class Device;
+class Memory;
+
+// =====================================================================================================================
+// Lowers the PAL priority of device-local VkDeviceMemory which went unused for a while, but only while the local heaps
+// are over the budget reported through VK_EXT_memory_budget, so that the kernel evicts idle allocations first instead
+// of thrashing ones the application still needs.  Every allocation is resident, so there are no per-submit reference
+// lists to watch; an allocation counts as used when it is mapped or bound.  Time is counted in epochs of a fixed number
+// of queue submissions.  A demoted allocation gets its priority back on the first epoch it is used in again, or once
+// the heaps are within budget.
+class MemoryResidencyTracker
+{
+public:
+    explicit MemoryResidencyTracker(Device* pDevice);
+
+    void Init();
+
+    VK_INLINE bool IsEnabled() const
+        { return (m_submitsPerEpoch != 0); }
+
+    void Register(Memory* pMemory);
+    void Unregister(Memory* pMemory);
+
+    void Touch(Memory* pMemory) const;
+
+    void OnSubmit();
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(MemoryResidencyTracker);
+
+    bool IsLocalMemoryOverBudget() const;
+
+    void Age();
+
+    Device* const     m_pDevice;
+    uint32_t          m_submitsPerEpoch; // Queue submissions per epoch, 0 if the tracker is disabled
+    uint32_t          m_idleEpochs;      // Epochs without use after which an allocation may be demoted
+    volatile uint32_t m_submitCount;     // Queue submissions so far
+    volatile uint32_t m_epoch;           // Current epoch
+    Util::Mutex       m_lock;            // Protects the list and serializes aging passes
+    Memory*           m_pFirst;          // Tracked allocations
+};
+
+} // namespace vk
+
+#endif /* __MEMORY_RESIDENCY_TRACKER_H__ */
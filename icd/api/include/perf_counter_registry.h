@@ -0,0 +1,188 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  perf_counter_registry.h
+* @brief Declaration of the device-wide registry of driver performance counters and histograms.
+***********************************************************************************************************************
+*/
+#ifndef __PERF_COUNTER_REGISTRY_H__
+#define __PERF_COUNTER_REGISTRY_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include <atomic>
+
+namespace Util
+{
+class JsonWriter;
+}
+
+namespace vk
+{
+
+class Device;
+
+// Driver performance counters.  Counters only grow; gauges go up and down with the resources they track.
+enum class PerfCounter : uint32_t
+{
+    PipelineUserCacheHits = 0,  // Pipeline binaries found in the application's VkPipelineCache
+    PipelineInternalCacheHits,  // Pipeline binaries found in the driver's internal cache
+    PipelinesCompiled,          // Pipeline binaries which had to be compiled
+    DescriptorSetsLive,         // Gauge: descriptor sets currently allocated
+    DescriptorHeapBytes,        // Gauge: descriptor pool GPU memory currently used by sets
+    DescriptorAllocFailures,    // vkAllocateDescriptorSets calls which ran out of pool memory
+    DrawsRecorded,              // Draws recorded into command buffers which ended
+    DispatchesRecorded,         // Dispatches recorded into command buffers which ended
+    BarriersRecorded,           // vkCmdPipelineBarrier* and vkCmdWaitEvents* calls of command buffers which ended
+    RedundantStateFiltered,     // State setting calls which changed nothing and were dropped
+    Count
+};
+
+// Driver performance histograms, binned by powers of two
+enum class PerfHistogram : uint32_t
+{
+    SubmitCpuTimeUs = 0,        // Time the application thread spent in vkQueueSubmit*
+    PipelineCompileTimeUs,      // Time spent compiling each pipeline binary which wasn't cached
+    Count
+};
+
+constexpr uint32_t PerfCounterCount   = static_cast<uint32_t>(PerfCounter::Count);
+constexpr uint32_t PerfHistogramCount = static_cast<uint32_t>(PerfHistogram::Count);
+
+// A consistent-enough copy of all counters; each value is exact, but values are read one after the other
+struct PerfCounterSnapshot
+{
+    static constexpr uint32_t BucketCount = 40;  // Bucket 0 counts zeroes, bucket i samples in [2^(i-1), 2^i)
+
+    struct Histogram
+    {
+        uint64_t count;                 // Number of samples
+        uint64_t sum;                   // Sum of all samples
+        uint64_t buckets[BucketCount];  // Sample count per bucket; the last one also holds all larger samples
+    };
+
+    int64_t   counters[PerfCounterCount];
+    Histogram histograms[PerfHistogramCount];
+};
+
+// =====================================================================================================================
+// One place for the subsystems of a device to report counters to.  Each counter is a set of atomics sharded by thread,
+// so threads reporting at the same time mostly hit different cache lines; readers add the shards up.  A disabled
+// registry costs one test of a pointer per report, and building with ICD_PERF_COUNTERS off compiles the reports out.
+// The counters can be read with Read(), are written to PerfCountersFile as JSON when the device is destroyed, and are
+// served to developer mode tools under the "perfcounters" URI.
+class PerfCounterRegistry
+{
+public:
+    explicit PerfCounterRegistry(Device* pDevice);
+
+    VkResult Init();
+    void Destroy();
+
+    VK_INLINE bool IsEnabled() const
+    {
+#if ICD_PERF_COUNTERS
+        return (m_pShards != nullptr);
+#else
+        return false;
+#endif
+    }
+
+    VK_INLINE void Add(
+        PerfCounter counter,
+        int64_t     value = 1)
+    {
+#if ICD_PERF_COUNTERS
+        if (m_pShards != nullptr)
+        {
+            GetShard()->counters[static_cast<uint32_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+        }
+#endif
+    }
+
+    VK_INLINE void Sample(
+        PerfHistogram histogram,
+        uint64_t      value)
+    {
+#if ICD_PERF_COUNTERS
+        if (m_pShards != nullptr)
+        {
+            AddSample(histogram, value);
+        }
+#endif
+    }
+
+    void Read(PerfCounterSnapshot* pSnapshot) const;
+
+    void Write(Util::JsonWriter* pWriter) const;
+
+    static const char* GetName(PerfCounter counter);
+    static const char* GetName(PerfHistogram histogram);
+    static bool IsGauge(PerfCounter counter);
+
+    static uint64_t GetBucketUpperBound(uint32_t bucket);
+
+private:
+    PAL_DISALLOW_DEFAULT_CTOR(PerfCounterRegistry);
+    PAL_DISALLOW_COPY_AND_ASSIGN(PerfCounterRegistry);
+
+    static constexpr uint32_t ShardCount = 16;  // Must be a power of two
+
+    struct Shard
+    {
+        std::atomic<int64_t>  counters[PerfCounterCount];
+        std::atomic<uint64_t> sums[PerfHistogramCount];
+        std::atomic<uint64_t> buckets[PerfHistogramCount][PerfCounterSnapshot::BucketCount];
+    };
+
+    // Shards are cache line aligned so the shards of different threads never share a line
+    static constexpr size_t ShardStride = (sizeof(Shard) + 63) & ~size_t(63);
+
+    static thread_local uint32_t s_shardIndex;
+
+    VK_INLINE Shard* GetShard() const
+    {
+        if (s_shardIndex == UINT32_MAX)
+        {
+            AssignShard();
+        }
+
+        return static_cast<Shard*>(Util::VoidPtrInc(m_pShards, s_shardIndex * ShardStride));
+    }
+
+    static void AssignShard();
+
+    void AddSample(PerfHistogram histogram, uint64_t value);
+
+    Device* const m_pDevice;
+    void*         m_pShards;  // ShardCount shards, or nullptr if the registry is disabled
+};
+
+} // namespace vk
+
+#endif /* __PERF_COUNTER_REGISTRY_H__ */
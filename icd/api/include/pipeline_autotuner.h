@@ -0,0 +1,190 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_autotuner.h
+* @brief Picks the wave size and NGG culling of hot pipelines by timing their variants over several runs.
+***********************************************************************************************************************
+*/
+#ifndef __PIPELINE_AUTOTUNER_H__
+#define __PIPELINE_AUTOTUNER_H__
+
+#pragma once
+
+#include "include/vk_alloccb.h"
+#include "include/app_shader_optimizer.h"
+
+#include "palHashMap.h"
+#include "palMutex.h"
+
+namespace Util
+{
+class JsonWriter;
+}
+
+namespace vk
+{
+
+class Device;
+struct PipelineStatsSample;
+
+// Compile option variants a pipeline is timed with
+enum AutotuneVariant : uint32_t
+{
+    AutotuneVariantBaseline = 0,    // Whatever the settings and other profiles pick
+    AutotuneVariantWave32,          // Wave32 pixel or compute shader
+    AutotuneVariantWave64,          // Wave64 pixel or compute shader
+    AutotuneVariantNggCulling,      // NGG backface, frustum and small primitive culling
+    AutotuneVariantCount
+};
+
+// =====================================================================================================================
+// Tunes compile options of the pipelines which take most of the GPU time, using the timed samples of the pipeline
+// statistics profile.
+//
+// A pipeline taking at least PipelineAutotuneHotSharePermille of the sampled GPU time of a run gets a record, keyed by
+// its shader optimizer key, in PipelineAutotuneFile.  In each later run every pipeline with such a record is compiled
+// with one of its variants, the one with the fewest samples so far, and its samples are summed per variant as GPU time
+// per shader invocation, so runs of different scenes stay comparable.  Once every variant has enough samples the
+// fastest one is kept, provided it beats the baseline by a margin; from then on the shader optimizer applies it as a
+// profile entry and the record no longer changes.
+//
+// Compile options are applied stage by stage while the optimizer key is still being filled in, so a key only matches
+// a record once its last active stage is reached.  That is also the stage the variants change.
+class PipelineAutotuner
+{
+public:
+    explicit PipelineAutotuner(Device* pDevice);
+
+    void Init();
+    void Destroy();
+
+    VK_INLINE bool IsEnabled() const
+        { return m_enabled; }
+
+    void ApplyTrial(
+        const PipelineOptimizerKey& pipelineKey,
+        PipelineShaderOptionsPtr    options);
+
+    void RegisterPipeline(
+        uint64_t                    apiHash,
+        const PipelineOptimizerKey& pipelineKey);
+
+    void RecordSamples(
+        const PipelineStatsSample* pSamples,
+        uint32_t                   sampleCount);
+
+    uint32_t GetTunedPipelines(
+        uint32_t              maxCount,
+        PipelineOptimizerKey* pKeys,
+        AutotuneVariant*      pVariants) const;
+
+    void Write(Util::JsonWriter* pWriter) const;
+
+    static ShaderStage GetTunedStage(const PipelineOptimizerKey& pipelineKey);
+
+    static constexpr uint32_t MaxRecords = 1024;   // Upper bound on the number of pipelines tuned
+
+private:
+    PAL_DISALLOW_DEFAULT_CTOR(PipelineAutotuner);
+    PAL_DISALLOW_COPY_AND_ASSIGN(PipelineAutotuner);
+
+    static constexpr uint32_t NoVariant = UINT32_MAX;
+
+    // A variant must be at least this many percent faster than the baseline to be kept
+    static constexpr uint32_t MinGainPercent = 3;
+
+    // Timed samples of one variant, summed over all runs
+    struct VariantStats
+    {
+        uint64_t gpuNs;        // GPU time of the samples
+        uint64_t invocations;  // Vertex, pixel and compute shader invocations of the samples
+        uint32_t samples;
+        uint32_t reserved;     // Must be zero
+    };
+
+    // A record as stored in the file
+    struct Record
+    {
+        PipelineOptimizerKey key;
+        VariantStats         variants[AutotuneVariantCount];
+        uint32_t             variantMask;  // Variants which apply to the pipeline
+        uint32_t             winner;       // Chosen variant, or NoVariant while the trials are running
+    };
+
+    // A record and the variant it is compiled with in this run
+    struct Entry
+    {
+        Record   record;
+        uint32_t trialVariant;  // NoVariant until a pipeline with the key is compiled
+    };
+
+    // A pipeline created in this run
+    struct PipelineInfo
+    {
+        uint64_t             keyHash;
+        PipelineOptimizerKey key;
+        uint64_t             gpuNs;    // Sampled GPU time in this run
+    };
+
+    // Header of the file, followed by entryCount records
+    struct FileHeader
+    {
+        uint32_t magic;        // FileMagic
+        uint32_t version;      // FileVersion
+        uint32_t deviceId;     // PCI device ID of the GPU the times were measured on
+        uint32_t entryCount;   // Number of records following the header
+        uint32_t recordSize;   // sizeof(Record) of the driver which wrote the file
+        uint32_t reserved;     // Must be zero
+    };
+
+    static constexpr uint32_t FileMagic   = 0x54505641;  // "AVPT"
+    static constexpr uint32_t FileVersion = 1;
+
+    using EntryMap    = Util::HashMap<uint64_t, Entry, PalAllocator>;
+    using PipelineMap = Util::HashMap<uint64_t, PipelineInfo, PalAllocator>;
+
+    static uint64_t HashKey(const PipelineOptimizerKey& pipelineKey);
+    static uint32_t GetVariantMask(const PipelineOptimizerKey& pipelineKey);
+    static double   GetCost(const VariantStats& stats);
+
+    void Load();
+    void Save();
+
+    void TrackHotPipelines();
+    void ChooseWinners();
+
+    Device* const       m_pDevice;
+    bool                m_enabled;
+    uint32_t            m_deviceId;
+    mutable Util::Mutex m_lock;         // Protects everything below
+    EntryMap            m_entries;      // Records by key hash
+    PipelineMap         m_pipelines;    // Pipelines of this run by API PSO hash
+    bool                m_dirty;        // Records changed since the file was read
+};
+
+} // namespace vk
+
+#endif /* __PIPELINE_AUTOTUNER_H__ */
@@ -32,13 +32,21 @@
 #include "pipeline_compiler.h"
 
 #include "palHashMap.h"
+#include "palHashSet.h"
 #include "palMetroHash.h"
 #include "palVector.h"
 #include "palCacheLayer.h"
+#include "palEvent.h"
+#include "palMutex.h"
+#include "palThread.h"
 #include "cache_adapter.h"
+#include "include/pipeline_compile_cost_db.h"
+
+#include <atomic>
 
 namespace Util
 {
+class IHashContext;
 class IPlatformKey;
 
 #if ICD_GPUOPEN_DEVMODE_BUILD
@@ -50,6 +58,8 @@ namespace vk
 {
 
 class CacheAdapter;
+class CompileThreadPool;
+class SharedMemoryCacheLayer;
 
 // Unified pipeline cache interface
 class PipelineBinaryCache
@@ -57,6 +67,21 @@ class PipelineBinaryCache
 public:
     using CacheId                    = Util::MetroHash::Hash;
 
+    // Lookup and residency statistics of the cache chain
+    struct CacheStats
+    {
+        uint64_t hits;          // Queries and loads that found the entry
+        uint64_t misses;        // Queries and loads that did not find the entry
+        uint64_t evictions;     // Entries evicted from the memory layer to stay within the memory budget
+        size_t   residentSize;  // Bytes held by the memory layer (only tracked while a memory budget is set)
+        uint64_t memoryHits;    // Hits answered by the memory layer
+        uint64_t sharedHits;    // Hits answered by the shared memory layer
+        uint64_t archiveHits;   // Hits answered by the archive (or other lower) layers
+        uint64_t mappedHits;    // Hits answered by the memory-mapped archive
+        uint64_t dedupedStores; // Compiler stores which only added an alias of an identical stored binary
+        uint64_t dedupedBytes;  // Binary bytes those stores did not have to add
+    };
+
     static PipelineBinaryCache* Create(
         VkAllocationCallbacks*     pAllocationCallbacks,
         Util::IPlatformKey*        pKey,
@@ -68,14 +93,20 @@ public:
 #endif
         size_t                     initDataSize,
         const void*                pInitData,
-        bool                       createArchiveLayers);
+        bool                       initDataValidated,
+        bool                       createArchiveLayers,
+        CompileThreadPool*         pThreadPool);
 
     static bool IsValidBlob(
-        VkAllocationCallbacks* pAllocationCallbacks,
-        Util::IPlatformKey*    pKey,
+        VkAllocationCallbacks*    pAllocationCallbacks,
+        const Util::IPlatformKey* pKey,
         size_t                 dataSize,
         const void*            pData);
 
+    static bool IsValidBlobLayout(
+        size_t      dataSize,
+        const void* pData);
+
     ~PipelineBinaryCache();
 
     VkResult Initialize(
@@ -89,6 +120,13 @@ public:
         uint32_t           flags,
         Util::QueryResult* pQuery);
 
+    void QueryPipelineBinaries(
+        uint32_t           count,
+        const CacheId*     pCacheIds,
+        uint32_t           flags,
+        Util::QueryResult* pQueries,
+        Util::Result*      pResults);
+
     Util::Result WaitPipelineBinary(
         const CacheId* pCacheId);
 
@@ -106,6 +144,15 @@ public:
         const Util::QueryResult* pQeuryId,
         void*                    pPipelineBinary) const;
 
+    Util::Result StoreShaderBinary(
+        const CacheId*  pCacheId,
+        size_t          shaderBinarySize,
+        const void*     pShaderBinary);
+
+    Util::Result ResolveShaderAlias(
+        uint32_t           flags,
+        Util::QueryResult* pQuery);
+
     Util::Result ReleaseCacheRef(
         const Util::QueryResult* pQuery) const;
 
@@ -125,7 +172,25 @@ public:
 
     VkResult Merge(
         uint32_t                    srcCacheCount,
-        const PipelineBinaryCache** ppSrcCaches);
+        const PipelineBinaryCache** ppSrcCaches,
+        CompileThreadPool*          pThreadPool);
+
+    VkResult SetMemoryBudget(
+        size_t budget);
+
+    void GetStats(
+        CacheStats* pStats) const;
+
+    void FlushWriteBack();
+
+    void RecordPrewarmEntry(
+        const CacheId* pCacheId);
+
+    void StartPrewarm();
+
+    // Returns the compile cost database next to the archive, or nullptr if it isn't enabled.
+    VK_INLINE PipelineCompileCostDb* GetCompileCostDb()
+        { return m_costDb.IsEnabled() ? &m_costDb : nullptr; }
 
 #if ICD_GPUOPEN_DEVMODE_BUILD
     Util::Result LoadReinjectionBinary(
@@ -154,7 +219,15 @@ public:
         { return &m_hashMappingLock; }
 #endif
 
-    void FreePipelineBinary(const void* pPipelineBinary);
+    void FreePipelineBinary(const void* pPipelineBinary) const;
+
+    // Returns true if the binary points into the memory-mapped archive and must not be freed by the caller.
+    VK_INLINE bool IsMappedBinary(const void* pPipelineBinary) const
+    {
+        return (m_pMappedArchive != nullptr)                                       &&
+               (pPipelineBinary >= m_pMappedArchive)                               &&
+               (pPipelineBinary <  Util::VoidPtrInc(m_pMappedArchive, m_mappedArchiveSize));
+    }
 
     void* AllocMem(
         size_t memSize) const;
@@ -185,6 +258,115 @@ private:
         Util::ICacheLayer*  pLayer,
         Util::ICacheLayer** pBottomLayer);
 
+    VkResult InitWriteBack();
+
+    void DestroyWriteBack();
+
+    // Header of a prewarm manifest file, followed by entryCount CacheIds in the order the pipelines were first used.
+    struct PrewarmManifestHeader
+    {
+        uint32_t magic;        // PrewarmManifestMagic
+        uint32_t version;      // PrewarmManifestVersion
+        uint64_t platformKey;  // 64-bit platform key of the cache which wrote the manifest
+        uint32_t entryCount;   // Number of CacheIds following the header
+        uint32_t reserved;     // Must be zero
+    };
+
+    static constexpr uint32_t PrewarmManifestMagic   = 0x4D505641;  // "AVPM"
+    static constexpr uint32_t PrewarmManifestVersion = 1;
+    static constexpr uint32_t MaxPrewarmEntries      = 64 * 1024;
+
+    void InitPrewarm(
+        const char* pCachePath,
+        const char* pBaseName);
+
+    void LoadPrewarmManifest();
+
+    void WritePrewarmManifest();
+
+    void DestroyPrewarm();
+
+    // A manifest entry with its recorded compile cost, used to order the prewarm
+    struct PrewarmOrderEntry
+    {
+        CacheId  cacheId;    // Entry hash
+        uint64_t compileUs;  // Recorded compile time, 0 if unknown
+    };
+
+    static void PrewarmThreadFunc(
+        void* pParam);
+
+    Util::Result QueueWriteBack(
+        const CacheId* pCacheId,
+        size_t         dataSize,
+        const void*    pData);
+
+    static void WriteBackThreadFunc(
+        void* pParam);
+
+    // A binary waiting to be written to the archive layers.  The binary data immediately follows this header.
+    struct WriteBackEntry
+    {
+        CacheId         cacheId;   // Entry hash
+        size_t          dataSize;  // Size of the binary in bytes
+        WriteBackEntry* pNext;     // Next queued entry
+    };
+
+    struct DecompressBatch;
+
+    // An entry of a source cache which is copied by Merge()
+    struct MergeEntry
+    {
+        CacheId  cacheId;      // Entry hash
+        uint32_t srcCacheIdx;  // Index of the source cache holding the entry
+    };
+
+    struct MergeBatch;
+
+    // Number of entries copied by each Merge() task
+    static constexpr uint32_t MergeChunkSize = 16;
+
+    static void MergeEntriesTask(
+        void*    pPayload,
+        uint32_t taskIndex);
+
+    static void DecompressEntryTask(
+        void*    pPayload,
+        uint32_t taskIndex);
+
+    void LoadInitialData(
+        size_t             initDataSize,
+        const void*        pInitData,
+        bool               initDataValidated,
+        CompileThreadPool* pThreadPool);
+
+    // State of the deferred validation of the initial data
+    enum InitDataState : uint32_t
+    {
+        InitDataValid   = 0,  // Validated (or never needed validation)
+        InitDataPending = 1,  // The validation thread is still hashing the blob
+        InitDataInvalid = 2,  // The blob failed validation; its entries were marked bad
+    };
+
+    void StartInitialDataValidation(
+        size_t      initDataSize,
+        const void* pInitData);
+
+    static void InitDataValidationThreadFunc(
+        void* pParam);
+
+    void FinishInitialDataValidation(
+        bool isValid);
+
+    void WaitForInitialDataValidation(
+        const CacheId* pCacheId) const;
+
+    // Pairs with the release store in FinishInitialDataValidation(), which follows the eviction of bad entries
+    bool IsInitialDataPending() const
+        { return (m_initDataState.load(std::memory_order_acquire) == InitDataPending); }
+
+    void DestroyInitialDataValidation();
+
     VkResult InitLayers(
         const char*            pDefaultCacheFilePath,
         bool                   createArchiveLayers,
@@ -201,10 +383,115 @@ private:
     VkResult InitMemoryCacheLayer(
         const RuntimeSettings& settings);
 
+    VkResult InitSharedMemoryLayer(
+        const RuntimeSettings& settings);
+
     VkResult InitArchiveLayers(
         const char*            pDefaultCacheFilePath,
         const RuntimeSettings& settings);
 
+    void InitMappedArchive(
+        const char*            pCachePath,
+        const RuntimeSettings& settings);
+
+    Util::Result IndexMappedArchive();
+
+    void DestroyMappedArchive();
+
+    void StartCacheDirCleanUp(
+        const char*            pCachePath,
+        const char*            pKeepPrefix,
+        const RuntimeSettings& settings);
+
+    void DestroyCacheDirCleanUp();
+
+    void CleanUpCacheDir();
+
+    static void CacheDirCleanUpThreadFunc(
+        void* pParam);
+
+    // An entry of the memory-mapped archive.  Queries that hit these entries are returned with a null pLayer and
+    // context.pEntryInfo pointing at the entry, so the rest of the cache interface can recognize them.
+    struct MappedEntry
+    {
+        const void*   pData;     // Entry data within the mapping
+        size_t        dataSize;  // Size of the entry data in bytes
+        volatile bool isBad;     // Set by MarkEntryBad; the entry is treated as missing afterwards
+    };
+
+    using MappedEntryMap = Util::HashMap<CacheId, MappedEntry, PalAllocator, Util::JenkinsHashFunc>;
+
+    MappedEntry* FindMappedEntry(const CacheId* pCacheId) const;
+
+    VK_INLINE static bool IsMappedQuery(const Util::QueryResult* pQuery)
+        { return (pQuery->pLayer == nullptr) && (pQuery->context.pEntryInfo != nullptr); }
+
+    // LRU bookkeeping for an entry of the memory layer.  Only maintained while a memory budget is set.
+    struct LruNode
+    {
+        CacheId  cacheId;   // Entry hash
+        size_t   dataSize;  // Size of the entry data in bytes, 0 while the entry is reserved but not yet stored
+        uint32_t refCount;  // References acquired through QueryPipelineBinary, plus one per queued write-back;
+                            // referenced entries are never evicted
+        LruNode* pPrev;     // More recently used neighbour
+        LruNode* pNext;     // Less recently used neighbour
+    };
+
+    using LruNodeMap = Util::HashMap<CacheId, LruNode*, PalAllocator, Util::JenkinsHashFunc>;
+
+    void TouchLruEntry(const CacheId* pCacheId, size_t dataSize, bool acquireRef) const;
+    void ReleaseLruRef(const CacheId* pCacheId) const;
+    void RemoveLruEntry(const CacheId* pCacheId) const;
+    void UnlinkLruNode(LruNode* pNode) const;
+    void EnforceMemoryBudget() const;
+    void DestroyLruNodes();
+
+    void CountHit(const Util::QueryResult* pQuery) const;
+
+    VK_INLINE bool IsMemoryBudgetEnabled() const
+        { return (m_memoryBudget > 0); }
+
+    // Stored in place of a compiler binary whose data is identical to one stored before.  The data itself is kept once,
+    // under a cache ID derived from its contents.
+    struct ShaderAliasRecord
+    {
+        uint32_t magic;      // ShaderAliasMagic
+        uint32_t version;    // ShaderAliasVersion
+        CacheId  contentId;  // Cache ID of the shared binary
+    };
+
+    static constexpr uint32_t ShaderAliasMagic   = 0x41535641;  // "AVSA"
+    static constexpr uint32_t ShaderAliasVersion = 1;
+
+    bool ContainsEntry(const CacheId* pCacheId) const;
+
+    // A binary stored since the last Serialize() call, which still has to be appended to the retained blob.
+    struct DirtyEntry
+    {
+        CacheId cacheId;   // Entry hash
+        size_t  dataSize;  // Size of the binary in bytes
+    };
+
+    using DirtyEntryVector = Util::Vector<DirtyEntry, 16, PalAllocator>;
+    using CacheIdSet       = Util::HashSet<CacheId, PalAllocator, Util::JenkinsHashFunc>;
+
+    VkResult InitIncrementalSerialize();
+    void DestroyIncrementalSerialize();
+    void TrackDirtyEntry(const CacheId* pCacheId, size_t dataSize);
+    void InvalidateSerializedBlob() const;
+    VkResult ResetSerializedBlob();
+    VkResult ReserveSerializedBlob(size_t size);
+    VkResult UpdateSerializedBlob();
+
+    VkResult AppendSerializedEntries(
+        const CacheId* pCacheIds,
+        uint32_t       count,
+        size_t         totalDataSize);
+
+    VkResult SerializeFull(
+        void*   pBlob,
+        size_t* pSize);
+
     Util::ICacheLayer*  GetMemoryLayer() const { return m_pMemoryLayer; }
     Util::IArchiveFile* OpenReadOnlyArchive(const char* path, const char* fileName, size_t bufferSize);
     Util::IArchiveFile* OpenWritableArchive(const char* path, const char* fileName, size_t bufferSize);
@@ -219,6 +506,10 @@ private:
     // Filename of an additional, read-only archive
     static constexpr char     EnvVarReadOnlyFileName[] = "AMD_VK_PIPELINE_CACHE_READ_ONLY_FILENAME";
 
+    // Filename of a pipeline cache blob (vkGetPipelineCacheData / cache_creator format) that is memory-mapped and
+    // served without copies
+    static constexpr char     EnvVarMappedFileName[] = "AMD_VK_PIPELINE_CACHE_MAPPED_FILENAME";
+
     static const uint32_t     ArchiveType;                // TypeId created by hashed string VK_SHADER_PIPELINE_CACHE
     static const uint32_t     ElfType;                    // TypeId created by hashed string VK_PIPELINE_ELF
 
@@ -242,6 +533,9 @@ private:
 
     Util::ICacheLayer*        m_pMemoryLayer;
 
+    SharedMemoryCacheLayer*   m_pSharedLayer;             // Layer shared with other processes, between the memory and
+                                                          // archive layers
+
     // Archive based cache layers
     using FileVector  = Util::Vector<Util::IArchiveFile*, 8, PalAllocator>;
     using LayerVector = Util::Vector<Util::ICacheLayer*, 8, PalAllocator>;
@@ -251,7 +545,97 @@ private:
 
     CacheAdapter*       m_pCacheAdapter;
 
-    Util::Mutex         m_entriesMutex;      // Mutex that will be used to get cache state by Query
+    bool                m_compressOnSerialize;  // Serialize LZ4-compressed entries
+    bool                m_dedupShaders;         // Store identical compiler binaries once (relocatable shaders only)
+
+    // Write-behind queue for the archive layers.  When enabled, stores only go to the memory layer synchronously and a
+    // background thread writes the queued binaries out to the archive.
+    bool                m_writeBackEnabled;     // Set once the write-back thread is running
+    volatile bool       m_writeBackStop;        // Tells the write-back thread to exit
+    Util::Thread        m_writeBackThread;      // Background thread draining the queue
+    Util::Event         m_writeBackEvent;       // Signaled when entries are queued or the thread must exit
+    Util::Mutex         m_writeBackLock;        // Protects the queue
+    Util::Mutex         m_writeBackFlushLock;   // Serializes flushes so that FlushWriteBack() waits for in-flight writes
+    WriteBackEntry*     m_pWriteBackHead;       // Oldest queued entry
+    WriteBackEntry*     m_pWriteBackTail;       // Newest queued entry
+
+    // Pipeline prewarm.  The cache IDs used by a run are recorded to a manifest next to the archive, and the next run
+    // loads those entries from the archive into the memory layer on a background thread.
+    using CacheIdVector = Util::Vector<CacheId, 64, PalAllocator>;
+
+    bool                m_prewarmEnabled;       // Set once the manifest path is known
+    char                m_prewarmManifestPath[Util::PathBufferLen];
+    Util::Mutex         m_prewarmLock;          // Protects m_prewarmIds, m_prewarmIdSet and m_prewarmDirty
+    CacheIdVector       m_prewarmIds;           // Manifest entries, in first-use order
+    CacheIdSet          m_prewarmIdSet;         // Entries of m_prewarmIds
+    uint32_t            m_prewarmLoadedCount;   // Number of entries read from the manifest at startup
+    bool                m_prewarmDirty;         // New entries were recorded since the manifest was read
+    volatile uint32_t   m_prewarmStarted;       // Non-zero once the prewarm thread has been started
+    volatile bool       m_prewarmStop;          // Tells the prewarm thread to exit
+    Util::Thread        m_prewarmThread;        // Background thread loading the manifest entries
+
+    PipelineCompileCostDb m_costDb;             // Compile times of the pipelines, persisted next to the archive
+
+    // Deferred validation of the initial data.  Only the layout of the blob is checked at creation time; its hash is
+    // verified on a background thread, and lookups of entries which came from the blob wait for the result.  Caches
+    // using application allocation callbacks validate at creation time instead.
+    std::atomic<uint32_t> m_initDataState;      // An InitDataState value
+    CacheIdSet          m_initDataIds;          // Entries loaded from the blob; immutable while validation is pending
+    void*               m_pInitDataCopy;        // Copy of the blob being hashed, owned by the validation thread
+    size_t              m_initDataCopySize;     // Size of m_pInitDataCopy in bytes
+    bool                m_initDataThreadStarted;
+    Util::Thread        m_initDataThread;       // Background thread hashing the blob
+    mutable Util::Event m_initDataEvent;        // Signaled once m_initDataState leaves InitDataPending
+
+    // Size bound of the default cache directory.  A low priority background thread removes the least recently used
+    // files of other applications once the directory outgrows the budget.
+    bool                m_cleanUpStarted;
+    volatile bool       m_cleanUpStop;          // Tells the clean-up thread to exit
+    Util::Thread        m_cleanUpThread;
+    Util::Event         m_cleanUpEvent;         // Signaled to wake the clean-up thread early for exiting
+    char                m_cleanUpPath[Util::PathBufferLen];            // Directory to bound
+    char                m_cleanUpKeepPrefix[Util::FilenameBufferLen];  // Files of this application are never removed
+    uint64_t            m_cleanUpBudget;        // Bytes the directory may take
+    uint64_t            m_cleanUpMinAge;        // Seconds a file must be unused before it can be removed
+
+    // Memory-mapped, read-only archive
+    void*               m_pMappedArchive;     // Base address of the mapping, or null
+    size_t              m_mappedArchiveSize;  // Size of the mapping in bytes
+    MappedEntryMap      m_mappedEntries;      // Index of the mapped entries; immutable once built
+
+    // Memory budget of the memory layer, enforced by evicting the least recently used unreferenced entries
+    size_t              m_memoryBudget;       // Budget in bytes, 0 if the memory layer is unbounded
+    mutable LruNodeMap  m_lruNodes;           // CacheId to LRU node lookup
+    mutable LruNode*    m_pLruHead;           // Most recently used entry
+    mutable LruNode*    m_pLruTail;           // Least recently used entry
+    mutable size_t      m_lruDataSize;        // Total data size of the tracked entries
+
+    mutable volatile uint64_t m_hitCount;     // Number of lookups that found the entry
+    mutable volatile uint64_t m_missCount;    // Number of lookups that did not find the entry
+    mutable volatile uint64_t m_evictCount;   // Number of entries evicted to stay within m_memoryBudget
+    mutable volatile uint64_t m_memoryHitCount;   // Hits answered by the memory layer
+    mutable volatile uint64_t m_sharedHitCount;   // Hits answered by the shared memory layer
+    mutable volatile uint64_t m_archiveHitCount;  // Hits answered by the archive (or other lower) layers
+    mutable volatile uint64_t m_mappedHitCount;   // Hits answered by the memory-mapped archive
+    volatile uint64_t         m_dedupStoreCount;  // Stores which were turned into aliases
+    volatile uint64_t         m_dedupByteCount;   // Binary bytes saved by those stores
+
+    // Incremental serialization.  The blob written by the last Serialize() call is retained, and later calls only
+    // append the entries stored in the meantime instead of loading every entry of the memory layer again.
+    bool                  m_incrementalSerialize;      // Set once the retained blob state is initialized
+    mutable volatile bool m_serializedBlobStale;       // Entries left the memory layer; the blob must be rebuilt
+    Util::Mutex           m_dirtyEntriesLock;          // Protects m_dirtyEntries
+    DirtyEntryVector      m_dirtyEntries;              // Entries stored since the last Serialize() call
+    Util::Mutex           m_serializeLock;             // Protects the retained blob state below
+    CacheIdSet            m_serializedIds;             // Entries the retained blob already contains
+    void*                 m_pSerializedBlob;           // Retained blob, starting with a PipelineBinaryCachePrivateHeader
+    size_t                m_serializedBlobSize;        // Bytes used in the retained blob
+    size_t                m_serializedBlobCapacity;    // Size of the m_pSerializedBlob allocation
+    Util::IHashContext*   m_pSerializedHashContext;    // Blob hash context which has consumed all retained entries
+    void*                 m_pSerializedHashMem;        // Placement memory of m_pSerializedHashContext
+
+    mutable Util::Mutex m_entriesMutex;      // Mutex that will be used to get cache state by Query, also protects the
+                                             // LRU bookkeeping
 };
 
 } // namespace vk
@@ -0,0 +1,139 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_compile_cost_db.h
+* @brief Declaration of the persistent per-pipeline compile cost database.
+***********************************************************************************************************************
+*/
+#ifndef __PIPELINE_COMPILE_COST_DB_H__
+#define __PIPELINE_COMPILE_COST_DB_H__
+
+#pragma once
+
+#include "include/vk_alloccb.h"
+#include "include/app_shader_optimizer.h"
+
+#include "palFile.h"
+#include "palHashMap.h"
+#include "palMetroHash.h"
+#include "palMutex.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+// Records how long each pipeline binary took to compile and in how many runs it was used, keyed by the ELF cache ID,
+// and persists the records in a file next to the pipeline cache archive.  The prewarm thread uses the costs to load
+// the most expensive pipelines first, and the shader optimizer uses them to steer pipelines which are expensive to
+// compile but rarely used towards cheaper compile options.
+class PipelineCompileCostDb
+{
+public:
+    using CacheId = Util::MetroHash::Hash;
+
+    explicit PipelineCompileCostDb(PalAllocator* pAllocator);
+
+    void Init(
+        const char* pFilePath,
+        uint64_t    platformKey);
+
+    void Destroy();
+
+    VK_INLINE bool IsEnabled() const
+        { return m_enabled; }
+
+    void RecordCompile(
+        const CacheId&              cacheId,
+        const PipelineOptimizerKey& profileKey,
+        uint64_t                    compileUs);
+
+    void RecordUse(
+        const CacheId& cacheId);
+
+    uint64_t GetCompileCost(
+        const CacheId& cacheId) const;
+
+    uint32_t GetExpensiveRarePipelines(
+        uint64_t              minCompileUs,
+        uint32_t              maxRuns,
+        uint32_t              maxCount,
+        PipelineOptimizerKey* pProfileKeys) const;
+
+    static constexpr uint32_t MaxEntries = 64 * 1024;  // Upper bound on the number of records kept
+
+private:
+    PAL_DISALLOW_DEFAULT_CTOR(PipelineCompileCostDb);
+    PAL_DISALLOW_COPY_AND_ASSIGN(PipelineCompileCostDb);
+
+    // A record as stored in the file
+    struct Record
+    {
+        CacheId              cacheId;     // ELF cache ID of the pipeline binary
+        PipelineOptimizerKey profileKey;  // Shader hashes of the pipeline, matched by the shader optimizer
+        uint64_t             compileUs;   // Time of the most recent compile in microseconds, 0 if never compiled
+        uint32_t             runCount;    // Number of runs which used the pipeline
+        uint32_t             reserved;    // Must be zero
+    };
+
+    // A record and whether this run has counted towards its runCount yet
+    struct Entry
+    {
+        Record record;
+        bool   usedThisRun;
+    };
+
+    // Header of the file, followed by entryCount records
+    struct FileHeader
+    {
+        uint32_t magic;        // FileMagic
+        uint32_t version;      // FileVersion
+        uint64_t platformKey;  // 64-bit platform key of the cache which wrote the file
+        uint32_t entryCount;   // Number of records following the header
+        uint32_t recordSize;   // sizeof(Record) of the driver which wrote the file
+    };
+
+    static constexpr uint32_t FileMagic   = 0x43435641;  // "AVCC"
+    static constexpr uint32_t FileVersion = 1;
+
+    using EntryMap = Util::HashMap<CacheId, Entry, PalAllocator, Util::JenkinsHashFunc>;
+
+    void Load();
+    void Save();
+
+    Entry* FindOrAddEntry(const CacheId& cacheId);
+    void   CountRun(Entry* pEntry);
+
+    bool                m_enabled;                         // Set once the file path is known
+    char                m_filePath[Util::PathBufferLen];
+    uint64_t            m_platformKey;                     // Key the file must have been written with
+    mutable Util::Mutex m_lock;                            // Protects m_entries and m_dirty
+    EntryMap            m_entries;
+    bool                m_dirty;                           // Records changed since the file was read
+};
+
+} // namespace vk
+
+#endif /* __PIPELINE_COMPILE_COST_DB_H__ */
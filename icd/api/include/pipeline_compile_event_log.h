@@ -0,0 +1,110 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_compile_event_log.h
+* @brief Declaration of the optional log of pipeline creation events.
+***********************************************************************************************************************
+*/
+#ifndef __PIPELINE_COMPILE_EVENT_LOG_H__
+#define __PIPELINE_COMPILE_EVENT_LOG_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+#include "include/pipeline_compile_stats.h"
+
+#include "palFile.h"
+#include "palMutex.h"
+
+namespace vk
+{
+
+class Device;
+
+// One vkCreate*Pipelines pipeline, as reported to the pipeline compile event log
+struct PipelineCompileEvent
+{
+    uint64_t                     apiHash;       // API PSO hash, as reported to RGP
+    uint64_t                     pipelineHash;  // Compiler pipeline hash, which also names pipeline dump files
+    uint64_t                     durationNs;    // Time spent in the create call for this pipeline
+    size_t                       binarySize;    // Size of the pipeline ELF
+    PipelineCompileStats::Source source;        // Where the pipeline binary came from
+    VkShaderStageFlags           stages;        // Shader stages of the pipeline
+};
+
+// =====================================================================================================================
+// Per-pipeline record of every pipeline the device creates, for attributing load times and hitches to individual
+// pipelines without a full capture.  Events are buffered and appended to the log file as CSV once the buffer is full
+// and when the device is destroyed.  Pipeline creation is slow enough compared to taking the lock that a single buffer
+// shared by all threads is enough.
+class PipelineCompileEventLog
+{
+public:
+    explicit PipelineCompileEventLog(Device* pDevice);
+
+    void Init();
+    void Destroy();
+
+    VK_INLINE bool IsEnabled() const
+        { return m_enabled; }
+
+    VK_INLINE void Record(const PipelineCompileEvent& event)
+    {
+        if (m_enabled)
+        {
+            RecordEvent(event);
+        }
+    }
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(PipelineCompileEventLog);
+
+    static constexpr uint32_t BufferSize = 64;
+
+    struct BufferedEvent
+    {
+        int64_t              timestamp; // CPU ticks when the create call returned
+        const void*          pThread;   // Identifies the thread that created the pipeline
+        PipelineCompileEvent event;
+    };
+
+    void RecordEvent(const PipelineCompileEvent& event);
+
+    void WriteEvents();
+
+    Device* const  m_pDevice;
+    bool           m_enabled;
+    int64_t        m_startTicks;         // Timestamps are written relative to this
+    int64_t        m_perfFrequency;      // CPU ticks per second
+    Util::Mutex    m_lock;               // Protects the buffer and the file
+    Util::File     m_file;
+    uint32_t       m_eventCount;         // Events in the buffer not yet written
+    BufferedEvent  m_events[BufferSize];
+};
+
+} // namespace vk
+
+#endif /* __PIPELINE_COMPILE_EVENT_LOG_H__ */
@@ -0,0 +1,114 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_compile_stats.h
+* @brief Declaration of the aggregate pipeline compile and cache statistics kept by the PipelineCompiler.
+***********************************************************************************************************************
+*/
+#ifndef __PIPELINE_COMPILE_STATS_H__
+#define __PIPELINE_COMPILE_STATS_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+namespace Util
+{
+class JsonWriter;
+}
+
+namespace vk
+{
+
+// =====================================================================================================================
+// Lock-free counters and latency histograms describing every pipeline the compiler has produced.  Recording a sample
+// costs a couple of atomic adds, so the stats are always collected; they are only formatted when written out.
+//
+// Latencies are binned in a log-linear histogram (four bins per power of two microseconds), which bounds the error of
+// the reported percentiles to about 25% without storing individual samples.
+class PipelineCompileStats
+{
+public:
+    // Stages of producing a pipeline binary
+    enum class Stage : uint32_t
+    {
+        Convert = 0,  // Vulkan create info to compiler build info
+        Hash,         // Pipeline hash and cache ID
+        CacheLookup,  // Application and internal cache lookups
+        Compile,      // Compiler invocation on a cache miss
+        Upload,       // PAL pipeline object creation, including the code upload
+        Count
+    };
+
+    // Where a pipeline binary came from
+    enum class Source : uint32_t
+    {
+        ApiHashCache = 0,  // API hash lookup, ahead of conversion
+        UserCache,         // Application pipeline cache
+        InternalCache,     // Internal pipeline cache
+        Compiled,          // Cache miss, compiled
+        Count
+    };
+
+    PipelineCompileStats();
+
+    void RecordStageTime(Stage stage, int64_t ticks);
+
+    void RecordBinary(Source source, size_t binarySize);
+
+    void RecordSpecialization(uint32_t entryCount, uint32_t droppedCount);
+
+    void Write(Util::JsonWriter* pWriter) const;
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(PipelineCompileStats);
+
+    static constexpr uint32_t SubBucketBits  = 2;
+    static constexpr uint32_t SubBucketCount = 1 << SubBucketBits;
+    static constexpr uint32_t BucketCount    = 128;
+
+    struct StageStats
+    {
+        volatile uint64_t count;                 // Number of samples
+        volatile uint64_t totalUs;               // Sum of all samples in microseconds
+        volatile uint64_t buckets[BucketCount];  // Sample count per latency bin
+    };
+
+    static uint32_t GetBucket(uint64_t us);
+    static uint64_t GetBucketUpperBound(uint32_t bucket);
+    static double   GetPercentileMs(const StageStats& stats, uint32_t percentile);
+
+    const int64_t     m_perfFrequency;                                        // Perf counter ticks per second
+    StageStats        m_stages[static_cast<uint32_t>(Stage::Count)];
+    volatile uint64_t m_binaryCount[static_cast<uint32_t>(Source::Count)];  // Binaries per source
+    volatile uint64_t m_binaryBytes[static_cast<uint32_t>(Source::Count)];  // Binary bytes per source
+    volatile uint64_t m_specEntries;                                        // Specialization map entries seen
+    volatile uint64_t m_specDroppedEntries;                                 // Entries dropped for having no effect
+};
+
+} // namespace vk
+
+#endif /* __PIPELINE_COMPILE_STATS_H__ */
@@ -33,12 +33,18 @@
 
 #include "include/khronos/vulkan.h"
 #include "include/compiler_solution.h"
+#include "include/pipeline_compile_stats.h"
+#include "include/pipeline_dump_writer.h"
 #include "include/shader_cache.h"
 
 #include "include/compiler_solution_llpc.h"
 
 #include "include/vk_shader_code.h"
 
+#include "palHashMap.h"
+#include "palMetroHash.h"
+#include "palMutex.h"
+
 namespace vk
 {
 
@@ -138,6 +144,16 @@ public:
         ComputePipelineCreateInfo*                      pInfo,
         const VkPipelineCreationFeedbackCreateInfoEXT** ppPipelineCreationFeadbackCreateInfo);
 
+    VkResult ConvertComputeShaderInfo(
+        Device*                                         pDevice,
+        const VkComputePipelineCreateInfo*              pIn,
+        ComputePipelineCreateInfo*                      pInfo,
+        const VkPipelineCreationFeedbackCreateInfoEXT** ppPipelineCreationFeadbackCreateInfo);
+
+    VkResult BuildComputeResourceMapping(
+        const VkComputePipelineCreateInfo*              pIn,
+        ComputePipelineCreateInfo*                      pInfo);
+
     void FreeShaderModule(ShaderModuleHandle* pShaderModule);
 
     void FreeComputePipelineBinary(
@@ -150,6 +166,50 @@ public:
         const void*                pPipelineBinary,
         size_t                     binarySize);
 
+    bool LoadGraphicsPipelineBinaryByApiHash(
+        const Device*                pDevice,
+        uint32_t                     deviceIdx,
+        PipelineCache*               pPipelineCache,
+        const Util::MetroHash::Hash& baseHash,
+        GraphicsPipelineCreateInfo*  pCreateInfo,
+        VbBindingInfo*               pVbInfo,
+        uint64_t*                    pPipelineHash,
+        size_t*                      pPipelineBinarySize,
+        const void**                 ppPipelineBinary,
+        Util::MetroHash::Hash*       pCacheId);
+
+    void PrefetchGraphicsPipelineBinaries(
+        const Device*                pDevice,
+        uint32_t                     deviceIdx,
+        PipelineCache*               pPipelineCache,
+        uint32_t                     count,
+        const VkPipelineCreateFlags* pFlags,
+        const Util::MetroHash::Hash* pBaseHashes);
+
+    void RegisterGraphicsPipelineApiHash(
+        const Device*                     pDevice,
+        uint32_t                          deviceIdx,
+        const Util::MetroHash::Hash&      baseHash,
+        const GraphicsPipelineCreateInfo& createInfo,
+        const VbBindingInfo&              vbInfo,
+        uint64_t                          pipelineHash,
+        const Util::MetroHash::Hash&      cacheId);
+
+    bool LoadComputePipelineBinaryByApiHash(
+        uint32_t                     deviceIdx,
+        PipelineCache*               pPipelineCache,
+        ComputePipelineCreateInfo*   pCreateInfo,
+        uint64_t*                    pPipelineHash,
+        size_t*                      pPipelineBinarySize,
+        const void**                 ppPipelineBinary,
+        Util::MetroHash::Hash*       pCacheId);
+
+    void RegisterComputePipelineApiHash(
+        uint32_t                         deviceIdx,
+        const ComputePipelineCreateInfo& createInfo,
+        uint64_t                         pipelineHash,
+        const Util::MetroHash::Hash&     cacheId);
+
     void FreeComputePipelineCreateInfo(ComputePipelineCreateInfo* pCreateInfo);
 
     void FreeGraphicsPipelineCreateInfo(GraphicsPipelineCreateInfo* pCreateInfo);
@@ -177,11 +237,81 @@ public:
 
     void GetElfCacheMetricString(char* pOutStr, size_t outStrSize);
 
+    PipelineCompileStats* GetCompileStats() { return &m_compileStats; }
+
+    void WriteCompileStats(const char* pFilePath);
+
     void DestroyPipelineBinaryCache();
 
+    void FlushPipelineBinaryCache();
+
+    void StartPipelinePrewarm();
+
+    void GetPipelineCreationInfoNext(
+        const VkStructHeader*                             pHeader,
+        const VkPipelineCreationFeedbackCreateInfoEXT**   ppPipelineCreationFeadbackCreateInfo);
+
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(PipelineCompiler);
 
+    // First-level cache entry which maps the API hash of a graphics pipeline to the ELF cache ID it was stored under,
+    // along with the state that would otherwise have to be rebuilt by ConvertGraphicsPipelineInfo().
+    struct ApiHashEntry;
+
+    using ApiHashMap = Util::HashMap<Util::MetroHash::Hash, ApiHashEntry*, PalAllocator, Util::JenkinsHashFunc>;
+
+    static constexpr uint32_t ApiHashMapBuckets = 1024;
+
+    // Stored in the internal binary cache under the key built by BuildComputeApiHashKey().  Unlike the graphics
+    // mapping it persists along with the binaries, so compute pipelines take the short path from the second run on.
+    struct ComputeApiHashRecord
+    {
+        uint32_t              magic;         // ComputeApiHashMagic
+        uint32_t              version;       // ComputeApiHashVersion
+        Util::MetroHash::Hash cacheId;       // ELF cache ID the pipeline binary was stored under
+        uint64_t              pipelineHash;  // LLPC pipeline hash, kept for logging
+    };
+
+    static constexpr uint32_t ComputeApiHashMagic   = 0x48435641;  // "AVCH"
+    static constexpr uint32_t ComputeApiHashVersion = 2;
+
+    bool IsApiHashLookupEnabled() const;
+
+    void BuildApiHashKey(
+        const Device*                pDevice,
+        uint32_t                     deviceIdx,
+        VkPipelineCreateFlags        flags,
+        const Util::MetroHash::Hash& baseHash,
+        Util::MetroHash::Hash*       pKey);
+
+    void BuildComputeApiHashKey(
+        uint32_t                         deviceIdx,
+        const ComputePipelineCreateInfo& createInfo,
+        Util::MetroHash::Hash*           pKey) const;
+
+    void DestroyApiHashMap();
+
+    void NormalizeSpecializationInfo(
+        const ShaderModule*       pShaderModule,
+        Vkgc::PipelineShaderInfo* pShaderInfo,
+        void**                    ppSpecBuffer);
+
+    void RecordBinaryStats(
+        Device*  pDevice,
+        VkResult result,
+        bool     compiled,
+        bool     isUserCacheHit,
+        bool     isInternalCacheHit,
+        int64_t  hashTime,
+        int64_t  compileTime,
+        size_t   binarySize);
+
+    void RecordCompileCost(
+        const Util::MetroHash::Hash& cacheId,
+        const PipelineOptimizerKey&  profileKey,
+        bool                         compiled,
+        int64_t                      compileTime);
+
     void ApplyProfileOptions(
         Device*                      pDevice,
         ShaderStage                  stage,
@@ -217,6 +347,28 @@ private:
         size_t*  pCodeSize,
         void**   ppCode);
 
+    // A replacement file preloaded from ShaderReplaceDir
+    struct ReplaceBinary
+    {
+        void*  pCode;
+        size_t codeSize;
+    };
+
+    using ReplaceBinaryMap = Util::HashMap<uint64_t, ReplaceBinary, PalAllocator>;
+
+    void LoadReplaceBinaries();
+
+    void DestroyReplaceBinaries();
+
+    bool CopyReplaceBinary(
+        const ReplaceBinaryMap&  map,
+        uint64_t                 key,
+        VkSystemAllocationScope  allocScope,
+        size_t*                  pCodeSize,
+        void**                   ppCode);
+
+    static uint64_t GetReplacePipelineKey(const char* pName, size_t nameLength);
+
     bool ReplacePipelineShaderModule(
         const Device*             pDevice,
         PipelineCompilerType      compilerType,
@@ -242,16 +394,24 @@ private:
 
     PipelineBinaryCache* m_pBinaryCache;       // Pipeline binary cache object
 
+    ApiHashMap           m_apiHashMap;         // Maps graphics pipeline API hashes to ELF cache IDs
+    Util::RWLock         m_apiHashLock;        // Protects m_apiHashMap
+    uint64_t             m_settingsHash;       // Hash of the runtime settings, salts persistent API hash records
+
     // Metrics
     uint32_t             m_cacheAttempts;      // Number of attempted cache loads
     uint32_t             m_cacheHits;          // Number of cache hits
     uint32_t             m_totalBinaries;      // Total number of binaries compiled or fetched
     int64_t              m_totalTimeSpent;     // Accumulation of time spent either loading or compiling pipeline
                                                // binaries
+    PipelineCompileStats m_compileStats;       // Per-stage latencies and per-source binary counts
+
+    // Shader replacement files, read once at initialization so pipeline creation never touches the disk for them
+    ReplaceBinaryMap     m_replaceShaders;     // Shader_0x<hash>_replace.spv files, keyed by the SPIR-V hash
+    ReplaceBinaryMap     m_replacePipelines;   // <pipeline name>_replace.elf files, keyed by GetReplacePipelineKey()
+
+    PipelineDumpWriter   m_dumpWriter;         // Finishes pipeline dumps in the background
 
-    void GetPipelineCreationInfoNext(
-        const VkStructHeader*                             pHeader,
-        const VkPipelineCreationFeedbackCreateInfoEXT**   ppPipelineCreationFeadbackCreateInfo);
 
     static VkPipelineCreateFlags GetCacheIdControlFlags(
         VkPipelineCreateFlags in);
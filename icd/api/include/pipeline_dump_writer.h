@@ -0,0 +1,97 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_dump_writer.h
+* @brief Background writer finishing pipeline dumps off the pipeline creation thread.
+***********************************************************************************************************************
+*/
+#ifndef __PIPELINE_DUMP_WRITER_H__
+#define __PIPELINE_DUMP_WRITER_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "vkgcDefs.h"
+
+#include "palEvent.h"
+#include "palMutex.h"
+#include "palThread.h"
+
+namespace vk
+{
+
+class Instance;
+
+// =====================================================================================================================
+// Finishes pipeline dumps on a background thread.  The pipeline info is still dumped by BeginPipelineDump() on the
+// creating thread, since it references the create info, but the pipeline binary (ELF file plus disassembly) is written
+// and the dump closed by the writer thread from a private copy of the binary.  Dump handles are independent of each
+// other, so finishing them on another thread is safe; the compiler itself dumps from several threads already.
+//
+// Without a running writer thread dumps are finished synchronously, as before.
+class PipelineDumpWriter
+{
+public:
+    PipelineDumpWriter(Instance* pInstance);
+
+    VkResult Init(const Vkgc::GfxIpVersion& gfxIp);
+
+    void Destroy();
+
+    void FinishDump(void* pDumpHandle, const void* pBinary, size_t binarySize);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(PipelineDumpWriter);
+
+    // A dump waiting to be finished.  The copy of the pipeline binary immediately follows this header.
+    struct Entry
+    {
+        void*  pDumpHandle;  // Handle returned by BeginPipelineDump()
+        size_t binarySize;   // Size of the binary in bytes, zero if the pipeline failed to build
+        Entry* pNext;        // Next queued entry
+    };
+
+    void WriteDump(void* pDumpHandle, const void* pBinary, size_t binarySize) const;
+
+    void Flush();
+
+    static void ThreadFunc(void* pParam);
+
+    Instance* const    m_pInstance;
+    Vkgc::GfxIpVersion m_gfxIp;
+    bool               m_started;     // Set once the writer thread is running
+    volatile bool      m_stop;        // Tells the writer thread to exit
+    Util::Thread       m_thread;      // Background thread draining the queue
+    Util::Event        m_event;       // Signaled when entries are queued or the thread must exit
+    Util::Mutex        m_lock;        // Protects the queue
+    Entry*             m_pHead;       // Oldest queued entry
+    Entry*             m_pTail;       // Newest queued entry
+};
+
+} // namespace vk
+
+#endif /* __PIPELINE_DUMP_WRITER_H__ */
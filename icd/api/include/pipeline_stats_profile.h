@@ -0,0 +1,164 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_stats_profile.h
+* @brief Declaration of the per-pipeline hardware statistics profile sampled at draw granularity.
+***********************************************************************************************************************
+*/
+#ifndef __PIPELINE_STATS_PROFILE_H__
+#define __PIPELINE_STATS_PROFILE_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+#include "include/vk_shader_code.h"
+#include "include/internal_mem_mgr.h"
+
+#include "palHashMap.h"
+#include "palMutex.h"
+#include "palPipeline.h"
+
+namespace Pal
+{
+class ICmdBuffer;
+class IQueryPool;
+}
+
+namespace Util
+{
+class JsonWriter;
+}
+
+namespace vk
+{
+
+class Device;
+struct PipelineOptimizerKey;
+
+// Number of pipeline statistics counters, in VkQueryPipelineStatisticFlagBits order
+constexpr uint32_t PipelineStatsCounterCount = 11;
+
+// One sampled draw or dispatch, handed from a command buffer to the device-wide profile
+struct PipelineStatsSample
+{
+    uint64_t apiHash;                              // API PSO hash of the bound pipeline
+    uint64_t counters[PipelineStatsCounterCount];  // Pipeline statistics of the draw or dispatch
+    uint64_t gpuNs;                                // GPU time of the draw or dispatch, 0 if it wasn't timed
+};
+
+// =====================================================================================================================
+// Device-wide pipeline statistics (vertices, primitives, shader invocations per stage) summed per pipeline over the
+// whole session.  Command buffers hand in their samples in batches once the GPU is known to be done with them, so the
+// profile is only locked once per recording.
+//
+// Pipelines register the code hashes of their shaders when they are created, so the sampled per-stage invocation
+// counts can also be summed per shader.  That gives a hotness ranking of the shaders by the same hashes the shader
+// profiles (app_shader_optimizer) match on.  Registrations and samples are passed on to the pipeline autotuner.
+class PipelineStatsProfile
+{
+public:
+    static PipelineStatsProfile* Create(Device* pDevice);
+
+    void Destroy();
+
+    void RegisterPipeline(uint64_t apiHash, const PipelineOptimizerKey& key);
+
+    void RecordSamples(const PipelineStatsSample* pSamples, uint32_t sampleCount, uint32_t droppedCount);
+
+    void Write(Util::JsonWriter* pWriter) const;
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(PipelineStatsProfile);
+
+    PipelineStatsProfile(Device* pDevice);
+
+    ~PipelineStatsProfile() { }
+
+    struct Entry
+    {
+        uint64_t        sampleCount;                          // Number of sampled draws and dispatches
+        uint64_t        counters[PipelineStatsCounterCount];  // Sum of the samples
+        uint64_t        gpuNs;                                // Sum of the GPU time of the timed samples
+        bool            shadersKnown;                         // The pipeline was registered
+        Pal::ShaderHash codeHashes[ShaderStageCount];         // Code hash of each stage, zero if the stage is unused
+    };
+
+    void WriteHotShaders(Util::JsonWriter* pWriter) const;
+
+    using EntryMap = Util::HashMap<uint64_t, Entry, PalAllocator>;
+
+    Device* const       m_pDevice;
+    mutable Util::Mutex m_lock;           // Serializes access to the entries
+    EntryMap            m_entries;        // Per-pipeline sums, keyed by API PSO hash
+    uint64_t            m_droppedCount;   // Draws and dispatches which were due a sample but didn't get one
+};
+
+// =====================================================================================================================
+// Per-command buffer state of the pipeline statistics profile.  Every PipelineStatsProfileSampleInterval-th draw or
+// dispatch is wrapped in a pipeline statistics query of a pool owned by the command buffer.  The results are read back
+// without waiting the next time the command buffer is begun, reset or destroyed, since the application must have
+// waited for it by then, and the slots are reset on the CPU.  Queries the GPU never completed are skipped.  If the
+// engine supports timestamps, each sampled draw or dispatch is also timed from top to bottom of the pipe.
+class PipelineStatsCmdBufferState
+{
+public:
+    PipelineStatsCmdBufferState(Device* pDevice, PipelineStatsProfile* pProfile);
+
+    VkResult Init();
+
+    void Destroy();
+
+    void BeginSample(Pal::ICmdBuffer* pPalCmdBuffer, uint64_t apiHash);
+
+    void EndSample(Pal::ICmdBuffer* pPalCmdBuffer);
+
+    void Resolve();
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(PipelineStatsCmdBufferState);
+
+    static constexpr uint32_t MaxSamples       = 128;
+    static constexpr uint32_t InvalidSlot      = UINT32_MAX;
+    static constexpr uint64_t TimestampNotDone = UINT64_MAX;
+
+    void WriteTimestamp(Pal::ICmdBuffer* pPalCmdBuffer, uint32_t slot, bool topOfPipe);
+
+    Device* const               m_pDevice;
+    PipelineStatsProfile* const m_pProfile;
+    const uint32_t              m_sampleInterval;          // Sample one out of this many draws and dispatches
+    Pal::IQueryPool*            m_pPalQueryPool;           // MaxSamples pipeline statistics slots
+    InternalMemory              m_queryMem;                // GPU memory bound to the query pool
+    InternalMemory              m_timestampMem;            // Begin and end timestamp of each slot, if timed
+    uint64_t                    m_apiHashes[MaxSamples];   // Pipeline of each used slot
+    uint32_t                    m_sampleCount;             // Slots used since the last resolve
+    uint32_t                    m_openSlot;                // Slot of the query currently begun, or InvalidSlot
+    uint32_t                    m_skipCount;               // Draws and dispatches left until the next sample
+    uint32_t                    m_droppedCount;            // Samples left out since the last resolve
+};
+
+} // namespace vk
+
+#endif /* __PIPELINE_STATS_PROFILE_H__ */
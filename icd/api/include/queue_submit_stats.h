@@ -0,0 +1,159 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  queue_submit_stats.h
+* @brief Declaration of the per-queue submission latency and GPU idle gap statistics.
+***********************************************************************************************************************
+*/
+#ifndef __QUEUE_SUBMIT_STATS_H__
+#define __QUEUE_SUBMIT_STATS_H__
+
+#pragma once
+
+#include "include/khronos/vulkan.h"
+#include "include/vk_utils.h"
+#include "include/internal_mem_mgr.h"
+
+namespace Pal
+{
+class IQueue;
+}
+
+namespace Util
+{
+class JsonWriter;
+}
+
+namespace vk
+{
+
+class Device;
+class Queue;
+struct CmdBufState;
+
+// =====================================================================================================================
+// Latency histograms of one queue, meant to show when the GPU starves.  The CPU side measures how long the application
+// thread spends in vkQueueSubmit and vkQueuePresentKHR and how much time passes between successive submits; this costs
+// two timer reads and a few atomic adds per call.
+//
+// The GPU side samples every Nth PAL submission of the queue: a bottom-of-pipe timestamp is written right after it and
+// a top-of-pipe timestamp right before the next submission.  The difference is how long the queue sat idle waiting
+// for work.  The result is picked up on a later submission once the GPU has written it, so sampling never waits.
+//
+// Presents also feed frame pacing stats: the time between successive presents, how long the presented images took to
+// acquire, and, for swap chains with low-latency pacing, the time from each present until the GPU finished it.
+class QueueSubmitStats
+{
+public:
+    static QueueSubmitStats* Create(
+        Device* pDevice,
+        Queue*  pQueue);
+
+    void Destroy();
+
+    void RecordSubmit(int64_t startTicks, int64_t endTicks);
+
+    void RecordPresent(int64_t startTicks, int64_t endTicks);
+
+    void RecordImagePresent(int64_t acquireWaitTicks, bool fullscreenFlip, bool failed);
+
+    void RecordPresentLatency(int64_t latencyTicks);
+
+    void BeforePalSubmit(Pal::IQueue* pPalQueue);
+
+    void AfterPalSubmit(Pal::IQueue* pPalQueue);
+
+    void Write(Util::JsonWriter* pWriter) const;
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(QueueSubmitStats);
+
+    QueueSubmitStats(Device* pDevice, Queue* pQueue);
+
+    ~QueueSubmitStats() { }
+
+    VkResult InitIdleGapProbe();
+
+    Pal::Result SubmitTimestamp(Pal::IQueue* pPalQueue, CmdBufState* pCmdBufState, bool topOfPipe);
+
+    void CheckIdleGapProbe();
+
+    static constexpr uint32_t SubBucketBits  = 2;
+    static constexpr uint32_t SubBucketCount = 1 << SubBucketBits;
+    static constexpr uint32_t BucketCount    = 128;
+
+    struct Histogram
+    {
+        volatile uint64_t count;                 // Number of samples
+        volatile uint64_t totalUs;               // Sum of all samples in microseconds
+        volatile uint64_t maxUs;                 // Largest sample; each histogram has a single writer
+        volatile uint64_t buckets[BucketCount];  // Sample count per latency bin
+    };
+
+    // Where the sampled idle gap measurement stands
+    enum class ProbeState : uint32_t
+    {
+        Idle = 0,      // Counting submissions until the next sample
+        EndWritten,    // The end timestamp follows the sampled submission, waiting for the next one
+        BeginWritten   // Both timestamps are queued, waiting for the GPU to write them
+    };
+
+    static void     AddSample(Histogram* pHistogram, uint64_t us);
+    void            AddTicksSample(Histogram* pHistogram, int64_t ticks) const;
+    static uint32_t GetBucket(uint64_t us);
+    static uint64_t GetBucketUpperBound(uint32_t bucket);
+    static uint64_t GetPercentileUs(const Histogram& histogram, uint32_t percentile);
+    static void     WriteHistogram(Util::JsonWriter* pWriter, const char* pName, const Histogram& histogram);
+
+    Device* const  m_pDevice;
+    Queue* const   m_pQueue;
+    const int64_t  m_perfFrequency;       // CPU perf counter ticks per second
+    const uint64_t m_timestampFrequency;  // GPU timestamp ticks per second
+
+    Histogram      m_submitCpuTime;       // Time the application thread spent in vkQueueSubmit
+    Histogram      m_submitInterval;      // Time between the starts of successive vkQueueSubmit calls
+    Histogram      m_presentCpuTime;      // Time the application thread spent in vkQueuePresentKHR
+    Histogram      m_gpuIdleGap;          // Sampled time the queue waited for its next submission
+    Histogram      m_presentInterval;     // Time between the starts of successive vkQueuePresentKHR calls
+    Histogram      m_acquireWait;         // Time vkAcquireNextImageKHR blocked for each presented image
+    Histogram      m_presentLatency;      // Time from a present until the GPU finished it (low-latency swap chains)
+    int64_t        m_lastSubmitTicks;     // Start of the previous vkQueueSubmit call, 0 before the first one
+    int64_t        m_lastPresentTicks;    // Start of the previous vkQueuePresentKHR call, 0 before the first one
+    uint64_t       m_imagePresentCount;   // Swap chain images presented
+    uint64_t       m_fullscreenFlipCount; // Of those, presented while the swap chain held fullscreen exclusive mode
+    uint64_t       m_failedPresentCount;  // Swap chain image presents which PAL failed
+
+    uint32_t       m_sampleInterval;      // PAL submissions per idle gap sample, 0 if sampling is off
+    uint32_t       m_submitsUntilSample;  // PAL submissions left until the next sample
+    ProbeState     m_probeState;
+    CmdBufState*   m_pEndCmdBuf;          // Writes the timestamp after the sampled submission
+    CmdBufState*   m_pBeginCmdBuf;        // Writes the timestamp before the submission after it
+    InternalMemory m_timestampMem;        // The end and begin timestamps, in that order
+};
+
+} // namespace vk
+
+#endif /* __QUEUE_SUBMIT_STATS_H__ */
@@ -0,0 +1,190 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  queue_submit_thread.h
+* @brief Declaration of the per-queue thread which performs deferred queue submissions.
+***********************************************************************************************************************
+*/
+#ifndef __QUEUE_SUBMIT_THREAD_H__
+#define __QUEUE_SUBMIT_THREAD_H__
+
+#pragma once
+
+#include "include/khronos/vulkan.h"
+#include "include/vk_utils.h"
+
+#include "palThread.h"
+#include "palMutex.h"
+#include "palEvent.h"
+#include "palConditionVariable.h"
+
+namespace vk
+{
+
+class Instance;
+class Queue;
+
+// =====================================================================================================================
+// Moves the PAL work of vkQueueSubmit and vkQueueBindSparse off the application's thread.  Submit() and BindSparse()
+// take a deep copy of the submit or bind infos, push it into a single-producer/single-consumer ring and return; the
+// thread of the queue pops the copies in order and runs them through Queue::PalSubmit() or Queue::PalBindSparse(),
+// which do the semaphore waits, the command buffer submissions or page remaps and the semaphore and fence signals
+// exactly as a synchronous call would.
+//
+// Every submission gets a sequence number.  Fences and semaphores remember the submission which signals them, and
+// anything that must observe a submission's PAL work (host waits, presents, submissions on other queues waiting on one
+// of its semaphores) first waits until the thread has handed that submission to PAL.  The first error returned by a
+// deferred submission sticks and is reported by every later Submit(), BindSparse() and wait.
+//
+// The producer side needs no lock as Vulkan requires external synchronization of the queue.
+class QueueSubmitThread
+{
+public:
+    static QueueSubmitThread* Create(
+        Instance* pInstance,
+        Queue*    pQueue);
+
+    void Destroy();
+
+    VkResult Submit(
+        uint32_t            submitCount,
+        const VkSubmitInfo* pSubmits,
+        VkFence             fence);
+
+    VkResult Submit(
+        uint32_t                submitCount,
+        const VkSubmitInfo2KHR* pSubmits,
+        VkFence                 fence);
+
+    VkResult BindSparse(
+        uint32_t                bindInfoCount,
+        const VkBindSparseInfo* pBindInfos,
+        VkFence                 fence);
+
+    VkResult WaitForSubmission(uint64_t sequence);
+
+    VK_INLINE VkResult WaitIdle()
+        { return WaitForSubmission(m_submittedCount); }
+
+    // Whether the given submission has been handed to PAL
+    VK_INLINE bool IsSubmitted(uint64_t sequence) const
+        { return (m_completedCount >= sequence); }
+
+    // First error returned by a deferred submission, VK_SUCCESS if there was none
+    VK_INLINE VkResult GetResult() const
+        { return m_result; }
+
+    static constexpr uint32_t RingSize = 64;  // Maximum number of submissions in flight
+
+    // The thread is woken explicitly; the timeouts only bound how long a lost wakeup could stall it or a waiter.
+    static constexpr float    IdleWaitSeconds      = 1.0f;
+    static constexpr uint32_t IdleWaitMilliseconds = 1000;
+
+private:
+    PAL_DISALLOW_DEFAULT_CTOR(QueueSubmitThread);
+    PAL_DISALLOW_COPY_AND_ASSIGN(QueueSubmitThread);
+
+    // A submission on another queue which signals a semaphore this submission waits on
+    struct Dependency
+    {
+        QueueSubmitThread* pThread;   // Submit thread of the other queue
+        uint64_t           sequence;  // Sequence number of the signaling submission
+    };
+
+    enum class JobType : uint32_t
+    {
+        Submit,      // pSubmits holds VkSubmitInfo
+        Submit2,     // pSubmits holds VkSubmitInfo2KHR
+        BindSparse   // pSubmits holds VkBindSparseInfo
+    };
+
+    // A deferred vkQueueSubmit/vkQueueSubmit2KHR/vkQueueBindSparse call.  The submit or bind infos and everything they
+    // point to are copied into the same allocation.
+    struct Job
+    {
+        JobType     type;               // Which call this is
+        uint32_t    submitCount;        // Number of submit or bind infos
+        const void* pSubmits;           // Copied submit or bind infos
+        VkFence     fence;              // Fence to signal after the last submit info
+        uint32_t    dependencyCount;    // Number of entries in pDependencies
+        Dependency* pDependencies;      // Submissions on other queues this one has to follow
+    };
+
+    QueueSubmitThread(Instance* pInstance, Queue* pQueue);
+
+    VkResult Init();
+
+    template <typename SubmitInfoType>
+    VkResult Enqueue(
+        uint32_t              submitCount,
+        const SubmitInfoType* pSubmits,
+        VkFence               fence);
+
+    static size_t GetCopySize(uint32_t submitCount, const VkSubmitInfo* pSubmits);
+    static size_t GetCopySize(uint32_t submitCount, const VkSubmitInfo2KHR* pSubmits);
+    static size_t GetCopySize(uint32_t submitCount, const VkBindSparseInfo* pSubmits);
+
+    static const void* CopySubmits(void* pMem, uint32_t submitCount, const VkSubmitInfo* pSubmits);
+    static const void* CopySubmits(void* pMem, uint32_t submitCount, const VkSubmitInfo2KHR* pSubmits);
+    static const void* CopySubmits(void* pMem, uint32_t submitCount, const VkBindSparseInfo* pSubmits);
+
+    static uint32_t GetWaitSemaphoreCount(uint32_t submitCount, const VkSubmitInfo* pSubmits);
+    static uint32_t GetWaitSemaphoreCount(uint32_t submitCount, const VkSubmitInfo2KHR* pSubmits);
+    static uint32_t GetWaitSemaphoreCount(uint32_t submitCount, const VkBindSparseInfo* pSubmits);
+
+    static JobType GetJobType(const VkSubmitInfo*)     { return JobType::Submit; }
+    static JobType GetJobType(const VkSubmitInfo2KHR*) { return JobType::Submit2; }
+    static JobType GetJobType(const VkBindSparseInfo*) { return JobType::BindSparse; }
+
+    void TrackSemaphores(Job* pJob, uint64_t sequence, uint32_t submitCount, const VkSubmitInfo* pSubmits);
+    void TrackSemaphores(Job* pJob, uint64_t sequence, uint32_t submitCount, const VkSubmitInfo2KHR* pSubmits);
+    void TrackSemaphores(Job* pJob, uint64_t sequence, uint32_t submitCount, const VkBindSparseInfo* pSubmits);
+
+    void AddDependency(Job* pJob, VkSemaphore semaphore);
+
+    static void ThreadFunc(void* pParam);
+
+    void ThreadLoop();
+
+    void RunJob(const Job* pJob);
+
+    Instance* const         m_pInstance;
+    Queue* const            m_pQueue;
+    Util::Thread            m_thread;                // Thread doing the PAL submissions
+    Util::Event             m_wakeEvent;             // Signaled when a job is queued or the thread must exit
+    Util::Mutex             m_doneLock;              // Serializes m_completedCount updates with m_submissionDone
+    Util::ConditionVariable m_submissionDone;        // Broadcast under m_doneLock after every job
+    Job*                    m_ring[RingSize];        // Queued jobs, indexed by sequence number modulo RingSize
+    volatile uint64_t       m_submittedCount;        // Jobs queued so far; written by the producer only
+    volatile uint64_t       m_completedCount;        // Jobs handed to PAL so far; written by the thread only
+    volatile VkResult       m_result;                // First error of a deferred submission
+    volatile bool           m_stop;                  // Set when the thread must exit
+    bool                    m_threadStarted;         // Whether m_thread is running
+};
+
+} // namespace vk
+
+#endif /* __QUEUE_SUBMIT_THREAD_H__ */
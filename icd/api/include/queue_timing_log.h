@@ -0,0 +1,185 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  queue_timing_log.h
+* @brief Declaration of the binary log of queue submissions, semaphore operations, presents and waits.
+***********************************************************************************************************************
+*/
+#ifndef __QUEUE_TIMING_LOG_H__
+#define __QUEUE_TIMING_LOG_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+#include "include/internal_mem_mgr.h"
+
+#include "palFile.h"
+#include "palMutex.h"
+
+namespace Pal
+{
+class IQueue;
+}
+
+namespace vk
+{
+
+class Device;
+class Queue;
+struct CmdBufState;
+
+// Kinds of records in the queue timing log
+enum class QueueTimingEventType : uint16_t
+{
+    Submit = 0,        // vkQueueSubmit batch handed to PAL; the GPU timestamp is taken once its work is done
+    SemaphoreWait,     // Semaphore waits of a batch; the GPU timestamp is taken once the queue got past them
+    SemaphoreSignal,   // Semaphore signals of a batch
+    Present,           // vkQueuePresentKHR
+    WaitIdle,          // vkQueueWaitIdle
+    Count
+};
+
+// Start of each device's section of the log file
+struct QueueTimingLogHeader
+{
+    uint32_t magic;           // QueueTimingLogMagic
+    uint32_t version;         // QueueTimingLogVersion
+    uint64_t cpuFrequency;    // CPU ticks per second
+    uint64_t gpuFrequency;    // GPU timestamp ticks per second, or 0 if the device has none
+    uint64_t cpuCalibration;  // CPU ticks read right after gpuCalibration, to line up the two clocks
+    uint64_t gpuCalibration;  // GPU timestamp read right before cpuCalibration
+};
+
+// One operation on a queue, as written to the log file
+struct QueueTimingRecord
+{
+    uint64_t cpuBeginTicks;   // CPU ticks when the driver started the operation
+    uint64_t cpuEndTicks;     // CPU ticks when the driver was done with it
+    uint64_t gpuTicks;        // GPU timestamp after the operation, or 0 if it wasn't sampled
+    uint32_t queueId;         // Queue family index in the upper 16 bits, queue index in the lower ones
+    uint16_t type;            // QueueTimingEventType
+    uint16_t count;           // Command buffers, semaphores or swap chains the operation covered
+};
+
+static_assert(sizeof(QueueTimingRecord) == 32, "Queue timing records are meant to stay compact");
+
+constexpr uint32_t QueueTimingLogMagic   = 0x54514B56; // "VKQT"
+constexpr uint32_t QueueTimingLogVersion = 1;
+
+// =====================================================================================================================
+// Device-wide binary log of the operations on all queues, for diagnosing queue starvation and synchronization stalls
+// on machines without developer tools.  It is a cut-down version of developer mode queue timing that works in every
+// build: the CPU time of each operation is always recorded, and submissions and semaphore waits also get a GPU
+// timestamp written right after them.  Records of different queues are not in order in the file.
+class QueueTimingLog
+{
+public:
+    explicit QueueTimingLog(Device* pDevice);
+
+    void Init();
+    void Destroy();
+
+    VK_INLINE bool IsEnabled() const
+        { return m_enabled; }
+
+    void Write(const QueueTimingRecord* pRecords, uint32_t recordCount);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(QueueTimingLog);
+
+    Device* const m_pDevice;
+    bool          m_enabled;
+    Util::Mutex   m_lock;     // Serializes writes to the file
+    Util::File    m_file;
+};
+
+// =====================================================================================================================
+// Per-queue side of the queue timing log.  Records wait in a small ring until the GPU has written their timestamp, so
+// recording never waits for the GPU; completed records are handed to the log in batches.  Each GPU timestamp costs an
+// extra PAL submission of a one-packet command buffer.  When all timestamp slots are in flight, the operation is
+// recorded without one.
+class QueueTimingState
+{
+public:
+    static QueueTimingState* Create(
+        Device* pDevice,
+        Queue*  pQueue);
+
+    void Destroy();
+
+    void RecordSubmit(Pal::IQueue* pPalQueue, int64_t cpuBeginTicks, uint32_t cmdBufferCount);
+
+    void RecordSemaphoreWait(Pal::IQueue* pPalQueue, int64_t cpuBeginTicks, uint32_t semaphoreCount);
+
+    void RecordCpuEvent(QueueTimingEventType type, int64_t cpuBeginTicks, uint32_t count);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(QueueTimingState);
+
+    QueueTimingState(Device* pDevice, Queue* pQueue);
+
+    ~QueueTimingState() { }
+
+    VkResult Init();
+
+    void AddRecord(
+        Pal::IQueue*         pPalQueue,
+        QueueTimingEventType type,
+        int64_t              cpuBeginTicks,
+        uint32_t             count,
+        bool                 sampleGpu);
+
+    void Retire(bool force);
+
+    static constexpr uint32_t MaxPending    = 256;
+    static constexpr uint32_t MaxGpuSlots   = 32;
+    static constexpr uint32_t InvalidSlot   = UINT32_MAX;
+
+    struct PendingRecord
+    {
+        QueueTimingRecord record;
+        uint32_t          gpuSlot;   // Timestamp slot of the record, or InvalidSlot
+    };
+
+    Device* const     m_pDevice;
+    Queue* const      m_pQueue;
+    const uint32_t    m_queueId;
+    Util::Mutex       m_lock;                       // The submit thread and the application thread both record
+
+    PendingRecord     m_pending[MaxPending];         // Records waiting for their GPU timestamp, oldest first
+    uint32_t          m_pendingHead;
+    uint32_t          m_pendingCount;
+
+    CmdBufState*      m_pGpuSlots[MaxGpuSlots];     // Command buffers writing the timestamps, used round-robin
+    InternalMemory    m_timestampMem;               // One timestamp per slot
+    uint32_t          m_gpuSlotHead;                // Oldest slot in flight
+    uint32_t          m_gpuSlotCount;               // Slots in flight
+    uint32_t          m_gpuSlotsCreated;            // Slots with a command buffer; none if timestamps are unsupported
+};
+
+} // namespace vk
+
+#endif /* __QUEUE_TIMING_LOG_H__ */
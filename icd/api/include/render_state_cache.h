@@ -36,6 +36,7 @@
 #pragma once
 
 #include "include/khronos/vulkan.h"
+#include "include/compact_param_map.h"
 #include "include/vk_alloccb.h"
 #include "include/vk_graphics_pipeline.h"
 
@@ -63,6 +64,28 @@ constexpr uint32_t DynamicRenderStateToken = 0;
 // as opposed to a pointer).
 constexpr uint32_t FirstStaticRenderStateToken = DynamicRenderStateToken + 1;
 
+// =====================================================================================================================
+// Key of a graphics pipeline's whole "static state bundle": the cached PAL state objects it binds, which pieces of
+// state are static, and the static tokens of those pieces.  Two pipelines that map to the same bundle token program
+// identical static state during pipeline binds.  Must be zero-initialized before being filled.
+struct StaticStateBundleKey
+{
+    const Pal::IMsaaState*         pMsaaState;
+    const Pal::IColorBlendState*   pColorBlendState;
+    const Pal::IDepthStencilState* pDepthStencilState;
+    uint32_t                       staticStateMask;
+    uint32_t                       bindFlags;
+    uint32_t                       inputAssemblyState;
+    uint32_t                       triangleRasterState;
+    uint32_t                       pointLineRasterState;
+    uint32_t                       lineStippleState;
+    uint32_t                       depthBias;
+    uint32_t                       blendConst;
+    uint32_t                       depthBounds;
+    uint32_t                       samplePattern;
+    uint32_t                       fragmentShadingRate;
+};
+
 // =====================================================================================================================
 // The render state cache allows pipelines to register pieces of static pipeline state (or other such render state) and
 // receive back a singular token (number or pointer, depending on state) that guarantees that, if those two tokens
@@ -146,6 +169,9 @@ public:
     uint32_t CreateLineStipple(const Pal::LineStippleStateParams& params);
     void DestroyLineStipple(const Pal::LineStippleStateParams& params, uint32_t token);
 
+    uint32_t CreateStaticStateBundle(const StaticStateBundleKey& key);
+    void DestroyStaticStateBundle(const StaticStateBundleKey& key, uint32_t token);
+
     void Destroy();
 
 private:
@@ -157,7 +183,7 @@ private:
     struct StaticParamState
     {
         uint32_t paramToken;    // Token value the state maps to
-        uint32_t refCount;      // Reference count of active pipelines holding to this state
+        uint32_t refCount;      // Reference count of active pipelines holding to this state (atomic under read lock)
     };
 
     // State mapping for a Pal::*CreateInfo -> Pal::I* bindable object (for redundancy checking CmdBind* functions)
@@ -169,7 +195,8 @@ private:
 
         CreateInfo info;                     // Original create info (copy of the key)
         PalObject* pObjects[MaxPalDevices];  // Per-device object pointers (mapping value)
-        uint32_t   refCount;                 // Reference count of pipelines holding on to this state
+        uint32_t   refCount;                 // Reference count of pipelines holding on to this state (atomic
+                                             // under read lock)
     };
 
     // Specializations for the three kinds of PAL objects we currently cache
@@ -258,70 +285,39 @@ private:
         const VkAllocationCallbacks* pAllocator);
 
     Device* const                                 m_pDevice;
-    Util::Mutex                                   m_mutex;
 
-    // These hash tables map static graphics pipeline state to a unique token i.e. a perfect hash.
-    Util::HashMap<Pal::InputAssemblyStateParams,
-                  StaticParamState,
-                  PalAllocator,
-                  Util::JenkinsHashFunc>          m_inputAssemblyState;
-    uint32_t                                      m_inputAssemblyStateNextId;
+    // Cache hits only take this lock for reading (reference counts are bumped atomically), so that parallel pipeline
+    // creation does not serialize on lookups.  Inserting or erasing a mapping requires the write lock.
+    Util::RWLock                                  m_lock;
 
-    Util::HashMap<Pal::TriangleRasterStateParams,
-                  StaticParamState,
-                  PalAllocator,
-                  Util::JenkinsHashFunc>          m_triangleRasterState;
-    uint32_t                                      m_triangleRasterStateNextId;
+    // These hash tables map static graphics pipeline state to a unique token i.e. a perfect hash.  The keys are small
+    // PODs, so they are stored inline in open-addressed tables that shrink again as entries are released.
+    CompactParamMap<Pal::InputAssemblyStateParams, StaticParamState>   m_inputAssemblyState;
+    uint32_t                                                            m_inputAssemblyStateNextId;
 
-    Util::HashMap<Pal::PointLineRasterStateParams,
-                  StaticParamState,
-                  PalAllocator,
-                  Util::JenkinsHashFunc>          m_pointLineRasterState;
-    uint32_t                                      m_pointLineRasterStateNextId;
+    CompactParamMap<Pal::TriangleRasterStateParams, StaticParamState>  m_triangleRasterState;
+    uint32_t                                                            m_triangleRasterStateNextId;
 
-    Util::HashMap<Pal::LineStippleStateParams,
-                  StaticParamState,
-                  PalAllocator>                   m_lineStippleState;
-    uint32_t                                      m_lineStippleStateNextId;
+    CompactParamMap<Pal::PointLineRasterStateParams, StaticParamState> m_pointLineRasterState;
+    uint32_t                                                            m_pointLineRasterStateNextId;
 
-    Util::HashMap<Pal::DepthBiasParams,
-                  StaticParamState,
-                  PalAllocator,
-                  Util::JenkinsHashFunc>          m_depthBias;
-    uint32_t                                      m_depthBiasNextId;
+    CompactParamMap<Pal::LineStippleStateParams, StaticParamState>     m_lineStippleState;
+    uint32_t                                                            m_lineStippleStateNextId;
 
-    Util::HashMap<Pal::BlendConstParams,
-                  StaticParamState,
-                  PalAllocator,
-                  Util::JenkinsHashFunc>          m_blendConst;
-    uint32_t                                      m_blendConstNextId;
+    CompactParamMap<Pal::DepthBiasParams, StaticParamState>            m_depthBias;
+    uint32_t                                                            m_depthBiasNextId;
 
-    Util::HashMap<Pal::DepthBoundsParams,
-                  StaticParamState,
-                  PalAllocator>                   m_depthBounds;
-    uint32_t                                      m_depthBoundsNextId;
+    CompactParamMap<Pal::BlendConstParams, StaticParamState>           m_blendConst;
+    uint32_t                                                            m_blendConstNextId;
 
-    static const size_t ViewportHashGroupSize = (sizeof(Pal::ViewportParams) + sizeof(StaticParamState)) * 8;
+    CompactParamMap<Pal::DepthBoundsParams, StaticParamState>          m_depthBounds;
+    uint32_t                                                            m_depthBoundsNextId;
 
-    Util::HashMap<Pal::ViewportParams,
-                  StaticParamState,
-                  PalAllocator,
-                  Util::JenkinsHashFunc,
-                  Util::DefaultEqualFunc,
-                  Util::HashAllocator<PalAllocator>,
-                  ViewportHashGroupSize>          m_viewport;
-    uint32_t                                      m_viewportNextId;
-
-    static const size_t ScissorRectHashGroupSize = (sizeof(Pal::ScissorRectParams) + sizeof(StaticParamState)) * 8;
+    CompactParamMap<Pal::ViewportParams, StaticParamState>             m_viewport;
+    uint32_t                                                            m_viewportNextId;
 
-    Util::HashMap<Pal::ScissorRectParams,
-                  StaticParamState,
-                  PalAllocator,
-                  Util::JenkinsHashFunc,
-                  Util::DefaultEqualFunc,
-                  Util::HashAllocator<PalAllocator>,
-                  ScissorRectHashGroupSize>       m_scissorRect;
-    uint32_t                                      m_scissorRectNextId;
+    CompactParamMap<Pal::ScissorRectParams, StaticParamState>          m_scissorRect;
+    uint32_t                                                            m_scissorRectNextId;
 
     // These hash tables do the same for certain PAL state objects that are owned by graphics pipelines.  Because
     // they are objects, the pointer address acts as an implicit unique ID.
@@ -337,16 +333,8 @@ private:
                   StaticMsaaState*,
                   PalAllocator>                      m_msaaRefs;
 
-    static const size_t SamplePatternHashGroupSize = (sizeof(SamplePattern) + sizeof(StaticParamState)) * 8;
-
-    Util::HashMap<SamplePattern,
-        StaticParamState,
-        PalAllocator,
-        Util::JenkinsHashFunc,
-        Util::DefaultEqualFunc,
-        Util::HashAllocator<PalAllocator>,
-        SamplePatternHashGroupSize>               m_samplePattern;
-    uint32_t                                      m_samplePatternNextId;
+    CompactParamMap<SamplePattern, StaticParamState>                   m_samplePattern;
+    uint32_t                                                            m_samplePatternNextId;
 
     Util::HashMap<Pal::ColorBlendStateCreateInfo,
         StaticColorBlendState*,
@@ -372,10 +360,11 @@ private:
         StaticDepthStencilState*,
         PalAllocator>                                 m_depthStencilRefs;
 
-    Util::HashMap<Pal::VrsRateParams,
-        StaticParamState,
-        PalAllocator>                                 m_fragmentShadingRate;
-    uint32_t                                          m_fragmentShadingRateNextId;
+    CompactParamMap<Pal::VrsRateParams, StaticParamState>              m_fragmentShadingRate;
+    uint32_t                                                            m_fragmentShadingRateNextId;
+
+    CompactParamMap<StaticStateBundleKey, StaticParamState>            m_staticStateBundle;
+    uint32_t                                                            m_staticStateBundleNextId;
 };
 
 };
@@ -0,0 +1,123 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  shader_module_cache.h
+* @brief Shares the SPIR-V copy and compiled module of shader modules created from identical code.
+***********************************************************************************************************************
+*/
+#ifndef __SHADER_MODULE_CACHE_H__
+#define __SHADER_MODULE_CACHE_H__
+
+#pragma once
+
+#include "include/compact_param_map.h"
+#include "include/compiler_solution.h"
+#include "include/vk_utils.h"
+
+#include "palMutex.h"
+#include "palPipeline.h"
+
+namespace vk
+{
+
+class Device;
+
+// Identifies the code a shader module was created from.  Zero-filled before use since it is compared bytewise.
+struct ShaderModuleKey
+{
+    Pal::ShaderHash           codeHash;
+    uint64_t                  codeSize;
+    VkShaderModuleCreateFlags flags;
+    uint32_t                  reserved;
+};
+
+// SPIR-V code and compiled module shared by all live shader modules created from it.  The retained code follows the
+// entry in the same allocation; it is LZ4 compressed if storedCodeSize is less than codeSize.
+struct ShaderModuleCacheEntry
+{
+    ShaderModuleKey    key;
+    uint32_t           refCount;        // Shader modules referencing the entry; protected by the cache lock
+    bool               inMap;           // False if the entry couldn't be added to the map and has one user only
+    size_t             codeSize;
+    size_t             storedCodeSize;
+    const void*        pCode;
+    ShaderModuleHandle handle;
+};
+
+// =====================================================================================================================
+// Device-level cache of the shader modules which are currently alive, keyed on their code hash, size and create
+// flags.  Applications often create many VkShaderModules from the same SPIR-V (e.g. once per pipeline); with the
+// cache, these share one copy of the code and one compiled ShaderModuleHandle instead of converting the code again.
+// Entries are reference counted and released together with the last shader module using them, so the cache never
+// holds more than the application does.
+class ShaderModuleCache
+{
+public:
+    explicit ShaderModuleCache(Device* pDevice);
+
+    void Init();
+
+    VK_INLINE bool IsEnabled() const
+        { return m_enabled; }
+
+    VkResult Acquire(
+        VkShaderModuleCreateFlags      flags,
+        size_t                         codeSize,
+        const void*                    pCode,
+        size_t                         storedCodeSize,
+        const void*                    pStoredCode,
+        const Pal::ShaderHash&         codeHash,
+        const ShaderModuleCacheEntry** ppEntry);
+
+    void Release(const ShaderModuleCacheEntry* pEntry);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(ShaderModuleCache);
+
+    static bool HoldsCode(
+        const ShaderModuleCacheEntry* pEntry,
+        size_t                        storedCodeSize,
+        const void*                   pStoredCode);
+
+    VkResult CreateEntry(
+        const ShaderModuleKey&   key,
+        size_t                   codeSize,
+        const void*              pCode,
+        size_t                   storedCodeSize,
+        const void*              pStoredCode,
+        ShaderModuleCacheEntry** ppEntry);
+
+    void FreeEntry(ShaderModuleCacheEntry* pEntry);
+
+    Device* const                                             m_pDevice;
+    bool                                                      m_enabled;
+    Util::Mutex                                               m_lock;     // Protects the map and the ref counts
+    CompactParamMap<ShaderModuleKey, ShaderModuleCacheEntry*> m_entries;
+};
+
+} // namespace vk
+
+#endif /* __SHADER_MODULE_CACHE_H__ */
@@ -0,0 +1,199 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  shared_memory_cache_layer.h
+* @brief Declaration of a pipeline cache layer backed by a named shared-memory segment.
+***********************************************************************************************************************
+*/
+#ifndef __SHARED_MEMORY_CACHE_LAYER_H__
+#define __SHARED_MEMORY_CACHE_LAYER_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "palCacheLayer.h"
+#include "palMutex.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+// A cache layer whose entries live in a named POSIX shared-memory segment, so that every process running the same
+// application on the same device sees the binaries compiled by the others.
+//
+// The segment is append-only: entries are never moved or freed, which lets readers look them up without taking any
+// lock.  Writers are serialized by a process-local mutex plus an advisory lock on the segment, and publish an entry by
+// writing its index slot state last.  Once the segment is full further stores are simply passed down the chain.
+class SharedMemoryCacheLayer final : public Util::ICacheLayer
+{
+public:
+    static SharedMemoryCacheLayer* Create(
+        const VkAllocationCallbacks* pAllocationCallbacks,
+        uint64_t                     platformKey,
+        size_t                       segmentSize);
+
+    // ICacheLayer
+    virtual Util::Result Query(
+        const Util::Hash128* pHashId,
+        uint32_t             policy,
+        uint32_t             flags,
+        Util::QueryResult*   pQuery) override;
+
+    virtual Util::Result Store(
+        const Util::Hash128* pHashId,
+        const void*          pData,
+        size_t               dataSize) override;
+
+    virtual Util::Result Load(
+        const Util::QueryResult* pQuery,
+        void*                    pBuffer) override;
+
+    virtual Util::Result Link(
+        Util::ICacheLayer* pNextLayer) override;
+
+    virtual Util::Result SetLoadPolicy(
+        uint32_t loadPolicy) override;
+
+    virtual Util::Result SetStorePolicy(
+        uint32_t storePolicy) override;
+
+    virtual Util::ICacheLayer* GetNextLayer() const override
+        { return m_pNextLayer; }
+
+    virtual uint32_t GetLoadPolicy() const override
+        { return m_loadPolicy; }
+
+    virtual uint32_t GetStorePolicy() const override
+        { return m_storePolicy; }
+
+    virtual Util::Result WaitForEntry(
+        const Util::Hash128* pHashId) override;
+
+    virtual Util::Result Evict(
+        const Util::Hash128* pHashId) override;
+
+    virtual Util::Result MarkEntryBad(
+        const Util::Hash128* pHashId) override;
+
+    virtual Util::Result ReleaseCacheRef(
+        const Util::QueryResult* pQuery) override;
+
+    virtual Util::Result GetCacheData(
+        const Util::QueryResult* pQuery,
+        const void**             ppData) override;
+
+    virtual void Destroy() override;
+
+    static constexpr size_t MinSegmentSize = 1024 * 1024;  // Smallest segment worth creating
+
+private:
+    PAL_DISALLOW_DEFAULT_CTOR(SharedMemoryCacheLayer);
+    PAL_DISALLOW_COPY_AND_ASSIGN(SharedMemoryCacheLayer);
+
+    // Header at the start of the segment.  The slot array immediately follows it, then the data region.
+    struct SegmentHeader
+    {
+        uint32_t magic;        // SegmentMagic once the creating process has finished initializing the segment
+        uint32_t version;      // SegmentVersion
+        uint64_t platformKey;  // Platform key of the driver/device that created the segment
+        uint64_t segmentSize;  // Total size of the segment in bytes
+        uint32_t slotCount;    // Number of index slots; a power of two
+        uint32_t reserved;
+        uint64_t dataOffset;   // Offset of the data region from the start of the segment
+        uint64_t dataUsed;     // Bytes of the data region handed out so far (protected by the writer lock)
+    };
+
+    // Index slot of one entry.  Written once under the writer lock; state is published last.
+    struct Slot
+    {
+        Util::Hash128 hashId;      // Entry hash
+        uint64_t      dataOffset;  // Offset of the entry data from the start of the segment
+        uint64_t      dataSize;    // Size of the entry data in bytes
+        uint32_t      state;       // One of the SlotState values
+        uint32_t      reserved;
+    };
+
+    enum SlotState : uint32_t
+    {
+        SlotEmpty = 0,  // Never written; ends a probe sequence
+        SlotReady,      // Entry data is complete and may be read
+        SlotBad,        // Entry was marked bad and is treated as missing
+    };
+
+    static constexpr uint32_t SegmentMagic   = 0x43505641;  // 'AVPC'
+    static constexpr uint32_t SegmentVersion = 1;
+    static constexpr size_t   BytesPerSlot   = 16 * 1024;   // Segment bytes budgeted per index slot
+    static constexpr uint32_t MinSlotCount   = 256;
+    static constexpr size_t   DataAlignment  = 16;          // Alignment of entry data within the segment
+
+    SharedMemoryCacheLayer(const VkAllocationCallbacks* pAllocationCallbacks);
+
+    Util::Result Init(
+        uint64_t platformKey,
+        size_t   segmentSize);
+
+    Util::Result InitSegmentHeader(
+        uint64_t platformKey,
+        size_t   segmentSize);
+
+    Util::Result StoreEntry(
+        const Util::Hash128* pHashId,
+        const void*          pData,
+        size_t               dataSize);
+
+    void LockWriter();
+    void UnlockWriter();
+
+    const Slot* FindSlot(const Util::Hash128* pHashId) const;
+
+    const void* GetSlotData(
+        const Slot* pSlot,
+        size_t*     pDataSize) const;
+
+    VK_INLINE SegmentHeader* GetHeader() const
+        { return static_cast<SegmentHeader*>(m_pSegment); }
+
+    VK_INLINE Slot* GetSlots() const
+        { return static_cast<Slot*>(Util::VoidPtrInc(m_pSegment, sizeof(SegmentHeader))); }
+
+    VK_INLINE bool IsOwnQuery(const Util::QueryResult* pQuery) const
+        { return (pQuery->pLayer == this); }
+
+    const VkAllocationCallbacks* m_pAllocationCallbacks;
+    Util::ICacheLayer*           m_pNextLayer;
+    uint32_t                     m_loadPolicy;
+    uint32_t                     m_storePolicy;
+
+    int                          m_fd;            // Shared-memory object, also used for the advisory writer lock
+    void*                        m_pSegment;      // Base address of the mapped segment
+    size_t                       m_segmentSize;   // Size of the mapping in bytes
+    Util::Mutex                  m_writerLock;    // Serializes writers within this process
+};
+
+} // namespace vk
+
+#endif /* __SHARED_MEMORY_CACHE_LAYER_H__ */
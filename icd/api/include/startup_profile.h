@@ -0,0 +1,94 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  startup_profile.h
+* @brief Timing of the one-time initialization phases of the driver.
+***********************************************************************************************************************
+*/
+#ifndef __STARTUP_PROFILE_H__
+#define __STARTUP_PROFILE_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "palSysUtil.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+// Process-wide breakdown of instance, physical device and device creation, for tracking the cold start cost of short
+// lived processes.  If AMDVLK_STARTUP_PROFILE names a file, every StartupPhase appends a line
+// "startup <phase> start_us=<n> duration_us=<n>" to it when it ends; start_us counts from the load of the driver
+// library.  Phases nest, so a phase's duration includes the phases which started and ended within it.
+//
+// No settings are available yet when the first phases run, hence the environment variable.
+class StartupProfile
+{
+public:
+    static VK_INLINE bool IsEnabled()
+        { return s_enabled; }
+
+    static void Record(
+        const char* pPhase,
+        int64_t     startTicks);
+
+private:
+    static const bool    s_enabled;
+    static const int64_t s_loadTicks;    // CPU ticks when the driver library was loaded
+};
+
+// =====================================================================================================================
+// Times the enclosing scope as a startup phase.  pPhase must be a literal.
+class StartupPhase
+{
+public:
+    explicit VK_INLINE StartupPhase(const char* pPhase)
+        :
+        m_pPhase(StartupProfile::IsEnabled() ? pPhase : nullptr),
+        m_startTicks((m_pPhase != nullptr) ? Util::GetPerfCpuTime() : 0)
+        { }
+
+    VK_INLINE ~StartupPhase()
+    {
+        if (m_pPhase != nullptr)
+        {
+            StartupProfile::Record(m_pPhase, m_startTicks);
+        }
+    }
+
+private:
+    PAL_DISALLOW_DEFAULT_CTOR(StartupPhase);
+    PAL_DISALLOW_COPY_AND_ASSIGN(StartupPhase);
+
+    const char* const m_pPhase;
+    const int64_t     m_startTicks;
+};
+
+} // namespace vk
+
+#endif /* __STARTUP_PROFILE_H__ */
@@ -0,0 +1,100 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  timestamp_calibrator.h
+* @brief Model of the device clock which answers calibrated timestamp requests without a kernel query.
+***********************************************************************************************************************
+*/
+#ifndef __TIMESTAMP_CALIBRATOR_H__
+#define __TIMESTAMP_CALIBRATOR_H__
+
+#pragma once
+
+#include "include/vk_utils.h"
+
+#include "palDevice.h"
+#include "palMutex.h"
+
+namespace vk
+{
+
+class Device;
+
+// =====================================================================================================================
+// Answers vkGetCalibratedTimestampsEXT from a linear fit of the device timestamp against CLOCK_MONOTONIC_RAW, so that
+// correlating CPU and GPU timelines every frame doesn't cost a kernel query each time.  The CPU clocks are read
+// directly and the device timestamp is extrapolated from the latest calibration queried from PAL (the anchor) with
+// the rate measured between an older calibration (the base) and the anchor.
+//
+// The reported maximum deviation is that of the anchor plus the rate uncertainty accumulated since it; a request is
+// left to a PAL query, which is then added as a new sample, once this exceeds twice the deviation of the anchor or
+// the anchor is older than CalibratedTimestampResampleInterval.  A sample which contradicts the model, e.g. after
+// the device timestamp was reset, restarts the fit.
+class TimestampCalibrator
+{
+public:
+    explicit TimestampCalibrator(Device* pDevice);
+
+    void Init();
+
+    bool Predict(
+        uint32_t                            timestampCount,
+        const VkCalibratedTimestampInfoEXT* pTimestampInfos,
+        uint64_t*                           pTimestamps,
+        uint64_t*                           pMaxDeviation);
+
+    void AddSample(const Pal::CalibratedTimestamps& calibration);
+
+private:
+    PAL_DISALLOW_DEFAULT_CTOR(TimestampCalibrator);
+    PAL_DISALLOW_COPY_AND_ASSIGN(TimestampCalibrator);
+
+    static constexpr uint64_t MinDeviationLimit = 10000;  // Nanoseconds the model may always deviate by
+    static constexpr uint32_t MaxBaselineFactor = 16;     // Longest base to anchor distance, in resample intervals
+
+    struct Sample
+    {
+        uint64_t rawNs;       // CLOCK_MONOTONIC_RAW
+        uint64_t gpuTicks;    // Device timestamp
+        uint64_t deviation;   // Nanoseconds, including the resolution of the device timestamp
+    };
+
+    Device* const m_pDevice;
+    bool          m_enabled;
+    uint64_t      m_resampleNs;       // Longest time the anchor is extrapolated from
+    double        m_nominalTicksPerNs;
+    uint64_t      m_tickNs;           // Resolution of the device timestamp, rounded up
+    Util::Mutex   m_lock;             // Protects everything below
+    uint32_t      m_sampleCount;      // Samples since the fit was last restarted, counted up to 2
+    Sample        m_base;
+    Sample        m_anchor;
+    double        m_ticksPerNs;       // Measured rate of the device timestamp
+    double        m_rateError;        // Relative uncertainty of m_ticksPerNs
+};
+
+} // namespace vk
+
+#endif /* __TIMESTAMP_CALIBRATOR_H__ */
@@ -0,0 +1,193 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  transient_alias_planner.h
+* @brief Shares the physical memory of transient attachments which are never alive at the same time.
+***********************************************************************************************************************
+*/
+#ifndef __TRANSIENT_ALIAS_PLANNER_H__
+#define __TRANSIENT_ALIAS_PLANNER_H__
+
+#pragma once
+
+#include "include/internal_mem_mgr.h"
+#include "include/vk_utils.h"
+
+#include "palMutex.h"
+#include "palVector.h"
+
+#include <atomic>
+
+namespace Pal
+{
+class IQueue;
+}
+
+namespace vk
+{
+
+class Device;
+class Framebuffer;
+class Image;
+class Memory;
+class RenderPass;
+
+// =====================================================================================================================
+// Lets transient attachments of a render pass whose lifetimes don't overlap share physical memory.
+//
+// A dedicated allocation of an image with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT only reserves a virtual address
+// range (see Memory::CreateTransientAliasMemory()), so that the image and its views get their final address at bind
+// time.  Physical memory is chosen when the image is first seen as an attachment: framebuffer creation plans all of
+// its attachments against the render pass, using the subpass range each attachment is referenced in.  Attachments
+// whose contents are neither loaded nor stored (RPAttachmentLifetime::aliasable) and whose ranges don't overlap are
+// placed in the same slot of physical memory; the render pass waits for earlier attachment accesses before the first
+// use of such an attachment, so neither later subpasses nor later render pass instances can race with the previous
+// user of the memory.  The mappings are made by the next queue submission, before its command buffers run.
+//
+// An image which turns out to need its contents beyond one render pass instance (it is used by a render pass that
+// loads or stores it, it overlaps one of its slot mates, or it is transitioned by a pipeline barrier) is moved to
+// memory of its own.  The slot it leaves stays allocated until the memory it was bound to is freed, since work
+// submitted before the move may still access the image there.
+class TransientAliasPlanner
+{
+public:
+    explicit TransientAliasPlanner(Device* pDevice);
+
+    void Init(uint32_t universalQueueCount);
+    void Destroy();
+
+    VK_INLINE bool IsEnabled() const
+        { return m_enabled; }
+
+    bool IsCandidate(const Image* pImage) const;
+
+    VkResult RegisterMemory(
+        const Memory*                   pMemory,
+        Pal::IGpuMemory*                pVirtualGpuMem,
+        const Pal::GpuMemoryCreateInfo& createInfo);
+
+    void ReleaseMemory(const Memory* pMemory);
+
+    void BindImage(
+        const Memory* pMemory,
+        const Image*  pImage);
+
+    VK_INLINE void ReleaseImage(
+        const Image* pImage)
+    {
+        if (m_enabled)
+        {
+            ReleaseImageBinding(pImage);
+        }
+    }
+
+    VkResult Plan(
+        const RenderPass*  pRenderPass,
+        const Framebuffer* pFramebuffer,
+        bool*              pHasAliasedAttachments);
+
+    VkResult MakePrivate(const Image* pImage);
+
+    // Makes the mappings planned since the last call.  Must be called before each submission to the universal queue.
+    VK_INLINE VkResult Commit(
+        Pal::IQueue* pPalQueue)
+    {
+        return (m_hasPendingRemaps.load(std::memory_order_acquire) ? CommitPending(pPalQueue) : VK_SUCCESS);
+    }
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(TransientAliasPlanner);
+
+    // Upper bound of attachments of one render pass that are planned together.  Alias candidates beyond it are given
+    // memory of their own.
+    static constexpr uint32_t MaxPlannedAttachments = 32;
+
+    // Remap ranges handed to PAL at a time
+    static constexpr uint32_t RemapBatchSize = 32;
+
+    // Physical memory backing one or more virtual ranges
+    struct Slot
+    {
+        InternalMemory memory;
+        Pal::gpusize   size;
+        uint32_t       refCount;    // Bindings mapped to this slot, or which were before they were made private
+    };
+
+    // A dedicated allocation of a transient attachment
+    struct Binding
+    {
+        const Memory*            pMemory;
+        Pal::IGpuMemory*         pVirtualGpuMem;
+        Pal::GpuMemoryCreateInfo createInfo;      // Heaps and (granularity aligned) size of the allocation
+        const Image*             pImage;          // Bound image, or nullptr while unbound or once destroyed
+        Slot*                    pSlot;           // Physical memory the range is (about to be) mapped to
+        Slot*                    pPrevSlot;       // Shared slot the binding was moved out of
+        bool                     shared;          // pSlot may be mapped by other bindings as well
+        bool                     remapPending;    // The range still has to be mapped to pSlot
+    };
+
+    // An attachment image in the render pass being planned
+    struct PlanEntry
+    {
+        Binding* pBinding;
+        uint32_t firstUseSubpass;
+        uint32_t finalUseSubpass;
+        uint32_t group;           // Slot to be created for the entry, or NoGroup
+    };
+
+    static constexpr uint32_t NoGroup = UINT32_MAX;
+
+    Binding* FindBinding(const Image* pImage) const;
+    uint32_t FindBindingIndex(const Memory* pMemory) const;
+
+    void ReleaseImageBinding(const Image* pImage);
+
+    VkResult CreateSlot(const Binding& binding, Pal::gpusize size, Slot** ppSlot);
+    void     ReleaseSlot(Slot* pSlot);
+    void     AssignSlot(Binding* pBinding, Slot* pSlot, bool shared);
+    VkResult MakeBindingPrivate(Binding* pBinding);
+
+    bool IsUsedDuring(
+        const PlanEntry* pEntries,
+        uint32_t         entryCount,
+        uint32_t         entryIndex,
+        const Slot*      pSlot,
+        uint32_t         group) const;
+
+    VkResult PlanEntries(PlanEntry* pEntries, uint32_t entryCount);
+    VkResult CommitPending(Pal::IQueue* pPalQueue);
+
+    Device* const                             m_pDevice;
+    bool                                      m_enabled;
+    Pal::VirtualGpuMemAccessMode              m_accessMode;      // Access mode of unmapped pages of a range
+    Util::Mutex                               m_lock;            // Protects everything below
+    Util::Vector<Binding*, 16, PalAllocator>  m_bindings;
+    std::atomic<bool>                         m_hasPendingRemaps; // Some binding has remapPending set
+};
+
+} // namespace vk
+
+#endif /* __TRANSIENT_ALIAS_PLANNER_H__ */
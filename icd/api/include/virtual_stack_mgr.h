@@ -38,17 +38,33 @@
 
 #include "pal.h"
 #include "palLinearAllocator.h"
-#include "palIntrusiveList.h"
 #include "palMutex.h"
 
+#include <atomic>
+
 namespace vk
 {
 
 // Forward declarations
 class Instance;
 
-// Virtual stack allocator base type
-typedef Util::VirtualLinearAllocatorWithNode VirtualStackAllocator;
+// =====================================================================================================================
+// Virtual stack allocator.  Knows its slot in the manager's table, which links the free ones into a lock-free stack.
+class VirtualStackAllocator final : public Util::VirtualLinearAllocator
+{
+public:
+    VirtualStackAllocator(size_t maxSize, uint32_t slot)
+        : Util::VirtualLinearAllocator(maxSize), m_slot(slot), m_nextFree(0)
+    {}
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(VirtualStackAllocator);
+
+    friend class VirtualStackMgr;
+
+    const uint32_t        m_slot;      // Index of this allocator in the manager's table
+    std::atomic<uint32_t> m_nextFree;  // Slot + 1 of the next free allocator on the stack, 0 at the bottom
+};
 
 // =====================================================================================================================
 // Virtual stack frame helper class
@@ -79,6 +95,10 @@ private:
 
 // =====================================================================================================================
 // Virtual stack frame manager class
+//
+// Every command buffer and queue holds an allocator, so acquires and releases come in bulk from many threads.  Each
+// thread caches the allocator it released last and takes it back on its next acquire.  The other free allocators sit
+// on a lock-free stack; the lock is only taken to create a new allocator.  Allocators are only freed with the manager.
 class VirtualStackMgr
 {
 public:
@@ -97,13 +117,26 @@ private:
 
     VirtualStackMgr(Instance* pInstance);
 
-    typedef Util::IntrusiveList<VirtualStackAllocator> VirtualStackList;
+    static constexpr uint32_t SlotsPerChunk = 256;
+    static constexpr uint32_t MaxChunks     = 4096;
+
+    VirtualStackAllocator* PopFree();
+    void PushFree(VirtualStackAllocator* pAllocator);
+
+    Pal::Result CreateAllocator(VirtualStackAllocator** ppAllocator);
+
+    VirtualStackAllocator* GetSlot(uint32_t slot) const
+        { return m_pChunks[slot / SlotsPerChunk].load(std::memory_order_acquire)[slot % SlotsPerChunk]; }
 
     Instance* const         m_pInstance;        // Vulkan instance the virtual stack manager belongs to
+    const uint64_t          m_id;               // Tells the thread caches of different managers apart
 
-    VirtualStackList        m_stackList;        // List of available virtual stack allocators
+    std::atomic<uint64_t>   m_freeHead;         // Top of the free stack: slot + 1 (0 if empty) in the low half, a
+                                                // counter against ABA in the high half
+    std::atomic<VirtualStackAllocator**> m_pChunks[MaxChunks]; // Allocator of each slot, SlotsPerChunk per chunk
+    uint32_t                m_slotCount;        // Number of allocators created
 
-    Util::Mutex             m_lock;             // Lock protecting concurrent access to the manager
+    Util::Mutex             m_lock;             // Serializes allocator creation
 };
 
 } // namespace vk
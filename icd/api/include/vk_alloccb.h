@@ -45,6 +45,30 @@ namespace allocator
 {
 
 extern const VkAllocationCallbacks g_DefaultAllocCallback;
+extern const VkAllocationCallbacks g_ThreadCachingAllocCallback;
+
+constexpr uint32_t AllocScopeCount = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+// Allocation counters of the thread-caching callbacks for one VkSystemAllocationScope
+struct AllocScopeStats
+{
+    uint64_t allocCount;       // Allocations made
+    uint64_t freeCount;        // Allocations freed
+    uint64_t cachedAllocCount; // Allocations served from a thread's free lists
+};
+
+bool IsThreadCachingEnabled();
+
+// Returns true if pCallbacks are the driver's own callbacks.  Unlike application callbacks, which may only be called
+// from the thread issuing the command they were given to, these may be called from any thread.
+inline bool IsDriverAllocCallbacks(
+    const VkAllocationCallbacks* pCallbacks)
+{
+    return (pCallbacks->pfnAllocation == g_DefaultAllocCallback.pfnAllocation) ||
+           (pCallbacks->pfnAllocation == g_ThreadCachingAllocCallback.pfnAllocation);
+}
+
+void GetAllocScopeStats(AllocScopeStats* pStats);
 
 void* PAL_STDCALL PalAllocFuncDelegator(
     void*                                   pClientData,
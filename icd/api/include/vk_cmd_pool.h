@@ -42,6 +42,8 @@
 #include "palCmdAllocator.h"
 #include "palHashSet.h"
 
+#include <atomic>
+
 namespace vk
 {
 
@@ -83,9 +85,19 @@ public:
 
     bool IsProtected() const { return m_flags.isProtected ? true : false; }
 
+    // Whether the chunk sizes and heaps of the private CmdAllocators follow the recorded usage
+    bool AdaptsCmdAllocators() const { return m_flags.adaptiveCmdAllocators ? true : false; }
+
+    void RecordCmdAllocatorUsage(const Pal::gpusize* pUsedSizes);
+
+    // Counts a submission of a command buffer of this pool; may be called from any thread
+    void NotifySubmit() { m_submitCount.fetch_add(1, std::memory_order_relaxed); }
+
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(CmdPool);
 
+    static constexpr uint32_t MinAdaptRecordings = 4;  // Recordings needed before the allocators are reconsidered
+
     CmdPool(
         Device*                      pDevice,
         Pal::ICmdAllocator**         pPalCmdAllocators,
@@ -94,7 +106,14 @@ private:
         VkCommandPoolCreateFlags     flags,
         bool                         sharedCmdAllocator);
 
+    static void InitCmdAllocatorCreateInfo(
+        const RuntimeSettings&       settings,
+        Pal::CmdAllocatorCreateInfo* pCreateInfo);
+
+    bool ComputeAdaptedCreateInfo(Pal::CmdAllocatorCreateInfo* pCreateInfo) const;
+
     VkResult ResetCmdAllocator();
+    VkResult ReplaceCmdAllocators(const Pal::CmdAllocatorCreateInfo& createInfo);
 
     Device*                      m_pDevice;
     Pal::ICmdAllocator*          m_pPalCmdAllocators[MaxPalDevices];
@@ -106,13 +125,23 @@ private:
     {
         struct
         {
-            uint32 isProtected : 1;
-            uint32 reserved    : 31;
+            uint32 isProtected           : 1;
+            uint32 adaptiveCmdAllocators : 1;
+            uint32 isDestroying          : 1;   // Command buffers don't unregister themselves while set
+            uint32 reserved              : 29;
         };
         uint32 u32All;
     } m_flags;
 
     Util::HashSet<CmdBuffer*, PalAllocator> m_cmdBufferRegistry;
+
+    // Adaptive sizing of the private CmdAllocators
+    Pal::CmdAllocatorCreateInfo m_cmdAllocatorInfo;                            // Create info of the current allocators
+    Pal::gpusize                m_usageHighWater[Pal::CmdAllocatorTypeCount]; // Decaying peak use of one recording
+    uint32_t                    m_recordingCount;                              // Recordings since the last check
+    std::atomic<uint32_t>       m_submitCount;                                 // Submissions since the last check
+    void*                       m_pReplacedAllocatorMem;                       // Memory of the current allocators if
+                                                                               // they replaced the original ones
 };
 
 namespace entry
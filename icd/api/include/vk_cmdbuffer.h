@@ -44,9 +44,11 @@
 #include "include/vk_render_pass.h"
 #include "include/vk_utils.h"
 
+#include "include/cmd_upload_ring.h"
 #include "include/internal_mem_mgr.h"
 #include "include/virtual_stack_mgr.h"
 #include "include/barrier_policy.h"
+#include "include/device_group_cmd_stream.h"
 
 #include "renderpass/renderpass_builder.h"
 
@@ -74,16 +76,23 @@ namespace vk
 {
 
 // Forward declare Vulkan classes used in this file
+class BarrierProfileCmdBufferState;
+class Buffer;
 class ComputePipeline;
 class Device;
 class DispatchableCmdBuffer;
 class Framebuffer;
+class GpuTimingCmdBufferState;
+class PipelineStatsCmdBufferState;
 class GraphicsPipeline;
 class Image;
+class ImageView;
 class Queue;
+class QueryPool;
 class RenderPass;
 class TimestampQueryPool;
 class SqttCmdBufferState;
+class BarrierFilterCmdBufferState;
 
 constexpr uint8_t DefaultStencilOpValue = 1;
 
@@ -95,6 +104,20 @@ enum PipelineBindPoint
     PipelineBindCount
 };
 
+// Mask with one bit per PipelineBindPoint
+constexpr uint32_t AllPipelineBindMask = (1u << PipelineBindCount) - 1;
+
+// Groups of fixed-function state tracked for redundancy filtering, besides the user data of each bind point.  They are
+// reset separately, e.g. only the groups an executed secondary command buffer changed.
+enum TrackedStateGroup : uint32_t
+{
+    TrackedStateGraphics      = 0x1,  // Static tokens, known dynamic state, viewports and scissors
+    TrackedStateVertexBuffers = 0x2,  // Vertex buffer bindings
+    TrackedStateAll           = 0x3
+};
+
+static_assert(MaxPushConstRegCount <= 32, "PipelineBindState::pushConstProgrammedMask is too small");
+
 // Dynamic bind-time info (wave limits, etc.) for either graphics or compute-based pipelines
 union PipelineDynamicBindInfo
 {
@@ -109,10 +132,16 @@ struct PipelineBindState
     UserDataLayout userDataLayout;
     // High-water mark of the largest number of bound sets
     uint32_t boundSetCount;
+    // Number of leading setBindingData entries whose current value is known to be programmed at userDataLayout's
+    // setBindingRegBase.  Binding a set which doesn't change these entries doesn't need another user data write.
+    uint32_t setBindingProgrammedCount;
     // High-water mark of the largest number of pushed constants
     uint32_t pushedConstCount;
     // Currently pushed constant values (relative to an base = 0)
     uint32_t pushConstData[MaxPushConstRegCount];
+    // Mask of the pushConstData dwords whose current value is known to be programmed at userDataLayout's
+    // pushConstRegBase.  Pushing an unchanged value to one of these dwords doesn't need another user data write.
+    uint32_t pushConstProgrammedMask;
     // Dynamic info (wave limits, etc.)
     PipelineDynamicBindInfo dynamicBindInfo;
 };
@@ -129,12 +158,51 @@ union DirtyState
         uint32 stencilRef       :  1;
         uint32 vrs              :  1;
         uint32 colorWriteEnable :  1;
-        uint32 reserved         : 24;
+        uint32 xfbTargets       :  1;   // Transform feedback targets left bound by EndTransformFeedback
+        uint32 reserved         : 23;
     };
 
     uint32 u32All;
 };
 
+// Dynamic states whose value recorded in the command buffer is known to be what PAL has been given, or will be given
+// once the dirty state is validated.  vkCmdSet* calls which don't change one of these states are filtered out.
+union KnownDynamicState
+{
+    struct
+    {
+        uint32 viewport      :  1;
+        uint32 scissor       :  1;
+        uint32 stencilRef    :  1;
+        uint32 lineWidth     :  1;
+        uint32 depthBias     :  1;
+        uint32 blendConst    :  1;
+        uint32 depthBounds   :  1;
+        uint32 indexBuffer   :  1;
+        uint32 rasterState   :  1;
+        uint32 inputAssembly :  1;
+        uint32 reserved      : 22;
+    };
+
+    uint32 u32All;
+};
+
+// Counts of what was recorded into a command buffer since Begin().  Draw counts and redundant state sets feed the
+// DrawValidation log; the whole block is reported at End() when EnableCmdBufferStats is set.
+struct CmdBufferStats
+{
+    uint64_t drawCount;              // Draws recorded
+    uint64_t validatedDrawCount;     // Draws which had dirty state to validate
+    uint64_t filteredStateCount;     // State setting calls which changed nothing
+    uint64_t dispatchCount;          // Dispatches recorded
+    uint64_t barrierCount;           // vkCmdPipelineBarrier* and vkCmdWaitEvents* calls
+    uint64_t descriptorSetBindCount; // Descriptor sets bound (one per set, not per call)
+    uint64_t pipelineBindCount;      // vkCmdBindPipeline calls
+    uint64_t skippedStateGroupCount; // Graphics pipeline state groups left alone because they matched the previous bind
+    uint64_t mergedQueryResetCount;  // vkCmdResetQueryPool calls merged into the previous reset of the same pool
+    uint64_t elidedClearCount;       // Image clears skipped because they repeated the previous clear
+};
+
 struct DynamicDepthStencil
 {
     Pal::IDepthStencilState* pPalDepthStencil[MaxPalDevices];
@@ -188,6 +256,8 @@ struct AllGpuRenderState
         uint32_t scissorRect;
         uint32_t samplePattern;
         uint32_t fragmentShadingRate;
+        uint32_t staticStateBundle;     // Combined token of the last bound graphics pipeline's static state.  Reset by
+                                        // anything that changes one of the states or PAL objects it covers.
     } staticTokens;
 
     // The Imageless Frambuffer extension allows setting this at RenderPassBind
@@ -197,6 +267,10 @@ struct AllGpuRenderState
     // changed for all GPUs if it is changed for any GPU. Put DirtyState management here will be easier to manage.
     DirtyState dirty;
 
+    // Dynamic states which can be redundancy checked against their recorded values.  Cleared whenever the recorded
+    // values may no longer match the PAL state (e.g. at Begin() or after executing secondary command buffers).
+    KnownDynamicState known;
+
     // Value of VK_PIPELINE_CREATE_VIEW_INDEX_FROM_DEVICE_INDEX_BIT
     // defined by the last bound GraphicsPipeline, which was not nullptr.
     bool viewIndexFromDeviceIndex;
@@ -225,6 +299,18 @@ struct AllGpuRenderState
     Pal::DepthStencilStateCreateInfo depthStencilCreateInfo;
     Pal::VrsRateParams               vrsRate;
     Pal::ColorWriteMaskParams        colorWriteMaskParams;
+
+    // Last values given to PAL by the vkCmdSet* functions which program state directly.  Only meaningful while the
+    // corresponding known bit is set and the static token is DynamicRenderStateToken.
+    Pal::PointLineRasterStateParams  pointLineRasterState;
+    Pal::DepthBiasParams             depthBias;
+    Pal::BlendConstParams            blendConst;
+    Pal::DepthBoundsParams           depthBounds;
+
+    // Last index buffer binding given to PAL.  Only meaningful while known.indexBuffer is set.
+    const Buffer*                    pIndexBuffer;
+    VkDeviceSize                     indexBufferOffset;
+    Pal::IndexType                   indexType;
 };
 
 // State tracked during a render pass instance when building a command buffer.
@@ -261,6 +347,45 @@ struct RenderPassInstanceState
     SamplePattern*                              pSamplePatterns;
 };
 
+// State tracked during a dynamic rendering instance (vkCmdBeginRenderingKHR) when building a command buffer.  The
+// attachments come straight from the begin info: there is no render pass, framebuffer or sync point to interpret, and
+// layouts only change through the application's own barriers.
+struct DynamicRenderingInstanceState
+{
+    // An attachment which is resolved at the end of the instance
+    struct ResolveAttachment
+    {
+        const ImageView*      pSrcView;
+        const ImageView*      pDstView;
+        Pal::ImageLayout      srcLayout;
+        Pal::ImageLayout      dstLayout;
+        uint32_t              plane;
+        VkResolveModeFlagBits resolveMode;
+    };
+
+    bool                  active;                               // Between vkCmdBeginRenderingKHR/EndRenderingKHR, or
+                                                                // a secondary inheriting a dynamic rendering instance
+    VkRenderingFlagsKHR   flags;
+    uint32_t              viewMask;
+    uint32_t              layerCount;
+    uint32_t              renderAreaCount;
+    Pal::Rect             renderArea[MaxPalDevices];
+    uint32_t              colorAttachmentCount;
+    VkFormat              colorFormats[Pal::MaxColorTargets];   // VK_FORMAT_UNDEFINED for unused attachments
+    VkFormat              depthStencilFormat;
+    uint32_t              samples;                              // Sample count of all attachments
+    SamplePattern         samplePattern;                        // Programmed for MSAA instances
+    uint32_t              resolveCount;
+    ResolveAttachment     resolves[Pal::MaxColorTargets + 2];   // Color resolves, then depth and stencil
+};
+
+// A counter buffer location of vkCmdBeginTransformFeedbackEXT or vkCmdEndTransformFeedbackEXT
+struct TransformFeedbackCounter
+{
+    VkBuffer        buffer;     // VK_NULL_HANDLE if the target has no counter buffer
+    VkDeviceSize    offset;
+};
+
 struct TransformFeedbackState
 {
     Pal::BindStreamOutTargetParams  params;
@@ -274,6 +399,11 @@ struct TransformFeedbackState
 
     uint32_t            bindMask;
     bool                enabled;
+
+    // EndTransformFeedback leaves the targets bound and the filled sizes in the GPU until the next draw, so that a
+    // BeginTransformFeedback which resumes from the counters just saved doesn't need to bind and load them again.
+    bool                        unbindPending;
+    TransformFeedbackCounter    savedCounters[Pal::MaxStreamOutTargets];    // Where End saved the filled sizes
 };
 
 enum AcquireReleaseMode
@@ -298,7 +428,11 @@ public:
     VkResult Begin(
         const VkCommandBufferBeginInfo*             pBeginInfo);
 
-    VkResult Reset(VkCommandBufferResetFlags flags);
+    VkResult Reset(
+        VkCommandBufferResetFlags flags,
+        bool                      allowWarmChunks);
+
+    VkResult AdoptPoolCmdAllocators();
 
     VkResult End(void);
 
@@ -314,6 +448,7 @@ public:
         VkDeviceSize                                offset,
         VkIndexType                                 indexType);
 
+    template <uint32_t numPalDevices = MaxPalDevices>
     void BindVertexBuffers(
         uint32_t                                    firstBinding,
         uint32_t                                    bindingCount,
@@ -322,12 +457,14 @@ public:
         const VkDeviceSize*                         pSizes,
         const VkDeviceSize*                         pStrides);
 
+    template <uint32_t numPalDevices = MaxPalDevices>
     void Draw(
         uint32_t                                    firstVertex,
         uint32_t                                    vertexCount,
         uint32_t                                    firstInstance,
         uint32_t                                    instanceCount);
 
+    template <uint32_t numPalDevices = MaxPalDevices>
     void DrawIndexed(
         uint32_t                                    firstIndex,
         uint32_t                                    indexCount,
@@ -344,6 +481,7 @@ public:
         VkBuffer                                    countBuffer,
         VkDeviceSize                                countOffset);
 
+    template <uint32_t numPalDevices = MaxPalDevices>
     void Dispatch(
         uint32_t                                    x,
         uint32_t                                    y,
@@ -451,6 +589,7 @@ public:
         uint32_t                                    rectCount,
         const VkImageResolve*                       pRects);
 
+    template <uint32_t numPalDevices = MaxPalDevices>
     void SetViewport(
         uint32_t                                    firstViewport,
         uint32_t                                    viewportCount,
@@ -464,6 +603,7 @@ public:
         const Pal::ViewportParams&                  params,
         uint32_t                                    staticToken);
 
+    template <uint32_t numPalDevices = MaxPalDevices>
     void SetScissor(
         uint32_t                                    firstScissor,
         uint32_t                                    scissorCount,
@@ -581,6 +721,27 @@ public:
         uint32_t                                    dependencyCount,
         const VkDependencyInfoKHR*                  pDependencyInfos);
 
+    bool CanAcquireLegacyEvents(
+        uint32_t                                    eventCount,
+        const VkEvent*                              pEvents,
+        uint32_t                                    bufferMemoryBarrierCount,
+        const VkBufferMemoryBarrier*                pBufferMemoryBarriers,
+        uint32_t                                    imageMemoryBarrierCount,
+        const VkImageMemoryBarrier*                 pImageMemoryBarriers) const;
+
+    void AcquireLegacyEvents(
+        VirtualStackFrame&                          virtStackFrame,
+        uint32_t                                    eventCount,
+        const VkEvent*                              pEvents,
+        PipelineStageFlags                          srcStageMask,
+        PipelineStageFlags                          dstStageMask,
+        uint32_t                                    memoryBarrierCount,
+        const VkMemoryBarrier*                      pMemoryBarriers,
+        uint32_t                                    bufferMemoryBarrierCount,
+        const VkBufferMemoryBarrier*                pBufferMemoryBarriers,
+        uint32_t                                    imageMemoryBarrierCount,
+        const VkImageMemoryBarrier*                 pImageMemoryBarriers);
+
     void ExecuteAcquireRelease(
         uint32_t                                    eventCount,
         const VkEvent*                              pEvents,
@@ -648,6 +809,12 @@ public:
 
     void EndRenderPass();
 
+    void BeginRendering(
+        const VkRenderingInfoKHR*    pRenderingInfo);
+
+    void EndRendering();
+
+    template <uint32_t numPalDevices = MaxPalDevices>
     void PushConstants(
         VkPipelineLayout                            layout,
         VkShaderStageFlags                          stageFlags,
@@ -661,6 +828,9 @@ public:
         VkDeviceSize            dstOffset,
         uint32_t                marker);
 
+    void BeginDebugLabel(const VkDebugUtilsLabelEXT* pLabelInfo);
+    void EndDebugLabel();
+
     void BindTransformFeedbackBuffers(
         uint32_t            firstBinding,
         uint32_t            bindingCount,
@@ -701,6 +871,9 @@ public:
 
     VK_INLINE void SetDeviceMask(uint32_t deviceMask)
     {
+        // The held back query reset is recorded for the devices current at the time of the vkCmdResetQueryPool call.
+        FlushQueryResets();
+
         // Ensure we are enabling valid devices within the group
         VK_ASSERT((m_pDevice->GetPalDeviceMask() & deviceMask) == deviceMask);
 
@@ -708,9 +881,24 @@ public:
         VK_ASSERT(((m_cbBeginDeviceMask ^ deviceMask) & deviceMask) == 0);
 
         // If called inside a render pass, ensure devices outside of render pass device mask are not enabled
-        VK_ASSERT((m_allGpuState.pRenderPass == nullptr) ||
+        VK_ASSERT(((m_allGpuState.pRenderPass == nullptr) && (m_dynamicRendering.active == false)) ||
                   (((m_rpDeviceMask ^ deviceMask) & deviceMask) == 0));
 
+        // The push constant shadow is shared by all devices, and set bindings were only programmed on the enabled
+        // devices, so a device which was just enabled may not have seen the values which are tracked as programmed.
+        if ((deviceMask & ~m_curDeviceMask) != 0)
+        {
+            for (uint32_t bindIdx = 0; bindIdx < PipelineBindCount; ++bindIdx)
+            {
+                m_allGpuState.pipelineState[bindIdx].pushConstProgrammedMask   = 0;
+                m_allGpuState.pipelineState[bindIdx].setBindingProgrammedCount = 0;
+            }
+
+            // The same goes for the index and vertex buffer bindings, which are filtered device-independently.
+            m_allGpuState.known.indexBuffer = 0;
+            m_vbKnownMask                   = 0;
+        }
+
         m_curDeviceMask = deviceMask;
     }
 
@@ -756,6 +944,13 @@ public:
             int32_t idx) const
     {
         VK_ASSERT((idx >= 0) && (idx < static_cast<int32_t>(MaxPalDevices)));
+
+        // Commands recorded once for all devices must reach PAL before anything recorded directly.
+        if ((m_pDeviceGroupStream != nullptr) && m_pDeviceGroupStream->HasPendingCommands())
+        {
+            m_pDeviceGroupStream->Replay();
+        }
+
         return m_pPalCmdBuffers[idx];
     }
 
@@ -790,6 +985,7 @@ public:
 
     void PalCmdUnbindIndexData(Pal::IndexType indexType);
 
+    template <uint32_t numPalDevices = MaxPalDevices>
     void PalCmdDraw(
         uint32_t firstVertex,
         uint32_t vertexCount,
@@ -797,6 +993,7 @@ public:
         uint32_t instanceCount,
         uint32_t drawId);
 
+    template <uint32_t numPalDevices = MaxPalDevices>
     void PalCmdDrawIndexed(
         uint32_t firstIndex,
         uint32_t indexCount,
@@ -805,6 +1002,7 @@ public:
         uint32_t instanceCount,
         uint32_t drawId);
 
+    template <uint32_t numPalDevices = MaxPalDevices>
     void PalCmdDispatch(
         uint32_t x,
         uint32_t y,
@@ -977,15 +1175,55 @@ public:
     VK_INLINE void DbgBarrierPostCmd(uint32_t cmd) {}
 #endif
 
+    // Pipeline statistics queries around draws and dispatches for the pipeline statistics profile
+    VK_INLINE void PipelineStatsPreCmd(PipelineBindPoint bindPoint)
+    {
+        if (m_flags.pipelineStatsActive)
+        {
+            BeginPipelineStatsSample(bindPoint);
+        }
+    }
+    VK_INLINE void PipelineStatsPostCmd()
+    {
+        if (m_flags.pipelineStatsActive)
+        {
+            EndPipelineStatsSample();
+        }
+    }
+
+    void BeginPipelineStatsSample(PipelineBindPoint bindPoint);
+    void EndPipelineStatsSample();
+
     SqttCmdBufferState* GetSqttState()
         { return m_pSqttState; }
 
+    BarrierFilterCmdBufferState* GetBarrierFilterState()
+        { return m_pBarrierFilterState; }
+
+    const ImageLayoutCmdBufferState* GetImageLayoutState() const
+        { return m_pLayoutState; }
+
+    // Returns the barrier profile state if the barriers recorded into the given PAL command buffer are being measured
+    BarrierProfileCmdBufferState* GetBarrierProfileState(const Pal::ICmdBuffer* pPalCmdBuffer)
+    {
+        return (m_flags.barrierProfileActive && (pPalCmdBuffer == PalCmdBuffer(DefaultDeviceIndex))) ?
+               m_pBarrierProfile : nullptr;
+    }
+
     VK_INLINE static bool IsStaticStateDifferent(
         uint32_t oldToken,
         uint32_t newToken);
 
     static PFN_vkCmdBindDescriptorSets GetCmdBindDescriptorSetsFunc(const Device* pDevice);
 
+    static PFN_vkCmdDraw               GetCmdDrawFunc(const Device* pDevice);
+    static PFN_vkCmdDrawIndexed        GetCmdDrawIndexedFunc(const Device* pDevice);
+    static PFN_vkCmdDispatch           GetCmdDispatchFunc(const Device* pDevice);
+    static PFN_vkCmdPushConstants      GetCmdPushConstantsFunc(const Device* pDevice);
+    static PFN_vkCmdBindVertexBuffers  GetCmdBindVertexBuffersFunc(const Device* pDevice);
+    static PFN_vkCmdSetViewport        GetCmdSetViewportFunc(const Device* pDevice);
+    static PFN_vkCmdSetScissor         GetCmdSetScissorFunc(const Device* pDevice);
+
     CmdPool* GetCmdPool() const { return m_pCmdPool; }
 
     PerGpuRenderState* PerGpuState(uint32 deviceIdx)
@@ -1007,10 +1245,30 @@ public:
     AllGpuRenderState* RenderState()
         { return &m_allGpuState; }
 
+    void RecordSkippedStateGroups(uint32_t count)
+        { m_stats.skippedStateGroupCount += count; }
+
+    // Sets the name reported with the stats of the command buffer, which must be interned in the device name table
+    void SetDebugName(const char* pName)
+        { m_pDebugName = pName; }
+
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(CmdBuffer);
 
-    void ValidateStates();
+    // Draws with no dirty dynamic state (the common case) only pay for a single test of the dirty mask.
+    VK_INLINE void ValidateStates()
+    {
+        m_stats.drawCount++;
+
+        ForgetImageClear();
+
+        if (m_allGpuState.dirty.u32All != 0)
+        {
+            ValidateDirtyStates();
+        }
+    }
+
+    void ValidateDirtyStates();
 
     CmdBuffer(
         Device*                         pDevice,
@@ -1021,17 +1279,33 @@ private:
         void*                           pPalMem,
         const Pal::CmdBufferCreateInfo& createInfo);
 
-    void ResetPipelineState();
+    void ResetPipelineState(
+        uint32_t userDataBindMask,
+        uint32_t stateMask);
+
+    void ReportStats();
+
+    void UpdateCmdDataUsage();
+
+    void ReportCmdAllocatorUsage();
+
+    void UpdateStencilRefMasks(const Pal::StencilRefMaskParams& stencilRefMasks);
 
     void ResetState();
 
+    void GetCounterBuffers(
+        uint32_t                  firstCounterBuffer,
+        uint32_t                  counterBufferCount,
+        const VkBuffer*           pCounterBuffers,
+        const VkDeviceSize*       pCounterBufferOffsets,
+        TransformFeedbackCounter* pCounters) const;
+
     VK_INLINE void CalcCounterBufferAddrs(
-        uint32_t            firstCounterBuffer,
-        uint32_t            counterBufferCount,
-        const VkBuffer*     pCounterBuffers,
-        const VkDeviceSize* pCounterBufferOffsets,
-        uint64_t*           counterBufferAddr,
-        uint32_t            deviceIdx);
+        const TransformFeedbackCounter* pCounters,
+        uint64_t*                       counterBufferAddr,
+        uint32_t                        deviceIdx);
+
+    void UnbindTransformFeedbackTargets();
 
     void FlushBarriers(
         Pal::BarrierInfo*              pBarrier,
@@ -1075,6 +1349,7 @@ private:
     void RPResolveAttachments(uint32_t count, const RPResolveInfo* pResolves);
     void RPSyncPoint(const RPSyncPointInfo& syncPoint, VirtualStackFrame* pVirtStack);
     void RPLoadOpClearColor(uint32_t count, const RPLoadOpClearInfo* pClears);
+    void RPLoadOpClearBoundColorTargets(uint32_t count, const RPLoadOpClearInfo* pClears);
     void RPLoadOpClearDepthStencil(uint32_t count, const RPLoadOpClearInfo* pClears);
     void RPBindTargets(const RPBindTargetsInfo& targets);
     void RPSyncPostLoadOpColorClear();
@@ -1083,6 +1358,65 @@ private:
 
     VK_INLINE Pal::ImageLayout RPGetAttachmentLayout(uint32_t attachment, uint32_t plane);
     VK_INLINE void RPSetAttachmentLayout(uint32_t attachment, uint32_t plane, Pal::ImageLayout layout);
+    void RPInitAttachmentLayouts();
+    void RPCacheAttachmentLayouts();
+
+    void DRBindTargets(const VkRenderingInfoKHR& renderingInfo);
+    void DRLoadOpClears(const VkRenderingInfoKHR& renderingInfo);
+    void DRResolveAttachments();
+    void DRAddResolve(const VkRenderingAttachmentInfoKHR& attachment, uint32_t plane);
+
+    // Returns the view mask of the current subpass or dynamic rendering instance, or 0 if multiview is disabled
+    VK_INLINE uint32_t GetActiveViewMask() const
+    {
+        return (m_allGpuState.pRenderPass != nullptr) ?
+               m_allGpuState.pRenderPass->GetViewMask(m_renderPassInstance.subpass) :
+               m_dynamicRendering.viewMask;
+    }
+
+    void PalCmdResetQueryPool(
+        const QueryPool* pBasePool,
+        uint32_t         firstQuery,
+        uint32_t         queryCount);
+
+    // Records the query reset held back by ResetQueryPool(), if any.  Must be called before any command which could
+    // access queries.
+    VK_INLINE void FlushQueryResets()
+    {
+        if (m_pendingQueryReset.pPool != nullptr)
+        {
+            PalCmdResetQueryPool(m_pendingQueryReset.pPool,
+                                 m_pendingQueryReset.firstQuery,
+                                 m_pendingQueryReset.queryCount);
+
+            m_pendingQueryReset.pPool = nullptr;
+        }
+    }
+
+    // Forgets the clear remembered by IsRedundantImageClear().  Must be called before any command which could write
+    // memory.
+    VK_INLINE void ForgetImageClear()
+    {
+        m_lastImageClear.pImage = nullptr;
+    }
+
+    // Forgets that the transform feedback filled sizes in the GPU match the counter buffers EndTransformFeedback saved
+    // them to.  Must be called before any command which could write buffer memory.
+    VK_INLINE void ForgetTransformFeedbackCounters()
+    {
+        m_flags.xfbCountersResident = 0;
+    }
+
+    void KeepTransientContents(
+        const Image*  pImage,
+        VkImageLayout oldLayout);
+
+    bool IsRedundantImageClear(
+        const Image*                   pImage,
+        Pal::ImageLayout               layout,
+        uint32_t                       rangeCount,
+        const VkImageSubresourceRange* pRanges,
+        const uint32_t*                pValue);
 
     void FillTimestampQueryPool(
         const TimestampQueryPool& timestampQueryPool,
@@ -1122,6 +1456,63 @@ private:
     template <uint32_t numPalDevices>
     static PFN_vkCmdBindDescriptorSets GetCmdBindDescriptorSetsFunc(const Device* pDevice);
 
+    // Entry points specialized on the number of PAL devices.  The single-device instantiations are installed in the
+    // dispatch table so that single-GPU devices skip the device mask iteration on the hottest recording commands.
+    template <uint32_t numPalDevices>
+    static VKAPI_ATTR void VKAPI_CALL CmdDraw(
+        VkCommandBuffer                             cmdBuffer,
+        uint32_t                                    vertexCount,
+        uint32_t                                    instanceCount,
+        uint32_t                                    firstVertex,
+        uint32_t                                    firstInstance);
+
+    template <uint32_t numPalDevices>
+    static VKAPI_ATTR void VKAPI_CALL CmdDrawIndexed(
+        VkCommandBuffer                             cmdBuffer,
+        uint32_t                                    indexCount,
+        uint32_t                                    instanceCount,
+        uint32_t                                    firstIndex,
+        int32_t                                     vertexOffset,
+        uint32_t                                    firstInstance);
+
+    template <uint32_t numPalDevices>
+    static VKAPI_ATTR void VKAPI_CALL CmdDispatch(
+        VkCommandBuffer                             cmdBuffer,
+        uint32_t                                    x,
+        uint32_t                                    y,
+        uint32_t                                    z);
+
+    template <uint32_t numPalDevices>
+    static VKAPI_ATTR void VKAPI_CALL CmdPushConstants(
+        VkCommandBuffer                             cmdBuffer,
+        VkPipelineLayout                            layout,
+        VkShaderStageFlags                          stageFlags,
+        uint32_t                                    offset,
+        uint32_t                                    size,
+        const void*                                 pValues);
+
+    template <uint32_t numPalDevices>
+    static VKAPI_ATTR void VKAPI_CALL CmdBindVertexBuffers(
+        VkCommandBuffer                             cmdBuffer,
+        uint32_t                                    firstBinding,
+        uint32_t                                    bindingCount,
+        const VkBuffer*                             pBuffers,
+        const VkDeviceSize*                         pOffsets);
+
+    template <uint32_t numPalDevices>
+    static VKAPI_ATTR void VKAPI_CALL CmdSetViewport(
+        VkCommandBuffer                             cmdBuffer,
+        uint32_t                                    firstViewport,
+        uint32_t                                    viewportCount,
+        const VkViewport*                           pViewports);
+
+    template <uint32_t numPalDevices>
+    static VKAPI_ATTR void VKAPI_CALL CmdSetScissor(
+        VkCommandBuffer                             cmdBuffer,
+        uint32_t                                    firstScissor,
+        uint32_t                                    scissorCount,
+        const VkRect2D*                             pScissors);
+
     VK_INLINE bool PalPipelineBindingOwnedBy(
         Pal::PipelineBindPoint palBind,
         PipelineBindPoint apiBind
@@ -1132,6 +1523,7 @@ private:
         Pal::PipelineBindPoint* pPalBindPoint,
         PipelineBindPoint*      pApiBind);
 
+    template <uint32_t numPalDevices = MaxPalDevices>
     VK_INLINE void WritePushConstants(
         PipelineBindPoint      apiBindPoint,
         Pal::PipelineBindPoint palBindPoint,
@@ -1167,11 +1559,41 @@ private:
             uint32_t subpassLoadOpClearsBoundAttachments :  1;
             uint32_t hasReleaseAcquire                   :  1;
             uint32_t useSplitReleaseAcquire              :  1;
-            uint32_t reserved2                           :  3;
-            uint32_t reserved                            : 18;
+            uint32_t trackSecondaryFootprint             :  1;
+            uint32_t adaptivePrefetch                    :  1;
+            uint32_t skipNextPrefetch                    :  1;
+            uint32_t reportStats                         :  1;
+            uint32_t keepWarmChunks                      :  1;
+            uint32_t useReleaseAcquireForEvents          :  1;
+            uint32_t coalesceQueryResets                 :  1;
+            uint32_t elideRedundantClears                :  1;
+            uint32_t gpuTimingActive                     :  1;
+            uint32_t pipelineStatsActive                 :  1;
+            uint32_t barrierProfileActive                :  1;
+            uint32_t xfbCountersResident                 :  1;
+            uint32_t reserved                            :  9;
         };
     };
 
+    // A vkCmdResetQueryPool range which hasn't been recorded yet
+    struct PendingQueryReset
+    {
+        const QueryPool* pPool;       // Query pool to reset, or nullptr if no reset is pending
+        uint32_t         firstQuery;
+        uint32_t         queryCount;
+    };
+
+    // The last single-range vkCmdClearColorImage or vkCmdClearDepthStencilImage, while nothing which could write memory
+    // has been recorded after it
+    struct LastImageClear
+    {
+        const Image*            pImage;      // Cleared image, or nullptr if there is no such clear
+        Pal::ImageLayout        layout;
+        uint32_t                deviceMask;
+        VkImageSubresourceRange range;       // With VK_REMAINING_MIP_LEVELS and VK_REMAINING_ARRAY_LAYERS resolved
+        uint32_t                value[4];    // Clear color, or the depth bits followed by the stencil value
+    };
+
     Device* const                 m_pDevice;
     CmdPool* const                m_pCmdPool;
     uint32_t                      m_queueFamilyIndex;
@@ -1194,7 +1616,19 @@ private:
 
     SqttCmdBufferState*           m_pSqttState; // Per-cmdbuf state for handling SQ thread-tracing annotations
 
+    BarrierFilterCmdBufferState*  m_pBarrierFilterState; // Per-cmdbuf image state tracked by the barrier filter layer
+
+    ImageLayoutCmdBufferState*    m_pLayoutState; // Layouts of tracked images, committed to them on submission
+
+    GpuTimingCmdBufferState*      m_pGpuTiming; // Timestamps around the command buffer and its debug labels, if enabled
+
+    PipelineStatsCmdBufferState*  m_pPipelineStats; // Pipeline statistics queries around sampled draws, if enabled
+
+    BarrierProfileCmdBufferState* m_pBarrierProfile; // Timestamps around barriers for the barrier profile, if enabled
+    DeviceGroupCmdStream*         m_pDeviceGroupStream; // Draws, dispatches and user data recorded once for all devices
+
     RenderPassInstanceState       m_renderPassInstance;
+    DynamicRenderingInstanceState m_dynamicRendering;
     TransformFeedbackState*       m_pTransformFeedbackState;
 
 #if VK_ENABLE_DEBUG_BARRIERS
@@ -1205,6 +1639,30 @@ private:
     Util::Vector<DynamicDepthStencil, 16, PalAllocator> m_palDepthStencilState;
 
     uint32                        m_vbWatermark;  // tracks how many vb entries need to be reset
+    uint64_t                      m_vbKnownMask;  // vb slots whose PAL binding is known to match vbBindings
+
+    uint32_t                      m_footprintUserDataMask; // Bind points whose user data this secondary leaves
+                                                           // changed once executed (see TrackSecondaryFootprints)
+    uint32_t                      m_footprintStateMask;    // TrackedStateGroups this secondary leaves changed
+
+    uint32_t                      m_touchedUserDataMask;  // Bind points whose PipelineBindState may differ from its
+                                                          // reset state
+    uint32_t                      m_touchedStateMask;     // TrackedStateGroups which may differ from their reset state
+
+    Pal::gpusize                  m_cmdDataUsedSize;      // Command data used by the last recording
+    Pal::gpusize                  m_cmdDataHighWater;     // Most command data used by a recording since the chunks
+                                                          // were last returned
+
+    CmdBufferStats                m_stats;              // Recording statistics since Begin()
+    const char*                   m_pDebugName;         // Debug utils name, if a messenger was registered when it
+                                                        // was set
+
+    PendingQueryReset             m_pendingQueryReset;  // Query reset held back to be merged with later ones
+    LastImageClear                m_lastImageClear;     // Clear which an identical following clear can be skipped for
+
+    CmdUploadRing                 m_uploadRing;         // Staging memory for vkCmdUpdateBuffer data
+    Pal::gpusize                  m_updateBufferStagingThreshold; // Smallest vkCmdUpdateBuffer staged through the
+                                                                  // upload ring, or 0
 
 };
 
@@ -1230,6 +1688,10 @@ void CmdBuffer::PalCmdBindMsaaState(
         pPalCmdBuf->CmdBindMsaaState(pState);
 
         PerGpuState(deviceIdx)->pMsaaState = pState;
+
+        m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
+
+        m_touchedStateMask |= TrackedStateGraphics;
     }
 }
 
@@ -1246,6 +1708,10 @@ void CmdBuffer::PalCmdBindColorBlendState(
         pPalCmdBuf->CmdBindColorBlendState(pState);
 
         PerGpuState(deviceIdx)->pColorBlendState = pState;
+
+        m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
+
+        m_touchedStateMask |= TrackedStateGraphics;
     }
 }
 
@@ -1262,6 +1728,10 @@ void CmdBuffer::PalCmdBindDepthStencilState(
         pPalCmdBuf->CmdBindDepthStencilState(pState);
 
         PerGpuState(deviceIdx)->pDepthStencilState = pState;
+
+        m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
+
+        m_touchedStateMask |= TrackedStateGraphics;
     }
 }
 
@@ -1867,6 +2337,13 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetColorWriteEnableEXT(
     uint32_t                                    attachmentCount,
     const VkBool32*                             pColorWriteEnables);
 
+VKAPI_ATTR void VKAPI_CALL vkCmdBeginRenderingKHR(
+    VkCommandBuffer                             commandBuffer,
+    const VkRenderingInfoKHR*                   pRenderingInfo);
+
+VKAPI_ATTR void VKAPI_CALL vkCmdEndRenderingKHR(
+    VkCommandBuffer                             commandBuffer);
+
 } // namespace entry
 
 } // namespace vk
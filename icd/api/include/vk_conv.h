@@ -50,13 +50,11 @@
 
 #include "vkgcDefs.h"
 
+#include <utility>
+
 namespace vk
 {
 
-namespace convert
-{
-extern Pal::SwizzledFormat VkToPalSwizzledFormatLookupTableStorage[VK_FORMAT_END_RANGE + 1];
-};
 
 constexpr uint32_t MaxPalAspectsPerMask         = 3;    // Images can have up to 3 planes (YUV image).
 constexpr uint32_t MaxPalColorAspectsPerMask    = 3;    // YUV images can have up to 3 planes.
@@ -74,45 +72,107 @@ VK_INLINE Pal::SwizzledFormat VkToPalFormat(VkFormat format, const RuntimeSettin
 #define VK_TO_PAL_TABLE_COMPLEX_AMD(srcType, srcTypeName, dstType, convertFunc, mapping) \
     VK_TO_PAL_TABLE_COMPLEX_WITH_SUFFIX(srcType, srcTypeName, dstType, convertFunc, mapping, _AMD)
 
+namespace convert
+{
+
+// One entry of a non-identity lookup table, as returned by the generated VkToPal*Entry() functions
+template<typename T>
+struct LookupEntry
+{
+    constexpr LookupEntry(
+        const T& entryValue,
+        uint32_t entryFlags)
+        :
+        value(entryValue),
+        flags(entryFlags)
+    { }
+
+    T        value;
+    uint32_t flags;   // LookupEntryFlags
+};
+
+enum LookupEntryFlags : uint32_t
+{
+    LookupEntryHandled  = 0x1,  // The enum value is handled by the mapping
+    LookupEntryValid    = 0x2,  // The enum value may be converted
+    LookupEntryIdentity = 0x4   // The enum value would map to itself
+};
+
+// Lookup table laid out densely by source enum value
+template<typename T, size_t N>
+struct LookupTable
+{
+    T values[N];
+
+    constexpr const T& operator[](size_t index) const { return values[index]; }
+};
+
+// =====================================================================================================================
+// Evaluates the given entry function for every source enum value to build a lookup table at compile time
+template<typename T, LookupEntry<T> (*EntryFunc)(size_t), size_t... Indices>
+constexpr LookupTable<T, sizeof...(Indices)> MakeLookupTable(
+    std::index_sequence<Indices...>)
+{
+    return { { EntryFunc(Indices).value... } };
+}
+
+// =====================================================================================================================
+// Returns the number of source enum values in [begin, end] whose entries have all of the given flags set
+template<typename T, LookupEntry<T> (*EntryFunc)(size_t)>
+constexpr size_t CountLookupEntries(
+    size_t   begin,
+    size_t   end,
+    uint32_t flags)
+{
+    size_t count = 0;
+
+    for (size_t i = begin; i <= end; ++i)
+    {
+        if ((EntryFunc(i).flags & flags) == flags)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+} // namespace convert
+
 // =====================================================================================================================
 // Macro to construct helper function for converting non-trivial non-identity mapping enums
 // The generated helper function's name takes the form "dstType convert::convertFunc(srcType)"
+// The lookup table is generated at compile time, densely indexed by enum value; its storage is provided once by
+// VK_TO_PAL_DECL_LOOKUP_TABLE_COMPLEX in vk_conv.cpp.
 // Checks performed:
-// - Checks at load-time whether all enum values in the source enum are handled
-// - Checks at load-time whether the enum actually needs a non-identity mapping
-// - Ensures that the lookup table initialization isn't done more than once
+// - Checks at compile-time whether all enum values in the source enum are handled
+// - Checks at compile-time whether the enum actually needs a non-identity mapping
 // - Checks at run-time whether an intentionally unhandled enum value is used
 #define VK_TO_PAL_TABLE_COMPLEX_WITH_SUFFIX(srcType, srcTypeName, dstType, convertFunc, mapping, suffix) \
     namespace convert \
     { \
-        extern dstType VkToPal##convertFunc##LookupTableStorage[VK_##srcType##_END_RANGE##suffix + 1]; \
-        extern const dstType* VkToPal##convertFunc##LookupTable; \
-        VK_DBG_DECL(extern bool VkToPal##convertFunc##Valid[VK_##srcType##_END_RANGE##suffix + 1]); \
-        static const dstType* InitVkToPal##convertFunc##LookupTable() \
+        typedef LookupTable<dstType, VK_##srcType##_END_RANGE##suffix + 1> VkToPal##convertFunc##LookupTableType; \
+        extern const VkToPal##convertFunc##LookupTableType VkToPal##convertFunc##LookupTable; \
+        constexpr LookupEntry<dstType> VkToPal##convertFunc##Entry(size_t i) \
         { \
-            dstType* lookupTable = VkToPal##convertFunc##LookupTableStorage; \
-            VK_DBG_DECL(static size_t numMatching = 0); \
-            VK_DBG_DECL(static bool initialized = false); \
-            VK_DBG_CHECK(!initialized, "Lookup table of Vk" #srcTypeName " should not be initialized more than once"); \
-            VK_DBG_EXPR(initialized = true); \
-            for (size_t i = VK_##srcType##_BEGIN_RANGE##suffix; i <= VK_##srcType##_END_RANGE##suffix; ++i) \
+            using Entry = LookupEntry<dstType>; \
+            switch (i) \
             { \
-                VK_DBG_DECL(bool& valid = VkToPal##convertFunc##Valid[i]); \
-                VK_DBG_EXPR(valid = true); \
-                switch (i) \
-                { \
-                mapping \
-                default: \
-                    VK_DBG_CHECK(false, "Unhandled Vk" #srcTypeName " enum value"); \
-                } \
+            mapping \
+            default: \
+                return Entry(dstType(), 0); \
             } \
-            VK_DBG_CHECK(numMatching != VK_##srcType##_RANGE_SIZE##suffix, "Enum Vk" #srcTypeName " should use " \
-                "identity mapping"); \
-            return lookupTable; \
         } \
+        static_assert(CountLookupEntries<dstType, VkToPal##convertFunc##Entry>(VK_##srcType##_BEGIN_RANGE##suffix, \
+            VK_##srcType##_END_RANGE##suffix, LookupEntryHandled) == VK_##srcType##_RANGE_SIZE##suffix, \
+            "Unhandled Vk" #srcTypeName " enum value"); \
+        static_assert(CountLookupEntries<dstType, VkToPal##convertFunc##Entry>(VK_##srcType##_BEGIN_RANGE##suffix, \
+            VK_##srcType##_END_RANGE##suffix, LookupEntryIdentity) != VK_##srcType##_RANGE_SIZE##suffix, \
+            "Enum Vk" #srcTypeName " should use identity mapping"); \
         VK_INLINE dstType convertFunc(Vk##srcTypeName value) \
         { \
-            VK_DBG_CHECK(VkToPal##convertFunc##Valid[value], "Enum value intentionally unhandled"); \
+            VK_DBG_CHECK((VkToPal##convertFunc##Entry(value).flags & LookupEntryValid) != 0, \
+                         "Enum value intentionally unhandled"); \
             return VkToPal##convertFunc##LookupTable[value]; \
         } \
     }
@@ -131,24 +191,20 @@ VK_INLINE Pal::SwizzledFormat VkToPalFormat(VkFormat format, const RuntimeSettin
 // Macro to construct a single enum value's mapping for converting non-identity mapping enums
 #define VK_TO_PAL_ENTRY_X(srcValue, dstValue) \
     case VK_##srcValue: \
-        VK_DBG_EXPR(if ((int32_t)i == (int32_t)Pal::dstValue) numMatching++); \
-        lookupTable[i] = Pal::dstValue; \
-        break;
+        return Entry(Pal::dstValue, LookupEntryHandled | LookupEntryValid | \
+                     (((int32_t)VK_##srcValue == (int32_t)Pal::dstValue) ? LookupEntryIdentity : 0u));
 
 // =====================================================================================================================
 // Macro to construct a single enum value's mapping for converting enum to struct
 #define VK_TO_PAL_STRUC_X(srcValue, dstValue) \
     case VK_##srcValue: \
-        lookupTable[i] = dstValue; \
-        break;
+        return Entry(dstValue, LookupEntryHandled | LookupEntryValid);
 
 // =====================================================================================================================
 // Macro to make an enum value invalid in case of non-identity mapping enums
 #define VK_TO_PAL_ERROR_X(srcValue) \
     case VK_##srcValue: \
-        VK_DBG_EXPR(numMatching++); \
-        VK_DBG_EXPR(valid = false); \
-        break;
+        return Entry(decltype(Entry::value)(), LookupEntryHandled | LookupEntryIdentity);
 
 // =====================================================================================================================
 // Macro to construct helper function for converting identity mapping enums
@@ -837,10 +893,13 @@ VK_INLINE uint32_t PalToVkVideoProfileLevel(uint32_t level)
 // Helper structure for mapping Vulkan primitive topology to PAL primitive type + adjacency
 struct PalQueryTypePool
 {
-    PalQueryTypePool()
+    constexpr PalQueryTypePool()
+        :
+        m_type(),
+        m_poolType()
     { }
 
-    PalQueryTypePool(
+    constexpr PalQueryTypePool(
         Pal::QueryType      type,
         Pal::QueryPoolType  poolType) :
         m_type(type),
@@ -1751,7 +1810,7 @@ VK_INLINE Pal::MemoryImageCopyRegion VkToPalMemoryImageCopyRegion(
 
 namespace convert
 {
-extern Pal::SwizzledFormat VkToPalSwizzledFormatLookupTableStorage[VK_FORMAT_END_RANGE + 1];
+extern const LookupTable<Pal::SwizzledFormat, VK_FORMAT_END_RANGE + 1> VkToPalSwizzledFormatLookupTable;
 };
 
 // =====================================================================================================================
@@ -1771,7 +1830,7 @@ VK_INLINE Pal::SwizzledFormat VkToPalFormat(VkFormat format, const RuntimeSettin
 {
     if (VK_ENUM_IN_RANGE(format, VK_FORMAT))
     {
-        return convert::VkToPalSwizzledFormatLookupTableStorage[format];
+        return convert::VkToPalSwizzledFormatLookupTable[format];
     }
     else
     {
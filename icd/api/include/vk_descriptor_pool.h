@@ -67,12 +67,22 @@ public:
         Device* pDevice,
         const VkAllocationCallbacks* pAllocator);
 
+    static uint32_t GetSetGpuMemSize(
+        const DescriptorSetLayout*  pLayout,
+        uint32_t                    variableDescriptorCounts);
+
     bool AllocSetGpuMem(
         const DescriptorSetLayout*  pLayout,
         uint32_t                    variableDescriptorCounts,
         Pal::gpusize*               pSetGpuMemOffset,
         void**                      pSetAllocHandle);
 
+    bool AllocOneShotSetGpuMemBatch(
+        uint32_t                    byteSize,
+        uint32_t                    count,
+        Pal::gpusize*               pFirstSetGpuMemOffset,
+        Pal::gpusize*               pSetGpuMemStride);
+
     void GetGpuMemRequirements(
         Pal::GpuMemoryRequirements* pGpuMemReqs);
 
@@ -90,6 +100,13 @@ public:
     VK_INLINE void* CpuShadowAddr(uint32_t deviceIdx) const
         { return m_pCpuShadowAddr[deviceIdx]; }
 
+    uint32_t GetFragmentationPercent() const;
+
+    Pal::gpusize GetUsedBytes() const;
+
+    VK_INLINE Pal::gpusize GetReservedBytes() const
+        { return m_gpuMemSize; }
+
 protected:
     struct DynamicAllocBlock
     {
@@ -101,6 +118,15 @@ protected:
         Pal::gpusize          gpuMemOffsetRangeEnd;     // End of GPU address range of this block
     };
 
+    // Free blocks are binned by size class: class k holds the free blocks whose size is in [2^k, 2^(k+1)) bytes, the
+    // last class also holds everything larger.
+    static constexpr uint32_t NumSizeClasses = 32;
+
+    static uint32_t SizeClass(Pal::gpusize size)
+    {
+        return (size > 0) ? Util::Min(Util::Log2(size), NumSizeClasses - 1) : 0;
+    }
+
     bool IsDynamicAllocBlockFree(const DynamicAllocBlock* pBlock) const
     {
         // pPrevFree is never null for free blocks as they are chained after a list header so this is how we determine
@@ -108,6 +134,11 @@ protected:
         return (pBlock != nullptr) && (pBlock->pPrevFree != nullptr);
     }
 
+    void LinkFreeBlock(DynamicAllocBlock* pBlock);
+    void UnlinkFreeBlock(DynamicAllocBlock* pBlock);
+
+    DynamicAllocBlock* FindFreeBlock(uint32_t byteSize, uint32_t alignment) const;
+
     uint32_t DynamicAllocBlockIndex(const DynamicAllocBlock* pBlock) const
     {
         // Calculate the index of the block within the block storage using pointer arithmetics.
@@ -122,7 +153,9 @@ protected:
 
     Pal::gpusize              m_oneShotAllocForward;    // Start of free memory for one-shot allocs (allocated forwards)
 
-    DynamicAllocBlock         m_dynamicAllocBlockFreeListHeader;    // Header for the list of free blocks
+    DynamicAllocBlock         m_freeListHeaders[NumSizeClasses];    // Headers of the free block list of each size class
+    uint32_t                  m_nonEmptySizeClassMask;              // Size classes whose free list isn't empty
+    Pal::gpusize              m_dynamicFreeBytes;                   // Total size of the free blocks
     DynamicAllocBlock*        m_pDynamicAllocBlocks;                // Storage of block structures
     uint32_t                  m_dynamicAllocBlockCount;             // Number of block structures
     uint32_t*                 m_pDynamicAllocBlockIndexStack;       // Stack of indices of available block structures
@@ -163,6 +196,16 @@ public:
     template <uint32_t numPalDevices>
     bool AllocSetState(VkDescriptorSet* pSet);
 
+    template <uint32_t numPalDevices>
+    void AllocSetStateBatch(uint32_t count, VkDescriptorSet* pSets);
+
+    // Number of sets which can still be allocated from the never-used range of the heap
+    VK_INLINE uint32_t GetUnusedSetCount() const
+        { return m_maxSets - m_nextFreeHandle; }
+
+    VK_INLINE uint32_t GetMaxSets() const
+        { return m_maxSets; }
+
     template <uint32_t numPalDevices>
     void FreeSetState(VkDescriptorSet set);
 
@@ -181,6 +224,8 @@ private:
     VkDescriptorSet DescriptorSetHandleFromIndex(uint32_t idx) const;
 
     uint32_t             m_nextFreeHandle;
+    uint32_t             m_usedSetCount;    // Sets handed out at least once since creation; only those can own
+                                            // private data
     uint32_t             m_maxSets;
 
     uint32_t*            m_pFreeIndexStack;
@@ -239,7 +284,66 @@ private:
         const VkDescriptorPoolCreateInfo*     pCreateInfo,
         const VkAllocationCallbacks*          pAllocator);
 
-    DescriptorPool(Device* pDevice);
+    DescriptorPool(Device* pDevice, void* pSetAllocInfoMem);
+
+    // How a set of a pool with FREE_DESCRIPTOR_SET_BIT was allocated, indexed by the set's heap index
+    struct SetAllocInfo
+    {
+        VkDescriptorSet nextFreed;     // Next set in the same freed set bucket
+        Pal::gpusize    gpuMemOffset;  // Offset of the set's GPU memory
+        uint32_t        gpuMemSize;    // Size of the set's GPU memory as computed by GetSetGpuMemSize()
+    };
+
+    // Freed sets whose state and GPU memory are kept for another set needing the same amount of GPU memory.  Keyed by
+    // that size rather than by layout, as a layout may be destroyed before the sets allocated with it are freed.
+    struct FreedSetBucket
+    {
+        uint32_t        gpuMemSize;    // GPU memory size of the sets in this bucket
+        uint32_t        count;         // Number of sets in this bucket
+        VkDescriptorSet head;          // Most recently freed set
+    };
+
+    static constexpr uint32_t FreedSetBucketCount = 8;
+
+    // Memory use of this pool.  The device-wide totals in DescriptorPoolStats are kept in step with this.
+    struct PoolStats
+    {
+        bool         registered;     // Whether the pool was added to the device-wide totals
+        uint32_t     liveSets;       // Sets currently allocated (not counting freed sets kept for reuse)
+        uint32_t     peakLiveSets;   // Most sets allocated at once
+        uint32_t     allocFailures;  // Allocate calls which ran out of pool memory
+        uint64_t     setsAllocated;  // Sets allocated over the pool's lifetime
+        Pal::gpusize usedBytes;      // GPU memory in use, as last reported to the device
+        Pal::gpusize peakUsedBytes;  // Most GPU memory in use at once
+    };
+
+    void UpdateStats(int32_t liveSetDelta);
+
+    void WriteStats(const char* pFilePath) const;
+
+    template <uint32_t numPalDevices>
+    bool AllocSameLayoutDescriptorSets(
+        uint32_t                     count,
+        const VkDescriptorSetLayout* pSetLayouts,
+        VkDescriptorSet*             pDescriptorSets);
+
+    template <uint32_t numPalDevices>
+    void AssignSet(
+        VkDescriptorSet            set,
+        const DescriptorSetLayout* pLayout,
+        Pal::gpusize               gpuMemOffset,
+        void*                      pSetAllocHandle);
+
+    template <uint32_t numPalDevices>
+    bool TakeFreedSet(
+        uint32_t         gpuMemSize,
+        VkDescriptorSet* pSet);
+
+    template <uint32_t numPalDevices>
+    bool CacheFreedSet(VkDescriptorSet set);
+
+    template <uint32_t numPalDevices>
+    bool ReleaseFreedSets();
 
     template <uint32_t numPalDevices>
     static VKAPI_ATTR VkResult VKAPI_CALL CreateDescriptorPool(
@@ -277,6 +381,11 @@ private:
 
     DescriptorAddr       m_addresses[MaxPalDevices];
 
+    SetAllocInfo*        m_pSetAllocInfo;      // Per-set allocation info (only for FREE_DESCRIPTOR_SET_BIT pools)
+    FreedSetBucket       m_freedSetBuckets[FreedSetBucketCount];
+
+    PoolStats            m_stats;
+
 };
 
 namespace entry
@@ -43,6 +43,13 @@
 
 #include "pal.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define VK_STREAMING_SRD_STORES 1
+#else
+#define VK_STREAMING_SRD_STORES 0
+#endif
+
 namespace vk
 {
 
@@ -301,6 +308,64 @@ public:
 
     static PFN_vkUpdateDescriptorSets GetUpdateDescriptorSetsFunc(const Device* pDevice);
 
+    // Descriptor set memory is mapped write-combined, and SRDs are written once and not read back by the CPU.  Whole
+    // SRDs are therefore written with non-temporal stores when the destination is suitably aligned, which fills the
+    // write-combining buffers without pulling the destination lines into the cache first.
+    template <size_t srdSize>
+    static VK_FORCEINLINE void CopySrd(
+        uint32_t*   pDestAddr,
+        const void* pSrcDesc)
+    {
+#if VK_STREAMING_SRD_STORES
+        if (((srdSize % sizeof(__m128i)) == 0) &&
+            Util::IsPow2Aligned(reinterpret_cast<uint64_t>(pDestAddr), sizeof(__m128i)))
+        {
+            __m128i*       pDst = reinterpret_cast<__m128i*>(pDestAddr);
+            const __m128i* pSrc = static_cast<const __m128i*>(pSrcDesc);
+
+            for (size_t i = 0; i < (srdSize / sizeof(__m128i)); ++i)
+            {
+                _mm_stream_si128(pDst + i, _mm_loadu_si128(pSrc + i));
+            }
+        }
+        else
+#endif
+        {
+            memcpy(pDestAddr, pSrcDesc, srdSize);
+        }
+    }
+
+    template <size_t srdSize>
+    static VK_FORCEINLINE void ClearSrd(
+        uint32_t* pDestAddr)
+    {
+#if VK_STREAMING_SRD_STORES
+        if (((srdSize % sizeof(__m128i)) == 0) &&
+            Util::IsPow2Aligned(reinterpret_cast<uint64_t>(pDestAddr), sizeof(__m128i)))
+        {
+            __m128i* pDst = reinterpret_cast<__m128i*>(pDestAddr);
+
+            for (size_t i = 0; i < (srdSize / sizeof(__m128i)); ++i)
+            {
+                _mm_stream_si128(pDst + i, _mm_setzero_si128());
+            }
+        }
+        else
+#endif
+        {
+            memset(pDestAddr, 0, srdSize);
+        }
+    }
+
+    // Orders the non-temporal stores of CopySrd() and ClearSrd() before any later store, e.g. a submit on another
+    // thread.  Called once at the end of every descriptor update entry point.
+    static VK_INLINE void FinishSrdWrites()
+    {
+#if VK_STREAMING_SRD_STORES
+        _mm_sfence();
+#endif
+    }
+
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(DescriptorUpdate);
 
@@ -335,6 +400,12 @@ private:
         uint32_t                     descriptorWriteCount,
         const VkWriteDescriptorSet*  pDescriptorWrites);
 
+    template <bool fmaskBasedMsaaReadEnabled, uint32_t numPalDevices>
+    static uint32_t CopyWholeDescriptorSet(
+        uint32_t                     deviceIdx,
+        uint32_t                     descriptorCopyCount,
+        const VkCopyDescriptorSet*   pDescriptorCopies);
+
     template <size_t imageDescSize, size_t fmaskDescSize, bool fmaskBasedMsaaReadEnabled, uint32_t numPalDevices>
     static void CopyDescriptorSets(
         const Device*                pDevice,
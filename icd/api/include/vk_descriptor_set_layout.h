@@ -63,6 +63,7 @@ struct DescriptorBindingFlags
 };
 
 class Device;
+class LayoutSignature;
 
 // =====================================================================================================================
 // API implementation of Vulkan descriptor set layout objects
@@ -230,6 +231,10 @@ protected:
     static uint64_t BuildApiHash(
         const VkDescriptorSetLayoutCreateInfo* pCreateInfo);
 
+    static void BuildSignature(
+        const VkDescriptorSetLayoutCreateInfo* pCreateInfo,
+        LayoutSignature*                       pSignature);
+
     const CreateInfo          m_info;    // Create-time information
     const Device* const       m_pDevice; // Device pointer
     const uint64_t            m_apiHash;
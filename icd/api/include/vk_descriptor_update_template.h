@@ -92,6 +92,11 @@ private:
         size_t          dstDynOffset;
     };
 
+    static bool ExtendsEntry(
+        const TemplateUpdateInfo& prev,
+        const TemplateUpdateInfo& next,
+        bool                      inlineUniformBlock);
+
     const TemplateUpdateInfo* GetEntries() const
     {
         return static_cast<const TemplateUpdateInfo*>(Util::VoidPtrInc(this, sizeof(*this)));
@@ -38,6 +38,7 @@
 
 #include "include/vk_defines.h"
 #include "include/vk_dispatch.h"
+#include "include/vk_event.h"
 #include "include/vk_physical_device.h"
 #include "include/vk_private_data_slot.h"
 #include "include/vk_queue.h"
@@ -50,6 +51,25 @@
 #include "include/render_state_cache.h"
 #include "include/virtual_stack_mgr.h"
 #include "include/barrier_policy.h"
+#include "include/debug_name_table.h"
+#include "include/descriptor_pool_stats.h"
+#include "include/external_memory_cache.h"
+#include "include/memory_block_cache.h"
+#include "include/memory_event_log.h"
+#include "include/perf_counter_registry.h"
+#include "include/gpu_address_index.h"
+#include "include/image_layout_tracker.h"
+#include "include/image_create_info_cache.h"
+#include "include/shader_module_cache.h"
+#include "include/layout_cache.h"
+#include "include/pipeline_compile_event_log.h"
+#include "include/queue_timing_log.h"
+#include "include/memory_residency_tracker.h"
+#include "include/transient_alias_planner.h"
+#include "include/pipeline_autotuner.h"
+#include "include/timestamp_calibrator.h"
+
+#include "utils/temp_mem_arena.h"
 
 #include "palDevice.h"
 #include "palImage.h"
@@ -57,6 +77,8 @@
 #include "palHashMap.h"
 #include "palPipeline.h"
 
+#include <atomic>
+
 namespace Pal
 {
 class IPipeline;
@@ -81,11 +103,14 @@ namespace vk
 {
 
 // Forward declarations of Vulkan classes used in this file.
+class ApiObjectPool;
+class ApiProfileLayer;
 class BarrierFilterLayer;
 class Buffer;
 class Device;
 class DispatchableDevice;
 class DispatchableQueue;
+class Fence;
 class Instance;
 class OptLayer;
 class PhysicalDevice;
@@ -94,6 +119,10 @@ class SqttMgr;
 class SwapChain;
 class ChillMgr;
 class AsyncLayer;
+class CompileThreadPool;
+class GpuTimingTable;
+class PipelineStatsProfile;
+class BarrierProfile;
 
 // =====================================================================================================================
 // Specifies properties for importing a semaphore, it's an encapsulation of VkImportSemaphoreFdInfoKHR and
@@ -142,6 +171,12 @@ public:
     };
     static const uint32_t MaxInternalPipelineUserNodeCount = 16;
 
+    // Upper bound on the number of thread-safe CmdAllocators command pools are spread over with UseSharedCmdAllocator
+    static const uint32_t MaxSharedCmdAllocators = 16;
+
+    // Upper bound on the number of SDMA engines a software compositing copy is split across
+    static const uint32_t MaxSwCompositingEngines = 2;
+
     typedef VkDevice ApiType;
 
     struct Properties
@@ -393,9 +428,18 @@ public:
     VK_FORCEINLINE Pal::ICmdAllocator* GetSharedCmdAllocator(int32_t idx) const
     {
         VK_ASSERT((idx >= 0) && (idx < static_cast<int32_t>(m_palDeviceCount)));
-        return m_perGpu[idx].pSharedPalCmdAllocator;
+        return m_perGpu[idx].pSharedPalCmdAllocators[0];
+    }
+
+    VK_FORCEINLINE Pal::ICmdAllocator* GetSharedCmdAllocator(int32_t idx, uint32_t slot) const
+    {
+        VK_ASSERT((idx >= 0) && (idx < static_cast<int32_t>(m_palDeviceCount)));
+        VK_ASSERT(slot < m_sharedCmdAllocatorCount);
+        return m_perGpu[idx].pSharedPalCmdAllocators[slot];
     }
 
+    uint32_t AcquireSharedCmdAllocatorSlot();
+
     VK_FORCEINLINE const Properties& GetProperties() const
         { return m_properties; }
 
@@ -484,6 +528,17 @@ public:
         Pal::IDevice*       pPalDevice,
         Pal::IGpuMemory*    pPalMemory);
 
+    Pal::Result AddDeferredMemReference(
+        Pal::IDevice*       pPalDevice,
+        Pal::IGpuMemory*    pPalMemory);
+
+    Pal::Result FlushMemReferences();
+
+    Fence* AcquirePooledFence();
+
+    bool ReleasePooledFence(
+        Fence*              pFence);
+
     VK_INLINE const RuntimeSettings& GetRuntimeSettings() const
         { return m_settings; }
 
@@ -537,8 +592,7 @@ public:
                 m_overallocationRequestedForPalHeap[palHeapIdx]);
     }
 
-    VK_INLINE const InternalPipeline& GetTimestampQueryCopyPipeline() const
-        { return m_timestampQueryCopyPipeline; }
+    const InternalPipeline* GetTimestampQueryCopyPipeline();
 
     VK_INLINE InternalPipeline& GetInternalRayTracingPipeline()
     {
@@ -565,9 +619,99 @@ public:
     VK_INLINE AsyncLayer* GetAsyncLayer()
         { return m_pAsyncLayer; }
 
+    VK_INLINE ApiProfileLayer* GetApiProfileLayer()
+        { return m_pApiProfileLayer; }
+
+    VK_INLINE CompileThreadPool* GetCompileThreadPool()
+        { return m_pCompileThreadPool; }
+
+    VK_INLINE GpuTimingTable* GetGpuTimingTable()
+        { return m_pGpuTimingTable; }
+
+    void WriteGpuTimingTable(const char* pFilePath);
+
+    VK_INLINE PipelineStatsProfile* GetPipelineStatsProfile()
+        { return m_pPipelineStatsProfile; }
+
+    void WritePipelineStatsProfile(const char* pFilePath);
+
+    VK_INLINE BarrierProfile* GetBarrierProfile()
+        { return m_pBarrierProfile; }
+
+    void WriteBarrierProfile(const char* pFilePath);
+
+    void RecordDrawValidationStats(
+        uint64_t drawCount,
+        uint64_t validatedDrawCount,
+        uint64_t filteredStateCount);
+
+    VK_INLINE DescriptorPoolStats* GetDescriptorPoolStats()
+        { return &m_descriptorPoolStats; }
+
+    void WriteDescriptorPoolStats(const char* pFilePath);
+
+    VK_INLINE MemoryBlockCache* GetMemoryBlockCache()
+        { return &m_memoryBlockCache; }
+
+    VK_INLINE ExternalMemoryCache* GetExternalMemoryCache()
+        { return &m_externalMemoryCache; }
+
+    VK_INLINE DebugNameTable* GetDebugNameTable()
+        { return &m_debugNameTable; }
+
+    VK_INLINE EventStatusValues* GetEventStatusValues()
+        { return &m_eventStatusValues; }
+
+    VK_INLINE utils::TempMemArenaPool* GetTempMemArenaPool()
+        { return &m_tempMemArenaPool; }
+
+    VK_INLINE MemoryResidencyTracker* GetResidencyTracker()
+        { return &m_residencyTracker; }
+
+    VK_INLINE MemoryEventLog* GetMemoryEventLog()
+        { return &m_memoryEventLog; }
+
+    VK_INLINE PerfCounterRegistry* GetPerfCounters()
+        { return &m_perfCounters; }
+
+    void WritePerfCounters(const char* pFilePath);
+
+    VK_INLINE GpuAddressIndex* GetGpuAddressIndex()
+        { return &m_gpuAddressIndex; }
+
+    VK_INLINE ImageCreateInfoCache* GetImageCreateInfoCache()
+        { return &m_imageCreateInfoCache; }
+
+    VK_INLINE ShaderModuleCache* GetShaderModuleCache()
+        { return &m_shaderModuleCache; }
+
+    VK_INLINE LayoutCache* GetLayoutCache()
+        { return &m_layoutCache; }
+
+    VK_INLINE TransientAliasPlanner* GetTransientAliasPlanner()
+        { return &m_transientAliasPlanner; }
+
+    VK_INLINE ImageLayoutTracker* GetImageLayoutTracker()
+        { return &m_imageLayoutTracker; }
+
+    VK_INLINE const ImageLayoutTracker* GetImageLayoutTracker() const
+        { return &m_imageLayoutTracker; }
+
+    VK_INLINE PipelineAutotuner* GetPipelineAutotuner()
+        { return &m_pipelineAutotuner; }
+
+    VK_INLINE PipelineCompileEventLog* GetPipelineCompileEventLog()
+        { return &m_pipelineCompileEventLog; }
+
+    VK_INLINE QueueTimingLog* GetQueueTimingLog()
+        { return &m_queueTimingLog; }
+
     VK_INLINE Util::Mutex* GetMemoryMutex()
         { return &m_memoryMutex; }
 
+    VK_INLINE Util::Mutex* GetImageViewSrdCacheLock()
+        { return &m_imageViewSrdCacheLock; }
+
     VK_INLINE PipelineCompiler* GetCompiler(uint32_t idx) const
         { return m_perGpu[idx].pPhysicalDevice->GetCompiler(); }
 
@@ -619,11 +763,14 @@ public:
     }
 
     Pal::IQueue* PerformSwCompositing(
-        uint32_t         deviceIdx,
-        uint32_t         presentationDeviceIdx,
-        Pal::ICmdBuffer* pCommandBuffer,
-        Pal::QueueType   cmdBufferQueueType,
-        const Queue*     pQueue);
+        uint32_t                deviceIdx,
+        uint32_t                presentationDeviceIdx,
+        Pal::ICmdBuffer* const* ppCommandBuffers,
+        uint32_t                cmdBufferCount,
+        Pal::QueueType          cmdBufferQueueType,
+        const Queue*            pQueue);
+
+    uint32_t GetSwCompositingEngineCount(uint32_t deviceIdx) const;
 
     VkResult SwCompositingNotifyFlipMetadata(
         Pal::IQueue*            pPresentQueue,
@@ -654,14 +801,19 @@ public:
         const VkAllocationCallbacks*    pAllocator,
         void*                           pMemory);
 
+    // Variants of AllocApiObject()/FreeApiObject() which serve objects created without application allocation
+    // callbacks from the device's API object pool.  Memory must be freed by the same variant it was allocated with.
+    void* AllocPooledApiObject(
+        const VkAllocationCallbacks*    pAllocator,
+        const size_t                    totalObjectSize);
+
+    void FreePooledApiObject(
+        const VkAllocationCallbacks*    pAllocator,
+        void*                           pMemory);
+
     void FreeUnreservedPrivateData(
         void*                           pMemory) const;
 
-    VK_INLINE Util::RWLock* GetPrivateDataRWLock()
-    {
-        return &m_privateDataRWLock;
-    }
-
     VkResult SetDebugUtilsObjectName(const VkDebugUtilsObjectNameInfoEXT* pNameInfo);
 
     uint32_t GetBorderColorIndex(
@@ -720,9 +872,19 @@ protected:
 
     VkResult CreateBltMsaaStates();
     void DestroyInternalPipelines();
+
+    static void TeardownTask(void* pPayload, uint32_t taskIndex);
+    void TeardownCaches();
     void InitSamplePatternPalette(Pal::SamplePatternPalette* pPalette) const;
 
     VkResult InitSwCompositing(uint32_t deviceIdx);
+    void DestroySwCompositing(uint32_t deviceIdx);
+
+    VkResult GetPalCalibratedTimestamps(
+        uint32_t                            timestampCount,
+        const VkCalibratedTimestampInfoEXT* pTimestampInfos,
+        uint64_t*                           pTimestamps,
+        uint64_t*                           pMaxDeviation);
 
     VkResult AllocBorderColorPalette();
 
@@ -749,6 +911,9 @@ protected:
 
     InternalPipeline                    m_internalRayTracingPipeline;
 
+    std::atomic<bool>                   m_internalPipelinesReady;  // Set once CreateInternalPipelines() succeeded
+    Util::Mutex                         m_internalPipelineLock;    // Serializes deferred internal pipeline creation
+
     static const uint32_t BltMsaaStateCount = 4;
 
     Pal::IMsaaState*                    m_pBltMsaaState[BltMsaaStateCount][MaxPalDevices];
@@ -759,11 +924,22 @@ protected:
     DispatchTable                       m_dispatchTable;           // Device dispatch table
     SqttMgr*                            m_pSqttMgr;                // Manager for developer mode SQ thread tracing
     AsyncLayer*                         m_pAsyncLayer;             // State for async compiler layer, otherwise null
+    CompileThreadPool*                  m_pCompileThreadPool;      // Workers for batched pipeline creates, otherwise
+                                                                   // null
+    GpuTimingTable*                     m_pGpuTimingTable;         // GPU time per command buffer and debug label, if
+                                                                   // enabled
+    PipelineStatsProfile*               m_pPipelineStatsProfile;   // Pipeline statistics per pipeline, if enabled
+    BarrierProfile*                     m_pBarrierProfile;         // GPU stall time per barrier call site, if enabled
     OptLayer*                           m_pAppOptLayer;            // State for an app-specific layer, otherwise null
     BarrierFilterLayer*                 m_pBarrierFilterLayer;     // State for enabling barrier filtering, otherwise
                                                                    // null
+    ApiProfileLayer*                    m_pApiProfileLayer;        // Per-entry point call counts and CPU time,
+                                                                   // otherwise null
+    ApiObjectPool*                      m_pApiObjectPool;          // Slabs for frequently created API objects, if
+                                                                   // enabled
 
     Util::Mutex                         m_memoryMutex;             // Shared mutex used occasionally by memory objects
+    Util::Mutex                         m_imageViewSrdCacheLock;   // Protects the view SRD caches of all images
 
     // The states of m_enabledFeatures are provided by application
     DeviceFeatures                      m_enabledFeatures;
@@ -794,13 +970,19 @@ protected:
     {
         PhysicalDevice*           pPhysicalDevice;
         Pal::IDevice*             pPalDevice;
-        Pal::ICmdAllocator*       pSharedPalCmdAllocator;
+        Pal::ICmdAllocator*       pSharedPalCmdAllocators[MaxSharedCmdAllocators]; // [0] is also used internally
 
-        void*                     pSwCompositingMemory;    // Internal memory for the below PAL objects (master and slave)
-        Pal::IQueue*              pSwCompositingQueue;     // Internal present queue (master) or transfer queue (slave)
-        Pal::IQueueSemaphore*     pSwCompositingSemaphore; // Internal semaphore (master and slave)
-        Pal::ICmdBuffer*          pSwCompositingCmdBuffer; // Internal dummy command buffer for flip metadata (master)
-        Pal::IBorderColorPalette* pPalBorderColorPalette;  // Pal border color palette for custom border color.
+        void*                     pSwCompositingMemory;        // Internal memory for the below PAL objects
+
+        // Per SDMA engine; [0] is also the internal present queue (master), the others are only used by slaves
+        Pal::IQueue*              pSwCompositingQueue[MaxSwCompositingEngines];         // Transfer queues
+        Pal::IQueueSemaphore*     pSwCompositingSemaphore[MaxSwCompositingEngines];     // Rendering done, waited by
+                                                                                        // the transfer queue (slave)
+        Pal::IQueueSemaphore*     pSwCompositingDoneSemaphore[MaxSwCompositingEngines]; // Compositing done, waited
+                                                                                        // by the present queue
+        Pal::ICmdBuffer*          pSwCompositingCmdBuffer;     // Internal dummy command buffer for flip metadata
+                                                               // (master)
+        Pal::IBorderColorPalette* pPalBorderColorPalette;      // Pal border color palette for custom border color.
 
     };
 
@@ -815,12 +997,97 @@ protected:
     uint32                              m_privateDataSlotRequestCount;
     volatile uint64                     m_nextPrivateDataSlot;
     size_t                              m_privateDataSize;
-    Util::RWLock                        m_privateDataRWLock;
+
+    // Custom border color palette entries are shared by all samplers using the same color
+    struct BorderColorKey
+    {
+        uint32_t color[4];
+    };
+
+    struct BorderColorSlot
+    {
+        BorderColorKey key;
+        uint32_t       refCount;    // Number of samplers using the entry; 0 if the entry is free
+        uint32_t       nextFree;    // Next free entry while this one is free
+    };
 
     InternalMemory                      m_memoryPalBorderColorPalette;
-    bool*                               m_pBorderColorUsedIndexes;
+    BorderColorSlot*                    m_pBorderColorSlots;
+    uint32_t                            m_borderColorFreeHead;     // First free palette entry
+    CompactParamMap<BorderColorKey, uint32_t> m_borderColorSlotMap; // Color to palette entry of the entries in use
     Util::Mutex                         m_borderColorMutex;
 
+    uint32_t                            m_sharedCmdAllocatorCount; // Number of created shared CmdAllocators per GPU
+    volatile uint32                     m_nextSharedCmdAllocator;  // Round-robin counter for assigning them to pools
+
+    volatile uint64                     m_drawCount;               // Draws recorded by ended command buffers
+    volatile uint64                     m_validatedDrawCount;      // Draws among those which had dirty state
+    volatile uint64                     m_filteredStateCount;      // Redundant vkCmdSet* calls which were skipped
+
+    DescriptorPoolStats                 m_descriptorPoolStats;     // Memory use of all descriptor pools
+
+    MemoryBlockCache                    m_memoryBlockCache;        // PAL memory of recently freed VkDeviceMemory
+
+    ExternalMemoryCache                 m_externalMemoryCache;     // Open imports of external memory handles
+
+    DebugNameTable                      m_debugNameTable;          // Names of objects which keep their debug name
+
+    EventStatusValues                   m_eventStatusValues;       // Host set/reset values of event memory
+
+    utils::TempMemArenaPool             m_tempMemArenaPool;        // Scratch arenas for render pass creation
+
+    MemoryResidencyTracker              m_residencyTracker;        // Demotes idle memory while over budget
+
+    MemoryEventLog                      m_memoryEventLog;          // Timeline of allocations, frees and binds
+
+    PerfCounterRegistry                 m_perfCounters;            // Counters all subsystems report to
+
+    GpuAddressIndex                     m_gpuAddressIndex;         // Buffers and images by bound GPU address
+
+    ImageCreateInfoCache                m_imageCreateInfoCache;    // Converted create infos of recent images
+
+    ShaderModuleCache                   m_shaderModuleCache;       // Code and modules of live shader modules
+
+    LayoutCache                         m_layoutCache;             // Live descriptor set and pipeline layouts
+
+    TransientAliasPlanner               m_transientAliasPlanner;   // Shares memory between transient attachments
+
+    ImageLayoutTracker                  m_imageLayoutTracker;      // Layouts submissions left dedicated images in
+
+    PipelineAutotuner                   m_pipelineAutotuner;       // Wave size and NGG culling trials of hot pipelines
+
+    PipelineCompileEventLog             m_pipelineCompileEventLog; // Record of every created pipeline
+
+    QueueTimingLog                      m_queueTimingLog;          // Binary record of every queue operation
+
+    TimestampCalibrator                 m_timestampCalibrator;     // Answers calibrated timestamp requests
+
+    // Residency adds from AddDeferredMemReference() which haven't been handed to PAL yet
+    struct PendingMemReference
+    {
+        Pal::IDevice*    pPalDevice;
+        Pal::IGpuMemory* pPalMemory;
+    };
+
+    static constexpr uint32_t MaxPendingMemReferences = 256;
+
+    Util::Mutex                         m_pendingMemRefLock;       // Protects the pending reference list
+    PendingMemReference                 m_pendingMemRefs[MaxPendingMemReferences];
+    volatile uint32                     m_pendingMemRefCount;
+
+    Pal::Result FlushMemReferencesLocked();
+
+    // Destroyed fences which still own their PAL fences, for reuse by later unsignaled vkCreateFence calls.  The first
+    // m_cleanFenceCount entries have already been reset; the rest are reset in one batch when they are needed.
+    static constexpr uint32_t MaxPooledFences = 64;
+
+    Util::Mutex                         m_fencePoolLock;
+    Fence*                              m_pPooledFences[MaxPooledFences];
+    uint32_t                            m_pooledFenceCount;
+    uint32_t                            m_cleanFenceCount;
+
+    void DestroyPooledFences();
+
     // This goes last.  The memory for the rest of the array is calculated dynamically based on the number of GPUs in
     // use.
     PerGpuInfo              m_perGpu[1];
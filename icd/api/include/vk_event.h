@@ -38,6 +38,8 @@
 #include "include/vk_dispatch.h"
 #include "include/internal_mem_mgr.h"
 
+#include <atomic>
+
 namespace Pal
 {
 
@@ -51,6 +53,23 @@ namespace vk
 class Device;
 class DispatchableEvent;
 
+// Values PAL writes to the memory of an event on a host set and reset, learned from the first host-visible event of a
+// device so that vkGetEventStatus can read the memory directly
+struct EventStatusValues
+{
+    enum State : uint32_t
+    {
+        Unknown = 0,  // No event probed yet
+        Probing,      // An event is being probed
+        Valid,        // setValue and resetValue can be used
+        Invalid       // Event memory doesn't hold a single status value; always ask PAL
+    };
+
+    std::atomic<uint32_t> state;
+    uint32_t              setValue;     // Written before state becomes Valid
+    uint32_t              resetValue;
+};
+
 class Event final : public NonDispatchable<VkEvent, Event>
 {
 public:
@@ -105,6 +124,12 @@ private:
         uint32_t           numDeviceEvents,
         VkEventCreateFlags flags);
 
+    void InitHostStatus(
+        Device*      pDevice,
+        Pal::gpusize memSize);
+
+    bool ReadHostStatus(VkResult* pStatus) const;
+
     union
     {
         Pal::IGpuEvent*    m_pPalEvents[MaxPalDevices];
@@ -113,6 +138,10 @@ private:
 
     InternalMemory         m_internalGpuMem;
 
+    const volatile uint32_t*  m_pHostStatus;       // CPU address of the event memory, or nullptr if it isn't read
+    uint32_t                  m_hostStatusDwords;  // Dwords of event memory
+    const EventStatusValues*  m_pStatusValues;     // Status values of the device
+
     // This flag is used to decide which path to use when setting and waiting event with CmdRelease/CmdAcquire.
     // if the flag is true, we will use sync tokens. Well, if the flag is false, we will use iGpuEvents.
     bool                   m_useToken;
@@ -241,6 +241,7 @@ public:
         KHR_DEVICE_GROUP,
         KHR_DRAW_INDIRECT_COUNT,
         KHR_DRIVER_PROPERTIES,
+        KHR_DYNAMIC_RENDERING,
         KHR_EXTERNAL_FENCE,
         KHR_EXTERNAL_FENCE_FD,
         KHR_EXTERNAL_FENCE_WIN32,
@@ -38,6 +38,8 @@
 #include "include/vk_dispatch.h"
 #include "include/vk_defines.h"
 
+#include <atomic>
+
 namespace Pal
 {
 
@@ -49,6 +51,7 @@ namespace vk
 {
 
 class Device;
+class QueueSubmitThread;
 
 class Fence final : public NonDispatchable<VkFence, Fence>
 {
@@ -94,6 +97,23 @@ public:
         return m_flags.isPermanence ? m_pPalFences[idx] : m_pPalTemporaryFences;
     }
 
+    // Records the deferred queue submission which signals this fence
+    VK_INLINE void SetPendingSubmission(QueueSubmitThread* pSubmitThread, uint64_t sequence)
+        { m_pSubmitThread = pSubmitThread; m_submitSequence = sequence; }
+
+    VK_INLINE void ClearPendingSubmission()
+        { m_pSubmitThread = nullptr; }
+
+    VkResult WaitForPendingSubmission() const;
+
+    // Set once the fence has been observed signaled; it then stays signaled until it is reset, a payload is imported or
+    // a sync fd is exported
+    VK_INLINE bool IsKnownSignaled() const
+        { return m_knownSignaled.load(std::memory_order_acquire); }
+
+    VK_INLINE void SetKnownSignaled(bool knownSignaled)
+        { m_knownSignaled.store(knownSignaled, std::memory_order_release); }
+
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(Fence);
 
@@ -103,7 +123,10 @@ private:
     :
     m_activeDeviceMask(0),
     m_groupedFenceCount(numGroupedFences),
-    m_pPalTemporaryFences(nullptr)
+    m_pPalTemporaryFences(nullptr),
+    m_pSubmitThread(nullptr),
+    m_submitSequence(0),
+    m_knownSignaled(false)
     {
         memcpy(m_pPalFences, pPalFences, sizeof(pPalFences[0]) * numGroupedFences);
         m_flags.value          = 0;
@@ -116,6 +139,10 @@ private:
     Pal::IFence* m_pPalFences[MaxPalDevices];
     Pal::IFence* m_pPalTemporaryFences;
 
+    QueueSubmitThread* m_pSubmitThread;   // Submit thread of the last deferred submission signaling this fence
+    uint64_t           m_submitSequence;  // Sequence number of that submission
+    std::atomic<bool>  m_knownSignaled;   // A status query or wait has returned success since the last reset
+
     union
     {
         struct
@@ -124,7 +151,8 @@ private:
             uint32_t isOpened       : 1;
             uint32_t isReference    : 1;
             uint32_t canBeInherited : 1;
-            uint32_t reserved       : 28;
+            uint32_t isExportable   : 1;
+            uint32_t reserved       : 27;
         };
         uint32_t value;
     } m_flags;
@@ -33,11 +33,15 @@
 
 #include "palVector.h"
 
+#include <atomic>
+
 namespace vk
 {
 
+class Device;
 class Image;
 class ImageView;
+class RenderPass;
 
 // =====================================================================================================================
 // Implementation of a Vulkan framebuffer (VkFramebuffer)
@@ -95,6 +99,26 @@ public:
         return m_globalScissorParams;
     }
 
+    const Pal::ImageLayout* GetBeginLayouts(
+        uint64_t                        renderPassHash,
+        uint32_t                        queueFamilyIndex) const;
+
+    void CacheBeginLayouts(
+        Device*                         pDevice,
+        uint64_t                        renderPassHash,
+        uint32_t                        queueFamilyIndex,
+        const Pal::ImageLayout*         pLayouts);
+
+    bool IsImageless() const { return m_imageless; }
+
+    VkResult PlanTransientAliasing(
+        Device*                         pDevice,
+        const RenderPass*               pRenderPass);
+
+    // Hash of the render pass the attachments' shared memory was last planned for, or 0 if none of them shares memory
+    uint64_t GetTransientAliasPlanHash() const
+        { return m_transientAliasPlanHash.load(std::memory_order_relaxed); }
+
 protected:
     Framebuffer(const VkFramebufferCreateInfo& info, Attachment* pAttachments, const RuntimeSettings& runTimeSettings);
 
@@ -117,9 +141,20 @@ private:
         return Util::Pow2Align(sizeof(Framebuffer), alignof(Attachment));
     }
 
+    // PAL layouts of all attachment planes at the start of a render pass instance, resolved for the render pass and
+    // queue family they were built for.  The layouts ([attachment][plane]) immediately follow this header.
+    struct BeginLayouts
+    {
+        uint64_t renderPassHash;
+        uint32_t queueFamilyIndex;
+    };
+
     const uint32_t            m_attachmentCount;
     Pal::GlobalScissorParams  m_globalScissorParams;
     const RuntimeSettings&    m_settings;
+    const bool                m_imageless;        // Attachments are only provided at render pass begin time
+    std::atomic<BeginLayouts*> m_pBeginLayouts;   // Layouts of the first render pass begun with this framebuffer
+    std::atomic<uint64_t>      m_transientAliasPlanHash; // See GetTransientAliasPlanHash()
 };
 
 namespace entry
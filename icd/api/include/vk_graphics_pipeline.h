@@ -48,6 +48,7 @@ class Device;
 class PipelineCache;
 class CmdBuffer;
 struct CmdBufferRenderState;
+struct StaticStateBundleKey;
 
 // Sample pattern structure containing pal format sample locations and sample counts
 // ToDo: Move this struct to different header once render_graph implementation is removed.
@@ -70,6 +71,21 @@ struct VbBindingInfo
     } bindings[Pal::MaxVertexBuffers];
 };
 
+// Upper bound of vertex attributes of a pipeline (VkPhysicalDeviceLimits::maxVertexInputAttributes)
+constexpr uint32_t MaxVertexAttributes = 64;
+
+// Vertex input state in canonical form: bindings no attribute reads and divisors of 1 are dropped, and bindings,
+// divisors and attributes are sorted by binding or location.  Vertex input states with the same vertex fetches have
+// the same canonical form.
+struct NormalizedVertexInput
+{
+    VkPipelineVertexInputStateCreateInfo           state;
+    VkPipelineVertexInputDivisorStateCreateInfoEXT divisorState;
+    VkVertexInputBindingDescription                bindings[Pal::MaxVertexBuffers];
+    VkVertexInputAttributeDescription              attributes[MaxVertexAttributes];
+    VkVertexInputBindingDivisorDescriptionEXT      divisors[Pal::MaxVertexBuffers];
+};
+
 // =====================================================================================================================
 // Convert sample location coordinates from [0,1] space (sent by the application) to [-8, 7] space (accepted by PAL)
 static void ConvertCoordinates(
@@ -177,6 +193,12 @@ public:
         const VkAllocationCallbacks*            pAllocator,
         VkPipeline*                             pPipeline);
 
+    static void PrefetchBinaries(
+        Device*                                 pDevice,
+        PipelineCache*                          pPipelineCache,
+        uint32_t                                count,
+        const VkGraphicsPipelineCreateInfo*     pCreateInfos);
+
     VkResult Destroy(
         Device*                         pDevice,
         const VkAllocationCallbacks*    pAllocator) override;
@@ -203,6 +225,19 @@ public:
 
     static void BindNullPipeline(CmdBuffer* pCmdBuffer);
 
+    static bool IsVertexInputStateNormalized(
+        const VkPipelineVertexInputStateCreateInfo& desc);
+
+    static const VkPipelineVertexInputStateCreateInfo* NormalizeVertexInputState(
+        const VkPipelineVertexInputStateCreateInfo& desc,
+        NormalizedVertexInput*                      pNormalized);
+
+    static const VkPipelineRenderingCreateInfoKHR* GetRenderingCreateInfo(
+        const VkGraphicsPipelineCreateInfo* pCreateInfo);
+
+    static VkFormat GetRenderingDepthStencilFormat(
+        const VkPipelineRenderingCreateInfoKHR& renderingInfo);
+
     // Returns value of VK_PIPELINE_CREATE_VIEW_INDEX_FROM_DEVICE_INDEX_BIT
     // defined by flags member of VkGraphicsPipelineCreateInfo.
     bool ViewIndexFromDeviceIndex() const
@@ -245,6 +280,7 @@ protected:
             uint32_t scissorRect;
             uint32_t samplePattern;
             uint32_t fragmentShadingRate;
+            uint32_t staticStateBundle;
         } staticTokens;
     };
 
@@ -270,8 +306,11 @@ protected:
         uint64_t                               apiHash,
         Util::MetroHash64*                     pPalPipelineHasher);
 
+    bool CanUsePalPipelinesOf(const Pipeline* pSource) const override;
+
     void CreateStaticState();
     void DestroyStaticState(const VkAllocationCallbacks* pAllocator);
+    void BuildStaticStateBundleKey(StaticStateBundleKey* pKey) const;
 
     ~GraphicsPipeline();
 
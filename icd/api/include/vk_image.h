@@ -43,6 +43,7 @@
 #include "include/vk_cmdbuffer.h"
 
 #include "include/barrier_policy.h"
+#include "include/image_layout_tracker.h"
 
 #include "palCmdBuffer.h"
 #include "palQueue.h"
@@ -66,6 +67,17 @@ class PeerImages;
 struct RPImageLayout;
 class SwapChain;
 struct ResourceOptimizerKey;
+struct ConvertedImageCreateInfo;
+
+// Image view parameters which fully determine the shader SRDs built for a view of a given image
+struct ImageViewSrdKey
+{
+    VkFormat                format;
+    VkImageViewType         viewType;
+    VkComponentMapping      components;
+    VkImageSubresourceRange subresourceRange;
+    VkImageUsageFlags       usage;
+};
 
 class Image final : public NonDispatchable<VkImage, Image>
 {
@@ -199,12 +211,32 @@ public:
 
     bool DedicatedMemoryRequired() const { return m_internalFlags.dedicatedRequired; }
 
+    bool IsTransientAliasBound() const { return m_internalFlags.transientAliasBound; }
+
+    // True if the device's ImageLayoutTracker tracks the layouts of this image
+    bool IsLayoutTracked() const { return m_internalFlags.layoutTracked; }
+
+    // Only accessed under the lock of the device's ImageLayoutTracker
+    CommittedImageLayouts* GetCommittedLayouts() const { return &m_committedLayouts; }
+
     VK_FORCEINLINE const ImageBarrierPolicy& GetBarrierPolicy() const
         { return m_barrierPolicy; }
 
     VK_FORCEINLINE const ResourceOptimizerKey& GetResourceKey() const
         { return m_ResourceKey; }
 
+    bool FindViewSrds(
+        Device*                pDevice,
+        const ImageViewSrdKey& key,
+        size_t                 size,
+        void*                  pSrds) const;
+
+    void AddViewSrds(
+        Device*                pDevice,
+        const ImageViewSrdKey& key,
+        size_t                 size,
+        const void*            pSrds) const;
+
     // Returns true if the image has a color format.
     VK_FORCEINLINE bool IsColorFormat() const
         { return m_internalFlags.isColorFormat == 1; }
@@ -262,7 +294,10 @@ private:
             uint32_t sampleLocsCompatDepth  : 1;  // VK_IMAGE_CREATE_SAMPLE_LOCATIONS_COMPATIBLE_DEPTH_BIT_EXT
             uint32_t linear                 : 1;  // True if the image has VK_IMAGE_TILING_LINEAR
             uint32_t isProtected            : 1;  // VK_IMAGE_CREATE_PROTECTED_BIT
-            uint32_t reserved               : 13;
+            uint32_t memReqsCached          : 1;  // m_memoryRequirements holds the memory requirements
+            uint32_t transientAliasBound    : 1;  // Bound to memory whose pages transient attachments may share
+            uint32_t layoutTracked          : 1;  // Bound to memory the device's ImageLayoutTracker tracks it in
+            uint32_t reserved               : 10;
         };
         uint32_t     u32All;
     };
@@ -309,6 +344,24 @@ private:
 
     void CalcMemoryPriority(const Device* pDevice);
 
+    static VkResult CreateFromConvertedInfo(
+        Device*                         pDevice,
+        const VkImageCreateInfo*        pCreateInfo,
+        const VkAllocationCallbacks*    pAllocator,
+        ConvertedImageCreateInfo*       pInfo,
+        VkImage*                        pImage);
+
+    void CalcMemoryRequirements(
+        const Device*         pDevice,
+        VkMemoryRequirements* pMemoryRequirements) const;
+
+    void SetMemoryRequirements(
+        const VkMemoryRequirements& memoryRequirements)
+    {
+        m_memoryRequirements          = memoryRequirements;
+        m_internalFlags.memReqsCached = 1;
+    }
+
     // This function is used to register presentable images with swap chains
     VK_FORCEINLINE void RegisterPresentableImageWithSwapChain(SwapChain* pSwapChain)
     {
@@ -361,6 +414,25 @@ private:
 
     ResourceOptimizerKey    m_ResourceKey;
 
+    VkMemoryRequirements    m_memoryRequirements; // Memory requirements shared with images of the same description,
+                                                  // valid if m_internalFlags.memReqsCached is set
+
+    // Shader SRDs built for views of this image, followed in memory by the SRD data
+    struct ViewSrdCacheEntry
+    {
+        ViewSrdCacheEntry* pNext;
+        ImageViewSrdKey    key;
+        size_t             size;
+    };
+
+    static constexpr uint32_t MaxViewSrdCacheEntries = 8;
+
+    mutable ViewSrdCacheEntry* m_pViewSrdCache;      // Views with identical parameters copy these instead of asking
+                                                     // PAL to build the SRDs again
+    mutable uint32_t           m_viewSrdCacheCount;
+
+    mutable CommittedImageLayouts m_committedLayouts;  // Layouts submitted command buffers left the image in
+
     // This goes last.  The memory for the rest of the array is calculated dynamically based on the number of GPUs in
     // use.
     PerGpuInfo              m_perGpu[1];
@@ -36,6 +36,7 @@
 
 #include "include/khronos/vulkan.h"
 #include "include/app_profile.h"
+#include "include/async_log.h"
 #include "include/vk_alloccb.h"
 #include "include/vk_dispatch.h"
 #include "include/vk_utils.h"
@@ -143,6 +144,11 @@ public:
     VK_INLINE VkAllocationCallbacks* GetAllocCallbacks()
         { return &m_allocCallbacks; }
 
+    // Returns true if the instance allocates system memory through the driver's own callbacks rather than the
+    // application's.  Only then may the instance callbacks be called from threads other than the calling one.
+    VK_INLINE bool UsesDriverAllocCallbacks() const
+        { return allocator::IsDriverAllocCallbacks(&m_allocCallbacks); }
+
     VK_FORCEINLINE Pal::IPlatform* PalPlatform() const
         { return m_pPalPlatform; }
 
@@ -225,6 +231,12 @@ public:
         VulkanSettingsLoader* settingsLoaders[],
         AppProfile*           pAppProfiles);
 
+    void GetAppProfileSettings(
+        uint32_t         appGpuID,
+        ProfileSettings* pProfileSettings);
+
+    void InvalidateAppProfileSettings();
+
     VkResult RegisterDebugCallback(
         DebugReportCallback* pCallback);
 
@@ -251,6 +263,10 @@ public:
     void UnregisterDebugUtilsMessenger(
         DebugUtilsMessenger* pMessenger);
 
+    // Tells whether any VK_EXT_debug_utils messenger is registered.  Unsynchronized, so only a hint.
+    bool HasDebugUtilsMessengers() const
+        { return (m_debugUtilsMessengers.NumElements() > 0); }
+
     void CallExternalMessengers(
         VkDebugUtilsMessageSeverityFlagBitsEXT      messageSeverity,
         VkDebugUtilsMessageTypeFlagsEXT             messageTypes,
@@ -276,6 +292,9 @@ private:
     void DevModeEarlyInitialize();
     void DevModeLateInitialize();
 
+    VkResult InitPhysicalDevices();
+    VkResult EnsurePhysicalDevices();
+
     static void PAL_STDCALL PalDeveloperCallback(
         void*                        pPrivateData,
         const Pal::uint32            deviceIndex,
@@ -312,7 +331,9 @@ private:
             uint32_t sqttSupport        : 1;  // True if SQTT thread trace annotation markers are enabled
             uint32_t nullGpuMode        : 1;  // True if the instance is running in null gpu mode (fake gpus for shader
                                               // compilation
-            uint32_t reserved           : 30;
+            uint32_t lazyDeviceInit     : 1;  // True if physical devices, their settings and the app profile are
+                                              // initialized on first use rather than at instance creation
+            uint32_t reserved           : 29;
         };
         uint32_t u32All;
     } m_flags;
@@ -340,6 +361,24 @@ private:
 
     static const size_t APP_INFO_MAX_CHARS = 256;
     char m_applicationName[APP_INFO_MAX_CHARS];
+    char m_engineName[APP_INFO_MAX_CHARS];    // Only kept for the deferred app profile scan of lazy initialization
+
+    Util::Mutex     m_physicalDeviceInitLock;   // Serializes lazy physical device initialization
+    uint64_t        m_instanceInitUs;           // Time spent in Init() before physical device initialization
+
+    // App profile settings resolved by ReloadAppProfileSettings(), reused until the profile sources change
+    struct AppProfileSettingsEntry
+    {
+        uint32_t        appGpuID;
+        ProfileSettings defaults;   // Values before the profile was applied
+        ProfileSettings resolved;
+    };
+
+    static constexpr uint32_t MaxAppProfileSettingsEntries = 8;
+
+    AppProfileSettingsEntry m_appProfileSettings[MaxAppProfileSettingsEntries];
+    uint32_t                m_appProfileSettingsCount;
+    Util::Mutex             m_appProfileSettingsLock;
 
     Util::List<DebugReportCallback*, PalAllocator>  m_debugReportCallbacks;             // List of registered Debug
                                                                                         // Report Callbacks
@@ -357,6 +396,7 @@ private:
     static const char* m_extensionsEnv;
 
     uint64_t  m_logTagIdMask;
+    AsyncLog  m_asyncLog;      // Background formatting of AmdvlkLog() messages
 };
 
 // =====================================================================================================================
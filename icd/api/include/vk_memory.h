@@ -38,12 +38,16 @@
 #include "include/vk_defines.h"
 #include "include/vk_dispatch.h"
 #include "include/vk_utils.h"
+#include "include/memory_block_cache.h"
+#include "include/memory_event_log.h"
 #include "palGpuMemory.h"
 
 namespace vk
 {
 class Device;
 class Image;
+class InternalMemory;
+struct ExternalMemoryImport;
 };
 
 namespace vk
@@ -146,6 +150,35 @@ public:
         return m_pExternalPalImage;
     }
 
+    // Offset of this memory within PalMemory().  Only non-zero if the memory is sub-allocated, which is why every
+    // bind offset has to be relative to it.
+    VK_INLINE Pal::gpusize Offset() const
+    {
+        return m_offset;
+    }
+
+    VK_INLINE bool IsSubAllocated() const
+    {
+        return (m_pSubAllocation != nullptr);
+    }
+
+    // True if the physical pages behind PalMemory() may be shared with other transient attachments
+    VK_INLINE bool IsTransientAlias() const
+    {
+        return m_flags.transientAlias;
+    }
+
+    // True if the memory was allocated for a single image and nothing outside the device can access it
+    VK_INLINE bool IsPrivateDedicatedImage() const
+    {
+        return m_flags.dedicatedImage;
+    }
+
+    // Tells the residency tracker that the memory is in use, e.g. mapped or bound
+    void MarkUsed();
+
+    void RecordBind(MemoryEventType type, const void* pResource, Pal::gpusize size, Pal::gpusize offset);
+
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(Memory);
 
@@ -160,6 +193,8 @@ private:
     // Image needs to be a friend class to be able to create wrapper API memory objects
     friend class Image;
 
+    friend class MemoryResidencyTracker;
+
     // Marks that the logical device's allocation count is incremented and needs to be decremented during the
     // destruction of this memory object.
     VK_INLINE void SetAllocationCounted(uint32_t sizeAccountedForDeviceMask)
@@ -199,12 +234,41 @@ private:
         void*                           pPinnedHostPtr,
         Memory**                        ppMemory);
 
+    static VkResult CreateCacheableGpuMemory(
+        Device*                         pDevice,
+        const VkAllocationCallbacks*    pAllocator,
+        const Pal::GpuMemoryCreateInfo& createInfo,
+        Memory**                        ppMemory);
+
+    void ReleaseCacheableBlock(Pal::IGpuMemory* pGpuMemory);
+
+    void SetDemoted(bool demoted);
+
+    static VkResult CreateTransientAliasMemory(
+        Device*                         pDevice,
+        const VkAllocationCallbacks*    pAllocator,
+        const Pal::GpuMemoryCreateInfo& createInfo,
+        Memory**                        ppMemory);
+
+    static VkResult CreateSubAllocatedMemory(
+        Device*                         pDevice,
+        const VkAllocationCallbacks*    pAllocator,
+        const Pal::GpuMemoryCreateInfo& createInfo,
+        bool                            hostVisible,
+        Memory**                        ppMemory);
+
     static VkResult OpenExternalSharedImage(
         Device*                 pDevice,
         Image*                  pBoundImage,
         const ImportMemoryInfo& importInfo,
         Memory**                ppVkMemory);
 
+    static VkResult OpenCachedImport(
+        Device*                 pDevice,
+        const ImportMemoryInfo& importInfo,
+        ExternalMemoryImport*   pImport,
+        Memory**                ppMemory);
+
     Device*               m_pDevice;
     Pal::IGpuMemory*      m_pPalMemory[MaxPalDevices][MaxPalDevices];
     Pal::IImage*          m_pExternalPalImage;
@@ -213,10 +277,17 @@ private:
     Pal::OsExternalHandle m_sharedGpuMemoryHandle;
 
     Pal::gpusize          m_size;
+    Pal::gpusize          m_offset;         // Offset within m_pPalMemory (non-zero only if sub-allocated)
+    InternalMemory*       m_pSubAllocation; // Range of a driver-owned block this memory lives in, if sub-allocated
+    ExternalMemoryImport* m_pImport;        // Import of the device's external memory cache owning the PAL objects
     Pal::GpuHeap          m_heap0;
     MemoryPriority        m_priority;
     uint32_t              m_sizeAccountedForDeviceMask;
     uint32_t              m_primaryDeviceIndex;
+    MemoryBlockKey        m_cacheKey;       // Key of the PAL memory in the device's block cache, if cacheable
+    Memory*               m_pResidencyPrev; // Neighbors in the residency tracker's list, if tracked
+    Memory*               m_pResidencyNext;
+    volatile uint32_t     m_lastUseEpoch;   // Last residency tracker epoch the memory was used in
 
     union
     {
@@ -226,7 +297,13 @@ private:
             uint32_t multiInstance     :  1;
             uint32_t allocationCounted :  1;
             uint32_t reserved1         :  1;
-            uint32_t reserved          : 28;
+            uint32_t blockCacheable    :  1; // PAL memory has its own system memory and may go to the block cache
+            uint32_t mapped            :  1; // PAL memory is currently mapped through Map()
+            uint32_t residencyTracked  :  1; // Memory is on the residency tracker's list
+            uint32_t residencyDemoted  :  1; // PAL memory priority is lowered by the residency tracker
+            uint32_t transientAlias    :  1; // PAL memory is a virtual range backed by the transient alias planner
+            uint32_t dedicatedImage    :  1; // Dedicated to one image and neither imported nor exported
+            uint32_t reserved          : 22;
         };
 
         uint32_t u32All;
@@ -70,6 +70,7 @@ namespace vk
 // Forward declare Vulkan classes used in this file.
 class DispatchablePhysicalDevice;
 class Surface;
+struct FormatCacheFileHeader;
 
 // =====================================================================================================================
 // Relevant window system information decoded from a VkSurfaceKHR
@@ -133,6 +134,14 @@ public:
 
     void PopulateQueueFamilies();
     void PopulateFormatProperties();
+    void ComputeFormatProperties(const Pal::MergedFormatPropertiesTable& fmtProperties);
+    bool LoadCachedFormatProperties(const FormatFeatureKey& key);
+    void StoreCachedFormatProperties(const FormatFeatureKey& key) const;
+    bool GetFormatCacheFileHeader(
+        const FormatFeatureKey& key,
+        FormatCacheFileHeader*  pHeader,
+        char*                   pPath,
+        size_t                  pathSize) const;
 
     VK_INLINE uint32_t GetMemoryTypeMask() const
     {
@@ -252,7 +261,7 @@ public:
     {
         uint32_t formatIndex = Formats::GetIndex(format);
 
-        *pFormatProperties = m_formatFeaturesTable[formatIndex];
+        *pFormatProperties = m_formatFeatures.formatFeatures[formatIndex];
 
         return VK_SUCCESS;
     }
@@ -261,7 +270,7 @@ public:
     {
         uint32_t formatIndex = Formats::GetIndex(format);
 
-        return Util::WideBitfieldIsSet(m_formatFeatureMsaaTarget, formatIndex);
+        return Util::WideBitfieldIsSet(m_formatFeatures.msaaTarget, formatIndex);
     }
 
     VK_INLINE void GetPhysicalDeviceIDProperties(
@@ -723,10 +732,7 @@ protected:
     VulkanSettingsLoader*            m_pSettingsLoader;
     VkPhysicalDeviceLimits           m_limits;
     VkSampleCountFlags               m_sampleLocationSampleCounts;
-    VkFormatProperties               m_formatFeaturesTable[VK_SUPPORTED_FORMAT_COUNT];
-    uint32_t                         m_formatFeatureMsaaTarget[Util::RoundUpQuotient(
-                                                                    static_cast<uint32_t>(VK_SUPPORTED_FORMAT_COUNT),
-                                                                    static_cast<uint32_t>(sizeof(uint32_t) << 3))];
+    FormatFeatureTable               m_formatFeatures;
     uint32_t                         m_vrHighPrioritySubEngineIndex;
     uint32_t                         m_RtCuHighComputeSubEngineIndex;
     uint32_t                         m_queueFamilyCount;
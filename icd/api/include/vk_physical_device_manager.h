@@ -35,6 +35,7 @@
 #pragma once
 
 #include "include/khronos/vulkan.h"
+#include "include/vk_formats.h"
 #include "include/vk_instance.h"
 #include "include/vk_utils.h"
 #include "include/vk_alloccb.h"
@@ -51,6 +52,22 @@ namespace vk
 class Instance;
 class PhysicalDevice;
 
+// Vulkan format support of a physical device, derived from its PAL format properties table.
+struct FormatFeatureTable
+{
+    VkFormatProperties formatFeatures[VK_SUPPORTED_FORMAT_COUNT];
+    uint32_t           msaaTarget[Util::RoundUpQuotient(static_cast<uint32_t>(VK_SUPPORTED_FORMAT_COUNT),
+                                                        static_cast<uint32_t>(sizeof(uint32_t) << 3))];
+};
+
+// Everything a FormatFeatureTable is computed from.  Physical devices with equal keys have identical format support.
+struct FormatFeatureKey
+{
+    Pal::AsicRevision                revision;
+    uint32_t                         extensionMask;     // Format-related device extensions which are supported
+    Pal::MergedFormatPropertiesTable palFormatProperties;
+};
+
 class PhysicalDeviceManager
 {
 public:
@@ -90,6 +107,14 @@ public:
         uint32_t*                       pPhysicalDeviceCount,
         VkPhysicalDeviceProperties**    ppPhysicalDeviceProperties);
 
+    bool FindFormatFeatureTable(
+        const FormatFeatureKey& key,
+        FormatFeatureTable*     pTable);
+
+    void AddFormatFeatureTable(
+        const FormatFeatureKey&   key,
+        const FormatFeatureTable& table);
+
 protected:
     PhysicalDeviceManager(
         Instance*       pInstance,
@@ -98,6 +123,13 @@ protected:
     VkResult Initialize();
     VkResult UpdateLockedPhysicalDeviceList(void);
     void     DestroyLockedPhysicalDeviceList(void);
+    void     CreateLockedPhysicalDevices(
+        uint32_t              palDeviceCount,
+        Pal::IDevice**        ppPalDevices,
+        VulkanSettingsLoader* pSettingsLoaders[],
+        const AppProfile*     pAppProfiles,
+        VkPhysicalDevice*     pDevices,
+        VkResult*             pResults);
 
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(PhysicalDeviceManager);
@@ -111,6 +143,16 @@ private:
     Util::Mutex                 m_devicesLock; // Mutex used to lock access to the vector of physical devices
 
     VkPhysicalDeviceProperties* m_pAllNullProperties; // Physical device properties exposed when NULL_GPU=ALL
+
+    struct FormatFeatureCacheEntry
+    {
+        FormatFeatureKey   key;
+        FormatFeatureTable table;
+    };
+
+    FormatFeatureCacheEntry*    m_pFormatFeatureCache[MaxPhysicalDevices]; // Format support shared between devices
+    uint32_t                    m_formatFeatureCacheCount;
+    Util::Mutex                 m_formatFeatureCacheLock;
 };
 
 }
@@ -37,6 +37,8 @@
 #include "palFile.h"
 #include "palPipelineAbi.h"
 
+#include <atomic>
+
 namespace Pal
 {
 
@@ -95,6 +97,15 @@ struct PipelineBinaryInfo
     void*  pBinary;
 };
 
+// The PAL pipelines of a pipeline object along with the data describing them.  A pipeline's own set is never modified
+// after the pipeline is created, so a set can be handed to another pipeline object by pointer.
+struct PalPipelineSet
+{
+    Pal::IPipeline*     pPalPipeline[MaxPalDevices];
+    uint64_t            palPipelineHash;    // Unique hash for Pal::Pipeline
+    PipelineBinaryInfo* pBinary;
+};
+
 enum class DynamicStatesInternal : uint32_t
 {
     Viewport = 0,
@@ -141,28 +152,33 @@ public:
         return reinterpret_cast<Pipeline*>(pipeline);
     }
 
+    // Returns the PAL pipelines currently used by this pipeline.  Callers which read more than one field should load the
+    // set once, since UsePalPipelinesOf() may replace it concurrently.
+    VK_INLINE const PalPipelineSet* GetPalPipelines() const
+        { return m_pPalPipelines.load(std::memory_order_acquire); }
+
     const Pal::IPipeline* PalPipeline(int32_t idx) const
     {
         VK_ASSERT((idx >= 0) && (idx < static_cast<int32_t>(MaxPalDevices)));
-        return m_pPalPipeline[idx];
+        return GetPalPipelines()->pPalPipeline[idx];
     }
 
     Pal::IPipeline* PalPipeline(int32_t idx)
     {
         VK_ASSERT((idx >= 0) && (idx < static_cast<int32_t>(MaxPalDevices)));
-        return m_pPalPipeline[idx];
+        return GetPalPipelines()->pPalPipeline[idx];
     }
 
     VK_INLINE uint64_t PalPipelineHash() const
     {
-        return m_palPipelineHash;
+        return GetPalPipelines()->palPipelineHash;
     }
 
     VK_INLINE uint64_t GetApiHash() const
         { return m_apiHash; }
 
     VK_INLINE const PipelineBinaryInfo* GetBinary() const
-        { return m_pBinary; }
+        { return GetPalPipelines()->pBinary; }
 
     VK_INLINE VkPipelineBindPoint GetType() const
         { return m_type; }
@@ -176,6 +192,8 @@ public:
     VK_INLINE bool ContainsDynamicState(DynamicStatesInternal dynamicState) const
         { return ((m_staticStateMask & (1UL << static_cast<uint32_t>(dynamicState))) == 0); }
 
+    bool UsePalPipelinesOf(const Pipeline* pSource);
+
     VkResult GetShaderDisassembly(
         const Device*                 pDevice,
         const Pal::IPipeline*         pPalPipeline,
@@ -198,6 +216,8 @@ protected:
         uint32_t              staticStateMask,
         uint64_t              apiHash);
 
+    virtual bool CanUsePalPipelinesOf(const Pipeline* pSource) const;
+
     static void GenerateHashFromSpecializationInfo(
         Util::MetroHash128*         pHasher,
         const VkSpecializationInfo& desc);
@@ -207,13 +227,13 @@ protected:
         const VkPipelineShaderStageCreateInfo& desc);
 
     static void GenerateHashFromDynamicStateCreateInfo(
-        Util::MetroHash128*                     pHasher,
+        Util::MetroHash128*                     pBaseHasher,
+        Util::MetroHash128*                     pApiHasher,
         const VkPipelineDynamicStateCreateInfo& desc);
 
     Device* const                      m_pDevice;
     UserDataLayout                     m_userDataLayout;
-    Pal::IPipeline*                    m_pPalPipeline[MaxPalDevices];
-    uint64_t                           m_palPipelineHash; // Unique hash for Pal::Pipeline
+    PalPipelineSet                     m_palPipelines;    // PAL pipelines owned by this object
     uint32_t                           m_staticStateMask; // Bitfield to detect which subset of pipeline state is
                                                           // static (written at bind-time as opposed to via vkCmd*).
     uint64_t                           m_apiHash;
@@ -222,7 +242,7 @@ protected:
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(Pipeline);
 
-    PipelineBinaryInfo*                m_pBinary;
+    std::atomic<const PalPipelineSet*> m_pPalPipelines;   // PAL pipelines in use; m_palPipelines unless replaced
 };
 
 namespace entry
@@ -175,6 +175,21 @@ protected:
 
     ~PipelineLayout() { }
 
+    void BuildMappingTemplate(
+        Device*                      pDevice,
+        const VkAllocationCallbacks* pAllocator);
+
+    VkResult BuildLlpcUserDataMapping(
+        uint32_t                                    stageMask,
+        void*                                       pBuffer,
+        uint32_t*                                   pUserDataNodeCount,
+        uint32_t*                                   pMappingNodeCount,
+        uint32_t*                                   pDescriptorRangeCount) const;
+
+    void CopyMappingTemplate(
+        uint32_t                                    stageMask,
+        void*                                       pBuffer) const;
+
     VkResult BuildLlpcSetMapping(
         uint32_t                       visibility,
         uint32_t                       setIndex,
@@ -194,6 +209,10 @@ protected:
     static uint64_t BuildApiHash(
         const VkPipelineLayoutCreateInfo* pCreateInfo);
 
+    static void BuildSignature(
+        const VkPipelineLayoutCreateInfo* pCreateInfo,
+        LayoutSignature*                  pSignature);
+
     static Vkgc::ResourceMappingNodeType MapLlpcResourceNodeType(
         VkDescriptorType descriptorType);
 
@@ -212,6 +231,14 @@ protected:
     const Device* const     m_pDevice;
     const uint64_t          m_apiHash;
 
+    // The stage-independent part of the LLPC resource mapping (everything but the VB table), built once at creation
+    // with all stages visible and laid out like the buffer passed to BuildLlpcPipelineMapping().  Null if the layout
+    // has no mapping or the allocation failed, in which case the mapping is built on every call.
+    void*                   m_pMappingTemplate;
+    uint32_t                m_templateUserDataNodeCount;
+    uint32_t                m_templateMappingNodeCount;
+    uint32_t                m_templateDescRangeCount;
+
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(PipelineLayout);
 };
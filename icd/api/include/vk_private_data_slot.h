@@ -43,16 +43,27 @@
 #include "palHashMapImpl.h"
 #include "palUtil.h"
 
+#include <atomic>
+
 using namespace Util;
 
 namespace vk
 {
 
-typedef Util::HashMap<uint64, uint64, PalAllocator> HashedPrivateDataMap;
+constexpr uint32_t PrivateDataChunkSize = 16;
+
+// Values of PrivateDataChunkSize consecutive unreserved private data slots of one object.  Chunks are only ever
+// prepended to the object's list and are freed along with the object, so values never move and need no lock.
+struct PrivateDataChunk
+{
+    PrivateDataChunk*       pNext;
+    uint64                  firstIndex;  // Slot index of values[0]
+    uint64                  values[PrivateDataChunkSize];
+};
 
 struct PrivateDataStorage
 {
-    HashedPrivateDataMap*   pUnreserved;
+    std::atomic<PrivateDataChunk*> pUnreserved;
     // The memory for the array is calculated dynamically based on the device createInfo
     // default count = 1
     uint64                  reserved[1];
@@ -94,7 +105,7 @@ private:
                         const uint64                            index);
 
     template <bool isSet>
-    HashedPrivateDataMap* GetUnreservedPrivateDataAddr(
+    uint64* GetUnreservedPrivateDataAddr(
                         Device*                                 pDevice,
                         PrivateDataStorage* const               pPrivateDataStorage);
 
@@ -264,6 +264,14 @@ public:
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(TimestampQueryPool);
 
+    // Number of polls of a pending timestamp before waiting for it starts yielding the thread
+    static constexpr uint32_t TimestampSpinPollCount = 64;
+
+    void WaitForTimestamps(
+        const void* pSrcData,
+        uint32_t    startQuery,
+        uint32_t    queryCount) const;
+
     TimestampQueryPool(
         Device* pDevice,
         VkQueryType           queryType,
@@ -62,6 +62,9 @@ class  SwapChain;
 class  FrtcFramePacer;
 class  TurboSync;
 class  SqttQueueState;
+class  QueueSubmitThread;
+class  QueueSubmitStats;
+class  QueueTimingState;
 
 // State of a command buffer.
 struct CmdBufState
@@ -95,6 +98,20 @@ public:
         const SubmitInfoType* pSubmits,
         VkFence               fence);
 
+    template<typename SubmitInfoType>
+    VkResult PalSubmit(
+        uint32_t              submitCount,
+        const SubmitInfoType* pSubmits,
+        VkFence               fence);
+
+    void StartSubmitThread();
+
+    void EnableSubmitStats();
+
+    void WriteSubmitStats(const char* pFilePath);
+
+    void EnableTimingLog();
+
     VkResult WaitIdle(void);
     VkResult PalSignalSemaphores(
         uint32_t            semaphoreCount,
@@ -118,6 +135,11 @@ public:
         const VkBindSparseInfo*                     pBindInfo,
         VkFence                                     fence);
 
+    VkResult PalBindSparse(
+        uint32_t                                    bindInfoCount,
+        const VkBindSparseInfo*                     pBindInfo,
+        VkFence                                     fence);
+
     void InsertDebugUtilsLabel(
         const VkDebugUtilsLabelEXT*                 pLabelInfo);
 
@@ -169,6 +191,9 @@ public:
     SqttQueueState* GetSqttState()
         { return m_pSqttState; }
 
+    QueueSubmitThread* GetSubmitThread()
+        { return m_pSubmitThread; }
+
     VkResult SubmitInternalCmdBuf(
         uint32_t                   deviceIdx,
         const Pal::CmdBufInfo&     cmdBufInfo,
@@ -182,6 +207,7 @@ protected:
         uint32_t                      maxRangeCount;
         uint32_t                      rangeCount;
         Pal::VirtualMemoryRemapRange* pRanges;
+        Pal::VirtualMemoryRemapRange* pSortedRanges;  // Scratch space for sorting the batch on commit, may be null
     };
 
     // Per-VidPnSource flip status
@@ -237,6 +263,10 @@ protected:
 
     VkResult CreateDummyCmdBuffer();
 
+    VkResult WaitForDeferredWork(
+        uint32_t           waitSemaphoreCount,
+        const VkSemaphore* pWaitSemaphores);
+
     void CreateCmdBufRing(
         uint32_t                   deviceIdx);
 
@@ -253,6 +283,11 @@ protected:
     CmdBufState* AcquireInternalCmdBuf(
         uint32_t                   deviceIdx);
 
+    CmdBufState* BuildLayoutFixups(
+        uint32_t                      deviceIdx,
+        uint32_t                      fixupCount,
+        const Pal::BarrierTransition* pFixups);
+
     bool BuildPostProcessCommands(
         uint32_t                         deviceIdx,
         CmdBufState*                     pCmdBufState,
@@ -295,11 +330,25 @@ protected:
     Pal::PerSourceFrameMetadataControl m_palFrameMetadataControl;
     Pal::ICmdBuffer*                   m_pDummyCmdBuffer[MaxPalDevices];
     SqttQueueState*                    m_pSqttState; // Per-queue state for handling SQ thread-tracing annotations
+
+    // The ring of internal command buffers never shrinks below this many entries, enough for double buffering.
+    static constexpr uint32_t MinInternalCmdBufCount = 2;
+
     typedef Util::Deque<CmdBufState*, PalAllocator> CmdBufRing;
     CmdBufRing*                        m_pCmdBufRing[MaxPalDevices];
+    CmdBufState*                       m_pUnusedCmdBufState[MaxPalDevices]; // Ring entry acquired at present which got
+                                                                            // no work and is still open, or null
+    QueueSubmitThread*                 m_pSubmitThread; // Does the PAL submissions if they are deferred, otherwise null
+    QueueSubmitStats*                  m_pSubmitStats;  // Submission latency and idle gap stats, null if disabled
+    QueueTimingState*                  m_pTimingState;  // Records of this queue for the queue timing log, null if
+                                                        // disabled
 
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(Queue);
+
+    // The idle gap sampling and the queue timing log record their command buffers like the internal ones of the queue.
+    friend class QueueSubmitStats;
+    friend class QueueTimingState;
 };
 
 VK_DEFINE_DISPATCHABLE(Queue);
@@ -32,11 +32,15 @@
 #include "include/vk_device.h"
 #include "include/vk_dispatch.h"
 
+#include "palMutex.h"
 #include "palQueueSemaphore.h"
 
+#include <atomic>
+
 namespace Pal
 {
 
+class IQueue;
 class IQueueSemaphore;
 
 }
@@ -45,6 +49,7 @@ namespace vk
 {
 
 class Device;
+class QueueSubmitThread;
 
 class Semaphore final : public NonDispatchable<VkSemaphore, Semaphore>
 {
@@ -132,6 +137,29 @@ public:
         return m_palCreateInfo.flags.timeline;
     }
 
+    // Records the deferred queue submission which last signals this semaphore
+    VK_INLINE void SetPendingSignal(QueueSubmitThread* pSubmitThread, uint64_t sequence)
+        { m_pSignalThread = pSubmitThread; m_signalSequence = sequence; }
+
+    VK_INLINE void GetPendingSignal(QueueSubmitThread** ppSubmitThread, uint64_t* pSequence) const
+        { *ppSubmitThread = m_pSignalThread; *pSequence = m_signalSequence; }
+
+    VkResult WaitForPendingSignal() const;
+
+    // Returns true if the timeline payload is known to have reached value already, without asking PAL.  Timeline
+    // values only ever increase, so any value seen by an earlier query, wait or signal is a safe lower bound.
+    VK_INLINE bool IsKnownToHaveReached(uint64_t value) const
+    {
+        return IsTimelineSemaphore() && (m_useTempSemaphore == false) &&
+               (value <= m_knownCompletedValue.load(std::memory_order_acquire));
+    }
+
+    void UpdateKnownCompletedValue(uint64_t value);
+
+    void RecordQueueSignal(const Pal::IQueue* pPalQueue, uint64_t value);
+
+    bool IsSignaledEarlierOnQueue(const Pal::IQueue* pPalQueue, uint64_t value) const;
+
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(Semaphore);
 
@@ -144,7 +172,12 @@ private:
         m_palCreateInfo(palCreateInfo),
         m_useTempSemaphore(false),
         m_sharedSemaphoreHandle(sharedSemaphorehandle),
-        m_sharedSemaphoreTempHandle(0)
+        m_sharedSemaphoreTempHandle(0),
+        m_pSignalThread(nullptr),
+        m_signalSequence(0),
+        m_knownCompletedValue(0),
+        m_pLastSignalQueue(nullptr),
+        m_lastSignalValue(0)
     {
         for (uint32_t i = 0; i < semaphoreCount; i++)
         {
@@ -173,6 +206,17 @@ private:
     Pal::OsExternalHandle           m_sharedSemaphoreHandle;
     Pal::OsExternalHandle           m_sharedSemaphoreTempHandle;
 
+    QueueSubmitThread*              m_pSignalThread;   // Submit thread of the last deferred submission to signal it
+    uint64_t                        m_signalSequence;  // Sequence number of that submission
+
+    std::atomic<uint64_t>           m_knownCompletedValue; // Highest timeline value this semaphore is known to have
+                                                           // reached
+
+    mutable Util::Mutex             m_queueSignalLock;     // Protects the last queue signal, as the submit threads of
+                                                           // several queues may signal and wait concurrently
+    const Pal::IQueue*              m_pLastSignalQueue;    // PAL queue the last timeline signal was submitted to
+    uint64_t                        m_lastSignalValue;     // Timeline value of that signal
+
 };
 
 namespace entry
@@ -43,6 +43,7 @@ namespace vk
 class Device;
 class DispatchableShader;
 class Instance;
+struct ShaderModuleCacheEntry;
 
 typedef void* (VKAPI_CALL *BilShaderAllocFun)(Instance* pInstance, void* pUserData, size_t size);
 
@@ -64,11 +65,19 @@ public:
         const VkAllocationCallbacks*    pAllocator);
 
     size_t GetCodeSize() const { return m_codeSize; }
-    const void* GetCode() const { return m_pCode; }
+
+    // Returns the SPIR-V code, or nullptr if it is retained in compressed form (see CopyCode()).
+    const void* GetCode() const { return IsCodeCompressed() ? nullptr : m_pCode; }
+
+    bool IsCodeCompressed() const { return (m_storedCodeSize != m_codeSize); }
+
+    VkResult CopyCode(void* pDst) const;
     const ShaderModuleHandle* GetShaderModuleHandle() const { return &m_handle; }
 
     Pal::ShaderHash GetCodeHash(const char* pEntryPoint) const;
 
+    VkShaderModuleCreateFlags GetFlags() const { return m_flags; }
+
     void* GetShaderData(PipelineCompilerType compilerType) const
     {
         return GetShaderData(compilerType, &m_handle);
@@ -78,14 +87,67 @@ public:
 
     static void* GetShaderData(PipelineCompilerType compilerType, const ShaderModuleHandle* pHandle);
 
+    // Returns true if the specialization constants of the module are known, so specialization infos can be reduced to
+    // the entries which have an effect on the code.
+    bool HasSpecConstantInfo() const { return m_specConstantsKnown; }
+
+    static size_t GetNormalizedSpecializationInfoSize(const VkSpecializationInfo& info);
+
+    const VkSpecializationInfo* NormalizeSpecializationInfo(
+        const VkSpecializationInfo* pInfo,
+        void*                       pBuffer,
+        uint32_t*                   pDroppedCount) const;
+
+    void HashSpecializationInfo(
+        Util::MetroHash128*         pHasher,
+        const VkSpecializationInfo& info) const;
+
 protected:
-    ShaderModule(size_t codeSize, const void* pCode);
-    VkResult Init(const Device* pDevice, VkShaderModuleCreateFlags flags);
+    // A specialization constant declared by the module
+    struct SpecConstant
+    {
+        uint32_t specId;        // SpecId decoration of the constant
+        uint32_t resultId;      // SPIR-V result ID of the constant
+        uint32_t size;          // Size of its value in a VkSpecializationInfo, or 0 if the type isn't a known scalar
+        uint32_t reserved;
+        uint64_t defaultValue;  // Value the code gives the constant, little endian
+    };
+
+    static bool ParseSpecConstants(
+        size_t        codeSize,
+        const void*   pCode,
+        uint32_t*     pCount,
+        SpecConstant* pConstants);
 
-    size_t                     m_codeSize;
-    const void*                m_pCode;
-    ShaderModuleHandle         m_handle;
-    Pal::ShaderHash            m_codeHash;
+    const VkSpecializationMapEntry* FindEffectiveEntry(
+        const VkSpecializationInfo& info,
+        const SpecConstant&         constant) const;
+
+    static bool IsSpecializationInfoValid(const VkSpecializationInfo& info);
+
+    ShaderModule(size_t codeSize, const void* pCode);
+    VkResult Init(
+        const Device*             pDevice,
+        VkShaderModuleCreateFlags flags,
+        size_t                    storedCodeSize,
+        const void*               pStoredCode);
+
+    VkResult InitShared(
+        Device*                   pDevice,
+        VkShaderModuleCreateFlags flags,
+        size_t                    storedCodeSize,
+        const void*               pStoredCode);
+
+    size_t                        m_codeSize;
+    const void*                   m_pCode;         // Retained code, LZ4 compressed if m_storedCodeSize is smaller
+    size_t                        m_storedCodeSize;
+    ShaderModuleHandle            m_handle;
+    Pal::ShaderHash               m_codeHash;
+    VkShaderModuleCreateFlags     m_flags;
+    const ShaderModuleCacheEntry* m_pCacheEntry;  // Code and module shared with identical modules, if any
+    const SpecConstant*           m_pSpecConstants;     // Spec constants of the code, sorted by specId
+    uint32_t                      m_specConstantCount;
+    bool                          m_specConstantsKnown; // The code was parsed for spec constants
 
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(ShaderModule);
@@ -50,6 +50,7 @@ namespace vk
 class FullscreenMgr;
 class Fence;
 class Image;
+class QueueSubmitStats;
 class Semaphore;
 class SwCompositor;
 
@@ -140,12 +141,19 @@ public:
     VK_INLINE uint32_t GetAppOwnedImageCount() const
         { return m_appOwnedImageCount; }
 
+    VK_INLINE int64_t GetAcquireWaitTicks() const
+        { return m_acquireWaitTicks; }
+
     VK_INLINE bool IsHwCompositingSupported() const
         { return (m_properties.flags.hwCompositing == 1); }
 
     VK_INLINE const Pal::ScreenColorConfig& GetColorParams() const
         { return m_colorParams; }
 
+    // Sets the name reported with the messages of the swapchain, which must be interned in the device name table
+    VK_INLINE void SetDebugName(const char* pName)
+        { m_pDebugName = pName; }
+
     Pal::IGpuMemory* UpdatePresentInfo(
         uint32_t                   deviceIdx,
         uint32_t                   imageIndex,
@@ -165,6 +173,10 @@ public:
 
     bool NeedPacePresent(const Pal::PresentSwapChainInfo& presentInfo);
 
+    void MarkFramePresented(
+        Pal::IQueue*      pPresentQueue,
+        QueueSubmitStats* pStats);
+
     void AcquireFullScreenProperties();
 
     void SetHdrMetadata(
@@ -184,6 +196,24 @@ protected:
 
     void InitSwCompositor(Pal::QueueType presentQueueType);
 
+    void InitLatencyFences();
+    void DestroyLatencyFences();
+    void PaceAcquire();
+    void RecordFrameLatency(uint32_t frameIdx);
+    void ReportFrameLatency();
+
+    // Maximum number of presented frames whose GPU completion is tracked by the low-latency pacer.
+    static constexpr uint32_t MaxLatencyFrames = 4;
+
+    // Per-frame latency marker written at present and completed when the frame's GPU work is seen to be done.
+    struct FrameLatencyMarker
+    {
+        Pal::IFence*      pFence;        // Signaled by a submission on the present queue right after the present
+        int64_t           presentTicks;  // CPU time at which the frame was presented
+        QueueSubmitStats* pStats;        // Stats of the presenting queue the latency is also recorded to, if any
+        bool              pending;       // The fence has been submitted but not yet seen signaled
+    };
+
     Device*                 m_pDevice;
     const Properties        m_properties;
     uint32_t                m_nextImage;
@@ -194,12 +224,24 @@ protected:
     SwCompositor*           m_pSwCompositor;
     int32_t                 m_appOwnedImageCount;
     uint32_t                m_presentCount;
+    int64_t                 m_acquireWaitTicks;  // Time the last vkAcquireNextImageKHR call blocked, if queue submit
+                                                 // stats are enabled
     VkPresentModeKHR        m_presentMode;
     bool                    m_deprecated;      // Indicates whether the swapchain has been used as
                                                // oldSwapChain when creating a new SwapChain.
 
     uint32_t                m_queueFamilyIndex;                    // Queue family index of the last present
 
+    FrameLatencyMarker      m_latencyFrames[MaxLatencyFrames];     // Ring of the most recently presented frames
+    void*                   m_pLatencyFenceMemory;                 // Storage of the latency marker fences, or nullptr
+                                                                   // if low-latency pacing is disabled
+    uint32_t                m_latencyFrameCount;                   // Number of frames marked so far
+    uint32_t                m_latencySampleCount;                  // Frames measured since the last latency report
+    int64_t                 m_latencySumTicks;                     // Sum of measured present-to-idle latencies
+    int64_t                 m_latencyMaxTicks;                     // Largest measured present-to-idle latency
+    const char*             m_pDebugName;                          // Debug utils name, if a messenger was registered
+                                                                   // when it was set
+
     static bool             s_forceTurboSyncEnable; // Force turbosync enable when synchronizing across swapchains
 
 private:
@@ -323,6 +365,7 @@ protected:
         const Device*     pDevice,
         uint32_t          presentationDeviceIdx,
         uint32_t          imageCount,
+        uint32_t          chunkCount,
         Pal::QueueType    queueType,
         Pal::IImage**     ppBltImages[],
         Pal::IGpuMemory** ppBltMemory[],
@@ -332,10 +375,12 @@ protected:
 
     uint32_t          m_presentationDeviceIdx;          // The physical device that performs the actual present
     uint32_t          m_imageCount;                     // The number of images in the swapchain
+    uint32_t          m_chunkCount;                     // The number of bands each peer copy is split into
     Pal::QueueType    m_queueType;                      // The queue type that the command buffers are compatible with
     Pal::IImage**     m_ppBltImages[MaxPalDevices];     // Array of intermediate images (master) or peer images (slave)
     Pal::IGpuMemory** m_ppBltMemory[MaxPalDevices];     // Array of intermediate memory (master) or peer memory (slave)
-    Pal::ICmdBuffer** m_ppBltCmdBuffers[MaxPalDevices]; // Array of copy to peer image command buffers (slave-only)
+    Pal::ICmdBuffer** m_ppBltCmdBuffers[MaxPalDevices]; // Array of copy to peer image command buffers per image and
+                                                        // band (slave-only)
 
 private:
     PAL_DISALLOW_COPY_AND_ASSIGN(SwCompositor);
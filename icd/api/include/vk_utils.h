@@ -302,6 +302,32 @@ private:
     uint32_t    m_mask;
 };
 
+// =====================================================================================================================
+// IterateMask for code which is specialized on the number of PAL devices.  The single-device variant visits device 0
+// exactly once without scanning the mask.
+template <uint32_t numPalDevices>
+class IterateDeviceMask : public IterateMask
+{
+public:
+    VK_INLINE IterateDeviceMask(uint32_t mask) :
+        IterateMask(mask)
+    {
+    }
+};
+
+template <>
+class IterateDeviceMask<1>
+{
+public:
+    VK_INLINE IterateDeviceMask(uint32_t /*mask*/)
+    {
+    }
+
+    VK_INLINE bool IterateNext() { return false; }
+
+    VK_INLINE uint32_t Index() const { return 0; }
+};
+
 // =====================================================================================================================
 // A "view" into an array of elements that are not tightly packed in memory. The use case is iterating over structures
 // nested in an array of structures, e.g. VkSparseImageMemoryRequirements inside VkSparseImageMemoryRequirements2.
@@ -36,6 +36,8 @@
 #include "include/vk_physical_device.h"
 #include "include/vk_utils.h"
 
+#include "utils/json_writer.h"
+
 #include "palInlineFuncs.h"
 #include "palBuddyAllocatorImpl.h"
 #include "palListImpl.h"
@@ -47,6 +49,71 @@ namespace vk
 
 static constexpr Pal::gpusize PoolAllocationSize        = 1ull << 18;   // 256 kilobytes
 static constexpr Pal::gpusize PoolMinSuballocationSize  = 1ull << 4;    // 16 bytes
+static constexpr Pal::gpusize SlabSize                  = 1ull << 16;   // 64 kilobytes
+
+// Slot sizes of the slab classes, in increasing order.  A small sub-allocation goes to the first class whose slots are
+// at least as large as both its size and its alignment.
+static constexpr uint32_t SlabSlotSizes[InternalMemMgr::SlabClassCount] = { 8, 64, 256, 4096 };
+
+// =====================================================================================================================
+// A slab is one buddy sub-allocation of SlabSize bytes split into equally sized slots.  Free slots are chained through
+// the index array stored right behind the structure, so allocating and freeing a slot is O(1) and never touches the
+// buddy allocator.  A slab is always on exactly one of its pool list's partial or full lists for its slot size.
+struct InternalMemorySlab
+{
+    InternalMemoryPool   memoryPool;    // Pool the slab's backing sub-allocation comes from
+    Pal::gpusize         baseOffset;    // Offset of the slab within the pool
+    uint32_t             slotSize;      // Size and alignment of each slot in bytes
+    uint32_t             slotCount;     // Number of slots in the slab
+    uint32_t             freeCount;     // Number of slots currently free
+    uint32_t             freeHead;      // Index of the first free slot (meaningless if freeCount is zero)
+    InternalMemorySlab** ppPartialHead; // Head of the owning pool list's partial slabs of this slot size
+    InternalMemorySlab** ppFullHead;    // Head of the owning pool list's full slabs of this slot size
+    InternalMemorySlab*  pPrev;         // Previous slab in the list the slab is on
+    InternalMemorySlab*  pNext;         // Next slab in the list the slab is on
+    uint16_t*            pNextFree;     // Per-slot index of the next free slot
+};
+
+// =====================================================================================================================
+static void SlabListPushFront(
+    InternalMemorySlab** ppHead,
+    InternalMemorySlab*  pSlab)
+{
+    pSlab->pPrev = nullptr;
+    pSlab->pNext = *ppHead;
+
+    if (*ppHead != nullptr)
+    {
+        (*ppHead)->pPrev = pSlab;
+    }
+
+    *ppHead = pSlab;
+}
+
+// =====================================================================================================================
+static void SlabListRemove(
+    InternalMemorySlab** ppHead,
+    InternalMemorySlab*  pSlab)
+{
+    if (pSlab->pPrev != nullptr)
+    {
+        pSlab->pPrev->pNext = pSlab->pNext;
+    }
+    else
+    {
+        VK_ASSERT(*ppHead == pSlab);
+
+        *ppHead = pSlab->pNext;
+    }
+
+    if (pSlab->pNext != nullptr)
+    {
+        pSlab->pNext->pPrev = pSlab->pPrev;
+    }
+
+    pSlab->pPrev = nullptr;
+    pSlab->pNext = nullptr;
+}
 
 // =====================================================================================================================
 // Filter invisible heap. For some objects as pipeline, invisible heap will be appended in memory requirement.
@@ -75,7 +142,8 @@ InternalMemMgr::InternalMemMgr(
     :
     m_pDevice(pDevice),
     m_pSysMemAllocator(pInstance->Allocator()),
-    m_poolListMap(32, m_pSysMemAllocator)
+    m_poolListMap(32, m_pSysMemAllocator),
+    m_slabsEnabled(false)
 {
     memset(m_commonPoolProps, 0, sizeof(m_commonPoolProps));
     memset(m_pCommonPools, 0, sizeof(m_pCommonPools));
@@ -98,6 +166,8 @@ VkResult InternalMemMgr::Init()
 
     result = PalToVkResult(palResult);
 
+    m_slabsEnabled = m_pDevice->GetRuntimeSettings().enableInternalMemSlabs;
+
     // Precompute commonly used pool information
     if (result == VK_SUCCESS)
     {
@@ -254,9 +324,28 @@ void InternalMemMgr::Destroy()
 
         MemoryPoolList* pPoolList = mapIt.Get()->value;
 
-        while (pPoolList->NumElements() != 0)
+        // The slabs' backing memory goes away with the pools below, so only their system memory is left to free
+        for (uint32_t slabClass = 0; slabClass < SlabClassCount; ++slabClass)
         {
-            auto it = pPoolList->Begin();
+            InternalMemorySlab* pSlabLists[] =
+                { pPoolList->pPartialSlabs[slabClass], pPoolList->pFullSlabs[slabClass] };
+
+            for (InternalMemorySlab* pSlab : pSlabLists)
+            {
+                while (pSlab != nullptr)
+                {
+                    InternalMemorySlab* pNext = pSlab->pNext;
+
+                    m_pDevice->VkInstance()->FreeMem(pSlab);
+
+                    pSlab = pNext;
+                }
+            }
+        }
+
+        while (pPoolList->pools.NumElements() != 0)
+        {
+            auto it = pPoolList->pools.Begin();
 
             InternalMemoryPool* pPool = it.Get();
 
@@ -289,7 +378,7 @@ void InternalMemMgr::Destroy()
             PAL_DELETE(pPool->pBuddyAllocator, m_pSysMemAllocator);
 
             // Remove item from list
-            pPoolList->Erase(&it);
+            pPoolList->pools.Erase(&it);
         }
 
         // Free this list
@@ -324,15 +413,12 @@ VkResult InternalMemMgr::CalcSubAllocationPool(
     const MemoryPoolProperties& poolProps,
     void**                      ppPoolInfo)
 {
-    Util::MutexAuto lock(&m_allocatorLock); // Ensure thread-safety using the lock
-
     return CalcSubAllocationPoolInternal(poolProps, reinterpret_cast<MemoryPoolList**>(ppPoolInfo));
 }
 
 // =====================================================================================================================
-// Internal version of CalcSubAllocationPool() that doesn't take the lock.
-//
-// WARNING: This function is NOT thread-safe and assumes the caller is holding a lock on m_allocatorLock.
+// Internal version of CalcSubAllocationPool() returning the typed pool list.  Lookups of existing lists only take
+// m_poolListMapLock for reading; the write lock is only needed the first time a property combination is seen.
 VkResult InternalMemMgr::CalcSubAllocationPoolInternal(
     const MemoryPoolProperties& poolProps,
      MemoryPoolList**           ppPoolList)
@@ -347,18 +433,41 @@ VkResult InternalMemMgr::CalcSubAllocationPoolInternal(
 
     VkResult result = VK_SUCCESS;
 
+    MemoryPoolList* pExistingList = nullptr;
+
     // Find a previously-seen memory pool list corresponding to the requested memory pool properties.
-    MemoryPoolList** ppExistingList = m_poolListMap.FindKey(poolProps);
+    {
+        Util::RWLockAuto<Util::RWLock::LockType::ReadOnly> readLock(&m_poolListMapLock);
+
+        MemoryPoolList** ppExistingList = m_poolListMap.FindKey(poolProps);
+
+        if (ppExistingList != nullptr)
+        {
+            pExistingList = *ppExistingList;
+        }
+    }
 
     // If one already exists, return that; if no memory pool list exists yet for the requested memory pool properties
     // then create a new one.
-    if (ppExistingList != nullptr)
+    if (pExistingList != nullptr)
     {
-        *ppPoolList = *ppExistingList;
+        *ppPoolList = pExistingList;
     }
     else
     {
-        result = CreateMemoryPoolList(poolProps, ppPoolList);
+        Util::RWLockAuto<Util::RWLock::LockType::ReadWrite> writeLock(&m_poolListMapLock);
+
+        // Another thread may have created the list between dropping the read lock and taking the write lock
+        MemoryPoolList** ppExistingList = m_poolListMap.FindKey(poolProps);
+
+        if (ppExistingList != nullptr)
+        {
+            *ppPoolList = *ppExistingList;
+        }
+        else
+        {
+            result = CreateMemoryPoolList(poolProps, ppPoolList);
+        }
 
         if (result != VK_SUCCESS)
         {
@@ -374,7 +483,7 @@ VkResult InternalMemMgr::CalcSubAllocationPoolInternal(
 // homogenous properties in terms of GPU heap, etc.  Sub-allocations will be made by looking for space within the
 // entries in this list.
 //
-// WARNING: This function is NOT thread-safe and assumes the caller is holding a lock on m_allocatorLock.
+// WARNING: This function is NOT thread-safe and assumes the caller is holding m_poolListMapLock for writing.
 VkResult InternalMemMgr::CreateMemoryPoolList(
     const MemoryPoolProperties& poolProps,
     MemoryPoolList**            ppNewList)
@@ -413,7 +522,7 @@ VkResult InternalMemMgr::CreateMemoryPoolList(
 // An initial sub-allocation will be made from the pool and information for that sub-allocation will be returned by this
 // function.
 //
-// WARNING: This function is NOT thread-safe and assumes the caller is holding a lock on m_allocatorLock.
+// WARNING: This function is NOT thread-safe and assumes the caller is holding the lock of pOwnerList.
 VkResult InternalMemMgr::CreateMemoryPoolAndSubAllocate(
     MemoryPoolList*              pOwnerList,
     const InternalMemCreateInfo& initialSubAllocInfo,
@@ -470,11 +579,13 @@ VkResult InternalMemMgr::CreateMemoryPoolAndSubAllocate(
 
     if (result == VK_SUCCESS)
     {
-        Pal::Result palResult = pOwnerList->PushFront(newPool);
+        newPool.pBuddyAllocatorLock = &pOwnerList->lock;
+
+        Pal::Result palResult = pOwnerList->pools.PushFront(newPool);
         result = PalToVkResult(palResult);
         VK_ASSERT(result == VK_SUCCESS);
 
-        pInternalMemory = pOwnerList->Begin().Get();
+        pInternalMemory = pOwnerList->pools.Begin().Get();
 
         // Allocate the base GPU memory object for this pool
         result = AllocBaseGpuMem(poolInfo.pal,
@@ -498,8 +609,8 @@ VkResult InternalMemMgr::CreateMemoryPoolAndSubAllocate(
     }
     else
     {
-        auto it = pOwnerList->Begin();
-        bool needEraseFromOwnerList = pOwnerList->NumElements() > 0 ?
+        auto it = pOwnerList->pools.Begin();
+        bool needEraseFromOwnerList = pOwnerList->pools.NumElements() > 0 ?
             (it.Get()->groupMemory.PalMemory(DefaultDeviceIndex) ==
              pInternalMemory->groupMemory.PalMemory(DefaultDeviceIndex)) : false;
 
@@ -518,7 +629,7 @@ VkResult InternalMemMgr::CreateMemoryPoolAndSubAllocate(
         // Remove this memory pool from the list if we added it
         if (needEraseFromOwnerList)
         {
-            pOwnerList->Erase(&it);
+            pOwnerList->pools.Erase(&it);
         }
     }
 
@@ -541,12 +652,244 @@ void InternalMemMgr::CheckProvidedSubAllocPoolInfo(
 
     GetMemoryPoolPropertiesFromAllocInfo(memInfo, &poolProps);
 
+    Util::RWLockAuto<Util::RWLock::LockType::ReadOnly> readLock(&m_poolListMapLock);
+
     MemoryPoolList** ppExistingList = m_poolListMap.FindKey(poolProps);
 
     VK_ASSERT((ppExistingList != nullptr) && (*ppExistingList == memInfo.pPoolInfo));
 #endif
 }
 
+// =====================================================================================================================
+// Sub-allocates from the first pool of the list with enough free space, creating a new pool if there is none.
+//
+// WARNING: This function is NOT thread-safe and assumes the caller is holding the lock of pPoolList.
+VkResult InternalMemMgr::SubAllocate(
+    MemoryPoolList*              pPoolList,
+    const InternalMemCreateInfo& createInfo,
+    uint32_t                     allocMask,
+    InternalMemoryPool*          pPool,
+    Pal::gpusize*                pOffset)
+{
+    // Assume that we won't find an appropriate pool
+    VkResult result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+    // Search for a memory pool to suballocate from
+    for (auto it = pPoolList->pools.Begin(); it.Get() != nullptr; it.Next())
+    {
+        InternalMemoryPool* pCandidate = it.Get();
+
+        // Try to suballocate from the current memory pool using its buddy allocator
+        Pal::Result palResult = pCandidate->pBuddyAllocator->Allocate(
+            createInfo.pal.size,
+            createInfo.pal.alignment,
+            pOffset);
+
+        if (palResult == Pal::Result::Success)
+        {
+            // If the suballocation succeeded, set the memory pool the suballocation came from
+            *pPool = *pCandidate;
+
+            // Set the result to success and quit the loop
+            result = VK_SUCCESS;
+            break;
+        }
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        // If at this point we still didn't manage to find an appropriate pool that has enough space then
+        // it means we need to create a new memory pool and sub-allocate from that
+        result = CreateMemoryPoolAndSubAllocate(pPoolList, createInfo, pPool, allocMask, pOffset);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Hands out a slot of the given slab class, carving a new slab out of the pool list if no slab has a free slot.
+//
+// WARNING: This function is NOT thread-safe and assumes the caller is holding the lock of pPoolList.
+VkResult InternalMemMgr::AllocSlabSlot(
+    MemoryPoolList*              pPoolList,
+    uint32_t                     slabClass,
+    const InternalMemCreateInfo& createInfo,
+    uint32_t                     allocMask,
+    InternalMemory*              pInternalMemory)
+{
+    VkResult result = VK_SUCCESS;
+
+    InternalMemorySlab* pSlab = pPoolList->pPartialSlabs[slabClass];
+
+    if (pSlab == nullptr)
+    {
+        const uint32_t slotSize  = SlabSlotSizes[slabClass];
+        const uint32_t slotCount = static_cast<uint32_t>(SlabSize / slotSize);
+
+        static_assert((SlabSize / 8) <= UINT16_MAX + 1, "Free slot indices must fit 16 bits");
+
+        pSlab = static_cast<InternalMemorySlab*>(m_pDevice->VkInstance()->AllocMem(
+            sizeof(InternalMemorySlab) + (slotCount * sizeof(uint16_t)),
+            VK_DEFAULT_MEM_ALIGN,
+            VK_SYSTEM_ALLOCATION_SCOPE_DEVICE));
+
+        if (pSlab != nullptr)
+        {
+            InternalMemCreateInfo slabInfo = createInfo;
+
+            slabInfo.pal.size      = SlabSize;
+            slabInfo.pal.alignment = slotSize;
+
+            result = SubAllocate(pPoolList, slabInfo, allocMask, &pSlab->memoryPool, &pSlab->baseOffset);
+
+            if (result == VK_SUCCESS)
+            {
+                pSlab->slotSize      = slotSize;
+                pSlab->slotCount     = slotCount;
+                pSlab->freeCount     = slotCount;
+                pSlab->freeHead      = 0;
+                pSlab->ppPartialHead = &pPoolList->pPartialSlabs[slabClass];
+                pSlab->ppFullHead    = &pPoolList->pFullSlabs[slabClass];
+                pSlab->pNextFree     = reinterpret_cast<uint16_t*>(pSlab + 1);
+
+                for (uint32_t slot = 0; slot < slotCount; ++slot)
+                {
+                    // The last entry wraps to 0 but is never followed since freeCount reaches zero first
+                    pSlab->pNextFree[slot] = static_cast<uint16_t>(slot + 1);
+                }
+
+                SlabListPushFront(pSlab->ppPartialHead, pSlab);
+            }
+            else
+            {
+                m_pDevice->VkInstance()->FreeMem(pSlab);
+            }
+        }
+        else
+        {
+            result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        const uint32_t slot = pSlab->freeHead;
+
+        pSlab->freeHead = pSlab->pNextFree[slot];
+        pSlab->freeCount--;
+
+        if (pSlab->freeCount == 0)
+        {
+            SlabListRemove(pSlab->ppPartialHead, pSlab);
+            SlabListPushFront(pSlab->ppFullHead, pSlab);
+        }
+
+        pInternalMemory->m_memoryPool = pSlab->memoryPool;
+        pInternalMemory->m_offset     = pSlab->baseOffset + (static_cast<Pal::gpusize>(slot) * pSlab->slotSize);
+        pInternalMemory->m_pSlab      = pSlab;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Returns a slot to its slab.  A slab that becomes entirely free is handed back to the buddy allocator unless it is
+// the only slab of its size with free slots, so that alternating allocate/free doesn't keep recreating it.
+void InternalMemMgr::FreeSlabSlot(
+    const InternalMemory* pInternalMemory)
+{
+    InternalMemorySlab* pSlab = pInternalMemory->m_pSlab;
+
+    VK_ASSERT(pSlab->memoryPool.pBuddyAllocatorLock != nullptr);
+
+    Util::MutexAuto lock(pSlab->memoryPool.pBuddyAllocatorLock);
+
+    const uint32_t slot = static_cast<uint32_t>((pInternalMemory->m_offset - pSlab->baseOffset) / pSlab->slotSize);
+
+    VK_ASSERT((slot < pSlab->slotCount) && (pSlab->freeCount < pSlab->slotCount));
+
+    pSlab->pNextFree[slot] = static_cast<uint16_t>(pSlab->freeHead);
+    pSlab->freeHead        = slot;
+
+    if (pSlab->freeCount == 0)
+    {
+        SlabListRemove(pSlab->ppFullHead, pSlab);
+        SlabListPushFront(pSlab->ppPartialHead, pSlab);
+    }
+
+    pSlab->freeCount++;
+
+    if ((pSlab->freeCount == pSlab->slotCount) &&
+        ((pSlab->pPrev != nullptr) || (pSlab->pNext != nullptr)))
+    {
+        SlabListRemove(pSlab->ppPartialHead, pSlab);
+
+        pSlab->memoryPool.pBuddyAllocator->Free(pSlab->baseOffset, SlabSize, pSlab->slotSize);
+
+        m_pDevice->VkInstance()->FreeMem(pSlab);
+    }
+}
+
+// =====================================================================================================================
+// Appends a JSON record of the occupancy of every slab to the given file.
+void InternalMemMgr::WriteSlabStats(
+    const char* pFilePath)
+{
+    utils::JsonOutputStream stream(pFilePath);
+    Util::JsonWriter        writer(&stream);
+
+    writer.BeginMap(false);
+    writer.KeyAndValue("timestampMs",
+                       static_cast<uint64_t>((Util::GetPerfCpuTime() * 1000) / Util::GetPerfFrequency()));
+    writer.KeyAndBeginList("poolLists", false);
+
+    Util::RWLockAuto<Util::RWLock::LockType::ReadOnly> readLock(&m_poolListMapLock);
+
+    for (auto mapIt = m_poolListMap.Begin(); mapIt.Get() != nullptr; mapIt.Next())
+    {
+        const MemoryPoolProperties& poolProps = mapIt.Get()->key;
+        MemoryPoolList*             pPoolList = mapIt.Get()->value;
+
+        Util::MutexAuto lock(&pPoolList->lock);
+
+        writer.BeginMap(false);
+        writer.KeyAndBeginList("heaps", true);
+
+        for (size_t h = 0; h < poolProps.heapCount; ++h)
+        {
+            writer.Value(static_cast<uint32_t>(poolProps.heaps[h]));
+        }
+
+        writer.EndList();
+        writer.KeyAndValue("persistentMapped", poolProps.flags.persistentMapped != 0);
+        writer.KeyAndBeginList("slabs", false);
+
+        for (uint32_t slabClass = 0; slabClass < SlabClassCount; ++slabClass)
+        {
+            const InternalMemorySlab* pSlabLists[] =
+                { pPoolList->pPartialSlabs[slabClass], pPoolList->pFullSlabs[slabClass] };
+
+            for (const InternalMemorySlab* pSlab : pSlabLists)
+            {
+                for (; pSlab != nullptr; pSlab = pSlab->pNext)
+                {
+                    writer.BeginMap(true);
+                    writer.KeyAndValue("slotSize", pSlab->slotSize);
+                    writer.KeyAndValue("slotCount", pSlab->slotCount);
+                    writer.KeyAndValue("usedSlots", pSlab->slotCount - pSlab->freeCount);
+                    writer.EndMap();
+                }
+            }
+        }
+
+        writer.EndList();
+        writer.EndMap();
+    }
+
+    writer.EndList();
+    writer.EndMap();
+}
+
 // =====================================================================================================================
 // Allocates GPU memory for internal use. Depending on the type of memory object requested, the memory may be
 // sub-allocated from an existing allocation, or it might not.
@@ -558,10 +901,10 @@ VkResult InternalMemMgr::AllocGpuMem(
 {
     VK_ASSERT(pInternalMemory != nullptr);
 
-    Util::MutexAuto lock(&m_allocatorLock); // Ensure thread-safety using the lock
-
     VkResult result = VK_SUCCESS;
 
+    pInternalMemory->m_pSlab = nullptr;
+
     // If the requested allocation is small enough (at most half the size of a single pool) then try to find an
     // appropriate pool and suballocate from it.
     if ((createInfo.flags.noSuballocation == false) &&
@@ -590,48 +933,40 @@ VkResult InternalMemMgr::AllocGpuMem(
 
         if (result == VK_SUCCESS)
         {
-            // Assume that we won't find an appropriate pool
-            result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+            // Find the smallest slab class that fits this allocation, if any
+            const Pal::gpusize slotSizeNeeded = Util::Max(createInfo.pal.size, createInfo.pal.alignment);
 
-            // If found an appropriate pool list then search for a memory pool to suballocate from
-            for (auto it = pPoolList->Begin(); it.Get() != nullptr; it.Next())
-            {
-                InternalMemoryPool* pPool = it.Get();
+            uint32_t slabClass = m_slabsEnabled ? 0 : SlabClassCount;
 
-                // Try to suballocate from the current memory pool using its buddy allocator
-                Pal::Result palResult = pPool->pBuddyAllocator->Allocate(
-                    createInfo.pal.size,
-                    createInfo.pal.alignment,
-                    &pInternalMemory->m_offset);
+            while ((slabClass < SlabClassCount) && (SlabSlotSizes[slabClass] < slotSizeNeeded))
+            {
+                ++slabClass;
+            }
 
-                if (palResult == Pal::Result::Success)
-                {
-                    // If the suballocation succeeded, set the memory pool the suballocation came from
-                    pInternalMemory->m_memoryPool = *pPool;
+            // Only allocations sharing this pool list's properties contend for its lock
+            Util::MutexAuto lock(&pPoolList->lock);
 
-                    // Set the result to success and quit the loop
-                    result = VK_SUCCESS;
-                    break;
-                }
+            if (slabClass < SlabClassCount)
+            {
+                result = AllocSlabSlot(pPoolList, slabClass, createInfo, allocMask, pInternalMemory);
             }
-
-            if (result != VK_SUCCESS)
+            else
             {
-                // If at this point we still didn't manage to find an appropriate pool that has enough space then
-                // it means we need to create a new memory pool and sub-allocate from that
-                result = CreateMemoryPoolAndSubAllocate(
+                result = SubAllocate(
                     pPoolList,
                     createInfo,
-                    &pInternalMemory->m_memoryPool,
                     allocMask,
+                    &pInternalMemory->m_memoryPool,
                     &pInternalMemory->m_offset);
             }
         }
     }
     else
     {
-        // We don't suballocate from a pool so there's no buddy allocator and also offset is always zero
-        pInternalMemory->m_memoryPool.pBuddyAllocator    = nullptr;
+        // We don't suballocate from a pool so there's no buddy allocator and also offset is always zero.  Base
+        // allocations don't touch any manager state, so no lock is needed here.
+        pInternalMemory->m_memoryPool.pBuddyAllocator     = nullptr;
+        pInternalMemory->m_memoryPool.pBuddyAllocatorLock = nullptr;
         pInternalMemory->m_offset = 0;
 
         // Issue a base memory allocation and use that as the memory object
@@ -674,6 +1009,13 @@ VkResult InternalMemMgr::AllocGpuMem(
 
         pInternalMemory->m_size      = createInfo.pal.size;
         pInternalMemory->m_alignment = createInfo.pal.alignment;
+
+        m_pDevice->GetMemoryEventLog()->Record(MemoryEventType::InternalAlloc,
+                                               pInternalMemory,
+                                               nullptr,
+                                               createInfo.pal.size,
+                                               pInternalMemory->m_offset,
+                                               createInfo.pal.heaps[0]);
     }
 
     return result;
@@ -767,12 +1109,25 @@ VkResult InternalMemMgr::AllocAndBindGpuMem(
 void InternalMemMgr::FreeGpuMem(
     const InternalMemory* pInternalMemory)
 {
-    Util::MutexAuto lock(&m_allocatorLock);
-
     VK_ASSERT(pInternalMemory != nullptr);
 
-    if (pInternalMemory->m_memoryPool.pBuddyAllocator != nullptr)
+    m_pDevice->GetMemoryEventLog()->Record(MemoryEventType::InternalFree,
+                                           pInternalMemory,
+                                           nullptr,
+                                           pInternalMemory->m_size,
+                                           pInternalMemory->m_offset,
+                                           Pal::GpuHeapCount);
+
+    if (pInternalMemory->m_pSlab != nullptr)
+    {
+        FreeSlabSlot(pInternalMemory);
+    }
+    else if (pInternalMemory->m_memoryPool.pBuddyAllocator != nullptr)
     {
+        VK_ASSERT(pInternalMemory->m_memoryPool.pBuddyAllocatorLock != nullptr);
+
+        Util::MutexAuto lock(pInternalMemory->m_memoryPool.pBuddyAllocatorLock);
+
         // The memory was suballocated so free it using the buddy allocator
         pInternalMemory->m_memoryPool.pBuddyAllocator->Free(
             pInternalMemory->m_offset,
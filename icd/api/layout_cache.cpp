@@ -0,0 +1,215 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  layout_cache.cpp
+* @brief Implementation of the cache of live descriptor set layouts and pipeline layouts.
+***********************************************************************************************************************
+*/
+
+#include "include/layout_cache.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+LayoutSignature::LayoutSignature(
+    Instance* pInstance)
+    :
+    m_data(pInstance->Allocator()),
+    m_valid(true)
+{
+}
+
+// =====================================================================================================================
+LayoutCache::LayoutCache(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_enabled(false),
+    m_entries(pDevice->VkInstance())
+{
+}
+
+// =====================================================================================================================
+void LayoutCache::Init()
+{
+    m_enabled = m_pDevice->GetRuntimeSettings().enableLayoutCache &&
+                (m_pDevice->GetPrivateDataSize() == 0)            &&
+                (m_entries.Init() == Pal::Result::Success);
+}
+
+// =====================================================================================================================
+// Returns true if an object created with the given allocation callbacks may be shared.
+bool LayoutCache::CanShare(
+    const VkAllocationCallbacks* pAllocator) const
+{
+    return m_enabled && (pAllocator == m_pDevice->VkInstance()->GetAllocCallbacks());
+}
+
+// =====================================================================================================================
+LayoutCache::Key LayoutCache::MakeKey(
+    LayoutType type,
+    uint64_t   apiHash)
+{
+    Key key;
+
+    memset(&key, 0, sizeof(key));
+
+    key.apiHash = apiHash;
+    key.type    = type;
+
+    return key;
+}
+
+// =====================================================================================================================
+// Returns true if an entry was created from a create info with the given signature.
+bool LayoutCache::Matches(
+    const Entry&           entry,
+    const LayoutSignature& signature)
+{
+    return (entry.signatureSize == signature.GetSize()) &&
+           (memcmp(entry.pSignature, signature.GetData(), signature.GetSize() * sizeof(uint32_t)) == 0);
+}
+
+// =====================================================================================================================
+// Returns a live object created from a create info with the given hash and signature and takes a reference to it, or
+// nullptr if there is none.
+void* LayoutCache::Acquire(
+    LayoutType             type,
+    uint64_t               apiHash,
+    const LayoutSignature& signature)
+{
+    VK_ASSERT(m_enabled && signature.IsValid());
+
+    void* pObject = nullptr;
+
+    Util::MutexAuto lock(&m_lock);
+
+    Entry* pEntry = m_entries.FindKey(MakeKey(type, apiHash));
+
+    if ((pEntry != nullptr) && Matches(*pEntry, signature))
+    {
+        pEntry->refCount++;
+
+        pObject = pEntry->pObject;
+    }
+
+    return pObject;
+}
+
+// =====================================================================================================================
+// Adds a newly created object to the cache.  Returns the object the create should return: the given one, or one with
+// the same hash and signature which another thread added in the meantime, in which case the caller must destroy its
+// own.  An object which can't be added, e.g. because another object holds the hash, is simply not shared.
+void* LayoutCache::Insert(
+    LayoutType             type,
+    uint64_t               apiHash,
+    const LayoutSignature& signature,
+    void*                  pObject)
+{
+    VK_ASSERT(m_enabled && signature.IsValid());
+
+    void* pResult = pObject;
+
+    Util::MutexAuto lock(&m_lock);
+
+    const Key key     = MakeKey(type, apiHash);
+    bool      existed = false;
+    Entry*    pEntry  = nullptr;
+
+    if (m_entries.FindAllocate(key, &existed, &pEntry) == Pal::Result::Success)
+    {
+        if (existed == false)
+        {
+            const size_t signatureBytes = signature.GetSize() * sizeof(uint32_t);
+
+            pEntry->pSignature = static_cast<uint32_t*>(m_pDevice->VkInstance()->AllocMem(
+                signatureBytes,
+                VK_SYSTEM_ALLOCATION_SCOPE_OBJECT));
+
+            if (pEntry->pSignature != nullptr)
+            {
+                memcpy(pEntry->pSignature, signature.GetData(), signatureBytes);
+
+                pEntry->pObject       = pObject;
+                pEntry->signatureSize = signature.GetSize();
+                pEntry->refCount      = 1;
+            }
+            else
+            {
+                m_entries.Erase(key);
+            }
+        }
+        else if (Matches(*pEntry, signature))
+        {
+            pEntry->refCount++;
+
+            pResult = pEntry->pObject;
+        }
+    }
+
+    return pResult;
+}
+
+// =====================================================================================================================
+// Drops a reference taken by creating the object.  Returns true if the caller must destroy the object, because this
+// was its last reference or it isn't shared.
+bool LayoutCache::Release(
+    LayoutType  type,
+    uint64_t    apiHash,
+    const void* pObject)
+{
+    bool destroy = true;
+
+    if (m_enabled)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        const Key key    = MakeKey(type, apiHash);
+        Entry*    pEntry = m_entries.FindKey(key);
+
+        if ((pEntry != nullptr) && (pEntry->pObject == pObject))
+        {
+            VK_ASSERT(pEntry->refCount > 0);
+
+            if (--pEntry->refCount == 0)
+            {
+                m_pDevice->VkInstance()->FreeMem(pEntry->pSignature);
+                m_entries.Erase(key);
+            }
+            else
+            {
+                destroy = false;
+            }
+        }
+    }
+
+    return destroy;
+}
+
+} // namespace vk
@@ -0,0 +1,321 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  memory_block_cache.cpp
+* @brief Implementation of the cache of PAL memory objects of freed VkDeviceMemory allocations.
+***********************************************************************************************************************
+*/
+#include "include/memory_block_cache.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+
+#include "palInlineFuncs.h"
+#include "palSysUtil.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+MemoryBlockCache::MemoryBlockCache(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_maxBytes(0),
+    m_maxBlockSize(0),
+    m_maxAgeTicks(0),
+    m_cachedBytes(0)
+{
+    memset(m_buckets, 0, sizeof(m_buckets));
+}
+
+// =====================================================================================================================
+void MemoryBlockCache::Init()
+{
+    const RuntimeSettings& settings = m_pDevice->GetRuntimeSettings();
+
+    m_maxBytes     = settings.memoryBlockCacheSize;
+    m_maxBlockSize = m_maxBytes / 4;
+    m_maxAgeTicks  = (static_cast<uint64_t>(settings.memoryBlockCacheMaxAge) * Util::GetPerfFrequency()) / 1000;
+}
+
+// =====================================================================================================================
+// Releases every cached block.
+void MemoryBlockCache::Destroy()
+{
+    Util::MutexAuto lock(&m_lock);
+
+    for (uint32_t bucketIdx = 0; bucketIdx < BucketCount; ++bucketIdx)
+    {
+        while (m_buckets[bucketIdx].count > 0)
+        {
+            EvictEntry(&m_buckets[bucketIdx], 0, true);
+        }
+    }
+
+    VK_ASSERT(m_cachedBytes == 0);
+}
+
+// =====================================================================================================================
+// Returns true if a block created with the given info may be reused by another allocation once it is freed.  Anything
+// that ties the block to its original allocation beyond its properties (sharing, a dedicated image, a fixed VA) or
+// that is too big for the cache's budget is not.
+bool MemoryBlockCache::IsCacheable(
+    const Pal::GpuMemoryCreateInfo& createInfo,
+    uint32_t                        allocationMask
+    ) const
+{
+    return (m_maxBytes > 0)                                     &&
+           (m_pDevice->NumPalDevices() == 1)                    &&
+           (allocationMask == (1u << DefaultDeviceIndex))       &&
+           (createInfo.size != 0)                               &&
+           (createInfo.size <= m_maxBlockSize)                  &&
+           (createInfo.flags.interprocess == 0)                 &&
+           (createInfo.flags.shareable == 0)                    &&
+           (createInfo.flags.tmzProtected == 0)                 &&
+           (createInfo.pImage == nullptr)                       &&
+           (createInfo.vaRange == Pal::VaRange::Default);
+}
+
+// =====================================================================================================================
+void MemoryBlockCache::MakeKey(
+    const Pal::GpuMemoryCreateInfo& createInfo,
+    MemoryBlockKey*                 pKey)
+{
+    memset(pKey, 0, sizeof(*pKey));
+
+    pKey->size           = createInfo.size;
+    pKey->alignment      = createInfo.alignment;
+    pKey->flags          = createInfo.flags;
+    pKey->priority       = createInfo.priority;
+    pKey->priorityOffset = createInfo.priorityOffset;
+    pKey->heapCount      = createInfo.heapCount;
+
+    for (uint32_t h = 0; h < createInfo.heapCount; ++h)
+    {
+        pKey->heaps[h] = createInfo.heaps[h];
+    }
+}
+
+// =====================================================================================================================
+uint32_t MemoryBlockCache::GetBucketIndex(
+    Pal::gpusize size)
+{
+    const uint32_t log2Size = Util::Log2(size);
+
+    return (log2Size < BucketCount) ? log2Size : (BucketCount - 1);
+}
+
+// =====================================================================================================================
+// Takes a block matching the key out of the cache, preferring the most recently freed one.  Returns null if there is
+// none.
+Pal::IGpuMemory* MemoryBlockCache::Acquire(
+    const MemoryBlockKey& key)
+{
+    Pal::IGpuMemory* pGpuMemory = nullptr;
+
+    if (m_maxBytes > 0)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        Bucket* pBucket = &m_buckets[GetBucketIndex(key.size)];
+
+        for (uint32_t entryIdx = pBucket->count; entryIdx-- > 0; )
+        {
+            if (memcmp(&pBucket->entries[entryIdx].key, &key, sizeof(key)) == 0)
+            {
+                pGpuMemory = pBucket->entries[entryIdx].pGpuMemory;
+
+                EvictEntry(pBucket, entryIdx, false);
+                break;
+            }
+        }
+    }
+
+    return pGpuMemory;
+}
+
+// =====================================================================================================================
+// Offers the block of a freed memory object to the cache.  Returns false if the cache didn't take it, in which case
+// the caller still owns the block.
+bool MemoryBlockCache::Release(
+    const MemoryBlockKey& key,
+    Pal::IGpuMemory*      pGpuMemory)
+{
+    bool cached = false;
+
+    if ((m_maxBytes > 0) && (key.size <= m_maxBlockSize))
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        const uint64_t now = Util::GetPerfCpuTime();
+
+        EvictExpired(now);
+
+        // Make room by dropping the blocks that have waited the longest
+        bool evicted = true;
+
+        while (((m_cachedBytes + key.size) > m_maxBytes) && evicted)
+        {
+            evicted = EvictOldest();
+        }
+
+        Bucket* pBucket = &m_buckets[GetBucketIndex(key.size)];
+
+        if (pBucket->count == EntriesPerBucket)
+        {
+            EvictEntry(pBucket, 0, true);
+        }
+
+        Entry* pEntry = &pBucket->entries[pBucket->count++];
+
+        pEntry->key         = key;
+        pEntry->pGpuMemory  = pGpuMemory;
+        pEntry->releaseTime = now;
+
+        m_cachedBytes += key.size;
+
+        m_pDevice->IncreaseAllocatedMemorySize(key.size, 1u << DefaultDeviceIndex, key.heaps[0]);
+
+        cached = true;
+    }
+
+    return cached;
+}
+
+// =====================================================================================================================
+// Releases cached blocks of the given heap until at least size bytes were released or none are left.  Used when the
+// device runs out of its memory budget.  Returns the number of bytes released.
+Pal::gpusize MemoryBlockCache::Trim(
+    Pal::GpuHeap heap,
+    Pal::gpusize size)
+{
+    Pal::gpusize released = 0;
+
+    if (m_maxBytes > 0)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        for (uint32_t bucketIdx = 0; (bucketIdx < BucketCount) && (released < size); ++bucketIdx)
+        {
+            Bucket* pBucket = &m_buckets[bucketIdx];
+
+            for (uint32_t entryIdx = 0; (entryIdx < pBucket->count) && (released < size); )
+            {
+                if (pBucket->entries[entryIdx].key.heaps[0] == heap)
+                {
+                    released += pBucket->entries[entryIdx].key.size;
+
+                    EvictEntry(pBucket, entryIdx, true);
+                }
+                else
+                {
+                    ++entryIdx;
+                }
+            }
+        }
+    }
+
+    return released;
+}
+
+// =====================================================================================================================
+// Removes an entry from its bucket and from the device's allocated memory size, destroying its block unless the caller
+// takes it over.
+//
+// WARNING: This function is NOT thread-safe and assumes the caller is holding m_lock.
+void MemoryBlockCache::EvictEntry(
+    Bucket*  pBucket,
+    uint32_t entryIdx,
+    bool     destroy)
+{
+    const Entry& entry = pBucket->entries[entryIdx];
+
+    m_cachedBytes -= entry.key.size;
+
+    m_pDevice->DecreaseAllocatedMemorySize(entry.key.size, 1u << DefaultDeviceIndex, entry.key.heaps[0]);
+
+    if (destroy)
+    {
+        entry.pGpuMemory->Destroy();
+
+        m_pDevice->VkInstance()->FreeMem(entry.pGpuMemory);
+    }
+
+    pBucket->count--;
+
+    for (uint32_t i = entryIdx; i < pBucket->count; ++i)
+    {
+        pBucket->entries[i] = pBucket->entries[i + 1];
+    }
+}
+
+// =====================================================================================================================
+// Releases all blocks that have been in the cache for longer than the maximum age.  Entries are ordered oldest first
+// within each bucket.
+//
+// WARNING: This function is NOT thread-safe and assumes the caller is holding m_lock.
+void MemoryBlockCache::EvictExpired(
+    uint64_t now)
+{
+    for (uint32_t bucketIdx = 0; bucketIdx < BucketCount; ++bucketIdx)
+    {
+        Bucket* pBucket = &m_buckets[bucketIdx];
+
+        while ((pBucket->count > 0) && ((now - pBucket->entries[0].releaseTime) > m_maxAgeTicks))
+        {
+            EvictEntry(pBucket, 0, true);
+        }
+    }
+}
+
+// =====================================================================================================================
+// Releases the block that has been in the cache the longest.  Returns false if the cache is empty.
+//
+// WARNING: This function is NOT thread-safe and assumes the caller is holding m_lock.
+bool MemoryBlockCache::EvictOldest()
+{
+    Bucket* pOldest = nullptr;
+
+    for (uint32_t bucketIdx = 0; bucketIdx < BucketCount; ++bucketIdx)
+    {
+        Bucket* pBucket = &m_buckets[bucketIdx];
+
+        if ((pBucket->count > 0) &&
+            ((pOldest == nullptr) || (pBucket->entries[0].releaseTime < pOldest->entries[0].releaseTime)))
+        {
+            pOldest = pBucket;
+        }
+    }
+
+    if (pOldest != nullptr)
+    {
+        EvictEntry(pOldest, 0, true);
+    }
+
+    return (pOldest != nullptr);
+}
+
+} // namespace vk
@@ -0,0 +1,160 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  memory_event_log.cpp
+* @brief Implementation of the optional log of memory allocation, free and bind events.
+***********************************************************************************************************************
+*/
+
+#include "include/memory_event_log.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+
+#include "palSysUtil.h"
+
+namespace vk
+{
+
+static const char* EventNames[static_cast<uint32_t>(MemoryEventType::Count)] =
+{
+    "MemoryCreate",
+    "MemoryFree",
+    "InternalAlloc",
+    "InternalFree",
+    "BufferBind",
+    "ImageBind",
+};
+
+// =====================================================================================================================
+MemoryEventLog::MemoryEventLog(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_enabled(false),
+    m_startTicks(0),
+    m_perfFrequency(1),
+    m_rings(pDevice->VkInstance()->GetAllocCallbacks(), VK_SYSTEM_ALLOCATION_SCOPE_DEVICE)
+{
+}
+
+// =====================================================================================================================
+// Opens the log file if the log is enabled.
+void MemoryEventLog::Init()
+{
+    const RuntimeSettings& settings = m_pDevice->GetRuntimeSettings();
+
+    if (settings.enableMemoryEventLog &&
+        (m_file.Open(settings.memoryEventLogFile, Util::FileAccessAppend) == Util::Result::Success))
+    {
+        m_startTicks    = Util::GetPerfCpuTime();
+        m_perfFrequency = Util::GetPerfFrequency();
+
+        m_file.Printf("# device %p, start %llu ms\n",
+                      static_cast<const void*>(m_pDevice),
+                      static_cast<uint64_t>((m_startTicks * 1000) / m_perfFrequency));
+        m_file.Printf("timeUs,event,object,memory,size,offset,heap\n");
+
+        m_enabled = true;
+    }
+}
+
+// =====================================================================================================================
+// Writes the events still in the rings and closes the file.  No thread may record events anymore.
+void MemoryEventLog::Destroy()
+{
+    if (m_enabled)
+    {
+        m_enabled = false;
+
+        Util::MutexAuto lock(&m_lock);
+
+        m_rings.ForEach([this](ThreadRing* pRing) { WriteRing(pRing); });
+        m_rings.Reset();
+
+        m_file.Close();
+    }
+}
+
+// =====================================================================================================================
+// Adds an event to the ring of the calling thread, writing the ring out first if it is full.
+void MemoryEventLog::RecordEvent(
+    MemoryEventType type,
+    const void*     pObject,
+    const void*     pMemory,
+    Pal::gpusize    size,
+    Pal::gpusize    offset,
+    Pal::GpuHeap    heap)
+{
+    ThreadRing* pRing = m_rings.Get([](ThreadRing* pNew) { pNew->count = 0; });
+
+    if (pRing != nullptr)
+    {
+        if (pRing->count == RingSize)
+        {
+            Util::MutexAuto lock(&m_lock);
+
+            WriteRing(pRing);
+        }
+
+        Event* pEvent = &pRing->events[pRing->count++];
+
+        pEvent->timestamp = Util::GetPerfCpuTime();
+        pEvent->pObject   = pObject;
+        pEvent->pMemory   = pMemory;
+        pEvent->size      = size;
+        pEvent->offset    = offset;
+        pEvent->type      = type;
+        pEvent->heap      = heap;
+    }
+}
+
+// =====================================================================================================================
+// Appends the events of a ring to the file and empties it.  Must be called with m_lock held.
+void MemoryEventLog::WriteRing(
+    ThreadRing* pRing)
+{
+    const double usPerTick = 1000000.0 / m_perfFrequency;
+
+    for (uint32_t i = 0; i < pRing->count; ++i)
+    {
+        const Event& event = pRing->events[i];
+
+        const uint64_t timeUs = static_cast<uint64_t>((event.timestamp - m_startTicks) * usPerTick);
+
+        m_file.Printf("%llu,%s,%p,%p,%llu,%llu,%d\n",
+                      timeUs,
+                      EventNames[static_cast<uint32_t>(event.type)],
+                      event.pObject,
+                      event.pMemory,
+                      static_cast<uint64_t>(event.size),
+                      static_cast<uint64_t>(event.offset),
+                      (event.heap == Pal::GpuHeapCount) ? -1 : static_cast<int32_t>(event.heap));
+    }
+
+    pRing->count = 0;
+}
+
+} // namespace vk
@@ -0,0 +1,197 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  memory_residency_tracker.cpp
+* @brief Implementation of the tracker lowering the priority of idle VkDeviceMemory while over budget.
+***********************************************************************************************************************
+*/
+
+#include "include/memory_residency_tracker.h"
+#include "include/vk_device.h"
+#include "include/vk_memory.h"
+#include "include/vk_physical_device.h"
+
+#include "palInlineFuncs.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+MemoryResidencyTracker::MemoryResidencyTracker(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_submitsPerEpoch(0),
+    m_idleEpochs(0),
+    m_submitCount(0),
+    m_epoch(0),
+    m_pFirst(nullptr)
+{
+}
+
+// =====================================================================================================================
+void MemoryResidencyTracker::Init()
+{
+    const RuntimeSettings& settings = m_pDevice->GetRuntimeSettings();
+
+    // Priorities are per PAL device, and demoting them on one device of a group makes little sense
+    if (m_pDevice->NumPalDevices() == 1)
+    {
+        m_submitsPerEpoch = settings.residencyTrackerEpochSubmits;
+        m_idleEpochs      = Util::Max(settings.residencyTrackerIdleEpochs, 1u);
+    }
+}
+
+// =====================================================================================================================
+// Starts tracking a memory object which owns its PAL memory in a local heap.
+void MemoryResidencyTracker::Register(
+    Memory* pMemory)
+{
+    VK_ASSERT(IsEnabled());
+
+    Util::MutexAuto lock(&m_lock);
+
+    pMemory->m_lastUseEpoch   = m_epoch;
+    pMemory->m_pResidencyPrev = nullptr;
+    pMemory->m_pResidencyNext = m_pFirst;
+
+    if (m_pFirst != nullptr)
+    {
+        m_pFirst->m_pResidencyPrev = pMemory;
+    }
+
+    m_pFirst = pMemory;
+
+    pMemory->m_flags.residencyTracked = 1;
+}
+
+// =====================================================================================================================
+// Stops tracking a memory object, giving it its own priority back if it is demoted.
+void MemoryResidencyTracker::Unregister(
+    Memory* pMemory)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    if (pMemory->m_pResidencyPrev != nullptr)
+    {
+        pMemory->m_pResidencyPrev->m_pResidencyNext = pMemory->m_pResidencyNext;
+    }
+    else
+    {
+        m_pFirst = pMemory->m_pResidencyNext;
+    }
+
+    if (pMemory->m_pResidencyNext != nullptr)
+    {
+        pMemory->m_pResidencyNext->m_pResidencyPrev = pMemory->m_pResidencyPrev;
+    }
+
+    if (pMemory->m_flags.residencyDemoted)
+    {
+        pMemory->SetDemoted(false);
+    }
+
+    pMemory->m_flags.residencyTracked = 0;
+}
+
+// =====================================================================================================================
+// Records that a memory object is used in the current epoch.
+void MemoryResidencyTracker::Touch(
+    Memory* pMemory
+    ) const
+{
+    if (pMemory->m_flags.residencyTracked)
+    {
+        pMemory->m_lastUseEpoch = m_epoch;
+    }
+}
+
+// =====================================================================================================================
+// Counts a queue submission and runs an aging pass at the end of every epoch.
+void MemoryResidencyTracker::OnSubmit()
+{
+    if (IsEnabled() && ((Util::AtomicIncrement(&m_submitCount) % m_submitsPerEpoch) == 0))
+    {
+        Age();
+    }
+}
+
+// =====================================================================================================================
+// Returns true if the application uses more of a local heap than its budget.
+bool MemoryResidencyTracker::IsLocalMemoryOverBudget() const
+{
+    PhysicalDevice* pPhysicalDevice = m_pDevice->VkPhysicalDevice(DefaultDeviceIndex);
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+
+    pPhysicalDevice->GetMemoryBudgetProperties(&budget);
+
+    const VkPhysicalDeviceMemoryProperties& memoryProperties = pPhysicalDevice->GetMemoryProperties();
+
+    bool overBudget = false;
+
+    for (uint32_t heapIndex = 0; heapIndex < memoryProperties.memoryHeapCount; ++heapIndex)
+    {
+        if (((memoryProperties.memoryHeaps[heapIndex].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0) &&
+            (budget.heapUsage[heapIndex] > budget.heapBudget[heapIndex]))
+        {
+            overBudget = true;
+        }
+    }
+
+    return overBudget;
+}
+
+// =====================================================================================================================
+// Ends the current epoch.  Demotes allocations idle for too long while over budget and promotes the others back.
+void MemoryResidencyTracker::Age()
+{
+    Util::MutexAuto lock(&m_lock);
+
+    const uint32_t epoch      = m_epoch;
+    const bool     overBudget = IsLocalMemoryOverBudget();
+
+    for (Memory* pMemory = m_pFirst; pMemory != nullptr; pMemory = pMemory->m_pResidencyNext)
+    {
+        const bool idle = ((epoch - pMemory->m_lastUseEpoch) >= m_idleEpochs);
+
+        if (overBudget && idle)
+        {
+            if (pMemory->m_flags.residencyDemoted == 0)
+            {
+                pMemory->SetDemoted(true);
+            }
+        }
+        else if (pMemory->m_flags.residencyDemoted)
+        {
+            pMemory->SetDemoted(false);
+        }
+    }
+
+    m_epoch = epoch + 1;
+}
+
+} // namespace vk
@@ -0,0 +1,246 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  perf_counter_registry.cpp
+* @brief Implementation of the device-wide registry of driver performance counters and histograms.
+***********************************************************************************************************************
+*/
+
+#include "include/perf_counter_registry.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+
+#include "palJsonWriter.h"
+
+namespace vk
+{
+
+static const char* CounterNames[PerfCounterCount] =
+{
+    "pipelineUserCacheHits",
+    "pipelineInternalCacheHits",
+    "pipelinesCompiled",
+    "descriptorSetsLive",
+    "descriptorHeapBytes",
+    "descriptorAllocFailures",
+    "drawsRecorded",
+    "dispatchesRecorded",
+    "barriersRecorded",
+    "redundantStateFiltered",
+};
+
+static const char* HistogramNames[PerfHistogramCount] =
+{
+    "submitCpuTimeUs",
+    "pipelineCompileTimeUs",
+};
+
+thread_local uint32_t PerfCounterRegistry::s_shardIndex = UINT32_MAX;
+
+// =====================================================================================================================
+PerfCounterRegistry::PerfCounterRegistry(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_pShards(nullptr)
+{
+}
+
+// =====================================================================================================================
+// Allocates the shards if the registry is enabled.
+VkResult PerfCounterRegistry::Init()
+{
+    VkResult result = VK_SUCCESS;
+
+#if ICD_PERF_COUNTERS
+    if (m_pDevice->GetRuntimeSettings().enablePerfCounters)
+    {
+        m_pShards = m_pDevice->VkInstance()->AllocMem(ShardCount * ShardStride,
+                                                      64,
+                                                      VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+        if (m_pShards != nullptr)
+        {
+            // All members of the shards are lock-free atomics of integers, so zeroed memory holds zero counts.
+            memset(m_pShards, 0, ShardCount * ShardStride);
+        }
+        else
+        {
+            result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+#endif
+
+    return result;
+}
+
+// =====================================================================================================================
+// Frees the shards.  Nothing may report to the registry anymore.
+void PerfCounterRegistry::Destroy()
+{
+    if (m_pShards != nullptr)
+    {
+        m_pDevice->VkInstance()->FreeMem(m_pShards);
+        m_pShards = nullptr;
+    }
+}
+
+// =====================================================================================================================
+// Gives the calling thread a shard.  Threads take the shards in turn, which spreads the threads of a typical
+// application evenly; the index is shared by all registries.
+void PerfCounterRegistry::AssignShard()
+{
+    static std::atomic<uint32_t> s_nextShard(0);
+
+    s_shardIndex = s_nextShard.fetch_add(1, std::memory_order_relaxed) & (ShardCount - 1);
+}
+
+// =====================================================================================================================
+// Adds a sample to the calling thread's shard of a histogram.
+void PerfCounterRegistry::AddSample(
+    PerfHistogram histogram,
+    uint64_t      value)
+{
+    const uint32_t index  = static_cast<uint32_t>(histogram);
+    const uint32_t bucket = (value == 0) ? 0 :
+                            Util::Min(Util::Log2(value) + 1, PerfCounterSnapshot::BucketCount - 1);
+
+    Shard* pShard = GetShard();
+
+    pShard->sums[index].fetch_add(value, std::memory_order_relaxed);
+    pShard->buckets[index][bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+// =====================================================================================================================
+// Adds up the shards of every counter and histogram.  May be called from any thread while others report.
+void PerfCounterRegistry::Read(
+    PerfCounterSnapshot* pSnapshot
+    ) const
+{
+    memset(pSnapshot, 0, sizeof(*pSnapshot));
+
+    if (m_pShards != nullptr)
+    {
+        for (uint32_t shard = 0; shard < ShardCount; shard++)
+        {
+            const Shard* pShard = static_cast<const Shard*>(Util::VoidPtrInc(m_pShards, shard * ShardStride));
+
+            for (uint32_t counter = 0; counter < PerfCounterCount; counter++)
+            {
+                pSnapshot->counters[counter] += pShard->counters[counter].load(std::memory_order_relaxed);
+            }
+
+            for (uint32_t histogram = 0; histogram < PerfHistogramCount; histogram++)
+            {
+                PerfCounterSnapshot::Histogram* pHistogram = &pSnapshot->histograms[histogram];
+
+                pHistogram->sum += pShard->sums[histogram].load(std::memory_order_relaxed);
+
+                for (uint32_t bucket = 0; bucket < PerfCounterSnapshot::BucketCount; bucket++)
+                {
+                    const uint64_t count = pShard->buckets[histogram][bucket].load(std::memory_order_relaxed);
+
+                    pHistogram->buckets[bucket] += count;
+                    pHistogram->count           += count;
+                }
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Writes the counters as key/value pairs and each histogram as a map of its count, sum and non-empty buckets, keyed by
+// the upper bound of the bucket.
+void PerfCounterRegistry::Write(
+    Util::JsonWriter* pWriter
+    ) const
+{
+    PerfCounterSnapshot snapshot;
+
+    Read(&snapshot);
+
+    for (uint32_t counter = 0; counter < PerfCounterCount; counter++)
+    {
+        pWriter->KeyAndValue(CounterNames[counter], snapshot.counters[counter]);
+    }
+
+    for (uint32_t histogram = 0; histogram < PerfHistogramCount; histogram++)
+    {
+        const PerfCounterSnapshot::Histogram& data = snapshot.histograms[histogram];
+
+        pWriter->KeyAndBeginMap(HistogramNames[histogram], false);
+        pWriter->KeyAndValue("count", data.count);
+        pWriter->KeyAndValue("sum", data.sum);
+        pWriter->KeyAndBeginList("buckets", true);
+
+        for (uint32_t bucket = 0; bucket < PerfCounterSnapshot::BucketCount; bucket++)
+        {
+            if (data.buckets[bucket] > 0)
+            {
+                pWriter->BeginMap(true);
+                pWriter->KeyAndValue("upTo", GetBucketUpperBound(bucket));
+                pWriter->KeyAndValue("count", data.buckets[bucket]);
+                pWriter->EndMap();
+            }
+        }
+
+        pWriter->EndList();
+        pWriter->EndMap();
+    }
+}
+
+// =====================================================================================================================
+const char* PerfCounterRegistry::GetName(
+    PerfCounter counter)
+{
+    return CounterNames[static_cast<uint32_t>(counter)];
+}
+
+// =====================================================================================================================
+const char* PerfCounterRegistry::GetName(
+    PerfHistogram histogram)
+{
+    return HistogramNames[static_cast<uint32_t>(histogram)];
+}
+
+// =====================================================================================================================
+bool PerfCounterRegistry::IsGauge(
+    PerfCounter counter)
+{
+    return (counter == PerfCounter::DescriptorSetsLive) || (counter == PerfCounter::DescriptorHeapBytes);
+}
+
+// =====================================================================================================================
+// Returns the largest sample a histogram bucket counts, or UINT64_MAX for the last bucket.
+uint64_t PerfCounterRegistry::GetBucketUpperBound(
+    uint32_t bucket)
+{
+    return (bucket == 0)                                    ? 0 :
+           (bucket == (PerfCounterSnapshot::BucketCount - 1)) ? UINT64_MAX :
+                                                              ((uint64_t(1) << bucket) - 1);
+}
+
+} // namespace vk
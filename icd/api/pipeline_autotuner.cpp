@@ -0,0 +1,536 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_autotuner.cpp
+* @brief Implementation of the wave size and NGG culling autotuner for hot pipelines.
+***********************************************************************************************************************
+*/
+#include "include/pipeline_autotuner.h"
+#include "include/pipeline_stats_profile.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+#include "include/vk_physical_device.h"
+
+#include "palFile.h"
+#include "palHashMapImpl.h"
+#include "palJsonWriter.h"
+#include "palMetroHash.h"
+
+#include <string.h>
+
+namespace vk
+{
+
+// =====================================================================================================================
+PipelineAutotuner::PipelineAutotuner(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_enabled(false),
+    m_deviceId(0),
+    m_entries(64, pDevice->VkInstance()->Allocator()),
+    m_pipelines(256, pDevice->VkInstance()->Allocator()),
+    m_dirty(false)
+{
+}
+
+// =====================================================================================================================
+// Reads the records of previous runs.  Must be called before the shader optimizer builds its profiles.
+void PipelineAutotuner::Init()
+{
+    const RuntimeSettings& settings = m_pDevice->GetRuntimeSettings();
+
+    if (settings.enablePipelineAutotune                   &&
+        settings.enablePipelineStatsProfile               &&
+        (settings.pipelineAutotuneFile[0] != '\0')        &&
+        (m_entries.Init() == Util::Result::Success)       &&
+        (m_pipelines.Init() == Util::Result::Success))
+    {
+        m_deviceId = m_pDevice->VkPhysicalDevice(DefaultDeviceIndex)->PalProperties().deviceId;
+        m_enabled  = true;
+
+        Load();
+    }
+}
+
+// =====================================================================================================================
+// Picks up the hot pipelines of this run, settles the trials which have enough samples and saves the records for the
+// next run.  All command buffers must have handed in their samples.
+void PipelineAutotuner::Destroy()
+{
+    if (m_enabled)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        TrackHotPipelines();
+        ChooseWinners();
+        Save();
+
+        m_enabled = false;
+    }
+}
+
+// =====================================================================================================================
+uint64_t PipelineAutotuner::HashKey(
+    const PipelineOptimizerKey& pipelineKey)
+{
+    Util::MetroHash::Hash hash = {};
+    Util::MetroHash64::Hash(reinterpret_cast<const uint8_t*>(&pipelineKey), sizeof(pipelineKey), hash.bytes);
+
+    return Util::MetroHash::Compact64(&hash);
+}
+
+// =====================================================================================================================
+// Returns the last active stage of a pipeline, which is the stage the variants are applied to.
+ShaderStage PipelineAutotuner::GetTunedStage(
+    const PipelineOptimizerKey& pipelineKey)
+{
+    ShaderStage tunedStage = ShaderStage::ShaderStageVertex;
+
+    for (uint32_t stage = 0; stage < ShaderStageCount; ++stage)
+    {
+        if (pipelineKey.shaders[stage].codeSize != 0)
+        {
+            tunedStage = static_cast<ShaderStage>(stage);
+        }
+    }
+
+    return tunedStage;
+}
+
+// =====================================================================================================================
+// Returns the GPU time per shader invocation of a variant, which stays comparable between runs of different scenes.
+double PipelineAutotuner::GetCost(
+    const VariantStats& stats)
+{
+    return static_cast<double>(stats.gpuNs) / static_cast<double>(Util::Max(stats.invocations, uint64_t(1)));
+}
+
+// =====================================================================================================================
+// Returns the mask of the variants which can make a difference to a pipeline.  The wave size is tuned on the pixel or
+// compute shader, and NGG culling only where the primitives come straight from the vertex shader.
+uint32_t PipelineAutotuner::GetVariantMask(
+    const PipelineOptimizerKey& pipelineKey)
+{
+    const auto IsActive = [&pipelineKey](ShaderStage stage) { return (pipelineKey.shaders[stage].codeSize != 0); };
+
+    uint32_t mask = (1 << AutotuneVariantBaseline);
+
+    if (IsActive(ShaderStage::ShaderStageFragment) || IsActive(ShaderStage::ShaderStageCompute))
+    {
+        mask |= (1 << AutotuneVariantWave32) | (1 << AutotuneVariantWave64);
+    }
+
+    if (IsActive(ShaderStage::ShaderStageVertex)                  &&
+        (IsActive(ShaderStage::ShaderStageTessControl) == false) &&
+        (IsActive(ShaderStage::ShaderStageTessEval) == false)    &&
+        (IsActive(ShaderStage::ShaderStageGeometry) == false))
+    {
+        mask |= (1 << AutotuneVariantNggCulling);
+    }
+
+    return mask;
+}
+
+// =====================================================================================================================
+// Called for each stage while a pipeline's compile options are set up.  If the (so far filled in) key belongs to a
+// pipeline under trial, applies the variant the pipeline is timed with in this run.  All pipelines with the same key
+// get the same variant.
+void PipelineAutotuner::ApplyTrial(
+    const PipelineOptimizerKey& pipelineKey,
+    PipelineShaderOptionsPtr    options)
+{
+    if (m_enabled)
+    {
+        uint32_t variant = NoVariant;
+
+        {
+            Util::MutexAuto lock(&m_lock);
+
+            Entry* pEntry = m_entries.FindKey(HashKey(pipelineKey));
+
+            if ((pEntry != nullptr) && (pEntry->record.winner == NoVariant))
+            {
+                if (pEntry->trialVariant == NoVariant)
+                {
+                    uint32_t fewestSamples = UINT32_MAX;
+
+                    for (uint32_t i = 0; i < AutotuneVariantCount; ++i)
+                    {
+                        if (((pEntry->record.variantMask & (1 << i)) != 0) &&
+                            (pEntry->record.variants[i].samples < fewestSamples))
+                        {
+                            fewestSamples        = pEntry->record.variants[i].samples;
+                            pEntry->trialVariant = i;
+                        }
+                    }
+                }
+
+                variant = pEntry->trialVariant;
+            }
+        }
+
+        if ((variant == AutotuneVariantWave32) || (variant == AutotuneVariantWave64))
+        {
+            if (options.pOptions != nullptr)
+            {
+                options.pOptions->waveSize = (variant == AutotuneVariantWave32) ? 32 : 64;
+            }
+        }
+        else if (variant == AutotuneVariantNggCulling)
+        {
+            if (options.pNggState != nullptr)
+            {
+                options.pNggState->enableBackfaceCulling = true;
+                options.pNggState->enableFrustumCulling  = true;
+                options.pNggState->enableSmallPrimFilter = true;
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Remembers the optimizer key of a pipeline, so its samples can be attributed to the key's record.
+void PipelineAutotuner::RegisterPipeline(
+    uint64_t                    apiHash,
+    const PipelineOptimizerKey& pipelineKey)
+{
+    if (m_enabled)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        bool          existed = false;
+        PipelineInfo* pInfo   = nullptr;
+
+        if (m_pipelines.FindAllocate(apiHash, &existed, &pInfo) == Util::Result::Success)
+        {
+            if (existed == false)
+            {
+                pInfo->gpuNs = 0;
+            }
+
+            pInfo->keyHash = HashKey(pipelineKey);
+            pInfo->key     = pipelineKey;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Adds timed samples to the run totals of their pipelines, and to the variant their pipeline is under trial with.
+void PipelineAutotuner::RecordSamples(
+    const PipelineStatsSample* pSamples,
+    uint32_t                   sampleCount)
+{
+    // Counters of the vertex, pixel and compute shader invocations
+    constexpr uint32_t InvocationCounters[] = { 2, 7, 10 };
+
+    if (m_enabled)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        for (uint32_t i = 0; i < sampleCount; ++i)
+        {
+            const PipelineStatsSample& sample = pSamples[i];
+
+            PipelineInfo* pInfo = (sample.gpuNs > 0) ? m_pipelines.FindKey(sample.apiHash) : nullptr;
+
+            if (pInfo != nullptr)
+            {
+                pInfo->gpuNs += sample.gpuNs;
+
+                Entry* pEntry = m_entries.FindKey(pInfo->keyHash);
+
+                uint64_t invocations = 0;
+
+                for (uint32_t counter : InvocationCounters)
+                {
+                    invocations += sample.counters[counter];
+                }
+
+                if ((pEntry != nullptr) && (pEntry->trialVariant != NoVariant) && (invocations > 0))
+                {
+                    VariantStats* pStats = &pEntry->record.variants[pEntry->trialVariant];
+
+                    pStats->gpuNs       += sample.gpuNs;
+                    pStats->invocations += invocations;
+                    pStats->samples++;
+
+                    m_dirty = true;
+                }
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Adds a record for every pipeline of this run which took enough of the sampled GPU time.  Must be called with m_lock
+// held.
+void PipelineAutotuner::TrackHotPipelines()
+{
+    const uint32_t hotSharePermille = m_pDevice->GetRuntimeSettings().pipelineAutotuneHotSharePermille;
+
+    uint64_t totalNs = 0;
+
+    for (auto it = m_pipelines.Begin(); it.Get() != nullptr; it.Next())
+    {
+        totalNs += it.Get()->value.gpuNs;
+    }
+
+    for (auto it = m_pipelines.Begin(); (totalNs > 0) && (it.Get() != nullptr); it.Next())
+    {
+        const PipelineInfo& info = it.Get()->value;
+
+        const uint32_t variantMask = GetVariantMask(info.key);
+
+        if (((info.gpuNs * 1000) >= (totalNs * hotSharePermille))   &&
+            (variantMask != (1 << AutotuneVariantBaseline))         &&
+            (m_entries.GetNumEntries() < MaxRecords))
+        {
+            bool   existed = false;
+            Entry* pEntry  = nullptr;
+
+            if ((m_entries.FindAllocate(info.keyHash, &existed, &pEntry) == Util::Result::Success) &&
+                (existed == false))
+            {
+                memset(pEntry, 0, sizeof(*pEntry));
+
+                pEntry->record.key         = info.key;
+                pEntry->record.variantMask = variantMask;
+                pEntry->record.winner      = NoVariant;
+                pEntry->trialVariant       = NoVariant;
+
+                m_dirty = true;
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Settles every trial whose variants all have enough samples.  Must be called with m_lock held.
+void PipelineAutotuner::ChooseWinners()
+{
+    const uint32_t minSamples = Util::Max(m_pDevice->GetRuntimeSettings().pipelineAutotuneMinSamples, 1u);
+
+    for (auto it = m_entries.Begin(); it.Get() != nullptr; it.Next())
+    {
+        Record* pRecord = &it.Get()->value.record;
+
+        bool complete = (pRecord->winner == NoVariant);
+
+        for (uint32_t i = 0; complete && (i < AutotuneVariantCount); ++i)
+        {
+            complete = ((pRecord->variantMask & (1 << i)) == 0) || (pRecord->variants[i].samples >= minSamples);
+        }
+
+        if (complete)
+        {
+            const auto CostOf = [pRecord](uint32_t variant) { return GetCost(pRecord->variants[variant]); };
+
+            const double baselineCost = CostOf(AutotuneVariantBaseline);
+
+            uint32_t winner     = AutotuneVariantBaseline;
+            double   winnerCost = (baselineCost * (100 - MinGainPercent)) / 100;
+
+            for (uint32_t i = AutotuneVariantBaseline + 1; i < AutotuneVariantCount; ++i)
+            {
+                if (((pRecord->variantMask & (1 << i)) != 0) && (CostOf(i) < winnerCost))
+                {
+                    winner     = i;
+                    winnerCost = CostOf(i);
+                }
+            }
+
+            pRecord->winner = winner;
+
+            m_dirty = true;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Writes the key and winning variant of up to maxCount settled pipelines whose winner isn't the baseline, and returns
+// their number.
+uint32_t PipelineAutotuner::GetTunedPipelines(
+    uint32_t              maxCount,
+    PipelineOptimizerKey* pKeys,
+    AutotuneVariant*      pVariants
+    ) const
+{
+    uint32_t count = 0;
+
+    if (m_enabled)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        for (auto it = m_entries.Begin(); (count < maxCount) && (it.Get() != nullptr); it.Next())
+        {
+            const Record& record = it.Get()->value.record;
+
+            if ((record.winner != NoVariant) && (record.winner != AutotuneVariantBaseline))
+            {
+                pKeys[count]     = record.key;
+                pVariants[count] = static_cast<AutotuneVariant>(record.winner);
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+// =====================================================================================================================
+// Writes the settled pipelines whose winner isn't the baseline, with the gain measured over the baseline, so that
+// winners worth keeping for all users can be turned into shader profile entries.
+void PipelineAutotuner::Write(
+    Util::JsonWriter* pWriter) const
+{
+    static const char* StageNames[ShaderStageCount]      = { "vs", "hs", "ds", "gs", "ps", "cs" };
+    static const char* VariantNames[AutotuneVariantCount] = { "baseline", "wave32", "wave64", "nggCulling" };
+
+    if (m_enabled)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        pWriter->KeyAndBeginList("tunedPipelines", false);
+
+        for (auto it = m_entries.Begin(); it.Get() != nullptr; it.Next())
+        {
+            const Record& record = it.Get()->value.record;
+
+            if ((record.winner != NoVariant) && (record.winner != AutotuneVariantBaseline))
+            {
+                const double baselineCost = GetCost(record.variants[AutotuneVariantBaseline]);
+                const double winnerCost   = GetCost(record.variants[record.winner]);
+
+                pWriter->BeginMap(true);
+                pWriter->KeyAndValue("variant", VariantNames[record.winner]);
+                pWriter->KeyAndValue("tunedStage", StageNames[GetTunedStage(record.key)]);
+                pWriter->KeyAndValue("gainPercent", (baselineCost > 0.0) ?
+                                     static_cast<uint32_t>(((baselineCost - winnerCost) * 100) / baselineCost) : 0u);
+                pWriter->KeyAndValue("samples", record.variants[AutotuneVariantBaseline].samples +
+                                                record.variants[record.winner].samples);
+                pWriter->KeyAndBeginMap("shaders", true);
+
+                for (uint32_t stage = 0; stage < ShaderStageCount; ++stage)
+                {
+                    const ShaderOptimizerKey& shaderKey = record.key.shaders[stage];
+
+                    if (shaderKey.codeSize != 0)
+                    {
+                        char codeHashString[36];
+                        Util::Snprintf(codeHashString, sizeof(codeHashString), "0x%016llX %016llX",
+                                       shaderKey.codeHash.upper, shaderKey.codeHash.lower);
+
+                        pWriter->KeyAndValue(StageNames[stage], codeHashString);
+                    }
+                }
+
+                pWriter->EndMap();
+                pWriter->EndMap();
+            }
+        }
+
+        pWriter->EndList();
+    }
+}
+
+// =====================================================================================================================
+// A missing, truncated or foreign file just leaves fewer records.
+void PipelineAutotuner::Load()
+{
+    const char* pFilePath = m_pDevice->GetRuntimeSettings().pipelineAutotuneFile;
+
+    Util::File file;
+    FileHeader header    = {};
+    size_t     bytesRead = 0;
+
+    if (Util::File::Exists(pFilePath) &&
+        (file.Open(pFilePath, Util::FileAccessRead | Util::FileAccessBinary) == Util::Result::Success))
+    {
+        if ((file.Read(&header, sizeof(header), &bytesRead) == Util::Result::Success) &&
+            (bytesRead == sizeof(header))                                            &&
+            (header.magic == FileMagic)                                              &&
+            (header.version == FileVersion)                                          &&
+            (header.deviceId == m_deviceId)                                          &&
+            (header.recordSize == sizeof(Record)))
+        {
+            const uint32_t entryCount = Util::Min(header.entryCount, MaxRecords);
+
+            Util::MutexAuto lock(&m_lock);
+
+            for (uint32_t i = 0; i < entryCount; i++)
+            {
+                Entry entry = {};
+
+                if ((file.Read(&entry.record, sizeof(Record), &bytesRead) != Util::Result::Success) ||
+                    (bytesRead != sizeof(Record)))
+                {
+                    break;
+                }
+
+                entry.trialVariant = NoVariant;
+
+                m_entries.Insert(HashKey(entry.record.key), entry);
+            }
+        }
+
+        file.Close();
+    }
+}
+
+// =====================================================================================================================
+// Rewrites the file if any record changed during this run.  Must be called with m_lock held.
+void PipelineAutotuner::Save()
+{
+    const char* pFilePath = m_pDevice->GetRuntimeSettings().pipelineAutotuneFile;
+
+    Util::File file;
+
+    if (m_dirty && (file.Open(pFilePath, Util::FileAccessWrite | Util::FileAccessBinary) == Util::Result::Success))
+    {
+        FileHeader header = {};
+        header.magic      = FileMagic;
+        header.version    = FileVersion;
+        header.deviceId   = m_deviceId;
+        header.entryCount = m_entries.GetNumEntries();
+        header.recordSize = sizeof(Record);
+
+        Util::Result result = file.Write(&header, sizeof(header));
+
+        for (auto it = m_entries.Begin(); (result == Util::Result::Success) && (it.Get() != nullptr); it.Next())
+        {
+            result = file.Write(&it.Get()->value.record, sizeof(Record));
+        }
+
+        VK_ALERT(result != Util::Result::Success);
+
+        file.Close();
+
+        m_dirty = false;
+    }
+}
+
+} // namespace vk
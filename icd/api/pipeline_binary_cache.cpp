@@ -30,26 +30,42 @@
 */
 #include "include/pipeline_binary_cache.h"
 #include "include/binary_cache_serialization.h"
+#include "include/compile_thread_pool.h"
+#include "include/shared_memory_cache_layer.h"
+#include "include/vk_alloccb.h"
 
 #include "palArchiveFile.h"
 #include "palAutoBuffer.h"
 #include "palPlatformKey.h"
 #include "palSysMemory.h"
+#include "palSysUtil.h"
 #include "palVectorImpl.h"
 #include "palHashMapImpl.h"
+#include "palHashSetImpl.h"
 #include "palFile.h"
 
 #if ICD_GPUOPEN_DEVMODE_BUILD
 #include "palPipelineAbiReader.h"
 #include "devmode/devmode_mgr.h"
 #endif
+#include <algorithm>
 #include <string.h>
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
 namespace vk
 {
 constexpr char   PipelineBinaryCache::EnvVarPath[];
 constexpr char   PipelineBinaryCache::EnvVarFileName[];
 constexpr char   PipelineBinaryCache::EnvVarReadOnlyFileName[];
+constexpr char   PipelineBinaryCache::EnvVarMappedFileName[];
 
 static constexpr char   ArchiveTypeString[]  = "VK_SHADER_PIPELINE_CACHE";
 static constexpr size_t ArchiveTypeStringLen = sizeof(ArchiveTypeString);
@@ -64,8 +80,8 @@ static Util::Hash128 ParseHash128(const char* str);
 #endif
 
 bool PipelineBinaryCache::IsValidBlob(
-    VkAllocationCallbacks* pAllocationCallbacks,
-    Util::IPlatformKey*    pKey,
+    VkAllocationCallbacks*    pAllocationCallbacks,
+    const Util::IPlatformKey* pKey,
     size_t                 dataSize,
     const void*            pData)
 {
@@ -98,7 +114,48 @@ bool PipelineBinaryCache::IsValidBlob(
 }
 
 // =====================================================================================================================
-// Allocate and initialize a PipelineBinaryCache object
+// Checks that a blob (without the public Vulkan header) consists of a private header followed by whole entries, without
+// hashing it.  This is only a cheap sanity check; blobs accepted by it must still be validated with IsValidBlob()
+// before their entries may be used, see StartInitialDataValidation().
+bool PipelineBinaryCache::IsValidBlobLayout(
+    size_t      dataSize,
+    const void* pData)
+{
+    VK_ASSERT(pData != nullptr);
+
+    constexpr size_t EntrySize = sizeof(BinaryCacheEntry);
+
+    bool isValid = false;
+
+    if (dataSize > (sizeof(PipelineBinaryCachePrivateHeader) + EntrySize))
+    {
+        const void* pBlob    = Util::VoidPtrInc(pData, sizeof(PipelineBinaryCachePrivateHeader));
+        size_t      blobSize = dataSize - sizeof(PipelineBinaryCachePrivateHeader);
+
+        while (blobSize >= EntrySize)
+        {
+            const BinaryCacheEntry* pEntry     = static_cast<const BinaryCacheEntry*>(pBlob);
+            const size_t            storedSize = GetBinaryCacheEntryStoredSize(*pEntry);
+
+            if ((storedSize == 0) || (storedSize > (blobSize - EntrySize)))
+            {
+                break;
+            }
+
+            pBlob     = Util::VoidPtrInc(pBlob, EntrySize + storedSize);
+            blobSize -= EntrySize + storedSize;
+        }
+
+        // Serialized blobs are made of whole entries only, so anything left over means this isn't one.
+        isValid = (blobSize == 0);
+    }
+
+    return isValid;
+}
+
+// =====================================================================================================================
+// Allocate and initialize a PipelineBinaryCache object.  If initDataValidated is false, only the layout of the initial
+// data has been checked and its hash is verified in the background.
 PipelineBinaryCache* PipelineBinaryCache::Create(
     VkAllocationCallbacks*    pAllocationCallbacks,
     Util::IPlatformKey*       pKey,
@@ -110,7 +167,9 @@ PipelineBinaryCache* PipelineBinaryCache::Create(
 #endif
     size_t                    initDataSize,
     const void*               pInitData,
-    bool                      createArchiveLayers
+    bool                      initDataValidated,
+    bool                      createArchiveLayers,
+    CompileThreadPool*        pThreadPool
     )
 {
     VK_ASSERT(pAllocationCallbacks != nullptr);
@@ -136,37 +195,271 @@ PipelineBinaryCache* PipelineBinaryCache::Create(
         else if ((pInitData != nullptr) &&
                  (initDataSize > (sizeof(BinaryCacheEntry) + sizeof(PipelineBinaryCachePrivateHeader))))
         {
-            const void* pBlob           = pInitData;
-            size_t   blobSize           = initDataSize;
-            constexpr size_t EntrySize  = sizeof(BinaryCacheEntry);
+            pObj->LoadInitialData(initDataSize, pInitData, initDataValidated, pThreadPool);
+        }
+    }
+    return pObj;
+}
+
+// =====================================================================================================================
+// Payload shared by the tasks which decompress the compressed entries of the initial data.
+struct PipelineBinaryCache::DecompressBatch
+{
+    PipelineBinaryCache*            pCache;
+    const BinaryCacheEntry* const*  ppEntries;
+};
+
+// =====================================================================================================================
+// Decompresses one compressed entry of the initial data and stores the result in the cache.  Entries which fail to
+// decompress are dropped; the pipeline will simply be compiled again.
+void PipelineBinaryCache::DecompressEntryTask(
+    void*    pPayload,
+    uint32_t taskIndex)
+{
+    const DecompressBatch*  pBatch = static_cast<const DecompressBatch*>(pPayload);
+    PipelineBinaryCache*    pCache = pBatch->pCache;
+    const BinaryCacheEntry* pEntry = pBatch->ppEntries[taskIndex];
+    const void*             pData  = Util::VoidPtrInc(pEntry, sizeof(BinaryCacheEntry));
+
+    size_t       binarySize = 0;
+    Util::Result result     = GetBinaryCacheEntryDecompressedSize(pEntry, pData, &binarySize);
+    void*        pBinary    = nullptr;
+
+    if ((result == Util::Result::Success) && (binarySize > 0))
+    {
+        pBinary = pCache->AllocMem(binarySize);
+        result  = (pBinary != nullptr) ? Util::Result::Success : Util::Result::ErrorOutOfMemory;
+    }
+
+    if (pBinary != nullptr)
+    {
+        if (result == Util::Result::Success)
+        {
+            result = DecompressBinaryCacheEntry(pEntry, pData, binarySize, pBinary);
+        }
+
+        if (result == Util::Result::Success)
+        {
+            pCache->StorePipelineBinary(&pEntry->hashId, binarySize, pBinary);
+        }
+
+        pCache->FreeMem(pBinary);
+    }
+}
+
+// =====================================================================================================================
+// Populates the cache from a serialized blob (without the public Vulkan header).  Uncompressed entries are stored
+// directly while walking the blob; compressed entries are collected and then decompressed in parallel on the thread
+// pool, if one is available.  Unvalidated blobs are loaded all the same, but their entries are remembered so that
+// lookups can wait for the background validation.
+void PipelineBinaryCache::LoadInitialData(
+    size_t              initDataSize,
+    const void*         pInitData,
+    bool                initDataValidated,
+    CompileThreadPool*  pThreadPool)
+{
+    using EntryVector = Util::Vector<const BinaryCacheEntry*, 64, PalAllocator>;
 
-            pBlob         = Util::VoidPtrInc(pBlob, sizeof(PipelineBinaryCachePrivateHeader));
-            blobSize     -= sizeof(PipelineBinaryCachePrivateHeader);
-            while (blobSize > EntrySize)
+    EntryVector      compressedEntries(&m_palAllocator);
+    const void*      pBlob      = pInitData;
+    size_t           blobSize   = initDataSize;
+    constexpr size_t EntrySize  = sizeof(BinaryCacheEntry);
+
+    if (initDataValidated == false)
+    {
+        // The validation thread allocates through the cache's callbacks while hashing, frees its copy of the blob and
+        // evicts bad entries.  Application callbacks may only be called from the thread issuing the command.
+        if ((allocator::IsDriverAllocCallbacks(m_pAllocationCallbacks) == false) ||
+            (m_initDataIds.Init() != Util::Result::Success))
+        {
+            // Can't validate in the background or track the entries, so validate up front instead.
+            if (IsValidBlob(m_pAllocationCallbacks, m_pPlatformKey, initDataSize, pInitData) == false)
             {
-                const BinaryCacheEntry* pEntry  = static_cast<const BinaryCacheEntry*>(pBlob);
-                const void*             pData   = Util::VoidPtrInc(pBlob, sizeof(BinaryCacheEntry));
-                const size_t entryAndDataSize   = pEntry->dataSize + sizeof(BinaryCacheEntry);
+                return;
+            }
 
-                if (blobSize >= entryAndDataSize)
-                {
-                    //add to cache
-                    Util::Result result = pObj->StorePipelineBinary(&pEntry->hashId, pEntry->dataSize, pData);
-                    if (result != Util::Result::Success)
-                    {
-                        break;
-                    }
-                    pBlob = Util::VoidPtrInc(pBlob, entryAndDataSize);
-                    blobSize -= entryAndDataSize;
-                }
-                else
-                {
-                    break;
-                }
+            initDataValidated = true;
+        }
+    }
+
+    pBlob         = Util::VoidPtrInc(pBlob, sizeof(PipelineBinaryCachePrivateHeader));
+    blobSize     -= sizeof(PipelineBinaryCachePrivateHeader);
+    while (blobSize > EntrySize)
+    {
+        const BinaryCacheEntry* pEntry  = static_cast<const BinaryCacheEntry*>(pBlob);
+        const void*             pData   = Util::VoidPtrInc(pBlob, sizeof(BinaryCacheEntry));
+        const size_t storedSize         = GetBinaryCacheEntryStoredSize(*pEntry);
+        const size_t entryAndDataSize   = storedSize + sizeof(BinaryCacheEntry);
+
+        if (blobSize >= entryAndDataSize)
+        {
+            Util::Result result = Util::Result::Success;
+
+            // Entries which can't be tracked can't be loaded before the blob is validated.
+            if (initDataValidated == false)
+            {
+                result = m_initDataIds.Insert(pEntry->hashId);
+            }
+
+            if (result != Util::Result::Success)
+            {
+                break;
+            }
+
+            if (IsCompressedBinaryCacheEntry(*pEntry))
+            {
+                result = compressedEntries.PushBack(pEntry);
             }
+            else
+            {
+                //add to cache
+                result = StorePipelineBinary(&pEntry->hashId, storedSize, pData);
+            }
+
+            if (result != Util::Result::Success)
+            {
+                break;
+            }
+            pBlob = Util::VoidPtrInc(pBlob, entryAndDataSize);
+            blobSize -= entryAndDataSize;
+        }
+        else
+        {
+            break;
         }
     }
-    return pObj;
+
+    const uint32_t compressedCount = compressedEntries.NumElements();
+
+    if (compressedCount > 0)
+    {
+        DecompressBatch batch = {};
+        batch.pCache    = this;
+        batch.ppEntries = &compressedEntries.Front();
+
+        if ((pThreadPool != nullptr) && (compressedCount > 1))
+        {
+            pThreadPool->Execute(DecompressEntryTask, &batch, compressedCount);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < compressedCount; ++i)
+            {
+                DecompressEntryTask(&batch, i);
+            }
+        }
+    }
+
+    if (initDataValidated == false)
+    {
+        StartInitialDataValidation(initDataSize, pInitData);
+    }
+}
+
+// =====================================================================================================================
+// Hashes a copy of the initial data on a background thread.  The application's blob is only valid during
+// vkCreatePipelineCache(), but copying it is much cheaper than hashing it.  If no thread can be started, the blob is
+// validated right away.
+void PipelineBinaryCache::StartInitialDataValidation(
+    size_t      initDataSize,
+    const void* pInitData)
+{
+    Util::EventCreateFlags flags = {};
+    flags.manualReset       = true;
+    flags.initiallySignaled = false;
+
+    void* pCopy = AllocMem(initDataSize);
+
+    if ((pCopy != nullptr) && (m_initDataEvent.Init(flags) == Util::Result::Success))
+    {
+        memcpy(pCopy, pInitData, initDataSize);
+
+        m_pInitDataCopy    = pCopy;
+        m_initDataCopySize = initDataSize;
+        m_initDataState.store(InitDataPending, std::memory_order_release);
+
+        m_initDataThreadStarted = (m_initDataThread.Begin(InitDataValidationThreadFunc, this) == Util::Result::Success);
+    }
+
+    if (m_initDataThreadStarted == false)
+    {
+        FreeMem(pCopy);
+
+        m_pInitDataCopy    = nullptr;
+        m_initDataCopySize = 0;
+
+        FinishInitialDataValidation(IsValidBlob(m_pAllocationCallbacks, m_pPlatformKey, initDataSize, pInitData));
+    }
+}
+
+// =====================================================================================================================
+void PipelineBinaryCache::InitDataValidationThreadFunc(
+    void* pParam)
+{
+    PipelineBinaryCache* pCache = static_cast<PipelineBinaryCache*>(pParam);
+
+    const bool isValid = IsValidBlob(pCache->m_pAllocationCallbacks,
+                                     pCache->m_pPlatformKey,
+                                     pCache->m_initDataCopySize,
+                                     pCache->m_pInitDataCopy);
+
+    pCache->FreeMem(pCache->m_pInitDataCopy);
+
+    pCache->m_pInitDataCopy    = nullptr;
+    pCache->m_initDataCopySize = 0;
+
+    pCache->FinishInitialDataValidation(isValid);
+
+    pCache->m_initDataEvent.Set();
+}
+
+// =====================================================================================================================
+// Publishes the result of the initial data validation.  If the hash didn't match, every entry loaded from the blob is
+// marked bad and evicted first, so that none of them is ever handed out or serialized again.
+void PipelineBinaryCache::FinishInitialDataValidation(
+    bool isValid)
+{
+    if (isValid == false)
+    {
+        for (auto it = m_initDataIds.Begin(); it.Get() != nullptr; it.Next())
+        {
+            Util::QueryResult query = {};
+            query.hashId = it.Get()->key;
+
+            MarkEntryBad(&query);
+            EvictEntry(&query);
+        }
+    }
+
+    // Lookups which see the final state must also see the entries marked bad above.
+    m_initDataState.store(isValid ? InitDataValid : InitDataInvalid, std::memory_order_release);
+}
+
+// =====================================================================================================================
+// Blocks until the initial data has been validated if the entry came from it, or for any entry if pCacheId is null.
+// Returns immediately once validation has finished.
+void PipelineBinaryCache::WaitForInitialDataValidation(
+    const CacheId* pCacheId) const
+{
+    if (IsInitialDataPending() &&
+        ((pCacheId == nullptr) || const_cast<CacheIdSet&>(m_initDataIds).Contains(*pCacheId)))
+    {
+        while (IsInitialDataPending())
+        {
+            m_initDataEvent.Wait(1.0f);
+        }
+    }
+}
+
+// =====================================================================================================================
+void PipelineBinaryCache::DestroyInitialDataValidation()
+{
+    if (m_initDataThreadStarted)
+    {
+        m_initDataThread.Join();
+
+        m_initDataThreadStarted = false;
+    }
 }
 
 // =====================================================================================================================
@@ -184,19 +477,85 @@ PipelineBinaryCache::PipelineBinaryCache(
     m_hashMapping          { 32, &m_palAllocator },
 #endif
     m_pMemoryLayer         { nullptr },
+    m_pSharedLayer         { nullptr },
     m_pArchiveLayer        { nullptr },
     m_openFiles            { &m_palAllocator },
     m_archiveLayers        { &m_palAllocator },
-    m_pCacheAdapter        { nullptr }
+    m_pCacheAdapter        { nullptr },
+    m_compressOnSerialize  { false },
+    m_dedupShaders         { false },
+    m_writeBackEnabled     { false },
+    m_writeBackStop        { false },
+    m_pWriteBackHead       { nullptr },
+    m_pWriteBackTail       { nullptr },
+    m_prewarmEnabled       { false },
+    m_prewarmIds           { &m_palAllocator },
+    m_prewarmIdSet         { 1024, &m_palAllocator },
+    m_prewarmLoadedCount   { 0 },
+    m_prewarmDirty         { false },
+    m_prewarmStarted       { 0 },
+    m_prewarmStop          { false },
+    m_costDb               { &m_palAllocator },
+    m_initDataState        { InitDataValid },
+    m_initDataIds          { 1024, &m_palAllocator },
+    m_pInitDataCopy        { nullptr },
+    m_initDataCopySize     { 0 },
+    m_initDataThreadStarted { false },
+    m_cleanUpStarted       { false },
+    m_cleanUpStop          { false },
+    m_cleanUpBudget        { 0 },
+    m_cleanUpMinAge        { 0 },
+    m_pMappedArchive       { nullptr },
+    m_mappedArchiveSize    { 0 },
+    m_mappedEntries        { 1024, &m_palAllocator },
+    m_memoryBudget         { 0 },
+    m_lruNodes             { 1024, &m_palAllocator },
+    m_pLruHead             { nullptr },
+    m_pLruTail             { nullptr },
+    m_lruDataSize          { 0 },
+    m_hitCount             { 0 },
+    m_missCount            { 0 },
+    m_evictCount           { 0 },
+    m_memoryHitCount       { 0 },
+    m_sharedHitCount       { 0 },
+    m_archiveHitCount      { 0 },
+    m_mappedHitCount       { 0 },
+    m_dedupStoreCount      { 0 },
+    m_dedupByteCount       { 0 },
+    m_incrementalSerialize { false },
+    m_serializedBlobStale  { false },
+    m_dirtyEntries         { &m_palAllocator },
+    m_serializedIds        { 1024, &m_palAllocator },
+    m_pSerializedBlob      { nullptr },
+    m_serializedBlobSize   { 0 },
+    m_serializedBlobCapacity { 0 },
+    m_pSerializedHashContext { nullptr },
+    m_pSerializedHashMem   { nullptr }
 {
     // Without copy constructor, a class type variable can't be initialized in initialization list with gcc 4.8.5.
     // Initialize m_gfxIp here instead to make gcc 4.8.5 work.
     m_gfxIp = gfxIp;
+
+    m_prewarmManifestPath[0] = '\0';
+    m_cleanUpPath[0]         = '\0';
+    m_cleanUpKeepPrefix[0]   = '\0';
 }
 
 // =====================================================================================================================
 PipelineBinaryCache::~PipelineBinaryCache()
 {
+    DestroyCacheDirCleanUp();
+
+    // The prewarm and validation threads query the layers, so they have to stop first.
+    DestroyPrewarm();
+
+    DestroyInitialDataValidation();
+
+    m_costDb.Destroy();
+
+    // Pending binaries must reach the archives before the layers go away.
+    DestroyWriteBack();
+
     if (m_pCacheAdapter != nullptr)
     {
         m_pCacheAdapter->Destroy();
@@ -219,6 +578,14 @@ PipelineBinaryCache::~PipelineBinaryCache()
 
     m_archiveLayers.Clear();
 
+    if (m_pSharedLayer != nullptr)
+    {
+        m_pSharedLayer->Destroy();
+        m_pSharedLayer = nullptr;
+    }
+
+    DestroyLruNodes();
+
     if (m_pMemoryLayer != nullptr)
     {
         m_pMemoryLayer->Destroy();
@@ -231,6 +598,10 @@ PipelineBinaryCache::~PipelineBinaryCache()
         m_pReinjectionLayer->Destroy();
     }
 #endif
+
+    DestroyMappedArchive();
+
+    DestroyIncrementalSerialize();
 }
 
 // =====================================================================================================================
@@ -268,16 +639,134 @@ Util::Result PipelineBinaryCache::QueryPipelineBinary(
 {
     VK_ASSERT(m_pTopLayer != nullptr);
 
+    WaitForInitialDataValidation(pCacheId);
+
+    const MappedEntry* pMappedEntry = FindMappedEntry(pCacheId);
+
+    if (pMappedEntry != nullptr)
+    {
+        // Mapped entries are always ready and never need a reference.
+        memset(pQuery, 0, sizeof(*pQuery));
+        pQuery->hashId             = *pCacheId;
+        pQuery->dataSize           = pMappedEntry->dataSize;
+        pQuery->context.pEntryInfo = const_cast<MappedEntry*>(pMappedEntry);
+
+        Util::AtomicIncrement64(&m_hitCount);
+        Util::AtomicIncrement64(&m_mappedHitCount);
+
+        return Util::Result::Success;
+    }
+
     uint32_t policy = Util::ICacheLayer::LinkPolicy::LoadOnQuery;
     // We have to make sure the Query is atomic, otherwise we could get unexpected result while running multi-thread
     // test case.
     m_entriesMutex.Lock();
     Util::Result result = m_pTopLayer->Query(pCacheId, policy, flags, pQuery);
+
+    const bool acquiredRef = ((flags & Util::ICacheLayer::QueryFlags::AcquireEntryRef) != 0) &&
+                             ((result == Util::Result::Success)  ||
+                              (result == Util::Result::Reserved) ||
+                              (result == Util::Result::NotReady));
+
+    // The entry is touched under the same lock as the query so that it can't be evicted before its reference is
+    // recorded.
+    if (IsMemoryBudgetEnabled() && ((result == Util::Result::Success) || acquiredRef))
+    {
+        TouchLruEntry(pCacheId, (result == Util::Result::Success) ? pQuery->dataSize : 0, acquiredRef);
+
+        // Hits in the archive layers are copied into the memory layer.
+        EnforceMemoryBudget();
+    }
     m_entriesMutex.Unlock();
 
+    Util::AtomicIncrement64((result == Util::Result::Success) ? &m_hitCount : &m_missCount);
+
+    if (result == Util::Result::Success)
+    {
+        CountHit(pQuery);
+    }
+
     return result;
 }
 
+// =====================================================================================================================
+// Queries a batch of binaries in one pass: the entries mutex is taken once and the memory budget is enforced once.  Hits
+// in the archive layers are copied into the memory layer like in QueryPipelineBinary(), so querying the binaries a
+// batch create call is going to load prefetches all of them before the individual loads run.  pResults[i] receives the
+// result QueryPipelineBinary() would have returned for entry i.  The hit statistics are left to those loads, so that
+// prefetched entries aren't counted twice.
+// Must call ReleaseCacheRef() on every referenced entry when the flags contains AcquireEntryRef
+void PipelineBinaryCache::QueryPipelineBinaries(
+    uint32_t           count,
+    const CacheId*     pCacheIds,
+    uint32_t           flags,
+    Util::QueryResult* pQueries,
+    Util::Result*      pResults)
+{
+    VK_ASSERT(m_pTopLayer != nullptr);
+
+    const uint32_t policy     = Util::ICacheLayer::LinkPolicy::LoadOnQuery;
+    const bool     acquireRef = ((flags & Util::ICacheLayer::QueryFlags::AcquireEntryRef) != 0);
+
+    for (uint32_t i = 0; (i < count) && IsInitialDataPending(); ++i)
+    {
+        WaitForInitialDataValidation(&pCacheIds[i]);
+    }
+
+    bool queryLayers = false;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const MappedEntry* pMappedEntry = FindMappedEntry(&pCacheIds[i]);
+
+        memset(&pQueries[i], 0, sizeof(pQueries[i]));
+
+        if (pMappedEntry != nullptr)
+        {
+            pQueries[i].hashId             = pCacheIds[i];
+            pQueries[i].dataSize           = pMappedEntry->dataSize;
+            pQueries[i].context.pEntryInfo = const_cast<MappedEntry*>(pMappedEntry);
+
+            pResults[i] = Util::Result::Success;
+        }
+        else
+        {
+            pResults[i] = Util::Result::NotFound;
+            queryLayers = true;
+        }
+    }
+
+    if (queryLayers)
+    {
+        Util::MutexAuto lock(&m_entriesMutex);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (IsMappedQuery(&pQueries[i]) == false)
+            {
+                pResults[i] = m_pTopLayer->Query(&pCacheIds[i], policy, flags, &pQueries[i]);
+
+                const bool acquiredRef = acquireRef &&
+                                         ((pResults[i] == Util::Result::Success)  ||
+                                          (pResults[i] == Util::Result::Reserved) ||
+                                          (pResults[i] == Util::Result::NotReady));
+
+                if (IsMemoryBudgetEnabled() && ((pResults[i] == Util::Result::Success) || acquiredRef))
+                {
+                    TouchLruEntry(&pCacheIds[i],
+                                  (pResults[i] == Util::Result::Success) ? pQueries[i].dataSize : 0,
+                                  acquiredRef);
+                }
+            }
+        }
+
+        if (IsMemoryBudgetEnabled())
+        {
+            EnforceMemoryBudget();
+        }
+    }
+}
+
 // =====================================================================================================================
 // Query if a pipeline binary exists in cache
 // Must call ReleaseCacheRef() when the flags contains AcquireEntryRef
@@ -286,10 +775,11 @@ Util::Result PipelineBinaryCache::WaitPipelineBinary(
 {
     VK_ASSERT(m_pTopLayer != nullptr);
 
-    return m_pTopLayer->WaitForEntry(pCacheId);
+    return (FindMappedEntry(pCacheId) != nullptr) ? Util::Result::Success : m_pTopLayer->WaitForEntry(pCacheId);
 }
 // =====================================================================================================================
-// Attempt to load a graphics pipeline binary from cache
+// Attempt to load a graphics pipeline binary from cache.  Binaries served from the memory-mapped archive are returned
+// without a copy; use FreePipelineBinary() (or check IsMappedBinary()) to release the result.
 Util::Result PipelineBinaryCache::LoadPipelineBinary(
     const CacheId* pCacheId,
     size_t*        pPipelineBinarySize,
@@ -297,9 +787,31 @@ Util::Result PipelineBinaryCache::LoadPipelineBinary(
 {
     VK_ASSERT(m_pTopLayer != nullptr);
 
+    WaitForInitialDataValidation(pCacheId);
+
+    const MappedEntry* pMappedEntry = FindMappedEntry(pCacheId);
+
+    if (pMappedEntry != nullptr)
+    {
+        *pPipelineBinarySize = pMappedEntry->dataSize;
+        *ppPipelineBinary    = pMappedEntry->pData;
+
+        Util::AtomicIncrement64(&m_hitCount);
+        Util::AtomicIncrement64(&m_mappedHitCount);
+
+        return Util::Result::Success;
+    }
+
     Util::QueryResult query  = {};
     Util::Result      result = m_pTopLayer->Query(pCacheId, 0, 0, &query);
 
+    if (IsMemoryBudgetEnabled() && (result == Util::Result::Success))
+    {
+        Util::MutexAuto lock(&m_entriesMutex);
+        TouchLruEntry(pCacheId, query.dataSize, false);
+        EnforceMemoryBudget();
+    }
+
     if (result == Util::Result::Success)
     {
         void* pOutputMem = AllocMem(query.dataSize);
@@ -311,6 +823,8 @@ Util::Result PipelineBinaryCache::LoadPipelineBinary(
             {
                 *pPipelineBinarySize = query.dataSize;
                 *ppPipelineBinary    = pOutputMem;
+
+                CountHit(&query);
             }
             else
             {
@@ -319,6 +833,8 @@ Util::Result PipelineBinaryCache::LoadPipelineBinary(
         }
     }
 
+    Util::AtomicIncrement64((result == Util::Result::Success) ? &m_hitCount : &m_missCount);
+
     return result;
 }
 
@@ -331,7 +847,52 @@ Util::Result PipelineBinaryCache::StorePipelineBinary(
 {
     VK_ASSERT(m_pTopLayer != nullptr);
 
-    return m_pTopLayer->Store(pCacheId, pPipelineBinary, pipelineBinarySize);
+    // With write-back enabled the memory layer doesn't pass stores on; the archives are written by the write-back
+    // thread instead.
+    Util::Result result = m_pTopLayer->Store(pCacheId, pPipelineBinary, pipelineBinarySize);
+
+    if (m_writeBackEnabled && (result == Util::Result::Success))
+    {
+        // The shared segment is only a copy into memory, and other processes should see the binary right away.
+        if (m_pSharedLayer != nullptr)
+        {
+            m_pSharedLayer->Store(pCacheId, pPipelineBinary, pipelineBinarySize);
+        }
+
+        // Until the write-back thread has written it, the binary can't be reloaded from the archives, so it's pinned
+        // in the memory layer.  The pin is taken before queueing so that the write-back thread can't drop it first.
+        if (IsMemoryBudgetEnabled())
+        {
+            Util::MutexAuto lock(&m_entriesMutex);
+            TouchLruEntry(pCacheId, pipelineBinarySize, true);
+        }
+
+        if (QueueWriteBack(pCacheId, pipelineBinarySize, pPipelineBinary) != Util::Result::Success)
+        {
+            // Fall back to writing through on this thread.
+            m_pArchiveLayer->Store(pCacheId, pPipelineBinary, pipelineBinarySize);
+
+            if (IsMemoryBudgetEnabled())
+            {
+                Util::MutexAuto lock(&m_entriesMutex);
+                ReleaseLruRef(pCacheId);
+            }
+        }
+    }
+
+    if (IsMemoryBudgetEnabled() && (result == Util::Result::Success))
+    {
+        Util::MutexAuto lock(&m_entriesMutex);
+        TouchLruEntry(pCacheId, pipelineBinarySize, false);
+        EnforceMemoryBudget();
+    }
+
+    if (m_incrementalSerialize && (result == Util::Result::Success))
+    {
+        TrackDirtyEntry(pCacheId, pipelineBinarySize);
+    }
+
+    return result;
 }
 
 // =====================================================================================================================
@@ -339,8 +900,22 @@ Util::Result PipelineBinaryCache::ReleaseCacheRef(
     const Util::QueryResult* pQuery) const
 {
     VK_ASSERT(m_pTopLayer != nullptr);
-    return m_pTopLayer->ReleaseCacheRef(pQuery);
-}
+
+    Util::Result result = Util::Result::Success;
+
+    if (IsMappedQuery(pQuery) == false)
+    {
+        result = m_pTopLayer->ReleaseCacheRef(pQuery);
+
+        if (IsMemoryBudgetEnabled())
+        {
+            Util::MutexAuto lock(&m_entriesMutex);
+            ReleaseLruRef(&pQuery->hashId);
+        }
+    }
+
+    return result;
+}
 
 // =====================================================================================================================
 Util::Result PipelineBinaryCache::GetCacheDataPtr(
@@ -348,7 +923,19 @@ Util::Result PipelineBinaryCache::GetCacheDataPtr(
     const void**             ppData) const
 {
     VK_ASSERT(m_pTopLayer != nullptr);
-    return m_pTopLayer->GetCacheData(pQuery, ppData);
+
+    Util::Result result = Util::Result::Success;
+
+    if (IsMappedQuery(pQuery))
+    {
+        *ppData = static_cast<const MappedEntry*>(pQuery->context.pEntryInfo)->pData;
+    }
+    else
+    {
+        result = m_pTopLayer->GetCacheData(pQuery, ppData);
+    }
+
+    return result;
 }
 
 // =====================================================================================================================
@@ -357,7 +944,23 @@ Util::Result PipelineBinaryCache::EvictEntry(
 {
     VK_ASSERT(m_pTopLayer != nullptr);
 
-    return m_pTopLayer->Evict(&pQuery->hashId);
+    Util::Result result = Util::Result::Success;
+
+    // The mapped archive is read-only; only entries in the regular layers can be evicted.
+    if (IsMappedQuery(pQuery) == false)
+    {
+        result = m_pTopLayer->Evict(&pQuery->hashId);
+
+        InvalidateSerializedBlob();
+
+        if (IsMemoryBudgetEnabled())
+        {
+            Util::MutexAuto lock(&m_entriesMutex);
+            RemoveLruEntry(&pQuery->hashId);
+        }
+    }
+
+    return result;
 }
 
 // =====================================================================================================================
@@ -366,7 +969,20 @@ Util::Result PipelineBinaryCache::MarkEntryBad(
 {
     VK_ASSERT(m_pTopLayer != nullptr);
 
-    return m_pTopLayer->MarkEntryBad(&pQuery->hashId);
+    Util::Result result = Util::Result::Success;
+
+    if (IsMappedQuery(pQuery))
+    {
+        static_cast<MappedEntry*>(pQuery->context.pEntryInfo)->isBad = true;
+    }
+    else
+    {
+        result = m_pTopLayer->MarkEntryBad(&pQuery->hashId);
+
+        InvalidateSerializedBlob();
+    }
+
+    return result;
 }
 
 // =====================================================================================================================
@@ -376,7 +992,130 @@ Util::Result PipelineBinaryCache::GetPipelineBinary(
 {
     VK_ASSERT(m_pTopLayer != nullptr);
 
-    return m_pTopLayer->Load(pQeuryId, pPipelineBinary);
+    Util::Result result = Util::Result::Success;
+
+    if (IsMappedQuery(pQeuryId))
+    {
+        memcpy(pPipelineBinary, static_cast<const MappedEntry*>(pQeuryId->context.pEntryInfo)->pData, pQeuryId->dataSize);
+    }
+    else
+    {
+        result = m_pTopLayer->Load(pQeuryId, pPipelineBinary);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Returns true if an entry is stored under the given ID.  Doesn't count towards the hit statistics.
+bool PipelineBinaryCache::ContainsEntry(
+    const CacheId* pCacheId) const
+{
+    Util::QueryResult query = {};
+
+    WaitForInitialDataValidation(pCacheId);
+
+    return (FindMappedEntry(pCacheId) != nullptr) ||
+           (m_pTopLayer->Query(pCacheId, 0, 0, &query) == Util::Result::Success);
+}
+
+// =====================================================================================================================
+// Stores a binary produced by the compiler through the cache adapter.  With relocatable shaders, the compiler stores
+// one ELF per shader stage, and stages shared by many pipelines often compile to identical ELFs under different IDs.
+// Those are stored once under an ID derived from their contents, and each compiler ID only gets a ShaderAliasRecord
+// referencing it.  Both are regular entries, so the sharing survives serialization and the archive layers.
+Util::Result PipelineBinaryCache::StoreShaderBinary(
+    const CacheId*  pCacheId,
+    size_t          shaderBinarySize,
+    const void*     pShaderBinary)
+{
+    Util::Result result = Util::Result::ErrorUnavailable;
+
+    if (m_dedupShaders && (shaderBinarySize > sizeof(ShaderAliasRecord)))
+    {
+        ShaderAliasRecord record = {};
+        record.magic   = ShaderAliasMagic;
+        record.version = ShaderAliasVersion;
+
+        // Salted so that content IDs can't collide with the compiler's IDs.
+        Util::MetroHash128 hasher;
+        hasher.Update(record.magic);
+        hasher.Update(static_cast<const uint8_t*>(pShaderBinary), shaderBinarySize);
+        hasher.Finalize(record.contentId.bytes);
+
+        if (ContainsEntry(&record.contentId))
+        {
+            result = Util::Result::Success;
+
+            Util::AtomicIncrement64(&m_dedupStoreCount);
+            Util::AtomicAdd64(&m_dedupByteCount, shaderBinarySize);
+        }
+        else
+        {
+            result = StorePipelineBinary(&record.contentId, shaderBinarySize, pShaderBinary);
+        }
+
+        if (result == Util::Result::Success)
+        {
+            result = StorePipelineBinary(pCacheId, sizeof(record), &record);
+        }
+    }
+
+    if (result != Util::Result::Success)
+    {
+        result = StorePipelineBinary(pCacheId, shaderBinarySize, pShaderBinary);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Replaces a successful query of a compiler binary stored as an alias with a query of the shared binary.  flags are
+// the query flags of pQuery; a reference held on the alias is released in favour of one on the shared binary.  If the
+// shared binary is gone the alias is marked bad, NotFound is returned and pQuery is left untouched.
+Util::Result PipelineBinaryCache::ResolveShaderAlias(
+    uint32_t           flags,
+    Util::QueryResult* pQuery)
+{
+    Util::Result result = Util::Result::Success;
+
+    if (m_dedupShaders && (pQuery->dataSize == sizeof(ShaderAliasRecord)))
+    {
+        ShaderAliasRecord record = {};
+
+        result = GetPipelineBinary(pQuery, &record);
+
+        // Otherwise this is a binary which just happens to have the size of an alias.
+        if ((result == Util::Result::Success) &&
+            (record.magic == ShaderAliasMagic) &&
+            (record.version == ShaderAliasVersion))
+        {
+            // The shared binary is always stored before its aliases, so it never needs to be reserved or waited on.
+            const uint32_t    contentFlags = flags & ~Util::ICacheLayer::QueryFlags::ReserveEntryOnMiss;
+            Util::QueryResult contentQuery = {};
+
+            result = QueryPipelineBinary(&record.contentId, contentFlags, &contentQuery);
+
+            if (result == Util::Result::Success)
+            {
+                if ((flags & Util::ICacheLayer::QueryFlags::AcquireEntryRef) != 0)
+                {
+                    ReleaseCacheRef(pQuery);
+                }
+
+                *pQuery = contentQuery;
+            }
+            else
+            {
+                // Lets the next lookup of the alias reserve it, so the binary gets stored again.
+                MarkEntryBad(pQuery);
+
+                result = Util::Result::NotFound;
+            }
+        }
+    }
+
+    return result;
 }
 
 #if ICD_GPUOPEN_DEVMODE_BUILD
@@ -489,11 +1228,14 @@ Util::Result PipelineBinaryCache::StoreReinjectionBinary(
 
 #endif
 // =====================================================================================================================
-// Free memory allocated by our allocator
+// Free memory allocated by our allocator.  Binaries served from the memory-mapped archive are left alone.
 void PipelineBinaryCache::FreePipelineBinary(
-    const void* pPipelineBinary)
+    const void* pPipelineBinary) const
 {
-    FreeMem(const_cast<void*>(pPipelineBinary));
+    if (IsMappedBinary(pPipelineBinary) == false)
+    {
+        FreeMem(const_cast<void*>(pPipelineBinary));
+    }
 }
 
 // =====================================================================================================================
@@ -523,6 +1265,9 @@ VkResult PipelineBinaryCache::Initialize(
 {
     VkResult result = VK_SUCCESS;
 
+    m_compressOnSerialize = settings.pipelineCacheCompressEntries;
+    m_dedupShaders        = settings.enableRelocatableShaders && settings.pipelineCacheDeduplicateShaders;
+
     if (pKey != nullptr)
     {
         m_pPlatformKey = pKey;
@@ -542,6 +1287,24 @@ VkResult PipelineBinaryCache::Initialize(
         result = OrderLayers(settings);
     }
 
+    // Only application caches are serialized; the internal cache would just pay for the bookkeeping.
+    if ((result == VK_SUCCESS) && (createArchiveLayers == false) && settings.pipelineCacheIncrementalSerialize)
+    {
+        // Not a terminal failure; Serialize() falls back to walking the whole memory layer.
+        VkResult serializeResult = InitIncrementalSerialize();
+        VK_ALERT(serializeResult != VK_SUCCESS);
+    }
+
+    // The write-back thread allocates and frees the queued binaries and stores them in the archive layers, all through
+    // the cache's callbacks.  Application callbacks may only be called from the thread issuing the command.
+    if ((result == VK_SUCCESS) && settings.enablePipelineCacheWriteBack &&
+        allocator::IsDriverAllocCallbacks(m_pAllocationCallbacks))
+    {
+        // Not a terminal failure; stores simply keep writing through to the archives.
+        VkResult writeBackResult = InitWriteBack();
+        VK_ALERT(writeBackResult != VK_SUCCESS);
+    }
+
 #if ICD_GPUOPEN_DEVMODE_BUILD
     if ((result == VK_SUCCESS) &&
         (m_pReinjectionLayer != nullptr))
@@ -812,165 +1575,788 @@ VkResult PipelineBinaryCache::InitMemoryCacheLayer(
 }
 
 // =====================================================================================================================
-// Open an archive file from disk for read
-Util::IArchiveFile* PipelineBinaryCache::OpenReadOnlyArchive(
-    const char* pFilePath,
-    const char* pFileName,
-    size_t      bufferSize)
+// Initialize the layer shared with other processes running on the same platform key
+VkResult PipelineBinaryCache::InitSharedMemoryLayer(
+    const RuntimeSettings& settings)
 {
-    VK_ASSERT(pFilePath != nullptr);
-    VK_ASSERT(pFileName != nullptr);
-
-    Util::ArchiveFileOpenInfo info  = {};
-    Util::IArchiveFile*       pFile = nullptr;
-
-    Util::AllocCallbacks allocCbs = {
-        m_pAllocationCallbacks,
-        allocator::PalAllocFuncDelegator,
-        allocator::PalFreeFuncDelegator
-    };
-
-    info.pMemoryCallbacks        = &allocCbs;
-    info.pFilePath               = pFilePath;
-    info.pFileName               = pFileName;
-    info.pPlatformKey            = m_pPlatformKey;
-    info.archiveType             = ArchiveType;
-    info.useStrictVersionControl = true;
-    info.allowWriteAccess        = false;
-    info.allowCreateFile         = false;
-    info.allowAsyncFileIo        = true;
-    info.useBufferedReadMemory   = (bufferSize > 0);
-    info.maxReadBufferMem        = bufferSize;
+    VK_ASSERT(m_pSharedLayer == nullptr);
 
-    size_t memSize = Util::GetArchiveFileObjectSize(&info);
-    void*  pMem    = AllocMem(memSize);
+    VkResult     result      = VK_SUCCESS;
+    const size_t segmentSize = static_cast<size_t>(settings.sharedPipelineCacheSize) * 1024 * 1024;
 
-    if (pMem != nullptr)
+    if (segmentSize < SharedMemoryCacheLayer::MinSegmentSize)
     {
-        Util::Result openResult = Util::OpenArchiveFile(&info, pMem, &pFile);
+        result = VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+    else
+    {
+        m_pSharedLayer = SharedMemoryCacheLayer::Create(m_pAllocationCallbacks, m_pPlatformKey->GetKey64(), segmentSize);
 
-        if (openResult == Util::Result::Success)
-        {
-            if (info.useBufferedReadMemory)
-            {
-                pFile->Preload(0, info.maxReadBufferMem);
-            }
-        }
-        else
+        if (m_pSharedLayer == nullptr)
         {
-            FreeMem(pMem);
-            pFile = nullptr;
+            result = VK_ERROR_INITIALIZATION_FAILED;
         }
     }
 
-    return pFile;
+    return result;
 }
 
 // =====================================================================================================================
-// Open an archive file from disk for read + write
-Util::IArchiveFile* PipelineBinaryCache::OpenWritableArchive(
-    const char* pFilePath,
-    const char* pFileName,
-    size_t      bufferSize)
+// Starts the write-back thread.  Only useful when both a memory layer (which serves the binaries until they are written)
+// and an archive layer exist.
+VkResult PipelineBinaryCache::InitWriteBack()
 {
-    VK_ASSERT(pFilePath != nullptr);
-    VK_ASSERT(pFileName != nullptr);
-
-    Util::ArchiveFileOpenInfo info  = {};
-    Util::IArchiveFile*       pFile = nullptr;
-
-    Util::AllocCallbacks allocCbs = {
-        m_pAllocationCallbacks,
-        allocator::PalAllocFuncDelegator,
-        allocator::PalFreeFuncDelegator
-    };
-
-    info.pMemoryCallbacks        = &allocCbs;
-    info.pFilePath               = pFilePath;
-    info.pFileName               = pFileName;
-    info.pPlatformKey            = m_pPlatformKey;
-    info.archiveType             = ArchiveType;
-    info.useStrictVersionControl = true;
-    info.allowWriteAccess        = true;
-    info.allowCreateFile         = true;
-    info.allowAsyncFileIo        = true;
-    info.useBufferedReadMemory   = (bufferSize > 0);
-    info.maxReadBufferMem        = bufferSize;
-
-    size_t memSize = Util::GetArchiveFileObjectSize(&info);
-    void*  pMem    = AllocMem(memSize);
+    VkResult result = VK_SUCCESS;
 
-    if (pMem != nullptr)
+    if ((m_pMemoryLayer != nullptr) && (m_pArchiveLayer != nullptr))
     {
-        Util::Result openResult = Util::OpenArchiveFile(&info, pMem, &pFile);
+        Util::EventCreateFlags flags = {};
+        flags.manualReset       = false;
+        flags.initiallySignaled = false;
 
-        if (openResult == Util::Result::ErrorIncompatibleLibrary)
+        result = PalToVkResult(m_writeBackEvent.Init(flags));
+
+        if (result == VK_SUCCESS)
         {
-            if (Util::DeleteArchiveFile(&info)  == Util::Result::Success)
-            {
-                openResult = Util::OpenArchiveFile(&info, pMem, &pFile);
-            }
+            result = PalToVkResult(m_writeBackThread.Begin(WriteBackThreadFunc, this));
         }
 
-        if (openResult == Util::Result::Success)
+        if (result == VK_SUCCESS)
         {
-            if (info.useBufferedReadMemory)
+            // Keep stores in the memory layer; the write-back thread forwards them to the archives.
+            m_pMemoryLayer->SetStorePolicy(0);
+
+            if (m_pSharedLayer != nullptr)
             {
-                pFile->Preload(0, info.maxReadBufferMem);
+                m_pSharedLayer->SetStorePolicy(0);
             }
-        }
-        else
-        {
-            FreeMem(pMem);
-            pFile = nullptr;
+            m_writeBackEnabled = true;
         }
     }
 
-    return pFile;
+    return result;
 }
 
 // =====================================================================================================================
-// Create a cache layer from an open file
-Util::ICacheLayer* PipelineBinaryCache::CreateFileLayer(
-    Util::IArchiveFile* pFile)
+// Stops the write-back thread and writes out everything that is still queued.
+void PipelineBinaryCache::DestroyWriteBack()
 {
-    VK_ASSERT(pFile != nullptr);
-    Util::ArchiveFileCacheCreateInfo info   = {};
-    Util::ICacheLayer*               pLayer = nullptr;
-
-    Util::AllocCallbacks allocCbs = {
-        m_pAllocationCallbacks,
-        allocator::PalAllocFuncDelegator,
-        allocator::PalFreeFuncDelegator
-    };
-
-    info.baseInfo.pCallbacks = &allocCbs;
-    info.pFile               = pFile;
-    info.pPlatformKey        = m_pPlatformKey;
-    info.dataTypeId          = ElfType;
+    if (m_writeBackEnabled)
+    {
+        m_writeBackStop = true;
+        m_writeBackEvent.Set();
+        m_writeBackThread.Join();
 
-    size_t memSize = Util::GetArchiveFileCacheLayerSize(&info);
-    void*  pMem    = AllocMem(memSize);
+        FlushWriteBack();
 
-    if (pMem != nullptr)
-    {
-        if (Util::CreateArchiveFileCacheLayer(&info, pMem, &pLayer) != Util::Result::Success)
-        {
-            FreeMem(pMem);
-            pLayer = nullptr;
-        }
+        m_writeBackEnabled = false;
     }
-
-    return pLayer;
 }
 
 // =====================================================================================================================
-// Open the archive file and initialize its cache layer
-VkResult PipelineBinaryCache::InitArchiveLayers(
-    const char*            pDefaultCacheFilePath,
-    const RuntimeSettings& settings)
+// Sets up pipeline prewarm for an archive named pBaseName in pCachePath and reads the manifest of the previous run.
+void PipelineBinaryCache::InitPrewarm(
+    const char* pCachePath,
+    const char* pBaseName)
 {
-    VkResult result = VK_SUCCESS;
+    if ((Util::Snprintf(m_prewarmManifestPath,
+                        sizeof(m_prewarmManifestPath),
+                        "%s/%s.manifest",
+                        pCachePath,
+                        pBaseName) > 0) &&
+        (m_prewarmIdSet.Init() == Util::Result::Success))
+    {
+        m_prewarmEnabled = true;
+
+        LoadPrewarmManifest();
+    }
+}
+
+// =====================================================================================================================
+// Reads the manifest written by the previous run.  A missing, truncated or foreign manifest just leaves fewer entries
+// to prewarm.
+void PipelineBinaryCache::LoadPrewarmManifest()
+{
+    Util::File            file;
+    PrewarmManifestHeader header    = {};
+    size_t                bytesRead = 0;
+
+    if (Util::File::Exists(m_prewarmManifestPath) &&
+        (file.Open(m_prewarmManifestPath, Util::FileAccessRead | Util::FileAccessBinary) == Util::Result::Success))
+    {
+        if ((file.Read(&header, sizeof(header), &bytesRead) == Util::Result::Success) &&
+            (bytesRead == sizeof(header))                                            &&
+            (header.magic == PrewarmManifestMagic)                                   &&
+            (header.version == PrewarmManifestVersion)                               &&
+            (header.platformKey == m_pPlatformKey->GetKey64()))
+        {
+            constexpr uint32_t ChunkSize = 256;
+
+            CacheId        chunk[ChunkSize];
+            const uint32_t entryCount = Util::Min(header.entryCount, MaxPrewarmEntries);
+
+            Util::MutexAuto lock(&m_prewarmLock);
+
+            for (uint32_t first = 0; first < entryCount; first += ChunkSize)
+            {
+                const uint32_t count = Util::Min(entryCount - first, ChunkSize);
+
+                if ((file.Read(chunk, count * sizeof(CacheId), &bytesRead) != Util::Result::Success) ||
+                    (bytesRead != (count * sizeof(CacheId))))
+                {
+                    break;
+                }
+
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    if ((m_prewarmIdSet.Contains(chunk[i]) == false)                  &&
+                        (m_prewarmIdSet.Insert(chunk[i]) == Util::Result::Success) &&
+                        (m_prewarmIds.PushBack(chunk[i]) != Util::Result::Success))
+                    {
+                        m_prewarmIdSet.Erase(chunk[i]);
+                    }
+                }
+            }
+
+            m_prewarmLoadedCount = m_prewarmIds.NumElements();
+        }
+
+        file.Close();
+    }
+}
+
+// =====================================================================================================================
+// Rewrites the manifest if this run used pipelines which it didn't list yet.
+void PipelineBinaryCache::WritePrewarmManifest()
+{
+    Util::MutexAuto lock(&m_prewarmLock);
+
+    Util::File file;
+
+    if (m_prewarmDirty &&
+        (file.Open(m_prewarmManifestPath, Util::FileAccessWrite | Util::FileAccessBinary) == Util::Result::Success))
+    {
+        PrewarmManifestHeader header = {};
+        header.magic       = PrewarmManifestMagic;
+        header.version     = PrewarmManifestVersion;
+        header.platformKey = m_pPlatformKey->GetKey64();
+        header.entryCount  = m_prewarmIds.NumElements();
+
+        Util::Result result = file.Write(&header, sizeof(header));
+
+        if ((result == Util::Result::Success) && (header.entryCount > 0))
+        {
+            result = file.Write(&m_prewarmIds.At(0), header.entryCount * sizeof(CacheId));
+        }
+
+        VK_ALERT(result != Util::Result::Success);
+
+        file.Close();
+
+        m_prewarmDirty = false;
+    }
+}
+
+// =====================================================================================================================
+// Stops the prewarm thread and saves the manifest for the next run.
+void PipelineBinaryCache::DestroyPrewarm()
+{
+    if (m_prewarmEnabled)
+    {
+        m_prewarmStop = true;
+
+        if (m_prewarmStarted != 0)
+        {
+            m_prewarmThread.Join();
+        }
+
+        WritePrewarmManifest();
+
+        m_prewarmEnabled = false;
+    }
+}
+
+// =====================================================================================================================
+// Adds a pipeline to the manifest written at the end of the run.
+void PipelineBinaryCache::RecordPrewarmEntry(
+    const CacheId* pCacheId)
+{
+    if (m_prewarmEnabled)
+    {
+        Util::MutexAuto lock(&m_prewarmLock);
+
+        if ((m_prewarmIds.NumElements() < MaxPrewarmEntries) &&
+            (m_prewarmIdSet.Contains(*pCacheId) == false)   &&
+            (m_prewarmIdSet.Insert(*pCacheId) == Util::Result::Success))
+        {
+            if (m_prewarmIds.PushBack(*pCacheId) == Util::Result::Success)
+            {
+                m_prewarmDirty = true;
+            }
+            else
+            {
+                m_prewarmIdSet.Erase(*pCacheId);
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Starts loading the entries of the previous run's manifest in the background.  Only the first call has any effect.
+void PipelineBinaryCache::StartPrewarm()
+{
+    if (m_prewarmEnabled && (m_prewarmLoadedCount > 0) && (Util::AtomicCompareAndSwap(&m_prewarmStarted, 0, 1) == 0))
+    {
+        if (m_prewarmThread.Begin(PrewarmThreadFunc, this) != Util::Result::Success)
+        {
+            // Nothing to join; pipelines will just be loaded on first use.
+            m_prewarmStarted = 0;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Queries every manifest entry in first-use order.  Queries load hits in the archive layers into the memory layer, so
+// the pipelines are already resident when the application creates them.  Entries which are no longer in the archive
+// are simply missed.  With the compile cost database, the entries which are most expensive to compile are loaded
+// first, since those are the ones an application reaching them before the prewarm would stall on the longest.
+void PipelineBinaryCache::PrewarmThreadFunc(
+    void* pParam)
+{
+    PipelineBinaryCache* pCache = static_cast<PipelineBinaryCache*>(pParam);
+
+    const uint32_t entryCount = pCache->m_prewarmLoadedCount;
+
+    Util::AutoBuffer<PrewarmOrderEntry, 64, PalAllocator> order(entryCount, &pCache->m_palAllocator);
+
+    if (order.Capacity() >= entryCount)
+    {
+        {
+            Util::MutexAuto lock(&pCache->m_prewarmLock);
+
+            for (uint32_t i = 0; i < entryCount; i++)
+            {
+                order[i].cacheId   = pCache->m_prewarmIds.At(i);
+                order[i].compileUs = pCache->m_costDb.GetCompileCost(order[i].cacheId);
+            }
+        }
+
+        // Stable, so that entries without a recorded cost stay in first-use order.
+        std::stable_sort(&order[0], &order[0] + entryCount,
+            [](const PrewarmOrderEntry& lhs, const PrewarmOrderEntry& rhs)
+            { return lhs.compileUs > rhs.compileUs; });
+
+        for (uint32_t i = 0; (i < entryCount) && (pCache->m_prewarmStop == false); i++)
+        {
+            Util::QueryResult query = {};
+            pCache->QueryPipelineBinary(&order[i].cacheId, 0, &query);
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; (i < entryCount) && (pCache->m_prewarmStop == false); i++)
+        {
+            CacheId cacheId = {};
+
+            {
+                Util::MutexAuto lock(&pCache->m_prewarmLock);
+                cacheId = pCache->m_prewarmIds.At(i);
+            }
+
+            Util::QueryResult query = {};
+            pCache->QueryPipelineBinary(&cacheId, 0, &query);
+        }
+    }
+}
+
+// =====================================================================================================================
+// Copies a binary into the write-back queue and wakes up the write-back thread.
+Util::Result PipelineBinaryCache::QueueWriteBack(
+    const CacheId* pCacheId,
+    size_t         dataSize,
+    const void*    pData)
+{
+    Util::Result    result = Util::Result::ErrorOutOfMemory;
+    WriteBackEntry* pEntry = static_cast<WriteBackEntry*>(AllocMem(sizeof(WriteBackEntry) + dataSize));
+
+    if (pEntry != nullptr)
+    {
+        pEntry->cacheId  = *pCacheId;
+        pEntry->dataSize = dataSize;
+        pEntry->pNext    = nullptr;
+
+        memcpy(Util::VoidPtrInc(pEntry, sizeof(WriteBackEntry)), pData, dataSize);
+
+        {
+            Util::MutexAuto lock(&m_writeBackLock);
+
+            if (m_pWriteBackTail != nullptr)
+            {
+                m_pWriteBackTail->pNext = pEntry;
+            }
+            else
+            {
+                m_pWriteBackHead = pEntry;
+            }
+
+            m_pWriteBackTail = pEntry;
+        }
+
+        m_writeBackEvent.Set();
+
+        result = Util::Result::Success;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Writes every queued binary to the archive layers and unpins it from the memory layer.  Entries queued while the flush
+// is running are picked up by the next flush.  Returns once all binaries which were queued before the call have been
+// written.
+void PipelineBinaryCache::FlushWriteBack()
+{
+    Util::MutexAuto flushLock(&m_writeBackFlushLock);
+
+    WriteBackEntry* pEntry = nullptr;
+
+    {
+        Util::MutexAuto lock(&m_writeBackLock);
+
+        pEntry           = m_pWriteBackHead;
+        m_pWriteBackHead = nullptr;
+        m_pWriteBackTail = nullptr;
+    }
+
+    while (pEntry != nullptr)
+    {
+        WriteBackEntry* pNext = pEntry->pNext;
+
+        Util::Result result = m_pArchiveLayer->Store(&pEntry->cacheId,
+                                                     Util::VoidPtrInc(pEntry, sizeof(WriteBackEntry)),
+                                                     pEntry->dataSize);
+        VK_ALERT(result != Util::Result::Success);
+
+        if (IsMemoryBudgetEnabled())
+        {
+            Util::MutexAuto lock(&m_entriesMutex);
+            ReleaseLruRef(&pEntry->cacheId);
+        }
+
+        FreeMem(pEntry);
+        pEntry = pNext;
+    }
+}
+
+// =====================================================================================================================
+// Write-back thread: drains the queue in batches until the cache is destroyed.
+void PipelineBinaryCache::WriteBackThreadFunc(
+    void* pParam)
+{
+    PipelineBinaryCache* pCache = static_cast<PipelineBinaryCache*>(pParam);
+
+    while (pCache->m_writeBackStop == false)
+    {
+        pCache->m_writeBackEvent.Wait(1.0f);
+        pCache->FlushWriteBack();
+    }
+}
+
+// =====================================================================================================================
+// Bounds the memory layer to the given number of bytes.  Once the budget is exceeded, the least recently used entries
+// which are not referenced are evicted from the memory layer; entries that are also backed by an archive layer are
+// reloaded from the archive on their next query.  A budget of 0 leaves the memory layer unbounded.
+//
+// Must be called before the cache is used.
+VkResult PipelineBinaryCache::SetMemoryBudget(
+    size_t budget)
+{
+    VK_ASSERT(m_lruNodes.GetNumEntries() == 0);
+
+    VkResult result = VK_SUCCESS;
+
+    if ((budget > 0) && (m_pMemoryLayer != nullptr))
+    {
+        result = PalToVkResult(m_lruNodes.Init());
+
+        if (result == VK_SUCCESS)
+        {
+            m_memoryBudget = budget;
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Returns a snapshot of the cache statistics
+void PipelineBinaryCache::GetStats(
+    CacheStats* pStats) const
+{
+    Util::MutexAuto lock(&m_entriesMutex);
+
+    pStats->hits         = m_hitCount;
+    pStats->misses       = m_missCount;
+    pStats->evictions    = m_evictCount;
+    pStats->residentSize = m_lruDataSize;
+    pStats->memoryHits   = m_memoryHitCount;
+    pStats->sharedHits   = m_sharedHitCount;
+    pStats->archiveHits  = m_archiveHitCount;
+    pStats->mappedHits   = m_mappedHitCount;
+    pStats->dedupedStores = m_dedupStoreCount;
+    pStats->dedupedBytes  = m_dedupByteCount;
+}
+
+// =====================================================================================================================
+// Attributes a hit in the layer chain to the layer which answered the query.
+void PipelineBinaryCache::CountHit(
+    const Util::QueryResult* pQuery) const
+{
+    volatile uint64_t* pCounter = &m_archiveHitCount;
+
+    if (pQuery->pLayer == m_pMemoryLayer)
+    {
+        pCounter = &m_memoryHitCount;
+    }
+    else if ((m_pSharedLayer != nullptr) && (pQuery->pLayer == m_pSharedLayer))
+    {
+        pCounter = &m_sharedHitCount;
+    }
+
+    Util::AtomicIncrement64(pCounter);
+}
+
+// =====================================================================================================================
+// Marks an entry as most recently used, starting to track it if needed.  A non-zero dataSize updates the tracked size
+// of the entry.  Must be called with m_entriesMutex held.
+void PipelineBinaryCache::TouchLruEntry(
+    const CacheId* pCacheId,
+    size_t         dataSize,
+    bool           acquireRef) const
+{
+    LruNode** ppNode = m_lruNodes.FindKey(*pCacheId);
+    LruNode*  pNode  = (ppNode != nullptr) ? *ppNode : nullptr;
+
+    if (pNode == nullptr)
+    {
+        pNode = static_cast<LruNode*>(AllocMem(sizeof(LruNode)));
+
+        if (pNode != nullptr)
+        {
+            memset(pNode, 0, sizeof(*pNode));
+            pNode->cacheId = *pCacheId;
+
+            if (m_lruNodes.Insert(*pCacheId, pNode) != Util::Result::Success)
+            {
+                // Untracked entries are simply never evicted.
+                FreeMem(pNode);
+                pNode = nullptr;
+            }
+        }
+    }
+    else
+    {
+        UnlinkLruNode(pNode);
+    }
+
+    if (pNode != nullptr)
+    {
+        if (dataSize > 0)
+        {
+            m_lruDataSize   -= pNode->dataSize;
+            m_lruDataSize   += dataSize;
+            pNode->dataSize  = dataSize;
+        }
+
+        if (acquireRef)
+        {
+            pNode->refCount++;
+        }
+
+        pNode->pPrev = nullptr;
+        pNode->pNext = m_pLruHead;
+
+        if (m_pLruHead != nullptr)
+        {
+            m_pLruHead->pPrev = pNode;
+        }
+
+        m_pLruHead = pNode;
+
+        if (m_pLruTail == nullptr)
+        {
+            m_pLruTail = pNode;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Drops a reference acquired by QueryPipelineBinary.  Must be called with m_entriesMutex held.
+void PipelineBinaryCache::ReleaseLruRef(
+    const CacheId* pCacheId) const
+{
+    LruNode** ppNode = m_lruNodes.FindKey(*pCacheId);
+
+    if ((ppNode != nullptr) && ((*ppNode)->refCount > 0))
+    {
+        (*ppNode)->refCount--;
+    }
+}
+
+// =====================================================================================================================
+// Stops tracking an entry.  Must be called with m_entriesMutex held.
+void PipelineBinaryCache::RemoveLruEntry(
+    const CacheId* pCacheId) const
+{
+    LruNode** ppNode = m_lruNodes.FindKey(*pCacheId);
+
+    if (ppNode != nullptr)
+    {
+        LruNode* pNode = *ppNode;
+
+        UnlinkLruNode(pNode);
+        m_lruNodes.Erase(*pCacheId);
+
+        m_lruDataSize -= pNode->dataSize;
+        FreeMem(pNode);
+    }
+}
+
+// =====================================================================================================================
+// Removes a node from the LRU list without freeing it.  Must be called with m_entriesMutex held.
+void PipelineBinaryCache::UnlinkLruNode(
+    LruNode* pNode) const
+{
+    if (pNode->pPrev != nullptr)
+    {
+        pNode->pPrev->pNext = pNode->pNext;
+    }
+    else
+    {
+        m_pLruHead = pNode->pNext;
+    }
+
+    if (pNode->pNext != nullptr)
+    {
+        pNode->pNext->pPrev = pNode->pPrev;
+    }
+    else
+    {
+        m_pLruTail = pNode->pPrev;
+    }
+
+    pNode->pPrev = nullptr;
+    pNode->pNext = nullptr;
+}
+
+// =====================================================================================================================
+// Evicts least recently used entries from the memory layer until the tracked size fits the memory budget.  Entries
+// with outstanding references are skipped, and the most recently used entry is always kept so that the caller which just
+// touched it can still load it.  Must be called with m_entriesMutex held.
+void PipelineBinaryCache::EnforceMemoryBudget() const
+{
+    LruNode* pNode = m_pLruTail;
+
+    while ((m_lruDataSize > m_memoryBudget) && (pNode != nullptr) && (pNode != m_pLruHead))
+    {
+        LruNode* pPrev = pNode->pPrev;
+
+        if ((pNode->refCount == 0) && (pNode->dataSize > 0))
+        {
+            const CacheId cacheId = pNode->cacheId;
+
+            // The entry may already be gone from the layer (e.g. after MarkEntryBad); drop it either way.
+            if (m_pMemoryLayer->Evict(&cacheId) == Util::Result::Success)
+            {
+                Util::AtomicIncrement64(&m_evictCount);
+                InvalidateSerializedBlob();
+            }
+
+            RemoveLruEntry(&cacheId);
+        }
+
+        pNode = pPrev;
+    }
+}
+
+// =====================================================================================================================
+// Frees all LRU nodes
+void PipelineBinaryCache::DestroyLruNodes()
+{
+    LruNode* pNode = m_pLruHead;
+
+    while (pNode != nullptr)
+    {
+        LruNode* pNext = pNode->pNext;
+        FreeMem(pNode);
+        pNode = pNext;
+    }
+
+    m_pLruHead    = nullptr;
+    m_pLruTail    = nullptr;
+    m_lruDataSize = 0;
+}
+
+// =====================================================================================================================
+// Open an archive file from disk for read
+Util::IArchiveFile* PipelineBinaryCache::OpenReadOnlyArchive(
+    const char* pFilePath,
+    const char* pFileName,
+    size_t      bufferSize)
+{
+    VK_ASSERT(pFilePath != nullptr);
+    VK_ASSERT(pFileName != nullptr);
+
+    Util::ArchiveFileOpenInfo info  = {};
+    Util::IArchiveFile*       pFile = nullptr;
+
+    Util::AllocCallbacks allocCbs = {
+        m_pAllocationCallbacks,
+        allocator::PalAllocFuncDelegator,
+        allocator::PalFreeFuncDelegator
+    };
+
+    info.pMemoryCallbacks        = &allocCbs;
+    info.pFilePath               = pFilePath;
+    info.pFileName               = pFileName;
+    info.pPlatformKey            = m_pPlatformKey;
+    info.archiveType             = ArchiveType;
+    info.useStrictVersionControl = true;
+    info.allowWriteAccess        = false;
+    info.allowCreateFile         = false;
+    info.allowAsyncFileIo        = true;
+    info.useBufferedReadMemory   = (bufferSize > 0);
+    info.maxReadBufferMem        = bufferSize;
+
+    size_t memSize = Util::GetArchiveFileObjectSize(&info);
+    void*  pMem    = AllocMem(memSize);
+
+    if (pMem != nullptr)
+    {
+        Util::Result openResult = Util::OpenArchiveFile(&info, pMem, &pFile);
+
+        if (openResult == Util::Result::Success)
+        {
+            if (info.useBufferedReadMemory)
+            {
+                pFile->Preload(0, info.maxReadBufferMem);
+            }
+        }
+        else
+        {
+            FreeMem(pMem);
+            pFile = nullptr;
+        }
+    }
+
+    return pFile;
+}
+
+// =====================================================================================================================
+// Open an archive file from disk for read + write
+Util::IArchiveFile* PipelineBinaryCache::OpenWritableArchive(
+    const char* pFilePath,
+    const char* pFileName,
+    size_t      bufferSize)
+{
+    VK_ASSERT(pFilePath != nullptr);
+    VK_ASSERT(pFileName != nullptr);
+
+    Util::ArchiveFileOpenInfo info  = {};
+    Util::IArchiveFile*       pFile = nullptr;
+
+    Util::AllocCallbacks allocCbs = {
+        m_pAllocationCallbacks,
+        allocator::PalAllocFuncDelegator,
+        allocator::PalFreeFuncDelegator
+    };
+
+    info.pMemoryCallbacks        = &allocCbs;
+    info.pFilePath               = pFilePath;
+    info.pFileName               = pFileName;
+    info.pPlatformKey            = m_pPlatformKey;
+    info.archiveType             = ArchiveType;
+    info.useStrictVersionControl = true;
+    info.allowWriteAccess        = true;
+    info.allowCreateFile         = true;
+    info.allowAsyncFileIo        = true;
+    info.useBufferedReadMemory   = (bufferSize > 0);
+    info.maxReadBufferMem        = bufferSize;
+
+    size_t memSize = Util::GetArchiveFileObjectSize(&info);
+    void*  pMem    = AllocMem(memSize);
+
+    if (pMem != nullptr)
+    {
+        Util::Result openResult = Util::OpenArchiveFile(&info, pMem, &pFile);
+
+        if (openResult == Util::Result::ErrorIncompatibleLibrary)
+        {
+            if (Util::DeleteArchiveFile(&info)  == Util::Result::Success)
+            {
+                openResult = Util::OpenArchiveFile(&info, pMem, &pFile);
+            }
+        }
+
+        if (openResult == Util::Result::Success)
+        {
+            if (info.useBufferedReadMemory)
+            {
+                pFile->Preload(0, info.maxReadBufferMem);
+            }
+        }
+        else
+        {
+            FreeMem(pMem);
+            pFile = nullptr;
+        }
+    }
+
+    return pFile;
+}
+
+// =====================================================================================================================
+// Create a cache layer from an open file
+Util::ICacheLayer* PipelineBinaryCache::CreateFileLayer(
+    Util::IArchiveFile* pFile)
+{
+    VK_ASSERT(pFile != nullptr);
+    Util::ArchiveFileCacheCreateInfo info   = {};
+    Util::ICacheLayer*               pLayer = nullptr;
+
+    Util::AllocCallbacks allocCbs = {
+        m_pAllocationCallbacks,
+        allocator::PalAllocFuncDelegator,
+        allocator::PalFreeFuncDelegator
+    };
+
+    info.baseInfo.pCallbacks = &allocCbs;
+    info.pFile               = pFile;
+    info.pPlatformKey        = m_pPlatformKey;
+    info.dataTypeId          = ElfType;
+
+    size_t memSize = Util::GetArchiveFileCacheLayerSize(&info);
+    void*  pMem    = AllocMem(memSize);
+
+    if (pMem != nullptr)
+    {
+        if (Util::CreateArchiveFileCacheLayer(&info, pMem, &pLayer) != Util::Result::Success)
+        {
+            FreeMem(pMem);
+            pLayer = nullptr;
+        }
+    }
+
+    return pLayer;
+}
+
+// =====================================================================================================================
+// Open the archive file and initialize its cache layer
+VkResult PipelineBinaryCache::InitArchiveLayers(
+    const char*            pDefaultCacheFilePath,
+    const RuntimeSettings& settings)
+{
+    VkResult result = VK_SUCCESS;
 
     // Buffer to hold constructed path
     char pathBuffer[Util::PathBufferLen] = {};
@@ -995,24 +2381,18 @@ VkResult PipelineBinaryCache::InitArchiveLayers(
                 if (Util::Snprintf(pathBuffer, sizeof(pathBuffer), "%s%s", pUserDataPath, pCacheSubPath) > 0)
                 {
                     pCachePath = pathBuffer;
-
-                    if (settings.allowCleanUpCacheDirectory)
-                    {
-                        uint64 totalSize = 0, oldestTime = 0;
-                        if (Util::GetStatusOfDir(pCachePath, &totalSize, &oldestTime) == Util::Result::Success)
-                        {
-                            if (totalSize >= settings.pipelineCacheDefaultLocationLimitation)
-                            {
-                                Util::RemoveFilesOfDir(pCachePath, oldestTime + settings.thresholdOfCleanUpCache);
-                            }
-                        }
-                    }
-                    result = VK_SUCCESS;
+                    result     = VK_SUCCESS;
                 }
             }
         }
     }
 
+    // Map the optional zero-copy archive. This may fail gracefully
+    if (result == VK_SUCCESS)
+    {
+        InitMappedArchive(pCachePath, settings);
+    }
+
     // Load the primary archive file
     if (result == VK_SUCCESS)
     {
@@ -1077,6 +2457,28 @@ VkResult PipelineBinaryCache::InitArchiveLayers(
             Util::Strncpy(nameBuffer, pCacheFileName, sizeof(nameBuffer));
         }
 
+        if (settings.enableCompileCostDatabase)
+        {
+            char costDbPath[Util::PathBufferLen] = {};
+
+            if (Util::Snprintf(costDbPath, sizeof(costDbPath), "%s/%s.cost", pCachePath, nameBuffer) > 0)
+            {
+                // Read first, so that the prewarm order can use the costs.
+                m_costDb.Init(costDbPath, m_pPlatformKey->GetKey64());
+            }
+        }
+
+        if (settings.enablePipelinePrewarm)
+        {
+            InitPrewarm(pCachePath, nameBuffer);
+        }
+
+        // Only the default location is shared by all applications and bounded in size
+        if ((pCachePath == pathBuffer) && settings.allowCleanUpCacheDirectory)
+        {
+            StartCacheDirCleanUp(pCachePath, nameBuffer, settings);
+        }
+
         Util::ICacheLayer* pWriteLayer    = nullptr;
         Util::ICacheLayer* pLastReadLayer = pThirdPartyLayer;
 
@@ -1162,6 +2564,298 @@ VkResult PipelineBinaryCache::InitArchiveLayers(
     return result;
 }
 
+// =====================================================================================================================
+// Starts the clean-up of the cache directory in the background.  Files whose names start with pKeepPrefix belong to
+// this application (archives, manifest, cost database) and are left alone.
+void PipelineBinaryCache::StartCacheDirCleanUp(
+    const char*            pCachePath,
+    const char*            pKeepPrefix,
+    const RuntimeSettings& settings)
+{
+    Util::EventCreateFlags flags = {};
+    flags.manualReset       = true;
+    flags.initiallySignaled = false;
+
+    Util::Strncpy(m_cleanUpPath, pCachePath, sizeof(m_cleanUpPath));
+    Util::Strncpy(m_cleanUpKeepPrefix, pKeepPrefix, sizeof(m_cleanUpKeepPrefix));
+
+    m_cleanUpBudget = settings.pipelineCacheDefaultLocationLimitation;
+    m_cleanUpMinAge = settings.thresholdOfCleanUpCache;
+
+    if ((m_cleanUpEvent.Init(flags) == Util::Result::Success) &&
+        (m_cleanUpThread.Begin(CacheDirCleanUpThreadFunc, this) == Util::Result::Success))
+    {
+        m_cleanUpStarted = true;
+    }
+}
+
+// =====================================================================================================================
+// Stops the clean-up thread, abandoning the clean-up if it is still running.
+void PipelineBinaryCache::DestroyCacheDirCleanUp()
+{
+    if (m_cleanUpStarted)
+    {
+        m_cleanUpStop = true;
+        m_cleanUpEvent.Set();
+        m_cleanUpThread.Join();
+
+        m_cleanUpStarted = false;
+    }
+}
+
+// =====================================================================================================================
+// Clean-up thread: waits for the application to get through its startup, then bounds the cache directory at the
+// lowest scheduling priority.
+void PipelineBinaryCache::CacheDirCleanUpThreadFunc(
+    void* pParam)
+{
+    // Give device creation and the first pipelines the disk to themselves
+    constexpr float StartDelay = 10.0f;
+
+    PipelineBinaryCache* pCache = static_cast<PipelineBinaryCache*>(pParam);
+
+#if defined(__linux__)
+    // On Linux, the nice value is a property of each thread
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+
+    pCache->m_cleanUpEvent.Wait(StartDelay);
+
+    if (pCache->m_cleanUpStop == false)
+    {
+        pCache->CleanUpCacheDir();
+    }
+}
+
+// =====================================================================================================================
+// Removes the least recently used files of the cache directory until it takes no more than 90% of the budget, so that
+// the next few runs don't have to clean up again.  A file's last use is the later of its access and modification time;
+// files used within the minimum age are kept even if the directory stays over budget.
+void PipelineBinaryCache::CleanUpCacheDir()
+{
+    struct CacheFile
+    {
+        time_t   lastUse;
+        uint64_t size;
+        char     name[Util::FilenameBufferLen];
+    };
+
+    Util::Vector<CacheFile, 64, PalAllocator> files(&m_palAllocator);
+
+    const time_t now         = time(nullptr);
+    const size_t prefixLen   = strlen(m_cleanUpKeepPrefix);
+    uint64_t     totalSize   = 0;
+    bool         listed      = true;
+
+    char filePath[Util::PathBufferLen] = {};
+
+    DIR* pDir = opendir(m_cleanUpPath);
+
+    if (pDir != nullptr)
+    {
+        const struct dirent* pEntry = nullptr;
+
+        while ((m_cleanUpStop == false) && ((pEntry = readdir(pDir)) != nullptr))
+        {
+            struct stat fileStat = {};
+
+            if ((Util::Snprintf(filePath, sizeof(filePath), "%s/%s", m_cleanUpPath, pEntry->d_name) > 0) &&
+                (stat(filePath, &fileStat) == 0) &&
+                S_ISREG(fileStat.st_mode))
+            {
+                CacheFile file = {};
+
+                file.lastUse = Util::Max(fileStat.st_atime, fileStat.st_mtime);
+                file.size    = static_cast<uint64_t>(fileStat.st_size);
+
+                totalSize += file.size;
+
+                if ((strncmp(pEntry->d_name, m_cleanUpKeepPrefix, prefixLen) != 0) &&
+                    ((now - file.lastUse) >= static_cast<time_t>(m_cleanUpMinAge)) &&
+                    (strlen(pEntry->d_name) < sizeof(file.name)))
+                {
+                    Util::Strncpy(file.name, pEntry->d_name, sizeof(file.name));
+
+                    listed = listed && (files.PushBack(file) == Util::Result::Success);
+                }
+            }
+        }
+
+        closedir(pDir);
+    }
+
+    if (listed && (m_cleanUpStop == false) && (totalSize > m_cleanUpBudget))
+    {
+        const uint64_t targetSize = m_cleanUpBudget - (m_cleanUpBudget / 10);
+
+        std::sort(files.Data(), files.Data() + files.NumElements(),
+                  [](const CacheFile& a, const CacheFile& b) { return a.lastUse < b.lastUse; });
+
+        for (uint32_t i = 0; (i < files.NumElements()) && (totalSize > targetSize) && (m_cleanUpStop == false); i++)
+        {
+            const CacheFile& file = files.At(i);
+
+            // Another process may have removed or be using the file; unlinking it is safe either way
+            if ((Util::Snprintf(filePath, sizeof(filePath), "%s/%s", m_cleanUpPath, file.name) > 0) &&
+                (unlink(filePath) == 0))
+            {
+                totalSize -= file.size;
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Memory-map a read-only pipeline cache blob and index its entries, so that hits are served straight from the mapping
+// instead of being read and copied into the memory layer. Failure is not fatal; the cache simply runs without it.
+void PipelineBinaryCache::InitMappedArchive(
+    const char*            pCachePath,
+    const RuntimeSettings& settings)
+{
+    VK_ASSERT(m_pMappedArchive == nullptr);
+
+    const char* const pFileName = getenv(EnvVarMappedFileName);
+
+    // ISA replacement and instruction dropping patch the returned binary in place, which a read-only mapping can't
+    // support.
+    if ((pFileName != nullptr)                                &&
+        (settings.shaderReplaceMode != ShaderReplaceShaderISA) &&
+        (settings.enableDropPipelineBinaryInst == false))
+    {
+        char filePath[Util::PathBufferLen] = {};
+        Util::Snprintf(filePath, sizeof(filePath), "%s/%s", pCachePath, pFileName);
+
+        const int fd = open(filePath, O_RDONLY);
+
+        if (fd >= 0)
+        {
+            struct stat fileStat = {};
+
+            if ((fstat(fd, &fileStat) == 0) && (fileStat.st_size > 0))
+            {
+                const size_t fileSize = static_cast<size_t>(fileStat.st_size);
+                void*        pMapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+                if (pMapping != MAP_FAILED)
+                {
+                    m_pMappedArchive    = pMapping;
+                    m_mappedArchiveSize = fileSize;
+                }
+            }
+
+            // The mapping keeps its own reference to the file.
+            close(fd);
+        }
+
+        if ((m_pMappedArchive != nullptr) && (IndexMappedArchive() != Util::Result::Success))
+        {
+            DestroyMappedArchive();
+        }
+    }
+}
+
+// =====================================================================================================================
+// Validates the mapped blob against the platform key and builds the entry index. The blob may optionally start with
+// the public Vulkan pipeline cache header.
+Util::Result PipelineBinaryCache::IndexMappedArchive()
+{
+    const void* pBlob    = m_pMappedArchive;
+    size_t      blobSize = m_mappedArchiveSize;
+
+    if (blobSize > VkPipelineCacheHeaderDataSize)
+    {
+        const PipelineCacheHeaderData* pHeader = static_cast<const PipelineCacheHeaderData*>(pBlob);
+
+        if ((pHeader->headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE) &&
+            (pHeader->headerLength  >= VkPipelineCacheHeaderDataSize)        &&
+            (pHeader->headerLength  <  blobSize))
+        {
+            pBlob     = Util::VoidPtrInc(pBlob, pHeader->headerLength);
+            blobSize -= pHeader->headerLength;
+        }
+    }
+
+    Util::Result result = Util::Result::ErrorInvalidValue;
+
+    if (IsValidBlob(m_pAllocationCallbacks, m_pPlatformKey, blobSize, pBlob))
+    {
+        result = m_mappedEntries.Init();
+    }
+
+    if (result == Util::Result::Success)
+    {
+        constexpr size_t EntrySize = sizeof(BinaryCacheEntry);
+
+        pBlob     = Util::VoidPtrInc(pBlob, sizeof(PipelineBinaryCachePrivateHeader));
+        blobSize -= sizeof(PipelineBinaryCachePrivateHeader);
+
+        while ((result == Util::Result::Success) && (blobSize > EntrySize))
+        {
+            const BinaryCacheEntry* pEntry           = static_cast<const BinaryCacheEntry*>(pBlob);
+            const size_t            storedSize       = GetBinaryCacheEntryStoredSize(*pEntry);
+            const size_t            entryAndDataSize = storedSize + EntrySize;
+
+            if ((storedSize == 0) || (blobSize < entryAndDataSize))
+            {
+                break;
+            }
+
+            // Compressed entries can't be served in place; those are simply compiled (or found elsewhere) on demand.
+            if (IsCompressedBinaryCacheEntry(*pEntry) == false)
+            {
+                MappedEntry entry = {};
+                entry.pData       = Util::VoidPtrInc(pBlob, EntrySize);
+                entry.dataSize    = storedSize;
+                entry.isBad       = false;
+
+                result = m_mappedEntries.Insert(pEntry->hashId, entry);
+            }
+
+            pBlob     = Util::VoidPtrInc(pBlob, entryAndDataSize);
+            blobSize -= entryAndDataSize;
+        }
+    }
+
+    if ((result == Util::Result::Success) && (m_mappedEntries.GetNumEntries() == 0))
+    {
+        result = Util::Result::NotFound;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+void PipelineBinaryCache::DestroyMappedArchive()
+{
+    if (m_pMappedArchive != nullptr)
+    {
+        munmap(m_pMappedArchive, m_mappedArchiveSize);
+
+        m_pMappedArchive    = nullptr;
+        m_mappedArchiveSize = 0;
+    }
+}
+
+// =====================================================================================================================
+// Looks up an entry of the memory-mapped archive. The index is immutable after initialization, so no lock is needed.
+PipelineBinaryCache::MappedEntry* PipelineBinaryCache::FindMappedEntry(
+    const CacheId* pCacheId) const
+{
+    MappedEntry* pEntry = nullptr;
+
+    if (m_pMappedArchive != nullptr)
+    {
+        pEntry = const_cast<MappedEntryMap&>(m_mappedEntries).FindKey(*pCacheId);
+
+        if ((pEntry != nullptr) && pEntry->isBad)
+        {
+            pEntry = nullptr;
+        }
+    }
+
+    return pEntry;
+}
+
 // =====================================================================================================================
 // Initialize layers (a single layer that supports storage for binaries needs to succeed)
 VkResult PipelineBinaryCache::InitLayers(
@@ -1177,9 +2871,12 @@ VkResult PipelineBinaryCache::InitLayers(
 
     bool memoryLayerOnline = (InitMemoryCacheLayer(settings) >= VK_SUCCESS);
 
+    // Only the internal cache is shared; application caches must only hold what the application put in them.
+    bool sharedLayerOnline = createArchiveLayers && (InitSharedMemoryLayer(settings) >= VK_SUCCESS);
+
     bool archiveLayerOnline = createArchiveLayers && (InitArchiveLayers(pDefaultCacheFilePath, settings) >= VK_SUCCESS);
 
-    return (injectionLayerOnline || memoryLayerOnline || archiveLayerOnline)
+    return (injectionLayerOnline || memoryLayerOnline || sharedLayerOnline || archiveLayerOnline)
         ? VK_SUCCESS
         : VK_ERROR_INITIALIZATION_FAILED;
 }
@@ -1227,6 +2924,11 @@ VkResult PipelineBinaryCache::OrderLayers(
         result = AddLayerToChain(m_pMemoryLayer, &pBottomLayer);
     }
 
+    if (result == VK_SUCCESS)
+    {
+        result = AddLayerToChain(m_pSharedLayer, &pBottomLayer);
+    }
+
     if (result == VK_SUCCESS)
     {
         result = AddLayerToChain(m_pArchiveLayer, &pBottomLayer);
@@ -1250,6 +2952,75 @@ VkResult PipelineBinaryCache::Serialize(
     void*   pBlob,    // [out] System memory pointer where the serialized data should be placed
     size_t* pSize)    // [in,out] Size of the memory pointed to by pBlob. If the value stored in pSize is zero then no
                       // data will be copied and instead the size required for serialization will be returned in pSize
+{
+    // Unvalidated entries must not end up in a blob with a fresh, valid hash.
+    WaitForInitialDataValidation(nullptr);
+
+    if (m_incrementalSerialize == false)
+    {
+        return SerializeFull(pBlob, pSize);
+    }
+
+    Util::MutexAuto lock(&m_serializeLock);
+
+    VkResult result = UpdateSerializedBlob();
+
+    if (result != VK_SUCCESS)
+    {
+        // Start over on the next call, and serialize this one from the memory layer directly.
+        InvalidateSerializedBlob();
+        result = SerializeFull(pBlob, pSize);
+    }
+    else if (*pSize == 0)
+    {
+        *pSize = m_serializedBlobSize;
+    }
+    else if (*pSize >= m_serializedBlobSize)
+    {
+        constexpr size_t HeaderSize = sizeof(PipelineBinaryCachePrivateHeader);
+
+        auto pHeader = static_cast<PipelineBinaryCachePrivateHeader*>(pBlob);
+
+        memcpy(Util::VoidPtrInc(pBlob, HeaderSize),
+               Util::VoidPtrInc(m_pSerializedBlob, HeaderSize),
+               m_serializedBlobSize - HeaderSize);
+
+        // The retained context has already consumed every entry; finish a copy of it so more entries can follow.
+        result = VK_ERROR_OUT_OF_HOST_MEMORY;
+
+        const size_t        contextSize = m_pSerializedHashContext->GetDuplicateObjectSize();
+        void*               pContextMem = AllocMem(contextSize);
+        Util::IHashContext* pContext    = nullptr;
+
+        if ((pContextMem != nullptr) &&
+            (m_pSerializedHashContext->Duplicate(pContextMem, &pContext) == Util::Result::Success))
+        {
+            result = PalToVkResult(pContext->Finish(pHeader->hashId));
+            pContext->Destroy();
+        }
+
+        FreeMem(pContextMem);
+
+        if (result == VK_SUCCESS)
+        {
+            *pSize = m_serializedBlobSize;
+        }
+    }
+    else
+    {
+        // Only part of the blob fits; let the serializer decide which entries make it in.
+        result = SerializeFull(pBlob, pSize);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Serializes every entry of the memory layer into the memory blob provided by the calling function.
+VkResult PipelineBinaryCache::SerializeFull(
+    void*   pBlob,    // [out] System memory pointer where the serialized data should be placed
+    size_t* pSize)    // [in,out] Size of the memory pointed to by pBlob. If the value stored in pSize is zero then no
+                      // data will be copied and instead the size required for serialization will be returned in pSize
 {
     VkResult result = VK_ERROR_INITIALIZATION_FAILED;
 
@@ -1273,7 +3044,7 @@ VkResult PipelineBinaryCache::Serialize(
             if (result == VK_SUCCESS)
             {
                 PipelineBinaryCacheSerializer serializer;
-                if (serializer.Initialize(*pSize, pBlob) == Util::Result::Success)
+                if (serializer.Initialize(*pSize, pBlob, m_compressOnSerialize) == Util::Result::Success)
                 {
                     Util::AutoBuffer<Util::Hash128, 8, PalAllocator> cacheIds(curCount, &m_palAllocator);
                     result = PalToVkResult(Util::GetMemoryCacheLayerHashIds(m_pMemoryLayer, curCount, &cacheIds[0]));
@@ -1286,13 +3057,21 @@ VkResult PipelineBinaryCache::Serialize(
                         if (result == VK_SUCCESS)
                         {
                             result = PalToVkResult(serializer.AddPipelineBinary(&entry, pBinaryCacheData));
-                            FreeMem(const_cast<void*>(pBinaryCacheData));
+                            FreePipelineBinary(pBinaryCacheData);
                         }
                     }
+                    size_t bytesWritten = 0;
+
                     result = PalToVkResult(serializer.Finalize(m_pAllocationCallbacks,
                                                                m_pPlatformKey,
                                                                nullptr,
-                                                               nullptr));
+                                                               &bytesWritten));
+
+                    // Compressed entries make the blob smaller than the size reported up front.
+                    if (result == VK_SUCCESS)
+                    {
+                        *pSize = bytesWritten;
+                    }
                 }
                 else
                 {
@@ -1304,18 +3083,355 @@ VkResult PipelineBinaryCache::Serialize(
     return result;
 }
 
+// =====================================================================================================================
+// Sets up the retained blob which lets Serialize() append only the entries stored since its previous call.
+VkResult PipelineBinaryCache::InitIncrementalSerialize()
+{
+    VkResult result = PalToVkResult(m_serializedIds.Init());
+
+    if (result == VK_SUCCESS)
+    {
+        m_pSerializedHashMem = AllocMem(m_pPlatformKey->GetKeyContext()->GetDuplicateObjectSize());
+
+        result = (m_pSerializedHashMem != nullptr) ? ResetSerializedBlob() : VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    m_incrementalSerialize = (result == VK_SUCCESS);
+
+    return result;
+}
+
+// =====================================================================================================================
+void PipelineBinaryCache::DestroyIncrementalSerialize()
+{
+    if (m_pSerializedHashContext != nullptr)
+    {
+        m_pSerializedHashContext->Destroy();
+        m_pSerializedHashContext = nullptr;
+    }
+
+    FreeMem(m_pSerializedHashMem);
+    FreeMem(m_pSerializedBlob);
+
+    m_pSerializedHashMem     = nullptr;
+    m_pSerializedBlob        = nullptr;
+    m_serializedBlobCapacity = 0;
+    m_serializedBlobSize     = 0;
+    m_incrementalSerialize   = false;
+}
+
+// =====================================================================================================================
+// Records an entry that has to be appended to the retained blob by the next Serialize() call.
+void PipelineBinaryCache::TrackDirtyEntry(
+    const CacheId* pCacheId,
+    size_t         dataSize)
+{
+    const DirtyEntry entry = { *pCacheId, dataSize };
+
+    Util::MutexAuto lock(&m_dirtyEntriesLock);
+
+    if (m_dirtyEntries.PushBack(entry) != Util::Result::Success)
+    {
+        // The entry would be lost from the retained blob; rebuild it from the memory layer instead.
+        InvalidateSerializedBlob();
+    }
+}
+
+// =====================================================================================================================
+// Called when entries leave the memory layer.  The retained blob can't drop entries, so it is rebuilt on the next
+// Serialize() call.
+void PipelineBinaryCache::InvalidateSerializedBlob() const
+{
+    if (m_incrementalSerialize)
+    {
+        m_serializedBlobStale = true;
+    }
+}
+
+// =====================================================================================================================
+// Empties the retained blob and restarts its hash.  Must be called with m_serializeLock held.
+VkResult PipelineBinaryCache::ResetSerializedBlob()
+{
+    constexpr size_t HeaderSize = sizeof(PipelineBinaryCachePrivateHeader);
+
+    if (m_pSerializedHashContext != nullptr)
+    {
+        m_pSerializedHashContext->Destroy();
+        m_pSerializedHashContext = nullptr;
+    }
+
+    m_serializedIds.Reset();
+    m_serializedBlobSize = 0;
+
+    VkResult result = ReserveSerializedBlob(HeaderSize);
+
+    if (result == VK_SUCCESS)
+    {
+        // Duplicating the key context seeds the hash with the platform key, as CalculatePipelineBinaryCacheHashId does.
+        result = PalToVkResult(m_pPlatformKey->GetKeyContext()->Duplicate(m_pSerializedHashMem,
+                                                                          &m_pSerializedHashContext));
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        memset(m_pSerializedBlob, 0, HeaderSize);
+        m_serializedBlobSize = HeaderSize;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Grows the retained blob allocation to hold at least size bytes, keeping its contents.
+VkResult PipelineBinaryCache::ReserveSerializedBlob(
+    size_t size)
+{
+    constexpr size_t MinCapacity = 64 * 1024;
+
+    VkResult result = VK_SUCCESS;
+
+    if (size > m_serializedBlobCapacity)
+    {
+        const size_t newCapacity = Util::Max(Util::Max(size, m_serializedBlobCapacity * 2), MinCapacity);
+        void*        pNewBlob    = AllocMem(newCapacity);
+
+        if (pNewBlob != nullptr)
+        {
+            if (m_serializedBlobSize > 0)
+            {
+                memcpy(pNewBlob, m_pSerializedBlob, m_serializedBlobSize);
+            }
+
+            FreeMem(m_pSerializedBlob);
+
+            m_pSerializedBlob        = pNewBlob;
+            m_serializedBlobCapacity = newCapacity;
+        }
+        else
+        {
+            result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Brings the retained blob up to date with the memory layer.  Usually this only appends the entries stored since the
+// last call; after entries were evicted or marked bad the blob is rebuilt from scratch.  Must be called with
+// m_serializeLock held.
+VkResult PipelineBinaryCache::UpdateSerializedBlob()
+{
+    VkResult result = VK_SUCCESS;
+
+    if (m_serializedBlobStale)
+    {
+        m_serializedBlobStale = false;
+
+        {
+            // Everything stored from here on is picked up either by the walk below or by the dirty list.
+            Util::MutexAuto lock(&m_dirtyEntriesLock);
+            m_dirtyEntries.Clear();
+        }
+
+        size_t curCount, curDataSize;
+
+        result = ResetSerializedBlob();
+
+        if (result == VK_SUCCESS)
+        {
+            result = PalToVkResult(Util::GetMemoryCacheLayerCurSize(m_pMemoryLayer, &curCount, &curDataSize));
+        }
+
+        if ((result == VK_SUCCESS) && (curCount > 0))
+        {
+            Util::AutoBuffer<Util::Hash128, 8, PalAllocator> cacheIds(curCount, &m_palAllocator);
+
+            result = PalToVkResult(Util::GetMemoryCacheLayerHashIds(m_pMemoryLayer, curCount, &cacheIds[0]));
+
+            if (result == VK_SUCCESS)
+            {
+                result = AppendSerializedEntries(&cacheIds[0], static_cast<uint32_t>(curCount), curDataSize);
+            }
+        }
+    }
+
+    Util::Vector<CacheId, 16, PalAllocator> dirtyIds(&m_palAllocator);
+    size_t                                  dirtyDataSize = 0;
+
+    if (result == VK_SUCCESS)
+    {
+        // Take the dirty list as a whole; entries stored while appending wait for the next call.
+        Util::MutexAuto lock(&m_dirtyEntriesLock);
+
+        result = PalToVkResult(dirtyIds.Reserve(m_dirtyEntries.NumElements()));
+
+        for (uint32_t i = 0; (result == VK_SUCCESS) && (i < m_dirtyEntries.NumElements()); i++)
+        {
+            result         = PalToVkResult(dirtyIds.PushBack(m_dirtyEntries.At(i).cacheId));
+            dirtyDataSize += m_dirtyEntries.At(i).dataSize;
+        }
+
+        if (result == VK_SUCCESS)
+        {
+            m_dirtyEntries.Clear();
+        }
+    }
+
+    if ((result == VK_SUCCESS) && (dirtyIds.NumElements() > 0))
+    {
+        result = AppendSerializedEntries(&dirtyIds.At(0), dirtyIds.NumElements(), dirtyDataSize);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Appends the given entries to the retained blob, skipping entries it already contains and entries which are no
+// longer in the cache.  totalDataSize is the summed size of the entries' binaries.
+VkResult PipelineBinaryCache::AppendSerializedEntries(
+    const CacheId* pCacheIds,
+    uint32_t       count,
+    size_t         totalDataSize)
+{
+    const size_t prevSize = m_serializedBlobSize;
+
+    VkResult result = ReserveSerializedBlob(
+        prevSize + PipelineBinaryCacheSerializer::CalculateAnticipatedCacheBlobSize(count, totalDataSize));
+
+    PipelineBinaryCacheSerializer serializer;
+
+    if ((result == VK_SUCCESS) &&
+        (serializer.InitializeAppend(m_serializedBlobCapacity,
+                                     m_pSerializedBlob,
+                                     prevSize,
+                                     m_compressOnSerialize) != Util::Result::Success))
+    {
+        result = VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    for (uint32_t i = 0; (result == VK_SUCCESS) && (i < count); i++)
+    {
+        if (m_serializedIds.Contains(pCacheIds[i]))
+        {
+            continue;
+        }
+
+        const void*      pBinaryCacheData = nullptr;
+        BinaryCacheEntry entry            = { pCacheIds[i], 0 };
+
+        if (LoadPipelineBinary(&entry.hashId, &entry.dataSize, &pBinaryCacheData) == Util::Result::Success)
+        {
+            result = PalToVkResult(serializer.AddPipelineBinary(&entry, pBinaryCacheData));
+            FreePipelineBinary(pBinaryCacheData);
+
+            if (result == VK_SUCCESS)
+            {
+                result = PalToVkResult(m_serializedIds.Insert(entry.hashId));
+            }
+        }
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        m_serializedBlobSize = serializer.GetBytesUsed();
+
+        result = PalToVkResult(m_pSerializedHashContext->AddData(Util::VoidPtrInc(m_pSerializedBlob, prevSize),
+                                                                 m_serializedBlobSize - prevSize));
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Payload shared by the tasks which copy the entries of the source caches of a Merge() call.
+struct PipelineBinaryCache::MergeBatch
+{
+    PipelineBinaryCache*              pCache;
+    const PipelineBinaryCache* const* ppSrcCaches;
+    const MergeEntry*                 pEntries;
+    uint32_t                          entryCount;
+    volatile bool                     failed;      // Set if any store failed
+};
+
+// =====================================================================================================================
+// Copies one chunk of MergeChunkSize entries from their source caches into the cache.
+void PipelineBinaryCache::MergeEntriesTask(
+    void*    pPayload,
+    uint32_t taskIndex)
+{
+    MergeBatch*    pBatch = static_cast<MergeBatch*>(pPayload);
+    const uint32_t first  = taskIndex * MergeChunkSize;
+    const uint32_t last   = Util::Min(first + MergeChunkSize, pBatch->entryCount);
+
+    for (uint32_t i = first; (i < last) && (pBatch->failed == false); i++)
+    {
+        const MergeEntry&          entry     = pBatch->pEntries[i];
+        const PipelineBinaryCache* pSrcCache = pBatch->ppSrcCaches[entry.srcCacheIdx];
+        size_t                     dataSize  = 0;
+        const void*                pBinary   = nullptr;
+
+        if (pSrcCache->LoadPipelineBinary(&entry.cacheId, &dataSize, &pBinary) == Util::Result::Success)
+        {
+            const Util::Result result = pBatch->pCache->StorePipelineBinary(&entry.cacheId, dataSize, pBinary);
+
+            pSrcCache->FreePipelineBinary(pBinary);
+
+            if (Util::IsErrorResult(result))
+            {
+                pBatch->failed = true;
+            }
+        }
+    }
+}
+
 // =====================================================================================================================
 // Merge the pipeline cache data into one
 //
+// The entries of all source caches are collected first, dropping cache IDs that are already present in this cache or
+// in an earlier source, and are then copied over in chunks on the thread pool, if one is available.
 VkResult PipelineBinaryCache::Merge(
     uint32_t                    srcCacheCount,
-    const PipelineBinaryCache** ppSrcCaches)
+    const PipelineBinaryCache** ppSrcCaches,
+    CompileThreadPool*          pThreadPool)
 {
     VkResult result = VK_ERROR_INITIALIZATION_FAILED;
 
+    for (uint32_t i = 0; i < srcCacheCount; i++)
+    {
+        ppSrcCaches[i]->WaitForInitialDataValidation(nullptr);
+    }
+
     if (m_pMemoryLayer != nullptr)
     {
-        for (uint32_t i = 0; i < srcCacheCount; i++)
+        result = VK_SUCCESS;
+
+        size_t totalCount = 0;
+
+        for (uint32_t i = 0; (result == VK_SUCCESS) && (i < srcCacheCount); i++)
+        {
+            size_t curCount, curDataSize;
+
+            result      = PalToVkResult(Util::GetMemoryCacheLayerCurSize(ppSrcCaches[i]->GetMemoryLayer(),
+                                                                          &curCount,
+                                                                          &curDataSize));
+            totalCount += curCount;
+        }
+
+        Util::Vector<MergeEntry, 16, PalAllocator> entries(&m_palAllocator);
+        CacheIdSet                                 mergedIds(Util::Max(totalCount, size_t(1)), &m_palAllocator);
+
+        if ((result == VK_SUCCESS) && (totalCount > 0))
+        {
+            result = PalToVkResult(entries.Reserve(static_cast<uint32_t>(totalCount)));
+        }
+
+        if ((result == VK_SUCCESS) && (totalCount > 0))
+        {
+            result = PalToVkResult(mergedIds.Init());
+        }
+
+        for (uint32_t i = 0; (result == VK_SUCCESS) && (totalCount > 0) && (i < srcCacheCount); i++)
         {
             Util::ICacheLayer* pMemoryLayer = ppSrcCaches[i]->GetMemoryLayer();
             size_t curCount, curDataSize;
@@ -1326,27 +3442,65 @@ VkResult PipelineBinaryCache::Merge(
                 Util::AutoBuffer<Util::Hash128, 8, PalAllocator> cacheIds(curCount, &m_palAllocator);
 
                 result = PalToVkResult(Util::GetMemoryCacheLayerHashIds(pMemoryLayer, curCount, &cacheIds[0]));
-                if (result == VK_SUCCESS)
+
+                for (uint32_t j = 0; (result == VK_SUCCESS) && (j < curCount); j++)
                 {
-                    for (uint32_t j = 0; j < curCount; j++)
+                    Util::QueryResult query = {};
+
+                    if (mergedIds.Contains(cacheIds[j]) ||
+                        (m_pMemoryLayer->Query(&cacheIds[j], 0, 0, &query) == Util::Result::Success))
                     {
-                        size_t           dataSize;
-                        const void*      pBinaryCacheData;
+                        continue;
+                    }
 
-                        result = PalToVkResult(ppSrcCaches[i]->LoadPipelineBinary(&cacheIds[j], &dataSize, &pBinaryCacheData));
-                        if (result == VK_SUCCESS)
-                        {
-                            result = PalToVkResult(StorePipelineBinary(&cacheIds[j], dataSize, pBinaryCacheData));
-                            FreeMem(const_cast<void*>(pBinaryCacheData));
-                            if (result != VK_SUCCESS)
-                            {
-                                break;
-                            }
-                        }
+                    const MergeEntry entry = { cacheIds[j], i };
+
+                    result = PalToVkResult(mergedIds.Insert(cacheIds[j]));
+
+                    if (result == VK_SUCCESS)
+                    {
+                        result = PalToVkResult(entries.PushBack(entry));
                     }
                 }
             }
         }
+
+        if (m_incrementalSerialize && (result == VK_SUCCESS))
+        {
+            // Grow the dirty list once instead of on every store.
+            Util::MutexAuto lock(&m_dirtyEntriesLock);
+
+            m_dirtyEntries.Reserve(m_dirtyEntries.NumElements() + entries.NumElements());
+        }
+
+        if ((result == VK_SUCCESS) && (entries.NumElements() > 0))
+        {
+            MergeBatch batch  = {};
+            batch.pCache      = this;
+            batch.ppSrcCaches = ppSrcCaches;
+            batch.pEntries    = &entries.At(0);
+            batch.entryCount  = entries.NumElements();
+            batch.failed      = false;
+
+            const uint32_t taskCount = (batch.entryCount + MergeChunkSize - 1) / MergeChunkSize;
+
+            if ((pThreadPool != nullptr) && (taskCount > 1))
+            {
+                pThreadPool->Execute(MergeEntriesTask, &batch, taskCount);
+            }
+            else
+            {
+                for (uint32_t i = 0; i < taskCount; i++)
+                {
+                    MergeEntriesTask(&batch, i);
+                }
+            }
+
+            if (batch.failed)
+            {
+                result = VK_ERROR_OUT_OF_HOST_MEMORY;
+            }
+        }
     }
 
     return result;
@@ -0,0 +1,297 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_compile_cost_db.cpp
+* @brief Implementation of the persistent per-pipeline compile cost database.
+***********************************************************************************************************************
+*/
+#include "include/pipeline_compile_cost_db.h"
+
+#include "palHashMapImpl.h"
+
+#include <string.h>
+
+namespace vk
+{
+
+// =====================================================================================================================
+PipelineCompileCostDb::PipelineCompileCostDb(
+    PalAllocator* pAllocator)
+    :
+    m_enabled(false),
+    m_platformKey(0),
+    m_entries(1024, pAllocator),
+    m_dirty(false)
+{
+    m_filePath[0] = '\0';
+}
+
+// =====================================================================================================================
+// Reads the records of previous runs from pFilePath.  Records are only written back by Destroy().
+void PipelineCompileCostDb::Init(
+    const char* pFilePath,
+    uint64_t    platformKey)
+{
+    Util::Strncpy(m_filePath, pFilePath, sizeof(m_filePath));
+
+    m_platformKey = platformKey;
+
+    if (m_entries.Init() == Util::Result::Success)
+    {
+        m_enabled = true;
+
+        Load();
+    }
+}
+
+// =====================================================================================================================
+// Saves the records for the next run.
+void PipelineCompileCostDb::Destroy()
+{
+    if (m_enabled)
+    {
+        Save();
+
+        m_enabled = false;
+    }
+}
+
+// =====================================================================================================================
+// A missing, truncated or foreign file just leaves fewer records.
+void PipelineCompileCostDb::Load()
+{
+    Util::File file;
+    FileHeader header    = {};
+    size_t     bytesRead = 0;
+
+    if (Util::File::Exists(m_filePath) &&
+        (file.Open(m_filePath, Util::FileAccessRead | Util::FileAccessBinary) == Util::Result::Success))
+    {
+        if ((file.Read(&header, sizeof(header), &bytesRead) == Util::Result::Success) &&
+            (bytesRead == sizeof(header))                                            &&
+            (header.magic == FileMagic)                                              &&
+            (header.version == FileVersion)                                          &&
+            (header.platformKey == m_platformKey)                                    &&
+            (header.recordSize == sizeof(Record)))
+        {
+            constexpr uint32_t ChunkSize = 64;
+
+            Record         chunk[ChunkSize];
+            const uint32_t entryCount = Util::Min(header.entryCount, MaxEntries);
+
+            Util::MutexAuto lock(&m_lock);
+
+            for (uint32_t first = 0; first < entryCount; first += ChunkSize)
+            {
+                const uint32_t count = Util::Min(entryCount - first, ChunkSize);
+
+                if ((file.Read(chunk, count * sizeof(Record), &bytesRead) != Util::Result::Success) ||
+                    (bytesRead != (count * sizeof(Record))))
+                {
+                    break;
+                }
+
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    Entry entry = {};
+                    entry.record = chunk[i];
+
+                    m_entries.Insert(chunk[i].cacheId, entry);
+                }
+            }
+        }
+
+        file.Close();
+    }
+}
+
+// =====================================================================================================================
+// Rewrites the file if any record changed during this run.
+void PipelineCompileCostDb::Save()
+{
+    Util::MutexAuto lock(&m_lock);
+
+    Util::File file;
+
+    if (m_dirty && (file.Open(m_filePath, Util::FileAccessWrite | Util::FileAccessBinary) == Util::Result::Success))
+    {
+        FileHeader header = {};
+        header.magic       = FileMagic;
+        header.version     = FileVersion;
+        header.platformKey = m_platformKey;
+        header.entryCount  = m_entries.GetNumEntries();
+        header.recordSize  = sizeof(Record);
+
+        Util::Result result = file.Write(&header, sizeof(header));
+
+        for (auto it = m_entries.Begin(); (result == Util::Result::Success) && (it.Get() != nullptr); it.Next())
+        {
+            result = file.Write(&it.Get()->value.record, sizeof(Record));
+        }
+
+        VK_ALERT(result != Util::Result::Success);
+
+        file.Close();
+
+        m_dirty = false;
+    }
+}
+
+// =====================================================================================================================
+// Returns the entry of a pipeline, adding an empty one if there is room.  Must be called with m_lock held.
+PipelineCompileCostDb::Entry* PipelineCompileCostDb::FindOrAddEntry(
+    const CacheId& cacheId)
+{
+    Entry* pEntry = m_entries.FindKey(cacheId);
+
+    if ((pEntry == nullptr) && (m_entries.GetNumEntries() < MaxEntries))
+    {
+        bool existed = false;
+
+        if (m_entries.FindAllocate(cacheId, &existed, &pEntry) == Util::Result::Success)
+        {
+            memset(pEntry, 0, sizeof(*pEntry));
+            pEntry->record.cacheId = cacheId;
+        }
+        else
+        {
+            pEntry = nullptr;
+        }
+    }
+
+    return pEntry;
+}
+
+// =====================================================================================================================
+// Counts this run towards the entry's run count, once.  Must be called with m_lock held.
+void PipelineCompileCostDb::CountRun(
+    Entry* pEntry)
+{
+    if (pEntry->usedThisRun == false)
+    {
+        pEntry->usedThisRun = true;
+        pEntry->record.runCount++;
+
+        m_dirty = true;
+    }
+}
+
+// =====================================================================================================================
+// Records that a pipeline binary was compiled, and how long that took.
+void PipelineCompileCostDb::RecordCompile(
+    const CacheId&              cacheId,
+    const PipelineOptimizerKey& profileKey,
+    uint64_t                    compileUs)
+{
+    if (m_enabled)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        Entry* pEntry = FindOrAddEntry(cacheId);
+
+        if (pEntry != nullptr)
+        {
+            pEntry->record.profileKey = profileKey;
+            pEntry->record.compileUs  = Util::Max(compileUs, uint64_t(1));
+
+            m_dirty = true;
+
+            CountRun(pEntry);
+        }
+    }
+}
+
+// =====================================================================================================================
+// Records that a pipeline binary was used without compiling it.  Binaries which have never been compiled while the
+// database was enabled have no cost to go with, so they aren't added.
+void PipelineCompileCostDb::RecordUse(
+    const CacheId& cacheId)
+{
+    if (m_enabled)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        Entry* pEntry = m_entries.FindKey(cacheId);
+
+        if (pEntry != nullptr)
+        {
+            CountRun(pEntry);
+        }
+    }
+}
+
+// =====================================================================================================================
+// Returns the recorded compile time of a pipeline in microseconds, or 0 if it isn't known.
+uint64_t PipelineCompileCostDb::GetCompileCost(
+    const CacheId& cacheId) const
+{
+    uint64_t compileUs = 0;
+
+    if (m_enabled)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        const Entry* pEntry = m_entries.FindKey(cacheId);
+
+        if (pEntry != nullptr)
+        {
+            compileUs = pEntry->record.compileUs;
+        }
+    }
+
+    return compileUs;
+}
+
+// =====================================================================================================================
+// Writes the profile keys of up to maxCount pipelines which took at least minCompileUs to compile and were used in at
+// most maxRuns runs to pProfileKeys, and returns their number.
+uint32_t PipelineCompileCostDb::GetExpensiveRarePipelines(
+    uint64_t              minCompileUs,
+    uint32_t              maxRuns,
+    uint32_t              maxCount,
+    PipelineOptimizerKey* pProfileKeys) const
+{
+    uint32_t count = 0;
+
+    if (m_enabled)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        for (auto it = m_entries.Begin(); (count < maxCount) && (it.Get() != nullptr); it.Next())
+        {
+            const Record& record = it.Get()->value.record;
+
+            if ((record.compileUs >= minCompileUs) && (record.runCount <= maxRuns))
+            {
+                pProfileKeys[count++] = record.profileKey;
+            }
+        }
+    }
+
+    return count;
+}
+
+} // namespace vk
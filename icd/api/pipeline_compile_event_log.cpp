@@ -0,0 +1,148 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_compile_event_log.cpp
+* @brief Implementation of the optional log of pipeline creation events.
+***********************************************************************************************************************
+*/
+
+#include "include/pipeline_compile_event_log.h"
+#include "include/vk_device.h"
+
+#include "palSysUtil.h"
+
+namespace vk
+{
+
+static const char* SourceNames[static_cast<uint32_t>(PipelineCompileStats::Source::Count)] =
+{
+    "ApiHashCache",
+    "UserCache",
+    "InternalCache",
+    "Compiled",
+};
+
+// The address of this is unique among running threads, so it tells the creating threads apart
+static thread_local uint8_t s_threadKey;
+
+// =====================================================================================================================
+PipelineCompileEventLog::PipelineCompileEventLog(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_enabled(false),
+    m_startTicks(0),
+    m_perfFrequency(1),
+    m_eventCount(0)
+{
+}
+
+// =====================================================================================================================
+// Opens the log file if the log is enabled.
+void PipelineCompileEventLog::Init()
+{
+    const RuntimeSettings& settings = m_pDevice->GetRuntimeSettings();
+
+    if (settings.enablePipelineCompileEventLog &&
+        (m_file.Open(settings.pipelineCompileEventLogFile, Util::FileAccessAppend) == Util::Result::Success))
+    {
+        m_startTicks    = Util::GetPerfCpuTime();
+        m_perfFrequency = Util::GetPerfFrequency();
+
+        m_file.Printf("# device %p, start %llu ms\n",
+                      static_cast<const void*>(m_pDevice),
+                      static_cast<uint64_t>((m_startTicks * 1000) / m_perfFrequency));
+        m_file.Printf("timeUs,thread,apiHash,pipelineHash,source,durationUs,stages,binarySize\n");
+
+        m_enabled = true;
+    }
+}
+
+// =====================================================================================================================
+// Writes the buffered events and closes the file.  No thread may record events anymore.
+void PipelineCompileEventLog::Destroy()
+{
+    if (m_enabled)
+    {
+        m_enabled = false;
+
+        Util::MutexAuto lock(&m_lock);
+
+        WriteEvents();
+
+        m_file.Close();
+    }
+}
+
+// =====================================================================================================================
+// Adds an event to the buffer, writing the buffer out first if it is full.
+void PipelineCompileEventLog::RecordEvent(
+    const PipelineCompileEvent& event)
+{
+    const int64_t timestamp = Util::GetPerfCpuTime();
+
+    Util::MutexAuto lock(&m_lock);
+
+    if (m_eventCount == BufferSize)
+    {
+        WriteEvents();
+    }
+
+    BufferedEvent* pEvent = &m_events[m_eventCount++];
+
+    pEvent->timestamp = timestamp;
+    pEvent->pThread   = &s_threadKey;
+    pEvent->event     = event;
+}
+
+// =====================================================================================================================
+// Appends the buffered events to the file and empties the buffer.  Must be called with m_lock held.
+void PipelineCompileEventLog::WriteEvents()
+{
+    const double usPerTick = 1000000.0 / m_perfFrequency;
+
+    for (uint32_t i = 0; i < m_eventCount; ++i)
+    {
+        const BufferedEvent&        buffered = m_events[i];
+        const PipelineCompileEvent& event    = buffered.event;
+
+        const uint64_t timeUs = static_cast<uint64_t>((buffered.timestamp - m_startTicks) * usPerTick);
+
+        m_file.Printf("%llu,%p,0x%016llX,0x%016llX,%s,%llu,0x%X,%llu\n",
+                      timeUs,
+                      buffered.pThread,
+                      event.apiHash,
+                      event.pipelineHash,
+                      SourceNames[static_cast<uint32_t>(event.source)],
+                      event.durationNs / 1000,
+                      event.stages,
+                      static_cast<uint64_t>(event.binarySize));
+    }
+
+    m_eventCount = 0;
+}
+
+} // namespace vk
@@ -0,0 +1,222 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_compile_stats.cpp
+* @brief Implementation of the aggregate pipeline compile and cache statistics kept by the PipelineCompiler.
+***********************************************************************************************************************
+*/
+#include "include/pipeline_compile_stats.h"
+
+#include "palInlineFuncs.h"
+#include "palJsonWriter.h"
+#include "palSysUtil.h"
+
+#include <string.h>
+
+namespace vk
+{
+
+static constexpr const char* StageNames[] =
+{
+    "convert",
+    "hash",
+    "cacheLookup",
+    "compile",
+    "upload",
+};
+
+static_assert(VK_ARRAY_SIZE(StageNames) == static_cast<uint32_t>(PipelineCompileStats::Stage::Count),
+              "Stage names don't match the stages");
+
+static constexpr const char* SourceNames[] =
+{
+    "apiHashCache",
+    "userCache",
+    "internalCache",
+    "compiled",
+};
+
+static_assert(VK_ARRAY_SIZE(SourceNames) == static_cast<uint32_t>(PipelineCompileStats::Source::Count),
+              "Source names don't match the sources");
+
+// =====================================================================================================================
+PipelineCompileStats::PipelineCompileStats()
+    :
+    m_perfFrequency(Util::GetPerfFrequency()),
+    m_specEntries(0),
+    m_specDroppedEntries(0)
+{
+    memset(&m_stages[0], 0, sizeof(m_stages));
+    memset(const_cast<uint64_t*>(&m_binaryCount[0]), 0, sizeof(m_binaryCount));
+    memset(const_cast<uint64_t*>(&m_binaryBytes[0]), 0, sizeof(m_binaryBytes));
+}
+
+// =====================================================================================================================
+// Adds a sample, in perf counter ticks, to the latency histogram of a stage.
+void PipelineCompileStats::RecordStageTime(
+    Stage   stage,
+    int64_t ticks)
+{
+    StageStats*    pStats = &m_stages[static_cast<uint32_t>(stage)];
+    const uint64_t us     = static_cast<uint64_t>(Util::Max(ticks, int64_t(0)) * 1000000) / m_perfFrequency;
+
+    Util::AtomicIncrement64(&pStats->count);
+    Util::AtomicAdd64(&pStats->totalUs, us);
+    Util::AtomicIncrement64(&pStats->buckets[GetBucket(us)]);
+}
+
+// =====================================================================================================================
+// Counts the map entries of a shader stage's specialization info, and those which were dropped because they have no
+// effect on the code.
+void PipelineCompileStats::RecordSpecialization(
+    uint32_t entryCount,
+    uint32_t droppedCount)
+{
+    Util::AtomicAdd64(&m_specEntries, entryCount);
+    Util::AtomicAdd64(&m_specDroppedEntries, droppedCount);
+}
+
+// =====================================================================================================================
+// Counts a pipeline binary handed out by the compiler.
+void PipelineCompileStats::RecordBinary(
+    Source source,
+    size_t binarySize)
+{
+    Util::AtomicIncrement64(&m_binaryCount[static_cast<uint32_t>(source)]);
+    Util::AtomicAdd64(&m_binaryBytes[static_cast<uint32_t>(source)], binarySize);
+}
+
+// =====================================================================================================================
+// Values below SubBucketCount get a bin each; above that, every power of two is split into SubBucketCount bins.
+uint32_t PipelineCompileStats::GetBucket(
+    uint64_t us)
+{
+    uint32_t bucket = static_cast<uint32_t>(us);
+
+    if (us >= SubBucketCount)
+    {
+        const uint32_t msb = Util::Log2(us);
+        const uint32_t sub = static_cast<uint32_t>(us >> (msb - SubBucketBits)) & (SubBucketCount - 1);
+
+        bucket = ((msb - SubBucketBits + 1) * SubBucketCount) + sub;
+    }
+
+    return Util::Min(bucket, BucketCount - 1);
+}
+
+// =====================================================================================================================
+// Returns the exclusive upper bound, in microseconds, of the samples counted in a bin.
+uint64_t PipelineCompileStats::GetBucketUpperBound(
+    uint32_t bucket)
+{
+    uint64_t bound = bucket + 1;
+
+    if (bucket >= SubBucketCount)
+    {
+        const uint32_t shift = (bucket / SubBucketCount) - 1;
+        const uint64_t sub   = bucket % SubBucketCount;
+
+        bound = (SubBucketCount + sub + 1) << shift;
+    }
+
+    return bound;
+}
+
+// =====================================================================================================================
+// Estimates a latency percentile of a stage from its histogram.  Reports the upper bound of the bin holding the sample.
+double PipelineCompileStats::GetPercentileMs(
+    const StageStats& stats,
+    uint32_t          percentile)
+{
+    const uint64_t count  = stats.count;
+    const uint64_t target = ((count * percentile) + 99) / 100;
+
+    uint64_t seen   = 0;
+    uint32_t bucket = 0;
+
+    for (; bucket < (BucketCount - 1); ++bucket)
+    {
+        seen += stats.buckets[bucket];
+
+        if ((seen >= target) && (seen > 0))
+        {
+            break;
+        }
+    }
+
+    return (count > 0) ? (GetBucketUpperBound(bucket) / 1000.0) : 0.0;
+}
+
+// =====================================================================================================================
+// Writes the stats as the members of the JSON map the writer is currently in.  The counters keep running while they
+// are read, so the members of a snapshot may be off by the few pipelines that were in flight.
+void PipelineCompileStats::Write(
+    Util::JsonWriter* pWriter) const
+{
+    pWriter->KeyAndBeginMap("stages", false);
+
+    for (uint32_t i = 0; i < static_cast<uint32_t>(Stage::Count); ++i)
+    {
+        const StageStats& stats = m_stages[i];
+
+        pWriter->KeyAndBeginMap(StageNames[i], false);
+        pWriter->KeyAndValue("count", stats.count);
+        pWriter->KeyAndValue("totalMs", stats.totalUs / 1000.0);
+        pWriter->KeyAndValue("p50Ms", GetPercentileMs(stats, 50));
+        pWriter->KeyAndValue("p99Ms", GetPercentileMs(stats, 99));
+        pWriter->EndMap();
+    }
+
+    pWriter->EndMap();
+
+    uint64_t totalBinaries = 0;
+
+    pWriter->KeyAndBeginMap("binaries", false);
+
+    for (uint32_t i = 0; i < static_cast<uint32_t>(Source::Count); ++i)
+    {
+        totalBinaries += m_binaryCount[i];
+
+        pWriter->KeyAndBeginMap(SourceNames[i], true);
+        pWriter->KeyAndValue("count", m_binaryCount[i]);
+        pWriter->KeyAndValue("bytes", m_binaryBytes[i]);
+        pWriter->EndMap();
+    }
+
+    pWriter->EndMap();
+
+    const uint64_t compiled = m_binaryCount[static_cast<uint32_t>(Source::Compiled)];
+
+    pWriter->KeyAndValue("cacheHitRate",
+                         (totalBinaries > 0) ? (static_cast<double>(totalBinaries - compiled) / totalBinaries) : 0.0);
+
+    pWriter->KeyAndBeginMap("specialization", true);
+    pWriter->KeyAndValue("entries", m_specEntries);
+    pWriter->KeyAndValue("droppedEntries", m_specDroppedEntries);
+    pWriter->EndMap();
+}
+
+} // namespace vk
@@ -30,6 +30,8 @@
  */
 #include "include/log.h"
 #include "include/pipeline_compiler.h"
+#include "include/startup_profile.h"
+#include "include/vk_conv.h"
 #include "include/vk_device.h"
 #include "include/vk_physical_device.h"
 #include "include/vk_shader.h"
@@ -37,9 +39,12 @@
 #include "include/vk_pipeline_layout.h"
 #include "include/vk_render_pass.h"
 #include "include/vk_graphics_pipeline.h"
+#include "utils/json_writer.h"
 #include <vector>
 
+#include "palAutoBuffer.h"
 #include "palFile.h"
+#include "palHashMapImpl.h"
 #include "palHashSetImpl.h"
 
 #include "include/pipeline_binary_cache.h"
@@ -63,10 +68,15 @@ PipelineCompiler::PipelineCompiler(
     m_pPhysicalDevice(pPhysicalDevice)
     , m_compilerSolutionLlpc(pPhysicalDevice)
     , m_pBinaryCache(nullptr)
+    , m_apiHashMap(ApiHashMapBuckets, pPhysicalDevice->VkInstance()->Allocator())
+    , m_settingsHash(0)
     , m_cacheAttempts(0)
     , m_cacheHits(0)
     , m_totalBinaries(0)
     , m_totalTimeSpent(0)
+    , m_replaceShaders(64, pPhysicalDevice->VkInstance()->Allocator())
+    , m_replacePipelines(64, pPhysicalDevice->VkInstance()->Allocator())
+    , m_dumpWriter(pPhysicalDevice->VkInstance())
 {
 
 }
@@ -96,6 +106,147 @@ void PipelineCompiler::GetElfCacheMetricString(
         "Average time spent per request - %0.3f ms\n";
 
     Util::Snprintf(pOutStr, outStrSize, metricFmtString, hitRate * 100, m_totalBinaries, totalMs, avgMs);
+
+    if (m_pBinaryCache != nullptr)
+    {
+        PipelineBinaryCache::CacheStats stats = {};
+        m_pBinaryCache->GetStats(&stats);
+
+        static constexpr char binaryCacheFmtString[] =
+            "Internal cache hits - %" PRIu64 "\n"
+            "Internal cache misses - %" PRIu64 "\n"
+            "Internal cache evictions - %" PRIu64 "\n"
+            "Internal cache resident size - %0.1f MB\n"
+            "Internal cache layer hits - memory %" PRIu64 ", shared %" PRIu64 ", archive %" PRIu64
+            ", mapped %" PRIu64 "\n"
+            "Internal cache deduplicated stores - %" PRIu64 " (%0.1f MB)\n";
+
+        const size_t length = strlen(pOutStr);
+
+        Util::Snprintf(pOutStr + length,
+                       outStrSize - length,
+                       binaryCacheFmtString,
+                       stats.hits,
+                       stats.misses,
+                       stats.evictions,
+                       stats.residentSize / (1024.0 * 1024.0),
+                       stats.memoryHits,
+                       stats.sharedHits,
+                       stats.archiveHits,
+                       stats.mappedHits,
+                       stats.dedupedStores,
+                       stats.dedupedBytes / (1024.0 * 1024.0));
+    }
+}
+
+// =====================================================================================================================
+// Feeds the outcome of a Create*PipelineBinary() call into the compile stats and the device's perf counters.
+void PipelineCompiler::RecordBinaryStats(
+    Device*  pDevice,
+    VkResult result,
+    bool     compiled,
+    bool     isUserCacheHit,
+    bool     isInternalCacheHit,
+    int64_t  hashTime,
+    int64_t  compileTime,
+    size_t   binarySize)
+{
+    PerfCounterRegistry* pPerfCounters = pDevice->GetPerfCounters();
+
+    m_compileStats.RecordStageTime(PipelineCompileStats::Stage::Hash, hashTime);
+
+    if (result == VK_SUCCESS)
+    {
+        if (compiled)
+        {
+            m_compileStats.RecordStageTime(PipelineCompileStats::Stage::Compile, compileTime);
+            m_compileStats.RecordBinary(PipelineCompileStats::Source::Compiled, binarySize);
+
+            pPerfCounters->Add(PerfCounter::PipelinesCompiled);
+            pPerfCounters->Sample(PerfHistogram::PipelineCompileTimeUs,
+                                  (static_cast<uint64_t>(compileTime) * 1000000) / Util::GetPerfFrequency());
+        }
+        else if (isUserCacheHit)
+        {
+            m_compileStats.RecordBinary(PipelineCompileStats::Source::UserCache, binarySize);
+
+            pPerfCounters->Add(PerfCounter::PipelineUserCacheHits);
+        }
+        else if (isInternalCacheHit)
+        {
+            m_compileStats.RecordBinary(PipelineCompileStats::Source::InternalCache, binarySize);
+
+            pPerfCounters->Add(PerfCounter::PipelineInternalCacheHits);
+        }
+    }
+}
+
+// =====================================================================================================================
+// Feeds a pipeline binary which was compiled (or served from a cache, if compiled is false) into the compile cost
+// database of the internal cache.
+void PipelineCompiler::RecordCompileCost(
+    const Util::MetroHash::Hash& cacheId,
+    const PipelineOptimizerKey&  profileKey,
+    bool                         compiled,
+    int64_t                      compileTime)
+{
+    PipelineCompileCostDb* pCostDb = m_pBinaryCache->GetCompileCostDb();
+
+    if (pCostDb != nullptr)
+    {
+        if (compiled)
+        {
+            const uint64_t compileUs = (static_cast<uint64_t>(compileTime) * 1000000) / Util::GetPerfFrequency();
+
+            pCostDb->RecordCompile(cacheId, profileKey, compileUs);
+        }
+        else
+        {
+            pCostDb->RecordUse(cacheId);
+        }
+    }
+}
+
+// =====================================================================================================================
+// Appends a JSON snapshot of the compile stats and the internal cache's per-layer hit counts to a file.
+void PipelineCompiler::WriteCompileStats(
+    const char* pFilePath)
+{
+    utils::JsonOutputStream stream(pFilePath);
+    Util::JsonWriter        writer(&stream);
+
+    const int64_t freq = Util::GetPerfFrequency();
+
+    writer.BeginMap(false);
+    writer.KeyAndValue("timestampMs", static_cast<uint64_t>((Util::GetPerfCpuTime() * 1000) / freq));
+
+    m_compileStats.Write(&writer);
+
+    if (m_pBinaryCache != nullptr)
+    {
+        PipelineBinaryCache::CacheStats stats = {};
+        m_pBinaryCache->GetStats(&stats);
+
+        writer.KeyAndBeginMap("internalCache", false);
+        writer.KeyAndValue("hits", stats.hits);
+        writer.KeyAndValue("misses", stats.misses);
+        writer.KeyAndValue("evictions", stats.evictions);
+        writer.KeyAndValue("residentBytes", static_cast<uint64_t>(stats.residentSize));
+
+        writer.KeyAndBeginMap("layerHits", true);
+        writer.KeyAndValue("memory", stats.memoryHits);
+        writer.KeyAndValue("shared", stats.sharedHits);
+        writer.KeyAndValue("archive", stats.archiveHits);
+        writer.KeyAndValue("mapped", stats.mappedHits);
+        writer.EndMap();
+
+        writer.KeyAndValue("dedupedStores", stats.dedupedStores);
+        writer.KeyAndValue("dedupedBytes", stats.dedupedBytes);
+
+        writer.EndMap();
+    }
+
+    writer.EndMap();
 }
 
 // =====================================================================================================================
@@ -108,6 +259,27 @@ void PipelineCompiler::DestroyPipelineBinaryCache()
     }
 }
 
+// =====================================================================================================================
+// Writes out pipeline binaries still queued for the on-disk cache.  The internal cache outlives devices, but the
+// application may exit without destroying the instance.
+void PipelineCompiler::FlushPipelineBinaryCache()
+{
+    if (m_pBinaryCache != nullptr)
+    {
+        m_pBinaryCache->FlushWriteBack();
+    }
+}
+
+// =====================================================================================================================
+// Starts loading the pipelines recorded in the internal cache's prewarm manifest in the background.
+void PipelineCompiler::StartPipelinePrewarm()
+{
+    if (m_pBinaryCache != nullptr)
+    {
+        m_pBinaryCache->StartPrewarm();
+    }
+}
+
 // =====================================================================================================================
 PipelineCompiler::~PipelineCompiler()
 {
@@ -118,6 +290,8 @@ PipelineCompiler::~PipelineCompiler()
 // Initializes pipeline compiler.
 VkResult PipelineCompiler::Initialize()
 {
+    StartupPhase startupPhase("PipelineCompiler::Initialize");
+
     Pal::IDevice* pPalDevice        = m_pPhysicalDevice->PalDevice();
     const RuntimeSettings& settings = m_pPhysicalDevice->GetRuntimeSettings();
 
@@ -182,21 +356,61 @@ VkResult PipelineCompiler::Initialize()
 #endif
                 0,
                 nullptr,
-                settings.enableOnDiskInternalPipelineCaches);
+                true,
+                settings.enableOnDiskInternalPipelineCaches,
+                nullptr);
 
         // This isn't a terminal failure, the device can continue without the pipeline cache if need be.
         VK_ALERT(m_pBinaryCache == nullptr);
         if (m_pBinaryCache != nullptr)
         {
+            const size_t memoryBudget = static_cast<size_t>(settings.internalPipelineCacheMemoryBudget) * 1024 * 1024;
+
+            // Running unbounded is not a terminal failure either.
+            VkResult budgetResult = m_pBinaryCache->SetMemoryBudget(memoryBudget);
+            VK_ALERT(budgetResult != VK_SUCCESS);
+
             pCacheAdapter = m_pBinaryCache->GetCacheAdapter();
         }
     }
 
+    if (result == VK_SUCCESS)
+    {
+        result = PalToVkResult(m_apiHashMap.Init());
+    }
+
+    // Compute pipeline API hash records outlive the process, so they must not be reused by a driver configured to
+    // build different binaries.  The settings applied through the shader and pipeline options are covered by the key
+    // itself; this only needs the settings which the compute cache ID takes in beside the options.
+    Util::MetroHash64 settingsHasher;
+    settingsHasher.Update(settings.forceCsThreadGroupSwizzleMode);
+    settingsHasher.Update(settings.pipelineUseShaderHashAsProfileHash);
+    settingsHasher.Update(reinterpret_cast<const uint8_t*>(settings.llpcOptions), sizeof(settings.llpcOptions));
+
+    Util::MetroHash::Hash settingsHash = {};
+    settingsHasher.Finalize(settingsHash.bytes);
+    m_settingsHash = Util::MetroHash::Compact64(&settingsHash);
+
     if (result == VK_SUCCESS)
     {
         result = m_compilerSolutionLlpc.Initialize(m_gfxIp, info.gfxLevel, pCacheAdapter);
     }
 
+    if ((result == VK_SUCCESS) &&
+        ((settings.shaderReplaceMode == ShaderReplaceShaderHash)         ||
+         (settings.shaderReplaceMode == ShaderReplaceShaderPipelineHash) ||
+         (settings.shaderReplaceMode == ShaderReplacePipelineBinaryHash)))
+    {
+        LoadReplaceBinaries();
+    }
+
+    if ((result == VK_SUCCESS) && settings.enablePipelineDump && settings.enableAsyncPipelineDump)
+    {
+        // Not fatal, dumps are finished synchronously without the writer thread.
+        VkResult writerResult = m_dumpWriter.Init(m_gfxIp);
+        VK_ALERT(writerResult != VK_SUCCESS);
+    }
+
     return result;
 }
 
@@ -204,9 +418,22 @@ VkResult PipelineCompiler::Initialize()
 // Destroys all compiler instance.
 void PipelineCompiler::Destroy()
 {
+    const RuntimeSettings& settings = m_pPhysicalDevice->GetRuntimeSettings();
+
+    if (settings.dumpPipelineCompileStats)
+    {
+        WriteCompileStats(settings.pipelineCompileStatsFile);
+    }
+
+    m_dumpWriter.Destroy();
+
+    DestroyReplaceBinaries();
+
     m_compilerSolutionLlpc.Destroy();
 
     DestroyPipelineBinaryCache();
+
+    DestroyApiHashMap();
 }
 
 // =====================================================================================================================
@@ -241,38 +468,185 @@ PipelineCompilerType PipelineCompiler::GetShaderCacheType()
 }
 
 // =====================================================================================================================
-// Loads shader binary  from replace shader folder with specified shader hash code.
-bool PipelineCompiler::LoadReplaceShaderBinary(
-    uint64_t shaderHash,
-    size_t*  pCodeSize,
-    void**   ppCode)
+// Returns the length of the name part of a replacement file name with the given suffix, or zero for other files.
+static size_t GetReplaceNameLength(
+    const char* pFileName,
+    const char* pSuffix)
 {
-    auto pInstance = m_pPhysicalDevice->Manager()->VkInstance();
-    const RuntimeSettings* pSettings = &m_pPhysicalDevice->GetRuntimeSettings();
-    bool findShader = false;
+    const size_t fileNameLength = strlen(pFileName);
+    const size_t suffixLength   = strlen(pSuffix);
 
-    char replaceFileName[Pal::MaxPathStrLen] = {};
-    Util::Snprintf(replaceFileName, sizeof(replaceFileName), "%s/Shader_0x%016llX_replace.spv",
-        pSettings->shaderReplaceDir, shaderHash);
+    return ((fileNameLength > suffixLength) && (strcmp(pFileName + fileNameLength - suffixLength, pSuffix) == 0)) ?
+           (fileNameLength - suffixLength) : 0;
+}
+
+// =====================================================================================================================
+// Hashes the pipeline name of a <pipeline name>_replace.elf file.
+uint64_t PipelineCompiler::GetReplacePipelineKey(
+    const char* pName,
+    size_t      nameLength)
+{
+    Util::MetroHash::Hash hash = {};
+    Util::MetroHash64::Hash(reinterpret_cast<const uint8_t*>(pName), nameLength, hash.bytes);
+
+    return Util::MetroHash::Compact64(&hash);
+}
 
-    Util::File replaceFile;
-    if (replaceFile.Open(replaceFileName, Util::FileAccessRead | Util::FileAccessBinary) == Util::Result::Success)
+// =====================================================================================================================
+// Reads every shader and pipeline binary replacement file in ShaderReplaceDir into memory, so that shader module and
+// pipeline creation only need a hash lookup.  Files added to the directory later are not picked up.
+void PipelineCompiler::LoadReplaceBinaries()
+{
+    const RuntimeSettings& settings  = m_pPhysicalDevice->GetRuntimeSettings();
+    Instance*              pInstance = m_pPhysicalDevice->Manager()->VkInstance();
+
+    uint32_t     fileCount          = 0;
+    size_t       fileNameBufferSize = 0;
+    const char** ppFileNames        = nullptr;
+    void*        pFileNameBuffer    = nullptr;
+
+    Util::Result result = m_replaceShaders.Init();
+
+    if (result == Util::Result::Success)
     {
-        size_t replaceCodeSize = replaceFile.GetFileSize(replaceFileName);
-        auto pReplaceCode = pInstance->AllocMem(replaceCodeSize,
-            VK_DEFAULT_MEM_ALIGN,
-            VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+        result = m_replacePipelines.Init();
+    }
 
-        size_t readBytes = 0;
-        replaceFile.Read(pReplaceCode, replaceCodeSize, &readBytes);
-        VK_ASSERT(readBytes == replaceCodeSize);
+    // Get the number of files in the directory and the size of the buffer to hold their names
+    if (result == Util::Result::Success)
+    {
+        result = Util::ListDir(settings.shaderReplaceDir, &fileCount, nullptr, &fileNameBufferSize, nullptr);
+    }
+
+    if ((result == Util::Result::Success) && (fileCount > 0))
+    {
+        ppFileNames     = static_cast<const char**>(pInstance->AllocMem(sizeof(const char*) * fileCount,
+                                                                        VK_SYSTEM_ALLOCATION_SCOPE_COMMAND));
+        pFileNameBuffer = pInstance->AllocMem(fileNameBufferSize, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+
+        result = ((ppFileNames != nullptr) && (pFileNameBuffer != nullptr)) ?
+                 Util::ListDir(settings.shaderReplaceDir, &fileCount, ppFileNames, &fileNameBufferSize,
+                               pFileNameBuffer) :
+                 Util::Result::ErrorOutOfMemory;
+
+        for (uint32_t i = 0; (result == Util::Result::Success) && (i < fileCount); ++i)
+        {
+            const char*       pFileName = ppFileNames[i];
+            ReplaceBinaryMap* pMap      = nullptr;
+            uint64_t          key       = 0;
+
+            const size_t shaderNameLength   = GetReplaceNameLength(pFileName, "_replace.spv");
+            const size_t pipelineNameLength = GetReplaceNameLength(pFileName, "_replace.elf");
+
+            // Same names as LoadReplaceShaderBinary() and ReplacePipelineBinary() used to open
+            if ((shaderNameLength > 0) && (strncmp(pFileName, "Shader_0x", 9) == 0))
+            {
+                char* pEnd = nullptr;
+
+                key  = strtoull(pFileName + 9, &pEnd, 16);
+                pMap = (pEnd == (pFileName + shaderNameLength)) ? &m_replaceShaders : nullptr;
+            }
+            else if (pipelineNameLength > 0)
+            {
+                key  = GetReplacePipelineKey(pFileName, pipelineNameLength);
+                pMap = &m_replacePipelines;
+            }
 
-        *ppCode = pReplaceCode;
-        *pCodeSize = replaceCodeSize;
-        findShader = true;
+            char filePath[Pal::MaxPathStrLen] = {};
+            Util::Snprintf(filePath, sizeof(filePath), "%s/%s", settings.shaderReplaceDir, pFileName);
+
+            Util::File file;
+
+            if ((pMap != nullptr) &&
+                (file.Open(filePath, Util::FileAccessRead | Util::FileAccessBinary) == Util::Result::Success))
+            {
+                ReplaceBinary binary = {};
+
+                binary.codeSize = Util::File::GetFileSize(filePath);
+                binary.pCode    = pInstance->AllocMem(binary.codeSize,
+                                                      VK_DEFAULT_MEM_ALIGN,
+                                                      VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
+
+                if (binary.pCode == nullptr)
+                {
+                    result = Util::Result::ErrorOutOfMemory;
+                }
+                else if ((file.Read(binary.pCode, binary.codeSize, nullptr) != Util::Result::Success) ||
+                         (pMap->Insert(key, binary) != Util::Result::Success))
+                {
+                    pInstance->FreeMem(binary.pCode);
+                }
+            }
+        }
     }
 
-    return findShader;
+    VK_ALERT(result != Util::Result::Success);
+
+    pInstance->FreeMem(pFileNameBuffer);
+    pInstance->FreeMem(ppFileNames);
+}
+
+// =====================================================================================================================
+void PipelineCompiler::DestroyReplaceBinaries()
+{
+    Instance* pInstance = m_pPhysicalDevice->Manager()->VkInstance();
+
+    ReplaceBinaryMap* maps[] = { &m_replaceShaders, &m_replacePipelines };
+
+    for (ReplaceBinaryMap* pMap : maps)
+    {
+        if (pMap->GetNumEntries() > 0)
+        {
+            for (auto it = pMap->Begin(); it.Get() != nullptr; it.Next())
+            {
+                pInstance->FreeMem(it.Get()->value.pCode);
+            }
+
+            pMap->Reset();
+        }
+    }
+}
+
+// =====================================================================================================================
+// Returns a copy of a preloaded replacement binary, which the caller frees.
+bool PipelineCompiler::CopyReplaceBinary(
+    const ReplaceBinaryMap&  map,
+    uint64_t                 key,
+    VkSystemAllocationScope  allocScope,
+    size_t*                  pCodeSize,
+    void**                   ppCode)
+{
+    bool found = false;
+
+    const ReplaceBinary* pBinary = (map.GetNumEntries() > 0) ? map.FindKey(key) : nullptr;
+
+    if (pBinary != nullptr)
+    {
+        void* pCode = m_pPhysicalDevice->Manager()->VkInstance()->AllocMem(pBinary->codeSize,
+                                                                           VK_DEFAULT_MEM_ALIGN,
+                                                                           allocScope);
+
+        if (pCode != nullptr)
+        {
+            memcpy(pCode, pBinary->pCode, pBinary->codeSize);
+
+            *ppCode    = pCode;
+            *pCodeSize = pBinary->codeSize;
+            found      = true;
+        }
+    }
+
+    return found;
+}
+
+// =====================================================================================================================
+// Loads shader binary from replace shader folder with specified shader hash code.
+bool PipelineCompiler::LoadReplaceShaderBinary(
+    uint64_t shaderHash,
+    size_t*  pCodeSize,
+    void**   ppCode)
+{
+    return CopyReplaceBinary(m_replaceShaders, shaderHash, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT, pCodeSize, ppCode);
 }
 
 // =====================================================================================================================
@@ -334,37 +708,23 @@ bool PipelineCompiler::ReplacePipelineBinary(
         const void**             ppPipelineBinary,
         uint64_t                 hashCode64)
 {
-    const RuntimeSettings& settings  = m_pPhysicalDevice->GetRuntimeSettings();
-    auto                   pInstance = m_pPhysicalDevice->Manager()->VkInstance();
-
     char fileName[Pal::MaxFileNameStrLen] = {};
     Vkgc::IPipelineDumper::GetPipelineName(pPipelineBuildInfo, fileName, sizeof(fileName), hashCode64);
 
-    char replaceFileName[Pal::MaxPathStrLen] = {};
-    int32_t length = Util::Snprintf(replaceFileName, sizeof(replaceFileName), "%s/%s_replace.elf", settings.shaderReplaceDir, fileName);
-    VK_ASSERT(length > 0 && (static_cast<uint32_t>(length) < sizeof(replaceFileName)));
-
-    Util::Result result = Util::File::Exists(replaceFileName) ? Util::Result::Success : Util::Result::ErrorUnavailable;
-    if (result == Util::Result::Success)
-    {
-        Util::File elfFile;
-        result = elfFile.Open(replaceFileName, Util::FileAccessRead | Util::FileAccessBinary);
-        if (result == Util::Result::Success)
-        {
-            size_t binSize = Util::File::GetFileSize(replaceFileName);
-            void *pAllocBuf = pInstance->AllocMem(
-                binSize,
-                VK_DEFAULT_MEM_ALIGN,
-                VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+    void* pBinary = nullptr;
 
-            elfFile.Read(pAllocBuf, binSize, nullptr);
+    const bool found = CopyReplaceBinary(m_replacePipelines,
+                                         GetReplacePipelineKey(fileName, strlen(fileName)),
+                                         VK_SYSTEM_ALLOCATION_SCOPE_COMMAND,
+                                         pPipelineBinarySize,
+                                         &pBinary);
 
-            *pPipelineBinarySize = binSize;
-            *ppPipelineBinary = pAllocBuf;
-            return true;
-        }
+    if (found)
+    {
+        *ppPipelineBinary = pBinary;
     }
-    return false;
+
+    return found;
 }
 
 // =====================================================================================================================
@@ -584,7 +944,10 @@ Util::Result PipelineCompiler::GetCachedPipelineBinary(
     }
     if (*pIsUserCacheHit || *pIsInternalCacheHit)
     {
-        *pFreeCompilerBinary = FreeWithInstanceAllocator;
+        // Binaries served from a memory-mapped archive are owned by the cache.
+        const bool isMappedBinary = (*pIsUserCacheHit == false) && m_pBinaryCache->IsMappedBinary(*ppPipelineBinary);
+
+        *pFreeCompilerBinary = isMappedBinary ? DoNotFree : FreeWithInstanceAllocator;
         cacheResult = Util::Result::Success;
         m_cacheHits++;
     }
@@ -630,7 +993,9 @@ VkResult PipelineCompiler::CreateGraphicsPipelineBinary(
     const RuntimeSettings& settings      = m_pPhysicalDevice->GetRuntimeSettings();
 
     int64_t compileTime = 0;
+    const int64_t hashStartTime = Util::GetPerfCpuTime();
     uint64_t pipelineHash = Vkgc::IPipelineDumper::GetPipelineHash(&pCreateInfo->pipelineInfo);
+    int64_t hashTime = Util::GetPerfCpuTime() - hashStartTime;
 
     void* pPipelineDumpHandle = nullptr;
     const void* moduleDataBaks[ShaderStage::ShaderStageGfxCount];
@@ -727,6 +1092,9 @@ VkResult PipelineCompiler::CreateGraphicsPipelineBinary(
         }
         hash.Finalize(pCacheId->bytes);
 
+        const int64_t lookupStartTime = Util::GetPerfCpuTime();
+        hashTime += lookupStartTime - startTime;
+
         cacheResult = GetCachedPipelineBinary(pCacheId, pPipelineBinaryCache, pPipelineBinarySize, ppPipelineBinary,
             &isUserCacheHit, &isInternalCacheHit, &pCreateInfo->freeCompilerBinary, &pCreateInfo->pipelineFeedback);
         if (cacheResult == Util::Result::Success)
@@ -735,6 +1103,9 @@ VkResult PipelineCompiler::CreateGraphicsPipelineBinary(
         }
 
         cacheTime = Util::GetPerfCpuTime() - startTime;
+
+        m_compileStats.RecordStageTime(PipelineCompileStats::Stage::CacheLookup,
+                                       (startTime + cacheTime) - lookupStartTime);
     }
 
     if (shouldCompile)
@@ -793,9 +1164,23 @@ VkResult PipelineCompiler::CreateGraphicsPipelineBinary(
         VK_ASSERT(Util::IsErrorResult(cacheResult) == false);
     }
 
+    if ((m_pBinaryCache != nullptr) && (result == VK_SUCCESS))
+    {
+        m_pBinaryCache->RecordPrewarmEntry(pCacheId);
+
+        RecordCompileCost(*pCacheId, pCreateInfo->pipelineProfileKey, shouldCompile, compileTime);
+    }
+
     m_totalTimeSpent += shouldCompile ? compileTime : cacheTime;
     m_totalBinaries++;
 
+    RecordBinaryStats(pDevice, result, shouldCompile, isUserCacheHit, isInternalCacheHit, hashTime, compileTime,
+                      *pPipelineBinarySize);
+
+    pCreateInfo->binarySource = shouldCompile  ? PipelineCompileStats::Source::Compiled :
+                                isUserCacheHit ? PipelineCompileStats::Source::UserCache :
+                                                 PipelineCompileStats::Source::InternalCache;
+
     if (settings.shaderReplaceMode == ShaderReplaceShaderISA)
     {
         ReplacePipelineIsaCode(pDevice, pipelineHash, 0, *ppPipelineBinary, *pPipelineBinarySize);
@@ -803,14 +1188,9 @@ VkResult PipelineCompiler::CreateGraphicsPipelineBinary(
 
     if (settings.enablePipelineDump && (pPipelineDumpHandle != nullptr))
     {
-        if (result == VK_SUCCESS)
-        {
-            Vkgc::BinaryData pipelineBinary = {};
-            pipelineBinary.codeSize = *pPipelineBinarySize;
-            pipelineBinary.pCode = *ppPipelineBinary;
-            Vkgc::IPipelineDumper::DumpPipelineBinary(pPipelineDumpHandle, m_gfxIp, &pipelineBinary);
-        }
-        Vkgc::IPipelineDumper::EndPipelineDump(pPipelineDumpHandle);
+        m_dumpWriter.FinishDump(pPipelineDumpHandle,
+                                (result == VK_SUCCESS) ? *ppPipelineBinary : nullptr,
+                                *pPipelineBinarySize);
     }
 
     if (shaderModuleReplaced)
@@ -845,7 +1225,9 @@ VkResult PipelineCompiler::CreateComputePipelineBinary(
     pCreateInfo->pipelineInfo.deviceIndex = deviceIdx;
 
     int64_t compileTime = 0;
+    const int64_t hashStartTime = Util::GetPerfCpuTime();
     uint64_t pipelineHash = Vkgc::IPipelineDumper::GetPipelineHash(&pCreateInfo->pipelineInfo);
+    int64_t hashTime = Util::GetPerfCpuTime() - hashStartTime;
 
     void* pPipelineDumpHandle = nullptr;
     const void* pModuleDataBak = nullptr;
@@ -923,6 +1305,9 @@ VkResult PipelineCompiler::CreateComputePipelineBinary(
         }
         hash.Finalize(pCacheId->bytes);
 
+        const int64_t lookupStartTime = Util::GetPerfCpuTime();
+        hashTime += lookupStartTime - startTime;
+
         cacheResult = GetCachedPipelineBinary(pCacheId, pPipelineBinaryCache, pPipelineBinarySize, ppPipelineBinary,
             &isUserCacheHit, &isInternalCacheHit, &pCreateInfo->freeCompilerBinary, &pCreateInfo->pipelineFeedback);
         if (cacheResult == Util::Result::Success)
@@ -931,6 +1316,9 @@ VkResult PipelineCompiler::CreateComputePipelineBinary(
         }
 
         cacheTime = Util::GetPerfCpuTime() - startTime;
+
+        m_compileStats.RecordStageTime(PipelineCompileStats::Stage::CacheLookup,
+                                       (startTime + cacheTime) - lookupStartTime);
     }
 
     if (shouldCompile)
@@ -986,8 +1374,22 @@ VkResult PipelineCompiler::CreateComputePipelineBinary(
         VK_ASSERT(Util::IsErrorResult(cacheResult) == false);
     }
 
+    if ((m_pBinaryCache != nullptr) && (result == VK_SUCCESS))
+    {
+        m_pBinaryCache->RecordPrewarmEntry(pCacheId);
+
+        RecordCompileCost(*pCacheId, pCreateInfo->pipelineProfileKey, shouldCompile, compileTime);
+    }
+
     m_totalTimeSpent += shouldCompile ? compileTime : cacheTime;
     m_totalBinaries++;
+
+    RecordBinaryStats(pDevice, result, shouldCompile, isUserCacheHit, isInternalCacheHit, hashTime, compileTime,
+                      *pPipelineBinarySize);
+
+    pCreateInfo->binarySource = shouldCompile  ? PipelineCompileStats::Source::Compiled :
+                                isUserCacheHit ? PipelineCompileStats::Source::UserCache :
+                                                 PipelineCompileStats::Source::InternalCache;
     if (settings.shaderReplaceMode == ShaderReplaceShaderISA)
     {
         ReplacePipelineIsaCode(pDevice, pipelineHash, 0, *ppPipelineBinary, *pPipelineBinarySize);
@@ -995,14 +1397,9 @@ VkResult PipelineCompiler::CreateComputePipelineBinary(
 
     if (settings.enablePipelineDump && (pPipelineDumpHandle != nullptr))
     {
-        if (result == VK_SUCCESS)
-        {
-            Vkgc::BinaryData pipelineBinary = {};
-            pipelineBinary.codeSize = *pPipelineBinarySize;
-            pipelineBinary.pCode = *ppPipelineBinary;
-            Vkgc::IPipelineDumper::DumpPipelineBinary(pPipelineDumpHandle, m_gfxIp, &pipelineBinary);
-        }
-        Vkgc::IPipelineDumper::EndPipelineDump(pPipelineDumpHandle);
+        m_dumpWriter.FinishDump(pPipelineDumpHandle,
+                                (result == VK_SUCCESS) ? *ppPipelineBinary : nullptr,
+                                *pPipelineBinarySize);
     }
 
     if (shaderModuleReplaced)
@@ -1135,6 +1532,7 @@ VkResult PipelineCompiler::ConvertGraphicsPipelineInfo(
     const RuntimeSettings& settings  = m_pPhysicalDevice->GetRuntimeSettings();
     auto                   pInstance = m_pPhysicalDevice->Manager()->VkInstance();
     auto                   flags     = pIn->flags;
+    const int64_t          startTime = Util::GetPerfCpuTime();
 
     EXTRACT_VK_STRUCTURES_0(
         gfxPipeline,
@@ -1151,6 +1549,7 @@ VkResult PipelineCompiler::ConvertGraphicsPipelineInfo(
 
     // Fill in necessary non-zero defaults in case some information is missing
     const RenderPass* pRenderPass = nullptr;
+    const VkPipelineRenderingCreateInfoKHR* pRenderingInfo = nullptr;
     const PipelineLayout* pLayout = nullptr;
     const VkPipelineShaderStageCreateInfo* pStageInfos[ShaderStage::ShaderStageGfxCount] = {};
 
@@ -1172,7 +1571,8 @@ VkResult PipelineCompiler::ConvertGraphicsPipelineInfo(
 
         VK_IGNORE(pGraphicsPipelineCreateInfo->flags & VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT);
 
-        pRenderPass = RenderPass::ObjectFromHandle(pGraphicsPipelineCreateInfo->renderPass);
+        pRenderPass    = RenderPass::ObjectFromHandle(pGraphicsPipelineCreateInfo->renderPass);
+        pRenderingInfo = GraphicsPipeline::GetRenderingCreateInfo(pGraphicsPipelineCreateInfo);
 
         if (pGraphicsPipelineCreateInfo->layout != VK_NULL_HANDLE)
         {
@@ -1181,6 +1581,22 @@ VkResult PipelineCompiler::ConvertGraphicsPipelineInfo(
 
         pCreateInfo->pipelineInfo.pVertexInput = pGraphicsPipelineCreateInfo->pVertexInputState;
 
+        // Hand LLPC the canonical form of the vertex input state, so that pipelines with the same vertex fetches get
+        // the same pipeline hash and share their binaries.
+        if ((pCreateInfo->pipelineInfo.pVertexInput != nullptr) &&
+            (GraphicsPipeline::IsVertexInputStateNormalized(*pCreateInfo->pipelineInfo.pVertexInput) == false))
+        {
+            auto pNormalized = static_cast<NormalizedVertexInput*>(pInstance->AllocMem(
+                sizeof(NormalizedVertexInput), VK_DEFAULT_MEM_ALIGN, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND));
+
+            if (pNormalized != nullptr)
+            {
+                pCreateInfo->pVertexInputBuffer        = pNormalized;
+                pCreateInfo->pipelineInfo.pVertexInput =
+                    GraphicsPipeline::NormalizeVertexInputState(*pCreateInfo->pipelineInfo.pVertexInput, pNormalized);
+            }
+        }
+
         const VkPipelineInputAssemblyStateCreateInfo* pIa = pGraphicsPipelineCreateInfo->pInputAssemblyState;
 
         // According to the spec this should never be null
@@ -1188,7 +1604,8 @@ VkResult PipelineCompiler::ConvertGraphicsPipelineInfo(
 
         pCreateInfo->pipelineInfo.iaState.enableMultiView    = (pRenderPass != nullptr) ?
                                                                 pRenderPass->IsMultiviewEnabled() :
-                                                                0;
+                                                                ((pRenderingInfo != nullptr) &&
+                                                                 (pRenderingInfo->viewMask != 0));
 
         pCreateInfo->pipelineInfo.iaState.topology           = pIa->topology;
         pCreateInfo->pipelineInfo.iaState.disableVertexReuse = false;
@@ -1269,11 +1686,18 @@ VkResult PipelineCompiler::ConvertGraphicsPipelineInfo(
 
             if (multisampleEnable)
             {
-                VK_ASSERT(pRenderPass != nullptr);
+                VK_ASSERT((pRenderPass != nullptr) || (pRenderingInfo != nullptr));
 
+                // All attachments of a dynamic rendering instance use the rasterization sample count.
                 uint32_t rasterizationSampleCount   = pMs->rasterizationSamples;
-                uint32_t subpassCoverageSampleCount = pRenderPass->GetSubpassMaxSampleCount(pGraphicsPipelineCreateInfo->subpass);
-                uint32_t subpassColorSampleCount    = pRenderPass->GetSubpassColorSampleCount(pGraphicsPipelineCreateInfo->subpass);
+                uint32_t subpassCoverageSampleCount = rasterizationSampleCount;
+                uint32_t subpassColorSampleCount    = rasterizationSampleCount;
+
+                if (pRenderPass != nullptr)
+                {
+                    subpassCoverageSampleCount = pRenderPass->GetSubpassMaxSampleCount(pGraphicsPipelineCreateInfo->subpass);
+                    subpassColorSampleCount    = pRenderPass->GetSubpassColorSampleCount(pGraphicsPipelineCreateInfo->subpass);
+                }
 
                 // subpassCoverageSampleCount would be equal to zero if there are zero attachments.
                 subpassCoverageSampleCount = subpassCoverageSampleCount == 0 ? rasterizationSampleCount : subpassCoverageSampleCount;
@@ -1319,6 +1743,10 @@ VkResult PipelineCompiler::ConvertGraphicsPipelineInfo(
                 {
                     cbFormat = pRenderPass->GetColorAttachmentFormat(pGraphicsPipelineCreateInfo->subpass, i);
                 }
+                else if ((pRenderingInfo != nullptr) && (i < pRenderingInfo->colorAttachmentCount))
+                {
+                    cbFormat = pRenderingInfo->pColorAttachmentFormats[i];
+                }
 
                 // If the sub pass attachment format is UNDEFINED, then it means that that subpass does not
                 // want to write to any attachment for that output (VK_ATTACHMENT_UNUSED).  Under such cases,
@@ -1327,7 +1755,12 @@ VkResult PipelineCompiler::ConvertGraphicsPipelineInfo(
                 if ((cbFormat != VK_FORMAT_UNDEFINED) ||
                     (pCreateInfo->pipelineInfo.cbState.alphaToCoverageEnable && (i == 0u)))
                 {
-                    pLlpcCbDst->format               = cbFormat != VK_FORMAT_UNDEFINED ? cbFormat  : pRenderPass->GetAttachmentDesc(i).format;
+                    // Dynamic rendering has no attachment to borrow a format from; any format with alpha carries the
+                    // coverage export.
+                    pLlpcCbDst->format               = (cbFormat != VK_FORMAT_UNDEFINED) ? cbFormat :
+                                                       (pRenderPass != nullptr)          ?
+                                                           pRenderPass->GetAttachmentDesc(i).format :
+                                                           VK_FORMAT_R8G8B8A8_UNORM;
                     pLlpcCbDst->blendEnable          = (src.blendEnable == VK_TRUE);
                     pLlpcCbDst->blendSrcAlphaToColor = IsSrcAlphaUsedInBlend(src.srcAlphaBlendFactor) ||
                                                         IsSrcAlphaUsedInBlend(src.dstAlphaBlendFactor) ||
@@ -1348,6 +1781,10 @@ VkResult PipelineCompiler::ConvertGraphicsPipelineInfo(
         {
             dbFormat = pRenderPass->GetDepthStencilAttachmentFormat(pGraphicsPipelineCreateInfo->subpass);
         }
+        else if (pRenderingInfo != nullptr)
+        {
+            dbFormat = GraphicsPipeline::GetRenderingDepthStencilFormat(*pRenderingInfo);
+        }
 
         pCreateInfo->dbFormat = dbFormat;
     }
@@ -1463,6 +1900,8 @@ VkResult PipelineCompiler::ConvertGraphicsPipelineInfo(
         pShaderInfo->pEntryTarget          = pStage->pName;
         pShaderInfo->entryStage = static_cast<Vkgc::ShaderStage>(stage);
 
+        NormalizeSpecializationInfo(pShaderModule, pShaderInfo, &pCreateInfo->pSpecBuffers[stage]);
+
         ApplyDefaultShaderOptions(static_cast<ShaderStage>(stage),
                                   &pShaderInfo->options
                                   );
@@ -1607,6 +2046,8 @@ VkResult PipelineCompiler::ConvertGraphicsPipelineInfo(
 
     pCreateInfo->freeCompilerBinary = FreeWithCompiler;
 
+    m_compileStats.RecordStageTime(PipelineCompileStats::Stage::Convert, Util::GetPerfCpuTime() - startTime);
+
     return result;
 }
 
@@ -1705,11 +2146,29 @@ VkResult PipelineCompiler::ConvertComputePipelineInfo(
     ComputePipelineCreateInfo*                      pCreateInfo,
     const VkPipelineCreationFeedbackCreateInfoEXT** ppPipelineCreationFeadbackCreateInfo)
 {
-    VkResult result    = VK_SUCCESS;
+    VkResult result = ConvertComputeShaderInfo(pDevice, pIn, pCreateInfo, ppPipelineCreationFeadbackCreateInfo);
 
-    auto     pInstance = m_pPhysicalDevice->Manager()->VkInstance();
+    if (result == VK_SUCCESS)
+    {
+        result = BuildComputeResourceMapping(pIn, pCreateInfo);
+    }
 
-    PipelineLayout* pLayout = nullptr;
+    return result;
+}
+
+// =====================================================================================================================
+// Converts the parts of the Vulkan compute pipeline parameters which don't depend on the pipeline layout: the shader
+// stage and the compile options.  This is all LoadComputePipelineBinaryByApiHash() needs, so the resource mapping is
+// only built by BuildComputeResourceMapping() once the pipeline has to go through the full path.
+VkResult PipelineCompiler::ConvertComputeShaderInfo(
+    Device*                                         pDevice,
+    const VkComputePipelineCreateInfo*              pIn,
+    ComputePipelineCreateInfo*                      pCreateInfo,
+    const VkPipelineCreationFeedbackCreateInfoEXT** ppPipelineCreationFeadbackCreateInfo)
+{
+    VkResult result = VK_SUCCESS;
+
+    const int64_t startTime = Util::GetPerfCpuTime();
 
     VK_ASSERT(pIn->sType == VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO);
 
@@ -1717,11 +2176,6 @@ VkResult PipelineCompiler::ConvertComputePipelineInfo(
         reinterpret_cast<const VkStructHeader*>(pIn->pNext),
         ppPipelineCreationFeadbackCreateInfo);
 
-    if (pIn->layout != VK_NULL_HANDLE)
-    {
-        pLayout = PipelineLayout::ObjectFromHandle(pIn->layout);
-    }
-
     pCreateInfo->flags  = pIn->flags;
 
     ApplyPipelineOptions(pDevice, pIn->flags, &pCreateInfo->pipelineInfo.options);
@@ -1733,11 +2187,52 @@ VkResult PipelineCompiler::ConvertComputePipelineInfo(
     pCreateInfo->pipelineInfo.cs.pEntryTarget        = pIn->stage.pName;
     pCreateInfo->pipelineInfo.cs.entryStage          = Vkgc::ShaderStageCompute;
 
+    NormalizeSpecializationInfo(pShaderModule, &pCreateInfo->pipelineInfo.cs, &pCreateInfo->pSpecBuffer);
+
     if ((pIn->stage.flags & VK_PIPELINE_SHADER_STAGE_CREATE_ALLOW_VARYING_SUBGROUP_SIZE_BIT_EXT) != 0)
     {
         pCreateInfo->pipelineInfo.cs.options.allowVaryWaveSize = true;
     }
 
+    pCreateInfo->compilerType = CheckCompilerType(&pCreateInfo->pipelineInfo);
+    pCreateInfo->pipelineInfo.cs.pModuleData = pShaderModule->GetShaderData(pCreateInfo->compilerType);
+
+    ApplyDefaultShaderOptions(ShaderStage::ShaderStageCompute,
+                              &pCreateInfo->pipelineInfo.cs.options
+                              );
+
+    ApplyProfileOptions(pDevice,
+                        ShaderStage::ShaderStageCompute,
+                        pShaderModule,
+                        nullptr,
+                        &pCreateInfo->pipelineInfo.cs,
+                        &pCreateInfo->pipelineProfileKey,
+                        nullptr
+                        );
+
+    m_compileStats.RecordStageTime(PipelineCompileStats::Stage::Convert, Util::GetPerfCpuTime() - startTime);
+
+    return result;
+}
+
+// =====================================================================================================================
+// Builds the LLPC resource mapping of a compute pipeline from its layout.  Must follow ConvertComputeShaderInfo(),
+// which takes the Convert stage sample of the pipeline.
+VkResult PipelineCompiler::BuildComputeResourceMapping(
+    const VkComputePipelineCreateInfo*              pIn,
+    ComputePipelineCreateInfo*                      pCreateInfo)
+{
+    VkResult result    = VK_SUCCESS;
+
+    auto     pInstance = m_pPhysicalDevice->Manager()->VkInstance();
+
+    PipelineLayout* pLayout = nullptr;
+
+    if (pIn->layout != VK_NULL_HANDLE)
+    {
+        pLayout = PipelineLayout::ObjectFromHandle(pIn->layout);
+    }
+
     if ((pLayout != nullptr) && (pLayout->GetPipelineInfo()->mappingBufferSize > 0))
     {
 
@@ -1815,22 +2310,6 @@ VkResult PipelineCompiler::ConvertComputePipelineInfo(
         }
     }
 
-    pCreateInfo->compilerType = CheckCompilerType(&pCreateInfo->pipelineInfo);
-    pCreateInfo->pipelineInfo.cs.pModuleData = pShaderModule->GetShaderData(pCreateInfo->compilerType);
-
-    ApplyDefaultShaderOptions(ShaderStage::ShaderStageCompute,
-                              &pCreateInfo->pipelineInfo.cs.options
-                              );
-
-    ApplyProfileOptions(pDevice,
-                        ShaderStage::ShaderStageCompute,
-                        pShaderModule,
-                        nullptr,
-                        &pCreateInfo->pipelineInfo.cs,
-                        &pCreateInfo->pipelineProfileKey,
-                        nullptr
-                        );
-
     return result;
 }
 
@@ -1953,6 +2432,486 @@ void PipelineCompiler::FreeGraphicsPipelineBinary(
     }
 }
 
+// =====================================================================================================================
+struct PipelineCompiler::ApiHashEntry
+{
+    Util::MetroHash::Hash cacheId;             // ELF cache ID the pipeline binary was stored under
+    uint64_t              pipelineHash;        // LLPC pipeline hash, kept for logging
+    PipelineOptimizerKey  pipelineProfileKey;  // Shader optimizer key of the pipeline
+    VbBindingInfo         vbInfo;              // Vertex buffer bindings read by the pipeline
+};
+
+// =====================================================================================================================
+// The first-level lookup skips the conversion to LLPC build info, so it is only usable when nothing downstream needs
+// that build info for a cache hit.
+bool PipelineCompiler::IsApiHashLookupEnabled() const
+{
+    const RuntimeSettings& settings = m_pPhysicalDevice->GetRuntimeSettings();
+
+    return settings.enablePipelineApiHashLookup                   &&
+           (m_pBinaryCache != nullptr)                            &&
+           (settings.shaderReplaceMode == ShaderReplaceDisable)   &&
+           (settings.enablePipelineDump == false)                 &&
+           (settings.enableDropPipelineBinaryInst == false);
+}
+
+// =====================================================================================================================
+// Builds the key of the first-level lookup.  The base hash covers all application state which affects compilation;
+// the options derived from the device's enabled features and extensions are folded in on top since the compiler is
+// shared by every logical device created from the physical device.
+void PipelineCompiler::BuildApiHashKey(
+    const Device*                pDevice,
+    uint32_t                     deviceIdx,
+    VkPipelineCreateFlags        flags,
+    const Util::MetroHash::Hash& baseHash,
+    Util::MetroHash::Hash*       pKey)
+{
+    Vkgc::PipelineOptions options = {};
+    ApplyPipelineOptions(pDevice, flags, &options);
+
+    Util::MetroHash128 hasher;
+    hasher.Update(baseHash);
+    hasher.Update(options);
+    hasher.Update(deviceIdx);
+    hasher.Finalize(pKey->bytes);
+}
+
+// =====================================================================================================================
+// Looks up a graphics pipeline binary by the API hash of its create info.  On success, the binary is loaded from the
+// pipeline caches under the ELF cache ID recorded by RegisterGraphicsPipelineApiHash(), and the state that
+// ConvertGraphicsPipelineInfo() would otherwise provide is restored.  Returns false if the pipeline hasn't been seen or
+// its binary is no longer cached, in which case the caller has to take the full path.
+bool PipelineCompiler::LoadGraphicsPipelineBinaryByApiHash(
+    const Device*                pDevice,
+    uint32_t                     deviceIdx,
+    PipelineCache*               pPipelineCache,
+    const Util::MetroHash::Hash& baseHash,
+    GraphicsPipelineCreateInfo*  pCreateInfo,
+    VbBindingInfo*               pVbInfo,
+    uint64_t*                    pPipelineHash,
+    size_t*                      pPipelineBinarySize,
+    const void**                 ppPipelineBinary,
+    Util::MetroHash::Hash*       pCacheId)
+{
+    bool found = false;
+
+    if (IsApiHashLookupEnabled())
+    {
+        int64_t startTime = Util::GetPerfCpuTime();
+
+        Util::MetroHash::Hash key = {};
+        BuildApiHashKey(pDevice, deviceIdx, pCreateInfo->flags, baseHash, &key);
+
+        ApiHashEntry entry = {};
+
+        {
+            Util::RWLockAuto<Util::RWLock::LockType::ReadOnly> readLock(&m_apiHashLock);
+
+            ApiHashEntry** ppEntry = m_apiHashMap.FindKey(key);
+
+            if (ppEntry != nullptr)
+            {
+                entry = **ppEntry;
+                found = true;
+            }
+        }
+
+        if (found)
+        {
+            PipelineBinaryCache* pPipelineBinaryCache = nullptr;
+
+            if ((pPipelineCache != nullptr) && (pPipelineCache->GetPipelineCache() != nullptr))
+            {
+                pPipelineBinaryCache = pPipelineCache->GetPipelineCache();
+            }
+
+            bool isUserCacheHit     = false;
+            bool isInternalCacheHit = false;
+
+            Util::Result cacheResult = GetCachedPipelineBinary(&entry.cacheId, pPipelineBinaryCache,
+                pPipelineBinarySize, ppPipelineBinary, &isUserCacheHit, &isInternalCacheHit,
+                &pCreateInfo->freeCompilerBinary, &pCreateInfo->pipelineFeedback);
+
+            if (cacheResult == Util::Result::Success)
+            {
+                // Keep both caches populated the same way the full path does.
+                if ((pPipelineBinaryCache != nullptr) && (isUserCacheHit == false))
+                {
+                    cacheResult = pPipelineBinaryCache->StorePipelineBinary(
+                        &entry.cacheId, *pPipelineBinarySize, *ppPipelineBinary);
+
+                    VK_ASSERT(Util::IsErrorResult(cacheResult) == false);
+                }
+
+                if (isInternalCacheHit == false)
+                {
+                    cacheResult = m_pBinaryCache->StorePipelineBinary(
+                        &entry.cacheId, *pPipelineBinarySize, *ppPipelineBinary);
+
+                    VK_ASSERT(Util::IsErrorResult(cacheResult) == false);
+                }
+
+                m_pBinaryCache->RecordPrewarmEntry(&entry.cacheId);
+
+                RecordCompileCost(entry.cacheId, entry.pipelineProfileKey, false, 0);
+
+                *pCacheId                       = entry.cacheId;
+                *pPipelineHash                  = entry.pipelineHash;
+                *pVbInfo                        = entry.vbInfo;
+                pCreateInfo->pipelineProfileKey = entry.pipelineProfileKey;
+                pCreateInfo->binarySource       = PipelineCompileStats::Source::ApiHashCache;
+
+                const int64_t lookupTime = Util::GetPerfCpuTime() - startTime;
+
+                m_totalTimeSpent += lookupTime;
+                m_totalBinaries++;
+
+                m_compileStats.RecordStageTime(PipelineCompileStats::Stage::CacheLookup, lookupTime);
+                m_compileStats.RecordBinary(PipelineCompileStats::Source::ApiHashCache, *pPipelineBinarySize);
+            }
+            else
+            {
+                // The binary has been evicted from every cache; drop the stale mapping.
+                Util::RWLockAuto<Util::RWLock::LockType::ReadWrite> writeLock(&m_apiHashLock);
+
+                ApiHashEntry** ppEntry = m_apiHashMap.FindKey(key);
+
+                if (ppEntry != nullptr)
+                {
+                    m_pPhysicalDevice->VkInstance()->FreeMem(*ppEntry);
+                    m_apiHashMap.Erase(key);
+                }
+
+                found = false;
+            }
+        }
+    }
+
+    return found;
+}
+
+// =====================================================================================================================
+// Resolves the API hashes of a batched create call to ELF cache IDs under a single lock and queries all of them from
+// the pipeline caches in one pass per cache.  The binaries the batch is going to load are then resident in the memory
+// layers before the entries are created, so the per-entry loads in LoadGraphicsPipelineBinaryByApiHash() don't each
+// go down to the archives.  pFlags and pBaseHashes hold the create flags and base hashes of count entries.
+void PipelineCompiler::PrefetchGraphicsPipelineBinaries(
+    const Device*                pDevice,
+    uint32_t                     deviceIdx,
+    PipelineCache*               pPipelineCache,
+    uint32_t                     count,
+    const VkPipelineCreateFlags* pFlags,
+    const Util::MetroHash::Hash* pBaseHashes)
+{
+    if (IsApiHashLookupEnabled() && (count > 0))
+    {
+        PalAllocator* pAllocator = m_pPhysicalDevice->VkInstance()->Allocator();
+
+        Util::AutoBuffer<Util::MetroHash::Hash, 16, PalAllocator> keys(count, pAllocator);
+        Util::AutoBuffer<Util::MetroHash::Hash, 16, PalAllocator> cacheIds(count, pAllocator);
+        Util::AutoBuffer<Util::QueryResult, 16, PalAllocator>     queries(count, pAllocator);
+        Util::AutoBuffer<Util::Result, 16, PalAllocator>          results(count, pAllocator);
+
+        if ((keys.Capacity()     >= count) &&
+            (cacheIds.Capacity() >= count) &&
+            (queries.Capacity()  >= count) &&
+            (results.Capacity()  >= count))
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                BuildApiHashKey(pDevice, deviceIdx, pFlags[i], pBaseHashes[i], &keys[i]);
+            }
+
+            uint32_t knownCount = 0;
+
+            {
+                Util::RWLockAuto<Util::RWLock::LockType::ReadOnly> readLock(&m_apiHashLock);
+
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    ApiHashEntry** ppEntry = m_apiHashMap.FindKey(keys[i]);
+
+                    if (ppEntry != nullptr)
+                    {
+                        cacheIds[knownCount++] = (*ppEntry)->cacheId;
+                    }
+                }
+            }
+
+            if (knownCount > 0)
+            {
+                // The application cache is checked first by GetCachedPipelineBinary(), but the internal cache is
+                // always looked up as well.
+                if ((pPipelineCache != nullptr) && (pPipelineCache->GetPipelineCache() != nullptr))
+                {
+                    pPipelineCache->GetPipelineCache()->QueryPipelineBinaries(
+                        knownCount, &cacheIds[0], 0, &queries[0], &results[0]);
+                }
+
+                m_pBinaryCache->QueryPipelineBinaries(knownCount, &cacheIds[0], 0, &queries[0], &results[0]);
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Records the ELF cache ID a graphics pipeline binary was stored under, keyed by the API hash of its create info, so
+// that later creates with the same create info can be served by LoadGraphicsPipelineBinaryByApiHash().
+void PipelineCompiler::RegisterGraphicsPipelineApiHash(
+    const Device*                     pDevice,
+    uint32_t                          deviceIdx,
+    const Util::MetroHash::Hash&      baseHash,
+    const GraphicsPipelineCreateInfo& createInfo,
+    const VbBindingInfo&              vbInfo,
+    uint64_t                          pipelineHash,
+    const Util::MetroHash::Hash&      cacheId)
+{
+    if (IsApiHashLookupEnabled())
+    {
+        Util::MetroHash::Hash key = {};
+        BuildApiHashKey(pDevice, deviceIdx, createInfo.flags, baseHash, &key);
+
+        Util::RWLockAuto<Util::RWLock::LockType::ReadWrite> writeLock(&m_apiHashLock);
+
+        bool           existed = false;
+        ApiHashEntry** ppEntry = nullptr;
+
+        Util::Result result = m_apiHashMap.FindAllocate(key, &existed, &ppEntry);
+
+        if ((result == Util::Result::Success) && (existed == false))
+        {
+            *ppEntry = static_cast<ApiHashEntry*>(m_pPhysicalDevice->VkInstance()->AllocMem(
+                sizeof(ApiHashEntry),
+                VK_SYSTEM_ALLOCATION_SCOPE_CACHE));
+
+            if (*ppEntry == nullptr)
+            {
+                m_apiHashMap.Erase(key);
+                result = Util::Result::ErrorOutOfMemory;
+            }
+        }
+
+        if (result == Util::Result::Success)
+        {
+            (*ppEntry)->cacheId            = cacheId;
+            (*ppEntry)->pipelineHash       = pipelineHash;
+            (*ppEntry)->pipelineProfileKey = createInfo.pipelineProfileKey;
+            (*ppEntry)->vbInfo             = vbInfo;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Builds the key a compute pipeline's ComputeApiHashRecord is stored under.  ConvertComputeShaderInfo() must have
+// filled in createInfo, as the key covers the compile options along with the API hash: those may change from run to
+// run, e.g. with the shader profiles or the autotuner.  The magic keeps the key apart from the compiler's cache IDs.
+void PipelineCompiler::BuildComputeApiHashKey(
+    uint32_t                         deviceIdx,
+    const ComputePipelineCreateInfo& createInfo,
+    Util::MetroHash::Hash*           pKey) const
+{
+    Util::MetroHash128 hasher;
+    hasher.Update(ComputeApiHashMagic);
+    hasher.Update(ComputeApiHashVersion);
+    hasher.Update(m_settingsHash);
+    hasher.Update(createInfo.basePipelineHash);
+    hasher.Update(createInfo.pipelineInfo.options);
+    hasher.Update(createInfo.pipelineInfo.cs.options);
+    hasher.Update(createInfo.pipelineProfileKey);
+    hasher.Update(GetCacheIdControlFlags(createInfo.flags));
+    hasher.Update(deviceIdx);
+    hasher.Update(createInfo.compilerType);
+    hasher.Finalize(pKey->bytes);
+}
+
+// =====================================================================================================================
+// Looks up a compute pipeline binary by the API hash of its create info.  pCreateInfo must have been filled in by
+// ConvertComputeShaderInfo(); on success the binary is loaded from the pipeline caches under the ELF cache ID recorded
+// by RegisterComputePipelineApiHash(), and neither the resource mapping nor the LLPC pipeline hash have to be built.
+// Returns false if the pipeline hasn't been seen or its binary is no longer cached, in which case the caller has to
+// take the full path.
+bool PipelineCompiler::LoadComputePipelineBinaryByApiHash(
+    uint32_t                     deviceIdx,
+    PipelineCache*               pPipelineCache,
+    ComputePipelineCreateInfo*   pCreateInfo,
+    uint64_t*                    pPipelineHash,
+    size_t*                      pPipelineBinarySize,
+    const void**                 ppPipelineBinary,
+    Util::MetroHash::Hash*       pCacheId)
+{
+    bool found = false;
+
+    if (IsApiHashLookupEnabled())
+    {
+        int64_t startTime = Util::GetPerfCpuTime();
+
+        Util::MetroHash::Hash key = {};
+        BuildComputeApiHashKey(deviceIdx, *pCreateInfo, &key);
+
+        ComputeApiHashRecord record     = {};
+        size_t               recordSize = 0;
+        const void*          pRecord    = nullptr;
+
+        if (m_pBinaryCache->LoadPipelineBinary(&key, &recordSize, &pRecord) == Util::Result::Success)
+        {
+            if (recordSize == sizeof(record))
+            {
+                memcpy(&record, pRecord, sizeof(record));
+
+                found = (record.magic == ComputeApiHashMagic) && (record.version == ComputeApiHashVersion);
+            }
+
+            m_pBinaryCache->FreePipelineBinary(pRecord);
+        }
+
+        if (found)
+        {
+            PipelineBinaryCache* pPipelineBinaryCache = nullptr;
+
+            if ((pPipelineCache != nullptr) && (pPipelineCache->GetPipelineCache() != nullptr))
+            {
+                pPipelineBinaryCache = pPipelineCache->GetPipelineCache();
+            }
+
+            bool isUserCacheHit     = false;
+            bool isInternalCacheHit = false;
+
+            Util::Result cacheResult = GetCachedPipelineBinary(&record.cacheId, pPipelineBinaryCache,
+                pPipelineBinarySize, ppPipelineBinary, &isUserCacheHit, &isInternalCacheHit,
+                &pCreateInfo->freeCompilerBinary, &pCreateInfo->pipelineFeedback);
+
+            if (cacheResult == Util::Result::Success)
+            {
+                // Keep both caches populated the same way the full path does.
+                if ((pPipelineBinaryCache != nullptr) && (isUserCacheHit == false))
+                {
+                    cacheResult = pPipelineBinaryCache->StorePipelineBinary(
+                        &record.cacheId, *pPipelineBinarySize, *ppPipelineBinary);
+
+                    VK_ASSERT(Util::IsErrorResult(cacheResult) == false);
+                }
+
+                if (isInternalCacheHit == false)
+                {
+                    cacheResult = m_pBinaryCache->StorePipelineBinary(
+                        &record.cacheId, *pPipelineBinarySize, *ppPipelineBinary);
+
+                    VK_ASSERT(Util::IsErrorResult(cacheResult) == false);
+                }
+
+                // The record is needed as early as the binary on the next run.
+                m_pBinaryCache->RecordPrewarmEntry(&key);
+                m_pBinaryCache->RecordPrewarmEntry(&record.cacheId);
+
+                RecordCompileCost(record.cacheId, pCreateInfo->pipelineProfileKey, false, 0);
+
+                *pCacheId                 = record.cacheId;
+                *pPipelineHash            = record.pipelineHash;
+                pCreateInfo->binarySource = PipelineCompileStats::Source::ApiHashCache;
+
+                const int64_t lookupTime = Util::GetPerfCpuTime() - startTime;
+
+                m_totalTimeSpent += lookupTime;
+                m_totalBinaries++;
+
+                m_compileStats.RecordStageTime(PipelineCompileStats::Stage::CacheLookup, lookupTime);
+                m_compileStats.RecordBinary(PipelineCompileStats::Source::ApiHashCache, *pPipelineBinarySize);
+            }
+            else
+            {
+                // The binary has been evicted; the full path stores it again under the same cache ID, which makes the
+                // record valid again.
+                found = false;
+            }
+        }
+    }
+
+    return found;
+}
+
+// =====================================================================================================================
+// Stores a ComputeApiHashRecord for a compute pipeline binary created through the full path, so that later creates
+// with the same create info, in this run or later ones, can be served by LoadComputePipelineBinaryByApiHash().
+void PipelineCompiler::RegisterComputePipelineApiHash(
+    uint32_t                         deviceIdx,
+    const ComputePipelineCreateInfo& createInfo,
+    uint64_t                         pipelineHash,
+    const Util::MetroHash::Hash&     cacheId)
+{
+    if (IsApiHashLookupEnabled())
+    {
+        Util::MetroHash::Hash key = {};
+        BuildComputeApiHashKey(deviceIdx, createInfo, &key);
+
+        ComputeApiHashRecord record = {};
+        record.magic        = ComputeApiHashMagic;
+        record.version      = ComputeApiHashVersion;
+        record.cacheId      = cacheId;
+        record.pipelineHash = pipelineHash;
+
+        // The record may already exist when only the binary was evicted; it is unchanged then.
+        Util::Result result = m_pBinaryCache->StorePipelineBinary(&key, sizeof(record), &record);
+
+        VK_ASSERT(Util::IsErrorResult(result) == false);
+
+        m_pBinaryCache->RecordPrewarmEntry(&key);
+    }
+}
+
+// =====================================================================================================================
+void PipelineCompiler::DestroyApiHashMap()
+{
+    Util::RWLockAuto<Util::RWLock::LockType::ReadWrite> writeLock(&m_apiHashLock);
+
+    for (auto it = m_apiHashMap.Begin(); it.Get() != nullptr; it.Next())
+    {
+        m_pPhysicalDevice->VkInstance()->FreeMem(it.Get()->value);
+    }
+
+    m_apiHashMap.Reset();
+}
+
+// =====================================================================================================================
+// Points a shader stage at the reduced form of its specialization info (see ShaderModule::NormalizeSpecializationInfo),
+// so that pipelines differing only in spec constant values which have no effect get the same LLPC pipeline hash, and
+// thereby the same cached binary.  ppSpecBuffer receives the memory holding the reduced info, if any, to be freed along
+// with the create info.  The original info is kept if no memory is available.
+void PipelineCompiler::NormalizeSpecializationInfo(
+    const ShaderModule*       pShaderModule,
+    Vkgc::PipelineShaderInfo* pShaderInfo,
+    void**                    ppSpecBuffer)
+{
+    const VkSpecializationInfo* pInfo = pShaderInfo->pSpecializationInfo;
+
+    if ((pInfo != nullptr) && pShaderModule->HasSpecConstantInfo())
+    {
+        Instance* pInstance = m_pPhysicalDevice->VkInstance();
+
+        void* pBuffer = pInstance->AllocMem(ShaderModule::GetNormalizedSpecializationInfoSize(*pInfo),
+                                            VK_DEFAULT_MEM_ALIGN,
+                                            VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+
+        if (pBuffer != nullptr)
+        {
+            uint32_t droppedCount = 0;
+
+            pShaderInfo->pSpecializationInfo =
+                pShaderModule->NormalizeSpecializationInfo(pInfo, pBuffer, &droppedCount);
+
+            m_compileStats.RecordSpecialization(pInfo->mapEntryCount, droppedCount);
+
+            if (pShaderInfo->pSpecializationInfo == pBuffer)
+            {
+                *ppSpecBuffer = pBuffer;
+            }
+            else
+            {
+                pInstance->FreeMem(pBuffer);
+            }
+        }
+    }
+}
+
 // =====================================================================================================================
 // Free the temp memories in compute pipeline create info
 void PipelineCompiler::FreeComputePipelineCreateInfo(
@@ -1965,6 +2924,12 @@ void PipelineCompiler::FreeComputePipelineCreateInfo(
         pInstance->FreeMem(pCreateInfo->pTempBuffer);
         pCreateInfo->pTempBuffer = nullptr;
     }
+
+    if (pCreateInfo->pSpecBuffer != nullptr)
+    {
+        pInstance->FreeMem(pCreateInfo->pSpecBuffer);
+        pCreateInfo->pSpecBuffer = nullptr;
+    }
 }
 
 // =====================================================================================================================
@@ -1979,6 +2944,21 @@ void PipelineCompiler::FreeGraphicsPipelineCreateInfo(
         pInstance->FreeMem(pCreateInfo->pTempBuffer);
         pCreateInfo->pTempBuffer = nullptr;
     }
+
+    for (uint32_t stage = 0; stage < ShaderStage::ShaderStageGfxCount; ++stage)
+    {
+        if (pCreateInfo->pSpecBuffers[stage] != nullptr)
+        {
+            pInstance->FreeMem(pCreateInfo->pSpecBuffers[stage]);
+            pCreateInfo->pSpecBuffers[stage] = nullptr;
+        }
+    }
+
+    if (pCreateInfo->pVertexInputBuffer != nullptr)
+    {
+        pInstance->FreeMem(pCreateInfo->pVertexInputBuffer);
+        pCreateInfo->pVertexInputBuffer = nullptr;
+    }
 }
 
 // =====================================================================================================================
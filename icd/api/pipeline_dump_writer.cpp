@@ -0,0 +1,204 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_dump_writer.cpp
+* @brief Implementation of the background pipeline dump writer.
+***********************************************************************************************************************
+*/
+#include "include/pipeline_dump_writer.h"
+#include "include/vk_instance.h"
+
+#include "palInlineFuncs.h"
+
+#include <string.h>
+
+namespace vk
+{
+
+// =====================================================================================================================
+PipelineDumpWriter::PipelineDumpWriter(
+    Instance* pInstance)
+    :
+    m_pInstance(pInstance),
+    m_gfxIp(),
+    m_started(false),
+    m_stop(false),
+    m_pHead(nullptr),
+    m_pTail(nullptr)
+{
+}
+
+// =====================================================================================================================
+// Starts the writer thread.  On failure dumps are simply finished synchronously.
+VkResult PipelineDumpWriter::Init(
+    const Vkgc::GfxIpVersion& gfxIp)
+{
+    m_gfxIp = gfxIp;
+
+    Util::EventCreateFlags flags = {};
+    flags.manualReset       = false;
+    flags.initiallySignaled = false;
+
+    VkResult result = PalToVkResult(m_event.Init(flags));
+
+    if (result == VK_SUCCESS)
+    {
+        result = PalToVkResult(m_thread.Begin(ThreadFunc, this));
+    }
+
+    m_started = (result == VK_SUCCESS);
+
+    return result;
+}
+
+// =====================================================================================================================
+// Stops the writer thread and finishes everything that is still queued.
+void PipelineDumpWriter::Destroy()
+{
+    if (m_started)
+    {
+        m_stop = true;
+        m_event.Set();
+        m_thread.Join();
+
+        Flush();
+
+        m_started = false;
+    }
+}
+
+// =====================================================================================================================
+// Writes the pipeline binary of a dump begun with BeginPipelineDump() and closes the dump.  pBinary may be null if the
+// pipeline failed to build.  The binary is copied, so the caller may free or modify it as soon as this returns.
+void PipelineDumpWriter::FinishDump(
+    void*       pDumpHandle,
+    const void* pBinary,
+    size_t      binarySize)
+{
+    const size_t copySize = (pBinary != nullptr) ? binarySize : 0;
+
+    Entry* pEntry = nullptr;
+
+    if (m_started)
+    {
+        pEntry = static_cast<Entry*>(m_pInstance->AllocMem(sizeof(Entry) + copySize,
+                                                           VK_DEFAULT_MEM_ALIGN,
+                                                           VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE));
+    }
+
+    if (pEntry != nullptr)
+    {
+        pEntry->pDumpHandle = pDumpHandle;
+        pEntry->binarySize  = copySize;
+        pEntry->pNext       = nullptr;
+
+        if (copySize > 0)
+        {
+            memcpy(Util::VoidPtrInc(pEntry, sizeof(Entry)), pBinary, copySize);
+        }
+
+        {
+            Util::MutexAuto lock(&m_lock);
+
+            if (m_pTail != nullptr)
+            {
+                m_pTail->pNext = pEntry;
+            }
+            else
+            {
+                m_pHead = pEntry;
+            }
+
+            m_pTail = pEntry;
+        }
+
+        m_event.Set();
+    }
+    else
+    {
+        WriteDump(pDumpHandle, pBinary, copySize);
+    }
+}
+
+// =====================================================================================================================
+void PipelineDumpWriter::WriteDump(
+    void*       pDumpHandle,
+    const void* pBinary,
+    size_t      binarySize
+    ) const
+{
+    if (binarySize > 0)
+    {
+        Vkgc::BinaryData pipelineBinary = {};
+        pipelineBinary.codeSize = binarySize;
+        pipelineBinary.pCode    = pBinary;
+
+        Vkgc::IPipelineDumper::DumpPipelineBinary(pDumpHandle, m_gfxIp, &pipelineBinary);
+    }
+
+    Vkgc::IPipelineDumper::EndPipelineDump(pDumpHandle);
+}
+
+// =====================================================================================================================
+// Finishes every queued dump.  Entries queued while the flush is running are picked up by the next flush.
+void PipelineDumpWriter::Flush()
+{
+    Entry* pEntry = nullptr;
+
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        pEntry  = m_pHead;
+        m_pHead = nullptr;
+        m_pTail = nullptr;
+    }
+
+    while (pEntry != nullptr)
+    {
+        Entry* pNext = pEntry->pNext;
+
+        WriteDump(pEntry->pDumpHandle, Util::VoidPtrInc(pEntry, sizeof(Entry)), pEntry->binarySize);
+
+        m_pInstance->FreeMem(pEntry);
+        pEntry = pNext;
+    }
+}
+
+// =====================================================================================================================
+// Writer thread: drains the queue until the writer is destroyed.
+void PipelineDumpWriter::ThreadFunc(
+    void* pParam)
+{
+    PipelineDumpWriter* pWriter = static_cast<PipelineDumpWriter*>(pParam);
+
+    while (pWriter->m_stop == false)
+    {
+        pWriter->m_event.Wait(1.0f);
+        pWriter->Flush();
+    }
+}
+
+} // namespace vk
@@ -0,0 +1,616 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_stats_profile.cpp
+* @brief Implementation of the per-pipeline hardware statistics profile sampled at draw granularity.
+***********************************************************************************************************************
+*/
+#include "include/pipeline_stats_profile.h"
+#include "include/app_shader_optimizer.h"
+#include "include/vk_conv.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+
+#include "palCmdBuffer.h"
+#include "palHashMapImpl.h"
+#include "palJsonWriter.h"
+#include "palQueryPool.h"
+
+#include <algorithm>
+
+namespace vk
+{
+
+static const char* CounterNames[PipelineStatsCounterCount] =
+{
+    "iaVertices",
+    "iaPrimitives",
+    "vsInvocations",
+    "gsInvocations",
+    "gsPrimitives",
+    "clippingInvocations",
+    "clippingPrimitives",
+    "fsInvocations",
+    "tcsPatches",
+    "tesInvocations",
+    "csInvocations",
+};
+
+// Counter holding the invocations of each shader stage, and the stage's name in shader profiles
+static const uint32_t StageCounters[ShaderStageCount] = { 2, 8, 9, 3, 7, 10 };
+static const char*    StageNames[ShaderStageCount]    = { "vs", "hs", "ds", "gs", "ps", "cs" };
+
+static_assert((ShaderStage::ShaderStageVertex == 0) && (ShaderStage::ShaderStageCompute == 5),
+              "Shader stage order changed");
+
+static_assert(VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT == (1 << (PipelineStatsCounterCount - 1)),
+              "Pipeline statistics counters changed");
+
+// =====================================================================================================================
+PipelineStatsProfile* PipelineStatsProfile::Create(
+    Device* pDevice)
+{
+    PipelineStatsProfile* pProfile = nullptr;
+    void*                 pMem     = pDevice->VkInstance()->AllocMem(sizeof(PipelineStatsProfile),
+                                                                     VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+    if (pMem != nullptr)
+    {
+        pProfile = VK_PLACEMENT_NEW(pMem) PipelineStatsProfile(pDevice);
+
+        if (pProfile->m_entries.Init() != Util::Result::Success)
+        {
+            pProfile->Destroy();
+            pProfile = nullptr;
+        }
+    }
+
+    return pProfile;
+}
+
+// =====================================================================================================================
+PipelineStatsProfile::PipelineStatsProfile(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_entries(64, pDevice->VkInstance()->Allocator()),
+    m_droppedCount(0)
+{
+}
+
+// =====================================================================================================================
+void PipelineStatsProfile::Destroy()
+{
+    Instance* pInstance = m_pDevice->VkInstance();
+
+    Util::Destructor(this);
+
+    pInstance->FreeMem(this);
+}
+
+// =====================================================================================================================
+// Remembers which shaders make up a pipeline.  Called when the pipeline is created, before it can be sampled.
+void PipelineStatsProfile::RegisterPipeline(
+    uint64_t                    apiHash,
+    const PipelineOptimizerKey& key)
+{
+    m_pDevice->GetPipelineAutotuner()->RegisterPipeline(apiHash, key);
+
+    Util::MutexAuto lock(&m_lock);
+
+    bool   existed = false;
+    Entry* pEntry  = nullptr;
+
+    if (m_entries.FindAllocate(apiHash, &existed, &pEntry) == Util::Result::Success)
+    {
+        if (existed == false)
+        {
+            memset(pEntry, 0, sizeof(*pEntry));
+        }
+
+        pEntry->shadersKnown = true;
+
+        for (uint32_t stage = 0; stage < ShaderStageCount; ++stage)
+        {
+            pEntry->codeHashes[stage] = key.shaders[stage].codeHash;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Adds the samples of one command buffer recording, plus the number of draws and dispatches which couldn't be sampled.
+void PipelineStatsProfile::RecordSamples(
+    const PipelineStatsSample* pSamples,
+    uint32_t                   sampleCount,
+    uint32_t                   droppedCount)
+{
+    m_pDevice->GetPipelineAutotuner()->RecordSamples(pSamples, sampleCount);
+
+    Util::MutexAuto lock(&m_lock);
+
+    m_droppedCount += droppedCount;
+
+    for (uint32_t i = 0; i < sampleCount; ++i)
+    {
+        bool   existed = false;
+        Entry* pEntry  = nullptr;
+
+        if (m_entries.FindAllocate(pSamples[i].apiHash, &existed, &pEntry) == Util::Result::Success)
+        {
+            if (existed == false)
+            {
+                memset(pEntry, 0, sizeof(*pEntry));
+            }
+
+            pEntry->sampleCount++;
+            pEntry->gpuNs += pSamples[i].gpuNs;
+
+            for (uint32_t counter = 0; counter < PipelineStatsCounterCount; ++counter)
+            {
+                pEntry->counters[counter] += pSamples[i].counters[counter];
+            }
+        }
+        else
+        {
+            m_droppedCount++;
+        }
+    }
+}
+
+// =====================================================================================================================
+void PipelineStatsProfile::Write(
+    Util::JsonWriter* pWriter) const
+{
+    Util::MutexAuto lock(&m_lock);
+
+    pWriter->KeyAndBeginList("pipelines", false);
+
+    for (auto it = m_entries.Begin(); it.Get() != nullptr; it.Next())
+    {
+        const Entry& entry = it.Get()->value;
+
+        // Registered pipelines which were never sampled
+        if (entry.sampleCount == 0)
+        {
+            continue;
+        }
+
+        char hashString[19];
+        Util::Snprintf(hashString, sizeof(hashString), "0x%016llX", it.Get()->key);
+
+        pWriter->BeginMap(true);
+        pWriter->KeyAndValue("apiHash", hashString);
+        pWriter->KeyAndValue("samples", entry.sampleCount);
+        pWriter->KeyAndValue("gpuTimeNs", entry.gpuNs);
+
+        for (uint32_t counter = 0; counter < PipelineStatsCounterCount; ++counter)
+        {
+            pWriter->KeyAndValue(CounterNames[counter], entry.counters[counter]);
+        }
+
+        if (entry.shadersKnown)
+        {
+            pWriter->KeyAndBeginMap("shaders", true);
+
+            for (uint32_t stage = 0; stage < ShaderStageCount; ++stage)
+            {
+                if ((entry.codeHashes[stage].upper != 0) || (entry.codeHashes[stage].lower != 0))
+                {
+                    char codeHashString[36];
+                    Util::Snprintf(codeHashString, sizeof(codeHashString), "0x%016llX %016llX",
+                                   entry.codeHashes[stage].upper, entry.codeHashes[stage].lower);
+
+                    pWriter->KeyAndValue(StageNames[stage], codeHashString);
+                }
+            }
+
+            pWriter->EndMap();
+        }
+
+        pWriter->EndMap();
+    }
+
+    pWriter->EndList();
+
+    WriteHotShaders(pWriter);
+
+    m_pDevice->GetPipelineAutotuner()->Write(pWriter);
+
+    pWriter->KeyAndValue("droppedSamples", m_droppedCount);
+}
+
+// =====================================================================================================================
+// Writes the sampled invocations of each shader summed over all the pipelines using it, hottest first.  The share is
+// relative to all the sampled invocations of the same stage.  Must be called with the lock held.
+void PipelineStatsProfile::WriteHotShaders(
+    Util::JsonWriter* pWriter) const
+{
+    struct ShaderEntry
+    {
+        Pal::ShaderHash codeHash;
+        uint32_t        stage;
+        uint32_t        pipelineCount;
+        uint64_t        invocations;
+    };
+
+    Instance* pInstance = m_pDevice->VkInstance();
+
+    ShaderEntry* pShaders = static_cast<ShaderEntry*>(pInstance->AllocMem(
+        sizeof(ShaderEntry) * Util::Max(m_entries.GetNumEntries(), 1u) * ShaderStageCount,
+        VK_SYSTEM_ALLOCATION_SCOPE_COMMAND));
+
+    pWriter->KeyAndBeginList("hotShaders", false);
+
+    if (pShaders != nullptr)
+    {
+        uint64_t stageTotals[ShaderStageCount] = {};
+        uint32_t shaderCount                   = 0;
+
+        for (auto it = m_entries.Begin(); it.Get() != nullptr; it.Next())
+        {
+            const Entry& entry = it.Get()->value;
+
+            if (entry.shadersKnown && (entry.sampleCount > 0))
+            {
+                for (uint32_t stage = 0; stage < ShaderStageCount; ++stage)
+                {
+                    if ((entry.codeHashes[stage].upper != 0) || (entry.codeHashes[stage].lower != 0))
+                    {
+                        ShaderEntry* pShader = &pShaders[shaderCount++];
+
+                        pShader->codeHash      = entry.codeHashes[stage];
+                        pShader->stage         = stage;
+                        pShader->pipelineCount = 1;
+                        pShader->invocations   = entry.counters[StageCounters[stage]];
+
+                        stageTotals[stage] += pShader->invocations;
+                    }
+                }
+            }
+        }
+
+        // Merge the pipelines sharing a shader
+        std::sort(pShaders, pShaders + shaderCount, [](const ShaderEntry& a, const ShaderEntry& b)
+        {
+            return (a.stage != b.stage)                   ? (a.stage < b.stage) :
+                   (a.codeHash.upper != b.codeHash.upper) ? (a.codeHash.upper < b.codeHash.upper) :
+                                                            (a.codeHash.lower < b.codeHash.lower);
+        });
+
+        uint32_t mergedCount = 0;
+
+        for (uint32_t i = 0; i < shaderCount; ++i)
+        {
+            ShaderEntry* pLast = (mergedCount > 0) ? &pShaders[mergedCount - 1] : nullptr;
+
+            if ((pLast != nullptr)                                    &&
+                (pLast->stage == pShaders[i].stage)                   &&
+                (pLast->codeHash.upper == pShaders[i].codeHash.upper) &&
+                (pLast->codeHash.lower == pShaders[i].codeHash.lower))
+            {
+                pLast->pipelineCount++;
+                pLast->invocations += pShaders[i].invocations;
+            }
+            else
+            {
+                pShaders[mergedCount++] = pShaders[i];
+            }
+        }
+
+        std::sort(pShaders, pShaders + mergedCount, [](const ShaderEntry& a, const ShaderEntry& b)
+        {
+            return a.invocations > b.invocations;
+        });
+
+        for (uint32_t i = 0; i < mergedCount; ++i)
+        {
+            const ShaderEntry& shader = pShaders[i];
+
+            // Same format as the codeHash of a shader profile pattern
+            char hashString[36];
+            Util::Snprintf(hashString, sizeof(hashString), "0x%016llX %016llX",
+                           shader.codeHash.upper, shader.codeHash.lower);
+
+            const uint64_t stageTotal = stageTotals[shader.stage];
+
+            pWriter->BeginMap(true);
+            pWriter->KeyAndValue("stage", StageNames[shader.stage]);
+            pWriter->KeyAndValue("codeHash", hashString);
+            pWriter->KeyAndValue("invocations", shader.invocations);
+            pWriter->KeyAndValue("stageSharePermille", (stageTotal > 0) ? ((shader.invocations * 1000) / stageTotal) : 0);
+            pWriter->KeyAndValue("pipelines", shader.pipelineCount);
+            pWriter->EndMap();
+        }
+
+        pInstance->FreeMem(pShaders);
+    }
+
+    pWriter->EndList();
+}
+
+// =====================================================================================================================
+PipelineStatsCmdBufferState::PipelineStatsCmdBufferState(
+    Device*               pDevice,
+    PipelineStatsProfile* pProfile)
+    :
+    m_pDevice(pDevice),
+    m_pProfile(pProfile),
+    m_sampleInterval(Util::Max(pDevice->GetRuntimeSettings().pipelineStatsProfileSampleInterval, 1u)),
+    m_pPalQueryPool(nullptr),
+    m_sampleCount(0),
+    m_openSlot(InvalidSlot),
+    m_skipCount(0),
+    m_droppedCount(0)
+{
+}
+
+// =====================================================================================================================
+// Creates the query pool and binds its memory.  Only the default device's command buffer is sampled.
+VkResult PipelineStatsCmdBufferState::Init()
+{
+    VkResult    result    = VK_SUCCESS;
+    Pal::Result palResult = Pal::Result::Success;
+
+    Pal::IDevice* pPalDevice = m_pDevice->PalDevice(DefaultDeviceIndex);
+
+    Pal::QueryPoolCreateInfo createInfo = {};
+
+    createInfo.queryPoolType         = Pal::QueryPoolType::PipelineStats;
+    createInfo.numSlots              = MaxSamples;
+    createInfo.enabledStats          = VkToPalQueryPipelineStatsFlags((1 << PipelineStatsCounterCount) - 1);
+    createInfo.flags.enableCpuAccess = true;
+
+    const size_t palSize = pPalDevice->GetQueryPoolSize(createInfo, &palResult);
+
+    void* pPalMem = nullptr;
+
+    if (palResult == Pal::Result::Success)
+    {
+        pPalMem = m_pDevice->VkInstance()->AllocMem(palSize, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+        result = (pPalMem != nullptr) ? VK_SUCCESS : VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    else
+    {
+        result = PalToVkResult(palResult);
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        result = PalToVkResult(pPalDevice->CreateQueryPool(createInfo, pPalMem, &m_pPalQueryPool));
+
+        if (result != VK_SUCCESS)
+        {
+            m_pDevice->VkInstance()->FreeMem(pPalMem);
+            m_pPalQueryPool = nullptr;
+        }
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        result = m_pDevice->MemMgr()->AllocAndBindGpuMem(
+            1,
+            reinterpret_cast<Pal::IGpuMemoryBindable**>(&m_pPalQueryPool),
+            false,
+            &m_queryMem,
+            1 << DefaultDeviceIndex,
+            true,
+            true);
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        m_pPalQueryPool->Reset(0, MaxSamples, nullptr);
+    }
+
+    // Timing is optional; without it the samples just carry no GPU time.
+    if ((result == VK_SUCCESS) && (m_pDevice->TimestampFrequency() > 0))
+    {
+        InternalMemCreateInfo allocInfo = {};
+
+        allocInfo.pal.size      = 2 * MaxSamples * sizeof(uint64_t);
+        allocInfo.pal.alignment = sizeof(uint64_t);
+        allocInfo.pal.priority  = Pal::GpuMemPriority::Normal;
+
+        m_pDevice->MemMgr()->GetCommonPool(InternalPoolCpuCacheableGpuUncached, &allocInfo);
+
+        if (m_pDevice->MemMgr()->AllocGpuMem(allocInfo, &m_timestampMem, 1 << DefaultDeviceIndex) == VK_SUCCESS)
+        {
+            memset(m_timestampMem.CpuAddr(DefaultDeviceIndex), 0xFF, 2 * MaxSamples * sizeof(uint64_t));
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+void PipelineStatsCmdBufferState::Destroy()
+{
+    if (m_pPalQueryPool != nullptr)
+    {
+        Resolve();
+
+        m_pPalQueryPool->Destroy();
+
+        if (m_queryMem.Size() > 0)
+        {
+            m_pDevice->MemMgr()->FreeGpuMem(&m_queryMem);
+        }
+
+        if (m_timestampMem.Size() > 0)
+        {
+            m_pDevice->MemMgr()->FreeGpuMem(&m_timestampMem);
+        }
+
+        m_pDevice->VkInstance()->FreeMem(m_pPalQueryPool);
+        m_pPalQueryPool = nullptr;
+    }
+}
+
+// =====================================================================================================================
+// Called before each draw or dispatch.
+void PipelineStatsCmdBufferState::BeginSample(
+    Pal::ICmdBuffer* pPalCmdBuffer,
+    uint64_t         apiHash)
+{
+    VK_ASSERT(m_openSlot == InvalidSlot);
+
+    if (m_skipCount > 0)
+    {
+        m_skipCount--;
+    }
+    else
+    {
+        m_skipCount = m_sampleInterval - 1;
+
+        if (m_sampleCount < MaxSamples)
+        {
+            Pal::QueryControlFlags flags = {};
+
+            m_openSlot              = m_sampleCount++;
+            m_apiHashes[m_openSlot] = apiHash;
+
+            WriteTimestamp(pPalCmdBuffer, m_openSlot, true);
+
+            pPalCmdBuffer->CmdBeginQuery(*m_pPalQueryPool, Pal::QueryType::PipelineStats, m_openSlot, flags);
+        }
+        else
+        {
+            m_droppedCount++;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Called after each draw or dispatch.
+void PipelineStatsCmdBufferState::EndSample(
+    Pal::ICmdBuffer* pPalCmdBuffer)
+{
+    if (m_openSlot != InvalidSlot)
+    {
+        pPalCmdBuffer->CmdEndQuery(*m_pPalQueryPool, Pal::QueryType::PipelineStats, m_openSlot);
+
+        WriteTimestamp(pPalCmdBuffer, m_openSlot, false);
+
+        m_openSlot = InvalidSlot;
+    }
+}
+
+// =====================================================================================================================
+// Hands the samples of the last recording to the profile and resets the used slots.  Only called when the command
+// buffer isn't pending, so the GPU has completed all the queries it is ever going to complete.
+void PipelineStatsCmdBufferState::Resolve()
+{
+    if (m_sampleCount > 0)
+    {
+        // Each slot's counters are followed by its availability
+        constexpr uint32_t SlotValueCount = PipelineStatsCounterCount + 1;
+
+        uint64_t results[MaxSamples * SlotValueCount];
+        size_t   dataSize = m_sampleCount * SlotValueCount * sizeof(uint64_t);
+
+        const Pal::QueryResultFlags flags =
+            static_cast<Pal::QueryResultFlags>(Pal::QueryResult64Bit | Pal::QueryResultAvailability);
+
+        const Pal::Result palResult = m_pPalQueryPool->GetResults(flags,
+                                                                  Pal::QueryType::PipelineStats,
+                                                                  0,
+                                                                  m_sampleCount,
+                                                                  m_queryMem.CpuAddr(DefaultDeviceIndex),
+                                                                  &dataSize,
+                                                                  results,
+                                                                  SlotValueCount * sizeof(uint64_t));
+
+        const uint64_t* pTimestamps = (m_timestampMem.Size() > 0) ?
+            static_cast<const uint64_t*>(m_timestampMem.CpuAddr(DefaultDeviceIndex)) : nullptr;
+        const uint64_t  frequency   = m_pDevice->TimestampFrequency();
+
+        PipelineStatsSample samples[MaxSamples];
+        uint32_t            validCount = 0;
+
+        // NotReady only means some queries never completed, e.g. because the command buffer was never submitted.
+        if ((palResult == Pal::Result::Success) || (palResult == Pal::Result::NotReady))
+        {
+            for (uint32_t slot = 0; slot < m_sampleCount; ++slot)
+            {
+                const uint64_t* pSlotValues = &results[slot * SlotValueCount];
+
+                if (pSlotValues[PipelineStatsCounterCount] != 0)
+                {
+                    samples[validCount].apiHash = m_apiHashes[slot];
+                    samples[validCount].gpuNs   = 0;
+                    memcpy(samples[validCount].counters, pSlotValues, sizeof(samples[validCount].counters));
+
+                    if (pTimestamps != nullptr)
+                    {
+                        const uint64_t beginTicks = pTimestamps[2 * slot];
+                        const uint64_t endTicks   = pTimestamps[(2 * slot) + 1];
+
+                        if ((beginTicks != TimestampNotDone) && (endTicks != TimestampNotDone) &&
+                            (endTicks >= beginTicks))
+                        {
+                            samples[validCount].gpuNs = ((endTicks - beginTicks) * 1000000000) / frequency;
+                        }
+                    }
+
+                    validCount++;
+                }
+            }
+        }
+
+        m_pProfile->RecordSamples(samples, validCount, m_droppedCount);
+
+        m_pPalQueryPool->Reset(0, m_sampleCount, nullptr);
+
+        if (pTimestamps != nullptr)
+        {
+            memset(m_timestampMem.CpuAddr(DefaultDeviceIndex), 0xFF, 2 * m_sampleCount * sizeof(uint64_t));
+        }
+
+        m_sampleCount  = 0;
+        m_droppedCount = 0;
+    }
+
+    m_openSlot  = InvalidSlot;
+    m_skipCount = 0;
+}
+
+// =====================================================================================================================
+void PipelineStatsCmdBufferState::WriteTimestamp(
+    Pal::ICmdBuffer* pPalCmdBuffer,
+    uint32_t         slot,
+    bool             topOfPipe)
+{
+    if (m_timestampMem.Size() > 0)
+    {
+        pPalCmdBuffer->CmdWriteTimestamp(topOfPipe ? Pal::HwPipeTop : Pal::HwPipeBottom,
+                                         *m_timestampMem.PalMemory(DefaultDeviceIndex),
+                                         m_timestampMem.Offset() + (((2 * slot) + (topOfPipe ? 0 : 1)) *
+                                                                    sizeof(uint64_t)));
+    }
+}
+
+} // namespace vk
@@ -0,0 +1,457 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  queue_submit_stats.cpp
+* @brief Implementation of the per-queue submission latency and GPU idle gap statistics.
+***********************************************************************************************************************
+*/
+#include "include/queue_submit_stats.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+#include "include/vk_queue.h"
+
+#include "palCmdBuffer.h"
+#include "palFence.h"
+#include "palInlineFuncs.h"
+#include "palJsonWriter.h"
+#include "palQueue.h"
+#include "palSysUtil.h"
+
+#include <string.h>
+
+namespace vk
+{
+
+// =====================================================================================================================
+// Allocates the stats of a queue.  The GPU idle gap sampling is left off if its resources can't be created, so this
+// only fails if the stats themselves can't be allocated.
+QueueSubmitStats* QueueSubmitStats::Create(
+    Device* pDevice,
+    Queue*  pQueue)
+{
+    QueueSubmitStats* pStats = nullptr;
+    void*             pMem   = pDevice->VkInstance()->AllocMem(sizeof(QueueSubmitStats),
+                                                               VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+    if (pMem != nullptr)
+    {
+        pStats = VK_PLACEMENT_NEW(pMem) QueueSubmitStats(pDevice, pQueue);
+
+        if ((pStats->m_sampleInterval > 0) && (pStats->InitIdleGapProbe() != VK_SUCCESS))
+        {
+            pStats->m_sampleInterval = 0;
+        }
+    }
+
+    return pStats;
+}
+
+// =====================================================================================================================
+QueueSubmitStats::QueueSubmitStats(
+    Device* pDevice,
+    Queue*  pQueue)
+    :
+    m_pDevice(pDevice),
+    m_pQueue(pQueue),
+    m_perfFrequency(Util::GetPerfFrequency()),
+    m_timestampFrequency(pDevice->TimestampFrequency()),
+    m_lastSubmitTicks(0),
+    m_lastPresentTicks(0),
+    m_imagePresentCount(0),
+    m_fullscreenFlipCount(0),
+    m_failedPresentCount(0),
+    m_sampleInterval(pDevice->GetRuntimeSettings().queueSubmitStatsIdleGapSampleInterval),
+    m_submitsUntilSample(pDevice->GetRuntimeSettings().queueSubmitStatsIdleGapSampleInterval),
+    m_probeState(ProbeState::Idle),
+    m_pEndCmdBuf(nullptr),
+    m_pBeginCmdBuf(nullptr)
+{
+    memset(&m_submitCpuTime, 0, sizeof(m_submitCpuTime));
+    memset(&m_submitInterval, 0, sizeof(m_submitInterval));
+    memset(&m_presentCpuTime, 0, sizeof(m_presentCpuTime));
+    memset(&m_gpuIdleGap, 0, sizeof(m_gpuIdleGap));
+    memset(&m_presentInterval, 0, sizeof(m_presentInterval));
+    memset(&m_acquireWait, 0, sizeof(m_acquireWait));
+    memset(&m_presentLatency, 0, sizeof(m_presentLatency));
+}
+
+// =====================================================================================================================
+// Creates the two command buffers and the timestamp memory of the idle gap sampling.  Only the default device's queue
+// is sampled, and only if its engine can write timestamps.
+VkResult QueueSubmitStats::InitIdleGapProbe()
+{
+    const Pal::DeviceProperties& props      = m_pDevice->VkPhysicalDevice(DefaultDeviceIndex)->PalProperties();
+    const Pal::EngineType        engineType = m_pDevice->GetQueueFamilyPalEngineType(m_pQueue->GetFamilyIndex());
+
+    VkResult result = VK_ERROR_FEATURE_NOT_PRESENT;
+
+    if ((props.engineProperties[engineType].flags.supportsTimestamps != 0) && (m_timestampFrequency > 0))
+    {
+        InternalMemCreateInfo allocInfo = {};
+
+        allocInfo.pal.size      = 2 * sizeof(uint64_t);
+        allocInfo.pal.alignment = sizeof(uint64_t);
+        allocInfo.pal.priority  = Pal::GpuMemPriority::Normal;
+
+        m_pDevice->MemMgr()->GetCommonPool(InternalPoolCpuCacheableGpuUncached, &allocInfo);
+
+        result = m_pDevice->MemMgr()->AllocGpuMem(allocInfo, &m_timestampMem, 1 << DefaultDeviceIndex);
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        m_pEndCmdBuf   = m_pQueue->CreateCmdBufState(DefaultDeviceIndex);
+        m_pBeginCmdBuf = m_pQueue->CreateCmdBufState(DefaultDeviceIndex);
+
+        if ((m_pEndCmdBuf == nullptr) || (m_pBeginCmdBuf == nullptr))
+        {
+            result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Frees the stats.  Waits for a sample still on the GPU, as it writes the timestamp memory.
+void QueueSubmitStats::Destroy()
+{
+    if (m_pEndCmdBuf != nullptr)
+    {
+        m_pQueue->DestroyCmdBufState(DefaultDeviceIndex, m_pEndCmdBuf);
+    }
+
+    if (m_pBeginCmdBuf != nullptr)
+    {
+        m_pQueue->DestroyCmdBufState(DefaultDeviceIndex, m_pBeginCmdBuf);
+    }
+
+    if (m_timestampMem.Size() > 0)
+    {
+        m_pDevice->MemMgr()->FreeGpuMem(&m_timestampMem);
+    }
+
+    Instance* pInstance = m_pDevice->VkInstance();
+
+    Util::Destructor(this);
+
+    pInstance->FreeMem(this);
+}
+
+// =====================================================================================================================
+// Records the CPU time of a vkQueueSubmit call and the time since the previous one started.
+void QueueSubmitStats::RecordSubmit(
+    int64_t startTicks,
+    int64_t endTicks)
+{
+    AddTicksSample(&m_submitCpuTime, endTicks - startTicks);
+
+    if (m_lastSubmitTicks != 0)
+    {
+        AddTicksSample(&m_submitInterval, startTicks - m_lastSubmitTicks);
+    }
+
+    m_lastSubmitTicks = startTicks;
+}
+
+// =====================================================================================================================
+// Records the CPU time of a vkQueuePresentKHR call and the time since the previous one started, which is the frame
+// time as seen by the application.
+void QueueSubmitStats::RecordPresent(
+    int64_t startTicks,
+    int64_t endTicks)
+{
+    AddTicksSample(&m_presentCpuTime, endTicks - startTicks);
+
+    if (m_lastPresentTicks != 0)
+    {
+        AddTicksSample(&m_presentInterval, startTicks - m_lastPresentTicks);
+    }
+
+    m_lastPresentTicks = startTicks;
+}
+
+// =====================================================================================================================
+// Records one swap chain image handed to PAL by vkQueuePresentKHR, along with how long acquiring it had blocked.
+void QueueSubmitStats::RecordImagePresent(
+    int64_t acquireWaitTicks,
+    bool    fullscreenFlip,
+    bool    failed)
+{
+    AddTicksSample(&m_acquireWait, acquireWaitTicks);
+
+    m_imagePresentCount++;
+
+    if (fullscreenFlip)
+    {
+        m_fullscreenFlipCount++;
+    }
+
+    if (failed)
+    {
+        m_failedPresentCount++;
+    }
+}
+
+// =====================================================================================================================
+// Records the time from a present until the GPU was seen done with it.  Called by swap chains with low-latency pacing,
+// possibly on a different thread than the presents.
+void QueueSubmitStats::RecordPresentLatency(
+    int64_t latencyTicks)
+{
+    AddTicksSample(&m_presentLatency, latencyTicks);
+}
+
+// =====================================================================================================================
+// Called right before the queue hands a command buffer submission to PAL.  Collects a finished sample, or completes
+// the pending one by writing the begin timestamp ahead of this submission.
+void QueueSubmitStats::BeforePalSubmit(
+    Pal::IQueue* pPalQueue)
+{
+    if (m_probeState == ProbeState::BeginWritten)
+    {
+        CheckIdleGapProbe();
+    }
+
+    if (m_probeState == ProbeState::EndWritten)
+    {
+        m_probeState = (SubmitTimestamp(pPalQueue, m_pBeginCmdBuf, true) == Pal::Result::Success) ?
+                       ProbeState::BeginWritten : ProbeState::Idle;
+    }
+}
+
+// =====================================================================================================================
+// Called right after the queue handed a command buffer submission to PAL.  Every m_sampleInterval-th submission gets
+// the end timestamp written after it.
+void QueueSubmitStats::AfterPalSubmit(
+    Pal::IQueue* pPalQueue)
+{
+    if ((m_probeState == ProbeState::Idle) && (m_sampleInterval > 0) && (--m_submitsUntilSample == 0))
+    {
+        m_submitsUntilSample = m_sampleInterval;
+
+        if (SubmitTimestamp(pPalQueue, m_pEndCmdBuf, false) == Pal::Result::Success)
+        {
+            m_probeState = ProbeState::EndWritten;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Records and submits a command buffer writing a single timestamp.  The begin timestamp goes to the second slot.
+Pal::Result QueueSubmitStats::SubmitTimestamp(
+    Pal::IQueue* pPalQueue,
+    CmdBufState* pCmdBufState,
+    bool         topOfPipe)
+{
+    Pal::CmdBufferBuildInfo buildInfo = {};
+
+    buildInfo.flags.optimizeOneTimeSubmit = 1;
+
+    Pal::Result result = pCmdBufState->pCmdBuf->Reset(m_pDevice->GetSharedCmdAllocator(DefaultDeviceIndex), true);
+
+    if (result == Pal::Result::Success)
+    {
+        result = pCmdBufState->pCmdBuf->Begin(buildInfo);
+    }
+
+    if (result == Pal::Result::Success)
+    {
+        pCmdBufState->pCmdBuf->CmdWriteTimestamp(topOfPipe ? Pal::HwPipeTop : Pal::HwPipeBottom,
+                                                 *m_timestampMem.PalMemory(DefaultDeviceIndex),
+                                                 m_timestampMem.Offset() + (topOfPipe ? sizeof(uint64_t) : 0));
+
+        result = pCmdBufState->pCmdBuf->End();
+    }
+
+    if (result == Pal::Result::Success)
+    {
+        result = m_pDevice->PalDevice(DefaultDeviceIndex)->ResetFences(1, &pCmdBufState->pFence);
+    }
+
+    if (result == Pal::Result::Success)
+    {
+        Pal::PerSubQueueSubmitInfo perSubQueueInfo = {};
+        Pal::SubmitInfo            submitInfo      = {};
+
+        perSubQueueInfo.cmdBufferCount = 1;
+        perSubQueueInfo.ppCmdBuffers   = &pCmdBufState->pCmdBuf;
+
+        submitInfo.pPerSubQueueInfo     = &perSubQueueInfo;
+        submitInfo.perSubQueueInfoCount = 1;
+        submitInfo.ppFences             = &pCmdBufState->pFence;
+        submitInfo.fenceCount           = 1;
+
+        result = pPalQueue->Submit(submitInfo);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Adds the idle gap of the pending sample to the histogram once the GPU has written both timestamps.  The end
+// timestamp is written first, so the begin one being done means both are.
+void QueueSubmitStats::CheckIdleGapProbe()
+{
+    if (m_pBeginCmdBuf->pFence->GetStatus() == Pal::Result::Success)
+    {
+        const uint64_t* pTimestamps = static_cast<const uint64_t*>(m_timestampMem.CpuAddr(DefaultDeviceIndex));
+
+        const uint64_t endTicks   = pTimestamps[0];
+        const uint64_t beginTicks = pTimestamps[1];
+        const uint64_t gapTicks   = (beginTicks > endTicks) ? (beginTicks - endTicks) : 0;
+
+        AddSample(&m_gpuIdleGap, (gapTicks * 1000000) / m_timestampFrequency);
+
+        m_probeState = ProbeState::Idle;
+    }
+}
+
+// =====================================================================================================================
+void QueueSubmitStats::AddSample(
+    Histogram* pHistogram,
+    uint64_t   us)
+{
+    Util::AtomicIncrement64(&pHistogram->count);
+    Util::AtomicAdd64(&pHistogram->totalUs, us);
+    Util::AtomicIncrement64(&pHistogram->buckets[GetBucket(us)]);
+
+    if (us > pHistogram->maxUs)
+    {
+        pHistogram->maxUs = us;
+    }
+}
+
+// =====================================================================================================================
+void QueueSubmitStats::AddTicksSample(
+    Histogram* pHistogram,
+    int64_t    ticks) const
+{
+    AddSample(pHistogram, static_cast<uint64_t>(Util::Max(ticks, int64_t(0)) * 1000000) / m_perfFrequency);
+}
+
+// =====================================================================================================================
+// Values below SubBucketCount get a bin each; above that, every power of two is split into SubBucketCount bins.
+uint32_t QueueSubmitStats::GetBucket(
+    uint64_t us)
+{
+    uint32_t bucket = static_cast<uint32_t>(us);
+
+    if (us >= SubBucketCount)
+    {
+        const uint32_t msb = Util::Log2(us);
+        const uint32_t sub = static_cast<uint32_t>(us >> (msb - SubBucketBits)) & (SubBucketCount - 1);
+
+        bucket = ((msb - SubBucketBits + 1) * SubBucketCount) + sub;
+    }
+
+    return Util::Min(bucket, BucketCount - 1);
+}
+
+// =====================================================================================================================
+// Returns the exclusive upper bound, in microseconds, of the samples counted in a bin.
+uint64_t QueueSubmitStats::GetBucketUpperBound(
+    uint32_t bucket)
+{
+    uint64_t bound = bucket + 1;
+
+    if (bucket >= SubBucketCount)
+    {
+        const uint32_t shift = (bucket / SubBucketCount) - 1;
+        const uint64_t sub   = bucket % SubBucketCount;
+
+        bound = (SubBucketCount + sub + 1) << shift;
+    }
+
+    return bound;
+}
+
+// =====================================================================================================================
+// Estimates a percentile from the histogram as the upper bound of the bin holding the sample.
+uint64_t QueueSubmitStats::GetPercentileUs(
+    const Histogram& histogram,
+    uint32_t         percentile)
+{
+    const uint64_t count  = histogram.count;
+    const uint64_t target = ((count * percentile) + 99) / 100;
+
+    uint64_t seen   = 0;
+    uint32_t bucket = 0;
+
+    for (; bucket < (BucketCount - 1); ++bucket)
+    {
+        seen += histogram.buckets[bucket];
+
+        if ((seen >= target) && (seen > 0))
+        {
+            break;
+        }
+    }
+
+    return (count > 0) ? GetBucketUpperBound(bucket) : 0;
+}
+
+// =====================================================================================================================
+void QueueSubmitStats::WriteHistogram(
+    Util::JsonWriter* pWriter,
+    const char*       pName,
+    const Histogram&  histogram)
+{
+    pWriter->KeyAndBeginMap(pName, true);
+    pWriter->KeyAndValue("count", histogram.count);
+    pWriter->KeyAndValue("totalUs", histogram.totalUs);
+    pWriter->KeyAndValue("p50Us", GetPercentileUs(histogram, 50));
+    pWriter->KeyAndValue("p90Us", GetPercentileUs(histogram, 90));
+    pWriter->KeyAndValue("p99Us", GetPercentileUs(histogram, 99));
+    pWriter->KeyAndValue("maxUs", histogram.maxUs);
+    pWriter->EndMap();
+}
+
+// =====================================================================================================================
+// Writes the stats as the members of the JSON map the writer is currently in.  Samples may be recorded while this runs,
+// so the members of a snapshot may be off by the calls that were in flight.
+void QueueSubmitStats::Write(
+    Util::JsonWriter* pWriter) const
+{
+    pWriter->KeyAndValue("queueFamilyIndex", m_pQueue->GetFamilyIndex());
+    pWriter->KeyAndValue("queueIndex", m_pQueue->GetIndex());
+
+    WriteHistogram(pWriter, "submitCpuTime", m_submitCpuTime);
+    WriteHistogram(pWriter, "submitInterval", m_submitInterval);
+    WriteHistogram(pWriter, "presentCpuTime", m_presentCpuTime);
+    WriteHistogram(pWriter, "gpuIdleGap", m_gpuIdleGap);
+    WriteHistogram(pWriter, "presentInterval", m_presentInterval);
+    WriteHistogram(pWriter, "acquireWait", m_acquireWait);
+    WriteHistogram(pWriter, "presentLatency", m_presentLatency);
+
+    pWriter->KeyAndValue("imagePresentCount", m_imagePresentCount);
+    pWriter->KeyAndValue("fullscreenFlipCount", m_fullscreenFlipCount);
+    pWriter->KeyAndValue("failedPresentCount", m_failedPresentCount);
+
+    pWriter->KeyAndValue("idleGapSampleInterval", m_sampleInterval);
+}
+
+} // namespace vk
@@ -0,0 +1,832 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  queue_submit_thread.cpp
+* @brief Implementation of the per-queue thread which performs deferred queue submissions.
+***********************************************************************************************************************
+*/
+#include "include/queue_submit_thread.h"
+#include "include/vk_conv.h"
+#include "include/vk_fence.h"
+#include "include/vk_instance.h"
+#include "include/vk_queue.h"
+#include "include/vk_semaphore.h"
+
+#include "palInlineFuncs.h"
+#include "palSysUtil.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+// Size of an array in a job allocation.  Every array starts 8-byte aligned.
+template <typename T>
+static size_t ArraySize(
+    uint32_t count)
+{
+    return Util::Pow2Align(sizeof(T) * count, sizeof(uint64_t));
+}
+
+// =====================================================================================================================
+// Copies an array to the front of a job allocation and advances the allocation past it.
+template <typename T>
+static T* CopyArray(
+    void**   ppMem,
+    const T* pSrc,
+    uint32_t count)
+{
+    T* pDst = nullptr;
+
+    if ((pSrc != nullptr) && (count > 0))
+    {
+        pDst = static_cast<T*>(*ppMem);
+        memcpy(pDst, pSrc, sizeof(T) * count);
+
+        *ppMem = Util::VoidPtrInc(*ppMem, ArraySize<T>(count));
+    }
+
+    return pDst;
+}
+
+// =====================================================================================================================
+// Allocates a submit thread and starts it.  Returns nullptr if the thread couldn't be started.
+QueueSubmitThread* QueueSubmitThread::Create(
+    Instance* pInstance,
+    Queue*    pQueue)
+{
+    QueueSubmitThread* pThread = nullptr;
+    void*              pMem    = pInstance->AllocMem(sizeof(QueueSubmitThread), VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+    if (pMem != nullptr)
+    {
+        pThread = VK_PLACEMENT_NEW(pMem) QueueSubmitThread(pInstance, pQueue);
+
+        if (pThread->Init() != VK_SUCCESS)
+        {
+            pThread->Destroy();
+            pThread = nullptr;
+        }
+    }
+
+    return pThread;
+}
+
+// =====================================================================================================================
+QueueSubmitThread::QueueSubmitThread(
+    Instance* pInstance,
+    Queue*    pQueue)
+    :
+    m_pInstance(pInstance),
+    m_pQueue(pQueue),
+    m_submittedCount(0),
+    m_completedCount(0),
+    m_result(VK_SUCCESS),
+    m_stop(false),
+    m_threadStarted(false)
+{
+    memset(m_ring, 0, sizeof(m_ring));
+}
+
+// =====================================================================================================================
+VkResult QueueSubmitThread::Init()
+{
+    Util::EventCreateFlags flags = {};
+    flags.manualReset       = false;
+    flags.initiallySignaled = false;
+
+    VkResult result = PalToVkResult(m_wakeEvent.Init(flags));
+
+    if (result == VK_SUCCESS)
+    {
+        result = PalToVkResult(m_submissionDone.Init());
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        result = PalToVkResult(m_thread.Begin(ThreadFunc, this));
+
+        m_threadStarted = (result == VK_SUCCESS);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Finishes all queued submissions, stops the thread and frees this object.
+void QueueSubmitThread::Destroy()
+{
+    if (m_threadStarted)
+    {
+        WaitIdle();
+
+        m_stop = true;
+        m_wakeEvent.Set();
+
+        m_thread.Join();
+    }
+
+    Instance* pInstance = m_pInstance;
+
+    Util::Destructor(this);
+
+    pInstance->FreeMem(this);
+}
+
+// =====================================================================================================================
+VkResult QueueSubmitThread::Submit(
+    uint32_t            submitCount,
+    const VkSubmitInfo* pSubmits,
+    VkFence             fence)
+{
+    return Enqueue(submitCount, pSubmits, fence);
+}
+
+// =====================================================================================================================
+VkResult QueueSubmitThread::Submit(
+    uint32_t                submitCount,
+    const VkSubmitInfo2KHR* pSubmits,
+    VkFence                 fence)
+{
+    return Enqueue(submitCount, pSubmits, fence);
+}
+
+// =====================================================================================================================
+VkResult QueueSubmitThread::BindSparse(
+    uint32_t                bindInfoCount,
+    const VkBindSparseInfo* pBindInfos,
+    VkFence                 fence)
+{
+    return Enqueue(bindInfoCount, pBindInfos, fence);
+}
+
+// =====================================================================================================================
+// Copies a submit or bind sparse call into a job and queues it for the thread.  Only fails if the copy can't be
+// allocated or an earlier deferred submission failed.
+template <typename SubmitInfoType>
+VkResult QueueSubmitThread::Enqueue(
+    uint32_t              submitCount,
+    const SubmitInfoType* pSubmits,
+    VkFence               fence)
+{
+    VkResult result = m_result;
+
+    if (result == VK_SUCCESS)
+    {
+        const uint32_t waitCount = GetWaitSemaphoreCount(submitCount, pSubmits);
+        const size_t   jobSize   = ArraySize<Job>(1) +
+                                   ArraySize<Dependency>(waitCount) +
+                                   GetCopySize(submitCount, pSubmits);
+
+        void* pMem = m_pInstance->AllocMem(jobSize, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+        if (pMem != nullptr)
+        {
+            const uint64_t sequence = m_submittedCount + 1;
+
+            Job* pJob = static_cast<Job*>(pMem);
+
+            pJob->type            = GetJobType(pSubmits);
+            pJob->submitCount     = submitCount;
+            pJob->fence           = fence;
+            pJob->dependencyCount = 0;
+            pJob->pDependencies   = static_cast<Dependency*>(Util::VoidPtrInc(pMem, ArraySize<Job>(1)));
+
+            void* pCopyMem = Util::VoidPtrInc(pJob->pDependencies, ArraySize<Dependency>(waitCount));
+
+            pJob->pSubmits = CopySubmits(pCopyMem, submitCount, pSubmits);
+
+            TrackSemaphores(pJob, sequence, submitCount, static_cast<const SubmitInfoType*>(pJob->pSubmits));
+
+            if (fence != VK_NULL_HANDLE)
+            {
+                Fence::ObjectFromHandle(fence)->SetPendingSubmission(this, sequence);
+            }
+
+            // The slot is free once the job which used it last has been handed to PAL.
+            if (sequence > RingSize)
+            {
+                WaitForSubmission(sequence - RingSize);
+            }
+
+            m_ring[sequence % RingSize] = pJob;
+
+            // Publish the job after its slot has been written.
+            Util::AtomicIncrement64(&m_submittedCount);
+
+            m_wakeEvent.Set();
+        }
+        else
+        {
+            result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Blocks until the thread has handed the given submission, and all earlier ones, to PAL.
+VkResult QueueSubmitThread::WaitForSubmission(
+    uint64_t sequence)
+{
+    if (IsSubmitted(sequence) == false)
+    {
+        Util::MutexAuto lock(&m_doneLock);
+
+        while (IsSubmitted(sequence) == false)
+        {
+            m_submissionDone.Wait(&m_doneLock, IdleWaitMilliseconds);
+        }
+    }
+
+    return m_result;
+}
+
+// =====================================================================================================================
+// Returns the size of the deep copy of an array of VkSubmitInfo, including the extension structures the queue uses.
+size_t QueueSubmitThread::GetCopySize(
+    uint32_t            submitCount,
+    const VkSubmitInfo* pSubmits)
+{
+    size_t size = ArraySize<VkSubmitInfo>(submitCount);
+
+    for (uint32_t i = 0; i < submitCount; ++i)
+    {
+        const VkSubmitInfo& submitInfo = pSubmits[i];
+
+        size += ArraySize<VkSemaphore>(submitInfo.waitSemaphoreCount) +
+                ArraySize<VkPipelineStageFlags>(submitInfo.waitSemaphoreCount) +
+                ArraySize<VkCommandBuffer>(submitInfo.commandBufferCount) +
+                ArraySize<VkSemaphore>(submitInfo.signalSemaphoreCount);
+
+        for (const VkStructHeader* pHeader = static_cast<const VkStructHeader*>(submitInfo.pNext);
+             pHeader != nullptr;
+             pHeader = pHeader->pNext)
+        {
+            switch (static_cast<int32_t>(pHeader->sType))
+            {
+            case VK_STRUCTURE_TYPE_DEVICE_GROUP_SUBMIT_INFO:
+            {
+                const auto* pInfo = reinterpret_cast<const VkDeviceGroupSubmitInfo*>(pHeader);
+
+                size += ArraySize<VkDeviceGroupSubmitInfo>(1) +
+                        ArraySize<uint32_t>(pInfo->waitSemaphoreCount) +
+                        ArraySize<uint32_t>(pInfo->commandBufferCount) +
+                        ArraySize<uint32_t>(pInfo->signalSemaphoreCount);
+                break;
+            }
+            case VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO:
+            {
+                const auto* pInfo = reinterpret_cast<const VkTimelineSemaphoreSubmitInfo*>(pHeader);
+
+                size += ArraySize<VkTimelineSemaphoreSubmitInfo>(1) +
+                        ArraySize<uint64_t>(pInfo->waitSemaphoreValueCount) +
+                        ArraySize<uint64_t>(pInfo->signalSemaphoreValueCount);
+                break;
+            }
+            case VK_STRUCTURE_TYPE_PROTECTED_SUBMIT_INFO:
+                size += ArraySize<VkProtectedSubmitInfo>(1);
+                break;
+
+            default:
+                // The queue ignores any other extension structures, so they aren't copied.
+                break;
+            }
+        }
+    }
+
+    return size;
+}
+
+// =====================================================================================================================
+// Returns the size of the deep copy of an array of VkSubmitInfo2KHR.
+size_t QueueSubmitThread::GetCopySize(
+    uint32_t                submitCount,
+    const VkSubmitInfo2KHR* pSubmits)
+{
+    size_t size = ArraySize<VkSubmitInfo2KHR>(submitCount);
+
+    for (uint32_t i = 0; i < submitCount; ++i)
+    {
+        size += ArraySize<VkSemaphoreSubmitInfoKHR>(pSubmits[i].waitSemaphoreInfoCount) +
+                ArraySize<VkCommandBufferSubmitInfoKHR>(pSubmits[i].commandBufferInfoCount) +
+                ArraySize<VkSemaphoreSubmitInfoKHR>(pSubmits[i].signalSemaphoreInfoCount);
+    }
+
+    return size;
+}
+
+// =====================================================================================================================
+// Returns the size of the deep copy of an array of VkBindSparseInfo, including the extension structures the queue uses.
+size_t QueueSubmitThread::GetCopySize(
+    uint32_t                bindInfoCount,
+    const VkBindSparseInfo* pBindInfos)
+{
+    size_t size = ArraySize<VkBindSparseInfo>(bindInfoCount);
+
+    for (uint32_t i = 0; i < bindInfoCount; ++i)
+    {
+        const VkBindSparseInfo& bindInfo = pBindInfos[i];
+
+        size += ArraySize<VkSemaphore>(bindInfo.waitSemaphoreCount) +
+                ArraySize<VkSparseBufferMemoryBindInfo>(bindInfo.bufferBindCount) +
+                ArraySize<VkSparseImageOpaqueMemoryBindInfo>(bindInfo.imageOpaqueBindCount) +
+                ArraySize<VkSparseImageMemoryBindInfo>(bindInfo.imageBindCount) +
+                ArraySize<VkSemaphore>(bindInfo.signalSemaphoreCount);
+
+        for (uint32_t j = 0; j < bindInfo.bufferBindCount; ++j)
+        {
+            size += ArraySize<VkSparseMemoryBind>(bindInfo.pBufferBinds[j].bindCount);
+        }
+
+        for (uint32_t j = 0; j < bindInfo.imageOpaqueBindCount; ++j)
+        {
+            size += ArraySize<VkSparseMemoryBind>(bindInfo.pImageOpaqueBinds[j].bindCount);
+        }
+
+        for (uint32_t j = 0; j < bindInfo.imageBindCount; ++j)
+        {
+            size += ArraySize<VkSparseImageMemoryBind>(bindInfo.pImageBinds[j].bindCount);
+        }
+
+        for (const VkStructHeader* pHeader = static_cast<const VkStructHeader*>(bindInfo.pNext);
+             pHeader != nullptr;
+             pHeader = pHeader->pNext)
+        {
+            switch (static_cast<int32_t>(pHeader->sType))
+            {
+            case VK_STRUCTURE_TYPE_DEVICE_GROUP_BIND_SPARSE_INFO:
+                size += ArraySize<VkDeviceGroupBindSparseInfo>(1);
+                break;
+
+            case VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO:
+            {
+                const auto* pInfo = reinterpret_cast<const VkTimelineSemaphoreSubmitInfo*>(pHeader);
+
+                size += ArraySize<VkTimelineSemaphoreSubmitInfo>(1) +
+                        ArraySize<uint64_t>(pInfo->waitSemaphoreValueCount) +
+                        ArraySize<uint64_t>(pInfo->signalSemaphoreValueCount);
+                break;
+            }
+            default:
+                // The queue ignores any other extension structures, so they aren't copied.
+                break;
+            }
+        }
+    }
+
+    return size;
+}
+
+// =====================================================================================================================
+// Deep copies an array of VkSubmitInfo into memory of the size returned by GetCopySize().
+const void* QueueSubmitThread::CopySubmits(
+    void*               pMem,
+    uint32_t            submitCount,
+    const VkSubmitInfo* pSubmits)
+{
+    VkSubmitInfo* pCopies = CopyArray(&pMem, pSubmits, submitCount);
+
+    for (uint32_t i = 0; i < submitCount; ++i)
+    {
+        VkSubmitInfo* pCopy = &pCopies[i];
+
+        pCopy->pWaitSemaphores   = CopyArray(&pMem, pCopy->pWaitSemaphores, pCopy->waitSemaphoreCount);
+        pCopy->pWaitDstStageMask = CopyArray(&pMem, pCopy->pWaitDstStageMask, pCopy->waitSemaphoreCount);
+        pCopy->pCommandBuffers   = CopyArray(&pMem, pCopy->pCommandBuffers, pCopy->commandBufferCount);
+        pCopy->pSignalSemaphores = CopyArray(&pMem, pCopy->pSignalSemaphores, pCopy->signalSemaphoreCount);
+
+        const VkStructHeader* pHeader = static_cast<const VkStructHeader*>(pCopy->pNext);
+        const void**          ppNext  = &pCopy->pNext;
+
+        pCopy->pNext = nullptr;
+
+        for (; pHeader != nullptr; pHeader = pHeader->pNext)
+        {
+            switch (static_cast<int32_t>(pHeader->sType))
+            {
+            case VK_STRUCTURE_TYPE_DEVICE_GROUP_SUBMIT_INFO:
+            {
+                auto* pInfo = CopyArray(&pMem, reinterpret_cast<const VkDeviceGroupSubmitInfo*>(pHeader), 1);
+
+                pInfo->pWaitSemaphoreDeviceIndices   = CopyArray(&pMem,
+                                                                 pInfo->pWaitSemaphoreDeviceIndices,
+                                                                 pInfo->waitSemaphoreCount);
+                pInfo->pCommandBufferDeviceMasks     = CopyArray(&pMem,
+                                                                 pInfo->pCommandBufferDeviceMasks,
+                                                                 pInfo->commandBufferCount);
+                pInfo->pSignalSemaphoreDeviceIndices = CopyArray(&pMem,
+                                                                 pInfo->pSignalSemaphoreDeviceIndices,
+                                                                 pInfo->signalSemaphoreCount);
+                pInfo->pNext = nullptr;
+
+                *ppNext = pInfo;
+                ppNext  = &pInfo->pNext;
+                break;
+            }
+            case VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO:
+            {
+                auto* pInfo = CopyArray(&pMem, reinterpret_cast<const VkTimelineSemaphoreSubmitInfo*>(pHeader), 1);
+
+                pInfo->pWaitSemaphoreValues   = CopyArray(&pMem,
+                                                          pInfo->pWaitSemaphoreValues,
+                                                          pInfo->waitSemaphoreValueCount);
+                pInfo->pSignalSemaphoreValues = CopyArray(&pMem,
+                                                          pInfo->pSignalSemaphoreValues,
+                                                          pInfo->signalSemaphoreValueCount);
+                pInfo->pNext = nullptr;
+
+                *ppNext = pInfo;
+                ppNext  = &pInfo->pNext;
+                break;
+            }
+            case VK_STRUCTURE_TYPE_PROTECTED_SUBMIT_INFO:
+            {
+                auto* pInfo = CopyArray(&pMem, reinterpret_cast<const VkProtectedSubmitInfo*>(pHeader), 1);
+
+                pInfo->pNext = nullptr;
+
+                *ppNext = pInfo;
+                ppNext  = &pInfo->pNext;
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    return pCopies;
+}
+
+// =====================================================================================================================
+// Deep copies an array of VkSubmitInfo2KHR into memory of the size returned by GetCopySize().  The queue doesn't look
+// at any extension structures of these, so the pNext chains are dropped.
+const void* QueueSubmitThread::CopySubmits(
+    void*                   pMem,
+    uint32_t                submitCount,
+    const VkSubmitInfo2KHR* pSubmits)
+{
+    VkSubmitInfo2KHR* pCopies = CopyArray(&pMem, pSubmits, submitCount);
+
+    for (uint32_t i = 0; i < submitCount; ++i)
+    {
+        VkSubmitInfo2KHR* pCopy = &pCopies[i];
+
+        pCopy->pNext                = nullptr;
+        pCopy->pWaitSemaphoreInfos  = CopyArray(&pMem, pCopy->pWaitSemaphoreInfos, pCopy->waitSemaphoreInfoCount);
+        pCopy->pCommandBufferInfos  = CopyArray(&pMem, pCopy->pCommandBufferInfos, pCopy->commandBufferInfoCount);
+        pCopy->pSignalSemaphoreInfos = CopyArray(&pMem, pCopy->pSignalSemaphoreInfos, pCopy->signalSemaphoreInfoCount);
+    }
+
+    return pCopies;
+}
+
+// =====================================================================================================================
+// Deep copies an array of VkBindSparseInfo into memory of the size returned by GetCopySize().
+const void* QueueSubmitThread::CopySubmits(
+    void*                   pMem,
+    uint32_t                bindInfoCount,
+    const VkBindSparseInfo* pBindInfos)
+{
+    VkBindSparseInfo* pCopies = CopyArray(&pMem, pBindInfos, bindInfoCount);
+
+    for (uint32_t i = 0; i < bindInfoCount; ++i)
+    {
+        VkBindSparseInfo* pCopy = &pCopies[i];
+
+        VkSparseBufferMemoryBindInfo*      pBufferBinds      =
+            CopyArray(&pMem, pCopy->pBufferBinds, pCopy->bufferBindCount);
+        VkSparseImageOpaqueMemoryBindInfo* pImageOpaqueBinds =
+            CopyArray(&pMem, pCopy->pImageOpaqueBinds, pCopy->imageOpaqueBindCount);
+        VkSparseImageMemoryBindInfo*       pImageBinds       =
+            CopyArray(&pMem, pCopy->pImageBinds, pCopy->imageBindCount);
+
+        for (uint32_t j = 0; j < pCopy->bufferBindCount; ++j)
+        {
+            pBufferBinds[j].pBinds = CopyArray(&pMem, pBufferBinds[j].pBinds, pBufferBinds[j].bindCount);
+        }
+
+        for (uint32_t j = 0; j < pCopy->imageOpaqueBindCount; ++j)
+        {
+            pImageOpaqueBinds[j].pBinds = CopyArray(&pMem, pImageOpaqueBinds[j].pBinds, pImageOpaqueBinds[j].bindCount);
+        }
+
+        for (uint32_t j = 0; j < pCopy->imageBindCount; ++j)
+        {
+            pImageBinds[j].pBinds = CopyArray(&pMem, pImageBinds[j].pBinds, pImageBinds[j].bindCount);
+        }
+
+        pCopy->pWaitSemaphores   = CopyArray(&pMem, pCopy->pWaitSemaphores, pCopy->waitSemaphoreCount);
+        pCopy->pBufferBinds      = pBufferBinds;
+        pCopy->pImageOpaqueBinds = pImageOpaqueBinds;
+        pCopy->pImageBinds       = pImageBinds;
+        pCopy->pSignalSemaphores = CopyArray(&pMem, pCopy->pSignalSemaphores, pCopy->signalSemaphoreCount);
+
+        const VkStructHeader* pHeader = static_cast<const VkStructHeader*>(pCopy->pNext);
+        const void**          ppNext  = &pCopy->pNext;
+
+        pCopy->pNext = nullptr;
+
+        for (; pHeader != nullptr; pHeader = pHeader->pNext)
+        {
+            switch (static_cast<int32_t>(pHeader->sType))
+            {
+            case VK_STRUCTURE_TYPE_DEVICE_GROUP_BIND_SPARSE_INFO:
+            {
+                auto* pInfo = CopyArray(&pMem, reinterpret_cast<const VkDeviceGroupBindSparseInfo*>(pHeader), 1);
+
+                pInfo->pNext = nullptr;
+
+                *ppNext = pInfo;
+                ppNext  = &pInfo->pNext;
+                break;
+            }
+            case VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO:
+            {
+                auto* pInfo = CopyArray(&pMem, reinterpret_cast<const VkTimelineSemaphoreSubmitInfo*>(pHeader), 1);
+
+                pInfo->pWaitSemaphoreValues   = CopyArray(&pMem,
+                                                          pInfo->pWaitSemaphoreValues,
+                                                          pInfo->waitSemaphoreValueCount);
+                pInfo->pSignalSemaphoreValues = CopyArray(&pMem,
+                                                          pInfo->pSignalSemaphoreValues,
+                                                          pInfo->signalSemaphoreValueCount);
+                pInfo->pNext = nullptr;
+
+                *ppNext = pInfo;
+                ppNext  = &pInfo->pNext;
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    return pCopies;
+}
+
+// =====================================================================================================================
+uint32_t QueueSubmitThread::GetWaitSemaphoreCount(
+    uint32_t            submitCount,
+    const VkSubmitInfo* pSubmits)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < submitCount; ++i)
+    {
+        count += pSubmits[i].waitSemaphoreCount;
+    }
+
+    return count;
+}
+
+// =====================================================================================================================
+uint32_t QueueSubmitThread::GetWaitSemaphoreCount(
+    uint32_t                submitCount,
+    const VkSubmitInfo2KHR* pSubmits)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < submitCount; ++i)
+    {
+        count += pSubmits[i].waitSemaphoreInfoCount;
+    }
+
+    return count;
+}
+
+// =====================================================================================================================
+uint32_t QueueSubmitThread::GetWaitSemaphoreCount(
+    uint32_t                bindInfoCount,
+    const VkBindSparseInfo* pBindInfos)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < bindInfoCount; ++i)
+    {
+        count += pBindInfos[i].waitSemaphoreCount;
+    }
+
+    return count;
+}
+
+// =====================================================================================================================
+// Collects the submissions of other queues the job's semaphore waits depend on and makes this job the pending signal
+// of the semaphores it signals.
+void QueueSubmitThread::TrackSemaphores(
+    Job*                pJob,
+    uint64_t            sequence,
+    uint32_t            submitCount,
+    const VkSubmitInfo* pSubmits)
+{
+    for (uint32_t i = 0; i < submitCount; ++i)
+    {
+        for (uint32_t j = 0; j < pSubmits[i].waitSemaphoreCount; ++j)
+        {
+            AddDependency(pJob, pSubmits[i].pWaitSemaphores[j]);
+        }
+
+        for (uint32_t j = 0; j < pSubmits[i].signalSemaphoreCount; ++j)
+        {
+            if (pSubmits[i].pSignalSemaphores[j] != VK_NULL_HANDLE)
+            {
+                Semaphore::ObjectFromHandle(pSubmits[i].pSignalSemaphores[j])->SetPendingSignal(this, sequence);
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+void QueueSubmitThread::TrackSemaphores(
+    Job*                    pJob,
+    uint64_t                sequence,
+    uint32_t                submitCount,
+    const VkSubmitInfo2KHR* pSubmits)
+{
+    for (uint32_t i = 0; i < submitCount; ++i)
+    {
+        for (uint32_t j = 0; j < pSubmits[i].waitSemaphoreInfoCount; ++j)
+        {
+            AddDependency(pJob, pSubmits[i].pWaitSemaphoreInfos[j].semaphore);
+        }
+
+        for (uint32_t j = 0; j < pSubmits[i].signalSemaphoreInfoCount; ++j)
+        {
+            if (pSubmits[i].pSignalSemaphoreInfos[j].semaphore != VK_NULL_HANDLE)
+            {
+                Semaphore::ObjectFromHandle(pSubmits[i].pSignalSemaphoreInfos[j].semaphore)->SetPendingSignal(
+                    this, sequence);
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+void QueueSubmitThread::TrackSemaphores(
+    Job*                    pJob,
+    uint64_t                sequence,
+    uint32_t                bindInfoCount,
+    const VkBindSparseInfo* pBindInfos)
+{
+    for (uint32_t i = 0; i < bindInfoCount; ++i)
+    {
+        for (uint32_t j = 0; j < pBindInfos[i].waitSemaphoreCount; ++j)
+        {
+            AddDependency(pJob, pBindInfos[i].pWaitSemaphores[j]);
+        }
+
+        for (uint32_t j = 0; j < pBindInfos[i].signalSemaphoreCount; ++j)
+        {
+            if (pBindInfos[i].pSignalSemaphores[j] != VK_NULL_HANDLE)
+            {
+                Semaphore::ObjectFromHandle(pBindInfos[i].pSignalSemaphores[j])->SetPendingSignal(this, sequence);
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Makes the job wait for the submission on another queue which signals the semaphore, if that one hasn't been handed
+// to PAL yet.  PAL then sees the signal before the wait, just like with synchronous submits.
+void QueueSubmitThread::AddDependency(
+    Job*        pJob,
+    VkSemaphore semaphore)
+{
+    QueueSubmitThread* pThread  = nullptr;
+    uint64_t           sequence = 0;
+
+    if (semaphore != VK_NULL_HANDLE)
+    {
+        Semaphore::ObjectFromHandle(semaphore)->GetPendingSignal(&pThread, &sequence);
+    }
+
+    if ((pThread != nullptr) && (pThread != this) && (pThread->IsSubmitted(sequence) == false))
+    {
+        uint32_t i = 0;
+
+        while ((i < pJob->dependencyCount) && (pJob->pDependencies[i].pThread != pThread))
+        {
+            ++i;
+        }
+
+        if (i == pJob->dependencyCount)
+        {
+            pJob->pDependencies[i].pThread  = pThread;
+            pJob->pDependencies[i].sequence = 0;
+            pJob->dependencyCount++;
+        }
+
+        pJob->pDependencies[i].sequence = Util::Max(pJob->pDependencies[i].sequence, sequence);
+    }
+}
+
+// =====================================================================================================================
+void QueueSubmitThread::ThreadFunc(
+    void* pParam)
+{
+    static_cast<QueueSubmitThread*>(pParam)->ThreadLoop();
+}
+
+// =====================================================================================================================
+void QueueSubmitThread::ThreadLoop()
+{
+    while (true)
+    {
+        if (m_completedCount < m_submittedCount)
+        {
+            const uint64_t sequence = m_completedCount + 1;
+            Job*           pJob     = m_ring[sequence % RingSize];
+
+            RunJob(pJob);
+
+            m_pInstance->FreeMem(pJob);
+
+            Util::MutexAuto lock(&m_doneLock);
+
+            m_completedCount = sequence;
+            m_submissionDone.WakeAll();
+        }
+        else if (m_stop)
+        {
+            break;
+        }
+        else
+        {
+            m_wakeEvent.Wait(IdleWaitSeconds);
+        }
+    }
+}
+
+// =====================================================================================================================
+// Hands a job to PAL once the submissions it depends on have been.  After an error no further jobs are submitted; the
+// error is what every later submit and wait reports.
+void QueueSubmitThread::RunJob(
+    const Job* pJob)
+{
+    for (uint32_t i = 0; i < pJob->dependencyCount; ++i)
+    {
+        pJob->pDependencies[i].pThread->WaitForSubmission(pJob->pDependencies[i].sequence);
+    }
+
+    if (m_result == VK_SUCCESS)
+    {
+        VkResult result = VK_SUCCESS;
+
+        switch (pJob->type)
+        {
+        case JobType::Submit:
+            result = m_pQueue->PalSubmit(pJob->submitCount,
+                                         static_cast<const VkSubmitInfo*>(pJob->pSubmits),
+                                         pJob->fence);
+            break;
+
+        case JobType::Submit2:
+            result = m_pQueue->PalSubmit(pJob->submitCount,
+                                         static_cast<const VkSubmitInfo2KHR*>(pJob->pSubmits),
+                                         pJob->fence);
+            break;
+
+        case JobType::BindSparse:
+            result = m_pQueue->PalBindSparse(pJob->submitCount,
+                                             static_cast<const VkBindSparseInfo*>(pJob->pSubmits),
+                                             pJob->fence);
+            break;
+
+        default:
+            VK_NEVER_CALLED();
+            break;
+        }
+
+        if (result != VK_SUCCESS)
+        {
+            m_result = result;
+        }
+    }
+}
+
+} // namespace vk
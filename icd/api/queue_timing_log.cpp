@@ -0,0 +1,390 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  queue_timing_log.cpp
+* @brief Implementation of the binary log of queue submissions, semaphore operations, presents and waits.
+***********************************************************************************************************************
+*/
+#include "include/queue_timing_log.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+#include "include/vk_physical_device.h"
+#include "include/vk_queue.h"
+
+#include "palCmdBuffer.h"
+#include "palFence.h"
+#include "palQueue.h"
+#include "palSysUtil.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+QueueTimingLog::QueueTimingLog(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_enabled(false)
+{
+}
+
+// =====================================================================================================================
+// Opens the log file and writes this device's header if the log is enabled.
+void QueueTimingLog::Init()
+{
+    const RuntimeSettings& settings = m_pDevice->GetRuntimeSettings();
+
+    if (settings.enableQueueTimingLog &&
+        (m_file.Open(settings.queueTimingLogFile, Util::FileAccessAppend | Util::FileAccessBinary) ==
+         Util::Result::Success))
+    {
+        QueueTimingLogHeader header = {};
+
+        header.magic        = QueueTimingLogMagic;
+        header.version      = QueueTimingLogVersion;
+        header.cpuFrequency = Util::GetPerfFrequency();
+        header.gpuFrequency = m_pDevice->TimestampFrequency();
+
+        Pal::CalibratedTimestamps calibration = {};
+
+        if (m_pDevice->PalDevice(DefaultDeviceIndex)->GetCalibratedTimestamps(&calibration) == Pal::Result::Success)
+        {
+            header.gpuCalibration = calibration.gpuTimestamp;
+            header.cpuCalibration = Util::GetPerfCpuTime();
+        }
+
+        m_file.Write(&header, sizeof(header));
+
+        m_enabled = true;
+    }
+}
+
+// =====================================================================================================================
+// Closes the file.  All queues must be destroyed by now.
+void QueueTimingLog::Destroy()
+{
+    if (m_enabled)
+    {
+        m_enabled = false;
+
+        m_file.Close();
+    }
+}
+
+// =====================================================================================================================
+void QueueTimingLog::Write(
+    const QueueTimingRecord* pRecords,
+    uint32_t                 recordCount)
+{
+    if (recordCount > 0)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        m_file.Write(pRecords, recordCount * sizeof(QueueTimingRecord));
+    }
+}
+
+// =====================================================================================================================
+QueueTimingState* QueueTimingState::Create(
+    Device* pDevice,
+    Queue*  pQueue)
+{
+    QueueTimingState* pState = nullptr;
+    void*             pMem   = pDevice->VkInstance()->AllocMem(sizeof(QueueTimingState),
+                                                               VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+    if (pMem != nullptr)
+    {
+        pState = VK_PLACEMENT_NEW(pMem) QueueTimingState(pDevice, pQueue);
+
+        // Without timestamp slots the queue still records the CPU side of every operation.
+        if (pState->Init() != VK_SUCCESS)
+        {
+            pState->m_gpuSlotsCreated = 0;
+        }
+    }
+
+    return pState;
+}
+
+// =====================================================================================================================
+QueueTimingState::QueueTimingState(
+    Device* pDevice,
+    Queue*  pQueue)
+    :
+    m_pDevice(pDevice),
+    m_pQueue(pQueue),
+    m_queueId((pQueue->GetFamilyIndex() << 16) | (pQueue->GetIndex() & 0xFFFF)),
+    m_pendingHead(0),
+    m_pendingCount(0),
+    m_gpuSlotHead(0),
+    m_gpuSlotCount(0),
+    m_gpuSlotsCreated(0)
+{
+    memset(m_pGpuSlots, 0, sizeof(m_pGpuSlots));
+}
+
+// =====================================================================================================================
+// Allocates the timestamp memory and the command buffers writing to it, if the queue's engine supports timestamps.
+VkResult QueueTimingState::Init()
+{
+    const Pal::DeviceProperties& props      = m_pDevice->VkPhysicalDevice(DefaultDeviceIndex)->PalProperties();
+    const Pal::EngineType        engineType = m_pDevice->GetQueueFamilyPalEngineType(m_pQueue->GetFamilyIndex());
+
+    VkResult result = VK_ERROR_FEATURE_NOT_PRESENT;
+
+    if ((props.engineProperties[engineType].flags.supportsTimestamps != 0) && (m_pDevice->TimestampFrequency() > 0))
+    {
+        InternalMemCreateInfo allocInfo = {};
+
+        allocInfo.pal.size      = MaxGpuSlots * sizeof(uint64_t);
+        allocInfo.pal.alignment = sizeof(uint64_t);
+        allocInfo.pal.priority  = Pal::GpuMemPriority::Normal;
+
+        m_pDevice->MemMgr()->GetCommonPool(InternalPoolCpuCacheableGpuUncached, &allocInfo);
+
+        result = m_pDevice->MemMgr()->AllocGpuMem(allocInfo, &m_timestampMem, 1 << DefaultDeviceIndex);
+    }
+
+    for (uint32_t i = 0; (result == VK_SUCCESS) && (i < MaxGpuSlots); ++i)
+    {
+        m_pGpuSlots[i] = m_pQueue->CreateCmdBufState(DefaultDeviceIndex);
+
+        if (m_pGpuSlots[i] != nullptr)
+        {
+            m_gpuSlotsCreated++;
+        }
+        else
+        {
+            result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Waits for the outstanding timestamps, hands the remaining records to the log and frees everything.
+void QueueTimingState::Destroy()
+{
+    Retire(true);
+
+    for (uint32_t i = 0; i < MaxGpuSlots; ++i)
+    {
+        if (m_pGpuSlots[i] != nullptr)
+        {
+            m_pQueue->DestroyCmdBufState(DefaultDeviceIndex, m_pGpuSlots[i]);
+        }
+    }
+
+    if (m_timestampMem.Size() > 0)
+    {
+        m_pDevice->MemMgr()->FreeGpuMem(&m_timestampMem);
+    }
+
+    Instance* pInstance = m_pDevice->VkInstance();
+
+    Util::Destructor(this);
+
+    pInstance->FreeMem(this);
+}
+
+// =====================================================================================================================
+// Records a PAL submission, followed by a bottom-of-pipe timestamp that lands once the submitted work is done.
+void QueueTimingState::RecordSubmit(
+    Pal::IQueue* pPalQueue,
+    int64_t      cpuBeginTicks,
+    uint32_t     cmdBufferCount)
+{
+    AddRecord(pPalQueue, QueueTimingEventType::Submit, cpuBeginTicks, cmdBufferCount, true);
+}
+
+// =====================================================================================================================
+// Records the semaphore waits of a batch, followed by a top-of-pipe timestamp that lands once the queue got past them.
+void QueueTimingState::RecordSemaphoreWait(
+    Pal::IQueue* pPalQueue,
+    int64_t      cpuBeginTicks,
+    uint32_t     semaphoreCount)
+{
+    AddRecord(pPalQueue, QueueTimingEventType::SemaphoreWait, cpuBeginTicks, semaphoreCount, true);
+}
+
+// =====================================================================================================================
+// Records an operation that only has a CPU side.
+void QueueTimingState::RecordCpuEvent(
+    QueueTimingEventType type,
+    int64_t              cpuBeginTicks,
+    uint32_t             count)
+{
+    AddRecord(nullptr, type, cpuBeginTicks, count, false);
+}
+
+// =====================================================================================================================
+void QueueTimingState::AddRecord(
+    Pal::IQueue*         pPalQueue,
+    QueueTimingEventType type,
+    int64_t              cpuBeginTicks,
+    uint32_t             count,
+    bool                 sampleGpu)
+{
+    const int64_t cpuEndTicks = Util::GetPerfCpuTime();
+
+    Util::MutexAuto lock(&m_lock);
+
+    Retire(false);
+
+    // A full ring means the GPU is hundreds of operations behind.  Rather than dropping records, wait for it.
+    if (m_pendingCount == MaxPending)
+    {
+        Retire(true);
+    }
+
+    PendingRecord* pPending = &m_pending[(m_pendingHead + m_pendingCount) % MaxPending];
+
+    pPending->record.cpuBeginTicks = static_cast<uint64_t>(cpuBeginTicks);
+    pPending->record.cpuEndTicks   = static_cast<uint64_t>(cpuEndTicks);
+    pPending->record.gpuTicks      = 0;
+    pPending->record.queueId       = m_queueId;
+    pPending->record.type          = static_cast<uint16_t>(type);
+    pPending->record.count         = static_cast<uint16_t>(Util::Min(count, static_cast<uint32_t>(UINT16_MAX)));
+    pPending->gpuSlot              = InvalidSlot;
+
+    m_pendingCount++;
+
+    if (sampleGpu && (m_gpuSlotCount < m_gpuSlotsCreated))
+    {
+        const uint32_t slot       = (m_gpuSlotHead + m_gpuSlotCount) % MaxGpuSlots;
+        const bool     topOfPipe  = (type == QueueTimingEventType::SemaphoreWait);
+        CmdBufState*   pCmdBuf    = m_pGpuSlots[slot];
+
+        Pal::CmdBufferBuildInfo buildInfo = {};
+
+        buildInfo.flags.optimizeOneTimeSubmit = 1;
+
+        Pal::Result result = pCmdBuf->pCmdBuf->Reset(m_pDevice->GetSharedCmdAllocator(DefaultDeviceIndex), true);
+
+        if (result == Pal::Result::Success)
+        {
+            result = pCmdBuf->pCmdBuf->Begin(buildInfo);
+        }
+
+        if (result == Pal::Result::Success)
+        {
+            pCmdBuf->pCmdBuf->CmdWriteTimestamp(topOfPipe ? Pal::HwPipeTop : Pal::HwPipeBottom,
+                                                *m_timestampMem.PalMemory(DefaultDeviceIndex),
+                                                m_timestampMem.Offset() + (slot * sizeof(uint64_t)));
+
+            result = pCmdBuf->pCmdBuf->End();
+        }
+
+        if (result == Pal::Result::Success)
+        {
+            result = m_pDevice->PalDevice(DefaultDeviceIndex)->ResetFences(1, &pCmdBuf->pFence);
+        }
+
+        if (result == Pal::Result::Success)
+        {
+            Pal::PerSubQueueSubmitInfo perSubQueueInfo = {};
+            Pal::SubmitInfo            submitInfo      = {};
+
+            perSubQueueInfo.cmdBufferCount = 1;
+            perSubQueueInfo.ppCmdBuffers   = &pCmdBuf->pCmdBuf;
+
+            submitInfo.pPerSubQueueInfo     = &perSubQueueInfo;
+            submitInfo.perSubQueueInfoCount = 1;
+            submitInfo.ppFences             = &pCmdBuf->pFence;
+            submitInfo.fenceCount           = 1;
+
+            result = pPalQueue->Submit(submitInfo);
+        }
+
+        if (result == Pal::Result::Success)
+        {
+            pPending->gpuSlot = slot;
+
+            m_gpuSlotCount++;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Hands the records at the front of the ring whose timestamps have landed to the log.  With force set, waits for the
+// outstanding timestamps first and empties the ring.  Must be called with m_lock held, except on destroy.
+void QueueTimingState::Retire(
+    bool force)
+{
+    QueueTimingRecord records[MaxPending];
+    uint32_t          recordCount = 0;
+
+    const uint64_t* pTimestamps = (m_gpuSlotsCreated > 0) ?
+        static_cast<const uint64_t*>(m_timestampMem.CpuAddr(DefaultDeviceIndex)) : nullptr;
+
+    bool blocked = false;
+
+    while ((m_pendingCount > 0) && (blocked == false))
+    {
+        PendingRecord* pPending = &m_pending[m_pendingHead];
+
+        if (pPending->gpuSlot != InvalidSlot)
+        {
+            Pal::IFence* pFence = m_pGpuSlots[pPending->gpuSlot]->pFence;
+
+            if (force)
+            {
+                m_pDevice->PalDevice(DefaultDeviceIndex)->WaitForFences(1, &pFence, true, UINT64_MAX);
+            }
+
+            if (pFence->GetStatus() == Pal::Result::Success)
+            {
+                pPending->record.gpuTicks = pTimestamps[pPending->gpuSlot];
+            }
+            else if (force == false)
+            {
+                blocked = true;
+            }
+
+            if (blocked == false)
+            {
+                VK_ASSERT(pPending->gpuSlot == m_gpuSlotHead);
+
+                m_gpuSlotHead = (m_gpuSlotHead + 1) % MaxGpuSlots;
+                m_gpuSlotCount--;
+            }
+        }
+
+        if (blocked == false)
+        {
+            records[recordCount++] = pPending->record;
+
+            m_pendingHead = (m_pendingHead + 1) % MaxPending;
+            m_pendingCount--;
+        }
+    }
+
+    m_pDevice->GetQueueTimingLog()->Write(records, recordCount);
+}
+
+} // namespace vk
@@ -46,34 +46,36 @@ RenderStateCache::RenderStateCache(
     Device* pDevice)
     :
     m_pDevice(pDevice),
-    m_inputAssemblyState(NumStateBuckets, pDevice->VkInstance()->Allocator()),
+    m_inputAssemblyState(pDevice->VkInstance()),
     m_inputAssemblyStateNextId(FirstStaticRenderStateToken),
-    m_triangleRasterState(NumStateBuckets, pDevice->VkInstance()->Allocator()),
+    m_triangleRasterState(pDevice->VkInstance()),
     m_triangleRasterStateNextId(FirstStaticRenderStateToken),
-    m_pointLineRasterState(NumStateBuckets, pDevice->VkInstance()->Allocator()),
+    m_pointLineRasterState(pDevice->VkInstance()),
     m_pointLineRasterStateNextId(FirstStaticRenderStateToken),
-    m_lineStippleState(NumStateBuckets, pDevice->VkInstance()->Allocator()),
+    m_lineStippleState(pDevice->VkInstance()),
     m_lineStippleStateNextId(FirstStaticRenderStateToken),
-    m_depthBias(NumStateBuckets, pDevice->VkInstance()->Allocator()),
+    m_depthBias(pDevice->VkInstance()),
     m_depthBiasNextId(FirstStaticRenderStateToken),
-    m_blendConst(NumStateBuckets, pDevice->VkInstance()->Allocator()),
+    m_blendConst(pDevice->VkInstance()),
     m_blendConstNextId(FirstStaticRenderStateToken),
-    m_depthBounds(NumStateBuckets, pDevice->VkInstance()->Allocator()),
+    m_depthBounds(pDevice->VkInstance()),
     m_depthBoundsNextId(FirstStaticRenderStateToken),
-    m_viewport(NumStateBuckets, pDevice->VkInstance()->Allocator()),
+    m_viewport(pDevice->VkInstance()),
     m_viewportNextId(FirstStaticRenderStateToken),
-    m_scissorRect(NumStateBuckets, pDevice->VkInstance()->Allocator()),
+    m_scissorRect(pDevice->VkInstance()),
     m_scissorRectNextId(FirstStaticRenderStateToken),
     m_msaaStates(NumStateBuckets, pDevice->VkInstance()->Allocator()),
     m_msaaRefs(NumStateBuckets, pDevice->VkInstance()->Allocator()),
-    m_samplePattern(NumStateBuckets, pDevice->VkInstance()->Allocator()),
+    m_samplePattern(pDevice->VkInstance()),
     m_samplePatternNextId(FirstStaticRenderStateToken),
     m_colorBlendStates(NumStateBuckets, pDevice->VkInstance()->Allocator()),
     m_colorBlendRefs(NumStateBuckets, pDevice->VkInstance()->Allocator()),
     m_depthStencilStates(NumStateBuckets, pDevice->VkInstance()->Allocator()),
     m_depthStencilRefs(NumStateBuckets, pDevice->VkInstance()->Allocator()),
-    m_fragmentShadingRate(NumStateBuckets, pDevice->VkInstance()->Allocator()),
-    m_fragmentShadingRateNextId(FirstStaticRenderStateToken)
+    m_fragmentShadingRate(pDevice->VkInstance()),
+    m_fragmentShadingRateNextId(FirstStaticRenderStateToken),
+    m_staticStateBundle(pDevice->VkInstance()),
+    m_staticStateBundleNextId(FirstStaticRenderStateToken)
 {
 
 }
@@ -164,6 +166,11 @@ VkResult RenderStateCache::Init()
         result = m_fragmentShadingRate.Init();
     }
 
+    if (result == Pal::Result::Success)
+    {
+        result = m_staticStateBundle.Init();
+    }
+
     return PalToVkResult(result);
 }
 
@@ -530,14 +537,45 @@ Pal::Result RenderStateCache::CreateStaticPalObjectState(
         return CreatePalObjects(createInfo, pAllocator, parentScope, pStates);
     }
 
-    // Try to find an existing static state object
+    // Try to find an existing static state object.  This is the common case, so only take the lock for reading.
     Pal::Result result = Pal::Result::Success;
+    StateObject* pCachedState = nullptr;
+
+    {
+        Util::RWLockAuto<Util::RWLock::LockType::ReadOnly> readLock(&m_lock);
+
+        StateObject** ppCachedState = pStateMap->FindKey(createInfo);
+
+        if (ppCachedState != nullptr)
+        {
+            pCachedState = *ppCachedState;
+
+            VK_ASSERT(pCachedState->refCount > 0);
+
+            // Entries can only be erased under the write lock, so it is safe to take the reference here.
+            Util::AtomicIncrement(&pCachedState->refCount);
+        }
+    }
+
+    if (pCachedState != nullptr)
+    {
+        for (uint32_t deviceIdx = 0; deviceIdx < m_pDevice->NumPalDevices(); ++deviceIdx)
+        {
+            VK_ASSERT(pCachedState->pObjects[deviceIdx] != nullptr);
+
+            pStates[deviceIdx] = pCachedState->pObjects[deviceIdx];
+        }
+
+        return result;
+    }
+
     bool existed = false;
     StateObject** ppState = nullptr;
 
-    Util::MutexAuto lock(&m_mutex);
+    Util::RWLockAuto<Util::RWLock::LockType::ReadWrite> lock(&m_lock);
 
-    // Map the createinfo to a pre-existing state object.  Allocate a new (empty) entry if one does not exist.
+    // Map the createinfo to a pre-existing state object (another thread may have inserted it since the lookup above).
+    // Allocate a new (empty) entry if one does not exist.
     result = pStateMap->FindAllocate(createInfo, &existed, &ppState);
 
     if (result == Pal::Result::Success)
@@ -629,7 +667,7 @@ void RenderStateCache::DestroyStaticPalObjectState(
     }
     else
     {
-        Util::MutexAuto lock(&m_mutex);
+        Util::RWLockAuto<Util::RWLock::LockType::ReadWrite> lock(&m_lock);
 
         // Find the state object containing the given PAL object.  This should always exist.
         auto** pValue = pRefMap->FindKey(ppStates[0]);
@@ -781,7 +819,24 @@ uint32_t RenderStateCache::CreateStaticParamsState(
 
     if (IsEnabled(enabledType))
     {
-        Util::MutexAuto lock(&m_mutex);
+        {
+            Util::RWLockAuto<Util::RWLock::LockType::ReadOnly> readLock(&m_lock);
+
+            StaticParamState* pCachedState = pMap->FindKey(params);
+
+            // Leave the (practically unreachable) reference count overflow handling to the locked path below.
+            if ((pCachedState != nullptr) && (pCachedState->refCount < (UINT_MAX - 1)))
+            {
+                Util::AtomicIncrement(&pCachedState->refCount);
+
+                token = pCachedState->paramToken;
+            }
+        }
+    }
+
+    if (IsEnabled(enabledType) && (token == DynamicRenderStateToken))
+    {
+        Util::RWLockAuto<Util::RWLock::LockType::ReadWrite> lock(&m_lock);
 
         bool existed = false;
         StaticParamState* pState = nullptr;
@@ -832,7 +887,7 @@ void RenderStateCache::DestroyStaticParamsState(
 {
     if (IsEnabled(enabledType) && (token != DynamicRenderStateToken))
     {
-        Util::MutexAuto lock(&m_mutex);
+        Util::RWLockAuto<Util::RWLock::LockType::ReadWrite> lock(&m_lock);
 
         StaticParamState* pValue = pMap->FindKey(params);
 
@@ -1103,4 +1158,29 @@ void RenderStateCache::DestroyFragmentShadingRate(
         &m_fragmentShadingRate);
 }
 
+// =====================================================================================================================
+// Maps a graphics pipeline's complete static state to a single token.  Pipelines sharing a token can skip re-binding
+// the covered state objects and parameters entirely when bound after one another.
+uint32_t RenderStateCache::CreateStaticStateBundle(
+    const StaticStateBundleKey& key)
+{
+    return CreateStaticParamsState(
+        OptRenderStateCacheStaticStateBundle,
+        key,
+        &m_staticStateBundle,
+        &m_staticStateBundleNextId);
+}
+
+// =====================================================================================================================
+void RenderStateCache::DestroyStaticStateBundle(
+    const StaticStateBundleKey& key,
+    uint32_t                    token)
+{
+    return DestroyStaticParamsState(
+        OptRenderStateCacheStaticStateBundle,
+        key,
+        token,
+        &m_staticStateBundle);
+}
+
 };
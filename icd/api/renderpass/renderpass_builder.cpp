@@ -86,6 +86,27 @@ RenderPassBuilder::~RenderPassBuilder()
     }
 }
 
+// =====================================================================================================================
+// Returns true if the render pass neither loads nor stores the contents of an attachment, so nothing outside of the
+// subpasses using it can observe its memory.
+static bool HasTransientContents(
+    const AttachmentDescription& desc)
+{
+    bool transient = (desc.initialLayout == VK_IMAGE_LAYOUT_UNDEFINED)    &&
+                     (desc.loadOp != VK_ATTACHMENT_LOAD_OP_LOAD)          &&
+                     (desc.storeOp == VK_ATTACHMENT_STORE_OP_DONT_CARE);
+
+    if (Formats::HasStencil(desc.format))
+    {
+        transient = transient                                                &&
+                    (desc.stencilInitialLayout == VK_IMAGE_LAYOUT_UNDEFINED) &&
+                    (desc.stencilLoadOp != VK_ATTACHMENT_LOAD_OP_LOAD)       &&
+                    (desc.stencilStoreOp == VK_ATTACHMENT_STORE_OP_DONT_CARE);
+    }
+
+    return transient;
+}
+
 // =====================================================================================================================
 // Initializes state arrays for building a render pass and precomputes some initial derived information.
 Pal::Result RenderPassBuilder::BuildInitialState()
@@ -164,6 +185,20 @@ Pal::Result RenderPassBuilder::BuildInitialState()
             if (m_pAttachments[attachment].finalUseSubpass != VK_SUBPASS_EXTERNAL)
             {
                 m_pSubpasses[m_pAttachments[attachment].finalUseSubpass].flags.hasFinalUseAttachments = true;
+
+                m_pAttachments[attachment].aliasable = HasTransientContents(*m_pAttachments[attachment].pDesc);
+            }
+        }
+
+        // Shading rate images are written by the application, not by the render pass.
+        for (uint32_t subpass = 0; subpass < m_subpassCount; ++subpass)
+        {
+            for (uint32_t attachment = 0; attachment < m_attachmentCount; ++attachment)
+            {
+                if ((GetSubpassReferenceMask(subpass, attachment) & AttachRefFragShading) != 0)
+                {
+                    m_pAttachments[attachment].aliasable = false;
+                }
             }
         }
 
@@ -292,7 +327,8 @@ RenderPassBuilder::AttachmentState::AttachmentState(
     prevReferenceSubpass(VK_SUBPASS_EXTERNAL),
     accumulatedRefMask(0),
     loaded(false),
-    resolvesInFlight(false)
+    resolvesInFlight(false),
+    aliasable(false)
 {
     prevReferenceLayout.layout            = pDesc->initialLayout;
     prevReferenceLayout.extraUsage        = 0;
@@ -321,6 +357,12 @@ VkResult RenderPassBuilder::Build(
         result = BuildEndState();
     }
 
+    if ((result == Pal::Result::Success) &&
+        m_pDevice->VkPhysicalDevice(DefaultDeviceIndex)->GetRuntimeSettings().renderPassMergeSyncPoints)
+    {
+        result = MergeSyncPoints();
+    }
+
     if (result == Pal::Result::Success)
     {
         result = Finalize(pAllocator, ppResult);
@@ -963,8 +1005,6 @@ Pal::Result RenderPassBuilder::BuildImplicitDependencies(
 {
     Pal::Result result = Pal::Result::Success;
 
-    // We don't actually have any real implicit dependencies at the moment, and don't do much in this function.
-
     if (dstSubpass != VK_SUBPASS_EXTERNAL)
     {
         // Set the flag that this syncpoint needs to handle an implicit external incoming dependency as per spec.
@@ -975,6 +1015,35 @@ Pal::Result RenderPassBuilder::BuildImplicitDependencies(
         {
             pSync->barrier.flags.implicitExternalIncoming = 1;
         }
+
+        // The memory of an aliasable attachment may have been used by another attachment until now, either in an
+        // earlier subpass or in an earlier render pass instance.
+        if (m_pSubpasses[dstSubpass].flags.hasFirstUseAttachments &&
+            m_pDevice->GetTransientAliasPlanner()->IsEnabled())
+        {
+            bool firstUseAliasable = false;
+
+            for (uint32_t a = 0; a < m_attachmentCount; ++a)
+            {
+                firstUseAliasable |= (m_pAttachments[a].aliasable && (m_pAttachments[a].firstUseSubpass == dstSubpass));
+            }
+
+            if (firstUseAliasable)
+            {
+                pSync->barrier.srcStageMask  |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                pSync->barrier.dstStageMask  |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                                VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                                                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+                pSync->barrier.srcAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                                VK_ACCESS_TRANSFER_WRITE_BIT |
+                                                VK_ACCESS_SHADER_WRITE_BIT;
+                pSync->barrier.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                                                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            }
+        }
     }
     else
     {
@@ -1027,8 +1096,9 @@ Pal::Result RenderPassBuilder::BuildSubpassDependencies(
             continue;
         }
 
-        // Does this dependency terminate at the current subpass?  If so, we need to handle it
-        if (dep.dstSubpass == subpass)
+        // Does this dependency terminate at the current subpass?  If so, we need to handle it unless it has been
+        // proven to not guard any attachment hazard.
+        if ((dep.dstSubpass == subpass) && (IsDependencyHazardFree(dep) == false))
         {
             pSync->barrier.srcStageMask |= dep.srcStageMask;
             pSync->barrier.dstStageMask |= dep.dstStageMask;
@@ -1047,6 +1117,55 @@ Pal::Result RenderPassBuilder::BuildSubpassDependencies(
     return result;
 }
 
+// =====================================================================================================================
+// Returns true if the given subpass dependency only orders attachment accesses of two subpasses that do not share any
+// attachment which either of them writes.  Such a dependency has nothing to synchronize and may be skipped.
+bool RenderPassBuilder::IsDependencyHazardFree(
+    const SubpassDependency& dep
+    ) const
+{
+    constexpr PipelineStageFlags AttachmentStages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR |
+                                                    VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR  |
+                                                    VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR;
+
+    constexpr AccessFlags AttachmentAccess = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR          |
+                                             VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR         |
+                                             VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR  |
+                                             VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR;
+
+    bool hazardFree = false;
+
+    // Only consider internal dependencies whose whole execution and memory scope is attachment access.  Anything
+    // touching shader stages may be guarding non-attachment memory we cannot see here.  Subpasses with resolves are
+    // left alone because their dependencies are also what waits for the resolve blts.
+    if (m_pDevice->VkPhysicalDevice(DefaultDeviceIndex)->GetRuntimeSettings().renderPassElideHazardFreeDependencies &&
+        (dep.srcSubpass != VK_SUBPASS_EXTERNAL)                          &&
+        (dep.dstSubpass != VK_SUBPASS_EXTERNAL)                          &&
+        ((dep.srcStageMask & ~AttachmentStages) == 0)                    &&
+        ((dep.dstStageMask & ~AttachmentStages) == 0)                    &&
+        ((dep.srcAccessMask & ~AttachmentAccess) == 0)                   &&
+        ((dep.dstAccessMask & ~AttachmentAccess) == 0)                   &&
+        (m_pSubpasses[dep.srcSubpass].resolves.NumElements() == 0))
+    {
+        hazardFree = true;
+
+        for (uint32_t attachment = 0; (attachment < m_attachmentCount) && hazardFree; ++attachment)
+        {
+            const uint32_t srcRefMask = GetSubpassReferenceMask(dep.srcSubpass, attachment);
+            const uint32_t dstRefMask = GetSubpassReferenceMask(dep.dstSubpass, attachment);
+
+            if ((srcRefMask != 0) &&
+                (dstRefMask != 0) &&
+                (WritesToAttachment(srcRefMask) || WritesToAttachment(dstRefMask)))
+            {
+                hazardFree = false;
+            }
+        }
+    }
+
+    return hazardFree;
+}
+
 // =====================================================================================================================
 // If the given subpass has resolves in flight for any attachment, this function will insert a barrier to wait for
 // resolves to complete in the given sync point.
@@ -1178,6 +1297,105 @@ void RenderPassBuilder::WaitForResolves(SyncPointState* pSync)
     }
 }
 
+// =====================================================================================================================
+// Folds the contents of one sync point into another sync point that executes later with no intervening commands.
+// Layout transitions of the same attachment are chained into a single transition (or dropped if they cancel out).
+Pal::Result RenderPassBuilder::MergeSyncPoint(
+    SyncPointState* pSrc,
+    SyncPointState* pDst)
+{
+    Pal::Result result = Pal::Result::Success;
+
+    pDst->barrier.srcStageMask  |= pSrc->barrier.srcStageMask;
+    pDst->barrier.dstStageMask  |= pSrc->barrier.dstStageMask;
+    pDst->barrier.srcAccessMask |= pSrc->barrier.srcAccessMask;
+    pDst->barrier.dstAccessMask |= pSrc->barrier.dstAccessMask;
+    pDst->barrier.flags.u32All  |= pSrc->barrier.flags.u32All;
+
+    while ((pSrc->transitions.NumElements() > 0) && (result == Pal::Result::Success))
+    {
+        auto srcIt = pSrc->transitions.Begin();
+
+        const RPTransitionInfo& srcTransition = *srcIt.Get();
+
+        bool chained = false;
+
+        auto dstIt = pDst->transitions.Begin();
+
+        while ((dstIt.Get() != nullptr) && (chained == false))
+        {
+            RPTransitionInfo* pDstTransition = dstIt.Get();
+
+            if (pDstTransition->attachment == srcTransition.attachment)
+            {
+                pDstTransition->prevLayout        = srcTransition.prevLayout;
+                pDstTransition->prevStencilLayout = srcTransition.prevStencilLayout;
+                pDstTransition->flags.isInitialLayoutTransition |= srcTransition.flags.isInitialLayoutTransition;
+
+                if ((pDstTransition->prevLayout == pDstTransition->nextLayout) &&
+                    (pDstTransition->prevStencilLayout == pDstTransition->nextStencilLayout) &&
+                    (pDstTransition->flags.isInitialLayoutTransition == 0))
+                {
+                    pDst->transitions.Erase(&dstIt);
+                }
+
+                chained = true;
+            }
+            else
+            {
+                dstIt.Next();
+            }
+        }
+
+        if (chained == false)
+        {
+            result = pDst->transitions.PushBack(srcTransition);
+        }
+
+        pSrc->transitions.Erase(&srcIt);
+    }
+
+    memset(&pSrc->barrier, 0, sizeof(pSrc->barrier));
+    pSrc->flags.u32All = 0;
+
+    // Recompute the derived pipe points, cache masks and active state of the combined sync point.
+    PostProcessSyncPoint(pDst);
+
+    return result;
+}
+
+// =====================================================================================================================
+// Subpasses without resolves execute their end-of-subpass sync points back-to-back with the top sync point of the next
+// subpass (or the end-instance sync point).  Fold those into the following sync point so that a single barrier is
+// issued per subpass boundary.
+Pal::Result RenderPassBuilder::MergeSyncPoints()
+{
+    Pal::Result result = Pal::Result::Success;
+
+    for (uint32_t subpass = 0; (subpass < m_subpassCount) && (result == Pal::Result::Success); ++subpass)
+    {
+        SubpassState* pSubpass = &m_pSubpasses[subpass];
+
+        if (pSubpass->resolves.NumElements() == 0)
+        {
+            SyncPointState* pNext = ((subpass + 1) < m_subpassCount) ? &m_pSubpasses[subpass + 1].syncTop :
+                                                                         &m_endState.syncEnd;
+
+            if (pSubpass->syncBottom.flags.active)
+            {
+                result = MergeSyncPoint(&pSubpass->syncBottom, pNext);
+            }
+
+            if ((result == Pal::Result::Success) && pSubpass->syncPreResolve.flags.active)
+            {
+                result = MergeSyncPoint(&pSubpass->syncPreResolve, pNext);
+            }
+        }
+    }
+
+    return result;
+}
+
 // =====================================================================================================================
 // Finalizes the building of a render pass by compressing all of the temporary build-time memory into permanent
 // structures that are retained by RenderPass objects.
@@ -1232,6 +1450,17 @@ Pal::Result RenderPassBuilder::Finalize(
 
         pStorage = m_endState.Finalize(pStorage, &pDst->end);
 
+        pDst->pAttachmentLifetimes = static_cast<RPAttachmentLifetime*>(pStorage);
+
+        for (uint32_t a = 0; a < m_attachmentCount; ++a)
+        {
+            pDst->pAttachmentLifetimes[a].firstUseSubpass = m_pAttachments[a].firstUseSubpass;
+            pDst->pAttachmentLifetimes[a].finalUseSubpass = m_pAttachments[a].finalUseSubpass;
+            pDst->pAttachmentLifetimes[a].aliasable       = m_pAttachments[a].aliasable;
+        }
+
+        pStorage = Util::VoidPtrInc(pStorage, m_attachmentCount * sizeof(RPAttachmentLifetime));
+
         VK_ASSERT(Util::VoidPtrDiff(pStorage, pStorageStart) == finalSize);
     }
 
@@ -1259,6 +1488,8 @@ size_t RenderPassBuilder::GetTotalExtraSize() const
 
     finalSize += m_endState.GetExtraSize();
 
+    finalSize += m_attachmentCount * sizeof(RPAttachmentLifetime);
+
     return finalSize;
 }
 
@@ -54,6 +54,7 @@ class RenderPassLogger;
 struct RenderPassCreateInfo;
 struct AttachmentDescription;
 struct SubpassDescription;
+struct SubpassDependency;
 
 // =====================================================================================================================
 // This class is a temporarily instantiated class that builds a RenderPassExecuteInfo during vkCreateRenderPass().
@@ -92,6 +93,8 @@ public:
         bool                           loaded;                      // True if attachment has been loaded.
         bool                           resolvesInFlight;            // True if a resolve blt is in flight either
                                                                     // from or to this attachment.
+        bool                           aliasable;                   // True if the contents only live during the
+                                                                    // subpasses referencing this attachment.
     };
 
     // State tracked per subpass sync point (build-time version of RPSyncPoint).
@@ -188,6 +191,9 @@ private:
         SyncPointState*      pSync);
     void WaitForResolves(SyncPointState* pSync);
     void WaitForResolvesFromSubpass(uint32_t subpass, SyncPointState* pSync);
+    bool IsDependencyHazardFree(const SubpassDependency& dep) const;
+    Pal::Result MergeSyncPoints();
+    Pal::Result MergeSyncPoint(SyncPointState* pSrc, SyncPointState* pDst);
 
     Pal::Result Finalize(
         const VkAllocationCallbacks* pAllocator,
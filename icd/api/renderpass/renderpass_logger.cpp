@@ -107,9 +107,11 @@ RenderPassLogger::RenderPassLogger(
     const Device*        pDevice)
     :
     m_pArena(pArena),
-    m_settings(pDevice->GetRuntimeSettings())
+    m_settings(pDevice->GetRuntimeSettings()),
+    m_pInfo(nullptr),
+    m_pExecute(nullptr)
 {
-    m_logging = true;
+    m_logging = m_settings.renderPassLogEnable;
 }
 
 // =====================================================================================================================
@@ -782,6 +784,11 @@ void RenderPassLogger::End()
     Log("// end\n");
 
     m_file.Close();
+
+    if ((m_pExecute != nullptr) && ((m_settings.renderPassLogFlags & RenderPassLogFlagCostStatistics) != 0))
+    {
+        LogCostStatistics();
+    }
 }
 
 // =====================================================================================================================
@@ -1065,6 +1072,149 @@ void RenderPassLogger::LogStatistics()
     Log("Temporary memory allocated during building: %llu bytes\n", (uint64_t)m_pArena->GetTotalAllocated());
 }
 
+// =====================================================================================================================
+// Accumulates the estimated cost of one render pass sync point.  These mirror what CmdBuffer::RPSyncPoint() emits.
+static void AccumulateSyncPointCost(
+    const RPSyncPointInfo& syncPoint,
+    RenderPassCostStatistics* pStats)
+{
+    if (syncPoint.flags.active)
+    {
+        pStats->syncPoints++;
+        pStats->transitions += syncPoint.transitionCount;
+
+        if (syncPoint.barrier.flags.needsGlobalTransition || (syncPoint.transitionCount > 0))
+        {
+            pStats->barriers++;
+        }
+
+        if ((syncPoint.barrier.srcAccessMask != 0) || (syncPoint.barrier.implicitSrcCacheMask != 0))
+        {
+            pStats->estimatedFlushes++;
+        }
+
+        if ((syncPoint.barrier.dstAccessMask != 0) || (syncPoint.barrier.implicitDstCacheMask != 0))
+        {
+            pStats->estimatedInvalidates++;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Computes the estimated cost of a single subpass's begin and end operations.
+static void AccumulateSubpassCost(
+    const RPExecuteSubpassInfo& subpass,
+    RenderPassCostStatistics*   pStats)
+{
+    AccumulateSyncPointCost(subpass.begin.syncTop, pStats);
+
+    pStats->colorClears += subpass.begin.loadOps.colorClearCount;
+    pStats->dsClears    += subpass.begin.loadOps.dsClearCount;
+
+    // Multi-target color clears are not auto-synced and get an extra post-clear barrier in RPBeginSubpass().
+    if (subpass.begin.syncTop.barrier.flags.preColorClearSync)
+    {
+        pStats->barriers++;
+        pStats->estimatedFlushes++;
+        pStats->estimatedInvalidates++;
+    }
+
+    AccumulateSyncPointCost(subpass.end.syncPreResolve, pStats);
+
+    pStats->resolves += subpass.end.resolveCount;
+
+    AccumulateSyncPointCost(subpass.end.syncBottom, pStats);
+}
+
+// =====================================================================================================================
+// Adds the statistics of one part of a render pass to a running total.
+static void AddCostStatistics(
+    const RenderPassCostStatistics& stats,
+    RenderPassCostStatistics*       pTotal)
+{
+    pTotal->syncPoints           += stats.syncPoints;
+    pTotal->barriers             += stats.barriers;
+    pTotal->transitions          += stats.transitions;
+    pTotal->colorClears          += stats.colorClears;
+    pTotal->dsClears             += stats.dsClears;
+    pTotal->resolves             += stats.resolves;
+    pTotal->estimatedFlushes     += stats.estimatedFlushes;
+    pTotal->estimatedInvalidates += stats.estimatedInvalidates;
+}
+
+// =====================================================================================================================
+// Writes one set of cost statistics as a JSON object.
+static void PrintCostStatistics(
+    Util::File*                     pFile,
+    const RenderPassCostStatistics& stats)
+{
+    pFile->Printf("{ \"syncPoints\": %u, \"barriers\": %u, \"transitions\": %u, \"colorClears\": %u, "
+                  "\"dsClears\": %u, \"resolves\": %u, \"estimatedFlushes\": %u, \"estimatedInvalidates\": %u }",
+                  stats.syncPoints,
+                  stats.barriers,
+                  stats.transitions,
+                  stats.colorClears,
+                  stats.dsClears,
+                  stats.resolves,
+                  stats.estimatedFlushes,
+                  stats.estimatedInvalidates);
+}
+
+// =====================================================================================================================
+// Writes the estimated driver-generated cost of executing this render pass to a machine-readable JSON file next to
+// the text log, so that render passes can be ranked by the overhead the builder produced for them.
+void RenderPassLogger::LogCostStatistics()
+{
+    char fileName[512];
+
+    Util::Snprintf(fileName, sizeof(fileName), "%s/RenderPass_0x%016llX.json",
+        m_settings.renderPassLogDirectory, m_pInfo->hash);
+
+    Util::File file;
+
+    if (file.Open(fileName, Util::FileAccessWrite) == Pal::Result::Success)
+    {
+        RenderPassCostStatistics total = {};
+
+        file.Printf("{\n");
+        file.Printf("  \"hash\": \"0x%016llX\",\n", m_pInfo->hash);
+        file.Printf("  \"attachmentCount\": %u,\n", m_pInfo->attachmentCount);
+        file.Printf("  \"subpassCount\": %u,\n", m_pInfo->subpassCount);
+        file.Printf("  \"dependencyCount\": %u,\n", m_pInfo->dependencyCount);
+        file.Printf("  \"buildMemoryBytes\": %llu,\n", static_cast<uint64_t>(m_pArena->GetTotalAllocated()));
+        file.Printf("  \"subpasses\": [\n");
+
+        for (uint32_t subpass = 0; subpass < m_pInfo->subpassCount; ++subpass)
+        {
+            RenderPassCostStatistics stats = {};
+
+            AccumulateSubpassCost(m_pExecute->pSubpasses[subpass], &stats);
+            AddCostStatistics(stats, &total);
+
+            file.Printf("    ");
+            PrintCostStatistics(&file, stats);
+            file.Printf("%s\n", ((subpass + 1) < m_pInfo->subpassCount) ? "," : "");
+        }
+
+        file.Printf("  ],\n");
+
+        RenderPassCostStatistics endStats = {};
+
+        AccumulateSyncPointCost(m_pExecute->end.syncEnd, &endStats);
+        AddCostStatistics(endStats, &total);
+
+        file.Printf("  \"end\": ");
+        PrintCostStatistics(&file, endStats);
+        file.Printf(",\n");
+
+        file.Printf("  \"total\": ");
+        PrintCostStatistics(&file, total);
+        file.Printf("\n}\n");
+
+        file.Close();
+    }
+}
+
 // =====================================================================================================================
 void RenderPassLogger::LogBeginSource()
 {
@@ -52,6 +52,22 @@ struct RenderPassExecuteInfo;
 struct AttachmentReference;
 struct SubpassDependency;
 
+// Bit in RenderPassLogFlags that requests a JSON file of estimated execution cost statistics per render pass.
+constexpr uint32_t RenderPassLogFlagCostStatistics = 0x20;
+
+// Estimated driver-generated work for (part of) a render pass instance.
+struct RenderPassCostStatistics
+{
+    uint32_t syncPoints;           // Active sync points
+    uint32_t barriers;             // Sync points and post-clear syncs that issue cache operations or transitions
+    uint32_t transitions;          // Automatic layout transitions
+    uint32_t colorClears;          // Load-op color clears
+    uint32_t dsClears;             // Load-op depth/stencil clears
+    uint32_t resolves;             // Resolve blts
+    uint32_t estimatedFlushes;     // Barriers that write back source caches
+    uint32_t estimatedInvalidates; // Barriers that invalidate destination caches
+};
+
 // =====================================================================================================================
 // This class dumps render passes in .asciidoc format as they are created.
 class RenderPassLogger
@@ -88,6 +104,7 @@ private:
     void LogAccessMask(AccessFlags flags, bool compact);
     void LogSubpassDependency(const SubpassDependency& dep, bool printSubpasses, bool label);
     void LogStatistics();
+    void LogCostStatistics();
     void LogBeginSource();
     void LogEndSource();
     void LogIntermSubpass(uint32_t subpass);
@@ -241,12 +241,23 @@ struct RPExecuteEndRenderPassInfo
     RPSyncPointInfo      syncEnd; // Synchronization that needs to be done during the end of a render pass instance.
 };
 
+// Describes the subpasses an attachment is used in, for planning which attachments may share memory.
+struct RPAttachmentLifetime
+{
+    uint32_t firstUseSubpass; // First subpass referencing the attachment, or VK_SUBPASS_EXTERNAL if it is unused
+    uint32_t finalUseSubpass; // Last subpass referencing the attachment, or VK_SUBPASS_EXTERNAL if it is unused
+    bool     aliasable;       // Contents are neither loaded nor stored, so other attachments may use its memory
+                              // outside of [firstUseSubpass, finalUseSubpass].  The render pass waits for earlier
+                              // attachment writes before the first use.
+};
+
 // The main structure that describes all information necessary to execute an instance of some render pass (except
 // for the subpass contents).
 struct RenderPassExecuteInfo
 {
     RPExecuteSubpassInfo*      pSubpasses;
     RPExecuteEndRenderPassInfo end;
+    RPAttachmentLifetime*      pAttachmentLifetimes; // One per attachment
 };
 
 } // namespace vk
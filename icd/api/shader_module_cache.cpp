@@ -0,0 +1,247 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  shader_module_cache.cpp
+* @brief Implementation of the cache of live shader modules.
+***********************************************************************************************************************
+*/
+
+#include "include/shader_module_cache.h"
+#include "include/pipeline_compiler.h"
+#include "include/vk_device.h"
+#include "include/vk_instance.h"
+
+namespace vk
+{
+
+// =====================================================================================================================
+ShaderModuleCache::ShaderModuleCache(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_enabled(false),
+    m_entries(pDevice->VkInstance())
+{
+}
+
+// =====================================================================================================================
+void ShaderModuleCache::Init()
+{
+    m_enabled = m_pDevice->GetRuntimeSettings().enableShaderModuleCache &&
+                (m_entries.Init() == Pal::Result::Success);
+}
+
+// =====================================================================================================================
+// Returns true if the entry retains exactly the given code.  The hash only selects the candidate; the code itself
+// decides whether the module can be shared.  Compression is deterministic, so compressed code can be compared as is.
+bool ShaderModuleCache::HoldsCode(
+    const ShaderModuleCacheEntry* pEntry,
+    size_t                        storedCodeSize,
+    const void*                   pStoredCode)
+{
+    return (pEntry->storedCodeSize == storedCodeSize) && (memcmp(pEntry->pCode, pStoredCode, storedCodeSize) == 0);
+}
+
+// =====================================================================================================================
+// Allocates an entry retaining a copy of the stored form of the given code and builds its shader module.
+VkResult ShaderModuleCache::CreateEntry(
+    const ShaderModuleKey&   key,
+    size_t                   codeSize,
+    const void*              pCode,
+    size_t                   storedCodeSize,
+    const void*              pStoredCode,
+    ShaderModuleCacheEntry** ppEntry)
+{
+    VkResult result = VK_SUCCESS;
+
+    void* pMemory = m_pDevice->VkInstance()->AllocMem(
+        sizeof(ShaderModuleCacheEntry) + storedCodeSize,
+        VK_DEFAULT_MEM_ALIGN,
+        VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+    if (pMemory != nullptr)
+    {
+        ShaderModuleCacheEntry* pEntry = static_cast<ShaderModuleCacheEntry*>(pMemory);
+        void*                   pCopy  = Util::VoidPtrInc(pMemory, sizeof(ShaderModuleCacheEntry));
+
+        memcpy(pCopy, pStoredCode, storedCodeSize);
+        memset(pEntry, 0, sizeof(*pEntry));
+
+        pEntry->key            = key;
+        pEntry->refCount       = 1;
+        pEntry->codeSize       = codeSize;
+        pEntry->storedCodeSize = storedCodeSize;
+        pEntry->pCode          = pCopy;
+
+        PipelineCompiler* pCompiler = m_pDevice->GetCompiler(DefaultDeviceIndex);
+
+        result = pCompiler->BuildShaderModule(m_pDevice, key.flags, codeSize, pCode, &pEntry->handle);
+
+        if (result == VK_SUCCESS)
+        {
+            *ppEntry = pEntry;
+        }
+        else
+        {
+            FreeEntry(pEntry);
+        }
+    }
+    else
+    {
+        result = VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+void ShaderModuleCache::FreeEntry(
+    ShaderModuleCacheEntry* pEntry)
+{
+    m_pDevice->GetCompiler(DefaultDeviceIndex)->FreeShaderModule(&pEntry->handle);
+
+    m_pDevice->VkInstance()->FreeMem(pEntry);
+}
+
+// =====================================================================================================================
+// Returns a referenced entry holding the given code and its compiled module, building the module if no live shader
+// module was created from the same code.  pStoredCode is the form of the code to retain, which may be compressed.
+VkResult ShaderModuleCache::Acquire(
+    VkShaderModuleCreateFlags      flags,
+    size_t                         codeSize,
+    const void*                    pCode,
+    size_t                         storedCodeSize,
+    const void*                    pStoredCode,
+    const Pal::ShaderHash&         codeHash,
+    const ShaderModuleCacheEntry** ppEntry)
+{
+    VK_ASSERT(m_enabled);
+
+    ShaderModuleKey key;
+
+    memset(&key, 0, sizeof(key));
+
+    key.codeHash = codeHash;
+    key.codeSize = codeSize;
+    key.flags    = flags;
+
+    ShaderModuleCacheEntry* pEntry = nullptr;
+
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        ShaderModuleCacheEntry* const* ppMapped = m_entries.FindKey(key);
+
+        if ((ppMapped != nullptr) && HoldsCode(*ppMapped, storedCodeSize, pStoredCode))
+        {
+            pEntry = *ppMapped;
+            pEntry->refCount++;
+        }
+    }
+
+    VkResult result = VK_SUCCESS;
+
+    if (pEntry == nullptr)
+    {
+        // Build outside the lock so that unrelated modules can be created concurrently.
+        ShaderModuleCacheEntry* pNewEntry = nullptr;
+
+        result = CreateEntry(key, codeSize, pCode, storedCodeSize, pStoredCode, &pNewEntry);
+
+        if (result == VK_SUCCESS)
+        {
+            Util::MutexAuto lock(&m_lock);
+
+            bool                     existed  = false;
+            ShaderModuleCacheEntry** ppMapped = nullptr;
+
+            pEntry = pNewEntry;
+
+            if (m_entries.FindAllocate(key, &existed, &ppMapped) == Pal::Result::Success)
+            {
+                if (existed == false)
+                {
+                    pNewEntry->inMap = true;
+                    *ppMapped        = pNewEntry;
+                }
+                else if (HoldsCode(*ppMapped, storedCodeSize, pStoredCode))
+                {
+                    // Another thread built the same code in the meantime; share its entry instead.
+                    pEntry = *ppMapped;
+                    pEntry->refCount++;
+                }
+            }
+
+            // Otherwise the map is out of memory or the hash collides with different code, and the new entry is
+            // simply not shared.
+        }
+
+        if ((pNewEntry != nullptr) && (pEntry != pNewEntry))
+        {
+            FreeEntry(pNewEntry);
+        }
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        *ppEntry = pEntry;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Drops a reference taken by Acquire(), freeing the entry and its compiled module with the last one.
+void ShaderModuleCache::Release(
+    const ShaderModuleCacheEntry* pEntry)
+{
+    ShaderModuleCacheEntry* pFreeEntry = nullptr;
+
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        ShaderModuleCacheEntry* pMutableEntry = const_cast<ShaderModuleCacheEntry*>(pEntry);
+
+        VK_ASSERT(pMutableEntry->refCount > 0);
+
+        if (--pMutableEntry->refCount == 0)
+        {
+            if (pMutableEntry->inMap)
+            {
+                m_entries.Erase(pMutableEntry->key);
+            }
+
+            pFreeEntry = pMutableEntry;
+        }
+    }
+
+    if (pFreeEntry != nullptr)
+    {
+        FreeEntry(pFreeEntry);
+    }
+}
+
+} // namespace vk
@@ -0,0 +1,627 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  shared_memory_cache_layer.cpp
+* @brief Implementation of the pipeline cache layer backed by a named shared-memory segment.
+***********************************************************************************************************************
+*/
+#include "include/shared_memory_cache_layer.h"
+
+#include "palInlineFuncs.h"
+#include "palSysMemory.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vk
+{
+
+// =====================================================================================================================
+// Opens (or creates) the segment shared by all processes of this user running on the same platform key.  Returns
+// nullptr if the segment can't be used, e.g. because another driver build created it with a different layout.
+SharedMemoryCacheLayer* SharedMemoryCacheLayer::Create(
+    const VkAllocationCallbacks* pAllocationCallbacks,
+    uint64_t                     platformKey,
+    size_t                       segmentSize)
+{
+    SharedMemoryCacheLayer* pLayer = nullptr;
+
+    void* pMem = pAllocationCallbacks->pfnAllocation(
+        pAllocationCallbacks->pUserData,
+        sizeof(SharedMemoryCacheLayer),
+        VK_DEFAULT_MEM_ALIGN,
+        VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+    if (pMem != nullptr)
+    {
+        pLayer = VK_PLACEMENT_NEW(pMem) SharedMemoryCacheLayer(pAllocationCallbacks);
+
+        if (pLayer->Init(platformKey, segmentSize) != Util::Result::Success)
+        {
+            pLayer->Destroy();
+            pLayer = nullptr;
+        }
+    }
+
+    return pLayer;
+}
+
+// =====================================================================================================================
+SharedMemoryCacheLayer::SharedMemoryCacheLayer(
+    const VkAllocationCallbacks* pAllocationCallbacks)
+    :
+    m_pAllocationCallbacks(pAllocationCallbacks),
+    m_pNextLayer(nullptr),
+    m_loadPolicy(LinkPolicy::PassCalls),
+    m_storePolicy(LinkPolicy::PassData),
+    m_fd(-1),
+    m_pSegment(nullptr),
+    m_segmentSize(0)
+{
+}
+
+// =====================================================================================================================
+// Unmaps the segment and frees the layer.  The segment itself is left in place for the other processes; it goes away
+// with the last mapping once it has been unlinked externally, or at reboot.
+void SharedMemoryCacheLayer::Destroy()
+{
+    if (m_pSegment != nullptr)
+    {
+        munmap(m_pSegment, m_segmentSize);
+    }
+
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+    }
+
+    const VkAllocationCallbacks* pAllocationCallbacks = m_pAllocationCallbacks;
+
+    Util::Destructor(this);
+
+    pAllocationCallbacks->pfnFree(pAllocationCallbacks->pUserData, this);
+}
+
+// =====================================================================================================================
+Util::Result SharedMemoryCacheLayer::Init(
+    uint64_t platformKey,
+    size_t   segmentSize)
+{
+    Util::Result result = Util::Result::Success;
+
+    // The name includes the user so that processes of different users never share (or fight over) a segment.
+    char name[64] = {};
+    Util::Snprintf(name, sizeof(name), "/amdvlk_pipeline_cache_%u_%016" PRIx64,
+                   static_cast<uint32_t>(getuid()), platformKey);
+
+    m_fd = shm_open(name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+
+    if (m_fd < 0)
+    {
+        result = Util::Result::ErrorUnavailable;
+    }
+
+    if (result == Util::Result::Success)
+    {
+        // Size and initialize the segment under the writer lock so that concurrently starting processes agree on the
+        // layout.  The first process to get the lock decides the size.
+        LockWriter();
+
+        struct stat segmentStat = {};
+
+        if (fstat(m_fd, &segmentStat) != 0)
+        {
+            result = Util::Result::ErrorUnavailable;
+        }
+        else if (segmentStat.st_size == 0)
+        {
+            if (ftruncate(m_fd, static_cast<off_t>(segmentSize)) != 0)
+            {
+                result = Util::Result::ErrorOutOfMemory;
+            }
+        }
+        else
+        {
+            segmentSize = static_cast<size_t>(segmentStat.st_size);
+        }
+
+        if (result == Util::Result::Success)
+        {
+            void* pMapping = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+
+            if (pMapping != MAP_FAILED)
+            {
+                m_pSegment    = pMapping;
+                m_segmentSize = segmentSize;
+
+                result = InitSegmentHeader(platformKey, segmentSize);
+            }
+            else
+            {
+                result = Util::Result::ErrorOutOfMemory;
+            }
+        }
+
+        UnlockWriter();
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Lays out a freshly created segment, or validates the layout of an existing one.  Must be called with the writer lock
+// held.
+Util::Result SharedMemoryCacheLayer::InitSegmentHeader(
+    uint64_t platformKey,
+    size_t   segmentSize)
+{
+    Util::Result   result  = Util::Result::Success;
+    SegmentHeader* pHeader = GetHeader();
+
+    if (segmentSize < MinSegmentSize)
+    {
+        result = Util::Result::ErrorInvalidValue;
+    }
+    else if (pHeader->magic == 0)
+    {
+        // New segments are zero-filled, so every slot starts out empty.
+        uint32_t slotCount = MinSlotCount;
+
+        while ((static_cast<size_t>(slotCount) * 2 * BytesPerSlot) <= segmentSize)
+        {
+            slotCount *= 2;
+        }
+
+        pHeader->version     = SegmentVersion;
+        pHeader->platformKey = platformKey;
+        pHeader->segmentSize = segmentSize;
+        pHeader->slotCount   = slotCount;
+        pHeader->dataOffset  = Util::Pow2Align(sizeof(SegmentHeader) + (slotCount * sizeof(Slot)), DataAlignment);
+        pHeader->dataUsed    = 0;
+
+        if (pHeader->dataOffset >= segmentSize)
+        {
+            result = Util::Result::ErrorInvalidValue;
+        }
+        else
+        {
+            pHeader->magic = SegmentMagic;
+        }
+    }
+    else if ((pHeader->magic       != SegmentMagic)   ||
+             (pHeader->version     != SegmentVersion) ||
+             (pHeader->platformKey != platformKey)    ||
+             (pHeader->segmentSize != segmentSize)    ||
+             (Util::IsPowerOfTwo(pHeader->slotCount) == false))
+    {
+        result = Util::Result::ErrorIncompatibleDevice;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+void SharedMemoryCacheLayer::LockWriter()
+{
+    // flock() locks belong to the open file description, so it only excludes other processes; threads of this process
+    // are excluded by the mutex.  The advisory lock is dropped automatically if a writer process dies.
+    m_writerLock.Lock();
+
+    while ((flock(m_fd, LOCK_EX) != 0) && (errno == EINTR))
+    {
+    }
+}
+
+// =====================================================================================================================
+void SharedMemoryCacheLayer::UnlockWriter()
+{
+    flock(m_fd, LOCK_UN);
+
+    m_writerLock.Unlock();
+}
+
+// =====================================================================================================================
+// Looks up the slot of an entry without taking any lock.  Slots are only ever filled in, never cleared, so a probe
+// sequence ends at the first slot that has never been written.  Returns bad entries too; callers check the state.
+const SharedMemoryCacheLayer::Slot* SharedMemoryCacheLayer::FindSlot(
+    const Util::Hash128* pHashId) const
+{
+    const SegmentHeader* pHeader   = GetHeader();
+    const Slot*          pSlots    = GetSlots();
+    const uint32_t       slotCount = pHeader->slotCount;
+    const Slot*          pFound    = nullptr;
+
+    for (uint32_t i = 0; i < slotCount; ++i)
+    {
+        const Slot* pSlot = &pSlots[(pHashId->dwords[0] + i) & (slotCount - 1)];
+
+        // Acquire pairs with the release in StoreEntry(): once the state is visible, so is the rest of the entry.
+        const uint32_t state = __atomic_load_n(&pSlot->state, __ATOMIC_ACQUIRE);
+
+        if (state == SlotEmpty)
+        {
+            break;
+        }
+
+        if (memcmp(&pSlot->hashId, pHashId, sizeof(*pHashId)) == 0)
+        {
+            pFound = pSlot;
+            break;
+        }
+    }
+
+    return pFound;
+}
+
+// =====================================================================================================================
+// Returns the data of a slot, or nullptr if the slot points outside of the segment.  Any process which maps the segment
+// can write the slot, so its location is read once and checked before the data is touched.
+const void* SharedMemoryCacheLayer::GetSlotData(
+    const Slot* pSlot,
+    size_t*     pDataSize) const
+{
+    const uint64_t dataOffset = __atomic_load_n(&pSlot->dataOffset, __ATOMIC_RELAXED);
+    const uint64_t dataSize   = __atomic_load_n(&pSlot->dataSize, __ATOMIC_RELAXED);
+    const void*    pData      = nullptr;
+
+    // Compared this way around so that neither side can overflow.
+    if ((dataOffset <= m_segmentSize) && (dataSize <= (m_segmentSize - dataOffset)))
+    {
+        pData      = Util::VoidPtrInc(m_pSegment, static_cast<size_t>(dataOffset));
+        *pDataSize = static_cast<size_t>(dataSize);
+    }
+
+    return pData;
+}
+
+// =====================================================================================================================
+// Appends an entry to the segment.  Returns AlreadyExists if another thread or process stored it first, and
+// ErrorOutOfMemory once the segment is full.
+Util::Result SharedMemoryCacheLayer::StoreEntry(
+    const Util::Hash128* pHashId,
+    const void*          pData,
+    size_t               dataSize)
+{
+    // Entries are never replaced, so duplicates can be rejected before taking the writer lock.
+    if (FindSlot(pHashId) != nullptr)
+    {
+        return Util::Result::AlreadyExists;
+    }
+
+    Util::Result result = Util::Result::ErrorOutOfMemory;
+
+    LockWriter();
+
+    SegmentHeader* pHeader   = GetHeader();
+    Slot*          pSlots    = GetSlots();
+    const uint32_t slotCount = pHeader->slotCount;
+    Slot*          pSlot     = nullptr;
+
+    for (uint32_t i = 0; i < slotCount; ++i)
+    {
+        Slot* pCandidate = &pSlots[(pHashId->dwords[0] + i) & (slotCount - 1)];
+
+        if (pCandidate->state == SlotEmpty)
+        {
+            pSlot = pCandidate;
+            break;
+        }
+
+        if (memcmp(&pCandidate->hashId, pHashId, sizeof(*pHashId)) == 0)
+        {
+            result = Util::Result::AlreadyExists;
+            break;
+        }
+    }
+
+    if (pSlot != nullptr)
+    {
+        const uint64_t dataOffset = pHeader->dataOffset + Util::Pow2Align(pHeader->dataUsed, DataAlignment);
+
+        if ((dataOffset <= m_segmentSize) && (dataSize <= (m_segmentSize - dataOffset)))
+        {
+            memcpy(Util::VoidPtrInc(m_pSegment, static_cast<size_t>(dataOffset)), pData, dataSize);
+
+            pSlot->hashId     = *pHashId;
+            pSlot->dataOffset = dataOffset;
+            pSlot->dataSize   = dataSize;
+
+            pHeader->dataUsed = (dataOffset - pHeader->dataOffset) + dataSize;
+
+            // Publish the entry to lock-free readers.
+            __atomic_store_n(&pSlot->state, SlotReady, __ATOMIC_RELEASE);
+
+            result = Util::Result::Success;
+        }
+    }
+
+    UnlockWriter();
+
+    return result;
+}
+
+// =====================================================================================================================
+// Looks up an entry in the segment, then in the next layer.  Entries found further down are copied into the segment
+// when the caller asks for LoadOnQuery, so that other processes can pick them up without touching their archives.
+Util::Result SharedMemoryCacheLayer::Query(
+    const Util::Hash128* pHashId,
+    uint32_t             policy,
+    uint32_t             flags,
+    Util::QueryResult*   pQuery)
+{
+    Util::Result result   = Util::Result::NotFound;
+    const Slot*  pSlot    = FindSlot(pHashId);
+    size_t       dataSize = 0;
+
+    // An entry whose data lies outside of the segment is treated as missing.
+    if ((pSlot != nullptr)                                              &&
+        (__atomic_load_n(&pSlot->state, __ATOMIC_ACQUIRE) == SlotReady) &&
+        (GetSlotData(pSlot, &dataSize) != nullptr))
+    {
+        memset(pQuery, 0, sizeof(*pQuery));
+        pQuery->hashId             = *pHashId;
+        pQuery->dataSize           = dataSize;
+        pQuery->pLayer             = this;
+        pQuery->context.pEntryInfo = const_cast<Slot*>(pSlot);
+
+        result = Util::Result::Success;
+    }
+    else if ((m_pNextLayer != nullptr) && Util::TestAnyFlagSet(m_loadPolicy, LinkPolicy::PassCalls))
+    {
+        result = m_pNextLayer->Query(pHashId, policy, flags, pQuery);
+
+        // Referenced queries have to stay with the layer that holds the reference.
+        if ((result == Util::Result::Success)                                    &&
+            Util::TestAnyFlagSet(policy, LinkPolicy::LoadOnQuery)                &&
+            (Util::TestAnyFlagSet(flags, QueryFlags::AcquireEntryRef) == false)  &&
+            (Util::TestAnyFlagSet(m_loadPolicy, LinkPolicy::Skip) == false))
+        {
+            void* pData = m_pAllocationCallbacks->pfnAllocation(
+                m_pAllocationCallbacks->pUserData,
+                pQuery->dataSize,
+                VK_DEFAULT_MEM_ALIGN,
+                VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+
+            if ((pData != nullptr) && (m_pNextLayer->Load(pQuery, pData) == Util::Result::Success))
+            {
+                const Util::Result storeResult = StoreEntry(pHashId, pData, pQuery->dataSize);
+
+                // Serve the caller from the segment too; the lower layer's query needs no cleanup.
+                pSlot = ((storeResult == Util::Result::Success) || (storeResult == Util::Result::AlreadyExists)) ?
+                        FindSlot(pHashId) : nullptr;
+
+                if ((pSlot != nullptr)                                              &&
+                    (__atomic_load_n(&pSlot->state, __ATOMIC_ACQUIRE) == SlotReady) &&
+                    (GetSlotData(pSlot, &dataSize) != nullptr)                      &&
+                    (dataSize == pQuery->dataSize))
+                {
+                    pQuery->pLayer             = this;
+                    pQuery->context.pEntryInfo = const_cast<Slot*>(pSlot);
+                }
+            }
+
+            if (pData != nullptr)
+            {
+                m_pAllocationCallbacks->pfnFree(m_pAllocationCallbacks->pUserData, pData);
+            }
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Stores an entry in the segment and passes it down the chain.  A full segment is not an error as long as the binary
+// made it into one of the layers below.
+Util::Result SharedMemoryCacheLayer::Store(
+    const Util::Hash128* pHashId,
+    const void*          pData,
+    size_t               dataSize)
+{
+    Util::Result result = StoreEntry(pHashId, pData, dataSize);
+
+    if (result == Util::Result::AlreadyExists)
+    {
+        result = Util::Result::Success;
+    }
+
+    if ((m_pNextLayer != nullptr) && Util::TestAnyFlagSet(m_storePolicy, LinkPolicy::PassData))
+    {
+        const Util::Result nextResult = m_pNextLayer->Store(pHashId, pData, dataSize);
+
+        if (result != Util::Result::Success)
+        {
+            result = nextResult;
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+Util::Result SharedMemoryCacheLayer::Load(
+    const Util::QueryResult* pQuery,
+    void*                    pBuffer)
+{
+    Util::Result result = Util::Result::ErrorInvalidValue;
+
+    if (IsOwnQuery(pQuery))
+    {
+        const Slot* pSlot    = static_cast<const Slot*>(pQuery->context.pEntryInfo);
+        size_t      dataSize = 0;
+        const void* pData    = GetSlotData(pSlot, &dataSize);
+
+        // The buffer was sized by Query(), so the slot must still describe the same data.
+        if ((pData != nullptr) && (dataSize == pQuery->dataSize))
+        {
+            memcpy(pBuffer, pData, dataSize);
+
+            result = Util::Result::Success;
+        }
+        else
+        {
+            result = Util::Result::NotFound;
+        }
+    }
+    else if (m_pNextLayer != nullptr)
+    {
+        result = m_pNextLayer->Load(pQuery, pBuffer);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Entry data is immutable once published, so it can be handed out in place for as long as the layer exists.
+Util::Result SharedMemoryCacheLayer::GetCacheData(
+    const Util::QueryResult* pQuery,
+    const void**             ppData)
+{
+    Util::Result result = Util::Result::ErrorInvalidValue;
+
+    if (IsOwnQuery(pQuery))
+    {
+        const Slot* pSlot    = static_cast<const Slot*>(pQuery->context.pEntryInfo);
+        size_t      dataSize = 0;
+
+        *ppData = GetSlotData(pSlot, &dataSize);
+
+        result = ((*ppData != nullptr) && (dataSize == pQuery->dataSize)) ? Util::Result::Success :
+                                                                             Util::Result::NotFound;
+    }
+    else if (m_pNextLayer != nullptr)
+    {
+        result = m_pNextLayer->GetCacheData(pQuery, ppData);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Entries of the segment are always complete; only the layers below can have entries in flight.
+Util::Result SharedMemoryCacheLayer::WaitForEntry(
+    const Util::Hash128* pHashId)
+{
+    Util::Result result = Util::Result::NotFound;
+    const Slot*  pSlot  = FindSlot(pHashId);
+
+    if ((pSlot != nullptr) && (__atomic_load_n(&pSlot->state, __ATOMIC_ACQUIRE) == SlotReady))
+    {
+        result = Util::Result::Success;
+    }
+    else if (m_pNextLayer != nullptr)
+    {
+        result = m_pNextLayer->WaitForEntry(pHashId);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Other processes may be using the entry, so the segment never evicts; the call is only passed down the chain.
+Util::Result SharedMemoryCacheLayer::Evict(
+    const Util::Hash128* pHashId)
+{
+    return (m_pNextLayer != nullptr) ? m_pNextLayer->Evict(pHashId) : Util::Result::Unsupported;
+}
+
+// =====================================================================================================================
+// A bad binary is bad for every process, so the entry is hidden from all of them.
+Util::Result SharedMemoryCacheLayer::MarkEntryBad(
+    const Util::Hash128* pHashId)
+{
+    Util::Result result = Util::Result::NotFound;
+    const Slot*  pSlot  = FindSlot(pHashId);
+
+    if (pSlot != nullptr)
+    {
+        __atomic_store_n(&const_cast<Slot*>(pSlot)->state, SlotBad, __ATOMIC_RELEASE);
+
+        result = Util::Result::Success;
+    }
+
+    if (m_pNextLayer != nullptr)
+    {
+        const Util::Result nextResult = m_pNextLayer->MarkEntryBad(pHashId);
+
+        if (result != Util::Result::Success)
+        {
+            result = nextResult;
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// The segment doesn't reference count its entries.
+Util::Result SharedMemoryCacheLayer::ReleaseCacheRef(
+    const Util::QueryResult* pQuery)
+{
+    Util::Result result = Util::Result::Success;
+
+    if ((IsOwnQuery(pQuery) == false) && (m_pNextLayer != nullptr))
+    {
+        result = m_pNextLayer->ReleaseCacheRef(pQuery);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+Util::Result SharedMemoryCacheLayer::Link(
+    Util::ICacheLayer* pNextLayer)
+{
+    m_pNextLayer = pNextLayer;
+
+    return Util::Result::Success;
+}
+
+// =====================================================================================================================
+Util::Result SharedMemoryCacheLayer::SetLoadPolicy(
+    uint32_t loadPolicy)
+{
+    m_loadPolicy = loadPolicy;
+
+    return Util::Result::Success;
+}
+
+// =====================================================================================================================
+Util::Result SharedMemoryCacheLayer::SetStorePolicy(
+    uint32_t storePolicy)
+{
+    m_storePolicy = storePolicy;
+
+    return Util::Result::Success;
+}
+
+} // namespace vk
@@ -245,6 +245,8 @@ SqttCmdBufferState::SqttCmdBufferState(
     m_debugTags(pCmdBuf->VkInstance()->Allocator())
 {
     m_cbId.u32All       = 0;
+    m_eventMarkerTemplate            = {};
+    m_eventMarkerTemplate.identifier = RgpSqttMarkerIdentifierEvent;
     m_deviceId          = reinterpret_cast<uint64_t>(ApiDevice::FromObject(m_pCmdBuf->VkDevice()));
     m_queueFamilyIndex  = m_pCmdBuf->GetQueueFamilyIndex();
 
@@ -287,6 +289,11 @@ void SqttCmdBufferState::Begin(
 
     m_cbId = m_pSqttMgr->GetNextCmdBufID(m_pCmdBuf->GetQueueFamilyIndex(), pBeginInfo);
 
+    // The identifier and command buffer ID are the same for every event marker recorded until the next Begin().
+    m_eventMarkerTemplate            = {};
+    m_eventMarkerTemplate.identifier = RgpSqttMarkerIdentifierEvent;
+    m_eventMarkerTemplate.cbID       = m_cbId.u32All;
+
     // Clear the list of debug tags whenever a new command buffer is started.
     auto it = m_debugTags.Begin();
     while (it.Get() != nullptr)
@@ -349,12 +356,10 @@ void SqttCmdBufferState::End()
 RgpSqttMarkerEvent SqttCmdBufferState::BuildEventMarker(
     RgpSqttMarkerEventType apiType)
 {
-    RgpSqttMarkerEvent marker = {};
+    RgpSqttMarkerEvent marker = m_eventMarkerTemplate;
 
-    marker.identifier  = RgpSqttMarkerIdentifierEvent;
     marker.apiType     = static_cast<uint32_t>(apiType);
     marker.cmdID       = m_currentEventId++;
-    marker.cbID        = m_cbId.u32All;
 
     return marker;
 }
@@ -460,8 +465,8 @@ void SqttCmdBufferState::WriteUserEventMarker(
     if ((m_enabledMarkers & DevModeSqttMarkerEnableUserEvent) &&
         (m_pUserEvent != nullptr))
     {
-        memset(m_pUserEvent, 0, sizeof(*m_pUserEvent));
-
+        // Only the dwords that are actually emitted are written; the rest of the 4KB string buffer is left untouched.
+        m_pUserEvent->header.dword01    = 0;
         m_pUserEvent->header.identifier = RgpSqttMarkerIdentifierUserEvent;
         m_pUserEvent->header.dataType   = eventType;
 
@@ -471,21 +476,22 @@ void SqttCmdBufferState::WriteUserEventMarker(
         {
             size_t strLength = 0;
 
-            // Copy and encode the string if one exists
+            // Copy the string if one exists.  The marker packs characters into dwords little-endian, which matches
+            // the in-memory byte order, so a straight copy with the last dword zero-padded is enough.
             if (pString != nullptr)
             {
                 strLength = Util::Min(strlen(pString), RgpSqttMaxUserEventStringLengthInDwords * sizeof(uint32_t));
 
-                for (uint32_t charIdx = 0; charIdx < strLength; ++charIdx)
+                if (strLength > 0)
                 {
-                    uint32_t c = static_cast<uint32_t>(pString[charIdx]);
+                    m_pUserEvent->stringData[(strLength - 1) / sizeof(uint32_t)] = 0;
 
-                    m_pUserEvent->stringData[charIdx / 4] |= (c << (8 * (charIdx % 4)));
+                    memcpy(m_pUserEvent->stringData, pString, strLength);
                 }
-
-                m_pUserEvent->stringLength = static_cast<uint32_t>(strLength);
             }
 
+            m_pUserEvent->stringLength = static_cast<uint32_t>(strLength);
+
             // Every data type other than Pop includes a string length
             markerSize += sizeof(uint32_t);
 
@@ -2091,28 +2097,7 @@ VKAPI_ATTR VkResult VKAPI_CALL vkDebugMarkerSetObjectNameEXT(
 
         if (pMeta != nullptr)
         {
-            size_t nameSize = strlen(pNameInfo->pObjectName) + 1;
-
-            if (pMeta->debugNameCapacity < nameSize)
-            {
-                if (pMeta->pDebugName != nullptr)
-                {
-                    pDevice->VkInstance()->FreeMem(pMeta->pDebugName);
-                }
-
-                pMeta->pDebugName = static_cast<char*>(pDevice->VkInstance()->AllocMem(nameSize,
-                    VK_SYSTEM_ALLOCATION_SCOPE_DEVICE));
-
-                if (pMeta->pDebugName != nullptr)
-                {
-                    pMeta->debugNameCapacity = nameSize;
-                }
-            }
-
-            if ((pMeta->debugNameCapacity >= nameSize) && (pMeta->pDebugName != nullptr))
-            {
-                memcpy(pMeta->pDebugName, pNameInfo->pObjectName, nameSize);
-            }
+            pMeta->pDebugName = pDevice->GetDebugNameTable()->Intern(pNameInfo->pObjectName);
         }
     }
 
@@ -2161,28 +2146,7 @@ VKAPI_ATTR VkResult VKAPI_CALL vkSetDebugUtilsObjectNameEXT(
 
         if (pMeta != nullptr)
         {
-            size_t nameSize = strlen(pNameInfo->pObjectName) + 1;
-
-            if (pMeta->debugNameCapacity < nameSize)
-            {
-                if (pMeta->pDebugName != nullptr)
-                {
-                    pDevice->VkInstance()->FreeMem(pMeta->pDebugName);
-                }
-
-                pMeta->pDebugName = static_cast<char*>(pDevice->VkInstance()->AllocMem(nameSize,
-                    VK_SYSTEM_ALLOCATION_SCOPE_DEVICE));
-
-                if (pMeta->pDebugName != nullptr)
-                {
-                    pMeta->debugNameCapacity = nameSize;
-                }
-            }
-
-            if ((pMeta->debugNameCapacity >= nameSize) && (pMeta->pDebugName != nullptr))
-            {
-                memcpy(pMeta->pDebugName, pNameInfo->pObjectName, nameSize);
-            }
+            pMeta->pDebugName = pDevice->GetDebugNameTable()->Intern(pNameInfo->pObjectName);
         }
     }
 
@@ -199,6 +199,7 @@ private:
     const RuntimeSettings&      m_settings;
     const DispatchTable*        m_pNextLayer;        // Pointer to next layer's dispatch table
     RgpSqttMarkerCbID           m_cbId;              // Command buffer ID associated with this command buffer
+    RgpSqttMarkerEvent          m_eventMarkerTemplate; // Event marker with the per-command-buffer fields filled in
     uint64_t                    m_deviceId;          // API-specific device ID (we use VkDevice handle)
     uint32_t                    m_queueFamilyIndex;
     VkQueueFlags                m_queueFamilyFlags;
@@ -82,7 +82,6 @@ void SqttObjectMgr::Init(
 // =====================================================================================================================
 SqttMetaState::SqttMetaState()
     :
-    debugNameCapacity(0),
     pDebugName(nullptr)
 {
 
@@ -92,10 +91,8 @@ SqttMetaState::SqttMetaState()
 void SqttMetaState::Destroy(
     Device* pDevice)
 {
-    if (pDebugName != nullptr)
-    {
-        pDevice->VkInstance()->FreeMem(pDebugName);
-    }
+    // The debug name is owned by the device name table
+    pDebugName = nullptr;
 }
 
 // =====================================================================================================================
@@ -58,8 +58,7 @@ struct SqttMetaState
 
     void Destroy(Device* pDevice);
 
-    size_t debugNameCapacity;
-    char*  pDebugName; // Debug object name string
+    const char* pDebugName; // Debug object name string, interned in the device name table
 
     union
     {
@@ -0,0 +1,88 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  startup_profile.cpp
+* @brief Timing of the one-time initialization phases of the driver.
+***********************************************************************************************************************
+*/
+
+#include "include/startup_profile.h"
+
+#include "palFile.h"
+#include "palMutex.h"
+
+#include <stdlib.h>
+
+namespace vk
+{
+
+static const char* const StartupProfileEnvVar = "AMDVLK_STARTUP_PROFILE";
+
+const bool    StartupProfile::s_enabled   = (getenv(StartupProfileEnvVar) != nullptr);
+const int64_t StartupProfile::s_loadTicks = Util::GetPerfCpuTime();
+
+// =====================================================================================================================
+// Appends a phase which started at startTicks and ends now to the profile file.  The file is opened by the first phase
+// which ends and stays open for the lifetime of the process; a phase is only lost if the file can't be opened.
+void StartupProfile::Record(
+    const char* pPhase,
+    int64_t     startTicks)
+{
+    struct ProfileFile
+    {
+        ProfileFile()
+        {
+            const char* pPath = getenv(StartupProfileEnvVar);
+
+            if (pPath != nullptr)
+            {
+                file.Open(pPath, Util::FileAccessAppend);
+            }
+        }
+
+        Util::Mutex mutex;
+        Util::File  file;
+    };
+
+    static ProfileFile profileFile;
+
+    const int64_t endTicks = Util::GetPerfCpuTime();
+
+    if (profileFile.file.IsOpen())
+    {
+        const double usPerTick = 1000000.0 / static_cast<double>(Util::GetPerfFrequency());
+
+        Util::MutexAuto lock(&profileFile.mutex);
+
+        profileFile.file.Printf("startup %s start_us=%llu duration_us=%llu\n",
+                                pPhase,
+                                static_cast<unsigned long long>((startTicks - s_loadTicks) * usPerTick),
+                                static_cast<unsigned long long>((endTicks - startTicks) * usPerTick));
+        profileFile.file.Flush();
+    }
+}
+
+} // namespace vk
@@ -50,3 +50,77 @@ $entry_point_members$
 '''
 
 entry_point_member = '    PFN_$func_name$ $func_name$;'
+
+device_entry_points_template = '''
+$copyright_string$
+
+// Do not edit this file by hand; generated via script from $entry_file$
+
+// Lists every device-level entry point as VKI_DEVICE_ENTRY_POINT(func_name).  Define that macro before including this
+// file; there is deliberately no include guard.
+
+$device_entry_points$'''
+
+device_entry_point = 'VKI_DEVICE_ENTRY_POINT($func_name$)'
+
+entry_point_hash_template = '''
+$copyright_string$
+
+// Do not edit this file by hand; generated via script from $entry_file$
+
+#ifndef __STRINGS_G_ENTRY_POINT_HASH_H__
+#define __STRINGS_G_ENTRY_POINT_HASH_H__
+
+#include <stdint.h>
+
+namespace vk
+{
+
+namespace strings
+{
+
+namespace entry
+{
+
+// Perfect hash of the entry point names (hash and displace).  The upper half of the 64-bit FNV-1a hash of a name
+// selects a bucket, and the lower half mixed with the bucket's displacement selects a unique slot holding the entry
+// point index.  Names which are not entry points land on an arbitrary slot, so the caller must compare the name.
+constexpr uint32_t EntryPointHashBucketCount = $bucket_count$;
+constexpr uint32_t EntryPointHashSlotBits    = $slot_bits$;
+constexpr uint16_t EntryPointHashEmptySlot   = 0xFFFF;
+
+static const uint16_t EntryPointHashDisplacements[EntryPointHashBucketCount] =
+{
+$displacements$
+};
+
+static const uint16_t EntryPointHashSlots[1u << EntryPointHashSlotBits] =
+{
+$slots$
+};
+
+// Returns the index of the only entry point pName can be, or EntryPointHashEmptySlot if it can't be any.
+inline uint32_t GetEntryPointIndexCandidate(
+    const char* pName)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for (const char* pChar = pName; *pChar != '\\0'; ++pChar)
+    {
+        hash = (hash ^ static_cast<uint8_t>(*pChar)) * 0x100000001B3ull;
+    }
+
+    const uint32_t bucket = static_cast<uint32_t>(hash >> 32) % EntryPointHashBucketCount;
+    const uint32_t mixed  = (static_cast<uint32_t>(hash) ^ EntryPointHashDisplacements[bucket]) * 0x9E3779B1u;
+
+    return EntryPointHashSlots[mixed >> (32 - EntryPointHashSlotBits)];
+}
+
+} // namespace entry
+
+} // namespace strings
+
+} // namespace vk
+
+#endif
+'''
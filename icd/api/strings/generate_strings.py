@@ -267,6 +267,165 @@ def generate_func_table(entry_file, header_file):
     header.write(header_template)
     header.close()
 
+def generate_device_entry_points(entry_file, header_file):
+    from func_table_template import device_entry_points_template
+    from func_table_template import device_entry_point
+
+    global open_copyright
+    global openSource;
+    global PREFIX
+
+    print("Generating %s from %s ..." % (header_file, entry_file))
+
+    f = open(entry_file)
+    lines = f.readlines()
+    f.close()
+
+    header = open(PREFIX + header_file, 'w')
+
+    device_entry_points = ''
+    prev_ext = ''
+
+    for line in lines:
+        original = line.rstrip().lstrip()
+        if original == "" or original[0] == '#':
+            continue
+
+        tokens = original.split('@', 2)
+
+        if tokens[1].rstrip() != 'device':
+            continue
+
+        # Use the same compile conditions as the function table, so only entry points it has members for are listed.
+        cur_ext = get_compile_condition('@' + tokens[2])
+
+        if cur_ext != prev_ext:
+            if len(prev_ext) > 0:
+                device_entry_points += '#endif\n'
+
+            if len(cur_ext) > 0:
+                device_entry_points += ('#if %s\n' % cur_ext)
+
+            prev_ext = cur_ext
+
+        func_name = tokens[0].rstrip()
+
+        device_entry_points += device_entry_point.replace('$func_name$', func_name) + '\n'
+
+    if len(prev_ext) > 0:
+        device_entry_points += '#endif\n'
+
+    template = device_entry_points_template
+
+    if openSource:
+        template = template.replace('$copyright_string$', open_copyright)
+    template = template.replace('$entry_file$', entry_file)
+    template = template.replace('$device_entry_points$', device_entry_points)
+
+    header.write(template)
+    header.close()
+
+def fnv1a64(name):
+    hash = 0xCBF29CE484222325
+
+    for byte in name.encode():
+        hash = ((hash ^ byte) * 0x100000001B3) & 0xFFFFFFFFFFFFFFFF
+
+    return hash
+
+def entry_point_hash_slot(lower_hash, displacement, slot_bits):
+    return (((lower_hash ^ displacement) * 0x9E3779B1) & 0xFFFFFFFF) >> (32 - slot_bits)
+
+def build_entry_point_hash(names, bucket_count, slot_bits):
+    # Hash and displace: place the largest buckets first, trying displacements until all of a bucket's names land on
+    # distinct free slots.
+    buckets = [[] for _ in range(bucket_count)]
+
+    for index, name in enumerate(names):
+        hash = fnv1a64(name)
+        buckets[(hash >> 32) % bucket_count].append((index, hash & 0xFFFFFFFF))
+
+    slots         = [0xFFFF] * (1 << slot_bits)
+    displacements = [0] * bucket_count
+
+    for bucket in sorted(range(bucket_count), key=lambda b: -len(buckets[b])):
+        if len(buckets[bucket]) == 0:
+            continue
+
+        placed = False
+
+        for displacement in range(0, 0xFFFF):
+            candidates = [entry_point_hash_slot(lower, displacement, slot_bits) for _, lower in buckets[bucket]]
+
+            if (len(set(candidates)) == len(candidates)) and all(slots[slot] == 0xFFFF for slot in candidates):
+                for (index, _), slot in zip(buckets[bucket], candidates):
+                    slots[slot] = index
+
+                displacements[bucket] = displacement
+                placed = True
+                break
+
+        if placed == False:
+            return None
+
+    return (displacements, slots)
+
+def format_table(values):
+    lines = []
+
+    for start in range(0, len(values), 12):
+        lines.append('    ' + ' '.join('0x%04X,' % value for value in values[start:start + 12]))
+
+    return '\n'.join(lines)
+
+def generate_entry_point_hash(entry_file, header_file):
+    from func_table_template import entry_point_hash_template
+
+    global open_copyright
+    global openSource;
+    global PREFIX
+
+    print("Generating %s from %s ..." % (header_file, entry_file))
+
+    f = open(entry_file)
+    lines = f.readlines()
+    f.close()
+
+    # Same entry point order as the _index defines of generate_string_file_pass()
+    names = []
+
+    for line in lines:
+        original = line.rstrip().lstrip()
+        if original == "" or original[0] == '#':
+            continue
+
+        if '@' in original:
+            names.append(original.split('@', 2)[0].rstrip())
+
+    bucket_count = max(1, (len(names) + 3) // 4)
+    slot_bits    = max(1, (len(names) + (len(names) // 4)).bit_length())
+    table        = build_entry_point_hash(names, bucket_count, slot_bits)
+
+    while table is None:
+        slot_bits += 1
+        table      = build_entry_point_hash(names, bucket_count, slot_bits)
+
+    (displacements, slots) = table
+
+    template = entry_point_hash_template
+
+    if openSource:
+        template = template.replace('$copyright_string$', open_copyright)
+    template = template.replace('$entry_file$', entry_file)
+    template = template.replace('$bucket_count$', str(bucket_count))
+    template = template.replace('$slot_bits$', str(slot_bits))
+    template = template.replace('$displacements$', format_table(displacements))
+    template = template.replace('$slots$', format_table(slots))
+
+    header = open(PREFIX + header_file, 'w')
+    header.write(template)
+    header.close()
+
 GetOpt()
 os.chdir(workDir)
 
@@ -275,3 +434,5 @@ PREFIX = "./"
 generate_string_file("extensions")
 generate_string_file("entry_points")
 generate_func_table("entry_points.txt", "g_func_table.h")
+generate_device_entry_points("entry_points.txt", "g_device_entry_points.h")
+generate_entry_point_hash("entry_points.txt", "g_entry_point_hash.h")
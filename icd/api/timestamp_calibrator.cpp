@@ -0,0 +1,225 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  timestamp_calibrator.cpp
+* @brief Model of the device clock which answers calibrated timestamp requests without a kernel query.
+***********************************************************************************************************************
+*/
+
+#include "include/timestamp_calibrator.h"
+#include "include/vk_device.h"
+#include "include/vk_physical_device.h"
+
+#include <math.h>
+#include <time.h>
+
+namespace vk
+{
+
+// =====================================================================================================================
+// Reads a CPU clock in nanoseconds.
+static VK_INLINE uint64_t ReadClockNs(
+    clockid_t clockId)
+{
+    timespec time = {};
+    clock_gettime(clockId, &time);
+
+    return (static_cast<uint64_t>(time.tv_sec) * 1000000000ull) + static_cast<uint64_t>(time.tv_nsec);
+}
+
+// =====================================================================================================================
+TimestampCalibrator::TimestampCalibrator(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_enabled(false),
+    m_resampleNs(0),
+    m_nominalTicksPerNs(0.0),
+    m_tickNs(0),
+    m_sampleCount(0),
+    m_base(),
+    m_anchor(),
+    m_ticksPerNs(0.0),
+    m_rateError(0.0)
+{
+}
+
+// =====================================================================================================================
+// The model needs the device timestamp and CLOCK_MONOTONIC_RAW, which PAL samples together on Linux.
+void TimestampCalibrator::Init()
+{
+    const Pal::DeviceProperties& props = m_pDevice->VkPhysicalDevice(DefaultDeviceIndex)->PalProperties();
+
+    m_resampleNs = static_cast<uint64_t>(m_pDevice->GetRuntimeSettings().calibratedTimestampResampleInterval) * 1000000;
+
+    m_enabled = (m_resampleNs > 0)                                          &&
+                (props.timestampFrequency > 0)                              &&
+                (props.osProperties.timeDomains.supportDevice != 0)         &&
+                (props.osProperties.timeDomains.supportClockMonotonicRaw != 0);
+
+    if (m_enabled)
+    {
+        m_nominalTicksPerNs = static_cast<double>(props.timestampFrequency) / 1000000000.0;
+        m_tickNs            = (1000000000ull + props.timestampFrequency - 1) / props.timestampFrequency;
+    }
+}
+
+// =====================================================================================================================
+// Answers a calibrated timestamp request from the model.  Returns false if the request has to be queried from PAL:
+// the model is disabled or doesn't have two samples yet, a time domain it can't answer is requested, or the answer
+// would deviate too much.
+bool TimestampCalibrator::Predict(
+    uint32_t                            timestampCount,
+    const VkCalibratedTimestampInfoEXT* pTimestampInfos,
+    uint64_t*                           pTimestamps,
+    uint64_t*                           pMaxDeviation)
+{
+    bool predicted = m_enabled;
+
+    for (uint32_t i = 0; predicted && (i < timestampCount); ++i)
+    {
+        predicted = (pTimestampInfos[i].timeDomain == VK_TIME_DOMAIN_DEVICE_EXT)          ||
+                    (pTimestampInfos[i].timeDomain == VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT) ||
+                    (pTimestampInfos[i].timeDomain == VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_EXT);
+    }
+
+    if (predicted)
+    {
+        // The device timestamp is extrapolated to the first raw reading; the window of the readings adds to the
+        // deviation.
+        const uint64_t rawNs     = ReadClockNs(CLOCK_MONOTONIC_RAW);
+        const uint64_t monoNs    = ReadClockNs(CLOCK_MONOTONIC);
+        const uint64_t rawEndNs  = ReadClockNs(CLOCK_MONOTONIC_RAW);
+
+        Util::MutexAuto lock(&m_lock);
+
+        predicted = (m_sampleCount >= 2);
+
+        if (predicted)
+        {
+            const int64_t elapsedNs   = static_cast<int64_t>(rawNs - m_anchor.rawNs);
+            const double  distanceNs  = fabs(static_cast<double>(elapsedNs));
+            const double  deviationNs = static_cast<double>(m_anchor.deviation + (rawEndNs - rawNs)) +
+                                        (distanceNs * m_rateError);
+
+            const double deviationLimit = static_cast<double>(Util::Max(2 * m_anchor.deviation, static_cast<uint64_t>(MinDeviationLimit)));
+
+            predicted = (distanceNs < static_cast<double>(m_resampleNs)) && (deviationNs <= deviationLimit);
+
+            if (predicted)
+            {
+                const uint64_t gpuTicks = m_anchor.gpuTicks +
+                                          static_cast<int64_t>(static_cast<double>(elapsedNs) * m_ticksPerNs);
+
+                for (uint32_t i = 0; i < timestampCount; ++i)
+                {
+                    switch (pTimestampInfos[i].timeDomain)
+                    {
+                    case VK_TIME_DOMAIN_DEVICE_EXT:
+                        pTimestamps[i] = gpuTicks;
+                        break;
+                    case VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT:
+                        pTimestamps[i] = monoNs;
+                        break;
+                    default:
+                        pTimestamps[i] = rawNs;
+                        break;
+                    }
+                }
+
+                *pMaxDeviation = static_cast<uint64_t>(ceil(deviationNs));
+            }
+        }
+    }
+
+    return predicted;
+}
+
+// =====================================================================================================================
+// Refits the model with a calibration queried from PAL.
+void TimestampCalibrator::AddSample(
+    const Pal::CalibratedTimestamps& calibration)
+{
+    if (m_enabled)
+    {
+        Sample sample = {};
+        sample.rawNs     = calibration.cpuClockMonotonicRawTimestamp;
+        sample.gpuTicks  = calibration.gpuTimestamp;
+        sample.deviation = calibration.maxDeviation + m_tickNs;
+
+        Util::MutexAuto lock(&m_lock);
+
+        if (m_sampleCount == 0)
+        {
+            m_base        = sample;
+            m_anchor      = sample;
+            m_sampleCount = 1;
+        }
+        else if (sample.rawNs > m_anchor.rawNs)
+        {
+            const double elapsedNs = static_cast<double>(sample.rawNs - m_anchor.rawNs);
+
+            bool consistent = (sample.gpuTicks > m_anchor.gpuTicks);
+
+            if (consistent && (m_sampleCount >= 2))
+            {
+                // Predictions were reported with this deviation, so a sample outside of it means the device timestamp
+                // jumped or changed its rate.
+                const double predictedTicks = static_cast<double>(m_anchor.gpuTicks) + (elapsedNs * m_ticksPerNs);
+                const double errorNs        = fabs(static_cast<double>(sample.gpuTicks) - predictedTicks) /
+                                              m_nominalTicksPerNs;
+
+                consistent = (errorNs <= (static_cast<double>(m_anchor.deviation + sample.deviation) +
+                                          (elapsedNs * m_rateError)));
+            }
+
+            if (consistent)
+            {
+                // A longer baseline measures the rate more precisely, but follows slow drift of it later
+                if ((sample.rawNs - m_base.rawNs) > (MaxBaselineFactor * m_resampleNs))
+                {
+                    m_base = m_anchor;
+                }
+
+                m_anchor = sample;
+
+                const double baselineNs = static_cast<double>(m_anchor.rawNs - m_base.rawNs);
+
+                m_ticksPerNs  = static_cast<double>(m_anchor.gpuTicks - m_base.gpuTicks) / baselineNs;
+                m_rateError   = static_cast<double>(m_anchor.deviation + m_base.deviation) / baselineNs;
+                m_sampleCount = Util::Min(m_sampleCount + 1, 2u);
+            }
+            else
+            {
+                m_base        = sample;
+                m_anchor      = sample;
+                m_sampleCount = 1;
+            }
+        }
+    }
+}
+
+} // namespace vk
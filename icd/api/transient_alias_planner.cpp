@@ -0,0 +1,649 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  transient_alias_planner.cpp
+* @brief Implementation of the memory sharing between transient attachments with disjoint lifetimes.
+***********************************************************************************************************************
+*/
+
+#include "include/transient_alias_planner.h"
+#include "include/vk_device.h"
+#include "include/vk_framebuffer.h"
+#include "include/vk_image.h"
+#include "include/vk_instance.h"
+#include "include/vk_memory.h"
+#include "include/vk_physical_device.h"
+#include "include/vk_render_pass.h"
+
+#include "palQueue.h"
+#include "palVectorImpl.h"
+
+#include <algorithm>
+
+namespace vk
+{
+
+// =====================================================================================================================
+// Returns true if physical memory created for one binding can back the other's range as well.
+static bool AreHeapsCompatible(
+    const Pal::GpuMemoryCreateInfo& lhs,
+    const Pal::GpuMemoryCreateInfo& rhs)
+{
+    return (lhs.heapCount == rhs.heapCount) &&
+           (memcmp(lhs.heaps, rhs.heaps, sizeof(lhs.heaps[0]) * lhs.heapCount) == 0);
+}
+
+// =====================================================================================================================
+TransientAliasPlanner::TransientAliasPlanner(
+    Device* pDevice)
+    :
+    m_pDevice(pDevice),
+    m_enabled(false),
+    m_accessMode(Pal::VirtualGpuMemAccessMode::Undefined),
+    m_bindings(pDevice->VkInstance()->Allocator()),
+    m_hasPendingRemaps(false)
+{
+}
+
+// =====================================================================================================================
+// Remapping is a queue operation, so it is only ordered against the rendering that uses the memory if all of that
+// rendering happens on one queue.
+void TransientAliasPlanner::Init(
+    uint32_t universalQueueCount)
+{
+    m_enabled = m_pDevice->GetRuntimeSettings().enableTransientAttachmentAliasing              &&
+                m_pDevice->VkPhysicalDevice(DefaultDeviceIndex)->IsVirtualRemappingSupported() &&
+                (m_pDevice->NumPalDevices() == 1)                                              &&
+                (universalQueueCount == 1);
+
+    if (m_pDevice->GetPrtFeatures() & Pal::PrtFeatureStrictNull)
+    {
+        m_accessMode = Pal::VirtualGpuMemAccessMode::ReadZero;
+    }
+}
+
+// =====================================================================================================================
+// Frees the physical memory of allocations the application didn't free before destroying the device.
+void TransientAliasPlanner::Destroy()
+{
+    for (uint32_t i = 0; i < m_bindings.NumElements(); ++i)
+    {
+        Binding* pBinding = m_bindings.At(i);
+
+        ReleaseSlot(pBinding->pSlot);
+        ReleaseSlot(pBinding->pPrevSlot);
+
+        m_pDevice->VkInstance()->FreeMem(pBinding);
+    }
+
+    m_bindings.Clear();
+
+    m_enabled = false;
+}
+
+// =====================================================================================================================
+// Returns true if a dedicated allocation for the given image should be made aliasable.
+bool TransientAliasPlanner::IsCandidate(
+    const Image* pImage
+    ) const
+{
+    return m_enabled                                                                 &&
+           ((pImage->GetImageUsage() & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0) &&
+           (pImage->IsSparse() == false)                                             &&
+           (pImage->IsPresentable() == false);
+}
+
+// =====================================================================================================================
+// Starts tracking the virtual range of a dedicated allocation.  Physical memory for the range is created the way it
+// would have been for the allocation itself.
+VkResult TransientAliasPlanner::RegisterMemory(
+    const Memory*                   pMemory,
+    Pal::IGpuMemory*                pVirtualGpuMem,
+    const Pal::GpuMemoryCreateInfo& createInfo)
+{
+    VkResult result = VK_SUCCESS;
+
+    Binding* pBinding = static_cast<Binding*>(m_pDevice->VkInstance()->AllocMem(
+        sizeof(Binding), VK_DEFAULT_MEM_ALIGN, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE));
+
+    if (pBinding != nullptr)
+    {
+        memset(pBinding, 0, sizeof(*pBinding));
+
+        pBinding->pMemory        = pMemory;
+        pBinding->pVirtualGpuMem = pVirtualGpuMem;
+        pBinding->createInfo     = createInfo;
+
+        Util::MutexAuto lock(&m_lock);
+
+        if (m_bindings.PushBack(pBinding) != Pal::Result::Success)
+        {
+            m_pDevice->VkInstance()->FreeMem(pBinding);
+
+            result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+    else
+    {
+        result = VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Stops tracking a freed allocation.  The application guarantees that no submitted work accesses the memory anymore,
+// so slots that only this binding referenced can be freed right away.
+void TransientAliasPlanner::ReleaseMemory(
+    const Memory* pMemory)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    const uint32_t index = FindBindingIndex(pMemory);
+
+    if (index != UINT32_MAX)
+    {
+        Binding* pBinding = m_bindings.At(index);
+
+        ReleaseSlot(pBinding->pSlot);
+        ReleaseSlot(pBinding->pPrevSlot);
+
+        m_bindings.At(index) = m_bindings.At(m_bindings.NumElements() - 1);
+        m_bindings.PopBack(nullptr);
+
+        m_pDevice->VkInstance()->FreeMem(pBinding);
+    }
+}
+
+// =====================================================================================================================
+void TransientAliasPlanner::BindImage(
+    const Memory* pMemory,
+    const Image*  pImage)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    const uint32_t index = FindBindingIndex(pMemory);
+
+    if (index != UINT32_MAX)
+    {
+        m_bindings.At(index)->pImage = pImage;
+    }
+}
+
+// =====================================================================================================================
+void TransientAliasPlanner::ReleaseImageBinding(
+    const Image* pImage)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    Binding* pBinding = FindBinding(pImage);
+
+    if (pBinding != nullptr)
+    {
+        pBinding->pImage = nullptr;
+    }
+}
+
+// =====================================================================================================================
+TransientAliasPlanner::Binding* TransientAliasPlanner::FindBinding(
+    const Image* pImage
+    ) const
+{
+    Binding* pBinding = nullptr;
+
+    for (uint32_t i = 0; (i < m_bindings.NumElements()) && (pBinding == nullptr); ++i)
+    {
+        if (m_bindings.At(i)->pImage == pImage)
+        {
+            pBinding = m_bindings.At(i);
+        }
+    }
+
+    return pBinding;
+}
+
+// =====================================================================================================================
+uint32_t TransientAliasPlanner::FindBindingIndex(
+    const Memory* pMemory
+    ) const
+{
+    uint32_t index = UINT32_MAX;
+
+    for (uint32_t i = 0; (i < m_bindings.NumElements()) && (index == UINT32_MAX); ++i)
+    {
+        if (m_bindings.At(i)->pMemory == pMemory)
+        {
+            index = i;
+        }
+    }
+
+    return index;
+}
+
+// =====================================================================================================================
+// Creates physical memory of the given size in the heaps of a binding.  The memory is never sub-allocated so that it
+// starts at a page boundary.
+VkResult TransientAliasPlanner::CreateSlot(
+    const Binding& binding,
+    Pal::gpusize   size,
+    Slot**         ppSlot)
+{
+    VkResult result = VK_SUCCESS;
+
+    void* pSlotMem = m_pDevice->VkInstance()->AllocMem(
+        sizeof(Slot), VK_DEFAULT_MEM_ALIGN, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+    if (pSlotMem != nullptr)
+    {
+        Slot* pSlot = VK_PLACEMENT_NEW(pSlotMem) Slot();
+
+        InternalMemCreateInfo createInfo = {};
+
+        createInfo.pal                   = binding.createInfo;
+        createInfo.pal.size              = size;
+        createInfo.flags.noSuballocation = 1;
+
+        result = m_pDevice->MemMgr()->AllocGpuMem(createInfo, &pSlot->memory, 1 << DefaultDeviceIndex);
+
+        if (result == VK_SUCCESS)
+        {
+            pSlot->size     = size;
+            pSlot->refCount = 0;
+
+            *ppSlot = pSlot;
+        }
+        else
+        {
+            m_pDevice->VkInstance()->FreeMem(pSlotMem);
+        }
+    }
+    else
+    {
+        result = VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+void TransientAliasPlanner::ReleaseSlot(
+    Slot* pSlot)
+{
+    if (pSlot != nullptr)
+    {
+        VK_ASSERT(pSlot->refCount > 0);
+
+        if (--pSlot->refCount == 0)
+        {
+            m_pDevice->MemMgr()->FreeGpuMem(&pSlot->memory);
+
+            Util::Destructor(pSlot);
+
+            m_pDevice->VkInstance()->FreeMem(pSlot);
+        }
+    }
+}
+
+// =====================================================================================================================
+void TransientAliasPlanner::AssignSlot(
+    Binding* pBinding,
+    Slot*    pSlot,
+    bool     shared)
+{
+    pSlot->refCount++;
+
+    pBinding->pSlot        = pSlot;
+    pBinding->shared       = shared;
+    pBinding->remapPending = true;
+
+    m_hasPendingRemaps.store(true, std::memory_order_release);
+}
+
+// =====================================================================================================================
+// Moves a binding to physical memory of its own, unless it already has that.  The shared slot it leaves is kept
+// referenced for the work which was submitted before the move.
+VkResult TransientAliasPlanner::MakeBindingPrivate(
+    Binding* pBinding)
+{
+    VkResult result = VK_SUCCESS;
+
+    if ((pBinding->pSlot == nullptr) || pBinding->shared)
+    {
+        Slot* pSlot = nullptr;
+
+        result = CreateSlot(*pBinding, pBinding->createInfo.size, &pSlot);
+
+        if (result == VK_SUCCESS)
+        {
+            // Private bindings are never shared again, so a binding leaves at most one shared slot behind.
+            VK_ASSERT(pBinding->pPrevSlot == nullptr);
+
+            pBinding->pPrevSlot = pBinding->pSlot;
+
+            AssignSlot(pBinding, pSlot, false);
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Moves the memory of an image to physical memory of its own, e.g. because its contents are expected to survive
+// beyond a render pass instance.
+VkResult TransientAliasPlanner::MakePrivate(
+    const Image* pImage)
+{
+    VkResult result = VK_SUCCESS;
+
+    if (m_enabled)
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        Binding* pBinding = FindBinding(pImage);
+
+        if (pBinding != nullptr)
+        {
+            result = MakeBindingPrivate(pBinding);
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Returns true if another attachment of the render pass is mapped to the given slot, or is about to be placed in the
+// given new slot, while the entry at entryIndex is in use.
+bool TransientAliasPlanner::IsUsedDuring(
+    const PlanEntry* pEntries,
+    uint32_t         entryCount,
+    uint32_t         entryIndex,
+    const Slot*      pSlot,
+    uint32_t         group
+    ) const
+{
+    const PlanEntry& entry = pEntries[entryIndex];
+
+    bool used = false;
+
+    for (uint32_t i = 0; (i < entryCount) && (used == false); ++i)
+    {
+        const PlanEntry& other = pEntries[i];
+
+        if ((i != entryIndex) &&
+            (((pSlot != nullptr) && (other.pBinding->pSlot == pSlot)) ||
+             ((group != NoGroup) && (other.group == group))))
+        {
+            used = (other.firstUseSubpass <= entry.finalUseSubpass) &&
+                   (entry.firstUseSubpass <= other.finalUseSubpass);
+        }
+    }
+
+    return used;
+}
+
+// =====================================================================================================================
+// Places the aliasable attachments of a render pass in shared slots.  Attachments which already share a slot with an
+// attachment alive at the same time are moved out of it.  The others are placed, in order of first use, in an existing
+// shared slot that is large enough and free for their lifetime, or else share a new slot with other attachments of the
+// render pass.
+VkResult TransientAliasPlanner::PlanEntries(
+    PlanEntry* pEntries,
+    uint32_t   entryCount)
+{
+    VkResult result = VK_SUCCESS;
+
+    std::stable_sort(pEntries, pEntries + entryCount,
+        [](const PlanEntry& lhs, const PlanEntry& rhs)
+        {
+            return lhs.firstUseSubpass < rhs.firstUseSubpass;
+        });
+
+    for (uint32_t i = 0; (i < entryCount) && (result == VK_SUCCESS); ++i)
+    {
+        Binding* pBinding = pEntries[i].pBinding;
+
+        if (pBinding->shared && IsUsedDuring(pEntries, i, i, pBinding->pSlot, NoGroup))
+        {
+            result = MakeBindingPrivate(pBinding);
+        }
+    }
+
+    Pal::gpusize groupSizes[MaxPlannedAttachments];
+    uint32_t     groupFirstEntry[MaxPlannedAttachments];
+    uint32_t     groupCount = 0;
+
+    for (uint32_t i = 0; (i < entryCount) && (result == VK_SUCCESS); ++i)
+    {
+        Binding* pBinding = pEntries[i].pBinding;
+
+        if (pBinding->pSlot == nullptr)
+        {
+            Slot* pTarget = nullptr;
+
+            for (uint32_t b = 0; (b < m_bindings.NumElements()) && (pTarget == nullptr); ++b)
+            {
+                const Binding* pOther = m_bindings.At(b);
+
+                if (pOther->shared                                                   &&
+                    (pOther->pSlot->size >= pBinding->createInfo.size)               &&
+                    AreHeapsCompatible(pOther->createInfo, pBinding->createInfo)     &&
+                    (IsUsedDuring(pEntries, entryCount, i, pOther->pSlot, NoGroup) == false))
+                {
+                    pTarget = pOther->pSlot;
+                }
+            }
+
+            if (pTarget != nullptr)
+            {
+                AssignSlot(pBinding, pTarget, true);
+            }
+            else
+            {
+                uint32_t group = NoGroup;
+
+                for (uint32_t g = 0; (g < groupCount) && (group == NoGroup); ++g)
+                {
+                    if (AreHeapsCompatible(pEntries[groupFirstEntry[g]].pBinding->createInfo, pBinding->createInfo) &&
+                        (IsUsedDuring(pEntries, entryCount, i, nullptr, g) == false))
+                    {
+                        group = g;
+                    }
+                }
+
+                if (group == NoGroup)
+                {
+                    group = groupCount++;
+
+                    groupSizes[group]      = 0;
+                    groupFirstEntry[group] = i;
+                }
+
+                groupSizes[group] = Util::Max(groupSizes[group], pBinding->createInfo.size);
+                pEntries[i].group = group;
+            }
+        }
+    }
+
+    for (uint32_t g = 0; (g < groupCount) && (result == VK_SUCCESS); ++g)
+    {
+        Slot* pSlot = nullptr;
+
+        result = CreateSlot(*pEntries[groupFirstEntry[g]].pBinding, groupSizes[g], &pSlot);
+
+        for (uint32_t i = 0; (i < entryCount) && (result == VK_SUCCESS); ++i)
+        {
+            if (pEntries[i].group == g)
+            {
+                AssignSlot(pEntries[i].pBinding, pSlot, true);
+            }
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Plans the memory of the transient attachments of a framebuffer for use with the given render pass.  Reports whether
+// any of them ends up in memory that other attachments may share.
+VkResult TransientAliasPlanner::Plan(
+    const RenderPass*  pRenderPass,
+    const Framebuffer* pFramebuffer,
+    bool*              pHasAliasedAttachments)
+{
+    VkResult result = VK_SUCCESS;
+
+    *pHasAliasedAttachments = false;
+
+    if (m_enabled)
+    {
+        const RPAttachmentLifetime* pLifetimes      = pRenderPass->GetExecuteInfo()->pAttachmentLifetimes;
+        const uint32_t              attachmentCount = Util::Min(pRenderPass->GetAttachmentCount(),
+                                                                pFramebuffer->GetAttachmentCount());
+
+        PlanEntry entries[MaxPlannedAttachments];
+        uint32_t  entryCount = 0;
+
+        Util::MutexAuto lock(&m_lock);
+
+        for (uint32_t a = 0; (a < attachmentCount) && (result == VK_SUCCESS); ++a)
+        {
+            const Image*                pImage   = pFramebuffer->GetAttachment(a).pImage;
+            const RPAttachmentLifetime& lifetime = pLifetimes[a];
+
+            Binding* pBinding = nullptr;
+
+            if ((pImage != nullptr) && pImage->IsTransientAliasBound())
+            {
+                pBinding = FindBinding(pImage);
+            }
+
+            // Unused attachments don't constrain the plan, and bindings made private stay private.
+            if ((pBinding != nullptr)                                   &&
+                (lifetime.firstUseSubpass != VK_SUBPASS_EXTERNAL)       &&
+                ((pBinding->pSlot == nullptr) || pBinding->shared))
+            {
+                // Several attachments may be views of the same image.
+                uint32_t entry = 0;
+
+                while ((entry < entryCount) && (entries[entry].pBinding != pBinding))
+                {
+                    entry++;
+                }
+
+                if (lifetime.aliasable == false)
+                {
+                    result = MakeBindingPrivate(pBinding);
+                }
+                else if (entry < entryCount)
+                {
+                    PlanEntry* pEntry = &entries[entry];
+
+                    pEntry->firstUseSubpass = Util::Min(pEntry->firstUseSubpass, lifetime.firstUseSubpass);
+                    pEntry->finalUseSubpass = Util::Max(pEntry->finalUseSubpass, lifetime.finalUseSubpass);
+                }
+                else if (entryCount < MaxPlannedAttachments)
+                {
+                    entries[entryCount].pBinding        = pBinding;
+                    entries[entryCount].firstUseSubpass = lifetime.firstUseSubpass;
+                    entries[entryCount].finalUseSubpass = lifetime.finalUseSubpass;
+                    entries[entryCount].group           = NoGroup;
+
+                    entryCount++;
+                }
+                else
+                {
+                    result = MakeBindingPrivate(pBinding);
+                }
+            }
+        }
+
+        if (result == VK_SUCCESS)
+        {
+            result = PlanEntries(entries, entryCount);
+        }
+
+        for (uint32_t i = 0; i < entryCount; ++i)
+        {
+            *pHasAliasedAttachments |= entries[i].pBinding->shared;
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Maps the ranges of bindings moved to another slot to their new memory.  The remaps are queued ahead of the
+// submission that follows, so they take effect after all work submitted before on the same queue.
+VkResult TransientAliasPlanner::CommitPending(
+    Pal::IQueue* pPalQueue)
+{
+    Pal::Result palResult = Pal::Result::Success;
+
+    Pal::VirtualMemoryRemapRange ranges[RemapBatchSize];
+    Binding*                     pBatch[RemapBatchSize];
+    uint32_t                     rangeCount = 0;
+
+    Util::MutexAuto lock(&m_lock);
+
+    const uint32_t bindingCount = m_bindings.NumElements();
+
+    for (uint32_t i = 0; (i < bindingCount) && (palResult == Pal::Result::Success); ++i)
+    {
+        Binding* pBinding = m_bindings.At(i);
+
+        if (pBinding->remapPending)
+        {
+            Pal::VirtualMemoryRemapRange* pRange = &ranges[rangeCount];
+
+            pRange->pVirtualGpuMem     = pBinding->pVirtualGpuMem;
+            pRange->virtualStartOffset = 0;
+            pRange->pRealGpuMem        = pBinding->pSlot->memory.PalMemory(DefaultDeviceIndex);
+            pRange->realStartOffset    = pBinding->pSlot->memory.Offset();
+            pRange->size               = pBinding->createInfo.size;
+            pRange->virtualAccessMode  = m_accessMode;
+
+            pBatch[rangeCount++] = pBinding;
+        }
+
+        if ((rangeCount == RemapBatchSize) || ((rangeCount > 0) && (i == (bindingCount - 1))))
+        {
+            palResult = pPalQueue->RemapVirtualMemoryPages(rangeCount, ranges, true, nullptr);
+
+            for (uint32_t r = 0; (r < rangeCount) && (palResult == Pal::Result::Success); ++r)
+            {
+                pBatch[r]->remapPending = false;
+            }
+
+            rangeCount = 0;
+        }
+    }
+
+    m_hasPendingRemaps.store(palResult != Pal::Result::Success, std::memory_order_release);
+
+    return PalToVkResult(palResult);
+}
+
+} // namespace vk
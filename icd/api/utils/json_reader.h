@@ -42,6 +42,8 @@ class Instance;
 namespace utils
 {
 
+struct TempMemArena;
+
 // List of valid JSON value types
 enum class JsonValueType
 {
@@ -81,6 +83,10 @@ struct JsonSettings
 // Parse a JSON string from a buffer into a tree of Json nodes.
 extern Json* JsonParse(const JsonSettings& settings, const void* pJson, size_t sz);
 
+// Parse a JSON string in place.  Keys and string values point into the buffer, which is modified and must outlive the
+// returned tree.  All nodes are allocated from the arena and are released with it; JsonDestroy() must not be called.
+extern Json* JsonParseInSitu(TempMemArena* pArena, void* pJson, size_t sz);
+
 // Destroy a tree of JSON nodes.
 extern void JsonDestroy(const JsonSettings& settings, Json* pJson);
 
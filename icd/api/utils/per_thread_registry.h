@@ -0,0 +1,237 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+**************************************************************************************************
+* @file  per_thread_registry.h
+* @brief A registry of one object per thread, found through a thread-local cache without locking.
+**************************************************************************************************
+*/
+#ifndef __UTILS_PER_THREAD_REGISTRY_H__
+#define __UTILS_PER_THREAD_REGISTRY_H__
+#pragma once
+
+#include "include/khronos/vulkan.h"
+#include "include/vk_utils.h"
+
+#include "palMutex.h"
+
+#include <atomic>
+
+namespace vk
+{
+
+namespace utils
+{
+
+// =====================================================================================================================
+// Holds one T for every thread that asked for one, e.g. the event rings or counters a thread records into without
+// locking.  The calling thread's object is found through a thread-local cache of the registry it used last, so the
+// lock is only taken on a thread's first Get() and whenever it switches between registries.  Objects are only ever
+// added at the head of the list, so ForEach() can walk it while other threads add theirs.  A finished thread's object
+// stays in the list and is handed to the next thread which gets the same thread-local storage.
+template <typename T>
+class PerThreadRegistry
+{
+public:
+    PerThreadRegistry(const VkAllocationCallbacks* pAllocator, VkSystemAllocationScope allocScope);
+    ~PerThreadRegistry() { Reset(); }
+
+    // Returns the calling thread's object, creating it and calling init(T*) on it under the lock the first time.
+    // Returns null if out of memory.
+    template <typename InitFunc>
+    VK_FORCEINLINE T* Get(InitFunc init)
+        { return (s_threadCache.registryId == m_id) ? s_threadCache.pData : Add(init); }
+
+    // Calls func(T*) for every object
+    template <typename Func>
+    void ForEach(Func func);
+
+    template <typename Func>
+    void ForEach(Func func) const;
+
+    // Destroys all objects.  No thread may call Get() or ForEach() at the same time.
+    void Reset();
+
+private:
+    PAL_DISALLOW_DEFAULT_CTOR(PerThreadRegistry);
+    PAL_DISALLOW_COPY_AND_ASSIGN(PerThreadRegistry);
+
+    struct Node
+    {
+        const void* pThreadKey; // Identifies the owning thread
+        Node*       pNext;
+        T           data;
+    };
+
+    // The object the thread got last
+    struct ThreadCache
+    {
+        uint64_t registryId;    // Registry the object belongs to
+        T*       pData;
+    };
+
+    static thread_local ThreadCache s_threadCache;
+    static std::atomic<uint64_t>    s_nextId;
+
+    template <typename InitFunc>
+    T* Add(InitFunc init);
+
+    Node* GetFirstNode() const;
+
+    const VkAllocationCallbacks* const m_pAllocator;
+    const VkSystemAllocationScope      m_allocScope;
+    uint64_t                           m_id;         // Tells the thread caches of different registries apart
+    mutable Util::Mutex                m_lock;       // Protects the list
+    Node*                              m_pFirstNode;
+};
+
+template <typename T>
+thread_local typename PerThreadRegistry<T>::ThreadCache PerThreadRegistry<T>::s_threadCache = {};
+
+template <typename T>
+std::atomic<uint64_t> PerThreadRegistry<T>::s_nextId(1);
+
+// =====================================================================================================================
+template <typename T>
+PerThreadRegistry<T>::PerThreadRegistry(
+    const VkAllocationCallbacks* pAllocator,
+    VkSystemAllocationScope      allocScope)
+    :
+    m_pAllocator(pAllocator),
+    m_allocScope(allocScope),
+    m_id(s_nextId.fetch_add(1, std::memory_order_relaxed)),
+    m_pFirstNode(nullptr)
+{
+}
+
+// =====================================================================================================================
+// Slow path of Get(): finds the object a thread with the same thread-local storage left behind, or creates one.
+template <typename T>
+template <typename InitFunc>
+T* PerThreadRegistry<T>::Add(
+    InitFunc init)
+{
+    // The address of the thread cache is unique among running threads
+    const void* pThreadKey = &s_threadCache;
+
+    Util::MutexAuto lock(&m_lock);
+
+    Node* pNode = m_pFirstNode;
+
+    while ((pNode != nullptr) && (pNode->pThreadKey != pThreadKey))
+    {
+        pNode = pNode->pNext;
+    }
+
+    if (pNode == nullptr)
+    {
+        void* pMem = m_pAllocator->pfnAllocation(m_pAllocator->pUserData,
+                                                 sizeof(Node),
+                                                 VK_DEFAULT_MEM_ALIGN,
+                                                 m_allocScope);
+
+        if (pMem != nullptr)
+        {
+            pNode = VK_PLACEMENT_NEW(pMem) Node;
+
+            pNode->pThreadKey = pThreadKey;
+            pNode->pNext      = m_pFirstNode;
+
+            init(&pNode->data);
+
+            // ForEach() reads the list head under the lock, which publishes the initialized object
+            m_pFirstNode = pNode;
+        }
+    }
+
+    T* pData = nullptr;
+
+    if (pNode != nullptr)
+    {
+        pData = &pNode->data;
+
+        s_threadCache.registryId = m_id;
+        s_threadCache.pData      = pData;
+    }
+
+    return pData;
+}
+
+// =====================================================================================================================
+template <typename T>
+typename PerThreadRegistry<T>::Node* PerThreadRegistry<T>::GetFirstNode() const
+{
+    Util::MutexAuto lock(&m_lock);
+
+    return m_pFirstNode;
+}
+
+// =====================================================================================================================
+template <typename T>
+template <typename Func>
+void PerThreadRegistry<T>::ForEach(
+    Func func)
+{
+    for (Node* pNode = GetFirstNode(); pNode != nullptr; pNode = pNode->pNext)
+    {
+        func(&pNode->data);
+    }
+}
+
+// =====================================================================================================================
+template <typename T>
+template <typename Func>
+void PerThreadRegistry<T>::ForEach(
+    Func func) const
+{
+    for (const Node* pNode = GetFirstNode(); pNode != nullptr; pNode = pNode->pNext)
+    {
+        func(&pNode->data);
+    }
+}
+
+// =====================================================================================================================
+// Destroys all objects.  The registry takes a new id so that the thread caches still pointing at them miss.
+template <typename T>
+void PerThreadRegistry<T>::Reset()
+{
+    while (m_pFirstNode != nullptr)
+    {
+        Node* pNode = m_pFirstNode;
+
+        m_pFirstNode = pNode->pNext;
+
+        pNode->~Node();
+        m_pAllocator->pfnFree(m_pAllocator->pUserData, pNode);
+    }
+
+    m_id = s_nextId.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace utils
+
+} // namespace vk
+
+#endif /* __UTILS_PER_THREAD_REGISTRY_H__ */
@@ -25,6 +25,8 @@
 
 #include "temp_mem_arena.h"
 
+#include <atomic>
+
 namespace vk { namespace utils {
 
 // =====================================================================================================================
@@ -69,12 +71,48 @@ void TempMemArena::Reset()
         if (pChunk->pNext == nullptr)
         {
             pChunk->pNext = m_pFirstAvailableChunk;
+
+            m_pFirstAvailableChunk = m_pFirstUsedChunk;
+
+            pChunk = nullptr;
+        }
+        else
+        {
+            pChunk = pChunk->pNext;
         }
     }
 
-    m_pFirstAvailableChunk = m_pFirstUsedChunk;
-    m_pFirstUsedChunk      = nullptr;
-    m_totalMemSize         = 0;
+    m_pFirstUsedChunk = nullptr;
+    m_totalMemSize    = 0;
+}
+
+// =====================================================================================================================
+// Frees reset chunks until at most maxRetainedSize bytes of chunk capacity are left.  Must follow Reset().
+void TempMemArena::Trim(
+    size_t maxRetainedSize)
+{
+    VK_ASSERT(m_pFirstUsedChunk == nullptr);
+
+    size_t     retainedSize = 0;
+    MemChunk** ppLink       = &m_pFirstAvailableChunk;
+
+    while (*ppLink != nullptr)
+    {
+        MemChunk* pChunk = *ppLink;
+
+        if (retainedSize + pChunk->capacity <= maxRetainedSize)
+        {
+            retainedSize += pChunk->capacity;
+
+            ppLink = &pChunk->pNext;
+        }
+        else
+        {
+            *ppLink = pChunk->pNext;
+
+            m_allocator.pfnFree(m_allocator.pUserData, pChunk);
+        }
+    }
 }
 
 // =====================================================================================================================
@@ -187,30 +225,29 @@ void* TempMemArena::Alloc(size_t size)
 
     void* pData = nullptr;
 
-    MemChunk* pChunk = m_pFirstAvailableChunk;
+    MemChunk** ppLink = &m_pFirstAvailableChunk;
 
-    while ((pChunk != nullptr) && (pData == nullptr))
+    while ((*ppLink != nullptr) && (pData == nullptr))
     {
+        MemChunk* pChunk = *ppLink;
+
         pData = AllocFromChunk(pChunk, size);
 
         if (pData == nullptr)
         {
-            MemChunk* pNext = pChunk->pNext;
-
             // If we are getting close to the end of this chunk
             if ((size <= pChunk->capacity) && (pChunk->capacity - pChunk->tail < pChunk->capacity / 4))
             {
-                // Pop it from the available list and into the used list
+                // Unlink it from the available list and push it onto the used list
+                *ppLink = pChunk->pNext;
+
                 pChunk->pNext     = m_pFirstUsedChunk;
                 m_pFirstUsedChunk = pChunk;
-
-                if (pChunk == m_pFirstAvailableChunk)
-                {
-                    m_pFirstAvailableChunk = nullptr;
-                }
             }
-
-            pChunk = pNext;
+            else
+            {
+                ppLink = &pChunk->pNext;
+            }
         }
     }
 
@@ -301,4 +338,112 @@ void* TempMemArena::AllocFromNewChunk(size_t size)
     return pData;
 }
 
+// =====================================================================================================================
+thread_local TempMemArenaPool::ThreadCache TempMemArenaPool::s_threadCache = {};
+
+static std::atomic<uint64_t> s_nextPoolId(1);
+
+// =====================================================================================================================
+TempMemArenaPool::TempMemArenaPool(
+    const VkAllocationCallbacks* pAllocator)
+    :
+    m_pAllocator(pAllocator),
+    m_id(s_nextPoolId.fetch_add(1, std::memory_order_relaxed)),
+    m_pFirstCreated(nullptr),
+    m_pFirstFree(nullptr)
+{
+
+}
+
+// =====================================================================================================================
+// Frees every arena the pool created.  Arenas still cached by other threads are told apart by the pool ID and are never
+// used again.  No arena may be in use.
+void TempMemArenaPool::Destroy()
+{
+    if (s_threadCache.poolId == m_id)
+    {
+        s_threadCache.pArena = nullptr;
+    }
+
+    while (m_pFirstCreated != nullptr)
+    {
+        PooledArena* pArena = m_pFirstCreated;
+
+        m_pFirstCreated = pArena->pNextCreated;
+
+        Util::Destructor(pArena);
+
+        m_pAllocator->pfnFree(m_pAllocator->pUserData, pArena);
+    }
+
+    m_pFirstFree = nullptr;
+}
+
+// =====================================================================================================================
+// Returns an empty arena: the one this thread released last, then any free one; otherwise a new one.  Returns null if
+// out of memory.
+TempMemArena* TempMemArenaPool::Acquire()
+{
+    PooledArena* pArena = nullptr;
+
+    if ((s_threadCache.poolId == m_id) && (s_threadCache.pArena != nullptr))
+    {
+        pArena = s_threadCache.pArena;
+
+        s_threadCache.pArena = nullptr;
+    }
+    else
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        if (m_pFirstFree != nullptr)
+        {
+            pArena = m_pFirstFree;
+
+            m_pFirstFree = pArena->pNextFree;
+        }
+        else
+        {
+            void* pMemory = m_pAllocator->pfnAllocation(
+                m_pAllocator->pUserData, sizeof(PooledArena), VK_DEFAULT_MEM_ALIGN, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+            if (pMemory != nullptr)
+            {
+                pArena = VK_PLACEMENT_NEW(pMemory) PooledArena(m_pAllocator);
+
+                pArena->pNextCreated = m_pFirstCreated;
+                m_pFirstCreated      = pArena;
+            }
+        }
+    }
+
+    return pArena;
+}
+
+// =====================================================================================================================
+// Resets an arena and hands it back to the pool, trimming its retained chunks to the high-water cap.
+void TempMemArenaPool::Release(
+    TempMemArena* pArena)
+{
+    PooledArena* pPooledArena = static_cast<PooledArena*>(pArena);
+
+    pPooledArena->Reset();
+    pPooledArena->Trim(MaxRetainedSize);
+
+    // Keep the arena for this thread's next acquire.  An arena cached for another pool is simply dropped from the
+    // cache; that pool still owns and frees it.
+    if ((s_threadCache.poolId != m_id) || (s_threadCache.pArena == nullptr))
+    {
+        s_threadCache.poolId = m_id;
+        s_threadCache.pArena = pPooledArena;
+    }
+    else
+    {
+        Util::MutexAuto lock(&m_lock);
+
+        pPooledArena->pNextFree = m_pFirstFree;
+        m_pFirstFree            = pPooledArena;
+    }
+}
+
 }; };
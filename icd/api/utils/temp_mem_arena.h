@@ -35,6 +35,7 @@
 #include "include/khronos/vulkan.h"
 #include "include/vk_utils.h"
 
+#include "palMutex.h"
 #include "palSysMemory.h"
 
 namespace vk
@@ -58,6 +59,7 @@ struct TempMemArena
     void* Alloc(const Util::AllocInfo& allocInfo);
     void  Free(const Util::FreeInfo& freeInfo);
     void  Reset();
+    void  Trim(size_t maxRetainedSize);
     size_t GetTotalAllocated() const { return m_totalMemSize; }
 
 private:
@@ -105,6 +107,51 @@ private:
 #endif
 };
 
+// =====================================================================================================================
+// Keeps reset TempMemArenas around so that short-lived users (e.g. render pass creation) stop allocating and freeing
+// their chunks every time.  Each thread caches the arena it released last; the others sit on a free list.  Arenas keep
+// at most MaxRetainedSize bytes of chunks while they are pooled, and are only freed with the pool.
+class TempMemArenaPool
+{
+public:
+    TempMemArenaPool(const VkAllocationCallbacks* pAllocator);
+
+    void Destroy();
+
+    TempMemArena* Acquire();
+    void Release(TempMemArena* pArena);
+
+private:
+    PAL_DISALLOW_COPY_AND_ASSIGN(TempMemArenaPool);
+
+    static constexpr size_t MaxRetainedSize = 1024 * 1024;
+
+    struct PooledArena : public TempMemArena
+    {
+        PooledArena(const VkAllocationCallbacks* pAllocator)
+            : TempMemArena(pAllocator, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE), pNextCreated(nullptr), pNextFree(nullptr)
+        {}
+
+        PooledArena* pNextCreated; // Next arena created by the pool
+        PooledArena* pNextFree;    // Next arena on the free list
+    };
+
+    // The arena a thread released last, if it hasn't acquired it again since
+    struct ThreadCache
+    {
+        uint64_t     poolId; // Pool the arena belongs to
+        PooledArena* pArena; // Cached arena, or null
+    };
+
+    static thread_local ThreadCache s_threadCache;
+
+    const VkAllocationCallbacks* m_pAllocator;     // Driver-owned allocation callbacks used for arenas and chunks
+    const uint64_t               m_id;             // Tells the thread caches of different pools apart
+    Util::Mutex                  m_lock;           // Protects the lists below
+    PooledArena*                 m_pFirstCreated;  // All arenas created by the pool
+    PooledArena*                 m_pFirstFree;     // Arenas not in use and not cached by a thread
+};
+
 };
 
 };
@@ -34,18 +34,34 @@
 #include "include/vk_conv.h"
 #include "include/vk_utils.h"
 
-#include "palIntrusiveListImpl.h"
-
 namespace vk
 {
 
 constexpr size_t MaxVirtualStackSize = 256 * 1024;  // 256 kilobytes
 
+// The allocator a thread released last, if it hasn't acquired it again since.
+struct VirtualStackCache
+{
+    uint64_t               mgrId;       // Manager the allocator belongs to
+    VirtualStackAllocator* pAllocator;  // Cached allocator, or null
+};
+
+static thread_local VirtualStackCache t_stackCache = {};
+
+static std::atomic<uint64_t> s_nextMgrId(1);
+
 // =====================================================================================================================
 VirtualStackMgr::VirtualStackMgr(
     Instance* pInstance)
-  : m_pInstance(pInstance)
+  : m_pInstance(pInstance),
+    m_id(s_nextMgrId.fetch_add(1, std::memory_order_relaxed)),
+    m_freeHead(0),
+    m_slotCount(0)
 {
+    for (uint32_t i = 0; i < MaxChunks; ++i)
+    {
+        m_pChunks[i].store(nullptr, std::memory_order_relaxed);
+    }
 }
 
 // =====================================================================================================================
@@ -88,19 +104,31 @@ Pal::Result VirtualStackMgr::Create(
 }
 
 // =====================================================================================================================
-// Tears down the virtual stack manager.
+// Tears down the virtual stack manager.  Frees every allocator it created, including the ones still cached by threads;
+// those caches are told apart by the manager ID and are never used again.
 void VirtualStackMgr::Destroy()
 {
+    if (t_stackCache.mgrId == m_id)
+    {
+        t_stackCache.pAllocator = nullptr;
+    }
+
     // Release all virtual stack allocators
-    while (m_stackList.IsEmpty() == false)
+    for (uint32_t slot = 0; slot < m_slotCount; ++slot)
     {
-        auto iter = m_stackList.Begin();
+        VirtualStackAllocator* pAllocator = GetSlot(slot);
 
-        VirtualStackAllocator* pAllocator = iter.Get();
+        PAL_DELETE(pAllocator, m_pInstance->Allocator());
+    }
 
-        m_stackList.Erase(&iter);
+    for (uint32_t i = 0; i < MaxChunks; ++i)
+    {
+        VirtualStackAllocator** pChunk = m_pChunks[i].load(std::memory_order_relaxed);
 
-        PAL_DELETE(pAllocator, m_pInstance->Allocator());
+        if (pChunk != nullptr)
+        {
+            m_pInstance->FreeMem(pChunk);
+        }
     }
 
     // Free the memory used by the object
@@ -113,26 +141,128 @@ void VirtualStackMgr::Destroy()
 Pal::Result VirtualStackMgr::AcquireAllocator(
     VirtualStackAllocator** ppAllocator)
 {
-    Util::MutexAuto lock(&m_lock);
-
     Pal::Result palResult = Pal::Result::Success;
 
-    // Reuse an existing allocator if possible; otherwise create a new one
-    if (m_stackList.IsEmpty() == false)
+    VirtualStackAllocator* pAllocator = nullptr;
+
+    // Take back the allocator this thread released last, then any free one; otherwise create a new one
+    if ((t_stackCache.mgrId == m_id) && (t_stackCache.pAllocator != nullptr))
     {
-        auto iter = m_stackList.Begin();
+        pAllocator = t_stackCache.pAllocator;
 
-        // Just return the first available stack allocator
-        *ppAllocator = iter.Get();
+        t_stackCache.pAllocator = nullptr;
+    }
+    else
+    {
+        pAllocator = PopFree();
+    }
 
-        // Remove the selected stack allocator from the list of the available ones
-        m_stackList.Erase(&iter);
+    if (pAllocator != nullptr)
+    {
+        *ppAllocator = pAllocator;
     }
     else
+    {
+        palResult = CreateAllocator(ppAllocator);
+    }
+
+    return palResult;
+}
+
+// =====================================================================================================================
+// Releases a virtual stack allocator.
+void VirtualStackMgr::ReleaseAllocator(
+    VirtualStackAllocator* pAllocator)
+{
+    VK_ASSERT(pAllocator != nullptr);
+
+    // Keep the allocator for this thread's next acquire.  An allocator cached for another manager is simply dropped
+    // from the cache; that manager still owns and frees it.
+    if ((t_stackCache.mgrId != m_id) || (t_stackCache.pAllocator == nullptr))
+    {
+        t_stackCache.mgrId      = m_id;
+        t_stackCache.pAllocator = pAllocator;
+    }
+    else
+    {
+        PushFree(pAllocator);
+    }
+}
+
+// =====================================================================================================================
+// Pops an allocator off the free stack.  Returns null if the stack is empty.
+VirtualStackAllocator* VirtualStackMgr::PopFree()
+{
+    VirtualStackAllocator* pAllocator = nullptr;
+
+    uint64_t head = m_freeHead.load(std::memory_order_acquire);
+
+    while (static_cast<uint32_t>(head) != 0)
+    {
+        pAllocator = GetSlot(static_cast<uint32_t>(head) - 1);
+
+        // Allocators are never freed before the manager, so reading the link is safe even if another thread popped
+        // this one in the meantime.  The counter makes the exchange fail then.
+        const uint64_t next = (((head >> 32) + 1) << 32) | pAllocator->m_nextFree.load(std::memory_order_relaxed);
+
+        if (m_freeHead.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            break;
+        }
+
+        pAllocator = nullptr;
+    }
+
+    return pAllocator;
+}
+
+// =====================================================================================================================
+// Pushes an allocator onto the free stack.
+void VirtualStackMgr::PushFree(
+    VirtualStackAllocator* pAllocator)
+{
+    uint64_t head = m_freeHead.load(std::memory_order_relaxed);
+    uint64_t next = 0;
+
+    do
+    {
+        pAllocator->m_nextFree.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+
+        next = (((head >> 32) + 1) << 32) | (pAllocator->m_slot + 1);
+    }
+    while (m_freeHead.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_relaxed) == false);
+}
+
+// =====================================================================================================================
+// Creates a new allocator in the next free slot of the table.
+Pal::Result VirtualStackMgr::CreateAllocator(
+    VirtualStackAllocator** ppAllocator)
+{
+    Util::MutexAuto lock(&m_lock);
+
+    Pal::Result palResult = Pal::Result::Success;
+
+    const uint32_t slot  = m_slotCount;
+    const uint32_t chunk = slot / SlotsPerChunk;
+
+    VirtualStackAllocator** pChunk = (chunk < MaxChunks) ? m_pChunks[chunk].load(std::memory_order_relaxed) : nullptr;
+
+    if ((chunk < MaxChunks) && (pChunk == nullptr))
+    {
+        pChunk = static_cast<VirtualStackAllocator**>(
+            m_pInstance->AllocMem(sizeof(VirtualStackAllocator*) * SlotsPerChunk, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT));
+
+        if (pChunk != nullptr)
+        {
+            m_pChunks[chunk].store(pChunk, std::memory_order_release);
+        }
+    }
+
+    if (pChunk != nullptr)
     {
         // Create a new stack allocator
         VirtualStackAllocator* pAllocator = PAL_NEW(VirtualStackAllocator,
-            m_pInstance->Allocator(), Util::AllocInternal) (MaxVirtualStackSize);
+            m_pInstance->Allocator(), Util::AllocInternal) (MaxVirtualStackSize, slot);
 
         if (pAllocator != nullptr)
         {
@@ -142,6 +272,10 @@ Pal::Result VirtualStackMgr::AcquireAllocator(
             if (palResult == Pal::Result::Success)
             {
                 // If the initialization is successful then return this object
+                pChunk[slot % SlotsPerChunk] = pAllocator;
+
+                m_slotCount = slot + 1;
+
                 *ppAllocator = pAllocator;
             }
             else
@@ -156,21 +290,12 @@ Pal::Result VirtualStackMgr::AcquireAllocator(
             palResult = Pal::Result::ErrorOutOfMemory;
         }
     }
+    else
+    {
+        palResult = Pal::Result::ErrorOutOfMemory;
+    }
 
     return palResult;
 }
 
-// =====================================================================================================================
-// Releases a virtual stack allocator.
-void VirtualStackMgr::ReleaseAllocator(
-    VirtualStackAllocator* pAllocator)
-{
-    Util::MutexAuto lock(&m_lock);
-
-    VK_ASSERT(pAllocator != nullptr);
-
-    // Simply put the allocator to the front of the list of available stack allocators
-    m_stackList.PushFront(pAllocator->GetNode());
-}
-
 } // namespace vk
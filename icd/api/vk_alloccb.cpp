@@ -34,7 +34,10 @@
 
 #include "palSysMemory.h"
 
+#include <atomic>
 #include <new>
+#include <stdlib.h>
+#include <string.h>
 
 #if defined(__unix__)
 #include <unistd.h>
@@ -136,6 +139,251 @@ extern const VkAllocationCallbacks g_DefaultAllocCallback =
     DefaultFreeNotification
 };
 
+// =====================================================================================================================
+// Thread-caching front end for the default callbacks.  Small allocations are rounded up to a size class and freed
+// blocks are kept on per-thread free lists for the next allocation of that class, so churn in hash map and list nodes
+// no longer reaches malloc.  Every block carries a header recording its class (or where the underlying allocation
+// starts for large and over-aligned blocks) and its scope.  Blocks are plain malloc memory, so a block freed on a
+// different thread than it was allocated on simply joins that thread's cache.
+
+constexpr size_t   BlockHeaderSize    = 16;         // Also the alignment every cached block is guaranteed
+constexpr uint32_t LargeSizeClass     = UINT32_MAX; // Header class of blocks which bypass the cache
+constexpr uint32_t MaxCachedPerClass  = 128;        // Blocks a thread keeps per size class before freeing them
+constexpr uint32_t StatsFlushInterval = 256;        // Allocations a thread counts before publishing its counters
+
+constexpr size_t SizeClasses[] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024 };
+
+constexpr uint32_t SizeClassCount = static_cast<uint32_t>(sizeof(SizeClasses) / sizeof(SizeClasses[0]));
+
+struct BlockHeader
+{
+    uint32_t sizeClass;  // Index into SizeClasses, or LargeSizeClass
+    uint32_t scope;      // VkSystemAllocationScope of the allocation
+    uint64_t baseOffset; // Distance from the start of the underlying allocation to the client pointer
+};
+
+static_assert(sizeof(BlockHeader) == BlockHeaderSize, "Block header must keep client pointers aligned");
+
+struct CachedBlock
+{
+    CachedBlock* pNext;
+};
+
+static std::atomic<uint64_t> s_scopeAllocCount[AllocScopeCount];
+static std::atomic<uint64_t> s_scopeFreeCount[AllocScopeCount];
+static std::atomic<uint64_t> s_scopeCachedAllocCount[AllocScopeCount];
+
+// Per-thread free lists and allocation counters
+struct ThreadAllocCache
+{
+    ThreadAllocCache() : alive(true), pendingAllocs(0)
+    {
+        memset(pFreeBlocks, 0, sizeof(pFreeBlocks));
+        memset(freeCount, 0, sizeof(freeCount));
+        memset(allocCount, 0, sizeof(allocCount));
+        memset(freeCountByScope, 0, sizeof(freeCountByScope));
+        memset(cachedAllocCount, 0, sizeof(cachedAllocCount));
+    }
+
+    ~ThreadAllocCache()
+    {
+        FlushStats();
+
+        for (uint32_t sizeClass = 0; sizeClass < SizeClassCount; ++sizeClass)
+        {
+            while (pFreeBlocks[sizeClass] != nullptr)
+            {
+                CachedBlock* pBlock = pFreeBlocks[sizeClass];
+
+                pFreeBlocks[sizeClass] = pBlock->pNext;
+
+                free(Util::VoidPtrDec(pBlock, BlockHeaderSize));
+            }
+        }
+
+        // Blocks freed by later thread-exit destructors go straight back to malloc
+        alive = false;
+    }
+
+    void FlushStats()
+    {
+        for (uint32_t scope = 0; scope < AllocScopeCount; ++scope)
+        {
+            s_scopeAllocCount[scope].fetch_add(allocCount[scope], std::memory_order_relaxed);
+            s_scopeFreeCount[scope].fetch_add(freeCountByScope[scope], std::memory_order_relaxed);
+            s_scopeCachedAllocCount[scope].fetch_add(cachedAllocCount[scope], std::memory_order_relaxed);
+
+            allocCount[scope]       = 0;
+            freeCountByScope[scope] = 0;
+            cachedAllocCount[scope] = 0;
+        }
+
+        pendingAllocs = 0;
+    }
+
+    bool         alive;
+    uint32_t     pendingAllocs;                     // Allocations counted since the last flush
+    CachedBlock* pFreeBlocks[SizeClassCount];       // Free blocks of each size class
+    uint32_t     freeCount[SizeClassCount];         // Length of each free list
+    uint64_t     allocCount[AllocScopeCount];       // Allocations per scope not yet published
+    uint64_t     freeCountByScope[AllocScopeCount]; // Frees per scope not yet published
+    uint64_t     cachedAllocCount[AllocScopeCount]; // Allocations served from the free lists not yet published
+};
+
+static thread_local ThreadAllocCache t_allocCache;
+
+// =====================================================================================================================
+// Returns the smallest size class which fits the given size, or LargeSizeClass.
+static uint32_t GetSizeClass(
+    size_t size)
+{
+    uint32_t sizeClass = 0;
+
+    while ((sizeClass < SizeClassCount) && (SizeClasses[sizeClass] < size))
+    {
+        ++sizeClass;
+    }
+
+    return (sizeClass < SizeClassCount) ? sizeClass : LargeSizeClass;
+}
+
+// =====================================================================================================================
+// Allocation callback of the thread-caching front end.
+static void* VKAPI_PTR ThreadCachingAllocFunc(
+    void*                                   pUserData,
+    size_t                                  size,
+    size_t                                  alignment,
+    VkSystemAllocationScope                 allocType)
+{
+    ThreadAllocCache* pCache = t_allocCache.alive ? &t_allocCache : nullptr;
+
+    const uint32_t sizeClass = (alignment <= BlockHeaderSize) ? GetSizeClass(size) : LargeSizeClass;
+    const uint32_t scope     = static_cast<uint32_t>(allocType) % AllocScopeCount;
+
+    void*    pMemory    = nullptr;
+    uint64_t baseOffset = BlockHeaderSize;
+
+    if (sizeClass != LargeSizeClass)
+    {
+        if ((pCache != nullptr) && (pCache->pFreeBlocks[sizeClass] != nullptr))
+        {
+            CachedBlock* pBlock = pCache->pFreeBlocks[sizeClass];
+
+            pCache->pFreeBlocks[sizeClass] = pBlock->pNext;
+            pCache->freeCount[sizeClass]--;
+            pCache->cachedAllocCount[scope]++;
+
+            pMemory = pBlock;
+        }
+        else
+        {
+            void* pBase = DefaultAllocFunc(
+                pUserData, BlockHeaderSize + SizeClasses[sizeClass], BlockHeaderSize, allocType);
+
+            pMemory = (pBase != nullptr) ? Util::VoidPtrInc(pBase, BlockHeaderSize) : nullptr;
+        }
+    }
+    else
+    {
+        // The header sits right below the client pointer, which keeps the requested alignment
+        baseOffset = Util::Max(Util::Pow2Align(alignment, sizeof(void*)), BlockHeaderSize);
+
+        void* pBase = DefaultAllocFunc(pUserData, baseOffset + size, baseOffset, allocType);
+
+        pMemory = (pBase != nullptr) ? Util::VoidPtrInc(pBase, static_cast<size_t>(baseOffset)) : nullptr;
+    }
+
+    if (pMemory != nullptr)
+    {
+        BlockHeader* pHeader = static_cast<BlockHeader*>(Util::VoidPtrDec(pMemory, BlockHeaderSize));
+
+        pHeader->sizeClass  = sizeClass;
+        pHeader->scope      = scope;
+        pHeader->baseOffset = baseOffset;
+
+        if (pCache != nullptr)
+        {
+            pCache->allocCount[scope]++;
+
+            if (++pCache->pendingAllocs >= StatsFlushInterval)
+            {
+                pCache->FlushStats();
+            }
+        }
+    }
+
+    return pMemory;
+}
+
+// =====================================================================================================================
+// Free callback of the thread-caching front end.
+static void VKAPI_PTR ThreadCachingFreeFunc(
+    void*                                   pUserData,
+    void*                                   pMem)
+{
+    if (pMem != nullptr)
+    {
+        ThreadAllocCache* pCache = t_allocCache.alive ? &t_allocCache : nullptr;
+
+        const BlockHeader* pHeader = static_cast<const BlockHeader*>(Util::VoidPtrDec(pMem, BlockHeaderSize));
+
+        const uint32_t sizeClass = pHeader->sizeClass;
+
+        if (pCache != nullptr)
+        {
+            pCache->freeCountByScope[pHeader->scope]++;
+        }
+
+        if ((sizeClass != LargeSizeClass) && (pCache != nullptr) && (pCache->freeCount[sizeClass] < MaxCachedPerClass))
+        {
+            CachedBlock* pBlock = static_cast<CachedBlock*>(pMem);
+
+            pBlock->pNext                  = pCache->pFreeBlocks[sizeClass];
+            pCache->pFreeBlocks[sizeClass] = pBlock;
+            pCache->freeCount[sizeClass]++;
+        }
+        else
+        {
+            DefaultFreeFunc(pUserData, Util::VoidPtrDec(pMem, static_cast<size_t>(pHeader->baseOffset)));
+        }
+    }
+}
+
+// =====================================================================================================================
+// Returns true if the thread-caching front end is requested for instances without application callbacks.
+bool IsThreadCachingEnabled()
+{
+    const char* pEnv = getenv("AMDVLK_ALLOC_THREAD_CACHE");
+
+    return (pEnv != nullptr) && (atoi(pEnv) != 0);
+}
+
+// =====================================================================================================================
+// Returns the allocation counters of the thread-caching front end, per VkSystemAllocationScope.  Counts of running
+// threads are published in batches, so they may lag slightly behind.
+void GetAllocScopeStats(
+    AllocScopeStats* pStats)
+{
+    t_allocCache.FlushStats();
+
+    for (uint32_t scope = 0; scope < AllocScopeCount; ++scope)
+    {
+        pStats[scope].allocCount       = s_scopeAllocCount[scope].load(std::memory_order_relaxed);
+        pStats[scope].freeCount        = s_scopeFreeCount[scope].load(std::memory_order_relaxed);
+        pStats[scope].cachedAllocCount = s_scopeCachedAllocCount[scope].load(std::memory_order_relaxed);
+    }
+}
+
+extern const VkAllocationCallbacks g_ThreadCachingAllocCallback =
+{
+    nullptr,
+    ThreadCachingAllocFunc,
+    DefaultReallocFunc,
+    ThreadCachingFreeFunc,
+    DefaultAllocNotification,
+    DefaultFreeNotification
+};
+
 // =====================================================================================================================
 // Delegation function that calls through to a Vulkan allocator on behalf of a PAL allocator callback. This allows PAL
 // to call into the application's allocator callbacks.
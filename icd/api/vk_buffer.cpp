@@ -139,7 +139,7 @@ VkResult Buffer::Create(
         VK_ASSERT(palResult == Pal::Result::Success);
 
         // Allocate enough system memory to also store the VA-only memory object
-        pMemory = pDevice->AllocApiObject(
+        pMemory = pDevice->AllocPooledApiObject(
                         pAllocator,
                         apiSize + (palMemSize * pDevice->NumPalDevices()));
 
@@ -166,7 +166,7 @@ VkResult Buffer::Create(
     else
     {
         // Allocate memory only for the dispatchable object
-        pMemory = pDevice->AllocApiObject(
+        pMemory = pDevice->AllocPooledApiObject(
                         pAllocator,
                         apiSize);
 
@@ -360,6 +360,8 @@ VkResult Buffer::Destroy(
         &data,
         sizeof(Pal::ResourceDestroyEventData));
 
+    pDevice->GetGpuAddressIndex()->Remove(this);
+
     for (uint32_t deviceIdx = 0; deviceIdx < pDevice->NumPalDevices(); deviceIdx++)
     {
         Pal::IGpuMemory* pMemoryObj = m_perGpu[deviceIdx].pGpuMemory;
@@ -380,7 +382,7 @@ VkResult Buffer::Destroy(
 
     Util::Destructor(this);
 
-    pDevice->FreeApiObject(pAllocator, this);
+    pDevice->FreePooledApiObject(pAllocator, this);
 
     return VK_SUCCESS;
 }
@@ -403,16 +405,22 @@ VkResult Buffer::BindMemory(
     {
         Memory*pMemory = Memory::ObjectFromHandle(mem);
 
+        // Sub-allocated memory only occupies part of its PAL memory object
+        m_memOffset += pMemory->Offset();
+
+        pMemory->MarkUsed();
+        pMemory->RecordBind(MemoryEventType::BufferBind, this, m_size, m_memOffset);
+
         if (pDevice->IsMultiGpu() == false)
         {
             const uint32_t singleIdx = DefaultDeviceIndex;
 
             Pal::IGpuMemory* pPalMemory = pMemory->PalMemory(singleIdx);
             m_perGpu[singleIdx].pGpuMemory  = pPalMemory;
-            m_perGpu[singleIdx].gpuVirtAddr = pPalMemory->Desc().gpuVirtAddr + memOffset;
+            m_perGpu[singleIdx].gpuVirtAddr = pPalMemory->Desc().gpuVirtAddr + m_memOffset;
 
             // @NOTE - This only handles the single GPU case currently.  MGPU is not supported by RMV v1
-            LogGpuMemoryBind(pDevice, pPalMemory, memOffset);
+            LogGpuMemoryBind(pDevice, pPalMemory, m_memOffset);
         }
         else
         {
@@ -423,7 +431,7 @@ VkResult Buffer::BindMemory(
 
                 m_perGpu[localDeviceIdx].pGpuMemory  = pMemory->PalMemory(localDeviceIdx, sourceMemInst);
                 m_perGpu[localDeviceIdx].gpuVirtAddr =
-                    m_perGpu[localDeviceIdx].pGpuMemory->Desc().gpuVirtAddr + memOffset;
+                    m_perGpu[localDeviceIdx].pGpuMemory->Desc().gpuVirtAddr + m_memOffset;
             }
         }
     }
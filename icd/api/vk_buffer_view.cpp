@@ -53,7 +53,7 @@ VkResult BufferView::Create(
     const size_t objSize = apiSize +
         (srdSize * pDevice->NumPalDevices());
 
-    void* pMemory = pDevice->AllocApiObject(pAllocator, objSize);
+    void* pMemory = pDevice->AllocPooledApiObject(pAllocator, objSize);
 
     if (pMemory == nullptr)
     {
@@ -137,7 +137,7 @@ VkResult BufferView::Destroy(
 {
     Util::Destructor(this);
 
-    pDevice->FreeApiObject(pAllocator, this);
+    pDevice->FreePooledApiObject(pAllocator, this);
 
     return VK_SUCCESS;
 }
@@ -60,7 +60,10 @@ CmdPool::CmdPool(
     m_pAllocator(pAllocator),
     m_queueFamilyIndex(queueFamilyIndex),
     m_sharedCmdAllocator(sharedCmdAllocator),
-    m_cmdBufferRegistry(32, pDevice->VkInstance()->Allocator())
+    m_cmdBufferRegistry(32, pDevice->VkInstance()->Allocator()),
+    m_recordingCount(0),
+    m_submitCount(0),
+    m_pReplacedAllocatorMem(nullptr)
 {
     m_flags.u32All = 0;
 
@@ -69,6 +72,14 @@ CmdPool::CmdPool(
         m_flags.isProtected = true;
     }
 
+    if ((sharedCmdAllocator == false) && pDevice->GetRuntimeSettings().adaptiveCmdAllocatorSizing)
+    {
+        m_flags.adaptiveCmdAllocators = true;
+    }
+
+    InitCmdAllocatorCreateInfo(pDevice->GetRuntimeSettings(), &m_cmdAllocatorInfo);
+    memset(m_usageHighWater, 0, sizeof(m_usageHighWater));
+
     memcpy(m_pPalCmdAllocators, pPalCmdAllocators, sizeof(pPalCmdAllocators[0]) * pDevice->NumPalDevices());
 }
 
@@ -81,6 +92,33 @@ VkResult CmdPool::Init()
     return PalToVkResult(palResult);
 }
 
+// =====================================================================================================================
+// Fills in the create info of a private CmdAllocator from the static settings.
+void CmdPool::InitCmdAllocatorCreateInfo(
+    const RuntimeSettings&       settings,
+    Pal::CmdAllocatorCreateInfo* pCreateInfo)
+{
+    memset(pCreateInfo, 0, sizeof(*pCreateInfo));
+
+    pCreateInfo->flags.autoMemoryReuse          = 1;
+    pCreateInfo->flags.disableBusyChunkTracking = 1;
+
+    // Initialize command data chunk allocation size
+    pCreateInfo->allocInfo[Pal::CommandDataAlloc].allocHeap    = settings.cmdAllocatorDataHeap;
+    pCreateInfo->allocInfo[Pal::CommandDataAlloc].allocSize    = settings.cmdAllocatorDataAllocSize;
+    pCreateInfo->allocInfo[Pal::CommandDataAlloc].suballocSize = settings.cmdAllocatorDataSubAllocSize;
+
+    // Initialize embedded data chunk allocation size
+    pCreateInfo->allocInfo[Pal::EmbeddedDataAlloc].allocHeap    = settings.cmdAllocatorEmbeddedHeap;
+    pCreateInfo->allocInfo[Pal::EmbeddedDataAlloc].allocSize    = settings.cmdAllocatorEmbeddedAllocSize;
+    pCreateInfo->allocInfo[Pal::EmbeddedDataAlloc].suballocSize = settings.cmdAllocatorEmbeddedSubAllocSize;
+
+    // Initialize GPU scratch memory chunk allocation size
+    pCreateInfo->allocInfo[Pal::GpuScratchMemAlloc].allocHeap    = settings.cmdAllocatorScratchHeap;
+    pCreateInfo->allocInfo[Pal::GpuScratchMemAlloc].allocSize    = settings.cmdAllocatorScratchAllocSize;
+    pCreateInfo->allocInfo[Pal::GpuScratchMemAlloc].suballocSize = settings.cmdAllocatorScratchSubAllocSize;
+}
+
 // =====================================================================================================================
 VkResult CmdPool::Create(
     Device*                        pDevice,
@@ -97,10 +135,13 @@ VkResult CmdPool::Create(
 
     if (pSettings->useSharedCmdAllocator)
     {
-        // Use the per-device shared CmdAllocator if the settings indicate so.
+        // Use one of the per-device shared CmdAllocators if the settings indicate so.  Each pool sticks to one slot
+        // for all GPUs, and different pools get different slots to reduce lock contention between recording threads.
+        const uint32_t slot = pDevice->AcquireSharedCmdAllocatorSlot();
+
         for (uint32_t deviceIdx = 0; deviceIdx < pDevice->NumPalDevices(); deviceIdx++)
         {
-            pPalCmdAllocator[deviceIdx] = pDevice->GetSharedCmdAllocator(deviceIdx);
+            pPalCmdAllocator[deviceIdx] = pDevice->GetSharedCmdAllocator(deviceIdx, slot);
         }
 
         pMemory = pDevice->AllocApiObject(pAllocator, sizeof(CmdPool));
@@ -116,23 +157,7 @@ VkResult CmdPool::Create(
         // object in a single thread at any given time, we don't need a thread safe CmdAllocator.
         Pal::CmdAllocatorCreateInfo createInfo = { };
 
-        createInfo.flags.autoMemoryReuse          = 1;
-        createInfo.flags.disableBusyChunkTracking = 1;
-
-        // Initialize command data chunk allocation size
-        createInfo.allocInfo[Pal::CommandDataAlloc].allocHeap    = pSettings->cmdAllocatorDataHeap;
-        createInfo.allocInfo[Pal::CommandDataAlloc].allocSize    = pSettings->cmdAllocatorDataAllocSize;
-        createInfo.allocInfo[Pal::CommandDataAlloc].suballocSize = pSettings->cmdAllocatorDataSubAllocSize;
-
-        // Initialize embedded data chunk allocation size
-        createInfo.allocInfo[Pal::EmbeddedDataAlloc].allocHeap    = pSettings->cmdAllocatorEmbeddedHeap;
-        createInfo.allocInfo[Pal::EmbeddedDataAlloc].allocSize    = pSettings->cmdAllocatorEmbeddedAllocSize;
-        createInfo.allocInfo[Pal::EmbeddedDataAlloc].suballocSize = pSettings->cmdAllocatorEmbeddedSubAllocSize;
-
-        // Initialize GPU scratch memory chunk allocation size
-        createInfo.allocInfo[Pal::GpuScratchMemAlloc].allocHeap    = pSettings->cmdAllocatorScratchHeap;
-        createInfo.allocInfo[Pal::GpuScratchMemAlloc].allocSize    = pSettings->cmdAllocatorScratchAllocSize;
-        createInfo.allocInfo[Pal::GpuScratchMemAlloc].suballocSize = pSettings->cmdAllocatorScratchSubAllocSize;
+        InitCmdAllocatorCreateInfo(*pSettings, &createInfo);
 
         Pal::Result  palResult     = Pal::Result::Success;
         const size_t allocatorSize = pDevice->PalDevice(DefaultDeviceIndex)->GetCmdAllocatorSize(createInfo, &palResult);
@@ -212,12 +237,13 @@ VkResult CmdPool::Destroy(
     const VkAllocationCallbacks*    pAllocator)
 {
     // When a command pool is destroyed, all command buffers allocated from the pool are implicitly freed and
-    // become invalid.
-    while (m_cmdBufferRegistry.GetNumEntries() > 0)
-    {
-        CmdBuffer* pCmdBuf = m_cmdBufferRegistry.Begin().Get()->key;
+    // become invalid.  They are destroyed in a single pass over the registry, which goes away as a whole with the
+    // pool, instead of each one erasing itself and the next one being searched for from the start of the table.
+    m_flags.isDestroying = 1;
 
-        pCmdBuf->Destroy();
+    for (auto it = m_cmdBufferRegistry.Begin(); it.Get() != nullptr; it.Next())
+    {
+        it.Get()->key->Destroy();
     }
 
     // If we don't use a shared CmdAllocator then we have to destroy our own one.
@@ -227,6 +253,11 @@ VkResult CmdPool::Destroy(
         {
             m_pPalCmdAllocators[deviceIdx]->Destroy();
         }
+
+        if (m_pReplacedAllocatorMem != nullptr)
+        {
+            m_pAllocator->pfnFree(m_pAllocator->pUserData, m_pReplacedAllocatorMem);
+        }
     }
 
     Util::Destructor(this);
@@ -266,15 +297,26 @@ VkResult CmdPool::Reset(VkCommandPoolResetFlags flags)
     // We first have to reset all the command buffers that use this pool (PAL doesn't do this automatically).
     for (auto it = m_cmdBufferRegistry.Begin(); (it.Get() != nullptr) && (result == VK_SUCCESS); it.Next())
     {
-        // Per-spec we always have to do a command buffer reset that also releases the used resources.
-        result = it.Get()->key->Reset(VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
+        // Per-spec we always have to do a command buffer reset that also releases the used resources.  Command buffers
+        // may only keep their chunks if the allocator isn't reset along with the pool.
+        result = it.Get()->key->Reset(VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT, m_sharedCmdAllocator);
     }
 
     if (result == VK_SUCCESS)
     {
         // After resetting the registered command buffers, reset the pool itself but only if we use per-pool
-        // CmdAllocator objects, not a single shared one.
-        if (m_sharedCmdAllocator == false)
+        // CmdAllocator objects, not a single shared one.  No command buffer holds any chunks now, which makes this the
+        // point where the allocators can be replaced by ones sized for what the pool actually records.
+        if (m_flags.adaptiveCmdAllocators && (m_recordingCount >= MinAdaptRecordings))
+        {
+            Pal::CmdAllocatorCreateInfo createInfo;
+
+            result = ComputeAdaptedCreateInfo(&createInfo) ? ReplaceCmdAllocators(createInfo) : ResetCmdAllocator();
+
+            m_recordingCount = 0;
+            m_submitCount.store(0, std::memory_order_relaxed);
+        }
+        else if (m_sharedCmdAllocator == false)
         {
             result = ResetCmdAllocator();
         }
@@ -283,6 +325,172 @@ VkResult CmdPool::Reset(VkCommandPoolResetFlags flags)
     return result;
 }
 
+// =====================================================================================================================
+// Records how much memory of each allocation type a command buffer of this pool used in the recording that just
+// ended.  The high-water mark decays by an eighth per recording so that a pool which stops recording large command
+// buffers eventually gets smaller chunks again.
+void CmdPool::RecordCmdAllocatorUsage(
+    const Pal::gpusize* pUsedSizes)
+{
+    VK_ASSERT(m_flags.adaptiveCmdAllocators);
+
+    for (uint32_t type = 0; type < Pal::CmdAllocatorTypeCount; ++type)
+    {
+        m_usageHighWater[type] = Util::Max(pUsedSizes[type], m_usageHighWater[type] - (m_usageHighWater[type] / 8));
+    }
+
+    m_recordingCount++;
+}
+
+// =====================================================================================================================
+// Derives the create info of the private CmdAllocators from the usage recorded since the last check.  Chunks are sized
+// so that a typical recording fits into one, within a factor of MaxChunkScale of the static settings.  Command and
+// embedded data of command buffers which are submitted many times per recording are placed in local memory, where the
+// GPU reads them faster; data written once and read once stays in GART.  Returns true if the result differs from the
+// create info of the current allocators.
+bool CmdPool::ComputeAdaptedCreateInfo(
+    Pal::CmdAllocatorCreateInfo* pCreateInfo) const
+{
+    constexpr uint32_t     MaxChunkScale   = 8;     // Maximum factor between adapted and static chunk sizes
+    constexpr uint32_t     LocalReuse      = 2;     // Submissions per recording that justify local memory
+    constexpr Pal::gpusize MinSuballocSize = 4096;
+
+    VK_ASSERT(m_recordingCount > 0);
+
+    Pal::CmdAllocatorCreateInfo staticInfo;
+
+    InitCmdAllocatorCreateInfo(m_pDevice->GetRuntimeSettings(), &staticInfo);
+
+    *pCreateInfo = staticInfo;
+
+    const bool reused  = (m_submitCount.load(std::memory_order_relaxed) >= (m_recordingCount * LocalReuse));
+    bool       changed = false;
+
+    for (uint32_t type = 0; type < Pal::CmdAllocatorTypeCount; ++type)
+    {
+        const auto& staticAlloc = staticInfo.allocInfo[type];
+        auto*       pAlloc      = &pCreateInfo->allocInfo[type];
+
+        const Pal::gpusize minSize   = Util::Max<Pal::gpusize>(staticAlloc.suballocSize / MaxChunkScale,
+                                                               MinSuballocSize);
+        const Pal::gpusize maxSize   = Util::Max<Pal::gpusize>(staticAlloc.suballocSize * MaxChunkScale, minSize);
+        const Pal::gpusize chunkSize = Util::Clamp(Util::Pow2Pad(m_usageHighWater[type]), minSize, maxSize);
+
+        // Keep the number of chunks per allocation of the static settings.
+        const Pal::gpusize chunksPerAlloc = Util::Max<Pal::gpusize>(
+            staticAlloc.allocSize / Util::Max<Pal::gpusize>(staticAlloc.suballocSize, 1), 1);
+
+        pAlloc->suballocSize = static_cast<uint32_t>(chunkSize);
+        pAlloc->allocSize    = static_cast<uint32_t>(chunkSize * chunksPerAlloc);
+
+        // PAL always places GPU scratch memory in invisible memory.
+        if (type != Pal::GpuScratchMemAlloc)
+        {
+            pAlloc->allocHeap = reused ? Pal::GpuHeapLocal : Pal::GpuHeapGartUswc;
+        }
+
+        const auto& currentAlloc = m_cmdAllocatorInfo.allocInfo[type];
+
+        if ((pAlloc->suballocSize != currentAlloc.suballocSize) ||
+            (pAlloc->allocSize    != currentAlloc.allocSize)    ||
+            (pAlloc->allocHeap    != currentAlloc.allocHeap))
+        {
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+// =====================================================================================================================
+// Replaces the private CmdAllocators by ones created with the given info and moves all command buffers of the pool onto
+// them.  Must only be called while no command buffer of the pool holds any chunks.  On failure the current allocators
+// are kept and reset instead.
+VkResult CmdPool::ReplaceCmdAllocators(
+    const Pal::CmdAllocatorCreateInfo& createInfo)
+{
+    VK_ASSERT(m_sharedCmdAllocator == false);
+
+    Pal::Result  palResult     = Pal::Result::Success;
+    const size_t allocatorSize = m_pDevice->PalDevice(DefaultDeviceIndex)->GetCmdAllocatorSize(createInfo, &palResult);
+
+    void*               pMemory                       = nullptr;
+    Pal::ICmdAllocator* pNewAllocators[MaxPalDevices] = {};
+    uint32_t            createdCount                  = 0;
+
+    if (palResult == Pal::Result::Success)
+    {
+        pMemory = m_pAllocator->pfnAllocation(m_pAllocator->pUserData,
+                                              allocatorSize * m_pDevice->NumPalDevices(),
+                                              VK_DEFAULT_MEM_ALIGN,
+                                              VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+        palResult = (pMemory != nullptr) ? Pal::Result::Success : Pal::Result::ErrorOutOfMemory;
+    }
+
+    for (; (createdCount < m_pDevice->NumPalDevices()) && (palResult == Pal::Result::Success); createdCount++)
+    {
+        palResult = m_pDevice->PalDevice(createdCount)->CreateCmdAllocator(
+            createInfo,
+            Util::VoidPtrInc(pMemory, allocatorSize * createdCount),
+            &pNewAllocators[createdCount]);
+    }
+
+    VkResult result = VK_SUCCESS;
+
+    if (palResult == Pal::Result::Success)
+    {
+        Pal::ICmdAllocator* pOldAllocators[MaxPalDevices] = {};
+
+        memcpy(pOldAllocators, m_pPalCmdAllocators, sizeof(m_pPalCmdAllocators));
+        memcpy(m_pPalCmdAllocators, pNewAllocators, sizeof(m_pPalCmdAllocators));
+
+        for (auto it = m_cmdBufferRegistry.Begin(); it.Get() != nullptr; it.Next())
+        {
+            const VkResult cmdBufResult = it.Get()->key->AdoptPoolCmdAllocators();
+
+            VK_ASSERT(cmdBufResult == VK_SUCCESS);
+
+            if (result == VK_SUCCESS)
+            {
+                result = cmdBufResult;
+            }
+        }
+
+        for (uint32_t deviceIdx = 0; deviceIdx < m_pDevice->NumPalDevices(); deviceIdx++)
+        {
+            pOldAllocators[deviceIdx]->Destroy();
+        }
+
+        if (m_pReplacedAllocatorMem != nullptr)
+        {
+            m_pAllocator->pfnFree(m_pAllocator->pUserData, m_pReplacedAllocatorMem);
+        }
+
+        m_pReplacedAllocatorMem = pMemory;
+        m_cmdAllocatorInfo      = createInfo;
+    }
+    else
+    {
+        for (uint32_t deviceIdx = 0; deviceIdx < createdCount; deviceIdx++)
+        {
+            if (pNewAllocators[deviceIdx] != nullptr)
+            {
+                pNewAllocators[deviceIdx]->Destroy();
+            }
+        }
+
+        if (pMemory != nullptr)
+        {
+            m_pAllocator->pfnFree(m_pAllocator->pUserData, pMemory);
+        }
+
+        result = ResetCmdAllocator();
+    }
+
+    return result;
+}
+
 // =====================================================================================================================
 // Register a command buffer with this pool. Used to reset the command buffers at pool reset time.
 Pal::Result CmdPool::RegisterCmdBuffer(CmdBuffer* pCmdBuffer)
@@ -294,7 +502,10 @@ Pal::Result CmdPool::RegisterCmdBuffer(CmdBuffer* pCmdBuffer)
 // Unregister a command buffer from this pool.
 void CmdPool::UnregisterCmdBuffer(CmdBuffer* pCmdBuffer)
 {
-    m_cmdBufferRegistry.Erase(pCmdBuffer);
+    if (m_flags.isDestroying == 0)
+    {
+        m_cmdBufferRegistry.Erase(pCmdBuffer);
+    }
 }
 
 /**
@@ -23,6 +23,10 @@
  *
  **********************************************************************************************************************/
 
+#include "include/barrier_profile.h"
+#include "include/gpu_timing_table.h"
+#include "include/pipeline_stats_profile.h"
+#include "include/log.h"
 #include "include/vk_buffer.h"
 #include "include/vk_cmdbuffer.h"
 #include "include/vk_compute_pipeline.h"
@@ -43,6 +47,8 @@
 #include "include/vk_query.h"
 #include "include/vk_queue.h"
 
+#include "appopt/barrier_filter_layer.h"
+
 #include "sqtt/sqtt_layer.h"
 #include "sqtt/sqtt_mgr.h"
 
@@ -181,14 +187,13 @@ Util::Vector<Pal::Range, 16, Util::GenericAllocator> RangesOfOnesInBitMask(
 
 // =====================================================================================================================
 // Populate a vector with PAL clear regions converted from Vulkan clear rects.
-// If multiview is enabled layer ranges are overridden according to viewMask.
+// If multiview is enabled (viewMask is non-zero) layer ranges are overridden according to viewMask.
 // Returns Pal::Result::Success if completed successfully.
 template <typename PalClearRegionVect>
 Pal::Result CreateClearRegions (
     const uint32_t              rectCount,
     const VkClearRect* const    pRects,
-    const RenderPass&           renderPass,
-    const uint32_t              subpass,
+    const uint32_t              viewMask,
     const uint32_t              zOffset,
     PalClearRegionVect* const   pOutClearRegions)
 {
@@ -202,9 +207,8 @@ Pal::Result CreateClearRegions (
 
     pOutClearRegions->Clear();
 
-    if (renderPass.IsMultiviewEnabled())
+    if (viewMask != 0)
     {
-        const auto viewMask    = renderPass.GetViewMask(subpass);
         const auto layerRanges = RangesOfOnesInBitMask(viewMask);
 
         palResult = pOutClearRegions->Reserve(rectCount * layerRanges.NumElements());
@@ -367,6 +371,21 @@ Pal::Result CreateClearRects(
     return palResult;
 }
 
+// =====================================================================================================================
+// Returns true if a vkCmdSet* call for state which is programmed directly (not through dirty state validation) would
+// set the value which PAL already has.  That is only known if the last value came from a vkCmdSet* call as well.
+template <typename StateParams>
+bool IsRedundantDynamicState(
+    bool               known,
+    uint32_t           staticToken,
+    const StateParams& current,
+    const StateParams& params)
+{
+    return known &&
+           (staticToken == DynamicRenderStateToken) &&
+           (memcmp(&current, &params, sizeof(StateParams)) == 0);
+}
+
 } // anonymous ns
 
 // =====================================================================================================================
@@ -388,9 +407,27 @@ CmdBuffer::CmdBuffer(
     m_flags(),
     m_recordingResult(VK_SUCCESS),
     m_pSqttState(nullptr),
+    m_pBarrierFilterState(nullptr),
+    m_pLayoutState(nullptr),
+    m_pGpuTiming(nullptr),
+    m_pPipelineStats(nullptr),
+    m_pBarrierProfile(nullptr),
+    m_pDeviceGroupStream(nullptr),
     m_renderPassInstance(pDevice->VkInstance()->Allocator()),
     m_pTransformFeedbackState(nullptr),
-    m_palDepthStencilState(pDevice->VkInstance()->Allocator())
+    m_palDepthStencilState(pDevice->VkInstance()->Allocator()),
+    m_footprintUserDataMask(AllPipelineBindMask),
+    m_footprintStateMask(TrackedStateAll),
+    m_touchedUserDataMask(AllPipelineBindMask),
+    m_touchedStateMask(TrackedStateAll),
+    m_cmdDataUsedSize(0),
+    m_cmdDataHighWater(0),
+    m_stats(),
+    m_pDebugName(nullptr),
+    m_uploadRing(pDevice),
+    m_updateBufferStagingThreshold(0),
+    m_pendingQueryReset(),
+    m_lastImageClear()
 {
     m_flags.wasBegun = false;
 
@@ -398,6 +435,7 @@ CmdBuffer::CmdBuffer(
 
     m_optimizeCmdbufMode             = settings.optimizeCmdbufMode;
     m_asyncComputeQueueMaxWavesPerCu = settings.asyncComputeQueueMaxWavesPerCu;
+    m_updateBufferStagingThreshold   = settings.updateBufferStagingThreshold;
 
 #if VK_ENABLE_DEBUG_BARRIERS
     m_dbgBarrierPreCmdMask  = settings.dbgBarrierPreCmdEnable;
@@ -409,6 +447,12 @@ CmdBuffer::CmdBuffer(
     m_flags.prefetchShaders                     = settings.prefetchShaders;
     m_flags.disableResetReleaseResources        = settings.disableResetReleaseResources;
     m_flags.subpassLoadOpClearsBoundAttachments = settings.subpassLoadOpClearsBoundAttachments;
+    m_flags.trackSecondaryFootprint             = settings.trackSecondaryFootprints;
+    m_flags.adaptivePrefetch                    = settings.adaptiveCommandPrefetch;
+    m_flags.reportStats                         = settings.enableCmdBufferStats;
+    m_flags.coalesceQueryResets                 = settings.coalesceQueryResets;
+    m_flags.elideRedundantClears                = settings.elideRedundantImageClears;
+    m_flags.keepWarmChunks                      = settings.keepWarmCmdBufferChunks;
 
     Pal::DeviceProperties info;
     m_pDevice->PalDevice(DefaultDeviceIndex)->GetProperties(&info);
@@ -420,6 +464,9 @@ CmdBuffer::CmdBuffer(
     m_flags.hasReleaseAcquire       = info.gfxipProperties.flags.supportReleaseAcquireInterface;
     m_flags.useSplitReleaseAcquire  = info.gfxipProperties.flags.supportReleaseAcquireInterface &&
                                       info.gfxipProperties.flags.supportSplitReleaseAcquire;
+
+    // Legacy vkCmdSetEvent()/vkCmdWaitEvents() pairs are mapped to a release and an acquire of the event as well.
+    m_flags.useReleaseAcquireForEvents = m_flags.useSplitReleaseAcquire && settings.legacyEventsUseReleaseAcquire;
 }
 
 // =====================================================================================================================
@@ -577,6 +624,124 @@ VkResult CmdBuffer::Initialize(
         }
     }
 
+    // Initialize the image state tracked by the barrier filter layer if redundant image barriers are filtered.
+    if ((result == Pal::Result::Success) &&
+        ((m_pDevice->GetRuntimeSettings().barrierFilterOptions & SkipRedundantImageBarriers) != 0))
+    {
+        void* pFilterStorage = m_pDevice->VkInstance()->AllocMem(sizeof(BarrierFilterCmdBufferState),
+            VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+        if (pFilterStorage != nullptr)
+        {
+            m_pBarrierFilterState = VK_PLACEMENT_NEW(pFilterStorage) BarrierFilterCmdBufferState();
+        }
+        else
+        {
+            result = Pal::Result::ErrorOutOfMemory;
+        }
+    }
+
+    // Record the layouts tracked images are left in.  Only primary command buffers rely on the layouts of earlier
+    // submissions, since they are the ones checked on submission.
+    if ((result == Pal::Result::Success) && m_pDevice->GetImageLayoutTracker()->IsEnabled())
+    {
+        void* pLayoutStorage = m_pDevice->VkInstance()->AllocMem(sizeof(ImageLayoutCmdBufferState),
+            VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+        if (pLayoutStorage != nullptr)
+        {
+            m_pLayoutState = VK_PLACEMENT_NEW(pLayoutStorage) ImageLayoutCmdBufferState(
+                m_pDevice->GetImageLayoutTracker(),
+                (m_flags.is2ndLvl == 0));
+        }
+        else
+        {
+            result = Pal::Result::ErrorOutOfMemory;
+        }
+    }
+
+    // Set up GPU timing if it is enabled and the engine can write timestamps.  The command buffer is still usable
+    // without it, so failures just leave it off.
+    const Pal::DeviceProperties& palProps = m_pDevice->VkPhysicalDevice(DefaultDeviceIndex)->PalProperties();
+
+    if ((result == Pal::Result::Success) && (m_pDevice->GetGpuTimingTable() != nullptr) &&
+        (palProps.engineProperties[m_palEngineType].flags.supportsTimestamps != 0))
+    {
+        void* pTimingStorage = m_pDevice->VkInstance()->AllocMem(sizeof(GpuTimingCmdBufferState),
+            VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+        if (pTimingStorage != nullptr)
+        {
+            m_pGpuTiming = VK_PLACEMENT_NEW(pTimingStorage) GpuTimingCmdBufferState(m_pDevice,
+                                                                                   m_pDevice->GetGpuTimingTable());
+
+            if (m_pGpuTiming->Init() != VK_SUCCESS)
+            {
+                m_pGpuTiming->Destroy();
+                Util::Destructor(m_pGpuTiming);
+                m_pDevice->VkInstance()->FreeMem(m_pGpuTiming);
+                m_pGpuTiming = nullptr;
+            }
+        }
+    }
+
+    // Likewise for the pipeline statistics profile, which needs an engine that supports pipeline statistics queries.
+    if ((result == Pal::Result::Success) && (m_pDevice->GetPipelineStatsProfile() != nullptr) &&
+        ((m_palEngineType == Pal::EngineTypeUniversal) || (m_palEngineType == Pal::EngineTypeCompute)))
+    {
+        void* pStatsStorage = m_pDevice->VkInstance()->AllocMem(sizeof(PipelineStatsCmdBufferState),
+            VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+        if (pStatsStorage != nullptr)
+        {
+            m_pPipelineStats = VK_PLACEMENT_NEW(pStatsStorage) PipelineStatsCmdBufferState(
+                m_pDevice,
+                m_pDevice->GetPipelineStatsProfile());
+
+            if (m_pPipelineStats->Init() != VK_SUCCESS)
+            {
+                m_pPipelineStats->Destroy();
+                Util::Destructor(m_pPipelineStats);
+                m_pDevice->VkInstance()->FreeMem(m_pPipelineStats);
+                m_pPipelineStats = nullptr;
+            }
+        }
+    }
+
+    // And for the barrier profile, which times barriers the same way GPU timing times regions.
+    if ((result == Pal::Result::Success) && (m_pDevice->GetBarrierProfile() != nullptr) &&
+        (palProps.engineProperties[m_palEngineType].flags.supportsTimestamps != 0))
+    {
+        void* pBarrierStorage = m_pDevice->VkInstance()->AllocMem(sizeof(BarrierProfileCmdBufferState),
+            VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+        if (pBarrierStorage != nullptr)
+        {
+            m_pBarrierProfile = VK_PLACEMENT_NEW(pBarrierStorage) BarrierProfileCmdBufferState(
+                m_pDevice,
+                m_pDevice->GetBarrierProfile());
+
+            if (m_pBarrierProfile->Init() != VK_SUCCESS)
+            {
+                m_pBarrierProfile->Destroy();
+                Util::Destructor(m_pBarrierProfile);
+                m_pDevice->VkInstance()->FreeMem(m_pBarrierProfile);
+                m_pBarrierProfile = nullptr;
+            }
+        }
+    }
+
+    // Record draws, dispatches and user data once for all devices of a device group.  Without the stream every device
+    // is recorded to directly, so it is optional as well.
+    if ((result == Pal::Result::Success) && (numGroupedCmdBuffers > 1) &&
+        m_pDevice->GetRuntimeSettings().deviceGroupRecordOnce)
+    {
+        m_pDeviceGroupStream = DeviceGroupCmdStream::Create(m_pDevice->VkInstance(),
+                                                            m_pDevice->GetCompileThreadPool(),
+                                                            m_pPalCmdBuffers,
+                                                            numGroupedCmdBuffers);
+    }
+
     return PalToVkResult(result);
 }
 
@@ -640,6 +805,11 @@ Pal::Result CmdBuffer::PalCmdBufferReset(Pal::ICmdAllocator* pCmdAllocator, bool
 {
     Pal::Result result = Pal::Result::Success;
 
+    if (m_pDeviceGroupStream != nullptr)
+    {
+        m_pDeviceGroupStream->Discard();
+    }
+
     // If there was no begin, skip the reset
     if (m_cbBeginDeviceMask != 0)
     {
@@ -699,6 +869,7 @@ void CmdBuffer::PalCmdUnbindIndexData(Pal::IndexType indexType)
 }
 
 // =====================================================================================================================
+template <uint32_t numPalDevices>
 void CmdBuffer::PalCmdDraw(
     uint32_t firstVertex,
     uint32_t vertexCount,
@@ -710,21 +881,29 @@ void CmdBuffer::PalCmdDraw(
     // add a delayed validation check for graphics.
     VK_ASSERT(PalPipelineBindingOwnedBy(Pal::PipelineBindPoint::Graphics, PipelineBindGraphics));
 
-    utils::IterateMask deviceGroup(m_curDeviceMask);
-    do
+    if ((numPalDevices > 1) && (m_pDeviceGroupStream != nullptr))
     {
-        const uint32_t deviceIdx = deviceGroup.Index();
+        m_pDeviceGroupStream->CmdDraw(m_curDeviceMask, firstVertex, vertexCount, firstInstance, instanceCount, drawId);
+    }
+    else
+    {
+        utils::IterateDeviceMask<numPalDevices> deviceGroup(m_curDeviceMask);
+        do
+        {
+            const uint32_t deviceIdx = deviceGroup.Index();
 
-        PalCmdBuffer(deviceIdx)->CmdDraw(firstVertex,
-            vertexCount,
-            firstInstance,
-            instanceCount,
-            drawId);
+            PalCmdBuffer(deviceIdx)->CmdDraw(firstVertex,
+                vertexCount,
+                firstInstance,
+                instanceCount,
+                drawId);
+        }
+        while (deviceGroup.IterateNext());
     }
-    while (deviceGroup.IterateNext());
 }
 
 // =====================================================================================================================
+template <uint32_t numPalDevices>
 void CmdBuffer::PalCmdDrawIndexed(
     uint32_t firstIndex,
     uint32_t indexCount,
@@ -737,33 +916,54 @@ void CmdBuffer::PalCmdDrawIndexed(
     // add a delayed validation check for graphics.
     VK_ASSERT(PalPipelineBindingOwnedBy(Pal::PipelineBindPoint::Graphics, PipelineBindGraphics));
 
-    utils::IterateMask deviceGroup(m_curDeviceMask);
-    do
+    if ((numPalDevices > 1) && (m_pDeviceGroupStream != nullptr))
     {
-        const uint32_t deviceIdx = deviceGroup.Index();
+        m_pDeviceGroupStream->CmdDrawIndexed(m_curDeviceMask,
+                                             firstIndex,
+                                             indexCount,
+                                             vertexOffset,
+                                             firstInstance,
+                                             instanceCount,
+                                             drawId);
+    }
+    else
+    {
+        utils::IterateDeviceMask<numPalDevices> deviceGroup(m_curDeviceMask);
+        do
+        {
+            const uint32_t deviceIdx = deviceGroup.Index();
 
-        PalCmdBuffer(deviceIdx)->CmdDrawIndexed(firstIndex,
-            indexCount,
-            vertexOffset,
-            firstInstance,
-            instanceCount,
-            drawId);
+            PalCmdBuffer(deviceIdx)->CmdDrawIndexed(firstIndex,
+                indexCount,
+                vertexOffset,
+                firstInstance,
+                instanceCount,
+                drawId);
+        }
+        while (deviceGroup.IterateNext());
     }
-    while (deviceGroup.IterateNext());
 }
 
 // =====================================================================================================================
+template <uint32_t numPalDevices>
 void CmdBuffer::PalCmdDispatch(
     uint32_t x,
     uint32_t y,
     uint32_t z)
 {
-    utils::IterateMask deviceGroup(m_curDeviceMask);
-    do
+    if ((numPalDevices > 1) && (m_pDeviceGroupStream != nullptr))
     {
-        PalCmdBuffer(deviceGroup.Index())->CmdDispatch(x, y, z);
+        m_pDeviceGroupStream->CmdDispatch(m_curDeviceMask, x, y, z);
+    }
+    else
+    {
+        utils::IterateDeviceMask<numPalDevices> deviceGroup(m_curDeviceMask);
+        do
+        {
+            PalCmdBuffer(deviceGroup.Index())->CmdDispatch(x, y, z);
+        }
+        while (deviceGroup.IterateNext());
     }
-    while (deviceGroup.IterateNext());
 }
 
 // =====================================================================================================================
@@ -1035,10 +1235,12 @@ VkResult CmdBuffer::Begin(
     RenderPass*  pRenderPass  = nullptr;
     Framebuffer* pFramebuffer = nullptr;
 
+    const VkCommandBufferInheritanceRenderingInfoKHR* pInheritedRendering = nullptr;
+
     m_cbBeginDeviceMask = m_pDevice->GetPalDeviceMask();
 
     cmdInfo.flags.u32All = 0;
-    cmdInfo.flags.prefetchCommands = m_flags.prefetchCommands;
+    cmdInfo.flags.prefetchCommands = m_flags.prefetchCommands && (m_flags.skipNextPrefetch == 0);
     cmdInfo.flags.prefetchShaders  = m_flags.prefetchShaders;
 
     if (IsProtected())
@@ -1053,6 +1255,10 @@ VkResult CmdBuffer::Begin(
     cmdInfo.flags.optimizeOneTimeSubmit   = (pBeginInfo->flags & VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT) ? 1 : 0;
     cmdInfo.flags.optimizeExclusiveSubmit = (pBeginInfo->flags & VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT) ? 0 : 1;
 
+    // Until End() records what a secondary changed, executing it resets all tracked state of the primary
+    m_footprintUserDataMask = AllPipelineBindMask;
+    m_footprintStateMask    = TrackedStateAll;
+
     switch (m_optimizeCmdbufMode)
     {
     case EnableOptimizeForRenderPassContinue:
@@ -1096,6 +1302,12 @@ VkResult CmdBuffer::Begin(
                 inheritedStateParams.stateFlags.predication = pExtInfo->conditionalRenderingEnable;
                 m_flags.hasConditionalRendering             = pExtInfo->conditionalRenderingEnable;
             }
+            else if ((pHeader->sType == VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR) &&
+                     (pRenderPass == nullptr) &&
+                     ((pBeginInfo->flags & VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT) != 0))
+            {
+                pInheritedRendering = static_cast<const VkCommandBufferInheritanceRenderingInfoKHR*>(pNext);
+            }
 
             pNext = pHeader->pNext;
         }
@@ -1145,6 +1357,32 @@ VkResult CmdBuffer::Begin(
             inheritedStateParams.sampleCount[i] = pRenderPass->GetColorAttachmentSamples(currentSubPass, i);
         }
     }
+    else if (pInheritedRendering != nullptr) // secondary VkCommandBuffer will be used inside dynamic rendering
+    {
+        VK_ASSERT(m_flags.is2ndLvl);
+
+        m_dynamicRendering.active               = true;
+        m_dynamicRendering.flags                = pInheritedRendering->flags;
+        m_dynamicRendering.viewMask             = pInheritedRendering->viewMask;
+        m_dynamicRendering.colorAttachmentCount = Util::Min(pInheritedRendering->colorAttachmentCount,
+                                                            Pal::MaxColorTargets);
+        m_dynamicRendering.samples              = pInheritedRendering->rasterizationSamples;
+        m_dynamicRendering.depthStencilFormat   =
+            (pInheritedRendering->depthAttachmentFormat != VK_FORMAT_UNDEFINED) ?
+                pInheritedRendering->depthAttachmentFormat : pInheritedRendering->stencilAttachmentFormat;
+
+        inheritedStateParams.colorTargetCount = m_dynamicRendering.colorAttachmentCount;
+        inheritedStateParams.stateFlags.targetViewState = 1;
+
+        for (uint32_t i = 0; i < inheritedStateParams.colorTargetCount; i++)
+        {
+            m_dynamicRendering.colorFormats[i] = pInheritedRendering->pColorAttachmentFormats[i];
+
+            inheritedStateParams.colorTargetSwizzledFormats[i] =
+                VkToPalFormat(m_dynamicRendering.colorFormats[i], m_pDevice->GetRuntimeSettings());
+            inheritedStateParams.sampleCount[i] = m_dynamicRendering.samples;
+        }
+    }
 
     Pal::Result result = PalCmdBufferBegin(cmdInfo);
 
@@ -1157,6 +1395,35 @@ VkResult CmdBuffer::Begin(
         m_pSqttState->Begin(pBeginInfo);
     }
 
+    if (m_pGpuTiming != nullptr)
+    {
+        // Only the default device's command buffer is timed.
+        m_flags.gpuTimingActive = ((m_cbBeginDeviceMask & (1 << DefaultDeviceIndex)) != 0);
+
+        if (m_flags.gpuTimingActive)
+        {
+            m_pGpuTiming->Begin(PalCmdBuffer(DefaultDeviceIndex), (m_flags.is2ndLvl == 0));
+        }
+        else
+        {
+            m_pGpuTiming->Resolve();
+        }
+    }
+
+    if (m_pPipelineStats != nullptr)
+    {
+        m_pPipelineStats->Resolve();
+
+        m_flags.pipelineStatsActive = ((m_cbBeginDeviceMask & (1 << DefaultDeviceIndex)) != 0);
+    }
+
+    if (m_pBarrierProfile != nullptr)
+    {
+        m_pBarrierProfile->Begin();
+
+        m_flags.barrierProfileActive = ((m_cbBeginDeviceMask & (1 << DefaultDeviceIndex)) != 0);
+    }
+
     if (result == Pal::Result::Success)
     {
         if (m_pStackAllocator == nullptr)
@@ -1208,6 +1475,11 @@ VkResult CmdBuffer::Begin(
         // function setting ViewMask for a subpass during the VkRenderPass is called.
         SetViewInstanceMask(GetDeviceMask());
     }
+    else if (m_dynamicRendering.active)
+    {
+        // The view mask of the dynamic rendering instance is given by the inheritance info in the same way.
+        SetViewInstanceMask(GetDeviceMask());
+    }
 
     if (Pal::QueueTypeUniversal == m_palQueueType)
     {
@@ -1276,6 +1548,8 @@ VkResult CmdBuffer::End(void)
 
     VK_ASSERT(m_flags.isRecording);
 
+    FlushQueryResets();
+
     DbgBarrierPreCmd(DbgBarrierCmdBufEnd);
 
     if (m_pSqttState != nullptr)
@@ -1283,38 +1557,127 @@ VkResult CmdBuffer::End(void)
         m_pSqttState->End();
     }
 
+    if (m_flags.gpuTimingActive)
+    {
+        m_pGpuTiming->End(PalCmdBuffer(DefaultDeviceIndex));
+
+        m_flags.gpuTimingActive = false;
+    }
+
+    m_flags.pipelineStatsActive  = false;
+    m_flags.barrierProfileActive = false;
+
+    UnbindTransformFeedbackTargets();
+
     DbgBarrierPostCmd(DbgBarrierCmdBufEnd);
 
     result = PalCmdBufferEnd();
 
     m_flags.isRecording = false;
 
+    if (m_flags.keepWarmChunks || m_flags.adaptivePrefetch)
+    {
+        UpdateCmdDataUsage();
+    }
+
+    // Command buffers are usually recorded with much the same contents every time.  Prefetching the command stream
+    // doesn't pay for itself for short streams without draws, so the next recording skips it if this one was one.
+    if (m_flags.adaptivePrefetch)
+    {
+        m_flags.skipNextPrefetch =
+            ((m_stats.drawCount == 0) &&
+             (m_cmdDataUsedSize < m_pDevice->GetRuntimeSettings().adaptiveCommandPrefetchMinBytes)) ? 1 : 0;
+    }
+
+    if (m_pCmdPool->AdaptsCmdAllocators())
+    {
+        ReportCmdAllocatorUsage();
+    }
+
+    // A secondary starts with all of its tracked state reset, so whatever was touched since is what executing it
+    // changes in the primary.
+    if (m_flags.is2ndLvl && m_flags.trackSecondaryFootprint)
+    {
+        m_footprintUserDataMask = m_touchedUserDataMask;
+        m_footprintStateMask    = m_touchedStateMask;
+    }
+
+    if (((m_stats.drawCount > 0) || (m_stats.filteredStateCount > 0)) &&
+        ((m_pDevice->GetRuntimeSettings().logTagIdMask & (1ULL << DrawValidation)) != 0))
+    {
+        m_pDevice->RecordDrawValidationStats(m_stats.drawCount,
+                                             m_stats.validatedDrawCount,
+                                             m_stats.filteredStateCount);
+    }
+
+    if (m_flags.reportStats)
+    {
+        ReportStats();
+    }
+
+    PerfCounterRegistry* pPerfCounters = m_pDevice->GetPerfCounters();
+
+    if (pPerfCounters->IsEnabled())
+    {
+        pPerfCounters->Add(PerfCounter::DrawsRecorded,          static_cast<int64_t>(m_stats.drawCount));
+        pPerfCounters->Add(PerfCounter::DispatchesRecorded,     static_cast<int64_t>(m_stats.dispatchCount));
+        pPerfCounters->Add(PerfCounter::BarriersRecorded,       static_cast<int64_t>(m_stats.barrierCount));
+        pPerfCounters->Add(PerfCounter::RedundantStateFiltered, static_cast<int64_t>(m_stats.filteredStateCount));
+    }
+
     return (m_recordingResult == VK_SUCCESS ? PalToVkResult(result) : m_recordingResult);
 }
 
 // =====================================================================================================================
 // Resets all state PipelineState.  This function is called both during vkBeginCommandBuffer (inside
 // CmdBuffer::ResetState()) and during vkResetCommandBuffer (inside CmdBuffer::ResetState()) and during
-// vkExecuteCommands.
-void CmdBuffer::ResetPipelineState()
+// vkExecuteCommands.  User data tracking is only reset for the bind points in userDataBindMask and fixed-function
+// tracking only for the TrackedStateGroups in stateMask, and of those only for the ones which were touched since they
+// were last reset.
+void CmdBuffer::ResetPipelineState(
+    uint32_t userDataBindMask,
+    uint32_t stateMask)
 {
-    ResetVertexBuffer();
+    const uint32_t resetStateMask = stateMask & m_touchedStateMask;
+
+    m_touchedStateMask &= ~stateMask;
+
+    if ((resetStateMask & TrackedStateVertexBuffers) != 0)
+    {
+        ResetVertexBuffer();
+    }
+
+    if ((resetStateMask & TrackedStateGraphics) != 0)
+    {
+        memset(&m_allGpuState.staticTokens, 0u, sizeof(m_allGpuState.staticTokens));
 
-    memset(&m_allGpuState.staticTokens, 0u, sizeof(m_allGpuState.staticTokens));
+        // Whatever was recorded before may have been overridden (e.g. by executed secondaries), so nothing is known.
+        m_allGpuState.known.u32All = 0;
 
-    memset(&m_allGpuState.depthStencilCreateInfo, 0u, sizeof(m_allGpuState.depthStencilCreateInfo));
+        memset(&m_allGpuState.depthStencilCreateInfo, 0u, sizeof(m_allGpuState.depthStencilCreateInfo));
+    }
+
+    // Bind points whose user data tracking wasn't touched since it was last reset are still in their reset state.
+    const uint32_t resetBindMask = userDataBindMask & m_touchedUserDataMask;
+
+    m_touchedUserDataMask &= ~userDataBindMask;
 
     uint32_t bindIdx = 0;
 
     do
     {
-        memset(&(m_allGpuState.pipelineState[bindIdx].userDataLayout),
-            0,
-            sizeof(m_allGpuState.pipelineState[bindIdx].userDataLayout));
+        if ((resetBindMask & (1u << bindIdx)) != 0)
+        {
+            memset(&(m_allGpuState.pipelineState[bindIdx].userDataLayout),
+                0,
+                sizeof(m_allGpuState.pipelineState[bindIdx].userDataLayout));
 
-        m_allGpuState.pipelineState[bindIdx].boundSetCount    = 0;
-        m_allGpuState.pipelineState[bindIdx].pushedConstCount = 0;
-        m_allGpuState.pipelineState[bindIdx].dynamicBindInfo  = {};
+            m_allGpuState.pipelineState[bindIdx].boundSetCount             = 0;
+            m_allGpuState.pipelineState[bindIdx].setBindingProgrammedCount = 0;
+            m_allGpuState.pipelineState[bindIdx].pushedConstCount          = 0;
+            m_allGpuState.pipelineState[bindIdx].pushConstProgrammedMask   = 0;
+            m_allGpuState.pipelineState[bindIdx].dynamicBindInfo           = {};
+        }
 
         bindIdx++;
     }
@@ -1322,8 +1685,15 @@ void CmdBuffer::ResetPipelineState()
 
     static_assert(VK_ARRAY_SIZE(m_allGpuState.palToApiPipeline) == 2, "");
 
-    m_allGpuState.palToApiPipeline[uint32_t(Pal::PipelineBindPoint::Compute)]  = PipelineBindCompute;
-    m_allGpuState.palToApiPipeline[uint32_t(Pal::PipelineBindPoint::Graphics)] = PipelineBindGraphics;
+    if ((userDataBindMask & (1u << PipelineBindCompute)) != 0)
+    {
+        m_allGpuState.palToApiPipeline[uint32_t(Pal::PipelineBindPoint::Compute)] = PipelineBindCompute;
+    }
+
+    if ((userDataBindMask & (1u << PipelineBindGraphics)) != 0)
+    {
+        m_allGpuState.palToApiPipeline[uint32_t(Pal::PipelineBindPoint::Graphics)] = PipelineBindGraphics;
+    }
 
     const uint32_t numPalDevices = m_pDevice->NumPalDevices();
     uint32_t deviceIdx           = 0;
@@ -1332,17 +1702,21 @@ void CmdBuffer::ResetPipelineState()
     {
         PerGpuRenderState* pPerGpuState = PerGpuState(deviceIdx);
 
-        pPerGpuState->pMsaaState                = nullptr;
-        pPerGpuState->pColorBlendState          = nullptr;
-        pPerGpuState->pDepthStencilState        = nullptr;
-        pPerGpuState->scissor.count             = 0;
-        pPerGpuState->viewport.count            = 0;
-        pPerGpuState->viewport.horzClipRatio    = FLT_MAX;
-        pPerGpuState->viewport.vertClipRatio    = FLT_MAX;
-        pPerGpuState->viewport.horzDiscardRatio = 1.0f;
-        pPerGpuState->viewport.vertDiscardRatio = 1.0f;
-        pPerGpuState->viewport.depthRange       = Pal::DepthRange::ZeroToOne;
-        pPerGpuState->maxPipelineStackSize      = 0;
+        if ((resetStateMask & TrackedStateGraphics) != 0)
+        {
+            pPerGpuState->pMsaaState                = nullptr;
+            pPerGpuState->pColorBlendState          = nullptr;
+            pPerGpuState->pDepthStencilState        = nullptr;
+            pPerGpuState->scissor.count             = 0;
+            pPerGpuState->viewport.count            = 0;
+            pPerGpuState->viewport.horzClipRatio    = FLT_MAX;
+            pPerGpuState->viewport.vertClipRatio    = FLT_MAX;
+            pPerGpuState->viewport.horzDiscardRatio = 1.0f;
+            pPerGpuState->viewport.vertDiscardRatio = 1.0f;
+            pPerGpuState->viewport.depthRange       = Pal::DepthRange::ZeroToOne;
+        }
+
+        pPerGpuState->maxPipelineStackSize = 0;
 
         deviceIdx++;
     }
@@ -1363,7 +1737,7 @@ void CmdBuffer::ResetState()
     // prior values are unknown.  Since DynamicRenderStateToken is 0, this is covered by the memset above.
     static_assert(DynamicRenderStateToken == 0, "Unexpected value!");
 
-    ResetPipelineState();
+    ResetPipelineState(AllPipelineBindMask, TrackedStateAll);
 
     m_curDeviceMask = InvalidPalDeviceMask;
 
@@ -1371,15 +1745,46 @@ void CmdBuffer::ResetState()
     m_renderPassInstance.subpass      = VK_SUBPASS_EXTERNAL;
     m_renderPassInstance.flags.u32All = 0;
 
+    memset(&m_dynamicRendering, 0, sizeof(m_dynamicRendering));
+
     m_recordingResult = VK_SUCCESS;
 
     m_flags.hasConditionalRendering = false;
 
+    memset(&m_stats, 0, sizeof(m_stats));
+
+    m_pendingQueryReset.pPool = nullptr;
+
+    m_lastImageClear.pImage = nullptr;
+
+    if (m_pTransformFeedbackState != nullptr)
+    {
+        m_pTransformFeedbackState->enabled       = false;
+        m_pTransformFeedbackState->unbindPending = false;
+    }
+
+    ForgetTransformFeedbackCounters();
+
+    // The command buffer isn't pending anymore, so the GPU is done with all earlier uploads
+    m_uploadRing.Reset();
+
+    if (m_pBarrierFilterState != nullptr)
+    {
+        m_pBarrierFilterState->Reset();
+    }
+
+    if (m_pLayoutState != nullptr)
+    {
+        m_pLayoutState->Reset();
+    }
 }
 
 // =====================================================================================================================
-// Reset Vulkan command buffer
-VkResult CmdBuffer::Reset(VkCommandBufferResetFlags flags)
+// Reset Vulkan command buffer.  allowWarmChunks is false when the caller is about to reset the PAL command allocator
+// itself, in which case the command buffer must not keep any chunks.
+VkResult CmdBuffer::Reset(
+    VkCommandBufferResetFlags flags,
+    bool                      allowWarmChunks)
 {
     VkResult result = VK_SUCCESS;
 
@@ -1406,7 +1811,40 @@ VkResult CmdBuffer::Reset(VkCommandBufferResetFlags flags)
             ReleaseResources();
         }
 
-        result = PalToVkResult(PalCmdBufferReset(nullptr, releaseResources));
+        // The command buffer isn't pending, so whatever it measured has landed.
+        if (m_pGpuTiming != nullptr)
+        {
+            m_pGpuTiming->Resolve();
+        }
+
+        if (m_pPipelineStats != nullptr)
+        {
+            m_pPipelineStats->Resolve();
+        }
+
+        if (m_pBarrierProfile != nullptr)
+        {
+            m_pBarrierProfile->Resolve();
+
+            m_flags.barrierProfileActive = false;
+        }
+
+        // Keep the command chunks for the next recording unless the last one needed much less than we hold; going
+        // back to the allocator for every chunk costs far more than reusing the ones we already have.
+        bool returnGpuMemory = releaseResources;
+
+        if (returnGpuMemory && allowWarmChunks && m_flags.keepWarmChunks &&
+            (m_cmdDataUsedSize >= (m_cmdDataHighWater / 2)))
+        {
+            returnGpuMemory = false;
+        }
+
+        if (returnGpuMemory || (allowWarmChunks == false))
+        {
+            m_cmdDataHighWater = 0;
+        }
+
+        result = PalToVkResult(PalCmdBufferReset(nullptr, returnGpuMemory));
 
         m_flags.wasBegun = false;
     }
@@ -1489,6 +1927,9 @@ void CmdBuffer::RebindPipeline()
     {
         const GraphicsPipeline* pPipeline = m_allGpuState.pGraphicsPipeline;
 
+        // The pipeline programs its static state and updates the tracked values of it
+        m_touchedStateMask |= TrackedStateGraphics;
+
         if (pPipeline != nullptr)
         {
             pPipeline->BindToCmdBuffer(this, pPipeline->GetBindInfo());
@@ -1557,6 +1998,8 @@ void CmdBuffer::BindPipeline(
 {
     DbgBarrierPreCmd(DbgBarrierBindPipeline);
 
+    m_stats.pipelineBindCount++;
+
     switch (pipelineBindPoint)
     {
     case VK_PIPELINE_BIND_POINT_COMPUTE:
@@ -1617,6 +2060,8 @@ CmdBuffer::RebindUserDataFlags CmdBuffer::SwitchUserDataLayouts(
 
     PipelineBindState* pBindState = &m_allGpuState.pipelineState[apiBindPoint];
 
+    m_touchedUserDataMask |= (1u << apiBindPoint);
+
     RebindUserDataFlags flags = 0;
 
     const UserDataLayout& newUserDataLayout = *pNewUserDataLayout;
@@ -1652,14 +2097,30 @@ void CmdBuffer::RebindUserData(
 {
     VK_ASSERT(flags != 0);
 
-    const PipelineBindState& bindState   = m_allGpuState.pipelineState[apiBindPoint];
+    PipelineBindState&    bindState      = m_allGpuState.pipelineState[apiBindPoint];
     const UserDataLayout& userDataLayout = bindState.userDataLayout;
 
+    m_touchedUserDataMask |= (1u << apiBindPoint);
+
     if ((flags & RebindUserDataDescriptorSets) != 0)
     {
         const uint32_t count = Util::Min(userDataLayout.setBindingRegCount, bindState.boundSetCount);
 
-        if (count > 0)
+        bindState.setBindingProgrammedCount = count;
+
+        if (m_pDeviceGroupStream != nullptr)
+        {
+            if (count > 0)
+            {
+                m_pDeviceGroupStream->CmdSetUserData(m_curDeviceMask,
+                                                     palBindPoint,
+                                                     userDataLayout.setBindingRegBase,
+                                                     count,
+                                                     sizeof(PerGpuRenderState),
+                                                     PerGpuState(0)->setBindingData[apiBindPoint]);
+            }
+        }
+        else if (count > 0)
         {
             utils::IterateMask deviceGroup(m_curDeviceMask);
             do
@@ -1678,6 +2139,10 @@ void CmdBuffer::RebindUserData(
     {
         const uint32_t count = Util::Min(userDataLayout.pushConstRegCount, bindState.pushedConstCount);
 
+        // Whatever was programmed before belongs to the old base or binding owner; only the dwords written below are
+        // known to be current now.
+        bindState.pushConstProgrammedMask = static_cast<uint32_t>((uint64_t(1) << count) - 1);
+
         if (count > 0)
         {
             // perDeviceStride is zero here because push constant data is replicated for all devices.
@@ -1700,48 +2165,232 @@ void CmdBuffer::ExecuteCommands(
     uint32_t                                    cmdBufferCount,
     const VkCommandBuffer*                      pCmdBuffers)
 {
+    FlushQueryResets();
+
+    ForgetImageClear();
+
+    // Secondary command buffers may draw
+    UnbindTransformFeedbackTargets();
+
     DbgBarrierPreCmd(DbgBarrierExecuteCommands);
 
-    for (uint32_t i = 0; i < cmdBufferCount; i++)
+    constexpr uint32_t MaxNestedCmdBuffersPerCall = 16;
+
+    Pal::ICmdBuffer* pPalNestedCmdBuffers[MaxNestedCmdBuffersPerCall];
+
+    // Secondaries which recorded their footprint only change the tracked state it covers; all others may change any.
+    uint32_t userDataBindMask = 0;
+    uint32_t stateMask        = 0;
+
+    for (uint32_t first = 0; first < cmdBufferCount; first += MaxNestedCmdBuffersPerCall)
     {
-        CmdBuffer* pInteralCmdBuf = ApiCmdBuffer::ObjectFromHandle(pCmdBuffers[i]);
+        const uint32_t count = Util::Min(cmdBufferCount - first, MaxNestedCmdBuffersPerCall);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const CmdBuffer* pInteralCmdBuf = ApiCmdBuffer::ObjectFromHandle(pCmdBuffers[first + i]);
+
+            userDataBindMask |= pInteralCmdBuf->m_footprintUserDataMask;
+            stateMask        |= pInteralCmdBuf->m_footprintStateMask;
+
+            if (m_pLayoutState != nullptr)
+            {
+                m_pLayoutState->Merge(*pInteralCmdBuf->m_pLayoutState);
+            }
+        }
 
         utils::IterateMask deviceGroup(m_curDeviceMask);
         do
         {
             const uint32_t deviceIdx = deviceGroup.Index();
 
-            Pal::ICmdBuffer* pPalNestedCmdBuffer = pInteralCmdBuf->PalCmdBuffer(deviceIdx);
-            PalCmdBuffer(deviceIdx)->CmdExecuteNestedCmdBuffers(1, &pPalNestedCmdBuffer);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                CmdBuffer* pInteralCmdBuf = ApiCmdBuffer::ObjectFromHandle(pCmdBuffers[first + i]);
+
+                pPalNestedCmdBuffers[i] = pInteralCmdBuf->PalCmdBuffer(deviceIdx);
+            }
+
+            PalCmdBuffer(deviceIdx)->CmdExecuteNestedCmdBuffers(count, pPalNestedCmdBuffers);
         }
         while (deviceGroup.IterateNext());
     }
 
     // Executing secondary command buffer will clear the states of Graphic Pipeline
     // in that case they cannot be used after ends of execution secondary command buffer
-    ResetPipelineState();
+    ResetPipelineState(userDataBindMask, stateMask);
 
     DbgBarrierPostCmd(DbgBarrierExecuteCommands);
 }
 
 // =====================================================================================================================
-// Destroy a command buffer object
-VkResult CmdBuffer::Destroy(void)
+// Reports the recording statistics of this command buffer to the application's VK_EXT_debug_utils messengers as an
+// informational performance message with the command buffer as its object.  This is cheap enough to leave enabled in
+// the field, unlike an SQTT capture.
+void CmdBuffer::ReportStats()
 {
-    Instance* const pInstance = m_pDevice->VkInstance();
+    const Pal::gpusize cmdStreamBytes = PalCmdBuffer(DefaultDeviceIndex)->GetUsedSize(Pal::CommandDataAlloc);
 
-    if (m_pSqttState != nullptr)
-    {
+    char message[512];
+
+    Util::Snprintf(message,
+                   sizeof(message),
+                   "Command buffer stats: draws=%llu dispatches=%llu barriers=%llu descriptorSetBinds=%llu "
+                   "pipelineBinds=%llu skippedStateGroups=%llu redundantStateSets=%llu mergedQueryResets=%llu "
+                   "elidedClears=%llu cmdStreamBytes=%llu",
+                   m_stats.drawCount,
+                   m_stats.dispatchCount,
+                   m_stats.barrierCount,
+                   m_stats.descriptorSetBindCount,
+                   m_stats.pipelineBindCount,
+                   m_stats.skippedStateGroupCount,
+                   m_stats.filteredStateCount,
+                   m_stats.mergedQueryResetCount,
+                   m_stats.elidedClearCount,
+                   cmdStreamBytes);
+
+    VkDebugUtilsObjectNameInfoEXT object = {};
+    object.sType        = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+    object.objectType   = VK_OBJECT_TYPE_COMMAND_BUFFER;
+    object.objectHandle = reinterpret_cast<uint64_t>(ApiCmdBuffer::FromObject(this));
+    object.pObjectName  = m_pDebugName;
+
+    VkDebugUtilsMessengerCallbackDataEXT callbackData = {};
+    callbackData.sType          = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CALLBACK_DATA_EXT;
+    callbackData.pMessageIdName = "AMD-CmdBufferStats";
+    callbackData.pMessage       = message;
+    callbackData.objectCount    = 1;
+    callbackData.pObjects       = &object;
+
+    m_pDevice->VkInstance()->CallExternalMessengers(VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT,
+                                                    VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
+                                                    &callbackData);
+}
+
+// =====================================================================================================================
+// Samples how much command data the recording that just ended used.  The high-water mark approximates how much command
+// memory the PAL command buffers keep when they are reset without returning it.
+void CmdBuffer::UpdateCmdDataUsage()
+{
+    m_cmdDataUsedSize = 0;
+
+    utils::IterateMask deviceGroup(m_cbBeginDeviceMask);
+    do
+    {
+        const uint32_t deviceIdx = deviceGroup.Index();
+
+        m_cmdDataUsedSize = Util::Max(m_cmdDataUsedSize,
+                                      PalCmdBuffer(deviceIdx)->GetUsedSize(Pal::CommandDataAlloc));
+    }
+    while (deviceGroup.IterateNext());
+
+    m_cmdDataHighWater = Util::Max(m_cmdDataHighWater, m_cmdDataUsedSize);
+}
+
+// =====================================================================================================================
+// Reports how much memory of each allocation type the recording that just ended used to the pool, which sizes its
+// CmdAllocators after it.
+void CmdBuffer::ReportCmdAllocatorUsage()
+{
+    Pal::gpusize usedSizes[Pal::CmdAllocatorTypeCount] = {};
+
+    utils::IterateMask deviceGroup(m_cbBeginDeviceMask);
+    do
+    {
+        const uint32_t deviceIdx = deviceGroup.Index();
+
+        for (uint32_t type = 0; type < Pal::CmdAllocatorTypeCount; ++type)
+        {
+            usedSizes[type] = Util::Max(usedSizes[type],
+                                        PalCmdBuffer(deviceIdx)->GetUsedSize(static_cast<Pal::CmdAllocType>(type)));
+        }
+    }
+    while (deviceGroup.IterateNext());
+
+    m_pCmdPool->RecordCmdAllocatorUsage(usedSizes);
+}
+
+// =====================================================================================================================
+// Moves the PAL command buffers onto the CmdAllocators the pool currently uses.  Called by the pool when it replaces
+// its allocators, after the command buffer has been reset with its resources released.
+VkResult CmdBuffer::AdoptPoolCmdAllocators()
+{
+    Pal::Result result = Pal::Result::Success;
+
+    for (uint32_t deviceIdx = 0;
+         (deviceIdx < m_pDevice->NumPalDevices()) && (result == Pal::Result::Success);
+         deviceIdx++)
+    {
+        result = PalCmdBuffer(deviceIdx)->Reset(m_pCmdPool->PalCmdAllocator(deviceIdx), true);
+    }
+
+    return PalToVkResult(result);
+}
+
+// =====================================================================================================================
+// Destroy a command buffer object
+VkResult CmdBuffer::Destroy(void)
+{
+    Instance* const pInstance = m_pDevice->VkInstance();
+
+    if (m_pSqttState != nullptr)
+    {
         Util::Destructor(m_pSqttState);
 
         pInstance->FreeMem(m_pSqttState);
     }
 
+    if (m_pBarrierFilterState != nullptr)
+    {
+        Util::Destructor(m_pBarrierFilterState);
+
+        pInstance->FreeMem(m_pBarrierFilterState);
+    }
+
+    if (m_pLayoutState != nullptr)
+    {
+        Util::Destructor(m_pLayoutState);
+
+        pInstance->FreeMem(m_pLayoutState);
+    }
+
+    if (m_pGpuTiming != nullptr)
+    {
+        m_pGpuTiming->Destroy();
+
+        Util::Destructor(m_pGpuTiming);
+
+        pInstance->FreeMem(m_pGpuTiming);
+    }
+
+    if (m_pPipelineStats != nullptr)
+    {
+        m_pPipelineStats->Destroy();
+
+        Util::Destructor(m_pPipelineStats);
+
+        pInstance->FreeMem(m_pPipelineStats);
+    }
+
+    if (m_pBarrierProfile != nullptr)
+    {
+        m_pBarrierProfile->Destroy();
+
+        Util::Destructor(m_pBarrierProfile);
+
+        pInstance->FreeMem(m_pBarrierProfile);
+    }
+
     if (m_pTransformFeedbackState != nullptr)
     {
         pInstance->FreeMem(m_pTransformFeedbackState);
     }
 
+    if (m_pDeviceGroupStream != nullptr)
+    {
+        m_pDeviceGroupStream->Destroy(pInstance);
+    }
+
     // Unregister this command buffer from the pool
     m_pCmdPool->UnregisterCmdBuffer(this);
 
@@ -1795,6 +2444,8 @@ void CmdBuffer::ReleaseResources()
 
         m_pStackAllocator = nullptr;
     }
+
+    m_uploadRing.Destroy();
 }
 
 // =====================================================================================================================
@@ -1810,6 +2461,8 @@ void CmdBuffer::BindDescriptorSets(
 {
     DbgBarrierPreCmd(DbgBarrierBindSetsPushConstants);
 
+    m_stats.descriptorSetBindCount += setCount;
+
     if (setCount > 0)
     {
         Pal::PipelineBindPoint palBindPoint;
@@ -1820,6 +2473,8 @@ void CmdBuffer::BindDescriptorSets(
         // Get the current binding state in the command buffer
         PipelineBindState* pBindState = &m_allGpuState.pipelineState[apiBindPoint];
 
+        m_touchedUserDataMask |= (1u << apiBindPoint);
+
         const PipelineLayout* pLayout = PipelineLayout::ObjectFromHandle(layout);
 
         // Get user data register information from the given pipeline layout
@@ -1828,6 +2483,46 @@ void CmdBuffer::BindDescriptorSets(
         // Update descriptor set binding data shadow.
         VK_ASSERT((firstSet + setCount) <= layoutInfo.setCount);
 
+        // Figure out the total range of user data registers written by this sequence of descriptor set binds
+        const PipelineLayout::SetUserDataLayout& firstSetLayout = pLayout->GetSetUserData(firstSet);
+        const PipelineLayout::SetUserDataLayout& lastSetLayout = pLayout->GetSetUserData(firstSet + setCount - 1);
+
+        const uint32_t rangeOffsetBegin = firstSetLayout.firstRegOffset;
+        const uint32_t rangeOffsetEnd = lastSetLayout.firstRegOffset + lastSetLayout.totalRegCount;
+
+        // Descriptor set with zero resource binding is allowed in spec, so we need to check this and only proceed when
+        // there are at least 1 user data to update.
+        const uint32_t rangeRegCount = rangeOffsetEnd - rangeOffsetBegin;
+
+        // Program the user data register only if the current user data layout base matches that of the given
+        // layout.  Otherwise, what's happening is that the application is binding descriptor sets for a future
+        // pipeline layout (e.g. at the top of the command buffer) and this register write will be redundant.  A
+        // future vkCmdBindPipeline will reprogram the user data register.
+        const bool programUserData =
+            (rangeRegCount > 0) &&
+            PalPipelineBindingOwnedBy(palBindPoint, apiBindPoint) &&
+            (pBindState->userDataLayout.setBindingRegBase == layoutInfo.userDataLayout.setBindingRegBase);
+
+        // Engines often rebind all sets when only one of them changed.  Remember the values of the range which are
+        // known to be programmed already, so that only the entries which actually change are written below.
+        const uint32_t knownRegEnd = programUserData ?
+            Util::Max(rangeOffsetBegin, Util::Min(pBindState->setBindingProgrammedCount, rangeOffsetEnd)) : 0;
+
+        uint32_t prevSetBindingData[numPalDevices][MaxBindingRegCount];
+
+        if (knownRegEnd > rangeOffsetBegin)
+        {
+            utils::IterateMask deviceGroup(m_curDeviceMask);
+            do
+            {
+                const uint32_t deviceIdx = deviceGroup.Index();
+
+                memcpy(prevSetBindingData[deviceIdx],
+                       &(PerGpuState(deviceIdx)->setBindingData[apiBindPoint][rangeOffsetBegin]),
+                       (knownRegEnd - rangeOffsetBegin) * sizeof(uint32_t));
+            } while (deviceGroup.IterateNext());
+        }
+
         for (uint32_t i = 0; i < setCount; ++i)
         {
             // Compute set binding point index
@@ -1880,29 +2575,66 @@ void CmdBuffer::BindDescriptorSets(
             }
         }
 
-        // Figure out the total range of user data registers written by this sequence of descriptor set binds
-        const PipelineLayout::SetUserDataLayout& firstSetLayout = pLayout->GetSetUserData(firstSet);
-        const PipelineLayout::SetUserDataLayout& lastSetLayout = pLayout->GetSetUserData(firstSet + setCount - 1);
-
-        const uint32_t rangeOffsetBegin = firstSetLayout.firstRegOffset;
-        const uint32_t rangeOffsetEnd = lastSetLayout.firstRegOffset + lastSetLayout.totalRegCount;
-
         // Update the high watermark of number of user data entries written for currently bound descriptor sets and
         // their dynamic offsets in the current command buffer state.
         pBindState->boundSetCount = Util::Max(pBindState->boundSetCount, rangeOffsetEnd);
 
-        // Descriptor set with zero resource binding is allowed in spec, so we need to check this and only proceed when
-        // there are at least 1 user data to update.
-        const uint32_t rangeRegCount = rangeOffsetEnd - rangeOffsetBegin;
-
-        if (rangeRegCount > 0)
+        if (programUserData)
         {
-            // Program the user data register only if the current user data layout base matches that of the given
-            // layout.  Otherwise, what's happening is that the application is binding descriptor sets for a future
-            // pipeline layout (e.g. at the top of the command buffer) and this register write will be redundant.  A
-            // future vkCmdBindPipeline will reprogram the user data register.
-            if (PalPipelineBindingOwnedBy(palBindPoint, apiBindPoint) &&
-                (pBindState->userDataLayout.setBindingRegBase == layoutInfo.userDataLayout.setBindingRegBase))
+            // Entries past knownRegEnd always have to be written; before it only those whose value changed on any
+            // device.  The span between the first and last such entry is written to every device.
+            uint32_t firstChangedReg = knownRegEnd;
+            uint32_t lastChangedReg  = rangeOffsetEnd - 1;
+
+            if (knownRegEnd > rangeOffsetBegin)
+            {
+                utils::IterateMask deviceGroup(m_curDeviceMask);
+                do
+                {
+                    const uint32_t  deviceIdx = deviceGroup.Index();
+                    const uint32_t* pNewData  = PerGpuState(deviceIdx)->setBindingData[apiBindPoint];
+
+                    for (uint32_t reg = rangeOffsetBegin; reg < firstChangedReg; ++reg)
+                    {
+                        if (pNewData[reg] != prevSetBindingData[deviceIdx][reg - rangeOffsetBegin])
+                        {
+                            firstChangedReg = reg;
+                        }
+                    }
+                } while (deviceGroup.IterateNext());
+
+                if (knownRegEnd == rangeOffsetEnd)
+                {
+                    lastChangedReg = rangeOffsetBegin;
+
+                    utils::IterateMask lastDeviceGroup(m_curDeviceMask);
+                    do
+                    {
+                        const uint32_t  deviceIdx = lastDeviceGroup.Index();
+                        const uint32_t* pNewData  = PerGpuState(deviceIdx)->setBindingData[apiBindPoint];
+
+                        for (uint32_t reg = rangeOffsetEnd - 1; reg > lastChangedReg; --reg)
+                        {
+                            if (pNewData[reg] != prevSetBindingData[deviceIdx][reg - rangeOffsetBegin])
+                            {
+                                lastChangedReg = reg;
+                            }
+                        }
+                    } while (lastDeviceGroup.IterateNext());
+                }
+            }
+
+            if ((firstChangedReg <= lastChangedReg) && (m_pDeviceGroupStream != nullptr))
+            {
+                m_pDeviceGroupStream->CmdSetUserData(
+                    m_curDeviceMask,
+                    palBindPoint,
+                    pBindState->userDataLayout.setBindingRegBase + firstChangedReg,
+                    lastChangedReg - firstChangedReg + 1,
+                    sizeof(PerGpuRenderState),
+                    &(PerGpuState(0)->setBindingData[apiBindPoint][firstChangedReg]));
+            }
+            else if (firstChangedReg <= lastChangedReg)
             {
                 utils::IterateMask deviceGroup(m_curDeviceMask);
                 do
@@ -1911,11 +2643,23 @@ void CmdBuffer::BindDescriptorSets(
 
                     PalCmdBuffer(deviceIdx)->CmdSetUserData(
                         palBindPoint,
-                        pBindState->userDataLayout.setBindingRegBase + rangeOffsetBegin,
-                        rangeRegCount,
-                        &(PerGpuState(deviceIdx)->setBindingData[apiBindPoint][rangeOffsetBegin]));
+                        pBindState->userDataLayout.setBindingRegBase + firstChangedReg,
+                        lastChangedReg - firstChangedReg + 1,
+                        &(PerGpuState(deviceIdx)->setBindingData[apiBindPoint][firstChangedReg]));
                 } while (deviceGroup.IterateNext());
             }
+
+            // The whole range is programmed now; it extends the known prefix if it starts within or right after it.
+            if (rangeOffsetBegin <= pBindState->setBindingProgrammedCount)
+            {
+                pBindState->setBindingProgrammedCount =
+                    Util::Max(pBindState->setBindingProgrammedCount, rangeOffsetEnd);
+            }
+        }
+        else if (rangeRegCount > 0)
+        {
+            // The shadow now holds values which haven't been programmed.
+            pBindState->setBindingProgrammedCount = Util::Min(pBindState->setBindingProgrammedCount, rangeOffsetBegin);
         }
     }
 
@@ -2008,71 +2752,245 @@ PFN_vkCmdBindDescriptorSets CmdBuffer::GetCmdBindDescriptorSetsFunc(
 }
 
 // =====================================================================================================================
-void CmdBuffer::BindIndexBuffer(
-    VkBuffer     buffer,
-    VkDeviceSize offset,
-    VkIndexType  indexType)
+template <uint32_t numPalDevices>
+VKAPI_ATTR void VKAPI_CALL CmdBuffer::CmdDraw(
+    VkCommandBuffer                             cmdBuffer,
+    uint32_t                                    vertexCount,
+    uint32_t                                    instanceCount,
+    uint32_t                                    firstVertex,
+    uint32_t                                    firstInstance)
 {
-    DbgBarrierPreCmd(DbgBarrierBindIndexVertexBuffer);
-
-    const Pal::IndexType palIndexType = VkToPalIndexType(indexType);
-    Buffer* pBuffer = Buffer::ObjectFromHandle(buffer);
-
-    if (pBuffer != NULL)
-    {
-        PalCmdBindIndexData(pBuffer, offset, palIndexType);
-    }
-    else
-    {
-        PalCmdUnbindIndexData(palIndexType);
-    }
-
-    DbgBarrierPostCmd(DbgBarrierBindIndexVertexBuffer);
+    ApiCmdBuffer::ObjectFromHandle(cmdBuffer)->Draw<numPalDevices>(
+        firstVertex,
+        vertexCount,
+        firstInstance,
+        instanceCount);
 }
 
 // =====================================================================================================================
-// Initializes VB binding manager state.  Should be called when the command buffer is being initialized.
-void CmdBuffer::InitializeVertexBuffer()
+template <uint32_t numPalDevices>
+VKAPI_ATTR void VKAPI_CALL CmdBuffer::CmdDrawIndexed(
+    VkCommandBuffer                             cmdBuffer,
+    uint32_t                                    indexCount,
+    uint32_t                                    instanceCount,
+    uint32_t                                    firstIndex,
+    int32_t                                     vertexOffset,
+    uint32_t                                    firstInstance)
 {
-    for (uint32 deviceIdx = 0; deviceIdx < m_pDevice->NumPalDevices(); deviceIdx++)
-    {
-        Pal::BufferViewInfo* pBindings = &PerGpuState(deviceIdx)->vbBindings[0];
-
-        for (uint32 i = 0; i < Pal::MaxVertexBuffers; ++i)
-        {
-            // Format needs to be set to invalid for struct srv SRDs
-            pBindings[i].swizzledFormat = Pal::UndefinedSwizzledFormat;
-            pBindings[i].gpuAddr        = 0;
-            pBindings[i].range          = 0;
-            pBindings[i].stride         = 0;
-            pBindings[i].flags.u32All   = 0;
-        }
-    }
+    ApiCmdBuffer::ObjectFromHandle(cmdBuffer)->DrawIndexed<numPalDevices>(
+        firstIndex,
+        indexCount,
+        vertexOffset,
+        firstInstance,
+        instanceCount);
+}
 
-    m_vbWatermark = 0;
+// =====================================================================================================================
+template <uint32_t numPalDevices>
+VKAPI_ATTR void VKAPI_CALL CmdBuffer::CmdDispatch(
+    VkCommandBuffer                             cmdBuffer,
+    uint32_t                                    x,
+    uint32_t                                    y,
+    uint32_t                                    z)
+{
+    ApiCmdBuffer::ObjectFromHandle(cmdBuffer)->Dispatch<numPalDevices>(x, y, z);
 }
 
 // =====================================================================================================================
-// Called to reset the state of the VB manager because the parent command buffer is being reset.
-void CmdBuffer::ResetVertexBuffer()
+template <uint32_t numPalDevices>
+VKAPI_ATTR void VKAPI_CALL CmdBuffer::CmdPushConstants(
+    VkCommandBuffer                             cmdBuffer,
+    VkPipelineLayout                            layout,
+    VkShaderStageFlags                          stageFlags,
+    uint32_t                                    offset,
+    uint32_t                                    size,
+    const void*                                 pValues)
 {
-    for (uint32 deviceIdx = 0; deviceIdx < m_pDevice->NumPalDevices(); deviceIdx++)
-    {
-        Pal::BufferViewInfo* pBindings = &PerGpuState(deviceIdx)->vbBindings[0];
+    ApiCmdBuffer::ObjectFromHandle(cmdBuffer)->PushConstants<numPalDevices>(
+        layout,
+        stageFlags,
+        offset,
+        size,
+        pValues);
+}
 
-        for (uint32 i = 0; i < m_vbWatermark; ++i)
-        {
-            pBindings[i].gpuAddr = 0;
-            pBindings[i].range   = 0;
-            pBindings[i].stride  = 0;
-        }
-    }
+// =====================================================================================================================
+template <uint32_t numPalDevices>
+VKAPI_ATTR void VKAPI_CALL CmdBuffer::CmdBindVertexBuffers(
+    VkCommandBuffer                             cmdBuffer,
+    uint32_t                                    firstBinding,
+    uint32_t                                    bindingCount,
+    const VkBuffer*                             pBuffers,
+    const VkDeviceSize*                         pOffsets)
+{
+    ApiCmdBuffer::ObjectFromHandle(cmdBuffer)->BindVertexBuffers<numPalDevices>(
+        firstBinding,
+        bindingCount,
+        pBuffers,
+        pOffsets,
+        nullptr,
+        nullptr);
+}
 
-    m_vbWatermark = 0;
+// =====================================================================================================================
+template <uint32_t numPalDevices>
+VKAPI_ATTR void VKAPI_CALL CmdBuffer::CmdSetViewport(
+    VkCommandBuffer                             cmdBuffer,
+    uint32_t                                    firstViewport,
+    uint32_t                                    viewportCount,
+    const VkViewport*                           pViewports)
+{
+    ApiCmdBuffer::ObjectFromHandle(cmdBuffer)->SetViewport<numPalDevices>(firstViewport, viewportCount, pViewports);
+}
+
+// =====================================================================================================================
+template <uint32_t numPalDevices>
+VKAPI_ATTR void VKAPI_CALL CmdBuffer::CmdSetScissor(
+    VkCommandBuffer                             cmdBuffer,
+    uint32_t                                    firstScissor,
+    uint32_t                                    scissorCount,
+    const VkRect2D*                             pScissors)
+{
+    ApiCmdBuffer::ObjectFromHandle(cmdBuffer)->SetScissor<numPalDevices>(firstScissor, scissorCount, pScissors);
+}
+
+// =====================================================================================================================
+// Single-GPU devices get an entry point without device mask iteration; other devices keep the generic one.
+PFN_vkCmdDraw CmdBuffer::GetCmdDrawFunc(
+    const Device* pDevice)
+{
+    return (pDevice->NumPalDevices() == 1) ? CmdDraw<1> : entry::vkCmdDraw;
+}
+
+// =====================================================================================================================
+PFN_vkCmdDrawIndexed CmdBuffer::GetCmdDrawIndexedFunc(
+    const Device* pDevice)
+{
+    return (pDevice->NumPalDevices() == 1) ? CmdDrawIndexed<1> : entry::vkCmdDrawIndexed;
+}
+
+// =====================================================================================================================
+PFN_vkCmdDispatch CmdBuffer::GetCmdDispatchFunc(
+    const Device* pDevice)
+{
+    return (pDevice->NumPalDevices() == 1) ? CmdDispatch<1> : entry::vkCmdDispatch;
+}
+
+// =====================================================================================================================
+PFN_vkCmdPushConstants CmdBuffer::GetCmdPushConstantsFunc(
+    const Device* pDevice)
+{
+    return (pDevice->NumPalDevices() == 1) ? CmdPushConstants<1> : entry::vkCmdPushConstants;
+}
+
+// =====================================================================================================================
+PFN_vkCmdBindVertexBuffers CmdBuffer::GetCmdBindVertexBuffersFunc(
+    const Device* pDevice)
+{
+    return (pDevice->NumPalDevices() == 1) ? CmdBindVertexBuffers<1> : entry::vkCmdBindVertexBuffers;
+}
+
+// =====================================================================================================================
+PFN_vkCmdSetViewport CmdBuffer::GetCmdSetViewportFunc(
+    const Device* pDevice)
+{
+    return (pDevice->NumPalDevices() == 1) ? CmdSetViewport<1> : entry::vkCmdSetViewport;
+}
+
+// =====================================================================================================================
+PFN_vkCmdSetScissor CmdBuffer::GetCmdSetScissorFunc(
+    const Device* pDevice)
+{
+    return (pDevice->NumPalDevices() == 1) ? CmdSetScissor<1> : entry::vkCmdSetScissor;
+}
+
+// =====================================================================================================================
+void CmdBuffer::BindIndexBuffer(
+    VkBuffer     buffer,
+    VkDeviceSize offset,
+    VkIndexType  indexType)
+{
+    m_touchedStateMask |= TrackedStateGraphics;
+
+    const Pal::IndexType palIndexType = VkToPalIndexType(indexType);
+    Buffer* pBuffer = Buffer::ObjectFromHandle(buffer);
+
+    // Engines often rebind the same index buffer for every draw; there is nothing to do for PAL in that case.
+    if (m_allGpuState.known.indexBuffer &&
+        (m_allGpuState.pIndexBuffer      == pBuffer) &&
+        (m_allGpuState.indexBufferOffset == offset) &&
+        (m_allGpuState.indexType         == palIndexType))
+    {
+        m_stats.filteredStateCount++;
+    }
+    else
+    {
+        DbgBarrierPreCmd(DbgBarrierBindIndexVertexBuffer);
+
+        if (pBuffer != NULL)
+        {
+            PalCmdBindIndexData(pBuffer, offset, palIndexType);
+        }
+        else
+        {
+            PalCmdUnbindIndexData(palIndexType);
+        }
+
+        m_allGpuState.pIndexBuffer      = pBuffer;
+        m_allGpuState.indexBufferOffset = offset;
+        m_allGpuState.indexType         = palIndexType;
+        m_allGpuState.known.indexBuffer = 1;
+
+        DbgBarrierPostCmd(DbgBarrierBindIndexVertexBuffer);
+    }
+}
+
+// =====================================================================================================================
+// Initializes VB binding manager state.  Should be called when the command buffer is being initialized.
+void CmdBuffer::InitializeVertexBuffer()
+{
+    for (uint32 deviceIdx = 0; deviceIdx < m_pDevice->NumPalDevices(); deviceIdx++)
+    {
+        Pal::BufferViewInfo* pBindings = &PerGpuState(deviceIdx)->vbBindings[0];
+
+        for (uint32 i = 0; i < Pal::MaxVertexBuffers; ++i)
+        {
+            // Format needs to be set to invalid for struct srv SRDs
+            pBindings[i].swizzledFormat = Pal::UndefinedSwizzledFormat;
+            pBindings[i].gpuAddr        = 0;
+            pBindings[i].range          = 0;
+            pBindings[i].stride         = 0;
+            pBindings[i].flags.u32All   = 0;
+        }
+    }
+
+    m_vbWatermark = 0;
+    m_vbKnownMask = 0;
+}
+
+// =====================================================================================================================
+// Called to reset the state of the VB manager because the parent command buffer is being reset.
+void CmdBuffer::ResetVertexBuffer()
+{
+    for (uint32 deviceIdx = 0; deviceIdx < m_pDevice->NumPalDevices(); deviceIdx++)
+    {
+        Pal::BufferViewInfo* pBindings = &PerGpuState(deviceIdx)->vbBindings[0];
+
+        for (uint32 i = 0; i < m_vbWatermark; ++i)
+        {
+            pBindings[i].gpuAddr = 0;
+            pBindings[i].range   = 0;
+            pBindings[i].stride  = 0;
+        }
+    }
+
+    m_vbWatermark = 0;
+    m_vbKnownMask = 0;
 }
 
 // =====================================================================================================================
 // Implementation of vkCmdBindVertexBuffers
+template <uint32_t numPalDevices>
 void CmdBuffer::BindVertexBuffers(
     uint32_t            firstBinding,
     uint32_t            bindingCount,
@@ -2081,11 +2999,18 @@ void CmdBuffer::BindVertexBuffers(
     const VkDeviceSize* pSizes,
     const VkDeviceSize* pStrides)
 {
+    m_touchedStateMask |= TrackedStateVertexBuffers;
+
     DbgBarrierPreCmd(DbgBarrierBindIndexVertexBuffer);
 
-    const bool padVertexBuffers = m_flags.padVertexBuffers;
+    static_assert(Pal::MaxVertexBuffers < 64, "m_vbKnownMask is too small");
 
-    utils::IterateMask deviceGroup(GetDeviceMask());
+    const bool     padVertexBuffers = m_flags.padVertexBuffers;
+    const uint64_t bindingMask      = ((uint64_t(1) << bindingCount) - 1) << firstBinding;
+
+    bool anyChanged = false;
+
+    utils::IterateDeviceMask<numPalDevices> deviceGroup(GetDeviceMask());
     do
     {
         const uint32_t deviceIdx = deviceGroup.Index();
@@ -2094,11 +3019,18 @@ void CmdBuffer::BindVertexBuffers(
         Pal::BufferViewInfo* pEndBinding = pBinding + bindingCount;
         uint32_t             inputIdx    = 0;
 
+        uint32_t firstChanged = UINT_MAX;
+        uint32_t lastChanged  = 0;
+
         while (pBinding != pEndBinding)
         {
             const VkBuffer     buffer = pBuffers[inputIdx];
             const VkDeviceSize offset = pOffsets[inputIdx];
 
+            const Pal::gpusize prevGpuAddr = pBinding->gpuAddr;
+            const Pal::gpusize prevRange   = pBinding->range;
+            const Pal::gpusize prevStride  = pBinding->stride;
+
             if (buffer != VK_NULL_HANDLE)
             {
                 const Buffer* pBuffer = Buffer::ObjectFromHandle(buffer);
@@ -2122,16 +3054,40 @@ void CmdBuffer::BindVertexBuffers(
                 pBinding->range = Util::RoundUpToMultiple(pBinding->range, pBinding->stride);
             }
 
+            const uint32_t slot = firstBinding + inputIdx;
+
+            if (((m_vbKnownMask & (uint64_t(1) << slot)) == 0) ||
+                (pBinding->gpuAddr != prevGpuAddr)               ||
+                (pBinding->range   != prevRange)                 ||
+                (pBinding->stride  != prevStride))
+            {
+                firstChanged = Util::Min(firstChanged, slot);
+                lastChanged  = Util::Max(lastChanged, slot);
+            }
+
             inputIdx++;
             pBinding++;
         }
 
-        PalCmdBuffer(deviceIdx)->CmdSetVertexBuffers(
-            firstBinding, bindingCount, &PerGpuState(deviceIdx)->vbBindings[firstBinding]);
+        // Only the changed span is handed to PAL, which builds the vertex buffer SRDs.  Rebinding the same buffers
+        // costs no SRD construction at all.
+        if (firstChanged <= lastChanged)
+        {
+            PalCmdBuffer(deviceIdx)->CmdSetVertexBuffers(
+                firstChanged, (lastChanged - firstChanged) + 1, &PerGpuState(deviceIdx)->vbBindings[firstChanged]);
+
+            anyChanged = true;
+        }
     }
     while (deviceGroup.IterateNext());
 
-    m_vbWatermark = Util::Max(m_vbWatermark, firstBinding + bindingCount);
+    m_vbWatermark  = Util::Max(m_vbWatermark, firstBinding + bindingCount);
+    m_vbKnownMask |= bindingMask;
+
+    if (anyChanged == false)
+    {
+        m_stats.filteredStateCount++;
+    }
 
     DbgBarrierPostCmd(DbgBarrierBindIndexVertexBuffer);
 }
@@ -2140,6 +3096,8 @@ void CmdBuffer::BindVertexBuffers(
 void CmdBuffer::UpdateVertexBufferStrides(
     const GraphicsPipeline* pPipeline)
 {
+    m_touchedStateMask |= TrackedStateVertexBuffers;
+
     VK_ASSERT(pPipeline != nullptr);
 
     // Update strides for each binding used by the graphics pipeline.  Rebuild SRD data for those bindings
@@ -2175,6 +3133,11 @@ void CmdBuffer::UpdateVertexBufferStrides(
                     firstChanged = Util::Min(firstChanged, slot);
                     lastChanged  = Util::Max(lastChanged, slot);
                 }
+                else
+                {
+                    // Unbound slots aren't sent to PAL, so PAL's copy of this binding no longer matches.
+                    m_vbKnownMask &= ~(uint64_t(1) << slot);
+                }
 
                 if (padVertexBuffers && (pBinding->stride != 0))
                 {
@@ -2194,6 +3157,7 @@ void CmdBuffer::UpdateVertexBufferStrides(
 }
 
 // =====================================================================================================================
+template <uint32_t numPalDevices>
 void CmdBuffer::Draw(
     uint32_t firstVertex,
     uint32_t vertexCount,
@@ -2204,16 +3168,21 @@ void CmdBuffer::Draw(
 
     ValidateStates();
 
-    PalCmdDraw(firstVertex,
+    PipelineStatsPreCmd(PipelineBindGraphics);
+
+    PalCmdDraw<numPalDevices>(firstVertex,
         vertexCount,
         firstInstance,
         instanceCount,
         0u);
 
+    PipelineStatsPostCmd();
+
     DbgBarrierPostCmd(DbgBarrierDrawNonIndexed);
 }
 
 // =====================================================================================================================
+template <uint32_t numPalDevices>
 void CmdBuffer::DrawIndexed(
     uint32_t firstIndex,
     uint32_t indexCount,
@@ -2225,12 +3194,16 @@ void CmdBuffer::DrawIndexed(
 
     ValidateStates();
 
-    PalCmdDrawIndexed(firstIndex,
-                      indexCount,
-                      vertexOffset,
-                      firstInstance,
-                      instanceCount,
-                      0u);
+    PipelineStatsPreCmd(PipelineBindGraphics);
+
+    PalCmdDrawIndexed<numPalDevices>(firstIndex,
+                                     indexCount,
+                                     vertexOffset,
+                                     firstInstance,
+                                     instanceCount,
+                                     0u);
+
+    PipelineStatsPostCmd();
 
     DbgBarrierPostCmd(DbgBarrierDrawIndexed);
 }
@@ -2245,6 +3218,13 @@ void CmdBuffer::DrawIndirect(
     VkBuffer     countBuffer,
     VkDeviceSize countOffset)
 {
+    // A direct draw count of zero records nothing.  With a count buffer the actual count is only known on the GPU, so
+    // those calls always go through.
+    if ((useBufferCount == false) && (count == 0))
+    {
+        return;
+    }
+
     DbgBarrierPreCmd((indexed ? DbgBarrierDrawIndexed : DbgBarrierDrawNonIndexed) | DbgBarrierDrawIndirect);
 
     ValidateStates();
@@ -2253,18 +3233,23 @@ void CmdBuffer::DrawIndirect(
 
     if ((stride + offset) <= pBuffer->PalMemory(DefaultDeviceIndex)->Desc().size)
     {
-        const Pal::gpusize paramOffset = pBuffer->MemOffset() + offset;
-        Pal::gpusize countVirtAddr = 0;
+        const Pal::gpusize paramOffset   = pBuffer->MemOffset() + offset;
+        Buffer*            pCountBuffer  = useBufferCount ? Buffer::ObjectFromHandle(countBuffer) : nullptr;
+        Pal::gpusize       countVirtAddr = 0;
 
+        // The whole drawCount range (and the GPU-side count, if any) is handed to PAL as a single indirect-multi packet
+        // per device, so the CPU cost of this call does not depend on the number of draws.  The draw index is supplied
+        // by the packet itself.
         utils::IterateMask deviceGroup(m_curDeviceMask);
 
+        PipelineStatsPreCmd(PipelineBindGraphics);
+
         do
         {
             const uint32_t deviceIdx = deviceGroup.Index();
 
             if (useBufferCount)
             {
-                Buffer* pCountBuffer = Buffer::ObjectFromHandle(countBuffer);
                 countVirtAddr = pCountBuffer->GpuVirtAddr(deviceIdx) + countOffset;
             }
 
@@ -2288,12 +3273,15 @@ void CmdBuffer::DrawIndirect(
             }
         }
         while (deviceGroup.IterateNext());
+
+        PipelineStatsPostCmd();
     }
 
     DbgBarrierPostCmd((indexed ? DbgBarrierDrawIndexed : DbgBarrierDrawNonIndexed) | DbgBarrierDrawIndirect);
 }
 
 // =====================================================================================================================
+template <uint32_t numPalDevices>
 void CmdBuffer::Dispatch(
     uint32_t x,
     uint32_t y,
@@ -2301,12 +3289,21 @@ void CmdBuffer::Dispatch(
 {
     DbgBarrierPreCmd(DbgBarrierDispatch);
 
+    m_stats.dispatchCount++;
+
+    ForgetImageClear();
+    ForgetTransformFeedbackCounters();
+
     if (PalPipelineBindingOwnedBy(Pal::PipelineBindPoint::Compute, PipelineBindCompute) == false)
     {
         RebindPipeline<PipelineBindCompute, false>();
     }
 
-    PalCmdDispatch(x, y, z);
+    PipelineStatsPreCmd(PipelineBindCompute);
+
+    PalCmdDispatch<numPalDevices>(x, y, z);
+
+    PipelineStatsPostCmd();
 
     DbgBarrierPostCmd(DbgBarrierDispatch);
 }
@@ -2322,13 +3319,22 @@ void CmdBuffer::DispatchOffset(
 {
     DbgBarrierPreCmd(DbgBarrierDispatch);
 
+    m_stats.dispatchCount++;
+
+    ForgetImageClear();
+    ForgetTransformFeedbackCounters();
+
     if (PalPipelineBindingOwnedBy(Pal::PipelineBindPoint::Compute, PipelineBindCompute) == false)
     {
         RebindPipeline<PipelineBindCompute, false>();
     }
 
+    PipelineStatsPreCmd(PipelineBindCompute);
+
     PalCmdDispatchOffset(base_x, base_y, base_z, dim_x, dim_y, dim_z);
 
+    PipelineStatsPostCmd();
+
     DbgBarrierPostCmd(DbgBarrierDispatch);
 }
 
@@ -2339,6 +3345,11 @@ void CmdBuffer::DispatchIndirect(
 {
     DbgBarrierPreCmd(DbgBarrierDispatchIndirect);
 
+    m_stats.dispatchCount++;
+
+    ForgetImageClear();
+    ForgetTransformFeedbackCounters();
+
     if (PalPipelineBindingOwnedBy(Pal::PipelineBindPoint::Compute, PipelineBindCompute) == false)
     {
         RebindPipeline<PipelineBindCompute, false>();
@@ -2346,8 +3357,12 @@ void CmdBuffer::DispatchIndirect(
 
     Buffer* pBuffer = Buffer::ObjectFromHandle(buffer);
 
+    PipelineStatsPreCmd(PipelineBindCompute);
+
     PalCmdDispatchIndirect(pBuffer, offset);
 
+    PipelineStatsPostCmd();
+
     DbgBarrierPostCmd(DbgBarrierDispatchIndirect);
 }
 
@@ -2360,6 +3375,9 @@ void CmdBuffer::CopyBuffer(
 {
     DbgBarrierPreCmd(DbgBarrierCopyBuffer);
 
+    ForgetImageClear();
+    ForgetTransformFeedbackCounters();
+
     PalCmdSuspendPredication(true);
 
     VirtualStackFrame virtStackFrame(m_pStackAllocator);
@@ -2379,14 +3397,35 @@ void CmdBuffer::CopyBuffer(
         {
             regionBatch = Util::Min(regionCount - regionIdx, maxRegions);
 
+            // Streaming uploads often split one contiguous range into many small regions.  Fold each region that
+            // continues the previous one in both buffers into it so that PAL sees fewer, larger copies.
+            uint32_t palRegionCount = 0;
+
             for (uint32_t i = 0; i < regionBatch; ++i)
             {
-                pPalRegions[i].srcOffset    = pSrcBuffer->MemOffset() + pRegions[regionIdx + i].srcOffset;
-                pPalRegions[i].dstOffset    = pDstBuffer->MemOffset() + pRegions[regionIdx + i].dstOffset;
-                pPalRegions[i].copySize     = pRegions[regionIdx + i].size;
+                const VkBufferCopy& region    = pRegions[regionIdx + i];
+                const Pal::gpusize  srcOffset = pSrcBuffer->MemOffset() + region.srcOffset;
+                const Pal::gpusize  dstOffset = pDstBuffer->MemOffset() + region.dstOffset;
+
+                Pal::MemoryCopyRegion* pPrev = (palRegionCount > 0) ? &pPalRegions[palRegionCount - 1] : nullptr;
+
+                if ((pPrev != nullptr) &&
+                    ((pPrev->srcOffset + pPrev->copySize) == srcOffset) &&
+                    ((pPrev->dstOffset + pPrev->copySize) == dstOffset))
+                {
+                    pPrev->copySize += region.size;
+                }
+                else
+                {
+                    pPalRegions[palRegionCount].srcOffset = srcOffset;
+                    pPalRegions[palRegionCount].dstOffset = dstOffset;
+                    pPalRegions[palRegionCount].copySize  = region.size;
+
+                    palRegionCount++;
+                }
             }
 
-            PalCmdCopyBuffer(pSrcBuffer, pDstBuffer, regionBatch, pPalRegions);
+            PalCmdCopyBuffer(pSrcBuffer, pDstBuffer, palRegionCount, pPalRegions);
         }
 
         virtStackFrame.FreeArray(pPalRegions);
@@ -2412,6 +3451,8 @@ void CmdBuffer::CopyImage(
 {
     DbgBarrierPreCmd(DbgBarrierCopyImage);
 
+    ForgetImageClear();
+
     PalCmdSuspendPredication(true);
 
     VirtualStackFrame virtStackFrame(m_pStackAllocator);
@@ -2475,18 +3516,25 @@ void CmdBuffer::BlitImage(
 {
     DbgBarrierPreCmd(DbgBarrierCopyImage);
 
+    ForgetImageClear();
+
     PalCmdSuspendPredication(true);
 
     VirtualStackFrame virtStackFrame(m_pStackAllocator);
 
-    const auto maxRegions  = Util::Max(EstimateMaxObjectsOnVirtualStack(sizeof(*pRegions)), MaxPalAspectsPerMask);
+    const auto maxRegions  = Util::Max(
+        EstimateMaxObjectsOnVirtualStack(sizeof(Pal::ImageScaledCopyRegion) + sizeof(Pal::ImageCopyRegion)),
+        MaxPalAspectsPerMask);
     auto       regionBatch = Util::Min(regionCount * MaxPalAspectsPerMask, maxRegions);
 
-    // Allocate space to store scaled image copy regions (we need a separate region per PAL aspect)
+    // Allocate space to store scaled image copy regions and the plain copy regions of unscaled blits (we need a
+    // separate region per PAL aspect)
     Pal::ImageScaledCopyRegion* pPalRegions =
         virtStackFrame.AllocArray<Pal::ImageScaledCopyRegion>(regionBatch);
+    Pal::ImageCopyRegion*       pPalCopyRegions =
+        virtStackFrame.AllocArray<Pal::ImageCopyRegion>(regionBatch);
 
-    if (pPalRegions != nullptr)
+    if ((pPalRegions != nullptr) && (pPalCopyRegions != nullptr))
     {
         const Image* const pSrcImage    = Image::ObjectFromHandle(srcImage);
         const Image* const pDstImage    = Image::ObjectFromHandle(destImage);
@@ -2494,6 +3542,8 @@ void CmdBuffer::BlitImage(
         const Pal::SwizzledFormat srcFormat = VkToPalFormat(pSrcImage->GetFormat(), m_pDevice->GetRuntimeSettings());
         const Pal::SwizzledFormat dstFormat = VkToPalFormat(pDstImage->GetFormat(), m_pDevice->GetRuntimeSettings());
 
+        const bool sameFormat = (pSrcImage->GetFormat() == pDstImage->GetFormat());
+
         Pal::ScaledCopyInfo palCopyInfo = {};
 
         palCopyInfo.srcImageLayout = pSrcImage->GetBarrierPolicy().GetTransferLayout(
@@ -2511,62 +3561,76 @@ void CmdBuffer::BlitImage(
         {
             palCopyInfo.regionCount = 0;
 
-            // Attempt a lightweight copy image instead of the requested scaled blit.
-            const VkImageBlit& region    = pRegions[regionIdx];
-            const VkExtent3D   srcExtent =
-            {
-                static_cast<uint32_t>(region.srcOffsets[1].x - region.srcOffsets[0].x),
-                static_cast<uint32_t>(region.srcOffsets[1].y - region.srcOffsets[0].y),
-                static_cast<uint32_t>(region.srcOffsets[1].z - region.srcOffsets[0].z)
-            };
+            uint32_t copyRegionCount = 0;
 
-            if ((pSrcImage->GetFormat() == pDstImage->GetFormat()) &&
-                (srcExtent.width  == static_cast<uint32_t>(region.dstOffsets[1].x - region.dstOffsets[0].x)) &&
-                (srcExtent.height == static_cast<uint32_t>(region.dstOffsets[1].y - region.dstOffsets[0].y)) &&
-                (srcExtent.depth  == static_cast<uint32_t>(region.dstOffsets[1].z - region.dstOffsets[0].z)))
+            // Sort the regions into lightweight copies for blits which aren't scaled and scaled blits, so that each
+            // batch takes at most one PAL call of either kind no matter how many mip levels or layers are blitted.
+            while ((regionIdx < regionCount)                                         &&
+                   (palCopyInfo.regionCount <= (regionBatch - MaxPalAspectsPerMask)) &&
+                   (copyRegionCount <= (regionBatch - MaxPalAspectsPerMask)))
             {
-                const VkImageCopy imageCopy =
+                const VkImageBlit& region    = pRegions[regionIdx];
+                const VkExtent3D   srcExtent =
                 {
-                    region.srcSubresource,
-                    region.srcOffsets[0],
-                    region.dstSubresource,
-                    region.dstOffsets[0],
-                    srcExtent
+                    static_cast<uint32_t>(region.srcOffsets[1].x - region.srcOffsets[0].x),
+                    static_cast<uint32_t>(region.srcOffsets[1].y - region.srcOffsets[0].y),
+                    static_cast<uint32_t>(region.srcOffsets[1].z - region.srcOffsets[0].z)
                 };
 
-                Pal::ImageCopyRegion palRegions[MaxPalAspectsPerMask];
-                uint32_t             palRegionCount = 0;
-
-                VkToPalImageCopyRegion(imageCopy, srcFormat.format, dstFormat.format, palRegions, &palRegionCount);
-
-                PalCmdCopyImage(pSrcImage, palCopyInfo.srcImageLayout, pDstImage, palCopyInfo.dstImageLayout,
-                    palRegionCount, palRegions);
+                if (sameFormat &&
+                    (srcExtent.width  == static_cast<uint32_t>(region.dstOffsets[1].x - region.dstOffsets[0].x)) &&
+                    (srcExtent.height == static_cast<uint32_t>(region.dstOffsets[1].y - region.dstOffsets[0].y)) &&
+                    (srcExtent.depth  == static_cast<uint32_t>(region.dstOffsets[1].z - region.dstOffsets[0].z)))
+                {
+                    const VkImageCopy imageCopy =
+                    {
+                        region.srcSubresource,
+                        region.srcOffsets[0],
+                        region.dstSubresource,
+                        region.dstOffsets[0],
+                        srcExtent
+                    };
+
+                    VkToPalImageCopyRegion(imageCopy, srcFormat.format, dstFormat.format,
+                        pPalCopyRegions, &copyRegionCount);
+                }
+                else
+                {
+                    VkToPalImageScaledCopyRegion(region, srcFormat.format, dstFormat.format,
+                        pPalRegions, &palCopyInfo.regionCount);
+                }
 
                 ++regionIdx;
             }
-            else
-            {
-                while ((regionIdx < regionCount) &&
-                       (palCopyInfo.regionCount <= (regionBatch - MaxPalAspectsPerMask)))
-                {
-                    VkToPalImageScaledCopyRegion(pRegions[regionIdx], srcFormat.format, dstFormat.format,
-                        pPalRegions, &palCopyInfo.regionCount);
 
-                    ++regionIdx;
-                }
+            if (copyRegionCount > 0)
+            {
+                PalCmdCopyImage(pSrcImage, palCopyInfo.srcImageLayout, pDstImage, palCopyInfo.dstImageLayout,
+                    copyRegionCount, pPalCopyRegions);
+            }
 
+            if (palCopyInfo.regionCount > 0)
+            {
                 // This will do a scaled blit
                 PalCmdScaledCopyImage(pSrcImage, pDstImage, palCopyInfo);
             }
         }
-
-        virtStackFrame.FreeArray(pPalRegions);
     }
     else
     {
         m_recordingResult = VK_ERROR_OUT_OF_HOST_MEMORY;
     }
 
+    if (pPalCopyRegions != nullptr)
+    {
+        virtStackFrame.FreeArray(pPalCopyRegions);
+    }
+
+    if (pPalRegions != nullptr)
+    {
+        virtStackFrame.FreeArray(pPalRegions);
+    }
+
     PalCmdSuspendPredication(false);
 
     DbgBarrierPostCmd(DbgBarrierCopyImage);
@@ -2583,6 +3647,8 @@ void CmdBuffer::CopyBufferToImage(
 {
     DbgBarrierPreCmd(DbgBarrierCopyBuffer | DbgBarrierCopyImage);
 
+    ForgetImageClear();
+
     PalCmdSuspendPredication(true);
 
     VirtualStackFrame virtStackFrame(m_pStackAllocator);
@@ -2602,21 +3668,32 @@ void CmdBuffer::CopyBufferToImage(
         const Pal::ImageLayout layout = pDstImage->GetBarrierPolicy().GetTransferLayout(
             destImageLayout, GetQueueFamilyIndex());
 
+        // Uploads of many mip levels or layers almost always use a single aspect, so only convert the format again
+        // when the aspect changes.
+        VkImageAspectFlags  lastAspectMask = 0;
+        Pal::SwizzledFormat dstFormat      = {};
+        uint32              plane          = 0;
+
         for (uint32_t regionIdx = 0; regionIdx < regionCount; regionIdx += regionBatch)
         {
             regionBatch = Util::Min(regionCount - regionIdx, maxRegions);
 
             for (uint32_t i = 0; i < regionBatch; ++i)
             {
-                // For image-buffer copies we have to override the format for depth-only and stencil-only copies
-                Pal::SwizzledFormat dstFormat = VkToPalFormat(
-                    Formats::GetAspectFormat(
-                    pDstImage->GetFormat(),
-                    pRegions[regionIdx + i].imageSubresource.aspectMask),
-                    m_pDevice->GetRuntimeSettings());
+                const VkImageAspectFlags aspectMask = pRegions[regionIdx + i].imageSubresource.aspectMask;
+
+                if (aspectMask != lastAspectMask)
+                {
+                    // For image-buffer copies we have to override the format for depth-only and stencil-only copies
+                    dstFormat = VkToPalFormat(
+                        Formats::GetAspectFormat(pDstImage->GetFormat(), aspectMask),
+                        m_pDevice->GetRuntimeSettings());
+
+                    plane = VkToPalImagePlaneSingle(
+                        pDstImage->GetFormat(), aspectMask, m_pDevice->GetRuntimeSettings());
 
-                uint32 plane =  VkToPalImagePlaneSingle(pDstImage->GetFormat(),
-                    pRegions[regionIdx + i].imageSubresource.aspectMask, m_pDevice->GetRuntimeSettings());
+                    lastAspectMask = aspectMask;
+                }
 
                 pPalRegions[i] = VkToPalMemoryImageCopyRegion(pRegions[regionIdx + i], dstFormat.format, plane, srcMemOffset);
             }
@@ -2647,6 +3724,9 @@ void CmdBuffer::CopyImageToBuffer(
 {
     DbgBarrierPreCmd(DbgBarrierCopyBuffer | DbgBarrierCopyImage);
 
+    ForgetImageClear();
+    ForgetTransformFeedbackCounters();
+
     PalCmdSuspendPredication(true);
 
     VirtualStackFrame virtStackFrame(m_pStackAllocator);
@@ -2666,18 +3746,30 @@ void CmdBuffer::CopyImageToBuffer(
         const Pal::ImageLayout layout = pSrcImage->GetBarrierPolicy().GetTransferLayout(
             srcImageLayout, GetQueueFamilyIndex());
 
+        // As for CopyBufferToImage(), only convert the format again when the aspect changes.
+        VkImageAspectFlags  lastAspectMask = 0;
+        Pal::SwizzledFormat srcFormat      = {};
+        uint32              plane          = 0;
+
         for (uint32_t regionIdx = 0; regionIdx < regionCount; regionIdx += regionBatch)
         {
             regionBatch = Util::Min(regionCount - regionIdx, maxRegions);
 
             for (uint32_t i = 0; i < regionBatch; ++i)
             {
-                // For image-buffer copies we have to override the format for depth-only and stencil-only copies
-                Pal::SwizzledFormat srcFormat = VkToPalFormat(Formats::GetAspectFormat(pSrcImage->GetFormat(),
-                    pRegions[regionIdx + i].imageSubresource.aspectMask), m_pDevice->GetRuntimeSettings());
+                const VkImageAspectFlags aspectMask = pRegions[regionIdx + i].imageSubresource.aspectMask;
+
+                if (aspectMask != lastAspectMask)
+                {
+                    // For image-buffer copies we have to override the format for depth-only and stencil-only copies
+                    srcFormat = VkToPalFormat(Formats::GetAspectFormat(pSrcImage->GetFormat(), aspectMask),
+                        m_pDevice->GetRuntimeSettings());
+
+                    plane = VkToPalImagePlaneSingle(
+                        pSrcImage->GetFormat(), aspectMask, m_pDevice->GetRuntimeSettings());
 
-                uint32 plane = VkToPalImagePlaneSingle(pSrcImage->GetFormat(),
-                    pRegions[regionIdx + i].imageSubresource.aspectMask, m_pDevice->GetRuntimeSettings());
+                    lastAspectMask = aspectMask;
+                }
 
                 pPalRegions[i] = VkToPalMemoryImageCopyRegion(pRegions[regionIdx + i], srcFormat.format, plane, dstMemOffset);
             }
@@ -2706,11 +3798,49 @@ void CmdBuffer::UpdateBuffer(
 {
     DbgBarrierPreCmd(DbgBarrierCopyBuffer);
 
+    ForgetImageClear();
+    ForgetTransformFeedbackCounters();
+
     PalCmdSuspendPredication(true);
 
     Buffer* pDestBuffer = Buffer::ObjectFromHandle(destBuffer);
 
-    PalCmdUpdateBuffer(pDestBuffer, pDestBuffer->MemOffset() + destOffset, dataSize, pData);
+    const Pal::gpusize dstOffset = pDestBuffer->MemOffset() + destOffset;
+
+    const InternalMemory* pStagingMem   = nullptr;
+    Pal::gpusize          stagingOffset = 0;
+
+    // Larger updates are staged through the upload ring and copied by the GPU rather than embedded in the command
+    // stream, which would otherwise be split across and bloat the command chunks
+    if ((m_updateBufferStagingThreshold != 0) &&
+        (dataSize >= m_updateBufferStagingThreshold) &&
+        (dataSize <= CmdUploadRing::ChunkSize) &&
+        (m_uploadRing.Upload(m_curDeviceMask, dataSize, pData, &pStagingMem, &stagingOffset) == VK_SUCCESS))
+    {
+        Pal::MemoryCopyRegion region = {};
+
+        region.srcOffset = stagingOffset;
+        region.dstOffset = dstOffset;
+        region.copySize  = dataSize;
+
+        utils::IterateMask deviceGroup(m_curDeviceMask);
+
+        do
+        {
+            const uint32_t deviceIdx = deviceGroup.Index();
+
+            PalCmdBuffer(deviceIdx)->CmdCopyMemory(
+                *pStagingMem->PalMemory(deviceIdx),
+                *pDestBuffer->PalMemory(deviceIdx),
+                1,
+                &region);
+        }
+        while (deviceGroup.IterateNext());
+    }
+    else
+    {
+        PalCmdUpdateBuffer(pDestBuffer, dstOffset, dataSize, pData);
+    }
 
     PalCmdSuspendPredication(false);
 
@@ -2726,6 +3856,9 @@ void CmdBuffer::FillBuffer(
 {
     DbgBarrierPreCmd(DbgBarrierCopyBuffer);
 
+    ForgetImageClear();
+    ForgetTransformFeedbackCounters();
+
     PalCmdSuspendPredication(true);
 
     Buffer* pDestBuffer = Buffer::ObjectFromHandle(destBuffer);
@@ -2764,17 +3897,21 @@ void CmdBuffer::ClearColorImage(
 
     VirtualStackFrame virtStackFrame(m_pStackAllocator);
 
+    const Pal::ImageLayout layout = pImage->GetBarrierPolicy().GetTransferLayout(
+        imageLayout, GetQueueFamilyIndex());
+
+    // Nothing is left to do for a repeat of the previous clear
+    const bool redundantClear = IsRedundantImageClear(pImage, layout, rangeCount, pRanges, pColor->uint32);
+
     const auto maxRanges  = Util::Max(EstimateMaxObjectsOnVirtualStack(sizeof(*pRanges)), MaxPalColorAspectsPerMask);
     auto       rangeBatch = Util::Min(rangeCount * MaxPalColorAspectsPerMask, maxRanges);
 
     // Allocate space to store image subresource ranges
-    Pal::SubresRange* pPalRanges = virtStackFrame.AllocArray<Pal::SubresRange>(rangeBatch);
+    Pal::SubresRange* pPalRanges =
+        redundantClear ? nullptr : virtStackFrame.AllocArray<Pal::SubresRange>(rangeBatch);
 
     if (pPalRanges != nullptr)
     {
-        const Pal::ImageLayout layout = pImage->GetBarrierPolicy().GetTransferLayout(
-            imageLayout, GetQueueFamilyIndex());
-
         for (uint32_t rangeIdx = 0; rangeIdx < rangeCount;)
         {
             uint32_t palRangeCount = 0;
@@ -2809,7 +3946,7 @@ void CmdBuffer::ClearColorImage(
 
         virtStackFrame.FreeArray(pPalRanges);
     }
-    else
+    else if (redundantClear == false)
     {
         m_recordingResult = VK_ERROR_OUT_OF_HOST_MEMORY;
     }
@@ -2868,18 +4005,26 @@ void CmdBuffer::ClearDepthStencilImage(
 
     VirtualStackFrame virtStackFrame(m_pStackAllocator);
 
+    const Image* pImage           = Image::ObjectFromHandle(image);
+    const Pal::ImageLayout layout = pImage->GetBarrierPolicy().GetTransferLayout(
+        imageLayout, GetQueueFamilyIndex());
+
+    uint32_t clearValue[4] = { 0, stencil, 0, 0 };
+
+    memcpy(&clearValue[0], &depth, sizeof(depth));
+
+    // Nothing is left to do for a repeat of the previous clear
+    const bool redundantClear = IsRedundantImageClear(pImage, layout, rangeCount, pRanges, clearValue);
+
     const auto maxRanges  = Util::Max(EstimateMaxObjectsOnVirtualStack(sizeof(*pRanges)), MaxPalDepthAspectsPerMask);
     auto       rangeBatch = Util::Min(rangeCount * MaxPalDepthAspectsPerMask, maxRanges);
 
     // Allocate space to store image subresource ranges (we need a separate region per PAL aspect)
-    Pal::SubresRange* pPalRanges = virtStackFrame.AllocArray<Pal::SubresRange>(rangeBatch);
+    Pal::SubresRange* pPalRanges =
+        redundantClear ? nullptr : virtStackFrame.AllocArray<Pal::SubresRange>(rangeBatch);
 
     if (pPalRanges != nullptr)
     {
-        const Image* pImage           = Image::ObjectFromHandle(image);
-        const Pal::ImageLayout layout = pImage->GetBarrierPolicy().GetTransferLayout(
-            imageLayout, GetQueueFamilyIndex());
-
         for (uint32_t rangeIdx = 0; rangeIdx < rangeCount;)
         {
             uint32_t palRangeCount = 0;
@@ -2916,7 +4061,7 @@ void CmdBuffer::ClearDepthStencilImage(
 
         virtStackFrame.FreeArray(pPalRanges);
     }
-    else
+    else if (redundantClear == false)
     {
         m_recordingResult = VK_ERROR_OUT_OF_HOST_MEMORY;
     }
@@ -2925,12 +4070,77 @@ void CmdBuffer::ClearDepthStencilImage(
 }
 
 // =====================================================================================================================
-// Clears a set of attachments in the current subpass
-void CmdBuffer::ClearAttachments(
-    uint32_t                 attachmentCount,
-    const VkClearAttachment* pAttachments,
-    uint32_t                 rectCount,
-    const VkClearRect*       pRects)
+// Returns true if a clear with a single range only repeats the previous clear: same image, layout and value, covering
+// at least the same subresources, with nothing recorded since which could have written the image.  Otherwise this
+// clear becomes the one later clears are compared against.
+bool CmdBuffer::IsRedundantImageClear(
+    const Image*                   pImage,
+    Pal::ImageLayout               layout,
+    uint32_t                       rangeCount,
+    const VkImageSubresourceRange* pRanges,
+    const uint32_t*                pValue)
+{
+    bool redundant = false;
+
+    if (m_flags.elideRedundantClears && (rangeCount == 1))
+    {
+        VkImageSubresourceRange range = pRanges[0];
+
+        if (range.levelCount == VK_REMAINING_MIP_LEVELS)
+        {
+            range.levelCount = pImage->GetMipLevels() - range.baseMipLevel;
+        }
+
+        if (range.layerCount == VK_REMAINING_ARRAY_LAYERS)
+        {
+            range.layerCount = pImage->GetArraySize() - range.baseArrayLayer;
+        }
+
+        const LastImageClear&          last      = m_lastImageClear;
+        const VkImageSubresourceRange& lastRange = last.range;
+
+        redundant = (last.pImage == pImage)                                                       &&
+                    (last.deviceMask == m_curDeviceMask)                                          &&
+                    (memcmp(&last.layout, &layout, sizeof(layout)) == 0)                          &&
+                    (memcmp(last.value, pValue, sizeof(last.value)) == 0)                         &&
+                    ((range.aspectMask & ~lastRange.aspectMask) == 0)                             &&
+                    (lastRange.baseMipLevel <= range.baseMipLevel)                                &&
+                    ((lastRange.baseMipLevel + lastRange.levelCount) >=
+                     (range.baseMipLevel + range.levelCount))                                     &&
+                    (lastRange.baseArrayLayer <= range.baseArrayLayer)                            &&
+                    ((lastRange.baseArrayLayer + lastRange.layerCount) >=
+                     (range.baseArrayLayer + range.layerCount));
+
+        if (redundant)
+        {
+            m_stats.elidedClearCount++;
+        }
+        else
+        {
+            m_lastImageClear.pImage     = pImage;
+            m_lastImageClear.layout     = layout;
+            m_lastImageClear.deviceMask = m_curDeviceMask;
+            m_lastImageClear.range      = range;
+
+            memcpy(m_lastImageClear.value, pValue, sizeof(m_lastImageClear.value));
+        }
+    }
+    else
+    {
+        // The clear writes the image, and possibly memory aliased with the remembered one
+        ForgetImageClear();
+    }
+
+    return redundant;
+}
+
+// =====================================================================================================================
+// Clears a set of attachments in the current subpass
+void CmdBuffer::ClearAttachments(
+    uint32_t                 attachmentCount,
+    const VkClearAttachment* pAttachments,
+    uint32_t                 rectCount,
+    const VkClearRect*       pRects)
 {
     if ((m_flags.is2ndLvl == false) && (m_allGpuState.pFramebuffer != nullptr))
     {
@@ -2954,9 +4164,11 @@ void CmdBuffer::ClearBoundAttachments(
 
     VirtualStackFrame virtStackFrame(m_pStackAllocator);
 
-    // Get the current renderpass and subpass
+    // Get the current renderpass and subpass.  Inside a dynamic rendering instance there is no render pass and the
+    // bound targets are described by m_dynamicRendering instead.
     const RenderPass* pRenderPass = m_allGpuState.pRenderPass;
     const uint32_t subpass        = m_renderPassInstance.subpass;
+    const uint32_t viewMask       = GetActiveViewMask();
 
     Util::Vector<Pal::ClearBoundTargetRegion, 8, VirtualStackFrame> clearRegions { &virtStackFrame };
     Util::Vector<Pal::BoundColorTarget,       8, VirtualStackFrame> colorTargets { &virtStackFrame };
@@ -2981,22 +4193,37 @@ void CmdBuffer::ClearBoundAttachments(
         // Detect if color clear or depth clear
         if ((clearInfo.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) != 0)
         {
-            // Get the corresponding color reference in the current subpass
-            const AttachmentReference& colorRef = pRenderPass->GetSubpassColorReference(
-                subpass, clearInfo.colorAttachment);
+            const uint32_t tgtIdx = clearInfo.colorAttachment;
+
+            VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+            uint32_t samples     = 1;
+
+            if (pRenderPass != nullptr)
+            {
+                // Get the corresponding color reference in the current subpass
+                const AttachmentReference& colorRef = pRenderPass->GetSubpassColorReference(subpass, tgtIdx);
+
+                if (colorRef.attachment != VK_ATTACHMENT_UNUSED)
+                {
+                    colorFormat = pRenderPass->GetColorAttachmentFormat(subpass, tgtIdx);
+                    samples     = pRenderPass->GetColorAttachmentSamples(subpass, tgtIdx);
+                }
+            }
+            else if (tgtIdx < m_dynamicRendering.colorAttachmentCount)
+            {
+                colorFormat = m_dynamicRendering.colorFormats[tgtIdx];
+                samples     = m_dynamicRendering.samples;
+            }
 
             // Clear only if the attachment reference is active
-            if (colorRef.attachment != VK_ATTACHMENT_UNUSED)
+            if (colorFormat != VK_FORMAT_UNDEFINED)
             {
                 // Fill in bound target information for this target, but don't clear yet
-                const uint32_t tgtIdx = clearInfo.colorAttachment;
-
                 Pal::BoundColorTarget target = {};
                 target.targetIndex    = tgtIdx;
-                target.swizzledFormat = VkToPalFormat(pRenderPass->GetColorAttachmentFormat(subpass, tgtIdx),
-                                                      m_pDevice->GetRuntimeSettings());
-                target.samples        = pRenderPass->GetColorAttachmentSamples(subpass, tgtIdx);
-                target.fragments      = pRenderPass->GetColorAttachmentSamples(subpass, tgtIdx);
+                target.swizzledFormat = VkToPalFormat(colorFormat, m_pDevice->GetRuntimeSettings());
+                target.samples        = samples;
+                target.fragments      = samples;
                 target.clearValue     = VkToPalClearColor(&clearInfo.clearValue.color, target.swizzledFormat);
 
                 colorTargets.PushBack(target);
@@ -3004,11 +4231,25 @@ void CmdBuffer::ClearBoundAttachments(
         }
         else // Depth-stencil clear
         {
-            // Get the corresponding color reference in the current subpass
-            const AttachmentReference& depthStencilRef = pRenderPass->GetSubpassDepthStencilReference(subpass);
+            bool     hasDepthStencil = false;
+            uint32_t samples         = 1;
+
+            if (pRenderPass != nullptr)
+            {
+                // Get the corresponding depth/stencil reference in the current subpass
+                const AttachmentReference& depthStencilRef = pRenderPass->GetSubpassDepthStencilReference(subpass);
+
+                hasDepthStencil = (depthStencilRef.attachment != VK_ATTACHMENT_UNUSED);
+                samples         = pRenderPass->GetDepthStencilAttachmentSamples(subpass);
+            }
+            else
+            {
+                hasDepthStencil = (m_dynamicRendering.depthStencilFormat != VK_FORMAT_UNDEFINED);
+                samples         = m_dynamicRendering.samples;
+            }
 
             // Clear only if the attachment reference is active
-            if (depthStencilRef.attachment != VK_ATTACHMENT_UNUSED)
+            if (hasDepthStencil)
             {
                 Pal::DepthStencilSelectFlags selectFlags = {};
 
@@ -3023,7 +4264,7 @@ void CmdBuffer::ClearBoundAttachments(
 
                     CreateClearRegions(
                         rectBatch, pRects + rectIdx,
-                        *pRenderPass, subpass, 0u,
+                        viewMask, 0u,
                         &clearRegions);
 
                     // Clear the bound depth stencil target immediately
@@ -3031,8 +4272,8 @@ void CmdBuffer::ClearBoundAttachments(
                         VkToPalClearDepth(clearInfo.clearValue.depthStencil.depth),
                         clearInfo.clearValue.depthStencil.stencil,
                         StencilWriteMaskFull,
-                        pRenderPass->GetDepthStencilAttachmentSamples(subpass),
-                        pRenderPass->GetDepthStencilAttachmentSamples(subpass),
+                        samples,
+                        samples,
                         selectFlags,
                         clearRegions.NumElements(),
                         clearRegions.Data());
@@ -3053,7 +4294,7 @@ void CmdBuffer::ClearBoundAttachments(
 
             CreateClearRegions(
                 rectBatch, pRects + rectIdx,
-                *pRenderPass, subpass, 0u,
+                viewMask, 0u,
                 &clearRegions);
 
             // Clear the bound color targets
@@ -3194,6 +4435,8 @@ void CmdBuffer::PalCmdResolveImage(
 {
     DbgBarrierPreCmd(DbgBarrierResolve);
 
+    ForgetImageClear();
+
     PreBltBindMsaaState(srcImage);
 
     utils::IterateMask deviceGroup(deviceMask);
@@ -3290,7 +4533,7 @@ void CmdBuffer::ClearImageAttachments(
 
                         CreateClearRegions(
                             rectCount, pRects + rectIdx,
-                            *pRenderPass, subpass, zOffset,
+                            pRenderPass->GetViewMask(subpass), zOffset,
                             &clearBoxes);
 
                         CreateClearSubresRanges(
@@ -3458,6 +4701,72 @@ void CmdBuffer::ResolveImage(
     PalCmdSuspendPredication(false);
 }
 
+// =====================================================================================================================
+// Returns the write accesses the given source pipeline stages are able to perform.  vkCmdSetEvent() only provides a
+// stage mask, so this determines which caches a release of the event has to flush.
+static AccessFlags GetStageWriteAccessMask(
+    PipelineStageFlags stageMask)
+{
+    constexpr PipelineStageFlags ShaderStages = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR                  |
+                                                VK_PIPELINE_STAGE_2_TESSELLATION_CONTROL_SHADER_BIT_KHR    |
+                                                VK_PIPELINE_STAGE_2_TESSELLATION_EVALUATION_SHADER_BIT_KHR |
+                                                VK_PIPELINE_STAGE_2_GEOMETRY_SHADER_BIT_KHR                |
+                                                VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR                |
+                                                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR                 |
+                                                VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR             |
+                                                VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
+
+    AccessFlags accessMask = 0;
+
+    if (stageMask & (VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR | VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT_KHR))
+    {
+        accessMask |= VK_ACCESS_MEMORY_WRITE_BIT                   |
+                      VK_ACCESS_SHADER_WRITE_BIT                   |
+                      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT         |
+                      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                      VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT   |
+                      VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT;
+
+        if (stageMask & VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR)
+        {
+            accessMask |= VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT;
+        }
+    }
+
+    if (stageMask & ShaderStages)
+    {
+        accessMask |= VK_ACCESS_SHADER_WRITE_BIT;
+    }
+
+    if (stageMask & (VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR |
+                     VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR))
+    {
+        accessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    }
+
+    if (stageMask & VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR)
+    {
+        accessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    }
+
+    if (stageMask & VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR)
+    {
+        accessMask |= VK_ACCESS_TRANSFER_WRITE_BIT;
+    }
+
+    if (stageMask & VK_PIPELINE_STAGE_2_HOST_BIT_KHR)
+    {
+        accessMask |= VK_ACCESS_HOST_WRITE_BIT;
+    }
+
+    if (stageMask & VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT)
+    {
+        accessMask |= VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT | VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT;
+    }
+
+    return accessMask;
+}
+
 // =====================================================================================================================
 // Implementation of vkCmdSetEvent()
 void CmdBuffer::SetEvent(
@@ -3466,7 +4775,39 @@ void CmdBuffer::SetEvent(
 {
     DbgBarrierPreCmd(DbgBarrierSetResetEvent);
 
-    PalCmdSetEvent(Event::ObjectFromHandle(event), VkToPalSrcPipePoint(stageMask));
+    if (m_flags.useReleaseAcquireForEvents)
+    {
+        // Release the event with the caches the source stages may have written through, so that the flushes overlap
+        // with the work recorded between the set and the wait instead of being performed by vkCmdWaitEvents().
+        VkMemoryBarrier2KHR memoryBarrier = {};
+
+        memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+        memoryBarrier.srcStageMask  = stageMask;
+        memoryBarrier.srcAccessMask = GetStageWriteAccessMask(stageMask);
+
+        VkDependencyInfoKHR dependencyInfo = {};
+
+        dependencyInfo.sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+        dependencyInfo.memoryBarrierCount = 1;
+        dependencyInfo.pMemoryBarriers    = &memoryBarrier;
+
+        utils::IterateMask deviceGroup(m_curDeviceMask);
+        do
+        {
+            ExecuteAcquireRelease(1,
+                                  &event,
+                                  deviceGroup.Index(),
+                                  1,
+                                  &dependencyInfo,
+                                  Release,
+                                  RgpBarrierExternalCmdWaitEvents);
+        }
+        while (deviceGroup.IterateNext());
+    }
+    else
+    {
+        PalCmdSetEvent(Event::ObjectFromHandle(event), VkToPalSrcPipePoint(stageMask));
+    }
 
     DbgBarrierPostCmd(DbgBarrierSetResetEvent);
 }
@@ -3565,6 +4906,10 @@ void CmdBuffer::FlushBarriers(
     // Remove any signaled events as we do not want to wait more than once.
     pBarrier->gpuEventWaitCount = 0;
     pBarrier->ppGpuEvents = nullptr;
+
+    // The folded cache masks have been applied by this barrier; later flushes of the same call only carry their own.
+    pBarrier->globalSrcCacheMask = 0u;
+    pBarrier->globalDstCacheMask = 0u;
 }
 
 // =====================================================================================================================
@@ -3606,53 +4951,40 @@ void CmdBuffer::ExecuteBarriers(
     const Image** pTransitionImages = (m_pDevice->NumPalDevices() > 1) && (imageMemoryBarrierCount > 0) ?
         virtStackFrame.AllocArray<const Image*>(MaxTransitionCount) : nullptr;
 
+    // Barriers which don't transition an image layout only contribute cache masks.  Rather than emitting one
+    // image-less transition per barrier, fold them all into the global cache masks of the PAL barrier.  A barrier
+    // storm of memory and buffer barriers then costs PAL a single cache operation instead of one per transition.
     for (uint32_t i = 0; i < memBarrierCount; ++i)
     {
+        Pal::BarrierTransition transition = {};
+
         m_pDevice->GetBarrierPolicy().ApplyBarrierCacheFlags(
             pMemoryBarriers[i].srcAccessMask,
             pMemoryBarriers[i].dstAccessMask,
             VK_IMAGE_LAYOUT_GENERAL,
             VK_IMAGE_LAYOUT_GENERAL,
-            pNextMain);
+            &transition);
 
-        pNextMain->imageInfo.pImage = nullptr;
         VK_ASSERT(pMemoryBarriers[i].pNext == nullptr);
 
-        ++pNextMain;
-
-        const uint32_t mainTransitionCount = static_cast<uint32_t>(pNextMain - pTransitions);
-
-        if (MaxPalAspectsPerMask + mainTransitionCount > MaxTransitionCount)
-        {
-            FlushBarriers(pBarrier, pTransitions, nullptr, mainTransitionCount);
-
-            pNextMain = pTransitions;
-        }
+        pBarrier->globalSrcCacheMask |= transition.srcCacheMask;
+        pBarrier->globalDstCacheMask |= transition.dstCacheMask;
     }
 
     for (uint32_t i = 0; i < bufferMemoryBarrierCount; ++i)
     {
-        const Buffer* pBuffer = Buffer::ObjectFromHandle(pBufferMemoryBarriers[i].buffer);
+        const Buffer*          pBuffer    = Buffer::ObjectFromHandle(pBufferMemoryBarriers[i].buffer);
+        Pal::BarrierTransition transition = {};
 
         pBuffer->GetBarrierPolicy().ApplyBufferMemoryBarrier<VkBufferMemoryBarrier>(
             GetQueueFamilyIndex(),
             pBufferMemoryBarriers[i],
-            pNextMain);
-
-        pNextMain->imageInfo.pImage = nullptr;
+            &transition);
 
         VK_ASSERT(pBufferMemoryBarriers[i].pNext == nullptr);
 
-        ++pNextMain;
-
-        const uint32_t mainTransitionCount = static_cast<uint32_t>(pNextMain - pTransitions);
-
-        if (MaxPalAspectsPerMask + mainTransitionCount > MaxTransitionCount)
-        {
-            FlushBarriers(pBarrier, pTransitions, nullptr, mainTransitionCount);
-
-            pNextMain = pTransitions;
-        }
+        pBarrier->globalSrcCacheMask |= transition.srcCacheMask;
+        pBarrier->globalDstCacheMask |= transition.dstCacheMask;
     }
 
     uint32_t locationIndex = 0;
@@ -3679,6 +5011,11 @@ void CmdBuffer::ExecuteBarriers(
             newLayouts,
             true);
 
+        if (layoutChanging)
+        {
+            KeepTransientContents(pImage, pImageMemoryBarriers[i].oldLayout);
+        }
+
         pNextMain->imageInfo.pImage = nullptr;
 
         uint32_t         layoutIdx     = 0;
@@ -3695,6 +5032,24 @@ void CmdBuffer::ExecuteBarriers(
             &palRangeCount,
             m_pDevice->GetRuntimeSettings());
 
+        // A tracked image which is already in the layouts it is transitioned to from UNDEFINED keeps its metadata, so
+        // the barrier only needs its cache operations.  Queue family ownership transfers are not tracked.
+        if (layoutChanging && (m_pLayoutState != nullptr) && pImage->IsLayoutTracked())
+        {
+            if (pImageMemoryBarriers[i].srcQueueFamilyIndex != pImageMemoryBarriers[i].dstQueueFamilyIndex)
+            {
+                m_pLayoutState->Forget(pImage);
+            }
+            else if (m_pLayoutState->FilterTransition(pImage,
+                                                      (pImageMemoryBarriers[i].oldLayout == VK_IMAGE_LAYOUT_UNDEFINED),
+                                                      palRangeCount,
+                                                      palRanges,
+                                                      newLayouts))
+            {
+                layoutChanging = false;
+            }
+        }
+
         if (layoutChanging && Formats::HasStencil(format))
         {
             if (palRangeCount == MaxPalDepthAspectsPerMask)
@@ -3729,24 +5084,24 @@ void CmdBuffer::ExecuteBarriers(
 
         VK_ASSERT(palRangeCount > 0 && palRangeCount <= MaxPalAspectsPerMask);
 
-        const Image** pLocalImageTransition = pTransitionImages;
-
-        Pal::BarrierTransition* pDestTransition = pNextMain;
+        if (layoutChanging)
+        {
+            const Image** pLocalImageTransition = pTransitionImages;
 
-        pNextMain += palRangeCount;
+            Pal::BarrierTransition* pDestTransition = pNextMain;
 
-        if (pTransitionImages != nullptr)
-        {
-            const size_t localOffset = (pDestTransition - pTransitions);
+            pNextMain += palRangeCount;
 
-            for (uint32_t rangeIdx = 0; rangeIdx < palRangeCount; rangeIdx++)
+            if (pTransitionImages != nullptr)
             {
-                pLocalImageTransition[localOffset + rangeIdx] = pImage;
+                const size_t localOffset = (pDestTransition - pTransitions);
+
+                for (uint32_t rangeIdx = 0; rangeIdx < palRangeCount; rangeIdx++)
+                {
+                    pLocalImageTransition[localOffset + rangeIdx] = pImage;
+                }
             }
-        }
 
-        if (layoutChanging)
-        {
             EXTRACT_VK_STRUCTURES_1(
                 Barrier,
                 ImageMemoryBarrier,
@@ -3789,12 +5144,8 @@ void CmdBuffer::ExecuteBarriers(
         }
         else
         {
-            for (uint32_t transitionIdx = 0; transitionIdx < palRangeCount; transitionIdx++)
-            {
-                pDestTransition[transitionIdx].srcCacheMask     = barrierTransition.srcCacheMask;
-                pDestTransition[transitionIdx].dstCacheMask     = barrierTransition.dstCacheMask;
-                pDestTransition[transitionIdx].imageInfo.pImage = nullptr;
-            }
+            pBarrier->globalSrcCacheMask |= barrierTransition.srcCacheMask;
+            pBarrier->globalDstCacheMask |= barrierTransition.dstCacheMask;
         }
 
         const uint32_t mainTransitionCount = static_cast<uint32_t>(pNextMain - pTransitions);
@@ -3842,83 +5193,277 @@ void CmdBuffer::WaitEvents(
 {
     DbgBarrierPreCmd(DbgBarrierPipelineBarrierWaitEvents);
 
-    VirtualStackFrame virtStackFrame(m_pStackAllocator);
+    m_stats.barrierCount++;
 
-    // Allocate space to store signaled event pointers (automatically rewound on unscope)
-    const Pal::IGpuEvent** ppGpuEvents = virtStackFrame.AllocArray<const Pal::IGpuEvent*>(NumDeviceEvents(eventCount));
+    ForgetImageClear();
+    ForgetTransformFeedbackCounters();
 
-    if (ppGpuEvents != nullptr)
+    VirtualStackFrame virtStackFrame(m_pStackAllocator);
+
+    // Events released by SetEvent() only need an acquire here unless an image barrier has to be transitioned or
+    // ownership has to be transferred, which the release didn't know about.
+    if (m_flags.useReleaseAcquireForEvents &&
+        CanAcquireLegacyEvents(eventCount,
+                               pEvents,
+                               bufferMemoryBarrierCount,
+                               pBufferMemoryBarriers,
+                               imageMemoryBarrierCount,
+                               pImageMemoryBarriers))
+    {
+        AcquireLegacyEvents(virtStackFrame,
+                            eventCount,
+                            pEvents,
+                            srcStageMask,
+                            dstStageMask,
+                            memoryBarrierCount,
+                            pMemoryBarriers,
+                            bufferMemoryBarrierCount,
+                            pBufferMemoryBarriers,
+                            imageMemoryBarrierCount,
+                            pImageMemoryBarriers);
+    }
+    else
     {
-        const uint32_t multiDeviceStride = eventCount;
+        // Allocate space to store signaled event pointers (automatically rewound on unscope)
+        const Pal::IGpuEvent** ppGpuEvents =
+            virtStackFrame.AllocArray<const Pal::IGpuEvent*>(NumDeviceEvents(eventCount));
 
-        for (uint32_t i = 0; i < eventCount; ++i)
+        if (ppGpuEvents != nullptr)
         {
-            const Event* pEvent = Event::ObjectFromHandle(pEvents[i]);
+            const uint32_t multiDeviceStride = eventCount;
 
-            InsertDeviceEvents(ppGpuEvents, pEvent, i, multiDeviceStride);
-        }
+            for (uint32_t i = 0; i < eventCount; ++i)
+            {
+                const Event* pEvent = Event::ObjectFromHandle(pEvents[i]);
+
+                InsertDeviceEvents(ppGpuEvents, pEvent, i, multiDeviceStride);
+            }
 
-        Pal::BarrierInfo barrier = {};
+            Pal::BarrierInfo barrier = {};
 
-        // Tell PAL to wait at a specific point until the given set of GpuEvent objects is signaled.
-        // We intentionally ignore the source stage flags as they are irrelevant in the presence of event objects
-        VK_IGNORE(srcStageMask);
+            // Tell PAL to wait at a specific point until the given set of GpuEvent objects is signaled.
+            // We intentionally ignore the source stage flags as they are irrelevant in the presence of event objects
+            VK_IGNORE(srcStageMask);
 
-        barrier.flags.u32All          = 0;
-        barrier.reason                = RgpBarrierExternalCmdWaitEvents;
-        barrier.waitPoint             = VkToPalWaitPipePoint(dstStageMask);
-        barrier.gpuEventWaitCount     = eventCount;
-        barrier.ppGpuEvents           = ppGpuEvents;
-        barrier.pSplitBarrierGpuEvent = nullptr;
+            barrier.flags.u32All          = 0;
+            barrier.reason                = RgpBarrierExternalCmdWaitEvents;
+            barrier.waitPoint             = VkToPalWaitPipePoint(dstStageMask);
+            barrier.gpuEventWaitCount     = eventCount;
+            barrier.ppGpuEvents           = ppGpuEvents;
+            barrier.pSplitBarrierGpuEvent = nullptr;
 
-        ExecuteBarriers(virtStackFrame,
-                        memoryBarrierCount,
-                        pMemoryBarriers,
-                        bufferMemoryBarrierCount,
-                        pBufferMemoryBarriers,
-                        imageMemoryBarrierCount,
-                        pImageMemoryBarriers,
-                        &barrier);
+            ExecuteBarriers(virtStackFrame,
+                            memoryBarrierCount,
+                            pMemoryBarriers,
+                            bufferMemoryBarrierCount,
+                            pBufferMemoryBarriers,
+                            imageMemoryBarrierCount,
+                            pImageMemoryBarriers,
+                            &barrier);
 
-        virtStackFrame.FreeArray(ppGpuEvents);
+            virtStackFrame.FreeArray(ppGpuEvents);
+        }
+        else
+        {
+            m_recordingResult = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
     }
-    else
+
+    DbgBarrierPostCmd(DbgBarrierPipelineBarrierWaitEvents);
+}
+
+// =====================================================================================================================
+// Returns true if a vkCmdWaitEvents() on events released by SetEvent() can be expressed as an acquire of the events.
+// The release only made the source stages' writes available, so barriers that transition image layouts or transfer
+// queue family ownership still need the full barrier path.  All events must also be of the same kind since PAL waits
+// either on sync tokens or on GPU events.
+bool CmdBuffer::CanAcquireLegacyEvents(
+    uint32_t                     eventCount,
+    const VkEvent*               pEvents,
+    uint32_t                     bufferMemoryBarrierCount,
+    const VkBufferMemoryBarrier* pBufferMemoryBarriers,
+    uint32_t                     imageMemoryBarrierCount,
+    const VkImageMemoryBarrier*  pImageMemoryBarriers) const
+{
+    bool canAcquire = (eventCount > 0);
+
+    for (uint32_t i = 1; canAcquire && (i < eventCount); ++i)
     {
-        m_recordingResult = VK_ERROR_OUT_OF_HOST_MEMORY;
+        canAcquire = (Event::ObjectFromHandle(pEvents[i])->IsUseToken() ==
+                      Event::ObjectFromHandle(pEvents[0])->IsUseToken());
     }
 
-    DbgBarrierPostCmd(DbgBarrierPipelineBarrierWaitEvents);
+    for (uint32_t i = 0; canAcquire && (i < bufferMemoryBarrierCount); ++i)
+    {
+        canAcquire = (pBufferMemoryBarriers[i].srcQueueFamilyIndex == pBufferMemoryBarriers[i].dstQueueFamilyIndex);
+    }
+
+    for (uint32_t i = 0; canAcquire && (i < imageMemoryBarrierCount); ++i)
+    {
+        canAcquire = (pImageMemoryBarriers[i].oldLayout == pImageMemoryBarriers[i].newLayout) &&
+                     (pImageMemoryBarriers[i].srcQueueFamilyIndex == pImageMemoryBarriers[i].dstQueueFamilyIndex);
+    }
+
+    return canAcquire;
 }
 
 // =====================================================================================================================
-// Implementation of vkCmdWaitEvents2KHR()
-void CmdBuffer::WaitEvents2(
-    uint32_t                   eventCount,
-    const VkEvent*             pEvents,
-    const VkDependencyInfoKHR* pDependencyInfos)
+// Acquires events released by SetEvent() for the barriers of a vkCmdWaitEvents() call by converting them to their
+// synchronization2 equivalents.
+void CmdBuffer::AcquireLegacyEvents(
+    VirtualStackFrame&           virtStackFrame,
+    uint32_t                     eventCount,
+    const VkEvent*               pEvents,
+    PipelineStageFlags           srcStageMask,
+    PipelineStageFlags           dstStageMask,
+    uint32_t                     memoryBarrierCount,
+    const VkMemoryBarrier*       pMemoryBarriers,
+    uint32_t                     bufferMemoryBarrierCount,
+    const VkBufferMemoryBarrier* pBufferMemoryBarriers,
+    uint32_t                     imageMemoryBarrierCount,
+    const VkImageMemoryBarrier*  pImageMemoryBarriers)
 {
-    DbgBarrierPreCmd(DbgBarrierPipelineBarrierWaitEvents);
+    VkMemoryBarrier2KHR* pMemoryBarriers2 = (memoryBarrierCount > 0) ?
+        virtStackFrame.AllocArray<VkMemoryBarrier2KHR>(memoryBarrierCount) : nullptr;
 
-    // If the ASIC provides split CmdRelease()/CmdReleaseEvent() and CmdAcquire()/CmdAcquireEvent() to express barrier,
-    // we will find range of gpu-only events and gpu events with cpu-access, we are assuming the case won't be to have
-    // a mixture, it means we can find ranges in the event list that are sync token or not sync token, and then call
-    // CmdAcquire() or CmdAcquireEvent() for each range. If the ASIC doesn't support it, we call
-    // WaitEventsSync2ToSync1() for all events.
-    if (m_flags.useSplitReleaseAcquire)
+    VkBufferMemoryBarrier2KHR* pBufferMemoryBarriers2 = (bufferMemoryBarrierCount > 0) ?
+        virtStackFrame.AllocArray<VkBufferMemoryBarrier2KHR>(bufferMemoryBarrierCount) : nullptr;
+
+    VkImageMemoryBarrier2KHR* pImageMemoryBarriers2 = (imageMemoryBarrierCount > 0) ?
+        virtStackFrame.AllocArray<VkImageMemoryBarrier2KHR>(imageMemoryBarrierCount) : nullptr;
+
+    if (((memoryBarrierCount > 0) && (pMemoryBarriers2 == nullptr)) ||
+        ((bufferMemoryBarrierCount > 0) && (pBufferMemoryBarriers2 == nullptr)) ||
+        ((imageMemoryBarrierCount > 0) && (pImageMemoryBarriers2 == nullptr)))
     {
-        uint32_t eventRangeCount = 0;
+        m_recordingResult = VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < memoryBarrierCount; i++)
+        {
+            pMemoryBarriers2[i] =
+            {
+                VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR,
+                pMemoryBarriers[i].pNext,
+                srcStageMask,
+                pMemoryBarriers[i].srcAccessMask,
+                dstStageMask,
+                pMemoryBarriers[i].dstAccessMask
+            };
+        }
 
-        for (uint32_t i = 0; i < eventCount; i += eventRangeCount)
+        for (uint32_t i = 0; i < bufferMemoryBarrierCount; i++)
         {
-            eventRangeCount = 1;
+            pBufferMemoryBarriers2[i] =
+            {
+                VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
+                pBufferMemoryBarriers[i].pNext,
+                srcStageMask,
+                pBufferMemoryBarriers[i].srcAccessMask,
+                dstStageMask,
+                pBufferMemoryBarriers[i].dstAccessMask,
+                pBufferMemoryBarriers[i].srcQueueFamilyIndex,
+                pBufferMemoryBarriers[i].dstQueueFamilyIndex,
+                pBufferMemoryBarriers[i].buffer,
+                pBufferMemoryBarriers[i].offset,
+                pBufferMemoryBarriers[i].size
+            };
+        }
 
-            if (Event::ObjectFromHandle(pEvents[i])->IsUseToken())
+        for (uint32_t i = 0; i < imageMemoryBarrierCount; i++)
+        {
+            pImageMemoryBarriers2[i] =
             {
-                for (uint32_t j = i + 1; j < eventCount; j++)
-                {
-                    if (Event::ObjectFromHandle(pEvents[j])->IsUseToken())
-                    {
-                        eventRangeCount++;
+                VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
+                pImageMemoryBarriers[i].pNext,
+                srcStageMask,
+                pImageMemoryBarriers[i].srcAccessMask,
+                dstStageMask,
+                pImageMemoryBarriers[i].dstAccessMask,
+                pImageMemoryBarriers[i].oldLayout,
+                pImageMemoryBarriers[i].newLayout,
+                pImageMemoryBarriers[i].srcQueueFamilyIndex,
+                pImageMemoryBarriers[i].dstQueueFamilyIndex,
+                pImageMemoryBarriers[i].image,
+                pImageMemoryBarriers[i].subresourceRange
+            };
+        }
+
+        VkDependencyInfoKHR dependencyInfo = {};
+
+        dependencyInfo.sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+        dependencyInfo.memoryBarrierCount       = memoryBarrierCount;
+        dependencyInfo.pMemoryBarriers          = pMemoryBarriers2;
+        dependencyInfo.bufferMemoryBarrierCount = bufferMemoryBarrierCount;
+        dependencyInfo.pBufferMemoryBarriers    = pBufferMemoryBarriers2;
+        dependencyInfo.imageMemoryBarrierCount  = imageMemoryBarrierCount;
+        dependencyInfo.pImageMemoryBarriers     = pImageMemoryBarriers2;
+
+        utils::IterateMask deviceGroup(m_curDeviceMask);
+        do
+        {
+            ExecuteAcquireRelease(eventCount,
+                                  pEvents,
+                                  deviceGroup.Index(),
+                                  1,
+                                  &dependencyInfo,
+                                  Acquire,
+                                  RgpBarrierExternalCmdWaitEvents);
+        }
+        while (deviceGroup.IterateNext());
+    }
+
+    if (pImageMemoryBarriers2 != nullptr)
+    {
+        virtStackFrame.FreeArray(pImageMemoryBarriers2);
+    }
+
+    if (pBufferMemoryBarriers2 != nullptr)
+    {
+        virtStackFrame.FreeArray(pBufferMemoryBarriers2);
+    }
+
+    if (pMemoryBarriers2 != nullptr)
+    {
+        virtStackFrame.FreeArray(pMemoryBarriers2);
+    }
+}
+
+// =====================================================================================================================
+// Implementation of vkCmdWaitEvents2KHR()
+void CmdBuffer::WaitEvents2(
+    uint32_t                   eventCount,
+    const VkEvent*             pEvents,
+    const VkDependencyInfoKHR* pDependencyInfos)
+{
+    DbgBarrierPreCmd(DbgBarrierPipelineBarrierWaitEvents);
+
+    m_stats.barrierCount++;
+
+    ForgetImageClear();
+    ForgetTransformFeedbackCounters();
+
+    // If the ASIC provides split CmdRelease()/CmdReleaseEvent() and CmdAcquire()/CmdAcquireEvent() to express barrier,
+    // we will find range of gpu-only events and gpu events with cpu-access, we are assuming the case won't be to have
+    // a mixture, it means we can find ranges in the event list that are sync token or not sync token, and then call
+    // CmdAcquire() or CmdAcquireEvent() for each range. If the ASIC doesn't support it, we call
+    // WaitEventsSync2ToSync1() for all events.
+    if (m_flags.useSplitReleaseAcquire)
+    {
+        uint32_t eventRangeCount = 0;
+
+        for (uint32_t i = 0; i < eventCount; i += eventRangeCount)
+        {
+            eventRangeCount = 1;
+
+            if (Event::ObjectFromHandle(pEvents[i])->IsUseToken())
+            {
+                for (uint32_t j = i + 1; j < eventCount; j++)
+                {
+                    if (Event::ObjectFromHandle(pEvents[j])->IsUseToken())
+                    {
+                        eventRangeCount++;
                     }
                     else
                     {
@@ -4238,6 +5783,17 @@ void CmdBuffer::ExecuteAcquireRelease(
                 newLayouts,
                 false);
 
+            if (layoutChanging)
+            {
+                KeepTransientContents(pImage, pThisDependencyInfo->pImageMemoryBarriers[i].oldLayout);
+
+                // Split acquire and release transitions aren't tracked
+                if ((m_pLayoutState != nullptr) && pImage->IsLayoutTracked())
+                {
+                    m_pLayoutState->Forget(pImage);
+                }
+            }
+
             VkFormat format = pImage->GetFormat();
 
             uint32_t layoutIdx     = 0;
@@ -4454,6 +6010,10 @@ void CmdBuffer::PipelineBarrier(
 {
     DbgBarrierPreCmd(DbgBarrierPipelineBarrierWaitEvents);
 
+    m_stats.barrierCount++;
+
+    ForgetImageClear();
+
     VirtualStackFrame virtStackFrame(m_pStackAllocator);
 
     Pal::BarrierInfo barrier = {};
@@ -4490,6 +6050,10 @@ void CmdBuffer::PipelineBarrier2(
 {
     DbgBarrierPreCmd(DbgBarrierPipelineBarrierWaitEvents);
 
+    m_stats.barrierCount++;
+
+    ForgetImageClear();
+
     if (m_flags.hasReleaseAcquire)
     {
         utils::IterateMask deviceGroup(m_curDeviceMask);
@@ -4636,6 +6200,8 @@ void CmdBuffer::BeginQueryIndexed(
     VkQueryControlFlags flags,
     uint32_t            index)
 {
+    FlushQueryResets();
+
     DbgBarrierPreCmd(DbgBarrierQueryBeginEnd);
 
     const QueryPool* pBasePool = QueryPool::ObjectFromHandle(queryPool);
@@ -4661,7 +6227,7 @@ void CmdBuffer::BeginQueryIndexed(
     }
     while (deviceGroup.IterateNext());
 
-    const auto* const pRenderPass = m_allGpuState.pRenderPass;
+    const uint32_t viewMask = GetActiveViewMask();
 
     // If queries are used while executing a render pass instance that has multiview enabled,
     // the query uses N consecutive query indices in the query pool (starting at query) where
@@ -4669,9 +6235,8 @@ void CmdBuffer::BeginQueryIndexed(
     //
     // Implementations may write the total result to the first query and
     // write zero to the other queries.
-    if (pRenderPass && pRenderPass->IsMultiviewEnabled())
+    if (viewMask != 0)
     {
-        const auto viewMask  = pRenderPass->GetViewMask(m_renderPassInstance.subpass);
         const auto viewCount = Util::CountSetBits(viewMask);
 
         // Call Begin() and immediately call End() for all remaining queries,
@@ -4708,6 +6273,8 @@ void CmdBuffer::EndQueryIndexed(
     uint32_t    query,
     uint32_t    index)
 {
+    FlushQueryResets();
+
     DbgBarrierPreCmd(DbgBarrierQueryBeginEnd);
 
     // NOTE: This function is illegal to call for TimestampQueryPools and  AccelerationStructureQueryPools
@@ -4835,17 +6402,56 @@ void CmdBuffer::FillTimestampQueryPool(
 }
 
 // =====================================================================================================================
+// Resets are held back so that resets of adjacent ranges of the same pool, which engines tend to issue one per pass or
+// per object, become a single one.  Timestamp pool resets each idle the pipeline, so this saves more than the fill.
 void CmdBuffer::ResetQueryPool(
     VkQueryPool queryPool,
     uint32_t    firstQuery,
     uint32_t    queryCount)
+{
+    const QueryPool* pBasePool = QueryPool::ObjectFromHandle(queryPool);
+
+    if (m_flags.coalesceQueryResets)
+    {
+        const uint32_t pendingEnd = m_pendingQueryReset.firstQuery + m_pendingQueryReset.queryCount;
+
+        // Only ranges which overlap or touch are merged; a gap would reset queries the application didn't ask for.
+        if ((m_pendingQueryReset.pPool == pBasePool)        &&
+            (firstQuery <= pendingEnd)                      &&
+            (m_pendingQueryReset.firstQuery <= (firstQuery + queryCount)))
+        {
+            const uint32_t newFirst = Util::Min(firstQuery, m_pendingQueryReset.firstQuery);
+
+            m_pendingQueryReset.queryCount = Util::Max(firstQuery + queryCount, pendingEnd) - newFirst;
+            m_pendingQueryReset.firstQuery = newFirst;
+
+            m_stats.mergedQueryResetCount++;
+        }
+        else
+        {
+            FlushQueryResets();
+
+            m_pendingQueryReset.pPool      = pBasePool;
+            m_pendingQueryReset.firstQuery = firstQuery;
+            m_pendingQueryReset.queryCount = queryCount;
+        }
+    }
+    else
+    {
+        PalCmdResetQueryPool(pBasePool, firstQuery, queryCount);
+    }
+}
+
+// =====================================================================================================================
+void CmdBuffer::PalCmdResetQueryPool(
+    const QueryPool* pBasePool,
+    uint32_t         firstQuery,
+    uint32_t         queryCount)
 {
     DbgBarrierPreCmd(DbgBarrierQueryReset);
 
     PalCmdSuspendPredication(true);
 
-    const QueryPool* pBasePool = QueryPool::ObjectFromHandle(queryPool);
-
     if (pBasePool->GetQueryType() == VK_QUERY_TYPE_TIMESTAMP)
     {
         const TimestampQueryPool* pQueryPool = pBasePool->AsTimestampQueryPool();
@@ -4976,6 +6582,8 @@ void CmdBuffer::PalCmdSetMsaaQuadSamplePattern(
     uint32_t                          numSamplesPerPixel,
     const Pal::MsaaQuadSamplePattern& quadSamplePattern)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     utils::IterateMask deviceGroup(m_curDeviceMask);
     do
     {
@@ -4983,6 +6591,8 @@ void CmdBuffer::PalCmdSetMsaaQuadSamplePattern(
         PalCmdBuffer(deviceIdx)->CmdSetMsaaQuadSamplePattern(numSamplesPerPixel, quadSamplePattern);
     }
     while (deviceGroup.IterateNext());
+
+    m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
 }
 
 // =====================================================================================================================
@@ -5012,6 +6622,11 @@ void CmdBuffer::CopyQueryPoolResults(
     VkDeviceSize       destStride,
     VkQueryResultFlags flags)
 {
+    FlushQueryResets();
+
+    ForgetImageClear();
+    ForgetTransformFeedbackCounters();
+
     DbgBarrierPreCmd(DbgBarrierCopyBuffer | DbgBarrierCopyQueryPool);
 
     PalCmdSuspendPredication(true);
@@ -5022,6 +6637,8 @@ void CmdBuffer::CopyQueryPoolResults(
     if ((pBasePool->GetQueryType() != VK_QUERY_TYPE_TIMESTAMP)
        )
     {
+        // PAL resolves occlusion, pipeline statistics and transform feedback queries on the GPU, covering the whole
+        // range with a single command and waiting for the results there if requested.
         const PalQueryPool* pPool = pBasePool->AsPalQueryPool();
 
         utils::IterateMask deviceGroup(m_curDeviceMask);
@@ -5041,11 +6658,16 @@ void CmdBuffer::CopyQueryPoolResults(
         }
         while (deviceGroup.IterateNext());
     }
-    else
+    else if ((queryCount > 0) && (m_pDevice->GetTimestampQueryCopyPipeline() == nullptr))
+    {
+        // The copy pipeline is created on first use and that failed, so the copy can't be recorded.
+        m_recordingResult = VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    else if (queryCount > 0)
     {
         const QueryPoolWithStorageView* pPool = pBasePool->AsQueryPoolWithStorageView();
 
-        const Device::InternalPipeline& pipeline = m_pDevice->GetTimestampQueryCopyPipeline();
+        const Device::InternalPipeline& pipeline = *m_pDevice->GetTimestampQueryCopyPipeline();
 
         // Wait for all previous query timestamps to complete.  For now we have to do a full pipeline idle but once
         // we have a PAL interface for doing a 64-bit WAIT_REG_MEM, we only have to wait on the queries being copied
@@ -5161,7 +6783,7 @@ void CmdBuffer::CopyQueryPoolResults(
             // Figure out how many thread groups we need to dispatch and dispatch
             constexpr uint32_t ThreadsPerGroup = 64;
 
-            uint32_t threadGroupCount = Util::Max(1U, (queryCount + ThreadsPerGroup - 1) / ThreadsPerGroup);
+            const uint32_t threadGroupCount = (queryCount + ThreadsPerGroup - 1) / ThreadsPerGroup;
 
             PalCmdBuffer(deviceIdx)->CmdDispatch(threadGroupCount, 1, 1);
 
@@ -5185,6 +6807,8 @@ void CmdBuffer::WriteTimestamp(
     const TimestampQueryPool* pQueryPool,
     uint32_t                  query)
 {
+    FlushQueryResets();
+
     DbgBarrierPreCmd(DbgBarrierWriteTimestamp);
 
     PalCmdSuspendPredication(true);
@@ -5199,7 +6823,7 @@ void CmdBuffer::WriteTimestamp(
             pQueryPool->PalMemory(deviceIdx),
             pQueryPool->GetSlotOffset(query));
 
-        const auto* const pRenderPass = m_allGpuState.pRenderPass;
+        const uint32_t viewMask = GetActiveViewMask();
 
         // If vkCmdWriteTimestamp is called while executing a render pass instance that has multiview enabled,
         // the timestamp uses N consecutive query indices in the query pool (starting at query) where
@@ -5207,9 +6831,8 @@ void CmdBuffer::WriteTimestamp(
         //
         // The first query is a timestamp value and (if more than one bit is set in the view mask)
         // zero is written to the remaining queries.
-        if (pRenderPass && pRenderPass->IsMultiviewEnabled())
+        if (viewMask != 0)
         {
-            const auto viewMask  = pRenderPass->GetViewMask(m_renderPassInstance.subpass);
             const auto viewCount = Util::CountSetBits(viewMask);
 
             VK_ASSERT(viewCount > 0);
@@ -5271,6 +6894,91 @@ void CmdBuffer::RPInitSamplePattern()
     }
 }
 
+// =====================================================================================================================
+// Sets the current layout of each attachment of the render pass instance to the PAL version of its initial layout.
+void CmdBuffer::RPInitAttachmentLayouts()
+{
+    const uint32_t attachmentCount = m_allGpuState.pRenderPass->GetAttachmentCount();
+
+    for (uint32_t a = 0; a < attachmentCount; ++a)
+    {
+        // Start current layouts to PAL version of initial layout for each attachment.
+        constexpr Pal::ImageLayout NullLayout     = {};
+        const Framebuffer::Attachment& attachment = m_allGpuState.pFramebuffer->GetAttachment(a);
+        const uint32 firstPlane = attachment.subresRange[0].startSubres.plane;
+
+        const RPImageLayout initialLayout =
+        { m_allGpuState.pRenderPass->GetAttachmentDesc(a).initialLayout, 0 };
+
+        // Clear the planes not covered below as well since these layouts may be cached in the framebuffer.
+        for (uint32_t plane = 0; plane < Pal::MaxNumPlanes; ++plane)
+        {
+            RPSetAttachmentLayout(a, plane, NullLayout);
+        }
+
+        if (!attachment.pImage->IsDepthStencilFormat())
+        {
+            RPSetAttachmentLayout(
+                a,
+                firstPlane,
+                attachment.pImage->GetAttachmentLayout(initialLayout, firstPlane, this));
+        }
+        else
+        {
+            // Note that we set both depth and stencil aspect layouts for depth/stencil formats to define
+            // initial values for them.  This avoids some (incorrect) PAL asserts when clearing depth- or
+            // stencil-only surfaces.  Here, the missing aspect will have a null usage but a non-null engine
+            // component.
+            VK_ASSERT((firstPlane == 0) || (firstPlane == 1));
+
+            const RPImageLayout initialStencilLayout =
+            { m_allGpuState.pRenderPass->GetAttachmentDesc(a).stencilInitialLayout, 0 };
+
+            RPSetAttachmentLayout(
+                a,
+                0,
+                attachment.pImage->GetAttachmentLayout(initialLayout, 0, this));
+
+            RPSetAttachmentLayout(
+                a,
+                1,
+                attachment.pImage->GetAttachmentLayout(initialStencilLayout, 1, this));
+        }
+    }
+}
+
+// =====================================================================================================================
+// Caches the attachment layouts set by RPInitAttachmentLayouts() in the framebuffer for later render pass instances
+// of the same render pass.
+void CmdBuffer::RPCacheAttachmentLayouts()
+{
+    const uint32_t attachmentCount = m_allGpuState.pRenderPass->GetAttachmentCount();
+
+    VirtualStackFrame virtStackFrame(m_pStackAllocator);
+
+    Pal::ImageLayout* pLayouts = (attachmentCount > 0) ?
+        virtStackFrame.AllocArray<Pal::ImageLayout>(attachmentCount * Pal::MaxNumPlanes) : nullptr;
+
+    // Failing to allocate the temporary array only means the layouts aren't cached.
+    if (pLayouts != nullptr)
+    {
+        for (uint32_t a = 0; a < attachmentCount; ++a)
+        {
+            memcpy(&pLayouts[a * Pal::MaxNumPlanes],
+                   m_renderPassInstance.pAttachments[a].planeLayout,
+                   sizeof(m_renderPassInstance.pAttachments[a].planeLayout));
+        }
+
+        m_allGpuState.pFramebuffer->CacheBeginLayouts(
+            m_pDevice,
+            m_allGpuState.pRenderPass->GetHash(),
+            GetQueueFamilyIndex(),
+            pLayouts);
+
+        virtStackFrame.FreeArray(pLayouts);
+    }
+}
+
 // =====================================================================================================================
 // Begins a render pass instance (vkCmdBeginRenderPass)
 void CmdBuffer::BeginRenderPass(
@@ -5279,6 +6987,11 @@ void CmdBuffer::BeginRenderPass(
 {
     VK_IGNORE(contents);
 
+    // Query resets aren't allowed inside a render pass instance, so don't let a held back one end up in there.
+    FlushQueryResets();
+
+    ForgetImageClear();
+
     DbgBarrierPreCmd(DbgBarrierBeginRenderPass);
 
     m_allGpuState.pRenderPass  = RenderPass::ObjectFromHandle(pRenderPassBegin->renderPass);
@@ -5428,6 +7141,27 @@ void CmdBuffer::BeginRenderPass(
         m_allGpuState.pFramebuffer->SetImageViews(pRenderPassAttachmentBeginInfo);
     }
 
+    // The attachments of imageless framebuffers are only known now, and a compatible render pass may use attachments
+    // differently than the render pass they were planned for.
+    if ((result == Pal::Result::Success) && m_pDevice->GetTransientAliasPlanner()->IsEnabled())
+    {
+        const uint64_t planHash = m_allGpuState.pFramebuffer->GetTransientAliasPlanHash();
+
+        if (m_allGpuState.pFramebuffer->IsImageless() ||
+            ((planHash != 0) && (planHash != m_allGpuState.pRenderPass->GetHash())))
+        {
+            const VkResult planResult = m_allGpuState.pFramebuffer->PlanTransientAliasing(
+                m_pDevice, m_allGpuState.pRenderPass);
+
+            if (planResult != VK_SUCCESS)
+            {
+                m_recordingResult = planResult;
+
+                result = Pal::Result::ErrorOutOfGpuMemory;
+            }
+        }
+    }
+
     if (result == Pal::Result::Success)
     {
         m_renderPassInstance.subpass = 0;
@@ -5443,44 +7177,29 @@ void CmdBuffer::BeginRenderPass(
             }
         }
 
-        // Initialize current layout state based on attachment initial layout
-        for (uint32_t a = 0; a < attachmentCount; ++a)
-        {
-            // Start current layouts to PAL version of initial layout for each attachment.
-            constexpr Pal::ImageLayout NullLayout     = {};
-            const Framebuffer::Attachment& attachment = m_allGpuState.pFramebuffer->GetAttachment(a);
-            const uint32 firstPlane = attachment.subresRange[0].startSubres.plane;
-
-            const RPImageLayout initialLayout =
-            { m_allGpuState.pRenderPass->GetAttachmentDesc(a).initialLayout, 0 };
+        // Initialize current layout state based on attachment initial layout.  These only depend on the render pass,
+        // the framebuffer's images and the queue family, so they are resolved once and cached in the framebuffer.
+        const bool              cacheBeginLayouts = (m_allGpuState.pFramebuffer->IsImageless() == false);
+        const Pal::ImageLayout* pBeginLayouts     = cacheBeginLayouts ?
+            m_allGpuState.pFramebuffer->GetBeginLayouts(m_allGpuState.pRenderPass->GetHash(), GetQueueFamilyIndex()) :
+            nullptr;
 
-            if (!attachment.pImage->IsDepthStencilFormat())
+        if (pBeginLayouts != nullptr)
+        {
+            for (uint32_t a = 0; a < attachmentCount; ++a)
             {
-                RPSetAttachmentLayout(
-                    a,
-                    firstPlane,
-                    attachment.pImage->GetAttachmentLayout(initialLayout, firstPlane, this));
+                memcpy(m_renderPassInstance.pAttachments[a].planeLayout,
+                       &pBeginLayouts[a * Pal::MaxNumPlanes],
+                       sizeof(m_renderPassInstance.pAttachments[a].planeLayout));
             }
-            else
+        }
+        else
+        {
+            RPInitAttachmentLayouts();
+
+            if (cacheBeginLayouts)
             {
-                // Note that we set both depth and stencil aspect layouts for depth/stencil formats to define
-                // initial values for them.  This avoids some (incorrect) PAL asserts when clearing depth- or
-                // stencil-only surfaces.  Here, the missing aspect will have a null usage but a non-null engine
-                // component.
-                VK_ASSERT((firstPlane == 0) || (firstPlane == 1));
-
-                const RPImageLayout initialStencilLayout =
-                { m_allGpuState.pRenderPass->GetAttachmentDesc(a).stencilInitialLayout, 0 };
-
-                RPSetAttachmentLayout(
-                    a,
-                    0,
-                    attachment.pImage->GetAttachmentLayout(initialLayout, 0, this));
-
-                RPSetAttachmentLayout(
-                    a,
-                    1,
-                    attachment.pImage->GetAttachmentLayout(initialStencilLayout, 1, this));
+                RPCacheAttachmentLayouts();
             }
         }
 
@@ -5578,6 +7297,24 @@ void CmdBuffer::BeginRenderPass(
     DbgBarrierPostCmd(DbgBarrierBeginRenderPass);
 }
 
+// =====================================================================================================================
+// Contents kept across a layout transition may be needed after the render pass instance that produced them, so the
+// image can't share memory with other transient attachments anymore.
+void CmdBuffer::KeepTransientContents(
+    const Image*  pImage,
+    VkImageLayout oldLayout)
+{
+    if (pImage->IsTransientAliasBound() && (oldLayout != VK_IMAGE_LAYOUT_UNDEFINED))
+    {
+        const VkResult result = m_pDevice->GetTransientAliasPlanner()->MakePrivate(pImage);
+
+        if (result != VK_SUCCESS)
+        {
+            m_recordingResult = result;
+        }
+    }
+}
+
 // =====================================================================================================================
 // Advances to the next sub-pass in the current render pass (vkCmdNextSubPass)
 void CmdBuffer::NextSubPass(
@@ -5798,6 +7535,12 @@ void CmdBuffer::RPSyncPoint(
 
                     ppImages[barrier.transitionCount] = attachment.pImage;
 
+                    // Attachment layouts of render passes aren't tracked
+                    if ((m_pLayoutState != nullptr) && attachment.pImage->IsLayoutTracked())
+                    {
+                        m_pLayoutState->Forget(attachment.pImage);
+                    }
+
                     Pal::BarrierTransition* pLayoutTransition = &pPalTransitions[barrier.transitionCount++];
 
                     pLayoutTransition->srcCacheMask                 = 0;
@@ -5876,63 +7619,44 @@ void CmdBuffer::RPLoadOpClearColor(
         m_pSqttState->BeginRenderPassColorClear();
     }
 
-    VirtualStackFrame virtStackFrame(m_pStackAllocator);
-
-    Util::Vector<Pal::ClearBoundTargetRegion, 8, VirtualStackFrame> clearRegions{ &virtStackFrame };
-
-    const auto maxRects = EstimateMaxObjectsOnVirtualStack(sizeof(VkClearRect));
-    auto       rectBatch = Util::Min(count, maxRects);
-    const auto palResult = clearRegions.Reserve(rectBatch);
-
-    VK_ASSERT(palResult == Pal::Result::Success);
-
-    for (uint32_t i = 0; i < count; ++i)
+    if (m_flags.subpassLoadOpClearsBoundAttachments)
     {
-        const RPLoadOpClearInfo& clear = pClears[i];
-
-        const Framebuffer::Attachment& attachment = m_allGpuState.pFramebuffer->GetAttachment(clear.attachment);
-
-        // Convert the clear color to the format of the attachment view
-        Pal::ClearColor clearColor = VkToPalClearColor(
-            &m_renderPassInstance.pAttachments[clear.attachment].clearValue.color,
-            attachment.viewFormat);
-
-        Pal::BoundColorTarget target = {};
-        if (m_flags.subpassLoadOpClearsBoundAttachments)
+        RPLoadOpClearBoundColorTargets(count, pClears);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < count; ++i)
         {
-            const uint32_t tgtIdx = clear.attachment;
-            const RenderPass* pRenderPass = m_allGpuState.pRenderPass;
-            const uint32_t subpass = m_renderPassInstance.subpass;
-
-            target.targetIndex = tgtIdx;
-            target.swizzledFormat = attachment.viewFormat;
-            target.samples = pRenderPass->GetColorAttachmentSamples(subpass, tgtIdx);
-            target.fragments = pRenderPass->GetColorAttachmentSamples(subpass, tgtIdx);
-            target.clearValue = clearColor;
-        }
+            const RPLoadOpClearInfo& clear = pClears[i];
 
-        Pal::SubresRange subresRange;
-        attachment.pView->GetFrameBufferAttachmentSubresRange(&subresRange);
+            const Framebuffer::Attachment& attachment = m_allGpuState.pFramebuffer->GetAttachment(clear.attachment);
 
-        const Pal::ImageLayout clearLayout = RPGetAttachmentLayout(clear.attachment, subresRange.startSubres.plane);
+            // Convert the clear color to the format of the attachment view
+            Pal::ClearColor clearColor = VkToPalClearColor(
+                &m_renderPassInstance.pAttachments[clear.attachment].clearValue.color,
+                attachment.viewFormat);
 
-        VK_ASSERT(clearLayout.usages & Pal::LayoutColorTarget);
+            Pal::SubresRange subresRange;
+            attachment.pView->GetFrameBufferAttachmentSubresRange(&subresRange);
 
-        const auto clearSubresRanges = LoadOpClearSubresRanges(
-            attachment, clear,
-            *m_allGpuState.pRenderPass);
+            const Pal::ImageLayout clearLayout = RPGetAttachmentLayout(clear.attachment,
+                                                                       subresRange.startSubres.plane);
 
-        utils::IterateMask deviceGroup(GetRpDeviceMask());
+            VK_ASSERT(clearLayout.usages & Pal::LayoutColorTarget);
 
-        do
-        {
-            const uint32_t deviceIdx = deviceGroup.Index();
+            const auto clearSubresRanges = LoadOpClearSubresRanges(
+                attachment, clear,
+                *m_allGpuState.pRenderPass);
 
-            Pal::Box clearBox = BuildClearBox(m_renderPassInstance.renderArea[deviceIdx], attachment);
+            utils::IterateMask deviceGroup(GetRpDeviceMask());
 
-            if (m_flags.subpassLoadOpClearsBoundAttachments == false)
+            do
             {
-                 PalCmdBuffer(deviceIdx)->CmdClearColorImage(
+                const uint32_t deviceIdx = deviceGroup.Index();
+
+                Pal::Box clearBox = BuildClearBox(m_renderPassInstance.renderArea[deviceIdx], attachment);
+
+                PalCmdBuffer(deviceIdx)->CmdClearColorImage(
                     *attachment.pImage->PalImage(deviceIdx),
                     clearLayout,
                     clearColor,
@@ -5942,38 +7666,8 @@ void CmdBuffer::RPLoadOpClearColor(
                     &clearBox,
                     count == 1 ? Pal::ColorClearAutoSync : 0); // Multi-RT clears are synchronized later in RPBeginSubpass()
             }
-            else
-            {
-                const RenderPass* pRenderPass = m_allGpuState.pRenderPass;
-                const uint32_t subpass = m_renderPassInstance.subpass;
-
-                const VkRect2D rect =
-                {
-                    { clearBox.offset.x,        clearBox.offset.y },            //    VkOffset2D    offset;
-                    { clearBox.extent.width,    clearBox.extent.height},        //    VkExtent2D    extent;
-                };
-
-                const VkClearRect clearRect =
-                {
-                    rect,                                       // VkRect2D    rect;
-                    static_cast<uint32_t>(clearBox.offset.z),   // deUint32    baseArrayLayer;
-                    clearBox.extent.depth                       // deUint32    layerCount;
-                };
-
-                CreateClearRegions(
-                    1, &clearRect,
-                    *pRenderPass, subpass, 0u,
-                    &clearRegions);
-
-               // Clear the bound color targets
-               PalCmdBuffer(deviceIdx)->CmdClearBoundColorTargets(
-                        1,
-                        &target,
-                        clearRegions.NumElements(),
-                        clearRegions.Data());
-            }
+            while (deviceGroup.IterateNext());
         }
-        while (deviceGroup.IterateNext());
     }
 
     if (m_pSqttState != nullptr)
@@ -5983,31 +7677,142 @@ void CmdBuffer::RPLoadOpClearColor(
 }
 
 // =====================================================================================================================
-// Does one or more load-op depth-stencil clears during a render pass instance.
-void CmdBuffer::RPLoadOpClearDepthStencil(
+// Does load-op color clears of the currently bound color targets.  Attachments sharing the same clear box are cleared
+// together with a single CmdClearBoundColorTargets() call rather than one call per attachment.
+void CmdBuffer::RPLoadOpClearBoundColorTargets(
     uint32_t                 count,
     const RPLoadOpClearInfo* pClears)
 {
-    if (m_pSqttState != nullptr)
-    {
-        m_pSqttState->BeginRenderPassDepthStencilClear();
-    }
-
     VirtualStackFrame virtStackFrame(m_pStackAllocator);
 
     Util::Vector<Pal::ClearBoundTargetRegion, 8, VirtualStackFrame> clearRegions{ &virtStackFrame };
 
-    const auto maxRects = EstimateMaxObjectsOnVirtualStack(sizeof(VkClearRect));
-    auto       rectBatch = Util::Min(count, maxRects);
+    const RenderPass* pRenderPass = m_allGpuState.pRenderPass;
+    const uint32_t    subpass     = m_renderPassInstance.subpass;
 
-    for (uint32_t i = 0; i < count; ++i)
+    Pal::BoundColorTarget* pTargets = virtStackFrame.AllocArray<Pal::BoundColorTarget>(count);
+
+    if (pTargets != nullptr)
     {
-        const RPLoadOpClearInfo& clear = pClears[i];
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const RPLoadOpClearInfo& clear = pClears[i];
 
-        const Framebuffer::Attachment& attachment = m_allGpuState.pFramebuffer->GetAttachment(clear.attachment);
+            const Framebuffer::Attachment& attachment = m_allGpuState.pFramebuffer->GetAttachment(clear.attachment);
 
-        const Pal::ImageLayout depthLayout   = RPGetAttachmentLayout(clear.attachment, 0);
-        const Pal::ImageLayout stencilLayout = RPGetAttachmentLayout(clear.attachment, 1);
+#if PAL_ENABLE_PRINTS_ASSERTS
+            Pal::SubresRange subresRange;
+            attachment.pView->GetFrameBufferAttachmentSubresRange(&subresRange);
+
+            VK_ASSERT(RPGetAttachmentLayout(clear.attachment, subresRange.startSubres.plane).usages &
+                      Pal::LayoutColorTarget);
+#endif
+
+            const uint32_t tgtIdx = clear.attachment;
+
+            pTargets[i]                = {};
+            pTargets[i].targetIndex    = tgtIdx;
+            pTargets[i].swizzledFormat = attachment.viewFormat;
+            pTargets[i].samples        = pRenderPass->GetColorAttachmentSamples(subpass, tgtIdx);
+            pTargets[i].fragments      = pRenderPass->GetColorAttachmentSamples(subpass, tgtIdx);
+            pTargets[i].clearValue     = VkToPalClearColor(
+                &m_renderPassInstance.pAttachments[clear.attachment].clearValue.color,
+                attachment.viewFormat);
+        }
+
+        utils::IterateMask deviceGroup(GetRpDeviceMask());
+
+        do
+        {
+            const uint32_t deviceIdx = deviceGroup.Index();
+
+            uint32_t batchStart = 0;
+
+            while (batchStart < count)
+            {
+                const Pal::Box clearBox = BuildClearBox(
+                    m_renderPassInstance.renderArea[deviceIdx],
+                    m_allGpuState.pFramebuffer->GetAttachment(pClears[batchStart].attachment));
+
+                // The 2D area comes from the render area, so only the slice range can differ between attachments.
+                uint32_t batchEnd = batchStart + 1;
+
+                while (batchEnd < count)
+                {
+                    const Pal::Box nextBox = BuildClearBox(
+                        m_renderPassInstance.renderArea[deviceIdx],
+                        m_allGpuState.pFramebuffer->GetAttachment(pClears[batchEnd].attachment));
+
+                    if ((nextBox.offset.z != clearBox.offset.z) || (nextBox.extent.depth != clearBox.extent.depth))
+                    {
+                        break;
+                    }
+
+                    ++batchEnd;
+                }
+
+                const VkRect2D rect =
+                {
+                    { clearBox.offset.x,        clearBox.offset.y },            //    VkOffset2D    offset;
+                    { clearBox.extent.width,    clearBox.extent.height},        //    VkExtent2D    extent;
+                };
+
+                const VkClearRect clearRect =
+                {
+                    rect,                                       // VkRect2D    rect;
+                    static_cast<uint32_t>(clearBox.offset.z),   // deUint32    baseArrayLayer;
+                    clearBox.extent.depth                       // deUint32    layerCount;
+                };
+
+                CreateClearRegions(
+                    1, &clearRect,
+                    pRenderPass->GetViewMask(subpass), 0u,
+                    &clearRegions);
+
+                // Clear the bound color targets
+                PalCmdBuffer(deviceIdx)->CmdClearBoundColorTargets(
+                    batchEnd - batchStart,
+                    &pTargets[batchStart],
+                    clearRegions.NumElements(),
+                    clearRegions.Data());
+
+                batchStart = batchEnd;
+            }
+        }
+        while (deviceGroup.IterateNext());
+    }
+    else
+    {
+        m_recordingResult = VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+}
+
+// =====================================================================================================================
+// Does one or more load-op depth-stencil clears during a render pass instance.
+void CmdBuffer::RPLoadOpClearDepthStencil(
+    uint32_t                 count,
+    const RPLoadOpClearInfo* pClears)
+{
+    if (m_pSqttState != nullptr)
+    {
+        m_pSqttState->BeginRenderPassDepthStencilClear();
+    }
+
+    VirtualStackFrame virtStackFrame(m_pStackAllocator);
+
+    Util::Vector<Pal::ClearBoundTargetRegion, 8, VirtualStackFrame> clearRegions{ &virtStackFrame };
+
+    const auto maxRects = EstimateMaxObjectsOnVirtualStack(sizeof(VkClearRect));
+    auto       rectBatch = Util::Min(count, maxRects);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const RPLoadOpClearInfo& clear = pClears[i];
+
+        const Framebuffer::Attachment& attachment = m_allGpuState.pFramebuffer->GetAttachment(clear.attachment);
+
+        const Pal::ImageLayout depthLayout   = RPGetAttachmentLayout(clear.attachment, 0);
+        const Pal::ImageLayout stencilLayout = RPGetAttachmentLayout(clear.attachment, 1);
 
         // Convert the clear color to the format of the attachment view
         const VkClearValue& clearValue = m_renderPassInstance.pAttachments[clear.attachment].clearValue;
@@ -6078,7 +7883,7 @@ void CmdBuffer::RPLoadOpClearDepthStencil(
 
                 CreateClearRegions(
                     1, &clearRect,
-                    *pRenderPass, subpass, 0u,
+                    pRenderPass->GetViewMask(subpass), 0u,
                     &clearRegions);
 
                 // Clear the bound depth stencil target immediately
@@ -6298,11 +8103,12 @@ void CmdBuffer::RPBindTargets(
 }
 
 // =====================================================================================================================
-// Sets view instance mask for a subpass during a render pass instance (on devices within passed in device mask).
+// Sets view instance mask for a subpass during a render pass or dynamic rendering instance (on devices within passed in
+// device mask).
 void CmdBuffer::SetViewInstanceMask(
     uint32_t deviceMask)
 {
-    const uint32_t subpassViewMask = m_allGpuState.pRenderPass->GetViewMask(m_renderPassInstance.subpass);
+    const uint32_t subpassViewMask = GetActiveViewMask();
 
     utils::IterateMask deviceGroup(deviceMask);
 
@@ -6380,6 +8186,511 @@ void CmdBuffer::EndRenderPass()
 }
 
 // =====================================================================================================================
+// Begins a dynamic rendering instance (vkCmdBeginRenderingKHR).  Targets are bound and load ops are done straight from
+// the attachment info of the call.  Unlike BeginRenderPass() there is no render pass to execute: the application has
+// already put the attachments into the given layouts with its own barriers, so no sync points or layout transitions
+// are recorded.
+void CmdBuffer::BeginRendering(
+    const VkRenderingInfoKHR* pRenderingInfo)
+{
+    // Query resets aren't allowed inside a render pass instance, so don't let a held back one end up in there.
+    FlushQueryResets();
+
+    ForgetImageClear();
+
+    DbgBarrierPreCmd(DbgBarrierBeginRenderPass);
+
+    const auto* pDeviceGroupInfo = GetExtensionStructure<VkDeviceGroupRenderPassBeginInfo>(
+        pRenderingInfo, VK_STRUCTURE_TYPE_DEVICE_GROUP_RENDER_PASS_BEGIN_INFO);
+
+    // Set the instance's device mask to the value the command buffer began with.
+    SetRpDeviceMask(m_cbBeginDeviceMask);
+
+    m_dynamicRendering.renderAreaCount = m_pDevice->NumPalDevices();
+
+    for (uint32_t deviceIdx = 0; deviceIdx < m_dynamicRendering.renderAreaCount; deviceIdx++)
+    {
+        m_dynamicRendering.renderArea[deviceIdx] = VkToPalRect(pRenderingInfo->renderArea);
+    }
+
+    if (pDeviceGroupInfo != nullptr)
+    {
+        SetRpDeviceMask(pDeviceGroupInfo->deviceMask);
+
+        SetDeviceMask(GetRpDeviceMask());
+
+        if (pDeviceGroupInfo->deviceRenderAreaCount > 0)
+        {
+            VK_ASSERT(m_pDevice->NumPalDevices() == pDeviceGroupInfo->deviceRenderAreaCount);
+
+            for (uint32_t deviceIdx = 0; deviceIdx < pDeviceGroupInfo->deviceRenderAreaCount; deviceIdx++)
+            {
+                m_dynamicRendering.renderArea[deviceIdx] = VkToPalRect(pDeviceGroupInfo->pDeviceRenderAreas[deviceIdx]);
+            }
+        }
+    }
+
+    m_dynamicRendering.active     = true;
+    m_dynamicRendering.flags      = pRenderingInfo->flags;
+    m_dynamicRendering.viewMask   = pRenderingInfo->viewMask;
+    m_dynamicRendering.layerCount = pRenderingInfo->layerCount;
+
+    utils::IterateMask deviceGroup(GetRpDeviceMask());
+    do
+    {
+        const uint32_t deviceIdx = deviceGroup.Index();
+
+        Pal::GlobalScissorParams scissorParams = { };
+        scissorParams.scissorRegion = m_dynamicRendering.renderArea[deviceIdx];
+
+        PalCmdBuffer(deviceIdx)->CmdSetGlobalScissor(scissorParams);
+    }
+    while (deviceGroup.IterateNext());
+
+    DRBindTargets(*pRenderingInfo);
+
+    if (m_dynamicRendering.samples > 1)
+    {
+        // If sample patterns are set in a bound pipeline, use those as the defaults
+        const Pal::MsaaQuadSamplePattern* pPipelineSampleLocations =
+            ((m_allGpuState.pGraphicsPipeline != nullptr) &&
+              m_allGpuState.pGraphicsPipeline->CustomSampleLocationsEnabled()) ?
+                m_allGpuState.pGraphicsPipeline->GetSampleLocations() : nullptr;
+
+        m_dynamicRendering.samplePattern.sampleCount = m_dynamicRendering.samples;
+        m_dynamicRendering.samplePattern.locations   = (pPipelineSampleLocations != nullptr) ?
+            *pPipelineSampleLocations : *Device::GetDefaultQuadSamplePattern(m_dynamicRendering.samples);
+
+        PalCmdSetMsaaQuadSamplePattern(
+            m_dynamicRendering.samplePattern.sampleCount,
+            m_dynamicRendering.samplePattern.locations);
+    }
+
+    // A resumed instance continues the suspended one, so its attachments were already loaded.
+    if ((pRenderingInfo->flags & VK_RENDERING_RESUMING_BIT_KHR) == 0)
+    {
+        DRLoadOpClears(*pRenderingInfo);
+    }
+
+    // Set view instance mask, on devices in the instance's device mask
+    SetViewInstanceMask(GetRpDeviceMask());
+
+    DbgBarrierPostCmd(DbgBarrierBeginRenderPass);
+}
+
+// =====================================================================================================================
+// Records the resolve of a dynamic rendering attachment, which is done at the end of the instance.
+void CmdBuffer::DRAddResolve(
+    const VkRenderingAttachmentInfoKHR& attachment,
+    uint32_t                            plane)
+{
+    VK_ASSERT(m_dynamicRendering.resolveCount < VK_ARRAY_SIZE(m_dynamicRendering.resolves));
+
+    const ImageView* pSrcView = ImageView::ObjectFromHandle(attachment.imageView);
+    const ImageView* pDstView = ImageView::ObjectFromHandle(attachment.resolveImageView);
+
+    const RPImageLayout srcLayout = { attachment.imageLayout,        Pal::LayoutResolveSrc };
+    const RPImageLayout dstLayout = { attachment.resolveImageLayout, Pal::LayoutResolveDst };
+
+    auto* pResolve = &m_dynamicRendering.resolves[m_dynamicRendering.resolveCount++];
+
+    pResolve->pSrcView    = pSrcView;
+    pResolve->pDstView    = pDstView;
+    pResolve->srcLayout   = pSrcView->GetImage()->GetAttachmentLayout(srcLayout, plane, this);
+    pResolve->dstLayout   = pDstView->GetImage()->GetAttachmentLayout(dstLayout, plane, this);
+    pResolve->plane       = plane;
+    pResolve->resolveMode = attachment.resolveMode;
+}
+
+// =====================================================================================================================
+// Binds the color/depth targets of a dynamic rendering instance.  Attachments which are resolved at the end of the
+// instance are bound in a layout which is also resolve-compatible, so the resolve doesn't need a layout transition.
+void CmdBuffer::DRBindTargets(
+    const VkRenderingInfoKHR& renderingInfo)
+{
+    static constexpr Pal::ImageLayout NullLayout = {};
+
+    Pal::BindTargetParams params = {};
+
+    params.colorTargetCount = Util::Min(renderingInfo.colorAttachmentCount, Pal::MaxColorTargets);
+
+    m_dynamicRendering.colorAttachmentCount = params.colorTargetCount;
+    m_dynamicRendering.depthStencilFormat   = VK_FORMAT_UNDEFINED;
+    m_dynamicRendering.samples              = 1;
+    m_dynamicRendering.resolveCount         = 0;
+
+    const ImageView* pColorViews[Pal::MaxColorTargets] = {};
+
+    for (uint32_t i = 0; i < params.colorTargetCount; ++i)
+    {
+        const VkRenderingAttachmentInfoKHR& attachment = renderingInfo.pColorAttachments[i];
+
+        pColorViews[i] = ImageView::ObjectFromHandle(attachment.imageView);
+
+        m_dynamicRendering.colorFormats[i] = VK_FORMAT_UNDEFINED;
+
+        if (pColorViews[i] != nullptr)
+        {
+            const Image* pImage    = pColorViews[i]->GetImage();
+            const bool   isResolve = (attachment.resolveMode != VK_RESOLVE_MODE_NONE) &&
+                                     (attachment.resolveImageView != VK_NULL_HANDLE);
+
+            const RPImageLayout layout = { attachment.imageLayout, isResolve ? Pal::LayoutResolveSrc : 0u };
+
+            params.colorTargets[i].imageLayout = pImage->GetAttachmentLayout(layout, 0, this);
+
+            m_dynamicRendering.colorFormats[i] = pColorViews[i]->GetViewFormat();
+            m_dynamicRendering.samples         = pImage->GetImageSamples();
+
+            if (isResolve)
+            {
+                DRAddResolve(attachment, 0);
+            }
+        }
+        else
+        {
+            params.colorTargets[i].imageLayout = NullLayout;
+        }
+    }
+
+    // Both attachments must use the same view if both are given.  Either one may be missing or have a null view.
+    const VkRenderingAttachmentInfoKHR* pDepth   =
+        ((renderingInfo.pDepthAttachment != nullptr) &&
+         (renderingInfo.pDepthAttachment->imageView != VK_NULL_HANDLE)) ? renderingInfo.pDepthAttachment : nullptr;
+    const VkRenderingAttachmentInfoKHR* pStencil =
+        ((renderingInfo.pStencilAttachment != nullptr) &&
+         (renderingInfo.pStencilAttachment->imageView != VK_NULL_HANDLE)) ? renderingInfo.pStencilAttachment : nullptr;
+
+    const ImageView* pDepthStencilView = nullptr;
+
+    if ((pDepth != nullptr) || (pStencil != nullptr))
+    {
+        const VkRenderingAttachmentInfoKHR& depthInfo   = (pDepth != nullptr)   ? *pDepth   : *pStencil;
+        const VkRenderingAttachmentInfoKHR& stencilInfo = (pStencil != nullptr) ? *pStencil : *pDepth;
+
+        pDepthStencilView = ImageView::ObjectFromHandle(depthInfo.imageView);
+
+        const Image*   pImage       = pDepthStencilView->GetImage();
+        const VkFormat format       = pDepthStencilView->GetViewFormat();
+        const uint32_t stencilPlane = Formats::HasDepth(format) ? 1 : 0;
+
+        const bool depthResolve   = (pDepth != nullptr) && Formats::HasDepth(format) &&
+                                    (pDepth->resolveMode != VK_RESOLVE_MODE_NONE) &&
+                                    (pDepth->resolveImageView != VK_NULL_HANDLE);
+        const bool stencilResolve = (pStencil != nullptr) && Formats::HasStencil(format) &&
+                                    (pStencil->resolveMode != VK_RESOLVE_MODE_NONE) &&
+                                    (pStencil->resolveImageView != VK_NULL_HANDLE);
+
+        const RPImageLayout depthLayout   = { depthInfo.imageLayout,   depthResolve   ? Pal::LayoutResolveSrc : 0u };
+        const RPImageLayout stencilLayout = { stencilInfo.imageLayout, stencilResolve ? Pal::LayoutResolveSrc : 0u };
+
+        params.depthTarget.depthLayout   = pImage->GetAttachmentLayout(depthLayout, 0, this);
+        params.depthTarget.stencilLayout = pImage->GetAttachmentLayout(stencilLayout, stencilPlane, this);
+
+        m_dynamicRendering.depthStencilFormat = format;
+        m_dynamicRendering.samples            = pImage->GetImageSamples();
+
+        if (depthResolve)
+        {
+            DRAddResolve(*pDepth, 0);
+        }
+
+        if (stencilResolve)
+        {
+            DRAddResolve(*pStencil, stencilPlane);
+        }
+    }
+    else
+    {
+        params.depthTarget.depthLayout   = NullLayout;
+        params.depthTarget.stencilLayout = NullLayout;
+    }
+
+    utils::IterateMask deviceGroup(GetRpDeviceMask());
+    do
+    {
+        const uint32_t deviceIdx = deviceGroup.Index();
+
+        for (uint32_t i = 0; i < params.colorTargetCount; ++i)
+        {
+            params.colorTargets[i].pColorTargetView =
+                (pColorViews[i] != nullptr) ? pColorViews[i]->PalColorTargetView(deviceIdx) : nullptr;
+        }
+
+        params.depthTarget.pDepthStencilView =
+            (pDepthStencilView != nullptr) ? pDepthStencilView->PalDepthStencilView(deviceIdx) : nullptr;
+
+        PalCmdBuffer(deviceIdx)->CmdBindTargets(params);
+    }
+    while (deviceGroup.IterateNext());
+}
+
+// =====================================================================================================================
+// Does the load-op clears of a dynamic rendering instance on the bound targets.  Bound target clears are pipelined by
+// the hardware, so no barriers are needed around them.
+void CmdBuffer::DRLoadOpClears(
+    const VkRenderingInfoKHR& renderingInfo)
+{
+    VirtualStackFrame virtStackFrame(m_pStackAllocator);
+
+    Util::Vector<Pal::ClearBoundTargetRegion, 8, VirtualStackFrame> clearRegions { &virtStackFrame };
+    Util::Vector<Pal::BoundColorTarget,       8, VirtualStackFrame> colorTargets { &virtStackFrame };
+
+    for (uint32_t i = 0; i < m_dynamicRendering.colorAttachmentCount; ++i)
+    {
+        const VkRenderingAttachmentInfoKHR& attachment = renderingInfo.pColorAttachments[i];
+
+        if ((m_dynamicRendering.colorFormats[i] != VK_FORMAT_UNDEFINED) &&
+            (attachment.loadOp == VK_ATTACHMENT_LOAD_OP_CLEAR))
+        {
+            Pal::BoundColorTarget target = {};
+            target.targetIndex    = i;
+            target.swizzledFormat = VkToPalFormat(m_dynamicRendering.colorFormats[i], m_pDevice->GetRuntimeSettings());
+            target.samples        = m_dynamicRendering.samples;
+            target.fragments      = m_dynamicRendering.samples;
+            target.clearValue     = VkToPalClearColor(&attachment.clearValue.color, target.swizzledFormat);
+
+            if (colorTargets.PushBack(target) != Pal::Result::Success)
+            {
+                m_recordingResult = VK_ERROR_OUT_OF_HOST_MEMORY;
+            }
+        }
+    }
+
+    Pal::DepthStencilSelectFlags selectFlags = {};
+
+    if (m_dynamicRendering.depthStencilFormat != VK_FORMAT_UNDEFINED)
+    {
+        selectFlags.depth   = (renderingInfo.pDepthAttachment != nullptr) &&
+                              (renderingInfo.pDepthAttachment->imageView != VK_NULL_HANDLE) &&
+                              (renderingInfo.pDepthAttachment->loadOp == VK_ATTACHMENT_LOAD_OP_CLEAR) &&
+                              Formats::HasDepth(m_dynamicRendering.depthStencilFormat);
+        selectFlags.stencil = (renderingInfo.pStencilAttachment != nullptr) &&
+                              (renderingInfo.pStencilAttachment->imageView != VK_NULL_HANDLE) &&
+                              (renderingInfo.pStencilAttachment->loadOp == VK_ATTACHMENT_LOAD_OP_CLEAR) &&
+                              Formats::HasStencil(m_dynamicRendering.depthStencilFormat);
+    }
+
+    const bool clearDepthStencil = (selectFlags.depth || selectFlags.stencil);
+
+    if ((colorTargets.NumElements() > 0) || clearDepthStencil)
+    {
+        const float clearDepth   = selectFlags.depth ?
+            VkToPalClearDepth(renderingInfo.pDepthAttachment->clearValue.depthStencil.depth) : 0.0f;
+        const uint8_t clearStencil = selectFlags.stencil ?
+            static_cast<uint8_t>(renderingInfo.pStencilAttachment->clearValue.depthStencil.stencil) : 0;
+
+        utils::IterateMask deviceGroup(GetRpDeviceMask());
+        do
+        {
+            const uint32_t  deviceIdx  = deviceGroup.Index();
+            const Pal::Rect renderArea = m_dynamicRendering.renderArea[deviceIdx];
+
+            const VkClearRect clearRect =
+            {
+                { { renderArea.offset.x, renderArea.offset.y },                 // VkOffset2D    offset;
+                  { renderArea.extent.width, renderArea.extent.height } },      // VkExtent2D    extent;
+                0u,                                                             // uint32_t      baseArrayLayer;
+                m_dynamicRendering.layerCount                                   // uint32_t      layerCount;
+            };
+
+            if (CreateClearRegions(1, &clearRect, m_dynamicRendering.viewMask, 0u, &clearRegions) ==
+                Pal::Result::Success)
+            {
+                if (colorTargets.NumElements() > 0)
+                {
+                    PalCmdBuffer(deviceIdx)->CmdClearBoundColorTargets(
+                        colorTargets.NumElements(),
+                        colorTargets.Data(),
+                        clearRegions.NumElements(),
+                        clearRegions.Data());
+                }
+
+                if (clearDepthStencil)
+                {
+                    PalCmdBuffer(deviceIdx)->CmdClearBoundDepthStencilTargets(
+                        clearDepth,
+                        clearStencil,
+                        StencilWriteMaskFull,
+                        m_dynamicRendering.samples,
+                        m_dynamicRendering.samples,
+                        selectFlags,
+                        clearRegions.NumElements(),
+                        clearRegions.Data());
+                }
+            }
+            else
+            {
+                m_recordingResult = VK_ERROR_OUT_OF_HOST_MEMORY;
+            }
+        }
+        while (deviceGroup.IterateNext());
+    }
+}
+
+// =====================================================================================================================
+// Resolves the attachments of a dynamic rendering instance at its end.  The attachments are already in
+// resolve-compatible layouts, so only the target writes have to be made visible to the resolve and the resolve writes
+// made visible like the attachment writes the application will synchronize against.
+void CmdBuffer::DRResolveAttachments()
+{
+    constexpr Pal::BarrierFlags NullFlags = {};
+
+    static const Pal::BarrierTransition PreTransition =
+    {
+        Pal::CoherColorTarget | Pal::CoherDepthStencilTarget,
+        Pal::CoherResolve,
+        {}
+    };
+
+    static const Pal::HwPipePoint PrePipePoint = Pal::HwPipeBottom;
+    static const Pal::BarrierInfo PreBarrier   =
+    {
+        NullFlags,                          // flags
+        Pal::HwPipePreBlt,                  // waitPoint
+        1,                                  // pipePointWaitCount
+        &PrePipePoint,                      // pPipePoints
+        0,                                  // gpuEventWaitCount
+        nullptr,                            // ppGpuEvents
+        0,                                  // rangeCheckedTargetWaitCount
+        nullptr,                            // ppTargets
+        1,                                  // transitionCount
+        &PreTransition,                     // pTransitions
+        0,                                  // globalSrcCacheMask
+        0,                                  // globalDstCacheMask
+        nullptr,                            // pSplitBarrierGpuEvent
+        RgpBarrierExternalRenderPassSync    // reason
+    };
+
+    static const Pal::BarrierTransition PostTransition =
+    {
+        Pal::CoherResolve,
+        Pal::CoherColorTarget | Pal::CoherDepthStencilTarget,
+        {}
+    };
+
+    static const Pal::HwPipePoint PostPipePoint = Pal::HwPipePostBlt;
+    static const Pal::BarrierInfo PostBarrier   =
+    {
+        NullFlags,                          // flags
+        Pal::HwPipePreRasterization,        // waitPoint
+        1,                                  // pipePointWaitCount
+        &PostPipePoint,                     // pPipePoints
+        0,                                  // gpuEventWaitCount
+        nullptr,                            // ppGpuEvents
+        0,                                  // rangeCheckedTargetWaitCount
+        nullptr,                            // ppTargets
+        1,                                  // transitionCount
+        &PostTransition,                    // pTransitions
+        0,                                  // globalSrcCacheMask
+        0,                                  // globalDstCacheMask
+        nullptr,                            // pSplitBarrierGpuEvent
+        RgpBarrierExternalRenderPassSync    // reason
+    };
+
+    if (m_pSqttState != nullptr)
+    {
+        m_pSqttState->BeginRenderPassResolve();
+    }
+
+    PalCmdBarrier(PreBarrier, GetRpDeviceMask());
+
+    for (uint32_t i = 0; i < m_dynamicRendering.resolveCount; ++i)
+    {
+        const DynamicRenderingInstanceState::ResolveAttachment& resolve = m_dynamicRendering.resolves[i];
+
+        Pal::SubresRange srcRange;
+        Pal::SubresRange dstRange;
+
+        resolve.pSrcView->GetFrameBufferAttachmentSubresRange(&srcRange);
+        resolve.pDstView->GetFrameBufferAttachmentSubresRange(&dstRange);
+
+        // We expect MSAA images to never have mipmaps
+        VK_ASSERT(srcRange.startSubres.mipLevel == 0);
+
+        uint32_t sliceCount = Util::Min(srcRange.numSlices, dstRange.numSlices);
+
+        if (m_dynamicRendering.viewMask == 0)
+        {
+            sliceCount = Util::Min(sliceCount, m_dynamicRendering.layerCount);
+        }
+
+        // Must be specified for depth because the source image was created with sampleLocsAlwaysKnown set
+        const Pal::MsaaQuadSamplePattern* pSampleLocations =
+            Formats::IsDepthStencilFormat(resolve.pSrcView->GetViewFormat()) ?
+                &m_dynamicRendering.samplePattern.locations : nullptr;
+
+        // During split-frame-rendering, the image to resolve could be split across multiple devices.
+        Pal::ImageResolveRegion regions[MaxPalDevices];
+
+        for (uint32_t idx = 0; idx < m_dynamicRendering.renderAreaCount; idx++)
+        {
+            const Pal::Rect& renderArea = m_dynamicRendering.renderArea[idx];
+
+            regions[idx].srcPlane           = resolve.plane;
+            regions[idx].srcSlice           = srcRange.startSubres.arraySlice;
+            regions[idx].srcOffset.x        = renderArea.offset.x;
+            regions[idx].srcOffset.y        = renderArea.offset.y;
+            regions[idx].srcOffset.z        = 0;
+            regions[idx].dstPlane           = resolve.plane;
+            regions[idx].dstMipLevel        = dstRange.startSubres.mipLevel;
+            regions[idx].dstSlice           = dstRange.startSubres.arraySlice;
+            regions[idx].dstOffset.x        = renderArea.offset.x;
+            regions[idx].dstOffset.y        = renderArea.offset.y;
+            regions[idx].dstOffset.z        = 0;
+            regions[idx].extent.width       = renderArea.extent.width;
+            regions[idx].extent.height      = renderArea.extent.height;
+            regions[idx].extent.depth       = 1;
+            regions[idx].numSlices          = sliceCount;
+            regions[idx].swizzledFormat     = Pal::UndefinedSwizzledFormat;
+            regions[idx].pQuadSamplePattern = pSampleLocations;
+        }
+
+        PalCmdResolveImage<false>(
+            *resolve.pSrcView->GetImage(),
+            resolve.srcLayout,
+            *resolve.pDstView->GetImage(),
+            resolve.dstLayout,
+            VkToPalResolveMode(resolve.resolveMode),
+            m_dynamicRendering.renderAreaCount,
+            regions,
+            GetRpDeviceMask());
+    }
+
+    PalCmdBarrier(PostBarrier, GetRpDeviceMask());
+
+    if (m_pSqttState != nullptr)
+    {
+        m_pSqttState->EndRenderPassResolve();
+    }
+}
+
+// =====================================================================================================================
+// Ends a dynamic rendering instance (vkCmdEndRenderingKHR).  The resolves of a suspended instance are done by the
+// instance which resumes it.
+void CmdBuffer::EndRendering()
+{
+    DbgBarrierPreCmd(DbgBarrierEndRenderPass);
+
+    if (m_dynamicRendering.active &&
+        (m_dynamicRendering.resolveCount > 0) &&
+        ((m_dynamicRendering.flags & VK_RENDERING_SUSPENDING_BIT_KHR) == 0))
+    {
+        DRResolveAttachments();
+    }
+
+    // Clean up instance state
+    m_dynamicRendering.active               = false;
+    m_dynamicRendering.viewMask             = 0;
+    m_dynamicRendering.colorAttachmentCount = 0;
+    m_dynamicRendering.depthStencilFormat   = VK_FORMAT_UNDEFINED;
+    m_dynamicRendering.resolveCount         = 0;
+
+    DbgBarrierPostCmd(DbgBarrierEndRenderPass);
+}
+
+// =====================================================================================================================
+template <uint32_t numPalDevices>
 VK_INLINE void CmdBuffer::WritePushConstants(
     PipelineBindPoint      apiBindPoint,
     Pal::PipelineBindPoint palBindPoint,
@@ -6388,13 +8699,23 @@ VK_INLINE void CmdBuffer::WritePushConstants(
     uint32_t               lengthInDwords,
     const uint32_t* const  pInputValues)
 {
-    PipelineBindState* pBindState = &m_allGpuState.pipelineState[apiBindPoint];
-    Pal::uint32* pUserData = reinterpret_cast<Pal::uint32*>(&pBindState->pushConstData[0]);
-    uint32_t* pUserDataPtr = pUserData + startInDwords;
+    PipelineBindState* pBindState   = &m_allGpuState.pipelineState[apiBindPoint];
+    uint32_t*          pUserDataPtr = &pBindState->pushConstData[startInDwords];
+
+    m_touchedUserDataMask |= (1u << apiBindPoint);
+
+    const uint32_t rangeMask = static_cast<uint32_t>(((uint64_t(1) << lengthInDwords) - 1) << startInDwords);
+
+    // Dwords which have to be written: those whose value changes and those not known to be programmed yet.
+    uint32_t changedMask = rangeMask & ~pBindState->pushConstProgrammedMask;
 
     for (uint32_t i = 0; i < lengthInDwords; i++)
     {
-        pUserDataPtr[i] = pInputValues[i];
+        if (pUserDataPtr[i] != pInputValues[i])
+        {
+            pUserDataPtr[i] = pInputValues[i];
+            changedMask    |= (1u << (startInDwords + i));
+        }
     }
 
     pBindState->pushedConstCount = Util::Max(pBindState->pushedConstCount, startInDwords + lengthInDwords);
@@ -6408,23 +8729,53 @@ VK_INLINE void CmdBuffer::WritePushConstants(
     if (PalPipelineBindingOwnedBy(palBindPoint, apiBindPoint) &&
         pBindState->userDataLayout.pushConstRegBase == userDataLayout.pushConstRegBase)
     {
-        utils::IterateMask deviceGroup(m_curDeviceMask);
-        do
+        uint32_t firstDword = 0;
+        uint32_t lastDword  = 0;
+
+        // Only the span between the first and last changed dword is written.  Engines typically update a few dwords of
+        // a larger block per draw, so this is usually a single register instead of the whole range.
+        if (Util::BitMaskScanForward(&firstDword, changedMask))
         {
-            const uint32_t deviceIdx = deviceGroup.Index();
+            Util::BitMaskScanReverse(&lastDword, changedMask);
 
-            PalCmdBuffer(deviceIdx)->CmdSetUserData(
-                palBindPoint,
-                pBindState->userDataLayout.pushConstRegBase + startInDwords,
-                lengthInDwords,
-                pUserDataPtr);
+            if ((numPalDevices > 1) && (m_pDeviceGroupStream != nullptr))
+            {
+                // Push constants are the same on all devices.
+                m_pDeviceGroupStream->CmdSetUserData(m_curDeviceMask,
+                                                     palBindPoint,
+                                                     pBindState->userDataLayout.pushConstRegBase + firstDword,
+                                                     lastDword - firstDword + 1,
+                                                     0,
+                                                     &pBindState->pushConstData[firstDword]);
+            }
+            else
+            {
+                utils::IterateDeviceMask<numPalDevices> deviceGroup(m_curDeviceMask);
+                do
+                {
+                    const uint32_t deviceIdx = deviceGroup.Index();
+
+                    PalCmdBuffer(deviceIdx)->CmdSetUserData(
+                        palBindPoint,
+                        pBindState->userDataLayout.pushConstRegBase + firstDword,
+                        lastDword - firstDword + 1,
+                        &pBindState->pushConstData[firstDword]);
+                }
+                while (deviceGroup.IterateNext());
+            }
         }
-        while (deviceGroup.IterateNext());
+
+        pBindState->pushConstProgrammedMask |= rangeMask;
+    }
+    else
+    {
+        pBindState->pushConstProgrammedMask &= ~rangeMask;
     }
 }
 
 // =====================================================================================================================
 // Set push constant values
+template <uint32_t numPalDevices>
 void CmdBuffer::PushConstants(
     VkPipelineLayout                            layout,
     VkShaderStageFlags                          stageFlags,
@@ -6445,33 +8796,36 @@ void CmdBuffer::PushConstants(
 
     if ((stageFlags & VK_SHADER_STAGE_COMPUTE_BIT) != 0)
     {
-        WritePushConstants(PipelineBindCompute,
-                           Pal::PipelineBindPoint::Compute,
-                           pLayout,
-                           startInDwords,
-                           lengthInDwords,
-                           pInputValues);
+        WritePushConstants<numPalDevices>(PipelineBindCompute,
+                                          Pal::PipelineBindPoint::Compute,
+                                          pLayout,
+                                          startInDwords,
+                                          lengthInDwords,
+                                          pInputValues);
     }
 
     if ((stageFlags & VK_SHADER_STAGE_ALL_GRAPHICS) != 0)
     {
-        WritePushConstants(PipelineBindGraphics,
-                           Pal::PipelineBindPoint::Graphics,
-                           pLayout,
-                           startInDwords,
-                           lengthInDwords,
-                           pInputValues);
+        WritePushConstants<numPalDevices>(PipelineBindGraphics,
+                                          Pal::PipelineBindPoint::Graphics,
+                                          pLayout,
+                                          startInDwords,
+                                          lengthInDwords,
+                                          pInputValues);
     }
 
     DbgBarrierPostCmd(DbgBarrierBindSetsPushConstants);
 }
 
 // =====================================================================================================================
+template <uint32_t numPalDevices>
 void CmdBuffer::SetViewport(
     uint32_t            firstViewport,
     uint32_t            viewportCount,
     const VkViewport*   pViewports)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     // If we hit this assert the application did not set the right number of viewports
     // in VkPipelineViewportStateCreateInfo.viewportCount.
     // VK_ASSERT((firstViewport + viewportCount) <= m_state.viewport.count);
@@ -6479,24 +8833,42 @@ void CmdBuffer::SetViewport(
     const bool khrMaintenance1 = ((m_pDevice->VkPhysicalDevice(DefaultDeviceIndex)->GetEnabledAPIVersion() >= VK_MAKE_VERSION(1, 1, 0)) ||
                                   m_pDevice->IsExtensionEnabled(DeviceExtensions::KHR_MAINTENANCE1));
 
-    utils::IterateMask deviceGroup(m_curDeviceMask);
+    bool changed = (m_allGpuState.known.viewport == 0);
+
+    utils::IterateDeviceMask<numPalDevices> deviceGroup(m_curDeviceMask);
 
     do
     {
         const uint32_t deviceIndex = deviceGroup.Index();
 
+        Pal::ViewportParams* pViewportParams = &PerGpuState(deviceIndex)->viewport;
+
         for (uint32_t i = 0; i < viewportCount; ++i)
         {
+            const Pal::Viewport prevViewport = pViewportParams->viewports[firstViewport + i];
+
             VkToPalViewport(pViewports[i],
                             firstViewport + i,
                             khrMaintenance1,
-                            &PerGpuState(deviceIndex)->viewport);
+                            pViewportParams);
+
+            changed |= (memcmp(&prevViewport,
+                               &pViewportParams->viewports[firstViewport + i],
+                               sizeof(prevViewport)) != 0);
         }
     }
     while (deviceGroup.IterateNext());
 
-    m_allGpuState.dirty.viewport         = 1;
-    m_allGpuState.staticTokens.viewports = DynamicRenderStateToken;
+    if (changed)
+    {
+        m_allGpuState.dirty.viewport         = 1;
+        m_allGpuState.known.viewport         = 1;
+        m_allGpuState.staticTokens.viewports = DynamicRenderStateToken;
+    }
+    else
+    {
+        m_stats.filteredStateCount++;
+    }
 }
 
 // =====================================================================================================================
@@ -6504,10 +8876,18 @@ void CmdBuffer::SetViewportWithCount(
     uint32_t            viewportCount,
     const VkViewport*   pViewports)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     utils::IterateMask deviceGroup(m_curDeviceMask);
     do
     {
-        PerGpuState(deviceGroup.Index())->viewport.count = viewportCount;
+        Pal::ViewportParams* pViewportParams = &PerGpuState(deviceGroup.Index())->viewport;
+
+        if (pViewportParams->count != viewportCount)
+        {
+            pViewportParams->count       = viewportCount;
+            m_allGpuState.known.viewport = 0;
+        }
     }
     while (deviceGroup.IterateNext());
 
@@ -6519,6 +8899,8 @@ void CmdBuffer::SetAllViewports(
     const Pal::ViewportParams& params,
     uint32_t                   staticToken)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     VK_ASSERT(m_cbBeginDeviceMask == m_pDevice->GetPalDeviceMask());
     utils::IterateMask deviceGroup(m_cbBeginDeviceMask);
     do
@@ -6535,29 +8917,51 @@ void CmdBuffer::SetAllViewports(
     while (deviceGroup.IterateNext());
 
     m_allGpuState.dirty.viewport         = 1;
+    m_allGpuState.known.viewport         = 1;
     m_allGpuState.staticTokens.viewports = staticToken;
 }
 
 // =====================================================================================================================
+template <uint32_t numPalDevices>
 void CmdBuffer::SetScissor(
     uint32_t            firstScissor,
     uint32_t            scissorCount,
     const VkRect2D*     pScissors)
 {
-    utils::IterateMask deviceGroup(m_curDeviceMask);
+    m_touchedStateMask |= TrackedStateGraphics;
+
+    bool changed = (m_allGpuState.known.scissor == 0);
+
+    utils::IterateDeviceMask<numPalDevices> deviceGroup(m_curDeviceMask);
     do
     {
         const uint32_t deviceIdx = deviceGroup.Index();
 
+        Pal::ScissorRectParams* pScissorParams = &PerGpuState(deviceIdx)->scissor;
+
         for (uint32_t i = 0; i < scissorCount; ++i)
         {
-            VkToPalScissorRect(pScissors[i], firstScissor + i, &PerGpuState(deviceIdx)->scissor);
+            const Pal::Rect prevScissor = pScissorParams->scissors[firstScissor + i];
+
+            VkToPalScissorRect(pScissors[i], firstScissor + i, pScissorParams);
+
+            changed |= (memcmp(&prevScissor,
+                               &pScissorParams->scissors[firstScissor + i],
+                               sizeof(prevScissor)) != 0);
         }
     }
     while (deviceGroup.IterateNext());
 
-    m_allGpuState.dirty.scissor            = 1;
-    m_allGpuState.staticTokens.scissorRect = DynamicRenderStateToken;
+    if (changed)
+    {
+        m_allGpuState.dirty.scissor            = 1;
+        m_allGpuState.known.scissor            = 1;
+        m_allGpuState.staticTokens.scissorRect = DynamicRenderStateToken;
+    }
+    else
+    {
+        m_stats.filteredStateCount++;
+    }
 }
 
 // =====================================================================================================================
@@ -6565,10 +8969,18 @@ void CmdBuffer::SetScissorWithCount(
     uint32_t            scissorCount,
     const VkRect2D*     pScissors)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     utils::IterateMask deviceGroup(m_curDeviceMask);
     do
     {
-        PerGpuState(deviceGroup.Index())->scissor.count = scissorCount;
+        Pal::ScissorRectParams* pScissorParams = &PerGpuState(deviceGroup.Index())->scissor;
+
+        if (pScissorParams->count != scissorCount)
+        {
+            pScissorParams->count       = scissorCount;
+            m_allGpuState.known.scissor = 0;
+        }
     }
     while (deviceGroup.IterateNext());
 
@@ -6580,6 +8992,8 @@ void CmdBuffer::SetAllScissors(
     const Pal::ScissorRectParams& params,
     uint32_t                      staticToken)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     VK_ASSERT(m_cbBeginDeviceMask == m_pDevice->GetPalDeviceMask());
 
     utils::IterateMask deviceGroup(m_cbBeginDeviceMask);
@@ -6597,6 +9011,7 @@ void CmdBuffer::SetAllScissors(
     while (deviceGroup.IterateNext());
 
     m_allGpuState.dirty.scissor            = 1;
+    m_allGpuState.known.scissor            = 1;
     m_allGpuState.staticTokens.scissorRect = staticToken;
 }
 
@@ -6604,7 +9019,7 @@ void CmdBuffer::SetAllScissors(
 void CmdBuffer::SetLineWidth(
     float               lineWidth)
 {
-    DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+    m_touchedStateMask |= TrackedStateGraphics;
 
     constexpr float PointWidth           = 1.0f;    // gl_PointSize is arbitrary, elsewhere pointSize is 1.0
     const VkPhysicalDeviceLimits& limits = m_pDevice->VkPhysicalDevice(DefaultDeviceIndex)->GetLimits();
@@ -6614,17 +9029,32 @@ void CmdBuffer::SetLineWidth(
                                                      limits.pointSizeRange[0],
                                                      limits.pointSizeRange[1] };
 
-    utils::IterateMask deviceGroup(m_curDeviceMask);
-
-    do
+    if (IsRedundantDynamicState(m_allGpuState.known.lineWidth,
+                                m_allGpuState.staticTokens.pointLineRasterState,
+                                m_allGpuState.pointLineRasterState,
+                                params))
     {
-        PalCmdBuffer(deviceGroup.Index())->CmdSetPointLineRasterState(params);
+        m_stats.filteredStateCount++;
     }
-    while (deviceGroup.IterateNext());
+    else
+    {
+        DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+
+        utils::IterateMask deviceGroup(m_curDeviceMask);
+
+        do
+        {
+            PalCmdBuffer(deviceGroup.Index())->CmdSetPointLineRasterState(params);
+        }
+        while (deviceGroup.IterateNext());
 
-    m_allGpuState.staticTokens.pointLineRasterState = DynamicRenderStateToken;
+        m_allGpuState.pointLineRasterState              = params;
+        m_allGpuState.known.lineWidth                   = 1;
+        m_allGpuState.staticTokens.pointLineRasterState = DynamicRenderStateToken;
+        m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
 
-    DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+        DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+    }
 }
 
 // =====================================================================================================================
@@ -6633,42 +9063,72 @@ void CmdBuffer::SetDepthBias(
     float               depthBiasClamp,
     float               slopeScaledDepthBias)
 {
-    DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+    m_touchedStateMask |= TrackedStateGraphics;
 
     const Pal::DepthBiasParams params = {depthBias, depthBiasClamp, slopeScaledDepthBias};
 
-    utils::IterateMask deviceGroup(m_curDeviceMask);
-
-    do
+    if (IsRedundantDynamicState(m_allGpuState.known.depthBias,
+                                m_allGpuState.staticTokens.depthBiasState,
+                                m_allGpuState.depthBias,
+                                params))
     {
-        PalCmdBuffer(deviceGroup.Index())->CmdSetDepthBiasState(params);
+        m_stats.filteredStateCount++;
     }
-    while (deviceGroup.IterateNext());
+    else
+    {
+        DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+
+        utils::IterateMask deviceGroup(m_curDeviceMask);
+
+        do
+        {
+            PalCmdBuffer(deviceGroup.Index())->CmdSetDepthBiasState(params);
+        }
+        while (deviceGroup.IterateNext());
 
-    m_allGpuState.staticTokens.depthBiasState = DynamicRenderStateToken;
+        m_allGpuState.depthBias                   = params;
+        m_allGpuState.known.depthBias             = 1;
+        m_allGpuState.staticTokens.depthBiasState = DynamicRenderStateToken;
+        m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
 
-    DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+        DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+    }
 }
 
 // =====================================================================================================================
 void CmdBuffer::SetBlendConstants(
     const float         blendConst[4])
 {
-    DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+    m_touchedStateMask |= TrackedStateGraphics;
 
     const Pal::BlendConstParams params = { blendConst[0], blendConst[1], blendConst[2], blendConst[3] };
 
-    utils::IterateMask deviceGroup(m_curDeviceMask);
-
-    do
+    if (IsRedundantDynamicState(m_allGpuState.known.blendConst,
+                                m_allGpuState.staticTokens.blendConst,
+                                m_allGpuState.blendConst,
+                                params))
     {
-        PalCmdBuffer(deviceGroup.Index())->CmdSetBlendConst(params);
+        m_stats.filteredStateCount++;
     }
-    while (deviceGroup.IterateNext());
+    else
+    {
+        DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+
+        utils::IterateMask deviceGroup(m_curDeviceMask);
+
+        do
+        {
+            PalCmdBuffer(deviceGroup.Index())->CmdSetBlendConst(params);
+        }
+        while (deviceGroup.IterateNext());
 
-    m_allGpuState.staticTokens.blendConst = DynamicRenderStateToken;
+        m_allGpuState.blendConst              = params;
+        m_allGpuState.known.blendConst        = 1;
+        m_allGpuState.staticTokens.blendConst = DynamicRenderStateToken;
+        m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
 
-    DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+        DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+    }
 }
 
 // =====================================================================================================================
@@ -6676,21 +9136,54 @@ void CmdBuffer::SetDepthBounds(
     float               minDepthBounds,
     float               maxDepthBounds)
 {
-    DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+    m_touchedStateMask |= TrackedStateGraphics;
 
     const Pal::DepthBoundsParams params = { minDepthBounds, maxDepthBounds };
 
-    utils::IterateMask deviceGroup(m_curDeviceMask);
-
-    do
+    if (IsRedundantDynamicState(m_allGpuState.known.depthBounds,
+                                m_allGpuState.staticTokens.depthBounds,
+                                m_allGpuState.depthBounds,
+                                params))
     {
-        PalCmdBuffer(deviceGroup.Index())->CmdSetDepthBounds(params);
+        m_stats.filteredStateCount++;
     }
-    while (deviceGroup.IterateNext());
+    else
+    {
+        DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+
+        utils::IterateMask deviceGroup(m_curDeviceMask);
+
+        do
+        {
+            PalCmdBuffer(deviceGroup.Index())->CmdSetDepthBounds(params);
+        }
+        while (deviceGroup.IterateNext());
 
-    m_allGpuState.staticTokens.depthBounds = DynamicRenderStateToken;
+        m_allGpuState.depthBounds              = params;
+        m_allGpuState.known.depthBounds        = 1;
+        m_allGpuState.staticTokens.depthBounds = DynamicRenderStateToken;
+        m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
 
-    DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+        DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+    }
+}
+
+// =====================================================================================================================
+// Marks the stencil reference and masks dirty if the new values differ from the recorded ones.
+void CmdBuffer::UpdateStencilRefMasks(
+    const Pal::StencilRefMaskParams& stencilRefMasks)
+{
+    if ((m_allGpuState.known.stencilRef == 0) ||
+        (memcmp(&m_allGpuState.stencilRefMasks, &stencilRefMasks, sizeof(stencilRefMasks)) != 0))
+    {
+        m_allGpuState.stencilRefMasks  = stencilRefMasks;
+        m_allGpuState.known.stencilRef = 1;
+        m_allGpuState.dirty.stencilRef = 1;
+    }
+    else
+    {
+        m_stats.filteredStateCount++;
+    }
 }
 
 // =====================================================================================================================
@@ -6698,16 +9191,20 @@ void CmdBuffer::SetStencilCompareMask(
     VkStencilFaceFlags  faceMask,
     uint32_t            stencilCompareMask)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
+    Pal::StencilRefMaskParams stencilRefMasks = m_allGpuState.stencilRefMasks;
+
     if (faceMask & VK_STENCIL_FACE_FRONT_BIT)
     {
-        m_allGpuState.stencilRefMasks.frontReadMask = static_cast<uint8_t>(stencilCompareMask);
+        stencilRefMasks.frontReadMask = static_cast<uint8_t>(stencilCompareMask);
     }
     if (faceMask & VK_STENCIL_FACE_BACK_BIT)
     {
-        m_allGpuState.stencilRefMasks.backReadMask = static_cast<uint8_t>(stencilCompareMask);
+        stencilRefMasks.backReadMask = static_cast<uint8_t>(stencilCompareMask);
     }
 
-    m_allGpuState.dirty.stencilRef = 1;
+    UpdateStencilRefMasks(stencilRefMasks);
 }
 
 // =====================================================================================================================
@@ -6715,16 +9212,20 @@ void CmdBuffer::SetStencilWriteMask(
     VkStencilFaceFlags  faceMask,
     uint32_t            stencilWriteMask)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
+    Pal::StencilRefMaskParams stencilRefMasks = m_allGpuState.stencilRefMasks;
+
     if (faceMask & VK_STENCIL_FACE_FRONT_BIT)
     {
-        m_allGpuState.stencilRefMasks.frontWriteMask = static_cast<uint8_t>(stencilWriteMask);
+        stencilRefMasks.frontWriteMask = static_cast<uint8_t>(stencilWriteMask);
     }
     if (faceMask & VK_STENCIL_FACE_BACK_BIT)
     {
-        m_allGpuState.stencilRefMasks.backWriteMask = static_cast<uint8_t>(stencilWriteMask);
+        stencilRefMasks.backWriteMask = static_cast<uint8_t>(stencilWriteMask);
     }
 
-    m_allGpuState.dirty.stencilRef = 1;
+    UpdateStencilRefMasks(stencilRefMasks);
 }
 
 // =====================================================================================================================
@@ -6732,16 +9233,20 @@ void CmdBuffer::SetStencilReference(
     VkStencilFaceFlags  faceMask,
     uint32_t            stencilReference)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
+    Pal::StencilRefMaskParams stencilRefMasks = m_allGpuState.stencilRefMasks;
+
     if (faceMask & VK_STENCIL_FACE_FRONT_BIT)
     {
-        m_allGpuState.stencilRefMasks.frontRef = static_cast<uint8_t>(stencilReference);
+        stencilRefMasks.frontRef = static_cast<uint8_t>(stencilReference);
     }
     if (faceMask & VK_STENCIL_FACE_BACK_BIT)
     {
-        m_allGpuState.stencilRefMasks.backRef = static_cast<uint8_t>(stencilReference);
+        stencilRefMasks.backRef = static_cast<uint8_t>(stencilReference);
     }
 
-    m_allGpuState.dirty.stencilRef = 1;
+    UpdateStencilRefMasks(stencilRefMasks);
 }
 
 // =====================================================================================================================
@@ -6813,6 +9318,9 @@ void CmdBuffer::WriteBufferMarker(
     VkDeviceSize            dstOffset,
     uint32_t                marker)
 {
+    ForgetImageClear();
+    ForgetTransformFeedbackCounters();
+
     const Buffer* pDestBuffer        = Buffer::ObjectFromHandle(dstBuffer);
     const Pal::HwPipePoint pipePoint = VkToPalSrcPipePointForMarkers(pipelineStage, m_palEngineType);
 
@@ -6831,6 +9339,26 @@ void CmdBuffer::WriteBufferMarker(
     while (deviceGroup.IterateNext());
 }
 
+// =====================================================================================================================
+// Opens a timed region for a vkCmdBeginDebugUtilsLabelEXT label.
+void CmdBuffer::BeginDebugLabel(
+    const VkDebugUtilsLabelEXT* pLabelInfo)
+{
+    if (m_flags.gpuTimingActive)
+    {
+        m_pGpuTiming->LabelBegin(PalCmdBuffer(DefaultDeviceIndex), pLabelInfo->pLabelName);
+    }
+}
+
+// =====================================================================================================================
+void CmdBuffer::EndDebugLabel()
+{
+    if (m_flags.gpuTimingActive)
+    {
+        m_pGpuTiming->LabelEnd(PalCmdBuffer(DefaultDeviceIndex));
+    }
+}
+
 // =====================================================================================================================
 void CmdBuffer::BindTransformFeedbackBuffers(
     uint32_t            firstBinding,
@@ -6860,6 +9388,8 @@ void CmdBuffer::BindTransformFeedbackBuffers(
     {
         VK_ASSERT(m_pTransformFeedbackState->enabled == false);
 
+        const Pal::BindStreamOutTargetParams prevParams = m_pTransformFeedbackState->params;
+
         utils::IterateMask deviceGroup(m_curDeviceMask);
         do
         {
@@ -6897,6 +9427,12 @@ void CmdBuffer::BindTransformFeedbackBuffers(
             }
         }
         while (deviceGroup.IterateNext());
+
+        // Rebinding the same buffers between passes keeps the targets EndTransformFeedback left bound usable
+        if (memcmp(&prevParams, &m_pTransformFeedbackState->params, sizeof(prevParams)) != 0)
+        {
+            ForgetTransformFeedbackCounters();
+        }
     }
 }
 
@@ -6907,22 +9443,41 @@ void CmdBuffer::BeginTransformFeedback(
     const VkBuffer*     pCounterBuffers,
     const VkDeviceSize* pCounterBufferOffsets)
 {
-    utils::IterateMask deviceGroup(m_curDeviceMask);
-    if (m_pTransformFeedbackState != nullptr)
+    if ((m_pTransformFeedbackState != nullptr) && (m_pTransformFeedbackState->bindMask != 0))
     {
-        do
+        TransformFeedbackCounter counters[Pal::MaxStreamOutTargets] = {};
+
+        if (pCounterBuffers != nullptr)
         {
-            uint64_t counterBufferAddr[Pal::MaxStreamOutTargets] = {};
+            GetCounterBuffers(firstCounterBuffer, counterBufferCount, pCounterBuffers, pCounterBufferOffsets, counters);
+        }
 
-            const uint32_t deviceIdx = deviceGroup.Index();
-            if (pCounterBuffers != nullptr)
+        // A pass which resumes from the counters the previous EndTransformFeedback saved to, with nothing which could
+        // have written them in between, finds its targets still bound and the filled sizes already in the GPU.
+        bool resident = (m_flags.xfbCountersResident != 0);
+
+        for (uint32_t i = 0; resident && (i < Pal::MaxStreamOutTargets); i++)
+        {
+            if ((m_pTransformFeedbackState->bindMask & (1 << i)) != 0)
             {
-                CalcCounterBufferAddrs(firstCounterBuffer, counterBufferCount, pCounterBuffers, pCounterBufferOffsets,
-                                       counterBufferAddr, deviceIdx);
+                const TransformFeedbackCounter& saved = m_pTransformFeedbackState->savedCounters[i];
+
+                resident = (counters[i].buffer != VK_NULL_HANDLE) &&
+                           (counters[i].buffer == saved.buffer)   &&
+                           (counters[i].offset == saved.offset);
             }
+        }
 
-            if (m_pTransformFeedbackState->bindMask != 0)
+        if (resident == false)
+        {
+            utils::IterateMask deviceGroup(m_curDeviceMask);
+            do
             {
+                uint64_t counterBufferAddr[Pal::MaxStreamOutTargets] = {};
+
+                const uint32_t deviceIdx = deviceGroup.Index();
+                CalcCounterBufferAddrs(counters, counterBufferAddr, deviceIdx);
+
                 PalCmdBuffer(deviceIdx)->CmdBindStreamOutTargets(m_pTransformFeedbackState->params);
                 PalCmdBuffer(deviceIdx)->CmdLoadBufferFilledSizes(counterBufferAddr);
 
@@ -6934,11 +9489,14 @@ void CmdBuffer::BeginTransformFeedback(
                         PalCmdBuffer(deviceIdx)->CmdSetBufferFilledSize(i, 0);
                     }
                 }
-
-                m_pTransformFeedbackState->enabled = true;
             }
+            while (deviceGroup.IterateNext());
         }
-        while (deviceGroup.IterateNext());
+
+        m_pTransformFeedbackState->enabled       = true;
+        m_pTransformFeedbackState->unbindPending = false;
+
+        ForgetTransformFeedbackCounters();
     }
 }
 
@@ -6951,55 +9509,102 @@ void CmdBuffer::EndTransformFeedback(
 {
     if ((m_pTransformFeedbackState != nullptr) && (m_pTransformFeedbackState->enabled))
     {
+        TransformFeedbackCounter* pCounters = m_pTransformFeedbackState->savedCounters;
+
+        memset(pCounters, 0, sizeof(m_pTransformFeedbackState->savedCounters));
+
+        if (pCounterBuffers != nullptr)
+        {
+            GetCounterBuffers(firstCounterBuffer,
+                              counterBufferCount,
+                              pCounterBuffers,
+                              pCounterBufferOffsets,
+                              pCounters);
+        }
+
         utils::IterateMask deviceGroup(m_curDeviceMask);
         do
         {
             uint64_t counterBufferAddr[Pal::MaxStreamOutTargets] = {};
 
             const uint32_t deviceIdx = deviceGroup.Index();
-            if (pCounterBuffers != nullptr)
-            {
-                CalcCounterBufferAddrs(firstCounterBuffer, counterBufferCount, pCounterBuffers, pCounterBufferOffsets,
-                                       counterBufferAddr, deviceIdx);
-            }
+            CalcCounterBufferAddrs(pCounters, counterBufferAddr, deviceIdx);
 
-            if (m_pTransformFeedbackState->bindMask != 0)
-            {
-                PalCmdBuffer(deviceIdx)->CmdSaveBufferFilledSizes(counterBufferAddr);
+            PalCmdBuffer(deviceIdx)->CmdSaveBufferFilledSizes(counterBufferAddr);
+        }
+        while (deviceGroup.IterateNext());
 
-                // Disable transform feedback by set bound buffer's size and stride to 0.
-                Pal::BindStreamOutTargetParams  params = {};
-                PalCmdBuffer(deviceIdx)->CmdBindStreamOutTargets(params);
-                m_pTransformFeedbackState->enabled = false;
-            }
+        // The targets are unbound before the next draw rather than here, see UnbindTransformFeedbackTargets(), so that
+        // a BeginTransformFeedback resuming from the saved counters before that doesn't need to bind and load them.
+        m_pTransformFeedbackState->enabled       = false;
+        m_pTransformFeedbackState->unbindPending = true;
+
+        m_allGpuState.dirty.xfbTargets = 1;
+        m_flags.xfbCountersResident    = 1;
+    }
+}
+
+// =====================================================================================================================
+// Unbinds the transform feedback targets EndTransformFeedback left bound, if any.  Must be called before anything
+// which could draw.
+void CmdBuffer::UnbindTransformFeedbackTargets()
+{
+    if ((m_pTransformFeedbackState != nullptr) && m_pTransformFeedbackState->unbindPending)
+    {
+        // Disable transform feedback by set bound buffer's size and stride to 0.
+        const Pal::BindStreamOutTargetParams params = {};
+
+        utils::IterateMask deviceGroup(m_cbBeginDeviceMask);
+        do
+        {
+            PalCmdBuffer(deviceGroup.Index())->CmdBindStreamOutTargets(params);
         }
         while (deviceGroup.IterateNext());
+
+        m_pTransformFeedbackState->unbindPending = false;
+
+        ForgetTransformFeedbackCounters();
     }
 }
 
 // =====================================================================================================================
-VK_INLINE void CmdBuffer::CalcCounterBufferAddrs(
-    uint32_t            firstCounterBuffer,
-    uint32_t            counterBufferCount,
-    const VkBuffer*     pCounterBuffers,
-    const VkDeviceSize* pCounterBufferOffsets,
-    uint64_t*           counterBufferAddr,
-    uint32_t            deviceIdx)
+// Gathers the counter buffers of the bound transform feedback targets, indexed by target.  Targets without one are
+// left alone.
+void CmdBuffer::GetCounterBuffers(
+    uint32_t                  firstCounterBuffer,
+    uint32_t                  counterBufferCount,
+    const VkBuffer*           pCounterBuffers,
+    const VkDeviceSize*       pCounterBufferOffsets,
+    TransformFeedbackCounter* pCounters) const
 {
-    for (uint32_t i = firstCounterBuffer; i < (firstCounterBuffer + counterBufferCount); i++)
+    VK_ASSERT(firstCounterBuffer + counterBufferCount <= Pal::MaxStreamOutTargets);
+
+    for (uint32_t i = 0; i < counterBufferCount; i++)
     {
+        const uint32_t slot = firstCounterBuffer + i;
+
         if ((pCounterBuffers[i] != VK_NULL_HANDLE) &&
-            (m_pTransformFeedbackState->bindMask & (1 << i)))
+            (m_pTransformFeedbackState->bindMask & (1 << slot)))
         {
-            Buffer* pCounterBuffer = Buffer::ObjectFromHandle(pCounterBuffers[i]);
-            if (pCounterBufferOffsets != nullptr)
-            {
-                counterBufferAddr[i] = pCounterBuffer->GpuVirtAddr(deviceIdx) + pCounterBufferOffsets[i];
-            }
-            else
-            {
-                counterBufferAddr[i] = pCounterBuffer->GpuVirtAddr(deviceIdx);
-            }
+            pCounters[slot].buffer = pCounterBuffers[i];
+            pCounters[slot].offset = (pCounterBufferOffsets != nullptr) ? pCounterBufferOffsets[i] : 0;
+        }
+    }
+}
+
+// =====================================================================================================================
+VK_INLINE void CmdBuffer::CalcCounterBufferAddrs(
+    const TransformFeedbackCounter* pCounters,
+    uint64_t*                       counterBufferAddr,
+    uint32_t                        deviceIdx)
+{
+    for (uint32_t i = 0; i < Pal::MaxStreamOutTargets; i++)
+    {
+        if (pCounters[i].buffer != VK_NULL_HANDLE)
+        {
+            Buffer* pCounterBuffer = Buffer::ObjectFromHandle(pCounters[i].buffer);
+
+            counterBufferAddr[i] = pCounterBuffer->GpuVirtAddr(deviceIdx) + pCounters[i].offset;
         }
     }
 }
@@ -7017,6 +9622,8 @@ void CmdBuffer::DrawIndirectByteCount(
 
     ValidateStates();
 
+    PipelineStatsPreCmd(PipelineBindGraphics);
+
     utils::IterateMask deviceGroup(m_curDeviceMask);
     do
     {
@@ -7031,6 +9638,29 @@ void CmdBuffer::DrawIndirectByteCount(
             instanceCount);
     }
     while (deviceGroup.IterateNext());
+
+    PipelineStatsPostCmd();
+}
+
+// =====================================================================================================================
+// Starts a pipeline statistics sample of the next draw or dispatch, attributed to the pipeline bound to the given bind
+// point.  Only the default device's command buffer is sampled.
+void CmdBuffer::BeginPipelineStatsSample(
+    PipelineBindPoint bindPoint)
+{
+    const Pipeline* pPipeline = (bindPoint == PipelineBindCompute)
+                              ? static_cast<const Pipeline*>(m_allGpuState.pComputePipeline)
+                              : static_cast<const Pipeline*>(m_allGpuState.pGraphicsPipeline);
+
+    const uint64_t apiHash = (pPipeline != nullptr) ? pPipeline->GetApiHash() : 0;
+
+    m_pPipelineStats->BeginSample(PalCmdBuffer(DefaultDeviceIndex), apiHash);
+}
+
+// =====================================================================================================================
+void CmdBuffer::EndPipelineStatsSample()
+{
+    m_pPipelineStats->EndSample(PalCmdBuffer(DefaultDeviceIndex));
 }
 
 // =====================================================================================================================
@@ -7038,6 +9668,8 @@ void CmdBuffer::SetLineStippleEXT(
     const Pal::LineStippleStateParams& params,
     uint32_t                           staticToken)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     m_allGpuState.lineStipple = params;
 
     utils::IterateMask deviceGroup(m_cbBeginDeviceMask);
@@ -7049,6 +9681,7 @@ void CmdBuffer::SetLineStippleEXT(
     while (deviceGroup.IterateNext());
 
     m_allGpuState.staticTokens.lineStippleState = staticToken;
+    m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
 }
 
 // =====================================================================================================================
@@ -7056,6 +9689,8 @@ void CmdBuffer::SetLineStippleEXT(
     uint32_t lineStippleFactor,
     uint16_t lineStipplePattern)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     // The line stipple factor is adjusted by one (carried over from OpenGL)
     m_allGpuState.lineStipple.lineStippleScale = (lineStippleFactor - 1);
 
@@ -7070,6 +9705,7 @@ void CmdBuffer::SetLineStippleEXT(
     while (deviceGroup.IterateNext());
 
     m_allGpuState.staticTokens.lineStippleState = DynamicRenderStateToken;
+    m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
 }
 
 // =====================================================================================================================
@@ -7077,6 +9713,8 @@ void CmdBuffer::CmdSetPerDrawVrsRate(
     const VkExtent2D*                        pFragmentSize,
     const VkFragmentShadingRateCombinerOpKHR combinerOps[2])
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     m_allGpuState.vrsRate.shadingRate = VkToPalShadingSize(
         VkClampShadingRate(*pFragmentSize, m_pDevice->GetMaxVrsShadingRate()));
 
@@ -7097,6 +9735,7 @@ void CmdBuffer::CmdSetPerDrawVrsRate(
     // Calling Pal->CmdSetPerDrawVrsRate will happen in ValidateStates
     m_allGpuState.dirty.vrs                        = 1;
     m_allGpuState.staticTokens.fragmentShadingRate = DynamicRenderStateToken;
+    m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
 }
 
 // =====================================================================================================================
@@ -7155,164 +9794,173 @@ void CmdBuffer::CmdEndConditionalRendering()
 }
 
 // =====================================================================================================================
-void CmdBuffer::ValidateStates()
+// Flushes the dirty dynamic state to PAL.  Only called through ValidateStates() when at least one dirty bit is set.
+void CmdBuffer::ValidateDirtyStates()
 {
-    if (m_allGpuState.dirty.u32All != 0)
+    VK_ASSERT(m_allGpuState.dirty.u32All != 0);
+
+    m_stats.validatedDrawCount++;
+
+    Pal::IDepthStencilState* pPalDepthStencil[MaxPalDevices] = {};
+
+    utils::IterateMask deviceGroup(m_cbBeginDeviceMask);
+    do
     {
-        Pal::IDepthStencilState* pPalDepthStencil[MaxPalDevices] = {};
+        const uint32_t deviceIdx = deviceGroup.Index();
 
-        utils::IterateMask deviceGroup(m_cbBeginDeviceMask);
-        do
+        if (m_allGpuState.dirty.viewport)
         {
-            const uint32_t deviceIdx = deviceGroup.Index();
+            DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
 
-            if (m_allGpuState.dirty.viewport)
-            {
-                DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+            PalCmdBuffer(deviceIdx)->CmdSetViewports(PerGpuState(deviceIdx)->viewport);
 
-                PalCmdBuffer(deviceIdx)->CmdSetViewports(PerGpuState(deviceIdx)->viewport);
+            DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+        }
 
-                DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
-            }
+        if (m_allGpuState.dirty.scissor)
+        {
+            DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
 
-            if (m_allGpuState.dirty.scissor)
-            {
-                DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+            PalCmdBuffer(deviceIdx)->CmdSetScissorRects(PerGpuState(deviceIdx)->scissor);
 
-                PalCmdBuffer(deviceIdx)->CmdSetScissorRects(PerGpuState(deviceIdx)->scissor);
+            DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+        }
 
-                DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
-            }
+        if (m_allGpuState.dirty.rasterState)
+        {
+            DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
 
-            if (m_allGpuState.dirty.rasterState)
-            {
-                DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+            PalCmdBuffer(deviceIdx)->CmdSetTriangleRasterState(m_allGpuState.triangleRasterState);
 
-                PalCmdBuffer(deviceIdx)->CmdSetTriangleRasterState(m_allGpuState.triangleRasterState);
+            DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+        }
 
-                DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
-            }
+        if (m_allGpuState.dirty.stencilRef)
+        {
+            DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
 
-            if (m_allGpuState.dirty.stencilRef)
-            {
-                DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+            PalCmdBuffer(deviceIdx)->CmdSetStencilRefMasks(m_allGpuState.stencilRefMasks);
 
-                PalCmdBuffer(deviceIdx)->CmdSetStencilRefMasks(m_allGpuState.stencilRefMasks);
+            DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+        }
 
-                DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
-            }
+        if (m_allGpuState.dirty.inputAssembly)
+        {
+            DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
 
-            if (m_allGpuState.dirty.inputAssembly)
-            {
-                DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+            PalCmdBuffer(deviceIdx)->CmdSetInputAssemblyState(m_allGpuState.inputAssemblyState);
 
-                PalCmdBuffer(deviceIdx)->CmdSetInputAssemblyState(m_allGpuState.inputAssemblyState);
+            DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+        }
 
-                DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
-            }
+        if (m_allGpuState.dirty.vrs)
+        {
+            DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
 
-            if (m_allGpuState.dirty.vrs)
-            {
-                DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+            const GraphicsPipeline* pGraphicsPipeline = m_allGpuState.pGraphicsPipeline;
 
-                const GraphicsPipeline* pGraphicsPipeline = m_allGpuState.pGraphicsPipeline;
+            const bool force1x1 = (pGraphicsPipeline != nullptr) &&
+                                  (pGraphicsPipeline->Force1x1ShaderRateEnabled());
 
-                const bool force1x1 = (pGraphicsPipeline != nullptr) &&
-                                      (pGraphicsPipeline->Force1x1ShaderRateEnabled());
+            // CmdSetPerDrawVrsRate has been called for the dynamic state
+            // Look at the currently bound pipeline and see if we need to force the values to 1x1
+            Pal::VrsRateParams vrsRate = m_allGpuState.vrsRate;
+            if (force1x1)
+            {
+                Force1x1ShaderRate(&vrsRate);
+            }
 
-                // CmdSetPerDrawVrsRate has been called for the dynamic state
-                // Look at the currently bound pipeline and see if we need to force the values to 1x1
-                Pal::VrsRateParams vrsRate = m_allGpuState.vrsRate;
-                if (force1x1)
-                {
-                    Force1x1ShaderRate(&vrsRate);
-                }
+            PalCmdBuffer(deviceIdx)->CmdSetPerDrawVrsRate(vrsRate);
 
-                PalCmdBuffer(deviceIdx)->CmdSetPerDrawVrsRate(vrsRate);
+            DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
+        }
 
-                DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
-            }
+        if (m_allGpuState.dirty.depthStencil)
+        {
+            RenderStateCache* pRSCache = m_pDevice->GetRenderStateCache();
 
-            if (m_allGpuState.dirty.depthStencil)
+            // Check pPalDepthStencil[0] should be fine since pPalDepthStencil[i] would be nullptr when
+            // pPalDepthStencil[0] is nullptr.
+            if (pPalDepthStencil[0] == nullptr)
             {
-                RenderStateCache* pRSCache = m_pDevice->GetRenderStateCache();
+                bool depthStencilExist = false;
 
-                // Check pPalDepthStencil[0] should be fine since pPalDepthStencil[i] would be nullptr when
-                // pPalDepthStencil[0] is nullptr.
-                if (pPalDepthStencil[0] == nullptr)
-                {
-                    bool depthStencilExist = false;
+                pRSCache->CreateDepthStencilState(m_allGpuState.depthStencilCreateInfo,
+                                                  m_pDevice->VkInstance()->GetAllocCallbacks(),
+                                                  VK_SYSTEM_ALLOCATION_SCOPE_OBJECT,
+                                                  pPalDepthStencil);
 
-                    pRSCache->CreateDepthStencilState(m_allGpuState.depthStencilCreateInfo,
-                                                      m_pDevice->VkInstance()->GetAllocCallbacks(),
-                                                      VK_SYSTEM_ALLOCATION_SCOPE_OBJECT,
-                                                      pPalDepthStencil);
+                // Check if pPalDepthStencil is already in the m_allGpuState.palDepthStencilState, destroy it
+                // and use the old one if yes. The destroy is not expensive since it's just a refCount--.
+                for (uint32_t i = 0; i < m_palDepthStencilState.NumElements(); ++i)
+                {
+                    const DynamicDepthStencil palDepthStencilState = m_palDepthStencilState.At(i);
 
-                    // Check if pPalDepthStencil is already in the m_allGpuState.palDepthStencilState, destroy it
-                    // and use the old one if yes. The destroy is not expensive since it's just a refCount--.
-                    for (uint32_t i = 0; i < m_palDepthStencilState.NumElements(); ++i)
+                    // Check device0 only should be sufficient
+                    if (palDepthStencilState.pPalDepthStencil[0] == pPalDepthStencil[0])
                     {
-                        const DynamicDepthStencil palDepthStencilState = m_palDepthStencilState.At(i);
-
-                        // Check device0 only should be sufficient
-                        if (palDepthStencilState.pPalDepthStencil[0] == pPalDepthStencil[0])
-                        {
-                            depthStencilExist = true;
+                        depthStencilExist = true;
 
-                            pRSCache->DestroyDepthStencilState(pPalDepthStencil,
-                                                               m_pDevice->VkInstance()->GetAllocCallbacks());
+                        pRSCache->DestroyDepthStencilState(pPalDepthStencil,
+                                                           m_pDevice->VkInstance()->GetAllocCallbacks());
 
-                            for (uint32_t j = 0; j < MaxPalDevices; ++j)
-                            {
-                                pPalDepthStencil[j] = palDepthStencilState.pPalDepthStencil[j];
-                            }
-                            break;
+                        for (uint32_t j = 0; j < MaxPalDevices; ++j)
+                        {
+                            pPalDepthStencil[j] = palDepthStencilState.pPalDepthStencil[j];
                         }
+                        break;
                     }
+                }
 
-                    // Add it to the m_palDepthStencilState if it doesn't exist
-                    if (!depthStencilExist)
-                    {
-                        DynamicDepthStencil palDepthStencilState = {};
-
-                        for (uint32_t i = 0; i < MaxPalDevices; ++i)
-                        {
-                            palDepthStencilState.pPalDepthStencil[i] = pPalDepthStencil[i];
-                        }
+                // Add it to the m_palDepthStencilState if it doesn't exist
+                if (!depthStencilExist)
+                {
+                    DynamicDepthStencil palDepthStencilState = {};
 
-                        m_palDepthStencilState.PushBack(palDepthStencilState);
+                    for (uint32_t i = 0; i < MaxPalDevices; ++i)
+                    {
+                        palDepthStencilState.pPalDepthStencil[i] = pPalDepthStencil[i];
                     }
+
+                    m_palDepthStencilState.PushBack(palDepthStencilState);
                 }
+            }
 
-                VK_ASSERT(pPalDepthStencil[0] != nullptr);
+            VK_ASSERT(pPalDepthStencil[0] != nullptr);
 
-                PalCmdBindDepthStencilState(
-                        m_pPalCmdBuffers[deviceIdx],
-                        deviceIdx,
-                        pPalDepthStencil[deviceIdx]);
-            }
+            PalCmdBindDepthStencilState(
+                    PalCmdBuffer(deviceIdx),
+                    deviceIdx,
+                    pPalDepthStencil[deviceIdx]);
+        }
 
-            if (m_allGpuState.dirty.colorWriteEnable)
-            {
-                DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
+        if (m_allGpuState.dirty.colorWriteEnable)
+        {
+            DbgBarrierPreCmd(DbgBarrierSetDynamicPipelineState);
 
-                m_allGpuState.lastColorWriteEnableDynamic = true;
-                PalCmdBuffer(deviceGroup.Index())->CmdSetColorWriteMask(m_allGpuState.colorWriteMaskParams);
+            m_allGpuState.lastColorWriteEnableDynamic = true;
+            PalCmdBuffer(deviceGroup.Index())->CmdSetColorWriteMask(m_allGpuState.colorWriteMaskParams);
 
-                DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
-            }
+            DbgBarrierPostCmd(DbgBarrierSetDynamicPipelineState);
         }
-        while (deviceGroup.IterateNext());
+    }
+    while (deviceGroup.IterateNext());
 
-        // Clear the dirty bits
-        m_allGpuState.dirty.u32All = 0;
+    if (m_allGpuState.dirty.xfbTargets)
+    {
+        UnbindTransformFeedbackTargets();
     }
+
+    // Clear the dirty bits
+    m_allGpuState.dirty.u32All = 0;
 }
 
 // =====================================================================================================================
 void CmdBuffer::SetCullModeEXT(
     VkCullModeFlags cullMode)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     Pal::CullMode palCullMode = VkToPalCullMode(cullMode);
 
     if (m_allGpuState.triangleRasterState.cullMode != palCullMode)
@@ -7320,14 +9968,21 @@ void CmdBuffer::SetCullModeEXT(
         m_allGpuState.triangleRasterState.cullMode = palCullMode;
         m_allGpuState.dirty.rasterState            = 1;
     }
+    else
+    {
+        m_stats.filteredStateCount++;
+    }
 
     m_allGpuState.staticTokens.triangleRasterState = DynamicRenderStateToken;
+    m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
 }
 
 // =====================================================================================================================
 void CmdBuffer::SetFrontFaceEXT(
     VkFrontFace frontFace)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     Pal::FaceOrientation palFrontFace = VkToPalFaceOrientation(frontFace);
 
     if (m_allGpuState.triangleRasterState.frontFace != palFrontFace)
@@ -7335,14 +9990,21 @@ void CmdBuffer::SetFrontFaceEXT(
         m_allGpuState.triangleRasterState.frontFace = palFrontFace;
         m_allGpuState.dirty.rasterState             = 1;
     }
+    else
+    {
+        m_stats.filteredStateCount++;
+    }
 
     m_allGpuState.staticTokens.triangleRasterState = DynamicRenderStateToken;
+    m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
 }
 
 // =====================================================================================================================
 void CmdBuffer::SetPrimitiveTopologyEXT(
     VkPrimitiveTopology primitiveTopology)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     Pal::PrimitiveTopology palTopology = VkToPalPrimitiveTopology(primitiveTopology);
 
     if (m_allGpuState.inputAssemblyState.topology != palTopology)
@@ -7350,36 +10012,55 @@ void CmdBuffer::SetPrimitiveTopologyEXT(
         m_allGpuState.inputAssemblyState.topology = palTopology;
         m_allGpuState.dirty.inputAssembly         = 1;
     }
+    else
+    {
+        m_stats.filteredStateCount++;
+    }
 
     m_allGpuState.staticTokens.inputAssemblyState = DynamicRenderStateToken;
+    m_allGpuState.staticTokens.staticStateBundle = DynamicRenderStateToken;
 }
 
 // =====================================================================================================================
 void CmdBuffer::SetDepthTestEnableEXT(
     VkBool32 depthTestEnable)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     if (m_allGpuState.depthStencilCreateInfo.depthEnable != static_cast<bool>(depthTestEnable))
     {
         m_allGpuState.depthStencilCreateInfo.depthEnable = depthTestEnable;
         m_allGpuState.dirty.depthStencil                 = 1;
     }
+    else
+    {
+        m_stats.filteredStateCount++;
+    }
 }
 
 // =====================================================================================================================
 void CmdBuffer::SetDepthWriteEnableEXT(
     VkBool32 depthWriteEnable)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     if (m_allGpuState.depthStencilCreateInfo.depthWriteEnable != static_cast<bool>(depthWriteEnable))
     {
         m_allGpuState.depthStencilCreateInfo.depthWriteEnable = depthWriteEnable;
         m_allGpuState.dirty.depthStencil                      = 1;
     }
+    else
+    {
+        m_stats.filteredStateCount++;
+    }
 }
 
 // =====================================================================================================================
 void CmdBuffer::SetDepthCompareOpEXT(
     VkCompareOp depthCompareOp)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     Pal::CompareFunc compareOp = VkToPalCompareFunc(depthCompareOp);
 
     if (m_allGpuState.depthStencilCreateInfo.depthFunc != compareOp)
@@ -7387,28 +10068,44 @@ void CmdBuffer::SetDepthCompareOpEXT(
         m_allGpuState.depthStencilCreateInfo.depthFunc = compareOp;
         m_allGpuState.dirty.depthStencil               = 1;
     }
+    else
+    {
+        m_stats.filteredStateCount++;
+    }
 }
 
 // =====================================================================================================================
 void CmdBuffer::SetDepthBoundsTestEnableEXT(
     VkBool32 depthBoundsTestEnable)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     if (m_allGpuState.depthStencilCreateInfo.depthBoundsEnable != static_cast<bool>(depthBoundsTestEnable))
     {
         m_allGpuState.depthStencilCreateInfo.depthBoundsEnable = depthBoundsTestEnable;
         m_allGpuState.dirty.depthStencil                       = 1;
     }
+    else
+    {
+        m_stats.filteredStateCount++;
+    }
 }
 
 // =====================================================================================================================
 void CmdBuffer::SetStencilTestEnableEXT(
     VkBool32 stencilTestEnable)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     if (m_allGpuState.depthStencilCreateInfo.stencilEnable != static_cast<bool>(stencilTestEnable))
     {
         m_allGpuState.depthStencilCreateInfo.stencilEnable = stencilTestEnable;
         m_allGpuState.dirty.depthStencil                   = 1;
     }
+    else
+    {
+        m_stats.filteredStateCount++;
+    }
 }
 
 // =====================================================================================================================
@@ -7419,6 +10116,8 @@ void CmdBuffer::SetStencilOpEXT(
     VkStencilOp        depthFailOp,
     VkCompareOp        compareOp)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     Pal::StencilOp   palFailOp      = VkToPalStencilOp(failOp);
     Pal::StencilOp   palPassOp      = VkToPalStencilOp(passOp);
     Pal::StencilOp   palDepthFailOp = VkToPalStencilOp(depthFailOp);
@@ -7464,6 +10163,8 @@ void CmdBuffer::SetColorWriteEnableEXT(
     uint32_t                                    attachmentCount,
     const VkBool32*                             pColorWriteEnables)
 {
+    m_touchedStateMask |= TrackedStateGraphics;
+
     if (pColorWriteEnables != nullptr)
     {
         m_allGpuState.colorWriteMaskParams.count = Util::Min(attachmentCount, Pal::MaxColorTargets);
@@ -7522,7 +10223,7 @@ VKAPI_ATTR VkResult VKAPI_CALL vkResetCommandBuffer(
     VkCommandBuffer                             cmdBuffer,
     VkCommandBufferResetFlags                   flags)
 {
-    return ApiCmdBuffer::ObjectFromHandle(cmdBuffer)->Reset(flags);
+    return ApiCmdBuffer::ObjectFromHandle(cmdBuffer)->Reset(flags, true);
 }
 
 // =====================================================================================================================
@@ -8275,12 +10976,14 @@ VKAPI_ATTR void VKAPI_CALL vkCmdBeginDebugUtilsLabelEXT(
     VkCommandBuffer                             commandBuffer,
     const VkDebugUtilsLabelEXT*                 pLabelInfo)
 {
+    ApiCmdBuffer::ObjectFromHandle(commandBuffer)->BeginDebugLabel(pLabelInfo);
 }
 
 // =====================================================================================================================
 VKAPI_ATTR void VKAPI_CALL vkCmdEndDebugUtilsLabelEXT(
     VkCommandBuffer                             commandBuffer)
 {
+    ApiCmdBuffer::ObjectFromHandle(commandBuffer)->EndDebugLabel();
 }
 
 // =====================================================================================================================
@@ -8606,6 +11309,21 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetColorWriteEnableEXT(
     ApiCmdBuffer::ObjectFromHandle(commandBuffer)->SetColorWriteEnableEXT(attachmentCount, pColorWriteEnables);
 }
 
+// =====================================================================================================================
+VKAPI_ATTR void VKAPI_CALL vkCmdBeginRenderingKHR(
+    VkCommandBuffer                             commandBuffer,
+    const VkRenderingInfoKHR*                   pRenderingInfo)
+{
+    ApiCmdBuffer::ObjectFromHandle(commandBuffer)->BeginRendering(pRenderingInfo);
+}
+
+// =====================================================================================================================
+VKAPI_ATTR void VKAPI_CALL vkCmdEndRenderingKHR(
+    VkCommandBuffer                             commandBuffer)
+{
+    ApiCmdBuffer::ObjectFromHandle(commandBuffer)->EndRendering();
+}
+
 } // namespace entry
 
 } // namespace vk
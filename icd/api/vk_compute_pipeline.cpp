@@ -23,6 +23,7 @@
  *
  **********************************************************************************************************************/
 
+#include "include/pipeline_stats_profile.h"
 #include "include/vk_cmdbuffer.h"
 #include "include/vk_compute_pipeline.h"
 #include "include/vk_conv.h"
@@ -137,12 +138,36 @@ VkResult ComputePipeline::Create(
     uint64_t                  apiPsoHash                         = BuildApiHash(pCreateInfo, &binaryCreateInfo.basePipelineHash);
 
     const VkPipelineCreationFeedbackCreateInfoEXT* pPipelineCreationFeadbackCreateInfo = nullptr;
-    VkResult result = pDefaultCompiler->ConvertComputePipelineInfo(
+    VkResult result = pDefaultCompiler->ConvertComputeShaderInfo(
         pDevice, pCreateInfo, &binaryCreateInfo, &pPipelineCreationFeadbackCreateInfo);
 
-    uint64_t pipelineHash = Vkgc::IPipelineDumper::GetPipelineHash(&binaryCreateInfo.pipelineInfo);
+    // Once the pipeline has been created with the same create info, its binary can be found by the API hash and the
+    // compile options alone, which skips building the resource mapping and hashing the full LLPC build info.  Each
+    // device in a multi-GPU setup may need a different binary, so those always take the full path.
+    uint64_t pipelineHash      = 0;
+    bool     isApiHashCacheHit = false;
+
+    if ((result == VK_SUCCESS) && (pDevice->NumPalDevices() == 1))
+    {
+        isApiHashCacheHit = pDefaultCompiler->LoadComputePipelineBinaryByApiHash(
+            DefaultDeviceIndex,
+            pPipelineCache,
+            &binaryCreateInfo,
+            &pipelineHash,
+            &pipelineBinarySizes[DefaultDeviceIndex],
+            &pPipelineBinaries[DefaultDeviceIndex],
+            &cacheId[DefaultDeviceIndex]);
+    }
+
+    if ((result == VK_SUCCESS) && (isApiHashCacheHit == false))
+    {
+        result = pDefaultCompiler->BuildComputeResourceMapping(pCreateInfo, &binaryCreateInfo);
+
+        pipelineHash = Vkgc::IPipelineDumper::GetPipelineHash(&binaryCreateInfo.pipelineInfo);
+    }
+
     for (uint32_t deviceIdx = 0;
-        (result == VK_SUCCESS) && (deviceIdx < pDevice->NumPalDevices())
+        (result == VK_SUCCESS) && (isApiHashCacheHit == false) && (deviceIdx < pDevice->NumPalDevices())
         ; deviceIdx++)
     {
         result = pDevice->GetCompiler(deviceIdx)->CreateComputePipelineBinary(
@@ -153,6 +178,15 @@ VkResult ComputePipeline::Create(
             &pipelineBinarySizes[deviceIdx],
             &pPipelineBinaries[deviceIdx],
             &cacheId[deviceIdx]);
+
+        if ((result == VK_SUCCESS) && (pDevice->NumPalDevices() == 1))
+        {
+            pDevice->GetCompiler(deviceIdx)->RegisterComputePipelineApiHash(
+                deviceIdx,
+                binaryCreateInfo,
+                pipelineHash,
+                cacheId[deviceIdx]);
+        }
     }
 
     if (result != VK_SUCCESS)
@@ -219,11 +253,16 @@ VkResult ComputePipeline::Create(
                 localPipelineInfo.pipeline.pPipelineBinary    = pPipelineBinaries[deviceIdx];
             }
 
+            const int64_t uploadStartTime = Util::GetPerfCpuTime();
+
             palResult = pDevice->PalDevice(deviceIdx)->CreateComputePipeline(
                 localPipelineInfo.pipeline,
                 Util::VoidPtrInc(pPalMem, deviceIdx * pipelineSize),
                 &pPalPipeline[deviceIdx]);
 
+            pDevice->GetCompiler(deviceIdx)->GetCompileStats()->RecordStageTime(
+                PipelineCompileStats::Stage::Upload, Util::GetPerfCpuTime() - uploadStartTime);
+
 #if ICD_GPUOPEN_DEVMODE_BUILD
             // Temporarily reinject post Pal pipeline creation (when the internal pipeline hash is available).
             // The reinjection cache layer can be linked back into the pipeline cache chain once the
@@ -338,6 +377,25 @@ VkResult ComputePipeline::Create(
         const RuntimeSettings& settings = pDevice->GetRuntimeSettings();
         // The hash is same as pipline dump file name, we can easily analyze further.
         AmdvlkLog(settings.logTagIdMask, PipelineCompileTime, "0x%016llX-%llu", pipelineHash, duration);
+
+        if (pDevice->GetPipelineCompileEventLog()->IsEnabled())
+        {
+            PipelineCompileEvent event = {};
+
+            event.apiHash      = apiPsoHash;
+            event.pipelineHash = pipelineHash;
+            event.durationNs   = duration;
+            event.binarySize   = pipelineBinarySizes[DefaultDeviceIndex];
+            event.source       = binaryCreateInfo.binarySource;
+            event.stages       = VK_SHADER_STAGE_COMPUTE_BIT;
+
+            pDevice->GetPipelineCompileEventLog()->Record(event);
+        }
+
+        if (pDevice->GetPipelineStatsProfile() != nullptr)
+        {
+            pDevice->GetPipelineStatsProfile()->RegisterPipeline(apiPsoHash, binaryCreateInfo.pipelineProfileKey);
+        }
     }
 
     return result;
@@ -356,9 +414,11 @@ void ComputePipeline::BindToCmdBuffer(
     params.cs                = computeShaderInfo;
     params.apiPsoHash        = m_apiHash;
 
+    const PalPipelineSet* pPalPipelines = GetPalPipelines();
+
     for (uint32_t deviceIdx = 0; deviceIdx < numGroupedCmdBuffers; deviceIdx++)
     {
-        params.pPipeline = m_pPalPipeline[deviceIdx];
+        params.pPipeline = pPalPipelines->pPalPipeline[deviceIdx];
 
         pCmdBuffer->PalCmdBuffer(deviceIdx)->CmdBindPipeline(params);
     }
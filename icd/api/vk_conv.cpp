@@ -364,9 +364,9 @@ VK_TO_PAL_STRUC_X(  FORMAT_A8B8G8R8_SRGB_PACK32,                  PalFmt_ABGR_PA
 #define VK_TO_PAL_DECL_LOOKUP_TABLE_COMPLEX_WITH_SUFFIX(srcType, dstType, convertFunc, suffix) \
     namespace convert \
     { \
-        dstType VkToPal##convertFunc##LookupTableStorage[VK_##srcType##_END_RANGE##suffix + 1]; \
-        const dstType* VkToPal##convertFunc##LookupTable = InitVkToPal##convertFunc##LookupTable(); \
-        VK_DBG_DECL(bool VkToPal##convertFunc##Valid[VK_##srcType##_END_RANGE##suffix + 1]); \
+        constexpr VkToPal##convertFunc##LookupTableType VkToPal##convertFunc##LookupTable = \
+            MakeLookupTable<dstType, VkToPal##convertFunc##Entry>( \
+                std::make_index_sequence<VK_##srcType##_END_RANGE##suffix + 1>()); \
     }
 
 // =====================================================================================================================
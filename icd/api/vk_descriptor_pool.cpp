@@ -39,10 +39,13 @@
 #include "include/vk_descriptor_set_layout.h"
 #include "include/vk_descriptor_set.h"
 
+#include "utils/json_writer.h"
+
 #include "palInlineFuncs.h"
 #include "palDevice.h"
 #include "palEventDefs.h"
 #include "palGpuMemory.h"
+#include "palSysUtil.h"
 
 namespace vk
 {
@@ -58,8 +61,9 @@ VkResult DescriptorPool::Create(
     const VkAllocationCallbacks*             pAllocator,
     VkDescriptorPool*                        pDescriptorPool)
 {
-    const size_t apiSize = sizeof(DescriptorPool);
-    const size_t objSize = apiSize;
+    const bool   freeable = (pCreateInfo->flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT) != 0;
+    const size_t apiSize  = sizeof(DescriptorPool);
+    const size_t objSize  = apiSize + (freeable ? (pCreateInfo->maxSets * sizeof(SetAllocInfo)) : 0);
 
     void* pSysMem = pDevice->AllocApiObject(pAllocator, objSize);
 
@@ -68,7 +72,7 @@ VkResult DescriptorPool::Create(
         return VK_ERROR_OUT_OF_HOST_MEMORY;
     }
 
-    VK_PLACEMENT_NEW (pSysMem) DescriptorPool(pDevice);
+    VK_PLACEMENT_NEW (pSysMem) DescriptorPool(pDevice, freeable ? Util::VoidPtrInc(pSysMem, apiSize) : nullptr);
 
     VkDescriptorPool handle = DescriptorPool::HandleFromVoidPointer(pSysMem);
 
@@ -88,12 +92,16 @@ VkResult DescriptorPool::Create(
 
 // =====================================================================================================================
 DescriptorPool::DescriptorPool(
-    Device* pDevice)
+    Device* pDevice,
+    void*   pSetAllocInfoMem)
     :
     m_pDevice(pDevice),
-    m_DynamicDataSupport(false)
+    m_DynamicDataSupport(false),
+    m_pSetAllocInfo(static_cast<SetAllocInfo*>(pSetAllocInfoMem))
 {
     memset(m_addresses, 0, sizeof(m_addresses));
+    memset(m_freedSetBuckets, 0, sizeof(m_freedSetBuckets));
+    memset(&m_stats, 0, sizeof(m_stats));
 }
 
 // =====================================================================================================================
@@ -120,6 +128,10 @@ VkResult DescriptorPool::Init(
             return result;
         }
 
+        pDevice->GetDescriptorPoolStats()->RecordPoolCreate(m_gpuMemHeap.GetReservedBytes());
+
+        m_stats.registered = true;
+
         // Get memory requirements
         Pal::GpuMemoryRequirements memReqs = {};
 
@@ -235,12 +247,70 @@ VkResult DescriptorPool::Init(
 template <uint32_t numPalDevices>
 VkResult DescriptorPool::Reset()
 {
+    // The heap resets below release the cached sets too.
+    memset(m_freedSetBuckets, 0, sizeof(m_freedSetBuckets));
+
     m_setHeap.Reset<numPalDevices>();
     m_gpuMemHeap.Reset();
 
+    UpdateStats(-static_cast<int32_t>(m_stats.liveSets));
+
     return VK_SUCCESS;
 }
 
+// =====================================================================================================================
+// Brings the pool's stats, and the device-wide totals with them, up to date after sets were allocated or freed.
+void DescriptorPool::UpdateStats(
+    int32_t liveSetDelta)
+{
+    const Pal::gpusize usedBytes = m_gpuMemHeap.GetUsedBytes();
+
+    m_stats.liveSets     += liveSetDelta;
+    m_stats.peakLiveSets  = Util::Max(m_stats.peakLiveSets, m_stats.liveSets);
+    m_stats.peakUsedBytes = Util::Max(m_stats.peakUsedBytes, usedBytes);
+
+    m_pDevice->GetDescriptorPoolStats()->RecordUsage(liveSetDelta,
+                                                     static_cast<int64_t>(usedBytes - m_stats.usedBytes));
+
+    m_pDevice->GetPerfCounters()->Add(PerfCounter::DescriptorSetsLive, liveSetDelta);
+    m_pDevice->GetPerfCounters()->Add(PerfCounter::DescriptorHeapBytes,
+                                      static_cast<int64_t>(usedBytes - m_stats.usedBytes));
+
+    m_stats.usedBytes = usedBytes;
+}
+
+// =====================================================================================================================
+// Appends a JSON record of this pool's memory use to a file.
+void DescriptorPool::WriteStats(
+    const char* pFilePath) const
+{
+    utils::JsonOutputStream stream(pFilePath);
+    Util::JsonWriter        writer(&stream);
+
+    const Pal::gpusize reservedBytes = m_gpuMemHeap.GetReservedBytes();
+
+    writer.BeginMap(false);
+    writer.KeyAndValue("timestampMs",
+                       static_cast<uint64_t>((Util::GetPerfCpuTime() * 1000) / Util::GetPerfFrequency()));
+
+    writer.KeyAndBeginMap("descriptorPool", false);
+    writer.KeyAndValue("freeable", (m_pSetAllocInfo != nullptr));
+    writer.KeyAndValue("maxSets", m_setHeap.GetMaxSets());
+    writer.KeyAndValue("reservedBytes", reservedBytes);
+    writer.KeyAndValue("usedBytes", m_stats.usedBytes);
+    writer.KeyAndValue("peakUsedBytes", m_stats.peakUsedBytes);
+    writer.KeyAndValue("peakUtilization",
+                       (reservedBytes > 0) ? (static_cast<double>(m_stats.peakUsedBytes) / reservedBytes) : 0.0);
+    writer.KeyAndValue("liveSets", m_stats.liveSets);
+    writer.KeyAndValue("peakLiveSets", m_stats.peakLiveSets);
+    writer.KeyAndValue("setsAllocated", m_stats.setsAllocated);
+    writer.KeyAndValue("allocFailures", m_stats.allocFailures);
+    writer.KeyAndValue("fragmentationPercent", m_gpuMemHeap.GetFragmentationPercent());
+    writer.EndMap();
+
+    writer.EndMap();
+}
+
 // =====================================================================================================================
 // Destroys a descriptor pool
 VkResult DescriptorPool::Destroy(
@@ -255,6 +325,25 @@ VkResult DescriptorPool::Destroy(
         &data,
         sizeof(Pal::ResourceDestroyEventData));
 
+    AmdvlkLog(pDevice->GetRuntimeSettings().logTagIdMask,
+              GeneralPrint,
+              "DescriptorPool %p: free memory fragmentation at destroy: %u%%",
+              this,
+              m_gpuMemHeap.GetFragmentationPercent());
+
+    if (m_stats.registered)
+    {
+        if (pDevice->GetRuntimeSettings().dumpDescriptorPoolStats)
+        {
+            WriteStats(pDevice->GetRuntimeSettings().descriptorPoolStatsFile);
+        }
+
+        DescriptorPoolStats* pDeviceStats = pDevice->GetDescriptorPoolStats();
+
+        pDeviceStats->RecordUsage(-static_cast<int64_t>(m_stats.liveSets), -static_cast<int64_t>(m_stats.usedBytes));
+        pDeviceStats->RecordPoolDestroy(m_gpuMemHeap.GetReservedBytes(), m_stats.peakUsedBytes);
+    }
+
     // Destroy children heaps
     m_setHeap.Destroy(pDevice, pAllocator);
     m_gpuMemHeap.Destroy(pDevice, pAllocator);
@@ -290,6 +379,15 @@ VkResult DescriptorPool::AllocDescriptorSets(
     const VkDescriptorSetVariableDescriptorCountAllocateInfo* pVariableDescriptorCount =
         reinterpret_cast<const VkDescriptorSetVariableDescriptorCountAllocateInfo*>(pAllocateInfo->pNext);
 
+    // Batches of one-shot sets sharing a layout are carved out of the pool in one go
+    if ((count > 1) &&
+        (m_pSetAllocInfo == nullptr) &&
+        (pVariableDescriptorCount == nullptr) &&
+        AllocSameLayoutDescriptorSets<numPalDevices>(count, pSetLayouts, pDescriptorSets))
+    {
+        allocCount = count;
+    }
+
     while ((result == VK_SUCCESS) && (allocCount < count))
     {
         // Try to allocate GPU memory for the descriptor set
@@ -301,62 +399,76 @@ VkResult DescriptorPool::AllocDescriptorSets(
         }
         else
         {
-            if ((m_setHeap.AllocSetState<numPalDevices>(&pDescriptorSets[allocCount])))
+            uint32_t variableDescriptorCounts = 0;
+
+            // Get variable descriptor counts for the last layout binding
+            if (pVariableDescriptorCount != nullptr)
             {
-                uint32_t variableDescriptorCounts = 0;
+                VK_ASSERT(pVariableDescriptorCount->sType ==
+                    VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO);
+
+                VK_ASSERT(pVariableDescriptorCount->descriptorSetCount == pAllocateInfo->descriptorSetCount);
+
+                uint32_t lastBindingIdx = pLayout->Info().count - 1;
 
-                // Get variable descriptor counts for the last layout binding
-                if (pVariableDescriptorCount != nullptr)
+                if (pLayout->Binding(lastBindingIdx).bindingFlags.variableDescriptorCount)
                 {
-                    VK_ASSERT(pVariableDescriptorCount->sType ==
-                        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO);
+                    variableDescriptorCounts = pVariableDescriptorCount->pDescriptorCounts[allocCount];
+                    VK_ASSERT(variableDescriptorCounts <= pLayout->Binding(lastBindingIdx).info.descriptorCount);
+                }
+            }
 
-                    VK_ASSERT(pVariableDescriptorCount->descriptorSetCount == pAllocateInfo->descriptorSetCount);
+            const uint32_t gpuMemSize = (m_pSetAllocInfo != nullptr) ?
+                DescriptorGpuMemHeap::GetSetGpuMemSize(pLayout, variableDescriptorCounts) : 0;
 
-                    uint32_t lastBindingIdx = pLayout->Info().count - 1;
+            // A recently freed set needing the same amount of GPU memory can be handed out again as it is.
+            if ((m_pSetAllocInfo != nullptr) && TakeFreedSet<numPalDevices>(gpuMemSize, &pDescriptorSets[allocCount]))
+            {
+                DescriptorSet<numPalDevices>* pSet =
+                    DescriptorSet<numPalDevices>::StateFromHandle(pDescriptorSets[allocCount]);
 
-                    if (pLayout->Binding(lastBindingIdx).bindingFlags.variableDescriptorCount)
-                    {
-                        variableDescriptorCounts = pVariableDescriptorCount->pDescriptorCounts[allocCount];
-                        VK_ASSERT(variableDescriptorCounts <= pLayout->Binding(lastBindingIdx).info.descriptorCount);
-                    }
-                }
+                AssignSet<numPalDevices>(pDescriptorSets[allocCount],
+                                         pLayout,
+                                         m_pSetAllocInfo[pSet->HeapIndex()].gpuMemOffset,
+                                         pSet->AllocHandle());
 
+                allocCount++;
+            }
+            else if ((m_setHeap.AllocSetState<numPalDevices>(&pDescriptorSets[allocCount])))
+            {
                 Pal::gpusize setGpuMemOffset;
                 void* pSetAllocHandle;
 
                 if (m_gpuMemHeap.AllocSetGpuMem(pLayout, variableDescriptorCounts, &setGpuMemOffset, &pSetAllocHandle))
                 {
-                    // Allocation succeeded: Mark this
-                    // Reallocate this descriptor set to use the allocated GPU range and layout
-                    DescriptorSet<numPalDevices>* pSet = DescriptorSet<numPalDevices>::StateFromHandle(pDescriptorSets[allocCount]);
-
-                    size_t privateDataSize = m_setHeap.GetPrivateDataSize();
+                    // Allocation succeeded: Reallocate this descriptor set to use the allocated GPU range and layout
+                    AssignSet<numPalDevices>(pDescriptorSets[allocCount], pLayout, setGpuMemOffset, pSetAllocHandle);
 
-                    if (privateDataSize > 0)
+                    if (m_pSetAllocInfo != nullptr)
                     {
-                        void* pMem = reinterpret_cast<void*>(pDescriptorSets[allocCount]);
+                        const DescriptorSet<numPalDevices>* pSet =
+                            DescriptorSet<numPalDevices>::StateFromHandle(pDescriptorSets[allocCount]);
+
+                        SetAllocInfo* pInfo = &m_pSetAllocInfo[pSet->HeapIndex()];
 
-                        //just memset the reserved slots here
-                        privateDataSize -= sizeof(HashedPrivateDataMap*);
-                        pMem = Util::VoidPtrDec(pMem, privateDataSize);
-                        memset(pMem, 0, privateDataSize);
+                        pInfo->gpuMemOffset = setGpuMemOffset;
+                        pInfo->gpuMemSize   = gpuMemSize;
                     }
 
-                    pSet->Reassign(pLayout,
-                        setGpuMemOffset,
-                        m_addresses,
-                        pSetAllocHandle);
+                    allocCount++;
                 }
                 else
                 {
-                    // State set will be released in error case handling below, since non-null handle is present
-                    result = VK_ERROR_OUT_OF_POOL_MEMORY;
-                }
+                    m_setHeap.FreeSetState<numPalDevices>(pDescriptorSets[allocCount]);
 
-                allocCount++;
+                    // The cached sets may be holding the memory we need; release them and retry this set.
+                    if (ReleaseFreedSets<numPalDevices>() == false)
+                    {
+                        result = VK_ERROR_OUT_OF_POOL_MEMORY;
+                    }
+                }
             }
-            else
+            else if (ReleaseFreedSets<numPalDevices>() == false)
             {
                 result = VK_ERROR_OUT_OF_POOL_MEMORY;
             }
@@ -381,11 +493,191 @@ VkResult DescriptorPool::AllocDescriptorSets(
             // No partial failures allowed for creating multiple descriptor sets. Update all to VK_NULL_HANDLE.
             pDescriptorSets[setIdx] = VK_NULL_HANDLE;
         }
+
+        m_stats.allocFailures++;
+        m_pDevice->GetDescriptorPoolStats()->RecordAllocFailure();
+        m_pDevice->GetPerfCounters()->Add(PerfCounter::DescriptorAllocFailures);
+
+        UpdateStats(0);
+    }
+    else
+    {
+        m_stats.setsAllocated += count;
+        m_pDevice->GetDescriptorPoolStats()->RecordAllocs(count);
+
+        UpdateStats(static_cast<int32_t>(count));
     }
 
     return result;
 }
 
+// =====================================================================================================================
+// Allocates all sets of a request from a one-shot pool with a single state and GPU memory allocation, if they all use
+// the same layout.  Returns false without allocating anything if the request doesn't qualify or doesn't fit, in which
+// case the sets are allocated one by one.
+template <uint32_t numPalDevices>
+bool DescriptorPool::AllocSameLayoutDescriptorSets(
+    uint32_t                     count,
+    const VkDescriptorSetLayout* pSetLayouts,
+    VkDescriptorSet*             pDescriptorSets)
+{
+    bool sameLayout = true;
+
+    for (uint32_t i = 1; (i < count) && sameLayout; ++i)
+    {
+        sameLayout = (pSetLayouts[i] == pSetLayouts[0]);
+    }
+
+    const DescriptorSetLayout* pLayout = DescriptorSetLayout::ObjectFromHandle(pSetLayouts[0]);
+
+    Pal::gpusize firstSetGpuMemOffset = 0;
+    Pal::gpusize setGpuMemStride      = 0;
+
+    // Check the state heap first, the GPU memory batch can't be given back once allocated.
+    const bool success = sameLayout &&
+                         (m_DynamicDataSupport || (pLayout->Info().numDynamicDescriptors == 0)) &&
+                         (m_setHeap.GetUnusedSetCount() >= count) &&
+                         m_gpuMemHeap.AllocOneShotSetGpuMemBatch(DescriptorGpuMemHeap::GetSetGpuMemSize(pLayout, 0),
+                                                                 count,
+                                                                 &firstSetGpuMemOffset,
+                                                                 &setGpuMemStride);
+
+    if (success)
+    {
+        m_setHeap.AllocSetStateBatch<numPalDevices>(count, pDescriptorSets);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            AssignSet<numPalDevices>(pDescriptorSets[i],
+                                     pLayout,
+                                     firstSetGpuMemOffset + (i * setGpuMemStride),
+                                     nullptr);
+        }
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Points a newly allocated descriptor set at its GPU memory and layout.
+template <uint32_t numPalDevices>
+void DescriptorPool::AssignSet(
+    VkDescriptorSet            set,
+    const DescriptorSetLayout* pLayout,
+    Pal::gpusize               gpuMemOffset,
+    void*                      pSetAllocHandle)
+{
+    size_t privateDataSize = m_setHeap.GetPrivateDataSize();
+
+    if (privateDataSize > 0)
+    {
+        void* pMem = reinterpret_cast<void*>(set);
+
+        //just memset the reserved slots here
+        privateDataSize -= sizeof(PrivateDataChunk*);
+        pMem = Util::VoidPtrDec(pMem, privateDataSize);
+        memset(pMem, 0, privateDataSize);
+    }
+
+    DescriptorSet<numPalDevices>::StateFromHandle(set)->Reassign(pLayout, gpuMemOffset, m_addresses, pSetAllocHandle);
+}
+
+// =====================================================================================================================
+// Takes the most recently freed set whose GPU memory has the given size out of the freed set buckets.
+template <uint32_t numPalDevices>
+bool DescriptorPool::TakeFreedSet(
+    uint32_t         gpuMemSize,
+    VkDescriptorSet* pSet)
+{
+    bool found = false;
+
+    for (uint32_t i = 0; (i < FreedSetBucketCount) && (found == false); ++i)
+    {
+        FreedSetBucket* pBucket = &m_freedSetBuckets[i];
+
+        if ((pBucket->count > 0) && (pBucket->gpuMemSize == gpuMemSize))
+        {
+            const DescriptorSet<numPalDevices>* pState = DescriptorSet<numPalDevices>::StateFromHandle(pBucket->head);
+
+            *pSet = pBucket->head;
+
+            pBucket->head = m_pSetAllocInfo[pState->HeapIndex()].nextFreed;
+            pBucket->count--;
+
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+// =====================================================================================================================
+// Keeps a freed set, including its GPU memory, for a later allocation of the same size.  Returns false if there is no
+// bucket for the set's size and no empty bucket left, in which case the set has to be released as usual.
+template <uint32_t numPalDevices>
+bool DescriptorPool::CacheFreedSet(
+    VkDescriptorSet set)
+{
+    const DescriptorSet<numPalDevices>* pSet  = DescriptorSet<numPalDevices>::StateFromHandle(set);
+    SetAllocInfo*                       pInfo = &m_pSetAllocInfo[pSet->HeapIndex()];
+
+    FreedSetBucket* pBucket = nullptr;
+
+    for (uint32_t i = 0; (i < FreedSetBucketCount) && ((pBucket == nullptr) || (pBucket->count == 0)); ++i)
+    {
+        if (m_freedSetBuckets[i].count == 0)
+        {
+            if (pBucket == nullptr)
+            {
+                pBucket = &m_freedSetBuckets[i];
+            }
+        }
+        else if (m_freedSetBuckets[i].gpuMemSize == pInfo->gpuMemSize)
+        {
+            pBucket = &m_freedSetBuckets[i];
+        }
+    }
+
+    if (pBucket != nullptr)
+    {
+        pBucket->gpuMemSize = pInfo->gpuMemSize;
+        pInfo->nextFreed    = (pBucket->count > 0) ? pBucket->head : VK_NULL_HANDLE;
+        pBucket->head       = set;
+        pBucket->count++;
+    }
+
+    return (pBucket != nullptr);
+}
+
+// =====================================================================================================================
+// Releases the state and GPU memory of all cached freed sets.  Returns false if there were none.
+template <uint32_t numPalDevices>
+bool DescriptorPool::ReleaseFreedSets()
+{
+    bool released = false;
+
+    for (uint32_t i = 0; i < FreedSetBucketCount; ++i)
+    {
+        FreedSetBucket* pBucket = &m_freedSetBuckets[i];
+
+        while (pBucket->count > 0)
+        {
+            const VkDescriptorSet               set  = pBucket->head;
+            const DescriptorSet<numPalDevices>* pSet = DescriptorSet<numPalDevices>::StateFromHandle(set);
+
+            pBucket->head = m_pSetAllocInfo[pSet->HeapIndex()].nextFreed;
+            pBucket->count--;
+
+            m_gpuMemHeap.FreeSetGpuMem(pSet->AllocHandle());
+            m_setHeap.FreeSetState<numPalDevices>(set);
+
+            released = true;
+        }
+    }
+
+    return released;
+}
+
 // =====================================================================================================================
 // Frees an individual descriptor set after it has been destroyed.
 template <uint32_t numPalDevices>
@@ -393,6 +685,8 @@ VkResult DescriptorPool::FreeDescriptorSets(
     uint32_t                         count,
     const VkDescriptorSet*           pDescriptorSets)
 {
+    int32_t freedCount = 0;
+
     for (uint32_t i = 0; i < count; ++i)
     {
         if (pDescriptorSets[i] == VK_NULL_HANDLE)
@@ -400,14 +694,22 @@ VkResult DescriptorPool::FreeDescriptorSets(
             continue;
         }
 
-        // Free this set's GPU memory
-        DescriptorSet<numPalDevices>* pSet  = DescriptorSet<numPalDevices>::StateFromHandle(pDescriptorSets[i]);
-        m_gpuMemHeap.FreeSetGpuMem(pSet->AllocHandle());
+        freedCount++;
+
+        // Keep the set for a later allocation of the same size if we can
+        if ((m_pSetAllocInfo == nullptr) || (CacheFreedSet<numPalDevices>(pDescriptorSets[i]) == false))
+        {
+            // Free this set's GPU memory
+            DescriptorSet<numPalDevices>* pSet  = DescriptorSet<numPalDevices>::StateFromHandle(pDescriptorSets[i]);
+            m_gpuMemHeap.FreeSetGpuMem(pSet->AllocHandle());
 
-        // Free this set's state
-        m_setHeap.FreeSetState<numPalDevices>(pDescriptorSets[i]);
+            // Free this set's state
+            m_setHeap.FreeSetState<numPalDevices>(pDescriptorSets[i]);
+        }
     }
 
+    UpdateStats(-freedCount);
+
     return VK_SUCCESS;
 }
 
@@ -415,6 +717,8 @@ VkResult DescriptorPool::FreeDescriptorSets(
 DescriptorGpuMemHeap::DescriptorGpuMemHeap() :
 m_usage(0),
 m_oneShotAllocForward(0),
+m_nonEmptySizeClassMask(0),
+m_dynamicFreeBytes(0),
 m_pDynamicAllocBlocks(nullptr),
 m_dynamicAllocBlockCount(0),
 m_pDynamicAllocBlockIndexStack(nullptr),
@@ -428,6 +732,7 @@ m_numPalDevices(0)
 
     memset(m_pCpuAddr, 0, sizeof(m_pCpuAddr));
     memset(m_pCpuShadowAddr, 0, sizeof(m_pCpuShadowAddr));
+    memset(m_freeListHeaders, 0, sizeof(m_freeListHeaders));
 }
 
 // =====================================================================================================================
@@ -475,10 +780,9 @@ VkResult DescriptorGpuMemHeap::Init(
         }
 
         // Initialize the management structures
-        m_dynamicAllocBlockFreeListHeader.pPrevFree = nullptr;
-        m_dynamicAllocBlockFreeListHeader.pNextFree = nullptr;
-        m_dynamicAllocBlockFreeListHeader.pPrev     = nullptr;
-        m_dynamicAllocBlockFreeListHeader.pNext     = nullptr;
+        memset(m_freeListHeaders, 0, sizeof(m_freeListHeaders));
+
+        m_nonEmptySizeClassMask = 0;
 
         m_pDynamicAllocBlocks               = reinterpret_cast<DynamicAllocBlock*>(pMemory);
         m_pDynamicAllocBlockIndexStack      = reinterpret_cast<uint32_t*>(Util::VoidPtrInc(pMemory, blockStorageSize));
@@ -522,25 +826,41 @@ void DescriptorGpuMemHeap::SanityCheckDynamicAllocBlockList()
     DynamicAllocBlock*  pBlock      = nullptr;
     DynamicAllocBlock*  pPrevBlock  = nullptr;
 
-    // Sanity check the free block list.
-    pPrevBlock = &m_dynamicAllocBlockFreeListHeader;
-    pBlock = m_dynamicAllocBlockFreeListHeader.pNextFree;
+    Pal::gpusize freeBytes = 0;
+
+    // Sanity check the free block lists.
     blockCount = 0;
-    while (pBlock != nullptr)
+    for (uint32_t sizeClass = 0; sizeClass < NumSizeClasses; ++sizeClass)
     {
-        blockCount++;
+        pPrevBlock = &m_freeListHeaders[sizeClass];
+        pBlock = m_freeListHeaders[sizeClass].pNextFree;
 
-        // The number of blocks in the free list should not exceed half of the blocks, otherwise that's an indication
-        // of a loop in the list of free blocks.
-        VK_ASSERT(blockCount <= (m_dynamicAllocBlockCount / 2 + 1));
+        // The non-empty mask should match the lists.
+        VK_ASSERT(((m_nonEmptySizeClassMask & (1u << sizeClass)) != 0) == (pBlock != nullptr));
 
-        // The pPrevFree field should point to the previous block in the free list.
-        VK_ASSERT(pBlock->pPrevFree == pPrevBlock);
+        while (pBlock != nullptr)
+        {
+            blockCount++;
 
-        pPrevBlock = pBlock;
-        pBlock = pBlock->pNextFree;
+            // The number of blocks in the free lists should not exceed half of the blocks, otherwise that's an
+            // indication of a loop in the list of free blocks.
+            VK_ASSERT(blockCount <= (m_dynamicAllocBlockCount / 2 + 1));
+
+            // The pPrevFree field should point to the previous block in the free list.
+            VK_ASSERT(pBlock->pPrevFree == pPrevBlock);
+
+            // The block should be in the list of its size class.
+            VK_ASSERT(SizeClass(pBlock->gpuMemOffsetRangeEnd - pBlock->gpuMemOffsetRangeStart) == sizeClass);
+
+            freeBytes += pBlock->gpuMemOffsetRangeEnd - pBlock->gpuMemOffsetRangeStart;
+
+            pPrevBlock = pBlock;
+            pBlock = pBlock->pNextFree;
+        }
     }
 
+    VK_ASSERT(freeBytes == m_dynamicFreeBytes);
+
     // Find the first node in the complete block list.
     pBlock = nullptr;
     for (uint32_t i = 0; i < m_dynamicAllocBlockCount; ++i)
@@ -601,15 +921,11 @@ void DescriptorGpuMemHeap::SanityCheckDynamicAllocBlockList()
 #endif
 
 // =====================================================================================================================
-// Allocates enough GPU memory to contain the given descriptor set layout.  Returns back a GPU VA offset and an opaque
-// handle that can be used to free that memory for non-one-shot allocations.
-bool DescriptorGpuMemHeap::AllocSetGpuMem(
+// Returns the number of bytes of GPU memory a set of the given layout and variable descriptor count needs.
+uint32_t DescriptorGpuMemHeap::GetSetGpuMemSize(
     const DescriptorSetLayout*  pLayout,
-    uint32_t                    variableDescriptorCounts,
-    Pal::gpusize*               pSetGpuMemOffset,
-    void**                      pSetAllocHandle)
+    uint32_t                    variableDescriptorCounts)
 {
-    // Figure out the byte size and alignment
     uint32_t byteSize = 0;
     if (variableDescriptorCounts > 0)
     {
@@ -625,6 +941,20 @@ bool DescriptorGpuMemHeap::AllocSetGpuMem(
         byteSize = pLayout->Info().sta.dwSize * sizeof(uint32_t);
     }
 
+    return byteSize;
+}
+
+// =====================================================================================================================
+// Allocates enough GPU memory to contain the given descriptor set layout.  Returns back a GPU VA offset and an opaque
+// handle that can be used to free that memory for non-one-shot allocations.
+bool DescriptorGpuMemHeap::AllocSetGpuMem(
+    const DescriptorSetLayout*  pLayout,
+    uint32_t                    variableDescriptorCounts,
+    Pal::gpusize*               pSetGpuMemOffset,
+    void**                      pSetAllocHandle)
+{
+    // Figure out the byte size and alignment
+    const uint32_t byteSize  = GetSetGpuMemSize(pLayout, variableDescriptorCounts);
     const uint32_t alignment = m_gpuMemAddrAlignment;
 
     if (byteSize == 0)
@@ -651,90 +981,118 @@ bool DescriptorGpuMemHeap::AllocSetGpuMem(
             return true;
         }
     }
-    // For dynamic allocations, do something more complicated
+    // For dynamic allocations, take a block from the free lists and give the rest of its range back
     else
     {
-        DynamicAllocBlock* pBlock = m_dynamicAllocBlockFreeListHeader.pNextFree;
+        DynamicAllocBlock* pBlock = FindFreeBlock(byteSize, alignment);
 
-        while (pBlock != nullptr)
+        if (pBlock != nullptr)
         {
-            Pal::gpusize gpuBaseOffset  = Util::Pow2Align(pBlock->gpuMemOffsetRangeStart, alignment);
-            Pal::gpusize newBlockStart  = gpuBaseOffset + byteSize;
+            const Pal::gpusize gpuBaseOffset = Util::Pow2Align(pBlock->gpuMemOffsetRangeStart, alignment);
+
+            // Round the allocation up to the alignment so that the remaining range starts aligned and any block of at
+            // least the requested size can hold the next allocation.  The last block of the pool may end unaligned.
+            const Pal::gpusize newBlockStart = Util::Min(gpuBaseOffset + Util::Pow2Align(byteSize, alignment),
+                                                         pBlock->gpuMemOffsetRangeEnd);
+
+            *pSetAllocHandle  = pBlock;
+            *pSetGpuMemOffset = gpuBaseOffset;
+
+            UnlinkFreeBlock(pBlock);
 
-            if (newBlockStart <= pBlock->gpuMemOffsetRangeEnd)
+            // If there's space left in this block then let's remember it.
+            if (newBlockStart < pBlock->gpuMemOffsetRangeEnd)
             {
-                *pSetAllocHandle  = pBlock;
-                *pSetGpuMemOffset = gpuBaseOffset;
+                // If the next block is a free one then attach the remaining range to it.
+                if (IsDynamicAllocBlockFree(pBlock->pNext))
+                {
+                    VK_ASSERT(pBlock->gpuMemOffsetRangeEnd == pBlock->pNext->gpuMemOffsetRangeStart);
+
+                    UnlinkFreeBlock(pBlock->pNext);
+
+                    pBlock->pNext->gpuMemOffsetRangeStart = newBlockStart;
 
-                // If there's space left in this block then let's remember it.
-                if (newBlockStart < pBlock->gpuMemOffsetRangeEnd)
+                    LinkFreeBlock(pBlock->pNext);
+                }
+                else
+                // Otherwise create a new free block for the remaining range.
                 {
-                    // If the next block is a free one then attach the remaining range to it.
-                    if (IsDynamicAllocBlockFree(pBlock->pNext))
-                    {
-                        VK_ASSERT(pBlock->gpuMemOffsetRangeEnd == pBlock->pNext->gpuMemOffsetRangeStart);
+                    VK_ASSERT(m_dynamicAllocBlockIndexStackCount > 0);
+                    uint32_t newBlockIndex = m_pDynamicAllocBlockIndexStack[--m_dynamicAllocBlockIndexStackCount];
 
-                        pBlock->pNext->gpuMemOffsetRangeStart = newBlockStart;
-                    }
-                    else
-                    // Otherwise create a new free block for the remaining range.
+                    DynamicAllocBlock* pNewBlock      = &m_pDynamicAllocBlocks[newBlockIndex];
+                    pNewBlock->pPrev                  = pBlock;
+                    pNewBlock->pNext                  = pBlock->pNext;
+                    pNewBlock->gpuMemOffsetRangeStart = newBlockStart;
+                    pNewBlock->gpuMemOffsetRangeEnd   = pBlock->gpuMemOffsetRangeEnd;
+
+                    if (pNewBlock->pNext != nullptr)
                     {
-                        VK_ASSERT(m_dynamicAllocBlockIndexStackCount > 0);
-                        uint32_t newBlockIndex = m_pDynamicAllocBlockIndexStack[--m_dynamicAllocBlockIndexStackCount];
-
-                        DynamicAllocBlock* pNewBlock      = &m_pDynamicAllocBlocks[newBlockIndex];
-                        pNewBlock->pPrevFree              = pBlock;
-                        pNewBlock->pNextFree              = pBlock->pNextFree;
-                        pNewBlock->pPrev                  = pBlock;
-                        pNewBlock->pNext                  = pBlock->pNext;
-                        pNewBlock->gpuMemOffsetRangeStart = newBlockStart;
-                        pNewBlock->gpuMemOffsetRangeEnd   = pBlock->gpuMemOffsetRangeEnd;
-
-                        if (pNewBlock->pNextFree != nullptr)
-                        {
-                            pNewBlock->pNextFree->pPrevFree = pNewBlock;
-                        }
-
-                        if (pNewBlock->pNext != nullptr)
-                        {
-                            pNewBlock->pNext->pPrev = pNewBlock;
-                        }
-
-                        pBlock->pNextFree               = pNewBlock;
-                        pBlock->pNext                   = pNewBlock;
+                        pNewBlock->pNext->pPrev = pNewBlock;
                     }
 
-                    // Truncate the block to the allocated size.
-                    pBlock->gpuMemOffsetRangeEnd = newBlockStart;
-                }
-
-                // Unlink this block from the list of free blocks.
+                    pBlock->pNext = pNewBlock;
 
-                pBlock->pPrevFree->pNextFree = pBlock->pNextFree;
-                if (pBlock->pNextFree != nullptr)
-                {
-                    pBlock->pNextFree->pPrevFree = pBlock->pPrevFree;
+                    LinkFreeBlock(pNewBlock);
                 }
 
-                pBlock->pNextFree   = nullptr;
-                pBlock->pPrevFree   = nullptr;
+                // Truncate the block to the allocated size.
+                pBlock->gpuMemOffsetRangeEnd = newBlockStart;
+            }
 
 #if DEBUG
-                // Sanity check the lists after a successful allocation.
-                SanityCheckDynamicAllocBlockList();
+            // Sanity check the lists after a successful allocation.
+            SanityCheckDynamicAllocBlockList();
 #endif
 
-                return true;
-            }
-
-            // Advance to the next free block.
-            pBlock      = pBlock->pNextFree;
+            return true;
         }
     }
 
     return false;
 }
 
+// =====================================================================================================================
+// Allocates GPU memory for count sets of byteSize bytes each from the one-shot range in a single step.  The sets are
+// laid out back to back, each aligned like AllocSetGpuMem() would align it.  Returns false without allocating anything
+// if the whole batch doesn't fit or the pool allows sets to be freed.
+bool DescriptorGpuMemHeap::AllocOneShotSetGpuMemBatch(
+    uint32_t                    byteSize,
+    uint32_t                    count,
+    Pal::gpusize*               pFirstSetGpuMemOffset,
+    Pal::gpusize*               pSetGpuMemStride)
+{
+    const bool oneShot = (m_usage & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT) == 0;
+
+    bool success = false;
+
+    if (oneShot && (byteSize == 0))
+    {
+        *pFirstSetGpuMemOffset = 0;
+        *pSetGpuMemStride      = 0;
+
+        success = true;
+    }
+    else if (oneShot && (count > 0))
+    {
+        const Pal::gpusize stride        = Util::Pow2Align(byteSize, m_gpuMemAddrAlignment);
+        const Pal::gpusize gpuBaseOffset = Util::Pow2Align(m_oneShotAllocForward, m_gpuMemAddrAlignment);
+        const Pal::gpusize gpuEndOffset  = gpuBaseOffset + (stride * (count - 1)) + byteSize;
+
+        if (gpuEndOffset <= m_gpuMemSize)
+        {
+            *pFirstSetGpuMemOffset = m_gpuMemOffsetRangeStart + gpuBaseOffset;
+            *pSetGpuMemStride      = stride;
+
+            m_oneShotAllocForward = gpuEndOffset;
+
+            success = true;
+        }
+    }
+
+    return success;
+}
+
 // =====================================================================================================================
 // Returns the GPU memory requirements of a DescriptorGpuMemHeap.
 void DescriptorGpuMemHeap::GetGpuMemRequirements(
@@ -808,18 +1166,17 @@ void DescriptorGpuMemHeap::FreeSetGpuMem(
 
         // The deallocation process is as follows:
         //   1. If the next block is free then:
-        //      a. Merge the range of the block into the next block
-        //      b. Unlink the block from the list and release it
-        //      c. Continue as if the next block was the original block
+        //      a. Unlink the next block from its free list
+        //      b. Merge the range of the block into the next block
+        //      c. Unlink the block from the list and release it
+        //      d. Continue as if the next block was the original block
         //   2. If the previous block is free then:
-        //      a. If this block is on the free list then unlink the block from the it
+        //      a. Unlink the previous block from its free list
         //      b. Merge the range of the block into the previous block
         //      c. Unlink the block from the list and release it
-        //   3. If we didn't release the block earlier then it means neither the previous or the next block was
-        //      free, thus we should simply link this block to the list of free blocks (it doesn't matter where
-        //      we link the block in the free list as that doesn't have to be necessarily ordered)
-
-        bool blockReleased = false;
+        //      d. Continue as if the previous block was the original block
+        //   3. Link the resulting block to the free list of its size class.  Merging changes the size of a block, which
+        //      is why merged neighbors are taken off their free lists first.
 
         // If the next block is a free one then attach the range of this block to it.
         if (IsDynamicAllocBlockFree(pBlock->pNext))
@@ -828,19 +1185,20 @@ void DescriptorGpuMemHeap::FreeSetGpuMem(
 
             DynamicAllocBlock* pNextBlock = pBlock->pNext;
 
+            UnlinkFreeBlock(pNextBlock);
+
             // Merge the range of the block into the next block.
-            pBlock->pNext->gpuMemOffsetRangeStart = pBlock->gpuMemOffsetRangeStart;
+            pNextBlock->gpuMemOffsetRangeStart = pBlock->gpuMemOffsetRangeStart;
 
             // Unlink the block from the list.
-            pBlock->pNext->pPrev = pBlock->pPrev;
+            pNextBlock->pPrev = pBlock->pPrev;
             if (pBlock->pPrev != nullptr)
             {
-                pBlock->pPrev->pNext = pBlock->pNext;
+                pBlock->pPrev->pNext = pNextBlock;
             }
 
             // Then release the block.
             m_pDynamicAllocBlockIndexStack[m_dynamicAllocBlockIndexStackCount++] = DynamicAllocBlockIndex(pBlock);
-            blockReleased = true;
 
             // Set the next block as the block.
             pBlock = pNextBlock;
@@ -851,51 +1209,168 @@ void DescriptorGpuMemHeap::FreeSetGpuMem(
         {
             VK_ASSERT(pBlock->gpuMemOffsetRangeStart == pBlock->pPrev->gpuMemOffsetRangeEnd);
 
-            // If this block is on the free list then unlink the block from it.
-            if (pBlock->pPrevFree != nullptr)
-            {
-                pBlock->pPrevFree->pNextFree = pBlock->pNextFree;
-            }
-            if (pBlock->pNextFree != nullptr)
-            {
-                pBlock->pNextFree->pPrevFree = pBlock->pPrevFree;
-            }
+            DynamicAllocBlock* pPrevBlock = pBlock->pPrev;
+
+            UnlinkFreeBlock(pPrevBlock);
 
             // Merge the range of the block into the previous block.
-            pBlock->pPrev->gpuMemOffsetRangeEnd = pBlock->gpuMemOffsetRangeEnd;
+            pPrevBlock->gpuMemOffsetRangeEnd = pBlock->gpuMemOffsetRangeEnd;
 
             // Unlink the block from the list.
-            pBlock->pPrev->pNext = pBlock->pNext;
+            pPrevBlock->pNext = pBlock->pNext;
             if (pBlock->pNext != nullptr)
             {
-                pBlock->pNext->pPrev = pBlock->pPrev;
+                pBlock->pNext->pPrev = pPrevBlock;
             }
 
             // Then release the block.
             m_pDynamicAllocBlockIndexStack[m_dynamicAllocBlockIndexStackCount++] = DynamicAllocBlockIndex(pBlock);
-            blockReleased = true;
+
+            // Set the previous block as the block.
+            pBlock = pPrevBlock;
         }
 
-        // If we didn't release the block so far then let's just link it to the list of free blocks
-        if (!blockReleased)
-        {
-            pBlock->pNextFree = m_dynamicAllocBlockFreeListHeader.pNextFree;
+        LinkFreeBlock(pBlock);
+
+#if DEBUG
+        // Sanity check the lists after a successful destroy.
+        SanityCheckDynamicAllocBlockList();
+#endif
+    }
+}
+
+// =====================================================================================================================
+// Links a free block to the head of the free list of its size class.
+void DescriptorGpuMemHeap::LinkFreeBlock(
+    DynamicAllocBlock* pBlock)
+{
+    const Pal::gpusize size      = pBlock->gpuMemOffsetRangeEnd - pBlock->gpuMemOffsetRangeStart;
+    const uint32_t     sizeClass = SizeClass(size);
+
+    DynamicAllocBlock* pHeader = &m_freeListHeaders[sizeClass];
+
+    pBlock->pPrevFree = pHeader;
+    pBlock->pNextFree = pHeader->pNextFree;
+
+    if (pBlock->pNextFree != nullptr)
+    {
+        pBlock->pNextFree->pPrevFree = pBlock;
+    }
+
+    pHeader->pNextFree = pBlock;
+
+    m_nonEmptySizeClassMask |= (1u << sizeClass);
+    m_dynamicFreeBytes      += size;
+}
+
+// =====================================================================================================================
+// Unlinks a free block from the free list of its size class.  The block's range must not have changed since it was
+// linked.
+void DescriptorGpuMemHeap::UnlinkFreeBlock(
+    DynamicAllocBlock* pBlock)
+{
+    VK_ASSERT(IsDynamicAllocBlockFree(pBlock));
+
+    const Pal::gpusize size      = pBlock->gpuMemOffsetRangeEnd - pBlock->gpuMemOffsetRangeStart;
+    const uint32_t     sizeClass = SizeClass(size);
+
+    pBlock->pPrevFree->pNextFree = pBlock->pNextFree;
 
-            if (pBlock->pNextFree != nullptr)
+    if (pBlock->pNextFree != nullptr)
+    {
+        pBlock->pNextFree->pPrevFree = pBlock->pPrevFree;
+    }
+
+    pBlock->pPrevFree = nullptr;
+    pBlock->pNextFree = nullptr;
+
+    if (m_freeListHeaders[sizeClass].pNextFree == nullptr)
+    {
+        m_nonEmptySizeClassMask &= ~(1u << sizeClass);
+    }
+
+    m_dynamicFreeBytes -= size;
+}
+
+// =====================================================================================================================
+// Finds a free block which can hold byteSize bytes at the given alignment.  Every block of a size class above the
+// request's is large enough, so the head of the first such non-empty list is taken.  Only when there is none do we
+// search the list of the request's own size class, whose blocks may or may not be large enough.
+DescriptorGpuMemHeap::DynamicAllocBlock* DescriptorGpuMemHeap::FindFreeBlock(
+    uint32_t byteSize,
+    uint32_t alignment) const
+{
+    DynamicAllocBlock* pFound    = nullptr;
+    const uint32_t     sizeClass = SizeClass(byteSize);
+
+    // 2u << 31 wraps to 0, which leaves no larger classes for the last one.
+    uint32_t largerClassMask = m_nonEmptySizeClassMask & ~((2u << sizeClass) - 1);
+
+    uint32_t candidateClass = 0;
+
+    while ((pFound == nullptr) && Util::BitMaskScanForward(&candidateClass, largerClassMask))
+    {
+        // Block starts are kept aligned, so the head fits unless this is the unaligned tail of the pool.
+        for (DynamicAllocBlock* pBlock = m_freeListHeaders[candidateClass].pNextFree;
+             (pBlock != nullptr) && (pFound == nullptr);
+             pBlock = pBlock->pNextFree)
+        {
+            if ((Util::Pow2Align(pBlock->gpuMemOffsetRangeStart, alignment) + byteSize) <= pBlock->gpuMemOffsetRangeEnd)
             {
-                pBlock->pNextFree->pPrevFree = pBlock;
+                pFound = pBlock;
             }
+        }
+
+        largerClassMask &= ~(1u << candidateClass);
+    }
+
+    for (DynamicAllocBlock* pBlock = m_freeListHeaders[sizeClass].pNextFree;
+         (pBlock != nullptr) && (pFound == nullptr);
+         pBlock = pBlock->pNextFree)
+    {
+        if ((Util::Pow2Align(pBlock->gpuMemOffsetRangeStart, alignment) + byteSize) <= pBlock->gpuMemOffsetRangeEnd)
+        {
+            pFound = pBlock;
+        }
+    }
+
+    return pFound;
+}
 
-            pBlock->pPrevFree = &m_dynamicAllocBlockFreeListHeader;
+// =====================================================================================================================
+// Returns how fragmented the free memory of a pool with FREE_DESCRIPTOR_SET_BIT is: the share of free bytes which are
+// not part of the largest free block, in percent.  0 means all free memory is contiguous.
+uint32_t DescriptorGpuMemHeap::GetFragmentationPercent() const
+{
+    uint32_t fragmentation = 0;
 
-            m_dynamicAllocBlockFreeListHeader.pNextFree = pBlock;
+    uint32_t largestClass = 0;
+
+    if ((m_dynamicFreeBytes > 0) && Util::BitMaskScanReverse(&largestClass, m_nonEmptySizeClassMask))
+    {
+        Pal::gpusize largestFreeBytes = 0;
+
+        for (const DynamicAllocBlock* pBlock = m_freeListHeaders[largestClass].pNextFree;
+             pBlock != nullptr;
+             pBlock = pBlock->pNextFree)
+        {
+            largestFreeBytes = Util::Max(largestFreeBytes,
+                                         pBlock->gpuMemOffsetRangeEnd - pBlock->gpuMemOffsetRangeStart);
         }
 
-#if DEBUG
-        // Sanity check the lists after a successful destroy.
-        SanityCheckDynamicAllocBlockList();
-#endif
+        fragmentation = static_cast<uint32_t>(((m_dynamicFreeBytes - largestFreeBytes) * 100) / m_dynamicFreeBytes);
     }
+
+    return fragmentation;
+}
+
+// =====================================================================================================================
+// Returns how much of the heap's GPU memory is taken by allocated sets, including the alignment padding between them.
+Pal::gpusize DescriptorGpuMemHeap::GetUsedBytes() const
+{
+    const bool oneShot = (m_usage & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT) == 0;
+
+    return oneShot ? m_oneShotAllocForward : ((m_gpuMemOffsetRangeEnd - m_gpuMemOffsetRangeStart) - m_dynamicFreeBytes);
 }
 
 // =====================================================================================================================
@@ -915,7 +1390,7 @@ void DescriptorGpuMemHeap::Reset()
         VK_ASSERT(m_pDynamicAllocBlockIndexStack != nullptr);
 
         // For dynamic allocations the only thing we have to do is release all blocks by resetting the free index stack
-        // and then reinitializing the free block list with a single entry covering the entire range.
+        // and then reinitializing the free block lists with a single entry covering the entire range.
 
         m_dynamicAllocBlockIndexStackCount = m_dynamicAllocBlockCount;
 
@@ -924,23 +1399,27 @@ void DescriptorGpuMemHeap::Reset()
             m_pDynamicAllocBlockIndexStack[i] = i;
         }
 
+        memset(m_freeListHeaders, 0, sizeof(m_freeListHeaders));
+
+        m_nonEmptySizeClassMask = 0;
+        m_dynamicFreeBytes      = 0;
+
         uint32_t blockIndex = m_pDynamicAllocBlockIndexStack[--m_dynamicAllocBlockIndexStackCount];
 
         DynamicAllocBlock* pBlock      = &m_pDynamicAllocBlocks[blockIndex];
-        pBlock->pPrevFree              = &m_dynamicAllocBlockFreeListHeader;
-        pBlock->pNextFree              = nullptr;
         pBlock->pPrev                  = nullptr;
         pBlock->pNext                  = nullptr;
         pBlock->gpuMemOffsetRangeStart = m_gpuMemOffsetRangeStart;
         pBlock->gpuMemOffsetRangeEnd   = m_gpuMemOffsetRangeEnd;
 
-        m_dynamicAllocBlockFreeListHeader.pNextFree = pBlock;
+        LinkFreeBlock(pBlock);
     }
 }
 
 // =====================================================================================================================
 DescriptorSetHeap::DescriptorSetHeap() :
 m_nextFreeHandle(0),
+m_usedSetCount(0),
 m_maxSets(0),
 m_pFreeIndexStack(nullptr),
 m_freeIndexStackCount(0),
@@ -1029,7 +1508,7 @@ VkResult DescriptorSetHeap::Init(
         {
             PrivateDataStorage* pPrivateDataStorage = static_cast<PrivateDataStorage*>(pSetMem);
 
-            pPrivateDataStorage->pUnreserved = nullptr;
+            pPrivateDataStorage->pUnreserved.store(nullptr, std::memory_order_relaxed);
             pSetMem = Util::VoidPtrInc(pSetMem, m_privateDataSize);
         }
 
@@ -1047,7 +1526,7 @@ void DescriptorSetHeap::Destroy(
 {
     if ((m_privateDataSize > 0) && (m_pSetMemory!= nullptr))
     {
-        for (uint32 index = 0; index < m_maxSets; ++index)
+        for (uint32 index = 0; index < m_usedSetCount; ++index)
         {
             void* pSetMem = Util::VoidPtrInc(m_pSetMemory, index * (m_privateDataSize + m_setSize));
 
@@ -1071,6 +1550,24 @@ VkDescriptorSet DescriptorSetHeap::DescriptorSetHandleFromIndex(
     return DescriptorSet<numPalDevices>::HandleFromVoidPointer(pMem);
 }
 
+// =====================================================================================================================
+// Allocates count consecutive VkDescriptorSet instances from the never-used range of the heap.  The caller must have
+// checked GetUnusedSetCount().
+template <uint32_t numPalDevices>
+void DescriptorSetHeap::AllocSetStateBatch(
+    uint32_t         count,
+    VkDescriptorSet* pSets)
+{
+    VK_ASSERT(count <= GetUnusedSetCount());
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        pSets[i] = DescriptorSetHandleFromIndex<numPalDevices>(m_nextFreeHandle++);
+    }
+
+    m_usedSetCount = Util::Max(m_usedSetCount, m_nextFreeHandle);
+}
+
 // =====================================================================================================================
 // Allocates a new VkDescriptorSet instance and returns a handle to it.
 template <uint32_t numPalDevices>
@@ -1082,6 +1579,8 @@ bool DescriptorSetHeap::AllocSetState(
     {
         *pSet = DescriptorSetHandleFromIndex<numPalDevices>(m_nextFreeHandle++);
 
+        m_usedSetCount = Util::Max(m_usedSetCount, m_nextFreeHandle);
+
         return true;
     }
 
@@ -118,13 +118,13 @@ void DescriptorUpdate::WriteSamplerDescriptors(
     {
         if (pImageInfo->sampler == VK_NULL_HANDLE)
         {
-            memset(pDestAddr, 0, samplerDescSize);
+            ClearSrd<samplerDescSize>(pDestAddr);
         }
         else
         {
             const void* pSamplerDesc = Sampler::ObjectFromHandle(pImageInfo->sampler)->Descriptor();
 
-            memcpy(pDestAddr, pSamplerDesc, samplerDescSize);
+            CopySrd<samplerDescSize>(pDestAddr, pSamplerDesc);
         }
 
         pImageInfo = static_cast<const VkDescriptorImageInfo*>(Util::VoidPtrInc(pImageInfo, imageInfoStride));
@@ -150,25 +150,25 @@ void DescriptorUpdate::WriteImageSamplerDescriptors(
     {
         if (pImageInfo->imageView == VK_NULL_HANDLE)
         {
-            memset(pDestAddr, 0, imageDescSize);
+            ClearSrd<imageDescSize>(pDestAddr);
         }
         else
         {
             const void* pImageDesc = ImageView::ObjectFromHandle(pImageInfo->imageView)->
                 Descriptor(deviceIdx, false, imageDescSize);
 
-            memcpy(pDestAddr, pImageDesc, imageDescSize);
+            CopySrd<imageDescSize>(pDestAddr, pImageDesc);
         }
 
         if (pImageInfo->sampler == VK_NULL_HANDLE)
         {
-            memset(pDestAddr + (imageDescSize / sizeof(uint32_t)), 0, samplerDescSize);
+            ClearSrd<samplerDescSize>(pDestAddr + (imageDescSize / sizeof(uint32_t)));
         }
         else
         {
             const void* pSamplerDesc = Sampler::ObjectFromHandle(pImageInfo->sampler)->Descriptor();
 
-            memcpy(pDestAddr + (imageDescSize / sizeof(uint32_t)), pSamplerDesc, samplerDescSize);
+            CopySrd<samplerDescSize>(pDestAddr + (imageDescSize / sizeof(uint32_t)), pSamplerDesc);
         }
 
         pImageInfo = static_cast<const VkDescriptorImageInfo*>(Util::VoidPtrInc(pImageInfo, imageInfoStride));
@@ -194,14 +194,14 @@ void DescriptorUpdate::WriteImageDescriptors(
     {
         if (pImageInfo->imageView == VK_NULL_HANDLE)
         {
-            memset(pDestAddr, 0, imageDescSize);
+            ClearSrd<imageDescSize>(pDestAddr);
         }
         else
         {
             const void* pImageDesc = ImageView::ObjectFromHandle(pImageInfo->imageView)->
                 Descriptor(deviceIdx, isShaderStorageDesc, imageDescSize);
 
-            memcpy(pDestAddr, pImageDesc, imageDescSize);
+            CopySrd<imageDescSize>(pDestAddr, pImageDesc);
         }
 
         pImageInfo = static_cast<const VkDescriptorImageInfo*>(Util::VoidPtrInc(pImageInfo, imageInfoStride));
@@ -229,7 +229,7 @@ void DescriptorUpdate::WriteImageDescriptorsYcbcr(
     {
         if (pImageInfo->imageView == VK_NULL_HANDLE)
         {
-            memset(pDestAddr, 0, imageDescSize);
+            ClearSrd<imageDescSize>(pDestAddr);
         }
         else
         {
@@ -242,7 +242,7 @@ void DescriptorUpdate::WriteImageDescriptorsYcbcr(
 
             for (uint32_t plane = 0; plane < multiPlaneCount; ++plane, pOutImageDesc += pOutImageDescStride)
             {
-                memcpy(pOutImageDesc, pImageDesc, imageDescSize);
+                CopySrd<imageDescSize>(pOutImageDesc, pImageDesc);
                 pImageDesc = Util::VoidPtrInc(pImageDesc, imageDescSize * ImageView::SrdIndexType::SrdCount);
             }
         }
@@ -271,7 +271,7 @@ void DescriptorUpdate::WriteFmaskDescriptors(
     {
         if (pImageInfo->imageView == VK_NULL_HANDLE)
         {
-            memset(pDestAddr, 0, fmaskDescSize);
+            ClearSrd<fmaskDescSize>(pDestAddr);
         }
         else
         {
@@ -284,12 +284,12 @@ void DescriptorUpdate::WriteFmaskDescriptors(
                 // Image descriptors including shader read and write descriptors.
                 const void* pSrcFmaskAddr = Util::VoidPtrInc(pImageDesc, imageDescSize * ImageView::SrdIndexType::SrdCount);
 
-                memcpy(pDestAddr, pSrcFmaskAddr, fmaskDescSize);
+                CopySrd<fmaskDescSize>(pDestAddr, pSrcFmaskAddr);
             }
             else
             {
                 // If no FMASK descriptor, need clear the memory to 0.
-                memset(pDestAddr, 0, fmaskDescSize);
+                ClearSrd<fmaskDescSize>(pDestAddr);
             }
         }
 
@@ -316,13 +316,13 @@ void DescriptorUpdate::WriteBufferDescriptors(
     {
         if (*pBufferView == VK_NULL_HANDLE)
         {
-            memset(pDestAddr, 0, bufferDescSize);
+            ClearSrd<bufferDescSize>(pDestAddr);
         }
         else
         {
             const void* pBufferDesc = BufferView::ObjectFromHandle(*pBufferView)->Descriptor(type, deviceIdx);
 
-            memcpy(pDestAddr, pBufferDesc, bufferDescSize);
+            CopySrd<bufferDescSize>(pDestAddr, pBufferDesc);
         }
 
         pBufferView = static_cast<const VkBufferView*>(Util::VoidPtrInc(pBufferView, bufferViewStride));
@@ -642,6 +642,95 @@ void DescriptorUpdate::WriteDescriptorSets(
     }
 }
 
+// =====================================================================================================================
+// Checks whether the copies at the start of pDescriptorCopies together copy every binding of one set to another set of
+// the same layout, in full and each binding exactly once.  If so, the whole set is copied with one block copy per
+// section and the number of copies consumed is returned.  Returns 0 without copying anything otherwise.
+template <bool fmaskBasedMsaaReadEnabled, uint32_t numPalDevices>
+uint32_t DescriptorUpdate::CopyWholeDescriptorSet(
+    uint32_t                     deviceIdx,
+    uint32_t                     descriptorCopyCount,
+    const VkCopyDescriptorSet*   pDescriptorCopies)
+{
+    const VkCopyDescriptorSet& first = pDescriptorCopies[0];
+
+    DescriptorSet<numPalDevices>* pSrcSet  = DescriptorSet<numPalDevices>::ObjectFromHandle(first.srcSet);
+    DescriptorSet<numPalDevices>* pDestSet = DescriptorSet<numPalDevices>::ObjectFromHandle(first.dstSet);
+
+    const DescriptorSetLayout* pLayout      = pSrcSet->Layout();
+    const uint32_t             bindingCount = pLayout->Info().count;
+
+    // Sets with a variable-sized last binding may be smaller than the layout's static section.
+    bool applicable = (first.srcSet != first.dstSet)      &&
+                      (pDestSet->Layout() == pLayout)     &&
+                      (bindingCount > 0)                  &&
+                      (bindingCount <= 64)                &&
+                      (pLayout->Binding(bindingCount - 1).bindingFlags.variableDescriptorCount == 0);
+
+    uint64_t requiredMask = 0;
+
+    for (uint32_t binding = 0; applicable && (binding < bindingCount); ++binding)
+    {
+        if (pLayout->Binding(binding).info.descriptorCount > 0)
+        {
+            requiredMask |= (1ull << binding);
+        }
+    }
+
+    uint64_t copiedMask = 0;
+    uint32_t copyCount  = 0;
+
+    while (applicable && (copiedMask != requiredMask) && (copyCount < descriptorCopyCount))
+    {
+        const VkCopyDescriptorSet& params = pDescriptorCopies[copyCount];
+
+        applicable = (params.srcSet == first.srcSet)                                                     &&
+                     (params.dstSet == first.dstSet)                                                     &&
+                     (params.srcBinding == params.dstBinding)                                            &&
+                     (params.srcBinding < bindingCount)                                                  &&
+                     (params.srcArrayElement == 0)                                                       &&
+                     (params.dstArrayElement == 0)                                                       &&
+                     (params.descriptorCount == pLayout->Binding(params.srcBinding).info.descriptorCount) &&
+                     (params.descriptorCount > 0)                                                        &&
+                     ((copiedMask & (1ull << params.srcBinding)) == 0);
+
+        if (applicable)
+        {
+            copiedMask |= (1ull << params.srcBinding);
+            copyCount++;
+        }
+    }
+
+    if (applicable && (copiedMask == requiredMask))
+    {
+        const DescriptorSetLayout::CreateInfo& info = pLayout->Info();
+
+        memcpy(pDestSet->StaticCpuAddress(deviceIdx),
+               pSrcSet->StaticCpuAddress(deviceIdx),
+               info.sta.dwSize * sizeof(uint32_t));
+
+        if (fmaskBasedMsaaReadEnabled && (pSrcSet->FmaskCpuAddress(deviceIdx) != nullptr))
+        {
+            memcpy(pDestSet->FmaskCpuAddress(deviceIdx),
+                   pSrcSet->FmaskCpuAddress(deviceIdx),
+                   info.sta.dwSize * sizeof(uint32_t));
+        }
+
+        if (info.dyn.dwSize > 0)
+        {
+            memcpy(pDestSet->DynamicDescriptorData(deviceIdx),
+                   pSrcSet->DynamicDescriptorData(deviceIdx),
+                   info.dyn.dwSize * sizeof(uint32_t));
+        }
+    }
+    else
+    {
+        copyCount = 0;
+    }
+
+    return copyCount;
+}
+
 // =====================================================================================================================
 // Copy from one descriptor set to another
 template <size_t imageDescSize, size_t fmaskDescSize, bool fmaskBasedMsaaReadEnabled, uint32_t numPalDevices>
@@ -653,6 +742,19 @@ void DescriptorUpdate::CopyDescriptorSets(
 {
     for (uint32_t i = 0; i < descriptorCopyCount; ++i)
     {
+        // Cloning a whole set is a common pattern (e.g. instancing material sets from a template set), which is cheaper
+        // as one block copy than as one copy per binding.
+        const uint32_t wholeSetCopyCount =
+            CopyWholeDescriptorSet<fmaskBasedMsaaReadEnabled, numPalDevices>(deviceIdx,
+                                                                             descriptorCopyCount - i,
+                                                                             &pDescriptorCopies[i]);
+
+        if (wholeSetCopyCount > 0)
+        {
+            i += wholeSetCopyCount - 1;
+            continue;
+        }
+
         const VkCopyDescriptorSet& params = pDescriptorCopies[i];
         uint32_t count = params.descriptorCount;
 
@@ -808,6 +910,8 @@ VKAPI_ATTR void VKAPI_CALL DescriptorUpdate::UpdateDescriptorSets(
                            descriptorCopyCount,
                            pDescriptorCopies);
     }
+
+    FinishSrdWrites();
 }
 
 // =====================================================================================================================
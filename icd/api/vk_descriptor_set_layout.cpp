@@ -114,6 +114,51 @@ uint64_t DescriptorSetLayout::BuildApiHash(
     return hash;
 }
 
+// =====================================================================================================================
+// Flattens the contents of the VkDescriptorSetLayoutCreateInfo struct which BuildApiHash() hashes.  Immutable samplers
+// are identified by their objects.
+void DescriptorSetLayout::BuildSignature(
+    const VkDescriptorSetLayoutCreateInfo* pCreateInfo,
+    LayoutSignature*                       pSignature)
+{
+    pSignature->Append(static_cast<uint32_t>(pCreateInfo->flags));
+    pSignature->Append(pCreateInfo->bindingCount);
+
+    for (uint32 i = 0; i < pCreateInfo->bindingCount; i++)
+    {
+        const VkDescriptorSetLayoutBinding& desc = pCreateInfo->pBindings[i];
+
+        pSignature->Append(desc.binding);
+        pSignature->Append(static_cast<uint32_t>(desc.descriptorType));
+        pSignature->Append(desc.descriptorCount);
+        pSignature->Append(static_cast<uint32_t>(desc.stageFlags));
+
+        if ((desc.pImmutableSamplers != nullptr) &&
+            ((desc.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER) ||
+             (desc.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)))
+        {
+            for (uint32_t j = 0; j < desc.descriptorCount; j++)
+            {
+                pSignature->Append(static_cast<uint64_t>(
+                    reinterpret_cast<uintptr_t>(Sampler::ObjectFromHandle(desc.pImmutableSamplers[j]))));
+            }
+        }
+    }
+
+    const auto* pBindingFlags = GetExtensionStructure<VkDescriptorSetLayoutBindingFlagsCreateInfo>(
+        pCreateInfo, VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO);
+
+    if (pBindingFlags != nullptr)
+    {
+        pSignature->Append(pBindingFlags->bindingCount);
+
+        for (uint32 i = 0; i < pBindingFlags->bindingCount; i++)
+        {
+            pSignature->Append(static_cast<uint32_t>(pBindingFlags->pBindingFlags[i]));
+        }
+    }
+}
+
 // =====================================================================================================================
 DescriptorSetLayout::DescriptorSetLayout(
     const Device*     pDevice,
@@ -585,6 +630,30 @@ VkResult DescriptorSetLayout::Create(
     const size_t auxSize = bindingInfoAuxSize + immSamplerAuxSize + immYCbCrMetaDataSize;
     const size_t objSize = apiSize + auxSize;
 
+    // Return the layout created from an identical create info if it's still alive
+    LayoutCache*    pLayoutCache = pDevice->GetLayoutCache();
+    LayoutSignature signature(pDevice->VkInstance());
+    bool            shareable    = pLayoutCache->CanShare(pAllocator);
+
+    if (shareable)
+    {
+        BuildSignature(pCreateInfo, &signature);
+
+        shareable = signature.IsValid();
+    }
+
+    if (shareable)
+    {
+        void* pShared = pLayoutCache->Acquire(LayoutType::DescriptorSetLayout, apiHash, signature);
+
+        if (pShared != nullptr)
+        {
+            *pLayout = DescriptorSetLayout::HandleFromVoidPointer(pShared);
+
+            return VK_SUCCESS;
+        }
+    }
+
     void* pSysMem = pDevice->AllocApiObject(pAllocator, objSize);
 
     if (pSysMem == nullptr)
@@ -622,6 +691,19 @@ VkResult DescriptorSetLayout::Create(
 
     VK_PLACEMENT_NEW (pSysMem) DescriptorSetLayout (pDevice, info, apiHash);
 
+    if (shareable)
+    {
+        void* pShared = pLayoutCache->Insert(LayoutType::DescriptorSetLayout, apiHash, signature, pSysMem);
+
+        // Another thread created the same layout in the meantime
+        if (pShared != pSysMem)
+        {
+            static_cast<DescriptorSetLayout*>(pSysMem)->Destroy(pDevice, pAllocator, true);
+
+            pSysMem = pShared;
+        }
+    }
+
     *pLayout = DescriptorSetLayout::HandleFromVoidPointer(pSysMem);
 
     return result;
@@ -670,17 +752,24 @@ uint32_t DescriptorSetLayout::GetImmYCbCrMetaDataArrayByteSize() const
 }
 
 // =====================================================================================================================
-// Destroy descriptor set layout object
+// Destroy descriptor set layout object.  A layout shared by several creates is only destroyed with the last handle.
 VkResult DescriptorSetLayout::Destroy(
     Device*                         pDevice,
     const VkAllocationCallbacks*    pAllocator,
     bool                            freeMemory)
 {
-    this->~DescriptorSetLayout();
+    // Copies embedded in pipeline layouts (freeMemory is false) are never shared
+    const bool destroy = (freeMemory == false) ||
+                         pDevice->GetLayoutCache()->Release(LayoutType::DescriptorSetLayout, m_apiHash, this);
 
-    if (freeMemory)
+    if (destroy)
     {
-        pDevice->FreeApiObject(pAllocator, this);
+        this->~DescriptorSetLayout();
+
+        if (freeMemory)
+        {
+            pDevice->FreeApiObject(pAllocator, this);
+        }
     }
 
     return VK_SUCCESS;
@@ -64,7 +64,8 @@ VkResult DescriptorUpdateTemplate::Create(
         // we don't support VK_KHR_push_descriptors.
         VK_ASSERT(pCreateInfo->templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET);
 
-        TemplateUpdateInfo* pEntries = static_cast<TemplateUpdateInfo*>(Util::VoidPtrInc(pSysMem, apiSize));
+        TemplateUpdateInfo* pEntries      = static_cast<TemplateUpdateInfo*>(Util::VoidPtrInc(pSysMem, apiSize));
+        uint32_t            numRunEntries = 0;
 
         for (uint32_t ii = 0; ii < numEntries; ii++)
         {
@@ -83,23 +84,39 @@ VkResult DescriptorUpdateTemplate::Create(
                 dstArrayElement = srcEntry.dstArrayElement;
             }
 
-            pEntries[ii].descriptorCount                = srcEntry.descriptorCount;
-            pEntries[ii].srcOffset                      = srcEntry.offset;
-            pEntries[ii].srcStride                      = srcEntry.stride;
-            pEntries[ii].dstBindStaDwArrayStride        = dstBinding.sta.dwArrayStride;
-            pEntries[ii].dstBindDynDataDwArrayStride    = dstBinding.dyn.dwArrayStride;
+            TemplateUpdateInfo entry;
 
-            pEntries[ii].dstStaOffset                   =
+            entry.descriptorCount                = srcEntry.descriptorCount;
+            entry.srcOffset                      = srcEntry.offset;
+            entry.srcStride                      = srcEntry.stride;
+            entry.dstBindStaDwArrayStride        = dstBinding.sta.dwArrayStride;
+            entry.dstBindDynDataDwArrayStride    = dstBinding.dyn.dwArrayStride;
+
+            entry.dstStaOffset                   =
                 pLayout->GetDstStaOffset(dstBinding, dstArrayElement);
 
-            pEntries[ii].dstDynOffset                   =
+            entry.dstDynOffset                   =
                 pLayout->GetDstDynOffset(dstBinding, dstArrayElement);
 
-            pEntries[ii].pFunc                          =
+            entry.pFunc                          =
                 GetUpdateEntryFunc(pDevice, srcEntry.descriptorType, dstBinding);
+
+            // Entries continuing the previous one in both pData and the set are folded into it, so that e.g. a
+            // template with one entry per binding of consecutive same-type bindings is executed as a single run.
+            const bool inlineUniformBlock =
+                (dstBinding.info.descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT);
+
+            if ((numRunEntries > 0) && ExtendsEntry(pEntries[numRunEntries - 1], entry, inlineUniformBlock))
+            {
+                pEntries[numRunEntries - 1].descriptorCount += entry.descriptorCount;
+            }
+            else
+            {
+                pEntries[numRunEntries++] = entry;
+            }
         }
 
-        VK_PLACEMENT_NEW(pSysMem) DescriptorUpdateTemplate(pCreateInfo->descriptorUpdateEntryCount);
+        VK_PLACEMENT_NEW(pSysMem) DescriptorUpdateTemplate(numRunEntries);
 
         *pDescriptorUpdateTemplate = DescriptorUpdateTemplate::HandleFromVoidPointer(pSysMem);
     }
@@ -291,6 +308,38 @@ DescriptorUpdateTemplate::PfnUpdateEntry DescriptorUpdateTemplate::GetUpdateEntr
     return pFunc;
 }
 
+// =====================================================================================================================
+// Returns true if next writes the descriptors directly following those of prev with the same update function, reading
+// its source data directly following prev's.  Inline uniform block entries count bytes rather than descriptors.
+bool DescriptorUpdateTemplate::ExtendsEntry(
+    const TemplateUpdateInfo& prev,
+    const TemplateUpdateInfo& next,
+    bool                      inlineUniformBlock)
+{
+    bool extends = (prev.pFunc == next.pFunc) && (next.pFunc != nullptr);
+
+    if (extends && inlineUniformBlock)
+    {
+        extends = ((prev.srcOffset + prev.descriptorCount) == next.srcOffset) &&
+                  ((prev.dstStaOffset + (prev.descriptorCount / sizeof(uint32_t))) == next.dstStaOffset);
+    }
+    else if (extends)
+    {
+        // A zero stride means tightly packed info structures to the write functions, so only merge explicit strides.
+        extends = (prev.srcStride != 0)                                                               &&
+                  (prev.srcStride == next.srcStride)                                                  &&
+                  (prev.dstBindStaDwArrayStride == next.dstBindStaDwArrayStride)                      &&
+                  (prev.dstBindDynDataDwArrayStride == next.dstBindDynDataDwArrayStride)              &&
+                  ((prev.srcOffset + (prev.descriptorCount * prev.srcStride)) == next.srcOffset)      &&
+                  ((prev.dstStaOffset + (prev.descriptorCount * prev.dstBindStaDwArrayStride)) ==
+                   next.dstStaOffset)                                                                 &&
+                  ((prev.dstDynOffset + (prev.descriptorCount * prev.dstBindDynDataDwArrayStride)) ==
+                   next.dstDynOffset);
+    }
+
+    return extends;
+}
+
 // =====================================================================================================================
 DescriptorUpdateTemplate::DescriptorUpdateTemplate(
     uint32_t                    numEntries)
@@ -330,6 +379,8 @@ void DescriptorUpdateTemplate::Update(
 
         pEntries[i].pFunc(pDevice, descriptorSet, pDescriptorInfo, pEntries[i]);
     }
+
+    DescriptorUpdate::FinishSrdWrites();
 }
 
 // =====================================================================================================================
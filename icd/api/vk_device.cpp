@@ -65,16 +65,26 @@
 #include "include/vk_swapchain.h"
 #include "include/vk_utils.h"
 #include "include/vk_conv.h"
+#include "include/api_object_pool.h"
+#include "include/compile_thread_pool.h"
+#include "include/gpu_timing_table.h"
+#include "include/pipeline_stats_profile.h"
+#include "include/startup_profile.h"
+#include "include/barrier_profile.h"
 #include "include/internal_layer_hooks.h"
+#include "include/log.h"
+
+#include "utils/json_writer.h"
 
 #include "sqtt/sqtt_layer.h"
 #include "sqtt/sqtt_mgr.h"
 #include "sqtt/sqtt_rgp_annotations.h"
 
+#include "appopt/api_profile_layer.h"
+#include "appopt/app_rule_layer.h"
 #include "appopt/async_layer.h"
 
 #include "appopt/barrier_filter_layer.h"
-#include "appopt/strange_brigade_layer.h"
 
 #if ICD_GPUOPEN_DEVMODE_BUILD
 #include "devmode/devmode_mgr.h"
@@ -94,6 +104,7 @@
 #include "palQueueSemaphore.h"
 #include "palAutoBuffer.h"
 #include "palBorderColorPalette.h"
+#include "palSysUtil.h"
 
 namespace vk
 {
@@ -218,6 +229,7 @@ Device::Device(
     m_shaderOptimizer(this, pPhysicalDevices[DefaultDeviceIndex]),
     m_resourceOptimizer(this, pPhysicalDevices[DefaultDeviceIndex]),
     m_renderStateCache(this),
+    m_internalPipelinesReady(false),
     m_barrierPolicy(
         pPhysicalDevices[DefaultDeviceIndex],
         pCreateInfo,
@@ -226,12 +238,46 @@ Device::Device(
     m_dispatchTable(DispatchTable::Type::DEVICE, m_pInstance, this),
     m_pSqttMgr(nullptr),
     m_pAsyncLayer(nullptr),
+    m_pCompileThreadPool(nullptr),
+    m_pGpuTimingTable(nullptr),
+    m_pPipelineStatsProfile(nullptr),
+    m_pBarrierProfile(nullptr),
     m_pAppOptLayer(nullptr),
     m_pBarrierFilterLayer(nullptr),
+    m_pApiProfileLayer(nullptr),
+    m_pApiObjectPool(nullptr),
     m_allocationSizeTracking(m_settings.memoryDeviceOverallocationAllowed ? false : true),
     m_useComputeAsTransferQueue(useComputeAsTransferQueue),
     m_useGlobalGpuVa(false)
-    , m_pBorderColorUsedIndexes(nullptr)
+    , m_pBorderColorSlots(nullptr)
+    , m_borderColorFreeHead(MaxBorderColorPaletteSize)
+    , m_borderColorSlotMap(pPhysicalDevices[DefaultDeviceIndex]->VkInstance())
+    , m_sharedCmdAllocatorCount(0)
+    , m_nextSharedCmdAllocator(0)
+    , m_drawCount(0)
+    , m_validatedDrawCount(0)
+    , m_filteredStateCount(0)
+    , m_memoryBlockCache(this)
+    , m_externalMemoryCache(this)
+    , m_debugNameTable(this)
+    , m_eventStatusValues()
+    , m_tempMemArenaPool(pPhysicalDevices[DefaultDeviceIndex]->VkInstance()->GetAllocCallbacks())
+    , m_residencyTracker(this)
+    , m_memoryEventLog(this)
+    , m_perfCounters(this)
+    , m_gpuAddressIndex(this)
+    , m_imageCreateInfoCache(this)
+    , m_shaderModuleCache(this)
+    , m_layoutCache(this)
+    , m_transientAliasPlanner(this)
+    , m_imageLayoutTracker(this)
+    , m_pipelineAutotuner(this)
+    , m_pipelineCompileEventLog(this)
+    , m_queueTimingLog(this)
+    , m_timestampCalibrator(this)
+    , m_pendingMemRefCount(0)
+    , m_pooledFenceCount(0)
+    , m_cleanFenceCount(0)
 {
     memset(m_pBltMsaaState, 0, sizeof(m_pBltMsaaState));
 
@@ -244,13 +290,17 @@ Device::Device(
         m_perGpu[deviceIdx].pPhysicalDevice = pPhysicalDevices[deviceIdx];
         m_perGpu[deviceIdx].pPalDevice      = pPalDevices[deviceIdx];
 
-        m_perGpu[deviceIdx].pSharedPalCmdAllocator = nullptr;
+        memset(m_perGpu[deviceIdx].pSharedPalCmdAllocators, 0, sizeof(m_perGpu[deviceIdx].pSharedPalCmdAllocators));
+
+        m_perGpu[deviceIdx].pSwCompositingMemory        = nullptr;
+        m_perGpu[deviceIdx].pSwCompositingCmdBuffer     = nullptr;
+        m_perGpu[deviceIdx].pPalBorderColorPalette      = nullptr;
 
-        m_perGpu[deviceIdx].pSwCompositingMemory    = nullptr;
-        m_perGpu[deviceIdx].pSwCompositingQueue     = nullptr;
-        m_perGpu[deviceIdx].pSwCompositingSemaphore = nullptr;
-        m_perGpu[deviceIdx].pSwCompositingCmdBuffer = nullptr;
-        m_perGpu[deviceIdx].pPalBorderColorPalette  = nullptr;
+        memset(m_perGpu[deviceIdx].pSwCompositingQueue, 0, sizeof(m_perGpu[deviceIdx].pSwCompositingQueue));
+        memset(m_perGpu[deviceIdx].pSwCompositingSemaphore, 0, sizeof(m_perGpu[deviceIdx].pSwCompositingSemaphore));
+        memset(m_perGpu[deviceIdx].pSwCompositingDoneSemaphore,
+               0,
+               sizeof(m_perGpu[deviceIdx].pSwCompositingDoneSemaphore));
 
     }
 
@@ -287,6 +337,9 @@ Device::Device(
     m_allocatedCount = 0;
     m_maxAllocations = pPhysicalDevices[DefaultDeviceIndex]->GetLimits().maxMemoryAllocationCount;
 
+    // The shader optimizer turns the settled autotuning trials into profile entries.
+    m_pipelineAutotuner.Init();
+
     m_shaderOptimizer.Init();
     m_resourceOptimizer.Init();
 
@@ -381,6 +434,8 @@ VkResult Device::Create(
     const VkAllocationCallbacks*    pAllocator,
     DispatchableDevice**            ppDevice)
 {
+    StartupPhase startupPhase("vkCreateDevice");
+
     Pal::Result palResult = Pal::Result::Success;
     uint32_t queueCounts[Queue::MaxQueueFamilies] = {};
     uint32_t queueFlags[Queue::MaxQueueFamilies] = {};
@@ -739,6 +794,15 @@ VkResult Device::Create(
             break;
         }
 
+        case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR:
+        {
+            vkResult = VerifyRequestedPhysicalDeviceFeatures<VkPhysicalDeviceDynamicRenderingFeaturesKHR>(
+                pPhysicalDevice,
+                reinterpret_cast<const VkPhysicalDeviceDynamicRenderingFeaturesKHR*>(pHeader));
+
+            break;
+        }
+
         case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_EXECUTABLE_PROPERTIES_FEATURES_KHR:
         {
             vkResult = VerifyRequestedPhysicalDeviceFeatures<VkPhysicalDevicePipelineExecutablePropertiesFeaturesKHR>(
@@ -1369,21 +1433,72 @@ VkResult Device::Initialize(
     const ExtendedRobustness&               extendedRobustnessEnabled,
     bool                                    bufferDeviceAddressMultiDeviceEnabled)
 {
+    StartupPhase startupPhase("Device::Initialize");
+
+    // Open the memory event log first so that it sees the internal memory manager's allocations
+    m_memoryEventLog.Init();
+
+    m_gpuAddressIndex.Init();
+
+    m_pipelineCompileEventLog.Init();
+
+    m_queueTimingLog.Init();
+
+    m_timestampCalibrator.Init();
+
     // Initialize the internal memory manager
     VkResult result = m_internalMemMgr.Init();
 
+    m_memoryBlockCache.Init();
+
+    m_externalMemoryCache.Init();
+
+    m_imageCreateInfoCache.Init();
+
+    m_shaderModuleCache.Init();
+
+    m_layoutCache.Init();
+
+    m_residencyTracker.Init();
+
+    if (result == VK_SUCCESS)
+    {
+        result = m_perfCounters.Init();
+    }
+
     // Initialize the render state cache
     if (result == VK_SUCCESS)
     {
         result = m_renderStateCache.Init();
     }
 
+    if (result == VK_SUCCESS)
+    {
+        result = m_debugNameTable.Init();
+    }
+
+    // API objects are only pooled when the application leaves system memory to the driver.  Objects are simply
+    // allocated one by one if the pool can't be created.
+    if ((result == VK_SUCCESS) && m_settings.enableApiObjectPool)
+    {
+        const PFN_vkAllocationFunction pfnAllocation = VkInstance()->GetAllocCallbacks()->pfnAllocation;
+
+        if ((pfnAllocation == allocator::g_DefaultAllocCallback.pfnAllocation) ||
+            (pfnAllocation == allocator::g_ThreadCachingAllocCallback.pfnAllocation))
+        {
+            m_pApiObjectPool = ApiObjectPool::Create(this);
+        }
+    }
+
     if (result == VK_SUCCESS)
     {
         // Create a common CmdAllocator for internal use. For the driver setting, useSharedCmdAllocator,
         // this CmdAllocator will be used by all command buffers created by this device.
         // It must be thread safe because two threads could modify two command buffers at once
         // which may cause those command buffers to access the allocator simultaneously.
+        //
+        // With useSharedCmdAllocator, sharedCmdAllocatorCount allocators are created and command pools are spread
+        // over them round-robin, so threads recording from different pools rarely contend on the same allocator lock.
         Pal::CmdAllocatorCreateInfo createInfo = {};
 
         createInfo.flags.threadSafe               = 1;
@@ -1408,27 +1523,54 @@ VkResult Device::Initialize(
         Pal::Result  palResult = Pal::Result::Success;
         const size_t allocatorSize = PalDevice(DefaultDeviceIndex)->GetCmdAllocatorSize(createInfo, &palResult);
 
+        const uint32_t allocatorCount = m_settings.useSharedCmdAllocator ?
+            Util::Clamp(m_settings.sharedCmdAllocatorCount, 1u, MaxSharedCmdAllocators) : 1u;
+
         if (palResult == Pal::Result::Success)
         {
-            void* pAllocatorMem = m_pInstance->AllocMem(
-                allocatorSize * NumPalDevices(), VK_DEFAULT_MEM_ALIGN, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+            // The allocators are laid out slot-major so that slot 0 of device 0 sits at the start of the allocation.
+            void* pAllocatorMem = m_pInstance->AllocMem(allocatorSize * NumPalDevices() * allocatorCount,
+                                                        VK_DEFAULT_MEM_ALIGN,
+                                                        VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
 
             if (pAllocatorMem != NULL)
             {
-                for (uint32_t deviceIdx = 0;
-                    (deviceIdx < NumPalDevices()) && (palResult == Pal::Result::Success);
-                    deviceIdx++)
+                for (uint32_t slot = 0; (slot < allocatorCount) && (palResult == Pal::Result::Success); slot++)
                 {
-                    VK_ASSERT(allocatorSize == PalDevice(deviceIdx)->GetCmdAllocatorSize(createInfo, &palResult));
+                    for (uint32_t deviceIdx = 0;
+                        (deviceIdx < NumPalDevices()) && (palResult == Pal::Result::Success);
+                        deviceIdx++)
+                    {
+                        VK_ASSERT(allocatorSize == PalDevice(deviceIdx)->GetCmdAllocatorSize(createInfo, &palResult));
+
+                        palResult = PalDevice(deviceIdx)->CreateCmdAllocator(createInfo,
+                            Util::VoidPtrInc(pAllocatorMem, allocatorSize * ((slot * NumPalDevices()) + deviceIdx)),
+                            &m_perGpu[deviceIdx].pSharedPalCmdAllocators[slot]);
+                    }
 
-                    palResult = PalDevice(deviceIdx)->CreateCmdAllocator(createInfo,
-                        Util::VoidPtrInc(pAllocatorMem, allocatorSize * deviceIdx),
-                        &m_perGpu[deviceIdx].pSharedPalCmdAllocator);
+                    if (palResult == Pal::Result::Success)
+                    {
+                        m_sharedCmdAllocatorCount++;
+                    }
                 }
                 result = PalToVkResult(palResult);
 
                 if (result != VK_SUCCESS)
                 {
+                    for (uint32_t deviceIdx = 0; deviceIdx < NumPalDevices(); deviceIdx++)
+                    {
+                        for (uint32_t slot = 0; slot < allocatorCount; slot++)
+                        {
+                            if (m_perGpu[deviceIdx].pSharedPalCmdAllocators[slot] != nullptr)
+                            {
+                                m_perGpu[deviceIdx].pSharedPalCmdAllocators[slot]->Destroy();
+                                m_perGpu[deviceIdx].pSharedPalCmdAllocators[slot] = nullptr;
+                            }
+                        }
+                    }
+
+                    m_sharedCmdAllocatorCount = 0;
+
                     m_pInstance->FreeMem(pAllocatorMem);
                 }
             }
@@ -1444,6 +1586,24 @@ VkResult Device::Initialize(
     }
 
     memcpy(&m_pQueues, pQueues, sizeof(m_pQueues));
+
+    uint32_t universalQueueCount = 0;
+
+    for (uint32_t i = 0; i < Queue::MaxQueueFamilies; ++i)
+    {
+        for (uint32_t j = 0; (j < Queue::MaxQueuesPerFamily) && (m_pQueues[i][j] != nullptr); ++j)
+        {
+            if (GetQueueFamilyPalQueueType(i) == Pal::QueueTypeUniversal)
+            {
+                universalQueueCount++;
+            }
+        }
+    }
+
+    m_transientAliasPlanner.Init(universalQueueCount);
+
+    m_imageLayoutTracker.Init();
+
     Pal::DeviceProperties deviceProps = {};
     result = PalToVkResult(PalDevice(DefaultDeviceIndex)->GetProperties(&deviceProps));
 
@@ -1493,9 +1653,13 @@ VkResult Device::Initialize(
         m_maxVrsShadingRate = PalToVkShadingSize(maxPalVrsShadingRate);
     }
 
-    if (result == VK_SUCCESS)
+    // Internal pipelines are only needed by a few commands, so by default they are built on first use.  That first
+    // build is cheap when EnableInternalPipelineCachingToDisk lets an earlier process's binaries be reused.
+    if ((result == VK_SUCCESS) && (m_settings.deferInternalPipelineCreation == false))
     {
         result = CreateInternalPipelines();
+
+        m_internalPipelinesReady = (result == VK_SUCCESS);
     }
 
     if (result == VK_SUCCESS)
@@ -1553,27 +1717,79 @@ VkResult Device::Initialize(
         }
     }
 
-    if (result == VK_SUCCESS)
+    // Developer mode tools time and trace the PAL submissions of the calling thread, so submits stay synchronous then.
+    if ((result == VK_SUCCESS)                             &&
+        m_settings.enableAsyncQueueSubmit                  &&
+        (VkInstance()->IsTracingSupportEnabled() == false) &&
+        (VkInstance()->GetDevModeMgr() == nullptr))
+    {
+        for (uint32_t i = 0; i < Queue::MaxQueueFamilies; ++i)
+        {
+            for (uint32_t j = 0; (j < Queue::MaxQueuesPerFamily) && (m_pQueues[i][j] != nullptr); ++j)
+            {
+                (*m_pQueues[i][j])->StartSubmitThread();
+            }
+        }
+    }
+
+    // Command buffers only time themselves if the table could be allocated, so failing here isn't fatal.
+    if ((result == VK_SUCCESS) && m_settings.enableGpuTimingTable && (TimestampFrequency() > 0))
+    {
+        m_pGpuTimingTable = GpuTimingTable::Create(this);
+    }
+
+    // Likewise for the pipeline statistics profile.
+    if ((result == VK_SUCCESS) && m_settings.enablePipelineStatsProfile)
+    {
+        m_pPipelineStatsProfile = PipelineStatsProfile::Create(this);
+    }
+
+    // And for the barrier profile.
+    if ((result == VK_SUCCESS) && m_settings.enableBarrierProfile && (TimestampFrequency() > 0))
     {
-        switch (GetAppProfile())
+        m_pBarrierProfile = BarrierProfile::Create(this);
+    }
+
+    if ((result == VK_SUCCESS) && m_settings.enableQueueSubmitStats)
+    {
+        for (uint32_t i = 0; i < Queue::MaxQueueFamilies; ++i)
+        {
+            for (uint32_t j = 0; (j < Queue::MaxQueuesPerFamily) && (m_pQueues[i][j] != nullptr); ++j)
+            {
+                (*m_pQueues[i][j])->EnableSubmitStats();
+            }
+        }
+    }
+
+    if ((result == VK_SUCCESS) && m_queueTimingLog.IsEnabled())
+    {
+        for (uint32_t i = 0; i < Queue::MaxQueueFamilies; ++i)
         {
-        case AppProfile::StrangeBrigade:
+            for (uint32_t j = 0; (j < Queue::MaxQueuesPerFamily) && (m_pQueues[i][j] != nullptr); ++j)
+            {
+                (*m_pQueues[i][j])->EnableTimingLog();
+            }
+        }
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        AppOptRules appOptRules;
+
+        AppRuleLayer::BuildRules(this, &appOptRules);
+
+        if (AppRuleLayer::HasRules(appOptRules))
         {
-            void* pMemory = VkInstance()->AllocMem(sizeof(StrangeBrigadeLayer), VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+            void* pMemory = VkInstance()->AllocMem(sizeof(AppRuleLayer), VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
 
             if (pMemory != nullptr)
             {
-                m_pAppOptLayer = VK_PLACEMENT_NEW(pMemory) StrangeBrigadeLayer();
+                m_pAppOptLayer = VK_PLACEMENT_NEW(pMemory) AppRuleLayer(appOptRules);
             }
             else
             {
                 result = VK_ERROR_OUT_OF_HOST_MEMORY;
             }
-
-            break;
-        }
-        default:
-            break;
         }
     }
 
@@ -1605,6 +1821,49 @@ VkResult Device::Initialize(
         }
     }
 
+    if ((result == VK_SUCCESS) && m_settings.enableApiProfileLayer)
+    {
+        void* pMemory = VkInstance()->AllocMem(sizeof(ApiProfileLayer), VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+        if (pMemory != nullptr)
+        {
+            m_pApiProfileLayer = VK_PLACEMENT_NEW(pMemory) ApiProfileLayer(this);
+        }
+        else
+        {
+            result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+
+    if ((result == VK_SUCCESS) && m_settings.enableParallelPipelineCompile)
+    {
+        uint32_t threadCount = m_settings.parallelPipelineCompileThreadCount;
+
+        if (threadCount == 0)
+        {
+            Util::SystemInfo sysInfo = {};
+            Util::QuerySystemInfo(&sysInfo);
+
+            threadCount = sysInfo.cpuLogicalCoreCount / 2;
+        }
+
+        // The calling thread always takes part in a batch, so a single core doesn't need any workers.
+        if (threadCount > 1)
+        {
+            // Failing to start the workers is not fatal; batched creates simply run on the calling thread.
+            m_pCompileThreadPool = CompileThreadPool::Create(VkInstance(), threadCount - 1);
+        }
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        // Start loading the pipelines the previous run used while the application is still setting up.
+        for (uint32_t deviceIdx = 0; deviceIdx < NumPalDevices(); deviceIdx++)
+        {
+            GetCompiler(deviceIdx)->StartPipelinePrewarm();
+        }
+    }
+
     const Pal::DeviceProperties& palProps = pPhysicalDevice->PalProperties();
 
     if (result == VK_SUCCESS)
@@ -1718,6 +1977,13 @@ void Device::InitDispatchTable()
 
     ep->vkUpdateDescriptorSets      = DescriptorUpdate::GetUpdateDescriptorSetsFunc(this);
     ep->vkCmdBindDescriptorSets     = CmdBuffer::GetCmdBindDescriptorSetsFunc(this);
+    ep->vkCmdDraw                   = CmdBuffer::GetCmdDrawFunc(this);
+    ep->vkCmdDrawIndexed            = CmdBuffer::GetCmdDrawIndexedFunc(this);
+    ep->vkCmdDispatch               = CmdBuffer::GetCmdDispatchFunc(this);
+    ep->vkCmdPushConstants          = CmdBuffer::GetCmdPushConstantsFunc(this);
+    ep->vkCmdBindVertexBuffers      = CmdBuffer::GetCmdBindVertexBuffersFunc(this);
+    ep->vkCmdSetViewport            = CmdBuffer::GetCmdSetViewportFunc(this);
+    ep->vkCmdSetScissor             = CmdBuffer::GetCmdSetScissorFunc(this);
     ep->vkCreateDescriptorPool      = DescriptorPool::GetCreateDescriptorPoolFunc(this);
     ep->vkFreeDescriptorSets        = DescriptorPool::GetFreeDescriptorSetsFunc(this);
     ep->vkResetDescriptorPool       = DescriptorPool::GetResetDescriptorPoolFunc(this);
@@ -1750,6 +2016,12 @@ void Device::InitDispatchTable()
         m_pAsyncLayer->OverrideDispatchTable(&m_dispatchTable);
     }
 
+    // Install the API profile layer last, so the time it measures includes all the other layers
+    if (m_pApiProfileLayer != nullptr)
+    {
+        m_pApiProfileLayer->OverrideDispatchTable(&m_dispatchTable);
+    }
+
 }
 
 // =====================================================================================================================
@@ -1928,6 +2200,123 @@ uint32_t Device::GetDefaultSamplePatternIndex(
     return patternIndex;
 }
 
+// =====================================================================================================================
+// Returns the shared CmdAllocator slot the next command pool should use.  Pools are assigned round-robin so that pools
+// recorded on different threads are spread evenly over the thread-safe shared allocators.
+uint32_t Device::AcquireSharedCmdAllocatorSlot()
+{
+    VK_ASSERT(m_sharedCmdAllocatorCount > 0);
+
+    return (Util::AtomicIncrement(&m_nextSharedCmdAllocator) % m_sharedCmdAllocatorCount);
+}
+
+// =====================================================================================================================
+// Accumulates the draw and redundant state counters of a command buffer whose recording has ended.  They are logged
+// under the DrawValidation log tag when the device is destroyed.
+void Device::RecordDrawValidationStats(
+    uint64_t drawCount,
+    uint64_t validatedDrawCount,
+    uint64_t filteredStateCount)
+{
+    Util::AtomicAdd64(&m_drawCount, drawCount);
+    Util::AtomicAdd64(&m_validatedDrawCount, validatedDrawCount);
+    Util::AtomicAdd64(&m_filteredStateCount, filteredStateCount);
+}
+
+// =====================================================================================================================
+// Appends a JSON snapshot of the device-wide descriptor pool memory stats to a file.
+void Device::WriteDescriptorPoolStats(
+    const char* pFilePath)
+{
+    utils::JsonOutputStream stream(pFilePath);
+    Util::JsonWriter        writer(&stream);
+
+    writer.BeginMap(false);
+    writer.KeyAndValue("timestampMs",
+                       static_cast<uint64_t>((Util::GetPerfCpuTime() * 1000) / Util::GetPerfFrequency()));
+    writer.KeyAndBeginMap("device", false);
+    m_descriptorPoolStats.Write(&writer);
+    writer.EndMap();
+    writer.EndMap();
+}
+
+// =====================================================================================================================
+// Appends a JSON snapshot of the GPU time table to a file.
+void Device::WriteGpuTimingTable(
+    const char* pFilePath)
+{
+    if (m_pGpuTimingTable != nullptr)
+    {
+        utils::JsonOutputStream stream(pFilePath);
+        Util::JsonWriter        writer(&stream);
+
+        writer.BeginMap(false);
+        writer.KeyAndValue("timestampMs",
+                           static_cast<uint64_t>((Util::GetPerfCpuTime() * 1000) / Util::GetPerfFrequency()));
+        writer.KeyAndBeginMap("gpuTiming", false);
+        m_pGpuTimingTable->Write(&writer);
+        writer.EndMap();
+        writer.EndMap();
+    }
+}
+
+// =====================================================================================================================
+// Appends a JSON snapshot of the per-pipeline statistics to a file.
+void Device::WritePipelineStatsProfile(
+    const char* pFilePath)
+{
+    if (m_pPipelineStatsProfile != nullptr)
+    {
+        utils::JsonOutputStream stream(pFilePath);
+        Util::JsonWriter        writer(&stream);
+
+        writer.BeginMap(false);
+        writer.KeyAndValue("timestampMs",
+                           static_cast<uint64_t>((Util::GetPerfCpuTime() * 1000) / Util::GetPerfFrequency()));
+        writer.KeyAndBeginMap("pipelineStats", false);
+        m_pPipelineStatsProfile->Write(&writer);
+        writer.EndMap();
+        writer.EndMap();
+    }
+}
+
+// =====================================================================================================================
+// Appends a JSON snapshot of the GPU cost per barrier call site to a file.
+void Device::WriteBarrierProfile(
+    const char* pFilePath)
+{
+    if (m_pBarrierProfile != nullptr)
+    {
+        utils::JsonOutputStream stream(pFilePath);
+        Util::JsonWriter        writer(&stream);
+
+        writer.BeginMap(false);
+        writer.KeyAndValue("timestampMs",
+                           static_cast<uint64_t>((Util::GetPerfCpuTime() * 1000) / Util::GetPerfFrequency()));
+        writer.KeyAndBeginMap("barrierProfile", false);
+        m_pBarrierProfile->Write(&writer);
+        writer.EndMap();
+        writer.EndMap();
+    }
+}
+
+// =====================================================================================================================
+// Appends a JSON snapshot of the driver performance counters to a file.
+void Device::WritePerfCounters(
+    const char* pFilePath)
+{
+    utils::JsonOutputStream stream(pFilePath);
+    Util::JsonWriter        writer(&stream);
+
+    writer.BeginMap(false);
+    writer.KeyAndValue("timestampMs",
+                       static_cast<uint64_t>((Util::GetPerfCpuTime() * 1000) / Util::GetPerfFrequency()));
+    writer.KeyAndBeginMap("perfCounters", false);
+    m_perfCounters.Write(&writer);
+    writer.EndMap();
+    writer.EndMap();
+}
+
 // =====================================================================================================================
 // Destroy Vulkan device. Destroy underlying PAL device, call destructor and free memory.
 VkResult Device::Destroy(const VkAllocationCallbacks* pAllocator)
@@ -1954,6 +2343,15 @@ VkResult Device::Destroy(const VkAllocationCallbacks* pAllocator)
         VkInstance()->FreeMem(m_pSqttMgr);
     }
 
+    if (m_pApiProfileLayer != nullptr)
+    {
+        m_pApiProfileLayer->WriteReport(m_settings.apiProfileFile);
+
+        Util::Destructor(m_pApiProfileLayer);
+
+        VkInstance()->FreeMem(m_pApiProfileLayer);
+    }
+
     if (m_pBarrierFilterLayer != nullptr)
     {
         Util::Destructor(m_pBarrierFilterLayer);
@@ -1975,6 +2373,74 @@ VkResult Device::Destroy(const VkAllocationCallbacks* pAllocator)
         VkInstance()->FreeMem(m_pAsyncLayer);
     }
 
+    // All command buffers are gone by now, and they hand in their last measurements when destroyed.
+    if (m_pGpuTimingTable != nullptr)
+    {
+        WriteGpuTimingTable(m_settings.gpuTimingTableFile);
+
+        m_pGpuTimingTable->Destroy();
+        m_pGpuTimingTable = nullptr;
+    }
+
+    if (m_pPipelineStatsProfile != nullptr)
+    {
+        WritePipelineStatsProfile(m_settings.pipelineStatsProfileFile);
+
+        m_pPipelineStatsProfile->Destroy();
+        m_pPipelineStatsProfile = nullptr;
+    }
+
+    m_pipelineAutotuner.Destroy();
+
+    if (m_pBarrierProfile != nullptr)
+    {
+        WriteBarrierProfile(m_settings.barrierProfileFile);
+
+        m_pBarrierProfile->Destroy();
+        m_pBarrierProfile = nullptr;
+    }
+
+    if (m_drawCount > 0)
+    {
+        const uint64_t fastPathDraws = m_drawCount - m_validatedDrawCount;
+
+        AmdvlkLog(m_settings.logTagIdMask,
+                  DrawValidation,
+                  "draws: %llu, fast path: %llu (%.1f%%), validated: %llu",
+                  m_drawCount,
+                  fastPathDraws,
+                  (100.0 * fastPathDraws) / m_drawCount,
+                  m_validatedDrawCount);
+    }
+
+    if (m_filteredStateCount > 0)
+    {
+        AmdvlkLog(m_settings.logTagIdMask,
+                  DrawValidation,
+                  "redundant dynamic state calls filtered: %llu",
+                  m_filteredStateCount);
+    }
+
+    if (m_settings.dumpDescriptorPoolStats)
+    {
+        WriteDescriptorPoolStats(m_settings.descriptorPoolStatsFile);
+    }
+
+    if (m_settings.dumpInternalMemSlabStats)
+    {
+        m_internalMemMgr.WriteSlabStats(m_settings.internalMemSlabStatsFile);
+    }
+
+    DestroyPooledFences();
+
+    m_memoryBlockCache.Destroy();
+
+    m_externalMemoryCache.Destroy();
+
+    m_transientAliasPlanner.Destroy();
+
+    m_tempMemArenaPool.Destroy();
+
     for (uint32_t i = 0; i < Queue::MaxQueueFamilies; ++i)
     {
         for (uint32_t j = 0; (j < Queue::MaxQueuesPerFamily) && (m_pQueues[i][j] != nullptr); ++j)
@@ -1996,45 +2462,57 @@ VkResult Device::Destroy(const VkAllocationCallbacks* pAllocator)
         m_renderStateCache.DestroyMsaaState(&m_pBltMsaaState[i][0], nullptr);
     }
 
-    DestroyInternalPipelines();
+    TeardownCaches();
 
-    for (uint32_t deviceIdx = 0; deviceIdx < NumPalDevices(); deviceIdx++)
+    if (m_pCompileThreadPool != nullptr)
     {
-        if (m_perGpu[deviceIdx].pSharedPalCmdAllocator != nullptr)
-        {
-            m_perGpu[deviceIdx].pSharedPalCmdAllocator->Destroy();
-        }
+        m_pCompileThreadPool->Destroy();
+        m_pCompileThreadPool = nullptr;
     }
 
-    VkInstance()->FreeMem(m_perGpu[DefaultDeviceIndex].pSharedPalCmdAllocator);
-
     for (uint32_t deviceIdx = 0; deviceIdx < NumPalDevices(); deviceIdx++)
     {
-        if (m_perGpu[deviceIdx].pSwCompositingMemory != nullptr)
+        for (uint32_t slot = 0; slot < m_sharedCmdAllocatorCount; slot++)
         {
-            if (m_perGpu[deviceIdx].pSwCompositingSemaphore != nullptr)
+            if (m_perGpu[deviceIdx].pSharedPalCmdAllocators[slot] != nullptr)
             {
-                m_perGpu[deviceIdx].pSwCompositingSemaphore->Destroy();
+                m_perGpu[deviceIdx].pSharedPalCmdAllocators[slot]->Destroy();
             }
+        }
+    }
 
-            if (m_perGpu[deviceIdx].pSwCompositingQueue != nullptr)
-            {
-                m_perGpu[deviceIdx].pSwCompositingQueue->Destroy();
-            }
+    VkInstance()->FreeMem(m_perGpu[DefaultDeviceIndex].pSharedPalCmdAllocators[0]);
 
-            if (m_perGpu[deviceIdx].pSwCompositingCmdBuffer != nullptr)
-            {
-                m_perGpu[deviceIdx].pSwCompositingCmdBuffer->Destroy();
-            }
+    for (uint32_t deviceIdx = 0; deviceIdx < NumPalDevices(); deviceIdx++)
+    {
+        DestroySwCompositing(deviceIdx);
+    }
 
-            VkInstance()->FreeMem(m_perGpu[deviceIdx].pSwCompositingMemory);
-        }
+    DestroyBorderColorPalette();
 
+    m_memoryEventLog.Destroy();
+
+    if (m_perfCounters.IsEnabled())
+    {
+        WritePerfCounters(m_settings.perfCountersFile);
     }
 
-    DestroyBorderColorPalette();
+    m_perfCounters.Destroy();
+
+    m_gpuAddressIndex.Destroy();
+
+    m_pipelineCompileEventLog.Destroy();
+
+    m_queueTimingLog.Destroy();
 
-    m_renderStateCache.Destroy();
+    m_debugNameTable.Destroy();
+
+    // Objects the application leaked are released along with the slabs
+    if (m_pApiObjectPool != nullptr)
+    {
+        m_pApiObjectPool->Destroy();
+        m_pApiObjectPool = nullptr;
+    }
 
     Util::Destructor(this);
 
@@ -2223,6 +2701,8 @@ VkResult Device::CreateInternalComputePipeline(
 // =====================================================================================================================
 VkResult Device::CreateInternalPipelines()
 {
+    StartupPhase startupPhase("Device::CreateInternalPipelines");
+
     VkResult result = VK_SUCCESS;
 
     const bool useStridedShader = UseStridedCopyQueryResults();
@@ -2284,6 +2764,25 @@ VkResult Device::CreateInternalPipelines()
     return result;
 }
 
+// =====================================================================================================================
+// Returns the compute pipeline which copies timestamp query pool results to a buffer, creating the internal pipelines
+// if this is their first use.  Returns nullptr if they could not be created.  Thread-safe.
+const Device::InternalPipeline* Device::GetTimestampQueryCopyPipeline()
+{
+    if (m_internalPipelinesReady.load(std::memory_order_acquire) == false)
+    {
+        Util::MutexAuto lock(&m_internalPipelineLock);
+
+        if ((m_internalPipelinesReady.load(std::memory_order_relaxed) == false) &&
+            (CreateInternalPipelines() == VK_SUCCESS))
+        {
+            m_internalPipelinesReady.store(true, std::memory_order_release);
+        }
+    }
+
+    return m_internalPipelinesReady.load(std::memory_order_acquire) ? &m_timestampQueryCopyPipeline : nullptr;
+}
+
 // =====================================================================================================================
 void Device::DestroyInternalPipeline(
     InternalPipeline* pPipeline)
@@ -2309,19 +2808,63 @@ void Device::DestroyInternalPipelines()
 }
 
 // =====================================================================================================================
-// Wait for device idle. Punts to PAL device.
-VkResult Device::WaitIdle(void)
+// Runs one of the independent teardown steps of TeardownCaches().  The first tasks flush the pipeline binary cache of
+// one device each.
+void Device::TeardownTask(
+    void*    pPayload,
+    uint32_t taskIndex)
 {
-    VkResult result = VK_SUCCESS;
+    Device* pDevice = static_cast<Device*>(pPayload);
 
-    for (uint32_t i = 0; (i < Queue::MaxQueueFamilies) && (result == VK_SUCCESS); ++i)
+    if (taskIndex < pDevice->NumPalDevices())
     {
-        for (uint32_t j = 0;
-            (j < Queue::MaxQueuesPerFamily) && (m_pQueues[i][j] != nullptr) && (result == VK_SUCCESS);
-            ++j)
-        {
-            result = (*m_pQueues[i][j])->WaitIdle();
-        }
+        pDevice->GetCompiler(taskIndex)->FlushPipelineBinaryCache();
+    }
+    else if (taskIndex == pDevice->NumPalDevices())
+    {
+        pDevice->DestroyInternalPipelines();
+    }
+    else
+    {
+        pDevice->m_renderStateCache.Destroy();
+    }
+}
+
+// =====================================================================================================================
+// Flushes the pipeline binary caches and destroys the internal pipelines and the cached render states.  None of these
+// share any data, so they can be torn down in parallel on the compile workers.  Nothing may use the render state cache
+// afterwards.
+void Device::TeardownCaches()
+{
+    const uint32_t taskCount = NumPalDevices() + 2;
+
+    if ((m_pCompileThreadPool != nullptr) && m_settings.parallelDeviceTeardown)
+    {
+        m_pCompileThreadPool->Execute(TeardownTask, this, taskCount);
+    }
+    else
+    {
+        for (uint32_t taskIndex = 0; taskIndex < taskCount; taskIndex++)
+        {
+            TeardownTask(this, taskIndex);
+        }
+    }
+}
+
+// =====================================================================================================================
+// Wait for device idle. Punts to PAL device.
+VkResult Device::WaitIdle(void)
+{
+    VkResult result = VK_SUCCESS;
+
+    for (uint32_t i = 0; (i < Queue::MaxQueueFamilies) && (result == VK_SUCCESS); ++i)
+    {
+        for (uint32_t j = 0;
+            (j < Queue::MaxQueuesPerFamily) && (m_pQueues[i][j] != nullptr) && (result == VK_SUCCESS);
+            ++j)
+        {
+            result = (*m_pQueues[i][j])->WaitIdle();
+        }
     }
 
     return result;
@@ -2426,6 +2969,33 @@ VkResult Device::WaitForFences(
     VkBool32       waitAll,
     uint64_t       timeout)
 {
+    // Fences which were already seen signaled need no kernel call; with a single fence, waitAll doesn't matter.
+    uint32_t knownSignaledCount = 0;
+
+    for (uint32_t i = 0; i < fenceCount; ++i)
+    {
+        if (Fence::ObjectFromHandle(pFences[i])->IsKnownSignaled())
+        {
+            knownSignaledCount++;
+        }
+    }
+
+    if ((knownSignaledCount == fenceCount) || ((waitAll == VK_FALSE) && (knownSignaledCount > 0)))
+    {
+        return VK_SUCCESS;
+    }
+
+    // Fences of deferred submissions must reach PAL before they can be waited on.
+    for (uint32_t i = 0; i < fenceCount; ++i)
+    {
+        const VkResult result = Fence::ObjectFromHandle(pFences[i])->WaitForPendingSubmission();
+
+        if (result != VK_SUCCESS)
+        {
+            return result;
+        }
+    }
+
     Pal::Result palResult = Pal::Result::Success;
 
     Pal::IFence** ppPalFences = static_cast<Pal::IFence**>(VK_ALLOC_A(sizeof(Pal::IFence*) * fenceCount));
@@ -2471,6 +3041,15 @@ VkResult Device::WaitForFences(
             }
         }
     }
+
+    if ((palResult == Pal::Result::Success) && ((waitAll != VK_FALSE) || (fenceCount == 1)))
+    {
+        for (uint32_t i = 0; i < fenceCount; ++i)
+        {
+            Fence::ObjectFromHandle(pFences[i])->SetKnownSignaled(true);
+        }
+    }
+
     return PalToVkResult(palResult);
 }
 
@@ -2487,6 +3066,9 @@ VkResult Device::ResetFences(
     // Clear the wait masks for each fence
     for (uint32_t i = 0; i < fenceCount; ++i)
     {
+        Fence::ObjectFromHandle(pFences[i])->WaitForPendingSubmission();
+        Fence::ObjectFromHandle(pFences[i])->ClearPendingSubmission();
+        Fence::ObjectFromHandle(pFences[i])->SetKnownSignaled(false);
         Fence::ObjectFromHandle(pFences[i])->ClearActiveDeviceMask();
         Fence::ObjectFromHandle(pFences[i])->RestoreFence(this);
     }
@@ -2637,18 +3219,76 @@ VkResult Device::CreateImageView(
 }
 
 // =====================================================================================================================
-VkResult Device::CreateGraphicsPipelines(
-    VkPipelineCache                             pipelineCache,
-    uint32_t                                    count,
-    const VkGraphicsPipelineCreateInfo*         pCreateInfos,
-    const VkAllocationCallbacks*                pAllocator,
-    VkPipeline*                                 pPipelines)
+// State shared by the tasks of a batched pipeline create call that is run on the compile thread pool.
+template<typename CreateInfoType>
+struct PipelineBatch
 {
-    VK_ASSERT(pCreateInfos != nullptr);
-    VK_ASSERT(pPipelines != nullptr);
+    Device*                      pDevice;
+    PipelineCache*               pPipelineCache;
+    const CreateInfoType*        pCreateInfos;
+    const VkAllocationCallbacks* pAllocator;
+    VkPipeline*                  pPipelines;
+    VkResult*                    pResults;
+};
+
+// =====================================================================================================================
+// Compiles a single entry of a batched pipeline create call.  Each task only writes its own slot of pPipelines and
+// pResults, and its own pipeline creation feedback structure, so no further synchronization is required.
+template<typename PipelineType, typename CreateInfoType>
+static void CreatePipelineTask(
+    void*    pPayload,
+    uint32_t taskIndex)
+{
+    const PipelineBatch<CreateInfoType>* pBatch = static_cast<const PipelineBatch<CreateInfoType>*>(pPayload);
+
+    pBatch->pResults[taskIndex] = PipelineType::Create(
+        pBatch->pDevice,
+        pBatch->pPipelineCache,
+        &pBatch->pCreateInfos[taskIndex],
+        pBatch->pAllocator,
+        &pBatch->pPipelines[taskIndex]);
+}
+
+// =====================================================================================================================
+// Looks up the cached binaries of a whole batch in one pass before its entries are compiled.  Only graphics pipelines
+// can be found by API hash, so this is a no-op for compute pipelines.
+static void PrefetchPipelineBinaries(
+    Device*                             pDevice,
+    PipelineCache*                      pPipelineCache,
+    uint32_t                            count,
+    const VkGraphicsPipelineCreateInfo* pCreateInfos)
+{
+    GraphicsPipeline::PrefetchBinaries(pDevice, pPipelineCache, count, pCreateInfos);
+}
+
+// =====================================================================================================================
+static void PrefetchPipelineBinaries(
+    Device*                            pDevice,
+    PipelineCache*                     pPipelineCache,
+    uint32_t                           count,
+    const VkComputePipelineCreateInfo* pCreateInfos)
+{
+    VK_IGNORE(pDevice);
+    VK_IGNORE(pPipelineCache);
+    VK_IGNORE(count);
+    VK_IGNORE(pCreateInfos);
+}
 
+// =====================================================================================================================
+// Common implementation of CreateGraphicsPipelines and CreateComputePipelines.  Batches are compiled concurrently on
+// the device's compile thread pool when one is available; results are then resolved in order so that the returned
+// VkResult and VK_PIPELINE_CREATE_EARLY_RETURN_ON_FAILURE_BIT_EXT behave exactly like the serial path.
+template<typename PipelineType, typename CreateInfoType>
+static VkResult CreatePipelines(
+    Device*                      pDevice,
+    CompileThreadPool*           pThreadPool,
+    PipelineCache*               pPipelineCache,
+    uint32_t                     count,
+    const CreateInfoType*        pCreateInfos,
+    const VkAllocationCallbacks* pAllocator,
+    VkPipeline*                  pPipelines)
+{
     VkResult finalResult = VK_SUCCESS;
-    PipelineCache* pPipelineCache = PipelineCache::ObjectFromHandle(pipelineCache);
 
     // Initialize output array to VK_NULL_HANDLE
     for (uint32_t i = 0; i < count; ++i)
@@ -2656,28 +3296,81 @@ VkResult Device::CreateGraphicsPipelines(
         pPipelines[i] = VK_NULL_HANDLE;
     }
 
-    for (uint32_t i = 0; i < count; ++i)
+    // Application-provided allocation callbacks may only be invoked from the calling thread, so the pipelines are only
+    // created on the compile pool if neither the create nor the instance uses them.
+    const bool useThreadPool = (pThreadPool != nullptr)                                   &&
+                               (count > 1)                                                &&
+                               (pAllocator == pDevice->VkInstance()->GetAllocCallbacks()) &&
+                               pDevice->VkInstance()->UsesDriverAllocCallbacks();
+
+    Util::AutoBuffer<VkResult, 16, PalAllocator> results(
+        useThreadPool ? count : 0,
+        pDevice->VkInstance()->Allocator());
+
+    if (useThreadPool && (results.Capacity() >= count))
     {
-        const VkGraphicsPipelineCreateInfo* pCreateInfo = &pCreateInfos[i];
+        PipelineBatch<CreateInfoType> batch = {};
+        batch.pDevice        = pDevice;
+        batch.pPipelineCache = pPipelineCache;
+        batch.pCreateInfos   = pCreateInfos;
+        batch.pAllocator     = pAllocator;
+        batch.pPipelines     = pPipelines;
+        batch.pResults       = &results[0];
 
-        VkResult result = GraphicsPipeline::Create(
-            this,
-            pPipelineCache,
-            pCreateInfo,
-            pAllocator,
-            &pPipelines[i]);
+        PrefetchPipelineBinaries(pDevice, pPipelineCache, count, pCreateInfos);
 
-        if (result != VK_SUCCESS)
+        pThreadPool->Execute(CreatePipelineTask<PipelineType, CreateInfoType>, &batch, count);
+
+        bool earlyReturn = false;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (earlyReturn)
+            {
+                // Entries after an early-return failure must come back as VK_NULL_HANDLE.
+                if (pPipelines[i] != VK_NULL_HANDLE)
+                {
+                    Pipeline::BaseObjectFromHandle(pPipelines[i])->Destroy(pDevice, pAllocator);
+                    pPipelines[i] = VK_NULL_HANDLE;
+                }
+            }
+            else if (results[i] != VK_SUCCESS)
+            {
+                // In case of failure, VK_NULL_HANDLE must be set
+                VK_ASSERT(pPipelines[i] == VK_NULL_HANDLE);
+
+                // Capture the first failure result and save it to be returned
+                finalResult = (finalResult != VK_SUCCESS) ? finalResult : results[i];
+
+                earlyReturn = ((pCreateInfos[i].flags & VK_PIPELINE_CREATE_EARLY_RETURN_ON_FAILURE_BIT_EXT) != 0);
+            }
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < count; ++i)
         {
-            // In case of failure, VK_NULL_HANDLE must be set
-            VK_ASSERT(pPipelines[i] == VK_NULL_HANDLE);
+            const CreateInfoType* pCreateInfo = &pCreateInfos[i];
 
-            // Capture the first failure result and save it to be returned
-            finalResult = (finalResult != VK_SUCCESS) ? finalResult : result;
+            VkResult result = PipelineType::Create(
+                pDevice,
+                pPipelineCache,
+                pCreateInfo,
+                pAllocator,
+                &pPipelines[i]);
 
-            if (pCreateInfo->flags & VK_PIPELINE_CREATE_EARLY_RETURN_ON_FAILURE_BIT_EXT)
+            if (result != VK_SUCCESS)
             {
-                break;
+                // In case of failure, VK_NULL_HANDLE must be set
+                VK_ASSERT(pPipelines[i] == VK_NULL_HANDLE);
+
+                // Capture the first failure result and save it to be returned
+                finalResult = (finalResult != VK_SUCCESS) ? finalResult : result;
+
+                if (pCreateInfo->flags & VK_PIPELINE_CREATE_EARLY_RETURN_ON_FAILURE_BIT_EXT)
+                {
+                    break;
+                }
             }
         }
     }
@@ -2686,52 +3379,45 @@ VkResult Device::CreateGraphicsPipelines(
 }
 
 // =====================================================================================================================
-VkResult Device::CreateComputePipelines(
+VkResult Device::CreateGraphicsPipelines(
     VkPipelineCache                             pipelineCache,
     uint32_t                                    count,
-    const VkComputePipelineCreateInfo*          pCreateInfos,
+    const VkGraphicsPipelineCreateInfo*         pCreateInfos,
     const VkAllocationCallbacks*                pAllocator,
     VkPipeline*                                 pPipelines)
 {
     VK_ASSERT(pCreateInfos != nullptr);
     VK_ASSERT(pPipelines != nullptr);
 
-    VkResult finalResult = VK_SUCCESS;
-    PipelineCache* pPipelineCache = PipelineCache::ObjectFromHandle(pipelineCache);
-
-    // Initialize output array to VK_NULL_HANDLE
-    for (uint32_t i = 0; i < count; ++i)
-    {
-        pPipelines[i] = VK_NULL_HANDLE;
-    }
-
-    for (uint32_t i = 0; i < count; ++i)
-    {
-        const VkComputePipelineCreateInfo* pCreateInfo = &pCreateInfos[i];
-
-        VkResult result = ComputePipeline::Create(
-            this,
-            pPipelineCache,
-            pCreateInfo,
-            pAllocator,
-            &pPipelines[i]);
-
-        if (result != VK_SUCCESS)
-        {
-            // In case of failure, VK_NULL_HANDLE must be set
-            VK_ASSERT(pPipelines[i] == VK_NULL_HANDLE);
-
-            // Capture the first failure result and save it to be returned
-            finalResult = (finalResult != VK_SUCCESS) ? finalResult : result;
+    return CreatePipelines<GraphicsPipeline>(
+        this,
+        m_pCompileThreadPool,
+        PipelineCache::ObjectFromHandle(pipelineCache),
+        count,
+        pCreateInfos,
+        pAllocator,
+        pPipelines);
+}
 
-            if (pCreateInfo->flags & VK_PIPELINE_CREATE_EARLY_RETURN_ON_FAILURE_BIT_EXT)
-            {
-                break;
-            }
-        }
-    }
+// =====================================================================================================================
+VkResult Device::CreateComputePipelines(
+    VkPipelineCache                             pipelineCache,
+    uint32_t                                    count,
+    const VkComputePipelineCreateInfo*          pCreateInfos,
+    const VkAllocationCallbacks*                pAllocator,
+    VkPipeline*                                 pPipelines)
+{
+    VK_ASSERT(pCreateInfos != nullptr);
+    VK_ASSERT(pPipelines != nullptr);
 
-    return finalResult;
+    return CreatePipelines<ComputePipeline>(
+        this,
+        m_pCompileThreadPool,
+        PipelineCache::ObjectFromHandle(pipelineCache),
+        count,
+        pCreateInfos,
+        pAllocator,
+        pPipelines);
 }
 
 // =====================================================================================================================
@@ -2953,6 +3639,24 @@ VkResult Device::GetCalibratedTimestamps(
     const VkCalibratedTimestampInfoEXT* pTimestampInfos,
     uint64_t*                           pTimestamps,
     uint64_t*                           pMaxDeviation)
+{
+    VkResult result = VK_SUCCESS;
+
+    if (m_timestampCalibrator.Predict(timestampCount, pTimestampInfos, pTimestamps, pMaxDeviation) == false)
+    {
+        result = GetPalCalibratedTimestamps(timestampCount, pTimestampInfos, pTimestamps, pMaxDeviation);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Queries calibrated timestamps from PAL and feeds them to the timestamp calibrator.
+VkResult Device::GetPalCalibratedTimestamps(
+    uint32_t                            timestampCount,
+    const VkCalibratedTimestampInfoEXT* pTimestampInfos,
+    uint64_t*                           pTimestamps,
+    uint64_t*                           pMaxDeviation)
 {
     Pal::CalibratedTimestamps calibratedTimestamps = {};
 
@@ -2961,6 +3665,8 @@ VkResult Device::GetCalibratedTimestamps(
 
     if (result == VK_SUCCESS)
     {
+        m_timestampCalibrator.AddSample(calibratedTimestamps);
+
         for (uint32_t i = 0; i < timestampCount; ++i)
         {
             switch (pTimestampInfos[i].timeDomain)
@@ -3046,22 +3752,61 @@ VkResult Device::WaitSemaphores(
     Pal::Result palResult = Pal::Result::Success;
     uint32_t flags = 0;
 
+    const bool waitAny = (pWaitInfo->flags == VK_SEMAPHORE_WAIT_ANY_BIT);
+
     Pal::IQueueSemaphore** ppPalSemaphores = static_cast<Pal::IQueueSemaphore**>(VK_ALLOC_A(
                 sizeof(Pal::IQueueSemaphore*) * pWaitInfo->semaphoreCount));
+    Semaphore** ppSemaphores = static_cast<Semaphore**>(VK_ALLOC_A(sizeof(Semaphore*) * pWaitInfo->semaphoreCount));
+    uint64_t*   pPalValues   = static_cast<uint64_t*>(VK_ALLOC_A(sizeof(uint64_t) * pWaitInfo->semaphoreCount));
+    uint32_t    palWaitCount = 0;
 
     for (uint32_t i = 0; i < pWaitInfo->semaphoreCount; ++i)
     {
         Semaphore* currentSemaphore = Semaphore::ObjectFromHandle(pWaitInfo->pSemaphores[i]);
-        ppPalSemaphores[i] = currentSemaphore->PalSemaphore(DefaultDeviceIndex);
+
+        // Values which the semaphore is already known to have reached need no kernel round trip.
+        if (currentSemaphore->IsKnownToHaveReached(pWaitInfo->pValues[i]))
+        {
+            if (waitAny)
+            {
+                return VK_SUCCESS;
+            }
+
+            continue;
+        }
+
+        // A signal still queued on a submit thread can't have happened yet, so only blocking waits need it in PAL.
+        if (timeout > 0)
+        {
+            currentSemaphore->WaitForPendingSignal();
+        }
+
+        ppPalSemaphores[palWaitCount] = currentSemaphore->PalSemaphore(DefaultDeviceIndex);
+        ppSemaphores[palWaitCount]    = currentSemaphore;
+        pPalValues[palWaitCount]      = pWaitInfo->pValues[i];
+        palWaitCount++;
+
         currentSemaphore->RestoreSemaphore();
     }
 
-    if (pWaitInfo->flags == VK_SEMAPHORE_WAIT_ANY_BIT)
+    if (palWaitCount > 0)
     {
-        flags |= Pal::HostWaitFlags::HostWaitAny;
+        if (waitAny)
+        {
+            flags |= Pal::HostWaitFlags::HostWaitAny;
+        }
+        palResult = PalDevice(DefaultDeviceIndex)->WaitForSemaphores(palWaitCount, ppPalSemaphores,
+                pPalValues, flags, timeout);
+
+        // After a successful wait-all every semaphore has reached its value; a wait-any doesn't tell which one did.
+        if ((palResult == Pal::Result::Success) && (waitAny == false))
+        {
+            for (uint32_t i = 0; i < palWaitCount; ++i)
+            {
+                ppSemaphores[i]->UpdateKnownCompletedValue(pPalValues[i]);
+            }
+        }
     }
-    palResult = PalDevice(DefaultDeviceIndex)->WaitForSemaphores(pWaitInfo->semaphoreCount, ppPalSemaphores,
-            pWaitInfo->pValues, flags, timeout);
 
     return PalToVkResult(palResult);
 }
@@ -3115,12 +3860,204 @@ void Device::RemoveMemReference(
     Pal::IDevice*    pPalDevice,
     Pal::IGpuMemory* pPalMemory)
 {
+    // Memory which is freed before any submission saw it never has to reach PAL's residency list at all.
+    if (m_pendingMemRefCount > 0)
+    {
+        Util::MutexAuto lock(&m_pendingMemRefLock);
+
+        for (uint32_t i = 0; i < m_pendingMemRefCount; ++i)
+        {
+            if ((m_pendingMemRefs[i].pPalMemory == pPalMemory) && (m_pendingMemRefs[i].pPalDevice == pPalDevice))
+            {
+                m_pendingMemRefs[i] = m_pendingMemRefs[m_pendingMemRefCount - 1];
+                m_pendingMemRefCount--;
+
+                return;
+            }
+        }
+    }
+
     pPalDevice->RemoveGpuMemoryReferences(1, &pPalMemory, nullptr);
 }
 
+// =====================================================================================================================
+// Adds an item to the residency list before the next submission.  Used for application memory, which the GPU can only
+// access through a queue submission.  Without BatchMemReferences the reference is added right away.
+Pal::Result Device::AddDeferredMemReference(
+    Pal::IDevice*    pPalDevice,
+    Pal::IGpuMemory* pPalMemory)
+{
+    if (m_settings.batchMemReferences == false)
+    {
+        return AddMemReference(pPalDevice, pPalMemory);
+    }
+
+    Util::MutexAuto lock(&m_pendingMemRefLock);
+
+    Pal::Result palResult = Pal::Result::Success;
+
+    if (m_pendingMemRefCount == MaxPendingMemReferences)
+    {
+        palResult = FlushMemReferencesLocked();
+    }
+
+    if (palResult == Pal::Result::Success)
+    {
+        m_pendingMemRefs[m_pendingMemRefCount].pPalDevice = pPalDevice;
+        m_pendingMemRefs[m_pendingMemRefCount].pPalMemory = pPalMemory;
+        m_pendingMemRefCount++;
+    }
+
+    return palResult;
+}
+
+// =====================================================================================================================
+// Hands all deferred residency adds to PAL, one call per PAL device.  Called before every submission and sparse bind.
+Pal::Result Device::FlushMemReferences()
+{
+    Pal::Result palResult = Pal::Result::Success;
+
+    if (m_pendingMemRefCount > 0)
+    {
+        Util::MutexAuto lock(&m_pendingMemRefLock);
+
+        palResult = FlushMemReferencesLocked();
+    }
+
+    return palResult;
+}
+
+// =====================================================================================================================
+// Must be called with m_pendingMemRefLock held.
+Pal::Result Device::FlushMemReferencesLocked()
+{
+    Pal::Result       palResult = Pal::Result::Success;
+    Pal::GpuMemoryRef memRefs[MaxPendingMemReferences];
+
+    const Pal::GpuMemoryRefFlags memoryReferenceFlags = static_cast<Pal::GpuMemoryRefFlags>(0);
+
+    for (uint32_t deviceIdx = 0; (deviceIdx < NumPalDevices()) && (palResult == Pal::Result::Success); ++deviceIdx)
+    {
+        Pal::IDevice* pPalDevice = PalDevice(deviceIdx);
+        uint32_t      refCount   = 0;
+
+        for (uint32_t i = 0; i < m_pendingMemRefCount; ++i)
+        {
+            if (m_pendingMemRefs[i].pPalDevice == pPalDevice)
+            {
+                memRefs[refCount]                = {};
+                memRefs[refCount].pGpuMemory     = m_pendingMemRefs[i].pPalMemory;
+                memRefs[refCount].flags.readOnly = false;
+                refCount++;
+            }
+        }
+
+        if (refCount > 0)
+        {
+            palResult = pPalDevice->AddGpuMemoryReferences(refCount, memRefs, nullptr, memoryReferenceFlags);
+        }
+    }
+
+    m_pendingMemRefCount = 0;
+
+    return palResult;
+}
+
+// =====================================================================================================================
+// Returns a recycled fence whose PAL fences are unsignaled, or nullptr if the pool is empty.  The caller constructs the
+// Fence object again in the returned memory.
+Fence* Device::AcquirePooledFence()
+{
+    Util::MutexAuto lock(&m_fencePoolLock);
+
+    Fence* pFence = nullptr;
+
+    if ((m_cleanFenceCount == 0) && (m_pooledFenceCount > 0))
+    {
+        // Reset every fence released since the last refill with one PAL call per device.
+        Pal::IFence* pPalFences[MaxPooledFences];
+        Pal::Result  palResult = Pal::Result::Success;
+
+        for (uint32_t deviceIdx = 0; (deviceIdx < NumPalDevices()) && (palResult == Pal::Result::Success); ++deviceIdx)
+        {
+            for (uint32_t i = 0; i < m_pooledFenceCount; ++i)
+            {
+                pPalFences[i] = m_pPooledFences[i]->PalFence(deviceIdx);
+            }
+
+            palResult = PalDevice(deviceIdx)->ResetFences(m_pooledFenceCount, pPalFences);
+        }
+
+        if (palResult == Pal::Result::Success)
+        {
+            m_cleanFenceCount = m_pooledFenceCount;
+        }
+    }
+
+    if (m_cleanFenceCount > 0)
+    {
+        pFence = m_pPooledFences[m_cleanFenceCount - 1];
+
+        m_pPooledFences[m_cleanFenceCount - 1] = m_pPooledFences[m_pooledFenceCount - 1];
+        m_cleanFenceCount--;
+        m_pooledFenceCount--;
+    }
+
+    return pFence;
+}
+
+// =====================================================================================================================
+// Keeps a destroyed fence, including its PAL fences, for reuse.  Returns false if the pool is full, in which case the
+// caller frees the fence as usual.
+bool Device::ReleasePooledFence(
+    Fence* pFence)
+{
+    // The next owner must start without the private data of this one.
+    if (m_privateDataSize > 0)
+    {
+        void* pPrivateData = Util::VoidPtrDec(pFence, m_privateDataSize);
+
+        FreeUnreservedPrivateData(pPrivateData);
+        memset(pPrivateData, 0, m_privateDataSize);
+    }
+
+    Util::MutexAuto lock(&m_fencePoolLock);
+
+    bool pooled = false;
+
+    if (m_pooledFenceCount < MaxPooledFences)
+    {
+        m_pPooledFences[m_pooledFenceCount++] = pFence;
+        pooled = true;
+    }
+
+    return pooled;
+}
+
+// =====================================================================================================================
+void Device::DestroyPooledFences()
+{
+    const VkAllocationCallbacks* pAllocator = VkInstance()->GetAllocCallbacks();
+
+    for (uint32_t i = 0; i < m_pooledFenceCount; ++i)
+    {
+        for (uint32_t deviceIdx = 0; deviceIdx < NumPalDevices(); ++deviceIdx)
+        {
+            m_pPooledFences[i]->PalFence(deviceIdx)->Destroy();
+        }
+
+        FreePooledApiObject(pAllocator, m_pPooledFences[i]);
+    }
+
+    m_pooledFenceCount = 0;
+    m_cleanFenceCount  = 0;
+}
+
 // =====================================================================================================================
 VkResult Device::CreateBltMsaaStates()
 {
+    StartupPhase startupPhase("Device::CreateBltMsaaStates");
+
     Pal::Result palResult = Pal::Result::Success;
 
     for (uint32_t log2Samples = 0;
@@ -3280,14 +4217,78 @@ void Device::DecreaseAllocatedMemorySize(
     while (deviceGroup.IterateNext());
 }
 
+// =====================================================================================================================
+// Returns the number of SDMA engines the software compositing copies from the given device are split across.
+uint32_t Device::GetSwCompositingEngineCount(
+    uint32_t deviceIdx
+    ) const
+{
+    const Pal::DeviceProperties& palProps = VkPhysicalDevice(deviceIdx)->PalProperties();
+
+    uint32_t engineCount = Util::Min(palProps.engineProperties[Pal::EngineTypeDma].engineCount,
+                                     MaxSwCompositingEngines);
+
+    if (m_settings.swCompositingSdmaEngineCount != 0)
+    {
+        engineCount = Util::Min(engineCount, m_settings.swCompositingSdmaEngineCount);
+    }
+
+    return Util::Max(engineCount, 1u);
+}
+
+// =====================================================================================================================
+// Destroys the software compositing objects of a physical device.
+void Device::DestroySwCompositing(
+    uint32_t deviceIdx)
+{
+    PerGpuInfo* pPerGpu = &m_perGpu[deviceIdx];
+
+    if (pPerGpu->pSwCompositingMemory != nullptr)
+    {
+        for (uint32_t engine = 0; engine < MaxSwCompositingEngines; engine++)
+        {
+            if (pPerGpu->pSwCompositingSemaphore[engine] != nullptr)
+            {
+                pPerGpu->pSwCompositingSemaphore[engine]->Destroy();
+                pPerGpu->pSwCompositingSemaphore[engine] = nullptr;
+            }
+
+            if (pPerGpu->pSwCompositingDoneSemaphore[engine] != nullptr)
+            {
+                pPerGpu->pSwCompositingDoneSemaphore[engine]->Destroy();
+                pPerGpu->pSwCompositingDoneSemaphore[engine] = nullptr;
+            }
+
+            if (pPerGpu->pSwCompositingQueue[engine] != nullptr)
+            {
+                pPerGpu->pSwCompositingQueue[engine]->Destroy();
+                pPerGpu->pSwCompositingQueue[engine] = nullptr;
+            }
+        }
+
+        if (pPerGpu->pSwCompositingCmdBuffer != nullptr)
+        {
+            pPerGpu->pSwCompositingCmdBuffer->Destroy();
+            pPerGpu->pSwCompositingCmdBuffer = nullptr;
+        }
+
+        VkInstance()->FreeMem(pPerGpu->pSwCompositingMemory);
+        pPerGpu->pSwCompositingMemory = nullptr;
+    }
+}
+
 // =====================================================================================================================
 // One time setup for software compositing for this physical device
 VkResult Device::InitSwCompositing(
     uint32_t deviceIdx)
 {
+    StartupPhase startupPhase("Device::InitSwCompositing");
+
     VkResult result = VK_SUCCESS;
 
-    if (m_perGpu[deviceIdx].pSwCompositingMemory == nullptr)
+    PerGpuInfo* pPerGpu = &m_perGpu[deviceIdx];
+
+    if (pPerGpu->pSwCompositingMemory == nullptr)
     {
         Pal::QueueSemaphoreCreateInfo semaphoreCreateInfo = {};
         semaphoreCreateInfo.maxCount = 1;
@@ -3315,43 +4316,67 @@ VkResult Device::InitSwCompositing(
         size_t cmdBufferSize = PalDevice(deviceIdx)->GetCmdBufferSize(cmdBufferCreateInfo, &palResult);
         VK_ASSERT(palResult == Pal::Result::Success);
 
-        m_perGpu[deviceIdx].pSwCompositingMemory = VkInstance()->AllocMem(
-            (palQueueSize + palSemaphoreSize + cmdBufferSize),
+        // The peer copies of a frame are split across the SDMA engines, each with its own queue.  Every engine needs
+        // two semaphores: one for the rendering queue to hand the frame to the transfer queue and one for the
+        // compositing queue to hand it to the present queue.  Sharing one binary semaphore for both hops would let the
+        // present queue consume the rendering queue's signal and start before the copy is done.
+        const uint32_t engineCount = GetSwCompositingEngineCount(deviceIdx);
+        const size_t   engineSize  = palQueueSize + (palSemaphoreSize * 2);
+
+        pPerGpu->pSwCompositingMemory = VkInstance()->AllocMem(
+            (engineSize * engineCount) + cmdBufferSize,
             VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
 
-        if (m_perGpu[deviceIdx].pSwCompositingMemory == nullptr)
+        if (pPerGpu->pSwCompositingMemory == nullptr)
         {
             result = VK_ERROR_OUT_OF_HOST_MEMORY;
         }
         else
         {
-            palResult = PalDevice(deviceIdx)->CreateQueueSemaphore(
-                semaphoreCreateInfo,
-                m_perGpu[deviceIdx].pSwCompositingMemory,
-                &m_perGpu[deviceIdx].pSwCompositingSemaphore);
+            palResult = Pal::Result::Success;
 
-            if (palResult == Pal::Result::Success)
+            for (uint32_t engine = 0; (engine < engineCount) && (palResult == Pal::Result::Success); engine++)
             {
-                palResult = PalDevice(deviceIdx)->CreateQueue(
-                    queueCreateInfo,
-                    Util::VoidPtrInc(m_perGpu[deviceIdx].pSwCompositingMemory, palSemaphoreSize),
-                    &m_perGpu[deviceIdx].pSwCompositingQueue);
+                void* pEngineMemory = Util::VoidPtrInc(pPerGpu->pSwCompositingMemory, engineSize * engine);
+
+                queueCreateInfo.engineIndex = engine;
+
+                palResult = PalDevice(deviceIdx)->CreateQueueSemaphore(
+                    semaphoreCreateInfo,
+                    pEngineMemory,
+                    &pPerGpu->pSwCompositingSemaphore[engine]);
+
+                if (palResult == Pal::Result::Success)
+                {
+                    palResult = PalDevice(deviceIdx)->CreateQueueSemaphore(
+                        semaphoreCreateInfo,
+                        Util::VoidPtrInc(pEngineMemory, palSemaphoreSize),
+                        &pPerGpu->pSwCompositingDoneSemaphore[engine]);
+                }
+
+                if (palResult == Pal::Result::Success)
+                {
+                    palResult = PalDevice(deviceIdx)->CreateQueue(
+                        queueCreateInfo,
+                        Util::VoidPtrInc(pEngineMemory, (palSemaphoreSize * 2)),
+                        &pPerGpu->pSwCompositingQueue[engine]);
+                }
             }
 
             if (palResult == Pal::Result::Success)
             {
                 palResult = PalDevice(deviceIdx)->CreateCmdBuffer(
                     cmdBufferCreateInfo,
-                    Util::VoidPtrInc(m_perGpu[deviceIdx].pSwCompositingMemory, (palSemaphoreSize + palQueueSize)),
-                    &(m_perGpu[deviceIdx].pSwCompositingCmdBuffer));
+                    Util::VoidPtrInc(pPerGpu->pSwCompositingMemory, (engineSize * engineCount)),
+                    &(pPerGpu->pSwCompositingCmdBuffer));
 
                 if (palResult == Pal::Result::Success)
                 {
                     Pal::CmdBufferBuildInfo buildInfo = {};
-                    palResult = m_perGpu[deviceIdx].pSwCompositingCmdBuffer->Begin(buildInfo);
+                    palResult = pPerGpu->pSwCompositingCmdBuffer->Begin(buildInfo);
                     if (palResult == Pal::Result::Success)
                     {
-                        palResult = m_perGpu[deviceIdx].pSwCompositingCmdBuffer->End();
+                        palResult = pPerGpu->pSwCompositingCmdBuffer->End();
                     }
                 }
             }
@@ -3359,24 +4384,7 @@ VkResult Device::InitSwCompositing(
             // Clean up if any error is encountered
             if (palResult != Pal::Result::Success)
             {
-                if (m_perGpu[deviceIdx].pSwCompositingSemaphore != nullptr)
-                {
-                    m_perGpu[deviceIdx].pSwCompositingSemaphore->Destroy();
-                    m_perGpu[deviceIdx].pSwCompositingSemaphore = nullptr;
-                }
-
-                if (m_perGpu[deviceIdx].pSwCompositingQueue != nullptr)
-                {
-                    m_perGpu[deviceIdx].pSwCompositingQueue->Destroy();
-                }
-
-                if (m_perGpu[deviceIdx].pSwCompositingCmdBuffer != nullptr)
-                {
-                    m_perGpu[deviceIdx].pSwCompositingCmdBuffer->Destroy();
-                }
-
-                VkInstance()->FreeMem(m_perGpu[deviceIdx].pSwCompositingMemory);
-                m_perGpu[deviceIdx].pSwCompositingMemory = nullptr;
+                DestroySwCompositing(deviceIdx);
 
                 result = PalToVkError(palResult);
             }
@@ -3404,7 +4412,7 @@ VkResult Device::AllocBorderColorPalette()
     if (result == VK_SUCCESS)
     {
         const size_t memSize = (palSize * NumPalDevices()) +
-                               (sizeof(bool)* MaxBorderColorPaletteSize);
+                               (sizeof(BorderColorSlot) * MaxBorderColorPaletteSize);
 
         pSystemMem = VkInstance()->AllocMem(memSize, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
 
@@ -3447,7 +4455,20 @@ VkResult Device::AllocBorderColorPalette()
 
     if (result == VK_SUCCESS)
     {
-        m_pBorderColorUsedIndexes = static_cast<bool*>(pSystemMem);
+        result = PalToVkResult(m_borderColorSlotMap.Init());
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        m_pBorderColorSlots = static_cast<BorderColorSlot*>(pSystemMem);
+
+        // Chain all palette entries into the free list
+        for (uint32_t index = 0; index < MaxBorderColorPaletteSize; ++index)
+        {
+            m_pBorderColorSlots[index].nextFree = index + 1;
+        }
+
+        m_borderColorFreeHead = 0;
     }
     else if (m_perGpu[0].pPalBorderColorPalette != nullptr)
     {
@@ -3475,13 +4496,15 @@ void Device::DestroyBorderColorPalette()
 }
 
 // =====================================================================================================================
-// Issue the software compositing and/or synchronization with the updated presenting queue
+// Submits the software compositing copy of a frame and returns the queue to present it on.  The copy from a slave
+// device is split into one command buffer per SDMA engine, which run concurrently; the present waits for all of them.
 Pal::IQueue* Device::PerformSwCompositing(
-    uint32_t         deviceIdx,
-    uint32_t         presentationDeviceIdx,
-    Pal::ICmdBuffer* pCommandBuffer,
-    Pal::QueueType   cmdBufferQueueType,
-    const Queue*     pQueue)
+    uint32_t                deviceIdx,
+    uint32_t                presentationDeviceIdx,
+    Pal::ICmdBuffer* const* ppCommandBuffers,
+    uint32_t                cmdBufferCount,
+    Pal::QueueType          cmdBufferQueueType,
+    const Queue*            pQueue)
 {
     Pal::IQueue* pPresentQueue = nullptr;
     VkResult     result        = VK_SUCCESS;
@@ -3496,44 +4519,55 @@ Pal::IQueue* Device::PerformSwCompositing(
 
     if (result == VK_SUCCESS)
     {
-        Pal::IQueue* pRenderQueue      = pQueue->PalQueue(deviceIdx);
-        Pal::IQueue* pCompositingQueue = pRenderQueue;
+        Pal::IQueue* pRenderQueue = pQueue->PalQueue(deviceIdx);
 
         // For SW composition, we must use a different present queue for slave devices. Otherwise, frame pacing
         // will block any rendering submitted to the master present queue. Using an internal master SDMA queue
         // for the presents of all devices is the simplest solution to this.
-        pPresentQueue = m_perGpu[presentationDeviceIdx].pSwCompositingQueue;
+        pPresentQueue = m_perGpu[presentationDeviceIdx].pSwCompositingQueue[0];
 
-        if (deviceIdx != presentationDeviceIdx)
+        // The presentation device doesn't copy anything; its present only waits for its own rendering.
+        const uint32_t copyCount = (deviceIdx != presentationDeviceIdx) ? cmdBufferCount : 0;
+
+        for (uint32_t engine = 0; engine < Util::Max(copyCount, 1u); engine++)
         {
-            Pal::CmdBufInfo cmdBufInfo = {};
-            cmdBufInfo.isValid = true;
-            cmdBufInfo.p2pCmd  = true;
+            Pal::IQueue* pCompositingQueue = pRenderQueue;
 
-            Pal::PerSubQueueSubmitInfo perSubQueueInfo = {};
-            perSubQueueInfo.cmdBufferCount  = 1;
-            perSubQueueInfo.ppCmdBuffers    = &pCommandBuffer;
-            perSubQueueInfo.pCmdBufInfoList = &cmdBufInfo;
+            if (engine < copyCount)
+            {
+                Pal::CmdBufInfo cmdBufInfo = {};
+                cmdBufInfo.isValid = true;
+                cmdBufInfo.p2pCmd  = true;
 
-            Pal::SubmitInfo submitInfo = {};
-            submitInfo.pPerSubQueueInfo     = &perSubQueueInfo;
-            submitInfo.perSubQueueInfoCount = 1;
+                Pal::PerSubQueueSubmitInfo perSubQueueInfo = {};
+                perSubQueueInfo.cmdBufferCount  = 1;
+                perSubQueueInfo.ppCmdBuffers    = &ppCommandBuffers[engine];
+                perSubQueueInfo.pCmdBufInfoList = &cmdBufInfo;
 
-            // Use the separate SDMA queue and synchronize the slave device's queue with the peer transfer
-            if (cmdBufferQueueType == Pal::QueueType::QueueTypeDma)
-            {
-                pCompositingQueue = m_perGpu[deviceIdx].pSwCompositingQueue;
+                Pal::SubmitInfo submitInfo = {};
+                submitInfo.pPerSubQueueInfo     = &perSubQueueInfo;
+                submitInfo.perSubQueueInfoCount = 1;
+
+                // Use the separate SDMA queue and synchronize the slave device's queue with the peer transfer
+                if (cmdBufferQueueType == Pal::QueueType::QueueTypeDma)
+                {
+                    VK_ASSERT(m_perGpu[deviceIdx].pSwCompositingQueue[engine] != nullptr);
+
+                    pCompositingQueue = m_perGpu[deviceIdx].pSwCompositingQueue[engine];
+
+                    pRenderQueue->SignalQueueSemaphore(m_perGpu[deviceIdx].pSwCompositingSemaphore[engine]);
+                    pCompositingQueue->WaitQueueSemaphore(m_perGpu[deviceIdx].pSwCompositingSemaphore[engine]);
+                }
 
-                pRenderQueue->SignalQueueSemaphore(m_perGpu[deviceIdx].pSwCompositingSemaphore);
-                pCompositingQueue->WaitQueueSemaphore(m_perGpu[deviceIdx].pSwCompositingSemaphore);
+                VK_ASSERT(cmdBufferQueueType == pCompositingQueue->Type());
+                pCompositingQueue->Submit(submitInfo);
             }
 
-            VK_ASSERT(cmdBufferQueueType == pCompositingQueue->Type());
-            pCompositingQueue->Submit(submitInfo);
+            // The rendering queue is never made to wait for the copy, so the next frame's rendering overlaps this
+            // frame's compositing; only the present waits for it.
+            pCompositingQueue->SignalQueueSemaphore(m_perGpu[deviceIdx].pSwCompositingDoneSemaphore[engine]);
+            pPresentQueue->WaitQueueSemaphore(m_perGpu[deviceIdx].pSwCompositingDoneSemaphore[engine]);
         }
-
-        pCompositingQueue->SignalQueueSemaphore(m_perGpu[deviceIdx].pSwCompositingSemaphore);
-        pPresentQueue->WaitQueueSemaphore(m_perGpu[deviceIdx].pSwCompositingSemaphore);
     }
 
     return pPresentQueue;
@@ -3549,7 +4583,7 @@ VkResult Device::SwCompositingNotifyFlipMetadata(
 
     for (uint32_t presentationDeviceIdx = 0; presentationDeviceIdx < NumPalDevices(); presentationDeviceIdx++)
     {
-        if (pPresentQueue == m_perGpu[presentationDeviceIdx].pSwCompositingQueue)
+        if (pPresentQueue == m_perGpu[presentationDeviceIdx].pSwCompositingQueue[0])
         {
             // Found the master device index for the correct dummy command buffer to use.
             Pal::PerSubQueueSubmitInfo perSubQueueInfo = {};
@@ -3582,19 +4616,44 @@ void Device::UpdateFeatureSettings()
 {
     ProfileSettings profileSettings = {};
 
-    ReloadAppProfileSettings(m_pInstance, &profileSettings);
+    m_pInstance->GetAppProfileSettings(0u, &profileSettings);
 
 }
 
 // =====================================================================================================================
-// Handles logging of debug names from the DebugUtils extension
+// Handles logging of debug names from the DebugUtils extension.  Names are only kept for consumers which are active when
+// they are set: objects reported to the application's messengers keep an interned copy, and RMV is only told while a
+// developer mode connection can exist.  Otherwise the name is dropped without being copied.
 VkResult Device::SetDebugUtilsObjectName(
     const VkDebugUtilsObjectNameInfoEXT* pNameInfo)
 {
+    if (((pNameInfo->objectType == VkObjectType::VK_OBJECT_TYPE_COMMAND_BUFFER) ||
+         (pNameInfo->objectType == VkObjectType::VK_OBJECT_TYPE_SWAPCHAIN_KHR)) &&
+        VkInstance()->HasDebugUtilsMessengers())
+    {
+        const char* pName = nullptr;
+
+        if ((pNameInfo->pObjectName != nullptr) && (pNameInfo->pObjectName[0] != '\0'))
+        {
+            pName = m_debugNameTable.Intern(pNameInfo->pObjectName);
+        }
+
+        if (pNameInfo->objectType == VkObjectType::VK_OBJECT_TYPE_COMMAND_BUFFER)
+        {
+            ApiCmdBuffer::ObjectFromHandle(reinterpret_cast<VkCommandBuffer>(pNameInfo->objectHandle))->
+                SetDebugName(pName);
+        }
+        else
+        {
+            reinterpret_cast<SwapChain*>(pNameInfo->objectHandle)->SetDebugName(pName);
+        }
+    }
+
     // Log the object name if it is an object type that RMV cares about.
-    if ((pNameInfo->objectType == VkObjectType::VK_OBJECT_TYPE_BUFFER) ||
-        (pNameInfo->objectType == VkObjectType::VK_OBJECT_TYPE_IMAGE) ||
-        (pNameInfo->objectType == VkObjectType::VK_OBJECT_TYPE_PIPELINE))
+    if (((pNameInfo->objectType == VkObjectType::VK_OBJECT_TYPE_BUFFER) ||
+         (pNameInfo->objectType == VkObjectType::VK_OBJECT_TYPE_IMAGE) ||
+         (pNameInfo->objectType == VkObjectType::VK_OBJECT_TYPE_PIPELINE)) &&
+        (VkInstance()->GetDevModeMgr() != nullptr))
     {
         // For buffers, the RMV resource handle is the same as the handle passed in so we can log that directly,
         // but for image and pipeline the RMV resource handle comes from the Pal object.
@@ -3625,28 +4684,47 @@ uint32_t Device::GetBorderColorIndex(
         const float*                 pBorderColor)
 {
     uint32_t borderColorIndex = MaxBorderColorPaletteSize;
-    bool     indexWasFound    = false;
+
+    BorderColorKey key = {};
+    memcpy(key.color, pBorderColor, sizeof(key.color));
 
     MutexAuto lock(&m_borderColorMutex);
 
-    for (uint32_t index = 0; (index < MaxBorderColorPaletteSize) && (indexWasFound == false); ++index)
+    // Samplers with the same border color share its palette entry
+    const uint32_t* pExistingIndex = m_borderColorSlotMap.FindKey(key);
+
+    if (pExistingIndex != nullptr)
+    {
+        borderColorIndex = *pExistingIndex;
+
+        m_pBorderColorSlots[borderColorIndex].refCount++;
+    }
+    else if (m_borderColorFreeHead < MaxBorderColorPaletteSize)
     {
-        if (m_pBorderColorUsedIndexes[index] == false)
+        bool      existed = false;
+        uint32_t* pIndex  = nullptr;
+
+        if (m_borderColorSlotMap.FindAllocate(key, &existed, &pIndex) == Pal::Result::Success)
         {
-            borderColorIndex = index;
-            m_pBorderColorUsedIndexes[index] = true;
+            borderColorIndex = m_borderColorFreeHead;
+
+            BorderColorSlot* pSlot = &m_pBorderColorSlots[borderColorIndex];
+
+            m_borderColorFreeHead = pSlot->nextFree;
+
+            pSlot->key      = key;
+            pSlot->refCount = 1;
+            *pIndex         = borderColorIndex;
 
             for (uint32_t deviceIdx = 0; deviceIdx < NumPalDevices(); deviceIdx++)
             {
                 // Update border color entry
                 m_perGpu[deviceIdx].pPalBorderColorPalette->Update(borderColorIndex, 1, pBorderColor);
             }
-
-            indexWasFound = true;
         }
     }
 
-    VK_ASSERT(indexWasFound);
+    VK_ASSERT(borderColorIndex != MaxBorderColorPaletteSize);
     return borderColorIndex;
 }
 
@@ -3655,7 +4733,18 @@ void Device::ReleaseBorderColorIndex(
         uint32_t                     borderColorIndex)
 {
     MutexAuto lock(&m_borderColorMutex);
-    m_pBorderColorUsedIndexes[borderColorIndex] = false;
+
+    BorderColorSlot* pSlot = &m_pBorderColorSlots[borderColorIndex];
+
+    VK_ASSERT(pSlot->refCount > 0);
+
+    if (--pSlot->refCount == 0)
+    {
+        m_borderColorSlotMap.Erase(pSlot->key);
+
+        pSlot->nextFree       = m_borderColorFreeHead;
+        m_borderColorFreeHead = borderColorIndex;
+    }
 }
 
 // =====================================================================================================================
@@ -3711,19 +4800,96 @@ void Device::FreeApiObject(
     pAllocator->pfnFree(pAllocator->pUserData, pActualMemory);
 }
 
+// =====================================================================================================================
+// Allocates the memory of an API object like AllocApiObject(), but from the API object pool if the object uses the
+// instance allocator and is small enough.  Every allocation starts with a header recording where it came from.
+void* Device::AllocPooledApiObject(
+        const VkAllocationCallbacks*    pAllocator,
+        const size_t                    totalObjectSize)
+{
+    VK_ASSERT(pAllocator != nullptr);
+
+    const size_t actualObjectSize = totalObjectSize + m_privateDataSize;
+
+    const uint32_t sizeClass =
+        ((m_pApiObjectPool != nullptr) && (pAllocator == VkInstance()->GetAllocCallbacks())) ?
+        ApiObjectPool::GetSizeClass(actualObjectSize) : ApiObjectPool::NoSizeClass;
+
+    void* pMemory = nullptr;
+
+    if (sizeClass != ApiObjectPool::NoSizeClass)
+    {
+        pMemory = m_pApiObjectPool->Alloc(sizeClass);
+    }
+    else
+    {
+        void* pBase = pAllocator->pfnAllocation(
+                        pAllocator->pUserData,
+                        ApiObjectPool::BlockHeaderSize + actualObjectSize,
+                        VK_DEFAULT_MEM_ALIGN,
+                        VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+        pMemory = (pBase != nullptr) ? ApiObjectPool::InitUnpooledBlock(pBase) : nullptr;
+    }
+
+    if ((m_privateDataSize > 0) && (pMemory != nullptr))
+    {
+        memset(pMemory, 0, m_privateDataSize);
+        pMemory = Util::VoidPtrInc(pMemory, m_privateDataSize);
+    }
+
+    return pMemory;
+}
+
+// =====================================================================================================================
+// Frees memory returned by AllocPooledApiObject().
+void Device::FreePooledApiObject(
+        const VkAllocationCallbacks*    pAllocator,
+        void*                           pMemory)
+{
+    VK_ASSERT(pAllocator != nullptr);
+
+    if (pMemory != nullptr)
+    {
+        void* pActualMemory = pMemory;
+
+        if (m_privateDataSize > 0)
+        {
+            pActualMemory = Util::VoidPtrDec(pActualMemory, m_privateDataSize);
+            FreeUnreservedPrivateData(pActualMemory);
+        }
+
+        const uint32_t sizeClass = ApiObjectPool::GetBlockSizeClass(pActualMemory);
+
+        if (sizeClass != ApiObjectPool::NoSizeClass)
+        {
+            m_pApiObjectPool->Free(sizeClass, pActualMemory);
+        }
+        else
+        {
+            pAllocator->pfnFree(pAllocator->pUserData, Util::VoidPtrDec(pActualMemory, ApiObjectPool::BlockHeaderSize));
+        }
+    }
+}
+
 // =====================================================================================================================
 void Device::FreeUnreservedPrivateData(
         void*                           pMemory) const
 {
     PrivateDataStorage* pPrivateDataStorage = static_cast<PrivateDataStorage*>(pMemory);
 
-    if (pPrivateDataStorage->pUnreserved != nullptr)
+    PrivateDataChunk* pChunk = pPrivateDataStorage->pUnreserved.load(std::memory_order_relaxed);
+
+    while (pChunk != nullptr)
     {
-        Util::Destructor(pPrivateDataStorage->pUnreserved);
-        VkInstance()->FreeMem(pPrivateDataStorage->pUnreserved);
+        PrivateDataChunk* pNext = pChunk->pNext;
+
+        VkInstance()->FreeMem(pChunk);
 
-        pPrivateDataStorage->pUnreserved = nullptr;
+        pChunk = pNext;
     }
+
+    pPrivateDataStorage->pUnreserved.store(nullptr, std::memory_order_relaxed);
 }
 
 // =====================================================================================================================
@@ -64,6 +64,8 @@
 #include "include/vk_swapchain.h"
 #include "include/vk_debug_report.h"
 
+#include "strings/g_entry_point_hash.h"
+
 #include <cstring>
 
 namespace vk
@@ -627,6 +629,9 @@ void DispatchTable::Init()
 
     INIT_DISPATCH_ENTRY(vkCmdSetColorWriteEnableEXT                     );
 
+    INIT_DISPATCH_ENTRY(vkCmdBeginRenderingKHR                          );
+    INIT_DISPATCH_ENTRY(vkCmdEndRenderingKHR                            );
+
 }
 
 // =====================================================================================================================
@@ -643,17 +648,18 @@ void DispatchTable::Init()
 PFN_vkVoidFunction DispatchTable::GetEntryPoint(const char* pName) const
 {
     PFN_vkVoidFunction pFunc = nullptr;
-    bool found = false;
 
-    for (uint32_t epIdx = 0; (found == false) && (epIdx < VKI_ENTRY_POINT_COUNT); epIdx++)
+    // The generated perfect hash maps any entry point name to its own index, so a single compare against that entry
+    // decides whether pName is known at all.
+    const uint32_t epIdx = strings::entry::GetEntryPointIndexCandidate(pName);
+
+    if (epIdx < VKI_ENTRY_POINT_COUNT)
     {
         const EntryPoint::Metadata& metadata = g_EntryPointMetadataTable[epIdx];
 
         if ((metadata.pName != nullptr) &&
             (strcmp(pName, metadata.pName) == 0))
         {
-            found = true;
-
             switch (metadata.type)
             {
             case EntryPoint::Type::GLOBAL:
@@ -49,6 +49,9 @@ Event::Event(
     bool             useToken)
     :
     m_internalGpuMem(),
+    m_pHostStatus(nullptr),
+    m_hostStatusDwords(0),
+    m_pStatusValues(nullptr),
     m_useToken(useToken)
 {
     if (useToken)
@@ -104,7 +107,7 @@ VkResult Event::Create(
     const size_t palSize = useToken ?
         0 : pDevice->PalDevice(DefaultDeviceIndex)->GetGpuEventSize(eventCreateInfo, nullptr);
 
-    void* pSystemMem = pDevice->AllocApiObject(
+    void* pSystemMem = pDevice->AllocPooledApiObject(
         pAllocator,
         apiSize + (palSize * numDeviceEvents));
 
@@ -167,7 +170,7 @@ VkResult Event::Create(
         Util::Destructor(pObject);
 
         // PAL event construction failed. Free system memory and return.
-        pDevice->FreeApiObject(pAllocator, pSystemMem);
+        pDevice->FreePooledApiObject(pAllocator, pSystemMem);
     }
 
     return result;
@@ -216,9 +219,104 @@ VkResult Event::Initialize(
         result = PalToVkResult(palResult);
     }
 
+    if ((result == VK_SUCCESS) &&
+        (pool == InternalPoolCpuCacheableGpuUncached) &&
+        pDevice->GetRuntimeSettings().enableEventHostStatusRead)
+    {
+        InitHostStatus(pDevice, gpuMemReqs.size);
+    }
+
     return result;
 }
 
+// =====================================================================================================================
+// Sets up reading the status of the event from its persistently mapped memory.  The first event of the device to get
+// here learns the values PAL writes on a host set and reset by setting and resetting it, which leaves the event reset
+// as a new event must be.
+void Event::InitHostStatus(
+    Device*      pDevice,
+    Pal::gpusize memSize)
+{
+    EventStatusValues* pValues    = pDevice->GetEventStatusValues();
+    volatile uint32_t* pStatus    = static_cast<volatile uint32_t*>(m_internalGpuMem.CpuAddr(DefaultDeviceIndex));
+    const uint32_t     dwordCount = static_cast<uint32_t>(memSize / sizeof(uint32_t));
+
+    uint32_t expected = EventStatusValues::Unknown;
+
+    if ((pStatus != nullptr) && (dwordCount > 0) &&
+        pValues->state.compare_exchange_strong(expected, EventStatusValues::Probing, std::memory_order_acq_rel))
+    {
+        bool valid = (PalEvent(DefaultDeviceIndex)->Set() == Pal::Result::Success);
+
+        const uint32_t setValue = pStatus[0];
+
+        for (uint32_t i = 1; valid && (i < dwordCount); ++i)
+        {
+            valid = (pStatus[i] == setValue);
+        }
+
+        valid = (PalEvent(DefaultDeviceIndex)->Reset() == Pal::Result::Success) && valid;
+
+        const uint32_t resetValue = pStatus[0];
+
+        for (uint32_t i = 1; valid && (i < dwordCount); ++i)
+        {
+            valid = (pStatus[i] == resetValue);
+        }
+
+        valid = valid &&
+                (setValue != resetValue) &&
+                (PalEvent(DefaultDeviceIndex)->GetStatus() == Pal::Result::EventReset);
+
+        pValues->setValue   = setValue;
+        pValues->resetValue = resetValue;
+        pValues->state.store(valid ? EventStatusValues::Valid : EventStatusValues::Invalid, std::memory_order_release);
+    }
+
+    if (pStatus != nullptr)
+    {
+        m_pHostStatus      = pStatus;
+        m_hostStatusDwords = dwordCount;
+        m_pStatusValues    = pValues;
+    }
+}
+
+// =====================================================================================================================
+// Reads the status of the event from its memory.  Returns false if the status has to be asked from PAL: the values
+// aren't known (yet), or the memory holds neither value in all of its dwords (e.g. while the GPU is writing it).
+bool Event::ReadHostStatus(
+    VkResult* pStatus
+    ) const
+{
+    bool known = (m_pHostStatus != nullptr) &&
+                 (m_pStatusValues->state.load(std::memory_order_acquire) == EventStatusValues::Valid);
+
+    if (known)
+    {
+        const uint32_t value = m_pHostStatus[0];
+
+        for (uint32_t i = 1; known && (i < m_hostStatusDwords); ++i)
+        {
+            known = (m_pHostStatus[i] == value);
+        }
+
+        if (known && (value == m_pStatusValues->setValue))
+        {
+            *pStatus = VK_EVENT_SET;
+        }
+        else if (known && (value == m_pStatusValues->resetValue))
+        {
+            *pStatus = VK_EVENT_RESET;
+        }
+        else
+        {
+            known = false;
+        }
+    }
+
+    return known;
+}
+
 // =====================================================================================================================
 // Signal an event object
 VkResult Event::Set(void)
@@ -241,9 +339,16 @@ VkResult Event::Reset(void)
 // Get the current status of an event object
 VkResult Event::GetStatus(void)
 {
-    const Pal::Result palStatus = PalEvent(DefaultDeviceIndex)->GetStatus();
+    VkResult result = VK_SUCCESS;
+
+    if (ReadHostStatus(&result) == false)
+    {
+        const Pal::Result palStatus = PalEvent(DefaultDeviceIndex)->GetStatus();
 
-    return PalToVkResult(palStatus);
+        result = PalToVkResult(palStatus);
+    }
+
+    return result;
 }
 
 // =====================================================================================================================
@@ -268,7 +373,7 @@ VkResult Event::Destroy(
     Util::Destructor(this);
 
     // Free memory
-    pDevice->FreeApiObject(pAllocator, this);
+    pDevice->FreePooledApiObject(pAllocator, this);
 
     // Cannot fail
     return VK_SUCCESS;
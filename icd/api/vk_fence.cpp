@@ -33,6 +33,7 @@
 #include "include/vk_fence.h"
 #include "include/vk_device.h"
 #include "include/vk_instance.h"
+#include "include/queue_submit_thread.h"
 
 #include "palFence.h"
 
@@ -52,6 +53,7 @@ VkResult Fence::Create(
     VK_ASSERT(pCreateInfo->sType == VK_STRUCTURE_TYPE_FENCE_CREATE_INFO);
 
     const VkExportFenceCreateInfo*         pVkExportCreateInfo = nullptr;
+    bool                                   isExportable        = false;
 
     Pal::FenceCreateInfo palFenceCreateInfo = {};
     palFenceCreateInfo.flags.signaled = (pCreateInfo->flags & VK_FENCE_CREATE_SIGNALED_BIT) != 0;
@@ -66,6 +68,7 @@ VkResult Fence::Create(
         {
         case VK_STRUCTURE_TYPE_EXPORT_FENCE_CREATE_INFO:
         {
+            isExportable = true;
             break;
         }
         default:
@@ -76,12 +79,40 @@ VkResult Fence::Create(
         pNext = pHeader->pNext;
     }
     const uint32_t numGroupedFences = pDevice->NumPalDevices();
+
+    // Unsignaled fences from the instance allocator can reuse a destroyed fence and its already created PAL fences.
+    // The memory of other fences belongs to the application's allocator and has to be returned on destroy.
+    if ((palFenceCreateInfo.flags.signaled == 0) &&
+        (isExportable == false)                  &&
+        (pAllocator == pInstance->GetAllocCallbacks()))
+    {
+        Fence* pPooledFence = pDevice->AcquirePooledFence();
+
+        if (pPooledFence != nullptr)
+        {
+            Pal::IFence* pPalFences[MaxPalDevices] = {};
+
+            for (uint32_t deviceIdx = 0; deviceIdx < numGroupedFences; deviceIdx++)
+            {
+                pPalFences[deviceIdx] = pPooledFence->PalFence(deviceIdx);
+            }
+
+            VK_PLACEMENT_NEW (pPooledFence) Fence(numGroupedFences,
+                                                  pPalFences,
+                                                  palFenceCreateInfo.flags.eventCanBeInherited);
+
+            *pFence = Fence::HandleFromObject(pPooledFence);
+
+            return VK_SUCCESS;
+        }
+    }
+
     const uint32_t apiSize          = sizeof(Fence);
     const size_t   palSize          = pDevice->PalDevice(DefaultDeviceIndex)->GetFenceSize(nullptr);
     const size_t   totalSize        = apiSize + (palSize * numGroupedFences);
 
     // Allocate system memory
-    void* pMemory = pDevice->AllocApiObject(pAllocator, totalSize);
+    void* pMemory = pDevice->AllocPooledApiObject(pAllocator, totalSize);
 
     if (pMemory == nullptr)
     {
@@ -109,14 +140,19 @@ VkResult Fence::Create(
     if (palResult == Pal::Result::Success)
     {
         // On success, wrap it in an API object and return to application
-        VK_PLACEMENT_NEW (pMemory) Fence(numGroupedFences, pPalFences, palFenceCreateInfo.flags.eventCanBeInherited);
+        Fence* pNewFence = VK_PLACEMENT_NEW (pMemory) Fence(numGroupedFences,
+                                                            pPalFences,
+                                                            palFenceCreateInfo.flags.eventCanBeInherited);
+
+        pNewFence->m_flags.isExportable = isExportable;
+        pNewFence->SetKnownSignaled(palFenceCreateInfo.flags.signaled != 0);
 
         *pFence = Fence::HandleFromVoidPointer(pMemory);
 
         return VK_SUCCESS;
     }
 
-    pDevice->FreeApiObject(pAllocator, pMemory);
+    pDevice->FreePooledApiObject(pAllocator, pMemory);
 
     return PalToVkResult(palResult);
 }
@@ -131,6 +167,16 @@ VkResult Fence::Destroy(
 
     RestoreFence(pDevice);
 
+    // Fences which only ever owned the PAL fences they were created with go back to the device pool.  The object is
+    // constructed again when the pool hands it out.
+    if ((m_flags.isOpened == 0)                                    &&
+        (m_flags.isExportable == 0)                                &&
+        (pAllocator == pDevice->VkInstance()->GetAllocCallbacks()) &&
+        pDevice->ReleasePooledFence(this))
+    {
+        return VK_SUCCESS;
+    }
+
     for (uint32_t groupIdx = 0; groupIdx < m_groupedFenceCount; groupIdx++)
     {
         PalFence(groupIdx)->Destroy();
@@ -140,16 +186,35 @@ VkResult Fence::Destroy(
     Util::Destructor(this);
 
     // Free memory
-    pDevice->FreeApiObject(pAllocator, this);
+    pDevice->FreePooledApiObject(pAllocator, this);
 
     // Cannot fail
     return VK_SUCCESS;
 }
 
+// =====================================================================================================================
+// Waits until the deferred submission signaling this fence, if any, has been handed to PAL.  Returns the error of the
+// submit thread if a deferred submission failed.
+VkResult Fence::WaitForPendingSubmission() const
+{
+    return (m_pSubmitThread != nullptr) ? m_pSubmitThread->WaitForSubmission(m_submitSequence) : VK_SUCCESS;
+}
+
 // =====================================================================================================================
 // Retrieve the status of a fence object
 VkResult Fence::GetStatus(void)
 {
+    if (IsKnownSignaled())
+    {
+        return VK_SUCCESS;
+    }
+
+    // A fence whose submission hasn't reached PAL yet can't have signaled.
+    if ((m_pSubmitThread != nullptr) && (m_pSubmitThread->IsSubmitted(m_submitSequence) == false))
+    {
+        return (m_pSubmitThread->GetResult() == VK_SUCCESS) ? VK_NOT_READY : m_pSubmitThread->GetResult();
+    }
+
     Pal::Result palResult = Pal::Result::Success;
 
     for (uint32_t deviceIdx = 0; (deviceIdx < m_groupedFenceCount) && (palResult == Pal::Result::Success); deviceIdx++)
@@ -169,6 +234,7 @@ VkResult Fence::GetStatus(void)
     if (palResult == Pal::Result::Success)
     {
         result = VK_SUCCESS;
+        SetKnownSignaled(true);
     }
     else if ((palResult == Pal::Result::ErrorUnavailable) ||
              (palResult == Pal::Result::NotReady)         ||
@@ -203,6 +269,7 @@ VkResult Fence::ImportFenceFd(
     m_flags.isOpened       = 1;
     m_flags.isPermanence   = isPermanence;
     m_flags.isReference    = openInfo.flags.isReference;
+    SetKnownSignaled(false);
     Pal::IFence* pPalFence = PalFence(DefaultDeviceIndex);
 
     if (isPermanence)
@@ -265,6 +332,8 @@ VkResult Fence::GetFenceFd(
     const VkFenceGetFdInfoKHR*      pGetFdInfo,
     int*                            pFd)
 {
+    WaitForPendingSubmission();
+
     VK_ASSERT((pGetFdInfo->handleType == VK_EXTERNAL_FENCE_HANDLE_TYPE_OPAQUE_FD_BIT_KHR) ||
               (pGetFdInfo->handleType == VK_EXTERNAL_FENCE_HANDLE_TYPE_SYNC_FD_BIT_KHR));
 
@@ -273,6 +342,12 @@ VkResult Fence::GetFenceFd(
     exportInfo.flags.implicitReset = (pGetFdInfo->handleType == VK_EXTERNAL_FENCE_HANDLE_TYPE_SYNC_FD_BIT_KHR);
     *pFd  = PalFence(DefaultDeviceIndex)->ExportExternalHandle(exportInfo);
 
+    // Exporting a sync fd resets the fence, as if by vkResetFences.
+    if (exportInfo.flags.implicitReset)
+    {
+        SetKnownSignaled(false);
+    }
+
     return VkResult::VK_SUCCESS;
 }
 #endif
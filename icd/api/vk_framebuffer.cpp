@@ -97,16 +97,30 @@ VkResult Framebuffer::Create(
     const size_t attachmentSize = sizeof(Attachment) * pCreateInfo->attachmentCount;
     const size_t objSize        = apiSize + attachmentSize;
 
-    void* pSystemMem = pDevice->AllocApiObject(pAllocator, objSize);
+    void* pSystemMem = pDevice->AllocPooledApiObject(pAllocator, objSize);
 
     // On success, wrap it up in a Vulkan object and return.
     if (pSystemMem != nullptr)
     {
         Attachment* pAttachments = static_cast<Attachment*>(Util::VoidPtrInc(pSystemMem, apiSize));
 
-        VK_PLACEMENT_NEW(pSystemMem) Framebuffer(*pCreateInfo, pAttachments, pDevice->GetRuntimeSettings());
+        Framebuffer* pObject =
+            VK_PLACEMENT_NEW(pSystemMem) Framebuffer(*pCreateInfo, pAttachments, pDevice->GetRuntimeSettings());
 
-        *pFramebuffer = Framebuffer::HandleFromVoidPointer(pSystemMem);
+        // The attachments of imageless framebuffers are only planned when a render pass begins
+        if (pDevice->GetTransientAliasPlanner()->IsEnabled() && (pObject->IsImageless() == false))
+        {
+            result = pObject->PlanTransientAliasing(pDevice, RenderPass::ObjectFromHandle(pCreateInfo->renderPass));
+        }
+
+        if (result == VK_SUCCESS)
+        {
+            *pFramebuffer = Framebuffer::HandleFromVoidPointer(pSystemMem);
+        }
+        else
+        {
+            pObject->Destroy(pDevice, pAllocator);
+        }
     }
     else
     {
@@ -134,7 +148,10 @@ Framebuffer::Framebuffer(const VkFramebufferCreateInfo& info,
                          Attachment*                    pAttachments,
                          const RuntimeSettings&         runTimeSettings)
         : m_attachmentCount (info.attachmentCount),
-		  m_settings(runTimeSettings)
+		  m_settings(runTimeSettings),
+          m_imageless((info.flags & VK_FRAMEBUFFER_CREATE_IMAGELESS_BIT) != 0),
+          m_pBeginLayouts(nullptr),
+          m_transientAliasPlanHash(0)
 {
     m_globalScissorParams.scissorRegion.offset.x      = 0;
     m_globalScissorParams.scissorRegion.offset.y      = 0;
@@ -167,16 +184,98 @@ VkResult Framebuffer::Destroy(
     Device*                         pDevice,
     const VkAllocationCallbacks*    pAllocator)
 {
+    BeginLayouts* pBeginLayouts = m_pBeginLayouts.load(std::memory_order_acquire);
+
+    if (pBeginLayouts != nullptr)
+    {
+        pDevice->VkInstance()->FreeMem(pBeginLayouts);
+    }
+
     // Call destructor
     Util::Destructor(this);
 
     // Free memory
-    pDevice->FreeApiObject(pAllocator, this);
+    pDevice->FreePooledApiObject(pAllocator, this);
 
     // Cannot fail
     return VK_SUCCESS;
 }
 
+// =====================================================================================================================
+// Lets transient attachments of this framebuffer share memory where their lifetimes in the given render pass allow.
+// Command buffers plan again when they begin a render pass with a different hash, since a compatible render pass may
+// use the attachments differently.
+VkResult Framebuffer::PlanTransientAliasing(
+    Device*                         pDevice,
+    const RenderPass*               pRenderPass)
+{
+    bool hasAliasedAttachments = false;
+
+    const VkResult result = pDevice->GetTransientAliasPlanner()->Plan(pRenderPass, this, &hasAliasedAttachments);
+
+    m_transientAliasPlanHash.store(hasAliasedAttachments ? pRenderPass->GetHash() : 0, std::memory_order_relaxed);
+
+    return result;
+}
+
+// =====================================================================================================================
+// Returns the cached attachment plane layouts a render pass instance starts with, or nullptr if none were cached for
+// the given render pass and queue family.  The returned array holds Pal::MaxNumPlanes layouts per attachment.
+const Pal::ImageLayout* Framebuffer::GetBeginLayouts(
+    uint64_t                        renderPassHash,
+    uint32_t                        queueFamilyIndex) const
+{
+    const Pal::ImageLayout* pLayouts      = nullptr;
+    const BeginLayouts*     pBeginLayouts = m_pBeginLayouts.load(std::memory_order_acquire);
+
+    if ((pBeginLayouts != nullptr) &&
+        (pBeginLayouts->renderPassHash == renderPassHash) &&
+        (pBeginLayouts->queueFamilyIndex == queueFamilyIndex))
+    {
+        pLayouts = static_cast<const Pal::ImageLayout*>(Util::VoidPtrInc(pBeginLayouts, sizeof(BeginLayouts)));
+    }
+
+    return pLayouts;
+}
+
+// =====================================================================================================================
+// Caches the attachment plane layouts a render pass instance of the given render pass starts with.  Only the first
+// render pass begun with the framebuffer is cached, which covers the common case of a framebuffer being created for
+// a single render pass, and keeps lookups lock-free for command buffers recorded concurrently.
+void Framebuffer::CacheBeginLayouts(
+    Device*                         pDevice,
+    uint64_t                        renderPassHash,
+    uint32_t                        queueFamilyIndex,
+    const Pal::ImageLayout*         pLayouts)
+{
+    VK_ASSERT(m_imageless == false);
+
+    if (m_pBeginLayouts.load(std::memory_order_relaxed) == nullptr)
+    {
+        const size_t layoutSize = sizeof(Pal::ImageLayout) * Pal::MaxNumPlanes * m_attachmentCount;
+
+        BeginLayouts* pBeginLayouts = static_cast<BeginLayouts*>(pDevice->VkInstance()->AllocMem(
+            sizeof(BeginLayouts) + layoutSize,
+            VK_SYSTEM_ALLOCATION_SCOPE_OBJECT));
+
+        if (pBeginLayouts != nullptr)
+        {
+            pBeginLayouts->renderPassHash   = renderPassHash;
+            pBeginLayouts->queueFamilyIndex = queueFamilyIndex;
+
+            memcpy(Util::VoidPtrInc(pBeginLayouts, sizeof(BeginLayouts)), pLayouts, layoutSize);
+
+            BeginLayouts* pExpected = nullptr;
+
+            if (m_pBeginLayouts.compare_exchange_strong(pExpected, pBeginLayouts, std::memory_order_acq_rel) == false)
+            {
+                // Another thread cached its layouts first.
+                pDevice->VkInstance()->FreeMem(pBeginLayouts);
+            }
+        }
+    }
+}
+
 // =====================================================================================================================
 // Set ImageViews for a Framebuffer attachment
 void Framebuffer::SetImageViews(
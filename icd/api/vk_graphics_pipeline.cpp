@@ -24,6 +24,7 @@
  **********************************************************************************************************************/
 
 #include "include/log.h"
+#include "include/pipeline_stats_profile.h"
 #include "include/vk_conv.h"
 #include "include/vk_device.h"
 #include "include/vk_graphics_pipeline.h"
@@ -50,16 +51,255 @@ using namespace Util;
 namespace vk
 {
 
+// =====================================================================================================================
+// Returns the vertex attribute divisor state chained to a vertex input state, if any
+static const VkPipelineVertexInputDivisorStateCreateInfoEXT* GetVertexInputDivisorState(
+    const VkPipelineVertexInputStateCreateInfo& desc)
+{
+    const VkPipelineVertexInputDivisorStateCreateInfoEXT* pDivisorState = nullptr;
+
+    const void* pNext = desc.pNext;
+
+    while ((pNext != nullptr) && (pDivisorState == nullptr))
+    {
+        const auto* pHeader = static_cast<const VkStructHeader*>(pNext);
+
+        if (static_cast<uint32>(pHeader->sType) ==
+            VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_DIVISOR_STATE_CREATE_INFO_EXT)
+        {
+            pDivisorState = static_cast<const VkPipelineVertexInputDivisorStateCreateInfoEXT*>(pNext);
+        }
+
+        pNext = pHeader->pNext;
+    }
+
+    return pDivisorState;
+}
+
+// =====================================================================================================================
+// Returns true if all bindings and locations of a vertex input state fit the arrays of NormalizedVertexInput.  Valid
+// states always do; others are left alone.
+static bool CanNormalizeVertexInputState(
+    const VkPipelineVertexInputStateCreateInfo&           desc,
+    const VkPipelineVertexInputDivisorStateCreateInfoEXT* pDivisorState)
+{
+    bool canNormalize = (desc.vertexBindingDescriptionCount   <= Pal::MaxVertexBuffers) &&
+                        (desc.vertexAttributeDescriptionCount <= MaxVertexAttributes);
+
+    for (uint32_t i = 0; canNormalize && (i < desc.vertexBindingDescriptionCount); i++)
+    {
+        canNormalize = (desc.pVertexBindingDescriptions[i].binding < Pal::MaxVertexBuffers);
+    }
+
+    for (uint32_t i = 0; canNormalize && (i < desc.vertexAttributeDescriptionCount); i++)
+    {
+        canNormalize = (desc.pVertexAttributeDescriptions[i].binding  < Pal::MaxVertexBuffers) &&
+                       (desc.pVertexAttributeDescriptions[i].location < MaxVertexAttributes);
+    }
+
+    if (pDivisorState != nullptr)
+    {
+        canNormalize = canNormalize && (pDivisorState->vertexBindingDivisorCount <= Pal::MaxVertexBuffers);
+
+        for (uint32_t i = 0; canNormalize && (i < pDivisorState->vertexBindingDivisorCount); i++)
+        {
+            canNormalize = (pDivisorState->pVertexBindingDivisors[i].binding < Pal::MaxVertexBuffers);
+        }
+    }
+
+    return canNormalize;
+}
+
+// =====================================================================================================================
+// Returns true if a vertex input state is in the canonical form described by NormalizedVertexInput, or can't be
+// normalized.
+bool GraphicsPipeline::IsVertexInputStateNormalized(
+    const VkPipelineVertexInputStateCreateInfo& desc)
+{
+    const VkPipelineVertexInputDivisorStateCreateInfoEXT* pDivisorState = GetVertexInputDivisorState(desc);
+
+    bool normalized = true;
+
+    if (CanNormalizeVertexInputState(desc, pDivisorState))
+    {
+        uint32_t usedBindingMask = 0;
+
+        for (uint32_t i = 0; i < desc.vertexAttributeDescriptionCount; i++)
+        {
+            const VkVertexInputAttributeDescription& attrib = desc.pVertexAttributeDescriptions[i];
+
+            usedBindingMask |= (1u << attrib.binding);
+
+            if ((i > 0) && (attrib.location <= desc.pVertexAttributeDescriptions[i - 1].location))
+            {
+                normalized = false;
+            }
+        }
+
+        for (uint32_t i = 0; i < desc.vertexBindingDescriptionCount; i++)
+        {
+            const uint32_t binding = desc.pVertexBindingDescriptions[i].binding;
+
+            if (((usedBindingMask & (1u << binding)) == 0) ||
+                ((i > 0) && (binding <= desc.pVertexBindingDescriptions[i - 1].binding)))
+            {
+                normalized = false;
+            }
+        }
+
+        if (pDivisorState != nullptr)
+        {
+            normalized = normalized && (pDivisorState->vertexBindingDivisorCount > 0);
+
+            for (uint32_t i = 0; i < pDivisorState->vertexBindingDivisorCount; i++)
+            {
+                const VkVertexInputBindingDivisorDescriptionEXT& divisor = pDivisorState->pVertexBindingDivisors[i];
+
+                if (((usedBindingMask & (1u << divisor.binding)) == 0) || (divisor.divisor == 1) ||
+                    ((i > 0) && (divisor.binding <= pDivisorState->pVertexBindingDivisors[i - 1].binding)))
+                {
+                    normalized = false;
+                }
+            }
+        }
+    }
+
+    return normalized;
+}
+
+// =====================================================================================================================
+// Brings a vertex input state into canonical form.  Returns the state itself if it already is (or can't be brought
+// into it), or the state built in pNormalized otherwise.  Other structures chained to the state are dropped, as they
+// don't affect the vertex fetches.
+const VkPipelineVertexInputStateCreateInfo* GraphicsPipeline::NormalizeVertexInputState(
+    const VkPipelineVertexInputStateCreateInfo& desc,
+    NormalizedVertexInput*                      pNormalized)
+{
+    static_assert(Pal::MaxVertexBuffers <= 32, "Binding masks must be widened");
+
+    const VkPipelineVertexInputStateCreateInfo* pState = &desc;
+
+    if (IsVertexInputStateNormalized(desc) == false)
+    {
+        const VkPipelineVertexInputDivisorStateCreateInfoEXT* pDivisorState = GetVertexInputDivisorState(desc);
+
+        const VkVertexInputBindingDescription*           pBindings[Pal::MaxVertexBuffers]  = {};
+        const VkVertexInputAttributeDescription*         pAttributes[MaxVertexAttributes]  = {};
+        const VkVertexInputBindingDivisorDescriptionEXT* pDivisors[Pal::MaxVertexBuffers]  = {};
+
+        uint32_t usedBindingMask = 0;
+
+        for (uint32_t i = 0; i < desc.vertexAttributeDescriptionCount; i++)
+        {
+            const VkVertexInputAttributeDescription& attrib = desc.pVertexAttributeDescriptions[i];
+
+            pAttributes[attrib.location] = &attrib;
+            usedBindingMask |= (1u << attrib.binding);
+        }
+
+        for (uint32_t i = 0; i < desc.vertexBindingDescriptionCount; i++)
+        {
+            pBindings[desc.pVertexBindingDescriptions[i].binding] = &desc.pVertexBindingDescriptions[i];
+        }
+
+        for (uint32_t i = 0; (pDivisorState != nullptr) && (i < pDivisorState->vertexBindingDivisorCount); i++)
+        {
+            pDivisors[pDivisorState->pVertexBindingDivisors[i].binding] = &pDivisorState->pVertexBindingDivisors[i];
+        }
+
+        uint32_t bindingCount   = 0;
+        uint32_t attributeCount = 0;
+        uint32_t divisorCount   = 0;
+
+        for (uint32_t binding = 0; binding < Pal::MaxVertexBuffers; binding++)
+        {
+            if ((usedBindingMask & (1u << binding)) != 0)
+            {
+                if (pBindings[binding] != nullptr)
+                {
+                    pNormalized->bindings[bindingCount++] = *pBindings[binding];
+                }
+
+                if ((pDivisors[binding] != nullptr) && (pDivisors[binding]->divisor != 1))
+                {
+                    pNormalized->divisors[divisorCount++] = *pDivisors[binding];
+                }
+            }
+        }
+
+        for (uint32_t location = 0; location < MaxVertexAttributes; location++)
+        {
+            if (pAttributes[location] != nullptr)
+            {
+                pNormalized->attributes[attributeCount++] = *pAttributes[location];
+            }
+        }
+
+        pNormalized->divisorState.sType                     =
+            VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_DIVISOR_STATE_CREATE_INFO_EXT;
+        pNormalized->divisorState.pNext                     = nullptr;
+        pNormalized->divisorState.vertexBindingDivisorCount = divisorCount;
+        pNormalized->divisorState.pVertexBindingDivisors    = pNormalized->divisors;
+
+        pNormalized->state.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        pNormalized->state.pNext                           = (divisorCount > 0) ? &pNormalized->divisorState : nullptr;
+        pNormalized->state.flags                           = desc.flags;
+        pNormalized->state.vertexBindingDescriptionCount   = bindingCount;
+        pNormalized->state.pVertexBindingDescriptions      = pNormalized->bindings;
+        pNormalized->state.vertexAttributeDescriptionCount = attributeCount;
+        pNormalized->state.pVertexAttributeDescriptions    = pNormalized->attributes;
+
+        pState = &pNormalized->state;
+    }
+
+    return pState;
+}
+
+// =====================================================================================================================
+// Returns the attachment description of a pipeline created for dynamic rendering, or nullptr if the pipeline is
+// created against a render pass.
+const VkPipelineRenderingCreateInfoKHR* GraphicsPipeline::GetRenderingCreateInfo(
+    const VkGraphicsPipelineCreateInfo* pCreateInfo)
+{
+    const VkPipelineRenderingCreateInfoKHR* pRenderingInfo = nullptr;
+
+    if (pCreateInfo->renderPass == VK_NULL_HANDLE)
+    {
+        pRenderingInfo = GetExtensionStructure<VkPipelineRenderingCreateInfoKHR>(
+            pCreateInfo, VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR);
+    }
+
+    return pRenderingInfo;
+}
+
+// =====================================================================================================================
+// Returns the depth/stencil format of a dynamic rendering pipeline.  Both formats must match when both are given.
+VkFormat GraphicsPipeline::GetRenderingDepthStencilFormat(
+    const VkPipelineRenderingCreateInfoKHR& renderingInfo)
+{
+    VK_ASSERT((renderingInfo.depthAttachmentFormat == VK_FORMAT_UNDEFINED)   ||
+              (renderingInfo.stencilAttachmentFormat == VK_FORMAT_UNDEFINED) ||
+              (renderingInfo.depthAttachmentFormat == renderingInfo.stencilAttachmentFormat));
+
+    return (renderingInfo.depthAttachmentFormat != VK_FORMAT_UNDEFINED) ? renderingInfo.depthAttachmentFormat :
+                                                                          renderingInfo.stencilAttachmentFormat;
+}
+
 // =====================================================================================================================
 // Generates a hash using the contents of a VkPipelineVertexInputStateCreateInfo struct
 // Pipeline compilation affected by:
 //     - desc.pVertexBindingDescriptions
 //     - desc.pVertexAttributeDescriptions
 //     - pDivisorStateCreateInfo->pVertexBindingDivisors
+//
+// The canonical form of the state is hashed, so that states with the same vertex fetches hash the same.
 void GraphicsPipeline::GenerateHashFromVertexInputStateCreateInfo(
     Util::MetroHash128*                         pHasher,
-    const VkPipelineVertexInputStateCreateInfo& desc)
+    const VkPipelineVertexInputStateCreateInfo& inputDesc)
 {
+    NormalizedVertexInput                       normalized;
+    const VkPipelineVertexInputStateCreateInfo& desc = *NormalizeVertexInputState(inputDesc, &normalized);
+
     pHasher->Update(desc.flags);
     pHasher->Update(desc.vertexBindingDescriptionCount);
 
@@ -441,9 +681,11 @@ void GraphicsPipeline::GenerateHashFromColorBlendStateCreateInfo(
 //     - pCreateInfo->pRasterizationState
 //     - pCreateInfo->pMultisampleState
 //     - pCreateInfo->pColorBlendState
+//     - pCreateInfo->pDynamicState
 //     - pCreateInfo->layout
 //     - pCreateInfo->renderPass
 //     - pCreateInfo->subpass
+//     - VkPipelineRenderingCreateInfoKHR, when renderPass is VK_NULL_HANDLE
 uint64_t GraphicsPipeline::BuildApiHash(
     const VkGraphicsPipelineCreateInfo* pCreateInfo,
     const CreateInfo*                   pInfo,
@@ -503,7 +745,7 @@ uint64_t GraphicsPipeline::BuildApiHash(
 
     if (pCreateInfo->pDynamicState != nullptr)
     {
-        GenerateHashFromDynamicStateCreateInfo(&apiHasher, *pCreateInfo->pDynamicState);
+        GenerateHashFromDynamicStateCreateInfo(&baseHasher, &apiHasher, *pCreateInfo->pDynamicState);
     }
 
     baseHasher.Update(PipelineLayout::ObjectFromHandle(pCreateInfo->layout)->GetApiHash());
@@ -512,6 +754,24 @@ uint64_t GraphicsPipeline::BuildApiHash(
     {
         baseHasher.Update(RenderPass::ObjectFromHandle(pCreateInfo->renderPass)->GetHash());
     }
+    else
+    {
+        const VkPipelineRenderingCreateInfoKHR* pRenderingInfo = GetRenderingCreateInfo(pCreateInfo);
+
+        if (pRenderingInfo != nullptr)
+        {
+            baseHasher.Update(pRenderingInfo->viewMask);
+            baseHasher.Update(pRenderingInfo->colorAttachmentCount);
+
+            for (uint32_t i = 0; i < pRenderingInfo->colorAttachmentCount; ++i)
+            {
+                baseHasher.Update(pRenderingInfo->pColorAttachmentFormats[i]);
+            }
+
+            baseHasher.Update(pRenderingInfo->depthAttachmentFormat);
+            baseHasher.Update(pRenderingInfo->stencilAttachmentFormat);
+        }
+    }
 
     baseHasher.Update(pCreateInfo->subpass);
 
@@ -826,7 +1086,8 @@ void GraphicsPipeline::ConvertGraphicsPipelineInfo(
         pIn,
         GRAPHICS_PIPELINE_CREATE_INFO)
 
-    const RenderPass* pRenderPass = nullptr;
+    const RenderPass*                       pRenderPass    = nullptr;
+    const VkPipelineRenderingCreateInfoKHR* pRenderingInfo = nullptr;
 
     // Set the states which are allowed to call CmdSetxxx outside of the PSO
     bool dynamicStateFlags[uint32_t(DynamicStatesInternal::DynamicStatesInternalCount)];
@@ -842,7 +1103,8 @@ void GraphicsPipeline::ConvertGraphicsPipelineInfo(
         }
         VK_IGNORE(pGraphicsPipelineCreateInfo->flags & VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT);
 
-        pRenderPass = RenderPass::ObjectFromHandle(pGraphicsPipelineCreateInfo->renderPass);
+        pRenderPass    = RenderPass::ObjectFromHandle(pGraphicsPipelineCreateInfo->renderPass);
+        pRenderingInfo = GetRenderingCreateInfo(pGraphicsPipelineCreateInfo);
 
         if (pGraphicsPipelineCreateInfo->layout != VK_NULL_HANDLE)
         {
@@ -1319,6 +1581,11 @@ void GraphicsPipeline::ConvertGraphicsPipelineInfo(
                     cbFormat[i] = pRenderPass->GetColorAttachmentFormat(pGraphicsPipelineCreateInfo->subpass, i);
                     pCbDst->swizzledFormat = VkToPalFormat(cbFormat[i], pDevice->GetRuntimeSettings());
                 }
+                else if ((pRenderingInfo != nullptr) && (i < pRenderingInfo->colorAttachmentCount))
+                {
+                    cbFormat[i] = pRenderingInfo->pColorAttachmentFormats[i];
+                    pCbDst->swizzledFormat = VkToPalFormat(cbFormat[i], pDevice->GetRuntimeSettings());
+                }
 
                 // If the sub pass attachment format is UNDEFINED, then it means that that subpass does not
                 // want to write to any attachment for that output (VK_ATTACHMENT_UNUSED).  Under such cases,
@@ -1374,6 +1641,10 @@ void GraphicsPipeline::ConvertGraphicsPipelineInfo(
         {
             dbFormat = pRenderPass->GetDepthStencilAttachmentFormat(pGraphicsPipelineCreateInfo->subpass);
         }
+        else if (pRenderingInfo != nullptr)
+        {
+            dbFormat = GetRenderingDepthStencilFormat(*pRenderingInfo);
+        }
 
         // If the sub pass attachment format is UNDEFINED, then it means that that subpass does not
         // want to write any depth-stencil data (VK_ATTACHMENT_UNUSED).  Under such cases, I think we have to
@@ -1450,7 +1721,9 @@ void GraphicsPipeline::ConvertGraphicsPipelineInfo(
         pInfo->pipeline.viewInstancingDesc = Pal::ViewInstancingDescriptor { };
 
         if (((pRenderPass != nullptr) &&
-             pRenderPass->IsMultiviewEnabled())
+             pRenderPass->IsMultiviewEnabled()) ||
+            ((pRenderingInfo != nullptr) &&
+             (pRenderingInfo->viewMask != 0))
             )
         {
             pInfo->pipeline.viewInstancingDesc.viewInstanceCount = Pal::MaxViewInstanceCount;
@@ -1464,6 +1737,48 @@ void GraphicsPipeline::ConvertGraphicsPipelineInfo(
     }
 }
 
+// =====================================================================================================================
+// Prefetches the binaries of a batched create call which can be found by their API hash, so that the entries of the
+// batch don't each take the cache locks and go down to the archives on their own.  Only computes the API hashes; the
+// entries are still created by Create().
+void GraphicsPipeline::PrefetchBinaries(
+    Device*                                 pDevice,
+    PipelineCache*                          pPipelineCache,
+    uint32_t                                count,
+    const VkGraphicsPipelineCreateInfo*     pCreateInfos)
+{
+    // Create() only looks binaries up by API hash with a single device.
+    if (pDevice->NumPalDevices() == 1)
+    {
+        PalAllocator* pAllocator = pDevice->VkInstance()->Allocator();
+
+        Util::AutoBuffer<VkPipelineCreateFlags, 16, PalAllocator> flags(count, pAllocator);
+        Util::AutoBuffer<Util::MetroHash::Hash, 16, PalAllocator> baseHashes(count, pAllocator);
+
+        if ((flags.Capacity() >= count) && (baseHashes.Capacity() >= count))
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                CreateInfo    localPipelineInfo = {};
+                VbBindingInfo vbInfo            = {};
+
+                ConvertGraphicsPipelineInfo(pDevice, &pCreateInfos[i], &vbInfo, &localPipelineInfo);
+                BuildApiHash(&pCreateInfos[i], &localPipelineInfo, &baseHashes[i]);
+
+                flags[i] = pCreateInfos[i].flags;
+            }
+
+            pDevice->GetCompiler(DefaultDeviceIndex)->PrefetchGraphicsPipelineBinaries(
+                pDevice,
+                DefaultDeviceIndex,
+                pPipelineCache,
+                count,
+                &flags[0],
+                &baseHashes[0]);
+        }
+    }
+}
+
 // =====================================================================================================================
 // Create a graphics pipeline object.
 VkResult GraphicsPipeline::Create(
@@ -1489,11 +1804,53 @@ VkResult GraphicsPipeline::Create(
 
     const VkPipelineCreationFeedbackCreateInfoEXT* pPipelineCreationFeadbackCreateInfo = nullptr;
 
-    VkResult result = pDefaultCompiler->ConvertGraphicsPipelineInfo(
-        pDevice, pCreateInfo, &binaryCreateInfo, &vbInfo, &pPipelineCreationFeadbackCreateInfo);
+    VkResult result = VK_SUCCESS;
 
+    // The API hash only reads the Vulkan create info, so it is built before the create info is converted to LLPC build
+    // info.  The vertex buffer count is filled in below, once the vertex buffer bindings are known.
     ConvertGraphicsPipelineInfo(pDevice, pCreateInfo, &vbInfo, &localPipelineInfo);
 
+    uint64_t apiPsoHash = BuildApiHash(pCreateInfo, &localPipelineInfo, &binaryCreateInfo.basePipelineHash);
+
+    const uint32_t numPalDevices = pDevice->NumPalDevices();
+
+    // On a warm cache the binary can be found by the API hash alone, which skips the conversion to LLPC build info and
+    // the hashing of it.  Each device in a multi-GPU setup may need a different binary, so those always take the full
+    // path.
+    uint64_t pipelineHash      = 0;
+    bool     isApiHashCacheHit = false;
+
+    if (numPalDevices == 1)
+    {
+        binaryCreateInfo.flags = pCreateInfo->flags;
+
+        isApiHashCacheHit = pDefaultCompiler->LoadGraphicsPipelineBinaryByApiHash(
+            pDevice,
+            DefaultDeviceIndex,
+            pPipelineCache,
+            binaryCreateInfo.basePipelineHash,
+            &binaryCreateInfo,
+            &vbInfo,
+            &pipelineHash,
+            &pipelineBinarySizes[DefaultDeviceIndex],
+            &pPipelineBinaries[DefaultDeviceIndex],
+            &cacheId[DefaultDeviceIndex]);
+    }
+
+    if (isApiHashCacheHit)
+    {
+        pDefaultCompiler->GetPipelineCreationInfoNext(
+            static_cast<const VkStructHeader*>(pCreateInfo->pNext),
+            &pPipelineCreationFeadbackCreateInfo);
+    }
+    else
+    {
+        result = pDefaultCompiler->ConvertGraphicsPipelineInfo(
+            pDevice, pCreateInfo, &binaryCreateInfo, &vbInfo, &pPipelineCreationFeadbackCreateInfo);
+    }
+
+    localPipelineInfo.pipeline.iaState.vertexBufferCount = vbInfo.bindingTableSize;
+
     // PAL internally disables dual-source blending when the blend func is min or max. In cases when it will be disabled, we should
     // overwrite dual source blending option so the pipeline is compiled with the correct value. This avoids a mismatch in how data
     // comes out of shaders and how the CB expects to see the data.
@@ -1506,12 +1863,12 @@ VkResult GraphicsPipeline::Create(
         binaryCreateInfo.pipelineInfo.cbState.dualSourceBlendEnable = false;
     }
 
-    uint64_t apiPsoHash = BuildApiHash(pCreateInfo, &localPipelineInfo, &binaryCreateInfo.basePipelineHash);
-
-    const uint32_t numPalDevices = pDevice->NumPalDevices();
+    if (isApiHashCacheHit == false)
+    {
+        pipelineHash = Vkgc::IPipelineDumper::GetPipelineHash(&binaryCreateInfo.pipelineInfo);
+    }
 
-    uint64_t pipelineHash = Vkgc::IPipelineDumper::GetPipelineHash(&binaryCreateInfo.pipelineInfo);
-    for (uint32_t i = 0; (result == VK_SUCCESS) && (i < numPalDevices)
+    for (uint32_t i = 0; (result == VK_SUCCESS) && (isApiHashCacheHit == false) && (i < numPalDevices)
         ; ++i)
     {
         if (i == DefaultDeviceIndex)
@@ -1525,6 +1882,18 @@ VkResult GraphicsPipeline::Create(
                 &pPipelineBinaries[i],
                 localPipelineInfo.rasterizationStream,
                 &cacheId[i]);
+
+            if ((result == VK_SUCCESS) && (numPalDevices == 1))
+            {
+                pDevice->GetCompiler(i)->RegisterGraphicsPipelineApiHash(
+                    pDevice,
+                    i,
+                    binaryCreateInfo.basePipelineHash,
+                    binaryCreateInfo,
+                    vbInfo,
+                    pipelineHash,
+                    cacheId[i]);
+            }
         }
         else
         {
@@ -1617,11 +1986,16 @@ VkResult GraphicsPipeline::Create(
                     localPipelineInfo.pipeline.pPipelineBinary    = pPipelineBinaries[deviceIdx];
                 }
 
+                const int64_t uploadStartTime = Util::GetPerfCpuTime();
+
                 palResult = pPalDevice->CreateGraphicsPipeline(
                     localPipelineInfo.pipeline,
                     Util::VoidPtrInc(pSystemMem, palOffset),
                     &pPalPipeline[deviceIdx]);
 
+                pDevice->GetCompiler(deviceIdx)->GetCompileStats()->RecordStageTime(
+                    PipelineCompileStats::Stage::Upload, Util::GetPerfCpuTime() - uploadStartTime);
+
 #if ICD_GPUOPEN_DEVMODE_BUILD
                 // Temporarily reinject post Pal pipeline creation (when the internal pipeline hash is available).
                 // The reinjection cache layer can be linked back into the pipeline cache chain once the
@@ -1810,6 +2184,25 @@ VkResult GraphicsPipeline::Create(
 
         // The hash is same as pipline dump file name, we can easily analyze further.
         AmdvlkLog(settings.logTagIdMask, PipelineCompileTime, "0x%016llX-%llu", pipelineHash, duration);
+
+        if (pDevice->GetPipelineCompileEventLog()->IsEnabled())
+        {
+            PipelineCompileEvent event = {};
+
+            event.apiHash      = apiPsoHash;
+            event.pipelineHash = pipelineHash;
+            event.durationNs   = duration;
+            event.binarySize   = pipelineBinarySizes[DefaultDeviceIndex];
+            event.source       = binaryCreateInfo.binarySource;
+            event.stages       = localPipelineInfo.activeStages;
+
+            pDevice->GetPipelineCompileEventLog()->Record(event);
+        }
+
+        if (pDevice->GetPipelineStatsProfile() != nullptr)
+        {
+            pDevice->GetPipelineStatsProfile()->RegisterPipeline(apiPsoHash, binaryCreateInfo.pipelineProfileKey);
+        }
     }
 
     return result;
@@ -1858,8 +2251,33 @@ GraphicsPipeline::GraphicsPipeline(
     m_flags.force1x1ShaderRate       = force1x1ShaderRate;
     CreateStaticState();
 
-    pPalPipelineHasher->Update(m_palPipelineHash);
-    pPalPipelineHasher->Finalize(reinterpret_cast<uint8* const>(&m_palPipelineHash));
+    pPalPipelineHasher->Update(m_palPipelines.palPipelineHash);
+    pPalPipelineHasher->Finalize(reinterpret_cast<uint8* const>(&m_palPipelines.palPipelineHash));
+}
+
+// =====================================================================================================================
+// The MSAA state and the shading rate override are chosen from the pixel shader of the PAL pipeline at creation, so
+// another build may only be used if it led to the same choices.
+bool GraphicsPipeline::CanUsePalPipelinesOf(
+    const Pipeline* pSource) const
+{
+    bool canUse = Pipeline::CanUsePalPipelinesOf(pSource);
+
+    if (canUse)
+    {
+        const GraphicsPipeline* pOther = static_cast<const GraphicsPipeline*>(pSource);
+
+        canUse = (m_flags.force1x1ShaderRate == pOther->m_flags.force1x1ShaderRate);
+
+        // The render state cache hands out one MSAA state object per create info.  Without the cache the objects never
+        // compare equal and the pipeline keeps its own build.
+        for (uint32_t deviceIdx = 0; canUse && (deviceIdx < m_pDevice->NumPalDevices()); deviceIdx++)
+        {
+            canUse = (m_pPalMsaa[deviceIdx] == pOther->m_pPalMsaa[deviceIdx]);
+        }
+    }
+
+    return canUse;
 }
 
 // =====================================================================================================================
@@ -1882,6 +2300,7 @@ void GraphicsPipeline::CreateStaticState()
     pStaticTokens->lineStippleState           = DynamicRenderStateToken;
 
     pStaticTokens->fragmentShadingRate        = DynamicRenderStateToken;
+    pStaticTokens->staticStateBundle          = DynamicRenderStateToken;
 
     if (m_flags.bindInputAssemblyState)
     {
@@ -1939,6 +2358,61 @@ void GraphicsPipeline::CreateStaticState()
         pStaticTokens->fragmentShadingRate =
             pCache->CreateFragmentShadingRate(m_info.vrsRateParams);
     }
+
+    // The bundle token is only meaningful if every piece of static state it covers has a real token.  A dynamic token
+    // here means that state is not cached and must be reprogrammed on every bind.
+    const bool allStateCached =
+        ((m_flags.bindInputAssemblyState == false) || (pStaticTokens->inputAssemblyState != DynamicRenderStateToken)) &&
+        ((m_flags.bindTriangleRasterState == false) || (pStaticTokens->triangleRasterState != DynamicRenderStateToken)) &&
+        (ContainsDynamicState(DynamicStatesInternal::LineWidth) ||
+         (pStaticTokens->pointLineRasterState != DynamicRenderStateToken)) &&
+        (ContainsDynamicState(DynamicStatesInternal::DepthBias) ||
+         (pStaticTokens->depthBias != DynamicRenderStateToken)) &&
+        (ContainsDynamicState(DynamicStatesInternal::BlendConstants) ||
+         (pStaticTokens->blendConst != DynamicRenderStateToken)) &&
+        (ContainsDynamicState(DynamicStatesInternal::DepthBounds) ||
+         (pStaticTokens->depthBounds != DynamicRenderStateToken)) &&
+        (ContainsDynamicState(DynamicStatesInternal::SampleLocationsExt) ||
+         (pStaticTokens->samplePattern != DynamicRenderStateToken)) &&
+        (ContainsDynamicState(DynamicStatesInternal::LineStippleExt) ||
+         (pStaticTokens->lineStippleState != DynamicRenderStateToken)) &&
+        (ContainsDynamicState(DynamicStatesInternal::FragmentShadingRateStateKhr) ||
+         (pStaticTokens->fragmentShadingRate != DynamicRenderStateToken));
+
+    if (allStateCached)
+    {
+        StaticStateBundleKey key;
+
+        BuildStaticStateBundleKey(&key);
+
+        pStaticTokens->staticStateBundle = pCache->CreateStaticStateBundle(key);
+    }
+}
+
+// =====================================================================================================================
+// Fills in the key identifying this pipeline's static state bundle in the render state cache.
+void GraphicsPipeline::BuildStaticStateBundleKey(
+    StaticStateBundleKey* pKey
+    ) const
+{
+    memset(pKey, 0, sizeof(*pKey));
+
+    pKey->pMsaaState           = m_pPalMsaa[0];
+    pKey->pColorBlendState     = m_pPalColorBlend[0];
+    pKey->pDepthStencilState   = m_flags.bindDepthStencilObject ? m_pPalDepthStencil[0] : nullptr;
+    pKey->staticStateMask      = m_staticStateMask;
+    pKey->bindFlags            = (m_flags.bindDepthStencilObject  ? 0x1 : 0) |
+                                 (m_flags.bindTriangleRasterState ? 0x2 : 0) |
+                                 (m_flags.bindInputAssemblyState  ? 0x4 : 0);
+    pKey->inputAssemblyState   = m_info.staticTokens.inputAssemblyState;
+    pKey->triangleRasterState  = m_info.staticTokens.triangleRasterState;
+    pKey->pointLineRasterState = m_info.staticTokens.pointLineRasterState;
+    pKey->lineStippleState     = m_info.staticTokens.lineStippleState;
+    pKey->depthBias            = m_info.staticTokens.depthBias;
+    pKey->blendConst           = m_info.staticTokens.blendConst;
+    pKey->depthBounds          = m_info.staticTokens.depthBounds;
+    pKey->samplePattern        = m_info.staticTokens.samplePattern;
+    pKey->fragmentShadingRate  = m_info.staticTokens.fragmentShadingRate;
 }
 
 // =====================================================================================================================
@@ -1948,6 +2422,16 @@ void GraphicsPipeline::DestroyStaticState(
 {
     RenderStateCache* pCache = m_pDevice->GetRenderStateCache();
 
+    // The bundle key refers to the state objects, so release it before they are destroyed.
+    if (m_info.staticTokens.staticStateBundle != DynamicRenderStateToken)
+    {
+        StaticStateBundleKey key;
+
+        BuildStaticStateBundleKey(&key);
+
+        pCache->DestroyStaticStateBundle(key, m_info.staticTokens.staticStateBundle);
+    }
+
     pCache->DestroyMsaaState(m_pPalMsaa, pAllocator);
     pCache->DestroyColorBlendState(m_pPalColorBlend, pAllocator);
 
@@ -2021,6 +2505,9 @@ void GraphicsPipeline::BindToCmdBuffer(
     // Get the old static tokens.  Copy these by value because in MGPU cases we update the new token state in a loop.
     const auto oldTokens = pRenderState->staticTokens;
 
+    // Number of state groups which already match the previous bind and are left untouched.
+    uint32_t skippedGroups = 0;
+
     // Program static pipeline state.
 
     // This code will attempt to skip programming state state based on redundant value checks.  These checks are often
@@ -2033,6 +2520,10 @@ void GraphicsPipeline::BindToCmdBuffer(
         {
             pCmdBuffer->SetAllViewports(m_info.viewportParams, newTokens.viewport);
         }
+        else
+        {
+            skippedGroups++;
+        }
     }
     else if (ContainsStaticState(DynamicStatesInternal::ViewportCount))
     {
@@ -2052,6 +2543,10 @@ void GraphicsPipeline::BindToCmdBuffer(
         {
             pCmdBuffer->SetAllScissors(m_info.scissorRectParams, newTokens.scissorRect);
         }
+        else
+        {
+            skippedGroups++;
+        }
     }
     else if (ContainsStaticState(DynamicStatesInternal::ScissorCount))
     {
@@ -2132,22 +2627,41 @@ void GraphicsPipeline::BindToCmdBuffer(
     if (m_flags.bindTriangleRasterState == false)
     {
         // Update the static states to renderState
-        pRenderState->triangleRasterState.frontFillMode   = m_info.triangleRasterState.frontFillMode;
-        pRenderState->triangleRasterState.backFillMode    = m_info.triangleRasterState.backFillMode;
-        pRenderState->triangleRasterState.provokingVertex = m_info.triangleRasterState.provokingVertex;
-        pRenderState->triangleRasterState.flags.u32All    = m_info.triangleRasterState.flags.u32All;
+        Pal::TriangleRasterStateParams* pRasterState = &(pRenderState->triangleRasterState);
+
+        const Pal::TriangleRasterStateParams prevRasterState = *pRasterState;
+
+        pRasterState->frontFillMode   = m_info.triangleRasterState.frontFillMode;
+        pRasterState->backFillMode    = m_info.triangleRasterState.backFillMode;
+        pRasterState->provokingVertex = m_info.triangleRasterState.provokingVertex;
+        pRasterState->flags.u32All    = m_info.triangleRasterState.flags.u32All;
 
         if (ContainsStaticState(DynamicStatesInternal::FrontFaceExt))
         {
-            pRenderState->triangleRasterState.frontFace = m_info.triangleRasterState.frontFace;
+            pRasterState->frontFace = m_info.triangleRasterState.frontFace;
         }
 
         if (ContainsStaticState(DynamicStatesInternal::CullModeExt))
         {
-            pRenderState->triangleRasterState.cullMode = m_info.triangleRasterState.cullMode;
+            pRasterState->cullMode = m_info.triangleRasterState.cullMode;
         }
 
-        pRenderState->dirty.rasterState = 1;
+        // Only revalidate if the merged state differs from what PAL has (or will be given at the next draw).
+        if ((pRenderState->known.rasterState == 0)                             ||
+            (pRasterState->frontFillMode   != prevRasterState.frontFillMode)   ||
+            (pRasterState->backFillMode    != prevRasterState.backFillMode)    ||
+            (pRasterState->provokingVertex != prevRasterState.provokingVertex) ||
+            (pRasterState->flags.u32All    != prevRasterState.flags.u32All)    ||
+            (pRasterState->frontFace       != prevRasterState.frontFace)       ||
+            (pRasterState->cullMode        != prevRasterState.cullMode))
+        {
+            pRenderState->dirty.rasterState = 1;
+            pRenderState->known.rasterState = 1;
+        }
+        else
+        {
+            skippedGroups++;
+        }
     }
     else
     {
@@ -2191,25 +2705,50 @@ void GraphicsPipeline::BindToCmdBuffer(
     {
         pRenderState->dirty.stencilRef = 1;
     }
+    else
+    {
+        skippedGroups++;
+    }
 
     if (m_flags.bindInputAssemblyState == false)
     {
-        // Update the static states to renderState
-        pRenderState->inputAssemblyState.primitiveRestartIndex =
-            m_info.inputAssemblyState.primitiveRestartIndex;
+        Pal::InputAssemblyStateParams* pInputAssembly = &(pRenderState->inputAssemblyState);
 
-        pRenderState->inputAssemblyState.primitiveRestartEnable =
-            m_info.inputAssemblyState.primitiveRestartEnable;
+        if ((pRenderState->known.inputAssembly == 0) ||
+            (pInputAssembly->primitiveRestartIndex  != m_info.inputAssemblyState.primitiveRestartIndex) ||
+            (pInputAssembly->primitiveRestartEnable != m_info.inputAssemblyState.primitiveRestartEnable))
+        {
+            // Update the static states to renderState
+            pInputAssembly->primitiveRestartIndex  = m_info.inputAssemblyState.primitiveRestartIndex;
+            pInputAssembly->primitiveRestartEnable = m_info.inputAssemblyState.primitiveRestartEnable;
 
-        pRenderState->dirty.inputAssembly = 1;
+            pRenderState->dirty.inputAssembly = 1;
+            pRenderState->known.inputAssembly = 1;
+        }
+        else
+        {
+            skippedGroups++;
+        }
     }
     else
     {
         pRenderState->inputAssemblyState = m_info.inputAssemblyState;
     }
 
+    const PalPipelineSet* pPalPipelines = GetPalPipelines();
+
     const uint64_t oldHash = pRenderState->boundGraphicsPipelineHash;
-    const uint64_t newHash = PalPipelineHash();
+    const uint64_t newHash = pPalPipelines->palPipelineHash;
+
+    // If the previous pipeline bound the same static state bundle and nothing has overridden any part of it since, all
+    // of the state objects and static parameters below are already programmed.
+    const bool sameBundle = (newTokens.staticStateBundle != DynamicRenderStateToken) &&
+                            (oldTokens.staticStateBundle == newTokens.staticStateBundle);
+
+    if (sameBundle)
+    {
+        skippedGroups++;
+    }
 
     utils::IterateMask deviceGroup(pCmdBuffer->GetDeviceMask());
     do
@@ -2226,7 +2765,7 @@ void GraphicsPipeline::BindToCmdBuffer(
                 Pal::PipelineBindParams params = {};
 
                 params.pipelineBindPoint = Pal::PipelineBindPoint::Graphics;
-                params.pPipeline         = m_pPalPipeline[deviceIdx];
+                params.pPipeline         = pPalPipelines->pPalPipeline[deviceIdx];
                 params.graphics          = graphicsShaderInfos;
                 params.apiPsoHash = m_apiHash;
 
@@ -2247,86 +2786,97 @@ void GraphicsPipeline::BindToCmdBuffer(
             Pal::PipelineBindParams params = {};
 
             params.pipelineBindPoint = Pal::PipelineBindPoint::Graphics;
-            params.pPipeline         = m_pPalPipeline[deviceIdx];
+            params.pPipeline         = pPalPipelines->pPalPipeline[deviceIdx];
             params.graphics          = graphicsShaderInfos;
             params.apiPsoHash = m_apiHash;
 
             pPalCmdBuf->CmdBindPipeline(params);
         }
 
-        // Bind state objects that are always static; these are redundancy checked by the pointer in the command buffer.
-        if (m_flags.bindDepthStencilObject)
+        if (sameBundle == false)
         {
-            pCmdBuffer->PalCmdBindDepthStencilState(pPalCmdBuf, deviceIdx, m_pPalDepthStencil[deviceIdx]);
+            // Bind state objects that are always static; these are redundancy checked by the pointer in the command
+            // buffer.
+            if (m_flags.bindDepthStencilObject)
+            {
+                pCmdBuffer->PalCmdBindDepthStencilState(pPalCmdBuf, deviceIdx, m_pPalDepthStencil[deviceIdx]);
 
-            pRenderState->dirty.depthStencil = 0;
-        }
+                pRenderState->dirty.depthStencil = 0;
+            }
 
-        pCmdBuffer->PalCmdBindColorBlendState(pPalCmdBuf, deviceIdx, m_pPalColorBlend[deviceIdx]);
-        pCmdBuffer->PalCmdBindMsaaState(pPalCmdBuf, deviceIdx, m_pPalMsaa[deviceIdx]);
+            pCmdBuffer->PalCmdBindColorBlendState(pPalCmdBuf, deviceIdx, m_pPalColorBlend[deviceIdx]);
+            pCmdBuffer->PalCmdBindMsaaState(pPalCmdBuf, deviceIdx, m_pPalMsaa[deviceIdx]);
 
-        // Write parameters that are marked static pipeline state.  Redundancy check these based on static tokens:
-        // skip the write if the previously written static token matches.
+            // Write parameters that are marked static pipeline state.  Redundancy check these based on static tokens:
+            // skip the write if the previously written static token matches.
 
-        if (CmdBuffer::IsStaticStateDifferent(oldTokens.inputAssemblyState, newTokens.inputAssemblyState) &&
-                m_flags.bindInputAssemblyState)
-        {
-            pPalCmdBuf->CmdSetInputAssemblyState(m_info.inputAssemblyState);
+            if (CmdBuffer::IsStaticStateDifferent(oldTokens.inputAssemblyState, newTokens.inputAssemblyState) &&
+                    m_flags.bindInputAssemblyState)
+            {
+                pPalCmdBuf->CmdSetInputAssemblyState(m_info.inputAssemblyState);
 
-            pRenderState->staticTokens.inputAssemblyState = newTokens.inputAssemblyState;
-            pRenderState->dirty.inputAssembly             = 0;
-        }
+                pRenderState->staticTokens.inputAssemblyState = newTokens.inputAssemblyState;
+                pRenderState->dirty.inputAssembly             = 0;
+                pRenderState->known.inputAssembly             = 1;
+            }
 
-        if (CmdBuffer::IsStaticStateDifferent(oldTokens.triangleRasterState, newTokens.triangleRasterState) &&
-                m_flags.bindTriangleRasterState)
-        {
-            pPalCmdBuf->CmdSetTriangleRasterState(m_info.triangleRasterState);
+            if (CmdBuffer::IsStaticStateDifferent(oldTokens.triangleRasterState, newTokens.triangleRasterState) &&
+                    m_flags.bindTriangleRasterState)
+            {
+                pPalCmdBuf->CmdSetTriangleRasterState(m_info.triangleRasterState);
 
-            pRenderState->staticTokens.triangleRasterState = newTokens.triangleRasterState;
-            pRenderState->dirty.rasterState                = 0;
-        }
+                pRenderState->staticTokens.triangleRasterState = newTokens.triangleRasterState;
+                pRenderState->dirty.rasterState                = 0;
+                pRenderState->known.rasterState                = 1;
+            }
 
-        if (ContainsStaticState(DynamicStatesInternal::LineWidth) &&
-            CmdBuffer::IsStaticStateDifferent(oldTokens.pointLineRasterState, newTokens.pointLineRasterState))
-        {
-            pPalCmdBuf->CmdSetPointLineRasterState(m_info.pointLineRasterParams);
-            pRenderState->staticTokens.pointLineRasterState = newTokens.pointLineRasterState;
-        }
+            if (ContainsStaticState(DynamicStatesInternal::LineWidth) &&
+                CmdBuffer::IsStaticStateDifferent(oldTokens.pointLineRasterState, newTokens.pointLineRasterState))
+            {
+                pPalCmdBuf->CmdSetPointLineRasterState(m_info.pointLineRasterParams);
+                pRenderState->staticTokens.pointLineRasterState = newTokens.pointLineRasterState;
+            }
 
-        if (ContainsStaticState(DynamicStatesInternal::LineStippleExt) &&
-            CmdBuffer::IsStaticStateDifferent(oldTokens.lineStippleState, newTokens.lineStippleState))
-        {
-            pPalCmdBuf->CmdSetLineStippleState(m_info.lineStippleParams);
-            pRenderState->staticTokens.lineStippleState = newTokens.lineStippleState;
-        }
+            if (ContainsStaticState(DynamicStatesInternal::LineStippleExt) &&
+                CmdBuffer::IsStaticStateDifferent(oldTokens.lineStippleState, newTokens.lineStippleState))
+            {
+                pPalCmdBuf->CmdSetLineStippleState(m_info.lineStippleParams);
+                pRenderState->staticTokens.lineStippleState = newTokens.lineStippleState;
+            }
 
-        if (ContainsStaticState(DynamicStatesInternal::DepthBias) &&
-            CmdBuffer::IsStaticStateDifferent(oldTokens.depthBiasState, newTokens.depthBias))
-        {
-            pPalCmdBuf->CmdSetDepthBiasState(m_info.depthBiasParams);
-            pRenderState->staticTokens.depthBiasState = newTokens.depthBias;
-        }
+            if (ContainsStaticState(DynamicStatesInternal::DepthBias) &&
+                CmdBuffer::IsStaticStateDifferent(oldTokens.depthBiasState, newTokens.depthBias))
+            {
+                pPalCmdBuf->CmdSetDepthBiasState(m_info.depthBiasParams);
+                pRenderState->staticTokens.depthBiasState = newTokens.depthBias;
+            }
 
-        if (ContainsStaticState(DynamicStatesInternal::BlendConstants) &&
-            CmdBuffer::IsStaticStateDifferent(oldTokens.blendConst, newTokens.blendConst))
-        {
-            pPalCmdBuf->CmdSetBlendConst(m_info.blendConstParams);
-            pRenderState->staticTokens.blendConst = newTokens.blendConst;
-        }
+            if (ContainsStaticState(DynamicStatesInternal::BlendConstants) &&
+                CmdBuffer::IsStaticStateDifferent(oldTokens.blendConst, newTokens.blendConst))
+            {
+                pPalCmdBuf->CmdSetBlendConst(m_info.blendConstParams);
+                pRenderState->staticTokens.blendConst = newTokens.blendConst;
+            }
 
-        if (ContainsStaticState(DynamicStatesInternal::DepthBounds) &&
-            CmdBuffer::IsStaticStateDifferent(oldTokens.depthBounds, newTokens.depthBounds))
-        {
-            pPalCmdBuf->CmdSetDepthBounds(m_info.depthBoundParams);
-            pRenderState->staticTokens.depthBounds = newTokens.depthBounds;
-        }
+            if (ContainsStaticState(DynamicStatesInternal::DepthBounds) &&
+                CmdBuffer::IsStaticStateDifferent(oldTokens.depthBounds, newTokens.depthBounds))
+            {
+                pPalCmdBuf->CmdSetDepthBounds(m_info.depthBoundParams);
+                pRenderState->staticTokens.depthBounds = newTokens.depthBounds;
+            }
 
-        if (ContainsStaticState(DynamicStatesInternal::SampleLocationsExt) &&
-            CmdBuffer::IsStaticStateDifferent(oldTokens.samplePattern, newTokens.samplePattern))
+            if (ContainsStaticState(DynamicStatesInternal::SampleLocationsExt) &&
+                CmdBuffer::IsStaticStateDifferent(oldTokens.samplePattern, newTokens.samplePattern))
+            {
+                pCmdBuffer->PalCmdSetMsaaQuadSamplePattern(
+                    m_info.samplePattern.sampleCount, m_info.samplePattern.locations);
+                pRenderState->staticTokens.samplePattern = newTokens.samplePattern;
+            }
+        }
+        else if (m_flags.bindDepthStencilObject)
         {
-            pCmdBuffer->PalCmdSetMsaaQuadSamplePattern(
-                m_info.samplePattern.sampleCount, m_info.samplePattern.locations);
-            pRenderState->staticTokens.samplePattern = newTokens.samplePattern;
+            // The bundle guarantees this pipeline's depth-stencil object is still bound.
+            pRenderState->dirty.depthStencil = 0;
         }
 
         if (ContainsStaticState(DynamicStatesInternal::ColorWriteEnableExt))
@@ -2342,7 +2892,8 @@ void GraphicsPipeline::BindToCmdBuffer(
         }
 
         // Only set the Fragment Shading Rate if the dynamic state is not set.
-        if (ContainsStaticState(DynamicStatesInternal::FragmentShadingRateStateKhr) &&
+        if ((sameBundle == false) &&
+            ContainsStaticState(DynamicStatesInternal::FragmentShadingRateStateKhr) &&
             CmdBuffer::IsStaticStateDifferent(oldTokens.fragmentShadingRate, newTokens.fragmentShadingRate))
         {
             pPalCmdBuf->CmdSetPerDrawVrsRate(m_info.vrsRateParams);
@@ -2353,7 +2904,10 @@ void GraphicsPipeline::BindToCmdBuffer(
     }
     while (deviceGroup.IterateNext());
 
-    pRenderState->boundGraphicsPipelineHash = newHash;
+    pRenderState->staticTokens.staticStateBundle = newTokens.staticStateBundle;
+    pRenderState->boundGraphicsPipelineHash      = newHash;
+
+    pCmdBuffer->RecordSkippedStateGroups(skippedGroups);
 
     // Binding GraphicsPipeline affects ViewMask,
     // because when VK_PIPELINE_CREATE_VIEW_INDEX_FROM_DEVICE_INDEX_BIT is specified
@@ -35,6 +35,7 @@
 #include "include/vk_formats.h"
 #include "include/vk_graphics_pipeline.h"
 #include "include/vk_image.h"
+#include "include/image_create_info_cache.h"
 #include "include/vk_instance.h"
 #include "include/vk_memory.h"
 #include "include/vk_swapchain.h"
@@ -195,7 +196,11 @@ Image::Image(
         extraLayoutUsages),
     m_pSwapChain(nullptr),
     m_pImageMemory(nullptr),
-    m_ResourceKey(resourceKey)
+    m_ResourceKey(resourceKey),
+    m_memoryRequirements(),
+    m_pViewSrdCache(nullptr),
+    m_viewSrdCacheCount(0),
+    m_committedLayouts()
 {
     m_internalFlags.u32All = internalFlags.u32All;
 
@@ -488,8 +493,28 @@ VkResult Image::Create(
     const VkAllocationCallbacks*    pAllocator,
     VkImage*                        pImage)
 {
+    ImageCreateInfoCache* pCreateInfoCache = pDevice->GetImageCreateInfoCache();
+
+    ImageCreateInfoKey       cacheKey      = {};
+    ConvertedImageCreateInfo convertedInfo = {};
+
+    // Descriptions seen before skip the conversion below as well as the PAL image size and memory requirements queries
+    const bool cacheable = pCreateInfoCache->BuildKey(pCreateInfo, &cacheKey);
+
+    if (cacheable && pCreateInfoCache->Find(cacheKey, &convertedInfo))
+    {
+        VkResult cachedResult = CreateFromConvertedInfo(pDevice, pCreateInfo, pAllocator, &convertedInfo, pImage);
+
+        if (cachedResult == VK_SUCCESS)
+        {
+            Image::ObjectFromHandle(*pImage)->SetMemoryRequirements(convertedInfo.memReqs);
+        }
+
+        return cachedResult;
+    }
+
     // Convert input create info
-    Pal::ImageCreateInfo palCreateInfo  = {};
+    Pal::ImageCreateInfo& palCreateInfo = convertedInfo.palCreateInfo;
     Pal::PresentableImageCreateInfo presentImageCreateInfo = {};
 
     const RuntimeSettings& settings          = pDevice->GetRuntimeSettings();
@@ -501,7 +526,6 @@ VkResult Image::Create(
 
     imageFlags.u32All = 0;
 
-    const uint32_t numDevices            = pDevice->NumPalDevices();
     const bool     isSparse              = (pCreateInfo->flags & SparseEnablingFlags) != 0;
     const bool     hasDepthStencilAspect = Formats::IsDepthStencilFormat(createInfoFormat);
     VkResult       result                = VK_SUCCESS;
@@ -836,14 +860,62 @@ VkResult Image::Create(
         return result;
     }
 
+    if (result == VK_SUCCESS)
+    {
+        convertedInfo.imageFlags   = imageFlags.u32All;
+        convertedInfo.stencilUsage = stencilUsage;
+        convertedInfo.sharingMode  = imageSharingMode;
+        convertedInfo.resourceKey  = resourceKey;
+
+        result = CreateFromConvertedInfo(pDevice, pCreateInfo, pAllocator, &convertedInfo, pImage);
+    }
+
+    if ((result == VK_SUCCESS) && cacheable)
+    {
+        Image* pNewImage = Image::ObjectFromHandle(*pImage);
+
+        pNewImage->CalcMemoryRequirements(pDevice, &convertedInfo.memReqs);
+        pNewImage->SetMemoryRequirements(convertedInfo.memReqs);
+
+        pCreateInfoCache->Insert(cacheKey, convertedInfo);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Creates the PAL images and the API image object from a converted create info, which may come from the image create
+// info cache.
+VkResult Image::CreateFromConvertedInfo(
+    Device*                         pDevice,
+    const VkImageCreateInfo*        pCreateInfo,
+    const VkAllocationCallbacks*    pAllocator,
+    ConvertedImageCreateInfo*       pInfo,
+    VkImage*                        pImage)
+{
+    const Pal::ImageCreateInfo& palCreateInfo    = pInfo->palCreateInfo;
+    const VkFormat              createInfoFormat = pCreateInfo->format;
+    const VkImageUsageFlags     stencilUsage     = pInfo->stencilUsage;
+    const uint32_t              numDevices       = pDevice->NumPalDevices();
+    const bool                  isSparse         = (pCreateInfo->flags & SparseEnablingFlags) != 0;
+    VkResult                    result           = VK_SUCCESS;
+    ImageFlags                  imageFlags;
+
+    imageFlags.u32All = pInfo->imageFlags;
+
     // Calculate required system memory size
     const size_t apiSize   = ObjectSize(pDevice);
     size_t       totalSize = apiSize;
     void*        pMemory   = nullptr;
     Pal::Result  palResult = Pal::Result::Success;
 
-    const size_t palImgSize = pDevice->PalDevice(DefaultDeviceIndex)->GetImageSize(palCreateInfo, &palResult);
-    VK_ASSERT(palResult == Pal::Result::Success);
+    if (pInfo->palImageSize == 0)
+    {
+        pInfo->palImageSize = pDevice->PalDevice(DefaultDeviceIndex)->GetImageSize(palCreateInfo, &palResult);
+        VK_ASSERT(palResult == Pal::Result::Success);
+    }
+
+    const size_t palImgSize = pInfo->palImageSize;
 
     if (result == VK_SUCCESS)
     {
@@ -923,7 +995,7 @@ VkResult Image::Create(
             pPalImages,
             pSparseMemory,
             pCreateInfo->usage | stencilUsage,
-            imageSharingMode,
+            pInfo->sharingMode,
             pCreateInfo->queueFamilyIndexCount,
             pCreateInfo->pQueueFamilyIndices,
             pCreateInfo->samples > VK_SAMPLE_COUNT_1_BIT,
@@ -937,7 +1009,7 @@ VkResult Image::Create(
             pCreateInfo->usage,
             stencilUsage,
             imageFlags,
-            resourceKey);
+            pInfo->resourceKey);
 
         imageHandle = Image::HandleFromVoidPointer(pMemory);
     }
@@ -1149,12 +1221,80 @@ VkResult Image::CreatePresentableImage(
     return PalToVkResult(result);
 }
 
+// =====================================================================================================================
+// Copies the shader SRDs of an earlier view of this image created with the same parameters.  Returns false if there
+// was no such view.  The SRDs only depend on the view parameters and the image, whose memory binding can't change
+// once views exist.
+bool Image::FindViewSrds(
+    Device*                pDevice,
+    const ImageViewSrdKey& key,
+    size_t                 size,
+    void*                  pSrds
+    ) const
+{
+    Util::MutexAuto lock(pDevice->GetImageViewSrdCacheLock());
+
+    bool found = false;
+
+    for (const ViewSrdCacheEntry* pEntry = m_pViewSrdCache; (pEntry != nullptr) && (found == false);
+         pEntry = pEntry->pNext)
+    {
+        if ((pEntry->size == size) && (memcmp(&pEntry->key, &key, sizeof(key)) == 0))
+        {
+            memcpy(pSrds, pEntry + 1, size);
+
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+// =====================================================================================================================
+// Remembers the shader SRDs built for a view of this image.  Only the first few distinct views are remembered, which
+// covers engines recreating the same views every pass or frame without growing with images viewed many ways.
+void Image::AddViewSrds(
+    Device*                pDevice,
+    const ImageViewSrdKey& key,
+    size_t                 size,
+    const void*            pSrds
+    ) const
+{
+    Util::MutexAuto lock(pDevice->GetImageViewSrdCacheLock());
+
+    if (m_viewSrdCacheCount < MaxViewSrdCacheEntries)
+    {
+        void* pMemory = pDevice->VkInstance()->AllocMem(sizeof(ViewSrdCacheEntry) + size,
+                                                        VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+
+        if (pMemory != nullptr)
+        {
+            ViewSrdCacheEntry* pEntry = static_cast<ViewSrdCacheEntry*>(pMemory);
+
+            pEntry->pNext = m_pViewSrdCache;
+            pEntry->key   = key;
+            pEntry->size  = size;
+
+            memcpy(pEntry + 1, pSrds, size);
+
+            m_pViewSrdCache = pEntry;
+            m_viewSrdCacheCount++;
+        }
+    }
+}
+
 // =====================================================================================================================
 // Destroy image object
 VkResult Image::Destroy(
     Device*                         pDevice,
     const VkAllocationCallbacks*    pAllocator)
 {
+    pDevice->GetGpuAddressIndex()->Remove(this);
+
+    if (m_internalFlags.transientAliasBound)
+    {
+        pDevice->GetTransientAliasPlanner()->ReleaseImage(this);
+    }
 
     for (uint32_t deviceIdx = 0; deviceIdx < pDevice->NumPalDevices(); deviceIdx++)
     {
@@ -1190,6 +1330,15 @@ VkResult Image::Destroy(
         pAllocator->pfnFree(pAllocator->pUserData, m_pImageMemory);
     }
 
+    while (m_pViewSrdCache != nullptr)
+    {
+        ViewSrdCacheEntry* pNext = m_pViewSrdCache->pNext;
+
+        pDevice->VkInstance()->FreeMem(m_pViewSrdCache);
+
+        m_pViewSrdCache = pNext;
+    }
+
     Util::Destructor(this);
 
     pDevice->FreeApiObject(pAllocator, this);
@@ -1310,16 +1459,31 @@ VkResult Image::BindMemory(
 
             Pal::IImage*     pPalImage      = m_perGpu[localDeviceIdx].pPalImage;
             Pal::IGpuMemory* pGpuMem        = nullptr;
+            Pal::gpusize     memBaseOffset  = 0;
             Pal::gpusize     baseAddrOffset = 0;
 
             if (pMemory != nullptr)
             {
                 pGpuMem = pMemory->PalMemory(localDeviceIdx, sourceMemInst);
 
+                // Sub-allocated memory only occupies part of its PAL memory object
+                memBaseOffset = pMemory->Offset();
+
+                pMemory->MarkUsed();
+
+                if (localDeviceIdx == DefaultDeviceIndex)
+                {
+                    pMemory->RecordBind(MemoryEventType::ImageBind, this, reqs.size, memBaseOffset + memOffset);
+
+                    m_internalFlags.transientAliasBound = pMemory->IsTransientAlias();
+                    m_internalFlags.layoutTracked       =
+                        pDevice->GetImageLayoutTracker()->IsCandidate(this, pMemory) ? 1 : 0;
+                }
+
                 // The bind offset within the memory should already be pre-aligned
                 VK_ASSERT(Util::IsPow2Aligned(memOffset, reqs.alignment));
 
-                VkDeviceSize baseGpuAddr = pGpuMem->Desc().gpuVirtAddr;
+                VkDeviceSize baseGpuAddr = pGpuMem->Desc().gpuVirtAddr + memBaseOffset;
 
                 // If the base address of the VkMemory is not already aligned
                 if ((Util::IsPow2Aligned(baseGpuAddr, reqs.alignment) == false) &&
@@ -1345,7 +1509,7 @@ VkResult Image::BindMemory(
                 }
             }
 
-            result = pPalImage->BindGpuMemory(pGpuMem, baseAddrOffset + memOffset);
+            result = pPalImage->BindGpuMemory(pGpuMem, memBaseOffset + baseAddrOffset + memOffset);
 
             if (result == Pal::Result::Success)
             {
@@ -1667,6 +1831,24 @@ void Image::GetSparseMemoryRequirements(
 VkResult Image::GetMemoryRequirements(
     const Device*         pDevice,
     VkMemoryRequirements* pReqs)
+{
+    if (m_internalFlags.memReqsCached)
+    {
+        *pReqs = m_memoryRequirements;
+    }
+    else
+    {
+        CalcMemoryRequirements(pDevice, pReqs);
+    }
+
+    return VK_SUCCESS;
+}
+
+// =====================================================================================================================
+// Queries PAL for the image's memory requirements and applies the driver's adjustments
+void Image::CalcMemoryRequirements(
+    const Device*         pDevice,
+    VkMemoryRequirements* pReqs) const
 {
     const bool                 isSparse           = IsSparse();
     Pal::GpuMemoryRequirements palReqs            = {};
@@ -1743,8 +1925,6 @@ VkResult Image::GetMemoryRequirements(
     {
         pReqs->size = Util::RoundUpToMultiple(palReqs.size, pReqs->alignment);
     }
-
-    return VK_SUCCESS;
 }
 
 // =====================================================================================================================
@@ -553,7 +553,7 @@ VkResult ImageView::Create(
         totalSize              = depthViewSegmentOffset + (depthViewSegmentSize * numDevices);
     }
 
-    void* pMemory = pDevice->AllocApiObject(pAllocator, totalSize);
+    void* pMemory = pDevice->AllocPooledApiObject(pAllocator, totalSize);
 
     if (pMemory == nullptr)
     {
@@ -567,8 +567,24 @@ VkResult ImageView::Create(
 
     VK_ASSERT(viewFormat.format != Pal::ChNumFormat::Undefined);
 
+    // The image view and FMASK SRDs follow the API object back to back.  Engines often create the same view of an
+    // image many times, so copy the SRDs of an identical earlier view instead of building them again.
+    const size_t shaderSrdSize = (srdSegmentSize + fmaskSegmentSize) * numDevices;
+
+    ImageViewSrdKey srdKey;
+    memset(&srdKey, 0, sizeof(srdKey));
+
+    srdKey.format           = createInfoFormat;
+    srdKey.viewType         = pCreateInfo->viewType;
+    srdKey.components       = pCreateInfo->components;
+    srdKey.subresourceRange = pCreateInfo->subresourceRange;
+    srdKey.usage            = imageViewUsage;
+
+    const bool srdsCached = (shaderSrdSize > 0) &&
+                            pImage->FindViewSrds(pDevice, srdKey, shaderSrdSize, Util::VoidPtrInc(pMemory, apiSize));
+
     // Build the PAL image view SRDs if needed
-    if (srdSegmentSize > 0)
+    if ((srdSegmentSize > 0) && (srdsCached == false))
     {
         Pal::SwizzledFormat aspectFormat = VkToPalFormat(Formats::GetAspectFormat(createInfoFormat,
                                                          subresRange.aspectMask), pDevice->GetRuntimeSettings());
@@ -592,13 +608,21 @@ VkResult ImageView::Create(
     }
 
     //Build Fmask View SRDS if needed
-    if (fmaskSegmentSize > 0)
+    if ((fmaskSegmentSize > 0) && (srdsCached == false))
     {
         void *pFmaskMem = Util::VoidPtrInc(pMemory, fmaskSegmentOffset);
 
         BuildFmaskViewSrds(pDevice, fmaskSegmentSize, pImage, palRanges[0], pCreateInfo, pFmaskMem);
     }
 
+    if ((shaderSrdSize > 0) && (srdsCached == false))
+    {
+        VK_ASSERT((srdSegmentSize == 0) || (srdSegmentOffset == apiSize));
+        VK_ASSERT((fmaskSegmentSize == 0) || (fmaskSegmentOffset == (apiSize + (srdSegmentSize * numDevices))));
+
+        pImage->AddViewSrds(pDevice, srdKey, shaderSrdSize, Util::VoidPtrInc(pMemory, apiSize));
+    }
+
     Pal::IColorTargetView* pColorView[MaxPalDevices] = {};
 
     // Build the color target view if needed
@@ -667,7 +691,7 @@ VkResult ImageView::Create(
     {
         // NOTE: None of PAL SRDs, color target views, and DS views require any clean-up other than their
         // memory freed.
-        pDevice->FreeApiObject(pAllocator, pMemory);
+        pDevice->FreePooledApiObject(pAllocator, pMemory);
 
         return PalToVkResult(result);
     }
@@ -681,7 +705,7 @@ VkResult ImageView::Destroy(
 {
     Util::Destructor(this);
 
-    pDevice->FreeApiObject(pAllocator, this);
+    pDevice->FreePooledApiObject(pAllocator, this);
 
     return VK_SUCCESS;
 }
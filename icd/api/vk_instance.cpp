@@ -29,9 +29,12 @@
  ***********************************************************************************************************************
  */
 
+#include "include/barrier_profile.h"
 #include "include/log.h"
+#include "include/startup_profile.h"
 #include "include/khronos/vulkan.h"
 #include "include/vk_alloccb.h"
+#include "include/vk_cmdbuffer.h"
 #include "include/vk_conv.h"
 #include "include/vk_instance.h"
 #include "include/vk_physical_device.h"
@@ -57,6 +60,7 @@
 #include "palListImpl.h"
 #include "palHashMapImpl.h"
 #include "palInlineFuncs.h"
+#include "palSysUtil.h"
 
 #include <new>
 
@@ -94,13 +98,18 @@ Instance::Instance(
     m_pDevModeMgr(nullptr),
     m_debugReportCallbacks(&m_palAllocator),
     m_debugUtilsMessengers(&m_palAllocator),
-    m_logTagIdMask(0)
+    m_instanceInitUs(0),
+    m_logTagIdMask(0),
+    m_asyncLog(this)
 {
     m_flags.u32All = 0;
 
     memset(m_screens, 0, sizeof(m_screens));
 
     memset(m_applicationName, 0, sizeof(m_applicationName));
+    memset(m_engineName, 0, sizeof(m_engineName));
+
+    m_appProfileSettingsCount = 0;
 }
 
 // =====================================================================================================================
@@ -152,15 +161,22 @@ VkResult Instance::Create(
     const VkAllocationCallbacks*    pAllocator,
     VkInstance*                     pInstance)
 {
+    StartupPhase startupPhase("vkCreateInstance");
+
+    // Short-lived processes (offline compilers, probe tools) can ask for the physical devices, their settings and the
+    // app profile to be initialized on first use, which takes most of the work out of vkCreateInstance.
+    const bool lazyDeviceInit = (getenv("AMDVLK_LAZY_INSTANCE_INIT") != nullptr);
+
     // Detect an initial app profile (if any).  This may later be overridden by private panel settings.
-    AppProfile preInitAppProfile = ScanApplicationProfile(*pCreateInfo);
+    AppProfile preInitAppProfile = lazyDeviceInit ? AppProfile::Default : ScanApplicationProfile(*pCreateInfo);
 
     const VkAllocationCallbacks* pAllocCb = pAllocator;
     const VkApplicationInfo* pAppInfo = pCreateInfo->pApplicationInfo;
 
     if (pAllocCb == nullptr)
     {
-        pAllocCb = &allocator::g_DefaultAllocCallback;
+        pAllocCb = allocator::IsThreadCachingEnabled() ? &allocator::g_ThreadCachingAllocCallback :
+                                                         &allocator::g_DefaultAllocCallback;
     }
     else
     {
@@ -228,6 +244,8 @@ VkResult Instance::Create(
                                  enabledInstanceExtensions,
                                  preInitAppProfile);
 
+    pNewInstance->m_flags.lazyDeviceInit = lazyDeviceInit ? 1 : 0;
+
     // Two-step initialization
     result = pNewInstance->Init(pAppInfo);
 
@@ -305,8 +323,12 @@ bool Instance::DetermineNullGpuSupport(
 VkResult Instance::Init(
     const VkApplicationInfo* pAppInfo)
 {
+    StartupPhase startupPhase("Instance::Init");
+
     VkResult status;
 
+    const int64_t startTicks = Util::GetPerfCpuTime();
+
     if (pAppInfo != nullptr)
     {
         if (pAppInfo->pApplicationName != nullptr)
@@ -314,6 +336,10 @@ VkResult Instance::Init(
             strncpy(m_applicationName, pAppInfo->pApplicationName, APP_INFO_MAX_CHARS - 1);
         }
 
+        if (pAppInfo->pEngineName != nullptr)
+        {
+            strncpy(m_engineName, pAppInfo->pEngineName, APP_INFO_MAX_CHARS - 1);
+        }
     }
 
     m_palAllocator.Init();
@@ -407,56 +433,18 @@ VkResult Instance::Init(
         DevModeEarlyInitialize();
     }
 
-    if (status == VK_SUCCESS)
-    {
-        // Create physical device manager
-        status = PhysicalDeviceManager::Create(this, &m_pPhysicalDeviceManager);
-    }
-
-    // Get all enumerated devices
-    uint32_t deviceCount = PhysicalDeviceManager::MaxPhysicalDevices;
-    VkPhysicalDevice devices[PhysicalDeviceManager::MaxPhysicalDevices] = {};
-
-    if ((status != VK_SUCCESS) ||
-        (m_pPhysicalDeviceManager->EnumeratePhysicalDevices(&deviceCount, devices) != VK_SUCCESS))
-    {
-        deviceCount = 0;
-    }
-
-    if ((status == VK_SUCCESS) && (deviceCount == 0))
-    {
-        // Prevent an instance from ever being created without any devices present.
-        status = VK_ERROR_INITIALIZATION_FAILED;
-    }
-
-    // Late-initialize the developer mode manager.  Needs to be called after settings are committed but BEFORE
-    // physical devices are late-initialized (below).
-    if ((status == VK_SUCCESS) && (m_pDevModeMgr != nullptr))
+    // Developer mode installs its dispatch table layers based on the device settings, so it can't wait for the devices.
+    if (m_pDevModeMgr != nullptr)
     {
-        DevModeLateInitialize();
+        m_flags.lazyDeviceInit = 0;
     }
 
-    // Do late initialization of physical devices
-    if (status == VK_SUCCESS)
-    {
-        for (uint32_t deviceIdx = 0; deviceIdx < deviceCount; ++deviceIdx)
-        {
-            ApiPhysicalDevice::ObjectFromHandle(devices[deviceIdx])->LateInitialize();
-        }
-    }
+    m_instanceInitUs = static_cast<uint64_t>(((Util::GetPerfCpuTime() - startTicks) * 1000000) /
+                                             Util::GetPerfFrequency());
 
-    if (status == VK_SUCCESS)
+    if ((status == VK_SUCCESS) && (m_flags.lazyDeviceInit == 0))
     {
-        PhysicalDevice* pPhysicalDevice = ApiPhysicalDevice::ObjectFromHandle(devices[DefaultDeviceIndex]);
-        Pal::DeviceProperties info;
-        pPhysicalDevice->PalDevice()->GetProperties(&info);
-        if (pPhysicalDevice->GetRuntimeSettings().enableSPP && info.gfxipProperties.flags.supportSpp)
-        {
-            char executableName[PATH_MAX];
-            char executablePath[PATH_MAX];
-            utils::GetExecutableNameAndPath(executableName, executablePath);
-            m_pPalPlatform->EnableSppProfile(executableName, executablePath);
-        }
+        status = InitPhysicalDevices();
     }
 
     // Install PAL developer callback if the SQTT layer is enabled.  This is required to trap internal barriers
@@ -535,17 +523,135 @@ VkResult Instance::Init(
 
     }
 
+    if (status == VK_SUCCESS)
+    {
+        InitDispatchTable();
+    }
+
+    return status;
+}
+
+// =====================================================================================================================
+// Creates the physical devices, which loads and commits their settings, and finishes the instance initialization that
+// depends on them.  Called from Init(), or on first use through EnsurePhysicalDevices() with lazy initialization.
+VkResult Instance::InitPhysicalDevices()
+{
+    VK_ASSERT(m_pPhysicalDeviceManager == nullptr);
+
+    StartupPhase startupPhase("Instance::InitPhysicalDevices");
+
+    const int64_t startTicks = Util::GetPerfCpuTime();
+
+    if (m_flags.lazyDeviceInit)
+    {
+        // The settings loader starts from the pre-init profile, so the scan skipped by Create() has to happen now.
+        VkApplicationInfo appInfo = {};
+        appInfo.sType            = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        appInfo.pApplicationName = (m_applicationName[0] != '\0') ? m_applicationName : nullptr;
+        appInfo.pEngineName      = (m_engineName[0] != '\0') ? m_engineName : nullptr;
+
+        VkInstanceCreateInfo createInfo = {};
+        createInfo.sType            = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        createInfo.pApplicationInfo = &appInfo;
+
+        m_preInitAppProfile = ScanApplicationProfile(createInfo);
+    }
+
+    // Create physical device manager
+    VkResult status = PhysicalDeviceManager::Create(this, &m_pPhysicalDeviceManager);
+
+    // Get all enumerated devices
+    uint32_t deviceCount = PhysicalDeviceManager::MaxPhysicalDevices;
+    VkPhysicalDevice devices[PhysicalDeviceManager::MaxPhysicalDevices] = {};
+
+    if ((status != VK_SUCCESS) ||
+        (m_pPhysicalDeviceManager->EnumeratePhysicalDevices(&deviceCount, devices) != VK_SUCCESS))
+    {
+        deviceCount = 0;
+    }
+
+    if ((status == VK_SUCCESS) && (deviceCount == 0))
+    {
+        // Prevent an instance from ever being used without any devices present.
+        status = VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    // Late-initialize the developer mode manager.  Needs to be called after settings are committed but BEFORE
+    // physical devices are late-initialized (below).
+    if ((status == VK_SUCCESS) && (m_pDevModeMgr != nullptr))
+    {
+        DevModeLateInitialize();
+    }
+
+    // Do late initialization of physical devices
+    if (status == VK_SUCCESS)
+    {
+        for (uint32_t deviceIdx = 0; deviceIdx < deviceCount; ++deviceIdx)
+        {
+            ApiPhysicalDevice::ObjectFromHandle(devices[deviceIdx])->LateInitialize();
+        }
+    }
+
+    if (status == VK_SUCCESS)
+    {
+        PhysicalDevice* pPhysicalDevice = ApiPhysicalDevice::ObjectFromHandle(devices[DefaultDeviceIndex]);
+        Pal::DeviceProperties info;
+        pPhysicalDevice->PalDevice()->GetProperties(&info);
+        if (pPhysicalDevice->GetRuntimeSettings().enableSPP && info.gfxipProperties.flags.supportSpp)
+        {
+            char executableName[PATH_MAX];
+            char executablePath[PATH_MAX];
+            utils::GetExecutableNameAndPath(executableName, executablePath);
+            m_pPalPlatform->EnableSppProfile(executableName, executablePath);
+        }
+    }
+
+
     if (status == VK_SUCCESS)
     {
         PhysicalDevice* pPhysicalDevice = ApiPhysicalDevice::ObjectFromHandle(devices[DefaultDeviceIndex]);
         m_logTagIdMask = pPhysicalDevice->GetRuntimeSettings().logTagIdMask;
+
+        if ((m_logTagIdMask != 0) && pPhysicalDevice->GetRuntimeSettings().enableAsyncLog)
+        {
+            // Logging is best effort; messages are printed synchronously if the async log can't be started
+            VK_IGNORE(m_asyncLog.Init(pPhysicalDevice->GetRuntimeSettings().asyncLogFile));
+        }
+
         AmdvlkLog(m_logTagIdMask, GeneralPrint, "%s Begin ********\n",
             GetApplicationName());
+
+        const uint64_t deviceInitUs = static_cast<uint64_t>(((Util::GetPerfCpuTime() - startTicks) * 1000000) /
+                                                            Util::GetPerfFrequency());
+
+        AmdvlkLog(m_logTagIdMask, GeneralPrint, "Instance init: %llu us, physical device init: %llu us%s\n",
+            m_instanceInitUs, deviceInitUs, m_flags.lazyDeviceInit ? " (deferred)" : "");
     }
+    else if (m_pPhysicalDeviceManager != nullptr)
+    {
+        m_pPhysicalDeviceManager->Destroy();
 
-    if (status == VK_SUCCESS)
+        m_pPhysicalDeviceManager = nullptr;
+    }
+
+    return status;
+}
+
+// =====================================================================================================================
+// With lazy initialization, creates the physical devices the first time anything needs them.  A failed attempt is
+// retried by the next call.
+VkResult Instance::EnsurePhysicalDevices()
+{
+    VkResult status = VK_SUCCESS;
+
+    if (m_flags.lazyDeviceInit)
     {
-        InitDispatchTable();
+        Util::MutexAuto lock(&m_physicalDeviceInitLock);
+
+        if (m_pPhysicalDeviceManager == nullptr)
+        {
+            status = InitPhysicalDevices();
+        }
     }
 
     return status;
@@ -594,28 +700,32 @@ VkResult Instance::LoadAndCommitSettings(
 {
     VkResult result = VK_SUCCESS;
 
-    for (uint32_t deviceIdx = 0; ((deviceIdx < deviceCount) && (result == VK_SUCCESS)); ++deviceIdx)
     {
-        pAppProfiles[deviceIdx] = m_preInitAppProfile;
-
-        // Load per-device settings
-        result = PalToVkResult(settingsLoaders[deviceIdx]->Init());
+        StartupPhase startupPhase("ReadSettings");
 
-        if (result == VK_SUCCESS)
+        for (uint32_t deviceIdx = 0; ((deviceIdx < deviceCount) && (result == VK_SUCCESS)); ++deviceIdx)
         {
-            result = settingsLoaders[deviceIdx]->ProcessSettings(
-                                &m_allocCallbacks, m_appVersion, &pAppProfiles[deviceIdx]);
-        }
+            pAppProfiles[deviceIdx] = m_preInitAppProfile;
 
-        if (result == VK_SUCCESS)
-        {
-            UpdateSettingsWithAppProfile(settingsLoaders[deviceIdx]->GetSettingsPtr());
+            // Load per-device settings
+            result = PalToVkResult(settingsLoaders[deviceIdx]->Init());
 
-            // Make sure the final settings have legal values and update dependant parameters
-            settingsLoaders[deviceIdx]->ValidateSettings();
+            if (result == VK_SUCCESS)
+            {
+                result = settingsLoaders[deviceIdx]->ProcessSettings(
+                                    &m_allocCallbacks, m_appVersion, &pAppProfiles[deviceIdx]);
+            }
 
-            // Update PAL settings based on runtime settings and desired driver defaults if needed
-            settingsLoaders[deviceIdx]->UpdatePalSettings();
+            if (result == VK_SUCCESS)
+            {
+                UpdateSettingsWithAppProfile(settingsLoaders[deviceIdx]->GetSettingsPtr());
+
+                // Make sure the final settings have legal values and update dependant parameters
+                settingsLoaders[deviceIdx]->ValidateSettings();
+
+                // Update PAL settings based on runtime settings and desired driver defaults if needed
+                settingsLoaders[deviceIdx]->UpdatePalSettings();
+            }
         }
     }
 
@@ -646,14 +756,62 @@ void Instance::UpdateSettingsWithAppProfile(
     // Set the default values
     profileSettings.texFilterQuality = pSettings->vulkanTexFilterQuality;
 
-    ReloadAppProfileSettings(this,
-                            &profileSettings,
-                            pSettings->appGpuID);
+    GetAppProfileSettings(pSettings->appGpuID, &profileSettings);
 
     pSettings->vulkanTexFilterQuality =
         static_cast<TextureFilterOptimizationSettings>(profileSettings.texFilterQuality);
 }
 
+// =====================================================================================================================
+// Applies the app profile to the given settings.  Querying the profile reads it from the driver store and matches it
+// against the executable name and content distribution ID, so the result is remembered per GPU and set of default
+// values and reused by later physical device enumerations and device creations until InvalidateAppProfileSettings().
+void Instance::GetAppProfileSettings(
+    uint32_t         appGpuID,
+    ProfileSettings* pProfileSettings)
+{
+    Util::MutexAuto lock(&m_appProfileSettingsLock);
+
+    bool found = false;
+
+    for (uint32_t i = 0; (i < m_appProfileSettingsCount) && (found == false); ++i)
+    {
+        const AppProfileSettingsEntry& entry = m_appProfileSettings[i];
+
+        if ((entry.appGpuID == appGpuID) &&
+            (memcmp(&entry.defaults, pProfileSettings, sizeof(ProfileSettings)) == 0))
+        {
+            *pProfileSettings = entry.resolved;
+            found             = true;
+        }
+    }
+
+    if (found == false)
+    {
+        const ProfileSettings defaults = *pProfileSettings;
+
+        ReloadAppProfileSettings(this, pProfileSettings, appGpuID);
+
+        if (m_appProfileSettingsCount < MaxAppProfileSettingsEntries)
+        {
+            AppProfileSettingsEntry* pEntry = &m_appProfileSettings[m_appProfileSettingsCount++];
+
+            pEntry->appGpuID = appGpuID;
+            pEntry->defaults = defaults;
+            pEntry->resolved = *pProfileSettings;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Forgets all resolved app profile settings.  Called when PAL reports that the profile sources changed.
+void Instance::InvalidateAppProfileSettings()
+{
+    Util::MutexAuto lock(&m_appProfileSettingsLock);
+
+    m_appProfileSettingsCount = 0;
+}
+
 // =====================================================================================================================
 // Destroys the Instance.
 VkResult Instance::Destroy(void)
@@ -663,12 +821,15 @@ VkResult Instance::Destroy(void)
 #if ICD_GPUOPEN_DEVMODE_BUILD
     // Pipeline binary cache is required to be freed before destroying DevModeMgr
     // because DevModeMgr manages the state of pipeline binary cache.
-    uint32_t deviceCount = PhysicalDeviceManager::MaxPhysicalDevices;
-    VkPhysicalDevice devices[PhysicalDeviceManager::MaxPhysicalDevices] = {};
-    m_pPhysicalDeviceManager->EnumeratePhysicalDevices(&deviceCount, devices);
-    for (uint32_t deviceIdx = 0; deviceIdx < deviceCount; ++deviceIdx)
+    if (m_pPhysicalDeviceManager != nullptr)
     {
-        ApiPhysicalDevice::ObjectFromHandle(devices[deviceIdx])->GetCompiler()->DestroyPipelineBinaryCache();
+        uint32_t deviceCount = PhysicalDeviceManager::MaxPhysicalDevices;
+        VkPhysicalDevice devices[PhysicalDeviceManager::MaxPhysicalDevices] = {};
+        m_pPhysicalDeviceManager->EnumeratePhysicalDevices(&deviceCount, devices);
+        for (uint32_t deviceIdx = 0; deviceIdx < deviceCount; ++deviceIdx)
+        {
+            ApiPhysicalDevice::ObjectFromHandle(devices[deviceIdx])->GetCompiler()->DestroyPipelineBinaryCache();
+        }
     }
 
     if (m_pDevModeMgr != nullptr)
@@ -705,6 +866,31 @@ VkResult Instance::Destroy(void)
         FreeMem(m_pPalPlatform);
     }
 
+    if (m_allocCallbacks.pfnAllocation == allocator::g_ThreadCachingAllocCallback.pfnAllocation)
+    {
+        static const char* ScopeNames[allocator::AllocScopeCount] =
+        {
+            "command", "object", "cache", "device", "instance"
+        };
+
+        allocator::AllocScopeStats stats[allocator::AllocScopeCount] = {};
+
+        allocator::GetAllocScopeStats(stats);
+
+        for (uint32_t scope = 0; scope < allocator::AllocScopeCount; ++scope)
+        {
+            AmdvlkLog(m_logTagIdMask,
+                      GeneralPrint,
+                      "%s scope allocations: %llu, frees: %llu, from thread cache: %llu",
+                      ScopeNames[scope],
+                      stats[scope].allocCount,
+                      stats[scope].freeCount,
+                      stats[scope].cachedAllocCount);
+        }
+    }
+
+    m_asyncLog.Destroy();
+
     // This was created with placement new. Need to explicitly call destructor.
     this->~Instance();
 
@@ -730,8 +916,15 @@ VkResult Instance::EnumeratePhysicalDevices(
         uint32_t*                   pPhysicalDeviceCount,
         VkPhysicalDevice*           pPhysicalDevices)
 {
-    // Query physical devices from the manager
-    return m_pPhysicalDeviceManager->EnumeratePhysicalDevices(pPhysicalDeviceCount, pPhysicalDevices);
+    VkResult result = EnsurePhysicalDevices();
+
+    if (result == VK_SUCCESS)
+    {
+        // Query physical devices from the manager
+        result = m_pPhysicalDeviceManager->EnumeratePhysicalDevices(pPhysicalDeviceCount, pPhysicalDevices);
+    }
+
+    return result;
 }
 
 // =====================================================================================================================
@@ -1053,6 +1246,13 @@ VkResult Instance::EnumeratePhysicalDeviceGroups(
     uint32_t*                           pPhysicalDeviceGroupCount,
     VkPhysicalDeviceGroupProperties*    pPhysicalDeviceGroupProperties)
 {
+    VkResult result = EnsurePhysicalDevices();
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
     if (pPhysicalDeviceGroupProperties == nullptr)
     {
         *pPhysicalDeviceGroupCount = m_pPhysicalDeviceManager->GetDeviceGroupIndices(0, nullptr);
@@ -1062,7 +1262,6 @@ VkResult Instance::EnumeratePhysicalDeviceGroups(
     int32_t  deviceGroupIndices[Pal::MaxDevices];
     uint32_t numDeviceGroups = m_pPhysicalDeviceManager->GetDeviceGroupIndices(Pal::MaxDevices, deviceGroupIndices);
 
-    VkResult result = VK_SUCCESS;
     if (numDeviceGroups > *pPhysicalDeviceGroupCount)
     {
         numDeviceGroups = *pPhysicalDeviceGroupCount;
@@ -1107,10 +1306,17 @@ VkResult Instance::EnumerateAllNullPhysicalDeviceProperties(
     uint32_t*                    pPhysicalDeviceCount,
     VkPhysicalDeviceProperties** ppPhysicalDeviceProperties)
 {
-    // Query physical devices from the manager
-    return m_pPhysicalDeviceManager->EnumerateAllNullPhysicalDeviceProperties(
-        pPhysicalDeviceCount,
-        ppPhysicalDeviceProperties);
+    VkResult result = EnsurePhysicalDevices();
+
+    if (result == VK_SUCCESS)
+    {
+        // Query physical devices from the manager
+        result = m_pPhysicalDeviceManager->EnumerateAllNullPhysicalDeviceProperties(
+            pPhysicalDeviceCount,
+            ppPhysicalDeviceProperties);
+    }
+
+    return result;
 }
 
 // =====================================================================================================================
@@ -1128,6 +1334,25 @@ void PAL_STDCALL Instance::PalDeveloperCallback(
         SqttMgr::PalDeveloperCallback(pInstance, deviceIndex, type, pCbData);
     }
 
+    // The barrier profile follows the barrier callbacks too, but doesn't need developer mode.
+    if ((type == Pal::Developer::CallbackType::BarrierBegin) ||
+        (type == Pal::Developer::CallbackType::BarrierEnd)   ||
+        (type == Pal::Developer::CallbackType::ImageBarrier))
+    {
+        const auto& barrier = *static_cast<const Pal::Developer::BarrierData*>(pCbData);
+
+        CmdBuffer* pCmdBuffer = static_cast<CmdBuffer*>(barrier.pCmdBuffer->GetClientData());
+
+        if (pCmdBuffer != nullptr)
+        {
+            BarrierProfileCmdBufferState* pBarrierProfile = pCmdBuffer->GetBarrierProfileState(barrier.pCmdBuffer);
+
+            if (pBarrierProfile != nullptr)
+            {
+                pBarrierProfile->PalBarrierCallback(barrier.pCmdBuffer, type, barrier);
+            }
+        }
+    }
 }
 
 // =====================================================================================================================
@@ -29,6 +29,7 @@
  ***********************************************************************************************************************
  */
 
+#include "include/internal_mem_mgr.h"
 #include "include/vk_conv.h"
 #include "include/vk_device.h"
 #include "include/vk_instance.h"
@@ -40,6 +41,11 @@
 #include "palEventDefs.h"
 #include "palGpuMemory.h"
 #include "palSysUtil.h"
+#include "palMetroHash.h"
+
+#if defined(__unix__)
+#include <unistd.h>
+#endif
 
 namespace vk
 {
@@ -93,6 +99,7 @@ VkResult Memory::Create(
 
     // Assign default priority based on panel setting (this may get elevated later by memory binds)
     MemoryPriority priority = MemoryPriority::FromSetting(settings.memoryPriorityDefault);
+    bool explicitPriority   = false;
 
     Image*  pBoundImage       = nullptr;
     VkImage  dedicatedImage   = VK_NULL_HANDLE;
@@ -268,7 +275,8 @@ VkResult Memory::Create(
             {
                 const auto* pExtInfo = reinterpret_cast<const VkMemoryPriorityAllocateInfoEXT *>(pHeader);
 
-                priority = MemoryPriority::FromVkMemoryPriority(pExtInfo->priority);
+                priority         = MemoryPriority::FromVkMemoryPriority(pExtInfo->priority);
+                explicitPriority = true;
             }
             break;
 
@@ -312,6 +320,36 @@ VkResult Memory::Create(
         pNext = pHeader->pNext;
     }
 
+    // Small allocations that nothing outside of this device ever sees as a separate allocation can be carved out of
+    // driver-owned blocks instead.  Anything the block would have to share (VA range, protection, priority, a handle
+    // or a dedicated resource) keeps its own PAL memory object.
+    const bool subAllocate = (settings.appMemorySubAllocThreshold > 0)                     &&
+                             (createInfo.size != 0)                                        &&
+                             (createInfo.size <= settings.appMemorySubAllocThreshold)      &&
+                             (pDevice->NumPalDevices() == 1)                               &&
+                             (isExternal == false)                                         &&
+                             (sharedViaAndroidHwBuf == false)                              &&
+                             (pPinnedHostPtr == nullptr)                                   &&
+                             (createInfo.flags.interprocess == 0)                          &&
+                             (createInfo.flags.tmzProtected == 0)                          &&
+                             (createInfo.vaRange == Pal::VaRange::Default)                 &&
+                             (dedicatedImage == VK_NULL_HANDLE)                            &&
+                             (dedicatedBuffer == VK_NULL_HANDLE)                           &&
+                             (explicitPriority == false);
+
+    // Dedicated memory of a transient attachment only reserves a virtual range; the pages behind it may be shared with
+    // attachments that are never alive at the same time.
+    const bool transientAlias = (pBoundImage != nullptr)                                               &&
+                                pDevice->GetTransientAliasPlanner()->IsCandidate(pBoundImage)          &&
+                                (pDevice->NumPalDevices() == 1)                                        &&
+                                (isExternal == false)                                                  &&
+                                (sharedViaAndroidHwBuf == false)                                       &&
+                                (pPinnedHostPtr == nullptr)                                            &&
+                                (createInfo.flags.interprocess == 0)                                   &&
+                                (createInfo.flags.tmzProtected == 0)                                   &&
+                                (createInfo.flags.cpuInvisible == 1)                                   &&
+                                (createInfo.vaRange == Pal::VaRange::Default);
+
     // Check for OOM before actually allocating to avoid overhead. Do not account for the memory allocation yet
     // since the commitment size can still increase
     if ((vkResult == VK_SUCCESS) &&
@@ -320,6 +358,13 @@ VkResult Memory::Create(
          (createInfo.heaps[0] == Pal::GpuHeap::GpuHeapLocal)))
     {
         vkResult = pDevice->TryIncreaseAllocatedMemorySize(createInfo.size, allocationMask, createInfo.heaps[0]);
+
+        // Blocks kept in the block cache count against the budget too, so give them up before failing
+        if ((vkResult != VK_SUCCESS) &&
+            (pDevice->GetMemoryBlockCache()->Trim(createInfo.heaps[0], createInfo.size) > 0))
+        {
+            vkResult = pDevice->TryIncreaseAllocatedMemorySize(createInfo.size, allocationMask, createInfo.heaps[0]);
+        }
     }
 
     if (vkResult == VK_SUCCESS)
@@ -345,7 +390,33 @@ VkResult Memory::Create(
             createInfo.priority       = priority.PalPriority();
             createInfo.priorityOffset = priority.PalOffset();
 
-            if (pPinnedHostPtr == nullptr)
+            if (transientAlias)
+            {
+                vkResult = CreateTransientAliasMemory(
+                    pDevice,
+                    pAllocator,
+                    createInfo,
+                    &pMemory);
+            }
+            else if (subAllocate)
+            {
+                vkResult = CreateSubAllocatedMemory(
+                    pDevice,
+                    pAllocator,
+                    createInfo,
+                    ((propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0),
+                    &pMemory);
+            }
+            else if ((pPinnedHostPtr == nullptr) &&
+                     pDevice->GetMemoryBlockCache()->IsCacheable(createInfo, allocationMask))
+            {
+                vkResult = CreateCacheableGpuMemory(
+                    pDevice,
+                    pAllocator,
+                    createInfo,
+                    &pMemory);
+            }
+            else if (pPinnedHostPtr == nullptr)
             {
                 vkResult = CreateGpuMemory(
                     pDevice,
@@ -379,6 +450,31 @@ VkResult Memory::Create(
         // Notify the memory object that it is counted so that the destructor can decrease the counter accordingly
         pMemory->SetAllocationCounted(allocationMask);
 
+        if ((dedicatedImage != VK_NULL_HANDLE)         &&
+            (isExternal == false)                      &&
+            (sharedViaAndroidHwBuf == false)           &&
+            (createInfo.flags.interprocess == 0))
+        {
+            pMemory->m_flags.dedicatedImage = 1;
+        }
+
+        // Only memory with its own PAL object in a local heap which nothing outside the device shares is demoted
+        if (pDevice->GetResidencyTracker()->IsEnabled()                 &&
+            (pMemory->IsSubAllocated() == false)                        &&
+            (pMemory->IsTransientAlias() == false)                      &&
+            (isExternal == false)                                       &&
+            (sharedViaAndroidHwBuf == false)                            &&
+            (pPinnedHostPtr == nullptr)                                 &&
+            (createInfo.flags.interprocess == 0)                        &&
+            ((createInfo.heaps[0] == Pal::GpuHeap::GpuHeapInvisible) ||
+             (createInfo.heaps[0] == Pal::GpuHeap::GpuHeapLocal)))
+        {
+            pDevice->GetResidencyTracker()->Register(pMemory);
+        }
+
+        pDevice->GetMemoryEventLog()->Record(
+            MemoryEventType::MemoryCreate, pMemory, nullptr, pMemory->m_size, pMemory->m_offset, pMemory->m_heap0);
+
         *pMemoryHandle = Memory::HandleFromObject(pMemory);
 
         Pal::ResourceDescriptionHeap desc = {};
@@ -407,7 +503,7 @@ VkResult Memory::Create(
             bindData.pObj               = pMemory;
             bindData.pGpuMemory         = pPalGpuMem;
             bindData.requiredGpuMemSize = pMemory->m_size;
-            bindData.offset             = 0;
+            bindData.offset             = pMemory->m_offset;
 
             pDevice->VkInstance()->PalPlatform()->LogEvent(
                 Pal::PalEvent::GpuMemoryResourceBind,
@@ -534,7 +630,7 @@ VkResult Memory::CreateGpuMemory(
                     if (palResult == Pal::Result::Success)
                     {
                         // Add the GPU memory object to the residency list
-                        palResult = pDevice->AddMemReference(pPalDevice, pGpuMemory[deviceIdx]);
+                        palResult = pDevice->AddDeferredMemReference(pPalDevice, pGpuMemory[deviceIdx]);
 
                         if (palResult != Pal::Result::Success)
                         {
@@ -617,6 +713,292 @@ VkResult Memory::CreateGpuMemory(
     return vkResult;
 }
 
+// =====================================================================================================================
+// Creates a single-GPU memory object whose PAL memory may be served from, and is returned to, the device's block cache.
+// Unlike in CreateGpuMemory() the PAL object gets system memory of its own so that it can outlive the API object.
+VkResult Memory::CreateCacheableGpuMemory(
+    Device*                         pDevice,
+    const VkAllocationCallbacks*    pAllocator,
+    const Pal::GpuMemoryCreateInfo& createInfo,
+    Memory**                        ppMemory)
+{
+    MemoryBlockCache* pCache     = pDevice->GetMemoryBlockCache();
+    Pal::IDevice*     pPalDevice = pDevice->PalDevice(DefaultDeviceIndex);
+
+    Pal::GpuMemoryCreateInfo localCreateInfo = createInfo;
+
+    localCreateInfo.flags.globalGpuVa = pDevice->IsGlobalGpuVaEnabled();
+
+    MemoryBlockKey key;
+    MemoryBlockCache::MakeKey(localCreateInfo, &key);
+
+    Pal::Result      palResult  = Pal::Result::Success;
+    Pal::IGpuMemory* pGpuMemory = pCache->Acquire(key);
+
+    if (pGpuMemory == nullptr)
+    {
+        const size_t gpuMemorySize = pPalDevice->GetGpuMemorySize(localCreateInfo, &palResult);
+        VK_ASSERT(palResult == Pal::Result::Success);
+
+        void* pPalSystemMem = pDevice->VkInstance()->AllocMem(
+            gpuMemorySize,
+            VK_DEFAULT_MEM_ALIGN,
+            VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+
+        if (pPalSystemMem != nullptr)
+        {
+            palResult = pPalDevice->CreateGpuMemory(localCreateInfo, pPalSystemMem, &pGpuMemory);
+
+            if (palResult != Pal::Result::Success)
+            {
+                pDevice->VkInstance()->FreeMem(pPalSystemMem);
+
+                pGpuMemory = nullptr;
+            }
+        }
+        else
+        {
+            palResult = Pal::Result::ErrorOutOfMemory;
+        }
+    }
+
+    void* pSystemMem = nullptr;
+
+    if (palResult == Pal::Result::Success)
+    {
+        // Add the GPU memory object to the residency list
+        palResult = pDevice->AddDeferredMemReference(pPalDevice, pGpuMemory);
+
+        if (palResult == Pal::Result::Success)
+        {
+            pSystemMem = pDevice->AllocApiObject(pAllocator, sizeof(Memory));
+
+            if (pSystemMem == nullptr)
+            {
+                pDevice->RemoveMemReference(pPalDevice, pGpuMemory);
+
+                palResult = Pal::Result::ErrorOutOfMemory;
+            }
+        }
+    }
+
+    VkResult vkResult = VK_SUCCESS;
+
+    if (palResult == Pal::Result::Success)
+    {
+        Pal::IGpuMemory* pPalMemory[MaxPalDevices] = {};
+
+        pPalMemory[DefaultDeviceIndex] = pGpuMemory;
+
+        *ppMemory = VK_PLACEMENT_NEW(pSystemMem) Memory(pDevice,
+                                                        pPalMemory,
+                                                        0,
+                                                        localCreateInfo,
+                                                        false,
+                                                        DefaultDeviceIndex);
+
+        (*ppMemory)->m_flags.blockCacheable = 1;
+        (*ppMemory)->m_cacheKey             = key;
+    }
+    else
+    {
+        if ((pGpuMemory != nullptr) && (pCache->Release(key, pGpuMemory) == false))
+        {
+            pGpuMemory->Destroy();
+            pDevice->VkInstance()->FreeMem(pGpuMemory);
+        }
+
+        vkResult = (palResult == Pal::Result::ErrorOutOfGpuMemory) ? VK_ERROR_OUT_OF_DEVICE_MEMORY :
+                                                                     VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    return vkResult;
+}
+
+// =====================================================================================================================
+// Hands the PAL memory of a freed cacheable memory object to the device's block cache, or destroys it if the cache
+// doesn't take it.  The memory must already be off the residency list.
+void Memory::ReleaseCacheableBlock(
+    Pal::IGpuMemory* pGpuMemory)
+{
+    // Freeing mapped memory implicitly unmaps it
+    if (m_flags.mapped)
+    {
+        pGpuMemory->Unmap();
+    }
+
+    // The priority may have been elevated since the block was created
+    m_cacheKey.priority       = m_priority.PalPriority();
+    m_cacheKey.priorityOffset = m_priority.PalOffset();
+
+    if (m_pDevice->GetMemoryBlockCache()->Release(m_cacheKey, pGpuMemory) == false)
+    {
+        pGpuMemory->Destroy();
+        m_pDevice->VkInstance()->FreeMem(pGpuMemory);
+    }
+}
+
+// =====================================================================================================================
+// Creates a memory object whose PAL memory is a virtual range the size of the dedicated transient attachment.  The
+// transient alias planner maps the range to physical memory in the memory's heaps, which attachments of disjoint
+// lifetimes may share.  Like sparse memory, the range itself is not on the residency list.
+VkResult Memory::CreateTransientAliasMemory(
+    Device*                         pDevice,
+    const VkAllocationCallbacks*    pAllocator,
+    const Pal::GpuMemoryCreateInfo& createInfo,
+    Memory**                        ppMemory)
+{
+    Pal::IDevice* pPalDevice = pDevice->PalDevice(DefaultDeviceIndex);
+
+    // Ranges are remapped in whole pages, and the physical memory is not tied to a single image.
+    Pal::GpuMemoryCreateInfo physicalCreateInfo = createInfo;
+
+    physicalCreateInfo.pImage    = nullptr;
+    physicalCreateInfo.alignment = Util::RoundUpToMultiple(pDevice->GetProperties().virtualMemAllocGranularity,
+                                                           createInfo.alignment);
+    physicalCreateInfo.size      = Util::RoundUpToMultiple(createInfo.size, physicalCreateInfo.alignment);
+
+    Pal::GpuMemoryCreateInfo virtualCreateInfo = {};
+
+    virtualCreateInfo.flags.globalGpuVa  = pDevice->IsGlobalGpuVaEnabled();
+    virtualCreateInfo.flags.virtualAlloc = 1;
+    virtualCreateInfo.alignment          = physicalCreateInfo.alignment;
+    virtualCreateInfo.size               = physicalCreateInfo.size;
+    virtualCreateInfo.heapCount          = 0;
+    virtualCreateInfo.heapAccess         = Pal::GpuHeapAccess::GpuHeapAccessExplicit;
+
+    if (pDevice->GetPrtFeatures() & Pal::PrtFeatureStrictNull)
+    {
+        virtualCreateInfo.virtualAccessMode = Pal::VirtualGpuMemAccessMode::ReadZero;
+    }
+
+    Pal::Result palResult = Pal::Result::Success;
+
+    const size_t gpuMemorySize = pPalDevice->GetGpuMemorySize(virtualCreateInfo, &palResult);
+    VK_ASSERT(palResult == Pal::Result::Success);
+
+    VkResult vkResult = VK_SUCCESS;
+
+    void* pSystemMem = pDevice->AllocApiObject(pAllocator, sizeof(Memory) + gpuMemorySize);
+
+    if (pSystemMem != nullptr)
+    {
+        Pal::IGpuMemory* pPalMemory[MaxPalDevices] = {};
+
+        palResult = pPalDevice->CreateGpuMemory(virtualCreateInfo,
+                                                Util::VoidPtrInc(pSystemMem, sizeof(Memory)),
+                                                &pPalMemory[DefaultDeviceIndex]);
+
+        if (palResult == Pal::Result::Success)
+        {
+            Memory* pMemory = VK_PLACEMENT_NEW(pSystemMem) Memory(pDevice,
+                                                                  pPalMemory,
+                                                                  0,
+                                                                  createInfo,
+                                                                  false,
+                                                                  DefaultDeviceIndex);
+
+            pMemory->m_flags.transientAlias = 1;
+
+            vkResult = pDevice->GetTransientAliasPlanner()->RegisterMemory(
+                pMemory, pPalMemory[DefaultDeviceIndex], physicalCreateInfo);
+
+            if (vkResult == VK_SUCCESS)
+            {
+                *ppMemory = pMemory;
+            }
+            else
+            {
+                pPalMemory[DefaultDeviceIndex]->Destroy();
+
+                Util::Destructor(pMemory);
+
+                pDevice->FreeApiObject(pAllocator, pSystemMem);
+            }
+        }
+        else
+        {
+            pDevice->FreeApiObject(pAllocator, pSystemMem);
+
+            vkResult = (palResult == Pal::Result::ErrorOutOfGpuMemory) ? VK_ERROR_OUT_OF_DEVICE_MEMORY :
+                                                                         VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+    else
+    {
+        vkResult = VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    return vkResult;
+}
+
+// =====================================================================================================================
+// Creates a memory object that is a range of a block owned by the device's internal memory manager, for small
+// allocations where a PAL memory object of their own costs more (kernel allocations, OS allocation limits) than it is
+// worth.  The block is persistently mapped if the memory type is host visible, so mapping is free.
+VkResult Memory::CreateSubAllocatedMemory(
+    Device*                         pDevice,
+    const VkAllocationCallbacks*    pAllocator,
+    const Pal::GpuMemoryCreateInfo& createInfo,
+    bool                            hostVisible,
+    Memory**                        ppMemory)
+{
+    VkResult vkResult = VK_SUCCESS;
+
+    // Allocate the API object together with the internal memory describing its range
+    void* pSystemMem = pDevice->AllocApiObject(pAllocator, sizeof(Memory) + sizeof(InternalMemory));
+
+    if (pSystemMem != nullptr)
+    {
+        InternalMemory* pSubAllocation =
+            VK_PLACEMENT_NEW(Util::VoidPtrInc(pSystemMem, sizeof(Memory))) InternalMemory();
+
+        InternalMemCreateInfo internalInfo = {};
+
+        internalInfo.pal                    = createInfo;
+        internalInfo.flags.persistentMapped = hostVisible ? 1 : 0;
+        internalInfo.flags.needGl2Uncached  = createInfo.flags.gl2Uncached;
+
+        // Blocks are shared with internal allocations of the same heaps that may still want to map them
+        internalInfo.pal.flags.cpuInvisible = 0;
+
+        // Resources bound to this memory can't be larger than it, so the natural alignment the buddy allocator gives
+        // a block of this size covers them in place of the (much larger) memory base address alignment.
+        internalInfo.pal.alignment = Util::Min(createInfo.alignment, Util::Pow2Pad(createInfo.size));
+
+        vkResult = pDevice->MemMgr()->AllocGpuMem(internalInfo, pSubAllocation, 1 << DefaultDeviceIndex);
+
+        if (vkResult == VK_SUCCESS)
+        {
+            Pal::IGpuMemory* pPalMemory[MaxPalDevices] = {};
+
+            pPalMemory[DefaultDeviceIndex] = pSubAllocation->PalMemory(DefaultDeviceIndex);
+
+            *ppMemory = VK_PLACEMENT_NEW(pSystemMem) Memory(pDevice,
+                                                            pPalMemory,
+                                                            0,
+                                                            createInfo,
+                                                            false,
+                                                            DefaultDeviceIndex);
+
+            (*ppMemory)->m_offset         = pSubAllocation->Offset();
+            (*ppMemory)->m_pSubAllocation = pSubAllocation;
+        }
+        else
+        {
+            Util::Destructor(pSubAllocation);
+
+            pDevice->FreeApiObject(pAllocator, pSystemMem);
+        }
+    }
+    else
+    {
+        vkResult = VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    return vkResult;
+}
+
 // =====================================================================================================================
 // Create Pinned Memory on each required device.
 // The function only create the PalMemory from device I and can be used on device I.
@@ -699,7 +1081,7 @@ VkResult Memory::CreateGpuPinnedMemory(
                     if (palResult == Pal::Result::Success)
                     {
                         // Add the GPU memory object to the residency list
-                        palResult = pDevice->AddMemReference(pPalDevice, pGpuMemory[deviceIdx]);
+                        palResult = pDevice->AddDeferredMemReference(pPalDevice, pGpuMemory[deviceIdx]);
 
                         if (palResult != Pal::Result::Success)
                         {
@@ -790,13 +1172,49 @@ VkResult Memory::OpenExternalSharedImage(
     {
     }
 
+    // The PAL image depends on how the handle is opened, so imports of the same allocation are only shared between
+    // images opening it the same way.  NT handles and Android hardware buffers can't be identified by the allocation
+    // behind them.
+    ExternalMemoryCache*  pImportCache = pDevice->GetExternalMemoryCache();
+    ExternalMemoryKey     importKey    = {};
+    ExternalMemoryImport* pImport      = nullptr;
+    bool                  cacheable    = false;
+
+    if (pImportCache->IsEnabled() && (openedViaName == false) && (importInfo.isNtHandle == false) &&
+        (importInfo.isAhbHandle == false))
+    {
+        Pal::ExternalImageOpenInfo hashedOpenInfo = palOpenInfo;
+        memset(&hashedOpenInfo.resourceInfo, 0, sizeof(hashedOpenInfo.resourceInfo));
+
+        Util::MetroHash::Hash hash = {};
+        Util::MetroHash64::Hash(reinterpret_cast<const uint8_t*>(&hashedOpenInfo), sizeof(hashedOpenInfo), hash.bytes);
+
+        cacheable = ExternalMemoryCache::MakeKey(importInfo.handle, Util::MetroHash::Compact64(&hash), &importKey);
+    }
+
+    if (cacheable)
+    {
+        pImport = pImportCache->Acquire(importKey);
+
+        if (pImport != nullptr)
+        {
+            return OpenCachedImport(pDevice, importInfo, pImport, ppVkMemory);
+        }
+    }
+
     palResult = pDevice->PalDevice(DefaultDeviceIndex)->GetExternalSharedImageSizes(
         palOpenInfo,
         &palImgSize,
         &palMemSize,
         &palImgCreateInfo);
 
-    const size_t totalSize = palImgSize + sizeof(Memory) + palMemSize;
+    // A cached import owns its PAL objects, which may outlive this memory object
+    if (cacheable)
+    {
+        pImport = pImportCache->CreateImport(importKey, palMemSize + palImgSize);
+    }
+
+    const size_t totalSize = (pImport != nullptr) ? sizeof(Memory) : (palImgSize + sizeof(Memory) + palMemSize);
 
     void* pMemMemory = static_cast<uint8_t*>(pDevice->AllocApiObject(
         pDevice->VkPhysicalDevice(DefaultDeviceIndex)->VkInstance()->GetAllocCallbacks(),
@@ -811,7 +1229,8 @@ VkResult Memory::OpenExternalSharedImage(
     Pal::IImage*     pExternalImage            = nullptr;
     if (palResult == Pal::Result::Success)
     {
-        void* pPalMemAddr    = Util::VoidPtrInc(pMemMemory, sizeof(Memory));
+        void* pPalMemAddr    = (pImport != nullptr) ? ExternalMemoryCache::GetPalStorage(pImport)
+                                                    : Util::VoidPtrInc(pMemMemory, sizeof(Memory));
         void* pImgMemoryAddr = Util::VoidPtrInc(pPalMemAddr, palMemSize);
 
         palResult = pDevice->PalDevice(DefaultDeviceIndex)->OpenExternalSharedImage(
@@ -844,6 +1263,17 @@ VkResult Memory::OpenExternalSharedImage(
                                                                   false,
                                                                   DefaultDeviceIndex,
                                                                   pExternalImage);
+
+                if (pImport != nullptr)
+                {
+                    pImport->pGpuMemory = pPalMemory[DefaultDeviceIndex];
+                    pImport->pImage     = pExternalImage;
+                    pImport->createInfo = palMemCreateInfo;
+
+                    pImportCache->AddImport(pImport);
+
+                    (*ppVkMemory)->m_pImport = pImport;
+                }
             }
             else
             {
@@ -860,9 +1290,60 @@ VkResult Memory::OpenExternalSharedImage(
         }
     }
 
+    if ((palResult != Pal::Result::Success) && (pImport != nullptr))
+    {
+        pImportCache->FreeImport(pImport);
+    }
+
     return PalToVkResult(palResult);
 }
 
+// =====================================================================================================================
+// Creates a memory object for an external allocation the device's external memory cache already has open.  The
+// memory object shares the PAL objects of the import and holds a reference to it instead of opening the handle again.
+// Importing takes ownership of the handle, and as PAL never sees this one, it is closed here.
+VkResult Memory::OpenCachedImport(
+    Device*                 pDevice,
+    const ImportMemoryInfo& importInfo,
+    ExternalMemoryImport*   pImport,
+    Memory**                ppMemory)
+{
+    VkResult result = VK_SUCCESS;
+
+    void* pSystemMem = pDevice->AllocApiObject(
+        pDevice->VkPhysicalDevice(DefaultDeviceIndex)->VkInstance()->GetAllocCallbacks(),
+        sizeof(Memory));
+
+    if (pSystemMem != nullptr)
+    {
+        Pal::IGpuMemory* pGpuMemory[MaxPalDevices] = {};
+
+        pGpuMemory[DefaultDeviceIndex] = pImport->pGpuMemory;
+
+        *ppMemory = VK_PLACEMENT_NEW(pSystemMem) Memory(pDevice,
+                                                        pGpuMemory,
+                                                        importInfo.handle,
+                                                        pImport->createInfo,
+                                                        false,
+                                                        DefaultDeviceIndex,
+                                                        pImport->pImage);
+
+        (*ppMemory)->m_pImport = pImport;
+
+#if defined(__unix__)
+        close(static_cast<int>(importInfo.handle));
+#endif
+    }
+    else
+    {
+        pDevice->GetExternalMemoryCache()->Release(pImport);
+
+        result = VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    return result;
+}
+
 // =====================================================================================================================
 void Memory::Init(
     Pal::IGpuMemory** ppPalMemory)
@@ -892,7 +1373,13 @@ Memory::Memory(
     m_primaryDeviceIndex(primaryIndex)
 {
     m_size = info.size;
+    m_offset = 0;
+    m_pSubAllocation = nullptr;
+    m_pImport = nullptr;
     m_heap0 = info.heaps[0];
+    m_pResidencyPrev = nullptr;
+    m_pResidencyNext = nullptr;
+    m_lastUseEpoch = 0;
 
     m_flags.u32All = 0;
     m_flags.sharedViaNtHandle = info.flags.sharedViaNtHandle;
@@ -917,7 +1404,13 @@ Memory::Memory(
 {
     // PAL info is not available for memory objects allocated for presentable images
     m_size = 0;
+    m_offset = 0;
+    m_pSubAllocation = nullptr;
+    m_pImport = nullptr;
     m_heap0 = Pal::GpuHeap::GpuHeapLocal;
+    m_pResidencyPrev = nullptr;
+    m_pResidencyNext = nullptr;
+    m_lastUseEpoch = 0;
 
     m_flags.u32All = 0;
     m_flags.multiInstance = multiInstance ? 1 : 0;
@@ -931,12 +1424,21 @@ void Memory::Free(
     Device*                      pDevice,
     const VkAllocationCallbacks* pAllocator)
 {
-    if (m_pExternalPalImage != nullptr)
+    // The PAL image of a cached import belongs to the import
+    if ((m_pExternalPalImage != nullptr) && (m_pImport == nullptr))
     {
         m_pExternalPalImage->Destroy();
         m_pExternalPalImage = nullptr;
     }
 
+    pDevice->GetMemoryEventLog()->Record(MemoryEventType::MemoryFree, this, nullptr, m_size, m_offset, m_heap0);
+
+    // Also restores the priority of demoted memory before it may go to the block cache
+    if (m_flags.residencyTracked)
+    {
+        pDevice->GetResidencyTracker()->Unregister(this);
+    }
+
     Pal::ResourceDestroyEventData data = {};
     data.pObj = this;
 
@@ -945,6 +1447,22 @@ void Memory::Free(
         &data,
         sizeof(Pal::ResourceDestroyEventData));
 
+    // Frees the physical memory no other transient attachment maps anymore
+    if (m_flags.transientAlias)
+    {
+        pDevice->GetTransientAliasPlanner()->ReleaseMemory(this);
+    }
+
+    if (m_pSubAllocation != nullptr)
+    {
+        // The PAL memory object belongs to the internal memory manager, so only the range goes back
+        pDevice->MemMgr()->FreeGpuMem(m_pSubAllocation);
+
+        Util::Destructor(m_pSubAllocation);
+
+        memset(m_pPalMemory, 0, sizeof(m_pPalMemory));
+    }
+
     for (uint32_t i = 0; i < m_pDevice->NumPalDevices(); ++i)
     {
         for (uint32_t j = 0; j < m_pDevice->NumPalDevices(); ++j)
@@ -972,13 +1490,34 @@ void Memory::Free(
     for (uint32_t i = 0; i < m_pDevice->NumPalDevices(); ++i)
     {
         Pal::IGpuMemory* pGpuMemory = m_pPalMemory[i][i];
-        if (pGpuMemory != nullptr)
+        if ((pGpuMemory != nullptr) && (m_pImport != nullptr))
+        {
+            // The PAL memory and its residency reference belong to the import, which other memory objects may share
+            if (m_flags.mapped)
+            {
+                pDevice->GetExternalMemoryCache()->Unmap(m_pImport);
+            }
+
+            pDevice->GetExternalMemoryCache()->Release(m_pImport);
+        }
+        else if (pGpuMemory != nullptr)
         {
             Pal::IDevice* pPalDevice = pDevice->PalDevice(i);
-            pDevice->RemoveMemReference(pPalDevice, pGpuMemory);
 
-            // Destroy PAL memory object
-            pGpuMemory->Destroy();
+            if (m_flags.transientAlias == 0)
+            {
+                pDevice->RemoveMemReference(pPalDevice, pGpuMemory);
+            }
+
+            if (m_flags.blockCacheable)
+            {
+                ReleaseCacheableBlock(pGpuMemory);
+            }
+            else
+            {
+                // Destroy PAL memory object
+                pGpuMemory->Destroy();
+            }
         }
     }
 
@@ -1035,26 +1574,60 @@ VkResult Memory::OpenExternalMemory(
 
     openInfo.resourceInfo.flags.ntHandle           = importInfo.isNtHandle;
     openInfo.resourceInfo.flags.androidHwBufHandle = importInfo.isAhbHandle;
+
+    // NT handles and Android hardware buffers can't be identified by the allocation behind them
+    ExternalMemoryCache*  pImportCache = pDevice->GetExternalMemoryCache();
+    ExternalMemoryKey     importKey    = {};
+    ExternalMemoryImport* pImport      = nullptr;
+
+    const bool cacheable = pImportCache->IsEnabled()           &&
+                           (openedViaName == false)            &&
+                           (importInfo.isNtHandle == false)    &&
+                           (importInfo.isAhbHandle == false)   &&
+                           ExternalMemoryCache::MakeKey(importInfo.handle, 0, &importKey);
+
+    if (cacheable)
+    {
+        pImport = pImportCache->Acquire(importKey);
+
+        if (pImport != nullptr)
+        {
+            return OpenCachedImport(pDevice, importInfo, pImport, ppMemory);
+        }
+    }
+
     // Get CPU memory requirements for PAL
     gpuMemorySize = pDevice->PalDevice(DefaultDeviceIndex)->GetExternalSharedGpuMemorySize(&palResult);
     VK_ASSERT(palResult == Pal::Result::Success);
 
+    // A cached import owns its PAL memory object, which may outlive this memory object
+    if (cacheable)
+    {
+        pImport = pImportCache->CreateImport(importKey, gpuMemorySize);
+    }
+
     // Allocate enough for the PAL memory object and our own dispatchable memory
     pSystemMem = static_cast<uint8_t*>(pDevice->AllocApiObject(
         pDevice->VkPhysicalDevice(DefaultDeviceIndex)->VkInstance()->GetAllocCallbacks(),
-        gpuMemorySize + sizeof(Memory)));
+        ((pImport != nullptr) ? 0 : gpuMemorySize) + sizeof(Memory)));
 
     // Check for out of memory
     if (pSystemMem == nullptr)
     {
+        if (pImport != nullptr)
+        {
+            pImportCache->FreeImport(pImport);
+        }
+
         return VK_ERROR_OUT_OF_HOST_MEMORY;
     }
 
     // Allocate the PAL memory object
-    palResult = pDevice->PalDevice(DefaultDeviceIndex)->OpenExternalSharedGpuMemory(openInfo,
-                                                                  pSystemMem + sizeof(Memory),
-                                                                  &createInfo,
-                                                                  &pGpuMemory[DefaultDeviceIndex]);
+    palResult = pDevice->PalDevice(DefaultDeviceIndex)->OpenExternalSharedGpuMemory(
+        openInfo,
+        (pImport != nullptr) ? ExternalMemoryCache::GetPalStorage(pImport) : (pSystemMem + sizeof(Memory)),
+        &createInfo,
+        &pGpuMemory[DefaultDeviceIndex]);
 
     // On success...
     if (palResult == Pal::Result::Success)
@@ -1071,6 +1644,16 @@ VkResult Memory::OpenExternalMemory(
                                                            createInfo,
                                                            false,
                                                            DefaultDeviceIndex);
+
+            if (pImport != nullptr)
+            {
+                pImport->pGpuMemory = pGpuMemory[DefaultDeviceIndex];
+                pImport->createInfo = createInfo;
+
+                pImportCache->AddImport(pImport);
+
+                (*ppMemory)->m_pImport = pImport;
+            }
         }
         else
         {
@@ -1084,6 +1667,11 @@ VkResult Memory::OpenExternalMemory(
         pDevice->FreeApiObject(
             pDevice->VkPhysicalDevice(DefaultDeviceIndex)->VkInstance()->GetAllocCallbacks(),
             pSystemMem);
+
+        if (pImport != nullptr)
+        {
+            pImportCache->FreeImport(pImport);
+        }
     }
 
     return PalToVkResult(palResult);
@@ -1101,6 +1689,9 @@ Pal::OsExternalHandle Memory::GetShareHandle(
     VK_ASSERT(condition);
 #endif
 
+    // Exportable memory is never sub-allocated
+    VK_ASSERT(m_pSubAllocation == nullptr);
+
     Pal::OsExternalHandle handle = 0;
 
     Pal::GpuMemoryExportInfo exportInfo = {};
@@ -1119,21 +1710,40 @@ VkResult Memory::Map(
 {
     VkResult result = VK_SUCCESS;
 
+    MarkUsed();
+
     // According to spec, "memory must not have been allocated with multiple instances"
     // if it is multi-instance allocation, we should just return VK_ERROR_MEMORY_MAP_FAILED
-    if (m_flags.multiInstance == 0)
+    if ((m_flags.multiInstance == 0) && (m_pSubAllocation != nullptr))
+    {
+        // The block of sub-allocated host visible memory is persistently mapped
+        void* pData = m_pSubAllocation->CpuAddr(m_primaryDeviceIndex);
+
+        if (pData != nullptr)
+        {
+            *ppData = Util::VoidPtrInc(pData, static_cast<size_t>(offset));
+        }
+        else
+        {
+            result = VK_ERROR_MEMORY_MAP_FAILED;
+        }
+    }
+    else if (m_flags.multiInstance == 0)
     {
         Pal::Result palResult = Pal::Result::Success;
         if (PalMemory(m_primaryDeviceIndex) != nullptr)
         {
             void* pData;
 
-            palResult = PalMemory(m_primaryDeviceIndex)->Map(&pData);
+            // Memory objects sharing a cached import share its mapping as well
+            palResult = (m_pImport != nullptr) ? m_pDevice->GetExternalMemoryCache()->Map(m_pImport, &pData)
+                                               : PalMemory(m_primaryDeviceIndex)->Map(&pData);
 
             if (palResult == Pal::Result::Success)
             {
                 *ppData = Util::VoidPtrInc(pData, static_cast<size_t>(offset));
 
+                m_flags.mapped = 1;
             }
             result = (palResult == Pal::Result::Success) ? VK_SUCCESS : VK_ERROR_MEMORY_MAP_FAILED;
         }
@@ -1158,8 +1768,20 @@ void Memory::Unmap(void)
 
     VK_ASSERT(m_flags.multiInstance == 0);
 
-    palResult = PalMemory(m_primaryDeviceIndex)->Unmap();
-    VK_ASSERT(palResult == Pal::Result::Success);
+    // Sub-allocated memory stays mapped for as long as its block lives
+    if ((m_pSubAllocation == nullptr) && (m_pImport != nullptr))
+    {
+        m_pDevice->GetExternalMemoryCache()->Unmap(m_pImport);
+
+        m_flags.mapped = 0;
+    }
+    else if (m_pSubAllocation == nullptr)
+    {
+        palResult = PalMemory(m_primaryDeviceIndex)->Unmap();
+        VK_ASSERT(palResult == Pal::Result::Success);
+
+        m_flags.mapped = 0;
+    }
 }
 
 // =====================================================================================================================
@@ -1182,8 +1804,9 @@ void Memory::ElevatePriority(
     MemoryPriority priority)
 {
     // Update PAL memory object's priority using a double-checked lock if the current priority is lower than
-    // the new given priority.
-    if (m_priority < priority)
+    // the new given priority.  The block of sub-allocated memory is shared, so its priority is left alone, and so are
+    // the virtual ranges of transient attachments.
+    if ((m_pSubAllocation == nullptr) && (m_flags.transientAlias == 0) && (m_priority < priority))
     {
         Util::MutexAuto lock(m_pDevice->GetMemoryMutex());
 
@@ -1202,6 +1825,74 @@ void Memory::ElevatePriority(
     }
 }
 
+// =====================================================================================================================
+// Tells the residency tracker that the memory is in use.
+void Memory::MarkUsed()
+{
+    m_pDevice->GetResidencyTracker()->Touch(this);
+}
+
+// =====================================================================================================================
+// Adds a buffer or image bind to the device's memory event log and GPU address index.
+void Memory::RecordBind(
+    MemoryEventType type,
+    const void*     pResource,
+    Pal::gpusize    size,
+    Pal::gpusize    offset)
+{
+    m_pDevice->GetMemoryEventLog()->Record(type, pResource, this, size, offset, m_heap0);
+
+    if (m_flags.transientAlias && (type == MemoryEventType::ImageBind))
+    {
+        m_pDevice->GetTransientAliasPlanner()->BindImage(this, static_cast<const Image*>(pResource));
+    }
+
+    GpuAddressIndex* pAddressIndex = m_pDevice->GetGpuAddressIndex();
+
+    if (pAddressIndex->IsEnabled() && (PalMemory(DefaultDeviceIndex) != nullptr))
+    {
+        pAddressIndex->Insert(pResource,
+                              (type == MemoryEventType::BufferBind) ? VK_OBJECT_TYPE_BUFFER : VK_OBJECT_TYPE_IMAGE,
+                              PalMemory(DefaultDeviceIndex)->Desc().gpuVirtAddr + offset,
+                              size);
+    }
+}
+
+// =====================================================================================================================
+// Lowers the priority of the PAL memory one level below this memory's own priority, or gives the memory its own
+// priority back.  Used by the residency tracker for memory that went idle while local memory is oversubscribed.
+void Memory::SetDemoted(
+    bool demoted)
+{
+    VK_ASSERT(m_pSubAllocation == nullptr);
+
+    Util::MutexAuto lock(m_pDevice->GetMemoryMutex());
+
+    MemoryPriority priority = m_priority;
+
+    if (demoted)
+    {
+        const uint32_t level = priority.priority;
+
+        if (level > static_cast<uint32_t>(Pal::GpuMemPriority::VeryLow))
+        {
+            priority.priority = level - 1;
+        }
+
+        priority.offset = static_cast<uint32_t>(Pal::GpuMemPriorityOffset::Offset0);
+    }
+
+    for (uint32_t deviceIdx = 0; deviceIdx < m_pDevice->NumPalDevices(); deviceIdx++)
+    {
+        if (PalMemory(deviceIdx) != nullptr)
+        {
+            PalMemory(deviceIdx)->SetPriority(priority.PalPriority(), priority.PalOffset());
+        }
+    }
+
+    m_flags.residencyDemoted = demoted ? 1 : 0;
+}
+
 // =====================================================================================================================
 // Decodes a priority setting value into a compatible PAL priority/offset pair.
 MemoryPriority MemoryPriority::FromSetting(
@@ -1480,7 +2171,7 @@ VKAPI_ATTR uint64_t VKAPI_CALL vkGetDeviceMemoryOpaqueCaptureAddress(
 {
     const Memory* pMemory = Memory::ObjectFromHandle(pInfo->memory);
 
-    return pMemory->PalMemory(DefaultDeviceIndex)->Desc().gpuVirtAddr;
+    return pMemory->PalMemory(DefaultDeviceIndex)->Desc().gpuVirtAddr + pMemory->Offset();
 }
 
 } // namespace entry
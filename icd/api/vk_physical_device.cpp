@@ -41,6 +41,7 @@
 #include "include/vk_utils.h"
 #include "include/vk_conv.h"
 #include "include/vk_surface.h"
+#include "include/startup_profile.h"
 
 #include "include/khronos/vk_icd.h"
 
@@ -52,9 +53,11 @@
 
 #include "palDevice.h"
 #include "palCmdBuffer.h"
+#include "palFile.h"
 #include "palFormatInfo.h"
 #include "palLib.h"
 #include "palMath.h"
+#include "palMetroHash.h"
 #include "palMsaaState.h"
 #include "palPlatformKey.h"
 #include "palScreen.h"
@@ -342,7 +345,7 @@ PhysicalDevice::PhysicalDevice(
     m_pPlatformKey(nullptr)
 {
     memset(&m_limits, 0, sizeof(m_limits));
-    memset(m_formatFeatureMsaaTarget, 0, sizeof(m_formatFeatureMsaaTarget));
+    memset(&m_formatFeatures, 0, sizeof(m_formatFeatures));
     memset(&m_queueFamilies, 0, sizeof(m_queueFamilies));
     memset(&m_memoryProperties, 0, sizeof(m_memoryProperties));
     memset(&m_gpaProps, 0, sizeof(m_gpaProps));
@@ -652,6 +655,8 @@ static VK_INLINE void GenerateCacheUuid(
 // =====================================================================================================================
 VkResult PhysicalDevice::Initialize()
 {
+    StartupPhase startupPhase("PhysicalDevice::Initialize");
+
     const bool nullGpu = VkInstance()->IsNullGpuModeEnabled();
 
     // Collect generic device properties
@@ -1011,6 +1016,12 @@ VkResult PhysicalDevice::Initialize()
     if (vkResult == VK_SUCCESS)
     {
         InitializePlatformKey(settings);
+
+        // Physical devices may be initialized concurrently, but the compiler's process-wide state is not set up in a
+        // thread-safe way.
+        static Util::Mutex compilerInitLock;
+        Util::MutexAuto    lock(&compilerInitLock);
+
         vkResult = m_compiler.Initialize();
     }
 
@@ -1088,10 +1099,195 @@ void PhysicalDevice::PopulateGpaProperties()
 // =====================================================================================================================
 void PhysicalDevice::PopulateFormatProperties()
 {
-    // Collect format properties
-    Pal::MergedFormatPropertiesTable fmtProperties = {};
-    m_pPalDevice->GetFormatProperties(&fmtProperties);
+    // Collect format properties.  The Vulkan format support computed from them only depends on the PAL table and a few
+    // extensions, so physical devices of the same ASIC can share it instead of each walking every format.
+    FormatFeatureKey key;
+    memset(&key, 0, sizeof(key));
+
+    key.revision = m_properties.revision;
+
+    m_pPalDevice->GetFormatProperties(&key.palFormatProperties);
+
+    if (IsExtensionSupported(DeviceExtensions::KHR_FRAGMENT_SHADING_RATE))
+    {
+        key.extensionMask |= 0x1;
+    }
+
+    if (IsExtensionSupported(DeviceExtensions::KHR_SAMPLER_YCBCR_CONVERSION))
+    {
+        key.extensionMask |= 0x2;
+    }
+
+    if (IsExtensionSupported(DeviceExtensions::EXT_SHADER_IMAGE_ATOMIC_INT64))
+    {
+        key.extensionMask |= 0x4;
+    }
+
+    if (Manager()->FindFormatFeatureTable(key, &m_formatFeatures) == false)
+    {
+        if (LoadCachedFormatProperties(key) == false)
+        {
+            ComputeFormatProperties(key.palFormatProperties);
+
+            StoreCachedFormatProperties(key);
+        }
+
+        Manager()->AddFormatFeatureTable(key, m_formatFeatures);
+    }
+
+    // We should always support some kind of compressed format
+    VK_ASSERT(VerifyBCFormatSupport(*this) || VerifyEtc2FormatSupport(*this) || VerifyAstcLdrFormatSupport(*this));
+}
+
+// =====================================================================================================================
+// Header of the persistent format support cache file.  The cache is only used if every field matches this process.
+// No runtime setting changes the format support computed from a FormatFeatureKey, and the extensions which do are part
+// of the key, so the settings need not be part of the header.
+struct FormatCacheFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t driverBuild;   // ICD version mixed with the build timestamp
+    uint32_t deviceId;
+    uint64_t keyHash;       // Hash of the FormatFeatureKey the table was computed from
+    uint32_t tableSize;     // sizeof(FormatFeatureTable)
+    uint32_t reserved;
+};
+
+static constexpr uint32_t FormatCacheFileMagic   = 0x43465641; // "AVFC"
+static constexpr uint32_t FormatCacheFileVersion = 2;
+
+// =====================================================================================================================
+// Fills in the header the persistent format support cache must have to be valid for this physical device and key.
+// Returns false if caching is disabled or no cache location is available; otherwise pPath receives the file path.
+bool PhysicalDevice::GetFormatCacheFileHeader(
+    const FormatFeatureKey& key,
+    FormatCacheFileHeader*  pHeader,
+    char*                   pPath,
+    size_t                  pathSize
+    ) const
+{
+    const RuntimeSettings& settings  = GetRuntimeSettings();
+    const char*            pUserPath = m_pPalDevice->GetCacheFilePath();
+
+    bool valid = settings.enablePhysicalDeviceCapsCache &&
+                 settings.usePipelineCachingDefaultLocation &&
+                 (pUserPath != nullptr);
 
+    if (valid)
+    {
+        valid = (Util::Snprintf(pPath, pathSize, "%s%sAMDVLK_formats_%x_%x.bin",
+                                pUserPath, settings.pipelineCachingDefaultLocation,
+                                m_properties.deviceId, m_properties.revisionId) > 0);
+    }
+
+    if (valid)
+    {
+        memset(pHeader, 0, sizeof(*pHeader));
+
+        pHeader->magic        = FormatCacheFileMagic;
+        pHeader->version      = FormatCacheFileVersion;
+        pHeader->driverBuild  = ((VULKAN_ICD_MAJOR_VERSION << 22) | (VULKAN_ICD_BUILD_VERSION & ((1 << 22) - 1))) ^
+                                Util::HashLiteralString(__DATE__ __TIME__);
+        pHeader->deviceId     = m_properties.deviceId;
+        pHeader->tableSize    = sizeof(FormatFeatureTable);
+
+        Util::MetroHash::Hash hash = {};
+
+        Util::MetroHash64::Hash(reinterpret_cast<const uint8_t*>(&key), sizeof(key), hash.bytes);
+        pHeader->keyHash      = Util::MetroHash::Compact64(&hash);
+    }
+
+    return valid;
+}
+
+// =====================================================================================================================
+// Loads this physical device's format support from the persistent cache written by an earlier process.  Returns false
+// if there is no cache file or it was written by a different driver build, device or PAL format table.
+bool PhysicalDevice::LoadCachedFormatProperties(
+    const FormatFeatureKey& key)
+{
+    FormatCacheFileHeader expected = {};
+    char                  path[Util::PathBufferLen] = {};
+
+    bool loaded = false;
+
+    if (GetFormatCacheFileHeader(key, &expected, path, sizeof(path)) && Util::File::Exists(path))
+    {
+        Util::File file;
+
+        if (file.Open(path, Util::FileAccessRead | Util::FileAccessBinary) == Util::Result::Success)
+        {
+            FormatCacheFileHeader header    = {};
+            FormatFeatureTable    table;
+            size_t                bytesRead = 0;
+
+            if ((file.Read(&header, sizeof(header), &bytesRead) == Util::Result::Success) &&
+                (bytesRead == sizeof(header)) &&
+                (memcmp(&header, &expected, sizeof(header)) == 0) &&
+                (file.Read(&table, sizeof(table), &bytesRead) == Util::Result::Success) &&
+                (bytesRead == sizeof(table)))
+            {
+                m_formatFeatures = table;
+                loaded           = true;
+            }
+
+            file.Close();
+        }
+    }
+
+    return loaded;
+}
+
+// =====================================================================================================================
+// Writes this physical device's format support to the persistent cache.  The file is written under a temporary name
+// and renamed into place so concurrently starting processes never read a partial file.  The temporary name is made
+// from the CPU timestamp, which concurrently starting processes are unlikely to share, and skips existing files.
+void PhysicalDevice::StoreCachedFormatProperties(
+    const FormatFeatureKey& key
+    ) const
+{
+    FormatCacheFileHeader header = {};
+    char                  path[Util::PathBufferLen] = {};
+
+    if (GetFormatCacheFileHeader(key, &header, path, sizeof(path)))
+    {
+        char tempPath[Util::PathBufferLen] = {};
+
+        uint64_t suffix = static_cast<uint64_t>(Util::GetPerfCpuTime());
+
+        do
+        {
+            Util::Snprintf(tempPath, sizeof(tempPath), "%s.%llx.tmp", path, static_cast<unsigned long long>(suffix++));
+        }
+        while (Util::File::Exists(tempPath));
+
+        Util::File file;
+
+        if (file.Open(tempPath, Util::FileAccessWrite | Util::FileAccessBinary) == Util::Result::Success)
+        {
+            Util::Result result = file.Write(&header, sizeof(header));
+
+            if (result == Util::Result::Success)
+            {
+                result = file.Write(&m_formatFeatures, sizeof(m_formatFeatures));
+            }
+
+            file.Close();
+
+            if ((result != Util::Result::Success) || (rename(tempPath, path) != 0))
+            {
+                remove(tempPath);
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Converts the PAL format properties table to the Vulkan format support of this physical device.
+void PhysicalDevice::ComputeFormatProperties(
+    const Pal::MergedFormatPropertiesTable& fmtProperties)
+{
     for (uint32_t i = 0; i < VK_SUPPORTED_FORMAT_COUNT; i++)
     {
         VkFormat format = Formats::FromIndex(i);
@@ -1175,11 +1371,11 @@ void PhysicalDevice::PopulateFormatProperties()
 
         if ((format == VK_FORMAT_R64_SINT) || (format == VK_FORMAT_R64_UINT))
         {
-            memset(&m_formatFeaturesTable[i], 0, sizeof(VkFormatProperties));
+            memset(&m_formatFeatures.formatFeatures[i], 0, sizeof(VkFormatProperties));
 
             if (IsExtensionSupported(DeviceExtensions::EXT_SHADER_IMAGE_ATOMIC_INT64))
             {
-                m_formatFeaturesTable[i].optimalTilingFeatures = (optimalFlags &
+                m_formatFeatures.formatFeatures[i].optimalTilingFeatures = (optimalFlags &
                     (VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT |
                      VK_FORMAT_FEATURE_TRANSFER_SRC_BIT  |
                      VK_FORMAT_FEATURE_TRANSFER_DST_BIT)) |
@@ -1190,9 +1386,9 @@ void PhysicalDevice::PopulateFormatProperties()
         }
         else
         {
-            m_formatFeaturesTable[i].bufferFeatures        = bufferFlags;
-            m_formatFeaturesTable[i].linearTilingFeatures  = linearFlags;
-            m_formatFeaturesTable[i].optimalTilingFeatures = optimalFlags;
+            m_formatFeatures.formatFeatures[i].bufferFeatures        = bufferFlags;
+            m_formatFeatures.formatFeatures[i].linearTilingFeatures  = linearFlags;
+            m_formatFeatures.formatFeatures[i].optimalTilingFeatures = optimalFlags;
         }
 
         // Vulkan doesn't have a corresponding flag for multisampling support.  If there ends up being more cases
@@ -1202,12 +1398,9 @@ void PhysicalDevice::PopulateFormatProperties()
 
         if (fmtProperties.features[formatIdx][Pal::IsNonLinear] & Pal::FormatFeatureMsaaTarget)
         {
-            Util::WideBitfieldSetBit(m_formatFeatureMsaaTarget, i);
+            Util::WideBitfieldSetBit(m_formatFeatures.msaaTarget, i);
         }
     }
-
-    // We should always support some kind of compressed format
-    VK_ASSERT(VerifyBCFormatSupport(*this) || VerifyEtc2FormatSupport(*this) || VerifyAstcLdrFormatSupport(*this));
 }
 
 // =====================================================================================================================
@@ -3648,6 +3841,7 @@ DeviceExtensions::Supported PhysicalDevice::GetAvailableExtensions(
         availableExtensions.AddExtension(VK_DEVICE_EXTENSION(KHR_SYNCHRONIZATION2));
         availableExtensions.AddExtension(VK_DEVICE_EXTENSION(EXT_CUSTOM_BORDER_COLOR));
         availableExtensions.AddExtension(VK_DEVICE_EXTENSION(EXT_COLOR_WRITE_ENABLE));
+        availableExtensions.AddExtension(VK_DEVICE_EXTENSION(KHR_DYNAMIC_RENDERING));
 
     bool disableAMDVendorExtensions = false;
     if (pPhysicalDevice != nullptr)
@@ -5167,6 +5361,13 @@ void PhysicalDevice::GetFeatures2(
                 break;
             }
 
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR:
+            {
+                auto* pExtInfo = reinterpret_cast<VkPhysicalDeviceDynamicRenderingFeaturesKHR*>(pHeader);
+                pExtInfo->dynamicRendering = VK_TRUE;
+                break;
+            }
+
 	    case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT:
 	    {
                 auto* pExtInfo = reinterpret_cast<VkPhysicalDeviceExtendedDynamicState2FeaturesEXT*>(pHeader);
@@ -32,10 +32,12 @@
 #include "include/vk_conv.h"
 #include "include/vk_physical_device.h"
 #include "include/vk_physical_device_manager.h"
+#include "include/startup_profile.h"
 #include "../layers/include/query_dlist.h"
 #include "palDevice.h"
 #include "palPlatform.h"
 #include "palScreen.h"
+#include "palThread.h"
 #include "palVectorImpl.h"
 #include <algorithm>
 #include <vector>
@@ -51,9 +53,10 @@ PhysicalDeviceManager::PhysicalDeviceManager(
     m_pInstance(pInstance),
     m_pDisplayManager(pDisplayManager),
     m_devices(pInstance->Allocator()),
-    m_pAllNullProperties(nullptr)
+    m_pAllNullProperties(nullptr),
+    m_formatFeatureCacheCount(0)
 {
-
+    memset(m_pFormatFeatureCache, 0, sizeof(m_pFormatFeatureCache));
 }
 
 // =====================================================================================================================
@@ -119,6 +122,11 @@ PhysicalDeviceManager::~PhysicalDeviceManager()
     }
 
     DestroyLockedPhysicalDeviceList();
+
+    for (uint32_t i = 0; i < m_formatFeatureCacheCount; ++i)
+    {
+        m_pInstance->FreeMem(m_pFormatFeatureCache[i]);
+    }
 }
 
 // =====================================================================================================================
@@ -239,6 +247,8 @@ uint32_t PhysicalDeviceManager::GetDeviceGroupIndices(
 // Update the list of physical devices tracked by the physical device manager (assumes mutex is locked).
 VkResult PhysicalDeviceManager::UpdateLockedPhysicalDeviceList(void)
 {
+    StartupPhase startupPhase("PhysicalDeviceManager::UpdateLockedPhysicalDeviceList");
+
     VkResult result = VK_SUCCESS;
 
     Pal::IDevice* pPalDeviceList[Pal::MaxDevices] = {};
@@ -295,27 +305,27 @@ VkResult PhysicalDeviceManager::UpdateLockedPhysicalDeviceList(void)
 
     if (result == VK_SUCCESS)
     {
+        VkPhysicalDevice newPhysicalDevices[Pal::MaxDevices] = {};
+        VkResult         createResults[Pal::MaxDevices]      = {};
+
+        CreateLockedPhysicalDevices(
+            palDeviceCount,
+            pPalDeviceList,
+            settingsArray,
+            appProfiles,
+            newPhysicalDevices,
+            createResults);
+
         for (uint32_t i = 0; i < palDeviceCount; ++i)
         {
-            // This physical device is currently not known by the physical device manager
-            // so we have to create a new API physical device object for it
-            VkPhysicalDevice newPhysicalDevice = VK_NULL_HANDLE;
-
-            result = PhysicalDevice::Create(
-                this,
-                pPalDeviceList[i],
-                settingsArray[i],
-                appProfiles[i],
-                &newPhysicalDevice);
-
-            if (result == VK_SUCCESS)
+            if (createResults[i] == VK_SUCCESS)
             {
                 // Add the new physical device object to the newly constructed list
-                deviceList[deviceCount++] = newPhysicalDevice;
+                deviceList[deviceCount++] = newPhysicalDevices[i];
             }
-            else
+            else if (result == VK_SUCCESS)
             {
-                break;
+                result = createResults[i];
             }
         }
     }
@@ -430,6 +440,80 @@ VkResult PhysicalDeviceManager::UpdateLockedPhysicalDeviceList(void)
     return result;
 }
 
+// =====================================================================================================================
+// Arguments and result of creating one physical device on a worker thread.
+struct PhysicalDeviceCreateTask
+{
+    PhysicalDeviceManager* pManager;
+    Pal::IDevice*          pPalDevice;
+    VulkanSettingsLoader*  pSettingsLoader;
+    AppProfile             appProfile;
+    VkPhysicalDevice       device;
+    VkResult               result;
+};
+
+// =====================================================================================================================
+static void CreatePhysicalDeviceThreadFunc(
+    void* pParam)
+{
+    PhysicalDeviceCreateTask* pTask = static_cast<PhysicalDeviceCreateTask*>(pParam);
+
+    pTask->result = PhysicalDevice::Create(
+        pTask->pManager,
+        pTask->pPalDevice,
+        pTask->pSettingsLoader,
+        pTask->appProfile,
+        &pTask->device);
+}
+
+// =====================================================================================================================
+// Creates an API physical device object for each PAL device (assumes mutex is locked).  Every device initializes its
+// own PAL device and shader compiler, which dominates instance creation on multi-GPU systems, so all but the first
+// device are created on worker threads while the first is created on the calling thread.  A device whose thread
+// cannot be started is created on the calling thread instead.
+void PhysicalDeviceManager::CreateLockedPhysicalDevices(
+    uint32_t              palDeviceCount,
+    Pal::IDevice**        ppPalDevices,
+    VulkanSettingsLoader* pSettingsLoaders[],
+    const AppProfile*     pAppProfiles,
+    VkPhysicalDevice*     pDevices,
+    VkResult*             pResults)
+{
+    PhysicalDeviceCreateTask tasks[Pal::MaxDevices]         = {};
+    Util::Thread             threads[Pal::MaxDevices];
+    bool                     threadStarted[Pal::MaxDevices] = {};
+
+    for (uint32_t i = 0; i < palDeviceCount; ++i)
+    {
+        tasks[i].pManager        = this;
+        tasks[i].pPalDevice      = ppPalDevices[i];
+        tasks[i].pSettingsLoader = pSettingsLoaders[i];
+        tasks[i].appProfile      = pAppProfiles[i];
+        tasks[i].device          = VK_NULL_HANDLE;
+        tasks[i].result          = VK_SUCCESS;
+    }
+
+    for (uint32_t i = 1; i < palDeviceCount; ++i)
+    {
+        threadStarted[i] = (threads[i].Begin(CreatePhysicalDeviceThreadFunc, &tasks[i]) == Util::Result::Success);
+    }
+
+    for (uint32_t i = 0; i < palDeviceCount; ++i)
+    {
+        if (threadStarted[i])
+        {
+            threads[i].Join();
+        }
+        else
+        {
+            CreatePhysicalDeviceThreadFunc(&tasks[i]);
+        }
+
+        pDevices[i] = tasks[i].device;
+        pResults[i] = tasks[i].result;
+    }
+}
+
 // =====================================================================================================================
 // Destroy currently tracked physical devices (assumes mutex is locked).
 void PhysicalDeviceManager::DestroyLockedPhysicalDeviceList(void)
@@ -524,4 +608,52 @@ VkResult PhysicalDeviceManager::EnumerateAllNullPhysicalDeviceProperties(
     return status;
 }
 
+// =====================================================================================================================
+// Looks for format support computed by an earlier physical device from the same inputs.  Returns true and copies it
+// to pTable if found.
+bool PhysicalDeviceManager::FindFormatFeatureTable(
+    const FormatFeatureKey& key,
+    FormatFeatureTable*     pTable)
+{
+    Util::MutexAuto lock(&m_formatFeatureCacheLock);
+
+    bool found = false;
+
+    for (uint32_t i = 0; (i < m_formatFeatureCacheCount) && (found == false); ++i)
+    {
+        if (memcmp(&m_pFormatFeatureCache[i]->key, &key, sizeof(key)) == 0)
+        {
+            *pTable = m_pFormatFeatureCache[i]->table;
+            found   = true;
+        }
+    }
+
+    return found;
+}
+
+// =====================================================================================================================
+// Remembers format support computed by a physical device so other devices of the same ASIC can skip computing it.
+// Failing to allocate the entry only costs the next such device the recomputation.
+void PhysicalDeviceManager::AddFormatFeatureTable(
+    const FormatFeatureKey&   key,
+    const FormatFeatureTable& table)
+{
+    Util::MutexAuto lock(&m_formatFeatureCacheLock);
+
+    if (m_formatFeatureCacheCount < MaxPhysicalDevices)
+    {
+        void* pMemory = m_pInstance->AllocMem(sizeof(FormatFeatureCacheEntry), VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE);
+
+        if (pMemory != nullptr)
+        {
+            FormatFeatureCacheEntry* pEntry = static_cast<FormatFeatureCacheEntry*>(pMemory);
+
+            pEntry->key   = key;
+            pEntry->table = table;
+
+            m_pFormatFeatureCache[m_formatFeatureCacheCount++] = pEntry;
+        }
+    }
+}
+
 } // namespace vk
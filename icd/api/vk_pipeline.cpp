@@ -91,7 +91,7 @@ static_assert(VK_ARRAY_SIZE(HwStageNames) == static_cast<uint32_t>(Util::Abi::Ha
 
 // The number of executable statistics to return through
 // the vkGetPipelineExecutableStatisticsKHR function
-static constexpr uint32_t ExecutableStatisticsCount = 5;
+static constexpr uint32_t ExecutableStatisticsCount = 8;
 
 // =====================================================================================================================
 // Generates a hash using the contents of a VkSpecializationInfo struct
@@ -122,9 +122,24 @@ void Pipeline::GenerateHashFromShaderStageCreateInfo(
 {
     pHasher->Update(desc.flags);
     pHasher->Update(desc.stage);
-    pHasher->Update(ShaderModule::ObjectFromHandle(desc.module)->GetCodeHash(desc.pName));
+    const ShaderModule* pModule = ShaderModule::ObjectFromHandle(desc.module);
 
-    if (desc.pSpecializationInfo != nullptr)
+    pHasher->Update(pModule->GetCodeHash(desc.pName));
+
+    // Optimized and unoptimized builds of the same code (see the async layer) produce different binaries, so they must
+    // not share API hashes.  Other modules keep their hashes.
+    if ((pModule->GetFlags() & VK_SHADER_MODULE_ENABLE_OPT_BIT) != 0)
+    {
+        pHasher->Update(VK_SHADER_MODULE_ENABLE_OPT_BIT);
+    }
+
+    // Only the entries which have an effect on the code are hashed where the module's spec constants are known, in
+    // line with the specialization info the compiler gets.
+    if ((desc.pSpecializationInfo != nullptr) && pModule->HasSpecConstantInfo())
+    {
+        pModule->HashSpecializationInfo(pHasher, *desc.pSpecializationInfo);
+    }
+    else if (desc.pSpecializationInfo != nullptr)
     {
         GenerateHashFromSpecializationInfo(pHasher, *desc.pSpecializationInfo);
     }
@@ -133,18 +148,26 @@ void Pipeline::GenerateHashFromShaderStageCreateInfo(
 
 // =====================================================================================================================
 // Generates a hash using the contents of a VkPipelineDynamicStateCreateInfo struct
-// Pipeline compilation affected by: none
+// Pipeline compilation affected by:
+//     - VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE_EXT
 void Pipeline::GenerateHashFromDynamicStateCreateInfo(
-    Util::MetroHash128* pHasher,
+    Util::MetroHash128*                     pBaseHasher,
+    Util::MetroHash128*                     pApiHasher,
     const VkPipelineDynamicStateCreateInfo& desc)
 {
-    pHasher->Update(desc.flags);
-    pHasher->Update(desc.dynamicStateCount);
+    bool dynamicVertexStride = false;
+
+    pApiHasher->Update(desc.flags);
+    pApiHasher->Update(desc.dynamicStateCount);
 
     for (uint32_t i = 0; i < desc.dynamicStateCount; i++)
     {
-        pHasher->Update(desc.pDynamicStates[i]);
+        pApiHasher->Update(desc.pDynamicStates[i]);
+
+        dynamicVertexStride |= (desc.pDynamicStates[i] == VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE_EXT);
     }
+
+    pBaseHasher->Update(dynamicVertexStride);
 }
 
 // =====================================================================================================================
@@ -154,13 +177,12 @@ Pipeline::Pipeline(
     :
     m_pDevice(pDevice),
     m_userDataLayout(),
-    m_palPipelineHash(0),
+    m_palPipelines(),
     m_staticStateMask(0),
     m_apiHash(0),
     m_type(type),
-    m_pBinary(nullptr)
+    m_pPalPipelines(&m_palPipelines)
 {
-    memset(m_pPalPipeline, 0, sizeof(m_pPalPipeline));
 }
 
 void Pipeline::Init(
@@ -173,12 +195,12 @@ void Pipeline::Init(
     m_userDataLayout = pLayout->GetInfo().userDataLayout;
     m_staticStateMask = staticStateMask;
     m_apiHash = apiHash;
-    m_pBinary = pBinary;
-    m_palPipelineHash = pPalPipeline[DefaultDeviceIndex]->GetInfo().internalPipelineHash.unique;
+    m_palPipelines.pBinary = pBinary;
+    m_palPipelines.palPipelineHash = pPalPipeline[DefaultDeviceIndex]->GetInfo().internalPipelineHash.unique;
 
     for (uint32_t devIdx = 0; devIdx < m_pDevice->NumPalDevices(); devIdx++)
     {
-        m_pPalPipeline[devIdx] = pPalPipeline[devIdx];
+        m_palPipelines.pPalPipeline[devIdx] = pPalPipeline[devIdx];
     }
 }
 
@@ -186,10 +208,50 @@ void Pipeline::Init(
 Pipeline::~Pipeline()
 {
     // Destroy PAL object
-    for (uint32_t deviceIdx = 0; (deviceIdx < m_pDevice->NumPalDevices()) && (m_pPalPipeline[deviceIdx] != nullptr); deviceIdx++)
+    for (uint32_t deviceIdx = 0;
+         (deviceIdx < m_pDevice->NumPalDevices()) && (m_palPipelines.pPalPipeline[deviceIdx] != nullptr);
+         deviceIdx++)
+    {
+        m_palPipelines.pPalPipeline[deviceIdx]->Destroy();
+    }
+}
+
+// =====================================================================================================================
+// Makes this pipeline use the PAL pipelines of pSource, a pipeline built from the same state, or its own again if
+// pSource is null.  Used to replace a quickly built pipeline with an optimized build after it was handed to the
+// application; the caller keeps pSource alive until the replacement is undone.  Returns false, leaving the pipeline
+// unchanged, if state this pipeline derived from its own PAL pipelines at creation doesn't match pSource.
+//
+// Command buffers may be binding the pipeline on other threads.  The set is published with a single release store, so
+// a bind sees either set as a whole.
+bool Pipeline::UsePalPipelinesOf(
+    const Pipeline* pSource)
+{
+    bool used = true;
+
+    if (pSource == nullptr)
+    {
+        m_pPalPipelines.store(&m_palPipelines, std::memory_order_release);
+    }
+    else if (CanUsePalPipelinesOf(pSource))
     {
-        m_pPalPipeline[deviceIdx]->Destroy();
+        m_pPalPipelines.store(&pSource->m_palPipelines, std::memory_order_release);
     }
+    else
+    {
+        used = false;
+    }
+
+    return used;
+}
+
+// =====================================================================================================================
+// Returns true if this pipeline may bind the PAL pipelines of pSource.  Derived pipelines compare the state they
+// derived from their own PAL pipelines.
+bool Pipeline::CanUsePalPipelinesOf(
+    const Pipeline* pSource) const
+{
+    return (m_type == pSource->m_type);
 }
 
 // =====================================================================================================================
@@ -199,9 +261,9 @@ VkResult Pipeline::Destroy(
     const VkAllocationCallbacks* pAllocator)
 {
     // Free binary if it exists
-    if (m_pBinary != nullptr)
+    if (m_palPipelines.pBinary != nullptr)
     {
-        m_pBinary->Destroy(pAllocator);
+        m_palPipelines.pBinary->Destroy(pAllocator);
     }
 
     // Call destructor
@@ -832,7 +894,8 @@ VKAPI_ATTR VkResult VKAPI_CALL vkGetPipelineExecutableStatisticsKHR(
     // Get an api shader type for the corresponding HW Shader
     Pal::ShaderType shaderType = GetApiShaderFromHwShader(hwStage, apiToHwShader);
 
-    // Get the shader stats for the corresponding API stage
+    // Get the shader stats for the corresponding API stage.  PAL reads them from the metadata of the pipeline ELF, so
+    // pipelines loaded from the binary cache report them without being recompiled.
     VkShaderStatisticsInfoAMD  vkShaderStats = {};
     Pal::ShaderStats           palStats      = {};
 
@@ -858,7 +921,13 @@ VKAPI_ATTR VkResult VKAPI_CALL vkGetPipelineExecutableStatisticsKHR(
         {VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR, 0, "ldsUsageSizeInBytes",
          "LDS usage size in Bytes", VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR, false},
         {VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR, 0, "scratchMemUsageInBytes",
-         "Scratch memory usage in Bytes", VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR, false}
+         "Scratch memory usage in Bytes", VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR, false},
+        {VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR, 0, "numAvailableVgprs",
+         "Number of VGPRs available to the stage", VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR, false},
+        {VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR, 0, "numAvailableSgprs",
+         "Number of SGPRs available to the stage", VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR, false},
+        {VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR, 0, "isaSizeInBytes",
+         "ISA size in Bytes", VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR, false}
     };
 
     // Number of used Vgprs
@@ -876,6 +945,15 @@ VKAPI_ATTR VkResult VKAPI_CALL vkGetPipelineExecutableStatisticsKHR(
     // Scratch memory usage in Bytes
     executableStatics[4].value.u64 = vkShaderStats.resourceUsage.scratchMemUsageInBytes;
 
+    // Number of available Vgprs
+    executableStatics[5].value.u64 = vkShaderStats.numAvailableVgprs;
+
+    // Number of available Sgprs
+    executableStatics[6].value.u64 = vkShaderStats.numAvailableSgprs;
+
+    // ISA size in Bytes
+    executableStatics[7].value.u64 = palStats.isaSizeInBytes;
+
     // Overwrite the number of written statistics
     *pStatisticCount = Util::Min(*pStatisticCount, static_cast<uint32_t>(ExecutableStatisticsCount));
 
@@ -76,6 +76,7 @@ VkResult PipelineCache::Create(
     size_t                  pipelineCacheSize[MaxPalDevices];
 
     bool                    usePipelineCacheInitialData   = false;
+    bool                    initialDataValidated          = true;
 
     PipelineCompilerType       cacheType = pDevice->GetCompiler(DefaultDeviceIndex)->GetShaderCacheType();
 
@@ -104,10 +105,19 @@ VkResult PipelineCache::Create(
                     size_t dataSize     = pCreateInfo->initialDataSize - sizeof(PipelineCacheHeaderData);
                     vk::PhysicalDevice* pPhysicalDevice = pDevice->VkPhysicalDevice(DefaultDeviceIndex);
 
-                    if (PipelineBinaryCache::IsValidBlob(pPhysicalDevice->VkInstance()->GetAllocCallbacks(),
-                                                         pPhysicalDevice->GetPlatformKey(),
-                                                         dataSize,
-                                                         pData))
+                    // Hashing a large blob up front stalls cache creation; with lazy validation only its layout is
+                    // checked here and the binary cache verifies the hash in the background.
+                    if (settings.pipelineCacheLazyValidation &&
+                        settings.allowExternalPipelineCacheObject &&
+                        PipelineBinaryCache::IsValidBlobLayout(dataSize, pData))
+                    {
+                        usePipelineCacheInitialData = true;
+                        initialDataValidated        = false;
+                    }
+                    else if (PipelineBinaryCache::IsValidBlob(pPhysicalDevice->VkInstance()->GetAllocCallbacks(),
+                                                              pPhysicalDevice->GetPlatformKey(),
+                                                              dataSize,
+                                                              pData))
                     {
                         usePipelineCacheInitialData = true;
                     }
@@ -215,7 +225,9 @@ VkResult PipelineCache::Create(
 #endif
                     initialDataSize,
                     pInitialData,
-                    false);
+                    initialDataValidated,
+                    false,
+                    pDevice->GetCompileThreadPool());
 
                 // This isn't a terminal failure, the device can continue without the pipeline cache if need be.
                 VK_ALERT(pBinaryCache == nullptr);
@@ -325,7 +337,7 @@ VkResult PipelineCache::Merge(
             binaryCaches[cacheIdx] = ppSrcCaches[cacheIdx]->GetPipelineCache();
         }
 
-        result = m_pBinaryCache->Merge(srcCacheCount, &binaryCaches[0]);
+        result = m_pBinaryCache->Merge(srcCacheCount, &binaryCaches[0], m_pDevice->GetCompileThreadPool());
     }
     else
     {
@@ -66,6 +66,32 @@ uint64_t PipelineLayout::BuildApiHash(
     return hash;
 }
 
+// =====================================================================================================================
+// Flattens the contents of the VkPipelineLayoutCreateInfo struct which BuildApiHash() hashes.  Descriptor set layouts
+// are identified by their objects, which the layout cache shares between identical create infos already.
+void PipelineLayout::BuildSignature(
+    const VkPipelineLayoutCreateInfo* pCreateInfo,
+    LayoutSignature*                  pSignature)
+{
+    pSignature->Append(static_cast<uint32_t>(pCreateInfo->flags));
+    pSignature->Append(pCreateInfo->setLayoutCount);
+
+    for (uint32_t i = 0; i < pCreateInfo->setLayoutCount; i++)
+    {
+        pSignature->Append(static_cast<uint64_t>(
+            reinterpret_cast<uintptr_t>(DescriptorSetLayout::ObjectFromHandle(pCreateInfo->pSetLayouts[i]))));
+    }
+
+    pSignature->Append(pCreateInfo->pushConstantRangeCount);
+
+    for (uint32_t i = 0; i < pCreateInfo->pushConstantRangeCount; i++)
+    {
+        pSignature->Append(static_cast<uint32_t>(pCreateInfo->pPushConstantRanges[i].stageFlags));
+        pSignature->Append(pCreateInfo->pPushConstantRanges[i].offset);
+        pSignature->Append(pCreateInfo->pPushConstantRanges[i].size);
+    }
+}
+
 constexpr size_t PipelineLayout::GetMaxResMappingRootNodeSize()
 {
     return
@@ -97,9 +123,45 @@ PipelineLayout::PipelineLayout(
     m_info(info),
     m_pipelineInfo(pipelineInfo),
     m_pDevice(pDevice),
-    m_apiHash(apiHash)
+    m_apiHash(apiHash),
+    m_pMappingTemplate(nullptr),
+    m_templateUserDataNodeCount(0),
+    m_templateMappingNodeCount(0),
+    m_templateDescRangeCount(0)
+{
+
+}
+
+// =====================================================================================================================
+// Builds the resource mapping template which BuildLlpcPipelineMapping() copies from.  Failing to allocate it is not an
+// error; the mapping is then built from scratch for every pipeline.
+void PipelineLayout::BuildMappingTemplate(
+    Device*                      pDevice,
+    const VkAllocationCallbacks* pAllocator)
 {
+    if (m_pipelineInfo.mappingBufferSize > 0)
+    {
+        void* pTemplate = pDevice->AllocApiObject(pAllocator, m_pipelineInfo.mappingBufferSize);
 
+        if (pTemplate != nullptr)
+        {
+            // Unused fields of some node types must be zero, as in the buffers the pipeline compiler passes in.
+            memset(pTemplate, 0, m_pipelineInfo.mappingBufferSize);
+
+            if (BuildLlpcUserDataMapping(UINT32_MAX,
+                                         pTemplate,
+                                         &m_templateUserDataNodeCount,
+                                         &m_templateMappingNodeCount,
+                                         &m_templateDescRangeCount) == VK_SUCCESS)
+            {
+                m_pMappingTemplate = pTemplate;
+            }
+            else
+            {
+                pDevice->FreeApiObject(pAllocator, pTemplate);
+            }
+        }
+    }
 }
 
 // =====================================================================================================================
@@ -284,17 +346,39 @@ VkResult PipelineLayout::Create(
 
     const size_t objSize = apiSize + setUserDataLayoutSize + descriptorSetLayoutSize + setLayoutsArraySize;
 
-    void* pSysMem = pDevice->AllocApiObject(pAllocator, objSize);
+    // Return the layout created from an identical create info if it's still alive
+    LayoutCache*    pLayoutCache = pDevice->GetLayoutCache();
+    LayoutSignature signature(pDevice->VkInstance());
+    bool            shareable    = pLayoutCache->CanShare(pAllocator);
+    void*           pSysMem      = nullptr;
+
+    if (shareable)
+    {
+        BuildSignature(pCreateInfo, &signature);
+
+        shareable = signature.IsValid();
+    }
+
+    void* pShared = shareable ? pLayoutCache->Acquire(LayoutType::PipelineLayout, apiHash, signature) : nullptr;
 
-    if (pSysMem == nullptr)
+    if (pShared != nullptr)
+    {
+        *pPipelineLayout = PipelineLayout::HandleFromVoidPointer(pShared);
+    }
+    else
     {
-        result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        pSysMem = pDevice->AllocApiObject(pAllocator, objSize);
+
+        if (pSysMem == nullptr)
+        {
+            result = VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
     }
 
     SetUserDataLayout*    pSetUserData = nullptr;
     DescriptorSetLayout** ppSetLayouts = nullptr;
 
-    if (result == VK_SUCCESS)
+    if ((result == VK_SUCCESS) && (pSysMem != nullptr))
     {
         pSetUserData = static_cast<SetUserDataLayout*>(Util::VoidPtrInc(pSysMem, apiSize));
         ppSetLayouts = static_cast<DescriptorSetLayout**>(
@@ -308,7 +392,7 @@ VkResult PipelineLayout::Create(
             pSetUserData);
     }
 
-    if (result == VK_SUCCESS)
+    if ((result == VK_SUCCESS) && (pSysMem != nullptr))
     {
         size_t currentSetLayoutOffset = apiSize + setUserDataLayoutSize + descriptorSetLayoutSize;
 
@@ -324,9 +408,27 @@ VkResult PipelineLayout::Create(
             currentSetLayoutOffset += pLayout->GetObjectSize();
         }
 
-        VK_PLACEMENT_NEW(pSysMem) PipelineLayout(pDevice, info, pipelineInfo, apiHash);
+        PipelineLayout* pPipelineLayoutObj = VK_PLACEMENT_NEW(pSysMem) PipelineLayout(pDevice,
+                                                                                      info,
+                                                                                      pipelineInfo,
+                                                                                      apiHash);
+
+        pPipelineLayoutObj->BuildMappingTemplate(pDevice, pAllocator);
+
+        void* pObject = pSysMem;
+
+        if (shareable)
+        {
+            pObject = pLayoutCache->Insert(LayoutType::PipelineLayout, apiHash, signature, pSysMem);
+
+            // Another thread created the same layout in the meantime
+            if (pObject != pSysMem)
+            {
+                pPipelineLayoutObj->Destroy(pDevice, pAllocator);
+            }
+        }
 
-        *pPipelineLayout = PipelineLayout::HandleFromVoidPointer(pSysMem);
+        *pPipelineLayout = PipelineLayout::HandleFromVoidPointer(pObject);
     }
 
     if (result != VK_SUCCESS)
@@ -521,13 +623,14 @@ int32_t PipelineLayout::BuildLlpcVertexInputDescriptors(
 }
 
 // =====================================================================================================================
-// This function populates the resource mapping node details to the shader-stage specific pipeline info structure.
-VkResult PipelineLayout::BuildLlpcPipelineMapping(
+// Builds the resource mapping nodes for transform feedback, push constants and all descriptor sets into pBuffer, which
+// is laid out as described by PipelineInfo.
+VkResult PipelineLayout::BuildLlpcUserDataMapping(
     uint32_t                                    stageMask,
     void*                                       pBuffer,
-    Vkgc::ResourceMappingData*                  pResourceMapping,
-    const VkPipelineVertexInputStateCreateInfo* pVertexInput,
-    VbBindingInfo*                              pVbInfo
+    uint32_t*                                   pUserDataNodeCount,
+    uint32_t*                                   pMappingNodeCount,
+    uint32_t*                                   pDescriptorRangeCount
     ) const
 {
     VkResult result = VK_SUCCESS;
@@ -632,6 +735,119 @@ VkResult PipelineLayout::BuildLlpcPipelineMapping(
         }
     }
 
+    *pUserDataNodeCount    = userDataNodeCount;
+    *pMappingNodeCount     = mappingNodeCount;
+    *pDescriptorRangeCount = descriptorRangeCount;
+
+    return result;
+}
+
+// =====================================================================================================================
+// Copies the mapping template into pBuffer and specializes it for the given stages.  Gives the same result as
+// BuildLlpcUserDataMapping(stageMask, ...) since the template was built with every stage visible.
+void PipelineLayout::CopyMappingTemplate(
+    uint32_t                                    stageMask,
+    void*                                       pBuffer
+    ) const
+{
+    const size_t userDataNodesOffset  = 0;
+    const size_t resourceNodesOffset  = m_pipelineInfo.numUserDataNodes * sizeof(Vkgc::ResourceMappingRootNode);
+    const size_t descRangeValueOffset = resourceNodesOffset +
+                                        (m_pipelineInfo.numRsrcMapNodes * sizeof(Vkgc::ResourceMappingNode));
+
+    memcpy(Util::VoidPtrInc(pBuffer, userDataNodesOffset),
+           Util::VoidPtrInc(m_pMappingTemplate, userDataNodesOffset),
+           m_templateUserDataNodeCount * sizeof(Vkgc::ResourceMappingRootNode));
+    memcpy(Util::VoidPtrInc(pBuffer, resourceNodesOffset),
+           Util::VoidPtrInc(m_pMappingTemplate, resourceNodesOffset),
+           m_templateMappingNodeCount * sizeof(Vkgc::ResourceMappingNode));
+    memcpy(Util::VoidPtrInc(pBuffer, descRangeValueOffset),
+           Util::VoidPtrInc(m_pMappingTemplate, descRangeValueOffset),
+           m_templateDescRangeCount * sizeof(Vkgc::StaticDescriptorValue));
+
+    Vkgc::ResourceMappingRootNode* pUserDataNodes = static_cast<Vkgc::ResourceMappingRootNode*>(pBuffer);
+
+    for (uint32_t i = 0; i < m_templateUserDataNodeCount; ++i)
+    {
+        Vkgc::ResourceMappingRootNode* pNode = &pUserDataNodes[i];
+
+        if (pNode->node.type == Vkgc::ResourceMappingNodeType::DescriptorTableVaPtr)
+        {
+            // Point the set tables at this buffer's copy of their nodes
+            const size_t tableOffset = Util::VoidPtrDiff(pNode->node.tablePtr.pNext, m_pMappingTemplate);
+
+            pNode->node.tablePtr.pNext = static_cast<const Vkgc::ResourceMappingNode*>(
+                Util::VoidPtrInc(pBuffer, tableOffset));
+        }
+
+        if (pNode->node.type == Vkgc::ResourceMappingNodeType::StreamOutTableVaPtr)
+        {
+            // Transform feedback is only visible to the last pre-rasterization stage
+            uint32_t xfbStages       = (stageMask & (Vkgc::ShaderStageFragmentBit - 1)) >> 1;
+            uint32_t lastXfbStageBit = Vkgc::ShaderStageVertexBit;
+
+            while (xfbStages > 0)
+            {
+                lastXfbStageBit <<= 1;
+                xfbStages >>= 1;
+            }
+
+            pNode->visibility = lastXfbStageBit;
+        }
+        else
+        {
+            pNode->visibility &= stageMask;
+        }
+    }
+
+    Vkgc::StaticDescriptorValue* pDescriptorRangeValues =
+        static_cast<Vkgc::StaticDescriptorValue*>(Util::VoidPtrInc(pBuffer, descRangeValueOffset));
+
+    for (uint32_t i = 0; i < m_templateDescRangeCount; ++i)
+    {
+        pDescriptorRangeValues[i].visibility &= stageMask;
+    }
+}
+
+// =====================================================================================================================
+// This function populates the resource mapping node details to the shader-stage specific pipeline info structure.
+VkResult PipelineLayout::BuildLlpcPipelineMapping(
+    uint32_t                                    stageMask,
+    void*                                       pBuffer,
+    Vkgc::ResourceMappingData*                  pResourceMapping,
+    const VkPipelineVertexInputStateCreateInfo* pVertexInput,
+    VbBindingInfo*                              pVbInfo
+    ) const
+{
+    VkResult result = VK_SUCCESS;
+
+    Vkgc::ResourceMappingRootNode* pUserDataNodes = static_cast<Vkgc::ResourceMappingRootNode*>(pBuffer);
+    Vkgc::ResourceMappingNode* pResourceNodes =
+        reinterpret_cast<Vkgc::ResourceMappingNode*>(pUserDataNodes + m_pipelineInfo.numUserDataNodes);
+    Vkgc::StaticDescriptorValue* pDescriptorRangeValues =
+        reinterpret_cast<Vkgc::StaticDescriptorValue*>(pResourceNodes + m_pipelineInfo.numRsrcMapNodes);
+
+    uint32_t userDataNodeCount    = 0; // Number of consumed ResourceMappingRootNodes
+    uint32_t mappingNodeCount     = 0; // Number of consumed ResourceMappingNodes (only sub-nodes)
+    uint32_t descriptorRangeCount = 0; // Number of consumed StaticResourceValues
+
+    if (m_pMappingTemplate != nullptr)
+    {
+        CopyMappingTemplate(stageMask, pBuffer);
+
+        userDataNodeCount    = m_templateUserDataNodeCount;
+        mappingNodeCount     = m_templateMappingNodeCount;
+        descriptorRangeCount = m_templateDescRangeCount;
+    }
+    else
+    {
+        result = BuildLlpcUserDataMapping(stageMask,
+                                          pBuffer,
+                                          &userDataNodeCount,
+                                          &mappingNodeCount,
+                                          &descriptorRangeCount);
+    }
+
     if ((result == VK_SUCCESS) && (pVertexInput != nullptr))
     {
         // Build the internal vertex buffer table mapping
@@ -677,19 +893,27 @@ VkResult PipelineLayout::BuildLlpcPipelineMapping(
 }
 
 // =====================================================================================================================
-// Destroy pipeline layout object
+// Destroy pipeline layout object.  A layout shared by several creates is only destroyed with the last handle.
 VkResult PipelineLayout::Destroy(
     Device*                         pDevice,
     const VkAllocationCallbacks*    pAllocator)
 {
-    for (uint32_t i = 0; i < m_info.setCount; ++i)
+    if (pDevice->GetLayoutCache()->Release(LayoutType::PipelineLayout, m_apiHash, this))
     {
-        GetSetLayouts(i)->Destroy(pDevice, pAllocator, false);
-    }
+        for (uint32_t i = 0; i < m_info.setCount; ++i)
+        {
+            GetSetLayouts(i)->Destroy(pDevice, pAllocator, false);
+        }
 
-    this->~PipelineLayout();
+        if (m_pMappingTemplate != nullptr)
+        {
+            pDevice->FreeApiObject(pAllocator, m_pMappingTemplate);
+        }
+
+        this->~PipelineLayout();
 
-    pDevice->FreeApiObject(pAllocator, this);
+        pDevice->FreeApiObject(pAllocator, this);
+    }
 
     return VK_SUCCESS;
 }
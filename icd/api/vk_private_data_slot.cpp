@@ -32,6 +32,8 @@
 #include "include/vk_private_data_slot.h"
 #include "include/vk_device.h"
 
+#include <string.h>
+
 namespace vk
 {
 // =====================================================================================================================
@@ -122,29 +124,7 @@ uint64* PrivateDataSlotEXT::GetPrivateDataItemAddr(
     }
     else
     {
-        if (isSet)
-        {
-            Util::RWLockAuto<Util::RWLock::LockType::ReadWrite> lock(pDevice->GetPrivateDataRWLock());
-
-            HashedPrivateDataMap* pHashed = GetUnreservedPrivateDataAddr<isSet>(pDevice, pPrivateDataStorage);
-
-            if (pHashed != nullptr)
-            {
-                bool existed = false;
-                pHashed->FindAllocate(m_index, &existed, &pItem);
-            }
-        }
-        else
-        {
-            Util::RWLockAuto<Util::RWLock::LockType::ReadOnly> lock(pDevice->GetPrivateDataRWLock());
-
-            HashedPrivateDataMap* pHashed = GetUnreservedPrivateDataAddr<isSet>(pDevice, pPrivateDataStorage);
-
-            if (pHashed != nullptr)
-            {
-                pItem = pHashed->FindKey(m_index);
-            }
-        }
+        pItem = GetUnreservedPrivateDataAddr<isSet>(pDevice, pPrivateDataStorage);
     }
 
     return pItem;
@@ -192,30 +172,75 @@ void PrivateDataSlotEXT::GetPrivateDataEXT(
 }
 
 // =====================================================================================================================
-// Caller should take a RWLock
+// Returns the chunk starting at the given slot index from the chunks between pFirst and pEnd (exclusive).
+static PrivateDataChunk* FindPrivateDataChunk(
+        PrivateDataChunk*               pFirst,
+        const PrivateDataChunk*         pEnd,
+        const uint64                    firstIndex)
+{
+    PrivateDataChunk* pChunk = pFirst;
+
+    while ((pChunk != pEnd) && (pChunk->firstIndex != firstIndex))
+    {
+        pChunk = pChunk->pNext;
+    }
+
+    return (pChunk != pEnd) ? pChunk : nullptr;
+}
+
+// =====================================================================================================================
+// Returns the address of this slot's value in the object's chunk list, adding the chunk if setting.  Lookups take no
+// lock: chunks are published with a compare-exchange on the list head, and a thread which loses the race to add the
+// same chunk uses the winner's instead.
 template <bool isSet>
-HashedPrivateDataMap* PrivateDataSlotEXT::GetUnreservedPrivateDataAddr(
+uint64* PrivateDataSlotEXT::GetUnreservedPrivateDataAddr(
         Device*                         pDevice,
         PrivateDataStorage* const       pPrivateDataStorage)
 {
-    HashedPrivateDataMap* pHashed = pPrivateDataStorage->pUnreserved;
+    const uint64 firstIndex = m_index - (m_index % PrivateDataChunkSize);
+
+    PrivateDataChunk* pHead  = pPrivateDataStorage->pUnreserved.load(std::memory_order_acquire);
+    PrivateDataChunk* pChunk = FindPrivateDataChunk(pHead, nullptr, firstIndex);
 
-    if ((pHashed == nullptr) && isSet)
+    if ((pChunk == nullptr) && isSet)
     {
-        void* pMemory = pDevice->VkInstance()->AllocMem(
-                                            sizeof(HashedPrivateDataMap),
+        PrivateDataChunk* pNewChunk = static_cast<PrivateDataChunk*>(pDevice->VkInstance()->AllocMem(
+                                            sizeof(PrivateDataChunk),
                                             VK_DEFAULT_MEM_ALIGN,
-                                            VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+                                            VK_SYSTEM_ALLOCATION_SCOPE_OBJECT));
 
-        if (pMemory != nullptr)
+        if (pNewChunk != nullptr)
         {
-            pHashed = VK_PLACEMENT_NEW(pMemory) HashedPrivateDataMap(32u, pDevice->VkInstance()->Allocator());
-            pHashed->Init();
-            pPrivateDataStorage->pUnreserved = pHashed;
+            memset(pNewChunk, 0, sizeof(PrivateDataChunk));
+
+            pNewChunk->firstIndex = firstIndex;
+            pNewChunk->pNext      = pHead;
+
+            // After a failed exchange pNext holds the new head; only chunks added since the last search can match.
+            PrivateDataChunk* pSearchedHead = pHead;
+
+            while ((pChunk == nullptr) &&
+                   (pPrivateDataStorage->pUnreserved.compare_exchange_weak(pNewChunk->pNext,
+                                                                           pNewChunk,
+                                                                           std::memory_order_release,
+                                                                           std::memory_order_acquire) == false))
+            {
+                pChunk        = FindPrivateDataChunk(pNewChunk->pNext, pSearchedHead, firstIndex);
+                pSearchedHead = pNewChunk->pNext;
+            }
+
+            if (pChunk != nullptr)
+            {
+                pDevice->VkInstance()->FreeMem(pNewChunk);
+            }
+            else
+            {
+                pChunk = pNewChunk;
+            }
         }
     }
 
-    return pHashed;
+    return (pChunk != nullptr) ? &pChunk->values[m_index - firstIndex] : nullptr;
 }
 
 namespace entry
@@ -37,6 +37,7 @@
 
 #include "palAutoBuffer.h"
 #include "palQueryPool.h"
+#include "palSysUtil.h"
 
 namespace vk
 {
@@ -576,6 +577,11 @@ VkResult TimestampQueryPool::GetResults(
         queryCount = Util::Min(queryCount,
                 static_cast<uint32_t>(dataSize / Util::Max(querySlotSize, static_cast<size_t>(stride))));
 
+        if ((flags & VK_QUERY_RESULT_WAIT_BIT) != 0)
+        {
+            WaitForTimestamps(pSrcData, startQuery, queryCount);
+        }
+
         // Write results of each query slot
         for (uint32_t dstSlot = 0; dstSlot < queryCount; ++dstSlot)
         {
@@ -586,18 +592,8 @@ VkResult TimestampQueryPool::GetResults(
                 reinterpret_cast<const uint64_t*>(Util::VoidPtrInc(pSrcData, srcSlotOffset));
 
             // Test if the timestamp query is available
-            uint64_t value = *pTimestamp;
-            bool ready     = (value != TimestampNotReady);
-
-            // Wait until the timestamp query has become available
-            if ((flags & VK_QUERY_RESULT_WAIT_BIT) != 0)
-            {
-                while (!ready)
-                {
-                    value = *pTimestamp;
-                    ready = (value != TimestampNotReady);
-                }
-            }
+            const uint64_t value = *pTimestamp;
+            const bool     ready = (value != TimestampNotReady);
 
             // Get a pointer to the start of this slot's data
             void* pSlotData = Util::VoidPtrInc(pData, static_cast<size_t>(dstSlot * stride));
@@ -649,6 +645,34 @@ VkResult TimestampQueryPool::GetResults(
     return result;
 }
 
+// =====================================================================================================================
+// Waits until the GPU has written all of the given timestamp slots.  The wait can last as long as the GPU work queued
+// ahead of the timestamps, so after a short spin each poll of a pending slot yields the thread instead of burning a
+// core.  Slots are checked in order and a written slot never becomes pending again, so each is waited for only once.
+void TimestampQueryPool::WaitForTimestamps(
+    const void* pSrcData,
+    uint32_t    startQuery,
+    uint32_t    queryCount) const
+{
+    uint32_t pollCount = 0;
+    uint32_t slot      = 0;
+
+    while (slot < queryCount)
+    {
+        volatile const uint64_t* pTimestamp =
+            reinterpret_cast<const uint64_t*>(Util::VoidPtrInc(pSrcData, (startQuery + slot) * GetSlotSize()));
+
+        if (*pTimestamp != TimestampNotReady)
+        {
+            ++slot;
+        }
+        else if (++pollCount > TimestampSpinPollCount)
+        {
+            Util::YieldThread();
+        }
+    }
+}
+
 // =====================================================================================================================
 // Reset timestamp query pool from CPU
 void TimestampQueryPool::Reset(
@@ -660,20 +684,16 @@ void TimestampQueryPool::Reset(
     {
         queryCount = Util::Min(queryCount, m_entryCount - startQuery);
 
-        // Query pool size needs to be reset in qwords.
-        const uint32_t queryDataSize = (m_slotSize * queryCount) / sizeof(uint64_t);
+        // Every byte of TimestampNotReady is the same, so the whole range is reset with a single memset.
+        static_assert(TimestampNotReady == UINT64_MAX, "The reset below relies on an all-ones TimestampNotReady");
+
+        const size_t queryDataSize = static_cast<size_t>(m_slotSize) * queryCount;
         for (uint32_t deviceIdx = 0; deviceIdx < pDevice->NumPalDevices(); deviceIdx++)
         {
             void* pMappedAddr = nullptr;
             if (m_internalMem.Map(deviceIdx, &pMappedAddr) == Pal::Result::Success)
             {
-                uint64_t* pQueryData = static_cast<uint64_t*>(Util::VoidPtrInc(pMappedAddr,
-                                                                               (m_slotSize * startQuery)));
-
-                for (uint32_t idx = 0; idx < queryDataSize; idx++)
-                {
-                    pQueryData[idx] = TimestampNotReady;
-                }
+                memset(Util::VoidPtrInc(pMappedAddr, (m_slotSize * startQuery)), 0xFF, queryDataSize);
 
                 if (pMappedAddr != nullptr)
                 {
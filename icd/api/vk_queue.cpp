@@ -41,6 +41,9 @@
 #include "include/vk_semaphore.h"
 #include "include/vk_swapchain.h"
 #include "include/vk_utils.h"
+#include "include/queue_submit_stats.h"
+#include "include/queue_timing_log.h"
+#include "include/queue_submit_thread.h"
 
 #if ICD_GPUOPEN_DEVMODE_BUILD
 #include "devmode/devmode_mgr.h"
@@ -48,8 +51,13 @@
 
 #include "sqtt/sqtt_layer.h"
 
+#include "utils/json_writer.h"
+
 #include "palDequeImpl.h"
 #include "palQueue.h"
+#include "palSysUtil.h"
+
+#include <algorithm>
 
 namespace vk
 {
@@ -71,7 +79,10 @@ Queue::Queue(
     m_queueIndex(queueIndex),
     m_queueFlags(queueFlags),
     m_pDevModeMgr(pDevice->VkInstance()->GetDevModeMgr()),
-    m_pStackAllocator(pStackAllocator)
+    m_pStackAllocator(pStackAllocator),
+    m_pSubmitThread(nullptr),
+    m_pSubmitStats(nullptr),
+    m_pTimingState(nullptr)
 {
     if (pPalQueues != nullptr)
     {
@@ -97,8 +108,9 @@ Queue::Queue(
 
     for (uint32_t deviceIdx = 0; deviceIdx < MaxPalDevices; deviceIdx++)
     {
-        m_pDummyCmdBuffer[deviceIdx] = nullptr;
-        m_pCmdBufRing[deviceIdx]     = nullptr;
+        m_pDummyCmdBuffer[deviceIdx]    = nullptr;
+        m_pCmdBufRing[deviceIdx]        = nullptr;
+        m_pUnusedCmdBufState[deviceIdx] = nullptr;
     }
 
     const Pal::DeviceProperties& deviceProps = m_pDevice->VkPhysicalDevice(DefaultDeviceIndex)->PalProperties();
@@ -109,6 +121,23 @@ Queue::Queue(
 // =====================================================================================================================
 Queue::~Queue()
 {
+    if (m_pSubmitThread != nullptr)
+    {
+        m_pSubmitThread->Destroy();
+    }
+
+    if (m_pSubmitStats != nullptr)
+    {
+        WriteSubmitStats(m_pDevice->GetRuntimeSettings().queueSubmitStatsFile);
+
+        m_pSubmitStats->Destroy();
+    }
+
+    if (m_pTimingState != nullptr)
+    {
+        m_pTimingState->Destroy();
+    }
+
     for (uint32_t deviceIdx = 0; deviceIdx < m_pDevice->NumPalDevices(); ++deviceIdx)
     {
         if (m_pDummyCmdBuffer[deviceIdx] != nullptr)
@@ -294,12 +323,156 @@ VkResult Queue::NotifyFlipMetadataAfterPresent(
 }
 
 // =====================================================================================================================
-// Submit an array of command buffers to a queue
+// Starts a thread which takes the PAL work of later submits off the calling thread.  The queue stays synchronous if the
+// thread can't be started.
+void Queue::StartSubmitThread()
+{
+    VK_ASSERT(m_pSubmitThread == nullptr);
+
+    m_pSubmitThread = QueueSubmitThread::Create(m_pDevice->VkInstance(), this);
+}
+
+// =====================================================================================================================
+// Starts collecting submission latency and GPU idle gap stats.  The queue runs without them if they can't be allocated.
+void Queue::EnableSubmitStats()
+{
+    VK_ASSERT(m_pSubmitStats == nullptr);
+
+    m_pSubmitStats = QueueSubmitStats::Create(m_pDevice, this);
+}
+
+// =====================================================================================================================
+// Starts recording this queue's operations into the device's queue timing log.  The queue runs without it if the state
+// can't be allocated.
+void Queue::EnableTimingLog()
+{
+    VK_ASSERT(m_pTimingState == nullptr);
+
+    m_pTimingState = QueueTimingState::Create(m_pDevice, this);
+}
+
+// =====================================================================================================================
+// Appends a JSON snapshot of the queue's submission stats to a file.
+void Queue::WriteSubmitStats(
+    const char* pFilePath)
+{
+    if (m_pSubmitStats != nullptr)
+    {
+        utils::JsonOutputStream stream(pFilePath);
+        Util::JsonWriter        writer(&stream);
+
+        writer.BeginMap(false);
+        writer.KeyAndValue("timestampMs",
+                           static_cast<uint64_t>((Util::GetPerfCpuTime() * 1000) / Util::GetPerfFrequency()));
+        writer.KeyAndBeginMap("queue", false);
+        m_pSubmitStats->Write(&writer);
+        writer.EndMap();
+        writer.EndMap();
+    }
+}
+
+// =====================================================================================================================
+// Waits until the submit thread has handed everything queued so far to PAL, as well as the deferred submissions of
+// other queues which signal the given semaphores.  Needed before any PAL work on the queue outside of PalSubmit().
+VkResult Queue::WaitForDeferredWork(
+    uint32_t           waitSemaphoreCount,
+    const VkSemaphore* pWaitSemaphores)
+{
+    VkResult result = VK_SUCCESS;
+
+    if (m_pSubmitThread != nullptr)
+    {
+        result = m_pSubmitThread->WaitIdle();
+    }
+
+    for (uint32_t i = 0; (i < waitSemaphoreCount) && (result == VK_SUCCESS); ++i)
+    {
+        if (pWaitSemaphores[i] != VK_NULL_HANDLE)
+        {
+            result = Semaphore::ObjectFromHandle(pWaitSemaphores[i])->WaitForPendingSignal();
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Returns true if nextInfo can share a PAL submission with prevInfo.  That is the case when no semaphore operation sits
+// between the command buffers of the two (prevInfo signals nothing and nextInfo waits on nothing), both use the same
+// protection mode and neither needs per-device command buffer masks.
+static bool CanMergeSubmits(
+    const VkSubmitInfo& prevInfo,
+    const VkSubmitInfo& nextInfo)
+{
+    const VkProtectedSubmitInfo* pPrevProtected =
+        GetExtensionStructure<VkProtectedSubmitInfo>(&prevInfo, VK_STRUCTURE_TYPE_PROTECTED_SUBMIT_INFO);
+    const VkProtectedSubmitInfo* pNextProtected =
+        GetExtensionStructure<VkProtectedSubmitInfo>(&nextInfo, VK_STRUCTURE_TYPE_PROTECTED_SUBMIT_INFO);
+
+    const bool prevProtected = (pPrevProtected != nullptr) && (pPrevProtected->protectedSubmit == VK_TRUE);
+    const bool nextProtected = (pNextProtected != nullptr) && (pNextProtected->protectedSubmit == VK_TRUE);
+
+    return (prevInfo.signalSemaphoreCount == 0) &&
+           (nextInfo.waitSemaphoreCount   == 0) &&
+           (prevProtected == nextProtected)     &&
+           (GetExtensionStructure(reinterpret_cast<const VkStructHeader*>(&prevInfo),
+                                  VK_STRUCTURE_TYPE_DEVICE_GROUP_SUBMIT_INFO) == nullptr) &&
+           (GetExtensionStructure(reinterpret_cast<const VkStructHeader*>(&nextInfo),
+                                  VK_STRUCTURE_TYPE_DEVICE_GROUP_SUBMIT_INFO) == nullptr);
+}
+
+// =====================================================================================================================
+static bool CanMergeSubmits(
+    const VkSubmitInfo2KHR& prevInfo,
+    const VkSubmitInfo2KHR& nextInfo)
+{
+    return (prevInfo.signalSemaphoreInfoCount == 0) &&
+           (nextInfo.waitSemaphoreInfoCount   == 0) &&
+           ((prevInfo.flags & VK_SUBMIT_PROTECTED_BIT_KHR) == (nextInfo.flags & VK_SUBMIT_PROTECTED_BIT_KHR));
+}
+
+// =====================================================================================================================
+// Submit an array of command buffers to a queue.  With a submit thread the submission is only queued here.
 template<typename SubmitInfoType>
 VkResult Queue::Submit(
     uint32_t              submitCount,
     const SubmitInfoType* pSubmits,
     VkFence               fence)
+{
+    PerfCounterRegistry* pPerfCounters = m_pDevice->GetPerfCounters();
+
+    const bool    timed      = (m_pSubmitStats != nullptr) || pPerfCounters->IsEnabled();
+    const int64_t startTicks = timed ? Util::GetPerfCpuTime() : 0;
+
+    const VkResult result = (m_pSubmitThread != nullptr) ? m_pSubmitThread->Submit(submitCount, pSubmits, fence) :
+                                                           PalSubmit(submitCount, pSubmits, fence);
+
+    if (timed)
+    {
+        const int64_t endTicks = Util::GetPerfCpuTime();
+
+        if (m_pSubmitStats != nullptr)
+        {
+            m_pSubmitStats->RecordSubmit(startTicks, endTicks);
+        }
+
+        pPerfCounters->Sample(PerfHistogram::SubmitCpuTimeUs,
+                              (static_cast<uint64_t>(endTicks - startTicks) * 1000000) / Util::GetPerfFrequency());
+    }
+
+    m_pDevice->GetResidencyTracker()->OnSubmit();
+
+    return result;
+}
+
+// =====================================================================================================================
+// Submits an array of command buffers to the PAL queue, including the semaphore waits and signals.  Consecutive submit
+// infos without a semaphore operation between them are combined into a single PAL submission.
+template<typename SubmitInfoType>
+VkResult Queue::PalSubmit(
+    uint32_t              submitCount,
+    const SubmitInfoType* pSubmits,
+    VkFence               fence)
 {
 #if ICD_GPUOPEN_DEVMODE_BUILD
     DevModeMgr* pDevModeMgr = m_pDevice->VkInstance()->GetDevModeMgr();
@@ -312,13 +485,23 @@ VkResult Queue::Submit(
 
     VirtualStackFrame virtStackFrame(m_pStackAllocator);
 
-    VkResult result = VK_SUCCESS;
+    // Memory allocated since the last submission has to be on the residency list before this one reaches the GPU.
+    VkResult result = PalToVkResult(m_pDevice->FlushMemReferences());
+
+    // Likewise, transient attachments have to be mapped to the memory planned for them.  Render passes only run on
+    // universal queues.
+    if ((result == VK_SUCCESS) &&
+        m_pDevice->GetTransientAliasPlanner()->IsEnabled() &&
+        (m_pDevice->GetQueueFamilyPalQueueType(m_queueFamilyIndex) == Pal::QueueTypeUniversal))
+    {
+        result = m_pDevice->GetTransientAliasPlanner()->Commit(PalQueue(DefaultDeviceIndex));
+    }
 
     const bool isSynchronization2 = std::is_same<SubmitInfoType, VkSubmitInfo2KHR>::value;
 
     // The fence should be only used in the last submission to PAL. The implicit ordering guarantees provided by PAL
     // make sure that the fence is only signaled when all submissions complete.
-    if ((submitCount == 0) && (pFence != nullptr))
+    if ((result == VK_SUCCESS) && (submitCount == 0) && (pFence != nullptr))
     {
         Pal::IFence* pPalFence = nullptr;
 
@@ -345,8 +528,21 @@ VkResult Queue::Submit(
     }
     else
     {
-        for (uint32_t submitIdx = 0; (submitIdx < submitCount) && (result == VK_SUCCESS); ++submitIdx)
+        uint32_t batchEnd = 0;
+
+        for (uint32_t submitIdx = 0; (submitIdx < submitCount) && (result == VK_SUCCESS); submitIdx = batchEnd + 1)
         {
+            // The batch [submitIdx, batchEnd] goes to PAL as one submission.  Its waits come from the first submit
+            // info and its signals from the last one.  Timed submissions stay separate so that each one is reported.
+            batchEnd = submitIdx;
+
+            while ((timedQueueEvents == false) &&
+                   ((batchEnd + 1) < submitCount) &&
+                   CanMergeSubmits(pSubmits[batchEnd], pSubmits[batchEnd + 1]))
+            {
+                ++batchEnd;
+            }
+
             const SubmitInfoType& submitInfo = pSubmits[submitIdx];
             const VkDeviceGroupSubmitInfo* pDeviceGroupInfo = nullptr;
             const VkProtectedSubmitInfo* pProtectedSubmitInfo = nullptr;
@@ -398,10 +594,23 @@ VkResult Queue::Submit(
                 pNext = pHeader->pNext;
             }
 
+            if ((isSynchronization2 == false) && (batchEnd != submitIdx))
+            {
+                const VkTimelineSemaphoreSubmitInfo* pLastTimelineInfo =
+                    GetExtensionStructure<VkTimelineSemaphoreSubmitInfo>(
+                        &pSubmits[batchEnd], VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO);
+
+                signalValueCount       = (pLastTimelineInfo != nullptr) ?
+                                         pLastTimelineInfo->signalSemaphoreValueCount : 0;
+                pSignalSemaphoreValues = (pLastTimelineInfo != nullptr) ?
+                                         pLastTimelineInfo->pSignalSemaphoreValues : nullptr;
+            }
+
             // Allocate space to store the PAL command buffer handles
             VkCommandBuffer* pCmdBuffers = nullptr;
             uint32_t cmdBufferCount      = 0;
             uint32_t waitSemaphoreCount  = 0;
+            bool     ownsCmdBuffers      = false;
 
             if (isSynchronization2)
             {
@@ -439,15 +648,34 @@ VkResult Queue::Submit(
                     virtStackFrame.FreeArray(pWaitSemaphoreDeviceIndices);
                 }
 
-                pCmdBuffers = pSubmitInfoKhr->commandBufferInfoCount > 0 ?
-                    virtStackFrame.AllocArray<VkCommandBuffer>(pSubmitInfoKhr->commandBufferInfoCount) : nullptr;
+                const VkSubmitInfo2KHR* pBatchInfos = reinterpret_cast<const VkSubmitInfo2KHR*>(pSubmits);
 
-                for (uint32_t i = 0; i < pSubmitInfoKhr->commandBufferInfoCount; i++)
+                for (uint32_t batchIdx = submitIdx; batchIdx <= batchEnd; ++batchIdx)
                 {
-                    pCmdBuffers[i] = pSubmitInfoKhr->pCommandBufferInfos[i].commandBuffer;
+                    cmdBufferCount += pBatchInfos[batchIdx].commandBufferInfoCount;
                 }
 
-                cmdBufferCount     = pSubmitInfoKhr->commandBufferInfoCount;
+                pCmdBuffers = (cmdBufferCount > 0) ?
+                              virtStackFrame.AllocArray<VkCommandBuffer>(cmdBufferCount) : nullptr;
+
+                if ((pCmdBuffers == nullptr) && (cmdBufferCount > 0))
+                {
+                    result = VK_ERROR_OUT_OF_HOST_MEMORY;
+                }
+                else
+                {
+                    uint32_t cmdBufferIdx = 0;
+
+                    for (uint32_t batchIdx = submitIdx; batchIdx <= batchEnd; ++batchIdx)
+                    {
+                        for (uint32_t i = 0; i < pBatchInfos[batchIdx].commandBufferInfoCount; i++)
+                        {
+                            pCmdBuffers[cmdBufferIdx++] = pBatchInfos[batchIdx].pCommandBufferInfos[i].commandBuffer;
+                        }
+                    }
+                }
+
+                ownsCmdBuffers     = (pCmdBuffers != nullptr);
                 waitSemaphoreCount = pSubmitInfoKhr->waitSemaphoreInfoCount;
             }
             else
@@ -467,20 +695,78 @@ VkResult Queue::Submit(
                         (pDeviceGroupInfo != nullptr ? pDeviceGroupInfo->pWaitSemaphoreDeviceIndices : nullptr));
                 }
 
-                pCmdBuffers        = const_cast<VkCommandBuffer*>(pSubmitInfoOld->pCommandBuffers);
-                cmdBufferCount     = pSubmitInfoOld->commandBufferCount;
+                if (batchEnd == submitIdx)
+                {
+                    pCmdBuffers    = const_cast<VkCommandBuffer*>(pSubmitInfoOld->pCommandBuffers);
+                    cmdBufferCount = pSubmitInfoOld->commandBufferCount;
+                }
+                else
+                {
+                    const VkSubmitInfo* pBatchInfos = reinterpret_cast<const VkSubmitInfo*>(pSubmits);
+
+                    for (uint32_t batchIdx = submitIdx; batchIdx <= batchEnd; ++batchIdx)
+                    {
+                        cmdBufferCount += pBatchInfos[batchIdx].commandBufferCount;
+                    }
+
+                    pCmdBuffers = (cmdBufferCount > 0) ?
+                                  virtStackFrame.AllocArray<VkCommandBuffer>(cmdBufferCount) : nullptr;
+
+                    if ((pCmdBuffers == nullptr) && (cmdBufferCount > 0))
+                    {
+                        result = VK_ERROR_OUT_OF_HOST_MEMORY;
+                    }
+                    else
+                    {
+                        uint32_t cmdBufferIdx = 0;
+
+                        for (uint32_t batchIdx = submitIdx; batchIdx <= batchEnd; ++batchIdx)
+                        {
+                            for (uint32_t i = 0; i < pBatchInfos[batchIdx].commandBufferCount; i++)
+                            {
+                                pCmdBuffers[cmdBufferIdx++] = pBatchInfos[batchIdx].pCommandBuffers[i];
+                            }
+                        }
+                    }
+
+                    ownsCmdBuffers = (pCmdBuffers != nullptr);
+                }
+
                 waitSemaphoreCount = pSubmitInfoOld->waitSemaphoreCount;
             }
 
+            // The layouts of tracked images are committed as their command buffers are submitted.  A command buffer
+            // recorded for other layouts than its images are in is preceded by an internal command buffer which
+            // transitions them, and whose fence is signaled by the same submission.
+            ImageLayoutTracker* const pLayoutTracker = m_pDevice->GetImageLayoutTracker();
+
+            const bool trackLayouts = pLayoutTracker->IsEnabled() && (cmdBufferCount > 0);
+
             Pal::ICmdBuffer** pPalCmdBuffers = (cmdBufferCount > 0) ?
-                                                virtStackFrame.AllocArray<Pal::ICmdBuffer*>(cmdBufferCount) :
-                                                nullptr;
+                virtStackFrame.AllocArray<Pal::ICmdBuffer*>(trackLayouts ? (cmdBufferCount * 2) : cmdBufferCount) :
+                nullptr;
 
             result = ((pPalCmdBuffers != nullptr) || (cmdBufferCount == 0)) ? result : VK_ERROR_OUT_OF_HOST_MEMORY;
 
-            bool lastBatch = (submitIdx == submitCount - 1);
+            bool lastBatch = (batchEnd == submitCount - 1);
+
+            Pal::IFence*  pPalFence   = nullptr;
+            Pal::IFence** ppPalFences = &pPalFence;
+
+            Pal::BarrierTransition* pLayoutFixups = nullptr;
+
+            if ((result == VK_SUCCESS) && trackLayouts)
+            {
+                VK_ASSERT(m_pDevice->NumPalDevices() == 1);
+
+                ppPalFences   = virtStackFrame.AllocArray<Pal::IFence*>(cmdBufferCount + 1);
+                pLayoutFixups = virtStackFrame.AllocArray<Pal::BarrierTransition>(
+                    ImageLayoutCmdBufferState::MaxFixupCount);
+
+                result = ((ppPalFences != nullptr) && (pLayoutFixups != nullptr)) ?
+                         result : VK_ERROR_OUT_OF_HOST_MEMORY;
+            }
 
-            Pal::IFence* pPalFence = nullptr;
             Pal::PerSubQueueSubmitInfo perSubQueueInfo = {};
 
             perSubQueueInfo.cmdBufferCount  = 0;
@@ -506,6 +792,8 @@ VkResult Queue::Submit(
                 perSubQueueInfo.cmdBufferCount = 0;
 
                 palSubmitInfo.stackSizeInDwords = 0;
+                palSubmitInfo.ppFences          = ppPalFences;
+                palSubmitInfo.fenceCount        = 0;
 
                 const uint32_t deviceMask = 1 << deviceIdx;
 
@@ -522,9 +810,39 @@ VkResult Queue::Submit(
 
                     if (cmdBuf.IsProtected() == protectedSubmit)
                     {
+                        if ((result == VK_SUCCESS) && trackLayouts && (cmdBuf.GetImageLayoutState() != nullptr))
+                        {
+                            const uint32_t fixupCount = pLayoutTracker->Commit(
+                                *cmdBuf.GetImageLayoutState(),
+                                ImageLayoutCmdBufferState::MaxFixupCount,
+                                pLayoutFixups);
+
+                            if (fixupCount > 0)
+                            {
+                                CmdBufState* pFixupState = BuildLayoutFixups(deviceIdx, fixupCount, pLayoutFixups);
+
+                                if (pFixupState != nullptr)
+                                {
+                                    pPalCmdBuffers[perSubQueueInfo.cmdBufferCount++] = pFixupState->pCmdBuf;
+                                    ppPalFences[palSubmitInfo.fenceCount++]          = pFixupState->pFence;
+                                }
+                                else
+                                {
+                                    // The command buffer can't run without its images in the layouts it expects
+                                    result = VK_ERROR_OUT_OF_HOST_MEMORY;
+                                }
+                            }
+                        }
 
                         pPalCmdBuffers[perSubQueueInfo.cmdBufferCount++] = cmdBuf.PalCmdBuffer(deviceIdx);
 
+                        // The pools place the command data of command buffers that are submitted repeatedly in local
+                        // memory.
+                        if ((deviceIdx == 0) && cmdBuf.GetCmdPool()->AdaptsCmdAllocators())
+                        {
+                            cmdBuf.GetCmdPool()->NotifySubmit();
+                        }
+
                         const uint32_t stackSizeInDwords =
                             Util::NumBytesToNumDwords(cmdBuf.PerGpuState(deviceIdx)->maxPipelineStackSize);
 
@@ -539,16 +857,15 @@ VkResult Queue::Submit(
 
                 if (lastBatch && (pFence != nullptr))
                 {
-                    pPalFence = pFence->PalFence(deviceIdx);
-                    palSubmitInfo.ppFences   = &pPalFence;
-                    palSubmitInfo.fenceCount = 1;
+                    ppPalFences[palSubmitInfo.fenceCount++] = pFence->PalFence(deviceIdx);
 
                     pFence->SetActiveDevice(deviceIdx);
                 }
 
-                if ((perSubQueueInfo.cmdBufferCount > 0) ||
-                    (palSubmitInfo.fenceCount > 0)     ||
-                    (waitSemaphoreCount > 0))
+                if ((result == VK_SUCCESS) &&
+                    ((perSubQueueInfo.cmdBufferCount > 0) ||
+                     (palSubmitInfo.fenceCount > 0)     ||
+                     (waitSemaphoreCount > 0)))
                 {
                     Pal::Result palResult = Pal::Result::Success;
 
@@ -610,7 +927,29 @@ VkResult Queue::Submit(
                         }
                         else
                         {
+                            // Only the default device's queue is sampled for idle gaps.
+                            QueueSubmitStats* pStats = (deviceIdx == DefaultDeviceIndex) ? m_pSubmitStats : nullptr;
+
+                            QueueTimingState* pTiming = (deviceIdx == DefaultDeviceIndex) ? m_pTimingState : nullptr;
+
+                            const int64_t submitTicks = (pTiming != nullptr) ? Util::GetPerfCpuTime() : 0;
+
+                            if (pStats != nullptr)
+                            {
+                                pStats->BeforePalSubmit(PalQueue(deviceIdx));
+                            }
+
                             palResult = PalQueue(deviceIdx)->Submit(palSubmitInfo);
+
+                            if ((pStats != nullptr) && (palResult == Pal::Result::Success))
+                            {
+                                pStats->AfterPalSubmit(PalQueue(deviceIdx));
+                            }
+
+                            if ((pTiming != nullptr) && (palResult == Pal::Result::Success))
+                            {
+                                pTiming->RecordSubmit(PalQueue(deviceIdx), submitTicks, cmdBufferCount);
+                            }
                         }
                     }
                     else
@@ -636,7 +975,7 @@ VkResult Queue::Submit(
 
             }
 
-            if (isSynchronization2 && (pCmdBuffers != nullptr))
+            if (ownsCmdBuffers)
             {
                 virtStackFrame.FreeArray(pCmdBuffers);
             }
@@ -645,7 +984,7 @@ VkResult Queue::Submit(
 
             if (isSynchronization2)
             {
-                const VkSubmitInfo2KHR* pSubmitInfoKhr = reinterpret_cast<const VkSubmitInfo2KHR*>(&pSubmits[submitIdx]);
+                const VkSubmitInfo2KHR* pSubmitInfoKhr = reinterpret_cast<const VkSubmitInfo2KHR*>(&pSubmits[batchEnd]);
 
                 if ((result == VK_SUCCESS) && (pSubmitInfoKhr->signalSemaphoreInfoCount > 0))
                 {
@@ -676,7 +1015,7 @@ VkResult Queue::Submit(
             }
             else
             {
-                const VkSubmitInfo* pSubmitInfoOld = reinterpret_cast<const VkSubmitInfo*>(&pSubmits[submitIdx]);
+                const VkSubmitInfo* pSubmitInfoOld = reinterpret_cast<const VkSubmitInfo*>(&pSubmits[batchEnd]);
 
                 if ((result == VK_SUCCESS) && (pSubmitInfoOld->signalSemaphoreCount > 0))
                 {
@@ -698,12 +1037,34 @@ VkResult Queue::Submit(
     return result;
 }
 
+// The submit thread calls these directly.
+template
+VkResult Queue::PalSubmit<VkSubmitInfo>(
+    uint32_t            submitCount,
+    const VkSubmitInfo* pSubmits,
+    VkFence             fence);
+
+template
+VkResult Queue::PalSubmit<VkSubmitInfo2KHR>(
+    uint32_t                submitCount,
+    const VkSubmitInfo2KHR* pSubmits,
+    VkFence                 fence);
+
 // =====================================================================================================================
 
 // =====================================================================================================================
 // Wait for a queue to go idle
 VkResult Queue::WaitIdle(void)
 {
+    const int64_t startTicks = (m_pTimingState != nullptr) ? Util::GetPerfCpuTime() : 0;
+
+    const VkResult result = WaitForDeferredWork(0, nullptr);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
     Pal::Result palResult = Pal::Result::Success;
 
     for (uint32_t deviceIdx = 0;
@@ -713,6 +1074,11 @@ VkResult Queue::WaitIdle(void)
         palResult = PalQueue(deviceIdx)->WaitIdle();
     }
 
+    if (m_pTimingState != nullptr)
+    {
+        m_pTimingState->RecordCpuEvent(QueueTimingEventType::WaitIdle, startTicks, 0);
+    }
+
     return PalToVkResult(palResult);
 }
 
@@ -738,6 +1104,8 @@ VkResult Queue::PalSignalSemaphores(
     bool timedQueueEvents = false;
 #endif
 
+    const int64_t startTicks = (m_pTimingState != nullptr) ? Util::GetPerfCpuTime() : 0;
+
     Pal::Result palResult = Pal::Result::Success;
     uint32_t    deviceIdx = DefaultDeviceIndex;
 
@@ -774,6 +1142,11 @@ VkResult Queue::PalSignalSemaphores(
             if (timedQueueEvents == false)
             {
                 palResult = PalQueue(deviceIdx)->SignalQueueSemaphore(pPalSemaphore, pointValue);
+
+                if ((palResult == Pal::Result::Success) && m_pDevice->GetRuntimeSettings().elideSameQueueSemaphoreWaits)
+                {
+                    pVkSemaphore->RecordQueueSignal(PalQueue(deviceIdx), pointValue);
+                }
             }
             else
             {
@@ -789,6 +1162,11 @@ VkResult Queue::PalSignalSemaphores(
         }
     }
 
+    if ((m_pTimingState != nullptr) && (semaphoreCount > 0))
+    {
+        m_pTimingState->RecordCpuEvent(QueueTimingEventType::SemaphoreSignal, startTicks, semaphoreCount);
+    }
+
     return  (palResult == Pal::Result::ErrorUnknown) ? VK_ERROR_DEVICE_LOST : PalToVkResult(palResult);
 }
 
@@ -803,6 +1181,8 @@ VkResult Queue::PalWaitSemaphores(
     const uint32_t      semaphoreDeviceIndicesCount,
     const uint32_t*     pSemaphoreDeviceIndices)
 {
+    const int64_t startTicks = (m_pTimingState != nullptr) ? Util::GetPerfCpuTime() : 0;
+
     Pal::Result palResult = Pal::Result::Success;
     uint32_t    deviceIdx = DefaultDeviceIndex;
 
@@ -846,6 +1226,16 @@ VkResult Queue::PalWaitSemaphores(
 
             VK_ASSERT(deviceIdx < m_pDevice->NumPalDevices());
 
+            // A timeline value this queue already signaled needs no kernel wait: the queue's own submission order
+            // already puts the waiting work behind the signal.  Binary semaphores still wait, as that consumes the
+            // payload other queues and the swapchain observe.
+            if ((timedQueueEvents == false)                                   &&
+                m_pDevice->GetRuntimeSettings().elideSameQueueSemaphoreWaits  &&
+                pSemaphore->IsSignaledEarlierOnQueue(PalQueue(deviceIdx), pointValue))
+            {
+                continue;
+            }
+
             // Wait for the semaphore.
             pPalSemaphore = pSemaphore->PalSemaphore(deviceIdx);
             pSemaphore->RestoreSemaphore();
@@ -871,6 +1261,12 @@ VkResult Queue::PalWaitSemaphores(
         }
     }
 
+    // The timestamp lands once the default device's queue got past the waits.
+    if ((m_pTimingState != nullptr) && (semaphoreCount > 0) && (palResult == Pal::Result::Success))
+    {
+        m_pTimingState->RecordSemaphoreWait(PalQueue(DefaultDeviceIndex), startTicks, semaphoreCount);
+    }
+
     return PalToVkResult(palResult);
 }
 
@@ -916,6 +1312,9 @@ bool Queue::NeedPacePresent(
 VkResult Queue::Present(
     const VkPresentInfoKHR* pPresentInfo)
 {
+    const int64_t startTicks = ((m_pSubmitStats != nullptr) || (m_pTimingState != nullptr)) ?
+                               Util::GetPerfCpuTime() : 0;
+
     uint32_t presentationDeviceIdx = 0;
     bool     needSemaphoreFlush    = false;
 
@@ -965,7 +1364,13 @@ VkResult Queue::Present(
         pNext = pHeader->pNext;
     }
 
-    VkResult result = VK_SUCCESS;
+    // The present has to follow the rendering it waits on in PAL.
+    VkResult result = WaitForDeferredWork(pPresentInfo->waitSemaphoreCount, pPresentInfo->pWaitSemaphores);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
 
     // Query driver feature settings that could change from frame to frame.
     uint32_t rsFeaturesChangedMask = 0;
@@ -978,7 +1383,9 @@ VkResult Queue::Present(
 
         if ((palResult == Pal::Result::Success) && (rsFeaturesChangedMask != 0))
         {
-            // Update the feature settings from the app profile or the global settings.
+            // Update the feature settings from the app profile or the global settings.  The profile sources changed,
+            // so settings resolved from them earlier are stale.
+            m_pDevice->VkInstance()->InvalidateAppProfileSettings();
             m_pDevice->UpdateFeatureSettings();
         }
     }
@@ -1063,6 +1470,12 @@ VkResult Queue::Present(
                                                           &presentInfo,
                                                           pSwapChain);
 
+        // Keep an untouched internal command buffer for the next present instead of leaving it in the ring.
+        if ((hasPostProcessing == false) && (pCmdBufState != nullptr))
+        {
+            m_pUnusedCmdBufState[presentationDeviceIdx] = pCmdBufState;
+        }
+
         // For MGPU, the swapchain and device properties might perform software composition and return
         // a different presentation device for the present of the intermediate surface.
         Pal::IQueue* pPresentQueue = pSwapChain->PrePresent(presentationDeviceIdx,
@@ -1110,6 +1523,21 @@ VkResult Queue::Present(
             break;
         }
 
+        if (palResult == Pal::Result::Success)
+        {
+            pSwapChain->MarkFramePresented(pPresentQueue, m_pSubmitStats);
+        }
+
+        if (m_pSubmitStats != nullptr)
+        {
+            const FullscreenMgr* pFullscreenMgr = pSwapChain->GetFullscreenMgr();
+
+            m_pSubmitStats->RecordImagePresent(
+                pSwapChain->GetAcquireWaitTicks(),
+                (pFullscreenMgr != nullptr) && (pFullscreenMgr->GetExclusiveModeFlags().acquired == 1),
+                (palResult != Pal::Result::Success));
+        }
+
         // Notify swap chain that a present occurred
         pSwapChain->PostPresent(presentInfo, &palResult);
 
@@ -1156,11 +1584,82 @@ VkResult Queue::Present(
         }
     }
 
+    if (m_pSubmitStats != nullptr)
+    {
+        m_pSubmitStats->RecordPresent(startTicks, Util::GetPerfCpuTime());
+    }
+
+    if (m_pTimingState != nullptr)
+    {
+        m_pTimingState->RecordCpuEvent(QueueTimingEventType::Present, startTicks, pPresentInfo->swapchainCount);
+    }
+
     return result;
 }
 
 // =====================================================================================================================
-// Adds an entry to the remap range array.
+// Returns true if next continues prev in both virtual and real memory, so that one remap range can cover both.
+static bool IsContiguousRemapRange(
+    const Pal::VirtualMemoryRemapRange& prev,
+    const Pal::VirtualMemoryRemapRange& next)
+{
+    return (next.pVirtualGpuMem     == prev.pVirtualGpuMem)                   &&
+           (next.pRealGpuMem        == prev.pRealGpuMem)                      &&
+           (next.virtualAccessMode  == prev.virtualAccessMode)                &&
+           (next.virtualStartOffset == (prev.virtualStartOffset + prev.size)) &&
+           ((next.pRealGpuMem == nullptr) || (next.realStartOffset == (prev.realStartOffset + prev.size)));
+}
+
+// =====================================================================================================================
+// Copies the ranges to pSortedRanges ordered by virtual address and merges the ones which are contiguous in both
+// virtual and real memory.  Returns the merged range count, or 0 if any two ranges overlap: then the later bind has to
+// win and the batch must be remapped in its original order.
+static uint32_t SortAndMergeRemapRanges(
+    const Pal::VirtualMemoryRemapRange* pRanges,
+    uint32_t                            rangeCount,
+    Pal::VirtualMemoryRemapRange*       pSortedRanges)
+{
+    memcpy(pSortedRanges, pRanges, sizeof(Pal::VirtualMemoryRemapRange) * rangeCount);
+
+    std::sort(pSortedRanges,
+              pSortedRanges + rangeCount,
+              [](const Pal::VirtualMemoryRemapRange& lhs, const Pal::VirtualMemoryRemapRange& rhs)
+              {
+                  const uintptr_t lhsMem = reinterpret_cast<uintptr_t>(lhs.pVirtualGpuMem);
+                  const uintptr_t rhsMem = reinterpret_cast<uintptr_t>(rhs.pVirtualGpuMem);
+
+                  return (lhsMem != rhsMem) ? (lhsMem < rhsMem) : (lhs.virtualStartOffset < rhs.virtualStartOffset);
+              });
+
+    uint32_t mergedCount = 1;
+
+    for (uint32_t i = 1; i < rangeCount; ++i)
+    {
+        Pal::VirtualMemoryRemapRange*       pPrev = &pSortedRanges[mergedCount - 1];
+        const Pal::VirtualMemoryRemapRange& next  = pSortedRanges[i];
+
+        if ((next.pVirtualGpuMem == pPrev->pVirtualGpuMem) &&
+            (next.virtualStartOffset < (pPrev->virtualStartOffset + pPrev->size)))
+        {
+            mergedCount = 0;
+            break;
+        }
+
+        if (IsContiguousRemapRange(*pPrev, next))
+        {
+            pPrev->size += next.size;
+        }
+        else
+        {
+            pSortedRanges[mergedCount++] = next;
+        }
+    }
+
+    return mergedCount;
+}
+
+// =====================================================================================================================
+// Adds an entry to the remap range array.  An entry which continues the previous one only grows that one.
 VkResult Queue::AddVirtualRemapRange(
     uint32_t           resourceDeviceIndex,
     Pal::IGpuMemory*   pVirtualGpuMem,
@@ -1174,22 +1673,32 @@ VkResult Queue::AddVirtualRemapRange(
 
     VK_ASSERT(pRemapState->rangeCount < pRemapState->maxRangeCount);
 
-    Pal::VirtualMemoryRemapRange* pRemapRange = &pRemapState->pRanges[pRemapState->rangeCount++];
+    Pal::VirtualMemoryRemapRange remapRange = {};
 
     if (m_pDevice->VkPhysicalDevice(resourceDeviceIndex)->GetPrtFeatures() & Pal::PrtFeatureStrictNull)
     {
-        pRemapRange->virtualAccessMode = Pal::VirtualGpuMemAccessMode::ReadZero;
+        remapRange.virtualAccessMode = Pal::VirtualGpuMemAccessMode::ReadZero;
     }
     else
     {
-        pRemapRange->virtualAccessMode = Pal::VirtualGpuMemAccessMode::Undefined;
+        remapRange.virtualAccessMode = Pal::VirtualGpuMemAccessMode::Undefined;
     }
 
-    pRemapRange->pVirtualGpuMem     = pVirtualGpuMem;
-    pRemapRange->virtualStartOffset = virtualOffset;
-    pRemapRange->pRealGpuMem        = pRealGpuMem;
-    pRemapRange->realStartOffset    = realOffset;
-    pRemapRange->size               = size;
+    remapRange.pVirtualGpuMem     = pVirtualGpuMem;
+    remapRange.virtualStartOffset = virtualOffset;
+    remapRange.pRealGpuMem        = pRealGpuMem;
+    remapRange.realStartOffset    = realOffset;
+    remapRange.size               = size;
+
+    if ((pRemapState->rangeCount > 0) &&
+        IsContiguousRemapRange(pRemapState->pRanges[pRemapState->rangeCount - 1], remapRange))
+    {
+        pRemapState->pRanges[pRemapState->rangeCount - 1].size += size;
+    }
+    else
+    {
+        pRemapState->pRanges[pRemapState->rangeCount++] = remapRange;
+    }
 
     // If we've hit our limit of batched remaps, send them to PAL and reset
     if (pRemapState->rangeCount >= pRemapState->maxRangeCount)
@@ -1212,9 +1721,24 @@ VkResult Queue::CommitVirtualRemapRanges(
 
     if (pRemapState->rangeCount > 0)
     {
+        const Pal::VirtualMemoryRemapRange* pRanges    = pRemapState->pRanges;
+        uint32_t                            rangeCount = pRemapState->rangeCount;
+
+        // Binds of neighbouring pages often arrive out of order; sorting lets them collapse into fewer ranges.
+        if ((rangeCount > 1) && (pRemapState->pSortedRanges != nullptr))
+        {
+            const uint32_t mergedCount = SortAndMergeRemapRanges(pRanges, rangeCount, pRemapState->pSortedRanges);
+
+            if (mergedCount > 0)
+            {
+                pRanges    = pRemapState->pSortedRanges;
+                rangeCount = mergedCount;
+            }
+        }
+
         result = PalQueue(deviceIndex)->RemapVirtualMemoryPages(
-            pRemapState->rangeCount,
-            pRemapState->pRanges,
+            rangeCount,
+            pRanges,
             true,
             pFence);
 
@@ -1256,14 +1780,15 @@ VkResult Queue::BindSparseEntry(
         for (uint32_t k = 0; k < bufBindInfo.bindCount; ++k)
         {
             const VkSparseMemoryBind& bind = bufBindInfo.pBinds[k];
-            Pal::IGpuMemory* pRealGpuMem = nullptr;
+            Pal::IGpuMemory* pRealGpuMem  = nullptr;
+            VkDeviceSize     memoryOffset = bind.memoryOffset;
 
             if (bind.memory != VK_NULL_HANDLE)
             {
                 Memory* pMemory = Memory::ObjectFromHandle(bind.memory);
 
-                pRealGpuMem = pMemory->PalMemory(resourceDeviceIndex, memoryDeviceIndex);
-
+                pRealGpuMem  = pMemory->PalMemory(resourceDeviceIndex, memoryDeviceIndex);
+                memoryOffset = bind.memoryOffset + pMemory->Offset();
             }
 
             VK_ASSERT(bind.flags == 0);
@@ -1273,7 +1798,7 @@ VkResult Queue::BindSparseEntry(
                 pVirtualGpuMem,
                 bind.resourceOffset,
                 pRealGpuMem,
-                bind.memoryOffset,
+                memoryOffset,
                 bind.size,
                 pRemapState);
 
@@ -1296,14 +1821,15 @@ VkResult Queue::BindSparseEntry(
         for (uint32_t k = 0; k < imgBindInfo.bindCount; ++k)
         {
             const VkSparseMemoryBind& bind = imgBindInfo.pBinds[k];
-            Pal::IGpuMemory* pRealGpuMem = nullptr;
+            Pal::IGpuMemory* pRealGpuMem  = nullptr;
+            VkDeviceSize     memoryOffset = bind.memoryOffset;
 
             if (bind.memory != VK_NULL_HANDLE)
             {
                 Memory* pMemory = Memory::ObjectFromHandle(bind.memory);
 
-                pRealGpuMem = pMemory->PalMemory(resourceDeviceIndex, memoryDeviceIndex);
-
+                pRealGpuMem  = pMemory->PalMemory(resourceDeviceIndex, memoryDeviceIndex);
+                memoryOffset = bind.memoryOffset + pMemory->Offset();
             }
 
             result = AddVirtualRemapRange(
@@ -1311,7 +1837,7 @@ VkResult Queue::BindSparseEntry(
                 pVirtualGpuMem,
                 bind.resourceOffset,
                 pRealGpuMem,
-                bind.memoryOffset,
+                memoryOffset,
                 bind.size,
                 pRemapState);
 
@@ -1339,14 +1865,15 @@ VkResult Queue::BindSparseEntry(
 
             VK_ASSERT(bind.flags == 0);
 
-            Pal::IGpuMemory* pRealGpuMem = nullptr;
+            Pal::IGpuMemory* pRealGpuMem  = nullptr;
+            VkDeviceSize     memoryOffset = bind.memoryOffset;
 
             if (bind.memory != VK_NULL_HANDLE)
             {
                 Memory* pMemory = Memory::ObjectFromHandle(bind.memory);
 
-                pRealGpuMem = pMemory->PalMemory(resourceDeviceIndex, memoryDeviceIndex);
-
+                pRealGpuMem  = pMemory->PalMemory(resourceDeviceIndex, memoryDeviceIndex);
+                memoryOffset = bind.memoryOffset + pMemory->Offset();
             }
 
             // Get the subresource layout to be able to figure out its offset
@@ -1402,7 +1929,7 @@ VkResult Queue::BindSparseEntry(
 
             // Calculate byte size to remap per row
             VkDeviceSize sizePerRow = extentInTiles.width * prtTileSize;
-            VkDeviceSize realOffset = bind.memoryOffset;
+            VkDeviceSize realOffset = memoryOffset;
 
             const VkDeviceSize tileOffsetX = offsetInTiles.x * prtTileSize;
             const VkDeviceSize tileOffsetY = offsetInTiles.y * prtTileRowPitch;
@@ -1488,7 +2015,8 @@ static void PeekDeviceGroupBindSparseDeviceIndicesAndSemaphoreInfo(
     }
 }
 // =====================================================================================================================
-// Update sparse bindings.
+// Update sparse bindings.  With a submit thread the binds are only queued here, and the semaphore waits, the remaps and
+// the signals happen on that thread.
 VkResult Queue::BindSparse(
     uint32_t                bindInfoCount,
     const VkBindSparseInfo* pBindInfo,
@@ -1496,21 +2024,54 @@ VkResult Queue::BindSparse(
 {
     VkResult result = VK_SUCCESS;
 
+    if (m_pSubmitThread != nullptr)
+    {
+        result = m_pSubmitThread->BindSparse(bindInfoCount, pBindInfo, fence);
+    }
+    else
+    {
+        result = WaitForDeferredWork(0, nullptr);
+
+        for (uint32_t i = 0; (i < bindInfoCount) && (result == VK_SUCCESS); ++i)
+        {
+            result = WaitForDeferredWork(pBindInfo[i].waitSemaphoreCount, pBindInfo[i].pWaitSemaphores);
+        }
+
+        if (result == VK_SUCCESS)
+        {
+            result = PalBindSparse(bindInfoCount, pBindInfo, fence);
+        }
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Waits on the semaphores, remaps the sparse pages and signals the semaphores and the fence of a vkQueueBindSparse call.
+VkResult Queue::PalBindSparse(
+    uint32_t                bindInfoCount,
+    const VkBindSparseInfo* pBindInfo,
+    VkFence                 fence)
+{
+    VkResult result = PalToVkResult(m_pDevice->FlushMemReferences());
+
     VirtualStackFrame virtStackFrame(m_pStackAllocator);
 
     // Initialize state to track batches of sparse bind calls
     VirtualRemapState remapState = {};
 
     // Max number of sparse bind operations per batch
-    constexpr uint32_t MaxVirtualRemapRangesPerBatch = 1024;
+    constexpr uint32_t MaxVirtualRemapRangesPerBatch = 4096;
 
+    // Half of the space is the scratch copy for sorting the batch
     remapState.maxRangeCount =
         Util::Min(
             MaxVirtualRemapRangesPerBatch,
-            static_cast<uint32_t>(m_pStackAllocator->Remaining() / sizeof(Pal::VirtualMemoryRemapRange)));
+            static_cast<uint32_t>(m_pStackAllocator->Remaining() / (2 * sizeof(Pal::VirtualMemoryRemapRange))));
 
     // Allocate temp memory for one batch of remaps
-    remapState.pRanges = virtStackFrame.AllocArray<Pal::VirtualMemoryRemapRange>(remapState.maxRangeCount);
+    remapState.pRanges       = virtStackFrame.AllocArray<Pal::VirtualMemoryRemapRange>(remapState.maxRangeCount);
+    remapState.pSortedRanges = virtStackFrame.AllocArray<Pal::VirtualMemoryRemapRange>(remapState.maxRangeCount);
 
     if (remapState.pRanges == nullptr)
     {
@@ -1634,6 +2195,11 @@ VkResult Queue::BindSparse(
         while ((result == VK_SUCCESS) && deviceGroup.IterateNext());
     }
 
+    if (remapState.pSortedRanges != nullptr)
+    {
+        virtStackFrame.FreeArray(remapState.pSortedRanges);
+    }
+
     virtStackFrame.FreeArray(remapState.pRanges);
 
     return result;
@@ -1672,6 +2238,9 @@ void Queue::DestroyCmdBufRing(
         Util::Destructor(m_pCmdBufRing[deviceIdx]);
         m_pDevice->VkInstance()->FreeMem(m_pCmdBufRing[deviceIdx]);
         m_pCmdBufRing[deviceIdx] = nullptr;
+
+        // The unused command buffer is owned by the ring and was destroyed with it.
+        m_pUnusedCmdBufState[deviceIdx] = nullptr;
     }
 }
 
@@ -1779,55 +2348,77 @@ void Queue::DestroyCmdBufState(
 CmdBufState* Queue::AcquireInternalCmdBuf(
     uint32_t                       deviceIdx)
 {
-    CmdBufState* pCmdBufState = nullptr;
+    CmdBufState* pCmdBufState = m_pUnusedCmdBufState[deviceIdx];
 
-    // Initialize on first use
-    if (m_pCmdBufRing[deviceIdx] == nullptr)
+    if (pCmdBufState != nullptr)
     {
-        CreateCmdBufRing(deviceIdx);
+        // The last present added no post-processing work, so its command buffer is still open and empty.  Reuse it as
+        // is rather than resetting and beginning another one on every present.
+        m_pUnusedCmdBufState[deviceIdx] = nullptr;
     }
-
-    if (m_pCmdBufRing[deviceIdx] != nullptr)
+    else
     {
-        // Create a new command buffer if the least recently used one is still busy.
-        if ((m_pCmdBufRing[deviceIdx]->NumElements() == 0) ||
-            (m_pCmdBufRing[deviceIdx]->Front()->pFence->GetStatus() == Pal::Result::NotReady))
-        {
-            pCmdBufState = CreateCmdBufState(deviceIdx);
-        }
-        else
+        // Initialize on first use
+        if (m_pCmdBufRing[deviceIdx] == nullptr)
         {
-            m_pCmdBufRing[deviceIdx]->PopFront(&pCmdBufState);
+            CreateCmdBufRing(deviceIdx);
         }
 
-        // Immediately push this command buffer onto the back of the deque to avoid leaking memory.
-        if (pCmdBufState != nullptr)
+        if (m_pCmdBufRing[deviceIdx] != nullptr)
         {
-            Pal::Result result = m_pCmdBufRing[deviceIdx]->PushBack(pCmdBufState);
+            CmdBufRing* pRing = m_pCmdBufRing[deviceIdx];
 
-            if (result != Pal::Result::Success)
+            // Grow the ring instead of waiting if the least recently used command buffer is still busy, so the ring ends
+            // up as large as the number of post-process submissions the GPU keeps in flight.
+            if ((pRing->NumElements() == 0) || (pRing->Front()->pFence->GetStatus() == Pal::Result::NotReady))
             {
-                // We failed to push this command buffer onto the deque. To avoid leaking memory we must delete it.
-                DestroyCmdBufState(deviceIdx, pCmdBufState);
-                pCmdBufState = nullptr;
+                pCmdBufState = CreateCmdBufState(deviceIdx);
             }
             else
             {
-                Pal::CmdBufferBuildInfo buildInfo = {};
-
-                buildInfo.flags.optimizeOneTimeSubmit = 1;
-
-                result = pCmdBufState->pCmdBuf->Reset(m_pDevice->GetSharedCmdAllocator(deviceIdx), true);
+                pRing->PopFront(&pCmdBufState);
 
-                if (result == Pal::Result::Success)
+                // If the next one is idle as well, fewer submissions are in flight than the ring was sized for.  Shrink
+                // it by one entry per acquire so that a short burst doesn't make it reallocate on the next one.
+                if ((pRing->NumElements() >= MinInternalCmdBufCount) &&
+                    (pRing->Front()->pFence->GetStatus() != Pal::Result::NotReady))
                 {
-                    result = pCmdBufState->pCmdBuf->Begin(buildInfo);
+                    CmdBufState* pIdleCmdBufState = nullptr;
+
+                    pRing->PopFront(&pIdleCmdBufState);
+                    DestroyCmdBufState(deviceIdx, pIdleCmdBufState);
                 }
+            }
+
+            // Immediately push this command buffer onto the back of the deque to avoid leaking memory.
+            if (pCmdBufState != nullptr)
+            {
+                Pal::Result result = pRing->PushBack(pCmdBufState);
 
                 if (result != Pal::Result::Success)
                 {
+                    // We failed to push this command buffer onto the deque. To avoid leaking memory we must delete it.
+                    DestroyCmdBufState(deviceIdx, pCmdBufState);
                     pCmdBufState = nullptr;
                 }
+                else
+                {
+                    Pal::CmdBufferBuildInfo buildInfo = {};
+
+                    buildInfo.flags.optimizeOneTimeSubmit = 1;
+
+                    result = pCmdBufState->pCmdBuf->Reset(m_pDevice->GetSharedCmdAllocator(deviceIdx), true);
+
+                    if (result == Pal::Result::Success)
+                    {
+                        result = pCmdBufState->pCmdBuf->Begin(buildInfo);
+                    }
+
+                    if (result != Pal::Result::Success)
+                    {
+                        pCmdBufState = nullptr;
+                    }
+                }
             }
         }
     }
@@ -1835,6 +2426,47 @@ CmdBufState* Queue::AcquireInternalCmdBuf(
     return pCmdBufState;
 }
 
+// =====================================================================================================================
+// Records the transitions which move tracked images into the layouts a command buffer was recorded for into an internal
+// command buffer.  The caller submits it right before that command buffer, together with its fence.
+CmdBufState* Queue::BuildLayoutFixups(
+    uint32_t                      deviceIdx,
+    uint32_t                      fixupCount,
+    const Pal::BarrierTransition* pFixups)
+{
+    CmdBufState* pCmdBufState = AcquireInternalCmdBuf(deviceIdx);
+
+    if (pCmdBufState != nullptr)
+    {
+        static const Pal::HwPipePoint pipePoint = Pal::HwPipeBottom;
+
+        Pal::BarrierInfo barrier = {};
+
+        barrier.waitPoint          = Pal::HwPipeTop;
+        barrier.pipePointWaitCount = 1;
+        barrier.pPipePoints        = &pipePoint;
+        barrier.transitionCount    = fixupCount;
+        barrier.pTransitions       = pFixups;
+
+        pCmdBufState->pCmdBuf->CmdBarrier(barrier);
+
+        Pal::Result result = pCmdBufState->pCmdBuf->End();
+
+        if (result == Pal::Result::Success)
+        {
+            result = m_pDevice->PalDevice(deviceIdx)->ResetFences(1, &pCmdBufState->pFence);
+        }
+
+        // A failed command buffer stays on the ring with a fence that was never submitted, so it is reused next time
+        if (result != Pal::Result::Success)
+        {
+            pCmdBufState = nullptr;
+        }
+    }
+
+    return pCmdBufState;
+}
+
 // =====================================================================================================================
 // Build post processing commands
 bool Queue::BuildPostProcessCommands(
@@ -809,8 +809,6 @@ static VkResult CreateRenderPass(
     VkResult result  = VK_SUCCESS;
     void*    pMemory = nullptr;
 
-    utils::TempMemArena buildArena(pAllocator, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
-
     RenderPassExtCreateInfo renderPassExt;
 
     const void* pNext = pCreateInfo->pNext;
@@ -852,6 +850,16 @@ static VkResult CreateRenderPass(
         return VK_ERROR_OUT_OF_HOST_MEMORY;
     }
 
+    // Build-time scratch memory comes from a pooled arena which keeps its chunks between render passes
+    utils::TempMemArena* pBuildArena = pDevice->GetTempMemArenaPool()->Acquire();
+
+    if (pBuildArena == nullptr)
+    {
+        pDevice->FreeApiObject(pAllocator, pMemory);
+
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
     RenderPassCreateInfo renderPassInfo;
 
     void* pMemoryInfo = Util::VoidPtrInc(pMemory, apiSize);
@@ -863,22 +871,35 @@ static VkResult CreateRenderPass(
         infoMemorySize);
 
     RenderPassExecuteInfo* pExecuteInfo = nullptr;
-    RenderPassLogger*      pLogger      = nullptr;
+
+    // The builder and logger must be gone before their arena is released
+    {
+        RenderPassLogger* pLogger = nullptr;
 
 #if ICD_LOG_RENDER_PASSES
-    RenderPassLogger logger(&buildArena, pDevice);
+        RenderPassLogger logger(pBuildArena, pDevice);
 
-    pLogger = &logger;
+        pLogger = &logger;
 #endif
 
-    RenderPassLogBegin(pLogger, &renderPassInfo);
+        RenderPassLogBegin(pLogger, &renderPassInfo);
 
-    RenderPassBuilder builder(pDevice, &buildArena, pLogger);
+        RenderPassBuilder builder(pDevice, pBuildArena, pLogger);
 
-    result = builder.Build(
-        &renderPassInfo,
-        pAllocator,
-        &pExecuteInfo);
+        result = builder.Build(
+            &renderPassInfo,
+            pAllocator,
+            &pExecuteInfo);
+
+        if (result == VK_SUCCESS)
+        {
+            RenderPassLogExecuteInfo(pLogger, pExecuteInfo);
+
+            RenderPassLogEnd(pLogger);
+        }
+    }
+
+    pDevice->GetTempMemArenaPool()->Release(pBuildArena);
 
     if (result != VK_SUCCESS)
     {
@@ -896,10 +917,6 @@ static VkResult CreateRenderPass(
         return result;
     }
 
-    RenderPassLogExecuteInfo(pLogger, pExecuteInfo);
-
-    RenderPassLogEnd(pLogger);
-
     VK_PLACEMENT_NEW(pMemory) RenderPass(&renderPassInfo, pExecuteInfo);
 
     *pOutRenderPass = RenderPass::HandleFromVoidPointer(pMemory);
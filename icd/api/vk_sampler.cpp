@@ -235,7 +235,7 @@ VkResult Sampler::Create(
 
     // Allocate system memory. Construct the sampler in memory and then wrap a Vulkan
     // object around it.
-    void* pMemory = pDevice->AllocApiObject(
+    void* pMemory = pDevice->AllocPooledApiObject(
         pAllocator,
         apiSize + palSize + yCbCrMetaDataSize);
 
@@ -282,7 +282,7 @@ VkResult Sampler::Destroy(
     Util::Destructor(this);
 
     // Free memory
-    pDevice->FreeApiObject(pAllocator, this);
+    pDevice->FreePooledApiObject(pAllocator, this);
 
     return VK_SUCCESS;
 }
@@ -27,6 +27,7 @@
 #include "include/vk_device.h"
 #include "include/vk_instance.h"
 #include "include/vk_semaphore.h"
+#include "include/queue_submit_thread.h"
 
 #include "palQueueSemaphore.h"
 
@@ -237,6 +238,14 @@ VkResult Semaphore::Create(
     return vkResult;
 }
 
+// =====================================================================================================================
+// Waits until the deferred submission which last signals this semaphore, if any, has been handed to PAL.  Returns the
+// error of the submit thread if a deferred submission failed.
+VkResult Semaphore::WaitForPendingSignal() const
+{
+    return (m_pSignalThread != nullptr) ? m_pSignalThread->WaitForSubmission(m_signalSequence) : VK_SUCCESS;
+}
+
 // =====================================================================================================================
 // Get external handle from the semaphore object.
 VkResult Semaphore::GetShareHandle(
@@ -244,6 +253,9 @@ VkResult Semaphore::GetShareHandle(
     VkExternalSemaphoreHandleTypeFlagBits       handleType,
     Pal::OsExternalHandle*                      pHandle)
 {
+    // Exported sync files capture the signal, which has to be in PAL by now.
+    WaitForPendingSignal();
+
 #if defined(__unix__)
     PAL_ASSERT((handleType == VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT) ||
                (handleType == VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_SYNC_FD_BIT));
@@ -406,6 +418,14 @@ void Semaphore::SetSemaphore(
     }
 
     m_sharedSemaphoreHandle = importedHandle;
+
+    // The imported payload has its own value history.
+    m_knownCompletedValue.store(0, std::memory_order_release);
+
+    Util::MutexAuto lock(&m_queueSignalLock);
+
+    m_pLastSignalQueue = nullptr;
+    m_lastSignalValue  = 0;
 }
 
 // =====================================================================================================================
@@ -455,6 +475,11 @@ VkResult Semaphore::GetSemaphoreCounterValue(
     {
         pPalSemaphore = pSemaphore->PalSemaphore(DefaultDeviceIndex);
         palResult = pPalSemaphore->QuerySemaphoreValue(pValue);
+
+        if (palResult == Pal::Result::Success)
+        {
+            pSemaphore->UpdateKnownCompletedValue(*pValue);
+        }
     }
 
     return PalToVkResult(palResult);
@@ -470,12 +495,17 @@ VkResult Semaphore::WaitSemaphoreValue(
     Pal::Result palResult = Pal::Result::Success;
     Pal::IQueueSemaphore* pPalSemaphore = nullptr;
 
-    if (pSemaphore != nullptr)
+    if ((pSemaphore != nullptr) && (pSemaphore->IsKnownToHaveReached(value) == false))
     {
         VK_ASSERT(pSemaphore->IsTimelineSemaphore());
         pPalSemaphore = pSemaphore->PalSemaphore(DefaultDeviceIndex);
         pSemaphore->RestoreSemaphore();
         palResult = pPalSemaphore->WaitSemaphoreValue(value, timeout);
+
+        if (palResult == Pal::Result::Success)
+        {
+            pSemaphore->UpdateKnownCompletedValue(value);
+        }
     }
 
     return PalToVkResult(palResult);
@@ -494,11 +524,64 @@ VkResult Semaphore::SignalSemaphoreValue(
     {
         pPalSemaphore = pSemaphore->PalSemaphore(DefaultDeviceIndex);
         palResult = pPalSemaphore->SignalSemaphoreValue(value);
+
+        if (palResult == Pal::Result::Success)
+        {
+            pSemaphore->UpdateKnownCompletedValue(value);
+        }
     }
 
     return PalToVkResult(palResult);
 }
 
+// =====================================================================================================================
+// Raises the cached lower bound of the timeline value.  Several threads may race here; the highest value wins.
+void Semaphore::UpdateKnownCompletedValue(
+    uint64_t value)
+{
+    uint64_t knownValue = m_knownCompletedValue.load(std::memory_order_relaxed);
+
+    while ((value > knownValue) &&
+           (m_knownCompletedValue.compare_exchange_weak(knownValue, value, std::memory_order_release) == false))
+    {
+    }
+}
+
+// =====================================================================================================================
+// Remembers the PAL queue a timeline signal was submitted to.  Values only increase, so the last signal also has the
+// highest value.
+void Semaphore::RecordQueueSignal(
+    const Pal::IQueue* pPalQueue,
+    uint64_t           value)
+{
+    if (IsTimelineSemaphore() && (m_useTempSemaphore == false))
+    {
+        Util::MutexAuto lock(&m_queueSignalLock);
+
+        m_pLastSignalQueue = pPalQueue;
+        m_lastSignalValue  = value;
+    }
+}
+
+// =====================================================================================================================
+// Returns true if a signal of at least the given timeline value was submitted to the same PAL queue as the wait.  The
+// queue executes its work in submission order, so the wait adds nothing but a kernel round trip then.
+bool Semaphore::IsSignaledEarlierOnQueue(
+    const Pal::IQueue* pPalQueue,
+    uint64_t           value) const
+{
+    bool signaled = false;
+
+    if (IsTimelineSemaphore() && (m_useTempSemaphore == false))
+    {
+        Util::MutexAuto lock(&m_queueSignalLock);
+
+        signaled = (m_pLastSignalQueue == pPalQueue) && (value <= m_lastSignalValue);
+    }
+
+    return signaled;
+}
+
 namespace entry
 {
 VKAPI_ATTR void VKAPI_CALL vkDestroySemaphore(
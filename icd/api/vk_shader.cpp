@@ -24,6 +24,8 @@
  **********************************************************************************************************************/
 
 #include "include/vk_shader.h"
+#include "include/binary_cache_serialization.h"
+#include "include/shader_module_cache.h"
 #include "include/vk_device.h"
 #include "include/vk_instance.h"
 
@@ -134,8 +136,15 @@ ShaderModule::ShaderModule(
     size_t      codeSize,
     const void* pCode)
 {
-    m_codeSize = codeSize;
-    m_pCode    = pCode;
+    m_codeSize       = codeSize;
+    m_pCode          = pCode;
+    m_storedCodeSize = codeSize;
+    m_flags          = 0;
+    m_pCacheEntry    = nullptr;
+
+    m_pSpecConstants     = nullptr;
+    m_specConstantCount  = 0;
+    m_specConstantsKnown = false;
 
     // Calculate a 128-bit hash from the SPIRV code.  This is used by profile-guided compilation
     // parameter tuning.
@@ -146,6 +155,371 @@ ShaderModule::ShaderModule(
     memset(&m_handle, 0, sizeof(m_handle));
 }
 
+// =====================================================================================================================
+// Scans the module-level instructions of SPIR-V code for the specialization constants it declares.  With pConstants
+// set to nullptr only their number is returned in pCount; otherwise pConstants receives *pCount of them, sorted by
+// SpecId.  Returns false if the code isn't SPIR-V this parser understands, in which case nothing may be assumed about
+// its spec constants.
+bool ShaderModule::ParseSpecConstants(
+    size_t        codeSize,
+    const void*   pCode,
+    uint32_t*     pCount,
+    SpecConstant* pConstants)
+{
+    constexpr uint32_t SpirvMagic            = 0x07230203;
+    constexpr uint32_t SpirvHeaderWords      = 5;
+    constexpr uint32_t OpTypeBool            = 20;
+    constexpr uint32_t OpTypeInt             = 21;
+    constexpr uint32_t OpTypeFloat           = 22;
+    constexpr uint32_t OpSpecConstantTrue    = 48;
+    constexpr uint32_t OpSpecConstantFalse   = 49;
+    constexpr uint32_t OpSpecConstant        = 50;
+    constexpr uint32_t OpFunction            = 54;
+    constexpr uint32_t OpDecorate            = 71;
+    constexpr uint32_t DecorationSpecId      = 1;
+    constexpr uint32_t MaxScalarTypes        = 16;
+
+    // Scalar types the constants may have, with the size of their values in a VkSpecializationInfo
+    struct ScalarType
+    {
+        uint32_t id;
+        uint32_t size;
+    };
+
+    ScalarType scalarTypes[MaxScalarTypes] = {};
+    uint32_t   scalarTypeCount             = 0;
+
+    const uint32_t* pWords    = static_cast<const uint32_t*>(pCode);
+    const size_t    wordCount = codeSize / sizeof(uint32_t);
+
+    bool     valid    = (wordCount >= SpirvHeaderWords) && (pWords[0] == SpirvMagic);
+    uint32_t count    = 0;
+    size_t   pos      = SpirvHeaderWords;
+    bool     finished = false;
+
+    // Decorations and constants all precede the first function.
+    while (valid && (finished == false) && (pos < wordCount))
+    {
+        const uint32_t opCode    = pWords[pos] & 0xFFFF;
+        const uint32_t instWords = pWords[pos] >> 16;
+
+        if ((instWords == 0) || ((pos + instWords) > wordCount))
+        {
+            valid = false;
+        }
+        else if (opCode == OpFunction)
+        {
+            finished = true;
+        }
+        else if ((opCode == OpDecorate) && (instWords >= 4) && (pWords[pos + 2] == DecorationSpecId))
+        {
+            if (pConstants != nullptr)
+            {
+                // The counting pass has seen the same decorations.
+                VK_ASSERT(count < *pCount);
+
+                pConstants[count]          = {};
+                pConstants[count].specId   = pWords[pos + 3];
+                pConstants[count].resultId = pWords[pos + 1];
+            }
+
+            count++;
+        }
+        else if ((pConstants != nullptr) &&
+                 ((opCode == OpTypeBool) || (opCode == OpTypeInt) || (opCode == OpTypeFloat)) &&
+                 (instWords >= 2))
+        {
+            if (scalarTypeCount < MaxScalarTypes)
+            {
+                scalarTypes[scalarTypeCount].id   = pWords[pos + 1];
+                scalarTypes[scalarTypeCount].size = (opCode == OpTypeBool) ? sizeof(VkBool32)
+                                                  : ((instWords >= 3) ? (pWords[pos + 2] / 8) : 0);
+                scalarTypeCount++;
+            }
+        }
+        else if ((pConstants != nullptr) &&
+                 ((opCode == OpSpecConstantTrue) || (opCode == OpSpecConstantFalse) || (opCode == OpSpecConstant)) &&
+                 (instWords >= 3))
+        {
+            const uint32_t typeId   = pWords[pos + 1];
+            const uint32_t resultId = pWords[pos + 2];
+
+            uint32_t size = 0;
+
+            for (uint32_t i = 0; i < scalarTypeCount; ++i)
+            {
+                if (scalarTypes[i].id == typeId)
+                {
+                    size = scalarTypes[i].size;
+                }
+            }
+
+            uint64_t defaultValue = (opCode == OpSpecConstantTrue) ? 1 : 0;
+
+            if (opCode == OpSpecConstant)
+            {
+                // One literal word for up to 32 bits, low-order word first for 64 bits.
+                const uint32_t literalWords = instWords - 3;
+
+                if ((literalWords == 0) || (literalWords > 2) || (size > (literalWords * sizeof(uint32_t))))
+                {
+                    size = 0;
+                }
+                else
+                {
+                    defaultValue = pWords[pos + 3];
+
+                    if (literalWords == 2)
+                    {
+                        defaultValue |= static_cast<uint64_t>(pWords[pos + 4]) << 32;
+                    }
+                }
+            }
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (pConstants[i].resultId == resultId)
+                {
+                    pConstants[i].size         = ((size > 0) && (size <= sizeof(uint64_t))) ? size : 0;
+                    pConstants[i].defaultValue = defaultValue;
+                }
+            }
+        }
+
+        pos += instWords;
+    }
+
+    if (valid && (pConstants != nullptr))
+    {
+        // Insertion sort; modules rarely declare more than a few dozen spec constants.
+        for (uint32_t i = 1; i < count; ++i)
+        {
+            const SpecConstant constant = pConstants[i];
+
+            uint32_t j = i;
+
+            while ((j > 0) && (pConstants[j - 1].specId > constant.specId))
+            {
+                pConstants[j] = pConstants[j - 1];
+                j--;
+            }
+
+            pConstants[j] = constant;
+        }
+    }
+
+    if (valid)
+    {
+        *pCount = count;
+    }
+
+    return valid;
+}
+
+// =====================================================================================================================
+// Checks that all map entries of a specialization info lie within its data, as the normalization has to read them.
+bool ShaderModule::IsSpecializationInfoValid(
+    const VkSpecializationInfo& info)
+{
+    bool valid = (info.pMapEntries != nullptr) || (info.mapEntryCount == 0);
+
+    for (uint32_t i = 0; valid && (i < info.mapEntryCount); ++i)
+    {
+        const VkSpecializationMapEntry& entry = info.pMapEntries[i];
+
+        valid = (info.pData != nullptr)          &&
+                (entry.offset <= info.dataSize) &&
+                (entry.size <= (info.dataSize - entry.offset));
+    }
+
+    return valid;
+}
+
+// =====================================================================================================================
+// Returns the map entry of info which gives the spec constant a value other than its default, or nullptr if the
+// constant keeps the value the code gives it.
+const VkSpecializationMapEntry* ShaderModule::FindEffectiveEntry(
+    const VkSpecializationInfo& info,
+    const SpecConstant&         constant
+    ) const
+{
+    const VkSpecializationMapEntry* pEntry = nullptr;
+
+    for (uint32_t i = 0; (pEntry == nullptr) && (i < info.mapEntryCount); ++i)
+    {
+        if (info.pMapEntries[i].constantID == constant.specId)
+        {
+            pEntry = &info.pMapEntries[i];
+        }
+    }
+
+    if ((pEntry != nullptr) &&
+        (constant.size != 0) &&
+        (pEntry->size == constant.size) &&
+        (memcmp(Util::VoidPtrInc(info.pData, pEntry->offset), &constant.defaultValue, constant.size) == 0))
+    {
+        pEntry = nullptr;
+    }
+
+    return pEntry;
+}
+
+// =====================================================================================================================
+// Returns the size of the buffer NormalizeSpecializationInfo() needs for info.
+size_t ShaderModule::GetNormalizedSpecializationInfoSize(
+    const VkSpecializationInfo& info)
+{
+    size_t size = sizeof(VkSpecializationInfo) + (info.mapEntryCount * sizeof(VkSpecializationMapEntry));
+
+    for (uint32_t i = 0; i < info.mapEntryCount; ++i)
+    {
+        size += info.pMapEntries[i].size;
+    }
+
+    return size;
+}
+
+// =====================================================================================================================
+// Reduces a specialization info to the entries which have an effect on the code of the module: entries of constants
+// the module doesn't declare, and entries which set a constant to its default value, are dropped, and the remaining
+// ones are packed in SpecId order.  Pipelines whose specialization infos only differ in what is dropped thereby share
+// the LLPC pipeline hash, and with it their binary.
+//
+// Returns pInfo if it already has that form, nullptr if no entry remains, or else the reduced info written to pBuffer,
+// which must hold GetNormalizedSpecializationInfoSize() bytes.  pDroppedCount receives the number of dropped entries.
+const VkSpecializationInfo* ShaderModule::NormalizeSpecializationInfo(
+    const VkSpecializationInfo* pInfo,
+    void*                       pBuffer,
+    uint32_t*                   pDroppedCount
+    ) const
+{
+    const VkSpecializationInfo* pResult = pInfo;
+
+    *pDroppedCount = 0;
+
+    if ((pInfo != nullptr) && m_specConstantsKnown && IsSpecializationInfoValid(*pInfo))
+    {
+        VkSpecializationInfo*     pOut     = static_cast<VkSpecializationInfo*>(pBuffer);
+        VkSpecializationMapEntry* pEntries = static_cast<VkSpecializationMapEntry*>(
+            Util::VoidPtrInc(pBuffer, sizeof(VkSpecializationInfo)));
+        uint8_t*                  pData    = reinterpret_cast<uint8_t*>(pEntries + pInfo->mapEntryCount);
+
+        uint32_t entryCount  = 0;
+        uint32_t dataSize    = 0;
+        bool     isCanonical = true;
+
+        for (uint32_t i = 0; i < m_specConstantCount; ++i)
+        {
+            const VkSpecializationMapEntry* pEntry = FindEffectiveEntry(*pInfo, m_pSpecConstants[i]);
+
+            if (pEntry != nullptr)
+            {
+                isCanonical = isCanonical                                    &&
+                              (pEntry == &pInfo->pMapEntries[entryCount])    &&
+                              (pEntry->offset == dataSize);
+
+                pEntries[entryCount].constantID = pEntry->constantID;
+                pEntries[entryCount].offset     = dataSize;
+                pEntries[entryCount].size       = pEntry->size;
+
+                memcpy(&pData[dataSize], Util::VoidPtrInc(pInfo->pData, pEntry->offset), pEntry->size);
+
+                dataSize += static_cast<uint32_t>(pEntry->size);
+                entryCount++;
+            }
+        }
+
+        isCanonical = isCanonical && (entryCount == pInfo->mapEntryCount) && (dataSize == pInfo->dataSize);
+
+        *pDroppedCount = pInfo->mapEntryCount - entryCount;
+
+        if (entryCount == 0)
+        {
+            pResult = nullptr;
+        }
+        else if (isCanonical == false)
+        {
+            pOut->mapEntryCount = entryCount;
+            pOut->pMapEntries   = pEntries;
+            pOut->dataSize      = dataSize;
+            pOut->pData         = pData;
+
+            pResult = pOut;
+        }
+    }
+
+    return pResult;
+}
+
+// =====================================================================================================================
+// Adds a specialization info to an API hash the way NormalizeSpecializationInfo() reduces it, so that pipelines which
+// share a binary share the hash as well.  Only valid if HasSpecConstantInfo() returns true.
+void ShaderModule::HashSpecializationInfo(
+    Util::MetroHash128*         pHasher,
+    const VkSpecializationInfo& info
+    ) const
+{
+    VK_ASSERT(m_specConstantsKnown);
+
+    if (IsSpecializationInfoValid(info))
+    {
+        for (uint32_t i = 0; i < m_specConstantCount; ++i)
+        {
+            const VkSpecializationMapEntry* pEntry = FindEffectiveEntry(info, m_pSpecConstants[i]);
+
+            if (pEntry != nullptr)
+            {
+                pHasher->Update(pEntry->constantID);
+                pHasher->Update(pEntry->size);
+                pHasher->Update(static_cast<const uint8_t*>(Util::VoidPtrInc(info.pData, pEntry->offset)),
+                                pEntry->size);
+            }
+        }
+    }
+    else
+    {
+        pHasher->Update(info.mapEntryCount);
+        pHasher->Update(reinterpret_cast<const uint8_t*>(info.pMapEntries),
+                        info.mapEntryCount * sizeof(VkSpecializationMapEntry));
+        pHasher->Update(info.dataSize);
+        pHasher->Update(static_cast<const uint8_t*>(info.pData), (info.pData != nullptr) ? info.dataSize : 0);
+    }
+}
+
+// =====================================================================================================================
+// Compresses SPIR-V code for retention.  Returns a temporary allocation holding the compressed code, or nullptr if the
+// code doesn't compress well enough to be worth decompressing later.
+static void* CompressCode(
+    const Device* pDevice,
+    size_t        codeSize,
+    const void*   pCode,
+    size_t*       pCompressedSize)
+{
+    // Worst case expansion of the LZ4 block format
+    const size_t capacity = codeSize + (codeSize / 255) + 16;
+
+    void* pCompressed = pDevice->VkInstance()->AllocMem(capacity, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+
+    if (pCompressed != nullptr)
+    {
+        const size_t compressedSize = CompressLz4Block(pCode, codeSize, pCompressed, capacity);
+
+        // Require a saving of at least 1/8.
+        if ((compressedSize == 0) || (compressedSize > (codeSize - (codeSize / 8))))
+        {
+            pDevice->VkInstance()->FreeMem(pCompressed);
+
+            pCompressed = nullptr;
+        }
+        else
+        {
+            *pCompressedSize = compressedSize;
+        }
+    }
+
+    return pCompressed;
+}
+
 // =====================================================================================================================
 VkResult ShaderModule::Create(
     Device*                         pDevice,
@@ -153,41 +527,164 @@ VkResult ShaderModule::Create(
     const VkAllocationCallbacks*    pAllocator,
     VkShaderModule*                 pShaderModule)
 {
-    const size_t objSize = sizeof(ShaderModule) + pCreateInfo->codeSize;
+    ShaderModuleCache* pCache = pDevice->GetShaderModuleCache();
 
-    void* pMemory = pDevice->AllocApiObject(pAllocator, objSize);
+    size_t storedCodeSize = pCreateInfo->codeSize;
+    void*  pCompressed    = nullptr;
 
-    if (pMemory == nullptr)
+    if (pDevice->GetRuntimeSettings().compressShaderModuleCode)
     {
-        return VK_ERROR_OUT_OF_HOST_MEMORY;
+        pCompressed = CompressCode(pDevice, pCreateInfo->codeSize, pCreateInfo->pCode, &storedCodeSize);
     }
 
-    void* pCode = Util::VoidPtrInc(pMemory, sizeof(ShaderModule));
+    const void* pStoredCode = (pCompressed != nullptr) ? pCompressed : pCreateInfo->pCode;
 
-    memcpy(pCode, pCreateInfo->pCode, pCreateInfo->codeSize);
+    // The spec constants are kept behind the object, ahead of the code.
+    uint32_t   specConstantCount  = 0;
+    const bool specConstantsKnown = pDevice->GetRuntimeSettings().normalizeSpecializationInfo &&
+                                    ParseSpecConstants(pCreateInfo->codeSize, pCreateInfo->pCode, &specConstantCount,
+                                                       nullptr);
 
-    VK_PLACEMENT_NEW(pMemory) ShaderModule(pCreateInfo->codeSize, pCode);
+    // Shared modules keep their code in the cache entry.
+    const size_t objSize = sizeof(ShaderModule) + (specConstantCount * sizeof(SpecConstant)) +
+                           (pCache->IsEnabled() ? 0 : storedCodeSize);
 
-    ShaderModule* pShaderModuleObj = static_cast<ShaderModule*>(pMemory);
-    VkResult vkResult = pShaderModuleObj->Init(pDevice, pCreateInfo->flags);
-    VK_ASSERT(vkResult == VK_SUCCESS);
+    void* pMemory = pDevice->AllocApiObject(pAllocator, objSize);
+
+    VkResult vkResult = VK_SUCCESS;
+
+    if (pMemory != nullptr)
+    {
+        // The application's code is only referenced until initialization points the module at the retained copy.
+        VK_PLACEMENT_NEW(pMemory) ShaderModule(pCreateInfo->codeSize, pCreateInfo->pCode);
+
+        ShaderModule* pShaderModuleObj = static_cast<ShaderModule*>(pMemory);
 
-    *pShaderModule = ShaderModule::HandleFromVoidPointer(pMemory);
+        if (specConstantsKnown)
+        {
+            SpecConstant* pSpecConstants = static_cast<SpecConstant*>(Util::VoidPtrInc(pMemory, sizeof(ShaderModule)));
+
+            ParseSpecConstants(pCreateInfo->codeSize, pCreateInfo->pCode, &specConstantCount, pSpecConstants);
+
+            pShaderModuleObj->m_pSpecConstants     = pSpecConstants;
+            pShaderModuleObj->m_specConstantCount  = specConstantCount;
+            pShaderModuleObj->m_specConstantsKnown = true;
+        }
+
+        if (pCache->IsEnabled())
+        {
+            vkResult = pShaderModuleObj->InitShared(pDevice, pCreateInfo->flags, storedCodeSize, pStoredCode);
+        }
+        else
+        {
+            vkResult = pShaderModuleObj->Init(pDevice, pCreateInfo->flags, storedCodeSize, pStoredCode);
+        }
+
+        if (vkResult == VK_SUCCESS)
+        {
+            *pShaderModule = ShaderModule::HandleFromVoidPointer(pMemory);
+        }
+        else
+        {
+            Util::Destructor(pShaderModuleObj);
+
+            pDevice->FreeApiObject(pAllocator, pMemory);
+        }
+    }
+    else
+    {
+        vkResult = VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    if (pCompressed != nullptr)
+    {
+        pDevice->VkInstance()->FreeMem(pCompressed);
+    }
 
     return vkResult;
 }
 
 // =====================================================================================================================
-// Initialize shader module object, performing SPIR-V to AMD IL shader binary conversion.
-VkResult ShaderModule::Init(const Device* pDevice, VkShaderModuleCreateFlags flags)
+// Initialize shader module object, performing SPIR-V to AMD IL shader binary conversion.  The code to retain (possibly
+// compressed) is copied behind the object and its spec constants.
+VkResult ShaderModule::Init(
+    const Device*             pDevice,
+    VkShaderModuleCreateFlags flags,
+    size_t                    storedCodeSize,
+    const void*               pStoredCode)
 {
+    m_flags = flags;
+
     PipelineCompiler* pCompiler = pDevice->GetCompiler(DefaultDeviceIndex);
-    return pCompiler->BuildShaderModule(pDevice,
-                                        flags,
-                                        m_codeSize,
-                                        m_pCode,
-                                        &m_handle
-                                        );
+    VkResult result = pCompiler->BuildShaderModule(pDevice,
+                                                   flags,
+                                                   m_codeSize,
+                                                   m_pCode,
+                                                   &m_handle
+                                                   );
+
+    if (result == VK_SUCCESS)
+    {
+        void* pCode = Util::VoidPtrInc(this, sizeof(ShaderModule) + (m_specConstantCount * sizeof(SpecConstant)));
+
+        memcpy(pCode, pStoredCode, storedCodeSize);
+
+        m_pCode          = pCode;
+        m_storedCodeSize = storedCodeSize;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Initialize shader module object from the device's shader module cache, sharing the code and the converted module
+// with other live modules created from the same code.
+VkResult ShaderModule::InitShared(
+    Device*                   pDevice,
+    VkShaderModuleCreateFlags flags,
+    size_t                    storedCodeSize,
+    const void*               pStoredCode)
+{
+    m_flags = flags;
+
+    VkResult result = pDevice->GetShaderModuleCache()->Acquire(
+        flags,
+        m_codeSize,
+        m_pCode,
+        storedCodeSize,
+        pStoredCode,
+        m_codeHash,
+        &m_pCacheEntry);
+
+    if (result == VK_SUCCESS)
+    {
+        m_pCode          = m_pCacheEntry->pCode;
+        m_storedCodeSize = m_pCacheEntry->storedCodeSize;
+        m_handle         = m_pCacheEntry->handle;
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Writes the SPIR-V code of the module, GetCodeSize() bytes, to the given buffer.
+VkResult ShaderModule::CopyCode(
+    void* pDst
+    ) const
+{
+    VkResult result = VK_SUCCESS;
+
+    if (IsCodeCompressed())
+    {
+        result = DecompressLz4Block(m_pCode, m_storedCodeSize, pDst, m_codeSize) ? VK_SUCCESS
+                                                                                  : VK_ERROR_INITIALIZATION_FAILED;
+    }
+    else
+    {
+        memcpy(pDst, m_pCode, m_codeSize);
+    }
+
+    return result;
 }
 
 // =====================================================================================================================
@@ -195,9 +692,16 @@ VkResult ShaderModule::Destroy(
     Device*                         pDevice,
     const VkAllocationCallbacks*    pAllocator)
 {
-    PipelineCompiler* pCompiler = pDevice->GetCompiler(DefaultDeviceIndex);
+    if (m_pCacheEntry != nullptr)
+    {
+        pDevice->GetShaderModuleCache()->Release(m_pCacheEntry);
+    }
+    else
+    {
+        PipelineCompiler* pCompiler = pDevice->GetCompiler(DefaultDeviceIndex);
 
-    pCompiler->FreeShaderModule(&m_handle);
+        pCompiler->FreeShaderModule(&m_handle);
+    }
 
     Util::Destructor(this);
 
@@ -33,6 +33,7 @@
 #ifdef VK_USE_PLATFORM_XCB_KHR
 #include <xcb/xcb.h>
 #endif
+#include "include/queue_submit_stats.h"
 #include "include/vk_conv.h"
 #include "include/vk_fence.h"
 #include "include/vk_image.h"
@@ -79,8 +80,16 @@ SwapChain::SwapChain(
     m_pSwCompositor(nullptr),
     m_appOwnedImageCount(0),
     m_presentCount(0),
+    m_acquireWaitTicks(0),
     m_presentMode(presentMode),
-    m_deprecated(false)
+    m_deprecated(false),
+    m_latencyFrames(),
+    m_pLatencyFenceMemory(nullptr),
+    m_latencyFrameCount(0),
+    m_latencySampleCount(0),
+    m_latencySumTicks(0),
+    m_latencyMaxTicks(0),
+    m_pDebugName(nullptr)
 {
     // Initialize the color gamut with the native values.
     if (m_pFullscreenMgr != nullptr)
@@ -265,7 +274,18 @@ VkResult SwapChain::Create(
     swapChainCreateInfo.imageArraySize      = 1;
     swapChainCreateInfo.swapChainMode       = VkToPalSwapChainMode(pCreateInfo->presentMode);
 
-    swapChainCreateInfo.flags.canAcquireBeforeSignaling = pDevice->GetRuntimeSettings().enableAcquireBeforeSignal;
+    const RuntimeSettings& settings = pDevice->GetRuntimeSettings();
+
+    // In FIFO mode images are released in the order they were presented, so the image PAL hands out next is always the
+    // one predicted to be free soonest.  With enough images there is usually one whose present is merely queued, and
+    // letting the GPU wait for it instead of the CPU lets the application start recording the next frame earlier.
+    const bool fifoAcquireBeforeSignal =
+        (settings.fifoAcquireBeforeSignalMinImages > 0)               &&
+        (swapImageCount >= settings.fifoAcquireBeforeSignalMinImages) &&
+        ((pCreateInfo->presentMode == VK_PRESENT_MODE_FIFO_KHR) ||
+         (pCreateInfo->presentMode == VK_PRESENT_MODE_FIFO_RELAXED_KHR));
+
+    swapChainCreateInfo.flags.canAcquireBeforeSignaling = (settings.enableAcquireBeforeSignal || fifoAcquireBeforeSignal);
 
     if (properties.displayableInfo.icdPlatform == VK_ICD_WSI_PLATFORM_DISPLAY)
     {
@@ -441,27 +461,38 @@ VkResult SwapChain::Create(
                 &properties.imageMemory[properties.imageCount]);
         }
 
-        if (result == VK_SUCCESS)
+        if (result != VK_SUCCESS)
         {
-            palResult = Pal::Result::Success;
+            break;
+        }
+    }
 
-            // Add memory references to presentable image memory
-            for (uint32_t deviceIdx = 0;
-                (deviceIdx < pDevice->NumPalDevices()) && (palResult == Pal::Result::Success);
-                 deviceIdx++)
-            {
-                palResult = pDevice->AddMemReference(
-                    pDevice->PalDevice(deviceIdx),
-                    Memory::ObjectFromHandle(properties.imageMemory[properties.imageCount])->PalMemory(deviceIdx),
-                    false);
-            }
+    if (result == VK_SUCCESS)
+    {
+        // Make all of the presentable image memory resident up front with one reference list update per device, and
+        // keep it from being trimmed, so the first frames after a (re)create don't stall on paging it in.
+        Util::AutoBuffer<Pal::GpuMemoryRef, 8, PalAllocator> memRefs(properties.imageCount,
+                                                                     pDevice->VkInstance()->Allocator());
 
-            result = PalToVkResult(palResult);
+        if (memRefs.Capacity() < properties.imageCount)
+        {
+            result = VK_ERROR_OUT_OF_HOST_MEMORY;
         }
 
-        if (result != VK_SUCCESS)
+        for (uint32_t deviceIdx = 0; (deviceIdx < pDevice->NumPalDevices()) && (result == VK_SUCCESS); deviceIdx++)
         {
-            break;
+            for (uint32_t i = 0; i < properties.imageCount; ++i)
+            {
+                memRefs[i]            = {};
+                memRefs[i].pGpuMemory = Memory::ObjectFromHandle(properties.imageMemory[i])->PalMemory(deviceIdx);
+            }
+
+            palResult = pDevice->PalDevice(deviceIdx)->AddGpuMemoryReferences(properties.imageCount,
+                                                                              &memRefs[0],
+                                                                              nullptr,
+                                                                              Pal::GpuMemoryRefCantTrim);
+
+            result = PalToVkResult(palResult);
         }
     }
 
@@ -532,6 +563,76 @@ void SwapChain::Init(const VkAllocationCallbacks* pAllocator)
 {
     VkResult result = VK_SUCCESS;
 
+    InitLatencyFences();
+}
+
+// =====================================================================================================================
+// Creates the fences used to track the GPU completion of presented frames when low-latency pacing is enabled.  Pacing
+// is silently left disabled if they can't be created.
+void SwapChain::InitLatencyFences()
+{
+    const RuntimeSettings& settings = m_pDevice->GetRuntimeSettings();
+
+    // With software compositing the present may go to another device's queue, so only single-GPU devices are paced.
+    if (settings.lowLatencyPresent && (m_pDevice->NumPalDevices() == 1))
+    {
+        Pal::IDevice* pPalDevice = m_pDevice->PalDevice(DefaultDeviceIndex);
+        Pal::Result   palResult  = Pal::Result::Success;
+
+        const size_t fenceSize = pPalDevice->GetFenceSize(&palResult);
+
+        if (palResult == Pal::Result::Success)
+        {
+            m_pLatencyFenceMemory = m_pDevice->VkInstance()->AllocMem(fenceSize * MaxLatencyFrames,
+                                                                      VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+        }
+
+        if (m_pLatencyFenceMemory != nullptr)
+        {
+            Pal::FenceCreateInfo fenceInfo = {};
+
+            for (uint32_t i = 0; (i < MaxLatencyFrames) && (palResult == Pal::Result::Success); ++i)
+            {
+                palResult = pPalDevice->CreateFence(fenceInfo,
+                                                    Util::VoidPtrInc(m_pLatencyFenceMemory, fenceSize * i),
+                                                    &m_latencyFrames[i].pFence);
+            }
+
+            if (palResult != Pal::Result::Success)
+            {
+                DestroyLatencyFences();
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Waits for any frames still tracked by the low-latency pacer and destroys its fences.
+void SwapChain::DestroyLatencyFences()
+{
+    if (m_pLatencyFenceMemory != nullptr)
+    {
+        Pal::IDevice* pPalDevice = m_pDevice->PalDevice(DefaultDeviceIndex);
+
+        for (uint32_t i = 0; i < MaxLatencyFrames; ++i)
+        {
+            if (m_latencyFrames[i].pFence != nullptr)
+            {
+                if (m_latencyFrames[i].pending)
+                {
+                    pPalDevice->WaitForFences(1, &m_latencyFrames[i].pFence, true, UINT64_MAX);
+                }
+
+                m_latencyFrames[i].pFence->Destroy();
+            }
+        }
+
+        m_pDevice->VkInstance()->FreeMem(m_pLatencyFenceMemory);
+
+        m_pLatencyFenceMemory = nullptr;
+
+        memset(m_latencyFrames, 0, sizeof(m_latencyFrames));
+    }
 }
 
 // =====================================================================================================================
@@ -570,6 +671,8 @@ VkResult SwapChain::Destroy(const VkAllocationCallbacks* pAllocator)
         m_pPalSwapChain->WaitIdle();
     }
 
+    DestroyLatencyFences();
+
     if (m_pFullscreenMgr != nullptr)
     {
         m_pFullscreenMgr->Destroy(pAllocator);
@@ -647,9 +750,13 @@ VkResult SwapChain::AcquireNextImage(
     Pal::AcquireNextImageInfo acquireInfo = {};
     VkResult                  result = VK_SUCCESS;
 
+    const int64_t startTicks = m_pDevice->GetRuntimeSettings().enableQueueSubmitStats ? Util::GetPerfCpuTime() : 0;
+
     // SwapChain should not return any image if it was marked as deprecated before.
     if (m_deprecated == false)
     {
+        PaceAcquire();
+
         Semaphore* pSemaphore = Semaphore::ObjectFromHandle(semaphore);
         Fence*     pFence     = Fence::ObjectFromHandle(fence);
 
@@ -667,6 +774,11 @@ VkResult SwapChain::AcquireNextImage(
             result = PalToVkResult(m_pPalSwapChain->AcquireNextImage(acquireInfo, pImageIndex));
         }
 
+        if ((result == VK_SUCCESS) && (startTicks != 0))
+        {
+            m_acquireWaitTicks = Util::GetPerfCpuTime() - startTicks;
+        }
+
         if (result == VK_SUCCESS)
         {
             m_appOwnedImageCount++;
@@ -708,6 +820,157 @@ void SwapChain::PostPresent(
     m_presentCount++;
 }
 
+// =====================================================================================================================
+// Called after a successful present of this swap chain on the given queue.  When low-latency pacing is enabled, this
+// submits a fence on the present queue so that the GPU completion of the frame can be observed by PaceAcquire().  The
+// measured latency is also recorded to the given queue stats, if any.
+void SwapChain::MarkFramePresented(
+    Pal::IQueue*      pPresentQueue,
+    QueueSubmitStats* pStats)
+{
+    if (m_pLatencyFenceMemory != nullptr)
+    {
+        Pal::IDevice*       pPalDevice = m_pDevice->PalDevice(DefaultDeviceIndex);
+        const uint32_t      frameIdx   = m_latencyFrameCount % MaxLatencyFrames;
+        FrameLatencyMarker* pMarker    = &m_latencyFrames[frameIdx];
+
+        // Normally PaceAcquire() has retired this marker already, unless the application presents several frames
+        // without acquiring in between.
+        if (pMarker->pending)
+        {
+            pPalDevice->WaitForFences(1, &pMarker->pFence, true, UINT64_MAX);
+
+            RecordFrameLatency(frameIdx);
+        }
+
+        Pal::Result palResult = pPalDevice->ResetFences(1, &pMarker->pFence);
+
+        if (palResult == Pal::Result::Success)
+        {
+            Pal::SubmitInfo submitInfo = {};
+
+            submitInfo.ppFences   = &pMarker->pFence;
+            submitInfo.fenceCount = 1;
+
+            palResult = pPresentQueue->Submit(submitInfo);
+        }
+
+        if (palResult == Pal::Result::Success)
+        {
+            pMarker->presentTicks = Util::GetPerfCpuTime();
+            pMarker->pStats       = pStats;
+            pMarker->pending      = true;
+
+            m_latencyFrameCount++;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Delays the acquire of the next image until no more than LowLatencyMaxQueuedFrames presented frames are still queued
+// on the GPU.  This keeps the CPU from running ahead of the GPU, so input sampled for the next frame is displayed
+// sooner.  Frames seen completed along the way are recorded as latency samples.
+void SwapChain::PaceAcquire()
+{
+    if (m_pLatencyFenceMemory != nullptr)
+    {
+        Pal::IDevice*  pPalDevice = m_pDevice->PalDevice(DefaultDeviceIndex);
+        const uint32_t maxQueued  = Util::Min(m_pDevice->GetRuntimeSettings().lowLatencyMaxQueuedFrames,
+                                              MaxLatencyFrames - 1);
+        const uint32_t firstFrame = (m_latencyFrameCount > MaxLatencyFrames) ?
+                                    (m_latencyFrameCount - MaxLatencyFrames) : 0;
+
+        // Retire frames oldest first.  Blocking on a frame completes it at the moment it is seen signaled, which also
+        // makes its latency sample exact.
+        for (uint32_t frame = firstFrame; frame < m_latencyFrameCount; ++frame)
+        {
+            const uint32_t      frameIdx = frame % MaxLatencyFrames;
+            FrameLatencyMarker* pMarker  = &m_latencyFrames[frameIdx];
+
+            if (pMarker->pending)
+            {
+                const bool mustWait = ((m_latencyFrameCount - frame) > maxQueued);
+
+                if (mustWait)
+                {
+                    pPalDevice->WaitForFences(1, &pMarker->pFence, true, UINT64_MAX);
+                }
+
+                if (mustWait || (pMarker->pFence->GetStatus() == Pal::Result::Success))
+                {
+                    RecordFrameLatency(frameIdx);
+                }
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Records the present-to-GPU-idle latency of a tracked frame which has just been seen completed.
+void SwapChain::RecordFrameLatency(
+    uint32_t frameIdx)
+{
+    FrameLatencyMarker* pMarker = &m_latencyFrames[frameIdx];
+
+    const int64_t latencyTicks = Util::GetPerfCpuTime() - pMarker->presentTicks;
+
+    pMarker->pending = false;
+
+    m_latencySumTicks += latencyTicks;
+    m_latencyMaxTicks  = Util::Max(m_latencyMaxTicks, latencyTicks);
+    m_latencySampleCount++;
+
+    if (pMarker->pStats != nullptr)
+    {
+        pMarker->pStats->RecordPresentLatency(latencyTicks);
+    }
+
+    const uint32_t reportInterval = m_pDevice->GetRuntimeSettings().lowLatencyReportInterval;
+
+    if ((reportInterval > 0) && (m_latencySampleCount >= reportInterval))
+    {
+        ReportFrameLatency();
+    }
+}
+
+// =====================================================================================================================
+// Reports the average and worst present-to-GPU-idle latency of the frames measured since the last report to the
+// application's VK_EXT_debug_utils messengers, then starts a new measurement window.
+void SwapChain::ReportFrameLatency()
+{
+    const double ticksPerMs = static_cast<double>(Util::GetPerfFrequency()) / 1000.0;
+
+    char message[256];
+
+    Util::Snprintf(message,
+                   sizeof(message),
+                   "Frame latency: frames=%u avgMs=%.3f maxMs=%.3f",
+                   m_latencySampleCount,
+                   (static_cast<double>(m_latencySumTicks) / m_latencySampleCount) / ticksPerMs,
+                   static_cast<double>(m_latencyMaxTicks) / ticksPerMs);
+
+    VkDebugUtilsObjectNameInfoEXT object = {};
+    object.sType        = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+    object.objectType   = VK_OBJECT_TYPE_SWAPCHAIN_KHR;
+    object.objectHandle = reinterpret_cast<uint64_t>(SwapChain::HandleFromObject(this));
+    object.pObjectName  = m_pDebugName;
+
+    VkDebugUtilsMessengerCallbackDataEXT callbackData = {};
+    callbackData.sType          = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CALLBACK_DATA_EXT;
+    callbackData.pMessageIdName = "AMD-FrameLatency";
+    callbackData.pMessage       = message;
+    callbackData.objectCount    = 1;
+    callbackData.pObjects       = &object;
+
+    m_pDevice->VkInstance()->CallExternalMessengers(VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT,
+                                                    VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
+                                                    &callbackData);
+
+    m_latencySampleCount = 0;
+    m_latencySumTicks    = 0;
+    m_latencyMaxTicks    = 0;
+}
+
 // =====================================================================================================================
 // Call to check to see if the swapchain (turbosync) needs to pace present
 bool SwapChain::NeedPacePresent(
@@ -1313,6 +1576,7 @@ SwCompositor::SwCompositor(
     const Device*     pDevice,
     uint32_t          presentationDeviceIdx,
     uint32_t          imageCount,
+    uint32_t          chunkCount,
     Pal::QueueType    queueType,
     Pal::IImage**     ppBltImages[],
     Pal::IGpuMemory** ppBltMemory[],
@@ -1320,6 +1584,7 @@ SwCompositor::SwCompositor(
     :
     m_presentationDeviceIdx(presentationDeviceIdx),
     m_imageCount(imageCount),
+    m_chunkCount(chunkCount),
     m_queueType(queueType)
 {
     for (uint32_t deviceIdx = 0; deviceIdx < pDevice->NumPalDevices(); ++deviceIdx)
@@ -1330,8 +1595,12 @@ SwCompositor::SwCompositor(
 
         for (uint32_t i = 0; i < m_imageCount; ++i)
         {
-            m_ppBltImages[deviceIdx][i]     = nullptr;
-            m_ppBltMemory[deviceIdx][i]     = nullptr;
+            m_ppBltImages[deviceIdx][i] = nullptr;
+            m_ppBltMemory[deviceIdx][i] = nullptr;
+        }
+
+        for (uint32_t i = 0; i < (m_imageCount * m_chunkCount); ++i)
+        {
             m_ppBltCmdBuffers[deviceIdx][i] = nullptr;
         }
     }
@@ -1380,17 +1649,36 @@ SwCompositor* SwCompositor::Create(
     palCmdBufferSize = pPalDevice->GetCmdBufferSize(cmdBufCreateInfo, &palResult);
     VK_ASSERT(palResult == Pal::Result::Success);
 
+    // Split each SDMA peer copy into horizontal bands, one per SDMA engine every other device has a compositing queue
+    // on, so that the bands are transferred concurrently.
+    uint32_t chunkCount = 1;
+
+    if (useSdmaCompositingBlt)
+    {
+        chunkCount = Device::MaxSwCompositingEngines;
+
+        for (uint32_t deviceIdx = 0; deviceIdx < pDevice->NumPalDevices(); ++deviceIdx)
+        {
+            if (deviceIdx != properties.presentationDeviceIdx)
+            {
+                chunkCount = Util::Min(chunkCount, pDevice->GetSwCompositingEngineCount(deviceIdx));
+            }
+        }
+    }
+
     // Total size for: 1. this object
-    //                 2. pBltImages, pBltMemory, pBltCmdBuffers for all images and devices
+    //                 2. pBltImages, pBltMemory for all images and devices, pBltCmdBuffers for all chunks as well
     //                 3. the intermediate images for the presentation device
     //                 4. the peer images for all of the other devices
+    const size_t cmdBufferArraySize = sizeof(Pal::ICmdBuffer*) * properties.imageCount * chunkCount;
+
     size_t imageArraysOffset       = sizeof(SwCompositor);
     size_t presentableDeviceOffset = imageArraysOffset +
-                                     ((sizeof(Pal::IImage*) + sizeof(Pal::IGpuMemory*) + sizeof(Pal::ICmdBuffer*)) *
-                                      properties.imageCount * pDevice->NumPalDevices());
+                                     (((sizeof(Pal::IImage*) + sizeof(Pal::IGpuMemory*)) * properties.imageCount) +
+                                      cmdBufferArraySize) * pDevice->NumPalDevices();
     size_t otherDevicesOffset      = presentableDeviceOffset + ((palImageSize + palMemorySize) * properties.imageCount);
     size_t totalSize               = otherDevicesOffset +
-                                     ((palPeerImageSize + palPeerMemorySize + palCmdBufferSize) *
+                                     ((palPeerImageSize + palPeerMemorySize + (palCmdBufferSize * chunkCount)) *
                                          properties.imageCount * (pDevice->NumPalDevices() - 1));
 
     void* pMemory = pDevice->VkInstance()->AllocMem(totalSize, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
@@ -1411,8 +1699,7 @@ SwCompositor* SwCompositor::Create(
                                             (sizeof(Pal::IImage*) * properties.imageCount)));
             ppBltCmdBuffers[deviceIdx] = static_cast<Pal::ICmdBuffer**>(Util::VoidPtrInc(ppBltMemory[deviceIdx],
                                             (sizeof(Pal::IGpuMemory*) * properties.imageCount)));
-            pNextImageArrays           = Util::VoidPtrInc(ppBltCmdBuffers[deviceIdx],
-                                            (sizeof(Pal::ICmdBuffer*) * properties.imageCount));
+            pNextImageArrays           = Util::VoidPtrInc(ppBltCmdBuffers[deviceIdx], cmdBufferArraySize);
         }
 
         // Construct the object after setting up the member array bases
@@ -1420,6 +1707,7 @@ SwCompositor* SwCompositor::Create(
             pDevice,
             properties.presentationDeviceIdx,
             properties.imageCount,
+            chunkCount,
             cmdBufCreateInfo.queueType,
             ppBltImages,
             ppBltMemory,
@@ -1461,7 +1749,12 @@ SwCompositor* SwCompositor::Create(
         Pal::ImageLayout     dstLayout = { Pal::LayoutCopyDst, cmdBufCreateInfo.engineType };
         Pal::ImageCopyRegion region    = {};
 
-        region.extent    = peerInfo.pOriginalImage->GetImageCreateInfo().extent;
+        const Pal::Extent3d imageExtent = peerInfo.pOriginalImage->GetImageCreateInfo().extent;
+
+        // Keep the band boundaries tile aligned so that no tile is written by two engines
+        const uint32_t chunkHeight = Util::Pow2Align((imageExtent.height + chunkCount - 1) / chunkCount, 64u);
+
+        region.extent    = imageExtent;
         region.numSlices = 1;
 
         region.srcSubres.plane     = 0;
@@ -1509,31 +1802,40 @@ SwCompositor* SwCompositor::Create(
                     pPeerImageMemory  = Util::VoidPtrInc(pPeerImageMemory, palPeerImageSize);
                     pPeerMemoryMemory = Util::VoidPtrInc(pPeerMemoryMemory, palPeerMemorySize);
 
-                    if (palResult == Pal::Result::Success)
+                    for (uint32_t chunk = 0; (chunk < chunkCount) && (palResult == Pal::Result::Success); ++chunk)
                     {
-                        palResult = pPalDevice->CreateCmdBuffer(
-                            cmdBufCreateInfo,
-                            pCmdBufferMemory,
-                            &ppBltCmdBuffers[deviceIdx][i]);
+                        Pal::ICmdBuffer** ppCmdBuffer = &ppBltCmdBuffers[deviceIdx][(i * chunkCount) + chunk];
+
+                        palResult = pPalDevice->CreateCmdBuffer(cmdBufCreateInfo, pCmdBufferMemory, ppCmdBuffer);
 
                         pCmdBufferMemory = Util::VoidPtrInc(pCmdBufferMemory, palCmdBufferSize);
 
-                        // Generate the BLT to the appropriate peer destination image
+                        // Generate the BLT of this band to the appropriate peer destination image.  Bands past the
+                        // bottom of a short image are left empty.
                         if (palResult == Pal::Result::Success)
                         {
-                            ppBltCmdBuffers[deviceIdx][i]->Begin(buildInfo);
-
-                            ppBltCmdBuffers[deviceIdx][i]->CmdCopyImage(
-                                *Image::ObjectFromHandle(properties.images[i])->PalImage(deviceIdx),
-                                srcLayout,
-                                *ppBltImages[deviceIdx][i],
-                                dstLayout,
-                                1,
-                                &region,
-                                nullptr,
-                                0);
-
-                            ppBltCmdBuffers[deviceIdx][i]->End();
+                            const uint32_t top = Util::Min(chunk * chunkHeight, imageExtent.height);
+
+                            region.srcOffset.y   = static_cast<int32_t>(top);
+                            region.dstOffset.y   = static_cast<int32_t>(top);
+                            region.extent.height = Util::Min(chunkHeight, imageExtent.height - top);
+
+                            (*ppCmdBuffer)->Begin(buildInfo);
+
+                            if (region.extent.height > 0)
+                            {
+                                (*ppCmdBuffer)->CmdCopyImage(
+                                    *Image::ObjectFromHandle(properties.images[i])->PalImage(deviceIdx),
+                                    srcLayout,
+                                    *ppBltImages[deviceIdx][i],
+                                    dstLayout,
+                                    1,
+                                    &region,
+                                    nullptr,
+                                    0);
+                            }
+
+                            (*ppCmdBuffer)->End();
                         }
                     }
                 }
@@ -1595,7 +1897,10 @@ void SwCompositor::Destroy(
                 m_ppBltImages[deviceIdx][i]->Destroy();
                 m_ppBltImages[deviceIdx][i] = nullptr;
             }
+        }
 
+        for (uint32_t i = 0; i < (m_imageCount * m_chunkCount); ++i)
+        {
             if (m_ppBltCmdBuffers[deviceIdx][i] != nullptr)
             {
                 m_ppBltCmdBuffers[deviceIdx][i]->Destroy();
@@ -1618,11 +1923,13 @@ Pal::IQueue* SwCompositor::DoSwCompositing(
     Pal::IGpuMemory**          ppSrcImageGpuMemory,
     const Queue*               pPresentQueue)
 {
-    Pal::IQueue* pPalQueue = pDevice->PerformSwCompositing(deviceIdx,
-                                                           m_presentationDeviceIdx,
-                                                           m_ppBltCmdBuffers[deviceIdx][pPresentInfo->imageIndex],
-                                                           m_queueType,
-                                                           pPresentQueue);
+    Pal::IQueue* pPalQueue = pDevice->PerformSwCompositing(
+        deviceIdx,
+        m_presentationDeviceIdx,
+        &m_ppBltCmdBuffers[deviceIdx][pPresentInfo->imageIndex * m_chunkCount],
+        m_chunkCount,
+        m_queueType,
+        pPresentQueue);
 
     if (pPalQueue != nullptr)
     {
@@ -41,6 +41,17 @@
 namespace vk
 {
 
+// Properties of the physical devices an instance's next link has returned, so enumerating again doesn't query them
+// again.  The loader keeps physical device handles stable across enumerations, so a handle's properties never change.
+struct PhysicalDevicePropertiesCache
+{
+    static constexpr uint32_t MaxDevices = 16;
+
+    uint32_t                   count;
+    VkPhysicalDevice           devices[MaxDevices];
+    VkPhysicalDeviceProperties properties[MaxDevices];
+};
+
 struct NextLinkFuncPointers
 {
     PFN_vkGetInstanceProcAddr                   pfnGetInstanceProcAddr;
@@ -50,6 +61,7 @@ struct NextLinkFuncPointers
     PFN_vkGetPhysicalDeviceProperties           pfnGetPhysicalDeviceProperties;
     PFN_vkEnumeratePhysicalDeviceGroups         pfnEnumeratePhysicalDeviceGroups;
     PFN_vkEnumeratePhysicalDeviceGroupsKHR      pfnEnumeratePhysicalDeviceGroupsKHR;
+    PhysicalDevicePropertiesCache*              pPropertiesCache;
 };
 
 typedef Util::HashMap<VkInstance, NextLinkFuncPointers, vk::PalAllocator> DispatchTableHashMap;
@@ -159,6 +159,18 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateInstance_SG(
                         reinterpret_cast<PFN_vkEnumeratePhysicalDeviceGroupsKHR>(
                             pfnGetInstanceProcAddr(*pInstance, "vkEnumeratePhysicalDeviceGroupsKHR"));
 
+                    // A failed allocation only disables caching of physical device properties
+                    nextLinkFuncs.pPropertiesCache = static_cast<PhysicalDevicePropertiesCache*>(
+                        pAllocCb->pfnAllocation(pAllocCb->pUserData,
+                                                sizeof(PhysicalDevicePropertiesCache),
+                                                sizeof(void*),
+                                                VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE));
+
+                    if (nextLinkFuncs.pPropertiesCache != nullptr)
+                    {
+                        nextLinkFuncs.pPropertiesCache->count = 0;
+                    }
+
                     // Store the next link's dispatch table to the hashmap
                     g_pDispatchTables->Insert(*pInstance, nextLinkFuncs);
                 }
@@ -181,6 +193,57 @@ VKAPI_ATTR void VKAPI_CALL vkDestroyInstance_SG(
     NextLinkFuncPointers nextLinkFuncs = *g_pDispatchTables->FindKey(instance);
     nextLinkFuncs.pfnDestroyInstance(instance, pAllocator);
     g_pDispatchTables->Erase(instance);
+
+    if (nextLinkFuncs.pPropertiesCache != nullptr)
+    {
+        const VkAllocationCallbacks* pAllocCb = &allocator::g_DefaultAllocCallback;
+        pAllocCb->pfnFree(pAllocCb->pUserData, nextLinkFuncs.pPropertiesCache);
+    }
+}
+
+// =====================================================================================================================
+// Gets the properties of a physical device returned by the next link.  They are only queried down the chain the first
+// time the instance sees the device; apps which enumerate repeatedly then don't pay for a property query per device
+// on every enumeration.
+static void GetPhysicalDeviceProperties_SG(
+    const NextLinkFuncPointers&                 nextLinkFuncs,
+    VkPhysicalDevice                            physicalDevice,
+    VkPhysicalDeviceProperties*                 pProperties)
+{
+    PhysicalDevicePropertiesCache* pCache = nextLinkFuncs.pPropertiesCache;
+
+    bool found = false;
+
+    if (pCache != nullptr)
+    {
+        Util::MutexAuto lock(&g_traceMutex);
+
+        for (uint32_t i = 0; (i < pCache->count) && (found == false); i++)
+        {
+            if (pCache->devices[i] == physicalDevice)
+            {
+                *pProperties = pCache->properties[i];
+                found        = true;
+            }
+        }
+    }
+
+    if (found == false)
+    {
+        nextLinkFuncs.pfnGetPhysicalDeviceProperties(physicalDevice, pProperties);
+
+        if (pCache != nullptr)
+        {
+            Util::MutexAuto lock(&g_traceMutex);
+
+            if (pCache->count < PhysicalDevicePropertiesCache::MaxDevices)
+            {
+                pCache->devices[pCache->count]    = physicalDevice;
+                pCache->properties[pCache->count] = *pProperties;
+                pCache->count++;
+            }
+        }
+    }
 }
 
 // =====================================================================================================================
@@ -264,7 +327,7 @@ VKAPI_ATTR VkResult VKAPI_CALL vkEnumeratePhysicalDevices_SG(
             for (uint32_t i = 0; i < physicalDeviceCount; i++)
             {
                 // Determine whether RADV Vulkan driver exists and get all physical device properites
-                nextLinkFuncs.pfnGetPhysicalDeviceProperties(pLayerPhysicalDevices[i], &pProperties[i]);
+                GetPhysicalDeviceProperties_SG(nextLinkFuncs, pLayerPhysicalDevices[i], &pProperties[i]);
                 if (((pProperties[i].vendorID == VENDOR_ID_AMD) || (pProperties[i].vendorID == VENDOR_ID_ATI)) &&
                    (strstr(pProperties[i].deviceName, "RADV") != nullptr))
                 {
@@ -438,7 +501,7 @@ static VkResult vkEnumeratePhysicalDeviceGroupsComm(
                 {
                     for (uint32_t i = 0; i < physicalDeviceCount; i++)
                     {
-                       nextLinkFuncs.pfnGetPhysicalDeviceProperties(pTmpLayerPhysicalDevice[i], &pProperties[i]);
+                       GetPhysicalDeviceProperties_SG(nextLinkFuncs, pTmpLayerPhysicalDevice[i], &pProperties[i]);
                     }
                 }
             }
@@ -452,8 +515,8 @@ static VkResult vkEnumeratePhysicalDeviceGroupsComm(
                 for (uint32_t i = 0; i < physicalDeviceGroupCount; i++)
                 {
                     VkPhysicalDeviceProperties properties = {};
-                    nextLinkFuncs.pfnGetPhysicalDeviceProperties(
-                            pLayerPhysicalDeviceGroups[i].physicalDevices[0], &properties);
+                    GetPhysicalDeviceProperties_SG(
+                            nextLinkFuncs, pLayerPhysicalDeviceGroups[i].physicalDevices[0], &properties);
                     for (uint32_t j = 0; j < physicalDeviceCount; j++)
                     {
                         if ((properties.vendorID == pProperties[j].vendorID) &&
@@ -140,6 +140,22 @@ void VulkanSettingsLoader::OverrideSettingsBySystemInfo()
 
         MakeAbsolutePath(m_settings.pipelineProfileDumpFile, sizeof(m_settings.pipelineProfileDumpFile),
                          pRootPath, m_settings.pipelineProfileDumpFile);
+        MakeAbsolutePath(m_settings.pipelineCompileStatsFile, sizeof(m_settings.pipelineCompileStatsFile),
+                         pRootPath, m_settings.pipelineCompileStatsFile);
+        MakeAbsolutePath(m_settings.descriptorPoolStatsFile, sizeof(m_settings.descriptorPoolStatsFile),
+                         pRootPath, m_settings.descriptorPoolStatsFile);
+        MakeAbsolutePath(m_settings.queueSubmitStatsFile, sizeof(m_settings.queueSubmitStatsFile),
+                         pRootPath, m_settings.queueSubmitStatsFile);
+        MakeAbsolutePath(m_settings.internalMemSlabStatsFile, sizeof(m_settings.internalMemSlabStatsFile),
+                         pRootPath, m_settings.internalMemSlabStatsFile);
+        MakeAbsolutePath(m_settings.memoryEventLogFile, sizeof(m_settings.memoryEventLogFile),
+                         pRootPath, m_settings.memoryEventLogFile);
+
+        if (m_settings.appOptRuleFile[0] != '\0')
+        {
+            MakeAbsolutePath(m_settings.appOptRuleFile, sizeof(m_settings.appOptRuleFile),
+                             pRootPath, m_settings.appOptRuleFile);
+        }
 #if ICD_RUNTIME_APP_PROFILE
         MakeAbsolutePath(m_settings.pipelineProfileRuntimeFile, sizeof(m_settings.pipelineProfileRuntimeFile),
                          pRootPath, m_settings.pipelineProfileRuntimeFile);
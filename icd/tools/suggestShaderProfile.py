@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+##
+ #######################################################################################################################
+ #
+ #  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ #
+ #  Permission is hereby granted, free of charge, to any person obtaining a copy
+ #  of this software and associated documentation files (the "Software"), to deal
+ #  in the Software without restriction, including without limitation the rights
+ #  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ #  copies of the Software, and to permit persons to whom the Software is
+ #  furnished to do so, subject to the following conditions:
+ #
+ #  The above copyright notice and this permission notice shall be included in all
+ #  copies or substantial portions of the Software.
+ #
+ #  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ #  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ #  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ #  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ #  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ #  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ #  SOFTWARE.
+ #
+ #######################################################################################################################
+
+# Turns pipeline statistics dumps (PipelineStatsProfileFile) of runs with EnablePipelineAutotune into candidate
+# profile.json entries for api/appopt/shader_profiles.
+#
+# The autotuner settles the wave size and NGG culling of the hot pipelines of one machine.  Its winners are listed in
+# the "tunedPipelines" section of the dump, while "pipelines" gives the sampled GPU time of each pipeline.  This script
+# gathers the dumps of many runs, keeps the winners the runs agree on which gain enough and cover enough of the GPU
+# time, and writes them as shader profile entries, hottest first.  Hot pipelines which are neither tuned nor covered by
+# the existing profile are reported, as they are the ones worth a closer look.
+#
+# Usage:
+#   suggestShaderProfile.py [--profile <profile.json>] [--merge] [-o <out.json>] <dump.json> [<dump.json> ...]
+
+import sys
+import json
+import argparse
+
+STAGES = ["vs", "hs", "ds", "gs", "ps", "cs"]
+
+# Shader profile actions of each autotune variant
+VARIANT_ACTIONS = {
+    "wave32":     { "waveSize": 32 },
+    "wave64":     { "waveSize": 64 },
+    "nggCulling": { "nggEnableBackfaceCulling": True,
+                    "nggEnableFrustumCulling":  True,
+                    "nggEnableSmallPrimFilter": True },
+}
+
+# Reads the last pipeline statistics snapshot of a dump.  Snapshots are appended to the file, and each one covers the
+# run up to the time it was written.
+def readLastSnapshot(fileName):
+    with open(fileName, "r") as file:
+        text = file.read()
+
+    decoder  = json.JSONDecoder()
+    snapshot = None
+    pos      = 0
+
+    while True:
+        while (pos < len(text)) and text[pos].isspace():
+            pos += 1
+
+        if pos >= len(text):
+            break
+
+        try:
+            obj, pos = decoder.raw_decode(text, pos)
+        except json.JSONDecodeError as e:
+            # A run which didn't exit cleanly may leave a truncated snapshot
+            print("{0}: ignoring the rest of the file: {1}".format(fileName, e), file=sys.stderr)
+            break
+
+        if "pipelineStats" in obj:
+            snapshot = obj["pipelineStats"]
+
+    return snapshot
+
+# Identifies a pipeline by the code hashes of its stages, in the lower case the profiles use
+def shaderKey(shaders):
+    return tuple(shaders.get(stage, "").lower() for stage in STAGES)
+
+# Builds a pattern matching exactly the pipelines with the given shaders, as the autotuner's own profile does
+def buildPattern(key):
+    pattern = {}
+
+    for stage, codeHash in zip(STAGES, key):
+        if codeHash:
+            pattern[stage] = { "stageActive": True, "codeHash": codeHash }
+        else:
+            pattern[stage] = { "stageInactive": True }
+
+    return pattern
+
+# Returns the shader keys fully pinned down by the entries of an existing profile
+def readProfileKeys(fileName):
+    with open(fileName, "r") as file:
+        profile = json.load(file)
+
+    keys = set()
+
+    for entry in profile.get("entries", []):
+        shaders = {}
+
+        for stage, stagePattern in entry.get("pattern", {}).items():
+            if (stage in STAGES) and ("codeHash" in stagePattern):
+                shaders[stage] = stagePattern["codeHash"]
+
+        if shaders:
+            keys.add(shaderKey(shaders))
+
+    return profile, keys
+
+def main():
+    parser = argparse.ArgumentParser(description="Suggest shader profile entries from pipeline statistics dumps.")
+    parser.add_argument("dumps", nargs="+", help="pipeline statistics dumps of runs with autotuning enabled")
+    parser.add_argument("--profile", help="existing profile.json of the title; pipelines it covers are skipped")
+    parser.add_argument("--merge", action="store_true", help="write the existing profile with the new entries appended")
+    parser.add_argument("--min-gain", type=int, default=5,
+                        help="minimum gain in percent a winner must show in every run (default: 5)")
+    parser.add_argument("--min-share", type=int, default=10,
+                        help="minimum permille of the GPU time a pipeline must take (default: 10)")
+    parser.add_argument("-o", "--output", help="output file (default: stdout)")
+    args = parser.parse_args()
+
+    gpuNs    = {}   # Sampled GPU time by shader key, over all runs
+    totalNs  = 0
+    votes    = {}   # Per shader key, (variant, tuned stage) -> list of gains
+    runCount = 0
+
+    for fileName in args.dumps:
+        snapshot = readLastSnapshot(fileName)
+
+        if snapshot is None:
+            print("{0}: no pipeline statistics found".format(fileName), file=sys.stderr)
+            continue
+
+        runCount += 1
+
+        for pipeline in snapshot.get("pipelines", []):
+            totalNs += pipeline.get("gpuTimeNs", 0)
+
+            if "shaders" in pipeline:
+                key = shaderKey(pipeline["shaders"])
+                gpuNs[key] = gpuNs.get(key, 0) + pipeline.get("gpuTimeNs", 0)
+
+        for tuned in snapshot.get("tunedPipelines", []):
+            if tuned["variant"] in VARIANT_ACTIONS:
+                key  = shaderKey(tuned["shaders"])
+                vote = (tuned["variant"], tuned["tunedStage"])
+                votes.setdefault(key, {}).setdefault(vote, []).append(tuned["gainPercent"])
+
+    if runCount == 0:
+        sys.exit("No usable dumps.")
+
+    profile, coveredKeys = readProfileKeys(args.profile) if args.profile else ({ "entries": [] }, set())
+
+    def sharePermille(key):
+        return (gpuNs.get(key, 0) * 1000) // totalNs if totalNs > 0 else 0
+
+    candidates = []
+
+    for key, keyVotes in votes.items():
+        if key in coveredKeys:
+            continue
+
+        # Different machines may settle on different winners; only suggest one all runs which tuned it agree on
+        if len(keyVotes) > 1:
+            print("Conflicting winners {0} for {1}".format(sorted(v[0] for v in keyVotes), key), file=sys.stderr)
+            continue
+
+        (variant, tunedStage), gains = next(iter(keyVotes.items()))
+
+        if (min(gains) >= args.min_gain) and (sharePermille(key) >= args.min_share):
+            candidates.append((gpuNs.get(key, 0), key, variant, tunedStage, gains))
+
+    candidates.sort(key=lambda c: c[0], reverse=True)
+
+    newEntries = []
+
+    for _, key, variant, tunedStage, gains in candidates:
+        newEntries.append({
+            "pattern": buildPattern(key),
+            "action":  { tunedStage: dict(VARIANT_ACTIONS[variant]) }
+        })
+
+        print("{0:4d} permille, {1} in {2} run(s), gain {3}-{4}%: {5}".format(
+              sharePermille(key), variant, len(gains), min(gains), max(gains), key), file=sys.stderr)
+
+    # Hot pipelines left for manual analysis
+    suggestedKeys = set(c[1] for c in candidates)
+
+    for key in sorted(gpuNs, key=gpuNs.get, reverse=True):
+        if (sharePermille(key) >= args.min_share) and (key not in suggestedKeys) and (key not in coveredKeys):
+            print("{0:4d} permille, not tuned: {1}".format(sharePermille(key), key), file=sys.stderr)
+
+    if args.merge:
+        output = dict(profile)
+        output["entries"] = profile.get("entries", []) + newEntries
+    else:
+        output = { "entries": newEntries }
+
+    text   = json.dumps(output, indent=2) + "\n"
+
+    if args.output:
+        with open(args.output, "w") as file:
+            file.write(text)
+    else:
+        sys.stdout.write(text)
+
+if __name__ == "__main__":
+    main()
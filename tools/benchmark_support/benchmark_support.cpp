@@ -0,0 +1,257 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  benchmark_support.cpp
+* @brief Command line parsing and instance/device setup shared by the benchmark tools.
+***********************************************************************************************************************
+*/
+#include "benchmark_support.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace bench
+{
+
+// =====================================================================================================================
+// Prints an error for a failed Vulkan call and returns whether the call succeeded.
+bool Check(
+    VkResult    result,
+    const char* pWhat)
+{
+    if (result != VK_SUCCESS)
+    {
+        fprintf(stderr, "%s failed: VkResult %d\n", pWhat, static_cast<int>(result));
+    }
+
+    return (result == VK_SUCCESS);
+}
+
+// =====================================================================================================================
+// Parses the command line.  Returns false if an argument is not recognized or invalid, or the positional argument is
+// missing.
+bool ParseArgs(
+    int            argc,
+    char**         argv,
+    const ArgDesc* pArgs,
+    uint32_t       argCount,
+    const char*    pUsage)
+{
+    const ArgDesc* pPositional = nullptr;
+
+    for (uint32_t j = 0; j < argCount; ++j)
+    {
+        if (pArgs[j].pName == nullptr)
+        {
+            pPositional = &pArgs[j];
+        }
+    }
+
+    bool positionalSeen = false;
+    bool valid          = true;
+
+    for (int i = 1; valid && (i < argc); ++i)
+    {
+        const ArgDesc* pArg = nullptr;
+
+        for (uint32_t j = 0; (pArg == nullptr) && (j < argCount); ++j)
+        {
+            if ((pArgs[j].pName != nullptr) && (strcmp(argv[i], pArgs[j].pName) == 0))
+            {
+                pArg = &pArgs[j];
+            }
+        }
+
+        if ((pArg != nullptr) && (pArg->type == ArgType::Flag))
+        {
+            *static_cast<bool*>(pArg->pValue) = true;
+        }
+        else if ((pArg != nullptr) && ((i + 1) < argc))
+        {
+            ++i;
+
+            if (pArg->type == ArgType::Uint)
+            {
+                uint32_t* pValue = static_cast<uint32_t*>(pArg->pValue);
+
+                *pValue = static_cast<uint32_t>(strtoul(argv[i], nullptr, 0));
+                valid   = (*pValue > 0);
+            }
+            else
+            {
+                *static_cast<const char**>(pArg->pValue) = argv[i];
+            }
+        }
+        else if ((pArg == nullptr) && (pPositional != nullptr) && (positionalSeen == false) && (argv[i][0] != '-'))
+        {
+            *static_cast<const char**>(pPositional->pValue) = argv[i];
+            positionalSeen                                  = true;
+        }
+        else
+        {
+            valid = false;
+        }
+    }
+
+    if ((valid == false) || ((pPositional != nullptr) && (positionalSeen == false)))
+    {
+        fprintf(stderr, "usage: %s %s\n", argv[0], pUsage);
+        valid = false;
+    }
+
+    return valid;
+}
+
+// =====================================================================================================================
+// Creates the instance.
+bool CreateInstance(
+    const char*    pAppName,
+    uint32_t       apiVersion,
+    DeviceContext* pContext)
+{
+    VkApplicationInfo appInfo = {};
+    appInfo.sType            = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = pAppName;
+    appInfo.apiVersion       = apiVersion;
+
+    VkInstanceCreateInfo instanceInfo = {};
+    instanceInfo.sType            = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.pApplicationInfo = &appInfo;
+
+    return Check(vkCreateInstance(&instanceInfo, nullptr, &pContext->instance), "vkCreateInstance");
+}
+
+// =====================================================================================================================
+// Picks the first physical device exposed by the loader and its first queue family which supports all of queueFlags.
+bool SelectPhysicalDevice(
+    VkQueueFlags   queueFlags,
+    DeviceContext* pContext)
+{
+    uint32_t physicalDeviceCount = 1;
+    VkResult result = vkEnumeratePhysicalDevices(pContext->instance, &physicalDeviceCount, &pContext->physicalDevice);
+
+    bool success = ((result == VK_SUCCESS) || (result == VK_INCOMPLETE)) && (physicalDeviceCount > 0);
+
+    if (success)
+    {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(pContext->physicalDevice, &queueFamilyCount, nullptr);
+
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(pContext->physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+        pContext->queueFamilyIndex = 0;
+
+        while ((pContext->queueFamilyIndex < queueFamilyCount) &&
+               ((queueFamilies[pContext->queueFamilyIndex].queueFlags & queueFlags) != queueFlags))
+        {
+            pContext->queueFamilyIndex++;
+        }
+
+        success = (pContext->queueFamilyIndex < queueFamilyCount);
+
+        if (success == false)
+        {
+            fprintf(stderr, "No queue family with flags 0x%x found\n", static_cast<uint32_t>(queueFlags));
+        }
+    }
+    else
+    {
+        fprintf(stderr, "No Vulkan physical device found\n");
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Creates the device with one queue of the selected family.  pNext and pFeatures are passed on in the device create
+// info.
+bool CreateDevice(
+    const void*                     pNext,
+    const VkPhysicalDeviceFeatures* pFeatures,
+    DeviceContext*                  pContext)
+{
+    const float queuePriority = 1.0f;
+
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = pContext->queueFamilyIndex;
+    queueInfo.queueCount       = 1;
+    queueInfo.pQueuePriorities = &queuePriority;
+
+    VkDeviceCreateInfo deviceInfo = {};
+    deviceInfo.sType                = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.pNext                = pNext;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos    = &queueInfo;
+    deviceInfo.pEnabledFeatures     = pFeatures;
+
+    const bool success = Check(vkCreateDevice(pContext->physicalDevice, &deviceInfo, nullptr, &pContext->device),
+                               "vkCreateDevice");
+
+    if (success)
+    {
+        vkGetDeviceQueue(pContext->device, pContext->queueFamilyIndex, 0, &pContext->queue);
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Creates the instance and the device on the first physical device, at API version 1.2.
+bool CreateContext(
+    const char*                     pAppName,
+    VkQueueFlags                    queueFlags,
+    const void*                     pNext,
+    const VkPhysicalDeviceFeatures* pFeatures,
+    DeviceContext*                  pContext)
+{
+    return CreateInstance(pAppName, VK_API_VERSION_1_2, pContext) &&
+           SelectPhysicalDevice(queueFlags, pContext) &&
+           CreateDevice(pNext, pFeatures, pContext);
+}
+
+// =====================================================================================================================
+// Destroys the device and the instance.
+void DestroyContext(
+    DeviceContext* pContext)
+{
+    if (pContext->device != VK_NULL_HANDLE)
+    {
+        vkDestroyDevice(pContext->device, nullptr);
+        pContext->device = VK_NULL_HANDLE;
+    }
+
+    if (pContext->instance != VK_NULL_HANDLE)
+    {
+        vkDestroyInstance(pContext->instance, nullptr);
+        pContext->instance = VK_NULL_HANDLE;
+    }
+}
+
+} // namespace bench
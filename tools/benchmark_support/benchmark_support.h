@@ -0,0 +1,96 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  benchmark_support.h
+* @brief Command line parsing and instance/device setup shared by the benchmark tools.
+*
+* The benchmarks are plain Vulkan applications which go through the loader.  Each one derives its own context from
+* DeviceContext, creates it with the functions below and adds the objects its measurements need.
+***********************************************************************************************************************
+*/
+#pragma once
+
+#include "vulkan.h"
+
+#include <cstdint>
+
+namespace bench
+{
+
+// Kinds of command line arguments
+enum class ArgType : uint32_t
+{
+    Uint,       // "--name <n>" into a uint32_t, which must be greater than zero
+    Flag,       // "--name" sets a bool
+    String,     // "--name <value>" into a const char*
+};
+
+// One command line argument.  An argument without a name is positional; it is a String and must be given.
+struct ArgDesc
+{
+    const char* pName;
+    ArgType     type;
+    void*       pValue;     // uint32_t*, bool* or const char** depending on type
+};
+
+// The instance, device and queue a benchmark runs on
+struct DeviceContext
+{
+    VkInstance       instance;
+    VkPhysicalDevice physicalDevice;
+    VkDevice         device;
+    VkQueue          queue;
+    uint32_t         queueFamilyIndex;
+};
+
+// Prints an error for a failed Vulkan call and returns whether the call succeeded.
+bool Check(VkResult result, const char* pWhat);
+
+// Parses the command line into the given arguments, which keep their values if not given.  Prints the usage and
+// returns false if an argument is not recognized or invalid.
+bool ParseArgs(int argc, char** argv, const ArgDesc* pArgs, uint32_t argCount, const char* pUsage);
+
+// Creates the instance.
+bool CreateInstance(const char* pAppName, uint32_t apiVersion, DeviceContext* pContext);
+
+// Picks the first physical device and its first queue family which supports all of queueFlags.
+bool SelectPhysicalDevice(VkQueueFlags queueFlags, DeviceContext* pContext);
+
+// Creates the device with one queue of the selected family and gets the queue.
+bool CreateDevice(const void* pNext, const VkPhysicalDeviceFeatures* pFeatures, DeviceContext* pContext);
+
+// Creates the instance and the device in one go, at API version 1.2.
+bool CreateContext(
+    const char*                     pAppName,
+    VkQueueFlags                    queueFlags,
+    const void*                     pNext,
+    const VkPhysicalDeviceFeatures* pFeatures,
+    DeviceContext*                  pContext);
+
+// Destroys the device and the instance.  Safe to call on a partially created context.
+void DestroyContext(DeviceContext* pContext);
+
+} // namespace bench
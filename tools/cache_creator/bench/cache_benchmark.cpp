@@ -0,0 +1,372 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Google LLC. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+
+// =====================================================================================================================
+//
+// Benchmarks the pipeline cache building blocks on synthetic caches of configurable size:
+// -  serializing entries into a cache blob (PipelineBinaryCacheSerializer, used by PipelineBinaryCache::Serialize),
+// -  validating a blob (the content hash recomputed by PipelineBinaryCache::IsValidBlob, and the entry layout walk of
+//    PipelineBinaryCache::IsValidBlobLayout),
+// -  loading the entries of a blob into a PAL memory cache layer, as done for the initial data of a cache,
+// -  sequential and random lookup latency in the memory layer,
+// -  merging one memory layer into another (PipelineBinaryCache::Merge).
+//
+// PipelineBinaryCache itself depends on the whole ICD, so the benchmark drives the same serializer, hash, and PAL
+// cache layer code directly. Results are printed one per line as `<phase>: <metric>` to make them easy to compare
+// between runs.
+//
+// =====================================================================================================================
+
+#include "cache_creator.h"
+#include "cache_info.h"
+#include "palCacheLayer.h"
+#include "palPlatformKey.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+#include <sys/resource.h>
+
+namespace {
+llvm::cl::OptionCategory CacheBenchmarkCat("Cache Benchmark Options");
+
+llvm::cl::opt<unsigned> NumEntries("entries", llvm::cl::desc("Number of cache entries"), llvm::cl::init(10000),
+                                   llvm::cl::value_desc("number"), llvm::cl::cat(CacheBenchmarkCat));
+llvm::cl::opt<unsigned> EntrySize("entry-size", llvm::cl::desc("Size of each cache entry in bytes"),
+                                  llvm::cl::init(16 * 1024), llvm::cl::value_desc("bytes"),
+                                  llvm::cl::cat(CacheBenchmarkCat));
+llvm::cl::opt<unsigned> NumLookups("lookups", llvm::cl::desc("Number of lookups for each lookup pattern"),
+                                   llvm::cl::init(100000), llvm::cl::value_desc("number"),
+                                   llvm::cl::cat(CacheBenchmarkCat));
+llvm::cl::opt<bool> Compress("compress", llvm::cl::desc("Store the serialized entries LZ4-compressed"),
+                             llvm::cl::init(false), llvm::cl::cat(CacheBenchmarkCat));
+llvm::cl::opt<unsigned> Seed("seed", llvm::cl::desc("Seed for the entry contents and the random lookup order"),
+                             llvm::cl::init(1), llvm::cl::value_desc("number"), llvm::cl::cat(CacheBenchmarkCat));
+
+using Clock = std::chrono::steady_clock;
+
+// =====================================================================================================================
+// Returns the seconds elapsed since `start`.
+//
+// @param start : Start time
+// @returns : Elapsed time in seconds
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// =====================================================================================================================
+// Prints the throughput of a phase which processed `bytes` in `seconds`.
+//
+// @param phase : Name of the benchmark phase
+// @param bytes : Bytes processed
+// @param seconds : Time taken
+void printThroughput(llvm::StringRef phase, size_t bytes, double seconds) {
+  llvm::outs() << phase << ": " << llvm::format("%.3f ms, %.1f MiB/s", seconds * 1000.0,
+                                                double(bytes) / (1024.0 * 1024.0) / std::max(seconds, 1e-9))
+               << "\n";
+}
+
+// =====================================================================================================================
+// Prints the peak resident set size of the process so far.
+//
+// @param phase : Name of the last finished benchmark phase
+void printPeakMemory(llvm::StringRef phase) {
+  rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+  llvm::outs() << phase << " peak RSS: " << (usage.ru_maxrss / 1024) << " MiB\n";
+}
+
+void *PAL_STDCALL benchmarkAlloc(void *, size_t size, size_t alignment, Util::SystemAllocType) {
+  void *mem = nullptr;
+  return posix_memalign(&mem, std::max(alignment, sizeof(void *)), size) == 0 ? mem : nullptr;
+}
+
+void PAL_STDCALL benchmarkFree(void *, void *mem) {
+  free(mem);
+}
+
+// Owning pointer to a PAL cache layer created in caller-provided memory.
+struct CacheLayerDeleter {
+  void operator()(Util::ICacheLayer *layer) {
+    void *mem = layer;
+    layer->Destroy();
+    free(mem);
+  }
+};
+using CacheLayerPtr = std::unique_ptr<Util::ICacheLayer, CacheLayerDeleter>;
+
+// =====================================================================================================================
+// Creates a memory cache layer configured like the memory layer of PipelineBinaryCache.
+//
+// @param callbacks : Allocation callbacks for the layer's entries
+// @returns : The layer, or nullptr on failure
+CacheLayerPtr createMemoryLayer(Util::AllocCallbacks &callbacks) {
+  Util::MemoryCacheCreateInfo createInfo = {};
+  createInfo.baseInfo.pCallbacks = &callbacks;
+  createInfo.maxObjectCount = SIZE_MAX;
+  createInfo.maxMemorySize = SIZE_MAX;
+  createInfo.evictOnFull = true;
+  createInfo.evictDuplicates = true;
+
+  void *mem = benchmarkAlloc(nullptr, Util::GetMemoryCacheLayerSize(&createInfo), 16, Util::SystemAllocType{});
+  Util::ICacheLayer *layer = nullptr;
+  if (!mem || Util::CreateMemoryCacheLayer(&createInfo, mem, &layer) != Util::Result::Success) {
+    free(mem);
+    return nullptr;
+  }
+  return CacheLayerPtr(layer);
+}
+
+// =====================================================================================================================
+// Returns the cache ID of the synthetic entry with the given index.
+//
+// @param idx : Entry index
+// @returns : Cache ID of the entry
+Util::MetroHash::Hash getEntryId(size_t idx) {
+  Util::MetroHash::Hash id = {};
+  id.qwords[0] = idx + 1;
+  id.qwords[1] = (idx + 1) * 0x9e3779b97f4a7c15ull;
+  return id;
+}
+
+// =====================================================================================================================
+// Measures the latency of `numLookups` lookups, each querying an entry and loading its data.
+//
+// @param phase : Name of the benchmark phase
+// @param layer : Layer to look the entries up in
+// @param order : Entry indices, looked up in this order and wrapped around if shorter than `numLookups`
+// @returns : False if any lookup missed
+bool benchmarkLookups(llvm::StringRef phase, Util::ICacheLayer &layer, llvm::ArrayRef<size_t> order) {
+  std::vector<uint8_t> loadBuffer(EntrySize);
+  std::vector<double> latencies;
+  latencies.reserve(NumLookups);
+
+  for (unsigned i = 0; i != NumLookups; ++i) {
+    const Util::MetroHash::Hash id = getEntryId(order[i % order.size()]);
+    const Clock::time_point start = Clock::now();
+    Util::QueryResult query = {};
+    if (layer.Query(&id, 0, 0, &query) != Util::Result::Success || query.dataSize > loadBuffer.size() ||
+        layer.Load(&query, loadBuffer.data()) != Util::Result::Success)
+      return false;
+    latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  const double average = std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+  llvm::outs() << phase << ": "
+               << llvm::format("avg %.0f ns, p50 %.0f ns, p99 %.0f ns", average, latencies[latencies.size() / 2],
+                               latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)])
+               << "\n";
+  return true;
+}
+
+int reportError(llvm::Error err) {
+  llvm::errs() << "Error:\t" << err << "\n";
+  llvm::consumeError(std::move(err));
+  return 4;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  llvm::cl::ParseCommandLineOptions(argc, argv);
+  if (NumEntries == 0 || EntrySize == 0 || NumLookups == 0) {
+    llvm::errs() << "--entries, --entry-size, and --lookups must be greater than 0\n";
+    return 2;
+  }
+
+  llvm::outs() << "Entries: " << NumEntries << ", entry size: " << EntrySize << " B, compression: "
+               << (Compress ? "on" : "off") << "\n";
+
+  // Entry contents: a repeating random pattern, so that compression has something to work with without making every
+  // entry trivially compressible.
+  std::mt19937_64 rng(Seed);
+  std::vector<uint8_t> pattern(4096);
+  std::generate(pattern.begin(), pattern.end(), [&rng] { return uint8_t(rng() % 64); });
+  std::vector<uint8_t> entryData(EntrySize);
+  auto fillEntry = [&](size_t idx) {
+    for (size_t i = 0; i < entryData.size(); ++i)
+      entryData[i] = pattern[(i + idx * 7) % pattern.size()];
+    std::memcpy(entryData.data(), &idx, std::min(sizeof(idx), entryData.size()));
+  };
+
+  // Serialize: build a cache blob with all entries.
+  const llvm::SmallVector<size_t> entrySizes(NumEntries, EntrySize);
+  std::vector<uint8_t> blob(cc::RelocatableCacheCreator::CalculateAnticipatedCacheFileSize(entrySizes));
+  const std::array<uint8_t, VK_UUID_SIZE> uuid = {};
+  size_t blobSize = 0;
+  {
+    auto creatorOrErr = cc::RelocatableCacheCreator::Create(0, uuid, {}, blob, Compress);
+    if (auto err = creatorOrErr.takeError())
+      return reportError(std::move(err));
+
+    double seconds = 0.0;
+    for (size_t idx = 0; idx != NumEntries; ++idx) {
+      fillEntry(idx);
+      vk::BinaryCacheEntry entry = {};
+      entry.hashId = getEntryId(idx);
+      entry.dataSize = entryData.size();
+      llvm::MemoryBufferRef entryBuffer(llvm::toStringRef(entryData), "entry");
+
+      const Clock::time_point start = Clock::now();
+      if (auto err = creatorOrErr->addParsedElf(entry, entryBuffer))
+        return reportError(std::move(err));
+      seconds += secondsSince(start);
+    }
+
+    const Clock::time_point start = Clock::now();
+    if (auto err = creatorOrErr->finalize(nullptr, &blobSize))
+      return reportError(std::move(err));
+    seconds += secondsSince(start);
+    printThroughput("serialize", size_t(NumEntries) * EntrySize, seconds);
+  }
+  blob.resize(blobSize);
+  llvm::outs() << "blob size: " << blobSize << " B\n";
+  printPeakMemory("serialize");
+
+  // Validate: recompute the content hash, then walk the entry headers.
+  VkAllocationCallbacks &vkCallbacks = cc::getDefaultAllocCallbacks();
+  const size_t privateBlobOffset = vk::VkPipelineCacheHeaderDataSize;
+  const size_t contentOffset = privateBlobOffset + sizeof(vk::PipelineBinaryCachePrivateHeader);
+  {
+    const Util::HashAlgorithm hashAlgo = Util::HashAlgorithm::Sha1;
+    std::unique_ptr<void, cc::AllocCallbacksDeleter> keyMem(
+        vkCallbacks.pfnAllocation(vkCallbacks.pUserData, Util::GetPlatformKeySize(hashAlgo), 16,
+                                  VK_SYSTEM_ALLOCATION_SCOPE_OBJECT),
+        {vkCallbacks});
+    Util::IPlatformKey *key = nullptr;
+    if (!keyMem || Util::CreatePlatformKey(hashAlgo, nullptr, 0, keyMem.get(), &key) != Util::Result::Success) {
+      llvm::errs() << "Failed to create platform key\n";
+      return 4;
+    }
+
+    const Clock::time_point start = Clock::now();
+    vk::PipelineBinaryCachePrivateHeader header = {};
+    const Util::Result result = vk::CalculatePipelineBinaryCacheHashId(
+        &vkCallbacks, key, blob.data() + contentOffset, blob.size() - contentOffset, header.hashId);
+    const double seconds = secondsSince(start);
+    key->Destroy();
+    if (result != Util::Result::Success ||
+        std::memcmp(header.hashId, blob.data() + privateBlobOffset, sizeof(header.hashId)) != 0) {
+      llvm::errs() << "The serialized blob failed validation\n";
+      return 4;
+    }
+    printThroughput("validate hash", blob.size() - contentOffset, seconds);
+  }
+
+  auto blobBuffer = llvm::MemoryBuffer::getMemBuffer(llvm::toStringRef(blob), "benchmark_blob", false);
+  auto blobInfoOrErr = cc::CacheBlobInfo::create(*blobBuffer);
+  if (auto err = blobInfoOrErr.takeError())
+    return reportError(std::move(err));
+
+  llvm::SmallVector<cc::BinaryCacheEntryInfo, 0> entries;
+  entries.reserve(NumEntries);
+  {
+    const Clock::time_point start = Clock::now();
+    if (auto err = blobInfoOrErr->readBinaryCacheEntriesInfo(entries, /* computeMD5Sums = */ false))
+      return reportError(std::move(err));
+    printThroughput("validate layout", blob.size() - contentOffset, secondsSince(start));
+  }
+
+  // Load: insert the entries of the blob into a memory layer, decompressing them if needed.
+  Util::AllocCallbacks palCallbacks = {nullptr, benchmarkAlloc, benchmarkFree};
+  CacheLayerPtr memoryLayer = createMemoryLayer(palCallbacks);
+  if (!memoryLayer) {
+    llvm::errs() << "Failed to create a memory cache layer\n";
+    return 4;
+  }
+  {
+    std::vector<uint8_t> decompressed(EntrySize);
+    const Clock::time_point start = Clock::now();
+    for (const cc::BinaryCacheEntryInfo &entry : entries) {
+      const void *data = entry.entryBlob.data();
+      size_t dataSize = entry.entryBlob.size();
+      if (entry.isCompressed) {
+        decompressed.resize(entry.decompressedSize);
+        if (vk::DecompressBinaryCacheEntry(entry.entryHeader, data, decompressed.size(), decompressed.data()) !=
+            Util::Result::Success) {
+          llvm::errs() << "Failed to decompress entry " << entry.idx << "\n";
+          return 4;
+        }
+        data = decompressed.data();
+        dataSize = decompressed.size();
+      }
+      if (memoryLayer->Store(&entry.entryHeader->hashId, data, dataSize) != Util::Result::Success) {
+        llvm::errs() << "Failed to store entry " << entry.idx << "\n";
+        return 4;
+      }
+    }
+    printThroughput("load", size_t(NumEntries) * EntrySize, secondsSince(start));
+  }
+  printPeakMemory("load");
+
+  // Lookup: sequential and random entry order.
+  std::vector<size_t> order(NumEntries);
+  std::iota(order.begin(), order.end(), 0);
+  if (!benchmarkLookups("sequential lookup", *memoryLayer, order)) {
+    llvm::errs() << "Sequential lookup missed an entry\n";
+    return 4;
+  }
+  std::shuffle(order.begin(), order.end(), rng);
+  if (!benchmarkLookups("random lookup", *memoryLayer, order)) {
+    llvm::errs() << "Random lookup missed an entry\n";
+    return 4;
+  }
+
+  // Merge: copy every entry of the loaded layer into an empty one.
+  CacheLayerPtr mergedLayer = createMemoryLayer(palCallbacks);
+  if (!mergedLayer) {
+    llvm::errs() << "Failed to create a memory cache layer\n";
+    return 4;
+  }
+  {
+    const Clock::time_point start = Clock::now();
+    for (size_t idx = 0; idx != NumEntries; ++idx) {
+      const Util::MetroHash::Hash id = getEntryId(idx);
+      Util::QueryResult query = {};
+      const void *data = nullptr;
+      if (memoryLayer->Query(&id, 0, Util::ICacheLayer::QueryFlags::AcquireEntryRef, &query) !=
+              Util::Result::Success ||
+          memoryLayer->GetCacheData(&query, &data) != Util::Result::Success ||
+          mergedLayer->Store(&id, data, query.dataSize) != Util::Result::Success) {
+        llvm::errs() << "Failed to merge entry " << idx << "\n";
+        return 4;
+      }
+      memoryLayer->ReleaseCacheRef(&query);
+    }
+    printThroughput("merge", size_t(NumEntries) * EntrySize, secondsSince(start));
+  }
+  printPeakMemory("merge");
+
+  return 0;
+}
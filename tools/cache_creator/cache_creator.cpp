@@ -31,6 +31,7 @@
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Regex.h"
 #include "llvm/Support/raw_ostream.h"
+#include <array>
 #include <cassert>
 #include <cinttypes>
 #include <numeric>
@@ -103,6 +104,10 @@ void AllocCallbacksDeleter::operator()(void *mem) {
   m_callbacks->pfnFree(m_callbacks->pUserData, mem);
 }
 
+void HashContextDestroyer::operator()(Util::IHashContext *context) {
+  context->Destroy();
+}
+
 static bool isValidHexUUIDStr(llvm::StringRef hexStr) {
   // Sample valid UUID string: 12345678-abcd-ef00-ffff-0123456789ab,
   // see: https://en.wikipedia.org/wiki/Universally_unique_identifier.
@@ -234,11 +239,11 @@ llvm::Expected<ElfLlpcCacheInfo> getCacheInfoFromMetadataBlob(llvm::StringRef no
 }
 
 // =====================================================================================================================
-// Tries to extract cache hash and LLPC version from the elf file.
+// Finds the PAL metadata note (NT_AMDGPU_METADATA) of an elf file.
 //
 // @param elfBuffer : The input elf
-// @returns : The hash found on success, or error on failure
-llvm::Expected<ElfLlpcCacheInfo> getElfLlpcCacheInfo(llvm::MemoryBufferRef elfBuffer) {
+// @returns : The msgpack blob of the note on success, or error on failure. The blob points into `elfBuffer`
+llvm::Expected<llvm::StringRef> getElfPalMetadataBlob(llvm::MemoryBufferRef elfBuffer) {
   auto elfObjectOrErr = llvm::object::ELF64LEObjectFile::create(elfBuffer);
   if (auto err = elfObjectOrErr.takeError())
     return std::move(err);
@@ -269,12 +274,24 @@ llvm::Expected<ElfLlpcCacheInfo> getElfLlpcCacheInfo(llvm::MemoryBufferRef elfBu
 
     for (const ElfFileTy::Elf_Note &note : noteRange) {
       if (note.getType() == llvm::ELF::NT_AMDGPU_METADATA)
-        return getCacheInfoFromMetadataBlob(note.getDescAsStringRef());
+        return note.getDescAsStringRef();
     }
   }
 
-  return llvm::createStringError(llvm::object::object_error::invalid_file_type,
-                                 "Could not find shader/pipeline elf hash");
+  return llvm::createStringError(llvm::object::object_error::invalid_file_type, "Could not find PAL metadata");
+}
+
+// =====================================================================================================================
+// Tries to extract cache hash and LLPC version from the elf file.
+//
+// @param elfBuffer : The input elf
+// @returns : The hash found on success, or error on failure
+llvm::Expected<ElfLlpcCacheInfo> getElfLlpcCacheInfo(llvm::MemoryBufferRef elfBuffer) {
+  auto noteBlobOrErr = getElfPalMetadataBlob(elfBuffer);
+  if (auto err = noteBlobOrErr.takeError())
+    return std::move(err);
+
+  return getCacheInfoFromMetadataBlob(*noteBlobOrErr);
 }
 
 // =====================================================================================================================
@@ -298,24 +315,19 @@ size_t RelocatableCacheCreator::CalculateAnticipatedCacheFileSize(llvm::ArrayRef
 // @param fingerprint : Initial data used to initialize the platform key. This should include information about the
 //                      target GPU and the driver/compiler stack used to construct the cache and later consume it.
 // @param [in/out] outputBuffer : Memory buffer where the pipeline cache data will be written
+// @param compressEntries : Store entries LZ4-compressed whenever that makes them smaller. The final cache size may then
+//                          be less than the anticipated size.
 // @returns : A RelocatableCacheCreator object on success, error when initialization failures
 llvm::Expected<RelocatableCacheCreator> RelocatableCacheCreator::Create(uint32_t deviceId, llvm::ArrayRef<uint8_t> uuid,
                                                                         llvm::ArrayRef<uint8_t> fingerprint,
-                                                                        llvm::MutableArrayRef<uint8_t> outputBuffer) {
+                                                                        llvm::MutableArrayRef<uint8_t> outputBuffer,
+                                                                        bool compressEntries) {
   VkAllocationCallbacks &callbacks = cc::getDefaultAllocCallbacks();
 
-  const Util::HashAlgorithm hashAlgo = Util::HashAlgorithm::Sha1;
-  const size_t keyMemSize = Util::GetPlatformKeySize(hashAlgo);
-  void *keyMem = callbacks.pfnAllocation(callbacks.pUserData, keyMemSize, 16, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
-  assert(keyMem);
-
-  uint8_t *initialData = fingerprint.empty() ? nullptr : const_cast<uint8_t *>(fingerprint.data());
-  Util::IPlatformKey *key = nullptr;
-  if (Util::CreatePlatformKey(hashAlgo, initialData, fingerprint.size(), keyMem, &key) != Util::Result::Success)
-    return llvm::createStringError(std::errc::state_not_recoverable, "Failed to create platform key");
-
-  assert(key);
-  std::unique_ptr<Util::IPlatformKey, AllocCallbacksDeleter> managedKey(key, {callbacks});
+  auto managedKeyOrErr = createPlatformKey(fingerprint, callbacks);
+  if (auto err = managedKeyOrErr.takeError())
+    return std::move(err);
+  std::unique_ptr<Util::IPlatformKey, AllocCallbacksDeleter> managedKey = std::move(*managedKeyOrErr);
 
   size_t vkHeaderBytes = 0;
   if (vk::WriteVkPipelineCacheHeaderData(outputBuffer.data(), outputBuffer.size(), cc::AMDVendorId, deviceId,
@@ -328,7 +340,7 @@ llvm::Expected<RelocatableCacheCreator> RelocatableCacheCreator::Create(uint32_t
   auto serializer = std::make_unique<vk::PipelineBinaryCacheSerializer>();
   assert(serializer);
 
-  if (serializer->Initialize(privateCacheData.size(), privateCacheData.data()) != Util::Result::Success)
+  if (serializer->Initialize(privateCacheData.size(), privateCacheData.data(), compressEntries) != Util::Result::Success)
     return llvm::createStringError(std::errc::state_not_recoverable,
                                    "Failed to initialize PipelineBinaryCacheSerializer");
 
@@ -336,11 +348,126 @@ llvm::Expected<RelocatableCacheCreator> RelocatableCacheCreator::Create(uint32_t
 }
 
 // =====================================================================================================================
-// Adds a new cache entry with the provided elf file.
+// Initializes a RelocatableCacheCreator object which writes the cache to a stream as entries are added. Only the entry
+// being added is kept in memory. The private header is written as a placeholder and patched by finalize, so the stream
+// has to support pwrite.
+//
+// @param deviceId : The device identifier of the target GPU
+// @param uuid : Pipeline cache UUID in the binary format
+// @param fingerprint : Initial data used to initialize the platform key, see Create
+// @param [in/out] outputStream : Stream where the pipeline cache data will be written, starting at its current position
+// @param compressEntries : Store entries LZ4-compressed whenever that makes them smaller
+// @returns : A RelocatableCacheCreator object on success, error when initialization failures
+llvm::Expected<RelocatableCacheCreator>
+RelocatableCacheCreator::CreateStreaming(uint32_t deviceId, llvm::ArrayRef<uint8_t> uuid,
+                                         llvm::ArrayRef<uint8_t> fingerprint, llvm::raw_pwrite_stream &outputStream,
+                                         bool compressEntries) {
+  VkAllocationCallbacks &callbacks = cc::getDefaultAllocCallbacks();
+
+  auto managedKeyOrErr = createPlatformKey(fingerprint, callbacks);
+  if (auto err = managedKeyOrErr.takeError())
+    return std::move(err);
+  std::unique_ptr<Util::IPlatformKey, AllocCallbacksDeleter> managedKey = std::move(*managedKeyOrErr);
+
+  // The content hash is computed the same way as by PipelineBinaryCacheSerializer::Finalize, just incrementally.
+  Util::IHashContext *keyContext = managedKey->GetKeyContext();
+  const size_t contextMemSize = keyContext->GetDuplicateObjectSize();
+  std::unique_ptr<void, AllocCallbacksDeleter> contextMem(
+      callbacks.pfnAllocation(callbacks.pUserData, contextMemSize, 16, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT), {callbacks});
+  Util::IHashContext *context = nullptr;
+  if (!contextMem || keyContext->Duplicate(contextMem.get(), &context) != Util::Result::Success)
+    return llvm::createStringError(std::errc::state_not_recoverable, "Failed to create cache hash context");
+
+  std::array<uint8_t, vk::VkPipelineCacheHeaderDataSize + sizeof(vk::PipelineBinaryCachePrivateHeader)> headers = {};
+  size_t vkHeaderBytes = 0;
+  if (vk::WriteVkPipelineCacheHeaderData(headers.data(), headers.size(), cc::AMDVendorId, deviceId,
+                                         const_cast<uint8_t *>(uuid.data()), uuid.size(),
+                                         &vkHeaderBytes) != Util::Result::Success)
+    return llvm::createStringError(std::errc::state_not_recoverable, "Failed to write Vulkan Pipeline Cache header");
+  assert(vkHeaderBytes == vk::VkPipelineCacheHeaderDataSize);
+
+  const uint64_t streamStartOffset = outputStream.tell();
+  outputStream.write(reinterpret_cast<const char *>(headers.data()), headers.size());
+
+  RelocatableCacheCreator creator(std::move(managedKey), std::make_unique<vk::PipelineBinaryCacheSerializer>(), {},
+                                  callbacks);
+  creator.m_outputStream = &outputStream;
+  creator.m_streamStartOffset = streamStartOffset;
+  creator.m_hashContextMem = std::move(contextMem);
+  creator.m_hashContext.reset(context);
+  creator.m_compressEntries = compressEntries;
+  return std::move(creator);
+}
+
+// =====================================================================================================================
+// Creates the platform key used to compute the cache content hash.
+//
+// @param fingerprint : Initial data used to initialize the platform key
+// @param callbacks : Allocation callbacks for the key memory
+// @returns : The platform key on success, error on failure
+llvm::Expected<std::unique_ptr<Util::IPlatformKey, AllocCallbacksDeleter>>
+RelocatableCacheCreator::createPlatformKey(llvm::ArrayRef<uint8_t> fingerprint, VkAllocationCallbacks &callbacks) {
+  const Util::HashAlgorithm hashAlgo = Util::HashAlgorithm::Sha1;
+  const size_t keyMemSize = Util::GetPlatformKeySize(hashAlgo);
+  void *keyMem = callbacks.pfnAllocation(callbacks.pUserData, keyMemSize, 16, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+  assert(keyMem);
+
+  uint8_t *initialData = fingerprint.empty() ? nullptr : const_cast<uint8_t *>(fingerprint.data());
+  Util::IPlatformKey *key = nullptr;
+  if (Util::CreatePlatformKey(hashAlgo, initialData, fingerprint.size(), keyMem, &key) != Util::Result::Success) {
+    callbacks.pfnFree(callbacks.pUserData, keyMem);
+    return llvm::createStringError(std::errc::state_not_recoverable, "Failed to create platform key");
+  }
+
+  assert(key);
+  return std::unique_ptr<Util::IPlatformKey, AllocCallbacksDeleter>(key, {callbacks});
+}
+
+// =====================================================================================================================
+// Points the serializer at a scratch buffer large enough for one entry with `storedSize` bytes of data.
+//
+// @param storedSize : Size of the entry data
+// @returns : Error if the serializer can't be initialized, or success
+llvm::Error RelocatableCacheCreator::prepareStreamedEntry(size_t storedSize) {
+  constexpr size_t headerSize = sizeof(vk::PipelineBinaryCachePrivateHeader);
+  const size_t requiredSize = headerSize + sizeof(vk::BinaryCacheEntry) + storedSize;
+  if (m_entryScratch.size() < requiredSize)
+    m_entryScratch.resize(requiredSize);
+
+  if (m_serializer->InitializeAppend(m_entryScratch.size(), m_entryScratch.data(), headerSize, m_compressEntries) !=
+      Util::Result::Success)
+    return llvm::createStringError(std::errc::state_not_recoverable,
+                                   "Failed to initialize PipelineBinaryCacheSerializer");
+
+  return llvm::Error::success();
+}
+
+// =====================================================================================================================
+// Writes the entry last added to the serializer to the output stream and adds it to the cache content hash.
+//
+// @returns : Error if the entry can't be hashed, or success
+llvm::Error RelocatableCacheCreator::flushStreamedEntry() {
+  constexpr size_t headerSize = sizeof(vk::PipelineBinaryCachePrivateHeader);
+  const size_t entryBytes = m_serializer->GetBytesUsed() - headerSize;
+  const uint8_t *entryData = m_entryScratch.data() + headerSize;
+
+  if (m_hashContext->AddData(entryData, entryBytes) != Util::Result::Success)
+    return llvm::createStringError(std::errc::state_not_recoverable, "Failed to hash cache entry");
+
+  m_outputStream->write(reinterpret_cast<const char *>(entryData), entryBytes);
+  m_streamedContentSize += entryBytes;
+  ++m_numStreamedEntries;
+  return llvm::Error::success();
+}
+
+// =====================================================================================================================
+// Parses the provided elf file and creates the cache entry header for it. Doesn't modify any state, so it may be called
+// concurrently from multiple threads.
 //
 // @param elfBuffer : Buffer with a relocatable shader elf compiled with LLPC
-// @returns : Error if it's not possible to process the elf or append it to the output buffer, or success
-llvm::Error RelocatableCacheCreator::addElf(llvm::MemoryBufferRef elfBuffer) {
+// @returns : The cache entry header on success, or error if the elf can't be processed or was built by an incompatible
+//            LLPC version
+llvm::Expected<vk::BinaryCacheEntry> RelocatableCacheCreator::parseElf(llvm::MemoryBufferRef elfBuffer) {
   auto elfLlpcInfoOrErr = cc::getElfLlpcCacheInfo(elfBuffer);
   if (auto err = elfLlpcInfoOrErr.takeError())
     return llvm::createFileError(elfBuffer.getBufferIdentifier(), std::move(err));
@@ -358,12 +485,64 @@ llvm::Error RelocatableCacheCreator::addElf(llvm::MemoryBufferRef elfBuffer) {
             elfLlpcInfoOrErr->llpcVersion.getAsString().c_str(), llpcBuildVersion.getAsString().c_str()));
   }
 
+  return entry;
+}
+
+// =====================================================================================================================
+// Adds a new cache entry with the provided elf file.
+//
+// @param elfBuffer : Buffer with a relocatable shader elf compiled with LLPC
+// @returns : Error if it's not possible to process the elf or append it to the output buffer, or success
+llvm::Error RelocatableCacheCreator::addElf(llvm::MemoryBufferRef elfBuffer) {
+  auto entryOrErr = parseElf(elfBuffer);
+  if (auto err = entryOrErr.takeError())
+    return std::move(err);
+
+  return addParsedElf(*entryOrErr, elfBuffer);
+}
+
+// =====================================================================================================================
+// Adds a new cache entry for an elf file previously parsed with parseElf.
+//
+// @param entry : The cache entry header returned by parseElf
+// @param elfBuffer : Buffer with the elf passed to parseElf
+// @returns : Error if it's not possible to append the elf to the output buffer, or success
+llvm::Error RelocatableCacheCreator::addParsedElf(const vk::BinaryCacheEntry &entry, llvm::MemoryBufferRef elfBuffer) {
+  assert(entry.dataSize == elfBuffer.getBufferSize());
+
+  if (isStreaming()) {
+    if (auto err = prepareStreamedEntry(entry.dataSize))
+      return err;
+  }
+
   if (m_serializer->AddPipelineBinary(&entry, elfBuffer.getBufferStart()) != Util::Result::Success)
     return llvm::createFileError(
         elfBuffer.getBufferIdentifier(),
         llvm::createStringError(std::errc::state_not_recoverable, "Failed to add cache entry"));
 
-  return llvm::Error::success();
+  return isStreaming() ? flushStreamedEntry() : llvm::Error::success();
+}
+
+// =====================================================================================================================
+// Copies an entry of an existing cache blob into the new cache, as stored. Compressed entries stay compressed and the
+// `compressEntries` setting doesn't apply to them.
+//
+// @param entry : The entry header read from the existing cache blob
+// @param storedData : The entry data following the header in the existing cache blob
+// @returns : Error if it's not possible to append the entry to the output buffer, or success
+llvm::Error RelocatableCacheCreator::addStoredEntry(const vk::BinaryCacheEntry &entry,
+                                                    llvm::ArrayRef<uint8_t> storedData) {
+  assert(vk::GetBinaryCacheEntryStoredSize(entry) == storedData.size());
+
+  if (isStreaming()) {
+    if (auto err = prepareStreamedEntry(storedData.size()))
+      return err;
+  }
+
+  if (m_serializer->AddStoredPipelineBinary(&entry, storedData.data()) != Util::Result::Success)
+    return llvm::createStringError(std::errc::state_not_recoverable, "Failed to copy cache entry");
+
+  return isStreaming() ? flushStreamedEntry() : llvm::Error::success();
 }
 
 // =====================================================================================================================
@@ -373,6 +552,23 @@ llvm::Error RelocatableCacheCreator::addElf(llvm::MemoryBufferRef elfBuffer) {
 // @param [out] outTotalSize: (Optional) Variable to store the final cache blob size
 // @returns : Error if it's not possible to finish cache serialization, or success.
 llvm::Error RelocatableCacheCreator::finalize(size_t *outTotalNumEntries, size_t *outTotalSize) {
+  if (isStreaming()) {
+    // Every entry is already in the stream; only the private header with the content hash is left to patch.
+    vk::PipelineBinaryCachePrivateHeader privateHeader = {};
+    if (m_hashContext->Finish(privateHeader.hashId) != Util::Result::Success)
+      return llvm::createStringError(std::errc::state_not_recoverable, "Failed to serialize cache");
+
+    m_outputStream->pwrite(reinterpret_cast<const char *>(&privateHeader), sizeof(privateHeader),
+                           m_streamStartOffset + vk::VkPipelineCacheHeaderDataSize);
+
+    if (outTotalNumEntries)
+      *outTotalNumEntries = m_numStreamedEntries;
+    if (outTotalSize)
+      *outTotalSize = vk::VkPipelineCacheHeaderDataSize + sizeof(privateHeader) + m_streamedContentSize;
+
+    return llvm::Error::success();
+  }
+
   size_t actualNumEntries = 0;
   size_t actualCacheSize = 0;
   if (m_serializer->Finalize(m_callbacks, m_platformKey.get(), &actualNumEntries, &actualCacheSize) !=
@@ -38,6 +38,13 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/MemoryBufferRef.h"
 #include "llvm/Support/VersionTuple.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <vector>
+
+namespace Util {
+class IHashContext;
+} // namespace Util
 
 namespace cc {
 
@@ -59,6 +66,12 @@ private:
   VkAllocationCallbacks *m_callbacks;
 };
 
+// Deleter class for PAL hash contexts duplicated into memory allocated with VkAllocationCallbacks. Only destroys the
+// context; the memory itself is released separately.
+struct HashContextDestroyer {
+  void operator()(Util::IHashContext *context);
+};
+
 constexpr size_t UuidLength = 36;
 using UuidString = llvm::SmallString<UuidLength>;
 
@@ -76,17 +89,27 @@ struct ElfLlpcCacheInfo {
 // Tries to extract cache hash and LLPC version from a PAL metadata note blob.
 llvm::Expected<ElfLlpcCacheInfo> getCacheInfoFromMetadataBlob(llvm::StringRef noteBlob);
 
+// Finds the PAL metadata note blob of the elf file.
+llvm::Expected<llvm::StringRef> getElfPalMetadataBlob(llvm::MemoryBufferRef elfBuffer);
+
 // Tries to extract cache hash and LLPC version from the elf file.
 llvm::Expected<ElfLlpcCacheInfo> getElfLlpcCacheInfo(llvm::MemoryBufferRef elfBuffer);
 
 // Creates portable PipelineBinaryCache files from relocatable LLPC elf files.
+// The cache is either serialized into a preallocated buffer large enough for the whole cache, or streamed to an output
+// stream one entry at a time, so that memory use doesn't grow with the size of the cache.
 // This class is moveable but not copyable.
 class RelocatableCacheCreator {
 public:
   static size_t CalculateAnticipatedCacheFileSize(llvm::ArrayRef<size_t> inputElfSizes);
   static llvm::Expected<RelocatableCacheCreator> Create(uint32_t deviceId, llvm::ArrayRef<uint8_t> uuid,
                                                         llvm::ArrayRef<uint8_t> fingerprint,
-                                                        llvm::MutableArrayRef<uint8_t> outputBuffer);
+                                                        llvm::MutableArrayRef<uint8_t> outputBuffer,
+                                                        bool compressEntries = false);
+  static llvm::Expected<RelocatableCacheCreator> CreateStreaming(uint32_t deviceId, llvm::ArrayRef<uint8_t> uuid,
+                                                                 llvm::ArrayRef<uint8_t> fingerprint,
+                                                                 llvm::raw_pwrite_stream &outputStream,
+                                                                 bool compressEntries = false);
 
   RelocatableCacheCreator() = delete;
   RelocatableCacheCreator(const RelocatableCacheCreator &) = delete;
@@ -95,7 +118,13 @@ public:
   RelocatableCacheCreator(RelocatableCacheCreator &&) = default;
   RelocatableCacheCreator &operator=(RelocatableCacheCreator &&) = default;
 
+  // Parses and validates an elf without touching the cache. Thread-safe, so that many inputs can be parsed in parallel
+  // and then appended with addParsedElf.
+  static llvm::Expected<vk::BinaryCacheEntry> parseElf(llvm::MemoryBufferRef elfBuffer);
+
   llvm::Error addElf(llvm::MemoryBufferRef elfBuffer);
+  llvm::Error addParsedElf(const vk::BinaryCacheEntry &entry, llvm::MemoryBufferRef elfBuffer);
+  llvm::Error addStoredEntry(const vk::BinaryCacheEntry &entry, llvm::ArrayRef<uint8_t> storedData);
   llvm::Error finalize(size_t *outTotalNumEntries, size_t *outTotalSize);
 
 private:
@@ -103,12 +132,30 @@ private:
                           std::unique_ptr<vk::PipelineBinaryCacheSerializer> serializer,
                           llvm::MutableArrayRef<uint8_t> outputBuffer, VkAllocationCallbacks &callbacks)
       : m_platformKey(std::move(platformKey)), m_serializer(std::move(serializer)), m_outputBuffer(outputBuffer),
-        m_callbacks(&callbacks) {}
+        m_callbacks(&callbacks), m_hashContextMem(nullptr, {callbacks}) {}
+
+  static llvm::Expected<std::unique_ptr<Util::IPlatformKey, AllocCallbacksDeleter>>
+  createPlatformKey(llvm::ArrayRef<uint8_t> fingerprint, VkAllocationCallbacks &callbacks);
+
+  bool isStreaming() const { return m_outputStream != nullptr; }
+  llvm::Error prepareStreamedEntry(size_t storedSize);
+  llvm::Error flushStreamedEntry();
 
   std::unique_ptr<Util::IPlatformKey, AllocCallbacksDeleter> m_platformKey;
   std::unique_ptr<vk::PipelineBinaryCacheSerializer> m_serializer;
   llvm::MutableArrayRef<uint8_t> m_outputBuffer;
   VkAllocationCallbacks *m_callbacks;
+
+  // Streaming output. The serializer only ever holds the entry being added, which is then written to the stream and
+  // added to the running hash of the cache content.
+  llvm::raw_pwrite_stream *m_outputStream = nullptr;
+  uint64_t m_streamStartOffset = 0;                  // Offset of the public header in the stream
+  std::vector<uint8_t> m_entryScratch;               // Serializer buffer for one entry
+  std::unique_ptr<void, AllocCallbacksDeleter> m_hashContextMem;
+  std::unique_ptr<Util::IHashContext, HashContextDestroyer> m_hashContext; // Destroyed before m_hashContextMem
+  size_t m_numStreamedEntries = 0;
+  size_t m_streamedContentSize = 0;                  // Bytes of entry headers and data written so far
+  bool m_compressEntries = false;
 };
 
 } // namespace cc
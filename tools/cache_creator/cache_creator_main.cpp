@@ -23,28 +23,83 @@
  *
  **********************************************************************************************************************/
 #include "cache_creator.h"
+#include "cache_info.h"
+#include "offline_compiler.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/CommandLine.h"
-#include "llvm/Support/FileOutputBuffer.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace {
 llvm::cl::OptionCategory CacheCreatorCat("Cache Creator Options");
 
 llvm::cl::list<std::string> InFiles(llvm::cl::Positional, llvm::cl::OneOrMore, llvm::cl::ValueRequired,
-                                    llvm::cl::cat(CacheCreatorCat), llvm::cl::desc("<Input elf file(s)>"));
-llvm::cl::opt<std::string> OutFileName("o", llvm::cl::desc("Output cache file"), llvm::cl::cat(CacheCreatorCat),
-                                       llvm::cl::value_desc("filename.bin"), llvm::cl::Required);
-llvm::cl::opt<uint32_t> DeviceId("device-id", llvm::cl::desc("Devide ID. This must match the target GPU."),
-                                 llvm::cl::value_desc("number"), llvm::cl::cat(CacheCreatorCat), llvm::cl::Required);
+                                    llvm::cl::cat(CacheCreatorCat),
+                                    llvm::cl::desc("<Input elf, .pipe, .spv, or .spvasm file(s)>"));
+// Several targets sharing a gfxip can be created from the same input elfs in one run: the n-th output file is created
+// for the n-th device ID and UUID.
+llvm::cl::list<std::string> OutFileNames("o",
+                                         llvm::cl::desc("Output cache file(s), one per device ID and UUID (comma-"
+                                                        "separated or repeated)"),
+                                         llvm::cl::cat(CacheCreatorCat), llvm::cl::value_desc("filename.bin"),
+                                         llvm::cl::OneOrMore, llvm::cl::CommaSeparated);
+llvm::cl::list<uint32_t> DeviceIds("device-id",
+                                   llvm::cl::desc("Devide ID(s). These must match the target GPUs (comma-separated or "
+                                                  "repeated)."),
+                                   llvm::cl::value_desc("number"), llvm::cl::cat(CacheCreatorCat), llvm::cl::OneOrMore,
+                                   llvm::cl::CommaSeparated);
 
 // This UUID is generated in vk_physical_device.cpp::Initialize.
+llvm::cl::list<std::string>
+    UuidStrs("uuid",
+             llvm::cl::desc("Pipeline cache UUID(s) for the specific driver and machine, e.g., "
+                            "00000000-12345-6789-abcd-ef0000000042 (comma-separated or repeated)"),
+             llvm::cl::value_desc("hex string"), llvm::cl::cat(CacheCreatorCat), llvm::cl::OneOrMore,
+             llvm::cl::CommaSeparated);
+
+llvm::cl::opt<bool> Compress("compress", llvm::cl::desc("Store cache entries LZ4-compressed"), llvm::cl::init(false),
+                             llvm::cl::cat(CacheCreatorCat));
+
 llvm::cl::opt<std::string>
-    UuidStr("uuid",
-            llvm::cl::desc(
-                "Pipeline cache UUID for the specific driver and machine, e.g., 00000000-12345-6789-abcd-ef0000000042"),
-            llvm::cl::value_desc("hex string"), llvm::cl::cat(CacheCreatorCat), llvm::cl::Required);
+    UpdateFileName("update",
+                   llvm::cl::desc("Existing cache file to update. Its entries are kept unless an input elf has the same "
+                                  "cache hash, so only new and changed elf files need to be passed. Requires a single "
+                                  "output file"),
+                   llvm::cl::value_desc("filename.bin"), llvm::cl::cat(CacheCreatorCat));
+
+llvm::cl::opt<unsigned> Threads("threads",
+                                llvm::cl::desc("Number of threads used to read and parse the input elf files. "
+                                               "0 uses all available cores"),
+                                llvm::cl::value_desc("number"), llvm::cl::init(0), llvm::cl::cat(CacheCreatorCat));
+
+// Offline compilation of pipeline and SPIR-V inputs.
+llvm::cl::opt<std::string> AmdllpcPath("amdllpc",
+                                       llvm::cl::desc("Path to the amdllpc executable used to compile .pipe, .spv, and "
+                                                      ".spvasm inputs. Searched for next to cache-creator and in PATH "
+                                                      "by default"),
+                                       llvm::cl::value_desc("filename"), llvm::cl::cat(CacheCreatorCat));
+llvm::cl::opt<std::string> Gfxip("gfxip",
+                                 llvm::cl::desc("Graphics IP version to compile .pipe, .spv, and .spvasm inputs for, "
+                                                "e.g., 10.3"),
+                                 llvm::cl::value_desc("major.minor[.stepping]"), llvm::cl::cat(CacheCreatorCat));
+llvm::cl::list<std::string> AmdllpcArgs("amdllpc-arg",
+                                        llvm::cl::desc("Additional argument for amdllpc, e.g., --amdllpc-arg=-spvgen-"
+                                                       "dir=<dir>. May be repeated"),
+                                        llvm::cl::value_desc("argument"), llvm::cl::cat(CacheCreatorCat));
 
 llvm::cl::opt<bool> Verbose("verbose", llvm::cl::desc("Enable verbose output"), llvm::cl::init(false),
                             llvm::cl::cat(CacheCreatorCat));
@@ -64,6 +119,104 @@ llvm::raw_ostream &infos() {
 
 namespace fs = llvm::sys::fs;
 
+// An input elf file, read and parsed by a worker thread.
+struct InputElf {
+  std::unique_ptr<llvm::MemoryBuffer> buffer;
+  vk::BinaryCacheEntry entry = {};
+  std::string readError;  // Set if the file couldn't be read
+  std::string parseError; // Set if the file couldn't be parsed
+};
+
+// =====================================================================================================================
+// Reads and parses all input elf files. The files are independent, so the work is spread over a thread pool; the
+// results are kept in input order so that the cache contents don't depend on scheduling.
+//
+// @param filenames : Input elf files
+// @param numThreads : Number of worker threads, 0 to use all available cores
+// @param [out] outInputs : Read and parsed input files, in the same order as `filenames`
+static void readInputElfs(llvm::ArrayRef<std::string> filenames, unsigned numThreads,
+                          llvm::MutableArrayRef<InputElf> outInputs) {
+  assert(filenames.size() == outInputs.size());
+
+  auto processFile = [](const std::string &filename, InputElf &input) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> inputBufferOrErr = llvm::MemoryBuffer::getFile(filename);
+    if (std::error_code err = inputBufferOrErr.getError()) {
+      input.readError = err.message();
+      return;
+    }
+    input.buffer = std::move(*inputBufferOrErr);
+
+    auto entryOrErr = cc::RelocatableCacheCreator::parseElf(*input.buffer);
+    if (auto err = entryOrErr.takeError()) {
+      input.parseError = llvm::toString(std::move(err));
+      return;
+    }
+    input.entry = *entryOrErr;
+  };
+
+  if (numThreads == 1 || filenames.size() == 1) {
+    for (auto &&nameInputPair : llvm::zip(filenames, outInputs))
+      processFile(std::get<0>(nameInputPair), std::get<1>(nameInputPair));
+    return;
+  }
+
+  llvm::ThreadPool pool(llvm::hardware_concurrency(numThreads));
+  for (auto &&nameInputPair : llvm::zip(filenames, outInputs)) {
+    const std::string &filename = std::get<0>(nameInputPair);
+    InputElf &input = std::get<1>(nameInputPair);
+    pool.async([&processFile, &filename, &input] { processFile(filename, input); });
+  }
+  pool.wait();
+}
+
+// An existing cache file whose entries are carried over into the new cache.
+struct BaseCache {
+  std::unique_ptr<llvm::MemoryBuffer> buffer;
+  llvm::SmallVector<cc::BinaryCacheEntryInfo, 0> entries;
+  size_t contentSize = 0; // Size of the serialized entries, including their headers
+};
+
+// =====================================================================================================================
+// Reads the entries of an existing cache file. The cache must have been created for the same device and pipeline cache
+// UUID, otherwise none of its entries could be used.
+//
+// @param filename : Existing cache file
+// @param deviceId : The device identifier of the target GPU
+// @param uuid : Pipeline cache UUID of the target
+// @param [out] outBaseCache : The cache file and its entries
+// @returns : Error if the file can't be read, isn't a valid cache, or doesn't match the target
+static llvm::Error readBaseCache(const std::string &filename, uint32_t deviceId, llvm::ArrayRef<uint8_t> uuid,
+                                 BaseCache &outBaseCache) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> bufferOrErr = llvm::MemoryBuffer::getFile(filename);
+  if (std::error_code err = bufferOrErr.getError())
+    return llvm::createFileError(filename, llvm::createStringError(err, "Failed to read the cache to update"));
+  outBaseCache.buffer = std::move(*bufferOrErr);
+
+  auto blobInfoOrErr = cc::CacheBlobInfo::create(*outBaseCache.buffer);
+  if (auto err = blobInfoOrErr.takeError())
+    return err;
+
+  auto publicHeaderInfoOrErr = blobInfoOrErr->readPublicVkHeaderInfo();
+  if (auto err = publicHeaderInfoOrErr.takeError())
+    return err;
+
+  const vk::PipelineCacheHeaderData &header = *publicHeaderInfoOrErr->publicHeader;
+  if (header.vendorID != cc::AMDVendorId || header.deviceID != deviceId ||
+      !std::equal(uuid.begin(), uuid.end(), std::begin(header.UUID))) {
+    return llvm::createFileError(filename, llvm::createStringError(std::errc::invalid_argument,
+                                                                   "Cache to update was created for a different "
+                                                                   "device ID or pipeline cache UUID"));
+  }
+
+  auto contentOffsetOrErr = blobInfoOrErr->getCacheContentOffset();
+  if (auto err = contentOffsetOrErr.takeError())
+    return err;
+  outBaseCache.contentSize = outBaseCache.buffer->getBufferSize() - *contentOffsetOrErr;
+
+  // The entries are copied as stored, so there is no need to decompress or hash them.
+  return blobInfoOrErr->readBinaryCacheEntriesInfo(outBaseCache.entries, /* computeMD5Sums = */ false);
+}
+
 static llvm::Error getFileSizes(llvm::ArrayRef<std::string> filenames, llvm::MutableArrayRef<size_t> outFileSizes) {
   assert(filenames.size() == outFileSizes.size());
   for (auto &&nameSizePair : llvm::zip(filenames, outFileSizes)) {
@@ -74,77 +227,294 @@ static llvm::Error getFileSizes(llvm::ArrayRef<std::string> filenames, llvm::Mut
   return llvm::Error::success();
 }
 
+// An output cache file and the target it is created for.
+struct OutputCache {
+  std::string fileName;
+  uint32_t deviceId = 0;
+  std::array<uint8_t, VK_UUID_SIZE> uuid = {};
+  llvm::Optional<fs::TempFile> tempFile;
+  std::unique_ptr<llvm::raw_fd_ostream> stream;
+};
+
+// =====================================================================================================================
+// Streams the caches to the outputs: the kept entries of the cache being updated first, followed by the input elfs.
+// Every entry is added to all outputs before moving on to the next one, so each input is only needed once.
+//
+// @param [in/out] outputs : Output caches with their streams open
+// @param baseCache : The cache being updated; has no entries when not updating
+// @param inputHashes : Hashes of all input elfs, which replace the base cache entries with the same hash
+// @param inputs : The read and parsed input elfs
+// @returns : 0 on success, or the exit code to return from main
+static int writeCaches(llvm::MutableArrayRef<OutputCache> outputs, const BaseCache &baseCache,
+                       const llvm::DenseSet<std::pair<uint64_t, uint64_t>> &inputHashes,
+                       llvm::MutableArrayRef<InputElf> inputs) {
+  std::vector<cc::RelocatableCacheCreator> cacheCreators;
+  cacheCreators.reserve(outputs.size());
+  for (OutputCache &output : outputs) {
+    // TODO(kuhar): Initialize the platform key properly by providing the `fingerprint` parameter instead of an empty
+    // array. This is so that the cache can pass validation and be consumed by the ICD. Note that this also requires
+    // ICD-side changes.
+    auto cacheCreatorOrErr =
+        cc::RelocatableCacheCreator::CreateStreaming(output.deviceId, output.uuid, {}, *output.stream, Compress);
+    if (auto err = cacheCreatorOrErr.takeError()) {
+      llvm::errs() << "Error:\t" << err << "\n";
+      llvm::consumeError(std::move(err));
+      return 4;
+    }
+    cacheCreators.push_back(std::move(*cacheCreatorOrErr));
+  }
+
+  // Carry over the entries of the cache being updated, except those replaced by an input elf.
+  size_t numKeptEntries = 0;
+  for (const cc::BinaryCacheEntryInfo &entryInfo : baseCache.entries) {
+    const Util::MetroHash::Hash &hash = entryInfo.entryHeader->hashId;
+    if (inputHashes.count({hash.qwords[0], hash.qwords[1]}))
+      continue;
+
+    for (cc::RelocatableCacheCreator &cacheCreator : cacheCreators) {
+      if (auto err = cacheCreator.addStoredEntry(*entryInfo.entryHeader, entryInfo.entryBlob)) {
+        llvm::errs() << "Error:\t" << err << "\n";
+        llvm::consumeError(std::move(err));
+        return 4;
+      }
+    }
+    ++numKeptEntries;
+  }
+  if (!UpdateFileName.empty()) {
+    infos() << "Kept entries: " << numKeptEntries << ", replaced entries: "
+            << (baseCache.entries.size() - numKeptEntries) << "\n";
+  }
+
+  for (InputElf &input : inputs) {
+    for (cc::RelocatableCacheCreator &cacheCreator : cacheCreators) {
+      if (auto err = cacheCreator.addParsedElf(input.entry, *input.buffer)) {
+        llvm::errs() << "Error:\t" << err << "\n";
+        llvm::consumeError(std::move(err));
+        return 4;
+      }
+    }
+    // The entry is in all output streams already; there's no need to keep the input around.
+    input.buffer.reset();
+  }
+
+  for (auto &&outputCreatorPair : llvm::zip(outputs, cacheCreators)) {
+    size_t actualNumEntries = 0;
+    size_t actualCacheSize = 0;
+    if (auto err = std::get<1>(outputCreatorPair).finalize(&actualNumEntries, &actualCacheSize)) {
+      llvm::errs() << "Error:\t" << err << "\n";
+      llvm::consumeError(std::move(err));
+      return 4;
+    }
+    if (outputs.size() > 1)
+      infos() << "Output: " << std::get<0>(outputCreatorPair).fileName << "\n";
+    infos() << "Num entries written: " << actualNumEntries << ", actual cache size: " << actualCacheSize << " B\n";
+  }
+
+  return 0;
+}
+
+// =====================================================================================================================
+// Discards the temporary files of all outputs that have one.
+//
+// @param [in/out] outputs : Output caches
+static void discardOutputs(llvm::MutableArrayRef<OutputCache> outputs) {
+  for (OutputCache &output : outputs) {
+    output.stream.reset();
+    if (output.tempFile)
+      llvm::consumeError(output.tempFile->discard());
+    output.tempFile.reset();
+  }
+}
+
+// =====================================================================================================================
+// Compiles the pipeline and SPIR-V inputs to elf files in a new temporary directory, and replaces them with the elf
+// files in `inOutFilenames`. Does nothing if all inputs are elf files already.
+//
+// @param argv0 : Path of the cache-creator executable, used to find amdllpc
+// @param [in/out] inOutFilenames : Input files; the compiled ones are replaced with their elf files
+// @param [out] outCompileDir : The temporary directory created, or empty if there was nothing to compile
+// @returns : 0 on success, or the exit code to return from main
+static int compileInputs(const char *argv0, llvm::MutableArrayRef<std::string> inOutFilenames,
+                         llvm::SmallVectorImpl<char> &outCompileDir) {
+  llvm::SmallVector<std::string> compiledFiles;
+  for (const std::string &filename : inOutFilenames) {
+    if (cc::isOfflineCompileInput(filename))
+      compiledFiles.push_back(filename);
+  }
+  if (compiledFiles.empty())
+    return 0;
+
+  if (Gfxip.empty()) {
+    llvm::errs() << "Compiling .pipe, .spv, and .spvasm inputs requires --gfxip. See `cache-creator --help` for usage "
+                    "details.\n";
+    return 2;
+  }
+
+  cc::OfflineCompileOptions options;
+  options.amdllpcPath = AmdllpcPath;
+  options.gfxip = Gfxip;
+  options.extraArgs.assign(AmdllpcArgs.begin(), AmdllpcArgs.end());
+  if (options.amdllpcPath.empty()) {
+    const std::string toolDir = std::string(llvm::sys::path::parent_path(llvm::sys::fs::getMainExecutable(
+        argv0, reinterpret_cast<void *>(&compileInputs))));
+    auto pathOrErr = llvm::sys::findProgramByName("amdllpc", {toolDir});
+    if (!pathOrErr)
+      pathOrErr = llvm::sys::findProgramByName("amdllpc");
+    if (!pathOrErr) {
+      llvm::errs() << "Failed to find amdllpc, which is required to compile .pipe, .spv, and .spvasm inputs. Use "
+                      "--amdllpc to specify its path.\n";
+      return 2;
+    }
+    options.amdllpcPath = *pathOrErr;
+  }
+
+  if (std::error_code err = fs::createUniqueDirectory("cache-creator", outCompileDir)) {
+    llvm::errs() << "Failed to create a directory for the compiled inputs: " << err.message() << "\n";
+    return 4;
+  }
+
+  infos() << "Compiling " << compiledFiles.size() << " input(s) with " << options.amdllpcPath << "\n";
+  llvm::SmallVector<std::string> elfPaths(compiledFiles.size());
+  const llvm::StringRef compileDir(outCompileDir.data(), outCompileDir.size());
+  if (auto err = cc::compileOffline(compiledFiles, options, compileDir, Threads, elfPaths)) {
+    llvm::errs() << "Error:\t" << err << "\n";
+    llvm::consumeError(std::move(err));
+    return 4;
+  }
+
+  auto elfPathIt = elfPaths.begin();
+  for (std::string &filename : inOutFilenames) {
+    if (!cc::isOfflineCompileInput(filename))
+      continue;
+    infos() << "Compiled: " << filename << " -> " << *elfPathIt << "\n";
+    filename = std::move(*elfPathIt++);
+  }
+  return 0;
+}
+
 int main(int argc, char **argv) {
   llvm::cl::ParseCommandLineOptions(argc, argv);
 
   llvm::outs() << "NOTE: cache-creator is still under development. Things may not work as expected.\n\n";
 
-  std::array<uint8_t, VK_UUID_SIZE> uuid = {};
-  if (!cc::hexStringToUuid(UuidStr, uuid)) {
-    llvm::errs() << "Failed to parse pipeline cache UUID (--uuid). See `cache-creator --help` for usage details.\n";
+  if (DeviceIds.size() != UuidStrs.size() || OutFileNames.size() != UuidStrs.size()) {
+    llvm::errs() << "The number of output files (-o), device IDs (--device-id), and pipeline cache UUIDs (--uuid) must "
+                    "match. See `cache-creator --help` for usage details.\n";
+    return 2;
+  }
+  if (!UpdateFileName.empty() && OutFileNames.size() != 1) {
+    llvm::errs() << "--update requires a single output file. See `cache-creator --help` for usage details.\n";
     return 2;
   }
 
-  const size_t numFiles = InFiles.size();
+  std::vector<OutputCache> outputs(OutFileNames.size());
+  for (size_t i = 0, e = outputs.size(); i != e; ++i) {
+    outputs[i].fileName = OutFileNames[i];
+    outputs[i].deviceId = DeviceIds[i];
+    if (!cc::hexStringToUuid(UuidStrs[i], outputs[i].uuid)) {
+      llvm::errs() << "Failed to parse pipeline cache UUID (--uuid). See `cache-creator --help` for usage details.\n";
+      return 2;
+    }
+  }
+
+  // Pipeline and SPIR-V inputs are compiled first; from then on, their elf files are handled like any other input.
+  std::vector<std::string> inputFiles(InFiles.begin(), InFiles.end());
+  llvm::SmallString<128> compileDir;
+  auto removeCompileDir = llvm::make_scope_exit([&compileDir] {
+    if (!compileDir.empty())
+      fs::remove_directories(compileDir);
+  });
+  if (int result = compileInputs(argv[0], inputFiles, compileDir))
+    return result;
+
+  const size_t numFiles = inputFiles.size();
   llvm::SmallVector<size_t> fileSizes(numFiles);
-  if (auto err = getFileSizes(InFiles, fileSizes)) {
+  if (auto err = getFileSizes(inputFiles, fileSizes)) {
     llvm::errs() << err << "\n";
     llvm::consumeError(std::move(err));
     return 3;
   }
 
-  const size_t cacheBlobSize = cc::RelocatableCacheCreator::CalculateAnticipatedCacheFileSize(fileSizes);
-  infos() << "Num inputs: " << numFiles << ", anticipated cache size: " << cacheBlobSize << "\n";
-
-  auto outFileBufferOrErr = llvm::FileOutputBuffer::create(OutFileName, cacheBlobSize);
-  if (auto err = outFileBufferOrErr.takeError()) {
-    llvm::errs() << "Failed to create the output file " << OutFileName << ". Error:\t" << err << "\n";
-    llvm::consumeError(std::move(err));
-    return 4;
+  BaseCache baseCache;
+  if (!UpdateFileName.empty()) {
+    if (auto err = readBaseCache(UpdateFileName, outputs.front().deviceId, outputs.front().uuid, baseCache)) {
+      llvm::errs() << err << "\n";
+      llvm::consumeError(std::move(err));
+      return 3;
+    }
+    infos() << "Read: " << UpdateFileName << ", " << baseCache.entries.size() << " entries\n";
   }
 
-  // TODO(kuhar): Initialize the platform key properly by providing the `fingerprint` parameter instead of an empty
-  // array. This is so that the cache can pass validation and be consumed by the ICD. Note that this also requires
-  // ICD-side changes.
-  auto cacheCreatorOrErr = cc::RelocatableCacheCreator::Create(
-      DeviceId, uuid, {},
-      llvm::makeMutableArrayRef((*outFileBufferOrErr)->getBufferStart(), (*outFileBufferOrErr)->getBufferSize()));
-  if (auto err = cacheCreatorOrErr.takeError()) {
-    llvm::errs() << "Error:\t" << err << "\n";
-    llvm::consumeError(std::move(err));
-    return 4;
-  }
-  cc::RelocatableCacheCreator &cacheCreator = *cacheCreatorOrErr;
+  // Entries carried over from the cache being updated take at most as much space as they did there.
+  const size_t cacheBlobSize =
+      cc::RelocatableCacheCreator::CalculateAnticipatedCacheFileSize(fileSizes) + baseCache.contentSize;
+  infos() << "Num inputs: " << numFiles << ", anticipated cache size: " << cacheBlobSize << "\n";
 
-  for (const std::string &filename : InFiles) {
-    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> inputBufferOrErr = llvm::MemoryBuffer::getFile(filename);
-    if (std::error_code err = inputBufferOrErr.getError()) {
-      llvm::errs() << "Failed to read input file " << filename << ": " << err.message() << "\n";
+  // Reading and parsing dominates for large numbers of inputs and runs in parallel; only the appends to the output
+  // stream are sequential.
+  std::vector<InputElf> inputs(numFiles);
+  readInputElfs(inputFiles, Threads, inputs);
+
+  llvm::DenseSet<std::pair<uint64_t, uint64_t>> inputHashes;
+  for (auto &&nameInputPair : llvm::zip(inputFiles, inputs)) {
+    const std::string &filename = std::get<0>(nameInputPair);
+    const InputElf &input = std::get<1>(nameInputPair);
+    if (!input.readError.empty()) {
+      llvm::errs() << "Failed to read input file " << filename << ": " << input.readError << "\n";
       return 3;
     }
     infos() << "Read: " << filename << "\n";
 
-    if (auto err = cacheCreator.addElf(**inputBufferOrErr)) {
-      llvm::errs() << "Error:\t" << err << "\n";
+    if (!input.parseError.empty()) {
+      llvm::errs() << "Error:\t" << input.parseError << "\n";
+      return 4;
+    }
+    inputHashes.insert({input.entry.hashId.qwords[0], input.entry.hashId.qwords[1]});
+  }
+
+  // Each cache is written to a temporary file next to its output and renamed once complete, so that a failed run never
+  // leaves a partial cache behind, and the output may be the same file as the cache being updated.
+  for (OutputCache &output : outputs) {
+    auto tempFileOrErr = fs::TempFile::create(output.fileName + "-%%%%%%.tmp");
+    if (auto err = tempFileOrErr.takeError()) {
+      llvm::errs() << "Failed to create the output file " << output.fileName << ". Error:\t" << err << "\n";
       llvm::consumeError(std::move(err));
+      discardOutputs(outputs);
       return 4;
     }
+    output.tempFile = std::move(*tempFileOrErr);
+    output.stream = std::make_unique<llvm::raw_fd_ostream>(output.tempFile->FD, /* shouldClose = */ false);
   }
 
-  size_t actualNumEntries = 0;
-  size_t actualCacheSize = 0;
-  if (auto err = cacheCreator.finalize(&actualNumEntries, &actualCacheSize)) {
-    llvm::errs() << "Error:\t" << err << "\n";
-    llvm::consumeError(std::move(err));
-    return 4;
+  int result = writeCaches(outputs, baseCache, inputHashes, inputs);
+  for (OutputCache &output : outputs) {
+    output.stream->flush();
+    if (result == 0 && output.stream->has_error()) {
+      llvm::errs() << "Failed to write the output file " << output.fileName << ": "
+                   << output.stream->error().message() << "\n";
+      result = 4;
+    }
+    output.stream->clear_error();
+    output.stream.reset();
   }
-  infos() << "Num entries written: " << actualNumEntries << ", actual cache size: " << actualCacheSize << " B\n";
 
-  if ((*outFileBufferOrErr)->commit()) {
-    llvm::errs() << "Failed to commit the serialized cache to the output file\n";
-    return 4;
+  if (result != 0) {
+    discardOutputs(outputs);
+    return result;
+  }
+
+  for (OutputCache &output : outputs) {
+    fs::TempFile tempFile = std::move(*output.tempFile);
+    output.tempFile.reset();
+    if (auto err = tempFile.keep(output.fileName)) {
+      llvm::errs() << "Failed to commit the serialized cache to the output file " << output.fileName << ". Error:\t"
+                   << err << "\n";
+      llvm::consumeError(std::move(err));
+      discardOutputs(outputs);
+      return 4;
+    }
+    llvm::outs() << "Cache successfully written to: " << output.fileName << "\n";
   }
-  llvm::outs() << "Cache successfully written to: " << (*outFileBufferOrErr)->getPath() << "\n";
 
   return 0;
 }
@@ -24,11 +24,21 @@
  **********************************************************************************************************************/
 #include "cache_info.h"
 #include "cache_creator.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/BinaryFormat/MsgPackDocument.h"
+#include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/MD5.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/xxhash.h"
+#include <algorithm>
 #include <cassert>
 #include <cinttypes>
+#include <cstring>
+#include <vector>
 
 namespace {
 
@@ -54,6 +64,66 @@ llvm::Error createBlobError(llvm::MemoryBufferRef blob, const char *format, cons
   return createBlobError(blob, llvm::createStringError(std::errc::state_not_recoverable, format, vals...));
 }
 
+// =====================================================================================================================
+// Checks if two cache entries have the same stored content, without comparing their headers.
+//
+// @param lhs : First entry
+// @param rhs : Second entry
+// @returns : True if both entries store identical bytes
+bool haveSameStoredContent(const cc::BinaryCacheEntryInfo &lhs, const cc::BinaryCacheEntryInfo &rhs) {
+  return lhs.entryBlob.size() == rhs.entryBlob.size() &&
+         std::memcmp(lhs.entryBlob.data(), rhs.entryBlob.data(), lhs.entryBlob.size()) == 0;
+}
+
+// =====================================================================================================================
+// Prints the hash ID of a cache entry.
+//
+// @param [in/out] os : Output stream
+// @param entry : Cache entry
+void printHashId(llvm::raw_ostream &os, const cc::BinaryCacheEntryInfo &entry) {
+  const vk::BinaryCacheEntry &header = *entry.entryHeader;
+  os << "0x" << llvm::format_hex_no_prefix(header.hashId.qwords[0], sizeof(uint64_t) * 2) << " 0x"
+     << llvm::format_hex_no_prefix(header.hashId.qwords[1], sizeof(uint64_t) * 2);
+}
+
+// =====================================================================================================================
+// Returns the sum of the stored sizes of the given entries.
+//
+// @param entries : Cache entries
+// @returns : Total stored size in bytes
+size_t getTotalStoredSize(llvm::ArrayRef<const cc::BinaryCacheEntryInfo *> entries) {
+  size_t totalSize = 0;
+  for (const cc::BinaryCacheEntryInfo *entry : entries)
+    totalSize += entry->entryBlob.size();
+  return totalSize;
+}
+
+// =====================================================================================================================
+// Decompresses the content of a compressed cache entry.
+//
+// @param entry : Compressed cache entry
+// @param [out] outContent : The decompressed content
+// @returns : True on success, false if the entry can not be decompressed
+bool decompressEntry(const cc::BinaryCacheEntryInfo &entry, std::vector<uint8_t> &outContent) {
+  assert(entry.isCompressed);
+  outContent.resize(entry.decompressedSize);
+  return vk::DecompressBinaryCacheEntry(entry.entryHeader, entry.entryBlob.data(), outContent.size(),
+                                        outContent.data()) == Util::Result::Success;
+}
+
+// =====================================================================================================================
+// Reads an unsigned integer field of a msgpack map.
+//
+// @param map : Map node
+// @param key : Field key
+// @returns : The field value, or 0 if the field is missing or not an unsigned integer
+uint64_t getUIntField(llvm::msgpack::MapDocNode &map, llvm::StringRef key) {
+  auto it = map.find(map.getDocument()->getNode(key));
+  if (it == map.end() || it->second.getKind() != llvm::msgpack::Type::UInt)
+    return 0;
+  return it->second.getUInt();
+}
+
 } // namespace
 
 namespace cc {
@@ -147,12 +217,14 @@ llvm::Expected<size_t> CacheBlobInfo::getCacheContentOffset() const {
 
 // =====================================================================================================================
 // Reads all PipelineBinaryCache entries. For each entry, calculates information about its location within the cache
-// blob, and computes the MD5 sum of the entry's content.
+// blob, and computes the MD5 sum of the entry's content. Compressed entries are decompressed to compute the MD5 sum.
 //
 // @param [out] entriesInfoOut : The cache entries found
+// @param computeMD5Sums : Whether to compute `entryMD5Sum`. Skipping it avoids decompressing and hashing every entry
+//                         when only the entry locations are needed
 // @returns : Error if the cache blob does not have a valid content section, success otherwise
-llvm::Error
-CacheBlobInfo::readBinaryCacheEntriesInfo(llvm::SmallVectorImpl<BinaryCacheEntryInfo> &entriesInfoOut) const {
+llvm::Error CacheBlobInfo::readBinaryCacheEntriesInfo(llvm::SmallVectorImpl<BinaryCacheEntryInfo> &entriesInfoOut,
+                                                      bool computeMD5Sums) const {
   auto contentOffsetOrErr = getCacheContentOffset();
   if (auto err = contentOffsetOrErr.takeError())
     return err;
@@ -173,21 +245,43 @@ CacheBlobInfo::readBinaryCacheEntriesInfo(llvm::SmallVectorImpl<BinaryCacheEntry
     currEntryInfo.entryHeader = reinterpret_cast<const vk::BinaryCacheEntry *>(currData);
     currEntryInfo.idx = entryIdx;
 
-    const size_t currEntryBlobSize = currEntryInfo.entryHeader->dataSize;
-    if (currData + EntrySize + currEntryBlobSize > blobEnd) {
+    const size_t currEntryBlobSize = vk::GetBinaryCacheEntryStoredSize(*currEntryInfo.entryHeader);
+    if (currEntryBlobSize > size_t(blobEnd - currData) - EntrySize) {
       return createBlobError(m_cacheBlob, "Insufficient buffer size for cache entry content #%zu at offset %zu",
                              entryIdx, currEntryOffset);
     }
 
     currData += EntrySize;
     currEntryInfo.entryBlob = {currData, currEntryBlobSize};
+    currEntryInfo.isCompressed = vk::IsCompressedBinaryCacheEntry(*currEntryInfo.entryHeader);
+    currEntryInfo.decompressedSize = currEntryBlobSize;
     currData += currEntryBlobSize;
 
-    llvm::MD5 md5;
-    md5.update(currEntryInfo.entryBlob);
-    llvm::MD5::MD5Result result = {};
-    md5.final(result);
-    currEntryInfo.entryMD5Sum = result.digest();
+    const void *entryData = currEntryInfo.entryBlob.data();
+    if (currEntryInfo.isCompressed &&
+        vk::GetBinaryCacheEntryDecompressedSize(currEntryInfo.entryHeader, entryData,
+                                                &currEntryInfo.decompressedSize) != Util::Result::Success) {
+      return createBlobError(m_cacheBlob, "Invalid compression header for cache entry #%zu at offset %zu", entryIdx,
+                             currEntryOffset);
+    }
+
+    if (computeMD5Sums) {
+      std::vector<uint8_t> decompressedBlob;
+      llvm::ArrayRef<uint8_t> entryContent = currEntryInfo.entryBlob;
+      if (currEntryInfo.isCompressed) {
+        if (!decompressEntry(currEntryInfo, decompressedBlob)) {
+          return createBlobError(m_cacheBlob, "Failed to decompress cache entry #%zu at offset %zu", entryIdx,
+                                 currEntryOffset);
+        }
+        entryContent = decompressedBlob;
+      }
+
+      llvm::MD5 md5;
+      md5.update(entryContent);
+      llvm::MD5::MD5Result result = {};
+      md5.final(result);
+      currEntryInfo.entryMD5Sum = result.digest();
+    }
 
     entriesInfoOut.push_back(std::move(currEntryInfo));
   }
@@ -228,8 +322,155 @@ llvm::raw_ostream &operator<<(llvm::raw_ostream &os, const BinaryCacheEntryInfo
      << "\thash ID:\t\t"
      << "0x" << llvm::format_hex_no_prefix(header.hashId.qwords[0], sizeof(uint64_t) * 2)
      << " 0x" << llvm::format_hex_no_prefix(header.hashId.qwords[1], sizeof(uint64_t) * 2) << '\n'
-     << "\tdata size:\t\t" << header.dataSize << "\n"
-     << "\tcalculated MD5 sum:\t" << info.entryMD5Sum << "\n";
+     << "\tdata size:\t\t" << vk::GetBinaryCacheEntryStoredSize(header) << "\n";
+  if (info.isCompressed)
+    os << "\tdecompressed size:\t" << info.decompressedSize << " (LZ4)\n";
+  os << "\tcalculated MD5 sum:\t" << info.entryMD5Sum << "\n";
+  return os;
+}
+
+// =====================================================================================================================
+// Computes size statistics and finds duplicate payloads over the given cache entries. The entry contents are only read
+// in place: duplicates are found by hashing the stored content, and candidates with equal hashes are compared
+// byte-by-byte. Compressed entries are not decompressed.
+//
+// @param entries : Cache entries, as read by `CacheBlobInfo::readBinaryCacheEntriesInfo`
+// @returns : Statistics over all entries
+CacheStats computeCacheStats(llvm::ArrayRef<BinaryCacheEntryInfo> entries) {
+  CacheStats stats = {};
+  llvm::DenseMap<uint64_t, llvm::SmallVector<const BinaryCacheEntryInfo *, 1>> entriesByContentHash;
+  entriesByContentHash.reserve(entries.size());
+
+  for (const BinaryCacheEntryInfo &entry : entries) {
+    const size_t storedSize = entry.entryBlob.size();
+    ++stats.numEntries;
+    stats.numCompressedEntries += entry.isCompressed;
+    stats.totalStoredSize += storedSize;
+
+    const size_t bucket = storedSize == 0 ? 0 : llvm::Log2_64(storedSize);
+    ++stats.sizeHistogram[std::min<size_t>(bucket, CacheStats::NumSizeBuckets - 1)];
+
+    auto &sameHashEntries = entriesByContentHash[llvm::xxHash64(llvm::toStringRef(entry.entryBlob))];
+    const bool isDuplicate = llvm::any_of(sameHashEntries, [&entry](const BinaryCacheEntryInfo *other) {
+      return haveSameStoredContent(entry, *other);
+    });
+    if (isDuplicate) {
+      ++stats.numDuplicateEntries;
+      stats.duplicateStoredSize += storedSize;
+    } else {
+      sameHashEntries.push_back(&entry);
+    }
+  }
+
+  return stats;
+}
+
+llvm::raw_ostream &operator<<(llvm::raw_ostream &os, const CacheStats &stats) {
+  os << "=== Cache Statistics ===\n"
+     << "num entries:\t\t" << stats.numEntries << "\n"
+     << "compressed entries:\t" << stats.numCompressedEntries << "\n"
+     << "total stored size:\t" << stats.totalStoredSize << " B\n"
+     << "duplicate entries:\t" << stats.numDuplicateEntries << ", " << stats.duplicateStoredSize << " B\n"
+     << "stored size histogram:\n";
+  for (size_t bucket = 0; bucket != CacheStats::NumSizeBuckets; ++bucket) {
+    if (stats.sizeHistogram[bucket] == 0)
+      continue;
+    os << "\t[" << (bucket == 0 ? 0 : uint64_t(1) << bucket) << ", ";
+    if (bucket + 1 == CacheStats::NumSizeBuckets)
+      os << "inf";
+    else
+      os << (uint64_t(1) << (bucket + 1));
+    os << ") B:\t" << stats.sizeHistogram[bucket] << "\n";
+  }
+  return os;
+}
+
+// =====================================================================================================================
+// Compares the entries of two cache blobs. Entries are matched by hash ID; matched entries are compared in place (no
+// decompression), so entries with the same content stored with different compression are reported as changed.
+//
+// @param oldEntries : Entries of the base cache
+// @param newEntries : Entries of the cache to compare against the base
+// @returns : Added, removed, and modified entries
+CacheDiff diffCacheEntries(llvm::ArrayRef<BinaryCacheEntryInfo> oldEntries,
+                           llvm::ArrayRef<BinaryCacheEntryInfo> newEntries) {
+  using HashKey = std::pair<uint64_t, uint64_t>;
+  auto getHashKey = [](const BinaryCacheEntryInfo &entry) {
+    const Util::MetroHash::Hash &hash = entry.entryHeader->hashId;
+    return HashKey(hash.qwords[0], hash.qwords[1]);
+  };
+
+  // The ICD never stores two entries with the same hash ID; if a blob does anyway, the first one wins.
+  llvm::DenseMap<HashKey, const BinaryCacheEntryInfo *> oldEntriesByHash;
+  oldEntriesByHash.reserve(oldEntries.size());
+  for (const BinaryCacheEntryInfo &entry : oldEntries)
+    oldEntriesByHash.insert({getHashKey(entry), &entry});
+
+  CacheDiff diff;
+  llvm::DenseSet<HashKey> matchedHashes;
+  matchedHashes.reserve(newEntries.size());
+  for (const BinaryCacheEntryInfo &newEntry : newEntries) {
+    auto oldIt = oldEntriesByHash.find(getHashKey(newEntry));
+    if (oldIt == oldEntriesByHash.end() || !matchedHashes.insert(oldIt->first).second) {
+      diff.addedEntries.push_back(&newEntry);
+      continue;
+    }
+
+    const BinaryCacheEntryInfo *oldEntry = oldIt->second;
+    if (oldEntry->entryBlob.size() != newEntry.entryBlob.size())
+      diff.resizedEntries.push_back({oldEntry, &newEntry});
+    else if (!haveSameStoredContent(*oldEntry, newEntry))
+      diff.changedEntries.push_back({oldEntry, &newEntry});
+    else
+      ++diff.numUnchangedEntries;
+  }
+
+  for (const BinaryCacheEntryInfo &oldEntry : oldEntries) {
+    const HashKey key = getHashKey(oldEntry);
+    if (!matchedHashes.count(key) || oldEntriesByHash.lookup(key) != &oldEntry)
+      diff.removedEntries.push_back(&oldEntry);
+  }
+
+  return diff;
+}
+
+llvm::raw_ostream &operator<<(llvm::raw_ostream &os, const CacheDiff &diff) {
+  const size_t addedSize = getTotalStoredSize(diff.addedEntries);
+  const size_t removedSize = getTotalStoredSize(diff.removedEntries);
+  int64_t resizedDelta = 0;
+  for (const CacheDiff::EntryPair &entries : diff.resizedEntries)
+    resizedDelta += int64_t(entries.second->entryBlob.size()) - int64_t(entries.first->entryBlob.size());
+
+  os << "=== Cache Diff ===\n"
+     << "added entries:\t\t" << diff.addedEntries.size() << ", +" << addedSize << " B\n"
+     << "removed entries:\t" << diff.removedEntries.size() << ", -" << removedSize << " B\n"
+     << "resized entries:\t" << diff.resizedEntries.size() << ", " << llvm::format("%+" PRId64, resizedDelta)
+     << " B\n"
+     << "changed entries:\t" << diff.changedEntries.size() << "\n"
+     << "unchanged entries:\t" << diff.numUnchangedEntries << "\n"
+     << "total size change:\t"
+     << llvm::format("%+" PRId64, int64_t(addedSize) - int64_t(removedSize) + resizedDelta) << " B\n";
+
+  for (const BinaryCacheEntryInfo *entry : diff.addedEntries) {
+    os << "\t+ ";
+    printHashId(os, *entry);
+    os << "\t" << entry->entryBlob.size() << " B\n";
+  }
+  for (const BinaryCacheEntryInfo *entry : diff.removedEntries) {
+    os << "\t- ";
+    printHashId(os, *entry);
+    os << "\t" << entry->entryBlob.size() << " B\n";
+  }
+  for (const CacheDiff::EntryPair &entries : diff.resizedEntries) {
+    os << "\t~ ";
+    printHashId(os, *entries.second);
+    os << "\t" << entries.first->entryBlob.size() << " B -> " << entries.second->entryBlob.size() << " B\n";
+  }
+  for (const CacheDiff::EntryPair &entries : diff.changedEntries) {
+    os << "\t! ";
+    printHashId(os, *entries.second);
+    os << "\t" << entries.second->entryBlob.size() << " B\n";
+  }
   return os;
 }
 
@@ -263,4 +504,84 @@ llvm::StringMap<std::string> mapMD5SumsToElfFilePath(llvm::Twine dir) {
   return md5ToElfPath;
 }
 
+// =====================================================================================================================
+// Reads the resource usage of every hardware stage of a cache entry from the PAL metadata of its ELF. These are the
+// statistics the driver reports through VK_KHR_pipeline_executable_properties, so they can be collected for a whole
+// cache without creating any pipelines.
+//
+// @param entry : The cache entry
+// @param [out] statsOut : The stats of each hardware stage found in the metadata
+// @returns : Error if the entry content can not be decompressed or is not a PAL pipeline ELF, success otherwise
+llvm::Error readHwStageStats(const BinaryCacheEntryInfo &entry, llvm::SmallVectorImpl<HwStageStats> &statsOut) {
+  std::vector<uint8_t> decompressedBlob;
+  llvm::ArrayRef<uint8_t> entryContent = entry.entryBlob;
+  if (entry.isCompressed) {
+    if (!decompressEntry(entry, decompressedBlob))
+      return llvm::createStringError(std::errc::state_not_recoverable, "Failed to decompress cache entry #%zu",
+                                     entry.idx);
+    entryContent = decompressedBlob;
+  }
+
+  const llvm::MemoryBufferRef elfBuffer(llvm::toStringRef(entryContent), "entry");
+  auto noteBlobOrErr = getElfPalMetadataBlob(elfBuffer);
+  if (auto err = noteBlobOrErr.takeError())
+    return err;
+
+  auto badMetadataError = [] {
+    return llvm::createStringError(llvm::object::object_error::invalid_file_type, "Unexpected PAL metadata format");
+  };
+
+  llvm::msgpack::Document document;
+  if (!document.readFromBlob(*noteBlobOrErr, false))
+    return badMetadataError();
+
+  llvm::msgpack::DocNode node = document.getRoot();
+  if (!node.isMap())
+    return badMetadataError();
+  node = node.getMap(false)["amdpal.pipelines"];
+  if (!node.isArray() || node.getArray(false).size() == 0)
+    return badMetadataError();
+  node = node.getArray(false)[0];
+  if (!node.isMap())
+    return badMetadataError();
+  node = node.getMap(false)[".hardware_stages"];
+  if (!node.isMap())
+    return badMetadataError();
+
+  // The ISA size of a stage is the size of its entry point symbol.
+  auto elfObjectOrErr = llvm::object::ELF64LEObjectFile::create(elfBuffer);
+  if (auto err = elfObjectOrErr.takeError())
+    return err;
+  llvm::StringMap<uint64_t> symbolSizes;
+  for (const llvm::object::ELFSymbolRef &symbol : elfObjectOrErr->symbols()) {
+    auto nameOrErr = symbol.getName();
+    if (auto err = nameOrErr.takeError()) {
+      llvm::consumeError(std::move(err));
+      continue;
+    }
+    symbolSizes[*nameOrErr] = symbol.getSize();
+  }
+
+  for (auto &stageNode : node.getMap(false)) {
+    if (!stageNode.first.isString() || !stageNode.second.isMap())
+      continue;
+    llvm::msgpack::MapDocNode stageMap = stageNode.second.getMap(false);
+
+    HwStageStats stats = {};
+    stats.stageName = stageNode.first.getString().str();
+    stats.vgprCount = getUIntField(stageMap, ".vgpr_count");
+    stats.sgprCount = getUIntField(stageMap, ".sgpr_count");
+    stats.ldsSize = getUIntField(stageMap, ".lds_size");
+    stats.scratchMemorySize = getUIntField(stageMap, ".scratch_memory_size");
+
+    auto entryPointIt = stageMap.find(document.getNode(".entry_point"));
+    if (entryPointIt != stageMap.end() && entryPointIt->second.isString())
+      stats.isaSize = symbolSizes.lookup(entryPointIt->second.getString());
+
+    statsOut.push_back(std::move(stats));
+  }
+
+  return llvm::Error::success();
+}
+
 } // namespace cc
@@ -38,7 +38,9 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/MemoryBufferRef.h"
 #include "llvm/Support/raw_ostream.h"
+#include <array>
 #include <string>
+#include <utility>
 
 namespace cc {
 
@@ -77,16 +79,68 @@ llvm::raw_ostream &operator<<(llvm::raw_ostream &os, const BinaryCachePrivateHea
 using MD5DigestStr = llvm::SmallString<32>;
 
 // Represents printable information about a Pipeline Binary Cache entry, its location within the cache blob, and
-// calculated MD5 sum of the entry content.
+// calculated MD5 sum of the entry content. For compressed entries, `entryBlob` is the stored (compressed) data and the
+// MD5 sum is calculated over the decompressed content, so that it can be matched against the source ELF files.
 struct BinaryCacheEntryInfo {
   const vk::BinaryCacheEntry *entryHeader;
   size_t idx;
   llvm::ArrayRef<uint8_t> entryBlob;
+  bool isCompressed;
+  size_t decompressedSize;
   MD5DigestStr entryMD5Sum;
 };
 
 llvm::raw_ostream &operator<<(llvm::raw_ostream &os, const BinaryCacheEntryInfo &info);
 
+// Summary statistics over the entries of a cache blob. Sizes are stored sizes, i.e., what the entries occupy in the
+// blob (compressed, if they are stored compressed), excluding the entry headers.
+struct CacheStats {
+  // Bucket `i` counts the entries with stored size in [2^i, 2^(i+1)); empty entries are counted in bucket 0 and the
+  // last bucket also counts all larger entries.
+  static constexpr size_t NumSizeBuckets = 40;
+
+  size_t numEntries;
+  size_t numCompressedEntries;
+  size_t totalStoredSize;
+  size_t numDuplicateEntries; // Entries with the same stored content as an earlier entry
+  size_t duplicateStoredSize; // Total stored size of the duplicate entries
+  std::array<size_t, NumSizeBuckets> sizeHistogram;
+};
+
+CacheStats computeCacheStats(llvm::ArrayRef<BinaryCacheEntryInfo> entries);
+
+llvm::raw_ostream &operator<<(llvm::raw_ostream &os, const CacheStats &stats);
+
+// Difference between the entries of two cache blobs: an old (base) one and a new one. Entries are matched by their
+// hash ID. The entry pointers point into the entry arrays passed to `diffCacheEntries`, and the lists are in the order
+// of the blob the entries come from.
+struct CacheDiff {
+  using EntryPair = std::pair<const BinaryCacheEntryInfo *, const BinaryCacheEntryInfo *>; // (old, new)
+
+  llvm::SmallVector<const BinaryCacheEntryInfo *> addedEntries;   // Only in the new blob
+  llvm::SmallVector<const BinaryCacheEntryInfo *> removedEntries; // Only in the old blob
+  llvm::SmallVector<EntryPair> resizedEntries;                    // Different stored size
+  llvm::SmallVector<EntryPair> changedEntries;                    // Same stored size, different stored content
+  size_t numUnchangedEntries = 0;
+};
+
+CacheDiff diffCacheEntries(llvm::ArrayRef<BinaryCacheEntryInfo> oldEntries,
+                           llvm::ArrayRef<BinaryCacheEntryInfo> newEntries);
+
+llvm::raw_ostream &operator<<(llvm::raw_ostream &os, const CacheDiff &diff);
+
+// Resource usage of one hardware shader stage of a cache entry, as recorded in the PAL metadata of the entry's ELF.
+struct HwStageStats {
+  std::string stageName; // PAL hardware stage name, e.g., ".cs"
+  uint64_t vgprCount;
+  uint64_t sgprCount;
+  uint64_t ldsSize;           // In bytes
+  uint64_t scratchMemorySize; // In bytes, per thread
+  uint64_t isaSize;           // Size of the stage entry point in bytes, 0 if the symbol is not found
+};
+
+llvm::Error readHwStageStats(const BinaryCacheEntryInfo &entry, llvm::SmallVectorImpl<HwStageStats> &statsOut);
+
 // Given a directory, returns a map from ELF MD5 sums their paths. Files without the '.elf' extension ignored.
 llvm::StringMap<std::string> mapMD5SumsToElfFilePath(llvm::Twine dir);
 
@@ -100,7 +154,8 @@ public:
 
   llvm::Expected<BinaryCachePrivateHeaderInfo> readBinaryCachePrivateHeaderInfo() const;
 
-  llvm::Error readBinaryCacheEntriesInfo(llvm::SmallVectorImpl<BinaryCacheEntryInfo> &entriesInfoOut) const;
+  llvm::Error readBinaryCacheEntriesInfo(llvm::SmallVectorImpl<BinaryCacheEntryInfo> &entriesInfoOut,
+                                         bool computeMD5Sums = true) const;
 
   llvm::Expected<size_t> getPrivateHeaderOffset() const;
   llvm::Expected<size_t> getCacheContentOffset() const;
@@ -26,6 +26,7 @@
 #include "cache_info.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <cassert>
 
@@ -36,6 +37,21 @@ llvm::cl::opt<std::string> InFile(llvm::cl::Positional, llvm::cl::ValueRequired,
                                   llvm::cl::desc("<Input cache_file.bin>"));
 llvm::cl::opt<std::string> ElfSourceDir("elf-source-dir", llvm::cl::desc("(Optional) Directory with source ELF files"),
                                         llvm::cl::cat(CacheInfoCat), llvm::cl::value_desc("directory"));
+// Not called `--stats`, which LLVM already registers.
+llvm::cl::opt<bool> PrintStats("size-stats",
+                               llvm::cl::desc("Print entry size statistics and duplicate payloads instead of every "
+                                              "entry"),
+                               llvm::cl::init(false), llvm::cl::cat(CacheInfoCat));
+llvm::cl::opt<std::string>
+    DiffFile("diff",
+             llvm::cl::desc("Compare the input cache (as the base) against this cache file: list added, removed, and "
+                            "modified entries, and print statistics for both"),
+             llvm::cl::cat(CacheInfoCat), llvm::cl::value_desc("filename.bin"));
+llvm::cl::opt<bool>
+    PrintShaderStats("shader-stats",
+                     llvm::cl::desc("Print the resource usage of every hardware stage of every entry as CSV, read from "
+                                    "the PAL metadata of the entries"),
+                     llvm::cl::init(false), llvm::cl::cat(CacheInfoCat));
 
 int reportAndConsumeError(llvm::Error err, int exitCode) {
   llvm::errs() << "[ERROR]: " << err << "\n";
@@ -46,10 +62,136 @@ int reportAndConsumeError(llvm::Error err, int exitCode) {
 
 namespace fs = llvm::sys::fs;
 
+// =====================================================================================================================
+// Maps a cache file into memory. Large files are mmapped instead of read, so that even multi-GB caches can be analyzed
+// without copying them.
+//
+// @param filename : Path to the cache file
+// @returns : The file buffer, or error if the file can't be opened or mapped
+static llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> mapCacheFile(const std::string &filename) {
+  llvm::Expected<fs::file_t> fileOrErr = fs::openNativeFileForRead(filename);
+  if (!fileOrErr)
+    return llvm::errorToErrorCode(fileOrErr.takeError());
+
+  fs::file_status status;
+  if (std::error_code err = fs::status(*fileOrErr, status)) {
+    fs::closeFile(*fileOrErr);
+    return err;
+  }
+
+  // The blob isn't parsed as text, so it doesn't need to be null-terminated. This is what allows mmapping any size.
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> bufferOrErr =
+      llvm::MemoryBuffer::getOpenFile(*fileOrErr, filename, status.getSize(), /* RequiresNullTerminator = */ false);
+  fs::closeFile(*fileOrErr);
+  return bufferOrErr;
+}
+
+// =====================================================================================================================
+// Reads the entries of a cache file for statistics and diffing. The entries point into the file buffer, and no MD5
+// sums are computed.
+//
+// @param filename : Path to the cache file
+// @param [out] outBuffer : The file buffer
+// @param [out] outEntries : The cache entries
+// @returns : 0 on success, or the exit code to return from main
+static int readCacheEntries(const std::string &filename, std::unique_ptr<llvm::MemoryBuffer> &outBuffer,
+                            llvm::SmallVectorImpl<cc::BinaryCacheEntryInfo> &outEntries) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> bufferOrErr = mapCacheFile(filename);
+  if (auto err = bufferOrErr.getError()) {
+    llvm::errs() << "Failed to read input file " << filename << ": " << err.message() << "\n";
+    return 3;
+  }
+  outBuffer = std::move(*bufferOrErr);
+  llvm::outs() << "Read: " << filename << ", " << outBuffer->getBufferSize() << " B\n";
+
+  auto blobInfoOrErr = cc::CacheBlobInfo::create(*outBuffer);
+  if (auto err = blobInfoOrErr.takeError())
+    return reportAndConsumeError(std::move(err), 4);
+
+  if (auto err = blobInfoOrErr->readBinaryCacheEntriesInfo(outEntries, /* computeMD5Sums = */ false))
+    return reportAndConsumeError(std::move(err), 4);
+
+  return 0;
+}
+
+// =====================================================================================================================
+// Implements the --size-stats and --diff modes.
+//
+// @returns : 0 on success, or the exit code to return from main
+static int printStatsAndDiff() {
+  std::unique_ptr<llvm::MemoryBuffer> baseBuffer;
+  llvm::SmallVector<cc::BinaryCacheEntryInfo, 0> baseEntries;
+  if (int result = readCacheEntries(InFile, baseBuffer, baseEntries))
+    return result;
+
+  std::unique_ptr<llvm::MemoryBuffer> otherBuffer;
+  llvm::SmallVector<cc::BinaryCacheEntryInfo, 0> otherEntries;
+  if (!DiffFile.empty()) {
+    if (int result = readCacheEntries(DiffFile, otherBuffer, otherEntries))
+      return result;
+  }
+  llvm::outs() << "\n";
+
+  llvm::outs() << "Base: " << InFile << "\n" << cc::computeCacheStats(baseEntries) << "\n";
+  if (!DiffFile.empty()) {
+    llvm::outs() << "Other: " << DiffFile << "\n"
+                 << cc::computeCacheStats(otherEntries) << "\n"
+                 << cc::diffCacheEntries(baseEntries, otherEntries) << "\n";
+  }
+
+  llvm::outs() << "=== Cache Info analysis finished ===\n";
+  return 0;
+}
+
+// =====================================================================================================================
+// Implements the --shader-stats mode: prints one CSV row per hardware stage of every cache entry. Entries that are not
+// PAL pipeline ELFs are reported on stderr and skipped.
+//
+// @returns : 0 on success, or the exit code to return from main
+static int printShaderStats() {
+  std::unique_ptr<llvm::MemoryBuffer> buffer;
+  llvm::SmallVector<cc::BinaryCacheEntryInfo, 0> entries;
+  if (int result = readCacheEntries(InFile, buffer, entries))
+    return result;
+  llvm::outs() << "\n";
+
+  llvm::outs() << "entry,hash,stage,vgprs,sgprs,lds_bytes,scratch_bytes,isa_bytes\n";
+
+  size_t numSkippedEntries = 0;
+  llvm::SmallVector<cc::HwStageStats, 8> stageStats;
+  for (const cc::BinaryCacheEntryInfo &entry : entries) {
+    stageStats.clear();
+    if (auto err = cc::readHwStageStats(entry, stageStats)) {
+      llvm::errs() << "[WARN]: Skipping cache entry #" << entry.idx << ": " << err << "\n";
+      llvm::consumeError(std::move(err));
+      ++numSkippedEntries;
+      continue;
+    }
+
+    const Util::MetroHash::Hash &hash = entry.entryHeader->hashId;
+    for (const cc::HwStageStats &stats : stageStats) {
+      llvm::outs() << entry.idx << ",0x" << llvm::format_hex_no_prefix(hash.qwords[0], sizeof(uint64_t) * 2)
+                   << llvm::format_hex_no_prefix(hash.qwords[1], sizeof(uint64_t) * 2) << "," << stats.stageName
+                   << "," << stats.vgprCount << "," << stats.sgprCount << "," << stats.ldsSize << ","
+                   << stats.scratchMemorySize << "," << stats.isaSize << "\n";
+    }
+  }
+
+  llvm::outs() << "\nskipped entries: " << numSkippedEntries << "\n"
+               << "=== Cache Info analysis finished ===\n";
+  return 0;
+}
+
 int main(int argc, char **argv) {
   llvm::cl::ParseCommandLineOptions(argc, argv);
 
-  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> inputBufferOrErr = llvm::MemoryBuffer::getFile(InFile);
+  if (PrintStats || !DiffFile.empty())
+    return printStatsAndDiff();
+
+  if (PrintShaderStats)
+    return printShaderStats();
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> inputBufferOrErr = mapCacheFile(InFile);
   if (auto err = inputBufferOrErr.getError()) {
     llvm::errs() << "Failed to read input file " << InFile << ": " << err.message() << "\n";
     return 3;
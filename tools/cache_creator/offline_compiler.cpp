@@ -0,0 +1,144 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Google LLC. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+#include "offline_compiler.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include <cassert>
+#include <mutex>
+
+namespace {
+
+// =====================================================================================================================
+// Runs `amdllpc` to compile a single input. The compiler output is redirected to a log file next to the elf file and
+// included in the returned error if the compilation fails.
+//
+// @param input : Pipeline or SPIR-V file to compile
+// @param options : Compiler executable and arguments
+// @param elfPath : Path of the elf file to write
+// @returns : Error if the compiler couldn't be run or failed, success otherwise
+llvm::Error compileInput(const std::string &input, const cc::OfflineCompileOptions &options,
+                         const std::string &elfPath) {
+  const std::string gfxipArg = "-gfxip=" + options.gfxip;
+  const std::string outputArg = "-o=" + elfPath;
+  llvm::SmallVector<llvm::StringRef> args = {options.amdllpcPath, gfxipArg};
+  for (const std::string &arg : options.extraArgs)
+    args.push_back(arg);
+  args.push_back(outputArg);
+  args.push_back(input);
+
+  const std::string logPath = elfPath + ".log";
+  const llvm::Optional<llvm::StringRef> redirects[] = {llvm::StringRef(""), llvm::StringRef(logPath),
+                                                       llvm::StringRef(logPath)};
+  std::string errMsg;
+  bool executionFailed = false;
+  const int exitCode = llvm::sys::ExecuteAndWait(options.amdllpcPath, args, llvm::None, redirects, 0, 0, &errMsg,
+                                                 &executionFailed);
+  if (executionFailed) {
+    return llvm::createFileError(input, llvm::createStringError(std::errc::no_such_file_or_directory,
+                                                                "Failed to run %s: %s", options.amdllpcPath.c_str(),
+                                                                errMsg.c_str()));
+  }
+
+  if (exitCode != 0) {
+    std::string log = "<no output>";
+    if (auto logBufferOrErr = llvm::MemoryBuffer::getFile(logPath))
+      log = (*logBufferOrErr)->getBuffer().rtrim().str();
+    return llvm::createFileError(input, llvm::createStringError(std::errc::state_not_recoverable,
+                                                                "amdllpc failed with exit code %d:\n%s", exitCode,
+                                                                log.c_str()));
+  }
+
+  return llvm::Error::success();
+}
+
+} // namespace
+
+namespace cc {
+
+// =====================================================================================================================
+// Checks if the input needs to be compiled with `amdllpc`, based on its file extension. All other inputs are expected
+// to be elf files.
+//
+// @param path : Input file path
+// @returns : True for pipeline and SPIR-V files
+bool isOfflineCompileInput(llvm::StringRef path) {
+  const llvm::StringRef extension = llvm::sys::path::extension(path);
+  return extension == ".pipe" || extension == ".spv" || extension == ".spvasm";
+}
+
+// =====================================================================================================================
+// Compiles pipeline and SPIR-V files to elf files. Each input is compiled by a separate `amdllpc` process, and the
+// processes are spread over a thread pool. The elf files are named after the input index, so inputs with the same file
+// name in different directories don't clash.
+//
+// @param inputs : Files to compile
+// @param options : Compiler executable and arguments
+// @param outputDir : Existing directory to write the elf files and compiler logs to
+// @param numThreads : Maximum number of concurrent compiler processes, 0 to use all available cores
+// @param [out] outElfPaths : Paths of the compiled elf files, in the same order as `inputs`
+// @returns : The errors of all failed compilations, or success
+llvm::Error compileOffline(llvm::ArrayRef<std::string> inputs, const OfflineCompileOptions &options,
+                           llvm::StringRef outputDir, unsigned numThreads,
+                           llvm::MutableArrayRef<std::string> outElfPaths) {
+  assert(inputs.size() == outElfPaths.size());
+
+  for (size_t i = 0, e = inputs.size(); i != e; ++i) {
+    llvm::SmallString<128> elfPath(outputDir);
+    llvm::sys::path::append(elfPath, llvm::Twine(i) + "-" + llvm::sys::path::stem(inputs[i]) + ".elf");
+    outElfPaths[i] = std::string(elfPath);
+  }
+
+  std::mutex errorLock;
+  llvm::Error errors = llvm::Error::success();
+  auto compileOne = [&](size_t idx) {
+    llvm::Error err = compileInput(inputs[idx], options, outElfPaths[idx]);
+    if (err) {
+      std::lock_guard<std::mutex> lock(errorLock);
+      errors = llvm::joinErrors(std::move(errors), std::move(err));
+    }
+  };
+
+  if (numThreads == 1 || inputs.size() == 1) {
+    for (size_t i = 0, e = inputs.size(); i != e; ++i)
+      compileOne(i);
+    return errors;
+  }
+
+  llvm::ThreadPool pool(llvm::hardware_concurrency(numThreads));
+  for (size_t i = 0, e = inputs.size(); i != e; ++i)
+    pool.async([&compileOne, i] { compileOne(i); });
+  pool.wait();
+
+  return errors;
+}
+
+} // namespace cc
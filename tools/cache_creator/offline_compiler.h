@@ -0,0 +1,59 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Google LLC. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+#pragma once
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include <string>
+
+namespace cc {
+
+// =====================================================================================================================
+//
+// Offline compilation front end for cache-creator. Pipeline (.pipe) and SPIR-V (.spv, .spvasm) inputs are compiled to
+// elf files by invoking the standalone LLPC compiler, `amdllpc`, so that a cache can be created straight from the
+// pipeline sources. Without relocatable shader elf options, `amdllpc` compiles full pipelines to non-relocatable elf
+// files, which is what the ICD would produce at runtime.
+//
+// =====================================================================================================================
+
+// Options for the `amdllpc` invocations.
+struct OfflineCompileOptions {
+  std::string amdllpcPath;                  // Path to the `amdllpc` executable
+  std::string gfxip;                        // Target graphics IP version, e.g., '10.3'
+  llvm::SmallVector<std::string> extraArgs; // Additional arguments passed to every `amdllpc` invocation
+};
+
+// Returns true if the file at `path` has to be compiled before it can be added to a cache.
+bool isOfflineCompileInput(llvm::StringRef path);
+
+// Compiles the inputs to elf files in `outputDir`, running up to `numThreads` compiler processes at a time.
+llvm::Error compileOffline(llvm::ArrayRef<std::string> inputs, const OfflineCompileOptions &options,
+                           llvm::StringRef outputDir, unsigned numThreads,
+                           llvm::MutableArrayRef<std::string> outElfPaths);
+
+} // namespace cc
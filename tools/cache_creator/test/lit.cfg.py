@@ -55,7 +55,13 @@ config.substitutions.append(('%PATH%', config.environment['PATH']))
 config.substitutions.append(('%gfxip', '-gfxip=' + config.gfxip))
 config.substitutions.append(('%spvgen', '-spvgen-dir=' + config.spvgen_dir))
 config.substitutions.append(('%reloc', '-unlinked -enable-relocatable-shader-elf'))
+# Options for cache-creator to compile .pipe and SPIR-V inputs with the same settings as the amdllpc runs above.
+config.substitutions.append(('%cc-gfxip', '--gfxip=' + config.gfxip))
+config.substitutions.append(('%cc-spvgen', '--amdllpc-arg=-spvgen-dir=' + config.spvgen_dir))
 
 tool_dirs = [config.cache_creator_tools_dir, config.amdllpc_dir, config.llvm_tools_dir]
 tools = ['amdllpc', 'cache-creator', 'cache-info', 'llvm-objdump', 'llvm-readelf', 'count', 'not', 'split-file']
 llvm_config.add_tool_substitutions(tools, tool_dirs)
+
+# cache-creator looks up amdllpc in PATH to compile .pipe and SPIR-V inputs.
+llvm_config.with_environment('PATH', config.amdllpc_dir, append_path=True)
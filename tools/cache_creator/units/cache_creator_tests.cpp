@@ -24,7 +24,9 @@
  **********************************************************************************************************************/
 #include "cache_creator.h"
 #include "units/doctest.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/BinaryFormat/MsgPackDocument.h"
+#include "llvm/Support/raw_ostream.h"
 #include <array>
 
 TEST_CASE("Placeholder test pass") {
@@ -169,3 +171,57 @@ amdpal.pipelines:
   CHECK(elfLlpcInfo.llpcVersion.getMajor() == 46);
   CHECK(elfLlpcInfo.llpcVersion.getMinor().getValue() == 1);
 }
+
+TEST_CASE("Streamed cache matches buffered cache") {
+  std::array<uint8_t, VK_UUID_SIZE> uuid = {};
+  uuid[0] = 0x42;
+  const uint32_t deviceId = 0x6080;
+
+  llvm::SmallVector<uint8_t> entryContent(512);
+  for (size_t i = 0; i < entryContent.size(); ++i)
+    entryContent[i] = uint8_t(i % 7);
+
+  const size_t entryCount = 3;
+  const size_t cacheSize = vk::VkPipelineCacheHeaderDataSize + sizeof(vk::PipelineBinaryCachePrivateHeader) +
+                           entryCount * (sizeof(vk::BinaryCacheEntry) + entryContent.size());
+
+  auto addEntries = [&](cc::RelocatableCacheCreator &creator) {
+    for (size_t i = 0; i < entryCount; ++i) {
+      vk::BinaryCacheEntry entry = {};
+      entry.hashId.qwords[0] = i + 1;
+      entry.dataSize = entryContent.size();
+      CHECK(!llvm::errorToBool(creator.addStoredEntry(entry, entryContent)));
+    }
+  };
+
+  llvm::SmallVector<uint8_t> buffered(cacheSize);
+  {
+    auto creatorOrErr = cc::RelocatableCacheCreator::Create(deviceId, uuid, {}, buffered);
+    REQUIRE(!llvm::errorToBool(creatorOrErr.takeError()));
+    addEntries(*creatorOrErr);
+    size_t numEntries = 0;
+    size_t totalSize = 0;
+    CHECK(!llvm::errorToBool(creatorOrErr->finalize(&numEntries, &totalSize)));
+    CHECK(numEntries == entryCount);
+    CHECK(totalSize == cacheSize);
+  }
+
+  // Start the stream at a non-zero offset to check that the private header is patched relative to the stream start.
+  const llvm::StringRef prefix = "prefix";
+  llvm::SmallString<0> streamed;
+  llvm::raw_svector_ostream stream(streamed);
+  stream << prefix;
+  {
+    auto creatorOrErr = cc::RelocatableCacheCreator::CreateStreaming(deviceId, uuid, {}, stream);
+    REQUIRE(!llvm::errorToBool(creatorOrErr.takeError()));
+    addEntries(*creatorOrErr);
+    size_t numEntries = 0;
+    size_t totalSize = 0;
+    CHECK(!llvm::errorToBool(creatorOrErr->finalize(&numEntries, &totalSize)));
+    CHECK(numEntries == entryCount);
+    CHECK(totalSize == cacheSize);
+  }
+
+  REQUIRE(streamed.size() == prefix.size() + cacheSize);
+  CHECK(streamed.str().drop_front(prefix.size()) == llvm::toStringRef(buffered));
+}
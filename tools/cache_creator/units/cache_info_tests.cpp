@@ -26,7 +26,10 @@
 #include "units/doctest.h"
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <numeric>
 
 static bool consumeErrorToBool(llvm::Error err) {
   const bool isError = bool(err);
@@ -200,4 +203,185 @@ TEST_CASE("Valid blob w/ one entry") {
   CHECK(entry.entryBlob.data() == entryBlob.data());
   CHECK(entry.entryBlob.size() == entryBlob.size());
   CHECK(entry.entryMD5Sum == calculateMD5Sum(entryBlob));
+
+  // The entry content is not a PAL ELF, so it has no stage stats.
+  llvm::SmallVector<cc::HwStageStats, 1> stageStats;
+  CHECK(consumeErrorToBool(cc::readHwStageStats(entry, stageStats)));
+  CHECK(stageStats.empty());
+}
+
+TEST_CASE("Valid blob w/ one compressed entry") {
+  // A repetitive payload, large enough to be compressed by the serializer.
+  llvm::SmallVector<uint8_t> entryContent(1024);
+  for (size_t i = 0; i < entryContent.size(); ++i)
+    entryContent[i] = uint8_t(i % 16);
+
+  llvm::SmallVector<uint8_t> buffer(vk::VkPipelineCacheHeaderDataSize + sizeof(vk::PipelineBinaryCachePrivateHeader) +
+                                    sizeof(vk::BinaryCacheEntry) + entryContent.size());
+  auto *publicHeader = new (buffer.data()) vk::PipelineCacheHeaderData();
+  publicHeader->headerLength = vk::VkPipelineCacheHeaderDataSize;
+
+  vk::PipelineBinaryCacheSerializer serializer;
+  CHECK(serializer.Initialize(buffer.size() - vk::VkPipelineCacheHeaderDataSize,
+                              buffer.data() + vk::VkPipelineCacheHeaderDataSize,
+                              /* compressEntries = */ true) == Util::Result::Success);
+
+  vk::BinaryCacheEntry entry = {};
+  entry.dataSize = entryContent.size();
+  CHECK(serializer.AddPipelineBinary(&entry, entryContent.data()) == Util::Result::Success);
+
+  // Only the used part of the buffer forms the blob; the compressed entry is smaller than the raw one.
+  const auto *entryHeader = reinterpret_cast<const vk::BinaryCacheEntry *>(
+      buffer.data() + vk::VkPipelineCacheHeaderDataSize + sizeof(vk::PipelineBinaryCachePrivateHeader));
+  CHECK(vk::IsCompressedBinaryCacheEntry(*entryHeader));
+  const size_t storedSize = vk::GetBinaryCacheEntryStoredSize(*entryHeader);
+  CHECK(storedSize < entryContent.size());
+  buffer.resize(vk::VkPipelineCacheHeaderDataSize + sizeof(vk::PipelineBinaryCachePrivateHeader) +
+                sizeof(vk::BinaryCacheEntry) + storedSize);
+
+  auto blobPtr = llvm::MemoryBuffer::getMemBuffer(llvm::toStringRef(buffer), "valid_compressed_entry", false);
+  assert(blobPtr);
+
+  auto blobInfoOrErr = cc::CacheBlobInfo::create(*blobPtr);
+  CHECK(!consumeErrorToBool(blobInfoOrErr));
+
+  llvm::SmallVector<cc::BinaryCacheEntryInfo, 1> entries;
+  auto err = blobInfoOrErr->readBinaryCacheEntriesInfo(entries);
+  CHECK(!consumeErrorToBool(std::move(err)));
+  CHECK(entries.size() == 1);
+
+  // The MD5 sum is computed over the decompressed content so that it matches the source file.
+  cc::BinaryCacheEntryInfo &entryInfo = entries.front();
+  CHECK(entryInfo.isCompressed);
+  CHECK(entryInfo.entryBlob.size() == storedSize);
+  CHECK(entryInfo.decompressedSize == entryContent.size());
+  CHECK(entryInfo.entryMD5Sum == calculateMD5Sum(entryContent));
+}
+
+TEST_CASE("Copy compressed entry as stored") {
+  llvm::SmallVector<uint8_t> entryContent(1024);
+  for (size_t i = 0; i < entryContent.size(); ++i)
+    entryContent[i] = uint8_t(i % 16);
+
+  const size_t blobCapacity =
+      vk::VkPipelineCacheHeaderDataSize + sizeof(vk::PipelineBinaryCachePrivateHeader) + sizeof(vk::BinaryCacheEntry) +
+      entryContent.size();
+  llvm::SmallVector<uint8_t> srcBuffer(blobCapacity);
+  auto *srcPublicHeader = new (srcBuffer.data()) vk::PipelineCacheHeaderData();
+  srcPublicHeader->headerLength = vk::VkPipelineCacheHeaderDataSize;
+
+  vk::PipelineBinaryCacheSerializer srcSerializer;
+  CHECK(srcSerializer.Initialize(blobCapacity - vk::VkPipelineCacheHeaderDataSize,
+                                 srcBuffer.data() + vk::VkPipelineCacheHeaderDataSize,
+                                 /* compressEntries = */ true) == Util::Result::Success);
+
+  vk::BinaryCacheEntry entry = {};
+  entry.dataSize = entryContent.size();
+  CHECK(srcSerializer.AddPipelineBinary(&entry, entryContent.data()) == Util::Result::Success);
+  srcBuffer.resize(vk::VkPipelineCacheHeaderDataSize + srcSerializer.GetBytesUsed());
+
+  auto srcBlobPtr = llvm::MemoryBuffer::getMemBuffer(llvm::toStringRef(srcBuffer), "src_compressed_entry", false);
+  auto srcBlobInfoOrErr = cc::CacheBlobInfo::create(*srcBlobPtr);
+  CHECK(!consumeErrorToBool(srcBlobInfoOrErr));
+
+  // Only the entry locations are needed to copy the entries; no MD5 sums are computed.
+  llvm::SmallVector<cc::BinaryCacheEntryInfo, 1> srcEntries;
+  auto err = srcBlobInfoOrErr->readBinaryCacheEntriesInfo(srcEntries, /* computeMD5Sums = */ false);
+  CHECK(!consumeErrorToBool(std::move(err)));
+  CHECK(srcEntries.size() == 1);
+  CHECK(srcEntries.front().isCompressed);
+  CHECK(srcEntries.front().decompressedSize == entryContent.size());
+  CHECK(srcEntries.front().entryMD5Sum.empty());
+
+  // Copying the stored entry must produce the exact same bytes, even with compression disabled.
+  llvm::SmallVector<uint8_t> dstBuffer(srcBuffer.size());
+  vk::PipelineBinaryCacheSerializer dstSerializer;
+  CHECK(dstSerializer.Initialize(dstBuffer.size() - vk::VkPipelineCacheHeaderDataSize,
+                                 dstBuffer.data() + vk::VkPipelineCacheHeaderDataSize) == Util::Result::Success);
+  CHECK(dstSerializer.AddStoredPipelineBinary(srcEntries.front().entryHeader, srcEntries.front().entryBlob.data()) ==
+        Util::Result::Success);
+  CHECK(dstSerializer.GetBytesUsed() == srcSerializer.GetBytesUsed());
+
+  const size_t contentOffset = vk::VkPipelineCacheHeaderDataSize + sizeof(vk::PipelineBinaryCachePrivateHeader);
+  CHECK(std::equal(srcBuffer.begin() + contentOffset, srcBuffer.end(), dstBuffer.begin() + contentOffset));
+}
+
+// Creates an uncompressed entry info over `content`, with the header stored in `header`.
+static cc::BinaryCacheEntryInfo makeEntryInfo(vk::BinaryCacheEntry &header, uint64_t hash,
+                                              llvm::ArrayRef<uint8_t> content, size_t idx) {
+  header = {};
+  header.hashId.qwords[0] = hash;
+  header.dataSize = content.size();
+
+  cc::BinaryCacheEntryInfo info = {};
+  info.entryHeader = &header;
+  info.idx = idx;
+  info.entryBlob = content;
+  info.decompressedSize = content.size();
+  return info;
+}
+
+TEST_CASE("Cache stats") {
+  const llvm::SmallVector<uint8_t> smallContent(100, 1);
+  const llvm::SmallVector<uint8_t> otherSmallContent(100, 2);
+  const llvm::SmallVector<uint8_t> largeContent(5000, 3);
+
+  std::array<vk::BinaryCacheEntry, 4> headers = {};
+  llvm::SmallVector<cc::BinaryCacheEntryInfo> entries;
+  entries.push_back(makeEntryInfo(headers[0], 1, smallContent, 0));
+  entries.push_back(makeEntryInfo(headers[1], 2, otherSmallContent, 1));
+  entries.push_back(makeEntryInfo(headers[2], 3, largeContent, 2));
+  entries.push_back(makeEntryInfo(headers[3], 4, smallContent, 3));
+
+  const cc::CacheStats stats = cc::computeCacheStats(entries);
+  CHECK(stats.numEntries == 4);
+  CHECK(stats.numCompressedEntries == 0);
+  CHECK(stats.totalStoredSize == 5300);
+  // Entries with the same size but different content are not duplicates.
+  CHECK(stats.numDuplicateEntries == 1);
+  CHECK(stats.duplicateStoredSize == 100);
+  CHECK(stats.sizeHistogram[6] == 3);  // [64, 128)
+  CHECK(stats.sizeHistogram[12] == 1); // [4096, 8192)
+  CHECK(std::accumulate(stats.sizeHistogram.begin(), stats.sizeHistogram.end(), size_t(0)) == 4);
+}
+
+TEST_CASE("Cache diff") {
+  const llvm::SmallVector<uint8_t> contentA(100, 1);
+  const llvm::SmallVector<uint8_t> contentB(100, 2);
+  const llvm::SmallVector<uint8_t> contentC(300, 3);
+
+  std::array<vk::BinaryCacheEntry, 4> oldHeaders = {};
+  llvm::SmallVector<cc::BinaryCacheEntryInfo> oldEntries;
+  oldEntries.push_back(makeEntryInfo(oldHeaders[0], 1, contentA, 0)); // Unchanged
+  oldEntries.push_back(makeEntryInfo(oldHeaders[1], 2, contentA, 1)); // Changed
+  oldEntries.push_back(makeEntryInfo(oldHeaders[2], 3, contentA, 2)); // Resized
+  oldEntries.push_back(makeEntryInfo(oldHeaders[3], 4, contentA, 3)); // Removed
+
+  std::array<vk::BinaryCacheEntry, 4> newHeaders = {};
+  llvm::SmallVector<cc::BinaryCacheEntryInfo> newEntries;
+  newEntries.push_back(makeEntryInfo(newHeaders[0], 5, contentB, 0)); // Added
+  newEntries.push_back(makeEntryInfo(newHeaders[1], 3, contentC, 1));
+  newEntries.push_back(makeEntryInfo(newHeaders[2], 2, contentB, 2));
+  newEntries.push_back(makeEntryInfo(newHeaders[3], 1, contentA, 3));
+
+  const cc::CacheDiff diff = cc::diffCacheEntries(oldEntries, newEntries);
+  REQUIRE(diff.addedEntries.size() == 1);
+  CHECK(diff.addedEntries.front() == &newEntries[0]);
+  REQUIRE(diff.removedEntries.size() == 1);
+  CHECK(diff.removedEntries.front() == &oldEntries[3]);
+  REQUIRE(diff.resizedEntries.size() == 1);
+  CHECK(diff.resizedEntries.front().first == &oldEntries[2]);
+  CHECK(diff.resizedEntries.front().second == &newEntries[1]);
+  REQUIRE(diff.changedEntries.size() == 1);
+  CHECK(diff.changedEntries.front().first == &oldEntries[1]);
+  CHECK(diff.changedEntries.front().second == &newEntries[2]);
+  CHECK(diff.numUnchangedEntries == 1);
+
+  // Diffing a cache against itself finds no differences.
+  const cc::CacheDiff selfDiff = cc::diffCacheEntries(newEntries, newEntries);
+  CHECK(selfDiff.addedEntries.empty());
+  CHECK(selfDiff.removedEntries.empty());
+  CHECK(selfDiff.resizedEntries.empty());
+  CHECK(selfDiff.changedEntries.empty());
+  CHECK(selfDiff.numUnchangedEntries == newEntries.size());
 }
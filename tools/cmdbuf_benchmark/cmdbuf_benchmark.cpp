@@ -0,0 +1,864 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  cmdbuf_benchmark.cpp
+* @brief Measures the CPU cost of recording Vulkan commands.
+*
+* The benchmark creates a device on the first physical device exposed by the loader, builds the minimal objects needed
+* to record valid draws (an attachment-less render pass and a vertex-only pipeline with rasterizer discard), and then
+* times the recording of each command.  The common commands are recorded by 1, 4 and 16 threads at once, each with its
+* own command pool, to show how recording scales.  Command buffers are never submitted.  Results are printed one per
+* line as `<command> <parameters>: <ns> ns/call`, the median over all repeats and threads, to make them easy to compare
+* between runs.
+***********************************************************************************************************************
+*/
+#include "benchmark_support.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+using bench::Check;
+
+// SPIR-V for an empty vertex shader: "void main() {}".  Rasterization is discarded, so nothing has to be written.
+const uint32_t EmptyVertexShader[] =
+{
+    0x07230203, 0x00010000, 0x00000000, 0x00000005, 0x00000000, // Header, id bound 5
+    0x00020011, 0x00000001,                                     // OpCapability Shader
+    0x0003000e, 0x00000000, 0x00000001,                         // OpMemoryModel Logical GLSL450
+    0x0005000f, 0x00000000, 0x00000003, 0x6e69616d, 0x00000000, // OpEntryPoint Vertex %3 "main"
+    0x00020013, 0x00000001,                                     // %1 = OpTypeVoid
+    0x00030021, 0x00000002, 0x00000001,                         // %2 = OpTypeFunction %1
+    0x00050036, 0x00000001, 0x00000003, 0x00000000, 0x00000002, // %3 = OpFunction %1 None %2
+    0x000200f8, 0x00000004,                                     // %4 = OpLabel
+    0x000100fd,                                                 // OpReturn
+    0x00010038,                                                 // OpFunctionEnd
+};
+
+// Size of the buffers used by the copy and barrier measurements
+constexpr VkDeviceSize TransferBufferSize = 64 * 1024;
+
+// Size of the push constant block; each vkCmdPushConstants call updates one dword of it
+constexpr uint32_t PushConstantSize = 128;
+
+struct Options
+{
+    uint32_t callsPerCmdBuffer;  // Number of timed calls recorded into one command buffer
+    uint32_t repeats;            // Number of times each measurement is repeated
+    uint32_t maxDrawCount;       // Largest drawCount used by the indirect draw measurements
+    uint32_t maxThreads;         // Largest number of recording threads
+};
+
+// All objects shared by the measurements.
+struct Context : public bench::DeviceContext
+{
+    VkBuffer         indirectBuffer;  // Large enough for maxDrawCount indexed indirect commands
+    VkBuffer         countBuffer;     // Holds the GPU-side draw count
+    VkBuffer         indexBuffer;
+    VkBuffer         srcBuffer;       // Copy source
+    VkBuffer         dstBuffer;       // Copy destination and barrier target
+    VkBuffer         uniformBuffer;   // Referenced by the descriptor set
+    VkDeviceMemory   memory[6];
+
+    VkRenderPass          renderPass;
+    VkFramebuffer         framebuffer;
+    VkDescriptorSetLayout setLayout;
+    VkDescriptorPool      descriptorPool;
+    VkDescriptorSet       descriptorSet;
+    VkPipelineLayout      pipelineLayout;
+    VkPipeline            pipeline;
+
+    PFN_vkCmdDrawIndirectCount        pfnCmdDrawIndirectCount;
+    PFN_vkCmdDrawIndexedIndirectCount pfnCmdDrawIndexedIndirectCount;
+};
+
+// Records the timed portion of one measurement into an already begun command buffer.
+typedef void (*RecordFunc)(const Context& context, VkCommandBuffer cmdBuffer, uint32_t calls, uint32_t param);
+
+// One command to measure
+struct Measurement
+{
+    const char* pName;
+    RecordFunc  pfnRecord;
+    bool        inRenderPass;  // Whether the command is recorded inside a render pass with the pipeline bound
+};
+
+// =====================================================================================================================
+// Parses the command line.  Returns false if an argument is not recognized.
+bool ParseOptions(
+    int      argc,
+    char**   argv,
+    Options* pOptions)
+{
+    pOptions->callsPerCmdBuffer = 1000;
+    pOptions->repeats           = 20;
+    pOptions->maxDrawCount      = 65536;
+    pOptions->maxThreads        = 16;
+
+    const bench::ArgDesc args[] =
+    {
+        { "--calls",          bench::ArgType::Uint, &pOptions->callsPerCmdBuffer },
+        { "--repeats",        bench::ArgType::Uint, &pOptions->repeats },
+        { "--max-draw-count", bench::ArgType::Uint, &pOptions->maxDrawCount },
+        { "--max-threads",    bench::ArgType::Uint, &pOptions->maxThreads },
+    };
+
+    return bench::ParseArgs(argc,
+                            argv,
+                            args,
+                            sizeof(args) / sizeof(args[0]),
+                            "[--calls <n>] [--repeats <n>] [--max-draw-count <n>] [--max-threads <n>]");
+}
+
+// =====================================================================================================================
+// Creates a buffer of the given size and binds it to its own memory allocation.
+bool CreateBuffer(
+    Context*           pContext,
+    VkDeviceSize       size,
+    VkBufferUsageFlags usage,
+    VkBuffer*          pBuffer,
+    VkDeviceMemory*    pMemory)
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size        = size;
+    bufferInfo.usage       = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    bool success = Check(vkCreateBuffer(pContext->device, &bufferInfo, nullptr, pBuffer), "vkCreateBuffer");
+
+    if (success)
+    {
+        VkMemoryRequirements             reqs     = {};
+        VkPhysicalDeviceMemoryProperties memProps = {};
+
+        vkGetBufferMemoryRequirements(pContext->device, *pBuffer, &reqs);
+        vkGetPhysicalDeviceMemoryProperties(pContext->physicalDevice, &memProps);
+
+        // The contents are never read, so any supported type will do; prefer device local memory.
+        uint32_t typeIndex = UINT32_MAX;
+
+        for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
+        {
+            if ((reqs.memoryTypeBits & (1u << i)) != 0)
+            {
+                if (typeIndex == UINT32_MAX)
+                {
+                    typeIndex = i;
+                }
+
+                if ((memProps.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0)
+                {
+                    typeIndex = i;
+                    break;
+                }
+            }
+        }
+
+        VkMemoryAllocateInfo allocInfo = {};
+        allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize  = reqs.size;
+        allocInfo.memoryTypeIndex = typeIndex;
+
+        success = Check(vkAllocateMemory(pContext->device, &allocInfo, nullptr, pMemory), "vkAllocateMemory") &&
+                  Check(vkBindBufferMemory(pContext->device, *pBuffer, *pMemory, 0), "vkBindBufferMemory");
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Creates the instance, the device and all objects used by the measurements.
+bool CreateContext(
+    const Options& options,
+    Context*       pContext)
+{
+    VkPhysicalDeviceVulkan12Features features12 = {};
+    features12.sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.drawIndirectCount = VK_TRUE;
+
+    VkPhysicalDeviceFeatures features = {};
+    features.multiDrawIndirect = VK_TRUE;
+
+    if (bench::CreateContext("cmdbuf-benchmark", VK_QUEUE_GRAPHICS_BIT, &features12, &features, pContext) == false)
+    {
+        return false;
+    }
+
+    pContext->pfnCmdDrawIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndirectCount>(
+        vkGetDeviceProcAddr(pContext->device, "vkCmdDrawIndirectCount"));
+    pContext->pfnCmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCount>(
+        vkGetDeviceProcAddr(pContext->device, "vkCmdDrawIndexedIndirectCount"));
+
+    bool success =
+        CreateBuffer(pContext,
+                     VkDeviceSize(options.maxDrawCount) * sizeof(VkDrawIndexedIndirectCommand),
+                     VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                     &pContext->indirectBuffer,
+                     &pContext->memory[0]) &&
+        CreateBuffer(pContext,
+                     sizeof(uint32_t),
+                     VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                     &pContext->countBuffer,
+                     &pContext->memory[1]) &&
+        CreateBuffer(pContext,
+                     64 * sizeof(uint32_t),
+                     VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                     &pContext->indexBuffer,
+                     &pContext->memory[2]) &&
+        CreateBuffer(pContext,
+                     TransferBufferSize,
+                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                     &pContext->srcBuffer,
+                     &pContext->memory[3]) &&
+        CreateBuffer(pContext,
+                     TransferBufferSize,
+                     VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                     &pContext->dstBuffer,
+                     &pContext->memory[4]) &&
+        CreateBuffer(pContext,
+                     256,
+                     VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                     &pContext->uniformBuffer,
+                     &pContext->memory[5]);
+
+    if (success)
+    {
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+        VkRenderPassCreateInfo renderPassInfo = {};
+        renderPassInfo.sType        = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses   = &subpass;
+
+        success = Check(vkCreateRenderPass(pContext->device, &renderPassInfo, nullptr, &pContext->renderPass),
+                        "vkCreateRenderPass");
+    }
+
+    if (success)
+    {
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType      = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = pContext->renderPass;
+        framebufferInfo.width      = 64;
+        framebufferInfo.height     = 64;
+        framebufferInfo.layers     = 1;
+
+        success = Check(vkCreateFramebuffer(pContext->device, &framebufferInfo, nullptr, &pContext->framebuffer),
+                        "vkCreateFramebuffer");
+    }
+
+    if (success)
+    {
+        VkDescriptorSetLayoutBinding binding = {};
+        binding.binding         = 0;
+        binding.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        binding.descriptorCount = 1;
+        binding.stageFlags      = VK_SHADER_STAGE_ALL_GRAPHICS;
+
+        VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+        setLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        setLayoutInfo.bindingCount = 1;
+        setLayoutInfo.pBindings    = &binding;
+
+        success = Check(vkCreateDescriptorSetLayout(pContext->device, &setLayoutInfo, nullptr, &pContext->setLayout),
+                        "vkCreateDescriptorSetLayout");
+    }
+
+    if (success)
+    {
+        VkDescriptorPoolSize poolSize = {};
+        poolSize.type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        poolSize.descriptorCount = 1;
+
+        VkDescriptorPoolCreateInfo poolInfo = {};
+        poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets       = 1;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes    = &poolSize;
+
+        success = Check(vkCreateDescriptorPool(pContext->device, &poolInfo, nullptr, &pContext->descriptorPool),
+                        "vkCreateDescriptorPool");
+    }
+
+    if (success)
+    {
+        VkDescriptorSetAllocateInfo allocInfo = {};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool     = pContext->descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts        = &pContext->setLayout;
+
+        success = Check(vkAllocateDescriptorSets(pContext->device, &allocInfo, &pContext->descriptorSet),
+                        "vkAllocateDescriptorSets");
+    }
+
+    if (success)
+    {
+        VkDescriptorBufferInfo bufferInfo = {};
+        bufferInfo.buffer = pContext->uniformBuffer;
+        bufferInfo.range  = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet write = {};
+        write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet          = pContext->descriptorSet;
+        write.descriptorCount = 1;
+        write.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        write.pBufferInfo     = &bufferInfo;
+
+        vkUpdateDescriptorSets(pContext->device, 1, &write, 0, nullptr);
+
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+        pushConstantRange.size       = PushConstantSize;
+
+        VkPipelineLayoutCreateInfo layoutInfo = {};
+        layoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layoutInfo.setLayoutCount         = 1;
+        layoutInfo.pSetLayouts            = &pContext->setLayout;
+        layoutInfo.pushConstantRangeCount = 1;
+        layoutInfo.pPushConstantRanges    = &pushConstantRange;
+
+        success = Check(vkCreatePipelineLayout(pContext->device, &layoutInfo, nullptr, &pContext->pipelineLayout),
+                        "vkCreatePipelineLayout");
+    }
+
+    if (success)
+    {
+        VkShaderModuleCreateInfo moduleInfo = {};
+        moduleInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = sizeof(EmptyVertexShader);
+        moduleInfo.pCode    = EmptyVertexShader;
+
+        VkShaderModule module = VK_NULL_HANDLE;
+
+        success = Check(vkCreateShaderModule(pContext->device, &moduleInfo, nullptr, &module), "vkCreateShaderModule");
+
+        if (success)
+        {
+            VkPipelineShaderStageCreateInfo stage = {};
+            stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stage.stage  = VK_SHADER_STAGE_VERTEX_BIT;
+            stage.module = module;
+            stage.pName  = "main";
+
+            VkPipelineVertexInputStateCreateInfo vertexInput = {};
+            vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+            VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+            inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+            inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+
+            VkPipelineRasterizationStateCreateInfo rasterization = {};
+            rasterization.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+            rasterization.rasterizerDiscardEnable = VK_TRUE;
+            rasterization.polygonMode             = VK_POLYGON_MODE_FILL;
+            rasterization.lineWidth               = 1.0f;
+
+            VkGraphicsPipelineCreateInfo pipelineInfo = {};
+            pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            pipelineInfo.stageCount          = 1;
+            pipelineInfo.pStages             = &stage;
+            pipelineInfo.pVertexInputState   = &vertexInput;
+            pipelineInfo.pInputAssemblyState = &inputAssembly;
+            pipelineInfo.pRasterizationState = &rasterization;
+            pipelineInfo.layout              = pContext->pipelineLayout;
+            pipelineInfo.renderPass          = pContext->renderPass;
+
+            success = Check(vkCreateGraphicsPipelines(pContext->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
+                                                      &pContext->pipeline),
+                            "vkCreateGraphicsPipelines");
+
+            vkDestroyShaderModule(pContext->device, module, nullptr);
+        }
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Destroys everything created by CreateContext.  Safe to call on a partially created context.
+void DestroyContext(
+    Context* pContext)
+{
+    if (pContext->device != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(pContext->device, pContext->pipeline, nullptr);
+        vkDestroyPipelineLayout(pContext->device, pContext->pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(pContext->device, pContext->descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(pContext->device, pContext->setLayout, nullptr);
+        vkDestroyFramebuffer(pContext->device, pContext->framebuffer, nullptr);
+        vkDestroyRenderPass(pContext->device, pContext->renderPass, nullptr);
+        vkDestroyBuffer(pContext->device, pContext->uniformBuffer, nullptr);
+        vkDestroyBuffer(pContext->device, pContext->dstBuffer, nullptr);
+        vkDestroyBuffer(pContext->device, pContext->srcBuffer, nullptr);
+        vkDestroyBuffer(pContext->device, pContext->indexBuffer, nullptr);
+        vkDestroyBuffer(pContext->device, pContext->countBuffer, nullptr);
+        vkDestroyBuffer(pContext->device, pContext->indirectBuffer, nullptr);
+
+        for (VkDeviceMemory memory : pContext->memory)
+        {
+            vkFreeMemory(pContext->device, memory, nullptr);
+        }
+    }
+
+    bench::DestroyContext(pContext);
+}
+
+// =====================================================================================================================
+void RecordDrawIndirect(
+    const Context&  context,
+    VkCommandBuffer cmdBuffer,
+    uint32_t        calls,
+    uint32_t        drawCount)
+{
+    for (uint32_t i = 0; i < calls; ++i)
+    {
+        vkCmdDrawIndirect(cmdBuffer, context.indirectBuffer, 0, drawCount, sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+
+// =====================================================================================================================
+void RecordDrawIndexedIndirect(
+    const Context&  context,
+    VkCommandBuffer cmdBuffer,
+    uint32_t        calls,
+    uint32_t        drawCount)
+{
+    for (uint32_t i = 0; i < calls; ++i)
+    {
+        vkCmdDrawIndexedIndirect(cmdBuffer, context.indirectBuffer, 0, drawCount,
+                                 sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+
+// =====================================================================================================================
+void RecordDrawIndirectCount(
+    const Context&  context,
+    VkCommandBuffer cmdBuffer,
+    uint32_t        calls,
+    uint32_t        maxDrawCount)
+{
+    for (uint32_t i = 0; i < calls; ++i)
+    {
+        context.pfnCmdDrawIndirectCount(cmdBuffer, context.indirectBuffer, 0, context.countBuffer, 0, maxDrawCount,
+                                        sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+
+// =====================================================================================================================
+void RecordDrawIndexedIndirectCount(
+    const Context&  context,
+    VkCommandBuffer cmdBuffer,
+    uint32_t        calls,
+    uint32_t        maxDrawCount)
+{
+    for (uint32_t i = 0; i < calls; ++i)
+    {
+        context.pfnCmdDrawIndexedIndirectCount(cmdBuffer, context.indirectBuffer, 0, context.countBuffer, 0,
+                                               maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+
+
+// =====================================================================================================================
+void RecordDraw(
+    const Context&  /* context */,
+    VkCommandBuffer cmdBuffer,
+    uint32_t        calls,
+    uint32_t        /* param */)
+{
+    for (uint32_t i = 0; i < calls; ++i)
+    {
+        vkCmdDraw(cmdBuffer, 3, 1, 0, 0);
+    }
+}
+
+// =====================================================================================================================
+void RecordDrawIndexed(
+    const Context&  /* context */,
+    VkCommandBuffer cmdBuffer,
+    uint32_t        calls,
+    uint32_t        /* param */)
+{
+    for (uint32_t i = 0; i < calls; ++i)
+    {
+        vkCmdDrawIndexed(cmdBuffer, 3, 1, 0, 0, 0);
+    }
+}
+
+// =====================================================================================================================
+void RecordBindDescriptorSets(
+    const Context&  context,
+    VkCommandBuffer cmdBuffer,
+    uint32_t        calls,
+    uint32_t        /* param */)
+{
+    for (uint32_t i = 0; i < calls; ++i)
+    {
+        vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, context.pipelineLayout, 0, 1,
+                                &context.descriptorSet, 0, nullptr);
+    }
+}
+
+// =====================================================================================================================
+// Every call writes a new value so that the driver can't skip the update as redundant.
+void RecordPushConstants(
+    const Context&  context,
+    VkCommandBuffer cmdBuffer,
+    uint32_t        calls,
+    uint32_t        /* param */)
+{
+    constexpr uint32_t DwordCount = PushConstantSize / sizeof(uint32_t);
+
+    for (uint32_t i = 0; i < calls; ++i)
+    {
+        vkCmdPushConstants(cmdBuffer, context.pipelineLayout, VK_SHADER_STAGE_ALL_GRAPHICS,
+                           (i % DwordCount) * sizeof(uint32_t), sizeof(uint32_t), &i);
+    }
+}
+
+// =====================================================================================================================
+void RecordPipelineBarrier(
+    const Context&  context,
+    VkCommandBuffer cmdBuffer,
+    uint32_t        calls,
+    uint32_t        /* param */)
+{
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask       = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer              = context.dstBuffer;
+    barrier.size                = VK_WHOLE_SIZE;
+
+    for (uint32_t i = 0; i < calls; ++i)
+    {
+        vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr, 1, &barrier, 0, nullptr);
+    }
+}
+
+// =====================================================================================================================
+// Each call is one begin/end pair of an empty render pass.
+void RecordRenderPass(
+    const Context&  context,
+    VkCommandBuffer cmdBuffer,
+    uint32_t        calls,
+    uint32_t        /* param */)
+{
+    VkRenderPassBeginInfo renderPassBegin = {};
+    renderPassBegin.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBegin.renderPass        = context.renderPass;
+    renderPassBegin.framebuffer       = context.framebuffer;
+    renderPassBegin.renderArea.extent = { 64, 64 };
+
+    for (uint32_t i = 0; i < calls; ++i)
+    {
+        vkCmdBeginRenderPass(cmdBuffer, &renderPassBegin, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdEndRenderPass(cmdBuffer);
+    }
+}
+
+// =====================================================================================================================
+// Copies 256 bytes per call, walking through the buffers so that consecutive copies don't overlap.
+void RecordCopyBuffer(
+    const Context&  context,
+    VkCommandBuffer cmdBuffer,
+    uint32_t        calls,
+    uint32_t        /* param */)
+{
+    constexpr VkDeviceSize CopySize  = 256;
+    constexpr uint32_t     CopySlots = static_cast<uint32_t>(TransferBufferSize / CopySize);
+
+    for (uint32_t i = 0; i < calls; ++i)
+    {
+        VkBufferCopy region = {};
+        region.srcOffset = (i % CopySlots) * CopySize;
+        region.dstOffset = region.srcOffset;
+        region.size      = CopySize;
+
+        vkCmdCopyBuffer(cmdBuffer, context.srcBuffer, context.dstBuffer, 1, &region);
+    }
+}
+
+// =====================================================================================================================
+// State shared by the threads which record one measurement in parallel
+struct ThreadSetup
+{
+    const Context*        pContext;
+    const Options*        pOptions;
+    const Measurement*    pMeasurement;
+    uint32_t              param;
+    uint32_t              threadCount;
+    std::atomic<uint32_t> readyCount;   // Number of threads which are ready to start recording
+};
+
+// =====================================================================================================================
+// Records options.callsPerCmdBuffer calls of the measured command, options.repeats times, into a command buffer of
+// the calling thread's own pool and appends the ns/call of every repeat to pSamples.  Only the calls themselves are
+// timed; begin, setup and end of the command buffer are not.
+void RecordOnThread(
+    ThreadSetup*         pSetup,
+    std::vector<double>* pSamples)
+{
+    const Context&     context     = *pSetup->pContext;
+    const Options&     options     = *pSetup->pOptions;
+    const Measurement& measurement = *pSetup->pMeasurement;
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = context.queueFamilyIndex;
+
+    VkCommandPool   pool      = VK_NULL_HANDLE;
+    VkCommandBuffer cmdBuffer = VK_NULL_HANDLE;
+
+    bool success = Check(vkCreateCommandPool(context.device, &poolInfo, nullptr, &pool), "vkCreateCommandPool");
+
+    if (success)
+    {
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool        = pool;
+        allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+
+        success = Check(vkAllocateCommandBuffers(context.device, &allocInfo, &cmdBuffer), "vkAllocateCommandBuffers");
+    }
+
+    // Wait for every thread to finish its setup so that the timed sections overlap.  A thread which failed still
+    // checks in, otherwise the others would wait forever.
+    pSetup->readyCount.fetch_add(1);
+
+    while (pSetup->readyCount.load() < pSetup->threadCount)
+    {
+        std::this_thread::yield();
+    }
+
+    if (success)
+    {
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        VkRenderPassBeginInfo renderPassBegin = {};
+        renderPassBegin.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBegin.renderPass        = context.renderPass;
+        renderPassBegin.framebuffer       = context.framebuffer;
+        renderPassBegin.renderArea.extent = { 64, 64 };
+
+        for (uint32_t repeat = 0; repeat < options.repeats; ++repeat)
+        {
+            vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+
+            if (measurement.inRenderPass)
+            {
+                vkCmdBeginRenderPass(cmdBuffer, &renderPassBegin, VK_SUBPASS_CONTENTS_INLINE);
+                vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, context.pipeline);
+                vkCmdBindIndexBuffer(cmdBuffer, context.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+            }
+
+            const Clock::time_point start = Clock::now();
+
+            measurement.pfnRecord(context, cmdBuffer, options.callsPerCmdBuffer, pSetup->param);
+
+            const Clock::time_point end = Clock::now();
+
+            if (measurement.inRenderPass)
+            {
+                vkCmdEndRenderPass(cmdBuffer);
+            }
+
+            vkEndCommandBuffer(cmdBuffer);
+            vkResetCommandBuffer(cmdBuffer, 0);
+
+            pSamples->push_back(std::chrono::duration<double, std::nano>(end - start).count() /
+                                options.callsPerCmdBuffer);
+        }
+    }
+
+    if (pool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(context.device, pool, nullptr);
+    }
+}
+
+// =====================================================================================================================
+// Runs one measurement on threadCount threads at once and returns the median ns/call over all repeats of all threads.
+double MeasureCommand(
+    const Context&     context,
+    const Options&     options,
+    const Measurement& measurement,
+    uint32_t           param,
+    uint32_t           threadCount)
+{
+    ThreadSetup setup = {};
+    setup.pContext     = &context;
+    setup.pOptions     = &options;
+    setup.pMeasurement = &measurement;
+    setup.param        = param;
+    setup.threadCount  = threadCount;
+    setup.readyCount   = 0;
+
+    std::vector<std::vector<double>> threadSamples(threadCount);
+    std::vector<std::thread>         threads;
+
+    for (uint32_t i = 1; i < threadCount; ++i)
+    {
+        threads.emplace_back(RecordOnThread, &setup, &threadSamples[i]);
+    }
+
+    // The calling thread records too.
+    RecordOnThread(&setup, &threadSamples[0]);
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::vector<double> samples;
+
+    for (const std::vector<double>& threadSample : threadSamples)
+    {
+        samples.insert(samples.end(), threadSample.begin(), threadSample.end());
+    }
+
+    double median = 0.0;
+
+    if (samples.empty() == false)
+    {
+        std::nth_element(samples.begin(), samples.begin() + (samples.size() / 2), samples.end());
+        median = samples[samples.size() / 2];
+    }
+
+    return median;
+}
+
+// =====================================================================================================================
+// The common per-draw and per-pass commands, recorded by 1, 4 and 16 threads at once.  With per-thread pools the cost
+// per call should not grow with the thread count; if it does, recording is contending on something shared.
+void RunCommonCommandBenchmarks(
+    const Context& context,
+    const Options& options)
+{
+    const Measurement measurements[] =
+    {
+        { "vkCmdDraw",                               RecordDraw,               true },
+        { "vkCmdDrawIndexed",                        RecordDrawIndexed,        true },
+        { "vkCmdBindDescriptorSets",                 RecordBindDescriptorSets, false },
+        { "vkCmdPushConstants",                      RecordPushConstants,      false },
+        { "vkCmdPipelineBarrier",                    RecordPipelineBarrier,    false },
+        { "vkCmdBeginRenderPass+vkCmdEndRenderPass", RecordRenderPass,         false },
+        { "vkCmdCopyBuffer",                         RecordCopyBuffer,         false },
+    };
+
+    const uint32_t threadCounts[] = { 1, 4, 16 };
+
+    for (const Measurement& measurement : measurements)
+    {
+        for (uint32_t threadCount : threadCounts)
+        {
+            if (threadCount <= options.maxThreads)
+            {
+                const double nsPerCall = MeasureCommand(context, options, measurement, 0, threadCount);
+
+                printf("%s threads=%u: %.1f ns/call\n", measurement.pName, threadCount, nsPerCall);
+            }
+        }
+    }
+}
+
+// =====================================================================================================================
+// Indirect draws record a single multi-draw packet no matter how many draws they launch, so their cost per call should
+// stay flat as drawCount grows.
+void RunIndirectDrawBenchmarks(
+    const Context& context,
+    const Options& options)
+{
+    const Measurement measurements[] =
+    {
+        { "vkCmdDrawIndirect",             RecordDrawIndirect,             true },
+        { "vkCmdDrawIndexedIndirect",      RecordDrawIndexedIndirect,      true },
+        { "vkCmdDrawIndirectCount",        RecordDrawIndirectCount,        true },
+        { "vkCmdDrawIndexedIndirectCount", RecordDrawIndexedIndirectCount, true },
+    };
+
+    for (const Measurement& measurement : measurements)
+    {
+        for (uint32_t drawCount = 1; drawCount <= options.maxDrawCount; drawCount *= 16)
+        {
+            const double nsPerCall = MeasureCommand(context, options, measurement, drawCount, 1);
+
+            printf("%s drawCount=%u: %.1f ns/call\n", measurement.pName, drawCount, nsPerCall);
+
+            if (drawCount > (UINT32_MAX / 16))
+            {
+                break;
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+// =====================================================================================================================
+int main(
+    int    argc,
+    char** argv)
+{
+    Options options = {};
+    Context context = {};
+
+    if (ParseOptions(argc, argv, &options) == false)
+    {
+        return EXIT_FAILURE;
+    }
+
+    const bool success = CreateContext(options, &context);
+
+    if (success)
+    {
+        RunCommonCommandBenchmarks(context, options);
+        RunIndirectDrawBenchmarks(context, options);
+    }
+
+    DestroyContext(&context);
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,807 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  descriptor_benchmark.cpp
+* @brief Measures the CPU cost of allocating, writing, template-updating and copying descriptor sets.
+*
+* The benchmark creates a device on the first physical device exposed by the loader, one buffer, texel buffer view,
+* image view and sampler to point descriptors at, and a set layout and update template per descriptor type.  Each
+* measurement runs on 1, 8 and 32 threads at once, every thread with its own descriptor pool and sets, so that the cost
+* per descriptor should not grow with the thread count unless the driver contends on something shared:
+*
+* - vkAllocateDescriptorSets+vkFreeDescriptorSets: sets of a typical mixed layout allocated and freed in batches.
+* - vkUpdateDescriptorSets: one write of a whole binding array per call, per descriptor type.
+* - vkUpdateDescriptorSetWithTemplate: the same update through a template.
+* - vkUpdateDescriptorSets (copy): the whole binding array copied from another set.
+*
+* Each update is compared against a memcpy roofline: copying the hardware descriptors of the same binding array, at
+* their usual sizes on AMD GPUs, with the same number of threads.  Results are printed one per line as
+* `<command> <type> threads=<n>: <ns> ns/descriptor (<x>x memcpy)`, the median over all repeats and threads.
+***********************************************************************************************************************
+*/
+#include "benchmark_support.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+using bench::Check;
+
+// Sets allocated and freed together by the allocation measurement
+constexpr uint32_t ChurnBatchSize = 32;
+
+// Size of the buffer the buffer descriptors point at
+constexpr VkDeviceSize BufferSize = 64 * 1024;
+
+struct Options
+{
+    uint32_t callsPerRepeat;    // Number of timed calls per repeat
+    uint32_t repeats;           // Number of times each measurement is repeated
+    uint32_t descriptorCount;   // Descriptors in the binding array of each set
+    uint32_t maxThreads;        // Largest number of updating threads
+};
+
+// A descriptor type and the size of its hardware descriptor, which is what an update has to write at the least
+struct DescriptorTypeInfo
+{
+    VkDescriptorType type;
+    const char*      pName;
+    uint32_t         hwSize;    // Bytes per descriptor on AMD GPUs
+};
+
+const DescriptorTypeInfo DescriptorTypes[] =
+{
+    { VK_DESCRIPTOR_TYPE_SAMPLER,                "SAMPLER",                16 },
+    { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, "COMBINED_IMAGE_SAMPLER", 48 },
+    { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,          "SAMPLED_IMAGE",          32 },
+    { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          "STORAGE_IMAGE",          32 },
+    { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,   "UNIFORM_TEXEL_BUFFER",   16 },
+    { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,   "STORAGE_TEXEL_BUFFER",   16 },
+    { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         "UNIFORM_BUFFER",         16 },
+    { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         "STORAGE_BUFFER",         16 },
+    { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, "UNIFORM_BUFFER_DYNAMIC", 16 },
+    { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, "STORAGE_BUFFER_DYNAMIC", 16 },
+};
+
+constexpr uint32_t DescriptorTypeCount = sizeof(DescriptorTypes) / sizeof(DescriptorTypes[0]);
+
+// One entry of the data passed to vkUpdateDescriptorSetWithTemplate
+union TemplateEntry
+{
+    VkDescriptorImageInfo  image;
+    VkDescriptorBufferInfo buffer;
+    VkBufferView           bufferView;
+};
+
+// All objects shared by the measurements.
+struct Context : public bench::DeviceContext
+{
+    VkBuffer         buffer;          // Target of the buffer descriptors
+    VkBuffer         texelBuffer;     // Target of the texel buffer views
+    VkImage          image;
+    VkDeviceMemory   memory[3];
+    VkBufferView     bufferView;
+    VkImageView      imageView;
+    VkSampler        sampler;
+
+    uint32_t                   descriptorCounts[DescriptorTypeCount];  // Size of the binding array of each type
+    VkDescriptorSetLayout      setLayouts[DescriptorTypeCount];        // One binding array per descriptor type
+    VkDescriptorUpdateTemplate templates[DescriptorTypeCount];         // Updates the whole binding array
+    VkDescriptorSetLayout      churnLayout;                            // Typical mixed layout for the allocation churn
+};
+
+enum class Operation : uint32_t
+{
+    AllocFree,   // vkAllocateDescriptorSets+vkFreeDescriptorSets
+    Write,       // vkUpdateDescriptorSets with writes
+    Template,    // vkUpdateDescriptorSetWithTemplate
+    Copy,        // vkUpdateDescriptorSets with copies
+    Memcpy,      // Roofline
+};
+
+// State shared by the threads which run one measurement in parallel
+struct ThreadSetup
+{
+    const Context*            pContext;
+    const Options*            pOptions;
+    Operation                 operation;
+    const DescriptorTypeInfo* pType;
+    uint32_t                  typeIndex;
+    uint32_t                  threadCount;
+    std::atomic<uint32_t>     readyCount;   // Number of threads which are ready to start
+};
+
+// =====================================================================================================================
+// Parses the command line.  Returns false if an argument is not recognized.
+bool ParseOptions(
+    int      argc,
+    char**   argv,
+    Options* pOptions)
+{
+    pOptions->callsPerRepeat  = 1000;
+    pOptions->repeats         = 20;
+    pOptions->descriptorCount = 16;
+    pOptions->maxThreads      = 32;
+
+    const bench::ArgDesc args[] =
+    {
+        { "--calls",       bench::ArgType::Uint, &pOptions->callsPerRepeat },
+        { "--repeats",     bench::ArgType::Uint, &pOptions->repeats },
+        { "--descriptors", bench::ArgType::Uint, &pOptions->descriptorCount },
+        { "--max-threads", bench::ArgType::Uint, &pOptions->maxThreads },
+    };
+
+    return bench::ParseArgs(argc,
+                            argv,
+                            args,
+                            sizeof(args) / sizeof(args[0]),
+                            "[--calls <n>] [--repeats <n>] [--descriptors <n>] [--max-threads <n>]");
+}
+
+// =====================================================================================================================
+// Allocates memory for a buffer or image requirement and returns the memory type, preferring device local memory.
+bool AllocateMemory(
+    Context*                    pContext,
+    const VkMemoryRequirements& reqs,
+    VkDeviceMemory*             pMemory)
+{
+    VkPhysicalDeviceMemoryProperties memProps = {};
+    vkGetPhysicalDeviceMemoryProperties(pContext->physicalDevice, &memProps);
+
+    // The contents are never read, so any supported type will do.
+    uint32_t typeIndex = UINT32_MAX;
+
+    for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
+    {
+        if ((reqs.memoryTypeBits & (1u << i)) != 0)
+        {
+            if (typeIndex == UINT32_MAX)
+            {
+                typeIndex = i;
+            }
+
+            if ((memProps.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0)
+            {
+                typeIndex = i;
+                break;
+            }
+        }
+    }
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize  = reqs.size;
+    allocInfo.memoryTypeIndex = typeIndex;
+
+    return Check(vkAllocateMemory(pContext->device, &allocInfo, nullptr, pMemory), "vkAllocateMemory");
+}
+
+// =====================================================================================================================
+// Creates a buffer of the given size and binds it to its own memory allocation.
+bool CreateBuffer(
+    Context*           pContext,
+    VkDeviceSize       size,
+    VkBufferUsageFlags usage,
+    VkBuffer*          pBuffer,
+    VkDeviceMemory*    pMemory)
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size        = size;
+    bufferInfo.usage       = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    bool success = Check(vkCreateBuffer(pContext->device, &bufferInfo, nullptr, pBuffer), "vkCreateBuffer");
+
+    if (success)
+    {
+        VkMemoryRequirements reqs = {};
+        vkGetBufferMemoryRequirements(pContext->device, *pBuffer, &reqs);
+
+        success = AllocateMemory(pContext, reqs, pMemory) &&
+                  Check(vkBindBufferMemory(pContext->device, *pBuffer, *pMemory, 0), "vkBindBufferMemory");
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Creates the image the image descriptors point at, with its view.
+bool CreateImage(
+    Context* pContext)
+{
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+    imageInfo.format        = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.extent        = { 64, 64, 1 };
+    imageInfo.mipLevels     = 1;
+    imageInfo.arrayLayers   = 1;
+    imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage         = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    bool success = Check(vkCreateImage(pContext->device, &imageInfo, nullptr, &pContext->image), "vkCreateImage");
+
+    if (success)
+    {
+        VkMemoryRequirements reqs = {};
+        vkGetImageMemoryRequirements(pContext->device, pContext->image, &reqs);
+
+        success = AllocateMemory(pContext, reqs, &pContext->memory[2]) &&
+                  Check(vkBindImageMemory(pContext->device, pContext->image, pContext->memory[2], 0),
+                        "vkBindImageMemory");
+    }
+
+    if (success)
+    {
+        VkImageViewCreateInfo viewInfo = {};
+        viewInfo.sType                       = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image                       = pContext->image;
+        viewInfo.viewType                    = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format                      = imageInfo.format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        success = Check(vkCreateImageView(pContext->device, &viewInfo, nullptr, &pContext->imageView),
+                        "vkCreateImageView");
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Creates the set layouts and update templates of all descriptor types, and the layout used by the allocation churn.
+bool CreateLayouts(
+    const Options& options,
+    Context*       pContext)
+{
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(pContext->physicalDevice, &properties);
+
+    bool success = true;
+
+    for (uint32_t i = 0; success && (i < DescriptorTypeCount); ++i)
+    {
+        // Dynamic buffers have a much lower per-set limit than the other types
+        uint32_t count = options.descriptorCount;
+
+        if (DescriptorTypes[i].type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+        {
+            count = std::min(count, properties.limits.maxDescriptorSetUniformBuffersDynamic);
+        }
+        else if (DescriptorTypes[i].type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+        {
+            count = std::min(count, properties.limits.maxDescriptorSetStorageBuffersDynamic);
+        }
+
+        pContext->descriptorCounts[i] = count;
+
+        VkDescriptorSetLayoutBinding binding = {};
+        binding.binding         = 0;
+        binding.descriptorType  = DescriptorTypes[i].type;
+        binding.descriptorCount = count;
+        binding.stageFlags      = VK_SHADER_STAGE_ALL;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+        layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = 1;
+        layoutInfo.pBindings    = &binding;
+
+        success = Check(vkCreateDescriptorSetLayout(pContext->device, &layoutInfo, nullptr, &pContext->setLayouts[i]),
+                        "vkCreateDescriptorSetLayout");
+
+        if (success)
+        {
+            VkDescriptorUpdateTemplateEntry entry = {};
+            entry.dstBinding      = 0;
+            entry.descriptorCount = count;
+            entry.descriptorType  = DescriptorTypes[i].type;
+            entry.stride          = sizeof(TemplateEntry);
+
+            VkDescriptorUpdateTemplateCreateInfo templateInfo = {};
+            templateInfo.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+            templateInfo.descriptorUpdateEntryCount = 1;
+            templateInfo.pDescriptorUpdateEntries   = &entry;
+            templateInfo.templateType               = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+            templateInfo.descriptorSetLayout        = pContext->setLayouts[i];
+
+            success = Check(vkCreateDescriptorUpdateTemplate(pContext->device, &templateInfo, nullptr,
+                                                             &pContext->templates[i]),
+                            "vkCreateDescriptorUpdateTemplate");
+        }
+    }
+
+    if (success)
+    {
+        VkDescriptorSetLayoutBinding bindings[3] = {};
+        bindings[0].binding         = 0;
+        bindings[0].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags      = VK_SHADER_STAGE_ALL;
+        bindings[1].binding         = 1;
+        bindings[1].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[1].descriptorCount = 4;
+        bindings[1].stageFlags      = VK_SHADER_STAGE_ALL;
+        bindings[2].binding         = 2;
+        bindings[2].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[2].descriptorCount = 2;
+        bindings[2].stageFlags      = VK_SHADER_STAGE_ALL;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+        layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = 3;
+        layoutInfo.pBindings    = bindings;
+
+        success = Check(vkCreateDescriptorSetLayout(pContext->device, &layoutInfo, nullptr, &pContext->churnLayout),
+                        "vkCreateDescriptorSetLayout");
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Creates the instance, the device and all objects used by the measurements.
+bool CreateContext(
+    const Options& options,
+    Context*       pContext)
+{
+    // Descriptor updates don't need a particular queue; the first family will do.
+    if (bench::CreateContext("descriptor-benchmark", 0, nullptr, nullptr, pContext) == false)
+    {
+        return false;
+    }
+
+    bool success =
+        CreateBuffer(pContext,
+                     BufferSize,
+                     VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                     &pContext->buffer,
+                     &pContext->memory[0]) &&
+        CreateBuffer(pContext,
+                     BufferSize,
+                     VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT,
+                     &pContext->texelBuffer,
+                     &pContext->memory[1]) &&
+        CreateImage(pContext);
+
+    if (success)
+    {
+        // R32_UINT supports both uniform and storage texel buffers on every implementation
+        VkBufferViewCreateInfo viewInfo = {};
+        viewInfo.sType  = VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO;
+        viewInfo.buffer = pContext->texelBuffer;
+        viewInfo.format = VK_FORMAT_R32_UINT;
+        viewInfo.range  = VK_WHOLE_SIZE;
+
+        success = Check(vkCreateBufferView(pContext->device, &viewInfo, nullptr, &pContext->bufferView),
+                        "vkCreateBufferView");
+    }
+
+    if (success)
+    {
+        VkSamplerCreateInfo samplerInfo = {};
+        samplerInfo.sType     = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.maxLod    = 1.0f;
+
+        success = Check(vkCreateSampler(pContext->device, &samplerInfo, nullptr, &pContext->sampler),
+                        "vkCreateSampler");
+    }
+
+    return success && CreateLayouts(options, pContext);
+}
+
+// =====================================================================================================================
+// Destroys everything created by CreateContext.  Safe to call on a partially created context.
+void DestroyContext(
+    Context* pContext)
+{
+    if (pContext->device != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorSetLayout(pContext->device, pContext->churnLayout, nullptr);
+
+        for (uint32_t i = 0; i < DescriptorTypeCount; ++i)
+        {
+            vkDestroyDescriptorUpdateTemplate(pContext->device, pContext->templates[i], nullptr);
+            vkDestroyDescriptorSetLayout(pContext->device, pContext->setLayouts[i], nullptr);
+        }
+
+        vkDestroySampler(pContext->device, pContext->sampler, nullptr);
+        vkDestroyImageView(pContext->device, pContext->imageView, nullptr);
+        vkDestroyBufferView(pContext->device, pContext->bufferView, nullptr);
+        vkDestroyImage(pContext->device, pContext->image, nullptr);
+        vkDestroyBuffer(pContext->device, pContext->texelBuffer, nullptr);
+        vkDestroyBuffer(pContext->device, pContext->buffer, nullptr);
+
+        for (VkDeviceMemory memory : pContext->memory)
+        {
+            vkFreeMemory(pContext->device, memory, nullptr);
+        }
+    }
+
+    bench::DestroyContext(pContext);
+}
+
+// =====================================================================================================================
+// Fills in the update data of count descriptors of the given type, pointing at the shared resources.
+void InitTemplateEntries(
+    const Context&       context,
+    VkDescriptorType     type,
+    uint32_t             count,
+    TemplateEntry*       pEntries)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        switch (type)
+        {
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+            pEntries[i].bufferView = context.bufferView;
+            break;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+            // Different offsets, so that the descriptors aren't all the same
+            pEntries[i].buffer.buffer = context.buffer;
+            pEntries[i].buffer.offset = (i * 256) % BufferSize;
+            pEntries[i].buffer.range  = 256;
+            break;
+        default:
+            pEntries[i].image.sampler     = context.sampler;
+            pEntries[i].image.imageView   = context.imageView;
+            pEntries[i].image.imageLayout = (type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) ?
+                                            VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            break;
+        }
+    }
+}
+
+// =====================================================================================================================
+// Creates the descriptor pool of one thread, large enough for the churn batch or two sets of any one type.
+bool CreateThreadPool(
+    const Context&    context,
+    const Options&    options,
+    VkDescriptorPool* pPool)
+{
+    std::vector<VkDescriptorPoolSize> poolSizes;
+
+    for (const DescriptorTypeInfo& typeInfo : DescriptorTypes)
+    {
+        VkDescriptorPoolSize poolSize = {};
+        poolSize.type            = typeInfo.type;
+        poolSize.descriptorCount = std::max(2 * options.descriptorCount, 4 * ChurnBatchSize);
+
+        poolSizes.push_back(poolSize);
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags         = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    poolInfo.maxSets       = ChurnBatchSize + 2;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes    = poolSizes.data();
+
+    return Check(vkCreateDescriptorPool(context.device, &poolInfo, nullptr, pPool), "vkCreateDescriptorPool");
+}
+
+// =====================================================================================================================
+// Runs options.repeats repeats of options.callsPerRepeat calls of the measured operation on the calling thread and
+// appends the ns/descriptor (ns/set for the allocation churn) of every repeat to pSamples.  Only the calls themselves
+// are timed.
+void RunOnThread(
+    ThreadSetup*         pSetup,
+    std::vector<double>* pSamples)
+{
+    const Context&  context = *pSetup->pContext;
+    const Options&  options = *pSetup->pOptions;
+    const uint32_t  count   = context.descriptorCounts[pSetup->typeIndex];
+
+    VkDescriptorPool             pool = VK_NULL_HANDLE;
+    VkDescriptorSet              sets[ChurnBatchSize] = {};
+    std::vector<TemplateEntry>   entries(count);
+    std::vector<uint8_t>         srcBytes;
+    std::vector<uint8_t>         dstBytes;
+
+    bool success = true;
+
+    if (pSetup->operation == Operation::Memcpy)
+    {
+        // Hardware descriptors of the binding array, copied from the CPU-side update data into the set
+        srcBytes.resize(count * pSetup->pType->hwSize, 0xcd);
+        dstBytes.resize(srcBytes.size(), 0);
+    }
+    else
+    {
+        success = CreateThreadPool(context, options, &pool);
+    }
+
+    if (success && (pSetup->operation != Operation::Memcpy) && (pSetup->operation != Operation::AllocFree))
+    {
+        // Source and destination set of the measured type
+        const VkDescriptorSetLayout layouts[2] =
+        {
+            context.setLayouts[pSetup->typeIndex],
+            context.setLayouts[pSetup->typeIndex]
+        };
+
+        VkDescriptorSetAllocateInfo allocInfo = {};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool     = pool;
+        allocInfo.descriptorSetCount = 2;
+        allocInfo.pSetLayouts        = layouts;
+
+        success = Check(vkAllocateDescriptorSets(context.device, &allocInfo, sets), "vkAllocateDescriptorSets");
+
+        InitTemplateEntries(context, pSetup->pType->type, count, entries.data());
+
+        if (success)
+        {
+            // The copy source has to be written
+            vkUpdateDescriptorSetWithTemplate(context.device, sets[0], context.templates[pSetup->typeIndex],
+                                              entries.data());
+        }
+    }
+
+    std::vector<VkDescriptorImageInfo>  imageInfos(count);
+    std::vector<VkDescriptorBufferInfo> bufferInfos(count);
+    std::vector<VkBufferView>           bufferViews(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        imageInfos[i]  = entries[i].image;
+        bufferInfos[i] = entries[i].buffer;
+        bufferViews[i] = entries[i].bufferView;
+    }
+
+    VkWriteDescriptorSet write = {};
+    write.sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet           = sets[1];
+    write.descriptorCount  = count;
+    write.descriptorType   = (pSetup->pType != nullptr) ? pSetup->pType->type : VK_DESCRIPTOR_TYPE_SAMPLER;
+    write.pImageInfo       = imageInfos.data();
+    write.pBufferInfo      = bufferInfos.data();
+    write.pTexelBufferView = bufferViews.data();
+
+    VkCopyDescriptorSet copy = {};
+    copy.sType           = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+    copy.srcSet          = sets[0];
+    copy.dstSet          = sets[1];
+    copy.descriptorCount = count;
+
+    VkDescriptorSetLayout churnLayouts[ChurnBatchSize];
+    std::fill(churnLayouts, churnLayouts + ChurnBatchSize, context.churnLayout);
+
+    VkDescriptorSetAllocateInfo churnInfo = {};
+    churnInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    churnInfo.descriptorPool     = pool;
+    churnInfo.descriptorSetCount = ChurnBatchSize;
+    churnInfo.pSetLayouts        = churnLayouts;
+
+    // Wait for every thread to finish its setup so that the timed sections overlap.  A thread which failed still
+    // checks in, otherwise the others would wait forever.
+    pSetup->readyCount.fetch_add(1);
+
+    while (pSetup->readyCount.load() < pSetup->threadCount)
+    {
+        std::this_thread::yield();
+    }
+
+    for (uint32_t repeat = 0; success && (repeat < options.repeats); ++repeat)
+    {
+        const Clock::time_point start = Clock::now();
+
+        for (uint32_t call = 0; call < options.callsPerRepeat; ++call)
+        {
+            switch (pSetup->operation)
+            {
+            case Operation::AllocFree:
+                vkAllocateDescriptorSets(context.device, &churnInfo, sets);
+                vkFreeDescriptorSets(context.device, pool, ChurnBatchSize, sets);
+                break;
+            case Operation::Write:
+                vkUpdateDescriptorSets(context.device, 1, &write, 0, nullptr);
+                break;
+            case Operation::Template:
+                vkUpdateDescriptorSetWithTemplate(context.device, sets[1], context.templates[pSetup->typeIndex],
+                                                  entries.data());
+                break;
+            case Operation::Copy:
+                vkUpdateDescriptorSets(context.device, 0, nullptr, 1, &copy);
+                break;
+            case Operation::Memcpy:
+                memcpy(dstBytes.data(), srcBytes.data(), dstBytes.size());
+                // Keep the compiler from dropping or merging the copies
+                asm volatile("" : : "r"(dstBytes.data()) : "memory");
+                break;
+            }
+        }
+
+        const Clock::time_point end = Clock::now();
+
+        const uint32_t units = (pSetup->operation == Operation::AllocFree) ? ChurnBatchSize : count;
+
+        pSamples->push_back(std::chrono::duration<double, std::nano>(end - start).count() /
+                            (double(options.callsPerRepeat) * units));
+    }
+
+    if (pool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(context.device, pool, nullptr);
+    }
+}
+
+// =====================================================================================================================
+// Runs one measurement on threadCount threads at once and returns the median over all repeats of all threads.
+double Measure(
+    const Context& context,
+    const Options& options,
+    Operation      operation,
+    uint32_t       typeIndex,
+    uint32_t       threadCount)
+{
+    ThreadSetup setup = {};
+    setup.pContext    = &context;
+    setup.pOptions    = &options;
+    setup.operation   = operation;
+    setup.pType       = (operation == Operation::AllocFree) ? nullptr : &DescriptorTypes[typeIndex];
+    setup.typeIndex   = typeIndex;
+    setup.threadCount = threadCount;
+    setup.readyCount  = 0;
+
+    std::vector<std::vector<double>> threadSamples(threadCount);
+    std::vector<std::thread>         threads;
+
+    for (uint32_t i = 1; i < threadCount; ++i)
+    {
+        threads.emplace_back(RunOnThread, &setup, &threadSamples[i]);
+    }
+
+    // The calling thread runs too.
+    RunOnThread(&setup, &threadSamples[0]);
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::vector<double> samples;
+
+    for (const std::vector<double>& threadSample : threadSamples)
+    {
+        samples.insert(samples.end(), threadSample.begin(), threadSample.end());
+    }
+
+    double median = 0.0;
+
+    if (samples.empty() == false)
+    {
+        std::nth_element(samples.begin(), samples.begin() + (samples.size() / 2), samples.end());
+        median = samples[samples.size() / 2];
+    }
+
+    return median;
+}
+
+// =====================================================================================================================
+// Runs every measurement on 1, 8 and 32 threads.
+void RunBenchmarks(
+    const Context& context,
+    const Options& options)
+{
+    struct UpdateMeasurement
+    {
+        const char* pName;
+        Operation   operation;
+    };
+
+    const UpdateMeasurement updates[] =
+    {
+        { "vkUpdateDescriptorSets",            Operation::Write },
+        { "vkUpdateDescriptorSetWithTemplate", Operation::Template },
+        { "vkUpdateDescriptorSets(copy)",      Operation::Copy },
+    };
+
+    const uint32_t threadCounts[] = { 1, 8, 32 };
+
+    for (uint32_t threadCount : threadCounts)
+    {
+        if (threadCount <= options.maxThreads)
+        {
+            const double nsPerSet = Measure(context, options, Operation::AllocFree, 0, threadCount);
+
+            printf("vkAllocateDescriptorSets+vkFreeDescriptorSets threads=%u: %.1f ns/set\n", threadCount, nsPerSet);
+        }
+    }
+
+    for (uint32_t typeIndex = 0; typeIndex < DescriptorTypeCount; ++typeIndex)
+    {
+        for (uint32_t threadCount : threadCounts)
+        {
+            if (threadCount <= options.maxThreads)
+            {
+                const double roofline = Measure(context, options, Operation::Memcpy, typeIndex, threadCount);
+
+                printf("memcpy %s threads=%u: %.2f ns/descriptor\n",
+                       DescriptorTypes[typeIndex].pName, threadCount, roofline);
+
+                for (const UpdateMeasurement& update : updates)
+                {
+                    const double nsPerDescriptor = Measure(context, options, update.operation, typeIndex, threadCount);
+
+                    printf("%s %s threads=%u: %.2f ns/descriptor (%.1fx memcpy)\n",
+                           update.pName,
+                           DescriptorTypes[typeIndex].pName,
+                           threadCount,
+                           nsPerDescriptor,
+                           (roofline > 0.0) ? (nsPerDescriptor / roofline) : 0.0);
+                }
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+// =====================================================================================================================
+int main(
+    int    argc,
+    char** argv)
+{
+    Options options = {};
+    Context context = {};
+
+    if (ParseOptions(argc, argv, &options) == false)
+    {
+        return EXIT_FAILURE;
+    }
+
+    const bool success = CreateContext(options, &context);
+
+    if (success)
+    {
+        RunBenchmarks(context, options);
+    }
+
+    DestroyContext(&context);
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,941 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  pipeline_benchmark.cpp
+* @brief Replays a directory of pipeline dumps through vkCreate*Pipelines and measures the creation throughput.
+*
+* The pipelines written by EnablePipelineDump are parsed with the LLPC vfx library and turned back into Vulkan create
+* infos: the SPIR-V and specialization constants of each stage, the vertex input, input assembly, rasterization and
+* color target state, and descriptor set and pipeline layouts matching the dumped resource mapping.  The layouts are
+* rebuilt from the mapping, so the driver may lay out descriptors slightly differently than for the original
+* application, but every pipeline goes through the same compile and cache paths.
+*
+* For each thread count (1, 2, 4, ... up to --max-threads) a new device is created with AMD_VK_PIPELINE_CACHE_PATH
+* pointing at an empty directory, and all pipelines are created twice: cold, into an empty VkPipelineCache, and warm,
+* again on the same device and VkPipelineCache.  Every thread takes the next pipeline of the corpus and creates it with
+* its own vkCreate*Pipelines call.  Results are printed one per line as
+* `<pass> threads=<n>: <pipelines/s>, p50/p99 latency, RSS`, to make them easy to compare between commits.
+***********************************************************************************************************************
+*/
+#include "benchmark_support.h"
+#include "vfx.h"
+#include "spvgen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <ftw.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+using bench::Check;
+
+// Color targets of a dumped graphics pipeline
+constexpr uint32_t MaxColorTargets = Vkgc::MaxColorTargets;
+
+struct Options
+{
+    const char* pCorpusDir;    // Directory of .pipe files
+    const char* pCacheRoot;    // Directory the per-run driver cache directories are created in
+    uint32_t    maxThreads;    // Largest number of creating threads
+};
+
+// A parsed pipeline dump.  The create infos point into the vfx document, so it stays open until the end.
+struct PipelineDump
+{
+    std::string         fileName;
+    void*               pDoc;
+    VfxPipelineStatePtr pState;
+};
+
+// The objects and create info of one pipeline on one device.  Instances are never moved once filled in, since the
+// create info points at the state blocks next to it.
+struct PipelineObjects
+{
+    std::vector<VkShaderModule>                    modules;
+    std::vector<VkPipelineShaderStageCreateInfo>   stages;
+    std::vector<VkDescriptorSetLayout>             setLayouts;
+    VkPipelineLayout                               layout;
+    VkRenderPass                                   renderPass;
+    bool                                           isCompute;
+
+    VkPipelineVertexInputStateCreateInfo           vertexInput;
+    VkPipelineInputAssemblyStateCreateInfo         inputAssembly;
+    VkPipelineTessellationStateCreateInfo          tessellation;
+    VkPipelineViewportStateCreateInfo              viewport;
+    VkPipelineRasterizationStateCreateInfo         rasterization;
+    VkPipelineMultisampleStateCreateInfo           multisample;
+    VkPipelineColorBlendAttachmentState            blendAttachments[MaxColorTargets];
+    VkPipelineColorBlendStateCreateInfo            colorBlend;
+    VkDynamicState                                 dynamicStates[2];
+    VkPipelineDynamicStateCreateInfo               dynamic;
+
+    VkGraphicsPipelineCreateInfo                   graphicsInfo;
+    VkComputePipelineCreateInfo                    computeInfo;
+};
+
+// One device with the objects of all pipelines of the corpus.  All devices share the instance.
+struct DeviceContext : public bench::DeviceContext
+{
+    VkPipelineCache              pipelineCache;
+    std::vector<PipelineObjects> pipelines;     // Same order as the corpus
+    std::string                  cacheDir;      // Driver cache directory of the device
+};
+
+// Results of creating the corpus once
+struct PassResult
+{
+    double   seconds;          // Wall time of the pass
+    double   p50Ms;            // Median latency of one vkCreate*Pipelines call
+    double   p99Ms;
+    uint32_t created;
+    uint32_t failed;
+};
+
+// =====================================================================================================================
+// Parses the command line.  Returns false if an argument is not recognized or the corpus directory is missing.
+bool ParseOptions(
+    int      argc,
+    char**   argv,
+    Options* pOptions)
+{
+    pOptions->pCorpusDir = nullptr;
+    pOptions->pCacheRoot = "/tmp";
+    pOptions->maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    const bench::ArgDesc args[] =
+    {
+        { "--max-threads", bench::ArgType::Uint,   &pOptions->maxThreads },
+        { "--cache-root",  bench::ArgType::String, &pOptions->pCacheRoot },
+        { nullptr,         bench::ArgType::String, &pOptions->pCorpusDir },
+    };
+
+    return bench::ParseArgs(argc,
+                            argv,
+                            args,
+                            sizeof(args) / sizeof(args[0]),
+                            "[--max-threads <n>] [--cache-root <dir>] <pipeline dump dir>");
+}
+
+// =====================================================================================================================
+// Parses all .pipe files of the corpus directory, in name order.  Files which fail to parse are reported and skipped.
+bool LoadCorpus(
+    const char*                pCorpusDir,
+    std::vector<PipelineDump>* pCorpus)
+{
+    std::vector<std::string> fileNames;
+
+    DIR* pDir = opendir(pCorpusDir);
+
+    if (pDir == nullptr)
+    {
+        fprintf(stderr, "Cannot open %s\n", pCorpusDir);
+        return false;
+    }
+
+    for (const dirent* pEntry = readdir(pDir); pEntry != nullptr; pEntry = readdir(pDir))
+    {
+        const size_t length = strlen(pEntry->d_name);
+
+        if ((length > 5) && (strcmp(pEntry->d_name + length - 5, ".pipe") == 0))
+        {
+            fileNames.push_back(pEntry->d_name);
+        }
+    }
+
+    closedir(pDir);
+
+    std::sort(fileNames.begin(), fileNames.end());
+
+    for (const std::string& fileName : fileNames)
+    {
+        const std::string path      = std::string(pCorpusDir) + "/" + fileName;
+        void*             pDoc      = nullptr;
+        const char*       pErrorMsg = nullptr;
+
+        if (Vfx::vfxParseFile(path.c_str(), 0, nullptr, VfxDocTypePipeline, &pDoc, &pErrorMsg))
+        {
+            PipelineDump dump = {};
+            dump.fileName = fileName;
+            dump.pDoc     = pDoc;
+
+            Vfx::vfxGetPipelineDoc(pDoc, &dump.pState);
+
+            pCorpus->push_back(dump);
+        }
+        else
+        {
+            fprintf(stderr, "%s: %s\n", fileName.c_str(), (pErrorMsg != nullptr) ? pErrorMsg : "parse error");
+        }
+    }
+
+    if (pCorpus->empty())
+    {
+        fprintf(stderr, "No pipelines found in %s\n", pCorpusDir);
+    }
+
+    return (pCorpus->empty() == false);
+}
+
+// =====================================================================================================================
+// Translates a resource mapping node type back to a descriptor type, with the size of one descriptor in dwords.
+// Several descriptor types share a node type; any of them compiles the same way.  Returns false for nodes which don't
+// correspond to a binding.
+bool MapNodeType(
+    Vkgc::ResourceMappingNodeType nodeType,
+    VkDescriptorType*             pDescriptorType,
+    uint32_t*                     pStrideInDwords)
+{
+    bool mapped = true;
+
+    switch (nodeType)
+    {
+    case Vkgc::ResourceMappingNodeType::DescriptorSampler:
+    case Vkgc::ResourceMappingNodeType::DescriptorYCbCrSampler:
+        *pDescriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        *pStrideInDwords = 4;
+        break;
+    case Vkgc::ResourceMappingNodeType::DescriptorCombinedTexture:
+        *pDescriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        *pStrideInDwords = 12;
+        break;
+    case Vkgc::ResourceMappingNodeType::DescriptorResource:
+        *pDescriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        *pStrideInDwords = 8;
+        break;
+    case Vkgc::ResourceMappingNodeType::DescriptorTexelBuffer:
+        *pDescriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+        *pStrideInDwords = 4;
+        break;
+    case Vkgc::ResourceMappingNodeType::DescriptorBuffer:
+        *pDescriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        *pStrideInDwords = 4;
+        break;
+    case Vkgc::ResourceMappingNodeType::DescriptorBufferCompact:
+        *pDescriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        *pStrideInDwords = 2;
+        break;
+    case Vkgc::ResourceMappingNodeType::PushConst:
+        // Inline uniform blocks; a uniform buffer is the closest core descriptor
+        *pDescriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        *pStrideInDwords = UINT32_MAX;
+        break;
+    default:
+        // Fmask descriptors share the binding of their image
+        mapped = false;
+        break;
+    }
+
+    return mapped;
+}
+
+// =====================================================================================================================
+// Adds a binding to the bindings of its set, merging it with a binding of the same number from another stage.
+void AddBinding(
+    const Vkgc::ResourceMappingNode&                                         node,
+    bool                                                                     isDynamic,
+    std::map<uint32_t, std::map<uint32_t, VkDescriptorSetLayoutBinding>>*    pSets)
+{
+    VkDescriptorType descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    uint32_t         stride         = 0;
+
+    if (MapNodeType(node.type, &descriptorType, &stride))
+    {
+        if (isDynamic && (descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER))
+        {
+            descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        }
+
+        VkDescriptorSetLayoutBinding& binding = (*pSets)[node.srdRange.set][node.srdRange.binding];
+
+        binding.binding         = node.srdRange.binding;
+        binding.descriptorType  = descriptorType;
+        binding.descriptorCount = std::max(binding.descriptorCount,
+                                           std::max(node.sizeInDwords / stride, 1u));
+        binding.stageFlags      = VK_SHADER_STAGE_ALL;
+    }
+}
+
+// =====================================================================================================================
+// Creates descriptor set layouts and a pipeline layout which reproduce the dumped resource mapping.
+bool CreateLayouts(
+    VkDevice                               device,
+    const Vkgc::ResourceMappingData&       mapping,
+    PipelineObjects*                       pObjects)
+{
+    std::map<uint32_t, std::map<uint32_t, VkDescriptorSetLayoutBinding>> sets;
+
+    uint32_t pushConstantSize = 0;
+
+    for (uint32_t i = 0; i < mapping.userDataNodeCount; ++i)
+    {
+        const Vkgc::ResourceMappingNode& node = mapping.pUserDataNodes[i].node;
+
+        if (node.type == Vkgc::ResourceMappingNodeType::DescriptorTableVaPtr)
+        {
+            for (uint32_t j = 0; j < node.tablePtr.nodeCount; ++j)
+            {
+                AddBinding(node.tablePtr.pNext[j], false, &sets);
+            }
+        }
+        else if (node.type == Vkgc::ResourceMappingNodeType::PushConst)
+        {
+            pushConstantSize = std::max(pushConstantSize, node.sizeInDwords * uint32_t(sizeof(uint32_t)));
+        }
+        else if ((node.type != Vkgc::ResourceMappingNodeType::IndirectUserDataVaPtr) &&
+                 (node.type != Vkgc::ResourceMappingNodeType::StreamOutTableVaPtr))
+        {
+            // Descriptors in user data are dynamic buffers
+            AddBinding(node, true, &sets);
+        }
+    }
+
+    const uint32_t setCount = sets.empty() ? 0 : (sets.rbegin()->first + 1);
+
+    bool success = true;
+
+    pObjects->setLayouts.resize(setCount, VK_NULL_HANDLE);
+
+    for (uint32_t set = 0; success && (set < setCount); ++set)
+    {
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+
+        for (const auto& binding : sets[set])
+        {
+            bindings.push_back(binding.second);
+        }
+
+        VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+        setLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        setLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        setLayoutInfo.pBindings    = bindings.data();
+
+        success = Check(vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &pObjects->setLayouts[set]),
+                        "vkCreateDescriptorSetLayout");
+    }
+
+    if (success)
+    {
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_ALL;
+        pushConstantRange.size       = pushConstantSize;
+
+        VkPipelineLayoutCreateInfo layoutInfo = {};
+        layoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layoutInfo.setLayoutCount         = setCount;
+        layoutInfo.pSetLayouts            = pObjects->setLayouts.data();
+        layoutInfo.pushConstantRangeCount = (pushConstantSize > 0) ? 1 : 0;
+        layoutInfo.pPushConstantRanges    = &pushConstantRange;
+
+        success = Check(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pObjects->layout),
+                        "vkCreatePipelineLayout");
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Creates the shader module of a stage and appends the stage to the create info.  Stages without SPIR-V are skipped.
+bool AddStage(
+    VkDevice                         device,
+    const VfxPipelineState&          state,
+    Vkgc::ShaderStage                stage,
+    const Vkgc::PipelineShaderInfo&  shaderInfo,
+    PipelineObjects*                 pObjects)
+{
+    static const VkShaderStageFlagBits StageBits[] =
+    {
+        VK_SHADER_STAGE_VERTEX_BIT,
+        VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
+        VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+        VK_SHADER_STAGE_GEOMETRY_BIT,
+        VK_SHADER_STAGE_FRAGMENT_BIT,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+    };
+
+    bool success = true;
+
+    for (uint32_t i = 0; success && (i < state.numStages); ++i)
+    {
+        if ((state.stages[i].stage == stage) && (state.stages[i].dataSize > 0))
+        {
+            VkShaderModuleCreateInfo moduleInfo = {};
+            moduleInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+            moduleInfo.codeSize = state.stages[i].dataSize;
+            moduleInfo.pCode    = reinterpret_cast<const uint32_t*>(state.stages[i].pData);
+
+            VkShaderModule module = VK_NULL_HANDLE;
+
+            success = Check(vkCreateShaderModule(device, &moduleInfo, nullptr, &module), "vkCreateShaderModule");
+
+            if (success)
+            {
+                VkPipelineShaderStageCreateInfo stageInfo = {};
+                stageInfo.sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                stageInfo.stage               = StageBits[stage];
+                stageInfo.module              = module;
+                stageInfo.pName               = (shaderInfo.pEntryTarget != nullptr) ? shaderInfo.pEntryTarget : "main";
+                stageInfo.pSpecializationInfo = shaderInfo.pSpecializationInfo;
+
+                pObjects->modules.push_back(module);
+                pObjects->stages.push_back(stageInfo);
+            }
+
+            break;
+        }
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Creates a render pass with the color targets of a dumped graphics pipeline.  The dump doesn't record the depth
+// format, so the subpass has no depth attachment.
+bool CreateRenderPass(
+    VkDevice                                device,
+    const Vkgc::GraphicsPipelineBuildInfo& info,
+    PipelineObjects*                        pObjects,
+    uint32_t*                               pColorCount)
+{
+    const VkSampleCountFlagBits samples = (info.rsState.numSamples > 1) ?
+                                          static_cast<VkSampleCountFlagBits>(info.rsState.numSamples) :
+                                          VK_SAMPLE_COUNT_1_BIT;
+
+    VkAttachmentDescription attachments[MaxColorTargets] = {};
+    VkAttachmentReference   colorRefs[MaxColorTargets]   = {};
+    uint32_t                attachmentCount              = 0;
+
+    *pColorCount = 0;
+
+    for (uint32_t i = 0; i < MaxColorTargets; ++i)
+    {
+        colorRefs[i].attachment = VK_ATTACHMENT_UNUSED;
+        colorRefs[i].layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        if (info.cbState.target[i].format != VK_FORMAT_UNDEFINED)
+        {
+            VkAttachmentDescription& attachment = attachments[attachmentCount];
+
+            attachment.format         = info.cbState.target[i].format;
+            attachment.samples        = samples;
+            attachment.loadOp         = VK_ATTACHMENT_LOAD_OP_LOAD;
+            attachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+            attachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            attachment.finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            colorRefs[i].attachment = attachmentCount++;
+            *pColorCount            = i + 1;
+        }
+    }
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = *pColorCount;
+    subpass.pColorAttachments    = colorRefs;
+
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = attachmentCount;
+    renderPassInfo.pAttachments    = attachments;
+    renderPassInfo.subpassCount    = 1;
+    renderPassInfo.pSubpasses      = &subpass;
+
+    return Check(vkCreateRenderPass(device, &renderPassInfo, nullptr, &pObjects->renderPass), "vkCreateRenderPass");
+}
+
+// =====================================================================================================================
+// Fills in the fixed function state of a graphics pipeline from its dump.
+void InitGraphicsState(
+    const Vkgc::GraphicsPipelineBuildInfo& info,
+    uint32_t                               colorCount,
+    PipelineObjects*                       pObjects)
+{
+    if (info.pVertexInput != nullptr)
+    {
+        pObjects->vertexInput = *info.pVertexInput;
+    }
+    else
+    {
+        pObjects->vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    }
+
+    pObjects->inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    pObjects->inputAssembly.topology = info.iaState.topology;
+
+    pObjects->tessellation.sType              = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO;
+    pObjects->tessellation.patchControlPoints = std::max(info.iaState.patchControlPoints, 1u);
+
+    pObjects->viewport.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    pObjects->viewport.viewportCount = 1;
+    pObjects->viewport.scissorCount  = 1;
+
+    pObjects->rasterization.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    pObjects->rasterization.rasterizerDiscardEnable = info.rsState.rasterizerDiscardEnable ? VK_TRUE : VK_FALSE;
+    pObjects->rasterization.polygonMode             = info.rsState.polygonMode;
+    pObjects->rasterization.cullMode                = info.rsState.cullMode;
+    pObjects->rasterization.frontFace               = info.rsState.frontFace;
+    pObjects->rasterization.depthBiasEnable         = info.rsState.depthBiasEnable ? VK_TRUE : VK_FALSE;
+    pObjects->rasterization.lineWidth               = 1.0f;
+
+    pObjects->multisample.sType                 = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    pObjects->multisample.rasterizationSamples  = (info.rsState.numSamples > 1) ?
+                                                  static_cast<VkSampleCountFlagBits>(info.rsState.numSamples) :
+                                                  VK_SAMPLE_COUNT_1_BIT;
+    pObjects->multisample.sampleShadingEnable   = info.rsState.perSampleShading ? VK_TRUE : VK_FALSE;
+    pObjects->multisample.minSampleShading      = 1.0f;
+    pObjects->multisample.alphaToCoverageEnable = info.cbState.alphaToCoverageEnable ? VK_TRUE : VK_FALSE;
+
+    for (uint32_t i = 0; i < colorCount; ++i)
+    {
+        VkPipelineColorBlendAttachmentState& blend = pObjects->blendAttachments[i];
+
+        blend.blendEnable         = info.cbState.target[i].blendEnable ? VK_TRUE : VK_FALSE;
+        blend.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        blend.colorBlendOp        = VK_BLEND_OP_ADD;
+        blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        blend.alphaBlendOp        = VK_BLEND_OP_ADD;
+        blend.colorWriteMask      = info.cbState.target[i].channelWriteMask;
+    }
+
+    pObjects->colorBlend.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    pObjects->colorBlend.logicOp         = VK_LOGIC_OP_COPY;
+    pObjects->colorBlend.attachmentCount = colorCount;
+    pObjects->colorBlend.pAttachments    = pObjects->blendAttachments;
+
+    pObjects->dynamicStates[0]          = VK_DYNAMIC_STATE_VIEWPORT;
+    pObjects->dynamicStates[1]          = VK_DYNAMIC_STATE_SCISSOR;
+    pObjects->dynamic.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    pObjects->dynamic.dynamicStateCount = 2;
+    pObjects->dynamic.pDynamicStates    = pObjects->dynamicStates;
+
+    VkGraphicsPipelineCreateInfo& createInfo = pObjects->graphicsInfo;
+
+    createInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    createInfo.stageCount          = static_cast<uint32_t>(pObjects->stages.size());
+    createInfo.pStages             = pObjects->stages.data();
+    createInfo.pVertexInputState   = &pObjects->vertexInput;
+    createInfo.pInputAssemblyState = &pObjects->inputAssembly;
+    createInfo.pTessellationState  = &pObjects->tessellation;
+    createInfo.pViewportState      = &pObjects->viewport;
+    createInfo.pRasterizationState = &pObjects->rasterization;
+    createInfo.pMultisampleState   = &pObjects->multisample;
+    createInfo.pColorBlendState    = &pObjects->colorBlend;
+    createInfo.pDynamicState       = &pObjects->dynamic;
+    createInfo.layout              = pObjects->layout;
+    createInfo.renderPass          = pObjects->renderPass;
+}
+
+// =====================================================================================================================
+// Creates the shader modules, layouts and render pass of a dumped pipeline and fills in its create info.
+bool CreatePipelineObjects(
+    VkDevice            device,
+    const PipelineDump& dump,
+    PipelineObjects*    pObjects)
+{
+    const VfxPipelineState& state = *dump.pState;
+
+    bool success = true;
+
+    pObjects->isCompute = (state.pipelineType == VfxPipelineTypeCompute);
+
+    if (pObjects->isCompute)
+    {
+        const Vkgc::ComputePipelineBuildInfo& info = state.compPipelineInfo;
+
+        success = AddStage(device, state, Vkgc::ShaderStageCompute, info.cs, pObjects) &&
+                  (pObjects->stages.empty() == false) &&
+                  CreateLayouts(device, info.resourceMapping, pObjects);
+
+        if (success)
+        {
+            pObjects->computeInfo.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            pObjects->computeInfo.stage  = pObjects->stages[0];
+            pObjects->computeInfo.layout = pObjects->layout;
+        }
+    }
+    else
+    {
+        const Vkgc::GraphicsPipelineBuildInfo& info = state.gfxPipelineInfo;
+
+        uint32_t colorCount = 0;
+
+        success = AddStage(device, state, Vkgc::ShaderStageVertex, info.vs, pObjects) &&
+                  AddStage(device, state, Vkgc::ShaderStageTessControl, info.tcs, pObjects) &&
+                  AddStage(device, state, Vkgc::ShaderStageTessEval, info.tes, pObjects) &&
+                  AddStage(device, state, Vkgc::ShaderStageGeometry, info.gs, pObjects) &&
+                  AddStage(device, state, Vkgc::ShaderStageFragment, info.fs, pObjects) &&
+                  (pObjects->stages.empty() == false) &&
+                  CreateLayouts(device, info.resourceMapping, pObjects) &&
+                  CreateRenderPass(device, info, pObjects, &colorCount);
+
+        if (success)
+        {
+            InitGraphicsState(info, colorCount, pObjects);
+        }
+    }
+
+    if (success == false)
+    {
+        fprintf(stderr, "%s: cannot rebuild the create info\n", dump.fileName.c_str());
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Destroys the objects of one pipeline.  Safe to call on partially created objects.
+void DestroyPipelineObjects(
+    VkDevice         device,
+    PipelineObjects* pObjects)
+{
+    vkDestroyRenderPass(device, pObjects->renderPass, nullptr);
+    vkDestroyPipelineLayout(device, pObjects->layout, nullptr);
+
+    for (VkDescriptorSetLayout setLayout : pObjects->setLayouts)
+    {
+        vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+    }
+
+    for (VkShaderModule module : pObjects->modules)
+    {
+        vkDestroyShaderModule(device, module, nullptr);
+    }
+}
+
+// =====================================================================================================================
+// Removes a file or directory of a driver cache directory.
+int RemoveCacheEntry(
+    const char*        pPath,
+    const struct stat* /* pStat */,
+    int                /* type */,
+    struct FTW*        /* pFtw */)
+{
+    return remove(pPath);
+}
+
+// =====================================================================================================================
+// Creates a device whose driver cache starts out empty, and the objects of all pipelines of the corpus on it.  All
+// supported features except robust buffer access are enabled, so that every dumped pipeline can be created.
+bool CreateDeviceContext(
+    const bench::DeviceContext&      instanceContext,
+    const Options&                   options,
+    const std::vector<PipelineDump>& corpus,
+    DeviceContext*                   pContext)
+{
+    char cacheDir[1024] = {};
+    snprintf(cacheDir, sizeof(cacheDir), "%s/pipeline-benchmark-XXXXXX", options.pCacheRoot);
+
+    if (mkdtemp(cacheDir) == nullptr)
+    {
+        fprintf(stderr, "Cannot create a cache directory in %s\n", options.pCacheRoot);
+        return false;
+    }
+
+    pContext->cacheDir = cacheDir;
+
+    // The driver reads the location of its on-disk cache when the device is created
+    setenv("AMD_VK_PIPELINE_CACHE_PATH", cacheDir, 1);
+
+    VkPhysicalDeviceVulkan12Features features12 = {};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceVulkan11Features features11 = {};
+    features11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+    features11.pNext = &features12;
+
+    VkPhysicalDeviceFeatures2 features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &features11;
+
+    vkGetPhysicalDeviceFeatures2(instanceContext.physicalDevice, &features);
+
+    features.features.robustBufferAccess = VK_FALSE;
+
+    // The device goes on the instance and the queue family picked for all devices
+    static_cast<bench::DeviceContext&>(*pContext) = instanceContext;
+
+    bool success = bench::CreateDevice(&features, nullptr, pContext);
+
+    if (success)
+    {
+        VkPipelineCacheCreateInfo cacheInfo = {};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+        success = Check(vkCreatePipelineCache(pContext->device, &cacheInfo, nullptr, &pContext->pipelineCache),
+                        "vkCreatePipelineCache");
+    }
+
+    if (success)
+    {
+        // Sized up front: the create infos point into their own entries
+        pContext->pipelines.resize(corpus.size(), PipelineObjects{});
+
+        for (size_t i = 0; success && (i < corpus.size()); ++i)
+        {
+            success = CreatePipelineObjects(pContext->device, corpus[i], &pContext->pipelines[i]);
+        }
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Destroys everything created by CreateDeviceContext and removes the driver cache directory.
+void DestroyDeviceContext(
+    DeviceContext* pContext)
+{
+    if (pContext->device != VK_NULL_HANDLE)
+    {
+        for (PipelineObjects& objects : pContext->pipelines)
+        {
+            DestroyPipelineObjects(pContext->device, &objects);
+        }
+
+        vkDestroyPipelineCache(pContext->device, pContext->pipelineCache, nullptr);
+        vkDestroyDevice(pContext->device, nullptr);
+    }
+
+    if (pContext->cacheDir.empty() == false)
+    {
+        nftw(pContext->cacheDir.c_str(), RemoveCacheEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+
+    pContext->pipelines.clear();
+}
+
+// =====================================================================================================================
+// Returns the resident set size of the process in MiB.
+double GetResidentMiB()
+{
+    long  pages = 0;
+    FILE* pFile = fopen("/proc/self/statm", "r");
+
+    if (pFile != nullptr)
+    {
+        long totalPages = 0;
+
+        if (fscanf(pFile, "%ld %ld", &totalPages, &pages) != 2)
+        {
+            pages = 0;
+        }
+
+        fclose(pFile);
+    }
+
+    return (static_cast<double>(pages) * sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+}
+
+// =====================================================================================================================
+// Returns the peak resident set size of the process in MiB.
+double GetPeakResidentMiB()
+{
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+}
+
+// =====================================================================================================================
+// Creates every pipeline of the corpus once on threadCount threads, then destroys them.  Each thread takes the next
+// pipeline not yet taken, so slow pipelines don't hold up the others.
+PassResult RunPass(
+    DeviceContext* pContext,
+    uint32_t       threadCount)
+{
+    const size_t pipelineCount = pContext->pipelines.size();
+
+    std::vector<VkPipeline>  pipelines(pipelineCount, VK_NULL_HANDLE);
+    std::vector<double>      latencyMs(pipelineCount, 0.0);
+    std::atomic<size_t>      nextIndex(0);
+    std::atomic<uint32_t>    failed(0);
+    std::vector<std::thread> threads;
+
+    auto createPipelines = [&]()
+    {
+        for (size_t i = nextIndex++; i < pipelineCount; i = nextIndex++)
+        {
+            const PipelineObjects& objects = pContext->pipelines[i];
+            const Clock::time_point start  = Clock::now();
+
+            const VkResult result = objects.isCompute ?
+                vkCreateComputePipelines(pContext->device, pContext->pipelineCache, 1, &objects.computeInfo,
+                                         nullptr, &pipelines[i]) :
+                vkCreateGraphicsPipelines(pContext->device, pContext->pipelineCache, 1, &objects.graphicsInfo,
+                                          nullptr, &pipelines[i]);
+
+            latencyMs[i] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+            if (result != VK_SUCCESS)
+            {
+                pipelines[i] = VK_NULL_HANDLE;
+                failed++;
+            }
+        }
+    };
+
+    const Clock::time_point passStart = Clock::now();
+
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        threads.emplace_back(createPipelines);
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    PassResult result = {};
+    result.seconds = std::chrono::duration<double>(Clock::now() - passStart).count();
+    result.failed  = failed;
+    result.created = static_cast<uint32_t>(pipelineCount) - result.failed;
+
+    std::sort(latencyMs.begin(), latencyMs.end());
+
+    result.p50Ms = latencyMs[pipelineCount / 2];
+    result.p99Ms = latencyMs[std::min(pipelineCount - 1, (pipelineCount * 99) / 100)];
+
+    for (VkPipeline pipeline : pipelines)
+    {
+        vkDestroyPipeline(pContext->device, pipeline, nullptr);
+    }
+
+    return result;
+}
+
+// =====================================================================================================================
+// Prints the result of one pass.
+void PrintPass(
+    const char*       pPass,
+    uint32_t          threadCount,
+    const PassResult& result,
+    double            baseMiB)
+{
+    const double residentMiB = GetResidentMiB();
+
+    printf("%s threads=%u: %.1f pipelines/s, p50 %.2f ms, p99 %.2f ms, RSS %.1f MiB (+%.1f), peak RSS %.1f MiB",
+           pPass,
+           threadCount,
+           (result.seconds > 0.0) ? (result.created / result.seconds) : 0.0,
+           result.p50Ms,
+           result.p99Ms,
+           residentMiB,
+           residentMiB - baseMiB,
+           GetPeakResidentMiB());
+
+    if (result.failed > 0)
+    {
+        printf(", %u failed", result.failed);
+    }
+
+    printf("\n");
+}
+
+} // anonymous namespace
+
+// =====================================================================================================================
+int main(
+    int    argc,
+    char** argv)
+{
+    Options                   options         = {};
+    std::vector<PipelineDump> corpus;
+    bench::DeviceContext      instanceContext = {};
+
+    if (ParseOptions(argc, argv, &options) == false)
+    {
+        return EXIT_FAILURE;
+    }
+
+    // SPIR-V assembly and GLSL sections of the dumps are assembled by spvgen
+    if (InitSpvGen() == false)
+    {
+        fprintf(stderr, "Cannot load spvgen\n");
+        return EXIT_FAILURE;
+    }
+
+    bool success = LoadCorpus(options.pCorpusDir, &corpus) &&
+                   bench::CreateInstance("pipeline-benchmark", VK_API_VERSION_1_2, &instanceContext) &&
+                   bench::SelectPhysicalDevice(VK_QUEUE_GRAPHICS_BIT, &instanceContext);
+
+    if (success)
+    {
+        printf("%zu pipelines from %s\n", corpus.size(), options.pCorpusDir);
+    }
+
+    for (uint32_t threadCount = 1; success; threadCount = std::min(threadCount * 2, options.maxThreads))
+    {
+        DeviceContext context = {};
+
+        const double baseMiB = GetResidentMiB();
+
+        success = CreateDeviceContext(instanceContext, options, corpus, &context);
+
+        if (success)
+        {
+            // Cold: empty driver cache and pipeline cache.  Warm: everything was just created on this device.
+            const PassResult cold = RunPass(&context, threadCount);
+            PrintPass("cold", threadCount, cold, baseMiB);
+
+            const PassResult warm = RunPass(&context, threadCount);
+            PrintPass("warm", threadCount, warm, baseMiB);
+        }
+
+        DestroyDeviceContext(&context);
+
+        if (threadCount == options.maxThreads)
+        {
+            break;
+        }
+    }
+
+    bench::DestroyContext(&instanceContext);
+
+    for (PipelineDump& dump : corpus)
+    {
+        Vfx::vfxCloseDoc(dump.pDoc);
+    }
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
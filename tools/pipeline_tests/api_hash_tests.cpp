@@ -0,0 +1,337 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  api_hash_tests.cpp
+* @brief Tests of the first-level lookup of graphics pipeline binaries by the API hash of their create info.
+*
+* The driver maps the API hash of every graphics pipeline it creates to the ELF cache ID of its binary, and serves
+* later creates with the same hash straight from the pipeline caches.  Whether a create was served from the
+* application's VkPipelineCache shows through VK_EXT_pipeline_creation_feedback, so two pipelines which have to be
+* compiled differently must never report a hit on each other's binary.
+***********************************************************************************************************************
+*/
+#include "vulkan.h"
+#include "doctest.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+// SPIR-V for a vertex shader which passes its only attribute through: "gl_Position = inPosition;".  The attribute
+// is read with the binding stride, so the stride being dynamic or not changes the fetch code.
+const uint32_t PassThroughVertexShader[] =
+{
+    0x07230203, 0x00010000, 0x00000000, 0x0000000c, 0x00000000, // Header, id bound 12
+    0x00020011, 0x00000001,                                     // OpCapability Shader
+    0x0003000e, 0x00000000, 0x00000001,                         // OpMemoryModel Logical GLSL450
+    0x0007000f, 0x00000000, 0x00000009, 0x6e69616d, 0x00000000, // OpEntryPoint Vertex %9 "main"
+    0x00000007, 0x00000008,                                     //     %7 %8
+    0x00040047, 0x00000007, 0x0000001e, 0x00000000,             // OpDecorate %7 Location 0
+    0x00040047, 0x00000008, 0x0000000b, 0x00000000,             // OpDecorate %8 BuiltIn Position
+    0x00020013, 0x00000001,                                     // %1 = OpTypeVoid
+    0x00030021, 0x00000002, 0x00000001,                         // %2 = OpTypeFunction %1
+    0x00030016, 0x00000003, 0x00000020,                         // %3 = OpTypeFloat 32
+    0x00040017, 0x00000004, 0x00000003, 0x00000004,             // %4 = OpTypeVector %3 4
+    0x00040020, 0x00000005, 0x00000001, 0x00000004,             // %5 = OpTypePointer Input %4
+    0x00040020, 0x00000006, 0x00000003, 0x00000004,             // %6 = OpTypePointer Output %4
+    0x0004003b, 0x00000005, 0x00000007, 0x00000001,             // %7 = OpVariable %5 Input
+    0x0004003b, 0x00000006, 0x00000008, 0x00000003,             // %8 = OpVariable %6 Output
+    0x00050036, 0x00000001, 0x00000009, 0x00000000, 0x00000002, // %9 = OpFunction %1 None %2
+    0x000200f8, 0x0000000a,                                     // %10 = OpLabel
+    0x0004003d, 0x00000004, 0x0000000b, 0x00000007,             // %11 = OpLoad %4 %7
+    0x0003003e, 0x00000008, 0x0000000b,                         // OpStore %8 %11
+    0x000100fd,                                                 // OpReturn
+    0x00010038,                                                 // OpFunctionEnd
+};
+
+// A device with extended dynamic state and pipeline creation feedback, and the objects every test pipeline shares
+struct Context
+{
+    VkInstance       instance;
+    VkPhysicalDevice physicalDevice;
+    VkDevice         device;
+    VkShaderModule   shaderModule;
+    VkPipelineLayout pipelineLayout;
+    VkRenderPass     renderPass;
+};
+
+// =====================================================================================================================
+// Returns whether the physical device exposes a device extension.
+bool HasExtension(
+    VkPhysicalDevice physicalDevice,
+    const char*      pName)
+{
+    uint32_t count = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, nullptr);
+
+    std::vector<VkExtensionProperties> extensions(count);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, extensions.data());
+
+    bool found = false;
+
+    for (const VkExtensionProperties& extension : extensions)
+    {
+        found |= (strcmp(extension.extensionName, pName) == 0);
+    }
+
+    return found;
+}
+
+// =====================================================================================================================
+// Creates the context.  Returns false, with all handles left null, if there is no device which supports the tests.
+bool CreateContext(
+    Context* pContext)
+{
+    *pContext = {};
+
+    VkApplicationInfo appInfo = {};
+    appInfo.sType            = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "pipeline-tests";
+    appInfo.apiVersion       = VK_API_VERSION_1_2;
+
+    VkInstanceCreateInfo instanceInfo = {};
+    instanceInfo.sType            = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.pApplicationInfo = &appInfo;
+
+    if (vkCreateInstance(&instanceInfo, nullptr, &pContext->instance) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    uint32_t physicalDeviceCount = 1;
+    VkResult result = vkEnumeratePhysicalDevices(pContext->instance, &physicalDeviceCount, &pContext->physicalDevice);
+
+    if (((result != VK_SUCCESS) && (result != VK_INCOMPLETE)) || (physicalDeviceCount == 0) ||
+        (HasExtension(pContext->physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME) == false) ||
+        (HasExtension(pContext->physicalDevice, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME) == false))
+    {
+        return false;
+    }
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(pContext->physicalDevice, &queueFamilyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(pContext->physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    uint32_t queueFamilyIndex = UINT32_MAX;
+
+    for (uint32_t i = 0; (i < queueFamilyCount) && (queueFamilyIndex == UINT32_MAX); ++i)
+    {
+        if ((queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0)
+        {
+            queueFamilyIndex = i;
+        }
+    }
+
+    if (queueFamilyIndex == UINT32_MAX)
+    {
+        return false;
+    }
+
+    const float queuePriority = 1.0f;
+
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = queueFamilyIndex;
+    queueInfo.queueCount       = 1;
+    queueInfo.pQueuePriorities = &queuePriority;
+
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT dynamicStateFeatures = {};
+    dynamicStateFeatures.sType                = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+    dynamicStateFeatures.extendedDynamicState = VK_TRUE;
+
+    const char* extensions[] =
+    {
+        VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME,
+        VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME,
+    };
+
+    VkDeviceCreateInfo deviceInfo = {};
+    deviceInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.pNext                   = &dynamicStateFeatures;
+    deviceInfo.queueCreateInfoCount    = 1;
+    deviceInfo.pQueueCreateInfos       = &queueInfo;
+    deviceInfo.enabledExtensionCount   = 2;
+    deviceInfo.ppEnabledExtensionNames = extensions;
+
+    if (vkCreateDevice(pContext->physicalDevice, &deviceInfo, nullptr, &pContext->device) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    VkShaderModuleCreateInfo moduleInfo = {};
+    moduleInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = sizeof(PassThroughVertexShader);
+    moduleInfo.pCode    = PassThroughVertexShader;
+
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType        = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses   = &subpass;
+
+    return (vkCreateShaderModule(pContext->device, &moduleInfo, nullptr, &pContext->shaderModule) == VK_SUCCESS) &&
+           (vkCreatePipelineLayout(pContext->device, &layoutInfo, nullptr, &pContext->pipelineLayout) == VK_SUCCESS) &&
+           (vkCreateRenderPass(pContext->device, &renderPassInfo, nullptr, &pContext->renderPass) == VK_SUCCESS);
+}
+
+// =====================================================================================================================
+void DestroyContext(
+    Context* pContext)
+{
+    if (pContext->device != VK_NULL_HANDLE)
+    {
+        vkDestroyRenderPass(pContext->device, pContext->renderPass, nullptr);
+        vkDestroyPipelineLayout(pContext->device, pContext->pipelineLayout, nullptr);
+        vkDestroyShaderModule(pContext->device, pContext->shaderModule, nullptr);
+        vkDestroyDevice(pContext->device, nullptr);
+    }
+
+    if (pContext->instance != VK_NULL_HANDLE)
+    {
+        vkDestroyInstance(pContext->instance, nullptr);
+    }
+}
+
+// =====================================================================================================================
+// Creates a pipeline which draws with the pass-through vertex shader and discards the primitives, optionally with a
+// dynamic vertex binding stride, and destroys it again.  Returns whether the create was served from pipelineCache.
+bool CreatePipelineHitsCache(
+    const Context&  context,
+    VkPipelineCache pipelineCache,
+    bool            dynamicStride)
+{
+    VkPipelineShaderStageCreateInfo stage = {};
+    stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stage.stage  = VK_SHADER_STAGE_VERTEX_BIT;
+    stage.module = context.shaderModule;
+    stage.pName  = "main";
+
+    VkVertexInputBindingDescription binding = {};
+    binding.binding   = 0;
+    binding.stride    = 4 * sizeof(float);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription attribute = {};
+    attribute.location = 0;
+    attribute.binding  = 0;
+    attribute.format   = VK_FORMAT_R32G32B32A32_SFLOAT;
+    attribute.offset   = 0;
+
+    VkPipelineVertexInputStateCreateInfo vertexInput = {};
+    vertexInput.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount   = 1;
+    vertexInput.pVertexBindingDescriptions      = &binding;
+    vertexInput.vertexAttributeDescriptionCount = 1;
+    vertexInput.pVertexAttributeDescriptions    = &attribute;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+
+    VkPipelineRasterizationStateCreateInfo rasterization = {};
+    rasterization.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.rasterizerDiscardEnable = VK_TRUE;
+    rasterization.lineWidth               = 1.0f;
+
+    const VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE_EXT };
+
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 1;
+    dynamicState.pDynamicStates    = dynamicStates;
+
+    VkPipelineCreationFeedbackEXT pipelineFeedback = {};
+    VkPipelineCreationFeedbackEXT stageFeedback    = {};
+
+    VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo = {};
+    feedbackInfo.sType                              = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+    feedbackInfo.pPipelineCreationFeedback          = &pipelineFeedback;
+    feedbackInfo.pipelineStageCreationFeedbackCount = 1;
+    feedbackInfo.pPipelineStageCreationFeedbacks    = &stageFeedback;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext               = &feedbackInfo;
+    pipelineInfo.stageCount          = 1;
+    pipelineInfo.pStages             = &stage;
+    pipelineInfo.pVertexInputState   = &vertexInput;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pRasterizationState = &rasterization;
+    pipelineInfo.pDynamicState       = dynamicStride ? &dynamicState : nullptr;
+    pipelineInfo.layout              = context.pipelineLayout;
+    pipelineInfo.renderPass          = context.renderPass;
+    pipelineInfo.subpass             = 0;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    REQUIRE(vkCreateGraphicsPipelines(context.device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) ==
+            VK_SUCCESS);
+
+    vkDestroyPipeline(context.device, pipeline, nullptr);
+
+    REQUIRE((pipelineFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT) != 0);
+
+    return ((pipelineFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT) != 0);
+}
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Two pipelines which only differ in VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE_EXT fetch their vertices differently,
+// so the second one must not be served the binary of the first, while each of them is served its own binary.
+TEST_CASE("Pipelines differing only in a dynamic vertex stride get their own binaries")
+{
+    Context context;
+
+    if (CreateContext(&context) == false)
+    {
+        DestroyContext(&context);
+        MESSAGE("Skipped: no device with VK_EXT_extended_dynamic_state and VK_EXT_pipeline_creation_feedback");
+        return;
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    REQUIRE(vkCreatePipelineCache(context.device, &cacheInfo, nullptr, &pipelineCache) == VK_SUCCESS);
+
+    CHECK(CreatePipelineHitsCache(context, pipelineCache, false) == false);
+    CHECK(CreatePipelineHitsCache(context, pipelineCache, true) == false);
+    CHECK(CreatePipelineHitsCache(context, pipelineCache, false));
+    CHECK(CreatePipelineHitsCache(context, pipelineCache, true));
+
+    vkDestroyPipelineCache(context.device, pipelineCache, nullptr);
+    DestroyContext(&context);
+}
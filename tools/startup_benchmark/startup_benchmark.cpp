@@ -0,0 +1,426 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  startup_benchmark.cpp
+* @brief Measures the time from process start to the first pipeline, with the driver's breakdown of it.
+*
+* Startup only happens once per process, so every iteration runs this executable again as a child with --child.  The
+* child times vkCreateInstance, vkEnumeratePhysicalDevices, vkCreateDevice and the creation of a first, trivial compute
+* pipeline, and prints them.  The parent points AMDVLK_STARTUP_PROFILE at a temporary file for every child, so that
+* the driver appends the duration of its own initialization phases (settings, app profile scan, physical device
+* enumeration, internal pipelines, compiler initialization...) to it.
+*
+* The parent reports the median, minimum and maximum over the iterations of every API call, of every driver phase and
+* of the lifetime of the child process, which includes loading the loader and the driver.  A phase which runs several
+* times in one process, e.g. once per physical device, is summed per process.  With --cold-cache each child gets an
+* empty pipeline cache directory, so the first pipeline is compiled rather than loaded.
+***********************************************************************************************************************
+*/
+#include "benchmark_support.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <ftw.h>
+#include <unistd.h>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+using bench::Check;
+
+struct Options
+{
+    uint32_t    iterations;     // Number of child processes
+    bool        coldCache;      // Give each child an empty pipeline cache directory
+    bool        child;          // Run the measured startup instead of the parent
+};
+
+// Samples of one API call or driver phase, one per iteration
+struct Timing
+{
+    std::string         name;
+    std::vector<double> us;
+};
+
+// Compute shader with an empty main(), local size 1x1x1
+const uint32_t EmptyComputeShader[] =
+{
+    0x07230203, 0x00010000, 0x00000000, 0x00000005, 0x00000000,
+    0x00020011, 0x00000001,                                                     // OpCapability Shader
+    0x0003000e, 0x00000000, 0x00000001,                                         // OpMemoryModel Logical GLSL450
+    0x0005000f, 0x00000005, 0x00000003, 0x6e69616d, 0x00000000,                 // OpEntryPoint GLCompute %3 "main"
+    0x00060010, 0x00000003, 0x00000011, 0x00000001, 0x00000001, 0x00000001,     // OpExecutionMode %3 LocalSize 1 1 1
+    0x00020013, 0x00000001,                                                     // %1 = OpTypeVoid
+    0x00030021, 0x00000002, 0x00000001,                                         // %2 = OpTypeFunction %1
+    0x00050036, 0x00000001, 0x00000003, 0x00000000, 0x00000002,                 // %3 = OpFunction %1 None %2
+    0x000200f8, 0x00000004,                                                     // %4 = OpLabel
+    0x000100fd,                                                                 // OpReturn
+    0x00010038,                                                                 // OpFunctionEnd
+};
+
+// =====================================================================================================================
+// Parses the command line.  Returns false if an argument is not recognized.
+bool ParseOptions(
+    int      argc,
+    char**   argv,
+    Options* pOptions)
+{
+    pOptions->iterations = 20;
+    pOptions->coldCache  = false;
+    pOptions->child      = false;
+
+    // --child is only passed by the parent, so it isn't in the usage
+    const bench::ArgDesc args[] =
+    {
+        { "--iterations", bench::ArgType::Uint, &pOptions->iterations },
+        { "--cold-cache", bench::ArgType::Flag, &pOptions->coldCache },
+        { "--child",      bench::ArgType::Flag, &pOptions->child },
+    };
+
+    return bench::ParseArgs(argc, argv, args, sizeof(args) / sizeof(args[0]), "[--iterations <n>] [--cold-cache]");
+}
+
+// =====================================================================================================================
+// Returns the microseconds elapsed since start.
+double ElapsedUs(
+    Clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// =====================================================================================================================
+// Creates an instance, a device and a first compute pipeline, and prints "api <call> <us>" for each step.  This is
+// the child side of the benchmark; everything it creates is destroyed untimed.
+bool RunStartup()
+{
+    bench::DeviceContext context        = {};
+    VkShaderModule       shaderModule   = VK_NULL_HANDLE;
+    VkPipelineLayout     pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline           pipeline       = VK_NULL_HANDLE;
+
+    Clock::time_point start = Clock::now();
+
+    bool success = bench::CreateInstance("startup-benchmark", VK_API_VERSION_1_1, &context);
+
+    if (success)
+    {
+        printf("api vkCreateInstance %.1f\n", ElapsedUs(start));
+
+        // Includes the queue family query, which is negligible next to the enumeration
+        start = Clock::now();
+
+        success = bench::SelectPhysicalDevice(VK_QUEUE_COMPUTE_BIT, &context);
+
+        printf("api vkEnumeratePhysicalDevices %.1f\n", ElapsedUs(start));
+    }
+
+    if (success)
+    {
+        start = Clock::now();
+
+        success = bench::CreateDevice(nullptr, nullptr, &context);
+
+        if (success)
+        {
+            printf("api vkCreateDevice %.1f\n", ElapsedUs(start));
+        }
+    }
+
+    if (success)
+    {
+        VkShaderModuleCreateInfo moduleInfo = {};
+        moduleInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = sizeof(EmptyComputeShader);
+        moduleInfo.pCode    = EmptyComputeShader;
+
+        VkPipelineLayoutCreateInfo layoutInfo = {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+        // The first pipeline includes the objects it needs, which are also created for the first time in the process
+        start = Clock::now();
+
+        success = Check(vkCreateShaderModule(context.device, &moduleInfo, nullptr, &shaderModule),
+                        "vkCreateShaderModule") &&
+                  Check(vkCreatePipelineLayout(context.device, &layoutInfo, nullptr, &pipelineLayout),
+                        "vkCreatePipelineLayout");
+
+        if (success)
+        {
+            VkComputePipelineCreateInfo pipelineInfo = {};
+            pipelineInfo.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            pipelineInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            pipelineInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+            pipelineInfo.stage.module = shaderModule;
+            pipelineInfo.stage.pName  = "main";
+            pipelineInfo.layout       = pipelineLayout;
+
+            success = Check(vkCreateComputePipelines(context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
+                                                     &pipeline),
+                            "vkCreateComputePipelines");
+        }
+
+        if (success)
+        {
+            printf("api FirstPipeline %.1f\n", ElapsedUs(start));
+        }
+    }
+
+    if (context.device != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(context.device, pipeline, nullptr);
+        vkDestroyPipelineLayout(context.device, pipelineLayout, nullptr);
+        vkDestroyShaderModule(context.device, shaderModule, nullptr);
+    }
+
+    bench::DestroyContext(&context);
+
+    return success;
+}
+
+// =====================================================================================================================
+// Adds a sample to the timing of the given name, creating it in order of first appearance.
+void AddSample(
+    std::vector<Timing>* pTimings,
+    const std::string&   name,
+    double               us)
+{
+    auto it = std::find_if(pTimings->begin(), pTimings->end(), [&name](const Timing& timing)
+                           { return timing.name == name; });
+
+    if (it == pTimings->end())
+    {
+        pTimings->push_back(Timing{ name, {} });
+        it = pTimings->end() - 1;
+    }
+
+    it->us.push_back(us);
+}
+
+// =====================================================================================================================
+// Reads the phases the driver wrote to the profile file of one child and adds their per-process sums to pPhases.
+void ReadStartupProfile(
+    const char*          pPath,
+    std::vector<Timing>* pPhases)
+{
+    std::vector<Timing> processPhases;
+
+    FILE* pFile = fopen(pPath, "r");
+
+    if (pFile != nullptr)
+    {
+        char               phase[128] = {};
+        unsigned long long startUs    = 0;
+        unsigned long long durationUs = 0;
+
+        while (fscanf(pFile, " startup %127s start_us=%llu duration_us=%llu", phase, &startUs, &durationUs) == 3)
+        {
+            AddSample(&processPhases, phase, static_cast<double>(durationUs));
+        }
+
+        fclose(pFile);
+    }
+
+    for (const Timing& timing : processPhases)
+    {
+        double sum = 0.0;
+
+        for (double us : timing.us)
+        {
+            sum += us;
+        }
+
+        AddSample(pPhases, timing.name, sum);
+    }
+}
+
+// =====================================================================================================================
+// Removes one entry of a temporary pipeline cache directory, see nftw().
+int RemoveEntry(
+    const char*        pPath,
+    const struct stat* /* pStat */,
+    int                /* typeFlag */,
+    struct FTW*        /* pFtw */)
+{
+    return remove(pPath);
+}
+
+// =====================================================================================================================
+// Runs one child process with its own profile file.  Returns false if the child failed.
+bool RunChild(
+    const char*          pExecutable,
+    const Options&       options,
+    std::vector<Timing>* pApiCalls,
+    std::vector<Timing>* pPhases)
+{
+    char profilePath[] = "/tmp/startup-benchmark-XXXXXX";
+    char cachePath[]   = "/tmp/startup-benchmark-cache-XXXXXX";
+
+    const int profileFd = mkstemp(profilePath);
+    bool      success   = (profileFd >= 0);
+
+    if (success)
+    {
+        close(profileFd);
+        setenv("AMDVLK_STARTUP_PROFILE", profilePath, 1);
+    }
+
+    if (success && options.coldCache)
+    {
+        success = (mkdtemp(cachePath) != nullptr);
+
+        if (success)
+        {
+            setenv("AMD_VK_PIPELINE_CACHE_PATH", cachePath, 1);
+        }
+    }
+
+    if (success)
+    {
+        const std::string command = std::string("'") + pExecutable + "' --child";
+
+        const Clock::time_point start = Clock::now();
+
+        FILE* pPipe = popen(command.c_str(), "r");
+        success     = (pPipe != nullptr);
+
+        if (success)
+        {
+            char   call[128] = {};
+            double us        = 0.0;
+
+            while (fscanf(pPipe, " api %127s %lf", call, &us) == 2)
+            {
+                AddSample(pApiCalls, call, us);
+            }
+
+            success = (pclose(pPipe) == 0);
+
+            AddSample(pApiCalls, "ChildProcess", ElapsedUs(start));
+        }
+
+        if (success)
+        {
+            ReadStartupProfile(profilePath, pPhases);
+        }
+    }
+
+    if (profileFd >= 0)
+    {
+        unlink(profilePath);
+    }
+
+    if (options.coldCache && (strstr(cachePath, "XXXXXX") == nullptr))
+    {
+        nftw(cachePath, RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Prints the median, minimum and maximum of every timing.
+void PrintTimings(
+    const char*          pKind,
+    std::vector<Timing>* pTimings)
+{
+    for (Timing& timing : *pTimings)
+    {
+        std::sort(timing.us.begin(), timing.us.end());
+
+        printf("%-6s %-52s median %10.1f us  min %10.1f us  max %10.1f us  (%zu samples)\n",
+               pKind,
+               timing.name.c_str(),
+               timing.us[timing.us.size() / 2],
+               timing.us.front(),
+               timing.us.back(),
+               timing.us.size());
+    }
+}
+
+} // anonymous namespace
+
+// =====================================================================================================================
+int main(
+    int    argc,
+    char** argv)
+{
+    Options options = {};
+
+    if (ParseOptions(argc, argv, &options) == false)
+    {
+        return EXIT_FAILURE;
+    }
+
+    bool success = true;
+
+    if (options.child)
+    {
+        success = RunStartup();
+    }
+    else
+    {
+        std::vector<Timing> apiCalls;
+        std::vector<Timing> phases;
+
+        printf("startup-benchmark: %u iterations, %s pipeline cache\n",
+               options.iterations,
+               options.coldCache ? "cold" : "default");
+
+        for (uint32_t i = 0; success && (i < options.iterations); ++i)
+        {
+            success = RunChild(argv[0], options, &apiCalls, &phases);
+
+            if (success == false)
+            {
+                fprintf(stderr, "Iteration %u failed\n", i);
+            }
+        }
+
+        if (success)
+        {
+            PrintTimings("api", &apiCalls);
+
+            if (phases.empty())
+            {
+                printf("No driver phases recorded; the driver under test doesn't support AMDVLK_STARTUP_PROFILE\n");
+            }
+            else
+            {
+                PrintTimings("driver", &phases);
+            }
+        }
+    }
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
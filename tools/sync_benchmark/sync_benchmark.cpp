@@ -0,0 +1,634 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+***********************************************************************************************************************
+* @file  sync_benchmark.cpp
+* @brief Measures the CPU cost and latency of queue submission and synchronization.
+*
+* The benchmark creates a device on the first physical device exposed by the loader and measures, at several batch
+* sizes:
+*
+* - vkQueueSubmit of empty command buffers, batched into one submit info or spread over several, with the time until
+*   the fence of the submission signals;
+* - vkWaitForFences and vkWaitSemaphores on objects which are already signaled, which is the pure CPU overhead paid
+*   by every frame which polls;
+* - a timeline semaphore round trip: the host signals a value a queued submission waits for, and waits for the value
+*   the submission signals back;
+* - vkQueueBindSparse remapping pages of a sparse buffer between two allocations, if the queue supports sparse binding.
+*
+* Every operation is repeated and reported as `<operation> <batch>: CPU <median> (p99 <p99>) ns/op, latency <median>
+* (p99 <p99>) us`, where the CPU time covers only the measured call and the latency lasts until the host observes that
+* the GPU is done.  The p99 is printed because spikes, not averages, are what stutter in frames.
+***********************************************************************************************************************
+*/
+#include "benchmark_support.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+using bench::Check;
+
+// Largest number of command buffers, fences and semaphores used at once
+constexpr uint32_t MaxBatchSize = 64;
+
+// Largest number of sparse pages remapped by one vkQueueBindSparse
+constexpr uint32_t MaxSparsePages = 256;
+
+struct Options
+{
+    uint32_t repeats;           // Number of times each measurement is repeated
+};
+
+// All objects shared by the measurements.
+struct Context : public bench::DeviceContext
+{
+    bool             sparseSupported;   // Whether the queue supports sparse binding
+
+    VkCommandPool    cmdPool;
+    VkCommandBuffer  cmdBuffers[MaxBatchSize];          // Empty, recorded once
+    VkFence          fence;                             // Signaled by the measured submissions
+    VkFence          signaledFences[MaxBatchSize];
+    VkSemaphore      signaledSemaphores[MaxBatchSize];  // Timeline semaphores at value 1
+    VkSemaphore      timeline;                          // Round trip semaphore
+
+    VkBuffer         sparseBuffer;
+    VkDeviceSize     sparsePageSize;
+    VkDeviceMemory   sparseMemory[2];                   // The pages are remapped between these
+
+    PFN_vkWaitSemaphores  pfnWaitSemaphores;
+    PFN_vkSignalSemaphore pfnSignalSemaphore;
+};
+
+// Samples of one measurement
+struct Samples
+{
+    std::vector<double> cpuNs;        // CPU time of the measured call, per operation
+    std::vector<double> latencyUs;    // Time until the host observed completion, empty if not applicable
+};
+
+// =====================================================================================================================
+// Parses the command line.  Returns false if an argument is not recognized.
+bool ParseOptions(
+    int      argc,
+    char**   argv,
+    Options* pOptions)
+{
+    pOptions->repeats = 200;
+
+    const bench::ArgDesc args[] =
+    {
+        { "--repeats", bench::ArgType::Uint, &pOptions->repeats },
+    };
+
+    return bench::ParseArgs(argc, argv, args, sizeof(args) / sizeof(args[0]), "[--repeats <n>]");
+}
+
+// =====================================================================================================================
+// Returns the index of the first memory type allowed by typeBits, preferring device local memory.
+uint32_t FindMemoryType(
+    const Context& context,
+    uint32_t       typeBits)
+{
+    VkPhysicalDeviceMemoryProperties memProps = {};
+    vkGetPhysicalDeviceMemoryProperties(context.physicalDevice, &memProps);
+
+    uint32_t typeIndex = UINT32_MAX;
+
+    for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
+    {
+        if ((typeBits & (1u << i)) != 0)
+        {
+            if (typeIndex == UINT32_MAX)
+            {
+                typeIndex = i;
+            }
+
+            if ((memProps.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0)
+            {
+                typeIndex = i;
+                break;
+            }
+        }
+    }
+
+    return typeIndex;
+}
+
+// =====================================================================================================================
+// Creates the sparse buffer and the two allocations its pages are remapped between.
+bool CreateSparseResources(
+    Context* pContext)
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.flags       = VK_BUFFER_CREATE_SPARSE_BINDING_BIT;
+    bufferInfo.size        = 64 * 1024 * MaxSparsePages;
+    bufferInfo.usage       = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    bool success = Check(vkCreateBuffer(pContext->device, &bufferInfo, nullptr, &pContext->sparseBuffer),
+                         "vkCreateBuffer");
+
+    if (success)
+    {
+        VkMemoryRequirements reqs = {};
+        vkGetBufferMemoryRequirements(pContext->device, pContext->sparseBuffer, &reqs);
+
+        pContext->sparsePageSize = reqs.alignment;
+
+        VkMemoryAllocateInfo allocInfo = {};
+        allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize  = reqs.alignment * MaxSparsePages;
+        allocInfo.memoryTypeIndex = FindMemoryType(*pContext, reqs.memoryTypeBits);
+
+        if (reqs.size >= allocInfo.allocationSize)
+        {
+            success = Check(vkAllocateMemory(pContext->device, &allocInfo, nullptr, &pContext->sparseMemory[0]),
+                            "vkAllocateMemory") &&
+                      Check(vkAllocateMemory(pContext->device, &allocInfo, nullptr, &pContext->sparseMemory[1]),
+                            "vkAllocateMemory");
+        }
+        else
+        {
+            // Pages larger than 64 KiB; the buffer doesn't hold MaxSparsePages of them
+            pContext->sparseSupported = false;
+        }
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Creates the instance, the device and all objects used by the measurements.
+bool CreateContext(
+    Context* pContext)
+{
+    if ((bench::CreateInstance("sync-benchmark", VK_API_VERSION_1_2, pContext) == false) ||
+        (bench::SelectPhysicalDevice(VK_QUEUE_GRAPHICS_BIT, pContext) == false))
+    {
+        return false;
+    }
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(pContext->physicalDevice, &queueFamilyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(pContext->physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    VkPhysicalDeviceFeatures supportedFeatures = {};
+    vkGetPhysicalDeviceFeatures(pContext->physicalDevice, &supportedFeatures);
+
+    pContext->sparseSupported =
+        (supportedFeatures.sparseBinding == VK_TRUE) &&
+        ((queueFamilies[pContext->queueFamilyIndex].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) != 0);
+
+    VkPhysicalDeviceVulkan12Features features12 = {};
+    features12.sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.timelineSemaphore = VK_TRUE;
+
+    VkPhysicalDeviceFeatures features = {};
+    features.sparseBinding = pContext->sparseSupported ? VK_TRUE : VK_FALSE;
+
+    if (bench::CreateDevice(&features12, &features, pContext) == false)
+    {
+        return false;
+    }
+
+    pContext->pfnWaitSemaphores = reinterpret_cast<PFN_vkWaitSemaphores>(
+        vkGetDeviceProcAddr(pContext->device, "vkWaitSemaphores"));
+    pContext->pfnSignalSemaphore = reinterpret_cast<PFN_vkSignalSemaphore>(
+        vkGetDeviceProcAddr(pContext->device, "vkSignalSemaphore"));
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = pContext->queueFamilyIndex;
+
+    bool success = Check(vkCreateCommandPool(pContext->device, &poolInfo, nullptr, &pContext->cmdPool),
+                         "vkCreateCommandPool");
+
+    if (success)
+    {
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool        = pContext->cmdPool;
+        allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = MaxBatchSize;
+
+        success = Check(vkAllocateCommandBuffers(pContext->device, &allocInfo, pContext->cmdBuffers),
+                        "vkAllocateCommandBuffers");
+    }
+
+    for (uint32_t i = 0; success && (i < MaxBatchSize); ++i)
+    {
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+        success = Check(vkBeginCommandBuffer(pContext->cmdBuffers[i], &beginInfo), "vkBeginCommandBuffer") &&
+                  Check(vkEndCommandBuffer(pContext->cmdBuffers[i]), "vkEndCommandBuffer");
+    }
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    success = success && Check(vkCreateFence(pContext->device, &fenceInfo, nullptr, &pContext->fence),
+                               "vkCreateFence");
+
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (uint32_t i = 0; success && (i < MaxBatchSize); ++i)
+    {
+        success = Check(vkCreateFence(pContext->device, &fenceInfo, nullptr, &pContext->signaledFences[i]),
+                        "vkCreateFence");
+    }
+
+    VkSemaphoreTypeCreateInfo typeInfo = {};
+    typeInfo.sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue  = 1;
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    for (uint32_t i = 0; success && (i < MaxBatchSize); ++i)
+    {
+        success = Check(vkCreateSemaphore(pContext->device, &semaphoreInfo, nullptr, &pContext->signaledSemaphores[i]),
+                        "vkCreateSemaphore");
+    }
+
+    typeInfo.initialValue = 0;
+
+    success = success && Check(vkCreateSemaphore(pContext->device, &semaphoreInfo, nullptr, &pContext->timeline),
+                               "vkCreateSemaphore");
+
+    if (success && pContext->sparseSupported)
+    {
+        success = CreateSparseResources(pContext);
+    }
+
+    return success;
+}
+
+// =====================================================================================================================
+// Destroys everything created by CreateContext.  Safe to call on a partially created context.
+void DestroyContext(
+    Context* pContext)
+{
+    if (pContext->device != VK_NULL_HANDLE)
+    {
+        vkDeviceWaitIdle(pContext->device);
+
+        vkDestroyBuffer(pContext->device, pContext->sparseBuffer, nullptr);
+
+        for (VkDeviceMemory memory : pContext->sparseMemory)
+        {
+            vkFreeMemory(pContext->device, memory, nullptr);
+        }
+
+        vkDestroySemaphore(pContext->device, pContext->timeline, nullptr);
+
+        for (uint32_t i = 0; i < MaxBatchSize; ++i)
+        {
+            vkDestroySemaphore(pContext->device, pContext->signaledSemaphores[i], nullptr);
+            vkDestroyFence(pContext->device, pContext->signaledFences[i], nullptr);
+        }
+
+        vkDestroyFence(pContext->device, pContext->fence, nullptr);
+        vkDestroyCommandPool(pContext->device, pContext->cmdPool, nullptr);
+    }
+
+    bench::DestroyContext(pContext);
+}
+
+// =====================================================================================================================
+// Returns the value at the given fraction of the sorted samples.
+double Percentile(
+    std::vector<double>* pSamples,
+    double               fraction)
+{
+    double value = 0.0;
+
+    if (pSamples->empty() == false)
+    {
+        const size_t index = std::min(pSamples->size() - 1, static_cast<size_t>(pSamples->size() * fraction));
+
+        std::nth_element(pSamples->begin(), pSamples->begin() + index, pSamples->end());
+        value = (*pSamples)[index];
+    }
+
+    return value;
+}
+
+// =====================================================================================================================
+// Prints the median and p99 of a measurement.
+void Print(
+    const char* pOperation,
+    const char* pBatch,
+    uint32_t    batchSize,
+    Samples*    pSamples)
+{
+    printf("%s %s=%u: CPU %.0f (p99 %.0f) ns/op",
+           pOperation,
+           pBatch,
+           batchSize,
+           Percentile(&pSamples->cpuNs, 0.5),
+           Percentile(&pSamples->cpuNs, 0.99));
+
+    if (pSamples->latencyUs.empty() == false)
+    {
+        printf(", latency %.1f (p99 %.1f) us",
+               Percentile(&pSamples->latencyUs, 0.5),
+               Percentile(&pSamples->latencyUs, 0.99));
+    }
+
+    printf("\n");
+}
+
+// =====================================================================================================================
+// Waits for the submission fence and resets it.  Returns the time at which the wait returned.
+Clock::time_point WaitForSubmission(
+    const Context& context)
+{
+    vkWaitForFences(context.device, 1, &context.fence, VK_TRUE, UINT64_MAX);
+
+    const Clock::time_point end = Clock::now();
+
+    vkResetFences(context.device, 1, &context.fence);
+
+    return end;
+}
+
+// =====================================================================================================================
+// vkQueueSubmit of empty command buffers: all in one submit info, or one submit info each.  The CPU time is per
+// command buffer.
+void RunSubmitBenchmarks(
+    const Context& context,
+    const Options& options)
+{
+    for (uint32_t separate = 0; separate < 2; ++separate)
+    {
+        for (uint32_t batchSize = 1; batchSize <= MaxBatchSize; batchSize *= 4)
+        {
+            std::vector<VkSubmitInfo> submitInfos(separate ? batchSize : 1);
+
+            for (uint32_t i = 0; i < submitInfos.size(); ++i)
+            {
+                submitInfos[i]                    = {};
+                submitInfos[i].sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                submitInfos[i].commandBufferCount = separate ? 1 : batchSize;
+                submitInfos[i].pCommandBuffers    = &context.cmdBuffers[i];
+            }
+
+            Samples samples;
+
+            for (uint32_t repeat = 0; repeat < options.repeats; ++repeat)
+            {
+                const Clock::time_point start = Clock::now();
+
+                vkQueueSubmit(context.queue, static_cast<uint32_t>(submitInfos.size()), submitInfos.data(),
+                              context.fence);
+
+                const Clock::time_point submitted = Clock::now();
+                const Clock::time_point end       = WaitForSubmission(context);
+
+                samples.cpuNs.push_back(std::chrono::duration<double, std::nano>(submitted - start).count() /
+                                        batchSize);
+                samples.latencyUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            }
+
+            Print(separate ? "vkQueueSubmit(one cmdbuf per submit)" : "vkQueueSubmit(one submit)",
+                  "cmdBuffers", batchSize, &samples);
+        }
+    }
+}
+
+// =====================================================================================================================
+// vkWaitForFences and vkWaitSemaphores on objects which are already signaled.  The CPU time is per call.
+void RunWaitBenchmarks(
+    const Context& context,
+    const Options& options)
+{
+    uint64_t values[MaxBatchSize];
+    std::fill(values, values + MaxBatchSize, 1);
+
+    for (uint32_t batchSize = 1; batchSize <= MaxBatchSize; batchSize *= 4)
+    {
+        Samples fenceSamples;
+        Samples semaphoreSamples;
+
+        VkSemaphoreWaitInfo waitInfo = {};
+        waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = batchSize;
+        waitInfo.pSemaphores    = context.signaledSemaphores;
+        waitInfo.pValues        = values;
+
+        for (uint32_t repeat = 0; repeat < options.repeats; ++repeat)
+        {
+            const Clock::time_point start = Clock::now();
+
+            vkWaitForFences(context.device, batchSize, context.signaledFences, VK_TRUE, UINT64_MAX);
+
+            const Clock::time_point fencesDone = Clock::now();
+
+            context.pfnWaitSemaphores(context.device, &waitInfo, UINT64_MAX);
+
+            const Clock::time_point semaphoresDone = Clock::now();
+
+            fenceSamples.cpuNs.push_back(std::chrono::duration<double, std::nano>(fencesDone - start).count());
+            semaphoreSamples.cpuNs.push_back(
+                std::chrono::duration<double, std::nano>(semaphoresDone - fencesDone).count());
+        }
+
+        Print("vkWaitForFences(signaled)", "fences", batchSize, &fenceSamples);
+        Print("vkWaitSemaphores(signaled)", "semaphores", batchSize, &semaphoreSamples);
+    }
+}
+
+// =====================================================================================================================
+// Timeline round trip: a submission waits for a value the host signals afterwards and signals the next value, which
+// the host waits for.  The CPU time is that of vkSignalSemaphore, the latency lasts from the signal until the wait
+// returns.
+void RunTimelineBenchmark(
+    const Context& context,
+    const Options& options)
+{
+    Samples  samples;
+    uint64_t value = 0;
+
+    for (uint32_t repeat = 0; repeat < options.repeats; ++repeat)
+    {
+        const uint64_t hostValue = ++value;
+        const uint64_t gpuValue  = ++value;
+
+        const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+        timelineInfo.sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount   = 1;
+        timelineInfo.pWaitSemaphoreValues      = &hostValue;
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues    = &gpuValue;
+
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext                = &timelineInfo;
+        submitInfo.waitSemaphoreCount   = 1;
+        submitInfo.pWaitSemaphores      = &context.timeline;
+        submitInfo.pWaitDstStageMask    = &waitStage;
+        submitInfo.commandBufferCount   = 1;
+        submitInfo.pCommandBuffers      = &context.cmdBuffers[0];
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores    = &context.timeline;
+
+        if (Check(vkQueueSubmit(context.queue, 1, &submitInfo, VK_NULL_HANDLE), "vkQueueSubmit") == false)
+        {
+            break;
+        }
+
+        VkSemaphoreSignalInfo signalInfo = {};
+        signalInfo.sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+        signalInfo.semaphore = context.timeline;
+        signalInfo.value     = hostValue;
+
+        VkSemaphoreWaitInfo waitInfo = {};
+        waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores    = &context.timeline;
+        waitInfo.pValues        = &gpuValue;
+
+        const Clock::time_point start = Clock::now();
+
+        context.pfnSignalSemaphore(context.device, &signalInfo);
+
+        const Clock::time_point signaled = Clock::now();
+
+        context.pfnWaitSemaphores(context.device, &waitInfo, UINT64_MAX);
+
+        const Clock::time_point end = Clock::now();
+
+        samples.cpuNs.push_back(std::chrono::duration<double, std::nano>(signaled - start).count());
+        samples.latencyUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    Print("timeline host-GPU-host round trip", "submits", 1, &samples);
+}
+
+// =====================================================================================================================
+// vkQueueBindSparse remapping pages of the sparse buffer, alternating between the two allocations so that every bind
+// changes the mapping.  The CPU time is per page.
+void RunBindSparseBenchmark(
+    const Context& context,
+    const Options& options)
+{
+    std::vector<VkSparseMemoryBind> binds(MaxSparsePages);
+
+    for (uint32_t batchSize = 1; batchSize <= MaxSparsePages; batchSize *= 4)
+    {
+        Samples samples;
+
+        for (uint32_t repeat = 0; repeat < options.repeats; ++repeat)
+        {
+            for (uint32_t i = 0; i < batchSize; ++i)
+            {
+                binds[i]                = {};
+                binds[i].resourceOffset = i * context.sparsePageSize;
+                binds[i].size           = context.sparsePageSize;
+                binds[i].memory         = context.sparseMemory[repeat & 1];
+                binds[i].memoryOffset   = i * context.sparsePageSize;
+            }
+
+            VkSparseBufferMemoryBindInfo bufferBind = {};
+            bufferBind.buffer    = context.sparseBuffer;
+            bufferBind.bindCount = batchSize;
+            bufferBind.pBinds    = binds.data();
+
+            VkBindSparseInfo bindInfo = {};
+            bindInfo.sType           = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+            bindInfo.bufferBindCount = 1;
+            bindInfo.pBufferBinds    = &bufferBind;
+
+            const Clock::time_point start = Clock::now();
+
+            if (Check(vkQueueBindSparse(context.queue, 1, &bindInfo, context.fence), "vkQueueBindSparse") == false)
+            {
+                break;
+            }
+
+            const Clock::time_point bound = Clock::now();
+            const Clock::time_point end   = WaitForSubmission(context);
+
+            samples.cpuNs.push_back(std::chrono::duration<double, std::nano>(bound - start).count() / batchSize);
+            samples.latencyUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+
+        Print("vkQueueBindSparse", "pages", batchSize, &samples);
+    }
+}
+
+} // anonymous namespace
+
+// =====================================================================================================================
+int main(
+    int    argc,
+    char** argv)
+{
+    Options options = {};
+    Context context = {};
+
+    if (ParseOptions(argc, argv, &options) == false)
+    {
+        return EXIT_FAILURE;
+    }
+
+    const bool success = CreateContext(&context);
+
+    if (success)
+    {
+        RunSubmitBenchmarks(context, options);
+        RunWaitBenchmarks(context, options);
+        RunTimelineBenchmark(context, options);
+
+        if (context.sparseSupported)
+        {
+            RunBindSparseBenchmark(context, options);
+        }
+        else
+        {
+            printf("vkQueueBindSparse: sparse binding not supported, skipped\n");
+        }
+    }
+
+    DestroyContext(&context);
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}